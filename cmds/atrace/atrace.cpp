@@ -30,8 +30,12 @@
 #include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <binder/IServiceManager.h>
@@ -505,6 +509,16 @@ static bool isCategorySupportedForRoot(const TracingCategory& category)
     return ok;
 }
 
+// Set a system property, unless it already has the value. Each set is a round trip to the
+// property service, and atrace sets the same values again when a trace is restarted.
+static bool setPropertyIfChanged(const std::string& key, const std::string& value)
+{
+    if (android::base::GetProperty(key, "") == value) {
+        return true;
+    }
+    return android::base::SetProperty(key, value);
+}
+
 // Enable or disable overwriting of the kernel trace buffers.  Disabling this
 // will cause tracing to stop once the trace buffers have filled up.
 static bool setTraceOverwriteEnable(bool enable)
@@ -515,7 +529,7 @@ static bool setTraceOverwriteEnable(bool enable)
 // Set the user initiated trace property
 static bool setUserInitiatedTraceProperty(bool enable)
 {
-    if (!android::base::SetProperty(k_userInitiatedTraceProperty, enable ? "1" : "")) {
+    if (!setPropertyIfChanged(k_userInitiatedTraceProperty, enable ? "1" : "")) {
         fprintf(stderr, "error setting user initiated strace system property\n");
         return false;
     }
@@ -603,7 +617,7 @@ static bool setPrintTgidEnableIfPresent(bool enable)
 static bool setTagsProperty(uint64_t tags)
 {
     std::string value = android::base::StringPrintf("%#" PRIx64, tags);
-    if (!android::base::SetProperty(k_traceTagsProperty, value)) {
+    if (!setPropertyIfChanged(k_traceTagsProperty, value)) {
         fprintf(stderr, "error setting trace tags system property\n");
         return false;
     }
@@ -612,7 +626,7 @@ static bool setTagsProperty(uint64_t tags)
 
 static void clearAppProperties()
 {
-    if (!android::base::SetProperty(k_traceAppsNumberProperty, "")) {
+    if (!setPropertyIfChanged(k_traceAppsNumberProperty, "")) {
         fprintf(stderr, "failed to clear system property: %s",
               k_traceAppsNumberProperty);
     }
@@ -631,7 +645,7 @@ static bool setAppCmdlineProperty(char* cmdline)
             end++;
         }
         std::string key = android::base::StringPrintf(k_traceAppsPropertyTemplate, i);
-        if (!android::base::SetProperty(key, start)) {
+        if (!setPropertyIfChanged(key, start)) {
             fprintf(stderr, "error setting trace app %d property to %s\n", i, key.c_str());
             clearAppProperties();
             return false;
@@ -641,7 +655,7 @@ static bool setAppCmdlineProperty(char* cmdline)
     }
 
     std::string value = android::base::StringPrintf("%d", i);
-    if (!android::base::SetProperty(k_traceAppsNumberProperty, value)) {
+    if (!setPropertyIfChanged(k_traceAppsNumberProperty, value)) {
         fprintf(stderr, "error setting trace app number property to %s\n", value.c_str());
         clearAppProperties();
         return false;
@@ -671,6 +685,42 @@ static bool disableKernelTraceEvents() {
     return ok;
 }
 
+// Set every /sys/ enable file to whether it is in an enabled category. Each file
+// is written once, with its final value, so that an event enabled by the
+// previous trace is not disabled and enabled again, which makes the kernel
+// unregister and register its tracepoint, and so that the same enable in
+// several categories is written once.
+static bool setKernelTraceEvents() {
+    bool ok = true;
+    std::map<std::string, bool> enables;
+    for (size_t i = 0; i < arraysize(k_categories); i++) {
+        const TracingCategory &c = k_categories[i];
+        for (int j = 0; j < MAX_SYS_FILES; j++) {
+            const char* path = c.sysfiles[j].path;
+            if (path == nullptr) {
+                continue;
+            }
+            if (g_categoryEnables[i] && c.sysfiles[j].required == REQ &&
+                    !fileIsWritable(path)) {
+                fprintf(stderr, "error writing file %s\n", path);
+                ok = false;
+            }
+            enables[path] |= g_categoryEnables[i];
+        }
+    }
+    for (const TracingVendorFileCategory& c : g_vendorFileCategories) {
+        for (const std::string& path : c.ftrace_enable_paths) {
+            enables[path] |= c.enabled;
+        }
+    }
+    for (const auto& [path, enable] : enables) {
+        if (fileIsWritable(path.c_str())) {
+            ok &= setKernelOptionEnable(path.c_str(), enable);
+        }
+    }
+    return ok;
+}
+
 // Verify that the comma separated list of functions are being traced by the
 // kernel.
 static bool verifyKernelTraceFuncs(const char* funcs)
@@ -725,15 +775,14 @@ static bool setKernelTraceFuncs(const char* funcs)
         ok &= setKernelOptionEnable(k_funcgraphCpuPath, true);
         ok &= setKernelOptionEnable(k_funcgraphProcPath, true);
 
-        // Set the requested filter functions.
+        // Set the requested filter functions, with a single write of the
+        // whitespace separated list.
         ok &= truncateFile(k_ftraceFilterPath);
-        char* myFuncs = strdup(funcs);
-        char* func = strtok(myFuncs, ",");
-        while (func) {
-            ok &= appendStr(k_ftraceFilterPath, func);
-            func = strtok(nullptr, ",");
+        std::vector<std::string> funcList = android::base::Split(funcs, ",");
+        funcList.erase(std::remove(funcList.begin(), funcList.end(), ""), funcList.end());
+        if (!funcList.empty()) {
+            ok &= appendStr(k_ftraceFilterPath, android::base::Join(funcList, ' ').c_str());
         }
-        free(myFuncs);
 
         // Verify that the set functions are being traced.
         if (ok) {
@@ -875,39 +924,7 @@ static bool setUpKernelTracing()
     ok &= setClock();
     ok &= setPrintTgidEnableIfPresent(true);
     ok &= setKernelTraceFuncs(g_kernelTraceFuncs);
-
-    // Disable all the sysfs enables.  This is done as a separate loop from
-    // the enables to allow the same enable to exist in multiple categories.
-    ok &= disableKernelTraceEvents();
-
-    // Enable all the sysfs enables that are in an enabled category.
-    for (size_t i = 0; i < arraysize(k_categories); i++) {
-        if (g_categoryEnables[i]) {
-            const TracingCategory &c = k_categories[i];
-            for (int j = 0; j < MAX_SYS_FILES; j++) {
-                const char* path = c.sysfiles[j].path;
-                bool required = c.sysfiles[j].required == REQ;
-                if (path != nullptr) {
-                    if (fileIsWritable(path)) {
-                        ok &= setKernelOptionEnable(path, true);
-                    } else if (required) {
-                        fprintf(stderr, "error writing file %s\n", path);
-                        ok = false;
-                    }
-                }
-            }
-        }
-    }
-
-    for (const TracingVendorFileCategory& c : g_vendorFileCategories) {
-        if (c.enabled) {
-            for (const std::string& path : c.ftrace_enable_paths) {
-                if (fileIsWritable(path.c_str())) {
-                    ok &= setKernelOptionEnable(path.c_str(), true);
-                }
-            }
-        }
-    }
+    ok &= setKernelTraceEvents();
 
     return ok;
 }
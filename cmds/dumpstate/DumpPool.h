@@ -158,8 +158,8 @@ class DumpPool {
             if (!tmp_file_ptr) {
                 return std::string("");
             }
+            // The file is only read back by WaitForTask, so it is not synced to the disk.
             invokeTask(dump_func, duration_title, tmp_file_ptr->fd.get());
-            fsync(tmp_file_ptr->fd.get());
             return std::string(tmp_file_ptr->path);
         });
         std::unique_lock lock(lock_);
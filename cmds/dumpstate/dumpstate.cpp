@@ -45,6 +45,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <fstream>
@@ -836,9 +837,17 @@ static const std::set<std::string> PROBLEMATIC_FILE_EXTENSIONS = {
       ".shb", ".sys", ".vb",  ".vbe", ".vbs", ".vxd", ".wsc", ".wsf", ".wsh"
 };
 
+// List of file extensions of files which are already compressed, and so are stored as they are
+// instead of being deflated again.
+static const std::set<std::string> COMPRESSED_FILE_EXTENSIONS = {
+      ".7z", ".apk", ".br", ".bz2", ".gz", ".jpeg", ".jpg", ".lz4", ".mp4", ".png", ".webp",
+      ".xz", ".zip", ".zst"
+};
+
 status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
                                       std::chrono::milliseconds timeout = 0ms) {
     std::string valid_name = entry_name;
+    size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
 
     // Rename extension if necessary.
     size_t idx = entry_name.rfind('.');
@@ -849,11 +858,13 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
             valid_name = entry_name + ".renamed";
             MYLOGI("Renaming entry %s to %s\n", entry_name.c_str(), valid_name.c_str());
         }
+        if (COMPRESSED_FILE_EXTENSIONS.count(extension) != 0) {
+            flags = 0;
+        }
     }
 
     // Logging statement  below is useful to time how long each entry takes, but it's too verbose.
     // MYLOGD("Adding zip entry %s\n", entry_name.c_str());
-    size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
     int32_t err = zip_writer_->StartEntryWithTime(valid_name.c_str(), flags,
                                                   get_mtime(fd, ds.now_));
     if (err != 0) {
@@ -905,14 +916,19 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
             MYLOGE("read(%s): %s\n", entry_name.c_str(), strerror(errno));
             return -errno;
         }
+        const uint64_t write_started = Nanotime();
         err = zip_writer_->WriteBytes(buffer.data(), bytes_read);
+        zip_write_ns_ += Nanotime() - write_started;
         if (err) {
             MYLOGE("zip_writer_->WriteBytes(): %s\n", ZipWriter::ErrorCodeString(err));
             return UNKNOWN_ERROR;
         }
+        (flags & ZipWriter::kCompress ? zip_compressed_bytes_ : zip_stored_bytes_) += bytes_read;
     }
 
+    const uint64_t finish_started = Nanotime();
     err = zip_writer_->FinishEntry();
+    zip_write_ns_ += Nanotime() - finish_started;
     finished_entry = true;
     if (err != 0) {
         MYLOGE("zip_writer_->FinishEntry(): %s\n", ZipWriter::ErrorCodeString(err));
@@ -970,6 +986,34 @@ bool Dumpstate::AddTextZipEntry(const std::string& entry_name, const std::string
     return true;
 }
 
+void Dumpstate::AddSectionDuration(const std::string& title, uint64_t started_ns,
+                                   uint64_t duration_ns) {
+    std::lock_guard<std::mutex> lock(section_durations_lock_);
+    section_durations_.push_back({title, started_ns, duration_ns});
+}
+
+std::string Dumpstate::FormatSectionDurations() {
+    std::vector<SectionDuration> durations;
+    {
+        std::lock_guard<std::mutex> lock(section_durations_lock_);
+        durations.swap(section_durations_);
+    }
+    // The sections are recorded when they finish, and nested ones before the enclosing ones.
+    std::stable_sort(durations.begin(), durations.end(),
+                     [](const SectionDuration& a, const SectionDuration& b) {
+                         return a.started_ns < b.started_ns;
+                     });
+    std::string content = "# start_s duration_s title\n";
+    for (const SectionDuration& duration : durations) {
+        content += StringPrintf("%.3f %.3f %s\n",
+                                (float)(duration.started_ns - durations[0].started_ns) /
+                                        NANOS_PER_SEC,
+                                (float)duration.duration_ns / NANOS_PER_SEC,
+                                duration.title.c_str());
+    }
+    return content;
+}
+
 static void DoKmsg() {
     struct stat st;
     if (!stat(PSTORE_LAST_KMSG, &st)) {
@@ -2629,6 +2673,10 @@ bool Dumpstate::FinishZipFile() {
         MYLOGE("Failed to add main_entry.txt to .zip file\n");
         return false;
     }
+    if (!AddTextZipEntry("dumpstate_durations.txt", FormatSectionDurations())) {
+        MYLOGE("Failed to add dumpstate_durations.txt to .zip file\n");
+        return false;
+    }
 
     // Add log file (which contains stderr output) to zip...
     fprintf(stderr, "dumpstate_log.txt entry on zip file logged up to here\n");
@@ -2648,6 +2696,9 @@ bool Dumpstate::FinishZipFile() {
         MYLOGE("zip_writer_->Finish(): %s\n", ZipWriter::ErrorCodeString(err));
         return false;
     }
+    MYLOGI("Spent %.3fs of %lds adding zip entries: %" PRIu64 " bytes compressed, %" PRIu64
+           " bytes stored\n", (float)zip_write_ns_ / NANOS_PER_SEC,
+           (long)(time(nullptr) - ds.now_), zip_compressed_bytes_, zip_stored_bytes_);
 
     // TODO: remove once FinishZipFile() is automatically handled by Dumpstate's destructor.
     ds.zip_file.reset(nullptr);
@@ -3642,7 +3693,9 @@ DurationReporter::DurationReporter(const std::string& title, bool logcat_only, b
 
 DurationReporter::~DurationReporter() {
     if (!title_.empty()) {
-        float elapsed = (float)(Nanotime() - started_) / NANOS_PER_SEC;
+        const uint64_t duration = Nanotime() - started_;
+        ds.AddSectionDuration(title_, started_, duration);
+        float elapsed = (float)duration / NANOS_PER_SEC;
         if (elapsed >= .5f || verbose_) {
             MYLOGD("Duration of '%s': %.2fs\n", title_.c_str(), elapsed);
         }
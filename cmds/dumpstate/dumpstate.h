@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -283,6 +284,12 @@ class Dumpstate {
      */
     bool AddTextZipEntry(const std::string& entry_name, const std::string& content);
 
+    /*
+     * Records the duration of a section for the dumpstate_durations.txt entry. Called from the
+     * threads of the DumpPool as well.
+     */
+    void AddSectionDuration(const std::string& title, uint64_t started_ns, uint64_t duration_ns);
+
     /*
      * Adds all files from a directory to the zipped bugreport file.
      */
@@ -598,6 +605,24 @@ class Dumpstate {
 
     android::sp<ConsentCallback> consent_callback_;
 
+    struct SectionDuration {
+        std::string title;
+        uint64_t started_ns;
+        uint64_t duration_ns;
+    };
+
+    // Lists the sections by start time, with the time since the first one started.
+    std::string FormatSectionDurations();
+
+    std::mutex section_durations_lock_;
+    std::vector<SectionDuration> section_durations_;
+
+    // The time spent writing and compressing the zip entries added from files, and their size.
+    // Only accessed by the thread which writes the zip file.
+    uint64_t zip_write_ns_ = 0;
+    uint64_t zip_compressed_bytes_ = 0;
+    uint64_t zip_stored_bytes_ = 0;
+
     std::recursive_mutex mutex_;
 
     DISALLOW_COPY_AND_ASSIGN(Dumpstate);
@@ -997,6 +997,22 @@ TEST_F(DumpstateTest, DumpPool_withParallelRunDisabled_isNull) {
     EXPECT_FALSE(ds.dump_pool_);
 }
 
+TEST_F(DumpstateTest, FormatSectionDurations) {
+    // Drops the sections recorded by the other tests.
+    ds.FormatSectionDurations();
+
+    ds.AddSectionDuration("INNER", 1500000000, 250000000);
+    ds.AddSectionDuration("OUTER", 1000000000, 2000000000);
+    ds.AddSectionDuration("PARALLEL", 1200000000, 500000000);
+
+    EXPECT_THAT(ds.FormatSectionDurations(),
+                StrEq("# start_s duration_s title\n"
+                      "0.000 2.000 OUTER\n"
+                      "0.200 0.500 PARALLEL\n"
+                      "0.500 0.250 INNER\n"));
+    EXPECT_THAT(ds.FormatSectionDurations(), StrEq("# start_s duration_s title\n"));
+}
+
 TEST_F(DumpstateTest, PreDumpUiData) {
     // These traces are always enabled, i.e. they are always pre-dumped
     const std::vector<std::filesystem::path> uiTraces = {
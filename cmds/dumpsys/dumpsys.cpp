@@ -65,16 +65,21 @@ static void usage() {
         "usage: dumpsys\n"
         "         To dump all services.\n"
         "or:\n"
-        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--clients] [--dump] [--pid] [--thread] "
-        "[--help | "
+        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--binder-stats] [--clients] [--dump] "
+        "[--pid] [--thread] [--parallel N] [--help | "
         "-l | --skip SERVICES "
         "| SERVICE [ARGS]]\n"
         "         --help: shows this help\n"
         "         -l: only list services, do not dump them\n"
         "         -t TIMEOUT_SEC: TIMEOUT to use in seconds instead of default 10 seconds\n"
         "         -T TIMEOUT_MS: TIMEOUT to use in milliseconds instead of default 10 seconds\n"
+        "         --binder-stats: dump the latency and size histograms of the binder\n"
+        "               transactions of the service host process instead of usual dump\n"
         "         --clients: dump client PIDs instead of usual dump\n"
         "         --dump: ask the service to dump itself (this is the default)\n"
+        "         --parallel N: dump up to N services at a time, each with its own timeout.\n"
+        "               The dumps are still written in order, and the duration and size of\n"
+        "               each dump are reported on stderr\n"
         "         --pid: dump PID instead of usual dump\n"
         "         --proto: filter services that support dumping data in proto format. Dumps\n"
         "               will be in proto format.\n"
@@ -135,13 +140,15 @@ int Dumpsys::main(int argc, char* const argv[]) {
     bool asProto = false;
     int dumpTypeFlags = 0;
     int timeoutArgMs = 10000;
+    size_t parallelism = 1;
     int priorityFlags = IServiceManager::DUMP_FLAG_PRIORITY_ALL;
     static struct option longOptions[] = {
         {"help", no_argument, 0, 0},           {"clients", no_argument, 0, 0},
         {"dump", no_argument, 0, 0},           {"pid", no_argument, 0, 0},
         {"priority", required_argument, 0, 0}, {"proto", no_argument, 0, 0},
         {"skip", no_argument, 0, 0},           {"stability", no_argument, 0, 0},
-        {"thread", no_argument, 0, 0},         {0, 0, 0, 0}};
+        {"thread", no_argument, 0, 0},         {"binder-stats", no_argument, 0, 0},
+        {"parallel", required_argument, 0, 0}, {0, 0, 0, 0}};
 
     // Must reset optind, otherwise subsequent calls will fail (wouldn't happen on main.cpp, but
     // happens on test cases).
@@ -182,6 +189,16 @@ int Dumpsys::main(int argc, char* const argv[]) {
                 dumpTypeFlags |= TYPE_THREAD;
             } else if (!strcmp(longOptions[optionIndex].name, "clients")) {
                 dumpTypeFlags |= TYPE_CLIENTS;
+            } else if (!strcmp(longOptions[optionIndex].name, "binder-stats")) {
+                dumpTypeFlags |= TYPE_BINDER_STATS;
+            } else if (!strcmp(longOptions[optionIndex].name, "parallel")) {
+                char* endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0) {
+                    fprintf(stderr, "Error: invalid number of parallel dumps: '%s'\n", optarg);
+                    return -1;
+                }
+                parallelism = static_cast<size_t>(value);
             }
             break;
 
@@ -271,6 +288,18 @@ int Dumpsys::main(int argc, char* const argv[]) {
         return 0;
     }
 
+    if (parallelism > 1 && N > 1) {
+        std::vector<String16> dumpedServices;
+        for (const auto& serviceName : services) {
+            if (!IsSkipped(skippedServices, serviceName)) {
+                dumpedServices.push_back(serviceName);
+            }
+        }
+        dumpServicesInParallel(dumpedServices, parallelism, dumpTypeFlags, args, priorityFlags,
+                               std::chrono::milliseconds(timeoutArgMs), asProto);
+        return 0;
+    }
+
     for (size_t i = 0; i < N; i++) {
         const String16& serviceName = services[i];
         if (IsSkipped(skippedServices, serviceName)) continue;
@@ -360,14 +389,15 @@ static status_t dumpStabilityToFd(const sp<IBinder>& service, const unique_fd& f
      return OK;
 }
 
-static status_t dumpThreadsToFd(const sp<IBinder>& service, const unique_fd& fd) {
+static status_t dumpThreadsToFd(const sp<IBinder>& service, const unique_fd& fd,
+                                BinderDebugSnapshot* snapshot) {
     pid_t pid;
     status_t status = service->getDebugPid(&pid);
     if (status != OK) {
         return status;
     }
     BinderPidInfo pidInfo;
-    status = getBinderPidInfo(BinderDebugContext::BINDER, pid, &pidInfo);
+    status = snapshot->getBinderPidInfo(pid, &pidInfo);
     if (status != OK) {
         return status;
     }
@@ -377,7 +407,8 @@ static status_t dumpThreadsToFd(const sp<IBinder>& service, const unique_fd& fd)
     return OK;
 }
 
-static status_t dumpClientsToFd(const sp<IBinder>& service, const unique_fd& fd) {
+static status_t dumpClientsToFd(const sp<IBinder>& service, const unique_fd& fd,
+                                BinderDebugSnapshot* snapshot) {
     std::string clientPids;
     const auto remoteBinder = service->remoteBinder();
     if (remoteBinder == nullptr) {
@@ -395,8 +426,7 @@ static status_t dumpClientsToFd(const sp<IBinder>& service, const unique_fd& fd)
     if (status != OK) {
         return status;
     }
-    status =
-        getBinderClientPids(BinderDebugContext::BINDER, myPid, servicePid, handle.value(), &pids);
+    status = snapshot->getBinderClientPids(myPid, servicePid, handle.value(), &pids);
     if (status != OK) {
         return status;
     }
@@ -406,6 +436,15 @@ static status_t dumpClientsToFd(const sp<IBinder>& service, const unique_fd& fd)
     return OK;
 }
 
+static status_t dumpBinderStatsToFd(const sp<IBinder>& service, const unique_fd& fd) {
+    Parcel data, reply;
+    status_t status = data.writeFileDescriptor(fd.get());
+    if (status != OK) {
+        return status;
+    }
+    return service->transact(IBinder::STATS_TRANSACTION, data, &reply);
+}
+
 static void reportDumpError(const String16& serviceName, status_t error, const char* context) {
     if (error == OK) return;
 
@@ -415,6 +454,11 @@ static void reportDumpError(const String16& serviceName, status_t error, const c
 
 status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName,
                                   const Vector<String16>& args) {
+    return startDump(dumpTypeFlags, serviceName, args, &activeThread_, &redirectFd_);
+}
+
+status_t Dumpsys::startDump(int dumpTypeFlags, const String16& serviceName,
+                            const Vector<String16>& args, std::thread* thread, unique_fd* fd) {
     sp<IBinder> service = sm_->checkService(serviceName);
     if (service == nullptr) {
         std::cerr << "Can't find service: " << serviceName << std::endl;
@@ -428,12 +472,18 @@ status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName
         return -errno;
     }
 
-    redirectFd_ = unique_fd(sfd[0]);
+    *fd = unique_fd(sfd[0]);
     unique_fd remote_end(sfd[1]);
     sfd[0] = sfd[1] = -1;
 
+    if ((dumpTypeFlags & (TYPE_THREAD | TYPE_CLIENTS)) && binderSnapshot_ == nullptr) {
+        binderSnapshot_ = std::make_shared<BinderDebugSnapshot>(BinderDebugContext::BINDER);
+    }
+    // shared with the dump thread, which may outlive this if it times out
+    std::shared_ptr<BinderDebugSnapshot> binderSnapshot = binderSnapshot_;
+
     // dump blocks until completion, so spawn a thread..
-    activeThread_ = std::thread([=, remote_end{std::move(remote_end)}]() mutable {
+    *thread = std::thread([=, remote_end{std::move(remote_end)}]() mutable {
         if (dumpTypeFlags & TYPE_PID) {
             status_t err = dumpPidToFd(service, remote_end, dumpTypeFlags == TYPE_PID);
             reportDumpError(serviceName, err, "dumping PID");
@@ -443,13 +493,17 @@ status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName
             reportDumpError(serviceName, err, "dumping stability");
         }
         if (dumpTypeFlags & TYPE_THREAD) {
-            status_t err = dumpThreadsToFd(service, remote_end);
+            status_t err = dumpThreadsToFd(service, remote_end, binderSnapshot.get());
             reportDumpError(serviceName, err, "dumping thread info");
         }
         if (dumpTypeFlags & TYPE_CLIENTS) {
-            status_t err = dumpClientsToFd(service, remote_end);
+            status_t err = dumpClientsToFd(service, remote_end, binderSnapshot.get());
             reportDumpError(serviceName, err, "dumping clients info");
         }
+        if (dumpTypeFlags & TYPE_BINDER_STATS) {
+            status_t err = dumpBinderStatsToFd(service, remote_end);
+            reportDumpError(serviceName, err, "dumping binder stats");
+        }
 
         // other types always act as a header, this is usually longer
         if (dumpTypeFlags & TYPE_DUMP) {
@@ -565,3 +619,156 @@ void Dumpsys::writeDumpFooter(int fd, const String16& serviceName,
                      elapsedDuration.count(), String8(serviceName).string(), oss.str().c_str());
     WriteStringToFd(msg, fd);
 }
+
+namespace {
+
+struct ServiceDump {
+    String16 serviceName;
+    std::thread thread;
+    // read end of the pipe, reset once the dump completed, failed or timed out
+    unique_fd fd;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::duration<double> elapsedDuration{0};
+    // output read before the dump's turn to be written out
+    std::string pending;
+    size_t bytesRead = 0;
+    bool started = false;
+    bool done = false;
+    status_t status = OK;
+};
+
+} // namespace
+
+void Dumpsys::dumpServicesInParallel(const std::vector<String16>& services, size_t parallelism,
+                                     int dumpTypeFlags, const Vector<String16>& args,
+                                     int priorityFlags, std::chrono::milliseconds timeout,
+                                     bool asProto) {
+    std::vector<ServiceDump> dumps(services.size());
+    // dumps[next] is the dump written out next, up to dumps[nextToStart] are started
+    size_t next = 0;
+    size_t nextToStart = 0;
+    bool nextHeaderWritten = false;
+
+    auto finish = [](ServiceDump& dump, status_t status) {
+        dump.status = status;
+        dump.done = true;
+        dump.elapsedDuration = std::chrono::steady_clock::now() - dump.start;
+        /* close read end of the dump output redirection pipe */
+        dump.fd.reset();
+    };
+
+    while (next < dumps.size()) {
+        // Bound the number of dumps which are buffered, not only the ones which are running.
+        while (nextToStart < dumps.size() && nextToStart - next < parallelism) {
+            ServiceDump& dump = dumps[nextToStart];
+            dump.serviceName = services[nextToStart];
+            dump.start = std::chrono::steady_clock::now();
+            dump.started = startDump(dumpTypeFlags, dump.serviceName, args, &dump.thread,
+                                     &dump.fd) == OK;
+            dump.done = !dump.started;
+            nextToStart++;
+        }
+
+        ServiceDump& head = dumps[next];
+        if (head.started && !nextHeaderWritten) {
+            writeDumpHeader(STDOUT_FILENO, head.serviceName, priorityFlags);
+            if (!WriteFully(STDOUT_FILENO, head.pending.data(), head.pending.size()) &&
+                !head.done) {
+                status_t status = -errno;
+                std::cerr << "Failed to write while dumping service " << head.serviceName
+                          << ": " << strerror(-status) << std::endl;
+                finish(head, status);
+            }
+            head.pending.clear();
+            nextHeaderWritten = true;
+        }
+        if (head.done) {
+            if (head.started) {
+                if (head.status == TIMED_OUT) {
+                    if (!asProto) {
+                        std::string msg = StringPrintf(
+                                "\n*** SERVICE '%s' DUMP TIMEOUT (%llums) EXPIRED ***\n\n",
+                                String8(head.serviceName).string(), timeout.count());
+                        WriteStringToFd(msg, STDOUT_FILENO);
+                    }
+                    std::cout << std::endl
+                              << "*** SERVICE '" << head.serviceName << "' DUMP TIMEOUT ("
+                              << timeout.count() << "ms) EXPIRED ***" << std::endl
+                              << std::endl;
+                }
+                writeDumpFooter(STDOUT_FILENO, head.serviceName, head.elapsedDuration);
+                std::cerr << StringPrintf("dumpsys: %.3fs and %zu bytes for service %s (%s)\n",
+                                          head.elapsedDuration.count(), head.bytesRead,
+                                          String8(head.serviceName).c_str(),
+                                          statusToString(head.status).c_str());
+                if (head.status == OK) {
+                    head.thread.join();
+                } else {
+                    head.thread.detach();
+                }
+            }
+            next++;
+            nextHeaderWritten = false;
+            continue;
+        }
+
+        // Wait for the output of any running dump, until the first deadline.
+        std::vector<pollfd> pfds;
+        std::vector<ServiceDump*> polled;
+        auto firstDeadline = std::chrono::steady_clock::time_point::max();
+        for (size_t i = next; i < nextToStart; i++) {
+            if (dumps[i].done) continue;
+            pfds.push_back({.fd = dumps[i].fd.get(), .events = POLLIN});
+            polled.push_back(&dumps[i]);
+            firstDeadline = std::min(firstDeadline, dumps[i].start + timeout);
+        }
+        auto time_left_ms = [](std::chrono::steady_clock::time_point end) {
+            auto now = std::chrono::steady_clock::now();
+            auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(end - now);
+            return std::max(diff.count(), 0LL);
+        };
+        int rc = TEMP_FAILURE_RETRY(poll(pfds.data(), pfds.size(), time_left_ms(firstDeadline)));
+        if (rc < 0) {
+            status_t status = -errno;
+            std::cerr << "Error in poll while dumping services: " << strerror(errno)
+                      << std::endl;
+            for (ServiceDump* dump : polled) {
+                finish(*dump, status);
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < pfds.size(); i++) {
+            ServiceDump& dump = *polled[i];
+            if (time_left_ms(dump.start + timeout) == 0) {
+                finish(dump, TIMED_OUT);
+                continue;
+            }
+            if (pfds[i].revents == 0) continue;
+
+            char buf[4096];
+            ssize_t bytes = TEMP_FAILURE_RETRY(read(dump.fd.get(), buf, sizeof(buf)));
+            if (bytes < 0) {
+                status_t status = -errno;
+                std::cerr << "Failed to read while dumping service " << dump.serviceName << ": "
+                          << strerror(-status) << std::endl;
+                finish(dump, status);
+                continue;
+            } else if (bytes == 0) {
+                // EOF.
+                finish(dump, OK);
+                continue;
+            }
+            dump.bytesRead += bytes;
+
+            if (&dump != &head) {
+                dump.pending.append(buf, bytes);
+            } else if (!WriteFully(STDOUT_FILENO, buf, bytes)) {
+                status_t status = -errno;
+                std::cerr << "Failed to write while dumping service " << dump.serviceName
+                          << ": " << strerror(-status) << std::endl;
+                finish(dump, status);
+            }
+        }
+    }
+}
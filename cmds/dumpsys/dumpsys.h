@@ -17,13 +17,18 @@
 #ifndef FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 #define FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 
+#include <chrono>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <android-base/unique_fd.h>
 #include <binder/IServiceManager.h>
 
 namespace android {
 
+class BinderDebugSnapshot;
+
 class Dumpsys {
   public:
     explicit Dumpsys(android::IServiceManager* sm) : sm_(sm) {
@@ -57,6 +62,7 @@ class Dumpsys {
         TYPE_STABILITY = 0x4,  // dump stability information of server
         TYPE_THREAD = 0x8,     // dump thread usage of server only
         TYPE_CLIENTS = 0x10,   // dump pid of clients
+        TYPE_BINDER_STATS = 0x20,  // dump binder transaction stats of server
     };
 
     /**
@@ -126,9 +132,26 @@ class Dumpsys {
     }
 
   private:
+    // Starts the dump thread of a service, see startDumpThread, into the given thread and
+    // read end of the pipe.
+    status_t startDump(int dumpTypeFlags, const String16& serviceName,
+                       const Vector<String16>& args, std::thread* thread,
+                       android::base::unique_fd* fd);
+
+    // Dumps up to `parallelism` services at a time, each with its own timeout. The output of
+    // the service written out next is streamed, the others are buffered until their turn, so
+    // that the services are written out in the order of `services` with their header and
+    // footer, as when they are dumped one after another.
+    void dumpServicesInParallel(const std::vector<String16>& services, size_t parallelism,
+                                int dumpTypeFlags, const Vector<String16>& args,
+                                int priorityFlags, std::chrono::milliseconds timeout,
+                                bool asProto);
+
     android::IServiceManager* sm_;
     std::thread activeThread_;
     mutable android::base::unique_fd redirectFd_;
+    // The binder state of the processes, read once for all the services that are dumped.
+    std::shared_ptr<BinderDebugSnapshot> binderSnapshot_;
 };
 }
 
@@ -454,6 +454,45 @@ TEST_F(DumpsysTest, DumpMultipleServices) {
     AssertDumped("running3", "dump3");
 }
 
+// Tests 'dumpsys --parallel 2', which should write the dumps in the order of the services
+TEST_F(DumpsysTest, DumpMultipleServicesInParallel) {
+    ExpectListServices({"running1", "stopped2", "running3", "running4"});
+    ExpectDump("running1", "dump1");
+    ExpectCheckService("stopped2", false);
+    ExpectDump("running3", "dump3");
+    ExpectDump("running4", "dump4");
+
+    CallMain({"--parallel", "2"});
+
+    AssertRunningServices({"running1", "running3", "running4"});
+    AssertDumped("running1", "dump1");
+    AssertStopped("stopped2");
+    AssertDumped("running3", "dump3");
+    AssertDumped("running4", "dump4");
+    EXPECT_LT(stdout_.find("dump1"), stdout_.find("dump3"));
+    EXPECT_LT(stdout_.find("dump3"), stdout_.find("dump4"));
+    EXPECT_THAT(stderr_, HasSubstr("5 bytes for service running3 (OK)"));
+}
+
+// Tests 'dumpsys --parallel 2 -T 500' on a service that times out after 2s
+TEST_F(DumpsysTest, DumpServicesInParallelWithTimeout) {
+    ExpectListServices({"Locksmith", "Valet", "Washer"});
+    ExpectDump("Locksmith", "dumped1");
+    sp<BinderMock> binder_mock = ExpectDumpAndHang("Valet", 2, "Here's your car");
+    ExpectDump("Washer", "dumped3");
+
+    CallMain({"--parallel", "2", "-T", "500"});
+
+    AssertDumped("Locksmith", "dumped1");
+    AssertOutputContains("SERVICE 'Valet' DUMP TIMEOUT (500ms) EXPIRED");
+    AssertNotDumped("Here's your car");
+    AssertDumped("Washer", "dumped3");
+    EXPECT_LT(stdout_.find("EXPIRED"), stdout_.find("dumped3"));
+
+    // TODO(b/65056227): BinderMock is not destructed because thread is detached on dumpsys.cpp
+    Mock::AllowLeak(binder_mock.get());
+}
+
 // Tests 'dumpsys --skip skipped3 skipped5', which should skip these services
 TEST_F(DumpsysTest, DumpWithSkip) {
     ExpectListServices({"running1", "stopped2", "skipped3", "running4", "skipped5"});
@@ -657,6 +696,15 @@ TEST_F(DumpsysTest, ListServiceWithClients) {
     const std::string format("Client PIDs are not available for local binders.\n");
     AssertOutputFormat(format);
 }
+// Tests 'dumpsys --binder-stats service_name'
+TEST_F(DumpsysTest, ListServiceWithBinderStats) {
+    ExpectCheckService("Locksmith");
+
+    CallMain({"--binder-stats", "Locksmith"});
+
+    AssertOutputContains("Binder transaction stats (enabled):");
+}
+
 // Tests 'dumpsys --thread --stability'
 TEST_F(DumpsysTest, ListAllServicesWithMultipleOptions) {
     ExpectListServices({"Locksmith", "Valet"});
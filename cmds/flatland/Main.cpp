@@ -37,6 +37,7 @@ using namespace ::android;
 
 static uint32_t    g_SleepBetweenSamplesMs = 0;
 static bool        g_PresentToWindow       = false;
+static bool        g_CsvOutput             = false;
 static size_t      g_BenchmarkNameLen      = 0;
 static sp<IBinder> g_DisplayToken          = nullptr;
 
@@ -588,17 +589,43 @@ static int cmpDouble(const double* lhs, const double* rhs) {
     return 0;
 }
 
+// Return the frame time in ms of the sample at the given percentile of the
+// sorted samples, each of which measures the given number of frames.
+static double percentileFrameTimeMs(const Vector<double>& samples,
+        double percentile, uint32_t frames) {
+    size_t i = size_t(percentile / 100.0 * double(samples.size() - 1) + 0.5);
+    return samples[i] / double(frames) / 1e6;
+}
+
+// Print the result of a benchmark as a line of comma-separated values.
+static void printCsvResult(const BenchmarkDesc& b, uint32_t runWidth,
+        uint32_t runHeight, const char* status, double result,
+        const Vector<double>& samples, uint32_t frames) {
+    printf("\"%s\",%u,%u,%s", b.name, runWidth, runHeight, status);
+    if (strcmp(status, "ok") == 0) {
+        printf(",%.3f,%.3f,%.3f,%.3f,%zu\n", result / double(frames) / 1e6,
+                percentileFrameTimeMs(samples, 50, frames),
+                percentileFrameTimeMs(samples, 90, frames),
+                percentileFrameTimeMs(samples, 99, frames), samples.size());
+    } else {
+        printf(",,,,,%zu\n", samples.size());
+    }
+}
+
 // Run a single benchmark and print the result.
 static bool runTest(const BenchmarkDesc b, size_t run) {
     bool success = true;
     double prevResult = 0.0, result = 0.0;
     Vector<double> samples;
+    const char* status = "ok";
 
     uint32_t runHeight = b.runHeights[run];
     uint32_t runWidth = b.width * runHeight / b.height;
-    printf(" %-*s | %4d x %4d | ", static_cast<int>(g_BenchmarkNameLen), b.name,
-            runWidth, runHeight);
-    fflush(stdout);
+    if (!g_CsvOutput) {
+        printf(" %-*s | %4d x %4d | ", static_cast<int>(g_BenchmarkNameLen),
+                b.name, runWidth, runHeight);
+        fflush(stdout);
+    }
 
     BenchmarkRunner r(b, run);
     if (!r.setUp()) {
@@ -629,11 +656,11 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
 
     if (totalFrames - warmUpFrames > 16) {
         // The test runs too fast to get a stable result.  Skip it.
-        printf("  fast");
+        status = "fast";
         goto done;
     } else if (totalFrames == 5 && runTime > 200e6) {
         // The test runs too slow to be very useful.  Skip it.
-        printf("  slow");
+        status = "slow";
         goto done;
     }
 
@@ -644,7 +671,7 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
         }
 
         if (newSamples > 512) {
-            printf("varies");
+            status = "varies";
             goto done;
         }
 
@@ -657,6 +684,7 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
 
             if (sample < 0.0) {
                 success = false;
+                status = "error";
                 goto done;
             }
 
@@ -670,11 +698,18 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
         result = (samples[elem-1] + samples[elem]) * 0.5;
     } while (fabs(result - prevResult) > threshold * result);
 
-    printf("%6.3f", result / double(totalFrames - warmUpFrames) / 1e6);
-
 done:
 
-    printf("\n");
+    if (g_CsvOutput) {
+        printCsvResult(b, runWidth, runHeight, status, result, samples,
+                totalFrames - warmUpFrames);
+    } else if (strcmp(status, "ok") == 0) {
+        printf("%6.3f\n", result / double(totalFrames - warmUpFrames) / 1e6);
+    } else if (success) {
+        printf("%6s\n", status);
+    } else {
+        printf("\n");
+    }
     fflush(stdout);
     r.tearDown();
 
@@ -682,6 +717,12 @@ done:
 }
 
 static void printResultsTableHeader() {
+    if (g_CsvOutput) {
+        printf("scenario,width,height,status,time_ms,p50_ms,p90_ms,p99_ms,"
+                "samples\n");
+        return;
+    }
+
     const char* scenario = "Scenario";
     size_t len = strlen(scenario);
     size_t leftPad = (g_BenchmarkNameLen - len) / 2;
@@ -727,6 +768,8 @@ static void showHelp(const char* cmd) {
       "options include:\n"
       "  -s N            sleep for N ms between samples\n"
       "  -d              display the test frame to a window\n"
+      "  -c              print the results as comma-separated values, with\n"
+      "                  the frame time percentiles of the samples\n"
       "  -i display-id   specify a display ID to use for multi-display device\n"
       "                  see \"dumpsys SurfaceFlinger --display-id\" for valid "
       "display IDs\n"
@@ -755,7 +798,7 @@ int main(int argc, char** argv) {
             {     0,               0, 0,  0 }
         };
 
-        ret = getopt_long(argc, argv, "ds:i:",
+        ret = getopt_long(argc, argv, "cds:i:",
                           long_options, &option_index);
 
         if (ret < 0) {
@@ -763,6 +806,10 @@ int main(int argc, char** argv) {
         }
 
         switch(ret) {
+            case 'c':
+                g_CsvOutput = true;
+            break;
+
             case 'd':
                 g_PresentToWindow = true;
             break;
@@ -810,11 +857,13 @@ int main(int argc, char** argv) {
 
     g_BenchmarkNameLen = maxBenchmarkNameLen();
 
-    printf(" cmdline:");
-    for (int i = 0; i < argc; i++) {
-        printf(" %s", argv[i]);
+    if (!g_CsvOutput) {
+        printf(" cmdline:");
+        for (int i = 0; i < argc; i++) {
+            printf(" %s", argv[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
     if (!runTests()) {
         fprintf(stderr, "exiting due to error.\n");
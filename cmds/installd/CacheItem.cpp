@@ -66,6 +66,19 @@ std::string CacheItem::buildPath() {
     return res;
 }
 
+bool CacheItem::isUnchanged() {
+    struct stat st;
+    if (lstat(buildPath().c_str(), &st) != 0) {
+        return false;
+    }
+    if (directory) {
+        // The modified time of a directory is the one of its newest entry, which is only known
+        // by walking it again, so a directory is purged as long as it still exists.
+        return S_ISDIR(st.st_mode);
+    }
+    return !S_ISDIR(st.st_mode) && st.st_mtime == modified;
+}
+
 int CacheItem::purge() {
     int res = 0;
     auto path = buildPath();
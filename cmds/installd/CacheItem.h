@@ -43,6 +43,9 @@ public:
     std::string buildPath();
 
     int purge();
+    // Returns whether the item is still on disk as it was loaded, so that a file rewritten
+    // since is not purged as an old one.
+    bool isUnchanged();
 
     short level;
     bool directory;
@@ -39,6 +39,7 @@ CacheTracker::CacheTracker(userid_t userId, appid_t appId, const std::string& uu
         mUserId(userId),
         mAppId(appId),
         mItemsLoaded(false),
+        mItemsReused(false),
         mUuid(uuid) {
 }
 
@@ -196,6 +197,21 @@ void CacheTracker::ensureItems() {
     }
 }
 
+void CacheTracker::reuseItems(std::vector<std::shared_ptr<CacheItem>> reusedItems) {
+    items = std::move(reusedItems);
+    mItemsLoaded = true;
+    mItemsReused = true;
+}
+
+bool CacheTracker::reloadReusedItems() {
+    if (!mItemsReused) {
+        return false;
+    }
+    loadItems();
+    mItemsReused = false;
+    return true;
+}
+
 int CacheTracker::getCacheRatio() {
     if (cacheQuota == 0) {
         return 0;
@@ -45,12 +45,21 @@ public:
     std::string toString();
 
     void addDataPath(const std::string& dataPath);
+    uid_t getUid() const { return multiuser_get_uid(mUserId, mAppId); }
+    const std::vector<std::string>& getDataPaths() const { return mDataPaths; }
 
     void loadStats();
     void loadItems();
 
     void ensureItems();
 
+    // Uses the items left from a previous purge instead of loading them, until they run out.
+    void reuseItems(std::vector<std::shared_ptr<CacheItem>> reusedItems);
+    bool itemsReused() const { return mItemsReused; }
+    // Loads the items of the data paths when the reused ones ran out, since files may have been
+    // added since they were loaded. Returns false if the items were loaded already.
+    bool reloadReusedItems();
+
     int getCacheRatio();
 
     int64_t cacheUsed;
@@ -62,6 +71,7 @@ private:
     userid_t mUserId;
     appid_t mAppId;
     bool mItemsLoaded;
+    bool mItemsReused;
     const std::string& mUuid;
 
     std::vector<std::string> mDataPaths;
@@ -35,10 +35,12 @@
 #include <sys/xattr.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <regex>
+#include <thread>
 #include <unordered_set>
 
 #include <android-base/file.h>
@@ -94,6 +96,13 @@ static constexpr const char* kTestUuid = "TEST";
 
 static constexpr const mode_t kRollbackFolderMode = 0700;
 
+// The items left by freeCache are reused for this long, so that the calls made while storage is
+// low do not walk all the caches again.
+static constexpr const std::chrono::seconds kCacheItemIndexMaxAge(60);
+
+// The number of threads, including the binder one, that createAppDataBatched sets apps up with.
+static constexpr const size_t kCreateAppDataThreads = 4;
+
 static constexpr const char* kCpPath = "/system/bin/cp";
 static constexpr const char* kXattrDefault = "user.default";
 
@@ -404,6 +413,28 @@ status_t InstalldNativeService::dump(int fd, const Vector<String16>& /* args */)
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mCacheIndexLock);
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        dprintf(fd, "freeCache:\n");
+        dprintf(fd, "    calls = %" PRId64 ", total = %" PRId64 "ms\n", mFreeCacheStats.calls,
+                static_cast<int64_t>(
+                        duration_cast<milliseconds>(mFreeCacheStats.totalDuration).count()));
+        dprintf(fd,
+                "    last: create = %" PRId64 "ms, populate = %" PRId64 "ms, bounce = %" PRId64
+                "ms\n",
+                static_cast<int64_t>(
+                        duration_cast<milliseconds>(mFreeCacheStats.lastCreateDuration).count()),
+                static_cast<int64_t>(
+                        duration_cast<milliseconds>(mFreeCacheStats.lastPopulateDuration).count()),
+                static_cast<int64_t>(
+                        duration_cast<milliseconds>(mFreeCacheStats.lastBounceDuration).count()));
+        dprintf(fd, "    items loaded = %" PRId64 ", reused = %" PRId64 ", indexed UIDs = %zu\n",
+                mFreeCacheStats.itemsLoaded, mFreeCacheStats.itemsReused,
+                mCacheItemIndex.size());
+    }
+
     dprintf(fd, "is_dexopt_blocked:%d\n", android::installd::is_dexopt_blocked());
 
     return NO_ERROR;
@@ -839,13 +870,24 @@ binder::Status InstalldNativeService::createAppDataBatched(
     ENFORCE_UID(AID_SYSTEM);
     // Locking is performed depeer in the callstack.
 
-    std::vector<android::os::CreateAppDataResult> results;
-    for (const auto &arg : args) {
-        android::os::CreateAppDataResult result;
-        createAppData(arg, &result);
-        results.push_back(result);
+    // Each app only locks its package and user, so the apps are set up on a few threads at once,
+    // which spend most of their time waiting for the file system.
+    std::vector<android::os::CreateAppDataResult> results(args.size());
+    std::atomic<size_t> next = 0;
+    auto createNext = [&]() {
+        for (size_t i = next++; i < args.size(); i = next++) {
+            createAppData(args[i], &results[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(args.size(), kCreateAppDataThreads); i++) {
+        threads.emplace_back(createNext);
+    }
+    createNext();
+    for (std::thread& thread : threads) {
+        thread.join();
     }
-    *_aidl_return = results;
+    *_aidl_return = std::move(results);
     return ok();
 }
 
@@ -1198,6 +1240,11 @@ binder::Status InstalldNativeService::deleteReferenceProfile(const std::string&
     return ok();
 }
 
+static int rename_delete_package_dir(const std::string& path, bool in_background) {
+    return in_background ? rename_delete_dir_contents_and_dir_in_background(path)
+                         : rename_delete_dir_contents_and_dir(path);
+}
+
 binder::Status InstalldNativeService::destroyAppData(const std::optional<std::string>& uuid,
         const std::string& packageName, int32_t userId, int32_t flags, int64_t ceDataInode) {
     ENFORCE_UID(AID_SYSTEM);
@@ -1208,16 +1255,17 @@ binder::Status InstalldNativeService::destroyAppData(const std::optional<std::st
     const char* uuid_ = uuid ? uuid->c_str() : nullptr;
     const char* pkgname = packageName.c_str();
 
+    const bool inBackground = flags & FLAG_DELETE_IN_BACKGROUND;
     binder::Status res = ok();
     if (flags & FLAG_STORAGE_CE) {
         auto path = create_data_user_ce_package_path(uuid_, userId, pkgname, ceDataInode);
-        if (rename_delete_dir_contents_and_dir(path) != 0) {
+        if (rename_delete_package_dir(path, inBackground) != 0) {
             res = error("Failed to delete " + path);
         }
     }
     if (flags & FLAG_STORAGE_DE) {
         auto path = create_data_user_de_package_path(uuid_, userId, pkgname);
-        if (rename_delete_dir_contents_and_dir(path) != 0) {
+        if (rename_delete_package_dir(path, inBackground) != 0) {
             res = error("Failed to delete " + path);
         }
         if ((flags & FLAG_CLEAR_APP_DATA_KEEP_ART_PROFILES) == 0) {
@@ -1283,7 +1331,7 @@ binder::Status InstalldNativeService::destroySdkSandboxDataPackageDirectory(
         }
         bool isCeData = (currentFlag == FLAG_STORAGE_CE);
         auto appPath = create_data_misc_sdk_sandbox_package_path(uuid_, isCeData, userId, pkgname);
-        if (rename_delete_dir_contents_and_dir(appPath) != 0) {
+        if (rename_delete_package_dir(appPath, flags & FLAG_DELETE_IN_BACKGROUND) != 0) {
             res = error("Failed to delete " + appPath);
         }
     }
@@ -1410,6 +1458,18 @@ static int32_t copy_directory_recursive(const char* from, const char* to) {
              (char*)to};
 
     LOG(DEBUG) << "Copying " << from << " to " << to;
+    const auto start = std::chrono::steady_clock::now();
+    CopyTreeStats stats;
+    if (copy_directory_tree(from, to, &stats) == 0) {
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+        LOG(INFO) << "Copied " << from << " to " << to << ": " << stats.files << " files, "
+                  << stats.bytes << " bytes (" << stats.clonedBytes << " cloned) in "
+                  << duration.count() << " ms";
+        return 0;
+    }
+    // cp removes what the failed copy left behind as it copies over it.
+    LOG(WARNING) << "Failed to copy " << from << " to " << to << " in process, falling back to cp";
     return logwrap_fork_execvp(ARRAY_SIZE(argv), argv, nullptr, false, LOG_ALOG, false, nullptr);
 }
 
@@ -1946,6 +2006,7 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         // files from the UIDs which are most over their allocated quota
 
         // 1. Create trackers for every known UID
+        const auto startTime = std::chrono::steady_clock::now();
         atrace_pm_begin("create");
         const auto users = get_known_users(uuid_);
 #ifdef GRANULAR_LOCKS
@@ -2028,6 +2089,7 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
             fts_close(fts);
         }
         atrace_pm_end();
+        const auto createdTime = std::chrono::steady_clock::now();
 
         // 2. Populate tracker stats and insert into priority queue
         atrace_pm_begin("populate");
@@ -2041,6 +2103,27 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
             queue.push(it.second);
         }
         atrace_pm_end();
+        const auto populatedTime = std::chrono::steady_clock::now();
+
+        // Loading the items of a tracker walks all of its cache, so the items left from the
+        // recent calls are purged first, which are the oldest ones unless they changed since.
+        std::map<uid_t, CacheItemIndexEntry> index;
+        {
+            std::lock_guard<std::mutex> lock(mCacheIndexLock);
+            for (auto it = mCacheItemIndex.begin(); it != mCacheItemIndex.end();) {
+                if (startTime - it->second.loadTime > kCacheItemIndexMaxAge) {
+                    it = mCacheItemIndex.erase(it);
+                    continue;
+                }
+                if (it->first.first == uuidString) {
+                    index.insert({it->first.second, it->second});
+                }
+                it++;
+            }
+        }
+        std::unordered_map<uid_t, std::chrono::steady_clock::time_point> loadTimes;
+        int64_t itemsLoaded = 0;
+        int64_t itemsReused = 0;
 
         // 3. Bounce across the queue, freeing items from whichever tracker is
         // the most over their assigned quota
@@ -2066,17 +2149,38 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                     queue.push(active);
                 }
                 active = queue.top(); queue.pop();
-                active->ensureItems();
+                const uid_t uid = active->getUid();
+                if (loadTimes.find(uid) == loadTimes.end()) {
+                    auto search = index.find(uid);
+                    if (search != index.end() &&
+                        search->second.dataPaths == active->getDataPaths()) {
+                        active->reuseItems(search->second.items);
+                        loadTimes[uid] = search->second.loadTime;
+                        itemsReused++;
+                    } else {
+                        active->ensureItems();
+                        loadTimes[uid] = std::chrono::steady_clock::now();
+                        itemsLoaded++;
+                    }
+                }
                 continue;
             }
 
             // If no items remain, go find another tracker
             if (active->items.empty()) {
+                if (active->reloadReusedItems()) {
+                    loadTimes[active->getUid()] = std::chrono::steady_clock::now();
+                    itemsLoaded++;
+                    continue;
+                }
                 active = nullptr;
                 continue;
             } else {
                 auto item = active->items.back();
                 active->items.pop_back();
+                if (active->itemsReused() && !item->isUnchanged()) {
+                    continue;
+                }
 
                 LOG(DEBUG) << "Purging " << item->toString() << " from " << active->toString();
                 if (!noop) {
@@ -2101,6 +2205,24 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
             }
         }
         atrace_pm_end();
+        const auto endTime = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(mCacheIndexLock);
+        // A noop call did not purge the items that it went through.
+        if (!noop) {
+            for (const auto& [uid, loadTime] : loadTimes) {
+                const auto& tracker = trackers[uid];
+                mCacheItemIndex[{uuidString, uid}] = {tracker->getDataPaths(), tracker->items,
+                                                      loadTime};
+            }
+        }
+        mFreeCacheStats.calls++;
+        mFreeCacheStats.totalDuration += endTime - startTime;
+        mFreeCacheStats.lastCreateDuration = createdTime - startTime;
+        mFreeCacheStats.lastPopulateDuration = populatedTime - createdTime;
+        mFreeCacheStats.lastBounceDuration = endTime - populatedTime;
+        mFreeCacheStats.itemsLoaded += itemsLoaded;
+        mFreeCacheStats.itemsReused += itemsReused;
 
     } else {
         return error("Legacy cache logic no longer supported");
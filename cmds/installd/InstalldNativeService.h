@@ -21,6 +21,10 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
 #include <vector>
@@ -35,6 +39,8 @@
 namespace android {
 namespace installd {
 
+class CacheItem;
+
 class InstalldNativeService : public BinderService<InstalldNativeService>, public os::BnInstalld {
 public:
     static status_t start();
@@ -206,6 +212,28 @@ private:
     /* Map from UID to cache quota size */
     std::unordered_map<uid_t, int64_t> mCacheQuotas;
 
+    /* The cache items left by freeCache for each UID, which the next calls purge first */
+    struct CacheItemIndexEntry {
+        std::vector<std::string> dataPaths;
+        std::vector<std::shared_ptr<CacheItem>> items;
+        std::chrono::steady_clock::time_point loadTime;
+    };
+
+    struct FreeCacheStats {
+        int64_t calls = 0;
+        std::chrono::nanoseconds totalDuration{0};
+        std::chrono::nanoseconds lastCreateDuration{0};
+        std::chrono::nanoseconds lastPopulateDuration{0};
+        std::chrono::nanoseconds lastBounceDuration{0};
+        // The number of trackers whose items were loaded from disk or reused from the index.
+        int64_t itemsLoaded = 0;
+        int64_t itemsReused = 0;
+    };
+
+    std::mutex mCacheIndexLock;
+    std::map<std::pair<std::string, uid_t>, CacheItemIndexEntry> mCacheItemIndex;
+    FreeCacheStats mFreeCacheStats;
+
     std::string findDataMediaPath(const std::optional<std::string>& uuid, userid_t userid);
 
     binder::Status createAppDataLocked(const std::optional<std::string>& uuid,
@@ -28,7 +28,10 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <condition_variable>
 #include <iomanip>
 #include <mutex>
 #include <unordered_set>
@@ -87,6 +90,30 @@ constexpr int kShortTimeoutMs = 60000; // 1 minute.
 // aborted before that watchdog would take down the system server.
 constexpr int kLongTimeoutMs = 570000; // 9.5 minutes.
 
+// How long a dex2oat job waits for the running ones to make room for it before it runs anyway, so
+// that the wait and the compilation stay within the Package Manager watchdog.
+constexpr std::chrono::milliseconds kJobSlotTimeout(20000);
+// How often a waiting job checks the available memory, which changes without the running jobs
+// finishing.
+constexpr std::chrono::milliseconds kJobSlotMemoryPollInterval(500);
+// The memory available that another dex2oat job needs to start while others are running.
+constexpr int64_t kMinMemAvailableForJob = 1024 * 1024 * 1024;
+
+// Returns the MemAvailable of /proc/meminfo in bytes, or -1 if it cannot be read.
+int64_t get_mem_available() {
+    std::string meminfo;
+    if (!android::base::ReadFileToString("/proc/meminfo", &meminfo)) {
+        return -1;
+    }
+    constexpr const char* kMemAvailable = "MemAvailable:";
+    size_t pos = meminfo.find(kMemAvailable);
+    if (pos == std::string::npos) {
+        return -1;
+    }
+    int64_t kb = strtoll(meminfo.c_str() + pos + strlen(kMemAvailable), nullptr, 10);
+    return kb * 1024;
+}
+
 class DexOptStatus {
  public:
     // Check if dexopt is cancelled and fork if it is not cancelled.
@@ -107,11 +134,43 @@ class DexOptStatus {
         return pid;
     }
 
+    // Same as check_cancellation_and_fork, for a dex2oat job. The package manager may dexopt
+    // several packages at once, and waits here until the job can run alongside the others: up to
+    // half of the online CPUs, since each dex2oat compiles on several threads, and only one job
+    // when the memory is low. The job counts until check_if_killed_and_remove_dexopt_pid.
+    pid_t wait_for_job_slot_and_fork(/* out */ bool *cancelled) {
+        std::unique_lock<std::mutex> lock(dexopt_lock_);
+        const auto deadline = std::chrono::steady_clock::now() + kJobSlotTimeout;
+        while (!dexopt_blocked_ && !can_start_job_locked()) {
+            if (job_slot_cv_.wait_for(lock, kJobSlotMemoryPollInterval) ==
+                        std::cv_status::timeout &&
+                std::chrono::steady_clock::now() >= deadline) {
+                LOG(WARNING) << "Running a dex2oat job alongside " << job_pids_.size()
+                             << " others after waiting for them";
+                break;
+            }
+        }
+        if (dexopt_blocked_) {
+            *cancelled = true;
+            return -1;
+        }
+        pid_t pid = fork();
+        *cancelled = false;
+        if (pid > 0) { // parent
+            dexopt_pids_.insert(pid);
+            job_pids_.insert(pid);
+        }
+        return pid;
+    }
+
     // Returns true if pid was killed (is in killed list). It could have finished if killing
     // happened after the process is finished.
     bool check_if_killed_and_remove_dexopt_pid(pid_t pid) {
         std::lock_guard<std::mutex> lock(dexopt_lock_);
         dexopt_pids_.erase(pid);
+        if (job_pids_.erase(pid) == 1) {
+            job_slot_cv_.notify_one();
+        }
         if (dexopt_killed_pids_.erase(pid) == 1) {
             return true;
         }
@@ -131,6 +190,8 @@ class DexOptStatus {
         if (!block) {
             return;
         }
+        // The waiting jobs are cancelled as well.
+        job_slot_cv_.notify_all();
         // Blocked, also kill currently running tasks
         for (auto pid : dexopt_pids_) {
             LOG(INFO) << "control_dexopt_blocking kill pid:" << pid;
@@ -141,6 +202,18 @@ class DexOptStatus {
     }
 
  private:
+    bool can_start_job_locked() {
+        if (job_pids_.empty()) {
+            return true;
+        }
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (job_pids_.size() >= static_cast<size_t>(std::max(1L, cpus / 2))) {
+            return false;
+        }
+        const int64_t mem_available = get_mem_available();
+        return mem_available == -1 || mem_available >= kMinMemAvailableForJob;
+    }
+
     std::mutex dexopt_lock_;
     // when true, dexopt is blocked and will not run.
     bool dexopt_blocked_ GUARDED_BY(dexopt_lock_) = false;
@@ -149,6 +222,10 @@ class DexOptStatus {
     std::unordered_set<pid_t> dexopt_pids_ GUARDED_BY(dexopt_lock_);
     // PIDs of child processes killed by cancellation.
     std::unordered_set<pid_t> dexopt_killed_pids_ GUARDED_BY(dexopt_lock_);
+    // PIDs of the running dex2oat jobs, a subset of dexopt_pids_.
+    std::unordered_set<pid_t> job_pids_ GUARDED_BY(dexopt_lock_);
+    // Notified when a job finishes, or when dexopt is blocked.
+    std::condition_variable job_slot_cv_;
 };
 
 android::base::NoDestructor<DexOptStatus> dexopt_status_;
@@ -1969,7 +2046,7 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
                       background_job_compile, compilation_reason);
 
     bool cancelled = false;
-    pid_t pid = dexopt_status_->check_cancellation_and_fork(&cancelled);
+    pid_t pid = dexopt_status_->wait_for_job_slot_and_fork(&cancelled);
     if (cancelled) {
         *completed = false;
         reference_profile.DisableCleanup();
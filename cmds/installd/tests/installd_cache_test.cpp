@@ -237,6 +237,33 @@ TEST_F(CacheTest, FreeCache_Age) {
     EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
 }
 
+TEST_F(CacheTest, FreeCache_RewrittenSinceLastCall) {
+    LOG(INFO) << "FreeCache_RewrittenSinceLastCall";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", kMbInBytes, 60);
+    touch("com.example/cache/foo/two", kMbInBytes, 120);
+    touch("com.example/cache/foo/three", kMbInBytes, 180);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/three"));
+
+    // The next call purges the items left by the first one, except those changed since.
+    touch("com.example/cache/foo/two", kMbInBytes, 240);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(-1, exists("com.example/cache/foo/three"));
+}
+
 TEST_F(CacheTest, FreeCache_Tombstone) {
     LOG(INFO) << "FreeCache_Tombstone";
 
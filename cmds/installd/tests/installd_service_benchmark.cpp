@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+#include <cutils/properties.h>
+
+#include "InstalldNativeService.h"
+#include "globals.h"
+#include "utils.h"
+
+// Usage: atest installd_service_benchmark
+// Sets up the data of apps in /data/local/tmp, which the "TEST" volume maps to, as root.
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace installd {
+
+int get_property(const char *key, char *value, const char *default_value) {
+    return property_get(key, value, default_value);
+}
+
+bool calculate_oat_file_path(char path[PKG_PATH_MAX], const char *oat_dir, const char *apk_path,
+        const char *instruction_set) {
+    return calculate_oat_file_path_default(path, oat_dir, apk_path, instruction_set);
+}
+
+bool calculate_odex_file_path(char path[PKG_PATH_MAX], const char *apk_path,
+        const char *instruction_set) {
+    return calculate_odex_file_path_default(path, apk_path, instruction_set);
+}
+
+bool create_cache_path(char path[PKG_PATH_MAX], const char *src, const char *instruction_set) {
+    return create_cache_path_default(path, src, instruction_set);
+}
+
+bool force_compile_without_image() {
+    return false;
+}
+
+namespace {
+
+constexpr const char* kTestUuid = "TEST";
+constexpr int kPackages = 300;
+constexpr int32_t kUserIds[] = {0, 10};
+constexpr const char* kDataDirs[] = {"user", "user_de", "misc_ce", "misc_de"};
+
+void clear_app_data() {
+    for (const char* dir : kDataDirs) {
+        delete_dir_contents_and_dir(StringPrintf("/data/local/tmp/%s", dir), true);
+    }
+}
+
+bool create_user_dirs() {
+    for (const char* dir : kDataDirs) {
+        const std::string path = StringPrintf("/data/local/tmp/%s", dir);
+        if (create_dir_if_needed(path, 0700) != 0) {
+            return false;
+        }
+        for (int32_t userId : kUserIds) {
+            if (create_dir_if_needed(StringPrintf("%s/%d", path.c_str(), userId), 0700) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The first boot of a device with two users, which sets up the data of every app for each user.
+std::vector<android::os::CreateAppDataArgs> create_args() {
+    std::vector<android::os::CreateAppDataArgs> args;
+    for (int32_t userId : kUserIds) {
+        for (int i = 0; i < kPackages; i++) {
+            android::os::CreateAppDataArgs arg;
+            arg.uuid = kTestUuid;
+            arg.packageName = StringPrintf("com.example.benchmark%d", i);
+            arg.userId = userId;
+            arg.appId = 10000 + i;
+            arg.previousAppId = -1;
+            arg.seInfo = "default";
+            arg.flags = InstalldNativeService::FLAG_STORAGE_CE |
+                    InstalldNativeService::FLAG_STORAGE_DE;
+            args.push_back(arg);
+        }
+    }
+    return args;
+}
+
+template <typename Create>
+void run_create_app_data(benchmark::State& state, Create create) {
+    android::base::SetMinimumLogSeverity(android::base::WARNING);
+    init_globals_from_data_and_root();
+    InstalldNativeService service;
+    const std::vector<android::os::CreateAppDataArgs> args = create_args();
+    for (auto _ : state) {
+        state.PauseTiming();
+        clear_app_data();
+        if (!create_user_dirs()) {
+            state.SkipWithError("Could not create the user directories");
+            break;
+        }
+        state.ResumeTiming();
+        create(service, args);
+    }
+    state.SetItemsProcessed(state.iterations() * args.size());
+    clear_app_data();
+}
+
+void BM_CreateAppData(benchmark::State& state) {
+    run_create_app_data(state,
+                        [](InstalldNativeService& service,
+                           const std::vector<android::os::CreateAppDataArgs>& args) {
+                            for (const auto& arg : args) {
+                                android::os::CreateAppDataResult result;
+                                service.createAppData(arg, &result);
+                            }
+                        });
+}
+BENCHMARK(BM_CreateAppData)->Unit(benchmark::kMillisecond);
+
+void BM_CreateAppDataBatched(benchmark::State& state) {
+    run_create_app_data(state,
+                        [](InstalldNativeService& service,
+                           const std::vector<android::os::CreateAppDataArgs>& args) {
+                            std::vector<android::os::CreateAppDataResult> results;
+                            service.createAppDataBatched(args, &results);
+                        });
+}
+BENCHMARK(BM_CreateAppDataBatched)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace installd
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -300,6 +300,56 @@ TEST_F(ServiceTest, DestroyAppData) {
     EXPECT_FALSE(exists_renamed_deleted_dir("/user/0"));
 }
 
+TEST_F(ServiceTest, DestroyAppData_InBackground) {
+    LOG(INFO) << "DestroyAppData_InBackground";
+
+    mkdir("user/0/com.example", 10000, 10000, 0700);
+    mkdir("user/0/com.example/foo", 10000, 10000, 0700);
+    touch("user/0/com.example/foo/file", 10000, 20000, 0700);
+
+    service->destroyAppData(testUuid, "com.example", 0,
+                            FLAG_STORAGE_DE | FLAG_STORAGE_CE |
+                                    InstalldNativeService::FLAG_DELETE_IN_BACKGROUND,
+                            0);
+
+    // The data is out of the way once the call returns.
+    EXPECT_FALSE(exists("user/0/com.example"));
+
+    wait_for_background_deletions();
+    EXPECT_FALSE(exists_renamed_deleted_dir("/user/0"));
+}
+
+TEST_F(ServiceTest, CreateAppDataBatched) {
+    LOG(INFO) << "CreateAppDataBatched";
+
+    std::vector<android::os::CreateAppDataArgs> args;
+    for (int i = 0; i < 16; i++) {
+        android::os::CreateAppDataArgs arg;
+        arg.uuid = testUuid;
+        // One malformed package name, to check that each app gets its own result.
+        arg.packageName = i == 5 ? "../com.example" : StringPrintf("com.example%d", i);
+        arg.userId = 0;
+        arg.appId = 10000 + i;
+        arg.previousAppId = -1;
+        arg.seInfo = "default";
+        arg.flags = FLAG_STORAGE_CE;
+        args.push_back(arg);
+    }
+
+    std::vector<android::os::CreateAppDataResult> results;
+    ASSERT_BINDER_SUCCESS(service->createAppDataBatched(args, &results));
+
+    ASSERT_EQ(args.size(), results.size());
+    for (size_t i = 0; i < args.size(); i++) {
+        if (i == 5) {
+            EXPECT_EQ(binder::Status::EX_ILLEGAL_ARGUMENT, results[i].exceptionCode);
+            continue;
+        }
+        EXPECT_EQ(binder::Status::EX_NONE, results[i].exceptionCode) << args[i].packageName;
+        EXPECT_TRUE(exists("user/0/" + args[i].packageName));
+    }
+}
+
 TEST_F(ServiceTest, CleanupInvalidPackageDirs) {
     LOG(INFO) << "CleanupInvalidPackageDirs";
 
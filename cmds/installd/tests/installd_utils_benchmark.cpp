@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+
+#include "utils.h"
+
+// Usage: atest installd_utils_benchmark
+
+namespace android {
+namespace installd {
+namespace {
+
+constexpr int kFilesPerDir = 1000;
+
+// Creates a tree of directories with kFilesPerDir small files each, like the caches of apps
+// which are measured when quotas are not supported.
+bool create_tree(const std::string& root, int64_t files) {
+    if (mkdir(root.c_str(), 0700) != 0) {
+        return false;
+    }
+    for (int64_t dir = 0; dir * kFilesPerDir < files; dir++) {
+        const std::string dir_path = android::base::StringPrintf("%s/%" PRId64, root.c_str(), dir);
+        if (mkdir(dir_path.c_str(), 0700) != 0) {
+            return false;
+        }
+        for (int file = 0; file < kFilesPerDir && dir * kFilesPerDir + file < files; file++) {
+            const std::string path = android::base::StringPrintf("%s/%d", dir_path.c_str(), file);
+            if (!android::base::WriteStringToFile("cache", path)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void BM_CalculateTreeSize(benchmark::State& state) {
+    const int64_t files = state.range(0);
+    const std::string root = "/data/local/tmp/installd_utils_benchmark";
+    delete_dir_contents_and_dir(root, true /* ignore_if_missing */);
+    if (!create_tree(root, files)) {
+        delete_dir_contents_and_dir(root, true /* ignore_if_missing */);
+        state.SkipWithError("Could not create the tree");
+        return;
+    }
+    for (auto _ : state) {
+        int64_t size = 0;
+        calculate_tree_size(root, &size);
+        benchmark::DoNotOptimize(size);
+    }
+    state.SetItemsProcessed(state.iterations() * files);
+    delete_dir_contents_and_dir(root, true /* ignore_if_missing */);
+}
+BENCHMARK(BM_CalculateTreeSize)
+        ->RangeMultiplier(10)
+        ->Range(10000, 1000000)
+        ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace installd
+}  // namespace android
+
+BENCHMARK_MAIN();
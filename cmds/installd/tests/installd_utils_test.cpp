@@ -15,12 +15,18 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/scopeguard.h>
+#include <android-base/stringprintf.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -678,6 +684,147 @@ TEST_F(UtilsTest, TestForEachSubdir) {
     EXPECT_THAT(result, UnorderedElementsAre("com.foo", "com.bar"));
 }
 
+static int64_t sTreeSize;
+
+static int add_tree_entry_size(const char*, const struct stat* st, int, struct FTW*) {
+    sTreeSize += st->st_blocks * 512;
+    return 0;
+}
+
+static int64_t measure_tree_with_nftw(const char* path) {
+    sTreeSize = 0;
+    nftw(path, add_tree_entry_size, 16, FTW_PHYS | FTW_MOUNT);
+    return sTreeSize;
+}
+
+TEST_F(UtilsTest, TestCalculateTreeSize) {
+    const std::string root = "/data/local/tmp/user/0/tree";
+    auto deleter = [&]() {
+        delete_dir_contents_and_dir("/data/local/tmp/user/0", true /* ignore_if_missing */);
+    };
+    auto scope_guard = android::base::make_scope_guard(deleter);
+
+    // Enough directories for the walk to be spread over several threads.
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 8; j++) {
+            const std::string dir = android::base::StringPrintf("%s/%d/%d", root.c_str(), i, j);
+            ASSERT_EQ(0, system(("mkdir -p " + dir).c_str()));
+            for (int k = 0; k < 8; k++) {
+                ASSERT_TRUE(android::base::WriteStringToFile(std::string(k * 1000, 'x'),
+                                                             dir + "/" + std::to_string(k)));
+            }
+        }
+    }
+    ASSERT_EQ(0, symlink("/data/local/tmp", (root + "/link").c_str()));
+
+    const int64_t expected = measure_tree_with_nftw(root.c_str());
+    ASSERT_GT(expected, 0);
+
+    int64_t size = 0;
+    EXPECT_EQ(0, calculate_tree_size(root, &size));
+    EXPECT_EQ(expected, size);
+
+    size = 0;
+    EXPECT_EQ(0, calculate_tree_size(root, &size, getegid()));
+    EXPECT_EQ(expected, size);
+
+    size = 0;
+    EXPECT_EQ(0, calculate_tree_size(root, &size, -1, getegid()));
+    EXPECT_EQ(0, size);
+
+    // The size is added to the one passed in.
+    size = 1;
+    EXPECT_EQ(0, calculate_tree_size(root + "/0/0/1", &size));
+    EXPECT_EQ(measure_tree_with_nftw((root + "/0/0/1").c_str()) + 1, size);
+
+    size = 0;
+    EXPECT_EQ(-1, calculate_tree_size(root + "/missing", &size));
+    EXPECT_EQ(0, size);
+}
+
+TEST_F(UtilsTest, TestCalculateTreeSizeDeep) {
+    const std::string root = "/data/local/tmp/user/0/tree";
+    auto deleter = [&]() {
+        delete_dir_contents_and_dir("/data/local/tmp/user/0", true /* ignore_if_missing */);
+    };
+    auto scope_guard = android::base::make_scope_guard(deleter);
+
+    // Deeper than the directories that can be open at once.
+    constexpr int kDepth = 256;
+    std::string dir = root;
+    for (int i = 0; i < kDepth; i++) {
+        dir += "/d";
+    }
+    ASSERT_EQ(0, system(("mkdir -p " + dir).c_str()));
+    ASSERT_TRUE(android::base::WriteStringToFile(std::string(10000, 'x'), dir + "/file"));
+
+    const int64_t expected = measure_tree_with_nftw(root.c_str());
+    ASSERT_GT(expected, 0);
+
+    struct rlimit limit;
+    ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+    const struct rlimit lowered = {.rlim_cur = kDepth / 2, .rlim_max = limit.rlim_max};
+    ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &lowered));
+    auto restore_limit =
+            android::base::make_scope_guard([&]() { setrlimit(RLIMIT_NOFILE, &limit); });
+
+    int64_t size = 0;
+    EXPECT_EQ(0, calculate_tree_size(root, &size));
+    EXPECT_EQ(expected, size);
+}
+
+TEST_F(UtilsTest, TestCopyDirectoryTree) {
+    const std::string root = "/data/local/tmp/user/0";
+    auto deleter = [&]() { delete_dir_contents_and_dir(root, true /* ignore_if_missing */); };
+    auto scope_guard = android::base::make_scope_guard(deleter);
+
+    const std::string from = root + "/from/com.foo";
+    const std::string to = root + "/to";
+    ASSERT_EQ(0, system(("mkdir -p " + from + "/dir/subdir " + to + "/com.foo/dir").c_str()));
+    for (int i = 0; i < 16; i++) {
+        ASSERT_TRUE(android::base::WriteStringToFile(std::string(i * 10000, 'x'),
+                                                     from + "/dir/" + std::to_string(i)));
+    }
+    ASSERT_TRUE(android::base::WriteStringToFile("new", from + "/dir/subdir/file"));
+    ASSERT_EQ(0, chmod((from + "/dir/subdir/file").c_str(), 0640));
+    ASSERT_EQ(0, symlink("../missing", (from + "/link").c_str()));
+    ASSERT_EQ(0, chmod((from + "/dir/subdir").c_str(), 0500));
+    const struct timespec times[2] = {{.tv_sec = 1000}, {.tv_sec = 2000}};
+    ASSERT_EQ(0, utimensat(AT_FDCWD, (from + "/dir").c_str(), times, 0));
+    // An existing destination is replaced.
+    ASSERT_TRUE(android::base::WriteStringToFile("old", to + "/com.foo/dir/0"));
+
+    CopyTreeStats stats;
+    ASSERT_EQ(0, copy_directory_tree(from, to, &stats));
+    EXPECT_EQ(17, stats.files);
+
+    std::string content;
+    ASSERT_TRUE(android::base::ReadFileToString(to + "/com.foo/dir/0", &content));
+    EXPECT_EQ("", content);
+    ASSERT_TRUE(android::base::ReadFileToString(to + "/com.foo/dir/15", &content));
+    EXPECT_EQ(std::string(150000, 'x'), content);
+    ASSERT_TRUE(android::base::ReadFileToString(to + "/com.foo/dir/subdir/file", &content));
+    EXPECT_EQ("new", content);
+
+    int64_t bytes = 0;
+    for (int i = 0; i < 16; i++) bytes += i * 10000;
+    EXPECT_EQ(bytes + 3, stats.bytes);
+
+    struct stat st;
+    ASSERT_EQ(0, stat((to + "/com.foo/dir/subdir/file").c_str(), &st));
+    EXPECT_EQ(0640u, st.st_mode & 07777);
+    ASSERT_EQ(0, stat((to + "/com.foo/dir/subdir").c_str(), &st));
+    EXPECT_EQ(0500u, st.st_mode & 07777);
+    ASSERT_EQ(0, stat((to + "/com.foo/dir").c_str(), &st));
+    EXPECT_EQ(2000, st.st_mtim.tv_sec);
+    std::string target;
+    ASSERT_TRUE(android::base::Readlink(to + "/com.foo/link", &target));
+    EXPECT_EQ("../missing", target);
+
+    ASSERT_EQ(0, chmod((from + "/dir/subdir").c_str(), 0700));
+    ASSERT_EQ(0, chmod((to + "/com.foo/dir/subdir").c_str(), 0700));
+}
+
 TEST_F(UtilsTest, TestSdkSandboxDataPaths) {
     // Ce data paths
     EXPECT_EQ("/data/misc_ce/0/sdksandbox",
@@ -22,6 +22,7 @@
 #include <poll.h>
 #include <stdlib.h>
 #include <sys/capability.h>
+#include <sys/ioctl.h>
 #include <sys/pidfd.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
@@ -30,8 +31,17 @@
 #include <unistd.h>
 #include <uuid/uuid.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/no_destructor.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 #include <android-base/unique_fd.h>
@@ -464,47 +474,220 @@ int set_quota_project_id(const std::string& path, long project_id, bool set_inhe
     return 0;
 }
 
-int calculate_tree_size(const std::string& path, int64_t* size,
-        int32_t include_gid, int32_t exclude_gid, bool exclude_apps) {
-    FTS *fts;
-    FTSENT *p;
-    int64_t matchedSize = 0;
-    char *argv[] = { (char*) path.c_str(), nullptr };
-    if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
-        if (errno != ENOENT) {
-            PLOG(ERROR) << "Failed to fts_open " << path;
+namespace {
+
+// The maximum number of threads, including the calling one, that a tree is measured with.
+constexpr size_t kTreeSizeThreads = 4;
+
+/**
+ * Measures a directory tree without crossing file systems, on up to kTreeSizeThreads threads.
+ *
+ * Each thread walks the directories it is given depth first, and hands the subdirectories it
+ * finds over to another thread while there is one to be started or waiting for work. The other
+ * threads are only started when there are directories for them, so that measuring a small
+ * tree costs no more than walking it.
+ *
+ * Like fts with FTS_NOCHDIR, the entries of a directory are all read before its subdirectories
+ * are opened by path, so that a thread only has one directory open however deep the tree is.
+ */
+class TreeSizeCalculator {
+public:
+    TreeSizeCalculator(dev_t dev, int32_t include_gid, int32_t exclude_gid, bool exclude_apps)
+          : mDev(dev),
+            mIncludeGid(include_gid),
+            mExcludeGid(exclude_gid),
+            mExcludeApps(exclude_apps) {}
+
+    // Returns whether the entry, and for a directory everything in it, is left out.
+    bool isExcluded(const struct stat& st) const {
+        if (!mExcludeApps) {
+            return false;
+        }
+        int32_t user_uid = multiuser_get_app_id(st.st_uid);
+        int32_t user_gid = multiuser_get_app_id(st.st_gid);
+        return (user_uid >= AID_APP_START && user_uid <= AID_APP_END)
+                || (user_gid >= AID_CACHE_GID_START && user_gid <= AID_CACHE_GID_END)
+                || (user_gid >= AID_SHARED_GID_START && user_gid <= AID_SHARED_GID_END);
+    }
+
+    // Returns the size that the entry itself adds to the total.
+    int64_t getSize(const struct stat& st) const {
+        int32_t gid = st.st_gid;
+        if ((mIncludeGid != -1 && gid != mIncludeGid) ||
+            (mExcludeGid != -1 && gid == mExcludeGid)) {
+            return 0;
+        }
+        return st.st_blocks * 512;
+    }
+
+    // Returns the size of everything inside of the directory.
+    int64_t measure(const std::string& path, ino_t ino) {
+        std::unique_lock lock(mLock);
+        mQueue.push_back({path, std::make_shared<const Directory>(ino, nullptr)});
+        runLocked(lock);
+        std::vector<std::thread> threads = std::move(mThreads);
+        lock.unlock();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return mSize;
+    }
+
+private:
+    // A directory being walked, and the directories above it, with which the cycles of bind
+    // mounts are detected like fts does.
+    struct Directory {
+        Directory(ino_t ino, std::shared_ptr<const Directory> parent)
+              : ino(ino), parent(std::move(parent)) {}
+        const ino_t ino;
+        const std::shared_ptr<const Directory> parent;
+
+        bool isInside(ino_t other) const {
+            for (const Directory* dir = this; dir != nullptr; dir = dir->parent.get()) {
+                if (dir->ino == other) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct PendingDirectory {
+        std::string path;
+        std::shared_ptr<const Directory> directory;
+    };
+
+    // Measures the queued directories until all the directories of the tree are measured.
+    void runLocked(std::unique_lock<std::mutex>& lock) {
+        while (true) {
+            mCondition.wait(lock, [this] { return !mQueue.empty() || mBusy == 0; });
+            if (mQueue.empty()) {
+                return;
+            }
+            PendingDirectory pending = std::move(mQueue.front());
+            mQueue.pop_front();
+            mBusy++;
+            lock.unlock();
+            int64_t size = walk(std::move(pending));
+            lock.lock();
+            mSize += size;
+            if (--mBusy == 0 && mQueue.empty()) {
+                mCondition.notify_all();
+            }
         }
-        return -1;
     }
-    while ((p = fts_read(fts)) != nullptr) {
-        switch (p->fts_info) {
-        case FTS_D:
-        case FTS_DEFAULT:
-        case FTS_F:
-        case FTS_SL:
-        case FTS_SLNONE:
-            int32_t uid = p->fts_statp->st_uid;
-            int32_t gid = p->fts_statp->st_gid;
-            int32_t user_uid = multiuser_get_app_id(uid);
-            int32_t user_gid = multiuser_get_app_id(gid);
-            if (exclude_apps && ((user_uid >= AID_APP_START && user_uid <= AID_APP_END)
-                    || (user_gid >= AID_CACHE_GID_START && user_gid <= AID_CACHE_GID_END)
-                    || (user_gid >= AID_SHARED_GID_START && user_gid <= AID_SHARED_GID_END))) {
-                // Don't traverse inside or measure
-                fts_set(fts, p, FTS_SKIP);
-                break;
+
+    // Queues the directory if a thread is waiting for work or can be started. Returns false if
+    // the caller has to walk the directory itself.
+    bool offload(PendingDirectory& pending) {
+        std::lock_guard lock(mLock);
+        // Every thread which is not walking is either waiting for a queued directory, or is yet
+        // to be started.
+        if (mBusy + mQueue.size() >= kTreeSizeThreads) {
+            return false;
+        }
+        mQueue.push_back(std::move(pending));
+        if (mBusy + mQueue.size() > mThreads.size() + 1) {
+            mThreads.emplace_back([this] {
+                std::unique_lock lock(mLock);
+                runLocked(lock);
+            });
+        } else {
+            mCondition.notify_one();
+        }
+        return true;
+    }
+
+    // Walks the directory and the subdirectories that are not handed over to other threads.
+    int64_t walk(PendingDirectory root) {
+        int64_t size = 0;
+        std::vector<PendingDirectory> pending;
+        pending.push_back(std::move(root));
+        while (!pending.empty()) {
+            PendingDirectory current = std::move(pending.back());
+            pending.pop_back();
+
+            // Directories which cannot be opened are measured but not traversed, as fts would.
+            unique_fd fd(open(current.path.c_str(),
+                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0) {
+                PLOG(WARNING) << "Failed to open " << current.path;
+                continue;
             }
-            if (include_gid != -1 && gid != include_gid) {
-                break;
+            if (st.st_dev != mDev || st.st_ino != current.directory->ino) {
+                LOG(WARNING) << "Skipping " << current.path << " which was replaced while measured";
+                continue;
             }
-            if (exclude_gid != -1 && gid == exclude_gid) {
-                break;
+            std::unique_ptr<DIR, decltype(&closedir)> dir(Fdopendir(std::move(fd)), closedir);
+            if (dir == nullptr) {
+                PLOG(WARNING) << "Failed to open " << current.path;
+                continue;
+            }
+
+            struct dirent* de;
+            while ((de = readdir(dir.get())) != nullptr) {
+                if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) {
+                    continue;
+                }
+                if (fstatat(dirfd(dir.get()), de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 ||
+                    isExcluded(st)) {
+                    continue;
+                }
+                const bool is_dir = S_ISDIR(st.st_mode);
+                if (is_dir && st.st_dev == mDev && current.directory->isInside(st.st_ino)) {
+                    continue;
+                }
+                size += getSize(st);
+                if (!is_dir || st.st_dev != mDev) {
+                    continue;
+                }
+                PendingDirectory subdir{current.path + "/" + de->d_name,
+                                        std::make_shared<const Directory>(st.st_ino,
+                                                                          current.directory)};
+                if (!offload(subdir)) {
+                    pending.push_back(std::move(subdir));
+                }
             }
-            matchedSize += (p->fts_statp->st_blocks * 512);
-            break;
         }
+        return size;
+    }
+
+    const dev_t mDev;
+    const int32_t mIncludeGid;
+    const int32_t mExcludeGid;
+    const bool mExcludeApps;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    // The directories waiting for a thread.
+    std::deque<PendingDirectory> mQueue;
+    // The number of threads walking directories.
+    size_t mBusy = 0;
+    std::vector<std::thread> mThreads;
+    int64_t mSize = 0;
+};
+
+}  // namespace
+
+int calculate_tree_size(const std::string& path, int64_t* size,
+        int32_t include_gid, int32_t exclude_gid, bool exclude_apps) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        if (errno != ENOENT) {
+            PLOG(ERROR) << "Failed to lstat " << path;
+        }
+        return -1;
+    }
+    TreeSizeCalculator calculator(st.st_dev, include_gid, exclude_gid, exclude_apps);
+    if (calculator.isExcluded(st)) {
+        // Don't traverse inside or measure
+        return 0;
+    }
+    int64_t matchedSize = calculator.getSize(st);
+    if (S_ISDIR(st.st_mode)) {
+        matchedSize += calculator.measure(path, st.st_ino);
     }
-    fts_close(fts);
 #if MEASURE_DEBUG
     if ((include_gid == -1) && (exclude_gid == -1)) {
         LOG(DEBUG) << "Measured " << path << " size " << matchedSize;
@@ -698,23 +881,85 @@ static std::string make_unique_name(std::string_view suffix) {
     return name;
 }
 
-static int rename_delete_dir_contents(const std::string& pathname,
-                                      int (*exclusion_predicate)(const char*, const int),
-                                      bool ignore_if_missing) {
+namespace {
+
+/**
+ * Deletes the directories renamed by rename_delete_dir_contents_and_dir_in_background, one after
+ * the other, on a thread which is started with the first one.
+ */
+class BackgroundDeleter {
+public:
+    void enqueue(std::string path) {
+        std::lock_guard lock(mLock);
+        mQueue.push_back(std::move(path));
+        if (!mStarted) {
+            // installd never exits, so neither does the thread.
+            std::thread([this] { run(); }).detach();
+            mStarted = true;
+        }
+        mCondition.notify_all();
+    }
+
+    void waitUntilIdle() {
+        std::unique_lock lock(mLock);
+        mCondition.wait(lock, [this] { return mQueue.empty() && !mDeleting; });
+    }
+
+private:
+    void run() {
+        std::unique_lock lock(mLock);
+        while (true) {
+            mCondition.wait(lock, [this] { return !mQueue.empty(); });
+            std::string path = std::move(mQueue.front());
+            mQueue.pop_front();
+            mDeleting = true;
+            lock.unlock();
+            delete_dir_contents(path.c_str(), 1, nullptr, true);
+            lock.lock();
+            mDeleting = false;
+            mCondition.notify_all();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::deque<std::string> mQueue;
+    bool mDeleting = false;
+    bool mStarted = false;
+};
+
+android::base::NoDestructor<BackgroundDeleter> sBackgroundDeleter;
+
+}  // namespace
+
+// Renames the directory next to itself, so that it is out of the way of a directory created at the
+// same path, and returns the new path. Returns the path itself if it cannot be renamed, or an
+// empty path if it is missing while that is allowed.
+static std::string rename_dir_to_delete(const std::string& pathname, bool ignore_if_missing) {
     auto temp_dir_name = make_unique_name(deletedSuffix);
     auto temp_dir_path =
             base::StringPrintf("%s/%s", Dirname(pathname).c_str(), temp_dir_name.c_str());
 
-    auto dir_to_delete = temp_dir_path.c_str();
-    if (::rename(pathname.c_str(), dir_to_delete)) {
+    if (::rename(pathname.c_str(), temp_dir_path.c_str())) {
         if (ignore_if_missing && (errno == ENOENT)) {
-            return 0;
+            return "";
         }
-        ALOGE("Couldn't rename %s -> %s: %s \n", pathname.c_str(), dir_to_delete, strerror(errno));
-        dir_to_delete = pathname.c_str();
+        ALOGE("Couldn't rename %s -> %s: %s \n", pathname.c_str(), temp_dir_path.c_str(),
+              strerror(errno));
+        return pathname;
+    }
+    return temp_dir_path;
+}
+
+static int rename_delete_dir_contents(const std::string& pathname,
+                                      int (*exclusion_predicate)(const char*, const int),
+                                      bool ignore_if_missing) {
+    auto dir_to_delete = rename_dir_to_delete(pathname, ignore_if_missing);
+    if (dir_to_delete.empty()) {
+        return 0;
     }
 
-    return delete_dir_contents(dir_to_delete, 1, exclusion_predicate, ignore_if_missing);
+    return delete_dir_contents(dir_to_delete.c_str(), 1, exclusion_predicate, ignore_if_missing);
 }
 
 bool is_renamed_deleted_dir(const std::string& path) {
@@ -729,6 +974,24 @@ int rename_delete_dir_contents_and_dir(const std::string& pathname, bool ignore_
     return rename_delete_dir_contents(pathname, nullptr, ignore_if_missing);
 }
 
+int rename_delete_dir_contents_and_dir_in_background(const std::string& pathname,
+                                                     bool ignore_if_missing) {
+    auto dir_to_delete = rename_dir_to_delete(pathname, ignore_if_missing);
+    if (dir_to_delete.empty()) {
+        return 0;
+    }
+    if (dir_to_delete == pathname) {
+        // The directory is still in the way, so it is deleted right away.
+        return delete_dir_contents(dir_to_delete.c_str(), 1, nullptr, ignore_if_missing);
+    }
+    sBackgroundDeleter->enqueue(std::move(dir_to_delete));
+    return 0;
+}
+
+void wait_for_background_deletions() {
+    sBackgroundDeleter->waitUntilIdle();
+}
+
 static auto open_dir(const char* dir) {
     struct DirCloser {
         void operator()(DIR* d) const noexcept { ::closedir(d); }
@@ -919,6 +1182,322 @@ int copy_dir_files(const char *srcname,
     return res;
 }
 
+namespace {
+
+constexpr size_t kCopyTreeThreads = 4;
+
+struct CopiedFile {
+    std::string from;
+    std::string to;
+    struct stat st;
+};
+
+// Copies the xattrs with the given calls to list, get and set them.
+template <typename List, typename Get, typename Set>
+int copy_xattrs(const std::string& from, const std::string& to, List list, Get get, Set set) {
+    ssize_t size = list(nullptr, 0);
+    if (size < 0) {
+        if (errno == EOPNOTSUPP) return 0;
+        PLOG(ERROR) << "Failed to list xattrs of " << from;
+        return -1;
+    }
+    std::vector<char> names(size);
+    size = list(names.data(), names.size());
+    if (size < 0) {
+        PLOG(ERROR) << "Failed to list xattrs of " << from;
+        return -1;
+    }
+    std::vector<char> value;
+    for (const char* name = names.data(); name < names.data() + size;
+         name += strlen(name) + 1) {
+        ssize_t value_size = get(name, nullptr, 0);
+        if (value_size >= 0) {
+            value.resize(value_size);
+            value_size = get(name, value.data(), value.size());
+        }
+        if (value_size < 0) {
+            PLOG(ERROR) << "Failed to get xattr " << name << " of " << from;
+            return -1;
+        }
+        if (set(name, value.data(), value_size) != 0) {
+            PLOG(ERROR) << "Failed to set xattr " << name << " of " << to;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Copies the owner, the mode, the xattrs and the timestamps, in that order since setting the
+// owner clears the setuid bits of the mode. The files are open, so that they cannot be replaced
+// meanwhile, e.g. by symlinks.
+int copy_attributes(int from_fd, const std::string& from, int to_fd, const std::string& to,
+                    const struct stat& st) {
+    if (fchown(to_fd, st.st_uid, st.st_gid) != 0) {
+        PLOG(ERROR) << "Failed to chown " << to;
+        return -1;
+    }
+    if (fchmod(to_fd, st.st_mode & 07777) != 0) {
+        PLOG(ERROR) << "Failed to chmod " << to;
+        return -1;
+    }
+    if (copy_xattrs(
+                from, to,
+                [&](char* names, size_t size) { return flistxattr(from_fd, names, size); },
+                [&](const char* name, void* value, size_t size) {
+                    return fgetxattr(from_fd, name, value, size);
+                },
+                [&](const char* name, const void* value, size_t size) {
+                    return fsetxattr(to_fd, name, value, size, 0);
+                }) != 0) {
+        return -1;
+    }
+    const struct timespec times[2] = {st.st_atim, st.st_mtim};
+    if (futimens(to_fd, times) != 0) {
+        PLOG(ERROR) << "Failed to set the timestamps of " << to;
+        return -1;
+    }
+    return 0;
+}
+
+// Copies the attributes of a symlink, or of a special file which is not opened, by path without
+// following symlinks.
+int copy_attributes(const std::string& from, const std::string& to, const struct stat& st) {
+    if (lchown(to.c_str(), st.st_uid, st.st_gid) != 0) {
+        PLOG(ERROR) << "Failed to chown " << to;
+        return -1;
+    }
+    if (!S_ISLNK(st.st_mode) &&
+        fchmodat(AT_FDCWD, to.c_str(), st.st_mode & 07777, AT_SYMLINK_NOFOLLOW) != 0) {
+        PLOG(ERROR) << "Failed to chmod " << to;
+        return -1;
+    }
+    if (copy_xattrs(
+                from, to,
+                [&](char* names, size_t size) { return llistxattr(from.c_str(), names, size); },
+                [&](const char* name, void* value, size_t size) {
+                    return lgetxattr(from.c_str(), name, value, size);
+                },
+                [&](const char* name, const void* value, size_t size) {
+                    return lsetxattr(to.c_str(), name, value, size, 0);
+                }) != 0) {
+        return -1;
+    }
+    const struct timespec times[2] = {st.st_atim, st.st_mtim};
+    if (utimensat(AT_FDCWD, to.c_str(), times, AT_SYMLINK_NOFOLLOW) != 0) {
+        PLOG(ERROR) << "Failed to set the timestamps of " << to;
+        return -1;
+    }
+    return 0;
+}
+
+// Removes a destination which is not a directory, the way cp -F does.
+int remove_destination(const std::string& path) {
+    if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+        PLOG(ERROR) << "Failed to remove " << path;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Copies a directory tree the way cp -F -R -P --preserve=mode,ownership,timestamps,xattr does,
+ * without forking. The directories are created by a walk of the tree, then the regular files
+ * are copied on up to kCopyTreeThreads threads, cloning their extents when the file system
+ * supports it. The attributes of the directories are copied last, so that copying their
+ * contents does not change their timestamps.
+ */
+class TreeCopier {
+public:
+    int copy(const std::string& from, const std::string& to) {
+        struct stat st;
+        if (lstat(from.c_str(), &st) != 0) {
+            PLOG(ERROR) << "Failed to lstat " << from;
+            return -1;
+        }
+        if (walk(from, to, st) != 0 || copyFiles() != 0) {
+            return -1;
+        }
+        for (const CopiedFile& dir : mDirs) {
+            if (copyDirectoryAttributes(dir) != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    CopyTreeStats getStats() const {
+        return {.files = static_cast<int64_t>(mFiles.size()),
+                .bytes = mBytes,
+                .clonedBytes = mClonedBytes};
+    }
+
+private:
+    int walk(const std::string& from, const std::string& to, const struct stat& st) {
+        if (S_ISREG(st.st_mode)) {
+            mFiles.push_back({from, to, st});
+            return 0;
+        }
+        if (S_ISLNK(st.st_mode)) {
+            return copySymlink(from, to, st);
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            if (remove_destination(to) != 0) return -1;
+            if (mknod(to.c_str(), st.st_mode, st.st_rdev) != 0) {
+                PLOG(ERROR) << "Failed to create " << to;
+                return -1;
+            }
+            return copy_attributes(from, to, st);
+        }
+
+        if (mkdir(to.c_str(), 0700) != 0) {
+            struct stat to_st;
+            if (errno != EEXIST || lstat(to.c_str(), &to_st) != 0) {
+                PLOG(ERROR) << "Failed to create " << to;
+                return -1;
+            }
+            if (!S_ISDIR(to_st.st_mode) &&
+                (remove_destination(to) != 0 || mkdir(to.c_str(), 0700) != 0)) {
+                PLOG(ERROR) << "Failed to create " << to;
+                return -1;
+            }
+        }
+        std::unique_ptr<DIR, decltype(&closedir)> dir(opendir(from.c_str()), closedir);
+        if (!dir) {
+            PLOG(ERROR) << "Failed to opendir " << from;
+            return -1;
+        }
+        struct dirent* de;
+        while ((de = readdir(dir.get())) != nullptr) {
+            if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+            const std::string child_from = from + "/" + de->d_name;
+            struct stat child_st;
+            if (lstat(child_from.c_str(), &child_st) != 0) {
+                PLOG(ERROR) << "Failed to lstat " << child_from;
+                return -1;
+            }
+            if (walk(child_from, to + "/" + de->d_name, child_st) != 0) {
+                return -1;
+            }
+        }
+        // After its subdirectories, so that a directory is only made read-only once its
+        // descendants are created.
+        mDirs.push_back({from, to, st});
+        return 0;
+    }
+
+    int copyDirectoryAttributes(const CopiedFile& dir) {
+        unique_fd from_fd(open(dir.from.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (from_fd < 0) {
+            PLOG(ERROR) << "Failed to open " << dir.from;
+            return -1;
+        }
+        unique_fd to_fd(open(dir.to.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (to_fd < 0) {
+            PLOG(ERROR) << "Failed to open " << dir.to;
+            return -1;
+        }
+        return copy_attributes(from_fd.get(), dir.from, to_fd.get(), dir.to, dir.st);
+    }
+
+    int copySymlink(const std::string& from, const std::string& to, const struct stat& st) {
+        std::string target;
+        if (!android::base::Readlink(from, &target)) {
+            PLOG(ERROR) << "Failed to readlink " << from;
+            return -1;
+        }
+        if (remove_destination(to) != 0) return -1;
+        if (symlink(target.c_str(), to.c_str()) != 0) {
+            PLOG(ERROR) << "Failed to create " << to;
+            return -1;
+        }
+        return copy_attributes(from, to, st);
+    }
+
+    int copyFiles() {
+        std::atomic<size_t> next = 0;
+        std::atomic<bool> failed = false;
+        auto copy_next_files = [&]() {
+            for (size_t i = next++; i < mFiles.size() && !failed; i = next++) {
+                if (copyFile(mFiles[i]) != 0) {
+                    failed = true;
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        const size_t thread_count = std::min(kCopyTreeThreads, mFiles.size());
+        for (size_t i = 1; i < thread_count; i++) {
+            threads.emplace_back(copy_next_files);
+        }
+        copy_next_files();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return failed ? -1 : 0;
+    }
+
+    int copyFile(const CopiedFile& file) {
+        unique_fd from_fd(open(file.from.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+        if (from_fd < 0) {
+            PLOG(ERROR) << "Failed to open " << file.from;
+            return -1;
+        }
+        if (remove_destination(file.to) != 0) return -1;
+        unique_fd to_fd(open(file.to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+                             0600));
+        if (to_fd < 0) {
+            PLOG(ERROR) << "Failed to create " << file.to;
+            return -1;
+        }
+        if (ioctl(to_fd.get(), FICLONE, from_fd.get()) == 0) {
+            mClonedBytes += file.st.st_size;
+        } else if (copy_file_data(from_fd.get(), to_fd.get()) != 0) {
+            PLOG(ERROR) << "Failed to copy " << file.from << " to " << file.to;
+            return -1;
+        }
+        mBytes += file.st.st_size;
+        return copy_attributes(from_fd.get(), file.from, to_fd.get(), file.to, file.st);
+    }
+
+    // Copies the data in the kernel when it can, or through a buffer otherwise.
+    static int copy_file_data(int from_fd, int to_fd) {
+        bool copy_file_range_works = true;
+        char buffer[64 * 1024];
+        while (true) {
+            ssize_t copied = -1;
+            if (copy_file_range_works) {
+                copied = copy_file_range(from_fd, nullptr, to_fd, nullptr, 1024 * 1024 * 1024, 0);
+                if (copied < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS ||
+                                   errno == EOPNOTSUPP)) {
+                    copy_file_range_works = false;
+                    continue;
+                }
+            } else {
+                copied = TEMP_FAILURE_RETRY(read(from_fd, buffer, sizeof(buffer)));
+                if (copied > 0 && !android::base::WriteFully(to_fd, buffer, copied)) {
+                    return -1;
+                }
+            }
+            if (copied < 0) return -1;
+            if (copied == 0) return 0;
+        }
+    }
+
+    std::vector<CopiedFile> mFiles;
+    std::vector<CopiedFile> mDirs;
+    std::atomic<int64_t> mBytes = 0;
+    std::atomic<int64_t> mClonedBytes = 0;
+};
+
+}  // namespace
+
+int copy_directory_tree(const std::string& from, const std::string& to_dir,
+                        CopyTreeStats* stats) {
+    TreeCopier copier;
+    const int res = copier.copy(from, to_dir + "/" + android::base::Basename(from));
+    *stats = copier.getStats();
+    return res;
+}
+
 int64_t data_disk_free(const std::string& data_path) {
     struct statvfs sfs;
     if (statvfs(data_path.c_str(), &sfs) == 0) {
@@ -131,6 +131,13 @@ int delete_dir_contents_and_dir(const std::string& pathname, bool ignore_if_miss
 
 bool is_renamed_deleted_dir(const std::string& path);
 int rename_delete_dir_contents_and_dir(const std::string& pathname, bool ignore_if_missing = true);
+// Same as rename_delete_dir_contents_and_dir, but only renames the directory, which a thread
+// then deletes. A directory left over by a restart of installd is deleted by
+// cleanup_invalid_package_dirs_under_path, since its name marks it as deleted.
+int rename_delete_dir_contents_and_dir_in_background(const std::string& pathname,
+                                                     bool ignore_if_missing = true);
+// Waits until the directories being deleted in background are deleted.
+void wait_for_background_deletions();
 
 int foreach_subdir(const std::string& pathname, std::function<void(const std::string&)> fn);
 
@@ -147,6 +154,18 @@ int rm_package_dir(const std::string& package_dir);
 
 int copy_dir_files(const char *srcname, const char *dstname, uid_t owner, gid_t group);
 
+struct CopyTreeStats {
+    // The number of regular files copied, and the size of their data.
+    int64_t files = 0;
+    int64_t bytes = 0;
+    // The part of the data which was cloned rather than copied.
+    int64_t clonedBytes = 0;
+};
+
+// Copies a directory tree into to_dir, like cp -F -R -P --preserve=mode,ownership,timestamps,xattr
+// but in process, and with the data of the files cloned when the file system supports it.
+int copy_directory_tree(const std::string& from, const std::string& to_dir, CopyTreeStats* stats);
+
 int64_t data_disk_free(const std::string& data_path);
 
 int get_path_inode(const std::string& path, ino_t *inode);
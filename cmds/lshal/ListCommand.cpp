@@ -25,6 +25,7 @@
 #include <iostream>
 #include <map>
 #include <regex>
+#include <set>
 #include <sstream>
 
 #include <android-base/file.h>
@@ -53,6 +54,10 @@ using ::android::hidl::manager::V1_0::IServiceManager;
 namespace android {
 namespace lshal {
 
+// Maximum number of HALs or processes queried at the same time. Each HIDL call from timeoutIPC
+// runs on its own thread as well.
+static constexpr size_t kMaxConcurrentQueries = 8;
+
 vintf::SchemaType toSchemaType(Partition p) {
     return (p == Partition::SYSTEM) ? vintf::SchemaType::FRAMEWORK : vintf::SchemaType::DEVICE;
 }
@@ -107,6 +112,30 @@ void ListCommand::removeDeadProcesses(Pids *pids) {
     }), pids->end());
 }
 
+void ListCommand::fetchCmdlines() {
+    static const pid_t myPid = getpid();
+    std::set<pid_t> pidSet;
+    forEachTable([&](const Table& table) {
+        for (const TableEntry& entry : table) {
+            pidSet.insert(entry.serverPid);
+            pidSet.insert(entry.clientPids.begin(), entry.clientPids.end());
+        }
+    });
+    std::vector<pid_t> pids;
+    for (pid_t pid : pidSet) {
+        if (pid != NO_PID && pid != myPid && mCmdlines.find(pid) == mCmdlines.end()) {
+            pids.push_back(pid);
+        }
+    }
+
+    std::vector<std::string> cmdlines(pids.size());
+    parallelFor(pids.size(), kMaxConcurrentQueries,
+                [&](size_t i) { cmdlines[i] = parseCmdline(pids[i]); });
+    for (size_t i = 0; i < pids.size(); ++i) {
+        mCmdlines.emplace(pids[i], std::move(cmdlines[i]));
+    }
+}
+
 Partition ListCommand::getPartition(pid_t pid) {
     if (pid == NO_PID) return Partition::UNKNOWN;
     auto it = mPartitions.find(pid);
@@ -210,13 +239,19 @@ bool ListCommand::getPidInfo(
 }
 
 const BinderPidInfo* ListCommand::getPidInfoCached(pid_t serverPid) {
-    auto pair = mCachedPidInfos.insert({serverPid, BinderPidInfo{}});
-    if (pair.second /* did insertion take place? */) {
-        if (!getPidInfo(serverPid, &pair.first->second)) {
-            return nullptr;
+    CachedPidInfo* cached;
+    {
+        std::lock_guard<std::mutex> lock(mCachedPidInfosLock);
+        auto& slot = mCachedPidInfos[serverPid];
+        if (slot == nullptr) {
+            slot = std::make_unique<CachedPidInfo>();
         }
+        cached = slot.get();
     }
-    return &pair.first->second;
+    // Parse outside of the lock so that different PIDs are parsed concurrently.
+    std::call_once(cached->once,
+                   [&] { cached->ok = getPidInfo(serverPid, &cached->info); });
+    return cached->ok ? &cached->info : nullptr;
 }
 
 bool ListCommand::shouldFetchHalType(const HalType &type) const {
@@ -256,6 +291,7 @@ void ListCommand::forEachTable(const std::function<void(const Table &)> &f) cons
 }
 
 void ListCommand::postprocess() {
+    fetchCmdlines();
     forEachTable([this](Table &table) {
         if (mSortColumn) {
             std::sort(table.begin(), table.end(), mSortColumn);
@@ -477,12 +513,8 @@ void ListCommand::dumpTable(const NullableOStream<std::ostream>& out) const {
         std::function<std::string(const std::string&)> emitDebugInfo = nullptr;
         if (mEmitDebugInfo && &table == &mServicesTable) {
             emitDebugInfo = [this](const auto& iName) {
-                std::stringstream ss;
-                auto pair = splitFirst(iName, '/');
-                mLshal.emitDebugInfo(pair.first, pair.second, {},
-                                     ParentDebugInfoLevel::FQNAME_ONLY, ss,
-                                     NullableOStream<std::ostream>(nullptr));
-                return ss.str();
+                auto it = mDebugInfos.find(iName);
+                return it == mDebugInfos.end() ? std::string{} : it->second;
             };
         }
         table.createTextTable(mNeat, emitDebugInfo).dump(out.buf());
@@ -490,6 +522,61 @@ void ListCommand::dumpTable(const NullableOStream<std::ostream>& out) const {
     });
 }
 
+void ListCommand::fetchDebugInfos() {
+    if (!mEmitDebugInfo || mVintf ||
+        std::find(mListTypes.begin(), mListTypes.end(), HalType::BINDERIZED_SERVICES) ==
+                mListTypes.end()) {
+        return;
+    }
+
+    std::vector<const TableEntry*> entries;
+    for (const TableEntry& entry : mServicesTable) {
+        entries.push_back(&entry);
+    }
+    std::vector<std::string> debugInfos(entries.size());
+    std::vector<std::chrono::nanoseconds> durations(entries.size());
+    parallelFor(entries.size(), kMaxConcurrentQueries, [&](size_t i) {
+        const auto start = std::chrono::steady_clock::now();
+        std::stringstream ss;
+        auto pair = splitFirst(entries[i]->interfaceName, '/');
+        mLshal.emitDebugInfo(pair.first, pair.second, {}, ParentDebugInfoLevel::FQNAME_ONLY, ss,
+                             NullableOStream<std::ostream>(nullptr));
+        debugInfos[i] = ss.str();
+        durations[i] = std::chrono::steady_clock::now() - start;
+    });
+    for (size_t i = 0; i < entries.size(); ++i) {
+        mDebugInfos[entries[i]->interfaceName] = std::move(debugInfos[i]);
+        mDebugDurations[entries[i]->interfaceName] = durations[i];
+    }
+}
+
+void ListCommand::dumpTiming() const {
+    using std::chrono::nanoseconds;
+    const auto toMs = [](nanoseconds d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    std::vector<std::pair<nanoseconds, std::string>> totals;
+    for (const auto& [name, fetchDuration] : mFetchDurations) {
+        auto it = mDebugDurations.find(name);
+        totals.emplace_back(fetchDuration + (it == mDebugDurations.end() ? nanoseconds{0}
+                                                                         : it->second),
+                            name);
+    }
+    std::sort(totals.begin(), totals.end(), std::greater<>());
+
+    err() << "Time spent on each binderized HAL, slowest first:" << std::endl;
+    for (const auto& [total, name] : totals) {
+        err() << std::fixed << std::setprecision(1) << std::setw(9) << toMs(total) << " ms  "
+              << name << " (fetch " << toMs(mFetchDurations.at(name)) << " ms";
+        auto it = mDebugDurations.find(name);
+        if (it != mDebugDurations.end()) {
+            err() << ", debug " << toMs(it->second) << " ms";
+        }
+        err() << ")" << std::endl;
+    }
+}
+
 Status ListCommand::dump() {
     auto dump = mVintf ? &ListCommand::dumpVintf : &ListCommand::dumpTable;
 
@@ -602,21 +689,42 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
         entry.interfaceName = fqInstanceName;
         entry.transport = mode;
         entry.serviceStatus = ServiceStatus::NON_RESPONSIVE;
-
-        status |= fetchBinderizedEntry(manager, &entry);
     }
 
+    // The entries are independent, so they are fetched concurrently. Warnings are buffered per
+    // entry and printed in order afterwards, so that the output does not depend on timing.
+    struct Fetch {
+        TableEntry* entry;
+        Status status = OK;
+        std::stringstream warnings;
+        std::chrono::nanoseconds duration{0};
+    };
+    std::vector<Fetch> fetches(allTableEntries.size());
+    size_t index = 0;
     for (auto& pair : allTableEntries) {
-        putEntry(HalType::BINDERIZED_SERVICES, std::move(pair.second));
+        fetches[index++].entry = &pair.second;
+    }
+    parallelFor(fetches.size(), kMaxConcurrentQueries, [&](size_t i) {
+        Fetch& fetch = fetches[i];
+        const auto start = std::chrono::steady_clock::now();
+        fetch.status = fetchBinderizedEntry(manager, fetch.entry, fetch.warnings);
+        fetch.duration = std::chrono::steady_clock::now() - start;
+    });
+
+    for (Fetch& fetch : fetches) {
+        status |= fetch.status;
+        err() << fetch.warnings.str();
+        mFetchDurations[fetch.entry->interfaceName] = fetch.duration;
+        putEntry(HalType::BINDERIZED_SERVICES, std::move(*fetch.entry));
     }
     return status;
 }
 
 Status ListCommand::fetchBinderizedEntry(const sp<IServiceManager> &manager,
-                                         TableEntry *entry) {
+                                         TableEntry *entry, std::ostream &warnings) {
     Status status = OK;
     const auto handleError = [&](Status additionalError, const std::string& msg) {
-        err() << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
+        warnings << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
         status |= DUMP_BINDERIZED_ERROR | additionalError;
     };
 
@@ -964,6 +1072,11 @@ void ListCommand::registerAllOptions() {
         thiz->mNeat = true;
         return OK;
     }, "output is machine parsable (no explanatory text).\nCannot be used with --debug."});
+    mOptions.push_back({'\0', "timing", no_argument, v++, [](ListCommand* thiz, const char*) {
+        thiz->mEmitTiming = true;
+        return OK;
+    }, "print the time spent fetching each binderized HAL\n"
+       "and dumping its debug info to stderr, slowest first."});
     mOptions.push_back(
             {'\0', "types", required_argument, v++,
              [](ListCommand* thiz, const char* arg) {
@@ -1145,7 +1258,11 @@ Status ListCommand::main(const Arg &arg) {
     }
     status = fetch();
     postprocess();
+    fetchDebugInfos();
     status |= dump();
+    if (mEmitTiming) {
+        dumpTiming();
+    }
     return status;
 }
 
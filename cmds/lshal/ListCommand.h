@@ -19,7 +19,11 @@
 #include <getopt.h>
 #include <stdint.h>
 
+#include <chrono>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -99,18 +103,25 @@ protected:
     Status fetchManifestHals();
     Status fetchLazyHals();
 
+    // Warnings are written to 'warnings' rather than err(), as the binderized HALs are fetched
+    // concurrently.
     Status fetchBinderizedEntry(const sp<::android::hidl::manager::V1_0::IServiceManager> &manager,
-                                TableEntry *entry);
+                                TableEntry *entry, std::ostream &warnings);
+    // Call IBase::debug on the binderized HALs concurrently, for dumpTable to emit.
+    void fetchDebugInfos();
 
     // Get relevant information for a PID by parsing files under
     // /dev/binderfs/binder_logs or /d/binder.
     // It is a virtual member function so that it can be mocked.
     virtual bool getPidInfo(pid_t serverPid, BinderPidInfo *info) const;
-    // Retrieve from mCachedPidInfos and call getPidInfo if necessary.
+    // Retrieve from mCachedPidInfos and call getPidInfo if necessary. Thread-safe; getPidInfo is
+    // called once per PID, even if the PID is requested by several threads at the same time.
     const BinderPidInfo* getPidInfoCached(pid_t serverPid);
 
     void dumpTable(const NullableOStream<std::ostream>& out) const;
     void dumpVintf(const NullableOStream<std::ostream>& out) const;
+    // Print the time spent fetching each binderized HAL, slowest first.
+    void dumpTiming() const;
     void addLine(TextTable *table, const std::string &interfaceName, const std::string &transport,
                  const std::string &arch, const std::string &threadUsage, const std::string &server,
                  const std::string &serverCmdline, const std::string &address,
@@ -123,6 +134,8 @@ protected:
     // Call getCmdline on all pid in pids. If it returns empty string, the process might
     // have died, and the pid is removed from pids.
     void removeDeadProcesses(Pids *pids);
+    // Call parseCmdline concurrently on all PIDs of the listed tables that are not in mCmdlines.
+    void fetchCmdlines();
 
     virtual Partition getPartition(pid_t pid);
     Partition resolvePartition(Partition processPartition, const FqInstance &fqInstance) const;
@@ -167,6 +180,13 @@ protected:
     TableEntryCompare mSortColumn = nullptr;
 
     bool mEmitDebugInfo = false;
+    // Output of IBase::debug for each binderized HAL, if mEmitDebugInfo.
+    std::map<std::string, std::string> mDebugInfos;
+
+    // If true, the time spent fetching each binderized HAL is printed to err().
+    bool mEmitTiming = false;
+    std::map<std::string, std::chrono::nanoseconds> mFetchDurations;
+    std::map<std::string, std::chrono::nanoseconds> mDebugDurations;
 
     // If true, output in VINTF format. Output only entries from the specified partition.
     bool mVintf = false;
@@ -185,8 +205,14 @@ protected:
     // If an entry exist and not empty, it contains the cached content of /proc/{pid}/cmdline.
     std::map<pid_t, std::string> mCmdlines;
 
-    // Cache for getPidInfo.
-    std::map<pid_t, BinderPidInfo> mCachedPidInfos;
+    // Cache for getPidInfo. Entries are never removed, so the returned pointers stay valid.
+    struct CachedPidInfo {
+        std::once_flag once;
+        bool ok = false;
+        BinderPidInfo info;
+    };
+    std::mutex mCachedPidInfosLock;
+    std::map<pid_t, std::unique_ptr<CachedPidInfo>> mCachedPidInfos;
 
     // Cache for getPartition.
     std::map<pid_t, Partition> mPartitions;
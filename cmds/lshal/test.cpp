@@ -17,6 +17,7 @@
 #define LOG_TAG "Lshal"
 #include <android-base/logging.h>
 
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -453,6 +454,49 @@ TEST_F(ListTest, GetPidInfoCached) {
     EXPECT_NE(nullptr, mockList->getPidInfoCached(5));
 }
 
+TEST_F(ListTest, GetPidInfoCachedConcurrently) {
+    EXPECT_CALL(*mockList, getPidInfo(5, _)).Times(1);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] { EXPECT_NE(nullptr, mockList->getPidInfoCached(5)); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST_F(ListTest, DumpTiming) {
+    const pid_t kServiceCount = 20;
+    EXPECT_CALL(*serviceManager, list(_)).WillRepeatedly(Invoke([&](IServiceManager::list_cb cb) {
+        std::vector<hidl_string> ret;
+        for (pid_t id = 1; id <= kServiceCount; ++id) {
+            ret.push_back(getFqInstanceName(id));
+        }
+        cb(ret);
+        return hardware::Void();
+    }));
+
+    // Fetched concurrently, but listed in order.
+    std::set<std::string> names;
+    for (pid_t id = 1; id <= kServiceCount; ++id) {
+        names.insert(getFqInstanceName(id));
+    }
+    std::string expected = "[fake description 0]\nInterface\n";
+    for (const auto& name : names) {
+        expected += name + "\n";
+    }
+    expected += "\n";
+
+    optind = 1; // mimic Lshal::parseArg()
+    EXPECT_EQ(0u, mockList->main(createArg({"lshal", "--types=b", "-i", "--timing"})));
+    EXPECT_EQ(expected, out.str());
+    EXPECT_THAT(err.str(), StartsWith("Time spent on each binderized HAL, slowest first:\n"));
+    for (const auto& name : names) {
+        EXPECT_THAT(err.str(), HasSubstr(" ms  " + name + " (fetch "));
+    }
+}
+
 TEST_F(ListTest, Fetch) {
     optind = 1; // mimic Lshal::parseArg()
     ASSERT_EQ(0u, mockList->parseArgs(createArg({"lshal"})));
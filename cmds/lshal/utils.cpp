@@ -16,6 +16,10 @@
 
 #include "utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace android {
 namespace lshal {
 
@@ -48,6 +52,25 @@ void replaceAll(std::string *s, char from, char to) {
     }
 }
 
+void parallelFor(size_t count, size_t maxThreads, const std::function<void(size_t)> &f) {
+    std::atomic<size_t> next{0};
+    const auto worker = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            f(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t threadCount = std::min(count, maxThreads);
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
 }  // namespace lshal
 }  // namespace android
 
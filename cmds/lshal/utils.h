@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -85,5 +86,9 @@ std::vector<std::string> split(const std::string &s, char c);
 
 void replaceAll(std::string *s, char from, char to);
 
+// Call f(i) for each i in [0, count) on up to maxThreads threads, including the calling one.
+// Returns when all calls have returned. The order of the calls is unspecified.
+void parallelFor(size_t count, size_t maxThreads, const std::function<void(size_t)> &f);
+
 }  // namespace lshal
 }  // namespace android
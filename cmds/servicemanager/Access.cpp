@@ -126,6 +126,7 @@ bool Access::canAdd(const CallingContext& ctx, const std::string& name) {
 }
 
 bool Access::canList(const CallingContext& ctx) {
+    std::unique_lock lock(mLock);
     return actionAllowed(ctx, mThisProcessContext, "list", "service_manager");
 }
 
@@ -153,6 +154,22 @@ bool Access::actionAllowed(const CallingContext& sctx, const char* tctx, const c
 
 bool Access::actionAllowedFromLookup(const CallingContext& sctx, const std::string& name, const char *perm) {
 #ifdef __ANDROID__
+    // Loading a policy or switching the enforcing mode may change any decision.
+    const std::pair<int, int> policy = {selinux_status_policyload(), selinux_status_getenforce()};
+    auto key = std::make_tuple(sctx.sid, std::string(perm), name);
+    {
+        std::shared_lock lock(mLock);
+        if (mAllowedLookupsPolicy == policy && mAllowedLookups.count(key) > 0) {
+            return true;
+        }
+    }
+
+    std::unique_lock lock(mLock);
+    if (mAllowedLookupsPolicy != policy) {
+        mAllowedLookups.clear();
+        mAllowedLookupsPolicy = policy;
+    }
+
     char *tctx = nullptr;
     if (selabel_lookup(getSehandle(), &tctx, name.c_str(), SELABEL_CTX_ANDROID_SERVICE) != 0) {
         LOG(ERROR) << "SELinux: No match for " << name << " in service_contexts.\n";
@@ -161,6 +178,15 @@ bool Access::actionAllowedFromLookup(const CallingContext& sctx, const std::stri
 
     bool allowed = actionAllowed(sctx, tctx, perm, name);
     freecon(tctx);
+
+    // Denials are checked again every time so that each of them is audited. The AVC only audits
+    // the first denial of a permissive domain, so caching what it allowed doesn't hide any.
+    if (allowed && !sctx.sid.empty()) {
+        if (mAllowedLookups.size() >= kMaxAllowedLookups) {
+            mAllowedLookups.clear();
+        }
+        mAllowedLookups.insert(std::move(key));
+    }
     return allowed;
 #else
     (void)sctx;
@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <set>
+#include <shared_mutex>
 #include <string>
 #include <sys/types.h>
+#include <tuple>
+#include <utility>
 
 namespace android {
 
@@ -45,12 +49,25 @@ public:
     virtual bool canList(const CallingContext& ctx);
 
 private:
+    // Requires mLock to be held exclusively.
     bool actionAllowed(const CallingContext& sctx, const char* tctx, const char* perm,
             const std::string& tname);
     bool actionAllowedFromLookup(const CallingContext& sctx, const std::string& name,
             const char *perm);
 
     char* mThisProcessContext = nullptr;
+
+    // libselinux may only be used by one thread at a time, while the cached lookups below are
+    // shared by the binder threads.
+    std::shared_mutex mLock;
+
+    // The (caller context, permission, service name) lookups which the policy allowed, so that
+    // the clients which look up the same services again and again, e.g. while they start, don't
+    // each pay for the service_contexts lookup and the access check. They are dropped when the
+    // policy number or the enforcing mode, in mAllowedLookupsPolicy, change.
+    static constexpr size_t kMaxAllowedLookups = 4096;
+    std::set<std::tuple<std::string, std::string, std::string>> mAllowedLookups;
+    std::pair<int, int> mAllowedLookupsPolicy = {-1, -1};
 };
 
 };
@@ -24,7 +24,14 @@
 #include <binder/Stability.h>
 #include <cutils/android_filesystem_config.h>
 #include <cutils/multiuser.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <thread>
+#include <unordered_map>
 
 #ifndef VENDORSERVICEMANAGER
 #include <vintf/VintfObject.h>
@@ -69,20 +76,6 @@ static std::vector<ManifestWithDescription> GetManifestsWithDescription() {
 #endif
 }
 
-// func true -> stop search and forEachManifest will return true
-static bool forEachManifest(const std::function<bool(const ManifestWithDescription&)>& func) {
-    for (const ManifestWithDescription& mwd : GetManifestsWithDescription()) {
-        if (mwd.manifest == nullptr) {
-            ALOGE("NULL VINTF MANIFEST!: %s", mwd.description);
-            // note, we explicitly do not retry here, so that we can detect VINTF
-            // or other bugs (b/151696835)
-            continue;
-        }
-        if (func(mwd)) return true;
-    }
-    return false;
-}
-
 struct AidlName {
     std::string package;
     std::string iface;
@@ -104,93 +97,144 @@ struct AidlName {
     }
 };
 
+// The AIDL instances of the manifests, so that the lookups, e.g. AServiceManager_isDeclared while
+// apps start, don't walk the manifests each time. An index is only valid for the manifests it was
+// built from, and libvintf gives out new manifest objects when they are loaded again.
+class VintfIndex {
+public:
+    struct Instance {
+        // The first manifest which declares the instance.
+        const char* description = nullptr;
+        std::optional<std::string> updatableViaApex;
+        std::optional<std::string> ip;
+        std::optional<uint64_t> port;
+    };
+
+    static std::shared_ptr<const VintfIndex> get() {
+        static std::mutex gLock;
+        static std::shared_ptr<const VintfIndex> gIndex;
+
+        std::vector<ManifestWithDescription> manifests = GetManifestsWithDescription();
+        std::lock_guard<std::mutex> lock(gLock);
+        if (gIndex == nullptr || !gIndex->isBuiltFrom(manifests)) {
+            gIndex = std::make_shared<const VintfIndex>(std::move(manifests));
+        }
+        return gIndex;
+    }
+
+    explicit VintfIndex(std::vector<ManifestWithDescription>&& manifests)
+          : mManifests(std::move(manifests)) {
+        for (const ManifestWithDescription& mwd : mManifests) {
+            if (mwd.manifest == nullptr) {
+                ALOGE("NULL VINTF MANIFEST!: %s", mwd.description);
+                // note, we explicitly do not retry here, so that we can detect VINTF
+                // or other bugs (b/151696835)
+                continue;
+            }
+
+            // Only the first declaration of a name in each manifest counts, like the searches
+            // which this index replaced.
+            std::set<std::string> namesInManifest;
+            std::map<std::string, std::set<std::string>> instancesInManifest;
+
+            mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
+                if (manifestInstance.format() != vintf::HalFormat::AIDL) return true;
+                const std::string iface =
+                        manifestInstance.package() + "." + manifestInstance.interface();
+                const std::string name = iface + "/" + manifestInstance.instance();
+                instancesInManifest[iface].insert(manifestInstance.instance());
+                if (manifestInstance.updatableViaApex().has_value()) {
+                    mApexToNames[*manifestInstance.updatableViaApex()].push_back(name);
+                }
+                if (!namesInManifest.insert(name).second) return true;
+
+                Instance& instance = mInstances[name];
+                if (instance.description == nullptr) instance.description = mwd.description;
+                if (!instance.updatableViaApex.has_value()) {
+                    instance.updatableViaApex = manifestInstance.updatableViaApex();
+                }
+                // the last manifest which declares the instance wins
+                instance.ip = manifestInstance.ip();
+                instance.port = manifestInstance.port();
+                return true;  // continue (libvintf uses opposite convention)
+            });
+
+            for (auto& [iface, instances] : instancesInManifest) {
+                std::vector<std::string>& all = mInterfaceToInstances[iface];
+                all.insert(all.end(), instances.begin(), instances.end());
+            }
+        }
+    }
+
+    const Instance* find(const std::string& name) const {
+        auto it = mInstances.find(name);
+        return it == mInstances.end() ? nullptr : &it->second;
+    }
+
+    std::vector<std::string> instancesOf(const std::string& iface) const {
+        auto it = mInterfaceToInstances.find(iface);
+        return it == mInterfaceToInstances.end() ? std::vector<std::string>{} : it->second;
+    }
+
+    std::vector<std::string> namesUpdatableVia(const std::string& apexName) const {
+        auto it = mApexToNames.find(apexName);
+        return it == mApexToNames.end() ? std::vector<std::string>{} : it->second;
+    }
+
+private:
+    bool isBuiltFrom(const std::vector<ManifestWithDescription>& manifests) const {
+        if (manifests.size() != mManifests.size()) return false;
+        for (size_t i = 0; i < manifests.size(); i++) {
+            if (manifests[i].manifest != mManifests[i].manifest) return false;
+        }
+        return true;
+    }
+
+    // Keeps the manifests alive, so that new ones can't be mistaken for them.
+    std::vector<ManifestWithDescription> mManifests;
+    // e.g. some.package.foo.IFoo/default
+    std::unordered_map<std::string, Instance> mInstances;
+    std::unordered_map<std::string, std::vector<std::string>> mInterfaceToInstances;
+    std::unordered_map<std::string, std::vector<std::string>> mApexToNames;
+};
+
 static bool isVintfDeclared(const std::string& name) {
     AidlName aname;
     if (!AidlName::fill(name, &aname)) return false;
 
-    bool found = forEachManifest([&](const ManifestWithDescription& mwd) {
-        if (mwd.manifest->hasAidlInstance(aname.package, aname.iface, aname.instance)) {
-            ALOGI("Found %s in %s VINTF manifest.", name.c_str(), mwd.description);
-            return true; // break
-        }
-        return false;  // continue
-    });
-
-    if (!found) {
-        // Although it is tested, explicitly rebuilding qualified name, in case it
-        // becomes something unexpected.
-        ALOGI("Could not find %s.%s/%s in the VINTF manifest.", aname.package.c_str(),
-              aname.iface.c_str(), aname.instance.c_str());
+    if (const VintfIndex::Instance* instance = VintfIndex::get()->find(name)) {
+        ALOGI("Found %s in %s VINTF manifest.", name.c_str(), instance->description);
+        return true;
     }
 
-    return found;
+    // Although it is tested, explicitly rebuilding qualified name, in case it
+    // becomes something unexpected.
+    ALOGI("Could not find %s.%s/%s in the VINTF manifest.", aname.package.c_str(),
+          aname.iface.c_str(), aname.instance.c_str());
+    return false;
 }
 
 static std::optional<std::string> getVintfUpdatableApex(const std::string& name) {
     AidlName aname;
     if (!AidlName::fill(name, &aname)) return std::nullopt;
 
-    std::optional<std::string> updatableViaApex;
-
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.format() != vintf::HalFormat::AIDL) return true;
-            if (manifestInstance.package() != aname.package) return true;
-            if (manifestInstance.interface() != aname.iface) return true;
-            if (manifestInstance.instance() != aname.instance) return true;
-            updatableViaApex = manifestInstance.updatableViaApex();
-            return false; // break (libvintf uses opposite convention)
-        });
-        if (updatableViaApex.has_value()) return true; // break (found match)
-        return false; // continue
-    });
-
-    return updatableViaApex;
+    const VintfIndex::Instance* instance = VintfIndex::get()->find(name);
+    return instance != nullptr ? instance->updatableViaApex : std::nullopt;
 }
 
 static std::vector<std::string> getVintfUpdatableInstances(const std::string& apexName) {
-    std::vector<std::string> instances;
-
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.format() == vintf::HalFormat::AIDL &&
-                manifestInstance.updatableViaApex().has_value() &&
-                manifestInstance.updatableViaApex().value() == apexName) {
-                std::string aname = manifestInstance.package() + "." +
-                        manifestInstance.interface() + "/" + manifestInstance.instance();
-                instances.push_back(aname);
-            }
-            return true; // continue (libvintf uses opposite convention)
-        });
-        return false; // continue
-    });
-
-    return instances;
+    return VintfIndex::get()->namesUpdatableVia(apexName);
 }
 
 static std::optional<ConnectionInfo> getVintfConnectionInfo(const std::string& name) {
     AidlName aname;
     if (!AidlName::fill(name, &aname)) return std::nullopt;
 
-    std::optional<std::string> ip;
-    std::optional<uint64_t> port;
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.format() != vintf::HalFormat::AIDL) return true;
-            if (manifestInstance.package() != aname.package) return true;
-            if (manifestInstance.interface() != aname.iface) return true;
-            if (manifestInstance.instance() != aname.instance) return true;
-            ip = manifestInstance.ip();
-            port = manifestInstance.port();
-            return false; // break (libvintf uses opposite convention)
-        });
-        return false; // continue
-    });
-
-    if (ip.has_value() && port.has_value()) {
+    const VintfIndex::Instance* instance = VintfIndex::get()->find(name);
+    if (instance != nullptr && instance->ip.has_value() && instance->port.has_value()) {
         ConnectionInfo info;
-        info.ipAddress = *ip;
-        info.port = *port;
+        info.ipAddress = *instance->ip;
+        info.port = *instance->port;
         return std::make_optional<ConnectionInfo>(info);
     } else {
         return std::nullopt;
@@ -205,17 +249,8 @@ static std::vector<std::string> getVintfInstances(const std::string& interface)
               interface.c_str());
         return {};
     }
-    const std::string package = interface.substr(0, lastDot);
-    const std::string iface = interface.substr(lastDot+1);
-
-    std::vector<std::string> ret;
-    (void)forEachManifest([&](const ManifestWithDescription& mwd) {
-        auto instances = mwd.manifest->getAidlInstances(package, iface);
-        ret.insert(ret.end(), instances.begin(), instances.end());
-        return false;  // continue
-    });
 
-    return ret;
+    return VintfIndex::get()->instancesOf(interface);
 }
 
 static bool meetsDeclarationRequirements(const sp<IBinder>& binder, const std::string& name) {
@@ -286,14 +321,20 @@ sp<IBinder> ServiceManager::tryGetService(const std::string& name, bool startIfN
     auto ctx = mAccess->getCallingContext();
 
     sp<IBinder> out;
-    Service* service = nullptr;
-    if (auto it = mNameToService.find(name); it != mNameToService.end()) {
-        service = &(it->second);
-
-        if (!service->allowIsolated && is_multiuser_uid_isolated(ctx.uid)) {
-            return nullptr;
+    bool needsClientGuarantee = false;
+    {
+        std::shared_lock lock(mLock);
+        if (auto it = mNameToService.find(name); it != mNameToService.end()) {
+            const Service& service = it->second;
+
+            if (!service.allowIsolated && is_multiuser_uid_isolated(ctx.uid)) {
+                return nullptr;
+            }
+            out = service.binder;
+            // The guarantee is only ever cleared for services with client callbacks.
+            needsClientGuarantee =
+                    !service.guaranteeClient || mNameToClientCallback.count(name) > 0;
         }
-        out = service->binder;
     }
 
     if (!mAccess->canFind(ctx, name)) {
@@ -304,7 +345,15 @@ sp<IBinder> ServiceManager::tryGetService(const std::string& name, bool startIfN
         tryStartService(name);
     }
 
-    if (out) {
+    if (out && needsClientGuarantee) {
+        std::unique_lock lock(mLock);
+        auto it = mNameToService.find(name);
+        // The service was replaced or removed in the meantime.
+        if (it == mNameToService.end() || it->second.binder != out) {
+            return out;
+        }
+        Service* service = &(it->second);
+
         // Force onClients to get sent, and then make sure the timerfd won't clear it
         // by setting guaranteeClient again. This logic could be simplified by using
         // a time-based guarantee. However, forcing onClients(true) to get sent
@@ -364,6 +413,8 @@ Status ServiceManager::addService(const std::string& name, const sp<IBinder>& bi
         ALOGW("Dump flag priority is not set when adding %s", name.c_str());
     }
 
+    std::unique_lock lock(mLock);
+
     // implicitly unlinked when the binder is removed
     if (binder->remoteBinder() != nullptr &&
         binder->linkToDeath(sp<ServiceManager>::fromExisting(this)) != OK) {
@@ -425,6 +476,8 @@ Status ServiceManager::listServices(int32_t dumpPriority, std::vector<std::strin
         return Status::fromExceptionCode(Status::EX_SECURITY, "SELinux denied.");
     }
 
+    std::shared_lock lock(mLock);
+
     size_t toReserve = 0;
     for (auto const& [name, service] : mNameToService) {
         (void) name;
@@ -442,6 +495,7 @@ Status ServiceManager::listServices(int32_t dumpPriority, std::vector<std::strin
             outList->push_back(name);
         }
     }
+    std::sort(outList->begin(), outList->end());
 
     return Status::ok();
 }
@@ -473,6 +527,8 @@ Status ServiceManager::registerForNotifications(
         return Status::fromExceptionCode(Status::EX_NULL_POINTER, "Null callback.");
     }
 
+    std::unique_lock lock(mLock);
+
     if (OK !=
         IInterface::asBinder(callback)->linkToDeath(
                 sp<ServiceManager>::fromExisting(this))) {
@@ -500,6 +556,8 @@ Status ServiceManager::unregisterForNotifications(
         return Status::fromExceptionCode(Status::EX_SECURITY, "SELinux denied.");
     }
 
+    std::unique_lock lock(mLock);
+
     bool found = false;
 
     auto it = mNameToRegistrationCallback.find(name);
@@ -631,6 +689,8 @@ void ServiceManager::removeRegistrationCallback(const wp<IBinder>& who,
 }
 
 void ServiceManager::binderDied(const wp<IBinder>& who) {
+    std::unique_lock lock(mLock);
+
     for (auto it = mNameToService.begin(); it != mNameToService.end();) {
         if (who == it->second.binder) {
             it = mNameToService.erase(it);
@@ -675,6 +735,8 @@ Status ServiceManager::registerClientCallback(const std::string& name, const sp<
         return Status::fromExceptionCode(Status::EX_SECURITY, "SELinux denied.");
     }
 
+    std::unique_lock lock(mLock);
+
     auto serviceIt = mNameToService.find(name);
     if (serviceIt == mNameToService.end()) {
         ALOGE("Could not add callback for nonexistent service: %s", name.c_str());
@@ -737,6 +799,8 @@ ssize_t ServiceManager::Service::getNodeStrongRefCount() {
 }
 
 void ServiceManager::handleClientCallbacks() {
+    std::unique_lock lock(mLock);
+
     for (const auto& [name, service] : mNameToService) {
         handleServiceClientCallback(1 /* sm has one refcount */, name, true);
     }
@@ -824,6 +888,8 @@ Status ServiceManager::tryUnregisterService(const std::string& name, const sp<IB
         return Status::fromExceptionCode(Status::EX_SECURITY, "SELinux denied.");
     }
 
+    std::unique_lock lock(mLock);
+
     auto serviceIt = mNameToService.find(name);
     if (serviceIt == mNameToService.end()) {
         ALOGW("Tried to unregister %s, but that service wasn't registered to begin with.",
@@ -881,6 +947,8 @@ Status ServiceManager::getServiceDebugInfo(std::vector<ServiceDebugInfo>* outRet
         return Status::fromExceptionCode(Status::EX_SECURITY, "SELinux denied.");
     }
 
+    std::shared_lock lock(mLock);
+
     outReturn->reserve(mNameToService.size());
     for (auto const& [name, service] : mNameToService) {
         ServiceDebugInfo info;
@@ -889,11 +957,14 @@ Status ServiceManager::getServiceDebugInfo(std::vector<ServiceDebugInfo>* outRet
 
         outReturn->push_back(std::move(info));
     }
+    std::sort(outReturn->begin(), outReturn->end(),
+              [](const ServiceDebugInfo& a, const ServiceDebugInfo& b) { return a.name < b.name; });
 
     return Status::ok();
 }
 
 void ServiceManager::clear() {
+    std::unique_lock lock(mLock);
     mNameToService.clear();
     mNameToRegistrationCallback.clear();
     mNameToClientCallback.clear();
@@ -20,6 +20,10 @@
 #include <android/os/IClientCallback.h>
 #include <android/os/IServiceCallback.h>
 
+#include <map>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "Access.h"
 
 namespace android {
@@ -86,7 +90,9 @@ private:
 
     using ServiceCallbackMap = std::map<std::string, std::vector<sp<IServiceCallback>>>;
     using ClientCallbackMap = std::map<std::string, std::vector<sp<IClientCallback>>>;
-    using ServiceMap = std::map<std::string, Service>;
+    using ServiceMap = std::unordered_map<std::string, Service>;
+
+    // The methods below require mLock to be held exclusively.
 
     // removes a callback from mNameToRegistrationCallback, removing it if the vector is empty
     // this updates iterator to the next location
@@ -105,6 +111,10 @@ private:
 
     sp<IBinder> tryGetService(const std::string& name, bool startIfNotFound);
 
+    // Incoming calls are served by several binder threads. The lookups only share the lock, unless
+    // they have to tell a lazy service about its client. Everything which changes the registry
+    // holds it exclusively, so that the registrations and their notifications are ordered.
+    std::shared_mutex mLock;
     ServiceMap mNameToService;
     ServiceCallbackMap mNameToRegistrationCallback;
     ClientCallbackMap mNameToClientCallback;
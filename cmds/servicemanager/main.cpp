@@ -36,6 +36,8 @@ using ::android::sp;
 using ::android::base::SetProperty;
 using ::android::os::IServiceManager;
 
+static constexpr size_t kMaxBinderThreads = 4;
+
 class BinderCallback : public LooperCallback {
 public:
     static sp<BinderCallback> setupTo(const sp<Looper>& looper) {
@@ -122,7 +124,9 @@ int main(int argc, char** argv) {
     LOG(INFO) << "Starting sm instance on " << driver;
 
     sp<ProcessState> ps = ProcessState::initWithDriver(driver);
-    ps->setThreadPoolMaxThreadCount(0);
+    // Besides the looper thread, the driver may start binder threads when the lookups queue up,
+    // e.g. while the system boots.
+    ps->setThreadPoolMaxThreadCount(kMaxBinderThreads);
     ps->setCallRestriction(ProcessState::CallRestriction::FATAL_IF_NOT_ONEWAY);
 
     sp<ServiceManager> manager = sp<ServiceManager>::make(std::make_unique<Access>());
@@ -132,6 +136,7 @@ int main(int argc, char** argv) {
 
     IPCThreadState::self()->setTheContextObject(manager);
     ps->becomeContextManager();
+    ps->startThreadPool();
 
     sp<Looper> looper = Looper::prepare(false /*allowNonCallbacks*/);
 
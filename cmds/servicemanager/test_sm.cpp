@@ -24,6 +24,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "Access.h"
 #include "ServiceManager.h"
 
@@ -262,6 +266,39 @@ TEST(GetService, NotAllowedFromIsolated) {
     EXPECT_EQ(nullptr, out.get());
 }
 
+TEST(GetService, ConcurrentWithAddService) {
+    auto sm = getPermissiveServiceManager();
+
+    EXPECT_TRUE(sm->addService("foo", getBinder(), false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    std::atomic<bool> done = false;
+    std::vector<std::thread> lookups;
+    for (size_t i = 0; i < 4; i++) {
+        lookups.emplace_back([&] {
+            while (!done) {
+                sp<IBinder> out;
+                EXPECT_TRUE(sm->checkService("foo", &out).isOk());
+                EXPECT_NE(nullptr, out);
+            }
+        });
+    }
+
+    for (size_t i = 0; i < 100; i++) {
+        EXPECT_TRUE(sm->addService("foo", getBinder(), false /*allowIsolated*/,
+            IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+        EXPECT_TRUE(sm->addService("bar" + std::to_string(i), getBinder(),
+            false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    }
+
+    done = true;
+    for (auto& lookup : lookups) lookup.join();
+
+    std::vector<std::string> out;
+    EXPECT_TRUE(sm->listServices(IServiceManager::DUMP_FLAG_PRIORITY_ALL, &out).isOk());
+    EXPECT_EQ(101u, out.size());
+}
+
 TEST(ListServices, NoPermissions) {
     std::unique_ptr<MockAccess> access = std::make_unique<NiceMock<MockAccess>>();
 
@@ -356,6 +393,25 @@ TEST(Vintf, GetUpdatableNames_InvalidApexNameReturnsEmpty) {
     EXPECT_EQ(std::vector<std::string>{}, names);
 }
 
+TEST(Vintf, DeclaredInstancesAreDeclared) {
+    if (!isCuttlefish()) GTEST_SKIP() << "Skipping non-Cuttlefish devices";
+
+    auto sm = getPermissiveServiceManager();
+    std::vector<std::string> instances;
+    EXPECT_TRUE(sm->getDeclaredInstances("android.hardware.camera.provider.ICameraProvider",
+                                         &instances)
+                        .isOk());
+    EXPECT_THAT(instances, testing::Contains("internal/0"));
+
+    for (const std::string& instance : instances) {
+        bool declared = false;
+        EXPECT_TRUE(sm->isDeclared("android.hardware.camera.provider.ICameraProvider/" + instance,
+                                   &declared)
+                            .isOk());
+        EXPECT_TRUE(declared) << instance;
+    }
+}
+
 class CallbackHistorian : public BnServiceCallback {
     Status onRegistration(const std::string& name, const sp<IBinder>& binder) override {
         registrations.push_back(name);
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <new>
 #include <type_traits>
@@ -84,6 +85,17 @@ struct ArrayTraits {
   // TODO: Replace with std::uninitialized_copy in C++20.
   template <typename Iterator>
   static void uninitialized_copy(Iterator first, Iterator last, const_iterator out) {
+    if constexpr (std::is_trivially_copyable_v<value_type> &&
+                  std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Iterator>>,
+                                 std::remove_cv_t<value_type>> &&
+                  std::is_pointer_v<Iterator>) {
+      if (first != last) {
+        std::memcpy(const_cast<void*>(static_cast<const void*>(out)), first,
+                    static_cast<std::size_t>(last - first) * sizeof(value_type));
+      }
+      return;
+    }
+
     while (first != last) {
       construct_at(out++, *first++);
     }
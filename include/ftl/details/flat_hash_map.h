@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace android::ftl::details {
+
+// Each slot of a FlatHashMap has a control byte, which is either kEmpty, kDeleted, or the low 7
+// bits of the hash of the key in the slot. The control bytes of a group of slots are matched in
+// parallel, so that the keys are only compared for the slots whose 7 bits of hash match.
+using Ctrl = int8_t;
+
+constexpr Ctrl kEmpty = -128;
+constexpr Ctrl kDeleted = -2;
+
+constexpr bool is_full(Ctrl ctrl) {
+  return ctrl >= 0;
+}
+
+// Mixes the bits of the hash, since std::hash is the identity for integers, and the two parts of
+// the hash are taken from the low and high bits.
+constexpr std::size_t mix_hash(std::size_t hash) {
+  if constexpr (sizeof(std::size_t) == sizeof(uint64_t)) {
+    const uint64_t h = static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ull;
+    return static_cast<std::size_t>(h ^ (h >> 32));
+  } else {
+    const uint32_t h = static_cast<uint32_t>(hash) * 0x9e3779b9u;
+    return static_cast<std::size_t>(h ^ (h >> 16));
+  }
+}
+
+constexpr Ctrl h2(std::size_t hash) {
+  return static_cast<Ctrl>(hash & 0x7f);
+}
+
+constexpr std::size_t h1(std::size_t hash) {
+  return hash >> 7;
+}
+
+// The slots matched in a group, one bit per slot, or one bit per byte if Shift is 3.
+template <std::size_t Shift, typename Mask>
+class BitMask {
+ public:
+  explicit constexpr BitMask(Mask mask) : mask_(mask) {}
+
+  explicit constexpr operator bool() const { return mask_ != 0; }
+
+  // Returns the index of the lowest matched slot. The mask must not be empty.
+  std::size_t lowest() const {
+    if constexpr (sizeof(Mask) > sizeof(unsigned)) {
+      return static_cast<std::size_t>(__builtin_ctzll(mask_)) >> Shift;
+    } else {
+      return static_cast<std::size_t>(__builtin_ctz(mask_)) >> Shift;
+    }
+  }
+
+  // Iterates over the indices of the matched slots.
+  BitMask& operator++() {
+    mask_ &= mask_ - 1;
+    return *this;
+  }
+
+  std::size_t operator*() const { return lowest(); }
+
+  BitMask begin() const { return *this; }
+  BitMask end() const { return BitMask(0); }
+
+  bool operator!=(const BitMask& other) const { return mask_ != other.mask_; }
+
+ private:
+  Mask mask_;
+};
+
+#if defined(__SSE2__)
+
+// A group of 16 control bytes, matched with SSE2.
+class Group {
+ public:
+  static constexpr std::size_t kWidth = 16;
+
+  using Mask = BitMask<0, uint32_t>;
+
+  // The control bytes must be aligned to kWidth.
+  explicit Group(const Ctrl* ctrl)
+      : ctrl_(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+  Mask match(Ctrl hash) const {
+    return Mask(to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(hash), ctrl_)));
+  }
+
+  Mask match_empty() const { return Mask(to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(kEmpty), ctrl_))); }
+
+  // kEmpty and kDeleted are the only control bytes with the sign bit set.
+  Mask match_empty_or_deleted() const { return Mask(to_mask(ctrl_)); }
+
+ private:
+  static uint32_t to_mask(__m128i v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+
+  __m128i ctrl_;
+};
+
+#else
+
+// A group of 8 control bytes, matched as the bytes of a word. On aarch64, the hash is matched with
+// NEON, and the other matches are cheaper in the word.
+class Group {
+ public:
+  static constexpr std::size_t kWidth = 8;
+
+  // The matched slots have the sign bit of their byte set.
+  using Mask = BitMask<3, uint64_t>;
+
+  explicit Group(const Ctrl* ctrl) {
+#if defined(__aarch64__)
+    ctrl_ = vld1_u8(reinterpret_cast<const uint8_t*>(ctrl));
+    word_ = vget_lane_u64(vreinterpret_u64_u8(ctrl_), 0);
+#else
+    std::memcpy(&word_, ctrl, sizeof(word_));
+#endif
+  }
+
+  Mask match(Ctrl hash) const {
+#if defined(__aarch64__)
+    const uint8x8_t equal = vceq_u8(ctrl_, vdup_n_u8(static_cast<uint8_t>(hash)));
+    return Mask(vget_lane_u64(vreinterpret_u64_u8(equal), 0) & kMsbs);
+#else
+    // May report a false positive in the byte after a match, which the key comparison rejects.
+    const uint64_t x = word_ ^ (kLsbs * static_cast<uint8_t>(hash));
+    return Mask((x - kLsbs) & ~x & kMsbs);
+#endif
+  }
+
+  // Only kEmpty has the sign bit set and bit 1 cleared.
+  Mask match_empty() const { return Mask(word_ & (~word_ << 6) & kMsbs); }
+
+  Mask match_empty_or_deleted() const { return Mask(word_ & kMsbs); }
+
+ private:
+  static constexpr uint64_t kLsbs = 0x0101010101010101ull;
+  static constexpr uint64_t kMsbs = 0x8080808080808080ull;
+
+#if defined(__aarch64__)
+  uint8x8_t ctrl_;
+#endif
+  uint64_t word_;
+};
+
+#endif
+
+}  // namespace android::ftl::details
@@ -0,0 +1,560 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ftl/details/flat_hash_map.h>
+#include <ftl/initializer_list.h>
+#include <ftl/optional.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace android::ftl {
+
+// Associative container with unique, unordered keys, for maps too large for the linear search of
+// ftl::SmallMap. Unlike std::unordered_map, key-value pairs are stored in a flat array of slots
+// rather than in a node per mapping, and the lookup is done by open addressing: each slot has a
+// control byte with 7 bits of the hash of its key, and the probing compares the control bytes of
+// a group of slots in parallel (16 slots with SSE2, or 8 slots in a word otherwise), so that keys
+// are rarely compared unless they are equal. The API mirrors ftl::SmallMap, notably the immutable
+// getters that can optionally transform the value.
+//
+// The order of iteration is unspecified, and changes when the map grows. An emplace that grows the
+// map relocates the mappings, invalidating all iterators and references. Otherwise, mappings are
+// never relocated, so a mapping can be erased while iterating.
+//
+// Example usage:
+//
+//   ftl::FlatHashMap<int, std::string> map;
+//   assert(map.empty());
+//
+//   map = ftl::init::map<int, std::string>(123, "abc")(-1)(42, 3u, '?');
+//   assert(map.size() == 3u);
+//
+//   assert(map.contains(123));
+//   assert(map.get(42).transform([](const std::string& s) { return s.size(); }) == 3u);
+//
+//   const auto opt = map.get(-1);
+//   assert(opt);
+//
+//   std::string& ref = *opt;
+//   assert(ref.empty());
+//   ref = "xyz";
+//
+//   map.emplace_or_replace(0, "vanilla", 2u, 3u);
+//   assert(map.size() == 4u);
+//
+//   assert(map == FlatHashMap(ftl::init::map(-1, "xyz"s)(0, "nil"s)(42, "???"s)(123, "abc"s)));
+//
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class FlatHashMap final {
+  using Ctrl = details::Ctrl;
+  using Group = details::Group;
+
+  union Slot {
+    Slot() {}
+    ~Slot() {}
+
+    std::pair<const K, V> pair;
+  };
+
+  // The control bytes are aligned for the loads of Group.
+  struct CtrlDeleter {
+    void operator()(Ctrl* ctrl) const { ::operator delete(ctrl, std::align_val_t(Group::kWidth)); }
+  };
+
+  template <bool Const>
+  class Iterator;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+
+  using value_type = std::pair<const K, V>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  using reference = value_type&;
+  using iterator = Iterator<false>;
+
+  using const_reference = const value_type&;
+  using const_iterator = Iterator<true>;
+
+  // Creates an empty map, which does not allocate until the first emplace.
+  FlatHashMap() = default;
+
+  // Constructs key-value pairs in place by forwarding per-pair constructor arguments. The syntax
+  // is the same as for ftl::SmallMap, and the first of duplicate keys is kept:
+  //
+  //   ftl::FlatHashMap map = ftl::init::map<int, std::string>(123, "abc")(-1)(42, 3u, '?');
+  //   static_assert(std::is_same_v<decltype(map), ftl::FlatHashMap<int, std::string>>);
+  //
+  template <typename Q, typename W, typename E, std::size_t... Sizes, typename... Types>
+  FlatHashMap(InitializerList<KeyValue<Q, W, E>, std::index_sequence<Sizes...>, Types...>&& list) {
+    reserve(sizeof...(Sizes));
+    emplace_list(std::move(list.tuple), std::make_index_sequence<sizeof...(Sizes)>{});
+  }
+
+  // Copies the mappings into the same slots, without rehashing the keys.
+  FlatHashMap(const FlatHashMap& other)
+      : capacity_(other.capacity_), size_(other.size_), growth_left_(other.growth_left_) {
+    if (capacity_ == 0) return;
+    allocate(capacity_);
+    std::copy_n(other.ctrl_.get(), capacity_, ctrl_.get());
+    for (size_type i = 0; i < capacity_; i++) {
+      if (details::is_full(ctrl_[i])) {
+        new (&slots_[i].pair) value_type(other.slots_[i].pair);
+      }
+    }
+  }
+
+  FlatHashMap(FlatHashMap&& other) noexcept { swap(other); }
+
+  FlatHashMap& operator=(FlatHashMap other) noexcept {
+    // Define copy/move assignment in terms of copy/move construction.
+    swap(other);
+    return *this;
+  }
+
+  ~FlatHashMap() { destroy_slots(); }
+
+  size_type max_size() const { return std::numeric_limits<difference_type>::max(); }
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns the number of slots, of which at most 7/8 are used before the map grows.
+  size_type capacity() const { return capacity_; }
+
+  iterator begin() { return next_used(0); }
+  const_iterator begin() const { return cbegin(); }
+  const_iterator cbegin() const { return const_cast<FlatHashMap&>(*this).begin(); }
+
+  iterator end() { return iterator_at(capacity_); }
+  const_iterator end() const { return cend(); }
+  const_iterator cend() const { return const_cast<FlatHashMap&>(*this).end(); }
+
+  // Returns whether a mapping exists for the given key.
+  bool contains(const key_type& key) const { return find(key) != end(); }
+
+  // Returns a reference to the value for the given key, or std::nullopt if the key was not found.
+  //
+  //   ftl::FlatHashMap map = ftl::init::map('a', 'A')('b', 'B')('c', 'C');
+  //
+  //   const auto opt = map.get('c');
+  //   assert(opt == 'C');
+  //
+  //   char d = 'd';
+  //   const auto ref = map.get('d').value_or(std::ref(d));
+  //   ref.get() = 'D';
+  //   assert(d == 'D');
+  //
+  auto get(const key_type& key) const -> Optional<std::reference_wrapper<const mapped_type>> {
+    if (const auto it = find(key); it != end()) {
+      return std::cref(it->second);
+    }
+    return {};
+  }
+
+  auto get(const key_type& key) -> Optional<std::reference_wrapper<mapped_type>> {
+    if (const auto it = find(key); it != end()) {
+      return std::ref(it->second);
+    }
+    return {};
+  }
+
+  // Returns an iterator to an existing mapping for the given key, or the end() iterator otherwise.
+  const_iterator find(const key_type& key) const {
+    return const_cast<FlatHashMap&>(*this).find(key);
+  }
+
+  iterator find(const key_type& key) {
+    if (empty()) return end();
+    return iterator_at(find_index(key, details::mix_hash(Hash{}(key))));
+  }
+
+  // Inserts a mapping unless it exists. Returns an iterator to the inserted or existing mapping,
+  // and whether the mapping was inserted.
+  //
+  // The arguments must not refer to mappings of the map, since the map may grow before the value
+  // is constructed. If the map grows, then all iterators are invalidated.
+  //
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    const auto [index, inserted] = find_or_prepare_insert(key);
+    if (inserted) {
+      new (&slots_[index].pair) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                           std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    return {iterator_at(index), inserted};
+  }
+
+  // Replaces a mapping if it exists, and returns an iterator to it. Returns the end() iterator
+  // otherwise.
+  //
+  // The value is replaced via move constructor, so type V does not need to define copy/move
+  // assignment, e.g. its data members may be const.
+  //
+  // The arguments may directly or indirectly refer to the mapping being replaced.
+  //
+  // Iterators to the replaced mapping point to its replacement, and others remain valid.
+  //
+  template <typename... Args>
+  iterator try_replace(const key_type& key, Args&&... args) {
+    const auto it = find(key);
+    if (it == end()) return it;
+    replace(it, std::forward<Args>(args)...);
+    return it;
+  }
+
+  // In-place counterpart of std::unordered_map's insert_or_assign. Returns true on emplace, or
+  // false on replace.
+  //
+  // The value is emplaced and replaced via move constructor, so type V does not need to define
+  // copy/move assignment, e.g. its data members may be const.
+  //
+  // On emplace, if the map grows, then all iterators are invalidated. On replace, iterators to the
+  // replaced mapping point to its replacement, and others remain valid.
+  //
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_or_replace(const key_type& key, Args&&... args) {
+    const auto [it, ok] = try_emplace(key, std::forward<Args>(args)...);
+    if (ok) return {it, ok};
+    replace(it, std::forward<Args>(args)...);
+    return {it, ok};
+  }
+
+  // Removes a mapping if it exists, and returns whether it did.
+  //
+  // Only the iterators to the erased mapping are invalidated.
+  //
+  bool erase(const key_type& key) {
+    const auto it = find(key);
+    if (it == end()) return false;
+    erase_at(index_of(it));
+    return true;
+  }
+
+  // Removes the mapping of the iterator, and returns an iterator to the next mapping.
+  //
+  // Only the iterators to the erased mapping are invalidated.
+  //
+  iterator erase(const_iterator it) {
+    const size_type index = index_of(it);
+    erase_at(index);
+    return next_used(index);
+  }
+
+  // Removes all mappings, but keeps the slots.
+  //
+  // All iterators are invalidated.
+  //
+  void clear() {
+    destroy_slots();
+    std::fill_n(ctrl_.get(), capacity_, details::kEmpty);
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+  }
+
+  // Grows the map so that it holds at least n mappings without growing again.
+  //
+  // If the map grows, then all iterators are invalidated.
+  //
+  void reserve(size_type n) {
+    if (n > max_load(capacity_)) {
+      rehash(capacity_for(n));
+    }
+  }
+
+  void swap(FlatHashMap& other) noexcept {
+    using std::swap;
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+  }
+
+ private:
+  static constexpr size_type max_load(size_type capacity) { return capacity - capacity / 8; }
+
+  static constexpr size_type capacity_for(size_type n) {
+    size_type capacity = Group::kWidth;
+    while (max_load(capacity) < n) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  size_type group_count() const { return capacity_ / Group::kWidth; }
+
+  iterator iterator_at(size_type index) {
+    return iterator(ctrl_.get() + index, slots_.get() + index, ctrl_.get() + capacity_);
+  }
+
+  // Returns an iterator to the first used slot from the index.
+  iterator next_used(size_type index) {
+    auto it = iterator_at(index);
+    it.skip_unused();
+    return it;
+  }
+
+  size_type index_of(const_iterator it) const {
+    return static_cast<size_type>(it.ctrl_ - ctrl_.get());
+  }
+
+  void allocate(size_type capacity) {
+    ctrl_.reset(static_cast<Ctrl*>(::operator new(capacity, std::align_val_t(Group::kWidth))));
+    slots_ = std::make_unique<Slot[]>(capacity);
+  }
+
+  // Returns the slot of the key, or the capacity if the key was not found.
+  size_type find_index(const key_type& key, size_type hash) const {
+    const Ctrl h2 = details::h2(hash);
+    const size_type mask = group_count() - 1;
+
+    for (size_type group = details::h1(hash) & mask, step = 1;; group = (group + step++) & mask) {
+      const size_type first = group * Group::kWidth;
+      const Group g(&ctrl_[first]);
+      for (const size_type i : g.match(h2)) {
+        if (KeyEqual{}(slots_[first + i].pair.first, key)) {
+          return first + i;
+        }
+      }
+      if (g.match_empty()) return capacity_;
+    }
+  }
+
+  // Returns the first empty or deleted slot in the probe sequence of the hash.
+  size_type find_free_slot(size_type hash) const {
+    const size_type mask = group_count() - 1;
+    for (size_type group = details::h1(hash) & mask, step = 1;; group = (group + step++) & mask) {
+      const size_type first = group * Group::kWidth;
+      if (const auto free = Group(&ctrl_[first]).match_empty_or_deleted()) {
+        return first + free.lowest();
+      }
+    }
+  }
+
+  // Returns the slot of the key, and whether the key was not found, in which case its control byte
+  // is set and the caller must construct the mapping in the slot.
+  std::pair<size_type, bool> find_or_prepare_insert(const key_type& key) {
+    const size_type hash = details::mix_hash(Hash{}(key));
+    if (capacity_ == 0) {
+      rehash(Group::kWidth);
+    } else if (const size_type index = find_index(key, hash); index != capacity_) {
+      return {index, false};
+    }
+
+    size_type index = find_free_slot(hash);
+
+    // The deleted slots are reused without growing, and count towards the load otherwise.
+    if (ctrl_[index] == details::kEmpty) {
+      if (growth_left_ == 0) {
+        // Only drop the deleted slots if they make up enough of the load.
+        rehash(size_ * 32 <= capacity_ * 25 ? capacity_ : capacity_ * 2);
+        index = find_free_slot(hash);
+      }
+      growth_left_--;
+    }
+
+    ctrl_[index] = details::h2(hash);
+    size_++;
+    return {index, true};
+  }
+
+  template <typename... Args>
+  void replace(const_iterator it, Args&&... args) {
+    const size_type index = index_of(it);
+    value_type pair(std::piecewise_construct, std::forward_as_tuple(it->first),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+    std::destroy_at(&slots_[index].pair);
+    new (&slots_[index].pair) value_type(std::move(pair));
+  }
+
+  void erase_at(size_type index) {
+    std::destroy_at(&slots_[index].pair);
+    size_--;
+
+    // A lookup stops at a group with an empty slot, so if the group of the erased slot has one,
+    // then no key further in a probe sequence relies on this slot being used.
+    const size_type first = index - index % Group::kWidth;
+    if (Group(&ctrl_[first]).match_empty()) {
+      ctrl_[index] = details::kEmpty;
+      growth_left_++;
+    } else {
+      ctrl_[index] = details::kDeleted;
+    }
+  }
+
+  void rehash(size_type capacity) {
+    auto ctrl = std::move(ctrl_);
+    auto slots = std::move(slots_);
+    const size_type old_capacity = capacity_;
+
+    allocate(capacity);
+    std::fill_n(ctrl_.get(), capacity, details::kEmpty);
+    capacity_ = capacity;
+    growth_left_ = max_load(capacity) - size_;
+
+    for (size_type i = 0; i < old_capacity; i++) {
+      if (!details::is_full(ctrl[i])) continue;
+
+      auto& pair = slots[i].pair;
+      const size_type hash = details::mix_hash(Hash{}(pair.first));
+      const size_type index = find_free_slot(hash);
+      ctrl_[index] = details::h2(hash);
+      new (&slots_[index].pair) value_type(std::move(pair));
+      std::destroy_at(&pair);
+    }
+  }
+
+  void destroy_slots() {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (size_type i = 0; i < capacity_; i++) {
+        if (details::is_full(ctrl_[i])) {
+          std::destroy_at(&slots_[i].pair);
+        }
+      }
+    }
+  }
+
+  template <typename Tuple, std::size_t... Is>
+  void emplace_list(Tuple&& tuple, std::index_sequence<Is...>) {
+    // Each pair is a triple of std::piecewise_construct, the key, and the value arguments.
+    (emplace_pair(std::get<3 * Is + 1>(std::move(tuple)), std::get<3 * Is + 2>(std::move(tuple))),
+     ...);
+  }
+
+  template <typename KeyTuple, typename ArgsTuple>
+  void emplace_pair(KeyTuple&& key, ArgsTuple&& args) {
+    std::apply(
+        [this, &key](auto&&... values) {
+          try_emplace(std::get<0>(std::forward<KeyTuple>(key)),
+                      std::forward<decltype(values)>(values)...);
+        },
+        std::forward<ArgsTuple>(args));
+  }
+
+  std::unique_ptr<Ctrl[], CtrlDeleter> ctrl_;
+  std::unique_ptr<Slot[]> slots_;
+  size_type capacity_ = 0;
+  size_type size_ = 0;
+
+  // The number of empty slots that can be used before the map grows.
+  size_type growth_left_ = 0;
+};
+
+template <typename K, typename V, typename H, typename E>
+template <bool Const>
+class FlatHashMap<K, V, H, E>::Iterator {
+  using SlotPointer = std::conditional_t<Const, const Slot*, Slot*>;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename FlatHashMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+  using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+  Iterator() = default;
+
+  // Converts an iterator to a const_iterator.
+  template <bool C = Const, typename = std::enable_if_t<C>>
+  Iterator(const Iterator<false>& other)
+      : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_) {}
+
+  reference operator*() const { return slot_->pair; }
+  pointer operator->() const { return &slot_->pair; }
+
+  Iterator& operator++() {
+    ++ctrl_;
+    ++slot_;
+    skip_unused();
+    return *this;
+  }
+
+  Iterator operator++(int) {
+    const Iterator it = *this;
+    ++*this;
+    return it;
+  }
+
+  friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+    return lhs.ctrl_ == rhs.ctrl_;
+  }
+  friend bool operator!=(const Iterator& lhs, const Iterator& rhs) { return !(lhs == rhs); }
+
+ private:
+  friend FlatHashMap;
+  friend class Iterator<!Const>;
+
+  Iterator(const Ctrl* ctrl, SlotPointer slot, const Ctrl* end)
+      : ctrl_(ctrl), slot_(slot), end_(end) {}
+
+  void skip_unused() {
+    while (ctrl_ != end_ && !details::is_full(*ctrl_)) {
+      ++ctrl_;
+      ++slot_;
+    }
+  }
+
+  const Ctrl* ctrl_ = nullptr;
+  SlotPointer slot_ = nullptr;
+  const Ctrl* end_ = nullptr;
+};
+
+// Deduction guide for in-place constructor.
+template <typename K, typename V, typename E, std::size_t... Sizes, typename... Types>
+FlatHashMap(InitializerList<KeyValue<K, V, E>, std::index_sequence<Sizes...>, Types...>&&)
+    -> FlatHashMap<K, V, std::hash<K>, E>;
+
+// Returns whether the key-value pairs of two maps are equal.
+template <typename K, typename V, typename H, typename Q, typename W, typename I, typename E>
+bool operator==(const FlatHashMap<K, V, H, E>& lhs, const FlatHashMap<Q, W, I, E>& rhs) {
+  if (lhs.size() != rhs.size()) return false;
+
+  for (const auto& [k, v] : lhs) {
+    const auto& lv = v;
+    if (!rhs.get(k).transform([&lv](const W& rv) { return lv == rv; }).value_or(false)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// TODO: Remove in C++20.
+template <typename K, typename V, typename H, typename Q, typename W, typename I, typename E>
+inline bool operator!=(const FlatHashMap<K, V, H, E>& lhs, const FlatHashMap<Q, W, I, E>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename K, typename V, typename H, typename E>
+inline void swap(FlatHashMap<K, V, H, E>& lhs, FlatHashMap<K, V, H, E>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace android::ftl
@@ -41,6 +41,9 @@ struct is_small_vector;
 // Unlike std::vector, T does not require copy/move assignment, so may be an object with const data
 // members, or be const itself.
 //
+// If T is trivially copyable, the static storage is copied with memcpy as for StaticVector, and
+// elements are moved to dynamic storage in bulk when the vector is promoted.
+//
 // SmallVector<T, 0> is a specialization that thinly wraps std::vector.
 //
 // Example usage:
@@ -234,6 +237,20 @@ class SmallVector final : details::ArrayTraits<T>, details::ArrayComparators<Sma
     }
   }
 
+  // Reserves dynamic storage for at least n elements if n exceeds the static capacity, in which
+  // case the vector is promoted.
+  //
+  // If the vector is promoted or reaches a new dynamic capacity, then all iterators are
+  // invalidated.
+  //
+  void reserve(size_type n) {
+    if (Dynamic* const vector = std::get_if<Dynamic>(&vector_)) {
+      vector->reserve(n);
+    } else if (n > Static::max_size()) {
+      promote(std::get<Static>(vector_), n);
+    }
+  }
+
   // Extracts the elements as std::vector.
   std::vector<T> promote() && {
     if (dynamic()) {
@@ -266,19 +283,18 @@ class SmallVector final : details::ArrayTraits<T>, details::ArrayComparators<Sma
 
     auto& vector = std::get<Static>(vector_);
     if (vector.full()) {
-      return (promote(vector).*InsertDynamic)(std::forward<Args>(args)...);
+      // Allocate double capacity to reduce probability of reallocation.
+      return (promote(vector, Static::max_size() * 2).*InsertDynamic)(std::forward<Args>(args)...);
     } else {
       return (vector.*InsertStatic)(std::forward<Args>(args)...);
     }
   }
 
-  Dynamic& promote(Static& static_vector) {
-    assert(static_vector.full());
-
-    // Allocate double capacity to reduce probability of reallocation.
+  Dynamic& promote(Static& static_vector, size_type capacity) {
     Dynamic vector;
-    vector.reserve(Static::max_size() * 2);
-    std::move(static_vector.begin(), static_vector.end(), std::back_inserter(vector));
+    vector.reserve(capacity);
+    vector.append(std::make_move_iterator(static_vector.begin()),
+                  std::make_move_iterator(static_vector.end()));
 
     return vector_.template emplace<Dynamic>(std::move(vector));
   }
@@ -398,6 +414,20 @@ class SmallVector<T, 0> final : details::ArrayTraits<T>,
   std::vector<T> promote() && { return std::move(*this); }
 
  private:
+  template <typename, std::size_t>
+  friend class SmallVector;
+
+  // Appends the range within the reserved capacity. Trivially copyable elements are appended in
+  // bulk, since std::vector then copies them with memcpy.
+  template <typename Iterator>
+  void append(Iterator first, Iterator last) {
+    if constexpr (std::is_trivially_copyable_v<T> && std::is_copy_assignable_v<T>) {
+      Impl::insert(Impl::end(), first, last);
+    } else {
+      std::copy(first, last, std::back_inserter(static_cast<Impl&>(*this)));
+    }
+  }
+
   template <typename U, std::size_t M>
   static Impl convert(SmallVector<U, M>&& other) {
     if constexpr (std::is_constructible_v<Impl, std::vector<U>&&>) {
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <type_traits>
@@ -42,6 +43,9 @@ constexpr struct IteratorRangeTag {
 // Unlike std::vector, T does not require copy/move assignment, so may be an object with const data
 // members, or be const itself.
 //
+// If T is trivially copyable, elements are copied, moved, swapped and erased with memcpy rather
+// than one by one, and vectors with a small capacity copy their storage as a whole.
+//
 // StaticVector<T, 1> is analogous to an iterable std::optional.
 // StaticVector<T, 0> is an error.
 //
@@ -121,10 +125,23 @@ class StaticVector final : details::ArrayTraits<T>,
   StaticVector() = default;
 
   // Copies and moves a vector, respectively.
-  StaticVector(const StaticVector& other)
-      : StaticVector(kIteratorRange, other.begin(), other.end()) {}
+  StaticVector(const StaticVector& other) {
+    if constexpr (kTriviallyCopyable) {
+      copy_trivially(other);
+    } else {
+      uninitialized_copy(other.begin(), other.end(), begin());
+      size_ = other.size_;
+    }
+  }
 
-  StaticVector(StaticVector&& other) { swap<true>(other); }
+  StaticVector(StaticVector&& other) {
+    if constexpr (kTriviallyCopyable) {
+      copy_trivially(other);
+      other.size_ = 0;
+    } else {
+      swap<true>(other);
+    }
+  }
 
   // Copies at most N elements from a smaller convertible vector.
   template <typename U, std::size_t M>
@@ -210,14 +227,24 @@ class StaticVector final : details::ArrayTraits<T>,
   ~StaticVector() { std::destroy(begin(), end()); }
 
   StaticVector& operator=(const StaticVector& other) {
-    StaticVector copy(other);
-    swap(copy);
+    if constexpr (kTriviallyCopyable) {
+      copy_trivially(other);
+    } else {
+      StaticVector copy(other);
+      swap(copy);
+    }
     return *this;
   }
 
   StaticVector& operator=(StaticVector&& other) {
-    clear();
-    swap<true>(other);
+    if constexpr (kTriviallyCopyable) {
+      if (&other == this) return *this;
+      copy_trivially(other);
+      other.size_ = 0;
+    } else {
+      clear();
+      swap<true>(other);
+    }
     return *this;
   }
 
@@ -318,6 +345,14 @@ class StaticVector final : details::ArrayTraits<T>,
   // The last() and end() iterators, as well as those to the erased element, are invalidated.
   //
   void unstable_erase(const_iterator it) {
+    if constexpr (kTriviallyCopyable) {
+      if (it != last()) {
+        std::memcpy(const_cast<void*>(static_cast<const void*>(it)), last(), sizeof(value_type));
+      }
+      --size_;
+      return;
+    }
+
     std::destroy_at(it);
     if (it != last()) {
       // Move last element and destroy its source for destructor side effects. This is only
@@ -329,6 +364,23 @@ class StaticVector final : details::ArrayTraits<T>,
   }
 
  private:
+  static constexpr bool kTriviallyCopyable = std::is_trivially_copyable_v<T>;
+
+  // Copying a whole storage of at most this size is a few fixed-size moves, which is faster than a
+  // copy sized at run time.
+  static constexpr std::size_t kMaxStorageCopySize = 64;
+
+  // Replaces the elements with those of the other vector, if T is trivially copyable.
+  void copy_trivially(const StaticVector& other) {
+    static_assert(kTriviallyCopyable);
+    if constexpr (sizeof(data_) <= kMaxStorageCopySize) {
+      std::memcpy(data_, other.data_, sizeof(data_));
+    } else {
+      std::memcpy(data_, other.data_, other.size_ * sizeof(value_type));
+    }
+    size_ = other.size_;
+  }
+
   // Recursion for variadic constructor.
   template <std::size_t I, typename E, typename... Es>
   StaticVector(std::index_sequence<I>, E&& element, Es&&... elements)
@@ -391,6 +443,19 @@ void StaticVector<T, N>::swap(StaticVector& other) {
   auto [to, from] = std::make_pair(this, &other);
   if (from == this) return;
 
+  if constexpr (kTriviallyCopyable) {
+    // The elements are swapped through a copy of this vector, but only as much as it holds.
+    StaticVector copy;
+    if constexpr (IsEmpty) {
+      assert(empty());
+    } else {
+      copy.copy_trivially(*this);
+    }
+    copy_trivially(other);
+    other.copy_trivially(copy);
+    return;
+  }
+
   // Assume this vector has fewer elements, so the excess of the other vector will be moved to it.
   auto [min, max] = std::make_pair(size(), other.size());
 
@@ -28,8 +28,11 @@
  * The InputConsumer is used by the application to receive events from the input dispatcher.
  */
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/chrono_utils.h>
 #include <android-base/result.h>
@@ -39,6 +42,7 @@
 #include <binder/Parcelable.h>
 #include <input/Input.h>
 #include <input/InputVerifier.h>
+#include <input/TouchResampler.h>
 #include <sys/stat.h>
 #include <ui/Transform.h>
 #include <utils/BitSet.h>
@@ -48,6 +52,7 @@
 
 
 namespace android {
+class InputChannelMemory;
 class Parcel;
 
 /*
@@ -126,7 +131,9 @@ struct InputMessage {
             int32_t metaState;
             int32_t buttonState;
             MotionClassification classification; // base type: uint8_t
-            uint8_t empty2[3];                   // 3 bytes to fill gap created by classification
+            // The number of samples after the first one, see extraSamples.
+            uint8_t extraSampleCount;
+            uint8_t empty2[2]; // 2 bytes to fill gap created by classification and sample count
             int32_t edgeFlags;
             nsecs_t downTime __attribute__((aligned(8)));
             float dsdx; // Begin window transform
@@ -146,16 +153,34 @@ struct InputMessage {
             float txRaw;   //
             float tyRaw;   // End raw transform
             /**
-             * The "pointers" field must be the last field of the struct InputMessage.
-             * When we send the struct InputMessage across the socket, we are not
-             * writing the entire "pointers" array, but only the pointerCount portion
-             * of it as an optimization. Adding a field after "pointers" would break this.
+             * The "pointers" field must be the last field of the struct InputMessage, except for
+             * "extraSamples". When we send the struct InputMessage across the socket, we are not
+             * writing the entire "pointers" array, but only the pointerCount portion of it as an
+             * optimization, unless the message has extra samples. Adding a field after "pointers"
+             * would break this.
              */
             struct Pointer {
                 PointerProperties properties;
                 PointerCoords coords;
             } pointers[MAX_POINTERS] __attribute__((aligned(8)));
 
+            // The maximum number of samples of a message, including the first one.
+            static constexpr size_t MAX_SAMPLES = 8;
+
+            /**
+             * A MOVE message may carry the later samples of the same pointers, which would
+             * otherwise be sent in their own messages. The pointers of the sample i, starting
+             * from 0 for the first sample, are at pointers[i * pointerCount], and the other
+             * fields of the samples after the first one are in extraSamples[i - 1]. The receiver
+             * splits the message back into one message per sample.
+             */
+            struct Sample {
+                uint32_t seq;
+                int32_t eventId;
+                nsecs_t eventTime;
+                std::array<uint8_t, 32> hmac;
+            } extraSamples[MAX_SAMPLES - 1] __attribute__((aligned(8)));
+
             int32_t getActionId() const {
                 uint32_t index = (action & AMOTION_EVENT_ACTION_POINTER_INDEX_MASK)
                         >> AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT;
@@ -163,8 +188,10 @@ struct InputMessage {
             }
 
             inline size_t size() const {
-                return sizeof(Motion) - sizeof(Pointer) * MAX_POINTERS
-                        + sizeof(Pointer) * pointerCount;
+                if (extraSampleCount != 0) {
+                    return offsetof(Motion, extraSamples) + sizeof(Sample) * extraSampleCount;
+                }
+                return offsetof(Motion, pointers) + sizeof(Pointer) * pointerCount;
             }
         } motion;
 
@@ -232,15 +259,30 @@ struct InputMessage {
  *
  * Each endpoint has its own InputChannel object that specifies its file descriptor.
  *
+ * A pair of channels can also share memory with a ring of messages for each direction. The
+ * messages then go through the rings, and the socket only carries the wakeups of the endpoints
+ * which wait for messages, so that the endpoints keep polling the fd of the socket.
+ *
  * The input channel is closed when all references to it are released.
  */
 class InputChannel : public Parcelable {
 public:
+    enum class Transport {
+        // The messages are sent on the socket.
+        SOCKET,
+        // The messages go through shared memory, if it can be set up, and the socket otherwise.
+        SHARED_MEMORY,
+    };
+
     static std::unique_ptr<InputChannel> create(const std::string& name,
                                                 android::base::unique_fd fd, sp<IBinder> token);
     InputChannel() = default;
     InputChannel(const InputChannel& other)
-          : mName(other.mName), mFd(::dup(other.mFd)), mToken(other.mToken){};
+          : mName(other.mName),
+            mFd(::dup(other.mFd)),
+            mToken(other.mToken),
+            mMemory(other.mMemory),
+            mIsServer(other.mIsServer){};
     InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token);
     ~InputChannel() override;
     /**
@@ -248,15 +290,23 @@ public:
      * The two returned input channels are equivalent, and are labeled as "server" and "client"
      * for convenience. The two input channels share the same token.
      *
+     * The channels use the shared memory transport if the ro.input.shared_memory_channels
+     * system property is set.
+     *
      * Return OK on success.
      */
     static status_t openInputChannelPair(const std::string& name,
                                          std::unique_ptr<InputChannel>& outServerChannel,
                                          std::unique_ptr<InputChannel>& outClientChannel);
+    static status_t openInputChannelPair(const std::string& name, Transport transport,
+                                         std::unique_ptr<InputChannel>& outServerChannel,
+                                         std::unique_ptr<InputChannel>& outClientChannel);
 
     inline std::string getName() const { return mName; }
     inline const android::base::unique_fd& getFd() const { return mFd; }
     inline sp<IBinder> getToken() const { return mToken; }
+    // Whether the messages go through shared memory rather than the socket.
+    inline bool usesSharedMemory() const { return mMemory != nullptr; }
 
     /* Send a message to the other endpoint.
      *
@@ -320,11 +370,18 @@ public:
 
 private:
     base::unique_fd dupFd() const;
+    status_t sendMessageToMemory(const InputMessage* msg);
+    status_t receiveMessageFromMemory(InputMessage* msg);
 
     std::string mName;
     android::base::unique_fd mFd;
 
     sp<IBinder> mToken;
+
+    // The shared memory of the pair of channels, if they use the shared memory transport, and
+    // whether this is the server channel, which writes to the server to client ring.
+    std::shared_ptr<InputChannelMemory> mMemory;
+    bool mIsServer = false;
 };
 
 /*
@@ -354,12 +411,27 @@ public:
                              int32_t flags, int32_t keyCode, int32_t scanCode, int32_t metaState,
                              int32_t repeatCount, nsecs_t downTime, nsecs_t eventTime);
 
+    /* A later sample of a motion event, which is published in the message of the event. */
+    struct MotionSample {
+        uint32_t seq;
+        int32_t eventId;
+        std::array<uint8_t, 32> hmac;
+        nsecs_t eventTime;
+        // The coordinates of the pointers of the event, in the same order.
+        const PointerCoords* pointerCoords;
+    };
+
     /* Publishes a motion event to the input channel.
+     *
+     * The later samples are the MOVE events which follow this one, with the same pointers and
+     * state, and which are published in the same message. The consumer receives them as if they
+     * were published one by one.
      *
      * Returns OK on success.
      * Returns WOULD_BLOCK if the channel is full.
      * Returns DEAD_OBJECT if the channel's peer has been closed.
-     * Returns BAD_VALUE if seq is 0 or if pointerCount is less than 1 or greater than MAX_POINTERS.
+     * Returns BAD_VALUE if seq is 0 or if pointerCount is less than 1 or greater than MAX_POINTERS,
+     * or if the later samples do not fit in one message, see getMaxMotionSampleCount.
      * Other errors probably indicate that the channel is broken.
      */
     status_t publishMotionEvent(uint32_t seq, int32_t eventId, int32_t deviceId, int32_t source,
@@ -371,7 +443,13 @@ public:
                                 float yCursorPosition, const ui::Transform& rawTransform,
                                 nsecs_t downTime, nsecs_t eventTime, uint32_t pointerCount,
                                 const PointerProperties* pointerProperties,
-                                const PointerCoords* pointerCoords);
+                                const PointerCoords* pointerCoords,
+                                const std::vector<MotionSample>& laterSamples = {});
+
+    /* Returns the maximum number of samples, including the first one, of a motion event with
+     * pointerCount pointers which are published in one message.
+     */
+    static size_t getMaxMotionSampleCount(uint32_t pointerCount);
 
     /* Publishes a focus event to the input channel.
      *
@@ -458,6 +536,10 @@ public:
     /* Create a consumer associated with an input channel, override resampling system property */
     explicit InputConsumer(const std::shared_ptr<InputChannel>& channel,
                            bool enableTouchResampling);
+    /* Create a consumer associated with an input channel, which resamples the touches with the
+     * given resampler, or does not resample them if it is null. */
+    explicit InputConsumer(const std::shared_ptr<InputChannel>& channel,
+                           std::unique_ptr<TouchResampler> touchResampler);
 
     /* Destroys the consumer and releases its input channel. */
     ~InputConsumer();
@@ -521,14 +603,18 @@ public:
     std::string dump() const;
 
 private:
-    // True if touch resampling is enabled.
-    const bool mResampleTouch;
+    // The resampler of the touches, or null if touch resampling is disabled.
+    const std::unique_ptr<TouchResampler> mTouchResampler;
 
     std::shared_ptr<InputChannel> mChannel;
 
     // The current input message.
     InputMessage mMsg;
 
+    // The samples of the last received message after its first one, each in its own message,
+    // which are handled before the next message is received.
+    std::deque<InputMessage> mExtraSamples;
+
     // True if mMsg contains a valid input message that was deferred from the previous
     // call to consume and that still needs to be handled.
     bool mMsgDeferred;
@@ -582,28 +668,31 @@ private:
         int32_t source;
         size_t historyCurrent;
         size_t historySize;
-        History history[2];
+        History history[3];
         History lastResample;
+        // The average interval between the moves reported by the device, or 0 if unknown.
+        nsecs_t reportInterval;
 
         void initialize(int32_t deviceId, int32_t source) {
             this->deviceId = deviceId;
             this->source = source;
             historyCurrent = 0;
             historySize = 0;
+            reportInterval = 0;
             lastResample.eventTime = 0;
             lastResample.idBits.clear();
         }
 
         void addHistory(const InputMessage& msg) {
-            historyCurrent ^= 1;
-            if (historySize < 2) {
+            historyCurrent = (historyCurrent + 2) % 3;
+            if (historySize < 3) {
                 historySize += 1;
             }
             history[historyCurrent].initializeFrom(msg);
         }
 
         const History* getHistory(size_t index) const {
-            return &history[(historyCurrent + index) & 1];
+            return &history[(historyCurrent + index) % 3];
         }
 
         bool recentCoordinatesAreIdentical(uint32_t id) const {
@@ -645,6 +734,8 @@ private:
 
     status_t consumeBatch(InputEventFactoryInterface* factory,
             nsecs_t frameTime, uint32_t* outSeq, InputEvent** outEvent);
+    // Moves the samples of mMsg after its first one to mExtraSamples.
+    void splitSamples(nsecs_t consumeTime);
     status_t consumeSamples(InputEventFactoryInterface* factory,
             Batch& batch, size_t count, uint32_t* outSeq, InputEvent** outEvent);
 
@@ -671,6 +762,8 @@ private:
     static ssize_t findSampleNoLaterThan(const Batch& batch, nsecs_t time);
 
     static bool isTouchResamplingEnabled();
+    // Creates the touch resampler selected by the system property.
+    static std::unique_ptr<TouchResampler> createTouchResampler();
 };
 
 } // namespace android
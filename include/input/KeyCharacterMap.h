@@ -29,6 +29,7 @@
 #include <utils/Tokenizer.h>
 #include <utils/Unicode.h>
 #include <map>
+#include <vector>
 
 // Maximum number of keys supported by KeyCharacterMaps
 #define MAX_KEYS 8192
@@ -73,7 +74,9 @@ public:
         int32_t metaState;
     };
 
-    /* Loads a key character map from a file. */
+    /* Loads a key character map from a file, in the text format or in the binary one written
+     * by toBinary(). The parsed files are cached, so the map which is returned is a copy of the
+     * cached one. */
     static base::Result<std::shared_ptr<KeyCharacterMap>> load(const std::string& filename,
                                                                Format format);
 
@@ -144,6 +147,12 @@ public:
     std::pair<int32_t /*keyCode*/, int32_t /*metaState*/> applyKeyBehavior(int32_t keyCode,
                                                                            int32_t metaState) const;
 
+    /* Returns the key map in the binary format which load() accepts as well as the text one, so
+     * that the key character map files can be precompiled, e.g. at build time. The binary maps
+     * are mapped read-only and read without tokenizing. The key remappings, which are not part
+     * of the files, are not included. */
+    std::vector<uint8_t> toBinary() const;
+
 #ifdef __linux__
     /* Reads a key map from a parcel. */
     static std::shared_ptr<KeyCharacterMap> readFromParcel(Parcel* parcel);
@@ -265,6 +274,11 @@ private:
             int32_t keyCode, int32_t keyMetaState,
             int32_t* currentMetaState);
 
+    /* Reads a key map written by toBinary(), which has to have the given format. */
+    static base::Result<std::shared_ptr<KeyCharacterMap>> fromBinary(const std::string& filename,
+                                                                     const uint8_t* data,
+                                                                     size_t size, Format format);
+
     /* Clears all data stored in this key character map */
     void clear();
 
@@ -21,6 +21,7 @@
 #include <utils/Errors.h>
 #include <utils/Tokenizer.h>
 #include <set>
+#include <vector>
 
 #include <input/InputDevice.h>
 
@@ -63,6 +64,8 @@ struct AxisInfo {
  */
 class KeyLayoutMap {
 public:
+    // Loads a key layout map from its contents, or else from a file, in the text format or in
+    // the binary one written by toBinary().
     static base::Result<std::shared_ptr<KeyLayoutMap>> load(const std::string& filename,
                                                             const char* contents = nullptr);
     static base::Result<std::shared_ptr<KeyLayoutMap>> loadContents(const std::string& filename,
@@ -80,10 +83,19 @@ public:
     // Return pair of sensor type and sensor data index, for the input device abs code
     base::Result<std::pair<InputDeviceSensorType, int32_t>> mapSensor(int32_t absCode) const;
 
+    // Returns the map in the binary format which load() accepts as well as the text one, so that
+    // the key layout files can be precompiled, e.g. at build time. The binary maps are mapped
+    // read-only and read without tokenizing.
+    std::vector<uint8_t> toBinary() const;
+
     virtual ~KeyLayoutMap();
 
 private:
+    static base::Result<std::shared_ptr<KeyLayoutMap>> parse(const std::string& filename,
+                                                             const char* contents);
     static base::Result<std::shared_ptr<KeyLayoutMap>> load(Tokenizer* tokenizer);
+    static base::Result<std::shared_ptr<KeyLayoutMap>> fromBinary(const uint8_t* data,
+                                                                  size_t size);
 
     struct Key {
         int32_t keyCode;
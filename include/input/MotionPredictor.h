@@ -86,7 +86,9 @@ private:
 
     std::unique_ptr<TfLiteMotionPredictorModel> mModel;
 
-    std::unique_ptr<TfLiteMotionPredictorBuffers> mBuffers;
+    // The buffers of each pointer of the current gesture, by pointer id. The pointers which are
+    // ready are predicted together, in one batch of the model.
+    std::unordered_map<int32_t, TfLiteMotionPredictorBuffers> mBuffers;
     std::optional<MotionEvent> mLastEvent;
 };
 
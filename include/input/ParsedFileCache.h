@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/result.h>
+#include <sys/stat.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+
+namespace android {
+
+/*
+ * Caches the objects parsed from files, such as key layouts, so that a file which is loaded
+ * again, e.g. for each input device with the same configuration, is only parsed once.
+ *
+ * An entry is only used while its file has the same inode, size and modification time as when
+ * it was parsed. The values are shared, so mutable objects should be copied by the callers.
+ */
+template <typename Value, typename Key = std::string>
+class ParsedFileCache {
+public:
+    // Returns the value of the file at path, which is parsed by load() unless it is cached.
+    // Only the values which are loaded successfully are cached.
+    template <typename Load>
+    base::Result<Value> getOrLoad(const Key& key, const std::string& path, Load load) {
+        // The file is stat'ed before it is parsed, so that a value parsed while the file was
+        // changing is parsed again the next time.
+        const std::optional<FileStamp> stamp = getFileStamp(path);
+        if (stamp) {
+            std::scoped_lock lock(mLock);
+            auto it = mEntries.find(key);
+            if (it != mEntries.end() && it->second.first == *stamp) {
+                return it->second.second;
+            }
+        }
+        base::Result<Value> value = load();
+        if (stamp && value.ok()) {
+            std::scoped_lock lock(mLock);
+            mEntries.insert_or_assign(key, std::make_pair(*stamp, *value));
+        }
+        return value;
+    }
+
+private:
+    using FileStamp = std::tuple<ino_t, off_t, time_t, long>;
+
+    static std::optional<FileStamp> getFileStamp(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+        return FileStamp{st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec};
+    }
+
+    std::mutex mLock;
+    std::map<Key, std::pair<FileStamp, Value>> mEntries;
+};
+
+} // namespace android
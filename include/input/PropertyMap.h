@@ -77,7 +77,8 @@ public:
     /* Adds all values from the specified property map. */
     void addAll(const PropertyMap* map);
 
-    /* Loads a property map from a file. */
+    /* Loads a property map from a file. The parsed files are cached, so the map which is
+     * returned is a copy of the cached one. */
     static android::base::Result<std::unique_ptr<PropertyMap>> load(const char* filename);
 
 private:
@@ -71,8 +71,9 @@ public:
     // Resets all buffers to their initial state.
     void reset();
 
-    // Copies the buffers to those of a model for prediction.
-    void copyTo(TfLiteMotionPredictorModel& model) const;
+    // Copies the buffers to those of a model for prediction, as the input at the given index of
+    // its batch.
+    void copyTo(TfLiteMotionPredictorModel& model, size_t batchIndex = 0) const;
 
     // Returns the current axis of the buffer's samples. Only valid if isReady().
     TfLiteMotionPredictorSample axisFrom() const { return *mAxisFrom; }
@@ -103,25 +104,34 @@ public:
 
     ~TfLiteMotionPredictorModel();
 
-    // Returns the length of the model's input buffers.
+    // Returns the length of the model's input buffers, for each input of the batch.
     size_t inputLength() const;
 
-    // Returns the length of the model's output buffers.
+    // Returns the length of the model's output buffers, for each input of the batch.
     size_t outputLength() const;
 
+    // Returns the number of inputs which the model is executed on at once.
+    size_t batchSize() const { return mBatchSize; }
+
+    // Sets the number of inputs which the model is executed on at once, and reallocates its
+    // tensors if it changed. Returns false if the input tensors have no batch dimension, in which
+    // case the batch size stays 1.
+    bool setBatchSize(size_t batchSize);
+
     // Executes the model.
     // Returns true if the model successfully executed and the output tensors can be read.
     bool invoke();
 
-    // Returns mutable buffers to the input tensors of inputLength() elements.
+    // Returns mutable buffers to the input tensors of inputLength() elements for each input of
+    // the batch, one input after the other.
     std::span<float> inputR();
     std::span<float> inputPhi();
     std::span<float> inputPressure();
     std::span<float> inputOrientation();
     std::span<float> inputTilt();
 
-    // Returns immutable buffers to the output tensors of identical length. Only valid after a
-    // successful call to invoke().
+    // Returns immutable buffers to the output tensors of outputLength() elements for each input
+    // of the batch, one input after the other. Only valid after a successful call to invoke().
     std::span<const float> outputR() const;
     std::span<const float> outputPhi() const;
     std::span<const float> outputPressure() const;
@@ -148,6 +158,7 @@ private:
     std::unique_ptr<tflite::FlatBufferModel> mModel;
     std::unique_ptr<tflite::Interpreter> mInterpreter;
     tflite::SignatureRunner* mRunner = nullptr;
+    size_t mBatchSize = 1;
 };
 
 } // namespace android
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * Computes the positions of the touches at the sample time of a frame from the positions that the
+ * touch device reported, so that the touches move smoothly with the frames of the app.
+ *
+ * The consumer samples the touches some latency before the frame time. When the device reported
+ * a position after the sample time, the resampler interpolates the touch between its reports, and
+ * otherwise it predicts where the touch moved after its last report.
+ */
+class TouchResampler {
+public:
+    // A position of a pointer at a time.
+    struct Sample {
+        nsecs_t eventTime;
+        float x;
+        float y;
+    };
+
+    virtual ~TouchResampler() = default;
+
+    virtual std::string getName() const = 0;
+
+    /*
+     * Returns how long before the frame time the touches are sampled, for a device which reports
+     * them every reportInterval, or 0 if the interval is not known yet. The longer the latency,
+     * the more often a touch is interpolated rather than predicted.
+     */
+    virtual nsecs_t getLatency(nsecs_t reportInterval) const = 0;
+
+    // Returns how far a touch is predicted after its last report, for reports delta apart.
+    virtual nsecs_t getMaxPrediction(nsecs_t delta) const = 0;
+
+    /*
+     * Returns the position of a pointer at the sample time from its last reports, from the oldest
+     * to the most recent one. There are at least two reports. The sample time is either between
+     * the last two reports, or after the last one.
+     */
+    virtual Sample resample(const Sample* samples, size_t sampleCount,
+                            nsecs_t sampleTime) const = 0;
+};
+
+/*
+ * Interpolates and predicts the touches along the line through their last two reports. They are
+ * sampled a fixed latency before the frame, so that most of their reports can be interpolated.
+ */
+class LinearTouchResampler : public TouchResampler {
+public:
+    std::string getName() const override;
+    nsecs_t getLatency(nsecs_t reportInterval) const override;
+    nsecs_t getMaxPrediction(nsecs_t delta) const override;
+    Sample resample(const Sample* samples, size_t sampleCount, nsecs_t sampleTime) const override;
+};
+
+/*
+ * Interpolates and predicts the touches along the parabola through their last three reports, which
+ * follows the acceleration of the touches. The predictions are accurate enough to sample the
+ * touches closer to the frame, with a latency proportional to the interval between the reports.
+ */
+class QuadraticTouchResampler : public TouchResampler {
+public:
+    std::string getName() const override;
+    nsecs_t getLatency(nsecs_t reportInterval) const override;
+    nsecs_t getMaxPrediction(nsecs_t delta) const override;
+    Sample resample(const Sample* samples, size_t sampleCount, nsecs_t sampleTime) const override;
+};
+
+} // namespace android
@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <sys/time.h>
+#include <memory>
 #include <vector>
 
 namespace android {
@@ -28,6 +29,8 @@ namespace android {
  * Represents data from a single scan of the touchscreen device.
  * Similar in concept to a video frame, but the touch strength is used as
  * the values instead.
+ * The data is shared between the copies of a frame, which are made as the
+ * frame is passed along with the motion events. It is never modified in place.
  */
 class TouchVideoFrame {
 public:
@@ -62,10 +65,17 @@ public:
      */
     void rotate(ui::Rotation orientation);
 
+    /**
+     * Downsample the video frame by averaging blocks of factor x factor values.
+     * The blocks at the bottom and right edges cover the remaining values when
+     * the dimensions are not multiples of the factor.
+     */
+    void downsample(uint32_t factor);
+
 private:
     uint32_t mHeight;
     uint32_t mWidth;
-    std::vector<int16_t> mData;
+    std::shared_ptr<const std::vector<int16_t>> mData;
     struct timeval mTimestamp;
 
     /**
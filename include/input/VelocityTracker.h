@@ -44,7 +44,8 @@ public:
         INT1 = 7,
         INT2 = 8,
         LEGACY = 9,
-        MAX = LEGACY,
+        LSQ2_INCREMENTAL = 10,
+        MAX = LSQ2_INCREMENTAL,
     };
 
     struct Estimator {
@@ -224,6 +225,61 @@ private:
 };
 
 
+/*
+ * Velocity tracker algorithm based on unweighted least-squares quadratic regression, like
+ * LeastSquaresVelocityTrackerStrategy with degree 2, which keeps running sums of the samples in its
+ * window instead of refitting all of them for each estimate. Adding a sample and getting an
+ * estimate both take constant time.
+ */
+class IncrementalLeastSquaresVelocityTrackerStrategy : public VelocityTrackerStrategy {
+public:
+    IncrementalLeastSquaresVelocityTrackerStrategy();
+    ~IncrementalLeastSquaresVelocityTrackerStrategy() override;
+
+    void clearPointer(int32_t pointerId) override;
+    void addMovement(nsecs_t eventTime, int32_t pointerId, float position) override;
+    std::optional<VelocityTracker::Estimator> getEstimator(int32_t pointerId) const override;
+
+private:
+    // The same window as LeastSquaresVelocityTrackerStrategy.
+    static const nsecs_t HORIZON = 100 * 1000000; // 100 ms
+    static const uint32_t HISTORY_SIZE = 20;
+
+    struct Movement {
+        nsecs_t eventTime;
+        float position;
+    };
+
+    // The sums of the powers of the times t of the samples, relative to a reference time, and of
+    // their products with the positions p, for all the samples of the window.
+    struct Sums {
+        double t = 0, t2 = 0, t3 = 0, t4 = 0;
+        double p = 0, tp = 0, t2p = 0;
+
+        // Adds a sample to the sums with a sign of 1, or removes it with a sign of -1.
+        void add(double time, double position, double sign);
+    };
+
+    struct Window {
+        // The movements of the window, from the oldest one at the start index.
+        std::array<Movement, HISTORY_SIZE> movements;
+        uint32_t start = 0;
+        uint32_t size = 0;
+        nsecs_t referenceTime = 0;
+        Sums sums;
+
+        const Movement& newest() const { return movements[(start + size - 1) % HISTORY_SIZE]; }
+    };
+
+    void addToSums(Window& window, const Movement& movement, double sign) const;
+    // Recomputes the sums relative to the newest movement, before their values are too far from
+    // the reference time for the running sums to stay accurate.
+    void rebase(Window& window) const;
+
+    std::map<int32_t /*pointerId*/, Window> mWindows;
+};
+
+
 /*
  * Velocity tracker algorithm that uses an IIR filter.
  */
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *                        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_POWERHINTDISPATCHER_H
+#define ANDROID_POWERHINTDISPATCHER_H
+
+#include <android-base/thread_annotations.h>
+#include <android/hardware/power/Boost.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/Mode.h>
+#include <android/hardware/power/SessionHint.h>
+#include <android/hardware/power/WorkDuration.h>
+#include <powermanager/PowerHalWrapper.h>
+#include <semaphore.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+namespace power {
+
+// -------------------------------------------------------------------------------------------------
+
+// Delivers the power hints to the Power HAL from a dedicated thread, so that the callers on a hot
+// path, like the main thread of SurfaceFlinger, never wait for a binder transaction.
+//
+// The hints are only recorded by the callers, with atomic operations and without taking a lock,
+// and the thread delivers the latest state of each hint once per coalescing window: a boost which
+// is requested several times is sent once, a mode which is enabled and then disabled again is not
+// sent at all, and only the last target work duration is sent. The actual work durations are
+// reported together, in a single call of the hint session.
+//
+// The results of the HAL calls are not returned to the callers, but the boosts and modes which the
+// HAL reports as unsupported are remembered, and so are the failures of the hint session.
+class PowerHintDispatcher {
+public:
+    static constexpr std::chrono::nanoseconds DEFAULT_COALESCING_WINDOW =
+            std::chrono::milliseconds(1);
+
+    explicit PowerHintDispatcher(HalWrapper& hal,
+                                 std::chrono::nanoseconds coalescingWindow =
+                                         DEFAULT_COALESCING_WINDOW);
+    // Delivers the pending hints before returning.
+    ~PowerHintDispatcher();
+
+    void setBoost(hardware::power::Boost boost, int32_t durationMs);
+    void setMode(hardware::power::Mode mode, bool enabled);
+
+    // Returns false once the HAL reported that it does not support the boost or the mode.
+    bool isSupported(hardware::power::Boost boost) const;
+    bool isSupported(hardware::power::Mode mode) const;
+
+    // Sets the hint session which the session hints and work durations are delivered to. The
+    // session is replaced, or cleared with nullptr, whenever the caller restarts it.
+    void setHintSession(sp<hardware::power::IPowerHintSession> session);
+
+    void sendHint(hardware::power::SessionHint hint);
+    void updateTargetWorkDuration(int64_t targetDurationNanos);
+    // Must only be called from one thread at a time. Returns false if the duration was dropped,
+    // because the durations were reported faster than the HAL accepts them.
+    bool reportActualWorkDuration(const hardware::power::WorkDuration& duration);
+
+    // Returns whether a call of the hint session failed since the last call of this method. The
+    // dispatcher then stops using the session, until the caller sets a new one.
+    bool takeHintSessionFailure();
+
+    // Waits until the hints recorded before this call are delivered.
+    void flush();
+
+private:
+    // The boosts, modes and session hints are indexed by their value in bit masks.
+    static constexpr size_t MAX_HINTS = 64;
+    static constexpr size_t WORK_DURATION_CAPACITY = 64;
+
+    HalWrapper& mHal;
+    const std::chrono::nanoseconds mCoalescingWindow;
+
+    std::atomic<uint64_t> mPendingBoosts = 0;
+    std::array<std::atomic<int32_t>, MAX_HINTS> mBoostDurationsMs = {};
+    std::atomic<uint64_t> mPendingModes = 0;
+    std::atomic<uint64_t> mEnabledModes = 0;
+    std::atomic<uint64_t> mUnsupportedBoosts = 0;
+    std::atomic<uint64_t> mUnsupportedModes = 0;
+
+    std::atomic<uint64_t> mPendingSessionHints = 0;
+    // The target work duration to send, or 0 if there is none.
+    std::atomic<int64_t> mPendingTargetDurationNanos = 0;
+    // A single producer, single consumer ring of the actual work durations.
+    std::array<hardware::power::WorkDuration, WORK_DURATION_CAPACITY> mWorkDurations;
+    std::atomic<uint64_t> mWorkDurationsHead = 0;
+    std::atomic<uint64_t> mWorkDurationsTail = 0;
+    std::atomic_bool mHintSessionFailed = false;
+
+    std::mutex mHintSessionMutex;
+    sp<hardware::power::IPowerHintSession> mHintSession GUARDED_BY(mHintSessionMutex);
+    // Incremented whenever the session is set, to tell the sessions apart.
+    uint64_t mHintSessionGeneration GUARDED_BY(mHintSessionMutex) = 0;
+
+    // Posted when the first hint is recorded after the thread started delivering the hints.
+    sem_t mWakeup;
+    std::atomic_bool mWakeupPending = false;
+    std::atomic_bool mStopping = false;
+
+    std::mutex mFlushMutex;
+    std::condition_variable mFlushCondition;
+    std::atomic<uint64_t> mFlushRequested = 0;
+    uint64_t mFlushCompleted GUARDED_BY(mFlushMutex) = 0;
+
+    // The state of the hints which the thread last sent, only accessed by the thread.
+    uint64_t mSentModes = 0;
+    uint64_t mKnownModes = 0;
+    int64_t mSentTargetDurationNanos = 0;
+    uint64_t mSentTargetSessionGeneration = 0;
+    std::vector<hardware::power::WorkDuration> mWorkDurationBatch;
+
+    std::thread mThread;
+
+    void wake();
+    void threadMain();
+    void deliverHints();
+    void deliverSessionHints();
+};
+
+// -------------------------------------------------------------------------------------------------
+
+}; // namespace power
+
+}; // namespace android
+
+#endif // ANDROID_POWERHINTDISPATCHER_H
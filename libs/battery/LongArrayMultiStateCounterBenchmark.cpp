@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include "LongArrayMultiStateCounter.h"
+
+namespace android {
+namespace battery {
+
+// The number of process states of BatteryStats.
+constexpr uint16_t kStateCount = 5;
+
+// Updates a counter the way BatteryStats does with the CPU times of a uid, with the time since
+// each update spread over all the states, so that every update distributes the delta
+// proportionally. The argument is the number of CPU frequencies of the arrays.
+static void BM_UpdateValue(benchmark::State& state) {
+    const size_t size = state.range(0);
+    LongArrayMultiStateCounter counter(kStateCount, std::vector<uint64_t>(size));
+    std::vector<uint64_t> value(size);
+    time_t timestamp = 0;
+    counter.updateValue(value, timestamp);
+    counter.setState(0, timestamp);
+    for (auto _ : state) {
+        for (uint16_t s = 0; s < kStateCount; s++) {
+            counter.setState(s, timestamp += 7);
+        }
+        for (size_t i = 0; i < size; i++) {
+            value[i] += i * 13 + 1;
+        }
+        benchmark::DoNotOptimize(counter.updateValue(value, timestamp += 3));
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_UpdateValue)->Arg(16)->Arg(64)->Arg(256);
+
+// Adds the increments to the current state only, without a proportional split.
+static void BM_AddValue(benchmark::State& state) {
+    const size_t size = state.range(0);
+    LongArrayMultiStateCounter counter(kStateCount, std::vector<uint64_t>(size));
+    const std::vector<uint64_t> increment(size, 3);
+    counter.setState(0, 0);
+    for (auto _ : state) {
+        counter.addValue(increment);
+    }
+    benchmark::DoNotOptimize(counter.getCount(0).data());
+    state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_AddValue)->Arg(16)->Arg(64)->Arg(256);
+
+} // namespace battery
+} // namespace android
+
+BENCHMARK_MAIN();
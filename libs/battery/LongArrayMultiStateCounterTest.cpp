@@ -54,6 +54,36 @@ TEST_F(LongArrayMultiStateCounterTest, accumulation) {
     EXPECT_EQ(std::vector<uint64_t>({70, 120, 170, 220}), testCounter.getCount(1));
 }
 
+TEST_F(LongArrayMultiStateCounterTest, proportionalSplit) {
+    const std::vector<uint64_t> delta = {1, 999, 1000000007, 12345678901234, UINT64_MAX / 7000};
+    LongArrayMultiStateCounter testCounter(3, std::vector<uint64_t>(delta.size()));
+    testCounter.updateValue(std::vector<uint64_t>(delta.size()), 0);
+    testCounter.setState(0, 0);
+    testCounter.setState(1, 1000);
+    testCounter.setState(2, 3001);
+    testCounter.updateValue(delta, 7000);
+
+    const time_t timeInState[] = {1000, 2001, 3999};
+    for (state_t state = 0; state < 3; state++) {
+        std::vector<uint64_t> expected;
+        for (uint64_t n : delta) expected.push_back(n * timeInState[state] / 7000);
+        EXPECT_EQ(expected, testCounter.getCount(state)) << "state " << state;
+    }
+}
+
+TEST_F(LongArrayMultiStateCounterTest, decreasingValue) {
+    LongArrayMultiStateCounter testCounter(2, std::vector<uint64_t>(4));
+    testCounter.updateValue(std::vector<uint64_t>({0, 0, 0, 0}), 1000);
+    testCounter.setState(0, 1000);
+    testCounter.updateValue(std::vector<uint64_t>({100, 200, 300, 400}), 2000);
+    // One of the values went down, so the whole update is ignored.
+    testCounter.updateValue(std::vector<uint64_t>({200, 300, 250, 500}), 3000);
+    testCounter.updateValue(std::vector<uint64_t>({300, 400, 350, 600}), 4000);
+
+    EXPECT_EQ(std::vector<uint64_t>({200, 300, 400, 500}), testCounter.getCount(0));
+    EXPECT_EQ(std::vector<uint64_t>({0, 0, 0, 0}), testCounter.getCount(1));
+}
+
 TEST_F(LongArrayMultiStateCounterTest, toString) {
     LongArrayMultiStateCounter testCounter(2, std::vector<uint64_t>(4));
     testCounter.updateValue(std::vector<uint64_t>({0, 0, 0, 0}), 1000);
@@ -17,8 +17,10 @@
 #include <binder/Binder.h>
 
 #include <atomic>
+#include <chrono>
 #include <set>
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/unique_fd.h>
 #include <binder/BpBinder.h>
@@ -29,6 +31,7 @@
 #include <binder/Parcel.h>
 #include <binder/RecordedTransaction.h>
 #include <binder/RpcServer.h>
+#include <binder/TransactionStats.h>
 #include <cutils/compiler.h>
 #include <private/android_filesystem_config.h>
 #include <pthread.h>
@@ -365,6 +368,12 @@ status_t BBinder::transact(
         reply->markSensitive();
     }
 
+    using android::binder::debug::TransactionStats;
+    const bool recordStats = kEnableKernelIpc && code >= FIRST_CALL_TRANSACTION &&
+            code <= LAST_CALL_TRANSACTION && TransactionStats::isEnabled();
+    const auto start = recordStats ? std::chrono::steady_clock::now()
+                                   : std::chrono::steady_clock::time_point();
+
     status_t err = NO_ERROR;
     switch (code) {
         case PING_TRANSACTION:
@@ -388,11 +397,24 @@ status_t BBinder::transact(
             err = setRpcClientDebug(data);
             break;
         }
+        case STATS_TRANSACTION:
+            err = dumpTransactionStats(data);
+            break;
         default:
             err = onTransact(code, data, reply, flags);
             break;
     }
 
+    if (recordStats) {
+        // The interface token is found once onTransact enforced it, which spares the virtual
+        // getInterfaceDescriptor call.
+        size_t descriptorLength = 0;
+        const char16_t* descriptor = data.interfaceTokenInplace(&descriptorLength);
+        TransactionStats::record(TransactionStats::Side::SERVER,
+                                 descriptor != nullptr ? descriptor : u"", descriptorLength, code,
+                                 std::chrono::steady_clock::now() - start, data.dataSize());
+    }
+
     // In case this is being transacted on in the same process.
     if (reply != nullptr) {
         reply->setDataPosition(0);
@@ -653,6 +675,24 @@ status_t BBinder::setRpcClientDebug(const Parcel& data) {
     return setRpcClientDebug(std::move(clientFd), keepAliveBinder);
 }
 
+status_t BBinder::dumpTransactionStats(const Parcel& data) {
+    if (!kEnableKernelIpc) {
+        ALOGW("Binder transaction stats disallowed because kernel binder is not enabled");
+        return INVALID_OPERATION;
+    }
+    uid_t uid = IPCThreadState::self()->getCallingUid();
+    if (uid != AID_ROOT && uid != AID_SHELL && uid != AID_SYSTEM && uid != getuid()) {
+        ALOGE("Binder transaction stats not allowed because client %" PRIu32
+              " is not root, shell or system",
+              uid);
+        return PERMISSION_DENIED;
+    }
+    android::base::unique_fd fd;
+    if (status_t status = data.readUniqueFileDescriptor(&fd); status != OK) return status;
+    if (!android::base::WriteStringToFd(TransactionStats::toString(), fd)) return -errno;
+    return OK;
+}
+
 status_t BBinder::setRpcClientDebug(android::base::unique_fd socketFd,
                                     const sp<IBinder>& keepAliveBinder) {
     if (!kEnableRpcDevServers) {
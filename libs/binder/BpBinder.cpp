@@ -23,11 +23,14 @@
 #include <binder/IResultReceiver.h>
 #include <binder/RpcSession.h>
 #include <binder/Stability.h>
+#include <binder/TransactionStats.h>
 #include <cutils/compiler.h>
 #include <utils/Log.h>
 
 #include <stdio.h>
 
+#include <chrono>
+
 #include "BuildFlags.h"
 
 #include <android-base/file.h>
@@ -366,7 +369,25 @@ status_t BpBinder::transact(
                 return INVALID_OPERATION;
             }
 
+            using android::binder::debug::TransactionStats;
+            const bool recordStats = code >= FIRST_CALL_TRANSACTION &&
+                    code <= LAST_CALL_TRANSACTION && TransactionStats::isEnabled();
+            const auto start = recordStats ? std::chrono::steady_clock::now()
+                                           : std::chrono::steady_clock::time_point();
+
             status = IPCThreadState::self()->transact(binderHandle(), code, data, reply, flags);
+
+            if (recordStats) {
+                // The descriptor is usually not cached for proxies, so take the interface token
+                // of the data instead.
+                size_t descriptorLength = 0;
+                const char16_t* descriptor = data.interfaceTokenInplace(&descriptorLength);
+                TransactionStats::record(TransactionStats::Side::CLIENT,
+                                         descriptor != nullptr ? descriptor : u"",
+                                         descriptorLength, code,
+                                         std::chrono::steady_clock::now() - start,
+                                         data.dataSize());
+            }
         }
         if (data.dataSize() > LOG_TRANSACTIONS_OVER_SIZE) {
             Mutex::Autolock _l(mLock);
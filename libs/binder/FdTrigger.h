@@ -58,6 +58,14 @@ public:
     [[nodiscard]] status_t triggerablePoll(const android::RpcTransportFd& transportFd,
                                            int16_t event);
 
+#ifndef BINDER_RPC_SINGLE_THREADED
+    /**
+     * The read end of the pipe, which receives POLLHUP once this is triggered,
+     * for callers which wait for many FDs at once (e.g. with epoll).
+     */
+    [[nodiscard]] base::borrowed_fd readFd() const { return mRead; }
+#endif
+
 private:
 #ifdef BINDER_RPC_SINGLE_THREADED
     bool mTriggered = false;
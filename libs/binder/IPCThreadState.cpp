@@ -28,9 +28,11 @@
 #include <utils/Log.h>
 #include <utils/SystemClock.h>
 
+#include <algorithm>
 #include <atomic>
 #include <errno.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <pthread.h>
 #include <sched.h>
 #include <signal.h>
@@ -38,6 +40,8 @@
 #include <sys/ioctl.h>
 #include <sys/resource.h>
 #include <unistd.h>
+#include <utility>
+#include <vector>
 
 #include "binder_module.h"
 
@@ -109,7 +113,9 @@ static const char *kCommandStrings[] = {
     "BC_EXIT_LOOPER",
     "BC_REQUEST_DEATH_NOTIFICATION",
     "BC_CLEAR_DEATH_NOTIFICATION",
-    "BC_DEAD_BINDER_DONE"
+    "BC_DEAD_BINDER_DONE",
+    "BC_TRANSACTION_SG",
+    "BC_REPLY_SG",
 };
 
 static const int64_t kWorkSourcePropagatedBitIndex = 32;
@@ -150,6 +156,15 @@ static const void* printBinderTransactionDataSecCtx(std::ostream& out, const voi
     return btd+1;
 }
 
+static const void* printBinderTransactionDataSg(std::ostream& out, const void* data) {
+    const binder_transaction_data_sg* btd = (const binder_transaction_data_sg*)data;
+
+    printBinderTransactionData(out, &btd->transaction_data);
+
+    out << "\tbuffers=" << (void*)btd->buffers_size << " bytes";
+    return btd+1;
+}
+
 static const void* printReturnCommand(std::ostream& out, const void* _cmd) {
     static const size_t N = sizeof(kReturnStrings)/sizeof(kReturnStrings[0]);
     const int32_t* cmd = (const int32_t*)_cmd;
@@ -233,6 +248,12 @@ static const void* printCommand(std::ostream& out, const void* _cmd) {
             cmd = (const int32_t*)printBinderTransactionData(out, cmd);
         } break;
 
+        case BC_TRANSACTION_SG:
+        case BC_REPLY_SG: {
+            out << ": ";
+            cmd = (const int32_t*)printBinderTransactionDataSg(out, cmd);
+        } break;
+
         case BC_ACQUIRE_RESULT: {
             const int32_t res = *cmd++;
             out << ": " << res << (res ? " (SUCCESS)" : " (FAILURE)");
@@ -615,6 +636,8 @@ void IPCThreadState::blockUntilThreadAvailable()
     pthread_mutex_lock(&mProcess->mThreadCountLock);
     mProcess->mWaitingForThreads++;
     while (mProcess->mExecutingThreadsCount >= mProcess->mMaxThreads) {
+        mProcess->growThreadPoolLocked();
+        if (mProcess->mExecutingThreadsCount < mProcess->mMaxThreads) break;
         ALOGW("Waiting for thread to be free. mExecutingThreadsCount=%lu mMaxThreads=%lu\n",
                 static_cast<unsigned long>(mProcess->mExecutingThreadsCount),
                 static_cast<unsigned long>(mProcess->mMaxThreads));
@@ -643,9 +666,14 @@ status_t IPCThreadState::getAndExecuteCommand()
 
         pthread_mutex_lock(&mProcess->mThreadCountLock);
         mProcess->mExecutingThreadsCount++;
+        mProcess->mPeakExecutingThreads =
+                std::max(mProcess->mPeakExecutingThreads, mProcess->mExecutingThreadsCount);
         if (mProcess->mExecutingThreadsCount >= mProcess->mMaxThreads &&
                 mProcess->mStarvationStartTimeMs == 0) {
             mProcess->mStarvationStartTimeMs = uptimeMillis();
+            mProcess->mStarvationCount++;
+            // Let the driver start another thread for the commands queued behind this one.
+            mProcess->growThreadPoolLocked();
         }
         pthread_mutex_unlock(&mProcess->mThreadCountLock);
 
@@ -736,6 +764,10 @@ void IPCThreadState::joinThreadPool(bool isMain)
     status_t result;
     do {
         processPendingDerefs();
+        if (!isMain && leaveThreadPoolIfIdle()) {
+            result = TIMED_OUT;
+            break;
+        }
         // now get the next command to be processed, waiting if necessary
         result = getAndExecuteCommand();
 
@@ -766,6 +798,26 @@ void IPCThreadState::joinThreadPool(bool isMain)
     pthread_mutex_unlock(&mProcess->mThreadCountLock);
 }
 
+bool IPCThreadState::leaveThreadPoolIfIdle()
+{
+    // Commands that were already read are executed first.
+    if (mIn.dataPosition() < mIn.dataSize()) return false;
+    const int64_t timeoutMs = mProcess->getIdleTimeoutMs();
+    if (timeoutMs < 0) return false;
+
+    // Send the pending commands, e.g. BC_FREE_BUFFER, before waiting.
+    if (mOut.dataSize() > 0) talkWithDriver(false);
+
+    // Reading from the driver cannot time out, so wait for work with poll() instead. Once it
+    // signals, the driver may hand the work to another thread, in which case this thread blocks
+    // in the read until the next command.
+    pollfd pfd = {.fd = mProcess->mDriverFD, .events = POLLIN, .revents = 0};
+    const int ready = TEMP_FAILURE_RETRY(
+            poll(&pfd, 1, static_cast<int>(std::min<int64_t>(timeoutMs, INT32_MAX))));
+    if (ready != 0) return false;
+    return mProcess->leaveThreadPoolIfIdle();
+}
+
 status_t IPCThreadState::setupPolling(int* fd)
 {
     if (mProcess->mDriverFD < 0) {
@@ -824,6 +876,25 @@ status_t IPCThreadState::transact(int32_t handle,
 
     LOG_ONEWAY(">>>> SEND from pid %d uid %d %s", getpid(), getuid(),
         (flags & TF_ONE_WAY) == 0 ? "READ REPLY" : "ONE WAY");
+
+    if ((flags & TF_ONE_WAY) != 0 && mBatchDepth > 0 && mProcess->mDriverFD >= 0 &&
+        data.errorCheck() == NO_ERROR) {
+        // The caller may release the data before the batch is sent. Data that cannot be
+        // copied, e.g. with buffer objects, is sent right away instead.
+        Parcel& copy = mBatchedData.emplace_back();
+        if (copy.appendFrom(&data, 0, data.dataSize()) == NO_ERROR &&
+            writeTransactionData(BC_TRANSACTION, flags, handle, code, copy, nullptr) ==
+                    NO_ERROR) {
+            if (mBatchedData.size() >= kMaxBatchedTransactions) {
+                flushBatch();
+            }
+            return NO_ERROR;
+        }
+        mBatchedData.pop_back();
+    }
+    // Otherwise the responses of the deferred transactions would be taken for this one's.
+    flushBatch();
+
     err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, nullptr);
 
     if (err != NO_ERROR) {
@@ -979,7 +1050,9 @@ IPCThreadState::IPCThreadState()
         mIsFlushing(false),
         mStrictModePolicy(0),
         mLastTransactionBinderFlags(0),
-        mCallRestriction(mProcess->mCallRestriction) {
+        mCallRestriction(mProcess->mCallRestriction),
+        mBatchDepth(0),
+        mBatchError(NO_ERROR) {
     pthread_setspecific(gTLS, this);
     clearCaller();
     mHasExplicitIdentity = false;
@@ -991,10 +1064,49 @@ IPCThreadState::~IPCThreadState()
 {
 }
 
+IPCThreadState::BatchScope::BatchScope() : mState(IPCThreadState::self()) {
+    if (mState) {
+        mState->mBatchDepth++;
+    }
+}
+
+IPCThreadState::BatchScope::~BatchScope() {
+    if (mState && --mState->mBatchDepth == 0) {
+        flush();
+    }
+}
+
+status_t IPCThreadState::BatchScope::flush() {
+    if (!mState) {
+        return DEAD_OBJECT;
+    }
+    mState->flushBatch();
+    return std::exchange(mState->mBatchError, NO_ERROR);
+}
+
+void IPCThreadState::flushBatch()
+{
+    while (!mBatchedData.empty()) {
+        // The driver completes the transactions in the order they were written, each with a
+        // BR_TRANSACTION_COMPLETE or an error, so every response is for the oldest one.
+        const status_t err = waitForResponse(nullptr, nullptr);
+        if (err != NO_ERROR && mBatchError == NO_ERROR) {
+            mBatchError = err;
+        }
+        if (err != NO_ERROR && err != DEAD_OBJECT && err != FAILED_TRANSACTION) {
+            // The driver failed, and may not have consumed the transactions, so their data is
+            // kept as long as they are in mOut.
+            return;
+        }
+        mBatchedData.pop_front();
+    }
+}
+
 status_t IPCThreadState::sendReply(const Parcel& reply, uint32_t flags)
 {
     status_t err;
     status_t statusBuffer;
+    flushBatch();
     err = writeTransactionData(BC_REPLY, flags, -1, 0, reply, &statusBuffer);
     if (err < NO_ERROR) return err;
 
@@ -1192,13 +1304,20 @@ status_t IPCThreadState::talkWithDriver(bool doReceive)
 
     if (err >= NO_ERROR) {
         if (bwr.write_consumed > 0) {
-            if (bwr.write_consumed < mOut.dataSize())
-                LOG_ALWAYS_FATAL("Driver did not consume write buffer. "
-                                 "err: %s consumed: %zu of %zu",
-                                 statusToString(err).c_str(),
-                                 (size_t)bwr.write_consumed,
-                                 mOut.dataSize());
-            else {
+            if (bwr.write_consumed < mOut.dataSize()) {
+                // The driver stops writing at a transaction that fails until its error is
+                // read, which can only leave the later transactions of a batch.
+                LOG_ALWAYS_FATAL_IF(mBatchedData.empty(),
+                                    "Driver did not consume write buffer. "
+                                    "err: %s consumed: %zu of %zu",
+                                    statusToString(err).c_str(),
+                                    (size_t)bwr.write_consumed,
+                                    mOut.dataSize());
+                const std::vector<uint8_t> remaining(mOut.data() + bwr.write_consumed,
+                                                     mOut.data() + mOut.dataSize());
+                mOut.setDataSize(0);
+                mOut.write(remaining.data(), remaining.size());
+            } else {
                 mOut.setDataSize(0);
                 processPostWriteDerefs();
             }
@@ -1258,6 +1377,17 @@ status_t IPCThreadState::writeTransactionData(int32_t cmd, uint32_t binderFlags,
         return (mLastError = err);
     }
 
+    if (const size_t buffersSize = err == NO_ERROR ? data.ipcBuffersSize() : 0;
+        buffersSize > 0) {
+        // The driver copies the memory of the buffer objects after the data.
+        binder_transaction_data_sg sg;
+        sg.transaction_data = tr;
+        sg.buffers_size = buffersSize;
+        mOut.writeInt32(cmd == BC_REPLY ? BC_REPLY_SG : BC_TRANSACTION_SG);
+        mOut.write(&sg, sizeof(sg));
+        return NO_ERROR;
+    }
+
     mOut.writeInt32(cmd);
     mOut.write(&tr, sizeof(tr));
 
@@ -66,6 +66,86 @@ const String16& IServiceManager::getInterfaceDescriptor() const {
 IServiceManager::IServiceManager() {}
 IServiceManager::~IServiceManager() {}
 
+// The services that this process looked up, so that looking one up again while the process still
+// holds it does not call servicemanager. Only weak references are kept: a lazy service must be
+// able to exit once its clients dropped it, so a lookup only hits the cache while another strong
+// reference is alive in the process.
+//
+// A name is cached from its second lookup, when the cache registers for the notifications of the
+// name with servicemanager, which sends the new binder when the service is registered again. The
+// cached binder is also dropped when it dies. Services which are only looked up once don't pay
+// for the registration.
+class ServiceCache : public android::os::BnServiceCallback, public IBinder::DeathRecipient {
+public:
+    sp<IBinder> lookup(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mEntries.find(name);
+        if (it == mEntries.end() || !it->second.watched) return nullptr;
+        sp<IBinder> binder = it->second.binder.promote();
+        if (binder == nullptr || !binder->isBinderAlive()) return nullptr;
+        return binder;
+    }
+
+    // Called with every service that servicemanager returned.
+    void add(const sp<AidlServiceManager>& sm, const std::string& name,
+             const sp<IBinder>& binder) {
+        // The notifications can only be received by the threadpool.
+        if (!ProcessState::self()->isThreadPoolStarted()) return;
+
+        std::unique_lock<std::mutex> lock(mLock);
+        auto [it, inserted] = mEntries.try_emplace(name);
+        Entry& entry = it->second;
+        if (inserted || entry.registering) return;
+        if (!entry.watched) {
+            entry.registering = true;
+            lock.unlock();
+            const bool watched =
+                    sm->registerForNotifications(name, sp<ServiceCache>::fromExisting(this))
+                            .isOk();
+            lock.lock();
+            entry.registering = false;
+            entry.watched = watched;
+            if (!watched) return;
+        }
+        lock.unlock();
+
+        // Local binders can't die.
+        if (status_t status = binder->linkToDeath(sp<ServiceCache>::fromExisting(this));
+            status != OK && status != INVALID_OPERATION) {
+            return;
+        }
+        lock.lock();
+        entry.binder = binder;
+    }
+
+    Status onRegistration(const std::string& name, const sp<IBinder>& binder) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (auto it = mEntries.find(name);
+            it != mEntries.end() && it->second.binder.unsafe_get() != binder.get()) {
+            it->second.binder.clear();
+        }
+        return Status::ok();
+    }
+
+    void binderDied(const wp<IBinder>& who) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto& [name, entry] : mEntries) {
+            if (entry.binder == who) entry.binder.clear();
+        }
+    }
+
+private:
+    struct Entry {
+        wp<IBinder> binder;
+        // Whether servicemanager sends the registrations of the name to this cache.
+        bool watched = false;
+        bool registering = false;
+    };
+
+    std::mutex mLock;
+    std::map<std::string, Entry> mEntries;
+};
+
 // From the old libbinder IServiceManager interface to IServiceManager.
 class ServiceManagerShim : public IServiceManager
 {
@@ -113,6 +193,7 @@ public:
 
 protected:
     sp<AidlServiceManager> mTheRealServiceManager;
+    sp<ServiceCache> mServiceCache = sp<ServiceCache>::make();
     // AidlRegistrationCallback -> services that its been registered for
     // notifications.
     using LocalRegistrationAndWaiter =
@@ -317,10 +398,14 @@ sp<IBinder> ServiceManagerShim::getService(const String16& name) const
 
 sp<IBinder> ServiceManagerShim::checkService(const String16& name) const
 {
+    const std::string name8 = String8(name).c_str();
+    if (sp<IBinder> cached = mServiceCache->lookup(name8); cached != nullptr) return cached;
+
     sp<IBinder> ret;
-    if (!mTheRealServiceManager->checkService(String8(name).c_str(), &ret).isOk()) {
+    if (!mTheRealServiceManager->checkService(name8, &ret).isOk()) {
         return nullptr;
     }
+    if (ret != nullptr) mServiceCache->add(mTheRealServiceManager, name8, ret);
     return ret;
 }
 
@@ -376,6 +461,7 @@ sp<IBinder> ServiceManagerShim::waitForService(const String16& name16)
     };
 
     const std::string name = String8(name16).c_str();
+    if (sp<IBinder> cached = mServiceCache->lookup(name); cached != nullptr) return cached;
 
     sp<IBinder> out;
     if (Status status = realGetService(name, &out); !status.isOk()) {
@@ -390,7 +476,10 @@ sp<IBinder> ServiceManagerShim::waitForService(const String16& name16)
         }
         return nullptr;
     }
-    if (out != nullptr) return out;
+    if (out != nullptr) {
+        mServiceCache->add(mTheRealServiceManager, name, out);
+        return out;
+    }
 
     sp<Waiter> waiter = sp<Waiter>::make();
     if (Status status = mTheRealServiceManager->registerForNotifications(name, waiter);
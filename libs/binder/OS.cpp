@@ -18,8 +18,12 @@
 
 #include <android-base/file.h>
 #include <binder/RpcTransportRaw.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <log/log.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using android::base::ErrnoError;
 using android::base::Result;
@@ -29,6 +33,13 @@ namespace android {
 // Linux kernel supports up to 253 (from SCM_MAX_FD) for unix sockets.
 constexpr size_t kMaxFdsPerMsg = 253;
 
+// memfd_create is missing from older host C libraries.
+#if defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+#define BINDER_WITH_SEALED_MEMFD
+// The seals which the receiver of shared memory relies on.
+constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+#endif
+
 Result<void> setNonBlocking(android::base::borrowed_fd fd) {
     int flags = TEMP_FAILURE_RETRY(fcntl(fd.get(), F_GETFL));
     if (flags == -1) {
@@ -162,4 +173,69 @@ ssize_t receiveMessageFromSocket(
     return TEMP_FAILURE_RETRY(recvmsg(socket.fd.get(), &msg, MSG_NOSIGNAL));
 }
 
+status_t createSealedSharedMemory(const uint8_t* data, size_t size, base::unique_fd* outFd) {
+#ifdef BINDER_WITH_SEALED_MEMFD
+    base::unique_fd fd(memfd_create("binder rpc data", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!fd.ok()) {
+        return -errno;
+    }
+    if (!base::WriteFully(fd, data, size)) {
+        return -errno;
+    }
+    if (TEMP_FAILURE_RETRY(fcntl(fd.get(), F_ADD_SEALS,
+                                 kRequiredSeals | F_SEAL_GROW | F_SEAL_SEAL)) == -1) {
+        return -errno;
+    }
+    *outFd = std::move(fd);
+    return OK;
+#else
+    (void)data;
+    (void)size;
+    (void)outFd;
+    return INVALID_OPERATION;
+#endif
+}
+
+status_t mapSealedSharedMemory(base::borrowed_fd fd, size_t size, const uint8_t** outData) {
+#ifdef BINDER_WITH_SEALED_MEMFD
+    if (size == 0) {
+        return BAD_VALUE;
+    }
+    int seals = TEMP_FAILURE_RETRY(fcntl(fd.get(), F_GET_SEALS));
+    if (seals == -1) {
+        return -errno;
+    }
+    if ((seals & kRequiredSeals) != kRequiredSeals) {
+        ALOGE("Shared memory is not sealed against changes: %#x", seals);
+        return BAD_VALUE;
+    }
+    struct stat st;
+    if (TEMP_FAILURE_RETRY(fstat(fd.get(), &st)) == -1) {
+        return -errno;
+    }
+    if (st.st_size < 0 || static_cast<uint64_t>(st.st_size) < size) {
+        ALOGE("Shared memory of %" PRId64 " bytes is smaller than its data of %zu bytes",
+              static_cast<int64_t>(st.st_size), size);
+        return BAD_VALUE;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (addr == MAP_FAILED) {
+        return -errno;
+    }
+    *outData = static_cast<const uint8_t*>(addr);
+    return OK;
+#else
+    (void)fd;
+    (void)size;
+    (void)outData;
+    return INVALID_OPERATION;
+#endif
+}
+
+void unmapSharedMemory(const uint8_t* data, size_t size) {
+    if (munmap(const_cast<uint8_t*>(data), size) == -1) {
+        ALOGE("Failed to unmap shared memory: %s", strerror(errno));
+    }
+}
+
 } // namespace android
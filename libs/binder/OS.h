@@ -25,6 +25,8 @@
 
 namespace android {
 
+class RpcEventLoop;
+
 android::base::Result<void> setNonBlocking(android::base::borrowed_fd fd);
 
 status_t getRandomBytes(uint8_t* data, size_t size);
@@ -41,4 +43,16 @@ ssize_t receiveMessageFromSocket(
         const RpcTransportFd& socket, iovec* iovs, int niovs,
         std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* ancillaryFds);
 
+// Copies data into a new memfd, which is sealed so that its contents can't change anymore.
+status_t createSealedSharedMemory(const uint8_t* data, size_t size, base::unique_fd* outFd);
+
+// Maps the first size bytes of a memfd made by createSealedSharedMemory read-only. Fails if the
+// memfd is smaller, or if its contents could still change.
+status_t mapSealedSharedMemory(base::borrowed_fd fd, size_t size, const uint8_t** outData);
+
+void unmapSharedMemory(const uint8_t* data, size_t size);
+
+// Returns nullptr if the OS can't wait for many connections at once.
+std::unique_ptr<RpcEventLoop> makeRpcEventLoop(size_t threads);
+
 } // namespace android
@@ -115,7 +115,143 @@ enum {
     BLOB_ASHMEM_MUTABLE = 2,
 };
 
+// The data and objects buffers of up to 16KB that the Parcels of a thread free are kept for the
+// next Parcels of the same thread, so that a thread that handles many small transactions stops
+// going through malloc once its pool is warm. The buffers are bucketed by power-of-two size
+// class, and are allocated with the size of their class so that they can hold any size of it.
+//
+// The buffers are all allocated by malloc, so they can still be freed by free().
+struct ParcelBufferPool {
+    static constexpr size_t kMinClassShift = 5;
+    static constexpr size_t kMaxClassShift = 14;
+    static constexpr size_t kClassCount = kMaxClassShift - kMinClassShift + 1;
+    static constexpr size_t kMaxBuffersPerClass = 4;
+    static constexpr size_t kMaxBytes = 64 * 1024;
+
+    void* buffers[kClassCount][kMaxBuffersPerClass];
+    size_t counts[kClassCount];
+    size_t bytes;
+    // Set once the thread exits, after which buffers are no longer pooled.
+    bool destroyed;
+};
+
+#ifdef BINDER_WITH_KERNEL_IPC
+// Trivially destructible, so that it can still be read by the Parcels destroyed after the
+// destructor of gParcelBufferPoolReaper ran.
+static thread_local ParcelBufferPool gParcelBufferPool;
+
+struct ParcelBufferPoolReaper {
+    ~ParcelBufferPoolReaper() {
+        ParcelBufferPool& pool = gParcelBufferPool;
+        for (size_t i = 0; i < ParcelBufferPool::kClassCount; i++) {
+            for (size_t j = 0; j < pool.counts[i]; j++) {
+                free(pool.buffers[i][j]);
+            }
+            pool.counts[i] = 0;
+        }
+        pool.bytes = 0;
+        pool.destroyed = true;
+    }
+};
+
+static ParcelBufferPool* getParcelBufferPool() {
+    if (gParcelBufferPool.destroyed) {
+        return nullptr;
+    }
+    // Frees the buffers of the thread when it exits.
+    static thread_local ParcelBufferPoolReaper reaper;
+    (void)reaper;
+    return &gParcelBufferPool;
+}
+#endif // BINDER_WITH_KERNEL_IPC
+
+// Returns the shift of the size class of a buffer, or 0 if buffers of this size are not pooled.
+static size_t parcelBufferClassShift(size_t size) {
 #ifdef BINDER_WITH_KERNEL_IPC
+    if (size == 0 || size > (size_t{1} << ParcelBufferPool::kMaxClassShift)) {
+        return 0;
+    }
+    const size_t shift = size == 1 ? 0 : sizeof(unsigned long long) * 8 - __builtin_clzll(size - 1);
+    return std::max(shift, ParcelBufferPool::kMinClassShift);
+#else  // BINDER_WITH_KERNEL_IPC
+    (void)size;
+    return 0;
+#endif // BINDER_WITH_KERNEL_IPC
+}
+
+static void* allocateParcelBuffer(size_t size) {
+    const size_t shift = parcelBufferClassShift(size);
+    if (shift == 0) {
+        return malloc(size);
+    }
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (ParcelBufferPool* pool = getParcelBufferPool()) {
+        const size_t index = shift - ParcelBufferPool::kMinClassShift;
+        if (pool->counts[index] > 0) {
+            pool->bytes -= size_t{1} << shift;
+            return pool->buffers[index][--pool->counts[index]];
+        }
+    }
+#endif // BINDER_WITH_KERNEL_IPC
+    return malloc(size_t{1} << shift);
+}
+
+static void releaseParcelBuffer(void* data, size_t size) {
+    if (data == nullptr) {
+        return;
+    }
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (const size_t shift = parcelBufferClassShift(size); shift != 0) {
+        ParcelBufferPool* pool = getParcelBufferPool();
+        const size_t index = shift - ParcelBufferPool::kMinClassShift;
+        const size_t bytes = size_t{1} << shift;
+        if (pool && pool->counts[index] < ParcelBufferPool::kMaxBuffersPerClass &&
+            pool->bytes + bytes <= ParcelBufferPool::kMaxBytes) {
+            pool->buffers[index][pool->counts[index]++] = data;
+            pool->bytes += bytes;
+            return;
+        }
+    }
+#endif // BINDER_WITH_KERNEL_IPC
+    (void)size;
+    free(data);
+}
+
+// Like realloc, for the buffers of allocateParcelBuffer.
+static void* reallocateParcelBuffer(void* data, size_t oldSize, size_t newSize) {
+    if (data == nullptr) {
+        return allocateParcelBuffer(newSize);
+    }
+    const size_t oldShift = parcelBufferClassShift(oldSize);
+    const size_t newShift = parcelBufferClassShift(newSize);
+    if (oldShift == 0 && newShift == 0) {
+        return realloc(data, newSize);
+    }
+    if (oldShift == newShift) {
+        return data;
+    }
+    if (newSize == 0) {
+        releaseParcelBuffer(data, oldSize);
+        return nullptr;
+    }
+    void* newData = allocateParcelBuffer(newSize);
+    if (newData == nullptr) {
+        return nullptr;
+    }
+    memcpy(newData, data, std::min(oldSize, newSize));
+    releaseParcelBuffer(data, oldSize);
+    return newData;
+}
+
+#ifdef BINDER_WITH_KERNEL_IPC
+// Returns the size of the object at the given offset of the data. Buffer objects are larger than
+// the other objects, which are flat_binder_objects.
+static size_t object_size(const uint8_t* data, binder_size_t offset) {
+    const auto* hdr = reinterpret_cast<const binder_object_header*>(data + offset);
+    return hdr->type == BINDER_TYPE_PTR ? sizeof(binder_buffer_object)
+                                        : sizeof(flat_binder_object);
+}
+
 static void acquire_object(const sp<ProcessState>& proc, const flat_binder_object& obj,
                            const void* who) {
     switch (obj.hdr.type) {
@@ -133,7 +269,9 @@ static void acquire_object(const sp<ProcessState>& proc, const flat_binder_objec
             }
             return;
         }
-        case BINDER_TYPE_FD: {
+        case BINDER_TYPE_FD:
+        // The memory of buffer objects is not owned by the Parcel.
+        case BINDER_TYPE_PTR: {
             return;
         }
     }
@@ -164,6 +302,9 @@ static void release_object(const sp<ProcessState>& proc, const flat_binder_objec
             }
             return;
         }
+        case BINDER_TYPE_PTR: {
+            return;
+        }
     }
 
     ALOGE("Invalid object type 0x%08x", obj.hdr.type);
@@ -493,6 +634,22 @@ status_t Parcel::appendFrom(const Parcel* parcel, size_t offset, size_t len) {
         return BAD_VALUE;
     }
 
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (const auto* otherKernelFields = parcel->maybeKernelFields()) {
+        // Buffer objects point to memory owned by the caller or by the other Parcel, which may
+        // not outlive this one.
+        for (size_t i = 0; i < otherKernelFields->mObjectsSize; i++) {
+            const binder_size_t off = otherKernelFields->mObjects[i];
+            if (off >= offset && off < offset + len &&
+                reinterpret_cast<const binder_object_header*>(data + off)->type ==
+                        BINDER_TYPE_PTR) {
+                ALOGE("Cannot append buffer objects from another Parcel");
+                return BAD_TYPE;
+            }
+        }
+    }
+#endif // BINDER_WITH_KERNEL_IPC
+
     if ((mDataSize+len) > mDataCapacity) {
         // grow data
         err = growData(len);
@@ -519,7 +676,7 @@ status_t Parcel::appendFrom(const Parcel* parcel, size_t offset, size_t len) {
         int firstIndex = -1, lastIndex = -2;
         for (int i = 0; i < (int)size; i++) {
             size_t off = objects[i];
-            if ((off >= offset) && (off + sizeof(flat_binder_object) <= offset + len)) {
+            if ((off >= offset) && (off + object_size(data, off) <= offset + len)) {
                 if (firstIndex == -1) {
                     firstIndex = i;
                 }
@@ -537,8 +694,11 @@ status_t Parcel::appendFrom(const Parcel* parcel, size_t offset, size_t len) {
                     return NO_MEMORY; // overflow
                 size_t newSize = ((kernelFields->mObjectsSize + numObjects) * 3) / 2;
                 if (newSize > SIZE_MAX / sizeof(binder_size_t)) return NO_MEMORY; // overflow
-                binder_size_t* objects = (binder_size_t*)realloc(kernelFields->mObjects,
-                                                                 newSize * sizeof(binder_size_t));
+                binder_size_t* objects = (binder_size_t*)
+                        reallocateParcelBuffer(kernelFields->mObjects,
+                                               kernelFields->mObjectsCapacity *
+                                                       sizeof(binder_size_t),
+                                               newSize * sizeof(binder_size_t));
                 if (objects == (binder_size_t*)nullptr) {
                     return NO_MEMORY;
                 }
@@ -771,7 +931,9 @@ status_t Parcel::hasFileDescriptorsInRange(size_t offset, size_t len, bool* resu
         for (size_t i = 0; i < kernelFields->mObjectsSize; i++) {
             size_t pos = kernelFields->mObjects[i];
             if (pos < offset) continue;
-            if (pos + sizeof(flat_binder_object) > offset + len) {
+            // Sorted objects do not overlap, so none of the objects after one which ends past
+            // the range is in it.
+            if (pos + object_size(mData, pos) > offset + len) {
                 if (kernelFields->mObjectsSorted) {
                     break;
                 } else {
@@ -910,6 +1072,21 @@ uid_t Parcel::readCallingWorkSourceUid() const
     return uid;
 }
 
+const char16_t* Parcel::interfaceTokenInplace(size_t* outLen) const
+{
+    auto* kernelFields = maybeKernelFields();
+    if (kernelFields == nullptr || !kernelFields->mRequestHeaderPresent) {
+        return nullptr;
+    }
+
+    // The work source and the vendor header precede the token.
+    const size_t initialPosition = dataPosition();
+    setDataPosition(kernelFields->mWorkSourceRequestHeaderPosition + 2 * sizeof(int32_t));
+    const char16_t* token = readString16Inplace(outLen);
+    setDataPosition(initialPosition);
+    return token;
+}
+
 bool Parcel::checkInterface(IBinder* binder) const
 {
     return enforceInterface(binder->getInterfaceDescriptor());
@@ -1678,8 +1855,10 @@ restart_write:
         if ((kernelFields->mObjectsSize + 2) > SIZE_MAX / 3) return NO_MEMORY; // overflow
         size_t newSize = ((kernelFields->mObjectsSize + 2) * 3) / 2;
         if (newSize > SIZE_MAX / sizeof(binder_size_t)) return NO_MEMORY; // overflow
-        binder_size_t* objects =
-                (binder_size_t*)realloc(kernelFields->mObjects, newSize * sizeof(binder_size_t));
+        binder_size_t* objects = (binder_size_t*)
+                reallocateParcelBuffer(kernelFields->mObjects,
+                                       kernelFields->mObjectsCapacity * sizeof(binder_size_t),
+                                       newSize * sizeof(binder_size_t));
         if (objects == nullptr) return NO_MEMORY;
         kernelFields->mObjects = objects;
         kernelFields->mObjectsCapacity = newSize;
@@ -1694,6 +1873,55 @@ restart_write:
 #endif // BINDER_WITH_KERNEL_IPC
 }
 
+status_t Parcel::writeBufferObject(const void* data, size_t size)
+{
+    auto* kernelFields = maybeKernelFields();
+    if (kernelFields == nullptr) {
+        ALOGE("Buffer objects are not supported by RPC Parcels");
+        return INVALID_OPERATION;
+    }
+
+#ifdef BINDER_WITH_KERNEL_IPC
+    if ((data == nullptr && size > 0) || size > INT32_MAX) {
+        return BAD_VALUE;
+    }
+
+    if (mDataPos + sizeof(binder_buffer_object) > mDataCapacity) {
+        const status_t err = growData(sizeof(binder_buffer_object));
+        if (err != NO_ERROR) return err;
+    }
+    if (kernelFields->mObjectsSize >= kernelFields->mObjectsCapacity) {
+        if (kernelFields->mObjectsSize > SIZE_MAX - 2) return NO_MEMORY;       // overflow
+        if ((kernelFields->mObjectsSize + 2) > SIZE_MAX / 3) return NO_MEMORY; // overflow
+        size_t newSize = ((kernelFields->mObjectsSize + 2) * 3) / 2;
+        if (newSize > SIZE_MAX / sizeof(binder_size_t)) return NO_MEMORY; // overflow
+        binder_size_t* objects = (binder_size_t*)
+                reallocateParcelBuffer(kernelFields->mObjects,
+                                       kernelFields->mObjectsCapacity * sizeof(binder_size_t),
+                                       newSize * sizeof(binder_size_t));
+        if (objects == nullptr) return NO_MEMORY;
+        kernelFields->mObjects = objects;
+        kernelFields->mObjectsCapacity = newSize;
+    }
+
+    binder_buffer_object obj;
+    memset(&obj, 0, sizeof(obj));
+    obj.hdr.type = BINDER_TYPE_PTR;
+    obj.buffer = reinterpret_cast<binder_uintptr_t>(data);
+    obj.length = size;
+    *reinterpret_cast<binder_buffer_object*>(mData + mDataPos) = obj;
+
+    kernelFields->mObjects[kernelFields->mObjectsSize] = mDataPos;
+    kernelFields->mObjectsSize++;
+
+    return finishWrite(sizeof(binder_buffer_object));
+#else  // BINDER_WITH_KERNEL_IPC
+    (void)data;
+    (void)size;
+    return INVALID_OPERATION;
+#endif // BINDER_WITH_KERNEL_IPC
+}
+
 status_t Parcel::writeNoException()
 {
     binder::Status status;
@@ -1720,7 +1948,8 @@ status_t Parcel::validateReadData(size_t upperBound) const
             // hint. Iterate until we find the right object
             size_t nextObject = kernelFields->mNextObjectHint;
             do {
-                if (mDataPos < kernelFields->mObjects[nextObject] + sizeof(flat_binder_object)) {
+                if (mDataPos < kernelFields->mObjects[nextObject] +
+                                object_size(mData, kernelFields->mObjects[nextObject])) {
                     // Requested info overlaps with an object
                     ALOGE("Attempt to read from protected data in Parcel %p", this);
                     return PERMISSION_DENIED;
@@ -2458,51 +2687,90 @@ const flat_binder_object* Parcel::readObject(bool nullMetaData) const
         }
 
         // Ensure that this object is valid...
-        binder_size_t* const OBJS = kernelFields->mObjects;
-        const size_t N = kernelFields->mObjectsSize;
-        size_t opos = kernelFields->mNextObjectHint;
-
-        if (N > 0) {
-            ALOGV("Parcel %p looking for obj at %zu, hint=%zu",
-                 this, DPOS, opos);
-
-            // Start at the current hint position, looking for an object at
-            // the current data position.
-            if (opos < N) {
-                while (opos < (N-1) && OBJS[opos] < DPOS) {
-                    opos++;
-                }
-            } else {
-                opos = N-1;
-            }
-            if (OBJS[opos] == DPOS) {
-                // Found it!
-                ALOGV("Parcel %p found obj %zu at index %zu with forward search",
-                     this, DPOS, opos);
-                kernelFields->mNextObjectHint = opos + 1;
-                ALOGV("readObject Setting data pos of %p to %zu", this, mDataPos);
-                return obj;
-            }
-
-            // Look backwards for it...
-            while (opos > 0 && OBJS[opos] > DPOS) {
-                opos--;
-            }
-            if (OBJS[opos] == DPOS) {
-                // Found it!
-                ALOGV("Parcel %p found obj %zu at index %zu with backward search",
-                     this, DPOS, opos);
-                kernelFields->mNextObjectHint = opos + 1;
-                ALOGV("readObject Setting data pos of %p to %zu", this, mDataPos);
-                return obj;
-            }
+        if (hasObjectAt(DPOS)) {
+            ALOGV("readObject Setting data pos of %p to %zu", this, mDataPos);
+            return obj;
         }
         ALOGW("Attempt to read object from Parcel %p at offset %zu that is not in the object list",
              this, DPOS);
     }
     return nullptr;
 }
+
+bool Parcel::hasObjectAt(size_t offset) const
+{
+    const auto* kernelFields = maybeKernelFields();
+    binder_size_t* const OBJS = kernelFields->mObjects;
+    const size_t N = kernelFields->mObjectsSize;
+    size_t opos = kernelFields->mNextObjectHint;
+
+    if (N == 0) {
+        return false;
+    }
+
+    ALOGV("Parcel %p looking for obj at %zu, hint=%zu", this, offset, opos);
+
+    // Start at the current hint position, looking for an object at
+    // the given position.
+    if (opos < N) {
+        while (opos < (N-1) && OBJS[opos] < offset) {
+            opos++;
+        }
+    } else {
+        opos = N-1;
+    }
+    if (OBJS[opos] == offset) {
+        // Found it!
+        ALOGV("Parcel %p found obj %zu at index %zu with forward search", this, offset, opos);
+        kernelFields->mNextObjectHint = opos + 1;
+        return true;
+    }
+
+    // Look backwards for it...
+    while (opos > 0 && OBJS[opos] > offset) {
+        opos--;
+    }
+    if (OBJS[opos] == offset) {
+        // Found it!
+        ALOGV("Parcel %p found obj %zu at index %zu with backward search", this, offset, opos);
+        kernelFields->mNextObjectHint = opos + 1;
+        return true;
+    }
+    return false;
+}
+#endif // BINDER_WITH_KERNEL_IPC
+
+status_t Parcel::readBufferObject(const void** outData, size_t* outSize) const
+{
+    if (maybeKernelFields() == nullptr) {
+        ALOGE("Buffer objects are not supported by RPC Parcels");
+        return INVALID_OPERATION;
+    }
+
+#ifdef BINDER_WITH_KERNEL_IPC
+    const size_t DPOS = mDataPos;
+    if (DPOS + sizeof(binder_buffer_object) > mDataSize) {
+        return NOT_ENOUGH_DATA;
+    }
+    const auto* obj = reinterpret_cast<const binder_buffer_object*>(mData + DPOS);
+    if (!hasObjectAt(DPOS) || obj->hdr.type != BINDER_TYPE_PTR) {
+        ALOGW("Attempt to read buffer object from Parcel %p at offset %zu that is not one",
+              this, DPOS);
+        return BAD_TYPE;
+    }
+    mDataPos = DPOS + sizeof(binder_buffer_object);
+
+    // Received buffers were copied by the driver into the transaction buffer of this process,
+    // and the driver updated the object to point to the copy.
+    *outData = reinterpret_cast<const void*>(obj->buffer);
+    *outSize = static_cast<size_t>(obj->length);
+    return OK;
+#else  // BINDER_WITH_KERNEL_IPC
+    (void)outData;
+    (void)outSize;
+    return INVALID_OPERATION;
 #endif // BINDER_WITH_KERNEL_IPC
+}
 
 void Parcel::closeFileDescriptors() {
     if (auto* kernelFields = maybeKernelFields()) {
@@ -2554,6 +2822,24 @@ size_t Parcel::ipcObjectsCount() const
     return 0;
 }
 
+size_t Parcel::ipcBuffersSize() const
+{
+    size_t size = 0;
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (const auto* kernelFields = maybeKernelFields()) {
+        for (size_t i = 0; i < kernelFields->mObjectsSize; i++) {
+            const binder_size_t offset = kernelFields->mObjects[i];
+            const auto* obj = reinterpret_cast<const binder_buffer_object*>(mData + offset);
+            if (obj->hdr.type == BINDER_TYPE_PTR) {
+                // The driver aligns each buffer to 8 bytes.
+                size += (obj->length + 7) & ~static_cast<binder_size_t>(7);
+            }
+        }
+    }
+#endif // BINDER_WITH_KERNEL_IPC
+    return size;
+}
+
 void Parcel::ipcSetDataReference(const uint8_t* data, size_t dataSize, const binder_size_t* objects,
                                  size_t objectsCount, release_func relFunc) {
     // this code uses 'mOwner == nullptr' to understand whether it owns memory
@@ -2584,7 +2870,7 @@ void Parcel::ipcSetDataReference(const uint8_t* data, size_t dataSize, const bin
             = reinterpret_cast<const flat_binder_object*>(mData + offset);
         uint32_t type = flat->hdr.type;
         if (!(type == BINDER_TYPE_BINDER || type == BINDER_TYPE_HANDLE ||
-              type == BINDER_TYPE_FD)) {
+              type == BINDER_TYPE_FD || type == BINDER_TYPE_PTR)) {
             // We should never receive other types (eg BINDER_TYPE_FDA) as long as we don't support
             // them in libbinder. If we do receive them, it probably means a kernel bug; try to
             // recover gracefully by clearing out the objects.
@@ -2598,7 +2884,7 @@ void Parcel::ipcSetDataReference(const uint8_t* data, size_t dataSize, const bin
             kernelFields->mObjectsSize = 0;
             break;
         }
-        minOffset = offset + sizeof(flat_binder_object);
+        minOffset = offset + object_size(mData, offset);
     }
     scanForFds();
 #else  // BINDER_WITH_KERNEL_IPC
@@ -2755,10 +3041,13 @@ void Parcel::freeDataNoInit()
             if (mDeallocZero) {
                 zeroMemory(mData, mDataSize);
             }
-            free(mData);
+            releaseParcelBuffer(mData, mDataCapacity);
         }
         auto* kernelFields = maybeKernelFields();
-        if (kernelFields && kernelFields->mObjects) free(kernelFields->mObjects);
+        if (kernelFields && kernelFields->mObjects) {
+            releaseParcelBuffer(kernelFields->mObjects,
+                                kernelFields->mObjectsCapacity * sizeof(binder_size_t));
+        }
     }
 }
 
@@ -2780,16 +3069,18 @@ status_t Parcel::growData(size_t len)
 
 static uint8_t* reallocZeroFree(uint8_t* data, size_t oldCapacity, size_t newCapacity, bool zero) {
     if (!zero) {
-        return (uint8_t*)realloc(data, newCapacity);
+        return (uint8_t*)reallocateParcelBuffer(data, oldCapacity, newCapacity);
     }
-    uint8_t* newData = (uint8_t*)malloc(newCapacity);
+    uint8_t* newData = (uint8_t*)allocateParcelBuffer(newCapacity);
     if (!newData) {
         return nullptr;
     }
 
-    memcpy(newData, data, std::min(oldCapacity, newCapacity));
-    zeroMemory(data, oldCapacity);
-    free(data);
+    if (data) {
+        memcpy(newData, data, std::min(oldCapacity, newCapacity));
+        zeroMemory(data, oldCapacity);
+    }
+    releaseParcelBuffer(data, oldCapacity);
     return newData;
 }
 
@@ -2834,7 +3125,8 @@ status_t Parcel::restartWrite(size_t desired)
     ALOGV("restartWrite Setting data pos of %p to %zu", this, mDataPos);
 
     if (auto* kernelFields = maybeKernelFields()) {
-        free(kernelFields->mObjects);
+        releaseParcelBuffer(kernelFields->mObjects,
+                            kernelFields->mObjectsCapacity * sizeof(binder_size_t));
         kernelFields->mObjects = nullptr;
         kernelFields->mObjectsSize = kernelFields->mObjectsCapacity = 0;
         kernelFields->mNextObjectHint = 0;
@@ -2892,7 +3184,7 @@ status_t Parcel::continueWrite(size_t desired)
 
         // If there is a different owner, we need to take
         // posession.
-        uint8_t* data = (uint8_t*)malloc(desired);
+        uint8_t* data = (uint8_t*)allocateParcelBuffer(desired);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -2900,9 +3192,9 @@ status_t Parcel::continueWrite(size_t desired)
         binder_size_t* objects = nullptr;
 
         if (kernelFields && objectsSize) {
-            objects = (binder_size_t*)calloc(objectsSize, sizeof(binder_size_t));
+            objects = (binder_size_t*)allocateParcelBuffer(objectsSize * sizeof(binder_size_t));
             if (!objects) {
-                free(data);
+                releaseParcelBuffer(data, desired);
 
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -2917,7 +3209,7 @@ status_t Parcel::continueWrite(size_t desired)
         }
         if (rpcFields) {
             if (status_t status = truncateRpcObjects(objectsSize); status != OK) {
-                free(data);
+                releaseParcelBuffer(data, desired);
                 return status;
             }
         }
@@ -2969,13 +3261,16 @@ status_t Parcel::continueWrite(size_t desired)
             }
 
             if (objectsSize == 0) {
-                free(kernelFields->mObjects);
+                releaseParcelBuffer(kernelFields->mObjects,
+                                    kernelFields->mObjectsCapacity * sizeof(binder_size_t));
                 kernelFields->mObjects = nullptr;
                 kernelFields->mObjectsCapacity = 0;
             } else {
-                binder_size_t* objects =
-                        (binder_size_t*)realloc(kernelFields->mObjects,
-                                                objectsSize * sizeof(binder_size_t));
+                binder_size_t* objects = (binder_size_t*)
+                        reallocateParcelBuffer(kernelFields->mObjects,
+                                               kernelFields->mObjectsCapacity *
+                                                       sizeof(binder_size_t),
+                                               objectsSize * sizeof(binder_size_t));
                 if (objects) {
                     kernelFields->mObjects = objects;
                     kernelFields->mObjectsCapacity = objectsSize;
@@ -3021,7 +3316,7 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        uint8_t* data = (uint8_t*)allocateParcelBuffer(desired);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -36,6 +36,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -44,6 +45,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <mutex>
 
 #define BINDER_VM_SIZE ((1 * 1024 * 1024) - sysconf(_SC_PAGE_SIZE) * 2)
@@ -419,25 +421,120 @@ void ProcessState::spawnPooledThread(bool isMain)
 status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
     LOG_ALWAYS_FATAL_IF(mThreadPoolStarted && maxThreads < mMaxThreads,
            "Binder threadpool cannot be shrunk after starting");
-    status_t result = NO_ERROR;
-    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &maxThreads) != -1) {
+    pthread_mutex_lock(&mThreadCountLock);
+    base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
+
+    status_t result = setDriverMaxThreadsLocked(maxThreads);
+    if (result == NO_ERROR) {
         mMaxThreads = maxThreads;
-    } else {
-        result = -errno;
-        ALOGE("Binder ioctl to set max threads failed: %s", strerror(-result));
+        mAdaptiveThreadPool = false;
     }
     return result;
 }
 
+status_t ProcessState::setThreadPoolAdaptive(size_t minThreads, size_t maxThreads,
+                                             std::chrono::milliseconds idleTimeout) {
+    if (minThreads > maxThreads || idleTimeout.count() <= 0) {
+        ALOGE("Invalid adaptive thread pool: min %zu, max %zu, idle timeout %" PRId64 " ms",
+              minThreads, maxThreads, static_cast<int64_t>(idleTimeout.count()));
+        return BAD_VALUE;
+    }
+    LOG_ALWAYS_FATAL_IF(mThreadPoolStarted,
+                        "Binder threadpool cannot be made adaptive after starting");
+    pthread_mutex_lock(&mThreadCountLock);
+    base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
+
+    status_t result = setDriverMaxThreadsLocked(minThreads);
+    if (result == NO_ERROR) {
+        mMaxThreads = minThreads;
+        mAdaptiveThreadPool = true;
+        mMinThreads = minThreads;
+        mAdaptiveMaxThreads = maxThreads;
+        mIdleTimeoutMs = static_cast<int64_t>(idleTimeout.count());
+    }
+    return result;
+}
+
+status_t ProcessState::setDriverMaxThreadsLocked(size_t maxThreads) {
+    // The driver compares the limit with the number of threads it ever started, so the threads
+    // that left the pool are added to it.
+    size_t driverMaxThreads = maxThreads + mExitedThreads;
+    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &driverMaxThreads) == -1) {
+        const status_t result = -errno;
+        ALOGE("Binder ioctl to set max threads failed: %s", strerror(-result));
+        return result;
+    }
+    return NO_ERROR;
+}
+
+void ProcessState::growThreadPoolLocked() {
+    if (!mAdaptiveThreadPool || mMaxThreads >= mAdaptiveMaxThreads) {
+        return;
+    }
+    // Grow by half of the limit, so that a burst reaches the maximum in a few steps.
+    const size_t maxThreads =
+            std::min(mAdaptiveMaxThreads, mMaxThreads + std::max<size_t>(1, mMaxThreads / 2));
+    if (setDriverMaxThreadsLocked(maxThreads) == NO_ERROR) {
+        ALOGI("Binder thread pool busy, raising its limit from %zu to %zu threads", mMaxThreads,
+              maxThreads);
+        mMaxThreads = maxThreads;
+        mThreadPoolGrowCount++;
+    }
+}
+
+int64_t ProcessState::getIdleTimeoutMs() const {
+    pthread_mutex_lock(&mThreadCountLock);
+    base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
+    if (!mAdaptiveThreadPool || mKernelStartedThreads <= mMinThreads) {
+        return -1;
+    }
+    return mIdleTimeoutMs;
+}
+
+bool ProcessState::leaveThreadPoolIfIdle() {
+    pthread_mutex_lock(&mThreadCountLock);
+    base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
+    // Other idle threads may have left since the timeout started.
+    if (!mAdaptiveThreadPool || mKernelStartedThreads <= mMinThreads) {
+        return false;
+    }
+    mKernelStartedThreads--;
+    mExitedThreads++;
+    // The limit follows the threads down, so that the driver starts threads again on the next
+    // burst only once the remaining ones are busy.
+    const size_t maxThreads = std::max(mMinThreads, mKernelStartedThreads);
+    if (maxThreads < mMaxThreads) {
+        mMaxThreads = maxThreads;
+    }
+    // Still needed when the limit is unchanged, since the exited thread moved it.
+    setDriverMaxThreadsLocked(mMaxThreads);
+    return true;
+}
+
+ProcessState::ThreadPoolStats ProcessState::getThreadPoolStats() const {
+    pthread_mutex_lock(&mThreadCountLock);
+    base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
+    return ThreadPoolStats{
+            .maxThreads = mMaxThreads,
+            .currentThreads = mCurrentThreads,
+            .executingThreads = mExecutingThreadsCount,
+            .peakExecutingThreads = mPeakExecutingThreads,
+            .starvationCount = mStarvationCount,
+            .growCount = mThreadPoolGrowCount,
+            .idleExitCount = mExitedThreads,
+    };
+}
+
 size_t ProcessState::getThreadPoolMaxTotalThreadCount() const {
     pthread_mutex_lock(&mThreadCountLock);
     base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
 
     // may actually be one more than this, if join is called
     if (mThreadPoolStarted) {
+        const size_t maxThreads = mAdaptiveThreadPool ? mAdaptiveMaxThreads : mMaxThreads;
         return mCurrentThreads < mKernelStartedThreads
-                ? mMaxThreads
-                : mMaxThreads + mCurrentThreads - mKernelStartedThreads;
+                ? maxThreads
+                : maxThreads + mCurrentThreads - mKernelStartedThreads;
     }
     // must not be initialized or maybe has poll thread setup, we
     // currently don't track this in libbinder
@@ -538,6 +635,14 @@ ProcessState::ProcessState(const char* driver)
         mCurrentThreads(0),
         mKernelStartedThreads(0),
         mStarvationStartTimeMs(0),
+        mAdaptiveThreadPool(false),
+        mMinThreads(0),
+        mAdaptiveMaxThreads(0),
+        mIdleTimeoutMs(0),
+        mExitedThreads(0),
+        mPeakExecutingThreads(0),
+        mStarvationCount(0),
+        mThreadPoolGrowCount(0),
         mForked(false),
         mThreadPoolStarted(false),
         mThreadPoolSeq(1),
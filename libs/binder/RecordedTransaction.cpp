@@ -21,11 +21,15 @@
 #include <binder/RecordedTransaction.h>
 #include <sys/mman.h>
 #include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <utility>
 
 using android::Parcel;
 using android::base::borrowed_fd;
 using android::base::unique_fd;
 using android::binder::debug::RecordedTransaction;
+using android::binder::debug::RecordedTransactionFile;
 
 #define PADDING8(s) ((8 - (s) % 8) % 8)
 
@@ -105,6 +109,11 @@ static_assert(PADDING8(8) == 0);
 //
 // No effort is made to ensure the expected chunks are present. A single
 // End Chunk may therefore produce an empty, meaningless RecordedTransaction.
+//
+// A file of transactions may be read with RecordedTransactionFile, which maps
+// the file and walks the ChunkDescriptors once to index the transactions by
+// their Header and Interface Name Chunks. The other chunks, and the
+// checksums, are only read when a transaction is read from the index.
 
 RecordedTransaction::RecordedTransaction(RecordedTransaction&& t) noexcept {
     mData = t.mData;
@@ -255,50 +264,106 @@ std::optional<RecordedTransaction> RecordedTransaction::fromFile(const unique_fd
             return std::nullopt;
         }
 
-        switch (chunk.chunkType) {
-            case HEADER_CHUNK: {
-                if (chunk.dataSize != static_cast<uint32_t>(sizeof(TransactionHeader))) {
-                    LOG(ERROR) << "Header Chunk indicated size " << chunk.dataSize << "; Expected "
-                               << sizeof(TransactionHeader) << ".";
-                    return std::nullopt;
-                }
-                t.mData.mHeader = *reinterpret_cast<TransactionHeader*>(payloadMap);
-                break;
-            }
-            case INTERFACE_NAME_CHUNK: {
-                t.mData.mInterfaceName =
-                        std::string(reinterpret_cast<char*>(payloadMap), chunk.dataSize);
-                break;
-            }
-            case DATA_PARCEL_CHUNK: {
-                if (t.mSent.setData(reinterpret_cast<const unsigned char*>(payloadMap),
-                                    chunk.dataSize) != android::NO_ERROR) {
-                    LOG(ERROR) << "Failed to set sent parcel data.";
-                    return std::nullopt;
-                }
-                break;
-            }
-            case REPLY_PARCEL_CHUNK: {
-                if (t.mReply.setData(reinterpret_cast<const unsigned char*>(payloadMap),
-                                     chunk.dataSize) != android::NO_ERROR) {
-                    LOG(ERROR) << "Failed to set reply parcel data.";
-                    return std::nullopt;
-                }
-                break;
-            }
-            case END_CHUNK:
-                break;
-            default:
-                LOG(INFO) << "Unrecognized chunk.";
-                break;
+        if (!t.readChunk(chunk.chunkType, chunk.dataSize,
+                         reinterpret_cast<const uint8_t*>(payloadMap))) {
+            return std::nullopt;
+        }
+    } while (chunk.chunkType != END_CHUNK);
+
+    return std::optional<RecordedTransaction>(std::move(t));
+}
+
+// Returns the size of the chunk at offset in [data, data + size), or 0 if the chunk doesn't fit.
+static size_t chunkSizeAt(const uint8_t* data, size_t size, size_t offset,
+                          ChunkDescriptor* chunkOut) {
+    if (size - offset < sizeof(ChunkDescriptor)) {
+        return 0;
+    }
+    memcpy(chunkOut, data + offset, sizeof(ChunkDescriptor));
+    if (chunkOut->dataSize > kMaxChunkDataSize) {
+        return 0;
+    }
+    size_t chunkSize = sizeof(ChunkDescriptor) + chunkOut->dataSize +
+            PADDING8(chunkOut->dataSize) + sizeof(transaction_checksum_t);
+    if (chunkSize > size - offset) {
+        return 0;
+    }
+    return chunkSize;
+}
+
+std::optional<RecordedTransaction> RecordedTransaction::fromChunks(const uint8_t* data,
+                                                                   size_t size) {
+    RecordedTransaction t;
+    ChunkDescriptor chunk;
+    size_t offset = 0;
+    do {
+        size_t chunkSize = chunkSizeAt(data, size, offset, &chunk);
+        if (chunkSize == 0) {
+            LOG(ERROR) << "Invalid chunk at offset " << offset << " of transaction.";
+            return std::nullopt;
         }
+        const transaction_checksum_t* chunkMap =
+                reinterpret_cast<const transaction_checksum_t*>(data + offset);
+        transaction_checksum_t checksum = 0;
+        for (size_t checksumIndex = 0; checksumIndex < chunkSize / sizeof(transaction_checksum_t);
+             checksumIndex++) {
+            checksum ^= chunkMap[checksumIndex];
+        }
+        if (checksum != 0) {
+            LOG(ERROR) << "Checksum failed.";
+            return std::nullopt;
+        }
+        if (!t.readChunk(chunk.chunkType, chunk.dataSize,
+                         data + offset + sizeof(ChunkDescriptor))) {
+            return std::nullopt;
+        }
+        offset += chunkSize;
     } while (chunk.chunkType != END_CHUNK);
 
     return std::optional<RecordedTransaction>(std::move(t));
 }
 
-android::status_t RecordedTransaction::writeChunk(borrowed_fd fd, uint32_t chunkType,
-                                                  size_t byteCount, const uint8_t* data) const {
+bool RecordedTransaction::readChunk(uint32_t chunkType, uint32_t dataSize, const uint8_t* data) {
+    switch (chunkType) {
+        case HEADER_CHUNK: {
+            if (dataSize != static_cast<uint32_t>(sizeof(TransactionHeader))) {
+                LOG(ERROR) << "Header Chunk indicated size " << dataSize << "; Expected "
+                           << sizeof(TransactionHeader) << ".";
+                return false;
+            }
+            mData.mHeader = *reinterpret_cast<const TransactionHeader*>(data);
+            break;
+        }
+        case INTERFACE_NAME_CHUNK: {
+            mData.mInterfaceName = std::string(reinterpret_cast<const char*>(data), dataSize);
+            break;
+        }
+        case DATA_PARCEL_CHUNK: {
+            if (mSent.setData(data, dataSize) != android::NO_ERROR) {
+                LOG(ERROR) << "Failed to set sent parcel data.";
+                return false;
+            }
+            break;
+        }
+        case REPLY_PARCEL_CHUNK: {
+            if (mReply.setData(data, dataSize) != android::NO_ERROR) {
+                LOG(ERROR) << "Failed to set reply parcel data.";
+                return false;
+            }
+            break;
+        }
+        case END_CHUNK:
+            break;
+        default:
+            LOG(INFO) << "Unrecognized chunk.";
+            break;
+    }
+    return true;
+}
+
+android::status_t RecordedTransaction::writeChunk(std::vector<std::byte>* buffer,
+                                                  uint32_t chunkType, size_t byteCount,
+                                                  const uint8_t* data) const {
     if (byteCount > kMaxChunkDataSize) {
         LOG(ERROR) << "Chunk data exceeds maximum size";
         return BAD_VALUE;
@@ -310,57 +375,65 @@ android::status_t RecordedTransaction::writeChunk(borrowed_fd fd, uint32_t chunk
     const std::byte* dataBytes = reinterpret_cast<const std::byte*>(data);
 
     // Add Chunk to intermediate buffer, except checksum
-    std::vector<std::byte> buffer;
-    buffer.insert(buffer.end(), descriptorBytes, descriptorBytes + sizeof(ChunkDescriptor));
-    buffer.insert(buffer.end(), dataBytes, dataBytes + byteCount);
+    const size_t chunkStart = buffer->size();
+    buffer->insert(buffer->end(), descriptorBytes, descriptorBytes + sizeof(ChunkDescriptor));
+    buffer->insert(buffer->end(), dataBytes, dataBytes + byteCount);
     std::byte zero{0};
-    buffer.insert(buffer.end(), PADDING8(byteCount), zero);
+    buffer->insert(buffer->end(), PADDING8(byteCount), zero);
 
-    // Calculate checksum from buffer
-    transaction_checksum_t* checksumData = reinterpret_cast<transaction_checksum_t*>(buffer.data());
+    // Calculate checksum from buffer, where every chunk starts on an 8-byte boundary
+    const transaction_checksum_t* checksumData =
+            reinterpret_cast<const transaction_checksum_t*>(buffer->data() + chunkStart);
     transaction_checksum_t checksumValue = 0;
-    for (size_t idx = 0; idx < (buffer.size() / sizeof(transaction_checksum_t)); idx++) {
+    for (size_t idx = 0; idx < (buffer->size() - chunkStart) / sizeof(transaction_checksum_t);
+         idx++) {
         checksumValue ^= checksumData[idx];
     }
 
     // Write checksum to buffer
     std::byte* checksumBytes = reinterpret_cast<std::byte*>(&checksumValue);
-    buffer.insert(buffer.end(), checksumBytes, checksumBytes + sizeof(transaction_checksum_t));
-
-    // Write buffer to file
-    if (!android::base::WriteFully(fd, buffer.data(), buffer.size())) {
-        LOG(ERROR) << "Failed to write chunk fd " << fd.get();
-        return UNKNOWN_ERROR;
-    }
+    buffer->insert(buffer->end(), checksumBytes, checksumBytes + sizeof(transaction_checksum_t));
     return NO_ERROR;
 }
 
 android::status_t RecordedTransaction::dumpToFile(const unique_fd& fd) const {
+    // The chunks are written at once, so that the I/O costs a single write per transaction.
+    std::vector<std::byte> buffer;
+    buffer.reserve(5 * (sizeof(ChunkDescriptor) + sizeof(transaction_checksum_t)) +
+                   sizeof(TransactionHeader) + mData.mInterfaceName.size() +
+                   mSent.dataBufferSize() + mReply.dataBufferSize() + 3 * 7);
     if (NO_ERROR !=
-        writeChunk(fd, HEADER_CHUNK, sizeof(TransactionHeader),
+        writeChunk(&buffer, HEADER_CHUNK, sizeof(TransactionHeader),
                    reinterpret_cast<const uint8_t*>(&(mData.mHeader)))) {
         LOG(ERROR) << "Failed to write transactionHeader to fd " << fd.get();
         return UNKNOWN_ERROR;
     }
     if (NO_ERROR !=
-        writeChunk(fd, INTERFACE_NAME_CHUNK, mData.mInterfaceName.size() * sizeof(uint8_t),
+        writeChunk(&buffer, INTERFACE_NAME_CHUNK, mData.mInterfaceName.size() * sizeof(uint8_t),
                    reinterpret_cast<const uint8_t*>(mData.mInterfaceName.c_str()))) {
         LOG(INFO) << "Failed to write Interface Name Chunk to fd " << fd.get();
         return UNKNOWN_ERROR;
     }
 
-    if (NO_ERROR != writeChunk(fd, DATA_PARCEL_CHUNK, mSent.dataBufferSize(), mSent.data())) {
+    if (NO_ERROR != writeChunk(&buffer, DATA_PARCEL_CHUNK, mSent.dataBufferSize(), mSent.data())) {
         LOG(ERROR) << "Failed to write sent Parcel to fd " << fd.get();
         return UNKNOWN_ERROR;
     }
-    if (NO_ERROR != writeChunk(fd, REPLY_PARCEL_CHUNK, mReply.dataBufferSize(), mReply.data())) {
+    if (NO_ERROR !=
+        writeChunk(&buffer, REPLY_PARCEL_CHUNK, mReply.dataBufferSize(), mReply.data())) {
         LOG(ERROR) << "Failed to write reply Parcel to fd " << fd.get();
         return UNKNOWN_ERROR;
     }
-    if (NO_ERROR != writeChunk(fd, END_CHUNK, 0, NULL)) {
+    if (NO_ERROR != writeChunk(&buffer, END_CHUNK, 0, NULL)) {
         LOG(ERROR) << "Failed to write end chunk to fd " << fd.get();
         return UNKNOWN_ERROR;
     }
+
+    // Write buffer to file
+    if (!android::base::WriteFully(fd, buffer.data(), buffer.size())) {
+        LOG(ERROR) << "Failed to write chunks to fd " << fd.get();
+        return UNKNOWN_ERROR;
+    }
     return NO_ERROR;
 }
 
@@ -397,3 +470,115 @@ const Parcel& RecordedTransaction::getDataParcel() const {
 const Parcel& RecordedTransaction::getReplyParcel() const {
     return mReply;
 }
+
+std::optional<RecordedTransactionFile> RecordedTransactionFile::fromFile(const unique_fd& fd) {
+    struct stat fileStat;
+    if (fstat(fd.get(), &fileStat) != 0) {
+        LOG(ERROR) << "Unable to get file information";
+        return std::nullopt;
+    }
+    RecordedTransactionFile file;
+    if (fileStat.st_size == 0) {
+        return std::optional<RecordedTransactionFile>(std::move(file));
+    }
+
+    // The mapping is page-aligned, and so are the chunks, which are multiples of 8 bytes.
+    void* mappedMemory = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (mappedMemory == MAP_FAILED) {
+        LOG(ERROR) << "Memory mapping failed for fd " << fd.get() << ": " << errno << " "
+                   << strerror(errno);
+        return std::nullopt;
+    }
+    file.mData = reinterpret_cast<const uint8_t*>(mappedMemory);
+    file.mSize = static_cast<size_t>(fileStat.st_size);
+
+    // Only the descriptors, and the header and interface name chunks, are read.
+    size_t offset = 0;
+    while (offset < file.mSize) {
+        Entry entry;
+        entry.offset = offset;
+        ChunkDescriptor chunk;
+        do {
+            size_t chunkSize = chunkSizeAt(file.mData, file.mSize, offset, &chunk);
+            if (chunkSize == 0) {
+                LOG(WARNING) << "Ignoring incomplete transaction at offset " << entry.offset
+                             << " of fd " << fd.get();
+                return std::optional<RecordedTransactionFile>(std::move(file));
+            }
+            const uint8_t* payload = file.mData + offset + sizeof(ChunkDescriptor);
+            if (chunk.chunkType == HEADER_CHUNK &&
+                chunk.dataSize == sizeof(RecordedTransaction::TransactionHeader)) {
+                const auto* header =
+                        reinterpret_cast<const RecordedTransaction::TransactionHeader*>(payload);
+                entry.code = header->code;
+                entry.flags = header->flags;
+                entry.timestamp = {.tv_sec = static_cast<time_t>(header->timestampSeconds),
+                                   .tv_nsec = header->timestampNanoseconds};
+            } else if (chunk.chunkType == INTERFACE_NAME_CHUNK) {
+                entry.interfaceName.assign(reinterpret_cast<const char*>(payload),
+                                           chunk.dataSize);
+            }
+            offset += chunkSize;
+        } while (chunk.chunkType != END_CHUNK);
+        entry.size = offset - entry.offset;
+        file.mIndex.push_back(std::move(entry));
+    }
+
+    return std::optional<RecordedTransactionFile>(std::move(file));
+}
+
+RecordedTransactionFile::RecordedTransactionFile(RecordedTransactionFile&& other) noexcept
+      : mData(std::exchange(other.mData, nullptr)),
+        mSize(std::exchange(other.mSize, 0)),
+        mIndex(std::move(other.mIndex)) {}
+
+RecordedTransactionFile& RecordedTransactionFile::operator=(
+        RecordedTransactionFile&& other) noexcept {
+    std::swap(mData, other.mData);
+    std::swap(mSize, other.mSize);
+    std::swap(mIndex, other.mIndex);
+    return *this;
+}
+
+RecordedTransactionFile::~RecordedTransactionFile() {
+    if (mData != nullptr) {
+        munmap(const_cast<uint8_t*>(mData), mSize);
+    }
+}
+
+std::optional<RecordedTransaction> RecordedTransactionFile::getTransaction(size_t index) const {
+    if (index >= mIndex.size()) {
+        LOG(ERROR) << "Transaction " << index << " is out of the " << mIndex.size()
+                   << " recorded transactions.";
+        return std::nullopt;
+    }
+    const Entry& entry = mIndex[index];
+    return RecordedTransaction::fromChunks(mData + entry.offset, entry.size);
+}
+
+std::vector<size_t> RecordedTransactionFile::findTransactions(
+        const std::function<bool(const Entry&)>& filter) const {
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < mIndex.size(); i++) {
+        if (filter(mIndex[i])) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+std::vector<size_t> RecordedTransactionFile::findTransactions(
+        std::string_view interfaceName, std::optional<uint32_t> code) const {
+    return findTransactions([&](const Entry& entry) {
+        return entry.interfaceName == interfaceName && (!code || entry.code == *code);
+    });
+}
+
+size_t RecordedTransactionFile::seek(timespec timestamp) const {
+    // The transactions are recorded in order, but the clock may have been set back meanwhile.
+    auto it = std::find_if(mIndex.begin(), mIndex.end(), [&](const Entry& entry) {
+        return std::tie(entry.timestamp.tv_sec, entry.timestamp.tv_nsec) >=
+                std::tie(timestamp.tv_sec, timestamp.tv_nsec);
+    });
+    return static_cast<size_t>(it - mIndex.begin());
+}
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "RpcEventLoop"
+
+#include "RpcEventLoop.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include <android-base/unique_fd.h>
+#include <log/log.h>
+
+#include "BuildFlags.h"
+#include "FdTrigger.h"
+#include "OS.h"
+#include "RpcState.h"
+
+namespace android {
+
+using base::unique_fd;
+
+void RpcEventLoop::joinOnThisThread(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult) {
+    RpcSession::join(std::move(session), std::move(setupResult));
+}
+
+void RpcEventLoop::releaseThisThread(const sp<RpcSession>& session) {
+    RpcMutexLockGuard _l(session->mMutex);
+    auto it = session->mConnections.mThreads.find(rpc_this_thread::get_id());
+    LOG_ALWAYS_FATAL_IF(it == session->mConnections.mThreads.end());
+    it->second.detach();
+    session->mConnections.mThreads.erase(it);
+}
+
+status_t RpcEventLoop::executeAvailableCommands(const sp<RpcSession>& session,
+                                                const sp<RpcConnection>& connection) {
+    // nested calls find the connection of this thread by its id
+    {
+        RpcMutexLockGuard _l(session->mMutex);
+        connection->exclusiveTid = rpcGetThreadId();
+    }
+
+    status_t status;
+    while ((status = connection->rpcTransport->pollRead()) == OK) {
+        status = session->state()->getAndExecuteCommand(connection, session,
+                                                        RpcState::CommandType::ANY);
+        if (status != OK) break;
+    }
+
+    session->clearConnectionTid(connection);
+
+    if (status == WOULD_BLOCK) return OK;
+    LOG_RPC_DETAIL("Binder connection closing w/ status %s", statusToString(status).c_str());
+    return status;
+}
+
+void RpcEventLoop::endConnection(sp<RpcSession>&& session, const sp<RpcConnection>& connection) {
+    sp<RpcSession::EventListener> listener;
+    {
+        RpcMutexLockGuard _l(session->mMutex);
+        listener = session->mEventListener.promote();
+    }
+
+    // session shutdown progresses via callbacks here
+    LOG_ALWAYS_FATAL_IF(!session->removeIncomingConnection(connection),
+                        "bad state: connection object guaranteed to be in list");
+
+    session = nullptr;
+
+    if (listener != nullptr) {
+        listener->onSessionIncomingThreadEnded();
+    }
+}
+
+FdTrigger* RpcEventLoop::shutdownTrigger(const sp<RpcSession>& session) {
+    return session->mShutdownTrigger.get();
+}
+
+#ifndef BINDER_RPC_SINGLE_THREADED
+
+namespace {
+
+// Waits with epoll for the connections to become readable. Each connection is
+// registered with EPOLLONESHOT, so that only one thread is woken up for it, and
+// it is only registered again once that thread read all of the available
+// commands. The threads wait with a single event each, so that a thread which
+// is busy with a command does not hold back the events of other connections.
+class EpollRpcEventLoop : public RpcEventLoop {
+public:
+    static std::unique_ptr<EpollRpcEventLoop> make(size_t threads) {
+        unique_fd epoll(epoll_create1(EPOLL_CLOEXEC));
+        if (!epoll.ok()) {
+            ALOGE("Could not create epoll: %s", strerror(errno));
+            return nullptr;
+        }
+        unique_fd wake(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+        if (!wake.ok()) {
+            ALOGE("Could not create eventfd: %s", strerror(errno));
+            return nullptr;
+        }
+        // level-triggered, and never read, so that it wakes up all of the threads
+        epoll_event event{.events = EPOLLIN, .data = {.fd = wake.get()}};
+        if (epoll_ctl(epoll.get(), EPOLL_CTL_ADD, wake.get(), &event) != 0) {
+            ALOGE("Could not watch eventfd: %s", strerror(errno));
+            return nullptr;
+        }
+
+        auto loop = std::unique_ptr<EpollRpcEventLoop>(
+                new EpollRpcEventLoop(std::move(epoll), std::move(wake)));
+        for (size_t i = 0; i < threads; i++) {
+            loop->mThreads.emplace_back(&EpollRpcEventLoop::threadLoop, loop.get());
+        }
+        return loop;
+    }
+
+    ~EpollRpcEventLoop() override {
+        LOG_ALWAYS_FATAL_IF(!mThreads.empty(), "Must call shutdown() before destructor");
+    }
+
+    void join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult, int fd) override {
+        // a multiplexed connection is read by a single thread, which runs the commands on a pool
+        // of its own
+        if (setupResult.status != OK || setupResult.connection->multiplexed) {
+            joinOnThisThread(std::move(session), std::move(setupResult));
+            return;
+        }
+        sp<RpcConnection> connection = std::move(setupResult.connection);
+
+        // commands may already be buffered by the transport, where epoll can't see them
+        status_t status = executeAvailableCommands(session, connection);
+        releaseThisThread(session);
+
+        RpcMutexUniqueLock _l(mMutex);
+        FdTrigger* trigger = shutdownTrigger(session);
+        if (status != OK || mShutdown || trigger->isTriggered()) {
+            _l.unlock();
+            endConnection(std::move(session), connection);
+            return;
+        }
+
+        const int triggerFd = trigger->readFd().get();
+        Watch& sessionWatch = mWatches[triggerFd];
+        if (sessionWatch.session == nullptr) {
+            sessionWatch.session = session;
+            // the trigger only needs to be handled once, after which it stays triggered
+            epoll_event event{.events = EPOLLIN | EPOLLONESHOT, .data = {.fd = triggerFd}};
+            LOG_ALWAYS_FATAL_IF(epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, triggerFd, &event) != 0,
+                                "Could not watch session trigger: %s", strerror(errno));
+        }
+        sessionWatch.connections++;
+
+        Watch& watch = mWatches[fd];
+        LOG_ALWAYS_FATAL_IF(watch.session != nullptr, "Connection fd %d is already watched", fd);
+        watch.session = std::move(session);
+        watch.connection = std::move(connection);
+        epoll_event event{.events = kConnectionEvents, .data = {.fd = fd}};
+        LOG_ALWAYS_FATAL_IF(epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, fd, &event) != 0,
+                            "Could not watch connection: %s", strerror(errno));
+    }
+
+    void shutdown() override {
+        {
+            RpcMutexLockGuard _l(mMutex);
+            if (mShutdown) return;
+            mShutdown = true;
+        }
+
+        uint64_t value = 1;
+        ssize_t written = TEMP_FAILURE_RETRY(write(mWake.get(), &value, sizeof(value)));
+        LOG_ALWAYS_FATAL_IF(written != static_cast<ssize_t>(sizeof(value)),
+                            "Could not wake event loop: %s", strerror(errno));
+        for (auto& thread : mThreads) {
+            thread.join();
+        }
+        mThreads.clear();
+
+        // the threads closed the connections which were busy
+        std::vector<std::pair<sp<RpcSession>, sp<RpcConnection>>> idle;
+        {
+            RpcMutexLockGuard _l(mMutex);
+            for (auto& [fd, watch] : mWatches) {
+                (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, fd, nullptr);
+                if (watch.connection != nullptr) {
+                    idle.emplace_back(std::move(watch.session), std::move(watch.connection));
+                }
+            }
+            mWatches.clear();
+        }
+        for (auto& [session, connection] : idle) {
+            endConnection(std::move(session), connection);
+        }
+    }
+
+private:
+    static constexpr uint32_t kConnectionEvents = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+
+    // A connection, or the shutdown trigger of a session, by fd.
+    struct Watch {
+        sp<RpcSession> session;
+        // nullptr for a session trigger
+        sp<RpcConnection> connection;
+        // whether a thread is executing the commands of the connection
+        bool busy = false;
+        // for a session trigger, the number of connections of the session
+        size_t connections = 0;
+    };
+
+    EpollRpcEventLoop(unique_fd epoll, unique_fd wake)
+          : mEpoll(std::move(epoll)), mWake(std::move(wake)) {}
+
+    void threadLoop() {
+        while (true) {
+            epoll_event event;
+            int ret = TEMP_FAILURE_RETRY(epoll_wait(mEpoll.get(), &event, 1, -1));
+            LOG_ALWAYS_FATAL_IF(ret < 0, "epoll_wait failed: %s", strerror(errno));
+            if (ret == 0) continue;
+            if (event.data.fd == mWake.get()) return;
+            handleEvent(event.data.fd);
+        }
+    }
+
+    void handleEvent(int fd) {
+        RpcMutexUniqueLock _l(mMutex);
+        auto it = mWatches.find(fd);
+        // the event was already handled (or the fd closed and reused) before this thread took the
+        // lock
+        if (it == mWatches.end() || it->second.busy) return;
+
+        if (it->second.connection == nullptr) {
+            // the session shut down, so close its idle connections, and let the busy ones close
+            // once their commands return
+            sp<RpcSession> session = it->second.session;
+            std::vector<sp<RpcConnection>> idle;
+            for (auto watchIt = mWatches.begin(); watchIt != mWatches.end();) {
+                Watch& watch = watchIt->second;
+                if (watch.session != session || watch.connection == nullptr || watch.busy) {
+                    watchIt++;
+                    continue;
+                }
+                (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, watchIt->first, nullptr);
+                idle.push_back(std::move(watch.connection));
+                watchIt = mWatches.erase(watchIt);
+            }
+            releaseSessionWatch(session, idle.size());
+            _l.unlock();
+
+            for (const auto& connection : idle) {
+                endConnection(sp<RpcSession>(session), connection);
+            }
+            return;
+        }
+
+        Watch& watch = it->second;
+        watch.busy = true;
+        sp<RpcSession> session = watch.session;
+        sp<RpcConnection> connection = watch.connection;
+        _l.unlock();
+
+        status_t status = executeAvailableCommands(session, connection);
+
+        _l.lock();
+        // busy connections are only removed by the thread which executes them
+        it = mWatches.find(fd);
+        LOG_ALWAYS_FATAL_IF(it == mWatches.end(), "Busy connection fd %d is not watched", fd);
+        if (status == OK && !mShutdown && !shutdownTrigger(session)->isTriggered()) {
+            it->second.busy = false;
+            epoll_event event{.events = kConnectionEvents, .data = {.fd = fd}};
+            LOG_ALWAYS_FATAL_IF(epoll_ctl(mEpoll.get(), EPOLL_CTL_MOD, fd, &event) != 0,
+                                "Could not watch connection: %s", strerror(errno));
+            return;
+        }
+        (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, fd, nullptr);
+        mWatches.erase(it);
+        releaseSessionWatch(session, 1);
+        _l.unlock();
+
+        endConnection(std::move(session), connection);
+    }
+
+    // Stops watching the trigger of a session once none of its connections are watched.
+    void releaseSessionWatch(const sp<RpcSession>& session, size_t connections) {
+        const int triggerFd = shutdownTrigger(session)->readFd().get();
+        auto it = mWatches.find(triggerFd);
+        LOG_ALWAYS_FATAL_IF(it == mWatches.end() || it->second.connections < connections,
+                            "Bad session trigger state for fd %d", triggerFd);
+        it->second.connections -= connections;
+        if (it->second.connections == 0) {
+            (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, triggerFd, nullptr);
+            mWatches.erase(it);
+        }
+    }
+
+    const unique_fd mEpoll;
+    const unique_fd mWake;
+    std::vector<RpcMaybeThread> mThreads;
+
+    RpcMutex mMutex; // for below
+    bool mShutdown = false;
+    std::map<int, Watch> mWatches;
+};
+
+} // namespace
+
+std::unique_ptr<RpcEventLoop> makeRpcEventLoop(size_t threads) {
+    return EpollRpcEventLoop::make(threads);
+}
+
+#else // BINDER_RPC_SINGLE_THREADED
+
+std::unique_ptr<RpcEventLoop> makeRpcEventLoop(size_t /* threads */) {
+    return nullptr;
+}
+
+#endif // BINDER_RPC_SINGLE_THREADED
+
+} // namespace android
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+
+#include <binder/RpcSession.h>
+
+namespace android {
+
+class FdTrigger;
+
+/**
+ * Serves the incoming connections of the sessions of an RpcServer on a fixed
+ * set of threads, instead of a thread blocked on each connection. The threads
+ * wait together for any idle connection to become readable, and the thread
+ * which is woken up executes the commands of that connection until it is idle
+ * again. See RpcServer::setEventLoopThreads.
+ *
+ * Only the methods below are used by RpcServer, so that the OS may not have an
+ * implementation (see makeRpcEventLoop in OS.h).
+ */
+class RpcEventLoop {
+public:
+    virtual ~RpcEventLoop() = default;
+
+    /**
+     * Takes over a connection which RpcServer set up, in place of
+     * RpcSession::join. The calling thread no longer belongs to the session
+     * when this returns, and it may exit. 'fd' is the socket of the connection,
+     * which is owned by its transport.
+     */
+    virtual void join(sp<RpcSession>&& session, RpcSession::PreJoinSetupResult&& setupResult,
+                      int fd) = 0;
+
+    /**
+     * Closes the connections which are idle, waits for the others to finish
+     * their commands, and stops the threads. Connections which are joined later
+     * are closed right away.
+     */
+    virtual void shutdown() = 0;
+
+protected:
+    using RpcConnection = RpcSession::RpcConnection;
+    using PreJoinSetupResult = RpcSession::PreJoinSetupResult;
+
+    // Serves the connection on the calling thread instead, see RpcSession::join.
+    static void joinOnThisThread(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult);
+
+    // The parts of RpcSession::join which the implementations run on their
+    // own threads.
+
+    // Gives up the ownership of the calling thread, which RpcServer passed to
+    // RpcSession::preJoinThreadOwnership.
+    static void releaseThisThread(const sp<RpcSession>& session);
+    // Executes the commands of a connection on the calling thread, until no
+    // more data is available. Returns an error once the connection can't be
+    // used anymore.
+    static status_t executeAvailableCommands(const sp<RpcSession>& session,
+                                             const sp<RpcConnection>& connection);
+    // Removes a connection which failed or whose session shut down.
+    static void endConnection(sp<RpcSession>&& session, const sp<RpcConnection>& connection);
+    static FdTrigger* shutdownTrigger(const sp<RpcSession>& session);
+};
+
+} // namespace android
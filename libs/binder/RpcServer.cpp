@@ -35,6 +35,7 @@
 #include "BuildFlags.h"
 #include "FdTrigger.h"
 #include "OS.h"
+#include "RpcEventLoop.h"
 #include "RpcSocketAddress.h"
 #include "RpcState.h"
 #include "RpcTransportUtils.h"
@@ -135,6 +136,16 @@ void RpcServer::setSupportedFileDescriptorTransportModes(
     }
 }
 
+void RpcServer::setSharedMemoryDataThreshold(size_t bytes) {
+    mSharedMemoryDataThreshold = bytes;
+}
+
+void RpcServer::setEventLoopThreads(size_t threads) {
+    LOG_ALWAYS_FATAL_IF(!kEnableRpcThreads, "Event loops require threads");
+    LOG_ALWAYS_FATAL_IF(mJoinThreadRunning, "Cannot set event loop threads while running");
+    mEventLoopThreads = threads;
+}
+
 void RpcServer::setRootObject(const sp<IBinder>& binder) {
     RpcMutexLockGuard _l(mLock);
     mRootObjectFactory = nullptr;
@@ -238,6 +249,10 @@ void RpcServer::join() {
         mJoinThreadRunning = true;
         mShutdownTrigger = FdTrigger::make();
         LOG_ALWAYS_FATAL_IF(mShutdownTrigger == nullptr, "Cannot create join signaler");
+        if (mEventLoopThreads > 0) {
+            mEventLoop = makeRpcEventLoop(mEventLoopThreads);
+            LOG_ALWAYS_FATAL_IF(mEventLoop == nullptr, "Cannot create event loop");
+        }
     }
 
     status_t status;
@@ -269,10 +284,19 @@ void RpcServer::join() {
 
         {
             RpcMutexLockGuard _l(mLock);
+            std::function<void(sp<RpcSession>&&, RpcSession::PreJoinSetupResult&&)> joinFn =
+                    RpcSession::join;
+            if (mEventLoop != nullptr) {
+                joinFn = [eventLoop = mEventLoop, fd = clientSocket.fd.get()](
+                                 sp<RpcSession>&& session,
+                                 RpcSession::PreJoinSetupResult&& setupResult) {
+                    eventLoop->join(std::move(session), std::move(setupResult), fd);
+                };
+            }
             RpcMaybeThread thread =
                     RpcMaybeThread(&RpcServer::establishConnection,
                                    sp<RpcServer>::fromExisting(this), std::move(clientSocket), addr,
-                                   addrLen, RpcSession::join);
+                                   addrLen, std::move(joinFn));
 
             auto& threadRef = mConnectingThreads[thread.get_id()];
             threadRef = std::move(thread);
@@ -335,6 +359,12 @@ bool RpcServer::shutdown() {
         mJoinThread.reset();
     }
 
+    // The connections of the event loop ended with the sessions, so this only stops its threads.
+    if (mEventLoop != nullptr) {
+        mEventLoop->shutdown();
+        mEventLoop = nullptr;
+    }
+
     LOG_RPC_DETAIL("Finished waiting on shutdown.");
 
     mShutdownTrigger = nullptr;
@@ -411,6 +441,7 @@ void RpcServer::establishConnection(
     }
 
     bool incoming = false;
+    bool multiplexed = false;
     uint32_t protocolVersion = 0;
     bool requestingNewSession = false;
 
@@ -419,10 +450,15 @@ void RpcServer::establishConnection(
         protocolVersion = std::min(header.version,
                                    server->mProtocolVersion.value_or(RPC_WIRE_PROTOCOL_VERSION));
         requestingNewSession = sessionId.empty();
+        // the client finds out whether this is supported from the version in the response
+        multiplexed = kEnableRpcThreads && !incoming && requestingNewSession &&
+                (header.options & RPC_CONNECTION_OPTION_MULTIPLEXED) &&
+                protocolVersion >= RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_MULTIPLEXED;
 
         if (requestingNewSession) {
             RpcNewSessionResponse response{
                     .version = protocolVersion,
+                    .options = multiplexed ? RPC_CONNECTION_OPTION_MULTIPLEXED : uint8_t{0},
             };
 
             iovec iov{&response, sizeof(response)};
@@ -483,6 +519,7 @@ void RpcServer::establishConnection(
 
             session = sp<RpcSession>::make(nullptr);
             session->setMaxIncomingThreads(server->mMaxThreads);
+            session->setSharedMemoryDataThreshold(server->mSharedMemoryDataThreshold);
             if (!session->setProtocolVersion(protocolVersion)) return;
 
             if (header.fileDescriptorTransportMode <
@@ -537,7 +574,7 @@ void RpcServer::establishConnection(
         session->preJoinThreadOwnership(std::move(thisThread));
     }
 
-    auto setupResult = session->preJoinSetup(std::move(client));
+    auto setupResult = session->preJoinSetup(std::move(client), multiplexed);
 
     // avoid strong cycle
     server = nullptr;
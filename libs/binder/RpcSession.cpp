@@ -24,7 +24,10 @@
 #include <poll.h>
 #include <unistd.h>
 
+#include <deque>
+#include <functional>
 #include <string_view>
+#include <vector>
 
 #include <android-base/hex.h>
 #include <android-base/macros.h>
@@ -145,6 +148,30 @@ RpcSession::FileDescriptorTransportMode RpcSession::getFileDescriptorTransportMo
     return mFileDescriptorTransportMode;
 }
 
+void RpcSession::setSharedMemoryDataThreshold(size_t bytes) {
+    RpcMutexLockGuard _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mStartedSetup,
+                        "Must set shared memory data threshold before setting up connections");
+    mSharedMemoryDataThreshold = bytes;
+}
+
+size_t RpcSession::getSharedMemoryDataThreshold() {
+    return mSharedMemoryDataThreshold;
+}
+
+void RpcSession::setMultiplexed(bool multiplexed) {
+    RpcMutexLockGuard _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mStartedSetup, "Must set multiplexed before setting up connections");
+    LOG_ALWAYS_FATAL_IF(multiplexed && !kEnableRpcThreads,
+                        "Multiplexed connections are not supported on single-threaded libbinder");
+    mMultiplexed = multiplexed;
+}
+
+bool RpcSession::isMultiplexed() {
+    RpcMutexLockGuard _l(mMutex);
+    return mMultiplexed;
+}
+
 status_t RpcSession::setupUnixDomainClient(const char* path) {
     return setupSocketClient(UnixSocketAddress(path));
 }
@@ -329,14 +356,24 @@ void RpcSession::WaitForShutdownListener::onSessionIncomingThreadEnded() {
     mCv.notify_all();
 }
 
+void RpcSession::WaitForShutdownListener::onMultiplexedReceiverStarted() {
+    mMultiplexedReceiving = true;
+}
+
+void RpcSession::WaitForShutdownListener::onMultiplexedReceiverEnded() {
+    mMultiplexedReceiving = false;
+    mCv.notify_all();
+}
+
 void RpcSession::WaitForShutdownListener::waitForShutdown(RpcMutexUniqueLock& lock,
                                                           const sp<RpcSession>& session) {
-    while (mShutdownCount < session->mConnections.mMaxIncoming) {
+    while (mShutdownCount < session->mConnections.mMaxIncoming || mMultiplexedReceiving) {
         if (std::cv_status::timeout == mCv.wait_for(lock, std::chrono::seconds(1))) {
             ALOGE("Waiting for RpcSession to shut down (1s w/o progress): %zu incoming connections "
-                  "still %zu/%zu fully shutdown.",
+                  "still %zu/%zu fully shutdown%s.",
                   session->mConnections.mIncoming.size(), mShutdownCount.load(),
-                  session->mConnections.mMaxIncoming);
+                  session->mConnections.mMaxIncoming,
+                  mMultiplexedReceiving ? ", multiplexed receiver still running" : "");
         }
     }
 }
@@ -351,10 +388,11 @@ void RpcSession::preJoinThreadOwnership(RpcMaybeThread thread) {
 }
 
 RpcSession::PreJoinSetupResult RpcSession::preJoinSetup(
-        std::unique_ptr<RpcTransport> rpcTransport) {
+        std::unique_ptr<RpcTransport> rpcTransport, bool multiplexed) {
     // must be registered to allow arbitrary client code executing commands to
     // be able to do nested calls (we can't only read from it)
-    sp<RpcConnection> connection = assignIncomingConnectionToThisThread(std::move(rpcTransport));
+    sp<RpcConnection> connection =
+            assignIncomingConnectionToThisThread(std::move(rpcTransport), multiplexed);
 
     status_t status;
 
@@ -437,13 +475,18 @@ void RpcSession::join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult
     if (setupResult.status == OK) {
         LOG_ALWAYS_FATAL_IF(!connection, "must have connection if setup succeeded");
         [[maybe_unused]] JavaThreadAttacher javaThreadAttacher;
-        while (true) {
-            status_t status = session->state()->getAndExecuteCommand(connection, session,
-                                                                     RpcState::CommandType::ANY);
-            if (status != OK) {
-                LOG_RPC_DETAIL("Binder connection thread closing w/ status %s",
-                               statusToString(status).c_str());
-                break;
+        if (connection->multiplexed) {
+            joinMultiplexed(session, connection);
+        } else {
+            while (true) {
+                status_t status =
+                        session->state()->getAndExecuteCommand(connection, session,
+                                                               RpcState::CommandType::ANY);
+                if (status != OK) {
+                    LOG_RPC_DETAIL("Binder connection thread closing w/ status %s",
+                                   statusToString(status).c_str());
+                    break;
+                }
             }
         }
     } else {
@@ -475,6 +518,91 @@ void RpcSession::join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult
     }
 }
 
+void RpcSession::joinMultiplexed(const sp<RpcSession>& session,
+                                 const sp<RpcConnection>& connection) {
+    // The synchronous transactions which were read but did not start yet, and the threads which
+    // run them, up to the maximum number of threads of the server.
+    RpcMutex mutex;
+    RpcConditionVariable cv;
+    std::deque<std::function<void()>> pending;
+    std::vector<RpcMaybeThread> threads;
+    size_t idleThreads = 0;
+    bool done = false;
+
+    const size_t maxThreads = std::max<size_t>(1, session->getMaxIncomingThreads());
+    const auto dispatch = [&](std::function<void()>&& transaction) {
+        RpcMutexLockGuard _l(mutex);
+        pending.push_back(std::move(transaction));
+        if (idleThreads >= pending.size() || threads.size() >= maxThreads) {
+            cv.notify_one();
+            return;
+        }
+        threads.emplace_back([&] {
+            [[maybe_unused]] JavaThreadAttacher javaThreadAttacher;
+            while (true) {
+                std::function<void()> next;
+                {
+                    RpcMutexUniqueLock lock(mutex);
+                    idleThreads++;
+                    cv.wait(lock, [&] { return done || !pending.empty(); });
+                    idleThreads--;
+                    // the session is shut down, so the replies could not be sent anyway
+                    if (done) return;
+
+                    next = std::move(pending.front());
+                    pending.pop_front();
+                }
+                next();
+            }
+        });
+    };
+
+    while (true) {
+        status_t status =
+                session->state()->getAndExecuteMultiplexedCommand(connection, session, dispatch);
+        if (status != OK) {
+            LOG_RPC_DETAIL("Multiplexed binder connection thread closing w/ status %s",
+                           statusToString(status).c_str());
+            break;
+        }
+    }
+
+    {
+        RpcMutexLockGuard _l(mutex);
+        done = true;
+    }
+    cv.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void RpcSession::startMultiplexedReceiver(const sp<RpcConnection>& connection) {
+    sp<WaitForShutdownListener> listener = mShutdownListener;
+    LOG_ALWAYS_FATAL_IF(listener == nullptr, "Shutdown listener not installed");
+    listener->onMultiplexedReceiverStarted();
+
+    RpcMaybeThread([session = sp<RpcSession>::fromExisting(this), connection,
+                    listener]() mutable {
+        while (true) {
+            status_t status = session->state()->getAndExecuteMultiplexedReply(connection, session);
+            if (status != OK) {
+                LOG_RPC_DETAIL("Multiplexed binder receiver closing w/ status %s",
+                               statusToString(status).c_str());
+                break;
+            }
+        }
+        // the connection is unusable from here
+        (void)session->shutdownAndWait(false);
+        session->state()->abortMultiplexedTransactions();
+
+        // done after all cleanup, since shutdownAndWait(true) may then return
+        connection = nullptr;
+        session = nullptr;
+        listener->onMultiplexedReceiverEnded();
+    }).detach();
+}
+
 sp<RpcServer> RpcSession::server() {
     RpcServer* unsafeServer = mForServer.unsafe_get();
     sp<RpcServer> server = mForServer.promote();
@@ -503,6 +631,7 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
     if (auto status = initShutdownTrigger(); status != OK) return status;
 
     auto oldProtocolVersion = mProtocolVersion;
+    auto oldMultiplexed = mMultiplexed;
     auto cleanup = base::ScopeGuard([&] {
         // if any threads are started, shut them down
         (void)shutdownAndWait(true);
@@ -519,6 +648,7 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
         // to connect to another server, force that server to request a
         // downgrade again
         mProtocolVersion = oldProtocolVersion;
+        mMultiplexed = oldMultiplexed;
 
         mConnections = {};
 
@@ -536,12 +666,31 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
             return status;
 
         uint32_t version;
+        bool multiplexed;
         if (status_t status =
                     state()->readNewSessionResponse(connection.get(),
-                                                    sp<RpcSession>::fromExisting(this), &version);
+                                                    sp<RpcSession>::fromExisting(this), &version,
+                                                    &multiplexed);
             status != OK)
             return status;
         if (!setProtocolVersionInternal(version, false)) return BAD_VALUE;
+
+        // the server only multiplexes the connection if it supports it too
+        if (mMultiplexed) {
+            if (multiplexed) {
+                {
+                    RpcMutexLockGuard _l(mMutex);
+                    connection.get()->multiplexed = true;
+                }
+                startMultiplexedReceiver(connection.get());
+            } else {
+                ALOGI("Server does not support multiplexed connections (protocol version %u), "
+                      "using one connection per outgoing thread.",
+                      version);
+                RpcMutexLockGuard _l(mMutex);
+                mMultiplexed = false;
+            }
+        }
     }
 
     // TODO(b/189955605): we should add additional sessions dynamically
@@ -571,6 +720,9 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
     // requested to be set) in order to allow the other side to reliably make
     // any requests at all.
 
+    // all outgoing calls share the multiplexed connection
+    if (mMultiplexed) outgoingConnections = 1;
+
     // we've already setup one client
     LOG_RPC_DETAIL("RpcSession::setupClient() instantiating %zu outgoing connections (server max: "
                    "%zu) and %zu incoming threads",
@@ -695,6 +847,11 @@ status_t RpcSession::initAndAddConnection(RpcTransportFd fd, const std::vector<u
     if (incoming) {
         header.options |= RPC_CONNECTION_OPTION_INCOMING;
     }
+    // the connection which requests the session becomes the multiplexed one, if the server
+    // supports it
+    if (mMultiplexed && !incoming && sessionId.empty()) {
+        header.options |= RPC_CONNECTION_OPTION_MULTIPLEXED;
+    }
 
     iovec headerIov{&header, sizeof(header)};
     auto sendHeaderStatus = server->interruptableWriteFully(mShutdownTrigger.get(), &headerIov, 1,
@@ -743,7 +900,7 @@ status_t RpcSession::addIncomingConnection(std::unique_ptr<RpcTransport> rpcTran
         session->preJoinThreadOwnership(std::move(thread));
 
         // only continue once we have a response or the connection fails
-        auto setupResult = session->preJoinSetup(std::move(movedRpcTransport));
+        auto setupResult = session->preJoinSetup(std::move(movedRpcTransport), false);
 
         ownershipTransferred = true;
         threadLock.unlock();
@@ -810,7 +967,7 @@ bool RpcSession::setForServer(const wp<RpcServer>& server, const wp<EventListene
 }
 
 sp<RpcSession::RpcConnection> RpcSession::assignIncomingConnectionToThisThread(
-        std::unique_ptr<RpcTransport> rpcTransport) {
+        std::unique_ptr<RpcTransport> rpcTransport, bool multiplexed) {
     RpcMutexLockGuard _l(mMutex);
 
     if (mConnections.mIncoming.size() >= mMaxIncomingThreads) {
@@ -830,6 +987,7 @@ sp<RpcSession::RpcConnection> RpcSession::assignIncomingConnectionToThisThread(
     sp<RpcConnection> session = sp<RpcConnection>::make();
     session->rpcTransport = std::move(rpcTransport);
     session->exclusiveTid = rpcGetThreadId();
+    session->multiplexed = multiplexed;
 
     mConnections.mIncoming.push_back(session);
     mConnections.mMaxIncoming = mConnections.mIncoming.size();
@@ -926,6 +1084,25 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
             }
         }
 
+        // A multiplexed connection is shared by all the threads, so it is used without taking it,
+        // for all but nested calls. The server side only sends ref counts on it, which its
+        // other threads may send too.
+        if (exclusive == nullptr) {
+            sp<RpcConnection> multiplexed;
+            if (available != nullptr && available->multiplexed) {
+                multiplexed = available;
+            } else if (use == ConnectionUse::CLIENT_REFCOUNT && available == nullptr) {
+                for (const auto& incoming : session->mConnections.mIncoming) {
+                    if (incoming->multiplexed) multiplexed = incoming;
+                }
+            }
+            if (multiplexed != nullptr) {
+                connection->mConnection = multiplexed;
+                connection->mReentrant = true;
+                break;
+            }
+        }
+
         // if our thread is already using a connection, prioritize using that
         if (exclusive != nullptr) {
             connection->mConnection = exclusive;
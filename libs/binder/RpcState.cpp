@@ -27,9 +27,11 @@
 #include <binder/RpcServer.h>
 
 #include "Debug.h"
+#include "OS.h"
 #include "RpcWireFormat.h"
 #include "Utils.h"
 
+#include <memory>
 #include <random>
 
 #include <inttypes.h>
@@ -350,6 +352,100 @@ RpcState::CommandData::CommandData(size_t size) : mSize(size) {
     mData.reset(new (std::nothrow) uint8_t[size]);
 }
 
+void RpcState::CommandData::setSharedData(const uint8_t* data, size_t size) {
+    mSharedData = std::unique_ptr<const uint8_t, SharedDataUnmapper>(data,
+                                                                     SharedDataUnmapper{size});
+}
+
+void RpcState::CommandData::SharedDataUnmapper::operator()(const uint8_t* data) const {
+    unmapSharedMemory(data, size);
+}
+
+bool RpcState::writeSharedMemoryData(
+        const sp<RpcSession>& session, const Parcel& parcel, base::unique_fd* outMemfd,
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* outFds) {
+    using FdMode = RpcSession::FileDescriptorTransportMode;
+    const size_t threshold = session->getSharedMemoryDataThreshold();
+    if (threshold == 0 || parcel.dataSize() < threshold ||
+        session->getFileDescriptorTransportMode() != FdMode::UNIX ||
+        session->getProtocolVersion().value() <
+                RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_SHARED_MEMORY_DATA) {
+        return false;
+    }
+
+    auto* rpcFields = parcel.maybeRpcFields();
+    LOG_ALWAYS_FATAL_IF(rpcFields == nullptr);
+    const size_t parcelFds = rpcFields->mFds != nullptr ? rpcFields->mFds->size() : 0;
+    // the memfd has to fit next to the file descriptors of the Parcel, see validateParcel
+    constexpr size_t kMaxFdsPerMsg = 253;
+    if (parcelFds >= kMaxFdsPerMsg) return false;
+
+    if (status_t status = createSealedSharedMemory(parcel.data(), parcel.dataSize(), outMemfd);
+        status != OK) {
+        // the data can still be sent over the connection
+        ALOGW("Failed to create shared memory for %zu bytes of Parcel data: %s",
+              parcel.dataSize(), statusToString(status).c_str());
+        return false;
+    }
+
+    outFds->clear();
+    outFds->reserve(parcelFds + 1);
+    for (size_t i = 0; i < parcelFds; i++) {
+        outFds->emplace_back(base::borrowed_fd(
+                std::visit([](const auto& fd) { return fd.get(); }, rpcFields->mFds->at(i))));
+    }
+    outFds->emplace_back(base::borrowed_fd(*outMemfd));
+    return true;
+}
+
+status_t RpcState::readSharedMemoryData(
+        const sp<RpcSession>& session, size_t size,
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* ancillaryFds,
+        const uint8_t** outData) {
+    if (session->getProtocolVersion().value() <
+                RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_SHARED_MEMORY_DATA ||
+        ancillaryFds->empty()) {
+        ALOGE("Command has its Parcel data in shared memory, but no memfd. Terminating!");
+        return BAD_VALUE;
+    }
+    auto* memfd = std::get_if<base::unique_fd>(&ancillaryFds->back());
+    if (memfd == nullptr) {
+        ALOGE("Shared memory of the Parcel data is not owned. Terminating!");
+        return BAD_VALUE;
+    }
+    base::unique_fd fd = std::move(*memfd);
+    ancillaryFds->pop_back();
+
+    if (status_t status = mapSealedSharedMemory(fd, size, outData); status != OK) {
+        ALOGE("Failed to map %zu bytes of Parcel data from shared memory: %s. Terminating!", size,
+              statusToString(status).c_str());
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
+status_t RpcState::readTransactionSharedMemoryData(
+        const sp<RpcSession>& session, const RpcWireHeader& command, CommandData* transactionData,
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* ancillaryFds) {
+    if (!(command.options & RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA)) return OK;
+
+    if (transactionData->size() < sizeof(RpcWireTransaction)) {
+        ALOGE("Expecting %zu but got %zu bytes for RpcWireTransaction. Terminating!",
+              sizeof(RpcWireTransaction), transactionData->size());
+        return BAD_VALUE;
+    }
+    const auto* transaction = reinterpret_cast<RpcWireTransaction*>(transactionData->data());
+
+    const uint8_t* sharedData;
+    if (status_t status = readSharedMemoryData(session, transaction->parcelDataSize,
+                                               ancillaryFds, &sharedData);
+        status != OK) {
+        return status;
+    }
+    transactionData->setSharedData(sharedData, transaction->parcelDataSize);
+    return OK;
+}
+
 status_t RpcState::rpcSend(
         const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
         const char* what, iovec* iovs, int niovs,
@@ -361,10 +457,17 @@ status_t RpcState::rpcSend(
                        android::base::HexString(iovs[i].iov_base, iovs[i].iov_len).c_str());
     }
 
-    if (status_t status =
-                connection->rpcTransport->interruptableWriteFully(session->mShutdownTrigger.get(),
-                                                                  iovs, niovs, altPoll,
-                                                                  ancillaryFds);
+    // Other threads write to a multiplexed connection too. Only its receiving thread reads it,
+    // and it never stops reading, so commands sent by the other side can't fill it up.
+    std::optional<RpcMutexLockGuard> writeLock;
+    if (connection->multiplexed) writeLock.emplace(connection->writeMutex);
+
+    if (status_t status = connection->rpcTransport
+                                  ->interruptableWriteFully(session->mShutdownTrigger.get(), iovs,
+                                                            niovs,
+                                                            connection->multiplexed ? std::nullopt
+                                                                                    : altPoll,
+                                                            ancillaryFds);
         status != OK) {
         LOG_RPC_DETAIL("Failed to write %s (%d iovs) on RpcTransport %p, error: %s", what, niovs,
                        connection->rpcTransport.get(), statusToString(status).c_str());
@@ -399,7 +502,8 @@ status_t RpcState::rpcRec(
 }
 
 status_t RpcState::readNewSessionResponse(const sp<RpcSession::RpcConnection>& connection,
-                                          const sp<RpcSession>& session, uint32_t* version) {
+                                          const sp<RpcSession>& session, uint32_t* version,
+                                          bool* multiplexed) {
     RpcNewSessionResponse response;
     iovec iov{&response, sizeof(response)};
     if (status_t status = rpcRec(connection, session, "new session response", &iov, 1, nullptr);
@@ -407,6 +511,8 @@ status_t RpcState::readNewSessionResponse(const sp<RpcSession::RpcConnection>& c
         return status;
     }
     *version = response.version;
+    *multiplexed = response.version >= RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_MULTIPLEXED &&
+            (response.options & RPC_CONNECTION_OPTION_MULTIPLEXED);
     return OK;
 }
 
@@ -539,15 +645,49 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     Span<const uint32_t> objectTableSpan = Span<const uint32_t>{rpcFields->mObjectPositions.data(),
                                                                 rpcFields->mObjectPositions.size()};
 
+    base::unique_fd sharedDataFd;
+    std::vector<std::variant<base::unique_fd, base::borrowed_fd>> sharedDataFds;
+    const bool sharedData = writeSharedMemoryData(session, data, &sharedDataFd, &sharedDataFds);
+    const size_t inlineDataSize = sharedData ? 0 : data.dataSize();
+
     uint32_t bodySize;
-    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(sizeof(RpcWireTransaction), data.dataSize(),
+    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(sizeof(RpcWireTransaction), inlineDataSize,
                                                &bodySize) ||
                                 __builtin_add_overflow(objectTableSpan.byteSize(), bodySize,
-                                                       &bodySize),
+                                                       &bodySize) ||
+                                static_cast<uint32_t>(data.dataSize()) != data.dataSize(),
                         "Too much data %zu", data.dataSize());
     RpcWireHeader command{
             .command = RPC_COMMAND_TRANSACT,
             .bodySize = bodySize,
+            .options = sharedData ? RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA : 0,
+    };
+
+    // On a multiplexed connection, the receiving thread passes the reply to this thread.
+    MultiplexedWaiter waiter{.reply = reply};
+    const bool waitForMultiplexedReply =
+            connection->multiplexed && !(flags & IBinder::FLAG_ONEWAY);
+    if (waitForMultiplexedReply) {
+        LOG_ALWAYS_FATAL_IF(reply == nullptr,
+                            "Reply parcel must be used for synchronous transaction.");
+        RpcMutexLockGuard _l(mMultiplexedMutex);
+        if (mMultiplexedAborted) return DEAD_OBJECT;
+        do {
+            mNextTransactionId++;
+        } while (mNextTransactionId == 0 ||
+                 mMultiplexedWaiters.find(mNextTransactionId) != mMultiplexedWaiters.end());
+        command.transactionId = mNextTransactionId;
+        mMultiplexedWaiters[command.transactionId] = &waiter;
+    }
+    base::ScopeGuard removeWaiter = [&]() {
+        if (!waitForMultiplexedReply) return;
+        // the receiving thread removes the waiter when it passes the reply, after which the ID
+        // may be reused
+        RpcMutexLockGuard _l(mMultiplexedMutex);
+        auto it = mMultiplexedWaiters.find(command.transactionId);
+        if (it != mMultiplexedWaiters.end() && it->second == &waiter) {
+            mMultiplexedWaiters.erase(it);
+        }
     };
 
     RpcWireTransaction transaction{
@@ -555,7 +695,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
             .code = code,
             .flags = flags,
             .asyncNumber = asyncNumber,
-            // bodySize didn't overflow => this cast is safe
+            // checked above => this cast is safe
             .parcelDataSize = static_cast<uint32_t>(data.dataSize()),
     };
 
@@ -569,7 +709,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     iovec iovs[]{
             {&command, sizeof(RpcWireHeader)},
             {&transaction, sizeof(RpcWireTransaction)},
-            {const_cast<uint8_t*>(data.data()), data.dataSize()},
+            {const_cast<uint8_t*>(data.data()), inlineDataSize},
             objectTableSpan.toIovec(),
     };
     if (status_t status = rpcSend(
@@ -590,7 +730,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
 
                     return drainCommands(connection, session, CommandType::CONTROL_ONLY);
                 },
-                rpcFields->mFds.get());
+                sharedData ? &sharedDataFds : rpcFields->mFds.get());
         status != OK) {
         // rpcSend calls shutdownAndWait, so all refcounts should be reset. If we ever tolerate
         // errors here, then we may need to undo the binder-sent counts for the transaction as
@@ -608,9 +748,20 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
 
     LOG_ALWAYS_FATAL_IF(reply == nullptr, "Reply parcel must be used for synchronous transaction.");
 
+    if (waitForMultiplexedReply) {
+        RpcMutexUniqueLock _l(mMultiplexedMutex);
+        waiter.cv.wait(_l, [&] { return waiter.status.has_value(); });
+        return *waiter.status;
+    }
+
     return waitForReply(connection, session, reply);
 }
 
+static void cleanup_shared_reply_data(const uint8_t* data, size_t dataSize,
+                                      const binder_size_t* /*objects*/, size_t /*objectsCount*/) {
+    unmapSharedMemory(data, dataSize);
+}
+
 static void cleanup_reply_data(const uint8_t* data, size_t dataSize, const binder_size_t* objects,
                                size_t objectsCount) {
     delete[] const_cast<uint8_t*>(data);
@@ -643,6 +794,14 @@ status_t RpcState::waitForReply(const sp<RpcSession::RpcConnection>& connection,
         ancillaryFds = decltype(ancillaryFds)();
     }
 
+    return readReply(connection, session, command, std::move(ancillaryFds), reply);
+}
+
+status_t RpcState::readReply(
+        const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+        const RpcWireHeader& command,
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds,
+        Parcel* reply) {
     const size_t rpcReplyWireSize = RpcWireReply::wireSize(session->getProtocolVersion().value());
 
     if (command.bodySize < rpcReplyWireSize) {
@@ -668,6 +827,29 @@ status_t RpcState::waitForReply(const sp<RpcSession::RpcConnection>& connection,
 
     if (rpcReply.status != OK) return rpcReply.status;
 
+    if (command.options & RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA) {
+        // the body only holds the object table
+        std::optional<Span<const uint32_t>> objectTableSpan =
+                Span<const uint8_t>{data.data(), data.size()}.reinterpret<const uint32_t>();
+        if (!objectTableSpan.has_value()) {
+            ALOGE("Bad object table size for shared memory Parcel data: %zu. Terminating!",
+                  data.size());
+            (void)session->shutdownAndWait(false);
+            return BAD_VALUE;
+        }
+        const uint8_t* sharedData;
+        if (status_t status = readSharedMemoryData(session, rpcReply.parcelDataSize,
+                                                   &ancillaryFds, &sharedData);
+            status != OK) {
+            (void)session->shutdownAndWait(false);
+            return status;
+        }
+        // the object table is copied, so data is freed here
+        return reply->rpcSetDataReference(session, sharedData, rpcReply.parcelDataSize,
+                                          objectTableSpan->data, objectTableSpan->size,
+                                          std::move(ancillaryFds), cleanup_shared_reply_data);
+    }
+
     Span<const uint8_t> parcelSpan = {data.data(), data.size()};
     Span<const uint32_t> objectTableSpan;
     if (session->getProtocolVersion().value() >=
@@ -765,6 +947,116 @@ status_t RpcState::drainCommands(const sp<RpcSession::RpcConnection>& connection
     return OK;
 }
 
+status_t RpcState::getAndExecuteMultiplexedCommand(
+        const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+        const std::function<void(std::function<void()>&&)>& dispatch) {
+    LOG_RPC_DETAIL("getAndExecuteMultiplexedCommand on RpcTransport %p",
+                   connection->rpcTransport.get());
+
+    std::vector<std::variant<base::unique_fd, base::borrowed_fd>> ancillaryFds;
+    RpcWireHeader command;
+    iovec iov{&command, sizeof(command)};
+    if (status_t status =
+                rpcRec(connection, session, "command header (for multiplexed server)", &iov, 1,
+                       enableAncillaryFds(session->getFileDescriptorTransportMode()) ? &ancillaryFds
+                                                                                     : nullptr);
+        status != OK)
+        return status;
+
+    // oneway transactions run here so that they stay in order, and refcounts are quick
+    if (command.command != RPC_COMMAND_TRANSACT || command.transactionId == 0) {
+        return processCommand(connection, session, command, CommandType::ANY,
+                              std::move(ancillaryFds));
+    }
+
+    CommandData transactionData(command.bodySize);
+    if (!transactionData.valid()) {
+        return NO_MEMORY;
+    }
+    iovec bodyIov{transactionData.data(), transactionData.size()};
+    if (status_t status = rpcRec(connection, session, "transaction body", &bodyIov, 1, nullptr);
+        status != OK)
+        return status;
+
+    if (status_t status = readTransactionSharedMemoryData(session, command, &transactionData,
+                                                          &ancillaryFds);
+        status != OK) {
+        (void)session->shutdownAndWait(false);
+        return status;
+    }
+
+    // std::function must be copyable
+    struct Transaction {
+        CommandData data;
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>> ancillaryFds;
+    };
+    auto transaction = std::make_shared<Transaction>(
+            Transaction{std::move(transactionData), std::move(ancillaryFds)});
+    dispatch([this, connection, session, transaction, transactionId = command.transactionId]() {
+        // errors end the session, or are sent in the reply
+        (void)processMultiplexedTransact(connection, session, std::move(transaction->data),
+                                         std::move(transaction->ancillaryFds), transactionId);
+    });
+    return OK;
+}
+
+status_t RpcState::getAndExecuteMultiplexedReply(const sp<RpcSession::RpcConnection>& connection,
+                                                 const sp<RpcSession>& session) {
+    LOG_RPC_DETAIL("getAndExecuteMultiplexedReply on RpcTransport %p",
+                   connection->rpcTransport.get());
+
+    std::vector<std::variant<base::unique_fd, base::borrowed_fd>> ancillaryFds;
+    RpcWireHeader command;
+    iovec iov{&command, sizeof(command)};
+    if (status_t status =
+                rpcRec(connection, session, "command header (for multiplexed client)", &iov, 1,
+                       enableAncillaryFds(session->getFileDescriptorTransportMode()) ? &ancillaryFds
+                                                                                     : nullptr);
+        status != OK)
+        return status;
+
+    // the server never sends nested transactions here, only refcounts
+    if (command.command != RPC_COMMAND_REPLY) {
+        return processCommand(connection, session, command, CommandType::CONTROL_ONLY,
+                              std::move(ancillaryFds));
+    }
+
+    MultiplexedWaiter* waiter;
+    {
+        RpcMutexLockGuard _l(mMultiplexedMutex);
+        auto it = mMultiplexedWaiters.find(command.transactionId);
+        if (it == mMultiplexedWaiters.end()) {
+            ALOGE("Reply for unknown transaction %" PRIu32 ". Terminating!",
+                  command.transactionId);
+            (void)session->shutdownAndWait(false);
+            return BAD_VALUE;
+        }
+        // the waiter stays until its status is set
+        waiter = it->second;
+        mMultiplexedWaiters.erase(it);
+    }
+
+    status_t status =
+            readReply(connection, session, command, std::move(ancillaryFds), waiter->reply);
+
+    RpcMutexLockGuard _l(mMultiplexedMutex);
+    waiter->status = status;
+    waiter->cv.notify_one();
+    // the status of the reply is for its waiter, but if the read failed, the session is shut
+    // down, so the next read fails
+    return OK;
+}
+
+void RpcState::abortMultiplexedTransactions() {
+    RpcMutexLockGuard _l(mMultiplexedMutex);
+    mMultiplexedAborted = true;
+    for (auto& [transactionId, waiter] : mMultiplexedWaiters) {
+        waiter->status = DEAD_OBJECT;
+        waiter->cv.notify_one();
+    }
+    mMultiplexedWaiters.clear();
+}
+
 status_t RpcState::processCommand(
         const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
         const RpcWireHeader& command, CommandType type,
@@ -820,8 +1112,44 @@ status_t RpcState::processTransact(
         status != OK)
         return status;
 
+    if (status_t status = readTransactionSharedMemoryData(session, command, &transactionData,
+                                                          &ancillaryFds);
+        status != OK) {
+        (void)session->shutdownAndWait(false);
+        return status;
+    }
+
+    return processTransactInternal(connection, session, std::move(transactionData),
+                                   std::move(ancillaryFds), 0 /*transactionId*/);
+}
+
+status_t RpcState::processMultiplexedTransact(
+        const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+        CommandData transactionData,
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds,
+        uint32_t transactionId) {
+    // as in processCommand, for the thread which runs the transaction
+#ifdef BINDER_WITH_KERNEL_IPC
+    IPCThreadState* kernelBinderState = IPCThreadState::selfOrNull();
+    IPCThreadState::SpGuard spGuard{
+            .address = __builtin_frame_address(0),
+            .context = "processing binder RPC command (where RpcServer::setPerSessionRootObject is "
+                       "used to distinguish callers)",
+    };
+    const IPCThreadState::SpGuard* origGuard;
+    if (kernelBinderState != nullptr) {
+        origGuard = kernelBinderState->pushGetCallingSpGuard(&spGuard);
+    }
+
+    base::ScopeGuard guardUnguard = [&]() {
+        if (kernelBinderState != nullptr) {
+            kernelBinderState->restoreGetCallingSpGuard(origGuard);
+        }
+    };
+#endif // BINDER_WITH_KERNEL_IPC
+
     return processTransactInternal(connection, session, std::move(transactionData),
-                                   std::move(ancillaryFds));
+                                   std::move(ancillaryFds), transactionId);
 }
 
 static void do_nothing_to_transact_data(const uint8_t* data, size_t dataSize,
@@ -835,7 +1163,8 @@ static void do_nothing_to_transact_data(const uint8_t* data, size_t dataSize,
 status_t RpcState::processTransactInternal(
         const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
         CommandData transactionData,
-        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds) {
+        std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds,
+        uint32_t transactionId) {
     // for 'recursive' calls to this, we have already read and processed the
     // binder from the transaction data and taken reference counts into account,
     // so it is cached here.
@@ -928,8 +1257,20 @@ processTransactInternalTailCall:
                                           transactionData.size() -
                                                   offsetof(RpcWireTransaction, data)};
         Span<const uint32_t> objectTableSpan;
-        if (session->getProtocolVersion().value() >=
-            RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE) {
+        if (transactionData.sharedData() != nullptr) {
+            // the body only holds the object table
+            std::optional<Span<const uint32_t>> maybeSpan =
+                    parcelSpan.reinterpret<const uint32_t>();
+            if (!maybeSpan.has_value()) {
+                ALOGE("Bad object table size for shared memory Parcel data: %zu. Terminating!",
+                      parcelSpan.byteSize());
+                (void)session->shutdownAndWait(false);
+                return BAD_VALUE;
+            }
+            objectTableSpan = *maybeSpan;
+            parcelSpan = {transactionData.sharedData(), transactionData.sharedDataSize()};
+        } else if (session->getProtocolVersion().value() >=
+                   RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE) {
             std::optional<Span<const uint8_t>> objectTableBytes =
                     parcelSpan.splitOff(transaction->parcelDataSize);
             if (!objectTableBytes.has_value()) {
@@ -964,7 +1305,10 @@ processTransactInternalTailCall:
         ancillaryFds = std::remove_reference<decltype(ancillaryFds)>::type();
 
         if (replyStatus == OK) {
-            if (target) {
+            if (target && connection->multiplexed) {
+                // other threads serve the connection too, so it can't carry nested calls
+                replyStatus = target->transact(transaction->code, data, &reply, transaction->flags);
+            } else if (target) {
                 bool origAllowNested = connection->allowNested;
                 connection->allowNested = !oneway;
 
@@ -1092,31 +1436,39 @@ processTransactInternalTailCall:
     Span<const uint32_t> objectTableSpan = Span<const uint32_t>{rpcFields->mObjectPositions.data(),
                                                                 rpcFields->mObjectPositions.size()};
 
+    base::unique_fd sharedDataFd;
+    std::vector<std::variant<base::unique_fd, base::borrowed_fd>> sharedDataFds;
+    const bool sharedData = writeSharedMemoryData(session, reply, &sharedDataFd, &sharedDataFds);
+    const size_t inlineDataSize = sharedData ? 0 : reply.dataSize();
+
     uint32_t bodySize;
-    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(rpcReplyWireSize, reply.dataSize(), &bodySize) ||
+    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(rpcReplyWireSize, inlineDataSize, &bodySize) ||
                                 __builtin_add_overflow(objectTableSpan.byteSize(), bodySize,
-                                                       &bodySize),
+                                                       &bodySize) ||
+                                static_cast<uint32_t>(reply.dataSize()) != reply.dataSize(),
                         "Too much data for reply %zu", reply.dataSize());
     RpcWireHeader cmdReply{
             .command = RPC_COMMAND_REPLY,
             .bodySize = bodySize,
+            .transactionId = transactionId,
+            .options = sharedData ? RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA : 0,
     };
     RpcWireReply rpcReply{
             .status = replyStatus,
             // NOTE: Not necessarily written to socket depending on session
             // version.
-            // NOTE: bodySize didn't overflow => this cast is safe
+            // NOTE: checked above => this cast is safe
             .parcelDataSize = static_cast<uint32_t>(reply.dataSize()),
             .reserved = {0, 0, 0},
     };
     iovec iovs[]{
             {&cmdReply, sizeof(RpcWireHeader)},
             {&rpcReply, rpcReplyWireSize},
-            {const_cast<uint8_t*>(reply.data()), reply.dataSize()},
+            {const_cast<uint8_t*>(reply.data()), inlineDataSize},
             objectTableSpan.toIovec(),
     };
     return rpcSend(connection, session, "reply", iovs, arraysize(iovs), std::nullopt,
-                   rpcFields->mFds.get());
+                   sharedData ? &sharedDataFds : rpcFields->mFds.get());
 }
 
 status_t RpcState::processDecStrong(const sp<RpcSession::RpcConnection>& connection,
@@ -21,6 +21,7 @@
 #include <binder/RpcSession.h>
 #include <binder/RpcThreads.h>
 
+#include <functional>
 #include <map>
 #include <optional>
 #include <queue>
@@ -64,7 +65,8 @@ public:
     ~RpcState();
 
     [[nodiscard]] status_t readNewSessionResponse(const sp<RpcSession::RpcConnection>& connection,
-                                                  const sp<RpcSession>& session, uint32_t* version);
+                                                  const sp<RpcSession>& session, uint32_t* version,
+                                                  bool* multiplexed);
     [[nodiscard]] status_t sendConnectionInit(const sp<RpcSession::RpcConnection>& connection,
                                               const sp<RpcSession>& session);
     [[nodiscard]] status_t readConnectionInit(const sp<RpcSession::RpcConnection>& connection,
@@ -119,6 +121,26 @@ public:
     [[nodiscard]] status_t drainCommands(const sp<RpcSession::RpcConnection>& connection,
                                          const sp<RpcSession>& session, CommandType type);
 
+    /**
+     * For multiplexed incoming connections (see RpcSession::setMultiplexed), reads and executes
+     * a command, except that synchronous transactions are passed to 'dispatch' to run on another
+     * thread, so that they don't hold up the commands which follow them.
+     */
+    [[nodiscard]] status_t getAndExecuteMultiplexedCommand(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            const std::function<void(std::function<void()>&&)>& dispatch);
+    /**
+     * For multiplexed outgoing connections, reads a command, and passes replies to the threads
+     * which wait for them in transact.
+     */
+    [[nodiscard]] status_t getAndExecuteMultiplexedReply(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session);
+    /**
+     * Called when no more replies can be read from the multiplexed connection. Fails the
+     * transactions which wait for a reply, and those which are sent from now on.
+     */
+    void abortMultiplexedTransactions();
+
     /**
      * Called by Parcel for outgoing binders. This implies one refcount of
      * ownership to the outgoing binder.
@@ -180,9 +202,21 @@ private:
         uint8_t* data() { return mData.get(); }
         uint8_t* release() { return mData.release(); }
 
+        // The Parcel data of a transaction which was sent in shared memory instead of in the
+        // body, see RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA. Unmapped with this object.
+        void setSharedData(const uint8_t* data, size_t size);
+        const uint8_t* sharedData() { return mSharedData.get(); }
+        size_t sharedDataSize() { return mSharedData.get_deleter().size; }
+
     private:
+        struct SharedDataUnmapper {
+            size_t size = 0;
+            void operator()(const uint8_t* data) const;
+        };
+
         std::unique_ptr<uint8_t[]> mData;
         size_t mSize;
+        std::unique_ptr<const uint8_t, SharedDataUnmapper> mSharedData;
     };
 
     [[nodiscard]] status_t rpcSend(
@@ -196,8 +230,31 @@ private:
             const char* what, iovec* iovs, int niovs,
             std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* ancillaryFds = nullptr);
 
+    // Whether the data of `parcel` goes in shared memory, in which case `outMemfd` holds it, and
+    // `outFds` the file descriptors to send with the command, which end with `outMemfd`.
+    [[nodiscard]] static bool writeSharedMemoryData(
+            const sp<RpcSession>& session, const Parcel& parcel, base::unique_fd* outMemfd,
+            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* outFds);
+    // For a command with RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA, takes the memfd from the end
+    // of `ancillaryFds`, and maps `size` bytes of Parcel data from it.
+    [[nodiscard]] static status_t readSharedMemoryData(
+            const sp<RpcSession>& session, size_t size,
+            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* ancillaryFds,
+            const uint8_t** outData);
+    // Maps the Parcel data of a transaction body, if the command has it in shared memory.
+    [[nodiscard]] static status_t readTransactionSharedMemoryData(
+            const sp<RpcSession>& session, const RpcWireHeader& command,
+            CommandData* transactionData,
+            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>* ancillaryFds);
+
     [[nodiscard]] status_t waitForReply(const sp<RpcSession::RpcConnection>& connection,
                                         const sp<RpcSession>& session, Parcel* reply);
+    // reads the body of a RPC_COMMAND_REPLY
+    [[nodiscard]] status_t readReply(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            const RpcWireHeader& command,
+            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds,
+            Parcel* reply);
     [[nodiscard]] status_t processCommand(
             const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
             const RpcWireHeader& command, CommandType type,
@@ -209,7 +266,13 @@ private:
     [[nodiscard]] status_t processTransactInternal(
             const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
             CommandData transactionData,
-            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds);
+            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds,
+            uint32_t transactionId);
+    [[nodiscard]] status_t processMultiplexedTransact(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            CommandData transactionData,
+            std::vector<std::variant<base::unique_fd, base::borrowed_fd>>&& ancillaryFds,
+            uint32_t transactionId);
     [[nodiscard]] status_t processDecStrong(const sp<RpcSession::RpcConnection>& connection,
                                             const sp<RpcSession>& session,
                                             const RpcWireHeader& command);
@@ -292,6 +355,18 @@ private:
     uint32_t mNextId = 0;
     // binders known by both sides of a session
     std::map<uint64_t, BinderNode> mNodeForAddress;
+
+    // A thread which waits in transact for the reply on a multiplexed connection.
+    struct MultiplexedWaiter {
+        Parcel* reply = nullptr;
+        std::optional<status_t> status;
+        RpcConditionVariable cv;
+    };
+
+    RpcMutex mMultiplexedMutex; // for all below
+    bool mMultiplexedAborted = false;
+    uint32_t mNextTransactionId = 0;
+    std::map<uint32_t, MultiplexedWaiter*> mMultiplexedWaiters;
 };
 
 } // namespace android
@@ -19,7 +19,14 @@
 
 #include <poll.h>
 
+#include <array>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <set>
+
 #include <openssl/bn.h>
+#include <openssl/sha.h>
 #include <openssl/ssl.h>
 
 #include <binder/RpcTlsUtils.h>
@@ -449,10 +456,27 @@ public:
     std::vector<uint8_t> getCertificate(RpcCertificateFormat) const override;
 
 protected:
+    // How long the sessions of a handshake may be resumed by later connections of the client.
+    static constexpr uint32_t kResumableSessionTimeoutSeconds = 5 * 60;
+
     static ssl_verify_result_t sslCustomVerify(SSL* ssl, uint8_t* outAlert);
     virtual void preHandshake(Ssl* ssl) const = 0;
+    // Calls mCertVerifier, unless it already accepted the certificate of the peer.
+    status_t verifyPeer(const SSL* ssl, uint8_t* outAlert) const;
+    // A resumed handshake skips sslCustomVerify, so the peer of the session is verified again.
+    bool verifyResumedPeer(Ssl* ssl) const;
     bssl::UniquePtr<SSL_CTX> mCtx;
     std::shared_ptr<RpcCertificateVerifier> mCertVerifier;
+
+private:
+    using CertificateDigest = std::array<uint8_t, SHA256_DIGEST_LENGTH>;
+    static constexpr size_t kMaxAcceptedCertificates = 64;
+    static std::optional<CertificateDigest> peerCertificateDigest(const SSL* ssl);
+
+    // The SHA-256 digests of the peer certificates which were accepted by mCertVerifier, if it
+    // allows caching them.
+    mutable std::mutex mAcceptedCertificatesMutex;
+    mutable std::set<CertificateDigest> mAcceptedCertificates;
 };
 
 std::vector<uint8_t> RpcTransportCtxTls::getCertificate(RpcCertificateFormat format) const {
@@ -472,7 +496,7 @@ ssl_verify_result_t RpcTransportCtxTls::sslCustomVerify(SSL* ssl, uint8_t* outAl
     auto rpcTransportCtxTls = reinterpret_cast<RpcTransportCtxTls*>(SSL_CTX_get_app_data(ctx));
     LOG_ALWAYS_FATAL_IF(rpcTransportCtxTls == nullptr);
 
-    status_t verifyStatus = rpcTransportCtxTls->mCertVerifier->verify(ssl, outAlert);
+    status_t verifyStatus = rpcTransportCtxTls->verifyPeer(ssl, outAlert);
     if (verifyStatus == OK) {
         return ssl_verify_ok;
     }
@@ -481,6 +505,58 @@ ssl_verify_result_t RpcTransportCtxTls::sslCustomVerify(SSL* ssl, uint8_t* outAl
     return ssl_verify_invalid;
 }
 
+std::optional<RpcTransportCtxTls::CertificateDigest> RpcTransportCtxTls::peerCertificateDigest(
+        const SSL* ssl) {
+    bssl::UniquePtr<X509> peerCert(SSL_get_peer_certificate(ssl)); // Does not set error queue
+    if (peerCert == nullptr) return std::nullopt;
+    CertificateDigest digest;
+    unsigned int size = 0;
+    if (!X509_digest(peerCert.get(), EVP_sha256(), digest.data(), &size) ||
+        size != digest.size()) {
+        ERR_clear_error();
+        return std::nullopt;
+    }
+    return digest;
+}
+
+status_t RpcTransportCtxTls::verifyPeer(const SSL* ssl, uint8_t* outAlert) const {
+    if (!mCertVerifier->canCacheAcceptedCertificates()) {
+        return mCertVerifier->verify(ssl, outAlert);
+    }
+
+    std::optional<CertificateDigest> digest = peerCertificateDigest(ssl);
+    if (digest.has_value()) {
+        std::lock_guard<std::mutex> lock(mAcceptedCertificatesMutex);
+        if (mAcceptedCertificates.count(*digest) > 0) return OK;
+    }
+    status_t status = mCertVerifier->verify(ssl, outAlert);
+    if (status == OK && digest.has_value()) {
+        std::lock_guard<std::mutex> lock(mAcceptedCertificatesMutex);
+        if (mAcceptedCertificates.size() < kMaxAcceptedCertificates) {
+            mAcceptedCertificates.insert(*digest);
+        }
+    }
+    return status;
+}
+
+bool RpcTransportCtxTls::verifyResumedPeer(Ssl* ssl) const {
+    auto [reused, errorQueue] = ssl->call(SSL_session_reused);
+    errorQueue.clear();
+    if (!reused) return true;
+
+    uint8_t alert = SSL_AD_CERTIFICATE_UNKNOWN;
+    auto [verifyStatus, verifyErrorQueue] =
+            ssl->call([this](SSL* s, uint8_t* outAlert) { return verifyPeer(s, outAlert); },
+                      &alert);
+    verifyErrorQueue.clear();
+    if (verifyStatus != OK) {
+        ALOGE("Failed to verify the peer of a resumed session: status = %s, alert = %s",
+              statusToString(verifyStatus).c_str(), SSL_alert_desc_string_long(alert));
+        return false;
+    }
+    return true;
+}
+
 // Common implementation for creating server and client contexts. The child class, |Impl|, is
 // provided as a template argument so that this function can initialize an |Impl| object.
 template <typename Impl, typename>
@@ -507,6 +583,8 @@ std::unique_ptr<RpcTransportCtxTls> RpcTransportCtxTls::create(
         SSL_CTX_set_info_callback(ctx.get(), sslDebugLog);
     }
 
+    TEST_AND_RETURN(nullptr, Impl::configureSessionResumption(ctx.get()));
+
     auto ret = std::make_unique<Impl>();
     // RpcTransportCtxTls* -> void*
     TEST_AND_RETURN(nullptr, SSL_CTX_set_app_data(ctx.get(), reinterpret_cast<void*>(ret.get())));
@@ -523,21 +601,78 @@ std::unique_ptr<RpcTransport> RpcTransportCtxTls::newTransport(android::RpcTrans
 
     preHandshake(&wrapped);
     TEST_AND_RETURN(nullptr, setFdAndDoHandshake(&wrapped, socket, fdTrigger));
+    TEST_AND_RETURN(nullptr, verifyResumedPeer(&wrapped));
     return std::make_unique<RpcTransportTls>(std::move(socket), std::move(wrapped));
 }
 
 class RpcTransportCtxTlsServer : public RpcTransportCtxTls {
+public:
+    // The session tickets are encrypted with a key of this context, which BoringSSL generates, so
+    // they can only be resumed with this server.
+    static bool configureSessionResumption(SSL_CTX* ctx) {
+        static constexpr uint8_t kSessionIdContext[] = "binder_rpc";
+        SSL_CTX_set_session_psk_dhe_timeout(ctx, kResumableSessionTimeoutSeconds);
+        return SSL_CTX_set_session_id_context(ctx, kSessionIdContext, sizeof(kSessionIdContext));
+    }
+
 protected:
     void preHandshake(Ssl* ssl) const override {
         ssl->call(SSL_set_accept_state).errorQueue.clear();
     }
 };
 
+// Each RpcSession has its own client context, so the connections of a session resume the TLS
+// sessions of its earlier connections, and skip the certificate exchange of a full handshake.
 class RpcTransportCtxTlsClient : public RpcTransportCtxTls {
+public:
+    static bool configureSessionResumption(SSL_CTX* ctx) {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(ctx, onNewSession);
+        return true;
+    }
+
 protected:
     void preHandshake(Ssl* ssl) const override {
         ssl->call(SSL_set_connect_state).errorQueue.clear();
+        if (bssl::UniquePtr<SSL_SESSION> session = takeResumableSession(); session != nullptr) {
+            auto [set, errorQueue] = ssl->call(SSL_set_session, session.get());
+            if (!set) ALOGW("Could not resume session: %s", errorQueue.toString().c_str());
+            errorQueue.clear();
+        }
     }
+
+private:
+    // TLS 1.3 tickets should only be used once, and the server sends new ones with each
+    // handshake, so a few are kept.
+    static constexpr size_t kMaxResumableSessions = 16;
+
+    // Called once the server sent a ticket, which the client reads after the handshake.
+    static int onNewSession(SSL* ssl, SSL_SESSION* session) {
+        // void* -> RpcTransportCtxTls*
+        auto ctx = reinterpret_cast<RpcTransportCtxTlsClient*>(
+                SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+        LOG_ALWAYS_FATAL_IF(ctx == nullptr);
+        std::lock_guard<std::mutex> lock(ctx->mResumableSessionsMutex);
+        ctx->mResumableSessions.emplace_back(session);
+        if (ctx->mResumableSessions.size() > kMaxResumableSessions) {
+            ctx->mResumableSessions.pop_front();
+        }
+        return 1; // takes the reference to session
+    }
+
+    bssl::UniquePtr<SSL_SESSION> takeResumableSession() const {
+        std::lock_guard<std::mutex> lock(mResumableSessionsMutex);
+        while (!mResumableSessions.empty()) {
+            // the newest session expires last
+            bssl::UniquePtr<SSL_SESSION> session = std::move(mResumableSessions.back());
+            mResumableSessions.pop_back();
+            if (SSL_SESSION_is_resumable(session.get())) return session;
+        }
+        return nullptr;
+    }
+
+    mutable std::mutex mResumableSessionsMutex;
+    mutable std::deque<bssl::UniquePtr<SSL_SESSION>> mResumableSessions;
 };
 
 } // namespace
@@ -21,6 +21,11 @@ namespace android {
 #pragma clang diagnostic error "-Wpadded"
 
 constexpr uint8_t RPC_CONNECTION_OPTION_INCOMING = 0x1; // default is outgoing
+// Requests that this outgoing connection carries the transactions of all the threads of the
+// client (see RpcSession::setMultiplexed). Only ever set on the connection which requests a new
+// session, and echoed in RpcNewSessionResponse if the server multiplexes it, starting with
+// protocol version RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_MULTIPLEXED.
+constexpr uint8_t RPC_CONNECTION_OPTION_MULTIPLEXED = 0x2;
 
 constexpr uint32_t RPC_WIRE_ADDRESS_OPTION_CREATED = 1 << 0; // distinguish from '0' address
 constexpr uint32_t RPC_WIRE_ADDRESS_OPTION_FOR_SERVER = 1 << 1;
@@ -59,7 +64,8 @@ static_assert(sizeof(RpcConnectionHeader) == 16);
  */
 struct RpcNewSessionResponse {
     uint32_t version; // maximum supported by callee <= maximum supported by caller
-    uint8_t reserved[4];
+    uint8_t options;  // RPC_CONNECTION_OPTION_MULTIPLEXED if the connection is multiplexed
+    uint8_t reserved[3];
 };
 static_assert(sizeof(RpcNewSessionResponse) == 8);
 
@@ -118,10 +124,21 @@ struct RpcWireHeader {
     uint32_t command; // RPC_COMMAND_*
     uint32_t bodySize;
 
-    uint32_t reserved[2];
+    // On multiplexed connections, a non-zero ID which the client picks for each synchronous
+    // RPC_COMMAND_TRANSACT, and which the server copies into the RPC_COMMAND_REPLY, so that
+    // the reply goes to the thread which waits for it. 0 for all other commands.
+    uint32_t transactionId;
+
+    uint32_t options; // RPC_WIRE_HEADER_OPTION_*
 };
 static_assert(sizeof(RpcWireHeader) == 16);
 
+// The Parcel data of this RPC_COMMAND_TRANSACT or RPC_COMMAND_REPLY is not in its body, which only
+// holds the object table after the RpcWireTransaction or RpcWireReply. Instead, it is in a sealed
+// memfd, which is the last of the file descriptors sent with the command. Only set starting with
+// RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_SHARED_MEMORY_DATA.
+constexpr uint32_t RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA = 1 << 0;
+
 struct RpcDecStrong {
     RpcWireAddress address;
     uint32_t amount;
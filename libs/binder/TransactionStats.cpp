@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/TransactionStats.h>
+
+#include <android-base/stringprintf.h>
+#include <cutils/compiler.h>
+#include <cutils/trace.h>
+#include <utils/String8.h>
+
+#include <algorithm>
+#include <atomic>
+#include <inttypes.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+using android::base::StringAppendF;
+using android::base::StringPrintf;
+
+namespace android {
+
+namespace binder::debug {
+
+namespace {
+
+using Side = TransactionStats::Side;
+
+std::atomic<bool> gEnabled = true;
+
+struct Entry {
+    // 0 while the entry is free. The thread that owns the table stores it last, so that readers
+    // that load it see the fields below set.
+    std::atomic<uint64_t> key = 0;
+    Side side = Side::CLIENT;
+    uint32_t code = 0;
+    std::string descriptor;
+    std::string counterName;
+
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> latencySumNs = 0;
+    std::atomic<uint64_t> maxLatencyNs = 0;
+    std::atomic<uint64_t> dataSizeSum = 0;
+    std::array<std::atomic<uint64_t>, TransactionStats::kLatencyBucketCount> latencyBuckets = {};
+    std::array<std::atomic<uint64_t>, TransactionStats::kSizeBucketCount> sizeBuckets = {};
+};
+
+// Only written by the thread that owns it, and kept when the thread exits, for the next thread.
+struct ThreadTable {
+    std::array<Entry, TransactionStats::kMaxEntriesPerThread> entries;
+    std::atomic<uint64_t> dropped = 0;
+};
+
+class Registry {
+public:
+    ThreadTable* acquire() {
+        std::lock_guard lock(mMutex);
+        if (!mFreeTables.empty()) {
+            ThreadTable* table = mFreeTables.back();
+            mFreeTables.pop_back();
+            return table;
+        }
+        return mTables.emplace_back(std::make_unique<ThreadTable>()).get();
+    }
+
+    void release(ThreadTable* table) {
+        std::lock_guard lock(mMutex);
+        mFreeTables.push_back(table);
+    }
+
+    template <typename F>
+    void forEachTable(F f) {
+        std::lock_guard lock(mMutex);
+        for (const auto& table : mTables) {
+            f(*table);
+        }
+    }
+
+private:
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<ThreadTable>> mTables;
+    std::vector<ThreadTable*> mFreeTables;
+};
+
+Registry& registry() {
+    // Never destroyed, since threads may exit after the static destructors ran.
+    static Registry* sRegistry = new Registry();
+    return *sRegistry;
+}
+
+struct ThreadTableHolder {
+    ThreadTable* table = nullptr;
+
+    ~ThreadTableHolder() {
+        if (table != nullptr) {
+            registry().release(table);
+        }
+    }
+};
+
+thread_local ThreadTableHolder tTableHolder;
+
+// Only the thread that owns a table writes to it, so it does not need atomic read-modify-writes.
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// FNV-1a, which relies on the multiplication wrapping around.
+__attribute__((no_sanitize("unsigned-integer-overflow")))
+uint64_t hashKey(Side side, const char16_t* descriptor, size_t length, uint32_t code) {
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+    mix(static_cast<uint64_t>(side));
+    mix(code);
+    for (size_t i = 0; i < length; i++) {
+        mix(descriptor[i]);
+    }
+    return hash != 0 ? hash : 1;
+}
+
+const char* sideString(Side side) {
+    return side == Side::CLIENT ? "client" : "server";
+}
+
+template <size_t N>
+size_t bucketOf(const std::array<uint32_t, N>& limits, uint64_t value, uint64_t scale) {
+    const auto it = std::lower_bound(limits.begin(), limits.end(), value,
+                                     [scale](uint32_t limit, uint64_t v) {
+                                         return limit * scale < v;
+                                     });
+    return static_cast<size_t>(it - limits.begin());
+}
+
+} // namespace
+
+bool TransactionStats::isEnabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void TransactionStats::setEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TransactionStats::record(Side side, const char16_t* descriptor, size_t descriptorLength,
+                              uint32_t code, std::chrono::nanoseconds latency, size_t dataSize) {
+    if (!isEnabled()) {
+        return;
+    }
+    ThreadTable*& table = tTableHolder.table;
+    if (table == nullptr) {
+        table = registry().acquire();
+    }
+
+    const uint64_t key = hashKey(side, descriptor, descriptorLength, code);
+    Entry* entry = nullptr;
+    const size_t first = key % kMaxEntriesPerThread;
+    for (size_t i = 0; i < kMaxEntriesPerThread; i++) {
+        Entry& candidate = table->entries[(first + i) % kMaxEntriesPerThread];
+        const uint64_t candidateKey = candidate.key.load(std::memory_order_relaxed);
+        if (candidateKey == key) {
+            entry = &candidate;
+            break;
+        }
+        if (candidateKey == 0) {
+            candidate.side = side;
+            candidate.code = code;
+            candidate.descriptor = String8(descriptor, descriptorLength).c_str();
+            candidate.counterName = StringPrintf("binder %s %s#%u us", sideString(side),
+                                                 candidate.descriptor.c_str(), code);
+            candidate.key.store(key, std::memory_order_release);
+            entry = &candidate;
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        add(table->dropped, 1);
+        return;
+    }
+
+    const uint64_t latencyNs = static_cast<uint64_t>(std::max<int64_t>(0, latency.count()));
+    add(entry->count, 1);
+    add(entry->latencySumNs, latencyNs);
+    if (latencyNs > entry->maxLatencyNs.load(std::memory_order_relaxed)) {
+        entry->maxLatencyNs.store(latencyNs, std::memory_order_relaxed);
+    }
+    add(entry->dataSizeSum, dataSize);
+    add(entry->latencyBuckets[bucketOf(kLatencyBucketLimitsUs, latencyNs, 1000)], 1);
+    add(entry->sizeBuckets[bucketOf(kSizeBucketLimits, dataSize, 1)], 1);
+
+    if (CC_UNLIKELY(atrace_is_tag_enabled(ATRACE_TAG_AIDL))) {
+        atrace_int64(ATRACE_TAG_AIDL, entry->counterName.c_str(),
+                     static_cast<int64_t>(latencyNs / 1000));
+    }
+}
+
+std::string TransactionStats::toString() {
+    struct Totals {
+        uint64_t count = 0;
+        uint64_t latencySumNs = 0;
+        uint64_t maxLatencyNs = 0;
+        uint64_t dataSizeSum = 0;
+        std::array<uint64_t, kLatencyBucketCount> latencyBuckets = {};
+        std::array<uint64_t, kSizeBucketCount> sizeBuckets = {};
+    };
+    std::map<std::tuple<Side, std::string, uint32_t>, Totals> totals;
+    uint64_t dropped = 0;
+
+    registry().forEachTable([&](const ThreadTable& table) {
+        for (const Entry& entry : table.entries) {
+            if (entry.key.load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            Totals& total = totals[{entry.side, entry.descriptor, entry.code}];
+            total.count += entry.count.load(std::memory_order_relaxed);
+            total.latencySumNs += entry.latencySumNs.load(std::memory_order_relaxed);
+            total.maxLatencyNs = std::max(total.maxLatencyNs,
+                                          entry.maxLatencyNs.load(std::memory_order_relaxed));
+            total.dataSizeSum += entry.dataSizeSum.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < kLatencyBucketCount; i++) {
+                total.latencyBuckets[i] += entry.latencyBuckets[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < kSizeBucketCount; i++) {
+                total.sizeBuckets[i] += entry.sizeBuckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        dropped += table.dropped.load(std::memory_order_relaxed);
+    });
+
+    std::string result = StringPrintf("Binder transaction stats (%s):\n",
+                                      isEnabled() ? "enabled" : "disabled");
+    for (const auto& [key, total] : totals) {
+        const auto& [side, descriptor, code] = key;
+        if (total.count == 0) {
+            continue;
+        }
+        StringAppendF(&result,
+                      "  %s %s code=%u: count=%" PRIu64 " avgLatency=%.1fus maxLatency=%.1fus"
+                      " avgSize=%" PRIu64 "\n",
+                      sideString(side), descriptor.c_str(), code, total.count,
+                      total.latencySumNs / 1e3 / total.count, total.maxLatencyNs / 1e3,
+                      total.dataSizeSum / total.count);
+        result.append("    latency(us):");
+        for (size_t i = 0; i < kLatencyBucketCount; i++) {
+            if (i < kLatencyBucketLimitsUs.size()) {
+                StringAppendF(&result, " <=%" PRIu32 ":%" PRIu64, kLatencyBucketLimitsUs[i],
+                              total.latencyBuckets[i]);
+            } else {
+                StringAppendF(&result, " >%" PRIu32 ":%" PRIu64, kLatencyBucketLimitsUs.back(),
+                              total.latencyBuckets[i]);
+            }
+        }
+        result.append("\n    size(bytes):");
+        for (size_t i = 0; i < kSizeBucketCount; i++) {
+            if (i < kSizeBucketLimits.size()) {
+                StringAppendF(&result, " <=%" PRIu32 ":%" PRIu64, kSizeBucketLimits[i],
+                              total.sizeBuckets[i]);
+            } else {
+                StringAppendF(&result, " >%" PRIu32 ":%" PRIu64, kSizeBucketLimits.back(),
+                              total.sizeBuckets[i]);
+            }
+        }
+        result.append("\n");
+    }
+    if (dropped > 0) {
+        StringAppendF(&result, "  dropped=%" PRIu64 " (more than %zu codes on a thread)\n",
+                      dropped, kMaxEntriesPerThread);
+    }
+    return result;
+}
+
+} // namespace binder::debug
+
+} // namespace android
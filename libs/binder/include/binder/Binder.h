@@ -130,6 +130,7 @@ private:
     Extras*             getOrCreateExtras();
 
     [[nodiscard]] status_t setRpcClientDebug(const Parcel& data);
+    [[nodiscard]] status_t dumpTransactionStats(const Parcel& data);
     void removeRpcServerLink(const sp<RpcServerLink>& link);
 
     std::atomic<Extras*> mExtras;
@@ -21,6 +21,8 @@
 #include <binder/ProcessState.h>
 #include <utils/Vector.h>
 
+#include <deque>
+
 #if defined(_WIN32)
 typedef  int  uid_t;
 #endif
@@ -157,6 +159,44 @@ public:
                                          uint32_t code, const Parcel& data,
                                          Parcel* reply, uint32_t flags);
 
+            /**
+             * Defers the oneway transactions that this thread makes while it
+             * is alive, so that they are sent to the driver together with a
+             * single BINDER_WRITE_READ when the outermost scope ends, or when
+             * kMaxBatchedTransactions are pending. The data of each deferred
+             * transaction is copied, since the caller may release it before
+             * it is sent.
+             *
+             * Deferred transactions return NO_ERROR. Their errors, e.g.
+             * DEAD_OBJECT for a listener that died, are only reported by
+             * flush(), so callers that need the status of every call must
+             * not batch them. Synchronous transactions and replies first
+             * send the deferred transactions, so ordering is preserved.
+             *
+             * Usage:
+             *     IPCThreadState::BatchScope batch;
+             *     for (const auto& listener : listeners) {
+             *         listener->onEvent(event); // oneway
+             *     }
+             */
+            class BatchScope {
+            public:
+                BatchScope();
+                ~BatchScope();
+                BatchScope(const BatchScope&) = delete;
+                BatchScope& operator=(const BatchScope&) = delete;
+
+                // Sends the deferred transactions of this thread now, and
+                // returns the first error of the transactions deferred since
+                // the last flush.
+                status_t flush();
+
+            private:
+                IPCThreadState* const mState;
+            };
+
+            static constexpr size_t kMaxBatchedTransactions = 32;
+
             void                incStrongHandle(int32_t handle, BpBinder *proxy);
             void                decStrongHandle(int32_t handle);
             void                incWeakHandle(int32_t handle, BpBinder *proxy);
@@ -212,10 +252,16 @@ private:
                                                      uint32_t code,
                                                      const Parcel& data,
                                                      status_t* statusBuffer);
+            // Sends the deferred oneway transactions and waits for the
+            // driver to complete each of them.
+            void                flushBatch();
             status_t            getAndExecuteCommand();
             status_t            executeCommand(int32_t command);
             void                processPendingDerefs();
             void                processPostWriteDerefs();
+            // Waits for work for the idle timeout of an adaptive thread pool, and returns
+            // whether this thread, which was started by the driver, should leave the pool.
+            bool                leaveThreadPoolIfIdle();
 
             void                clearCaller();
 
@@ -248,6 +294,15 @@ private:
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
             CallRestriction     mCallRestriction;
+            // The number of live BatchScopes of this thread.
+            size_t              mBatchDepth;
+            // The copies of the data of the deferred oneway transactions, in
+            // the order they were written to mOut, until the driver
+            // completes them.
+            std::deque<Parcel>  mBatchedData;
+            // The first error of the deferred transactions since the last
+            // BatchScope::flush().
+            status_t            mBatchError;
 };
 
 } // namespace android
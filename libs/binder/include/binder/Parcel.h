@@ -49,6 +49,8 @@ namespace android {
 
 template <typename T> class Flattenable;
 template <typename T> class LightFlattenable;
+class BBinder;
+class BpBinder;
 class IBinder;
 class IPCThreadState;
 class ProcessState;
@@ -60,6 +62,8 @@ class Status;
 }
 
 class Parcel {
+    friend class BBinder;
+    friend class BpBinder;
     friend class IPCThreadState;
     friend class RpcState;
 
@@ -370,6 +374,13 @@ public:
     // as long as it keeps a dup of the blob file descriptor handy for later.
     status_t            writeDupImmutableBlobFileDescriptor(int fd);
 
+    // Writes a reference to `size` bytes of caller memory, which the kernel driver copies
+    // straight into the buffer of the recipient instead of them being copied into this Parcel
+    // first. Use it for large payloads, e.g. pixels or serialized dumps. The memory must stay
+    // valid and unchanged until the transaction that sends this Parcel returns.
+    // Returns INVALID_OPERATION for RPC Parcels, which have no such object.
+    status_t            writeBufferObject(const void* data, size_t size);
+
     status_t            writeObject(const flat_binder_object& val, bool nullMetaData);
 
     // Like Parcel.java's writeNoException().  Just writes a zero int32.
@@ -585,6 +596,11 @@ public:
     // The caller should call release() on the blob after reading its contents.
     status_t            readBlob(size_t len, ReadableBlob* outBlob) const;
 
+    // Reads a buffer written with writeBufferObject() without copying it. The memory is part of
+    // the transaction buffer of this Parcel, and stays valid until this Parcel is destroyed or
+    // written to.
+    status_t            readBufferObject(const void** outData, size_t* outSize) const;
+
     const flat_binder_object* readObject(bool nullMetaData) const;
 
     // Explicitly close all file descriptors in the parcel.
@@ -610,6 +626,8 @@ private:
     size_t              ipcDataSize() const;
     uintptr_t           ipcObjects() const;
     size_t              ipcObjectsCount() const;
+    // The size of the buffers referenced by the buffer objects, as the driver lays them out.
+    size_t              ipcBuffersSize() const;
     void ipcSetDataReference(const uint8_t* data, size_t dataSize, const binder_size_t* objects,
                              size_t objectsCount, release_func relFunc);
     // Takes ownership even when an error is returned.
@@ -636,8 +654,13 @@ private:
     void                initState();
     void                scanForFds() const;
     status_t            validateReadData(size_t len) const;
+    // Whether an object was written or received at the given offset of the data.
+    bool                hasObjectAt(size_t offset) const;
 
     void                updateWorkSourceRequestHeaderPosition() const;
+    // Returns the interface token written with writeInterfaceToken to a kernel binder Parcel,
+    // or nullptr.
+    const char16_t*     interfaceTokenInplace(size_t* outLen) const;
 
     status_t            finishFlattenBinder(const sp<IBinder>& binder);
     status_t            finishUnflattenBinder(const sp<IBinder>& binder, sp<IBinder>* out) const;
@@ -859,7 +882,8 @@ private:
             || std::is_same_v<T, uint64_t>
             || std::is_same_v<T, int64_t>
             || std::is_same_v<T, double>
-            || (std::is_enum_v<T> && (sizeof(T) == 1 || sizeof(T) == 4)); // size check not type
+            // 8 byte enums are written as their underlying int64_t or uint64_t, like the above.
+            || (std::is_enum_v<T> && (sizeof(T) == 1 || sizeof(T) == 4 || sizeof(T) == 8));
 
     // allowed "nullable" types
     // These are nonintrusive containers std::optional, std::unique_ptr, std::shared_ptr.
@@ -997,7 +1021,7 @@ private:
         using T = first_template_type_t<CT>;  // The T in CT == C<T, ...>
         if (c.size() >  std::numeric_limits<int32_t>::max()) return BAD_VALUE;
         const auto size = static_cast<int32_t>(c.size());
-        writeData(size);
+        if (const status_t status = writeData(size); status != OK) return status;
         if constexpr (is_pointer_equivalent_array_v<T>) {
             constexpr size_t limit = std::numeric_limits<size_t>::max() / sizeof(T);
             if (c.size() > limit) return BAD_VALUE;
@@ -1032,6 +1056,15 @@ private:
         if constexpr (is_pointer_equivalent_array_v<T>) {
             static_assert(N <= std::numeric_limits<size_t>::max() / sizeof(T));
             return write(val.data(), val.size() * sizeof(T));
+        } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char16_t>) {
+            // reserve data space once rather than growing the parcel by element
+            static_assert(N <= std::numeric_limits<size_t>::max() / sizeof(int32_t));
+            auto data = reinterpret_cast<int32_t*>(writeInplace(N * sizeof(int32_t)));
+            if (data == nullptr) return BAD_VALUE;
+            for (const auto t : val) {
+                *data++ = static_cast<int32_t>(t);
+            }
+            return OK;
         } else /* constexpr */ {
             for (const auto& t : val) {
                 status = writeData(t);
@@ -1246,6 +1279,12 @@ private:
             auto data = reinterpret_cast<const T*>(readInplace(N * sizeof(T)));
             if (data == nullptr) return BAD_VALUE;
             memcpy(val->data(), data, N * sizeof(T));
+        } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char16_t>) {
+            auto data = reinterpret_cast<const int32_t*>(readInplace(N * sizeof(int32_t)));
+            if (data == nullptr) return BAD_VALUE;
+            for (auto& t : *val) {
+                t = static_cast<T>(*data++);
+            }
         } else if constexpr (is_specialization_v<T, sp>) {
             for (auto& t : *val) {
                 if (readFlags & READ_FLAG_SP_NULLABLE) {
@@ -24,6 +24,8 @@
 
 #include <pthread.h>
 
+#include <chrono>
+
 // ---------------------------------------------------------------------------
 namespace android {
 
@@ -65,6 +67,20 @@ public:
 
     // For main functions - dangerous for libraries to use
     status_t setThreadPoolMaxThreadCount(size_t maxThreads);
+
+    // For main functions - dangerous for libraries to use
+    //
+    // Lets the number of threads started by the driver follow the load, between minThreads and
+    // maxThreads, instead of growing to a fixed maximum and never shrinking:
+    //  - The limit starts at minThreads. It is raised by half, up to maxThreads, whenever every
+    //    thread of the pool is executing a command or threads wait in
+    //    IPCThreadState::blockUntilThreadAvailable().
+    //  - Threads started by the driver beyond minThreads leave the pool once they have waited
+    //    for work for idleTimeout, and the limit is lowered with them.
+    // Must be called before the thread pool is started. setThreadPoolMaxThreadCount() restores a
+    // fixed maximum.
+    status_t setThreadPoolAdaptive(size_t minThreads, size_t maxThreads,
+                                   std::chrono::milliseconds idleTimeout);
     status_t enableOnewaySpamDetection(bool enable);
 
     // Set the name of the current thread to look like a threadpool
@@ -109,6 +125,23 @@ public:
      */
     bool isThreadPoolStarted() const;
 
+    struct ThreadPoolStats {
+        // The number of threads the driver may currently start.
+        size_t maxThreads = 0;
+        // The threads in the thread pool, including the ones that joined it.
+        size_t currentThreads = 0;
+        // The threads executing a command, now and at most.
+        size_t executingThreads = 0;
+        size_t peakExecutingThreads = 0;
+        // The number of times every thread of the pool was executing a command.
+        uint64_t starvationCount = 0;
+        // The number of times an adaptive thread pool raised its limit, and the number of idle
+        // threads that left it.
+        uint64_t growCount = 0;
+        uint64_t idleExitCount = 0;
+    };
+    ThreadPoolStats getThreadPoolStats() const;
+
     enum class DriverFeature {
         ONEWAY_SPAM_DETECTION,
         EXTENDED_ERROR,
@@ -140,6 +173,18 @@ private:
 
     handle_entry* lookupHandleLocked(int32_t handle);
 
+    // Tells the driver how many threads it may start, knowing that it keeps counting the threads
+    // that left the pool. Requires mThreadCountLock.
+    status_t setDriverMaxThreadsLocked(size_t maxThreads);
+    // Raises the limit of an adaptive thread pool. Requires mThreadCountLock.
+    void growThreadPoolLocked();
+    // Returns how long an idle thread started by the driver should wait for work before leaving
+    // an adaptive thread pool, or -1 if it should stay.
+    int64_t getIdleTimeoutMs() const;
+    // Returns whether a thread started by the driver that waited for work for the idle timeout
+    // leaves the thread pool.
+    bool leaveThreadPoolIfIdle();
+
     String8 mDriverName;
     int mDriverFD;
     void* mVMStart;
@@ -160,6 +205,16 @@ private:
     size_t mKernelStartedThreads;
     // Time when thread pool was emptied
     int64_t mStarvationStartTimeMs;
+    // Whether mMaxThreads follows the load, between mMinThreads and mAdaptiveMaxThreads.
+    bool mAdaptiveThreadPool;
+    size_t mMinThreads;
+    size_t mAdaptiveMaxThreads;
+    int64_t mIdleTimeoutMs;
+    // Threads started by the driver that left the thread pool.
+    size_t mExitedThreads;
+    size_t mPeakExecutingThreads;
+    uint64_t mStarvationCount;
+    uint64_t mThreadPoolGrowCount;
 
     mutable Mutex mLock; // protects everything below.
 
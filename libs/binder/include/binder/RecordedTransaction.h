@@ -18,7 +18,10 @@
 
 #include <android-base/unique_fd.h>
 #include <binder/Parcel.h>
+#include <functional>
 #include <mutex>
+#include <string_view>
+#include <vector>
 
 namespace android {
 
@@ -51,9 +54,19 @@ public:
     const Parcel& getReplyParcel() const;
 
 private:
+    friend class RecordedTransactionFile;
+
     RecordedTransaction() = default;
 
-    android::status_t writeChunk(const android::base::borrowed_fd, uint32_t chunkType,
+    // Filled with the transaction whose chunks are in [data, data + size), which must be
+    // 8-byte aligned.
+    static std::optional<RecordedTransaction> fromChunks(const uint8_t* data, size_t size);
+
+    // Sets the fields of a chunk which was read. Returns false if the chunk is invalid.
+    bool readChunk(uint32_t chunkType, uint32_t dataSize, const uint8_t* data);
+
+    // Appends a chunk to buffer, which is written with a single write by dumpToFile.
+    android::status_t writeChunk(std::vector<std::byte>* buffer, uint32_t chunkType,
                                  size_t byteCount, const uint8_t* data) const;
 
 #pragma clang diagnostic push
@@ -80,6 +93,56 @@ private:
     Parcel mReply;
 };
 
+// A recording of transactions, as written by RecordedTransaction::dumpToFile, which is mapped
+// into memory and indexed once when it is opened. The index only holds the header of each
+// transaction, so that a replay can filter and seek the transactions without reading them,
+// and the transactions are then read from the mapping without any I/O. All the methods are
+// const and may be called from several threads.
+class RecordedTransactionFile {
+public:
+    struct Entry {
+        // Offset and size of the chunks of the transaction in the file.
+        size_t offset = 0;
+        size_t size = 0;
+        std::string interfaceName;
+        uint32_t code = 0;
+        uint32_t flags = 0;
+        timespec timestamp = {};
+    };
+
+    // Maps the whole file of fd, whose position is unchanged. A transaction which is only
+    // partially written at the end of the file, e.g. because it is still being recorded, is
+    // left out of the index.
+    static std::optional<RecordedTransactionFile> fromFile(const android::base::unique_fd& fd);
+
+    RecordedTransactionFile(RecordedTransactionFile&& other) noexcept;
+    RecordedTransactionFile& operator=(RecordedTransactionFile&& other) noexcept;
+    ~RecordedTransactionFile();
+
+    // The transactions in the order they were recorded.
+    const std::vector<Entry>& getIndex() const { return mIndex; }
+    size_t size() const { return mIndex.size(); }
+
+    // Reads the transaction at the given position of the index, checking its checksums.
+    std::optional<RecordedTransaction> getTransaction(size_t index) const;
+
+    // Returns the positions in the index of the transactions for which filter returns true.
+    std::vector<size_t> findTransactions(const std::function<bool(const Entry&)>& filter) const;
+    // Returns the positions of the transactions of an interface, with a given code if any.
+    std::vector<size_t> findTransactions(std::string_view interfaceName,
+                                         std::optional<uint32_t> code = std::nullopt) const;
+    // Returns the position of the first transaction recorded at or after timestamp, or size()
+    // if there is none.
+    size_t seek(timespec timestamp) const;
+
+private:
+    RecordedTransactionFile() = default;
+
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+    std::vector<Entry> mIndex;
+};
+
 } // namespace binder::debug
 
 } // namespace android
@@ -29,6 +29,7 @@
 namespace android {
 
 class FdTrigger;
+class RpcEventLoop;
 class RpcServerTrusty;
 class RpcSocketAddress;
 
@@ -148,6 +149,29 @@ public:
     void setSupportedFileDescriptorTransportModes(
             const std::vector<RpcSession::FileDescriptorTransportMode>& modes);
 
+    /**
+     * See RpcSession::setSharedMemoryDataThreshold, which applies to the replies of the
+     * sessions of this server.
+     */
+    void setSharedMemoryDataThreshold(size_t bytes);
+
+    /**
+     * By default, each incoming connection has a thread which waits for its
+     * commands, so a server with many sessions has many idle threads. When this
+     * is set, the connections are instead served by this many threads, which
+     * wait for any connection to have a command and execute it. The threads are
+     * started by join() and stopped by shutdown().
+     *
+     * setMaxThreads still sets the number of connections of each session. A
+     * command which takes long, e.g. a nested call back into the client, keeps
+     * one of these threads from serving the other connections.
+     *
+     * Multiplexed connections (see RpcSession::setMultiplexed) keep their own
+     * threads. This is not supported on all platforms, nor in single-threaded
+     * builds.
+     */
+    void setEventLoopThreads(size_t threads);
+
     /**
      * The root object can be retrieved by any client, without any
      * authentication. TODO(b/183988761)
@@ -256,6 +280,8 @@ private:
     // A mode is supported if the N'th bit is on, where N is the mode enum's value.
     std::bitset<8> mSupportedFileDescriptorTransportModes = std::bitset<8>().set(
             static_cast<size_t>(RpcSession::FileDescriptorTransportMode::NONE));
+    size_t mSharedMemoryDataThreshold = 0;
+    size_t mEventLoopThreads = 0;
     RpcTransportFd mServer; // socket we are accepting sessions on
 
     RpcMutex mLock; // for below
@@ -269,6 +295,8 @@ private:
     std::function<bool(const void*, size_t)> mConnectionFilter;
     std::map<std::vector<uint8_t>, sp<RpcSession>> mSessions;
     std::unique_ptr<FdTrigger> mShutdownTrigger;
+    // shared with the connecting threads, which may still be running once shutdown() returns
+    std::shared_ptr<RpcEventLoop> mEventLoop;
     RpcConditionVariable mShutdownCv;
     std::function<status_t(const RpcServer& server, RpcTransportFd* out)> mAcceptFn;
 };
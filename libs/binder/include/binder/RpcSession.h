@@ -30,6 +30,7 @@
 namespace android {
 
 class Parcel;
+class RpcEventLoop;
 class RpcServer;
 class RpcServerTrusty;
 class RpcSocketAddress;
@@ -37,9 +38,9 @@ class RpcState;
 class RpcTransport;
 class FdTrigger;
 
-constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_NEXT = 2;
+constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_NEXT = 4;
 constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_EXPERIMENTAL = 0xF0000000;
-constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION = 1;
+constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION = 3;
 
 // Starting with this version:
 //
@@ -47,6 +48,18 @@ constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION = 1;
 // * RpcWireTransaction and RpcWireReplyV1 include the parcel data size.
 constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE = 1;
 
+// Starting with this version:
+//
+// * A client may request a multiplexed connection (RPC_CONNECTION_OPTION_MULTIPLEXED), where
+//   RpcWireHeader::transactionId matches replies with their transactions.
+constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_MULTIPLEXED = 2;
+
+// Starting with this version:
+//
+// * The Parcel data of a transaction or reply may be sent in a sealed memfd instead of in the
+//   command body (RPC_WIRE_HEADER_OPTION_SHARED_MEMORY_DATA).
+constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_SHARED_MEMORY_DATA = 3;
+
 /**
  * This represents a session (group of connections) between a client
  * and a server. Multiple connections are needed for multiple parallel "binder"
@@ -115,6 +128,44 @@ public:
     void setFileDescriptorTransportMode(FileDescriptorTransportMode mode);
     FileDescriptorTransportMode getFileDescriptorTransportMode();
 
+    /**
+     * Send the data of the Parcels of at least this many bytes, which this session sends in
+     * transactions or replies, in shared memory instead of over the connection. The data is
+     * copied once into a sealed memfd, which the other side maps, rather than being copied
+     * through the socket buffers. This also allows Parcels larger than the buffer that the other
+     * side allocates for each command.
+     *
+     * This only applies with FileDescriptorTransportMode::UNIX, and starting with
+     * RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_SHARED_MEMORY_DATA. By default, this is 0,
+     * which disables it. This must be called before setting up connections.
+     */
+    void setSharedMemoryDataThreshold(size_t bytes);
+    size_t getSharedMemoryDataThreshold();
+
+    /**
+     * Make all the threads of this client share a single outgoing connection, instead of
+     * taking one connection for each concurrent call, e.g. to avoid the sockets and handshakes
+     * of the other connections over vsock or TLS. By default, this is false. This must be called
+     * before setting up this connection as a client. If the server does not support it (see
+     * RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_MULTIPLEXED), the session uses one connection
+     * per thread as usual, see isMultiplexed.
+     *
+     * The calls of the threads are interleaved on the connection, and a thread of this session
+     * receives the replies and passes them to the threads which wait for them. The server still
+     * runs at most its maximum number of threads of calls at the same time, and runs the oneway
+     * calls in order on the thread which reads them. Nested calls can't use the multiplexed
+     * connection, so a server which calls back into this client while serving a call needs
+     * incoming connections, see setMaxIncomingThreads.
+     *
+     * If this is called, 'shutdown' on this session must also be called.
+     * Otherwise, the thread which receives the replies will leak.
+     */
+    void setMultiplexed(bool multiplexed);
+    /**
+     * Whether the outgoing calls of this session share a multiplexed connection.
+     */
+    bool isMultiplexed();
+
     /**
      * This should be called once per thread, matching 'join' in the remote
      * process.
@@ -219,6 +270,7 @@ public:
 
 private:
     friend sp<RpcSession>;
+    friend RpcEventLoop;
     friend RpcServer;
     friend RpcServerTrusty;
     friend RpcState;
@@ -243,11 +295,14 @@ private:
     public:
         void onSessionAllIncomingThreadsEnded(const sp<RpcSession>& session) override;
         void onSessionIncomingThreadEnded() override;
+        void onMultiplexedReceiverStarted();
+        void onMultiplexedReceiverEnded();
         void waitForShutdown(RpcMutexUniqueLock& lock, const sp<RpcSession>& session);
 
     private:
         RpcConditionVariable mCv;
         std::atomic<size_t> mShutdownCount = 0;
+        std::atomic<bool> mMultiplexedReceiving = false;
     };
     friend WaitForShutdownListener;
 
@@ -259,6 +314,11 @@ private:
         std::optional<uint64_t> exclusiveTid;
 
         bool allowNested = false;
+
+        // whether all the threads use this connection at the same time, in which case
+        // writes take writeMutex, and a single thread reads.
+        bool multiplexed = false;
+        RpcMutex writeMutex;
     };
 
     [[nodiscard]] status_t readId();
@@ -278,9 +338,15 @@ private:
         // Status of setup
         status_t status;
     };
-    PreJoinSetupResult preJoinSetup(std::unique_ptr<RpcTransport> rpcTransport);
+    PreJoinSetupResult preJoinSetup(std::unique_ptr<RpcTransport> rpcTransport, bool multiplexed);
     // join on thread passed to preJoinThreadOwnership
     static void join(sp<RpcSession>&& session, PreJoinSetupResult&& result);
+    // for a multiplexed incoming connection, this thread reads the commands, and other threads
+    // run the synchronous transactions
+    static void joinMultiplexed(const sp<RpcSession>& session,
+                                const sp<RpcConnection>& connection);
+    // for a multiplexed outgoing connection, starts the thread which reads the replies
+    void startMultiplexedReceiver(const sp<RpcConnection>& connection);
 
     [[nodiscard]] status_t setupClient(
             const std::function<status_t(const std::vector<uint8_t>& sessionId, bool incoming)>&
@@ -300,7 +366,7 @@ private:
                                     const std::vector<uint8_t>& sessionId,
                                     const sp<IBinder>& sessionSpecificRoot);
     sp<RpcConnection> assignIncomingConnectionToThisThread(
-            std::unique_ptr<RpcTransport> rpcTransport);
+            std::unique_ptr<RpcTransport> rpcTransport, bool multiplexed);
     [[nodiscard]] bool removeIncomingConnection(const sp<RpcConnection>& connection);
     void clearConnectionTid(const sp<RpcConnection>& connection);
 
@@ -378,6 +444,8 @@ private:
     size_t mMaxOutgoingConnections = kDefaultMaxOutgoingConnections;
     std::optional<uint32_t> mProtocolVersion;
     FileDescriptorTransportMode mFileDescriptorTransportMode = FileDescriptorTransportMode::NONE;
+    size_t mSharedMemoryDataThreshold = 0;
+    bool mMultiplexed = false;
 
     RpcConditionVariable mAvailableConnectionCv; // for mWaitingThreads
 
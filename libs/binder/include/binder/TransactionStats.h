@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace android {
+
+namespace binder::debug {
+
+// Histograms of the latency and the data size of the user transactions of this process, per
+// side, interface descriptor and transaction code. BpBinder records the transactions that the
+// process makes, from the call to the reply, and BBinder the ones it serves, around onTransact.
+// The descriptor is the interface token of the data, so it is empty for transactions that do not
+// write one.
+//
+// Each thread records into its own table, so recording costs a hash of the descriptor and a few
+// uncontended stores. The tables are read when the stats are dumped, e.g. with
+// `dumpsys --binder-stats SERVICE`, which sends IBinder::STATS_TRANSACTION to the service.
+//
+// While the AIDL atrace tag is enabled, the latency of each transaction is also reported as a
+// counter track, so that the slow methods can be seen next to the rest of a perfetto trace.
+class TransactionStats {
+public:
+    enum class Side : uint8_t {
+        CLIENT,
+        SERVER,
+    };
+
+    // The upper bounds of the latency buckets, in microseconds. The last bucket holds the
+    // longer transactions.
+    static constexpr std::array<uint32_t, 12> kLatencyBucketLimitsUs = {
+            10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+    };
+    static constexpr size_t kLatencyBucketCount = kLatencyBucketLimitsUs.size() + 1;
+    // The upper bounds of the data size buckets, in bytes.
+    static constexpr std::array<uint32_t, 7> kSizeBucketLimits = {
+            64, 256, 1024, 4096, 16384, 65536, 262144,
+    };
+    static constexpr size_t kSizeBucketCount = kSizeBucketLimits.size() + 1;
+    // The number of (side, descriptor, code) pairs that each thread records. Transactions
+    // beyond that are only counted as dropped.
+    static constexpr size_t kMaxEntriesPerThread = 32;
+
+    // Stats are recorded unless disabled.
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    static void record(Side side, const char16_t* descriptor, size_t descriptorLength,
+                       uint32_t code, std::chrono::nanoseconds latency, size_t dataSize);
+
+    // Returns the stats of all the threads, summed per side, descriptor and code.
+    static std::string toString();
+};
+
+} // namespace binder::debug
+
+} // namespace android
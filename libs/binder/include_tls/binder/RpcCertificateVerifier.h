@@ -38,6 +38,12 @@ public:
     // - NO_INIT for not presenting a certificate when requested
     // - UNKNOWN_ERROR for other errors
     virtual status_t verify(const SSL* ssl, uint8_t* outAlert) = 0;
+
+    // If this returns true, the leaf certificates which verify() accepted are remembered by the
+    // RpcTransportCtx, which accepts them again without calling verify(), e.g. for the other
+    // connections of a session. Only return true if a certificate which was accepted once is
+    // never rejected later.
+    virtual bool canCacheAcceptedCertificates() const { return false; }
 };
 
 } // namespace android
@@ -22,6 +22,7 @@
 #include "status_internal.h"
 
 #include <limits>
+#include <type_traits>
 
 #include <android-base/logging.h>
 #include <android-base/unique_fd.h>
@@ -105,14 +106,13 @@ binder_status_t WriteArray<char16_t>(AParcel* parcel, const char16_t* array, int
     if (length <= 0) return STATUS_OK;
 
     int32_t size = 0;
-    if (__builtin_smul_overflow(sizeof(char16_t), length, &size)) return STATUS_NO_MEMORY;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    Parcel* rawParcel = parcel->get();
+    int32_t* const data = static_cast<int32_t*>(parcel->get()->writeInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
     for (int32_t i = 0; i < length; i++) {
-        status = rawParcel->writeChar(array[i]);
-
-        if (status != STATUS_OK) return PruneStatusT(status);
+        data[i] = static_cast<int32_t>(array[i]);
     }
 
     return STATUS_OK;
@@ -175,12 +175,13 @@ binder_status_t ReadArray<char16_t>(const AParcel* parcel, void* arrayData,
     if (array == nullptr) return STATUS_NO_MEMORY;
 
     int32_t size = 0;
-    if (__builtin_smul_overflow(sizeof(char16_t), length, &size)) return STATUS_NO_MEMORY;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    for (int32_t i = 0; i < length; i++) {
-        status_t status = rawParcel->readChar(array + i);
+    const int32_t* const data = static_cast<const int32_t*>(rawParcel->readInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
-        if (status != STATUS_OK) return PruneStatusT(status);
+    for (int32_t i = 0; i < length; i++) {
+        array[i] = static_cast<char16_t>(data[i]);
     }
 
     return STATUS_OK;
@@ -197,10 +198,23 @@ binder_status_t WriteArray(AParcel* parcel, const void* arrayData, int32_t lengt
 
     Parcel* rawParcel = parcel->get();
 
-    for (int32_t i = 0; i < length; i++) {
-        status = (rawParcel->*write)(getter(arrayData, i));
+    if constexpr (std::is_same_v<T, bool>) {
+        // Each element is written as an int32_t, so reserve the space of the array at once.
+        int32_t size = 0;
+        if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
+
+        int32_t* const data = static_cast<int32_t*>(rawParcel->writeInplace(size));
+        if (data == nullptr) return STATUS_NO_MEMORY;
+
+        for (int32_t i = 0; i < length; i++) {
+            data[i] = static_cast<int32_t>(getter(arrayData, i));
+        }
+    } else {
+        for (int32_t i = 0; i < length; i++) {
+            status = (rawParcel->*write)(getter(arrayData, i));
 
-        if (status != STATUS_OK) return PruneStatusT(status);
+            if (status != STATUS_OK) return PruneStatusT(status);
+        }
     }
 
     return STATUS_OK;
@@ -226,12 +240,24 @@ binder_status_t ReadArray(const AParcel* parcel, void* arrayData, ArrayAllocator
 
     if (length <= 0) return STATUS_OK;
 
-    for (int32_t i = 0; i < length; i++) {
-        T readTarget;
-        status_t status = (rawParcel->*read)(&readTarget);
-        if (status != STATUS_OK) return PruneStatusT(status);
+    if constexpr (std::is_same_v<T, bool>) {
+        int32_t size = 0;
+        if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
+
+        const int32_t* const data = static_cast<const int32_t*>(rawParcel->readInplace(size));
+        if (data == nullptr) return STATUS_NO_MEMORY;
 
-        setter(arrayData, i, readTarget);
+        for (int32_t i = 0; i < length; i++) {
+            setter(arrayData, i, data[i] != 0);
+        }
+    } else {
+        for (int32_t i = 0; i < length; i++) {
+            T readTarget;
+            status_t status = (rawParcel->*read)(&readTarget);
+            if (status != STATUS_OK) return PruneStatusT(status);
+
+            setter(arrayData, i, readTarget);
+        }
     }
 
     return STATUS_OK;
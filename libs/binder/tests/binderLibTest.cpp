@@ -27,6 +27,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <android-base/file.h>
 #include <android-base/properties.h>
 #include <android-base/result-gmock.h>
 #include <android-base/result.h>
@@ -40,6 +41,7 @@
 #include <binder/IServiceManager.h>
 #include <binder/RpcServer.h>
 #include <binder/RpcSession.h>
+#include <binder/TransactionStats.h>
 
 #include <linux/sched.h>
 #include <sys/epoll.h>
@@ -124,7 +126,9 @@ enum BinderLibTestTranscationCode {
     BINDER_LIB_TEST_LOCK_UNLOCK,
     BINDER_LIB_TEST_PROCESS_LOCK,
     BINDER_LIB_TEST_UNLOCK_AFTER_MS,
-    BINDER_LIB_TEST_PROCESS_TEMPORARY_LOCK
+    BINDER_LIB_TEST_PROCESS_TEMPORARY_LOCK,
+    BINDER_LIB_TEST_ECHO_BUFFER_OBJECT,
+    BINDER_LIB_TEST_GET_THREAD_POOL_STATS,
 };
 
 pid_t start_server_process(int arg2, bool usePoll = false)
@@ -456,6 +460,29 @@ TEST_F(BinderLibTest, AddManagerToManager) {
     EXPECT_EQ(NO_ERROR, sm->addService(String16("binderLibTest-manager"), binder));
 }
 
+TEST_F(BinderLibTest, CheckServiceAfterServiceIsRegisteredAgain) {
+    sp<IServiceManager> sm = defaultServiceManager();
+    const String16 name("binderLibTest-registeredAgain");
+    sp<IBinder> first = sp<BBinder>::make();
+    ASSERT_EQ(NO_ERROR, sm->addService(name, first));
+
+    // The service is cached from the second lookup.
+    EXPECT_EQ(first, sm->checkService(name));
+    EXPECT_EQ(first, sm->checkService(name));
+    EXPECT_EQ(first, sm->checkService(name));
+
+    sp<IBinder> second = sp<BBinder>::make();
+    ASSERT_EQ(NO_ERROR, sm->addService(name, second));
+
+    // servicemanager notifies the cache asynchronously.
+    sp<IBinder> found;
+    for (int i = 0; i < 100 && found != second; i++) {
+        found = sm->checkService(name);
+        if (found != second) usleep(10000);
+    }
+    EXPECT_EQ(second, found);
+}
+
 TEST_F(BinderLibTest, WasParceled) {
     auto binder = sp<BBinder>::make();
     EXPECT_FALSE(binder->wasParceled());
@@ -1166,6 +1193,39 @@ TEST_F(BinderLibTest, VectorSent) {
     EXPECT_EQ(readValue, testValue);
 }
 
+TEST_F(BinderLibTest, BufferObjectSent) {
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+
+    for (size_t size : {size_t{0}, size_t{3}, size_t{64 * 1024}, size_t{512 * 1024 + 5}}) {
+        std::vector<uint8_t> testValue(size);
+        for (size_t i = 0; i < size; i++) {
+            testValue[i] = static_cast<uint8_t>(i * 31);
+        }
+
+        Parcel data, reply;
+        data.writeInt32(42);
+        EXPECT_THAT(data.writeBufferObject(testValue.data(), testValue.size()), StatusEq(OK));
+        data.writeInt32(43);
+        // The buffer is not copied into the data.
+        EXPECT_LT(data.dataSize(), size_t{64});
+        EXPECT_THAT(server->transact(BINDER_LIB_TEST_ECHO_BUFFER_OBJECT, data, &reply),
+                    StatusEq(NO_ERROR))
+                << size;
+
+        // The server replies with a buffer object pointing into its own transaction buffer.
+        const void* readData = nullptr;
+        size_t readSize = 0;
+        ASSERT_THAT(reply.readBufferObject(&readData, &readSize), StatusEq(OK));
+        ASSERT_EQ(size, readSize);
+        if (size > 0) {
+            EXPECT_NE(static_cast<const void*>(testValue.data()), readData);
+            EXPECT_EQ(0, memcmp(testValue.data(), readData, size));
+        }
+        EXPECT_EQ(43, reply.readInt32());
+    }
+}
+
 TEST_F(BinderLibTest, FileDescriptorRemainsNonBlocking) {
     sp<IBinder> server = addServer();
     ASSERT_TRUE(server != nullptr);
@@ -1390,6 +1450,71 @@ TEST_F(BinderLibTest, ThreadPoolAvailableThreads) {
     EXPECT_EQ(replyi, kKernelThreads + 1);
 }
 
+TEST_F(BinderLibTest, ThreadPoolStats) {
+    Parcel data, reply;
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+    EXPECT_THAT(server->transact(BINDER_LIB_TEST_GET_THREAD_POOL_STATS, data, &reply),
+                StatusEq(NO_ERROR));
+    // The pool of the server has a fixed maximum, so it never grows or shrinks.
+    EXPECT_EQ(kKernelThreads, reply.readInt32());
+    EXPECT_GE(reply.readInt32(), 1); // the thread executing this command
+    EXPECT_EQ(0, reply.readInt32());
+    EXPECT_EQ(0, reply.readInt32());
+}
+
+TEST_F(BinderLibTest, BatchedOnewayTransactions) {
+    sp<BinderLibTestCallBack> callBack = new BinderLibTestCallBack();
+    {
+        IPCThreadState::BatchScope batch;
+        // More transactions than a batch holds, so that some are sent before the scope ends.
+        for (size_t i = 0; i < IPCThreadState::kMaxBatchedTransactions + 1; i++) {
+            Parcel data;
+            EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, nullptr,
+                                           TF_ONE_WAY),
+                        StatusEq(NO_ERROR));
+        }
+        // The data is copied, so it can be released before the batch is sent.
+        {
+            Parcel data;
+            data.writeStrongBinder(callBack);
+            EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_CALL_BACK, data, nullptr,
+                                           TF_ONE_WAY),
+                        StatusEq(NO_ERROR));
+        }
+        EXPECT_THAT(batch.flush(), StatusEq(NO_ERROR));
+    }
+    EXPECT_THAT(callBack->waitEvent(5), StatusEq(NO_ERROR));
+    EXPECT_THAT(callBack->getResult(), StatusEq(NO_ERROR));
+}
+
+TEST_F(BinderLibTest, TransactionStats) {
+    using android::binder::debug::TransactionStats;
+    Parcel data, reply;
+    data.writeInterfaceToken(binderLibTestServiceName);
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_GET_WORK_SOURCE_TRANSACTION, data, &reply),
+                StatusEq(NO_ERROR));
+    const std::string code =
+            " code=" + std::to_string(BINDER_LIB_TEST_GET_WORK_SOURCE_TRANSACTION) + ": count=";
+    EXPECT_THAT(TransactionStats::toString(),
+                testing::HasSubstr("client " + std::string(String8(binderLibTestServiceName)) +
+                                   code));
+
+    // The server records the transaction too.
+    base::unique_fd readEnd, writeEnd;
+    ASSERT_TRUE(base::Pipe(&readEnd, &writeEnd));
+    Parcel statsData, statsReply;
+    ASSERT_THAT(statsData.writeFileDescriptor(writeEnd.get()), StatusEq(NO_ERROR));
+    EXPECT_THAT(m_server->transact(IBinder::STATS_TRANSACTION, statsData, &statsReply),
+                StatusEq(NO_ERROR));
+    writeEnd.reset();
+    std::string stats;
+    ASSERT_TRUE(base::ReadFdToString(readEnd, &stats));
+    EXPECT_THAT(stats,
+                testing::HasSubstr("server " + std::string(String8(binderLibTestServiceName)) +
+                                   code));
+}
+
 TEST_F(BinderLibTest, ThreadPoolStarted) {
     Parcel data, reply;
     sp<IBinder> server = addServer();
@@ -1834,6 +1959,18 @@ public:
                 reply->writeUint64Vector(vector);
                 return NO_ERROR;
             }
+            case BINDER_LIB_TEST_ECHO_BUFFER_OBJECT: {
+                if (data.readInt32() != 42) return BAD_VALUE;
+                const void* buffer;
+                size_t size;
+                auto err = data.readBufferObject(&buffer, &size);
+                if (err != NO_ERROR) return err;
+                // The buffer stays valid until the reply is sent.
+                err = reply->writeBufferObject(buffer, size);
+                if (err != NO_ERROR) return err;
+                reply->writeInt32(data.readInt32());
+                return NO_ERROR;
+            }
             case BINDER_LIB_TEST_GET_NON_BLOCKING_FD: {
                 std::array<int, 2> sockets;
                 const bool created = socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets.data()) == 0;
@@ -1866,6 +2003,14 @@ public:
                 reply->writeInt32(ProcessState::self()->getThreadPoolMaxTotalThreadCount());
                 return NO_ERROR;
             }
+            case BINDER_LIB_TEST_GET_THREAD_POOL_STATS: {
+                const auto stats = ProcessState::self()->getThreadPoolStats();
+                reply->writeInt32(static_cast<int32_t>(stats.maxThreads));
+                reply->writeInt32(static_cast<int32_t>(stats.peakExecutingThreads));
+                reply->writeInt32(static_cast<int32_t>(stats.growCount));
+                reply->writeInt32(static_cast<int32_t>(stats.idleExitCount));
+                return NO_ERROR;
+            }
             case BINDER_LIB_TEST_IS_THREADPOOL_STARTED: {
                 reply->writeBool(ProcessState::self()->isThreadPoolStarted());
                 return NO_ERROR;
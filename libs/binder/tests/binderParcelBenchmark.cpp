@@ -36,6 +36,10 @@ void writeVector(android::Parcel &p, const V<T, Args...> &v) {
         p.writeInt32Vector(v);
     } else if constexpr (std::is_same_v<T, int64_t>) {
         p.writeInt64Vector(v);
+    } else if constexpr (std::is_same_v<T, float>) {
+        p.writeFloatVector(v);
+    } else if constexpr (std::is_same_v<T, double>) {
+        p.writeDoubleVector(v);
     } else {
         static_assert(dependent_false_v<V<T>>);
     }
@@ -53,6 +57,10 @@ void readVector(android::Parcel &p, V<T, Args...> *v) {
         p.readInt32Vector(v);
     } else if constexpr (std::is_same_v<T, int64_t>) {
         p.readInt64Vector(v);
+    } else if constexpr (std::is_same_v<T, float>) {
+        p.readFloatVector(v);
+    } else if constexpr (std::is_same_v<T, double>) {
+        p.readDoubleVector(v);
     } else {
         static_assert(dependent_false_v<V<T>>);
     }
@@ -169,4 +177,74 @@ BENCHMARK(BM_CharVector)->Apply(VectorArgs);
 BENCHMARK(BM_Int32Vector)->Apply(VectorArgs);
 BENCHMARK(BM_Int64Vector)->Apply(VectorArgs);
 
+// Construct a series of args { 1 << 4, 1 << 6, ..., 1 << 16 }
+static void LargeVectorArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 4; i <= 16; i += 2) {
+        b->Args({1 << i});
+    }
+}
+
+/*
+  Large vectors of the primitive types, as sent with sensor batches, audio
+  buffers or bitmaps. The packed types are copied with a single memcpy, and
+  bool and char16_t, which are sent as int32_t, are converted in a single pass
+  over space reserved once, so every type should scale linearly without a
+  per-element write call.
+*/
+static void BM_FloatVector(benchmark::State& state) {
+    BM_ParcelVector<float>(state);
+}
+
+static void BM_DoubleVector(benchmark::State& state) {
+    BM_ParcelVector<double>(state);
+}
+
+BENCHMARK(BM_BoolVector)->Apply(LargeVectorArgs)->Complexity();
+BENCHMARK(BM_CharVector)->Apply(LargeVectorArgs)->Complexity();
+BENCHMARK(BM_Int32Vector)->Apply(LargeVectorArgs)->Complexity();
+BENCHMARK(BM_Int64Vector)->Apply(LargeVectorArgs)->Complexity();
+BENCHMARK(BM_FloatVector)->Apply(LargeVectorArgs)->Complexity();
+BENCHMARK(BM_DoubleVector)->Apply(LargeVectorArgs)->Complexity();
+
+// Fixed-size arrays, which do not go through the vector paths.
+template <typename T, size_t N>
+static void BM_ParcelFixedArray(benchmark::State& state) {
+    std::array<T, N> a1{};
+    std::array<T, N> a2{};
+    android::Parcel p;
+    while (state.KeepRunning()) {
+        p.setDataPosition(0);
+        p.writeFixedArray(a1);
+
+        p.setDataPosition(0);
+        p.readFixedArray(&a2);
+
+        benchmark::DoNotOptimize(a2[0]);
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_ParcelFixedArray, bool, 1024);
+BENCHMARK_TEMPLATE(BM_ParcelFixedArray, char16_t, 1024);
+BENCHMARK_TEMPLATE(BM_ParcelFixedArray, int32_t, 1024);
+
+/*
+  A Parcel created, filled and destroyed per iteration, like the data and
+  reply Parcels of a transaction. Once the buffer pool of the thread is warm,
+  payloads of up to 16KB are written without going through malloc, so the cost
+  of a 1KB payload stays close to that of a 16B one. The 32KB payload is not
+  pooled, and shows the cost of malloc and realloc.
+*/
+static void BM_ParcelLifetime(benchmark::State& state) {
+    const std::vector<uint8_t> payload(state.range(0));
+    while (state.KeepRunning()) {
+        android::Parcel p;
+        p.writeInt32(0);
+        p.writeByteVector(payload);
+        benchmark::DoNotOptimize(p.data());
+    }
+}
+
+BENCHMARK(BM_ParcelLifetime)->Arg(16)->Arg(256)->Arg(1024)->Arg(4096)->Arg(32768);
+
 BENCHMARK_MAIN();
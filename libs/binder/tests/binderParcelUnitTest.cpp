@@ -20,6 +20,10 @@
 #include <cutils/ashmem.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <cstring>
+#include <vector>
+
 using android::BBinder;
 using android::IBinder;
 using android::IPCThreadState;
@@ -200,6 +204,50 @@ TEST_READ_WRITE_INVERSE(int8_t, Byte, {-1, 0, 1});
 TEST_READ_WRITE_INVERSE(String8, String8, {String8(), String8("a"), String8("asdf")});
 TEST_READ_WRITE_INVERSE(String16, String16, {String16(), String16("a"), String16("asdf")});
 
+// Bulk array writes must keep the wire format of writing the elements one by one.
+TEST(Parcel, FixedArrayBulkWireFormat) {
+    const std::array<bool, 3> bools = {true, false, true};
+    const std::array<char16_t, 3> chars = {u'a', u'\0', u'\xffff'};
+
+    Parcel bulk;
+    ASSERT_EQ(OK, bulk.writeFixedArray(bools));
+    ASSERT_EQ(OK, bulk.writeFixedArray(chars));
+
+    Parcel single;
+    single.writeInt32(static_cast<int32_t>(bools.size()));
+    for (bool b : bools) single.writeBool(b);
+    single.writeInt32(static_cast<int32_t>(chars.size()));
+    for (char16_t c : chars) single.writeChar(c);
+
+    ASSERT_EQ(single.dataSize(), bulk.dataSize());
+    EXPECT_EQ(0, memcmp(single.data(), bulk.data(), bulk.dataSize()));
+
+    bulk.setDataPosition(0);
+    std::array<bool, 3> outBools;
+    std::array<char16_t, 3> outChars;
+    EXPECT_EQ(OK, bulk.readFixedArray(&outBools));
+    EXPECT_EQ(OK, bulk.readFixedArray(&outChars));
+    EXPECT_EQ(bools, outBools);
+    EXPECT_EQ(chars, outChars);
+}
+
+TEST(Parcel, Int64EnumVectorWireFormat) {
+    enum class LongEnum : int64_t { A = -1, B = 1ll << 40 };
+    const std::vector<LongEnum> enums = {LongEnum::A, LongEnum::B};
+
+    Parcel bulk;
+    ASSERT_EQ(OK, bulk.writeEnumVector(enums));
+    Parcel single;
+    ASSERT_EQ(OK, single.writeInt64Vector(std::vector<int64_t>{-1, 1ll << 40}));
+    ASSERT_EQ(single.dataSize(), bulk.dataSize());
+    EXPECT_EQ(0, memcmp(single.data(), bulk.data(), bulk.dataSize()));
+
+    bulk.setDataPosition(0);
+    std::vector<LongEnum> out;
+    EXPECT_EQ(OK, bulk.readEnumVector(&out));
+    EXPECT_EQ(enums, out);
+}
+
 TEST(Parcel, GetOpenAshmemSize) {
     constexpr size_t kSize = 1024;
     constexpr size_t kCount = 3;
@@ -22,6 +22,7 @@ using android::Parcel;
 using android::status_t;
 using android::base::unique_fd;
 using android::binder::debug::RecordedTransaction;
+using android::binder::debug::RecordedTransactionFile;
 
 TEST(BinderRecordedTransaction, RoundTripEncoding) {
     android::String16 interfaceName("SampleInterface");
@@ -138,3 +139,52 @@ TEST(BinderRecordedTransaction, PayloadsExceedPageBoundaries) {
         EXPECT_EQ(retrievedTransaction->getReplyParcel().readInt32(), 99);
     }
 }
+
+TEST(BinderRecordedTransaction, IndexedFile) {
+    Parcel d;
+    d.writeInt32(12);
+    Parcel r;
+    r.writeInt32(99);
+
+    auto file = std::tmpfile();
+    auto fd = unique_fd(fcntl(fileno(file), F_DUPFD, 1));
+
+    for (uint32_t code = 0; code < 4; code++) {
+        android::String16 interfaceName(code % 2 == 0 ? "EvenInterface" : "OddInterface");
+        timespec ts = {static_cast<time_t>(1000 + code), 0};
+        auto transaction = RecordedTransaction::fromDetails(interfaceName, code, 0, ts, d, r, 0);
+        ASSERT_TRUE(transaction.has_value());
+        ASSERT_EQ(android::NO_ERROR, transaction->dumpToFile(fd));
+    }
+    // A transaction which is still being recorded is left out.
+    uint64_t partialChunk = 1;
+    write(fd.get(), &partialChunk, sizeof(partialChunk));
+
+    auto recording = RecordedTransactionFile::fromFile(fd);
+    ASSERT_TRUE(recording.has_value());
+    ASSERT_EQ(recording->size(), 4);
+    EXPECT_EQ(recording->getIndex()[1].interfaceName, "OddInterface");
+    EXPECT_EQ(recording->getIndex()[1].code, 1);
+    EXPECT_EQ(recording->getIndex()[1].timestamp.tv_sec, 1001);
+
+    EXPECT_EQ(recording->findTransactions("OddInterface"), (std::vector<size_t>{1, 3}));
+    EXPECT_EQ(recording->findTransactions("EvenInterface", 2), (std::vector<size_t>{2}));
+    EXPECT_EQ(recording->seek({1002, 0}), 2);
+    EXPECT_EQ(recording->seek({2000, 0}), 4);
+
+    auto transaction = recording->getTransaction(3);
+    ASSERT_TRUE(transaction.has_value());
+    EXPECT_EQ(transaction->getInterfaceName(), "OddInterface");
+    EXPECT_EQ(transaction->getCode(), 3);
+    EXPECT_EQ(transaction->getDataParcel().readInt32(), 12);
+    EXPECT_EQ(transaction->getReplyParcel().readInt32(), 99);
+    EXPECT_FALSE(recording->getTransaction(4).has_value());
+
+    // The checksums are checked when the transaction is read.
+    uint32_t badData = 0xffffffff;
+    pwrite(fd.get(), &badData, sizeof(badData), recording->getIndex()[2].offset + 9);
+    recording = RecordedTransactionFile::fromFile(fd);
+    ASSERT_TRUE(recording.has_value());
+    EXPECT_FALSE(recording->getTransaction(2).has_value());
+    EXPECT_TRUE(recording->getTransaction(3).has_value());
+}
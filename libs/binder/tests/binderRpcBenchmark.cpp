@@ -80,6 +80,10 @@ enum Transport {
     KERNEL,
     RPC,
     RPC_TLS,
+    RPC_MULTIPLEXED,
+    RPC_TLS_MULTIPLEXED,
+    RPC_SHARED_MEMORY,
+    RPC_EVENT_LOOP,
 };
 
 static const std::initializer_list<int64_t> kTransportList = {
@@ -88,8 +92,21 @@ static const std::initializer_list<int64_t> kTransportList = {
 #endif
         Transport::RPC,
         Transport::RPC_TLS,
+        Transport::RPC_MULTIPLEXED,
+        Transport::RPC_TLS_MULTIPLEXED,
+        Transport::RPC_SHARED_MEMORY,
+        Transport::RPC_EVENT_LOOP,
 };
 
+// Parcel data of at least this many bytes is sent in shared memory by RPC_SHARED_MEMORY.
+static constexpr size_t kSharedMemoryDataThreshold = 4096;
+
+// The number of threads of the RPC servers, and so the number of client threads which can make
+// calls at the same time.
+static constexpr size_t kRpcServerThreads = 8;
+// The number of threads which serve all of the connections of the RPC_EVENT_LOOP server.
+static constexpr size_t kRpcEventLoopThreads = 2;
+
 std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls() {
     auto pkey = android::makeKeyPairForSelfSignedCert();
     CHECK_NE(pkey.get(), nullptr);
@@ -107,6 +124,15 @@ static sp<IBinder> gRpcBinder;
 // Skip certificate validation to simplify the setup process.
 static sp<RpcSession> gSessionTls = RpcSession::make(makeFactoryTls());
 static sp<IBinder> gRpcTlsBinder;
+// The same servers, with sessions which carry the calls of all the threads on one connection.
+static sp<RpcSession> gSessionMultiplexed = RpcSession::make();
+static sp<IBinder> gRpcMultiplexedBinder;
+static sp<RpcSession> gSessionTlsMultiplexed = RpcSession::make(makeFactoryTls());
+static sp<IBinder> gRpcTlsMultiplexedBinder;
+static sp<RpcSession> gSessionSharedMemory = RpcSession::make();
+static sp<IBinder> gRpcSharedMemoryBinder;
+static sp<RpcSession> gSessionEventLoop = RpcSession::make();
+static sp<IBinder> gRpcEventLoopBinder;
 #ifdef __BIONIC__
 static const String16 kKernelBinderInstance = String16(u"binderRpcBenchmark-control");
 static sp<IBinder> gKernelBinder;
@@ -123,6 +149,14 @@ static sp<IBinder> getBinderForOptions(benchmark::State& state) {
             return gRpcBinder;
         case RPC_TLS:
             return gRpcTlsBinder;
+        case RPC_MULTIPLEXED:
+            return gRpcMultiplexedBinder;
+        case RPC_TLS_MULTIPLEXED:
+            return gRpcTlsMultiplexedBinder;
+        case RPC_SHARED_MEMORY:
+            return gRpcSharedMemoryBinder;
+        case RPC_EVENT_LOOP:
+            return gRpcEventLoopBinder;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
             return nullptr;
@@ -137,6 +171,11 @@ void BM_pingTransaction(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_pingTransaction)->ArgsProduct({kTransportList});
+// Calls from several threads at once, which use one connection each, unless multiplexed.
+BENCHMARK(BM_pingTransaction)
+        ->ArgsProduct({kTransportList})
+        ->ThreadRange(2, kRpcServerThreads)
+        ->UseRealTime();
 
 void BM_repeatTwoPageString(benchmark::State& state) {
     sp<IBinder> binder = getBinderForOptions(state);
@@ -186,6 +225,11 @@ void BM_throughputForTransportAndBytes(benchmark::State& state) {
 BENCHMARK(BM_throughputForTransportAndBytes)
         ->ArgsProduct({kTransportList,
                        {64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537}});
+// Only shared memory can carry Parcels larger than the buffer which RPC binder allocates on the
+// receiving side for each command.
+BENCHMARK(BM_throughputForTransportAndBytes)
+        ->ArgsProduct({{Transport::RPC_SHARED_MEMORY},
+                       {262144, 524288, 1048576, 2097152, 4194304}});
 
 void BM_repeatBinder(benchmark::State& state) {
     sp<IBinder> binder = getBinderForOptions(state);
@@ -204,17 +248,47 @@ void BM_repeatBinder(benchmark::State& state) {
 }
 BENCHMARK(BM_repeatBinder)->ArgsProduct({kTransportList});
 
-void forkRpcServer(const char* addr, const sp<RpcServer>& server) {
+static std::string gRpcAddr;
+static std::string gRpcTlsAddr;
+
+// Sets up a session with a connection for each server thread, and shuts it down. With TLS, the
+// connections after the first one resume its TLS session.
+void BM_sessionSetup(benchmark::State& state) {
+    Transport transport = static_cast<Transport>(state.range(0));
+    CHECK(transport == RPC || transport == RPC_TLS) << "Unsupported transport: " << transport;
+    const std::string& addr = transport == RPC_TLS ? gRpcTlsAddr : gRpcAddr;
+
+    while (state.KeepRunning()) {
+        // generating the key and the certificate of the client is not part of the setup
+        state.PauseTiming();
+        sp<RpcSession> session =
+                transport == RPC_TLS ? RpcSession::make(makeFactoryTls()) : RpcSession::make();
+        state.ResumeTiming();
+
+        CHECK_EQ(OK, session->setupUnixDomainClient(addr.c_str()));
+        CHECK(session->shutdownAndWait(true));
+    }
+}
+BENCHMARK(BM_sessionSetup)->ArgsProduct({{Transport::RPC, Transport::RPC_TLS}});
+
+void forkRpcServer(const char* addr, const sp<RpcServer>& server, size_t eventLoopThreads = 0) {
     if (0 == fork()) {
         prctl(PR_SET_PDEATHSIG, SIGHUP); // racey, okay
         server->setRootObject(sp<MyBinderRpcBenchmark>::make());
+        server->setMaxThreads(kRpcServerThreads);
+        server->setEventLoopThreads(eventLoopThreads);
+        server->setSupportedFileDescriptorTransportModes(
+                {RpcSession::FileDescriptorTransportMode::NONE,
+                 RpcSession::FileDescriptorTransportMode::UNIX});
+        server->setSharedMemoryDataThreshold(kSharedMemoryDataThreshold);
         CHECK_EQ(OK, server->setupUnixDomainServer(addr));
         server->join();
         exit(1);
     }
 }
 
-void setupClient(const sp<RpcSession>& session, const char* addr) {
+void setupClient(const sp<RpcSession>& session, const char* addr, bool multiplexed = false) {
+    session->setMultiplexed(multiplexed);
     status_t status;
     for (size_t tries = 0; tries < 5; tries++) {
         usleep(10000);
@@ -222,6 +296,7 @@ void setupClient(const sp<RpcSession>& session, const char* addr) {
         if (status == OK) break;
     }
     CHECK_EQ(status, OK) << "Could not connect: " << addr << ": " << statusToString(status).c_str();
+    CHECK_EQ(multiplexed, session->isMultiplexed());
 }
 
 int main(int argc, char** argv) {
@@ -232,6 +307,13 @@ int main(int argc, char** argv) {
     std::cerr << "\t.../" << Transport::KERNEL << " is KERNEL" << std::endl;
     std::cerr << "\t.../" << Transport::RPC << " is RPC" << std::endl;
     std::cerr << "\t.../" << Transport::RPC_TLS << " is RPC with TLS" << std::endl;
+    std::cerr << "\t.../" << Transport::RPC_MULTIPLEXED << " is RPC, multiplexed" << std::endl;
+    std::cerr << "\t.../" << Transport::RPC_TLS_MULTIPLEXED << " is RPC with TLS, multiplexed"
+              << std::endl;
+    std::cerr << "\t.../" << Transport::RPC_SHARED_MEMORY << " is RPC, large data in shared memory"
+              << std::endl;
+    std::cerr << "\t.../" << Transport::RPC_EVENT_LOOP << " is RPC, served by "
+              << kRpcEventLoopThreads << " event loop threads" << std::endl;
 
 #ifdef __BIONIC__
     if (0 == fork()) {
@@ -252,17 +334,33 @@ int main(int argc, char** argv) {
 
     std::string tmp = getenv("TMPDIR") ?: "/tmp";
 
-    std::string addr = tmp + "/binderRpcBenchmark";
-    (void)unlink(addr.c_str());
-    forkRpcServer(addr.c_str(), RpcServer::make(RpcTransportCtxFactoryRaw::make()));
-    setupClient(gSession, addr.c_str());
+    gRpcAddr = tmp + "/binderRpcBenchmark";
+    (void)unlink(gRpcAddr.c_str());
+    forkRpcServer(gRpcAddr.c_str(), RpcServer::make(RpcTransportCtxFactoryRaw::make()));
+    setupClient(gSession, gRpcAddr.c_str());
     gRpcBinder = gSession->getRootObject();
-
-    std::string tlsAddr = tmp + "/binderRpcTlsBenchmark";
-    (void)unlink(tlsAddr.c_str());
-    forkRpcServer(tlsAddr.c_str(), RpcServer::make(makeFactoryTls()));
-    setupClient(gSessionTls, tlsAddr.c_str());
+    setupClient(gSessionMultiplexed, gRpcAddr.c_str(), true /*multiplexed*/);
+    gRpcMultiplexedBinder = gSessionMultiplexed->getRootObject();
+    gSessionSharedMemory->setFileDescriptorTransportMode(
+            RpcSession::FileDescriptorTransportMode::UNIX);
+    gSessionSharedMemory->setSharedMemoryDataThreshold(kSharedMemoryDataThreshold);
+    setupClient(gSessionSharedMemory, gRpcAddr.c_str());
+    gRpcSharedMemoryBinder = gSessionSharedMemory->getRootObject();
+
+    std::string eventLoopAddr = tmp + "/binderRpcEventLoopBenchmark";
+    (void)unlink(eventLoopAddr.c_str());
+    forkRpcServer(eventLoopAddr.c_str(), RpcServer::make(RpcTransportCtxFactoryRaw::make()),
+                  kRpcEventLoopThreads);
+    setupClient(gSessionEventLoop, eventLoopAddr.c_str());
+    gRpcEventLoopBinder = gSessionEventLoop->getRootObject();
+
+    gRpcTlsAddr = tmp + "/binderRpcTlsBenchmark";
+    (void)unlink(gRpcTlsAddr.c_str());
+    forkRpcServer(gRpcTlsAddr.c_str(), RpcServer::make(makeFactoryTls()));
+    setupClient(gSessionTls, gRpcTlsAddr.c_str());
     gRpcTlsBinder = gSessionTls->getRootObject();
+    setupClient(gSessionTlsMultiplexed, gRpcTlsAddr.c_str(), true /*multiplexed*/);
+    gRpcTlsMultiplexedBinder = gSessionTlsMultiplexed->getRootObject();
 
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
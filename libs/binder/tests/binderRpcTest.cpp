@@ -297,6 +297,9 @@ std::unique_ptr<ProcessSession> BinderRpc::createRpcTestSocketServerProcessEtc(
     serverConfig.vsockPort = allocateVsockPort();
     serverConfig.addr = addr;
     serverConfig.socketFd = socketFd.get();
+    serverConfig.sharedMemoryDataThreshold =
+            static_cast<int32_t>(options.sharedMemoryDataThreshold);
+    serverConfig.eventLoopThreads = static_cast<int32_t>(options.eventLoopThreads);
     for (auto mode : options.serverSupportedFileDescriptorTransportModes) {
         serverConfig.serverSupportedFileDescriptorTransportModes.push_back(
                 static_cast<int32_t>(mode));
@@ -357,6 +360,8 @@ std::unique_ptr<ProcessSession> BinderRpc::createRpcTestSocketServerProcessEtc(
         session->setMaxIncomingThreads(numIncoming);
         session->setMaxOutgoingConnections(options.numOutgoingConnections);
         session->setFileDescriptorTransportMode(options.clientFileDescriptorTransportMode);
+        session->setMultiplexed(options.multiplexed);
+        session->setSharedMemoryDataThreshold(options.sharedMemoryDataThreshold);
 
         switch (socketType) {
             case SocketType::PRECONNECTED:
@@ -493,6 +498,126 @@ TEST_P(BinderRpc, ThreadPoolLimitOutgoing) {
     testThreadPoolOverSaturated(proc.rootIface, kNumCalls, 500 /*ms*/);
 }
 
+TEST_P(BinderRpc, MultiplexedThreadPoolOverSaturated) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumThreads = 10;
+    constexpr size_t kNumCalls = kNumThreads + 3;
+    auto proc = createRpcTestSocketServerProcess({.numThreads = kNumThreads, .multiplexed = true});
+    EXPECT_EQ(std::min(clientVersion(), serverVersion()) >=
+                      RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_MULTIPLEXED,
+              proc.proc->sessions.at(0).session->isMultiplexed());
+
+    // the calls of all the threads share a connection, but still run in parallel on the server
+    testThreadPoolOverSaturated(proc.rootIface, kNumCalls, 500 /*ms*/);
+
+    // also waits for the thread receiving the replies
+    proc.forceShutdown();
+}
+
+TEST_P(BinderRpc, MultiplexedThreadingStressTest) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumClientThreads = 10;
+    constexpr size_t kNumServerThreads = 5;
+    constexpr size_t kNumCalls = 50;
+
+    auto proc = createRpcTestSocketServerProcess(
+            {.numThreads = kNumServerThreads, .multiplexed = true});
+
+    // interleave synchronous calls, which send binders back and forth, and oneway calls
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kNumClientThreads; i++) {
+        threads.push_back(std::thread([&] {
+            for (size_t j = 0; j < kNumCalls; j++) {
+                sp<IBinder> out;
+                EXPECT_OK(proc.rootIface->repeatBinder(proc.rootBinder, &out));
+                EXPECT_EQ(proc.rootBinder, out);
+                EXPECT_OK(proc.rootIface->sendString("a"));
+            }
+        }));
+    }
+
+    for (auto& t : threads) t.join();
+
+    proc.forceShutdown();
+}
+
+TEST_P(BinderRpc, MultiplexedNestedCallsUseIncomingConnections) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    auto proc = createRpcTestSocketServerProcess({.numThreads = 2,
+                                                  .numIncomingConnectionsBySession = {1},
+                                                  .multiplexed = true});
+
+    auto nastyNester = sp<MyBinderRpcTestDefault>::make();
+    EXPECT_OK(proc.rootIface->nestMe(nastyNester, 10));
+
+    proc.forceShutdown();
+}
+
+TEST_P(BinderRpc, EventLoopThreadPoolOverSaturated) {
+    if (clientOrServerSingleThreaded() || socketType() == SocketType::TIPC) {
+        GTEST_SKIP() << "This test requires an event loop on the server";
+    }
+
+    constexpr size_t kNumThreads = 10;
+    constexpr size_t kNumCalls = kNumThreads + 3;
+    auto proc = createRpcTestSocketServerProcess(
+            {.numThreads = kNumThreads, .eventLoopThreads = kNumThreads});
+
+    testThreadPoolOverSaturated(proc.rootIface, kNumCalls, 500 /*ms*/);
+}
+
+TEST_P(BinderRpc, EventLoopServesMoreConnectionsThanThreads) {
+    if (clientOrServerSingleThreaded() || socketType() == SocketType::TIPC) {
+        GTEST_SKIP() << "This test requires an event loop on the server";
+    }
+
+    constexpr size_t kNumSessions = 4;
+    constexpr size_t kNumConnections = 3;
+    constexpr size_t kNumCalls = 20;
+    auto proc = createRpcTestSocketServerProcess({.numThreads = kNumConnections,
+                                                  .numSessions = kNumSessions,
+                                                  .eventLoopThreads = 2});
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kNumSessions; i++) {
+        auto iface = interface_cast<IBinderRpcTest>(proc.proc->sessions.at(i).root);
+        for (size_t j = 0; j < kNumConnections; j++) {
+            threads.push_back(std::thread([=] {
+                for (size_t k = 0; k < kNumCalls; k++) {
+                    sp<IBinder> out;
+                    EXPECT_OK(iface->repeatBinder(IInterface::asBinder(iface), &out));
+                    EXPECT_EQ(IInterface::asBinder(iface), out);
+                }
+            }));
+        }
+    }
+    for (auto& t : threads) t.join();
+}
+
+TEST_P(BinderRpc, EventLoopNestedCalls) {
+    if (clientOrServerSingleThreaded() || socketType() == SocketType::TIPC) {
+        GTEST_SKIP() << "This test requires an event loop on the server";
+    }
+
+    auto proc = createRpcTestSocketServerProcess({.numThreads = 2,
+                                                  .numIncomingConnectionsBySession = {1},
+                                                  .eventLoopThreads = 1});
+
+    // the nested calls back into the server are executed by the thread of the event loop which
+    // is waiting for them
+    auto nastyNester = sp<MyBinderRpcTestDefault>::make();
+    EXPECT_OK(proc.rootIface->nestMe(nastyNester, 10));
+}
+
 TEST_P(BinderRpc, ThreadingStressTest) {
     if (clientOrServerSingleThreaded()) {
         GTEST_SKIP() << "This test requires multiple threads";
@@ -1019,6 +1144,33 @@ TEST_P(BinderRpc, SendTooManyFiles) {
     EXPECT_EQ(status.transactionError(), BAD_VALUE) << status;
 }
 
+TEST_P(BinderRpc, LargeParcelsInSharedMemory) {
+    if (!supportsFdTransport()) {
+        GTEST_SKIP() << "Shared memory is sent as a file descriptor";
+    }
+    if (std::min(clientVersion(), serverVersion()) <
+        RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_SHARED_MEMORY_DATA) {
+        GTEST_SKIP() << "Shared memory Parcel data is not supported by this protocol version";
+    }
+
+    auto proc = createRpcTestSocketServerProcess({
+            .clientFileDescriptorTransportMode = RpcSession::FileDescriptorTransportMode::UNIX,
+            .serverSupportedFileDescriptorTransportModes =
+                    {RpcSession::FileDescriptorTransportMode::UNIX},
+            .sharedMemoryDataThreshold = 4096,
+    });
+
+    // both are larger than a command body may be, so they can only be sent in shared memory
+    std::string str(512 * 1024, 'a');
+    std::string out;
+    EXPECT_OK(proc.rootIface->doubleString(str, &out));
+    EXPECT_EQ(str + str, out);
+
+    // smaller data is still sent in the body
+    EXPECT_OK(proc.rootIface->doubleString("cool ", &out));
+    EXPECT_EQ("cool cool ", out);
+}
+
 TEST_P(BinderRpc, AppendInvalidFd) {
     if (socketType() == SocketType::TIPC) {
         GTEST_SKIP() << "File descriptor tests not supported on Trusty (yet)";
@@ -1742,6 +1894,22 @@ TEST_P(RpcTransportTest, MultipleClients) {
     for (auto& client : clients) client.run();
 }
 
+TEST_P(RpcTransportTest, ReconnectingClient) {
+    auto server = std::make_unique<Server>();
+    ASSERT_TRUE(server->setUp(GetParam()));
+
+    Client client(server->getConnectToServerFn());
+    ASSERT_TRUE(client.setUp(GetParam()));
+
+    ASSERT_EQ(OK, trust(&client, server));
+    ASSERT_EQ(OK, trust(server, &client));
+
+    server->start();
+    // with TLS, the later connections resume the session of an earlier one, whose ticket the
+    // client read with the message
+    for (int i = 0; i < 3; i++) client.run();
+}
+
 TEST_P(RpcTransportTest, UntrustedServer) {
     auto [socketType, rpcSecurity, certificateFormat, serverVersion] = GetParam();
     (void)serverVersion;
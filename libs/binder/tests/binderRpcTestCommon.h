@@ -141,6 +141,12 @@ struct BinderRpcOptions {
     // If true, connection failures will result in `ProcessSession::sessions` being empty
     // instead of a fatal error.
     bool allowConnectFailure = false;
+    // See RpcSession::setMultiplexed.
+    bool multiplexed = false;
+    // See RpcSession::setSharedMemoryDataThreshold, for the client and the server.
+    size_t sharedMemoryDataThreshold = 0;
+    // See RpcServer::setEventLoopThreads.
+    size_t eventLoopThreads = 0;
 };
 
 #ifndef __TRUSTY__
@@ -120,6 +120,10 @@ int main(int argc, char* argv[]) {
 
     server->setProtocolVersion(serverConfig.serverVersion);
     server->setMaxThreads(serverConfig.numThreads);
+    server->setSharedMemoryDataThreshold(serverConfig.sharedMemoryDataThreshold);
+    if (serverConfig.eventLoopThreads > 0) {
+        server->setEventLoopThreads(serverConfig.eventLoopThreads);
+    }
     server->setSupportedFileDescriptorTransportModes(serverSupportedFileDescriptorTransportModes);
 
     unsigned int outPort = 0;
@@ -241,11 +241,21 @@ TEST(RpcWire, V1) {
     checkRepr(kCurrentRepr, 1);
 }
 
+// Version 2 only changes multiplexed connections, so Parcels are the same.
+TEST(RpcWire, V2) {
+    checkRepr(kCurrentRepr, 2);
+}
+
+// Version 3 only moves large Parcel data out of the command body, so Parcels are the same.
+TEST(RpcWire, V3) {
+    checkRepr(kCurrentRepr, 3);
+}
+
 TEST(RpcWire, CurrentVersion) {
     checkRepr(kCurrentRepr, RPC_WIRE_PROTOCOL_VERSION);
 }
 
-static_assert(RPC_WIRE_PROTOCOL_VERSION == 1,
+static_assert(RPC_WIRE_PROTOCOL_VERSION == 3,
               "If the binder wire protocol is updated, this test should test additional versions. "
               "The binder wire protocol should only be updated on upstream AOSP.");
 
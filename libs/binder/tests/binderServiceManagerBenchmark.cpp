@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <binder/IServiceManager.h>
+#include <binder/ProcessState.h>
+#include <utils/Log.h>
+#include <utils/String8.h>
+
+#include <vector>
+
+// Usage: atest binderServiceManagerBenchmark
+
+using android::BBinder;
+using android::defaultServiceManager;
+using android::IBinder;
+using android::OK;
+using android::ProcessState;
+using android::sp;
+using android::String16;
+using android::String8;
+
+// The services which the benchmarks look up, as a starting process looks up the services it
+// uses.
+constexpr size_t kServiceCount = 16;
+static std::vector<String16> gServiceNames;
+static std::vector<sp<IBinder>> gServices;
+
+static std::vector<sp<IBinder>> lookUpServices() {
+    std::vector<sp<IBinder>> services;
+    services.reserve(gServiceNames.size());
+    for (const String16& name : gServiceNames) {
+        services.push_back(defaultServiceManager()->checkService(name));
+        LOG_ALWAYS_FATAL_IF(services.back() == nullptr, "Service %s not found",
+                            String8(name).c_str());
+    }
+    return services;
+}
+
+// Each of the services is looked up range(0) times while the process holds it, e.g. by the
+// different modules of a process which start up together.
+static void BM_lookUpHeldServices(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        std::vector<sp<IBinder>> held = lookUpServices();
+        for (int64_t i = 1; i < state.range(0); i++) {
+            benchmark::DoNotOptimize(lookUpServices());
+        }
+    }
+}
+BENCHMARK(BM_lookUpHeldServices)->Arg(1)->Arg(4)->Arg(16);
+
+// The services are dropped right after each lookup, so every lookup goes to servicemanager.
+static void BM_lookUpReleasedServices(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        for (int64_t i = 0; i < state.range(0); i++) {
+            benchmark::DoNotOptimize(lookUpServices());
+        }
+    }
+}
+BENCHMARK(BM_lookUpReleasedServices)->Arg(1)->Arg(4)->Arg(16);
+
+// Replays a boot storm: all the threads look up the services at the same time, as many processes
+// starting together, while the first thread registers one of them again, as a restarting service.
+// servicemanager serves the lookups of the different threads in parallel.
+static void BM_bootStorm(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        if (state.thread_index() == 0) {
+            LOG_ALWAYS_FATAL_IF(defaultServiceManager()->addService(gServiceNames[0],
+                                                                    gServices[0]) != OK,
+                                "Failed to add %s", String8(gServiceNames[0]).c_str());
+        }
+        benchmark::DoNotOptimize(lookUpServices());
+    }
+}
+BENCHMARK(BM_bootStorm)->ThreadRange(1, 16)->UseRealTime();
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    // The service cache is only used with a threadpool, which receives its notifications.
+    ProcessState::self()->startThreadPool();
+
+    for (size_t i = 0; i < kServiceCount; i++) {
+        String16 name(String8::format("binderServiceManagerBenchmark-%zu", i));
+        gServices.push_back(sp<BBinder>::make());
+        LOG_ALWAYS_FATAL_IF(defaultServiceManager()->addService(name, gServices.back()) != OK,
+                            "Failed to add %s", String8(name).c_str());
+        gServiceNames.push_back(name);
+    }
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
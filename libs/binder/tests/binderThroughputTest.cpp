@@ -8,6 +8,7 @@
 #include <cstdio>
 
 #include <iostream>
+#include <optional>
 #include <vector>
 #include <tuple>
 
@@ -103,6 +104,13 @@ public:
 static const uint32_t num_buckets = 128;
 static uint64_t max_time_bucket = 50ull * 1000000;
 static uint64_t time_per_bucket = max_time_bucket / num_buckets;
+// Send the payload as a buffer object, which the driver copies straight from
+// the memory of the client, instead of writing it into the Parcel.
+static bool use_buffer_object = false;
+// Send this many oneway transactions per iteration instead of a synchronous
+// one, and whether to batch them into a single ioctl.
+static int oneway_count = 0;
+static bool batch_oneway = false;
 
 struct ProcResults {
     uint64_t m_worst = 0;
@@ -176,6 +184,21 @@ String16 generateServiceName(int num)
     return serviceName;
 }
 
+static status_t send_oneway(const sp<IBinder>& target, const Parcel& data)
+{
+    optional<IPCThreadState::BatchScope> batch;
+    if (batch_oneway) {
+        batch.emplace();
+    }
+    for (int i = 0; i < oneway_count; i++) {
+        status_t ret = target->transact(BINDER_NOP, data, nullptr, IBinder::FLAG_ONEWAY);
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+    }
+    return batch ? batch->flush() : NO_ERROR;
+}
+
 void worker_fx(int num,
                int worker_count,
                int iterations,
@@ -210,17 +233,23 @@ void worker_fx(int num,
     // Run the benchmark if client
     ProcResults results;
     chrono::time_point<chrono::high_resolution_clock> start, end;
+    const vector<uint8_t> payload(use_buffer_object ? payload_size : 0);
     for (int i = 0; (!cs_pair || num >= server_count) && i < iterations; i++) {
         Parcel data, reply;
         int target = cs_pair ? num % server_count : rand() % workers.size();
         int sz = payload_size;
 
+        if (use_buffer_object) {
+            ASSERT_TRUE(data.writeBufferObject(payload.data(), payload.size()) == NO_ERROR);
+            sz = 0;
+        }
         while (sz >= sizeof(uint32_t)) {
             data.writeInt32(0);
             sz -= sizeof(uint32_t);
         }
         start = chrono::high_resolution_clock::now();
-        status_t ret = workers[target]->transact(BINDER_NOP, data, &reply);
+        status_t ret = oneway_count > 0 ? send_oneway(workers[target], data)
+                                        : workers[target]->transact(BINDER_NOP, data, &reply);
         end = chrono::high_resolution_clock::now();
 
         uint64_t cur_time = uint64_t(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
@@ -348,6 +377,9 @@ int main(int argc, char *argv[])
             cout << "\t-m N    : Specify expected max latency in microseconds." << endl;
             cout << "\t-p      : Split workers into client/server pairs." << endl;
             cout << "\t-s N    : Specify payload size." << endl;
+            cout << "\t-b      : Send the payload as a buffer object." << endl;
+            cout << "\t-o N    : Send N oneway transactions per iteration." << endl;
+            cout << "\t-B      : Batch the oneway transactions into one ioctl." << endl;
             cout << "\t-t N    : Run training round." << endl;
             cout << "\t-w N    : Specify total number of workers." << endl;
             return 0;
@@ -366,6 +398,21 @@ int main(int argc, char *argv[])
             payload_size = atoi(argv[i+1]);
             i++;
         }
+        if (string(argv[i]) == "-b") {
+            // The driver copies the payload from the memory of the
+            // client into the server, rather than from the Parcel.
+            use_buffer_object = true;
+        }
+        if (string(argv[i]) == "-o") {
+            oneway_count = atoi(argv[i+1]);
+            i++;
+            continue;
+        }
+        if (string(argv[i]) == "-B") {
+            // The oneway transactions of an iteration are sent
+            // with a single ioctl, and completed together.
+            batch_oneway = true;
+        }
         if (string(argv[i]) == "-p") {
             // client/server pairs instead of spreading
             // requests to all workers. If true, half
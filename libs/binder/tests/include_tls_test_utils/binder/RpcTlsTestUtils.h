@@ -64,6 +64,8 @@ private:
 class RpcCertificateVerifierSimple : public RpcCertificateVerifier {
 public:
     status_t verify(const SSL*, uint8_t*) override;
+    // Trusted certificates are never removed.
+    bool canCacheAcceptedCertificates() const override { return true; }
 
     // Add a trusted peer certificate. Peers presenting this certificate are accepted.
     //
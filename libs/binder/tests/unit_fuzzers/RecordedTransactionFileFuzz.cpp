@@ -30,6 +30,13 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
 
     auto transaction = android::binder::debug::RecordedTransaction::fromFile(fd);
 
+    auto recording = android::binder::debug::RecordedTransactionFile::fromFile(fd);
+    if (recording.has_value()) {
+        for (size_t i = 0; i < recording->size(); i++) {
+            auto indexedTransaction ATTRIBUTE_UNUSED = recording->getTransaction(i);
+        }
+    }
+
     std::fclose(intermediateFile);
 
     if (transaction.has_value()) {
@@ -24,6 +24,7 @@
 #include <binder/RpcTransportTipcTrusty.h>
 
 #include "../OS.h"
+#include "../RpcEventLoop.h"
 #include "TrustyStatus.h"
 
 using android::base::Result;
@@ -73,4 +74,20 @@ ssize_t receiveMessageFromSocket(
     return -1;
 }
 
+status_t createSealedSharedMemory(const uint8_t* /* data */, size_t /* size */,
+                                  base::unique_fd* /* outFd */) {
+    return INVALID_OPERATION;
+}
+
+status_t mapSealedSharedMemory(base::borrowed_fd /* fd */, size_t /* size */,
+                               const uint8_t** /* outData */) {
+    return INVALID_OPERATION;
+}
+
+void unmapSharedMemory(const uint8_t* /* data */, size_t /* size */) {}
+
+std::unique_ptr<RpcEventLoop> makeRpcEventLoop(size_t /* threads */) {
+    return nullptr;
+}
+
 } // namespace android
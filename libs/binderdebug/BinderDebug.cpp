@@ -14,13 +14,18 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
-#include <android-base/parseint.h>
 #include <android-base/strings.h>
 #include <binder/Binder.h>
 #include <sys/types.h>
-#include <fstream>
-#include <regex>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 
 #include <binderdebug/BinderDebug.h>
 
@@ -39,164 +44,264 @@ static std::string contextToString(BinderDebugContext context) {
     }
 }
 
-static status_t scanBinderContext(pid_t pid, const std::string& contextName,
-                                  std::function<void(const std::string&)> eachLine) {
-    std::ifstream ifs("/dev/binderfs/binder_logs/proc/" + std::to_string(pid));
-    if (!ifs.is_open()) {
-        ifs.open("/d/binder/proc/" + std::to_string(pid));
-        if (!ifs.is_open()) {
-            return -errno;
-        }
+struct BinderDebugSnapshot::Process {
+    status_t status = OK;
+    BinderPidInfo info;
+    std::unordered_map<int32_t, int32_t> refToNode;                // desc -> node
+    std::unordered_map<int32_t, std::vector<pid_t>> nodeToPids;   // node -> client processes
+};
+
+namespace {
+
+using Process = BinderDebugSnapshot::Process;
+
+// At most this many threads read the processes of a prefetch.
+constexpr size_t kMaxReadThreads = 8;
+
+std::vector<std::string_view> tokenize(std::string_view line) {
+    std::vector<std::string_view> tokens;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t start = line.find_first_not_of(' ', pos);
+        if (start == std::string_view::npos) break;
+        size_t end = line.find(' ', start);
+        if (end == std::string_view::npos) end = line.size();
+        tokens.push_back(line.substr(start, end - start));
+        pos = end;
     }
+    return tokens;
+}
 
-    bool isDesiredContext = false;
-    std::string line;
-    while (getline(ifs, line)) {
-        if (base::StartsWith(line, "context")) {
-            isDesiredContext = base::Split(line, " ").back() == contextName;
-            continue;
-        }
-        if (!isDesiredContext) {
-            continue;
+template <typename T>
+bool parse(std::string_view token, T* out, int base = 10) {
+    const char* end = token.data() + token.size();
+    auto [ptr, ec] = std::from_chars(token.data(), end, *out, base);
+    return ec == std::errc() && ptr == end && !token.empty();
+}
+
+// The pids after "proc", at the end of a node line, up to the first one which can't be parsed.
+void parseNodePids(const std::vector<std::string_view>& tokens, std::vector<pid_t>* pids) {
+    auto proc = std::find(tokens.begin(), tokens.end(), "proc");
+    if (proc == tokens.end()) return;
+    for (auto it = proc + 1; it != tokens.end(); it++) {
+        pid_t pid;
+        if (!parse(*it, &pid)) {
+            LOG(ERROR) << "Failed to parse pid int: " << *it;
+            return;
         }
-        eachLine(line);
+        pids->push_back(pid);
     }
-    return OK;
 }
 
 // Examples of what we are looking at:
 // node 66730: u00007590061890e0 c0000759036130950 pri 0:120 hs 1 hw 1 ls 0 lw 0 is 2 iw 2 tr 1 proc 2300 1790
-// thread 2999: l 00 need_return 1 tr 0
-status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
-    std::smatch match;
-    static const std::regex kReferencePrefix("^\\s*node \\d+:\\s+u([0-9a-f]+)\\s+c([0-9a-f]+)\\s+");
-    static const std::regex kThreadPrefix("^\\s*thread \\d+:\\s+l\\s+(\\d)(\\d)");
-    std::string contextStr = contextToString(context);
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
-        if (base::StartsWith(line, "  node")) {
-            std::vector<std::string> splitString = base::Tokenize(line, " ");
-            bool pids = false;
-            uint64_t ptr = 0;
-            for (const auto& token : splitString) {
-                if (base::StartsWith(token, "u")) {
-                    const std::string ptrString = "0x" + token.substr(1);
-                    if (!::android::base::ParseUint(ptrString.c_str(), &ptr)) {
-                        LOG(ERROR) << "Failed to parse pointer: " << ptrString;
-                        return;
-                    }
-                } else {
-                    // The last numbers in the line after "proc" are all client PIDs
-                    if (token == "proc") {
-                        pids = true;
-                    } else if (pids) {
-                        int32_t pid;
-                        if (!::android::base::ParseInt(token, &pid)) {
-                            LOG(ERROR) << "Failed to parse pid int: " << token;
-                            return;
-                        }
-                        if (ptr == 0) {
-                            LOG(ERROR) << "We failed to parse the pointer, so we can't add the refPids";
-                            return;
-                        }
-                        pidInfo->refPids[ptr].push_back(pid);
-                    }
-                }
-            }
-        } else if (base::StartsWith(line, "  thread")) {
-            auto pos = line.find("l ");
-            if (pos != std::string::npos) {
-                // "1" is waiting in binder driver
-                // "2" is poll. It's impossible to tell if these are in use.
-                //     and HIDL default code doesn't use it.
-                bool isInUse = line.at(pos + 2) != '1';
-                // "0" is a thread that has called into binder
-                // "1" is looper thread
-                // "2" is main looper thread
-                bool isBinderThread = line.at(pos + 3) != '0';
-                if (!isBinderThread) {
-                    return;
-                }
-                if (isInUse) {
-                    pidInfo->threadUsage++;
-                }
-
-                pidInfo->threadCount++;
-            }
-        }
-    });
-    return ret;
+void parseNode(std::string_view line, Process* process) {
+    std::vector<std::string_view> tokens = tokenize(line);
+    if (tokens.size() < 3 || tokens[1].back() != ':' || tokens[2].front() != 'u') {
+        LOG(ERROR) << "Failed to parse binder_logs node entry: " << line;
+        return;
+    }
+    int32_t node;
+    if (!parse(tokens[1].substr(0, tokens[1].size() - 1), &node)) {
+        LOG(ERROR) << "Failed to parse node int: " << tokens[1];
+        return;
+    }
+    uint64_t ptr;
+    if (!parse(tokens[2].substr(1), &ptr, 16)) {
+        LOG(ERROR) << "Failed to parse pointer: " << tokens[2];
+        return;
+    }
+
+    std::vector<pid_t> pids;
+    parseNodePids(tokens, &pids);
+    if (!pids.empty()) {
+        std::vector<pid_t>& refPids = process->info.refPids[ptr];
+        refPids.insert(refPids.end(), pids.begin(), pids.end());
+    }
+    process->nodeToPids[node] = std::move(pids);
 }
 
-// Examples of what we are looking at:
 // ref 52493: desc 910 node 52492 s 1 w 1 d 0000000000000000
-// node 29413: u00007803fc982e80 c000078042c982210 pri 0:139 hs 1 hw 1 ls 0 lw 0 is 2 iw 2 tr 1 proc 488 683
-status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servicePid,
-                             int32_t handle, std::vector<pid_t>* pids) {
-    std::smatch match;
-    static const std::regex kNodeNumber("^\\s+ref \\d+:\\s+desc\\s+(\\d+)\\s+node\\s+(\\d+).*");
-    std::string contextStr = contextToString(context);
+void parseRef(std::string_view line, Process* process) {
+    std::vector<std::string_view> tokens = tokenize(line);
+    if (tokens.size() < 6) {
+        LOG(ERROR) << "Failed to parse binder_logs ref entry: " << line;
+        return;
+    }
+    int32_t desc;
     int32_t node;
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
-        if (!base::StartsWith(line, "  ref")) return;
+    if (!parse(tokens[3], &desc) || !parse(tokens[5], &node)) {
+        LOG(ERROR) << "Failed to parse binder_logs ref entry: " << line;
+        return;
+    }
+    process->refToNode.insert_or_assign(desc, node);
+}
 
-        std::vector<std::string> splitString = base::Tokenize(line, " ");
-        if (splitString.size() < 12) {
-            LOG(ERROR) << "Failed to parse binder_logs ref entry. Expecting size greater than 11, but got: " << splitString.size();
-            return;
-        }
-        int32_t desc;
-        if (!::android::base::ParseInt(splitString[3].c_str(), &desc)) {
-            LOG(ERROR) << "Failed to parse desc int: " << splitString[3];
-            return;
+// thread 2999: l 00 need_return 1 tr 0
+void parseThread(std::string_view line, Process* process) {
+    auto pos = line.find("l ");
+    if (pos == std::string_view::npos || pos + 3 >= line.size()) return;
+
+    // "1" is waiting in binder driver
+    // "2" is poll. It's impossible to tell if these are in use.
+    //     and HIDL default code doesn't use it.
+    // "3" is poll and waiting in binder driver, e.g. the idle threads of an
+    //     adaptive thread pool once they stop polling.
+    bool isInUse = line[pos + 2] != '1' && line[pos + 2] != '3';
+    // "0" is a thread that has called into binder
+    // "1" is looper thread
+    // "2" is main looper thread
+    bool isBinderThread = line[pos + 3] != '0';
+    if (!isBinderThread) {
+        return;
+    }
+    if (isInUse) {
+        process->info.threadUsage++;
+    }
+    process->info.threadCount++;
+}
+
+void parseProcess(std::string_view content, const std::string& contextName, Process* process) {
+    bool isDesiredContext = false;
+    while (!content.empty()) {
+        size_t end = content.find('\n');
+        std::string_view line = content.substr(0, end);
+        content.remove_prefix(end == std::string_view::npos ? content.size() : end + 1);
+
+        if (base::StartsWith(line, "context")) {
+            isDesiredContext = line.substr(line.rfind(' ') + 1) == contextName;
+            continue;
         }
-        if (handle != desc) {
-            return;
+        if (!isDesiredContext) {
+            continue;
         }
-        if (!::android::base::ParseInt(splitString[5].c_str(), &node)) {
-            LOG(ERROR) << "Failed to parse node int: " << splitString[5];
-            return;
+        if (base::StartsWith(line, "  node")) {
+            parseNode(line, process);
+        } else if (base::StartsWith(line, "  ref")) {
+            parseRef(line, process);
+        } else if (base::StartsWith(line, "  thread")) {
+            parseThread(line, process);
         }
-        LOG(INFO) << "Parsed the node: " << node;
-    });
-    if (ret != OK) {
-        return ret;
     }
+}
 
-    ret = scanBinderContext(servicePid, contextStr, [&](const std::string& line) {
-        if (!base::StartsWith(line, "  node")) return;
+} // namespace
 
-        std::vector<std::string> splitString = base::Tokenize(line, " ");
-        if (splitString.size() < 21) {
-            LOG(ERROR) << "Failed to parse binder_logs node entry. Expecting size greater than 20, but got: " << splitString.size();
-            return;
-        }
+BinderDebugSnapshot::BinderDebugSnapshot(BinderDebugContext context)
+      : BinderDebugSnapshot(context, std::string()) {}
 
-        // remove the colon
-        const std::string nodeString = splitString[1].substr(0, splitString[1].size() - 1);
-        int32_t matchedNode;
-        if (!::android::base::ParseInt(nodeString.c_str(), &matchedNode)) {
-            LOG(ERROR) << "Failed to parse node int: " << nodeString;
-            return;
-        }
+BinderDebugSnapshot::BinderDebugSnapshot(BinderDebugContext context, std::string procDir)
+      : mContextName(contextToString(context)), mProcDir(std::move(procDir)) {}
 
-        if (node != matchedNode) {
-            return;
+BinderDebugSnapshot::~BinderDebugSnapshot() = default;
+
+std::shared_ptr<const BinderDebugSnapshot::Process> BinderDebugSnapshot::readProcess(
+        pid_t pid) const {
+    auto process = std::make_shared<Process>();
+
+    std::string content;
+    bool read;
+    if (!mProcDir.empty()) {
+        read = base::ReadFileToString(mProcDir + "/" + std::to_string(pid), &content);
+    } else {
+        read = base::ReadFileToString("/dev/binderfs/binder_logs/proc/" + std::to_string(pid),
+                                      &content) ||
+                base::ReadFileToString("/d/binder/proc/" + std::to_string(pid), &content);
+    }
+    if (!read) {
+        process->status = -errno;
+        return process;
+    }
+
+    parseProcess(content, mContextName, process.get());
+    return process;
+}
+
+std::shared_ptr<const BinderDebugSnapshot::Process> BinderDebugSnapshot::getProcess(pid_t pid) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (auto it = mProcesses.find(pid); it != mProcesses.end()) return it->second;
+    }
+    // Another thread may read it at the same time, and then the first one is kept.
+    std::shared_ptr<const Process> process = readProcess(pid);
+    std::lock_guard<std::mutex> lock(mLock);
+    return mProcesses.try_emplace(pid, std::move(process)).first->second;
+}
+
+void BinderDebugSnapshot::prefetch(const std::vector<pid_t>& pids) {
+    std::vector<pid_t> toRead;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (pid_t pid : pids) {
+            if (mProcesses.count(pid) == 0) toRead.push_back(pid);
         }
-        bool pidsSection = false;
-        for (const auto& token : splitString) {
-            if (token == "proc") {
-                pidsSection = true;
-            } else if (pidsSection == true) {
-                int32_t pid;
-                if (!::android::base::ParseInt(token.c_str(), &pid)) {
-                    LOG(ERROR) << "Failed to parse PID int: " << token;
-                    return;
-                }
-                pids->push_back(pid);
-            }
+    }
+    std::sort(toRead.begin(), toRead.end());
+    toRead.erase(std::unique(toRead.begin(), toRead.end()), toRead.end());
+
+    std::vector<std::shared_ptr<const Process>> processes(toRead.size());
+    std::atomic<size_t> next = 0;
+    auto readNext = [&] {
+        for (size_t i = next++; i < toRead.size(); i = next++) {
+            processes[i] = readProcess(toRead[i]);
         }
-    });
-    return ret;
+    };
+    size_t threadCount = std::min<size_t>({std::max(std::thread::hardware_concurrency(), 1u),
+                                           kMaxReadThreads, toRead.size()});
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(readNext);
+    }
+    readNext();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    for (size_t i = 0; i < toRead.size(); i++) {
+        mProcesses.try_emplace(toRead[i], std::move(processes[i]));
+    }
+}
+
+status_t BinderDebugSnapshot::getBinderPidInfo(pid_t pid, BinderPidInfo* pidInfo) {
+    std::shared_ptr<const Process> process = getProcess(pid);
+    if (process->status != OK) {
+        return process->status;
+    }
+    *pidInfo = process->info;
+    return OK;
+}
+
+status_t BinderDebugSnapshot::getBinderClientPids(pid_t pid, pid_t servicePid, int32_t handle,
+                                                  std::vector<pid_t>* pids) {
+    prefetch({pid, servicePid});
+
+    std::shared_ptr<const Process> process = getProcess(pid);
+    if (process->status != OK) {
+        return process->status;
+    }
+    std::shared_ptr<const Process> service = getProcess(servicePid);
+    if (service->status != OK) {
+        return service->status;
+    }
+
+    auto ref = process->refToNode.find(handle);
+    if (ref == process->refToNode.end()) {
+        return OK;
+    }
+    if (auto node = service->nodeToPids.find(ref->second); node != service->nodeToPids.end()) {
+        pids->insert(pids->end(), node->second.begin(), node->second.end());
+    }
+    return OK;
+}
+
+status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
+    return BinderDebugSnapshot(context).getBinderPidInfo(pid, pidInfo);
+}
+
+status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servicePid,
+                             int32_t handle, std::vector<pid_t>* pids) {
+    return BinderDebugSnapshot(context).getBinderClientPids(pid, servicePid, handle, pids);
 }
 
 } // namespace  android
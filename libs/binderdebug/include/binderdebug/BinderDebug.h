@@ -18,14 +18,17 @@
 #include <utils/Errors.h>
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace android {
 
 struct BinderPidInfo {
     std::map<uint64_t, std::vector<pid_t>> refPids; // cookie -> processes which hold binder
-    uint32_t threadUsage;                           // number of threads in use
-    uint32_t threadCount;                           // number of threads total
+    uint32_t threadUsage = 0;                       // number of threads in use
+    uint32_t threadCount = 0;                       // number of threads total
 };
 
 enum class BinderDebugContext {
@@ -44,4 +47,42 @@ status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo*
 status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servicePid,
                              int32_t handle, std::vector<pid_t>* pids);
 
+/**
+ * The binder state of processes, to answer the queries above about many services at once, e.g.
+ * for all the services that dumpsys dumps. Each process is read and parsed from its binder_logs
+ * file once, when it is first queried or by prefetch, and then kept for the lifetime of the
+ * snapshot. The queries may be made from any thread.
+ */
+class BinderDebugSnapshot {
+public:
+    explicit BinderDebugSnapshot(BinderDebugContext context);
+    /**
+     * Reads the processes from procDir/<pid> instead, e.g. from a copy of the binder_logs of a
+     * device.
+     */
+    BinderDebugSnapshot(BinderDebugContext context, std::string procDir);
+    ~BinderDebugSnapshot();
+
+    /**
+     * Reads the processes which weren't read yet, on several threads.
+     */
+    void prefetch(const std::vector<pid_t>& pids);
+
+    status_t getBinderPidInfo(pid_t pid, BinderPidInfo* pidInfo);
+    status_t getBinderClientPids(pid_t pid, pid_t servicePid, int32_t handle,
+                                 std::vector<pid_t>* pids);
+
+    // What was parsed from the file of a process.
+    struct Process;
+
+private:
+    std::shared_ptr<const Process> getProcess(pid_t pid);
+    std::shared_ptr<const Process> readProcess(pid_t pid) const;
+
+    const std::string mContextName;
+    const std::string mProcDir;
+    std::mutex mLock;
+    std::map<pid_t, std::shared_ptr<const Process>> mProcesses;
+};
+
 } // namespace  android
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+#include <binderdebug/BinderDebug.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Usage: atest libbinderdebug_benchmark
+
+using android::BinderDebugContext;
+using android::BinderDebugSnapshot;
+using android::BinderPidInfo;
+using android::OK;
+using android::base::StringAppendF;
+
+// A synthetic binder_logs/proc tree, where each process serves a service to each of the
+// others, as the services that `dumpsys --pid --thread --clients` goes through.
+constexpr pid_t kFirstPid = 1000;
+constexpr size_t kProcessCount = 200;
+constexpr size_t kThreadsPerProcess = 16;
+static TemporaryDir* gProcDir;
+
+static void writeProcDir() {
+    gProcDir = new TemporaryDir();
+    for (size_t i = 0; i < kProcessCount; i++) {
+        const pid_t pid = kFirstPid + static_cast<pid_t>(i);
+        std::string content = android::base::StringPrintf("binder proc state:\nproc %d\n", pid);
+        content += "context binder\n";
+        for (size_t thread = 0; thread < kThreadsPerProcess; thread++) {
+            StringAppendF(&content, "  thread %zu: l %s need_return 0 tr 0\n", pid + thread,
+                          thread % 4 == 0 ? "02" : "12");
+        }
+        // node i of a process is referenced by the process i, as handle i
+        StringAppendF(&content,
+                      "  node %zu: u%016zx c%016zx pri 0:120 hs 1 hw 1 ls 0 lw 0 is %zu iw %zu "
+                      "tr 1 proc",
+                      i, i * 0x40, i * 0x80, kProcessCount, kProcessCount);
+        for (size_t client = 0; client < kProcessCount; client++) {
+            StringAppendF(&content, " %zu", kFirstPid + client);
+        }
+        content += "\n";
+        for (size_t ref = 0; ref < kProcessCount; ref++) {
+            StringAppendF(&content, "  ref %zu: desc %zu node %zu s 1 w 1 d 0000000000000000\n",
+                          ref + 10000, ref, ref);
+        }
+        content += "context hwbinder\n";
+        CHECK(android::base::WriteStringToFile(content,
+                                               std::string(gProcDir->path) + "/" +
+                                                       std::to_string(pid)));
+    }
+}
+
+// Queries the threads and the clients of the service of each process, as dumpsys does. Without
+// a shared snapshot, each query reads the files again, as getBinderPidInfo and
+// getBinderClientPids do.
+static void queryAll(BinderDebugSnapshot* shared) {
+    for (size_t i = 0; i < kProcessCount; i++) {
+        const pid_t pid = kFirstPid + static_cast<pid_t>(i);
+        std::optional<BinderDebugSnapshot> own;
+        auto snapshot = [&] {
+            if (shared != nullptr) return shared;
+            return &own.emplace(BinderDebugContext::BINDER, gProcDir->path);
+        };
+
+        BinderPidInfo info;
+        CHECK_EQ(OK, snapshot()->getBinderPidInfo(pid, &info));
+        std::vector<pid_t> pids;
+        CHECK_EQ(OK,
+                 snapshot()->getBinderClientPids(kFirstPid, pid, static_cast<int32_t>(i), &pids));
+        CHECK_EQ(kProcessCount, pids.size());
+    }
+}
+
+static void BM_snapshotPerQuery(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        queryAll(nullptr);
+    }
+}
+BENCHMARK(BM_snapshotPerQuery)->Unit(benchmark::kMillisecond);
+
+// The queries share a snapshot, which reads each file once.
+static void BM_sharedSnapshot(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        BinderDebugSnapshot snapshot(BinderDebugContext::BINDER, gProcDir->path);
+        queryAll(&snapshot);
+    }
+}
+BENCHMARK(BM_sharedSnapshot)->Unit(benchmark::kMillisecond);
+
+// The files are read in parallel before the queries.
+static void BM_prefetchedSnapshot(benchmark::State& state) {
+    std::vector<pid_t> pids;
+    for (size_t i = 0; i < kProcessCount; i++) {
+        pids.push_back(kFirstPid + static_cast<pid_t>(i));
+    }
+    while (state.KeepRunning()) {
+        BinderDebugSnapshot snapshot(BinderDebugContext::BINDER, gProcDir->path);
+        snapshot.prefetch(pids);
+        queryAll(&snapshot);
+    }
+}
+BENCHMARK(BM_prefetchedSnapshot)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    writeProcDir();
+    ::benchmark::RunSpecifiedBenchmarks();
+    delete gProcDir;
+    return 0;
+}
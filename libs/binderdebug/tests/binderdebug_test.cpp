@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <binder/Binder.h>
 #include <binder/IServiceManager.h>
 #include <binder/ProcessState.h>
@@ -60,6 +61,42 @@ TEST(BinderDebugTests, BinderThreads) {
     EXPECT_GE(pidInfo.threadCount, 1);
 }
 
+TEST(BinderDebugTests, SnapshotOfLogs) {
+    TemporaryDir dir;
+    ASSERT_TRUE(base::WriteStringToFile(
+            "binder proc state:\n"
+            "proc 100\n"
+            "context hwbinder\n"
+            "  thread 1: l 02 need_return 0 tr 0\n"
+            "context binder\n"
+            "  thread 101: l 02 need_return 0 tr 0\n"
+            "  thread 102: l 11 need_return 0 tr 0\n"
+            "  thread 103: l 00 need_return 0 tr 0\n"
+            "  node 66730: u00007590061890e0 c0000759036130950 pri 0:120 hs 1 hw 1 ls 0 lw 0 "
+            "is 2 iw 2 tr 1 proc 2300 1790\n",
+            std::string(dir.path) + "/100"));
+    ASSERT_TRUE(base::WriteStringToFile(
+            "context binder\n"
+            "  ref 52493: desc 910 node 66730 s 1 w 1 d 0000000000000000\n",
+            std::string(dir.path) + "/200"));
+
+    BinderDebugSnapshot snapshot(BinderDebugContext::BINDER, dir.path);
+    snapshot.prefetch({100, 200, 300});
+
+    BinderPidInfo pidInfo;
+    ASSERT_EQ(OK, snapshot.getBinderPidInfo(100, &pidInfo));
+    EXPECT_EQ(1u, pidInfo.threadUsage);
+    EXPECT_EQ(2u, pidInfo.threadCount);
+    EXPECT_EQ((std::map<uint64_t, std::vector<pid_t>>{{0x7590061890e0, {2300, 1790}}}),
+              pidInfo.refPids);
+
+    std::vector<pid_t> pids;
+    ASSERT_EQ(OK, snapshot.getBinderClientPids(200, 100, 910, &pids));
+    EXPECT_EQ((std::vector<pid_t>{2300, 1790}), pids);
+
+    EXPECT_NE(OK, snapshot.getBinderPidInfo(300, &pidInfo));
+}
+
 extern "C" {
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -22,8 +22,13 @@
 #include <dirent.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <linux/bpf.h>
+#include <string.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <mutex>
 #include <numeric>
 #include <optional>
@@ -54,6 +59,9 @@ static bool gTracking = false;
 static uint32_t gNPolicies = 0;
 static uint32_t gNCpus = 0;
 static std::vector<std::vector<uint32_t>> gPolicyFreqs;
+// The offset of the times of each policy in the times of a uid_cpu_freq_times_t.
+static std::vector<uint32_t> gPolicyFreqOffsets;
+static uint32_t gFreqCount = 0;
 static std::vector<std::vector<uint32_t>> gPolicyCpus;
 static std::vector<uint32_t> gCpuIndexMap;
 static std::set<uint32_t> gAllFreqs;
@@ -121,6 +129,8 @@ static bool initGlobals() {
         }
         if (freqs.empty()) return false;
         std::sort(freqs.begin(), freqs.end());
+        gPolicyFreqOffsets.emplace_back(gFreqCount);
+        gFreqCount += freqs.size();
         gPolicyFreqs.emplace_back(freqs);
 
         for (auto freq : freqs) gAllFreqs.insert(freq);
@@ -360,50 +370,132 @@ getUidsCpuFreqTimes() {
     return getUidsUpdatedCpuFreqTimes(nullptr);
 }
 
+// The number of entries of uid_time_in_state_map which are read by each BPF_MAP_LOOKUP_BATCH.
+static constexpr uint32_t LOOKUP_BATCH_SIZE = 128;
+// Internal to the kernel, but returned by the bpf syscall for the maps which have no batch ops.
+static constexpr int ENOTSUPP_KERNEL = 524;
+
+static int lookupMapBatch(int fd, const void *inBatch, void *outBatch, void *keys, void *values,
+                          uint32_t *count) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.batch.in_batch = reinterpret_cast<uintptr_t>(inBatch);
+    attr.batch.out_batch = reinterpret_cast<uintptr_t>(outBatch);
+    attr.batch.keys = reinterpret_cast<uintptr_t>(keys);
+    attr.batch.values = reinterpret_cast<uintptr_t>(values);
+    attr.batch.count = *count;
+    attr.batch.map_fd = fd;
+    int ret = syscall(__NR_bpf, BPF_MAP_LOOKUP_BATCH, &attr, sizeof(attr));
+    *count = attr.batch.count;
+    return ret;
+}
+
+// Calls fn(key, vals) for each entry of uid_time_in_state_map, reading the entries in batches when
+// the kernel supports it and one by one otherwise. Returns false on error, or if fn returns false.
+template <typename Fn>
+static bool forEachUidTimeInStateEntry(std::vector<uint8_t> *buffer, Fn fn) {
+    const size_t valsSize = gNCpus * sizeof(tis_val_t);
+    buffer->resize(LOOKUP_BATCH_SIZE * (sizeof(time_key_t) + valsSize));
+    auto keys = reinterpret_cast<time_key_t *>(buffer->data());
+    uint8_t *values = buffer->data() + LOOKUP_BATCH_SIZE * sizeof(time_key_t);
+
+    uint64_t inBatch, outBatch;
+    for (bool first = true;; first = false) {
+        uint32_t count = LOOKUP_BATCH_SIZE;
+        int ret = lookupMapBatch(gTisMapFd, first ? nullptr : &inBatch, &outBatch, keys, values,
+                                 &count);
+        if (ret && errno != ENOENT) {
+            // Kernels before 5.6 do not have the command.
+            if (first && (errno == EINVAL || errno == ENOTSUPP_KERNEL)) break;
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!fn(keys[i], reinterpret_cast<const tis_val_t *>(values + i * valsSize))) {
+                return false;
+            }
+        }
+        // ENOENT once the last entries were read.
+        if (ret) return true;
+        inBatch = outBatch;
+    }
+
+    auto vals = reinterpret_cast<tis_val_t *>(values);
+    time_key_t key, prevKey;
+    if (getFirstMapKey(gTisMapFd, &key)) return errno == ENOENT;
+    do {
+        if (findMapEntry(gTisMapFd, &key, vals)) return false;
+        if (!fn(key, vals)) return false;
+    } while (prevKey = key, !getNextMapKey(gTisMapFd, &prevKey, &key));
+    return errno == ENOENT;
+}
+
 // Retrieve the times in ns that each uid spent running at each CPU freq, excluding UIDs that have
 // not run since before lastUpdate.
 // Return format is the same as getUidsCpuFreqTimes()
 std::optional<std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>>>
 getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate) {
-    if (!gInitialized && !initGlobals()) return {};
-    time_key_t key, prevKey;
+    uid_cpu_freq_times_t times;
+    if (!getUidsUpdatedCpuFreqTimes(lastUpdate, &times)) return {};
+
     std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>> map;
-    if (getFirstMapKey(gTisMapFd, &key)) {
-        if (errno == ENOENT) return map;
-        return std::nullopt;
+    map.reserve(times.uids.size());
+    for (size_t i = 0; i < times.uids.size(); ++i) {
+        auto uidTimes = times.times.begin() + i * times.freqCount;
+        std::vector<std::vector<uint64_t>> policyTimes;
+        for (uint32_t j = 0; j < gNPolicies; ++j) {
+            auto begin = uidTimes + gPolicyFreqOffsets[j];
+            policyTimes.emplace_back(begin, begin + gPolicyFreqs[j].size());
+        }
+        map.emplace(times.uids[i], std::move(policyTimes));
     }
+    return map;
+}
 
-    std::vector<std::vector<uint64_t>> mapFormat;
-    for (const auto &freqList : gPolicyFreqs) mapFormat.emplace_back(freqList.size(), 0);
+// Retrieve the times in ns that each uid spent running at each CPU freq into times, reusing its
+// memory. Returns false on error.
+bool getUidsCpuFreqTimes(uid_cpu_freq_times_t *times) {
+    return getUidsUpdatedCpuFreqTimes(nullptr, times);
+}
+
+// Retrieve the times in ns that each uid spent running at each CPU freq into times, excluding UIDs
+// that have not run since before lastUpdate. Returns false on error.
+bool getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate, uid_cpu_freq_times_t *times) {
+    if (!gInitialized && !initGlobals()) return false;
+    times->freqCount = gFreqCount;
+    times->uids.clear();
+    times->times.clear();
+    times->uidIndices.clear();
 
     uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
-    std::vector<tis_val_t> vals(gNCpus);
-    do {
-        if (lastUpdate) {
-            auto uidUpdated = uidUpdatedSince(key.uid, *lastUpdate, &newLastUpdate);
-            if (!uidUpdated.has_value()) return {};
-            if (!*uidUpdated) continue;
+    auto addEntry = [&](const time_key_t &key, const tis_val_t *vals) {
+        auto it = times->uidIndices.find(key.uid);
+        if (it == times->uidIndices.end()) {
+            if (lastUpdate) {
+                auto uidUpdated = uidUpdatedSince(key.uid, *lastUpdate, &newLastUpdate);
+                if (!uidUpdated.has_value()) return false;
+                if (!*uidUpdated) return true;
+            }
+            it = times->uidIndices.emplace(key.uid, times->uids.size()).first;
+            times->uids.push_back(key.uid);
+            times->times.resize(times->times.size() + gFreqCount, 0);
         }
-        if (findMapEntry(gTisMapFd, &key, vals.data())) return {};
-        if (map.find(key.uid) == map.end()) map.emplace(key.uid, mapFormat);
 
-        auto offset = key.bucket * FREQS_PER_ENTRY;
-        auto nextOffset = (key.bucket + 1) * FREQS_PER_ENTRY;
+        uint64_t *uidTimes = times->times.data() + it->second * gFreqCount;
+        const uint32_t offset = key.bucket * FREQS_PER_ENTRY;
         for (uint32_t i = 0; i < gNPolicies; ++i) {
             if (offset >= gPolicyFreqs[i].size()) continue;
-            auto begin = map[key.uid][i].begin() + offset;
-            auto end = nextOffset < gPolicyFreqs[i].size() ? begin + FREQS_PER_ENTRY :
-                map[key.uid][i].end();
+            uint64_t *begin = uidTimes + gPolicyFreqOffsets[i] + offset;
+            const size_t count = std::min<size_t>(FREQS_PER_ENTRY, gPolicyFreqs[i].size() - offset);
             for (const auto &cpu : gPolicyCpus[i]) {
-                std::transform(begin, end, std::begin(vals[gCpuIndexMap[cpu]].ar), begin,
-                               std::plus<uint64_t>());
+                const uint64_t *cpuTimes = vals[gCpuIndexMap[cpu]].ar;
+                for (size_t j = 0; j < count; ++j) begin[j] += cpuTimes[j];
             }
         }
-        prevKey = key;
-    } while (prevKey = key, !getNextMapKey(gTisMapFd, &prevKey, &key));
-    if (errno != ENOENT) return {};
+        return true;
+    };
+    if (!forEachUidTimeInStateEntry(&times->entryBuffer, addEntry)) return false;
     if (lastUpdate && newLastUpdate > *lastUpdate) *lastUpdate = newLastUpdate;
-    return map;
+    return true;
 }
 
 static bool verifyConcurrentTimes(const concurrent_time_t &ct) {
@@ -32,6 +32,23 @@ std::optional<std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>>>
     getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate);
 std::optional<std::vector<std::vector<uint32_t>>> getCpuFreqs();
 
+// The times of all the uids in one contiguous array, which can be reused from one call to the next
+// so that polling the times of every uid does not allocate memory each time.
+struct uid_cpu_freq_times_t {
+    // The number of frequencies of all the clusters together.
+    uint32_t freqCount = 0;
+    std::vector<uint32_t> uids;
+    // The times of uids[i] are at times[i * freqCount] to times[(i + 1) * freqCount - 1], cluster
+    // by cluster in the order of getCpuFreqs().
+    std::vector<uint64_t> times;
+    // Memory for reading the map entries, which is reused as well.
+    std::unordered_map<uint32_t, uint32_t> uidIndices;
+    std::vector<uint8_t> entryBuffer;
+};
+
+bool getUidsCpuFreqTimes(uid_cpu_freq_times_t *times);
+bool getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate, uid_cpu_freq_times_t *times);
+
 struct concurrent_time_t {
     std::vector<uint64_t> active;
     std::vector<std::vector<uint64_t>> policy;
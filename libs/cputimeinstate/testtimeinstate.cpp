@@ -21,6 +21,7 @@
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <chrono>
 #include <numeric>
 #include <unordered_map>
 #include <vector>
@@ -206,6 +207,93 @@ TEST_F(TimeInStateTest, AllUidUpdatedTimeInState) {
     }
 }
 
+static void TestFlatTimesMatch(
+        const std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>> &map,
+        const uid_cpu_freq_times_t &flat) {
+    // Uids can start running between the reads.
+    ASSERT_GE(flat.uids.size(), map.size());
+    ASSERT_EQ(flat.times.size(), flat.uids.size() * flat.freqCount);
+    for (size_t i = 0; i < flat.uids.size(); ++i) {
+        auto it = map.find(flat.uids[i]);
+        if (it == map.end()) continue;
+        size_t offset = i * flat.freqCount;
+        for (const auto &policyTimes : it->second) {
+            for (auto time : policyTimes) {
+                // The times were read at different moments, so they can only have increased.
+                ASSERT_LE(time, flat.times[offset++]);
+            }
+        }
+        ASSERT_EQ(offset, (i + 1) * flat.freqCount);
+    }
+}
+
+TEST_F(TimeInStateTest, AllUidTimeInStateFlat) {
+    auto freqs = getCpuFreqs();
+    ASSERT_TRUE(freqs.has_value());
+    uint32_t freqCount = 0;
+    for (const auto &policyFreqs : *freqs) freqCount += policyFreqs.size();
+
+    uid_cpu_freq_times_t times;
+    for (int i = 0; i < 2; ++i) {
+        // The second read reuses the memory of the first one.
+        auto map = getUidsCpuFreqTimes();
+        ASSERT_TRUE(map.has_value());
+        ASSERT_TRUE(getUidsCpuFreqTimes(&times));
+        ASSERT_EQ(times.freqCount, freqCount);
+        ASSERT_FALSE(times.uids.empty());
+        ASSERT_NO_FATAL_FAILURE(TestFlatTimesMatch(*map, times));
+    }
+
+    uint64_t lastUpdate = 0;
+    ASSERT_TRUE(getUidsUpdatedCpuFreqTimes(&lastUpdate, &times));
+    ASSERT_FALSE(times.uids.empty());
+    ASSERT_NE(lastUpdate, (uint64_t)0);
+}
+
+TEST_F(TimeInStateTest, AllUidTimeInStateManyUids) {
+    constexpr uint32_t kFakeUidCount = 1000;
+    uint32_t firstFakeUid = 0;
+    {
+        auto times = getUidsCpuFreqTimes();
+        ASSERT_TRUE(times.has_value());
+        for (const auto &kv : *times) firstFakeUid = std::max(firstFakeUid, kv.first);
+        ++firstFakeUid;
+    }
+    {
+        // Add map entries for fake UIDs by copying a real map entry
+        android::base::unique_fd fd{
+                bpf_obj_get(BPF_FS_PATH "map_timeInState_uid_time_in_state_map")};
+        ASSERT_GE(fd, 0);
+        time_key_t k;
+        ASSERT_FALSE(getFirstMapKey(fd, &k));
+        std::vector<tis_val_t> vals(get_nprocs_conf());
+        ASSERT_FALSE(findMapEntry(fd, &k, vals.data()));
+        for (uint32_t i = 0; i < kFakeUidCount; ++i) {
+            k.uid = firstFakeUid + i;
+            ASSERT_FALSE(writeToMapEntry(fd, &k, vals.data(), BPF_NOEXIST));
+        }
+    }
+
+    constexpr int kReadCount = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kReadCount; ++i) ASSERT_TRUE(getUidsCpuFreqTimes().has_value());
+    auto mapDuration = std::chrono::steady_clock::now() - start;
+
+    uid_cpu_freq_times_t times;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kReadCount; ++i) ASSERT_TRUE(getUidsCpuFreqTimes(&times));
+    auto flatDuration = std::chrono::steady_clock::now() - start;
+    ASSERT_GE(times.uids.size(), kFakeUidCount);
+
+    using std::chrono::microseconds;
+    printf("Read the times of %zu uids in %lld us, or %lld us into a reused buffer\n",
+           times.uids.size(),
+           (long long)std::chrono::duration_cast<microseconds>(mapDuration).count() / kReadCount,
+           (long long)std::chrono::duration_cast<microseconds>(flatDuration).count() / kReadCount);
+
+    for (uint32_t i = 0; i < kFakeUidCount; ++i) ASSERT_TRUE(clearUidTimes(firstFakeUid + i));
+}
+
 TEST_F(TimeInStateTest, TotalAndAllUidTimeInStateConsistent) {
     auto allUid = getUidsCpuFreqTimes();
     auto total = getTotalCpuFreqTimes();
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ftl/flat_hash_map.h>
+#include <ftl/small_map.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace {
+
+// The maps are keyed like the layer maps of SurfaceFlinger, by sequence numbers that are mostly
+// consecutive, and map to a pointer-sized value.
+using Key = int32_t;
+using Value = std::unique_ptr<int>;
+
+using UnorderedMap = std::unordered_map<Key, Value>;
+using FlatHashMap = ftl::FlatHashMap<Key, Value>;
+using SmallMap = ftl::SmallMap<Key, Value, 16>;
+
+template <typename Map>
+bool contains(const Map& map, Key key) {
+  return map.find(key) != map.end();
+}
+
+template <typename Map>
+void emplace(Map& map, Key key) {
+  map.try_emplace(key, nullptr);
+}
+
+std::vector<Key> makeKeys(int64_t count, Key first) {
+  std::vector<Key> keys;
+  for (Key key = first; key < first + count; key++) {
+    keys.push_back(key * 3);
+  }
+  return keys;
+}
+
+template <typename Map>
+Map makeMap(const std::vector<Key>& keys) {
+  Map map;
+  for (const Key key : keys) {
+    emplace(map, key);
+  }
+  return map;
+}
+
+template <typename Map>
+void BM_LookupHit(benchmark::State& state) {
+  const auto keys = makeKeys(state.range(0), 0);
+  const auto map = makeMap<Map>(keys);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(contains(map, keys[i]));
+    i = i + 1 == keys.size() ? 0 : i + 1;
+  }
+}
+
+template <typename Map>
+void BM_LookupMiss(benchmark::State& state) {
+  const auto keys = makeKeys(state.range(0), 0);
+  const auto misses = makeKeys(state.range(0), Key(state.range(0)));
+  const auto map = makeMap<Map>(keys);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(contains(map, misses[i]));
+    i = i + 1 == misses.size() ? 0 : i + 1;
+  }
+}
+
+// Fills a map from empty, which includes the growth of the map.
+template <typename Map>
+void BM_Insert(benchmark::State& state) {
+  const auto keys = makeKeys(state.range(0), 0);
+  for (auto _ : state) {
+    auto map = makeMap<Map>(keys);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Moves every mapping to another map and back, like LayerHistory does when layers become active
+// or inactive.
+template <typename Map>
+void BM_Partition(benchmark::State& state) {
+  const auto keys = makeKeys(state.range(0), 0);
+  auto active = makeMap<Map>(keys);
+  Map inactive;
+  for (auto _ : state) {
+    for (auto it = active.begin(); it != active.end();) {
+      inactive.try_emplace(it->first, std::move(it->second));
+      it = active.erase(it);
+    }
+    std::swap(active, inactive);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define FTL_HASH_MAP_BENCHMARK(name)                                \
+  BENCHMARK_TEMPLATE(name, UnorderedMap)->Arg(8)->Arg(64)->Arg(512); \
+  BENCHMARK_TEMPLATE(name, FlatHashMap)->Arg(8)->Arg(64)->Arg(512)
+
+// SmallMap is only compared for the lookups, since its linear search does not scale.
+FTL_HASH_MAP_BENCHMARK(BM_LookupHit);
+BENCHMARK_TEMPLATE(BM_LookupHit, SmallMap)->Arg(8)->Arg(64);
+FTL_HASH_MAP_BENCHMARK(BM_LookupMiss);
+BENCHMARK_TEMPLATE(BM_LookupMiss, SmallMap)->Arg(8)->Arg(64);
+FTL_HASH_MAP_BENCHMARK(BM_Insert);
+FTL_HASH_MAP_BENCHMARK(BM_Partition);
+
+#undef FTL_HASH_MAP_BENCHMARK
+
+}  // namespace
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ftl/flat_hash_map.h>
+#include <ftl/unit.h>
+#include <gtest/gtest.h>
+
+#include <cctype>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+using namespace std::string_literals;
+
+namespace android::test {
+
+using ftl::FlatHashMap;
+
+// Keep in sync with example usage in header file.
+TEST(FlatHashMap, Example) {
+  ftl::FlatHashMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+
+  map = ftl::init::map<int, std::string>(123, "abc")(-1)(42, 3u, '?');
+  EXPECT_EQ(map.size(), 3u);
+
+  EXPECT_TRUE(map.contains(123));
+
+  EXPECT_EQ(map.get(42).transform([](const std::string& s) { return s.size(); }), 3u);
+
+  const auto opt = map.get(-1);
+  ASSERT_TRUE(opt);
+
+  std::string& ref = *opt;
+  EXPECT_TRUE(ref.empty());
+  ref = "xyz";
+
+  map.emplace_or_replace(0, "vanilla", 2u, 3u);
+  EXPECT_EQ(map.size(), 4u);
+
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(-1, "xyz"s)(0, "nil"s)(42, "???"s)(123, "abc"s)));
+}
+
+TEST(FlatHashMap, Construct) {
+  {
+    // Default constructor.
+    FlatHashMap<int, std::string> map;
+
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.capacity(), 0u);
+    EXPECT_EQ(map.begin(), map.end());
+  }
+  {
+    // In-place constructor with same types.
+    FlatHashMap<int, std::string> map =
+        ftl::init::map<int, std::string>(123, "abc")(456, "def")(789, "ghi");
+
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_EQ(map, FlatHashMap(ftl::init::map(123, "abc"s)(456, "def"s)(789, "ghi"s)));
+  }
+  {
+    // In-place constructor with duplicate keys keeps the first.
+    const FlatHashMap map = ftl::init::map<char, std::string>('a', "A")('b', "B")('a', "!");
+
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.get('a')->get(), "A");
+  }
+  {
+    // Copy constructor.
+    const FlatHashMap map = ftl::init::map(1, '1')(2, '2')(3, '3');
+    const FlatHashMap copy = map;
+
+    EXPECT_EQ(copy, map);
+    EXPECT_EQ(copy.capacity(), map.capacity());
+  }
+  {
+    // Move constructor.
+    FlatHashMap map = ftl::init::map(1, '1')(2, '2')(3, '3');
+    const FlatHashMap moved = std::move(map);
+
+    EXPECT_EQ(moved, FlatHashMap(ftl::init::map(1, '1')(2, '2')(3, '3')));
+  }
+}
+
+TEST(FlatHashMap, Assign) {
+  {
+    // Same types; smaller capacity.
+    FlatHashMap map = ftl::init::map<int, char>(1, '1')(2, '2');
+    const FlatHashMap other = ftl::init::map<int, char>(3, '3');
+
+    map = other;
+    EXPECT_EQ(map, other);
+
+    map = FlatHashMap<int, char>();
+    EXPECT_TRUE(map.empty());
+  }
+  {
+    // Move-only value type.
+    FlatHashMap<int, std::unique_ptr<int>> map;
+    map.try_emplace(1, std::make_unique<int>(1));
+
+    FlatHashMap<int, std::unique_ptr<int>> other;
+    other = std::move(map);
+
+    ASSERT_TRUE(other.contains(1));
+    EXPECT_EQ(*other.get(1)->get(), 1);
+  }
+}
+
+TEST(FlatHashMap, Get) {
+  {
+    // Constant reference.
+    const FlatHashMap map = ftl::init::map('a', 'A')('b', 'B')('c', 'C');
+
+    const auto opt = map.get('b');
+    EXPECT_EQ(opt, 'B');
+
+    const char d = 'D';
+    const auto ref = map.get('d').value_or(std::cref(d));
+    EXPECT_EQ(ref.get(), 'D');
+  }
+  {
+    // Mutable reference.
+    FlatHashMap map = ftl::init::map('a', 'A')('b', 'B')('c', 'C');
+
+    const auto opt = map.get('c');
+    EXPECT_EQ(opt, 'C');
+
+    char d = 'd';
+    const auto ref = map.get('d').value_or(std::ref(d));
+    ref.get() = 'D';
+    EXPECT_EQ(d, 'D');
+  }
+  {
+    // Immutable transform operation.
+    const FlatHashMap map = ftl::init::map('a', 'x')('b', 'y')('c', 'z');
+    EXPECT_EQ(map.get('c').transform([](char c) { return std::toupper(c); }), 'Z');
+  }
+  {
+    // Mutable transform operation.
+    FlatHashMap map = ftl::init::map('a', 'x')('b', 'y')('c', 'z');
+    EXPECT_EQ(map.get('c').transform(ftl::unit_fn([](char& c) { c = std::toupper(c); })),
+              ftl::unit);
+
+    EXPECT_EQ(map, FlatHashMap(ftl::init::map('c', 'Z')('b', 'y')('a', 'x')));
+  }
+}
+
+TEST(FlatHashMap, TryEmplace) {
+  FlatHashMap<int, std::string> map;
+  using Pair = decltype(map)::value_type;
+
+  {
+    const auto [it, ok] = map.try_emplace(123, "abc");
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(*it, Pair(123, "abc"s));
+  }
+  {
+    const auto [it, ok] = map.try_emplace(42, 3u, '?');
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(*it, Pair(42, "???"s));
+  }
+  {
+    const auto [it, ok] = map.try_emplace(-1);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(*it, Pair(-1, std::string()));
+  }
+  {
+    // Insertion fails if mapping exists.
+    const auto [it, ok] = map.try_emplace(42, "!!!");
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(*it, Pair(42, "???"));
+  }
+
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(-1, ""s)(42, "???"s)(123, "abc"s)));
+}
+
+namespace {
+
+// The mapped type does not require a copy/move assignment operator.
+struct String {
+  template <typename... Args>
+  String(Args... args) : str(args...) {}
+  const std::string str;
+
+  bool operator==(const String& other) const { return other.str == str; }
+};
+
+}  // namespace
+
+TEST(FlatHashMap, TryReplace) {
+  FlatHashMap<int, String> map = ftl::init::map(1, "a")(2, "B");
+  using Pair = decltype(map)::value_type;
+
+  {
+    // Replacing fails unless mapping exists.
+    const auto it = map.try_replace(3, "c");
+    EXPECT_EQ(it, map.end());
+  }
+  {
+    // Replacement arguments can refer to the replaced mapping.
+    const auto ref = map.get(2).transform([](const String& s) { return s.str[0]; });
+    ASSERT_TRUE(ref);
+
+    // Construct std::string from one character.
+    const auto it = map.try_replace(2, 1u, static_cast<char>(std::tolower(*ref)));
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(*it, Pair(2, "b"));
+  }
+  {
+    // Replacement arguments can refer to the replaced mapping.
+    EXPECT_TRUE(map.try_emplace(3, "abc").second);
+    const auto ref = map.get(3);
+    ASSERT_TRUE(ref);
+
+    // Construct std::string from substring.
+    const auto it = map.try_replace(3, ref->get().str, 2u, 1u);
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(*it, Pair(3, "c"));
+  }
+
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(3, "c"s)(2, "b"s)(1, "a"s)));
+}
+
+TEST(FlatHashMap, EmplaceOrReplace) {
+  FlatHashMap<int, String> map = ftl::init::map(1, "a")(2, "B");
+  using Pair = decltype(map)::value_type;
+
+  {
+    // New mapping is emplaced.
+    const auto [it, emplace] = map.emplace_or_replace(3, "c");
+    EXPECT_TRUE(emplace);
+    EXPECT_EQ(*it, Pair(3, "c"));
+  }
+  {
+    // Replacement arguments can refer to the replaced mapping.
+    const auto ref = map.get(2).transform([](const String& s) { return s.str[0]; });
+    ASSERT_TRUE(ref);
+
+    // Construct std::string from one character.
+    const auto [it, emplace] = map.emplace_or_replace(2, 1u, static_cast<char>(std::tolower(*ref)));
+    EXPECT_FALSE(emplace);
+    EXPECT_EQ(*it, Pair(2, "b"));
+  }
+
+  EXPECT_FALSE(map.emplace_or_replace(3, "abc").second);  // Replace.
+  EXPECT_TRUE(map.emplace_or_replace(4, "d").second);     // Emplace.
+
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(4, "d"s)(3, "abc"s)(2, "b"s)(1, "a"s)));
+}
+
+TEST(FlatHashMap, Erase) {
+  FlatHashMap map = ftl::init::map(1, '1')(2, '2')(3, '3')(4, '4');
+
+  EXPECT_FALSE(map.erase(0));  // Key not found.
+
+  EXPECT_TRUE(map.erase(2));
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(1, '1')(3, '3')(4, '4')));
+
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(3, '3')(4, '4')));
+
+  EXPECT_TRUE(map.erase(4));
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(3, '3')));
+
+  EXPECT_TRUE(map.erase(3));
+  EXPECT_FALSE(map.erase(3));  // Key not found.
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(FlatHashMap, EraseWhileIterating) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 100; i++) {
+    map.try_emplace(i, i * i);
+  }
+
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->first % 3 == 0) {
+      it = map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  EXPECT_EQ(map.size(), 66u);
+  EXPECT_EQ(std::distance(map.begin(), map.end()), 66);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(map.contains(i), i % 3 != 0) << i;
+  }
+}
+
+TEST(FlatHashMap, Grow) {
+  FlatHashMap<int, std::string> map;
+  std::unordered_map<int, std::string> expected;
+
+  // Interleave emplaces and erases, so that the erased slots are reused or dropped on rehash.
+  for (int i = 0; i < 2000; i++) {
+    const int key = (i * 7919) % 1000;
+    if (i % 5 == 4) {
+      EXPECT_EQ(map.erase(key), expected.erase(key) != 0) << key;
+    } else {
+      EXPECT_EQ(map.try_emplace(key, std::to_string(i)).second,
+                expected.try_emplace(key, std::to_string(i)).second)
+          << key;
+    }
+    ASSERT_EQ(map.size(), expected.size());
+  }
+
+  EXPECT_LE(map.size(), map.capacity() - map.capacity() / 8);
+  for (const auto& [key, value] : expected) {
+    EXPECT_EQ(map.get(key).transform([](const std::string& s) { return s; }), value) << key;
+  }
+  for (const auto& [key, value] : map) {
+    EXPECT_EQ(expected.at(key), value) << key;
+  }
+}
+
+TEST(FlatHashMap, Reserve) {
+  FlatHashMap<int, int> map;
+  map.reserve(100);
+
+  const auto capacity = map.capacity();
+  EXPECT_GE(capacity - capacity / 8, 100u);
+
+  for (int i = 0; i < 100; i++) {
+    map.try_emplace(i, i);
+  }
+  EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(FlatHashMap, Clear) {
+  FlatHashMap map = ftl::init::map(1, '1')(2, '2')(3, '3');
+  const auto capacity = map.capacity();
+
+  map.clear();
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.capacity(), capacity);
+
+  EXPECT_TRUE(map.try_emplace(1, '!').second);
+  EXPECT_EQ(map, FlatHashMap(ftl::init::map(1, '!')));
+}
+
+TEST(FlatHashMap, KeyEqual) {
+  struct Hash {
+    std::size_t operator()(int key) const { return static_cast<std::size_t>(key % 10); }
+  };
+
+  struct KeyEqual {
+    bool operator()(int lhs, int rhs) const { return lhs % 10 == rhs % 10; }
+  };
+
+  FlatHashMap<int, char, Hash, KeyEqual> map;
+
+  EXPECT_TRUE(map.try_emplace(3, '3').second);
+  EXPECT_FALSE(map.try_emplace(13, '3').second);
+
+  EXPECT_TRUE(map.try_emplace(22, '2').second);
+  EXPECT_TRUE(map.contains(42));
+
+  EXPECT_TRUE(map.try_emplace(111, '1').second);
+  EXPECT_EQ(map.get(321), '1');
+
+  map.erase(123);
+  EXPECT_EQ(map, (FlatHashMap<int, char, Hash, KeyEqual>(
+                         ftl::init::map<int, char, KeyEqual>(1, '1')(2, '2'))));
+}
+
+TEST(FlatHashMap, Collisions) {
+  // All keys have the same hash, so they are in the same probe sequence.
+  struct Hash {
+    std::size_t operator()(int) const { return 0; }
+  };
+
+  FlatHashMap<int, int, Hash> map;
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(map.try_emplace(i, i).second);
+  }
+  for (int i = 0; i < 50; i += 2) {
+    ASSERT_TRUE(map.erase(i));
+  }
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(map.contains(i), i % 2 == 1) << i;
+  }
+  for (int i = 50; i < 75; i++) {
+    ASSERT_TRUE(map.try_emplace(i, i).second);
+  }
+  EXPECT_EQ(map.size(), 50u);
+}
+
+}  // namespace android::test
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ftl/small_vector.h>
+#include <ftl/static_vector.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace android {
+namespace {
+
+// A trivially copyable element, like the display IDs, and one that is not, like the FenceTime
+// pointers.
+using Trivial = uint64_t;
+using NonTrivial = std::shared_ptr<int>;
+
+static_assert(std::is_trivially_copyable_v<Trivial>);
+static_assert(!std::is_trivially_copyable_v<NonTrivial>);
+
+constexpr std::size_t kCapacity = 8;
+
+template <typename T>
+T makeElement(std::size_t i) {
+  if constexpr (std::is_same_v<T, Trivial>) {
+    return i;
+  } else {
+    return std::make_shared<int>(static_cast<int>(i));
+  }
+}
+
+template <typename Vector>
+Vector makeVector(std::size_t size) {
+  Vector vector;
+  for (std::size_t i = 0; i < size; i++) {
+    vector.push_back(makeElement<typename Vector::value_type>(i));
+  }
+  return vector;
+}
+
+template <typename T>
+void BM_StaticVectorCopy(benchmark::State& state) {
+  const auto vector = makeVector<ftl::StaticVector<T, kCapacity>>(kCapacity - 2);
+  for (auto _ : state) {
+    auto copy = vector;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+template <typename T>
+void BM_StaticVectorMove(benchmark::State& state) {
+  auto vector = makeVector<ftl::StaticVector<T, kCapacity>>(kCapacity - 2);
+  for (auto _ : state) {
+    auto moved = std::move(vector);
+    benchmark::DoNotOptimize(moved);
+    vector = std::move(moved);
+  }
+}
+
+template <typename T>
+void BM_StaticVectorSwap(benchmark::State& state) {
+  auto vector = makeVector<ftl::StaticVector<T, kCapacity>>(kCapacity - 2);
+  auto other = makeVector<ftl::StaticVector<T, kCapacity>>(kCapacity / 2);
+  for (auto _ : state) {
+    vector.swap(other);
+    benchmark::DoNotOptimize(vector);
+  }
+}
+
+template <typename T>
+void BM_StaticVectorUnstableErase(benchmark::State& state) {
+  auto vector = makeVector<ftl::StaticVector<T, kCapacity>>(kCapacity);
+  const T element = makeElement<T>(kCapacity);
+  for (auto _ : state) {
+    vector.unstable_erase(vector.begin());
+    vector.push_back(element);
+    benchmark::DoNotOptimize(vector);
+  }
+}
+
+// Appends one element more than the static capacity, so that the elements move to the heap.
+template <typename T>
+void BM_SmallVectorPromote(benchmark::State& state) {
+  const T element = makeElement<T>(0);
+  for (auto _ : state) {
+    ftl::SmallVector<T, kCapacity> vector;
+    for (std::size_t i = 0; i <= kCapacity; i++) {
+      vector.push_back(element);
+    }
+    benchmark::DoNotOptimize(vector);
+  }
+}
+
+// Reserves the heap storage once the static capacity is filled.
+template <typename T>
+void BM_SmallVectorReserve(benchmark::State& state) {
+  const T element = makeElement<T>(0);
+  for (auto _ : state) {
+    ftl::SmallVector<T, kCapacity> vector;
+    for (std::size_t i = 0; i < kCapacity; i++) {
+      vector.push_back(element);
+    }
+    vector.reserve(kCapacity * 4);
+    benchmark::DoNotOptimize(vector);
+  }
+}
+
+#define FTL_VECTOR_BENCHMARK(name)   \
+  BENCHMARK_TEMPLATE(name, Trivial); \
+  BENCHMARK_TEMPLATE(name, NonTrivial)
+
+FTL_VECTOR_BENCHMARK(BM_StaticVectorCopy);
+FTL_VECTOR_BENCHMARK(BM_StaticVectorMove);
+FTL_VECTOR_BENCHMARK(BM_StaticVectorSwap);
+FTL_VECTOR_BENCHMARK(BM_StaticVectorUnstableErase);
+FTL_VECTOR_BENCHMARK(BM_SmallVectorPromote);
+FTL_VECTOR_BENCHMARK(BM_SmallVectorReserve);
+
+#undef FTL_VECTOR_BENCHMARK
+
+}  // namespace
+}  // namespace android
+
+BENCHMARK_MAIN();
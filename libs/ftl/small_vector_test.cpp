@@ -659,4 +659,52 @@ TEST(SmallVector, Promote) {
   EXPECT_EQ(0, dead);
 }
 
+TEST(SmallVector, Reserve) {
+  {
+    // Within the static capacity.
+    SmallVector vector = {1, 2, 3};
+    vector.reserve(3);
+
+    EXPECT_FALSE(vector.dynamic());
+    EXPECT_EQ(vector, (SmallVector{1, 2, 3}));
+  }
+  {
+    // Trivially copyable elements are moved in bulk.
+    SmallVector vector = {1, 2, 3};
+    vector.reserve(8);
+
+    EXPECT_TRUE(vector.dynamic());
+    EXPECT_EQ(vector, (SmallVector{1, 2, 3}));
+
+    const auto data = vector.begin();
+    for (int i = 4; i <= 8; i++) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(vector.begin(), data);
+    EXPECT_EQ(vector, (SmallVector{1, 2, 3, 4, 5, 6, 7, 8}));
+  }
+  {
+    // Other elements are moved one by one.
+    SmallVector vector = {"snow"s, "cone"s};
+    vector.reserve(4);
+
+    EXPECT_TRUE(vector.dynamic());
+    EXPECT_EQ(vector, (SmallVector{"snow"s, "cone"s}));
+
+    const auto data = vector.begin();
+    vector.emplace_back("tira");
+    vector.emplace_back("misu");
+    EXPECT_EQ(vector.begin(), data);
+  }
+  {
+    // Within the dynamic capacity.
+    SmallVector<int, 1> vector = {1};
+    vector.push_back(2);
+    vector.reserve(8);
+
+    EXPECT_TRUE(vector.dynamic());
+    EXPECT_EQ(vector, (SmallVector{1, 2}));
+  }
+}
+
 }  // namespace android::test
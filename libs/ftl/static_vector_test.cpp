@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <string>
 #include <utility>
@@ -202,6 +203,57 @@ TEST(StaticVector, Move) {
   }
 }
 
+TEST(StaticVector, TriviallyCopyable) {
+  {
+    // Small storage, which is copied as a whole.
+    StaticVector<int, 4> vector = {1, 2, 3};
+
+    StaticVector copy = vector;
+    EXPECT_EQ(copy, (StaticVector{1, 2, 3}));
+
+    StaticVector move = std::move(vector);
+    EXPECT_TRUE(vector.empty());
+    EXPECT_EQ(move, (StaticVector{1, 2, 3}));
+
+    StaticVector<int, 4> other = {4, 5};
+    move.swap(other);
+    EXPECT_EQ(move, (StaticVector{4, 5}));
+    EXPECT_EQ(other, (StaticVector{1, 2, 3}));
+
+    copy = move;
+    EXPECT_EQ(copy, (StaticVector{4, 5}));
+
+    other.unstable_erase(other.begin());
+    EXPECT_EQ(other, (StaticVector{3, 2}));
+
+    other.unstable_erase(other.last());
+    EXPECT_EQ(other, (StaticVector{3}));
+  }
+  {
+    // Large storage, of which only the elements are copied.
+    using Vector = StaticVector<int64_t, 16>;
+    Vector vector = {1, 2, 3};
+
+    Vector copy = vector;
+    EXPECT_EQ(copy, vector);
+
+    Vector move;
+    move = std::move(vector);
+    EXPECT_TRUE(vector.empty());
+    EXPECT_EQ(move, copy);
+
+    // Self-assignment.
+    Vector& self = move;
+    move = std::move(self);
+    EXPECT_EQ(move, copy);
+
+    Vector other = {4, 5, 6, 7, 8};
+    move.swap(other);
+    EXPECT_EQ(move, (Vector{4, 5, 6, 7, 8}));
+    EXPECT_EQ(other, copy);
+  }
+}
+
 TEST(StaticVector, String) {
   StaticVector<char, 10> chars;
   char c = 'a';
@@ -336,6 +336,7 @@ void GraphicsEnv::setTargetStatsArray(const GpuStatsInfo::Stats stats, const uin
 
     std::lock_guard<std::mutex> lock(mStatsLock);
     if (!readyToSendGpuStatsLocked()) return;
+    if (!updateSentTargetStatsLocked(stats, values, valueCount)) return;
 
     const sp<IGpuService> gpuService = getGpuService();
     if (gpuService) {
@@ -344,6 +345,36 @@ void GraphicsEnv::setTargetStatsArray(const GpuStatsInfo::Stats stats, const uin
     }
 }
 
+bool GraphicsEnv::updateSentTargetStatsLocked(const GpuStatsInfo::Stats stats,
+                                              const uint64_t* values, const uint32_t valueCount) {
+    // Such stats are sent every time a context, device or swapchain is created, while GpuService
+    // only sets a flag or merges the feature bits, so only the first ones need a binder call.
+    switch (stats) {
+        case GpuStatsInfo::Stats::CPU_VULKAN_IN_USE:
+        case GpuStatsInfo::Stats::FALSE_PREROTATION:
+        case GpuStatsInfo::Stats::GLES_1_IN_USE:
+        case GpuStatsInfo::Stats::CREATED_GLES_CONTEXT:
+        case GpuStatsInfo::Stats::CREATED_VULKAN_DEVICE:
+        case GpuStatsInfo::Stats::CREATED_VULKAN_SWAPCHAIN: {
+            const uint32_t bit = 1u << static_cast<uint32_t>(stats);
+            if (mGpuStats.sentTargetStats & bit) return false;
+            mGpuStats.sentTargetStats |= bit;
+            return true;
+        }
+        case GpuStatsInfo::Stats::VULKAN_DEVICE_FEATURES_ENABLED: {
+            uint64_t features = 0;
+            for (uint32_t i = 0; i < valueCount; i++) {
+                features |= values[i];
+            }
+            if (!(features & ~mGpuStats.sentVulkanDeviceFeatures)) return false;
+            mGpuStats.sentVulkanDeviceFeatures |= features;
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
 void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
                                      int64_t driverLoadingTime) {
     ATRACE_CALL();
@@ -383,6 +414,11 @@ void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
                                 mGpuStats.appPackageName, mGpuStats.vulkanVersion, driver,
                                 isIntendedDriverLoaded, driverLoadingTime);
     }
+
+    // GpuService may have dropped the stats of the app meanwhile, and recreated them with the
+    // driver stats, so the target stats are sent again.
+    mGpuStats.sentTargetStats = 0;
+    mGpuStats.sentVulkanDeviceFeatures = 0;
 }
 
 bool GraphicsEnv::setInjectLayersPrSetDumpable() {
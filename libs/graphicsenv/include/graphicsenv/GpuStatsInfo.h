@@ -138,6 +138,11 @@ public:
     bool vkDriverToSend = false;
     int64_t glDriverLoadingTime = 0;
     int64_t vkDriverLoadingTime = 0;
+    // Bit mask of the target stats which GpuService only records as a flag, and which were sent
+    // since the driver stats were last sent.
+    uint32_t sentTargetStats = 0;
+    // The Vulkan device features sent since the driver stats were last sent.
+    uint64_t sentVulkanDeviceFeatures = 0;
 };
 
 } // namespace android
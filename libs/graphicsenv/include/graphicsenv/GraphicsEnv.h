@@ -147,6 +147,10 @@ private:
     bool readyToSendGpuStatsLocked();
     // Send the initial complete GpuStats to GpuService.
     void sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded, int64_t driverLoadingTime);
+    // Check whether the target stats would change the stats of the app in GpuService, and if so
+    // record them as sent.
+    bool updateSentTargetStatsLocked(const GpuStatsInfo::Stats stats, const uint64_t* values,
+                                     const uint32_t valueCount);
 
     GraphicsEnv() = default;
     // Path to updatable driver libs.
@@ -30,11 +30,14 @@
 #include <gui/IProducerListener.h>
 #include <gui/Surface.h>
 #include <gui/TraceUtils.h>
+#include <ui/FenceSignalWatcher.h>
 #include <utils/Singleton.h>
 #include <utils/Trace.h>
 
 #include <private/gui/ComposerService.h>
 #include <private/gui/ComposerServiceAIDL.h>
+#include <private/gui/FrameTimestampRing.h>
+#include <private/gui/GraphicBufferPool.h>
 
 #include <android-base/thread_annotations.h>
 #include <chrono>
@@ -113,12 +116,28 @@ void BLASTBufferItemConsumer::updateFrameTimestamps(uint64_t frameNumber, nsecs_
     std::shared_ptr<FenceTime> glDoneFenceTime = std::make_shared<FenceTime>(glDoneFence);
     std::shared_ptr<FenceTime> presentFenceTime = std::make_shared<FenceTime>(presentFence);
     std::shared_ptr<FenceTime> releaseFenceTime = std::make_shared<FenceTime>(prevReleaseFence);
+    // The frame timestamps are queried until the fences signal.
+    FenceSignalWatcher::getInstance().watch(glDoneFenceTime);
+    FenceSignalWatcher::getInstance().watch(presentFenceTime);
+    FenceSignalWatcher::getInstance().watch(releaseFenceTime);
 
     mFrameEventHistory.addLatch(frameNumber, latchTime);
     mFrameEventHistory.addRelease(frameNumber, dequeueReadyTime, std::move(releaseFenceTime));
     mFrameEventHistory.addPreComposition(frameNumber, refreshStartTime);
     mFrameEventHistory.addPostComposition(frameNumber, glDoneFenceTime, presentFenceTime,
                                           compositorTiming);
+    if (mFrameTimestampRing) {
+        mFrameTimestampRing->addFrame(frameNumber, latchTime, refreshStartTime, dequeueReadyTime,
+                                      glDoneFence, presentFence, prevReleaseFence);
+    }
+}
+
+std::shared_ptr<FrameTimestampRing> BLASTBufferItemConsumer::getFrameTimestampRing() {
+    Mutex::Autolock lock(mMutex);
+    if (!mFrameTimestampRing) {
+        mFrameTimestampRing = std::make_shared<FrameTimestampRing>();
+    }
+    return mFrameTimestampRing;
 }
 
 void BLASTBufferItemConsumer::getConnectionEvents(uint64_t frameNumber, bool* needsDisconnect) {
@@ -915,6 +934,16 @@ public:
         return mBbq->setFrameTimelineInfo(frameNumber, frameTimelineInfo);
     }
 
+protected:
+    std::shared_ptr<FrameTimestampRing> getFrameTimestampRing() override {
+        std::lock_guard _lock{mMutex};
+        if (mDestroyed) {
+            return nullptr;
+        }
+        return mBbq->getFrameTimestampRing();
+    }
+
+public:
     void destroy() override {
         Surface::destroy();
 
@@ -959,6 +988,10 @@ sp<Surface> BLASTBufferQueue::getSurface(bool includeSurfaceControlHandle) {
     return new BBQSurface(mProducer, true, scHandle, this);
 }
 
+std::shared_ptr<FrameTimestampRing> BLASTBufferQueue::getFrameTimestampRing() {
+    return mBufferItemConsumer->getFrameTimestampRing();
+}
+
 void BLASTBufferQueue::mergeWithNextTransaction(SurfaceComposerClient::Transaction* t,
                                                 uint64_t frameNumber) {
     std::lock_guard _lock{mMutex};
@@ -1137,6 +1170,9 @@ void BLASTBufferQueue::createBufferQueue(sp<IGraphicBufferProducer>* outProducer
 
     sp<BufferQueueCore> core(new BufferQueueCore());
     LOG_ALWAYS_FATAL_IF(core == nullptr, "BLASTBufferQueue: failed to create BufferQueueCore");
+    // The producer and consumer are in this process, so the buffers replaced on resize can be
+    // reused by any BLASTBufferQueue of the process instead of reallocated.
+    core->mRecycleBuffers = GraphicBufferPool::getInstance().isEnabled();
 
     sp<IGraphicBufferProducer> producer(new BBQBufferQueueProducer(core, this));
     LOG_ALWAYS_FATAL_IF(producer == nullptr,
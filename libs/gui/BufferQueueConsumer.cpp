@@ -80,6 +80,13 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
         nsecs_t expectedPresent, uint64_t maxFrameNumber) {
     ATRACE_CALL();
 
+    // Don't contend with the producer for the lock if there is nothing to
+    // acquire. A buffer queued concurrently is still reported to the consumer
+    // through onFrameAvailable, as if it had been queued after this call.
+    if (!mCore->mHasBufferToAcquire.load(std::memory_order_acquire)) {
+        return NO_BUFFER_AVAILABLE;
+    }
+
     int numDroppedBuffers = 0;
     sp<IProducerListener> listener;
     {
@@ -201,6 +208,7 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
                 }
 
                 mCore->mQueue.erase(front);
+                mCore->updateHasBufferToAcquireLocked();
                 front = mCore->mQueue.begin();
             }
 
@@ -273,6 +281,9 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
 
         if (!outBuffer->mIsStale) {
             mSlots[slot].mAcquireCalled = true;
+            if (mCore->mTelemetry.isEnabled()) {
+                mCore->mTelemetry.recordAcquired(slot, systemTime());
+            }
             // Don't decrease the queue count if the BufferItem wasn't
             // previously in the queue. This happens in shared buffer mode when
             // the queue is empty and the BufferItem is created above.
@@ -292,6 +303,7 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
         }
 
         mCore->mQueue.erase(front);
+        mCore->updateHasBufferToAcquireLocked();
 
         // We might have freed a slot while dropping old buffers, or the producer
         // may be blocked waiting for the number of buffers in the queue to
@@ -478,6 +490,9 @@ status_t BufferQueueConsumer::releaseBuffer(int slot, uint64_t frameNumber,
         mSlots[slot].mEglFence = eglFence;
         mSlots[slot].mFence = releaseFence;
         mSlots[slot].mBufferState.release();
+        if (mCore->mTelemetry.isEnabled()) {
+            mCore->mTelemetry.recordReleased(slot, systemTime());
+        }
 
         // After leaving shared buffer mode, the shared buffer will
         // still be around. Mark it as no longer shared if this
@@ -550,6 +565,7 @@ status_t BufferQueueConsumer::disconnect() {
     mCore->mQueue.clear();
     mCore->freeAllBuffersLocked();
     mCore->mSharedBufferSlot = BufferQueueCore::INVALID_BUFFER_SLOT;
+    mCore->updateHasBufferToAcquireLocked();
     mCore->mDequeueCondition.notify_all();
     return NO_ERROR;
 }
@@ -721,6 +737,7 @@ status_t BufferQueueConsumer::setConsumerName(const String8& name) {
     BQ_LOGV("setConsumerName: '%s'", name.string());
     std::lock_guard<std::mutex> lock(mCore->mMutex);
     mCore->mConsumerName = name;
+    mCore->mTelemetry.setName(name);
     mConsumerName = name;
     return NO_ERROR;
 }
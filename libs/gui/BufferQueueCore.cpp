@@ -98,6 +98,7 @@ BufferQueueCore::BufferQueueCore()
         mBufferReleasedCbEnabled(false),
         mSlots(),
         mQueue(),
+        mHasBufferToAcquire(false),
         mFreeSlots(),
         mFreeBuffers(),
         mUnusedSlots(),
@@ -119,6 +120,7 @@ BufferQueueCore::BufferQueueCore()
         mIsAllocating(false),
         mIsAllocatingCondition(),
         mAllowAllocation(true),
+        mRecycleBuffers(false),
         mBufferAge(0),
         mGenerationNumber(0),
         mAsyncMode(false),
@@ -128,9 +130,11 @@ BufferQueueCore::BufferQueueCore()
         mSharedBufferCache(Rect::INVALID_RECT, 0, NATIVE_WINDOW_SCALING_MODE_FREEZE,
                            HAL_DATASPACE_UNKNOWN),
         mLastQueuedSlot(INVALID_BUFFER_SLOT),
+        mTelemetry(BufferQueueTelemetry::isEnabledByProperty()),
         mUniqueId(getUniqueId()),
         mAutoPrerotation(false),
         mTransformHintInUse(0) {
+    mTelemetry.setName(mConsumerName);
     int numStartingBuffers = getMaxBufferCountLocked();
     for (int s = 0; s < numStartingBuffers; s++) {
         mFreeSlots.insert(s);
@@ -219,6 +223,8 @@ void BufferQueueCore::dumpState(const String8& prefix, String8* outResult) const
         outResult->appendFormat("%s  [%02d:%p] state=%-8s\n", prefix.string(), s, buffer.get(),
                                 mSlots[s].mBufferState.string());
     }
+
+    mTelemetry.dump(prefix, outResult);
 }
 
 int BufferQueueCore::getMinUndequeuedBufferCountLocked() const {
@@ -274,6 +280,7 @@ void BufferQueueCore::clearBufferSlotLocked(int slot) {
     if (mLastQueuedSlot == slot) {
         mLastQueuedSlot = INVALID_BUFFER_SLOT;
     }
+    mTelemetry.recordCleared(slot);
 }
 
 void BufferQueueCore::freeAllBuffersLocked() {
@@ -371,6 +378,13 @@ void BufferQueueCore::waitWhileAllocatingLocked(std::unique_lock<std::mutex>& lo
     }
 }
 
+void BufferQueueCore::updateHasBufferToAcquireLocked() {
+    const bool sharedBufferAvailable = mSharedBufferMode && mAutoRefresh &&
+            mSharedBufferSlot != INVALID_BUFFER_SLOT;
+    mHasBufferToAcquire.store(!mQueue.empty() || sharedBufferAvailable,
+            std::memory_order_release);
+}
+
 #if DEBUG_ONLY_CODE
 void BufferQueueCore::validateConsistencyLocked() const {
     static const useconds_t PAUSE_TIME = 0;
@@ -16,6 +16,9 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <vector>
+
 #define LOG_TAG "BufferQueueProducer"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 //#define LOG_NDEBUG 0
@@ -37,6 +40,7 @@
 #include <gui/IProducerListener.h>
 #include <gui/TraceUtils.h>
 #include <private/gui/BufferQueueThreadState.h>
+#include <private/gui/GraphicBufferPool.h>
 
 #include <utils/Log.h>
 #include <utils/Trace.h>
@@ -70,6 +74,46 @@ namespace android {
 static constexpr uint32_t BQ_LAYER_COUNT = 1;
 ProducerListener::~ProducerListener() = default;
 
+struct BufferQueueProducer::DequeuedBuffer {
+    // The requested attributes, with the defaults of the BufferQueue applied once the slot is
+    // dequeued.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    PixelFormat format = 0;
+    uint64_t usage = 0;
+
+    int slot = BufferQueueCore::INVALID_BUFFER_SLOT;
+    sp<Fence> fence;
+    uint64_t bufferAge = 0;
+    status_t returnFlags = NO_ERROR;
+    bool attachedByConsumer = false;
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLSyncKHR eglFence = EGL_NO_SYNC_KHR;
+    // Whether the buffer, if it needs to be allocated, can be taken from the GraphicBufferPool.
+    bool recycleBuffers = false;
+};
+
+struct BufferQueueProducer::QueuedBuffer {
+    // Deflated from the QueueBufferInput.
+    int64_t requestedPresentTimestamp = 0;
+    bool isAutoTimestamp = false;
+    android_dataspace dataSpace = HAL_DATASPACE_UNKNOWN;
+    Rect crop = Rect::EMPTY_RECT;
+    int scalingMode = 0;
+    uint32_t transform = 0;
+    uint32_t stickyTransform = 0;
+    sp<Fence> acquireFence;
+    std::shared_ptr<FenceTime> acquireFenceTime;
+    bool getFrameTimestamps = false;
+
+    // Set once the buffer is queued, to report it to the consumer.
+    BufferItem item;
+    uint64_t frameNumber = 0;
+    sp<IConsumerListener> frameAvailableListener;
+    sp<IConsumerListener> frameReplacedListener;
+    int callbackTicket = 0;
+};
+
 BufferQueueProducer::BufferQueueProducer(const sp<BufferQueueCore>& core,
         bool consumerIsSurfaceFlinger) :
     mCore(core),
@@ -92,7 +136,24 @@ status_t BufferQueueProducer::requestBuffer(int slot, sp<GraphicBuffer>* buf) {
     ATRACE_CALL();
     BQ_LOGV("requestBuffer: slot %d", slot);
     std::lock_guard<std::mutex> lock(mCore->mMutex);
+    return requestBufferLocked(slot, buf);
+}
+
+status_t BufferQueueProducer::requestBuffers(const std::vector<int32_t>& slots,
+                                             std::vector<RequestBufferOutput>* outputs) {
+    ATRACE_CALL();
+    BQ_LOGV("requestBuffers: %zu slots", slots.size());
+    outputs->clear();
+    outputs->reserve(slots.size());
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    for (int32_t slot : slots) {
+        RequestBufferOutput& output = outputs->emplace_back();
+        output.result = requestBufferLocked(static_cast<int>(slot), &output.buffer);
+    }
+    return NO_ERROR;
+}
 
+status_t BufferQueueProducer::requestBufferLocked(int slot, sp<GraphicBuffer>* buf) {
     if (mCore->mIsAbandoned) {
         BQ_LOGE("requestBuffer: BufferQueue has been abandoned");
         return NO_INIT;
@@ -286,6 +347,7 @@ status_t BufferQueueProducer::waitForFreeSlotThenRelock(FreeSlotCaller caller,
     auto callerString = (caller == FreeSlotCaller::Dequeue) ?
             "dequeueBuffer" : "attachBuffer";
     bool tryAgain = true;
+    bool starved = false;
     while (tryAgain) {
         if (mCore->mIsAbandoned) {
             BQ_LOGE("%s: BufferQueue has been abandoned", callerString);
@@ -361,6 +423,10 @@ status_t BufferQueueProducer::waitForFreeSlotThenRelock(FreeSlotCaller caller,
         // max buffer count to change.
         tryAgain = (*found == BufferQueueCore::INVALID_BUFFER_SLOT) ||
                    tooManyBuffers;
+        if (tryAgain && !starved && caller == FreeSlotCaller::Dequeue) {
+            starved = true;
+            mCore->mTelemetry.recordStarvation();
+        }
         if (tryAgain) {
             // Return an error if we're in non-blocking mode (producer and
             // consumer are controlled by the application).
@@ -394,227 +460,390 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
     ATRACE_CALL();
     { // Autolock scope
         std::lock_guard<std::mutex> lock(mCore->mMutex);
-        mConsumerName = mCore->mConsumerName;
-
-        if (mCore->mIsAbandoned) {
-            BQ_LOGE("dequeueBuffer: BufferQueue has been abandoned");
-            return NO_INIT;
+        status_t status = checkCanDequeueLocked();
+        if (status != NO_ERROR) {
+            return status;
         }
+    } // Autolock scope
 
-        if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
-            BQ_LOGE("dequeueBuffer: BufferQueue has no connected producer");
-            return NO_INIT;
+    DequeuedBuffer dequeued{.width = width, .height = height, .format = format, .usage = usage};
+    { // Autolock scope
+        std::unique_lock<std::mutex> lock(mCore->mMutex);
+        waitWhileAllocatingForDequeueLocked(lock);
+
+        status_t status = dequeueSlotLocked(lock, &dequeued);
+        if (status != NO_ERROR) {
+            return status;
         }
     } // Autolock scope
 
-    BQ_LOGV("dequeueBuffer: w=%u h=%u format=%#x, usage=%#" PRIx64, width, height, format, usage);
+    *outSlot = dequeued.slot;
 
-    if ((width && !height) || (!width && height)) {
-        BQ_LOGE("dequeueBuffer: invalid size: w=%u h=%u", width, height);
-        return BAD_VALUE;
+    if (dequeued.returnFlags & BUFFER_NEEDS_REALLOCATION) {
+        sp<GraphicBuffer> graphicBuffer = allocateDequeuedBuffer(&dequeued);
+
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        status_t status = attachAllocatedBufferLocked(dequeued, graphicBuffer);
+        mCore->mIsAllocating = false;
+        mCore->mIsAllocatingCondition.notify_all();
+        if (status != NO_ERROR) {
+            return status;
+        }
     }
 
-    status_t returnFlags = NO_ERROR;
-    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
-    EGLSyncKHR eglFence = EGL_NO_SYNC_KHR;
-    bool attachedByConsumer = false;
+    *outFence = dequeued.fence;
+    return finishDequeue(dequeued, outBufferAge, outTimestamps);
+}
 
+status_t BufferQueueProducer::dequeueBuffers(const std::vector<DequeueBufferInput>& inputs,
+                                             std::vector<DequeueBufferOutput>* outputs) {
+    ATRACE_CALL();
+    BQ_LOGV("dequeueBuffers: %zu buffers", inputs.size());
+    outputs->clear();
+    outputs->resize(inputs.size());
+
+    // The slots of all the buffers are dequeued with the lock held once. Only the buffers that
+    // need to be allocated take the lock again, once for the whole batch, to be attached.
+    std::vector<DequeuedBuffer> dequeued(inputs.size());
+    bool needsAllocation = false;
     { // Autolock scope
         std::unique_lock<std::mutex> lock(mCore->mMutex);
-
-        // If we don't have a free buffer, but we are currently allocating, we wait until allocation
-        // is finished such that we don't allocate in parallel.
-        if (mCore->mFreeBuffers.empty() && mCore->mIsAllocating) {
-            mDequeueWaitingForAllocation = true;
-            mCore->waitWhileAllocatingLocked(lock);
-            mDequeueWaitingForAllocation = false;
-            mDequeueWaitingForAllocationCondition.notify_all();
+        const status_t status = checkCanDequeueLocked();
+        if (status == NO_ERROR) {
+            waitWhileAllocatingForDequeueLocked(lock);
         }
 
-        if (format == 0) {
-            format = mCore->mDefaultBufferFormat;
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (status != NO_ERROR) {
+                (*outputs)[i].result = status;
+                continue;
+            }
+            dequeued[i] = DequeuedBuffer{.width = inputs[i].width,
+                                         .height = inputs[i].height,
+                                         .format = inputs[i].format,
+                                         .usage = inputs[i].usage};
+            (*outputs)[i].result = dequeueSlotLocked(lock, &dequeued[i]);
+            if ((*outputs)[i].result == NO_ERROR &&
+                (dequeued[i].returnFlags & BUFFER_NEEDS_REALLOCATION)) {
+                needsAllocation = true;
+            }
         }
+    } // Autolock scope
 
-        // Enable the usage bits the consumer requested
-        usage |= mCore->mConsumerUsageBits;
-
-        const bool useDefaultSize = !width && !height;
-        if (useDefaultSize) {
-            width = mCore->mDefaultWidth;
-            height = mCore->mDefaultHeight;
-            if (mCore->mAutoPrerotation &&
-                (mCore->mTransformHintInUse & NATIVE_WINDOW_TRANSFORM_ROT_90)) {
-                std::swap(width, height);
+    if (needsAllocation) {
+        std::vector<sp<GraphicBuffer>> graphicBuffers(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if ((*outputs)[i].result == NO_ERROR &&
+                (dequeued[i].returnFlags & BUFFER_NEEDS_REALLOCATION)) {
+                graphicBuffers[i] = allocateDequeuedBuffer(&dequeued[i]);
             }
         }
 
-        int found = BufferItem::INVALID_BUFFER_SLOT;
-        while (found == BufferItem::INVALID_BUFFER_SLOT) {
-            status_t status = waitForFreeSlotThenRelock(FreeSlotCaller::Dequeue, lock, &found);
-            if (status != NO_ERROR) {
-                return status;
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (graphicBuffers[i] != nullptr) {
+                (*outputs)[i].result = attachAllocatedBufferLocked(dequeued[i], graphicBuffers[i]);
             }
+        }
+        mCore->mIsAllocating = false;
+        mCore->mIsAllocatingCondition.notify_all();
+    }
 
-            // This should not happen
-            if (found == BufferQueueCore::INVALID_BUFFER_SLOT) {
-                BQ_LOGE("dequeueBuffer: no available buffer slots");
-                return -EBUSY;
-            }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        DequeueBufferOutput& output = (*outputs)[i];
+        if (output.result != NO_ERROR) {
+            continue;
+        }
+        output.slot = dequeued[i].slot;
+        output.fence = dequeued[i].fence;
+        output.result = finishDequeue(dequeued[i], &output.bufferAge,
+                                      inputs[i].getTimestamps ? &output.timestamps.emplace()
+                                                              : nullptr);
+    }
+    return NO_ERROR;
+}
 
-            const sp<GraphicBuffer>& buffer(mSlots[found].mGraphicBuffer);
+status_t BufferQueueProducer::checkCanDequeueLocked() {
+    mConsumerName = mCore->mConsumerName;
 
-            // If we are not allowed to allocate new buffers,
-            // waitForFreeSlotThenRelock must have returned a slot containing a
-            // buffer. If this buffer would require reallocation to meet the
-            // requested attributes, we free it and attempt to get another one.
-            if (!mCore->mAllowAllocation) {
-                if (buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage)) {
-                    if (mCore->mSharedBufferSlot == found) {
-                        BQ_LOGE("dequeueBuffer: cannot re-allocate a sharedbuffer");
-                        return BAD_VALUE;
-                    }
-                    mCore->mFreeSlots.insert(found);
-                    mCore->clearBufferSlotLocked(found);
-                    found = BufferItem::INVALID_BUFFER_SLOT;
-                    continue;
-                }
-            }
-        }
+    if (mCore->mIsAbandoned) {
+        BQ_LOGE("dequeueBuffer: BufferQueue has been abandoned");
+        return NO_INIT;
+    }
 
-        const sp<GraphicBuffer>& buffer(mSlots[found].mGraphicBuffer);
-        if (mCore->mSharedBufferSlot == found &&
-                buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage)) {
-            BQ_LOGE("dequeueBuffer: cannot re-allocate a shared"
-                    "buffer");
+    if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
+        BQ_LOGE("dequeueBuffer: BufferQueue has no connected producer");
+        return NO_INIT;
+    }
+    return NO_ERROR;
+}
 
-            return BAD_VALUE;
+void BufferQueueProducer::waitWhileAllocatingForDequeueLocked(std::unique_lock<std::mutex>& lock) {
+    // If we don't have a free buffer, but we are currently allocating, we wait until allocation
+    // is finished such that we don't allocate in parallel.
+    if (mCore->mFreeBuffers.empty() && mCore->mIsAllocating) {
+        mDequeueWaitingForAllocation = true;
+        mCore->waitWhileAllocatingLocked(lock);
+        mDequeueWaitingForAllocation = false;
+        mDequeueWaitingForAllocationCondition.notify_all();
+    }
+}
+
+status_t BufferQueueProducer::dequeueSlotLocked(std::unique_lock<std::mutex>& lock,
+                                                DequeuedBuffer* dequeued) {
+    uint32_t& width = dequeued->width;
+    uint32_t& height = dequeued->height;
+    PixelFormat& format = dequeued->format;
+    uint64_t& usage = dequeued->usage;
+
+    BQ_LOGV("dequeueBuffer: w=%u h=%u format=%#x, usage=%#" PRIx64, width, height, format, usage);
+
+    if ((width && !height) || (!width && height)) {
+        BQ_LOGE("dequeueBuffer: invalid size: w=%u h=%u", width, height);
+        return BAD_VALUE;
+    }
+
+    if (format == 0) {
+        format = mCore->mDefaultBufferFormat;
+    }
+
+    // Enable the usage bits the consumer requested
+    usage |= mCore->mConsumerUsageBits;
+
+    const bool useDefaultSize = !width && !height;
+    if (useDefaultSize) {
+        width = mCore->mDefaultWidth;
+        height = mCore->mDefaultHeight;
+        if (mCore->mAutoPrerotation &&
+            (mCore->mTransformHintInUse & NATIVE_WINDOW_TRANSFORM_ROT_90)) {
+            std::swap(width, height);
         }
+    }
 
-        if (mCore->mSharedBufferSlot != found) {
-            mCore->mActiveBuffers.insert(found);
+    const nsecs_t waitStartTime = mCore->mTelemetry.isEnabled() ? systemTime() : 0;
+    int found = BufferItem::INVALID_BUFFER_SLOT;
+    while (found == BufferItem::INVALID_BUFFER_SLOT) {
+        status_t status = waitForFreeSlotThenRelock(FreeSlotCaller::Dequeue, lock, &found);
+        if (status != NO_ERROR) {
+            return status;
         }
-        *outSlot = found;
-        ATRACE_BUFFER_INDEX(found);
 
-        attachedByConsumer = mSlots[found].mNeedsReallocation;
-        mSlots[found].mNeedsReallocation = false;
+        // This should not happen
+        if (found == BufferQueueCore::INVALID_BUFFER_SLOT) {
+            BQ_LOGE("dequeueBuffer: no available buffer slots");
+            return -EBUSY;
+        }
 
-        mSlots[found].mBufferState.dequeue();
+        const sp<GraphicBuffer>& buffer(mSlots[found].mGraphicBuffer);
 
-        if ((buffer == nullptr) ||
-                buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage))
-        {
-            if (CC_UNLIKELY(ATRACE_ENABLED())) {
-                if (buffer == nullptr) {
-                    ATRACE_FORMAT_INSTANT("%s buffer reallocation: null", mConsumerName.string());
-                } else {
-                    ATRACE_FORMAT_INSTANT("%s buffer reallocation actual %dx%d format:%d "
-                                          "layerCount:%d "
-                                          "usage:%d requested: %dx%d format:%d layerCount:%d "
-                                          "usage:%d ",
-                                          mConsumerName.string(), width, height, format,
-                                          BQ_LAYER_COUNT, usage, buffer->getWidth(),
-                                          buffer->getHeight(), buffer->getPixelFormat(),
-                                          buffer->getLayerCount(), buffer->getUsage());
+        // If we are not allowed to allocate new buffers,
+        // waitForFreeSlotThenRelock must have returned a slot containing a
+        // buffer. If this buffer would require reallocation to meet the
+        // requested attributes, we free it and attempt to get another one.
+        if (!mCore->mAllowAllocation) {
+            if (buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage)) {
+                if (mCore->mSharedBufferSlot == found) {
+                    BQ_LOGE("dequeueBuffer: cannot re-allocate a sharedbuffer");
+                    return BAD_VALUE;
                 }
+                mCore->mFreeSlots.insert(found);
+                mCore->clearBufferSlotLocked(found);
+                found = BufferItem::INVALID_BUFFER_SLOT;
+                continue;
             }
-            mSlots[found].mAcquireCalled = false;
-            mSlots[found].mGraphicBuffer = nullptr;
-            mSlots[found].mRequestBufferCalled = false;
-            mSlots[found].mEglDisplay = EGL_NO_DISPLAY;
-            mSlots[found].mEglFence = EGL_NO_SYNC_KHR;
-            mSlots[found].mFence = Fence::NO_FENCE;
-            mCore->mBufferAge = 0;
-            mCore->mIsAllocating = true;
-
-            returnFlags |= BUFFER_NEEDS_REALLOCATION;
-        } else {
-            // We add 1 because that will be the frame number when this buffer
-            // is queued
-            mCore->mBufferAge = mCore->mFrameCounter + 1 - mSlots[found].mFrameNumber;
         }
+    }
 
-        BQ_LOGV("dequeueBuffer: setting buffer age to %" PRIu64,
-                mCore->mBufferAge);
+    const sp<GraphicBuffer>& buffer(mSlots[found].mGraphicBuffer);
+    if (mCore->mSharedBufferSlot == found &&
+            buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage)) {
+        BQ_LOGE("dequeueBuffer: cannot re-allocate a shared"
+                "buffer");
 
-        if (CC_UNLIKELY(mSlots[found].mFence == nullptr)) {
-            BQ_LOGE("dequeueBuffer: about to return a NULL fence - "
-                    "slot=%d w=%d h=%d format=%u",
-                    found, buffer->width, buffer->height, buffer->format);
-        }
+        return BAD_VALUE;
+    }
 
-        eglDisplay = mSlots[found].mEglDisplay;
-        eglFence = mSlots[found].mEglFence;
-        // Don't return a fence in shared buffer mode, except for the first
-        // frame.
-        *outFence = (mCore->mSharedBufferMode &&
-                mCore->mSharedBufferSlot == found) ?
-                Fence::NO_FENCE : mSlots[found].mFence;
-        mSlots[found].mEglFence = EGL_NO_SYNC_KHR;
-        mSlots[found].mFence = Fence::NO_FENCE;
+    if (mCore->mTelemetry.isEnabled()) {
+        mCore->mTelemetry.recordDequeueWait(systemTime() - waitStartTime);
+    }
 
-        // If shared buffer mode has just been enabled, cache the slot of the
-        // first buffer that is dequeued and mark it as the shared buffer.
-        if (mCore->mSharedBufferMode && mCore->mSharedBufferSlot ==
-                BufferQueueCore::INVALID_BUFFER_SLOT) {
-            mCore->mSharedBufferSlot = found;
-            mSlots[found].mBufferState.mShared = true;
-        }
+    if (mCore->mSharedBufferSlot != found) {
+        mCore->mActiveBuffers.insert(found);
+    }
+    dequeued->slot = found;
+    ATRACE_BUFFER_INDEX(found);
+
+    dequeued->attachedByConsumer = mSlots[found].mNeedsReallocation;
+    mSlots[found].mNeedsReallocation = false;
+
+    mSlots[found].mBufferState.dequeue();
 
-        if (!(returnFlags & BUFFER_NEEDS_REALLOCATION)) {
-            if (mCore->mConsumerListener != nullptr) {
-                mCore->mConsumerListener->onFrameDequeued(mSlots[*outSlot].mGraphicBuffer->getId());
+    if ((buffer == nullptr) ||
+            buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage))
+    {
+        if (CC_UNLIKELY(ATRACE_ENABLED())) {
+            if (buffer == nullptr) {
+                ATRACE_FORMAT_INSTANT("%s buffer reallocation: null", mConsumerName.string());
+            } else {
+                ATRACE_FORMAT_INSTANT("%s buffer reallocation actual %dx%d format:%d "
+                                      "layerCount:%d "
+                                      "usage:%d requested: %dx%d format:%d layerCount:%d "
+                                      "usage:%d ",
+                                      mConsumerName.string(), width, height, format,
+                                      BQ_LAYER_COUNT, usage, buffer->getWidth(),
+                                      buffer->getHeight(), buffer->getPixelFormat(),
+                                      buffer->getLayerCount(), buffer->getUsage());
             }
         }
-    } // Autolock scope
+        if (mCore->mRecycleBuffers) {
+            recycleSlotBufferLocked(found, *dequeued);
+            dequeued->recycleBuffers = true;
+        }
+        mSlots[found].mAcquireCalled = false;
+        mSlots[found].mGraphicBuffer = nullptr;
+        mSlots[found].mRequestBufferCalled = false;
+        mSlots[found].mEglDisplay = EGL_NO_DISPLAY;
+        mSlots[found].mEglFence = EGL_NO_SYNC_KHR;
+        mSlots[found].mFence = Fence::NO_FENCE;
+        mCore->mBufferAge = 0;
+        mCore->mIsAllocating = true;
+
+        dequeued->returnFlags |= BUFFER_NEEDS_REALLOCATION;
+    } else {
+        // We add 1 because that will be the frame number when this buffer
+        // is queued
+        mCore->mBufferAge = mCore->mFrameCounter + 1 - mSlots[found].mFrameNumber;
+    }
+    dequeued->bufferAge = mCore->mBufferAge;
 
-    if (returnFlags & BUFFER_NEEDS_REALLOCATION) {
-        BQ_LOGV("dequeueBuffer: allocating a new buffer for slot %d", *outSlot);
-        sp<GraphicBuffer> graphicBuffer = new GraphicBuffer(
-                width, height, format, BQ_LAYER_COUNT, usage,
-                {mConsumerName.string(), mConsumerName.size()});
+    BQ_LOGV("dequeueBuffer: setting buffer age to %" PRIu64,
+            mCore->mBufferAge);
 
-        status_t error = graphicBuffer->initCheck();
+    if (CC_UNLIKELY(mSlots[found].mFence == nullptr)) {
+        BQ_LOGE("dequeueBuffer: about to return a NULL fence - "
+                "slot=%d w=%d h=%d format=%u",
+                found, buffer->width, buffer->height, buffer->format);
+    }
 
-        { // Autolock scope
-            std::lock_guard<std::mutex> lock(mCore->mMutex);
+    dequeued->eglDisplay = mSlots[found].mEglDisplay;
+    dequeued->eglFence = mSlots[found].mEglFence;
+    // Don't return a fence in shared buffer mode, except for the first
+    // frame.
+    dequeued->fence = (mCore->mSharedBufferMode &&
+            mCore->mSharedBufferSlot == found) ?
+            Fence::NO_FENCE : mSlots[found].mFence;
+    mSlots[found].mEglFence = EGL_NO_SYNC_KHR;
+    mSlots[found].mFence = Fence::NO_FENCE;
+
+    // If shared buffer mode has just been enabled, cache the slot of the
+    // first buffer that is dequeued and mark it as the shared buffer.
+    if (mCore->mSharedBufferMode && mCore->mSharedBufferSlot ==
+            BufferQueueCore::INVALID_BUFFER_SLOT) {
+        mCore->mSharedBufferSlot = found;
+        mSlots[found].mBufferState.mShared = true;
+        mCore->updateHasBufferToAcquireLocked();
+    }
 
-            if (error == NO_ERROR && !mCore->mIsAbandoned) {
-                graphicBuffer->setGenerationNumber(mCore->mGenerationNumber);
-                mSlots[*outSlot].mGraphicBuffer = graphicBuffer;
-                if (mCore->mConsumerListener != nullptr) {
-                    mCore->mConsumerListener->onFrameDequeued(
-                            mSlots[*outSlot].mGraphicBuffer->getId());
-                }
-            }
+    if (!(dequeued->returnFlags & BUFFER_NEEDS_REALLOCATION)) {
+        if (mCore->mConsumerListener != nullptr) {
+            mCore->mConsumerListener->onFrameDequeued(mSlots[found].mGraphicBuffer->getId());
+        }
+    }
+    return NO_ERROR;
+}
 
-            mCore->mIsAllocating = false;
-            mCore->mIsAllocatingCondition.notify_all();
+void BufferQueueProducer::recycleSlotBufferLocked(int slot, const DequeuedBuffer& dequeued) {
+    GraphicBufferPool& pool = GraphicBufferPool::getInstance();
+    BufferSlot& bufferSlot = mSlots[slot];
+    // A buffer that is waited on with an EGL fence may still be read by the consumer.
+    if (bufferSlot.mGraphicBuffer != nullptr && bufferSlot.mEglFence == EGL_NO_SYNC_KHR) {
+        pool.put({.buffer = bufferSlot.mGraphicBuffer, .fence = bufferSlot.mFence});
+    }
 
-            if (error != NO_ERROR) {
-                mCore->mFreeSlots.insert(*outSlot);
-                mCore->clearBufferSlotLocked(*outSlot);
-                BQ_LOGE("dequeueBuffer: createGraphicBuffer failed");
-                return error;
-            }
+    // The other buffers of the BufferQueue will need to be reallocated as well once they are
+    // dequeued, so allocate them ahead of time.
+    const auto needsReallocation = [&](int s) {
+        const sp<GraphicBuffer>& buffer = mSlots[s].mGraphicBuffer;
+        return s != slot && buffer != nullptr &&
+                buffer->needsReallocation(dequeued.width, dequeued.height, dequeued.format,
+                                          BQ_LAYER_COUNT, dequeued.usage);
+    };
+    const size_t count =
+            std::count_if(mCore->mFreeBuffers.begin(), mCore->mFreeBuffers.end(),
+                          needsReallocation) +
+            std::count_if(mCore->mActiveBuffers.begin(), mCore->mActiveBuffers.end(),
+                          needsReallocation);
+    if (count > 0) {
+        pool.preallocate({.width = dequeued.width,
+                          .height = dequeued.height,
+                          .format = dequeued.format,
+                          .layerCount = BQ_LAYER_COUNT,
+                          .usage = dequeued.usage},
+                         count, {mConsumerName.string(), mConsumerName.size()});
+    }
+}
 
-            if (mCore->mIsAbandoned) {
-                mCore->mFreeSlots.insert(*outSlot);
-                mCore->clearBufferSlotLocked(*outSlot);
-                BQ_LOGE("dequeueBuffer: BufferQueue has been abandoned");
-                return NO_INIT;
-            }
+sp<GraphicBuffer> BufferQueueProducer::allocateDequeuedBuffer(DequeuedBuffer* dequeued) {
+    if (dequeued->recycleBuffers) {
+        if (auto recycled = GraphicBufferPool::getInstance().take(
+                    {.width = dequeued->width,
+                     .height = dequeued->height,
+                     .format = dequeued->format,
+                     .layerCount = BQ_LAYER_COUNT,
+                     .usage = dequeued->usage})) {
+            BQ_LOGV("dequeueBuffer: recycling a buffer for slot %d", dequeued->slot);
+            dequeued->fence = std::move(recycled->fence);
+            return std::move(recycled->buffer);
+        }
+    }
 
-            VALIDATE_CONSISTENCY();
-        } // Autolock scope
+    BQ_LOGV("dequeueBuffer: allocating a new buffer for slot %d", dequeued->slot);
+    return new GraphicBuffer(dequeued->width, dequeued->height, dequeued->format, BQ_LAYER_COUNT,
+                             dequeued->usage, {mConsumerName.string(), mConsumerName.size()});
+}
+
+status_t BufferQueueProducer::attachAllocatedBufferLocked(const DequeuedBuffer& dequeued,
+                                                          const sp<GraphicBuffer>& graphicBuffer) {
+    const int slot = dequeued.slot;
+    status_t error = graphicBuffer->initCheck();
+
+    if (error == NO_ERROR && !mCore->mIsAbandoned) {
+        graphicBuffer->setGenerationNumber(mCore->mGenerationNumber);
+        mSlots[slot].mGraphicBuffer = graphicBuffer;
+        mCore->mTelemetry.recordAllocation();
+        if (mCore->mConsumerListener != nullptr) {
+            mCore->mConsumerListener->onFrameDequeued(mSlots[slot].mGraphicBuffer->getId());
+        }
+    }
+
+    if (error != NO_ERROR) {
+        mCore->mFreeSlots.insert(slot);
+        mCore->clearBufferSlotLocked(slot);
+        BQ_LOGE("dequeueBuffer: createGraphicBuffer failed");
+        return error;
+    }
+
+    if (mCore->mIsAbandoned) {
+        mCore->mFreeSlots.insert(slot);
+        mCore->clearBufferSlotLocked(slot);
+        BQ_LOGE("dequeueBuffer: BufferQueue has been abandoned");
+        return NO_INIT;
     }
 
-    if (attachedByConsumer) {
+    VALIDATE_CONSISTENCY();
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::finishDequeue(const DequeuedBuffer& dequeued,
+                                            uint64_t* outBufferAge,
+                                            FrameEventHistoryDelta* outTimestamps) {
+    status_t returnFlags = dequeued.returnFlags;
+    if (dequeued.attachedByConsumer) {
         returnFlags |= BUFFER_NEEDS_REALLOCATION;
     }
 
-    if (eglFence != EGL_NO_SYNC_KHR) {
-        EGLint result = eglClientWaitSyncKHR(eglDisplay, eglFence, 0,
+    if (dequeued.eglFence != EGL_NO_SYNC_KHR) {
+        EGLint result = eglClientWaitSyncKHR(dequeued.eglDisplay, dequeued.eglFence, 0,
                 1000000000);
         // If something goes wrong, log the error, but return the buffer without
         // synchronizing access to it. It's too late at this point to abort the
@@ -625,16 +854,16 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
         } else if (result == EGL_TIMEOUT_EXPIRED_KHR) {
             BQ_LOGE("dequeueBuffer: timeout waiting for fence");
         }
-        eglDestroySyncKHR(eglDisplay, eglFence);
+        eglDestroySyncKHR(dequeued.eglDisplay, dequeued.eglFence);
     }
 
     BQ_LOGV("dequeueBuffer: returning slot=%d/%" PRIu64 " buf=%p flags=%#x",
-            *outSlot,
-            mSlots[*outSlot].mFrameNumber,
-            mSlots[*outSlot].mGraphicBuffer->handle, returnFlags);
+            dequeued.slot,
+            mSlots[dequeued.slot].mFrameNumber,
+            mSlots[dequeued.slot].mGraphicBuffer->handle, returnFlags);
 
     if (outBufferAge) {
-        *outBufferAge = mCore->mBufferAge;
+        *outBufferAge = dequeued.bufferAge;
     }
     addAndGetFrameTimestamps(nullptr, outTimestamps);
 
@@ -834,215 +1063,290 @@ status_t BufferQueueProducer::queueBuffer(int slot,
     ATRACE_CALL();
     ATRACE_BUFFER_INDEX(slot);
 
-    int64_t requestedPresentTimestamp;
-    bool isAutoTimestamp;
-    android_dataspace dataSpace;
-    Rect crop(Rect::EMPTY_RECT);
-    int scalingMode;
-    uint32_t transform;
-    uint32_t stickyTransform;
-    sp<Fence> acquireFence;
-    bool getFrameTimestamps = false;
-    input.deflate(&requestedPresentTimestamp, &isAutoTimestamp, &dataSpace,
-            &crop, &scalingMode, &transform, &acquireFence, &stickyTransform,
-            &getFrameTimestamps);
-    const Region& surfaceDamage = input.getSurfaceDamage();
-    const HdrMetadata& hdrMetadata = input.getHdrMetadata();
+    QueuedBuffer queued;
+    status_t status = parseQueueBufferInput(input, &queued);
+    if (status != NO_ERROR) {
+        return status;
+    }
+
+    { // Autolock scope
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        status = queueBufferLocked(slot, input, output, &queued);
+        if (status != NO_ERROR) {
+            return status;
+        }
+    } // Autolock scope
+
+    int connectedApi;
+    sp<Fence> lastQueuedFence;
+    notifyBufferQueued(queued, output, &connectedApi, &lastQueuedFence);
+
+    // Wait without lock held
+    if (connectedApi == NATIVE_WINDOW_API_EGL) {
+        // Waiting here allows for two full buffers to be queued but not a
+        // third. In the event that frames take varying time, this makes a
+        // small trade-off in favor of latency rather than throughput.
+        lastQueuedFence->waitForever("Throttling EGL Production");
+    }
+
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::queueBuffers(const std::vector<QueueBufferInput>& inputs,
+                                           std::vector<QueueBufferOutput>* outputs) {
+    ATRACE_CALL();
+    BQ_LOGV("queueBuffers: %zu buffers", inputs.size());
+    outputs->clear();
+    outputs->resize(inputs.size());
+
+    std::vector<QueuedBuffer> queued(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        (*outputs)[i].result = parseQueueBufferInput(inputs[i], &queued[i]);
+    }
+
+    { // Autolock scope
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if ((*outputs)[i].result == NO_ERROR) {
+                (*outputs)[i].result =
+                        queueBufferLocked(inputs[i].slot, inputs[i], &(*outputs)[i], &queued[i]);
+            }
+        }
+    } // Autolock scope
+
+    // The callback tickets of the batch are consecutive, so the buffers are reported in order
+    // without waiting for other producers.
+    int connectedApi = BufferQueueCore::NO_CONNECTED_API;
+    sp<Fence> lastQueuedFence;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if ((*outputs)[i].result == NO_ERROR) {
+            notifyBufferQueued(queued[i], &(*outputs)[i], &connectedApi, &lastQueuedFence);
+        }
+    }
+
+    // Throttle once for the batch, on the buffer queued before the last one, the same way
+    // queueBuffer does.
+    if (connectedApi == NATIVE_WINDOW_API_EGL) {
+        lastQueuedFence->waitForever("Throttling EGL Production");
+    }
 
-    if (acquireFence == nullptr) {
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::parseQueueBufferInput(const QueueBufferInput& input,
+                                                    QueuedBuffer* queued) {
+    input.deflate(&queued->requestedPresentTimestamp, &queued->isAutoTimestamp,
+            &queued->dataSpace, &queued->crop, &queued->scalingMode, &queued->transform,
+            &queued->acquireFence, &queued->stickyTransform, &queued->getFrameTimestamps);
+
+    if (queued->acquireFence == nullptr) {
         BQ_LOGE("queueBuffer: fence is NULL");
         return BAD_VALUE;
     }
 
-    auto acquireFenceTime = std::make_shared<FenceTime>(acquireFence);
+    queued->acquireFenceTime = std::make_shared<FenceTime>(queued->acquireFence);
 
-    switch (scalingMode) {
+    switch (queued->scalingMode) {
         case NATIVE_WINDOW_SCALING_MODE_FREEZE:
         case NATIVE_WINDOW_SCALING_MODE_SCALE_TO_WINDOW:
         case NATIVE_WINDOW_SCALING_MODE_SCALE_CROP:
         case NATIVE_WINDOW_SCALING_MODE_NO_SCALE_CROP:
             break;
         default:
-            BQ_LOGE("queueBuffer: unknown scaling mode %d", scalingMode);
+            BQ_LOGE("queueBuffer: unknown scaling mode %d", queued->scalingMode);
             return BAD_VALUE;
     }
+    return NO_ERROR;
+}
 
-    sp<IConsumerListener> frameAvailableListener;
-    sp<IConsumerListener> frameReplacedListener;
-    int callbackTicket = 0;
-    uint64_t currentFrameNumber = 0;
-    BufferItem item;
-    { // Autolock scope
-        std::lock_guard<std::mutex> lock(mCore->mMutex);
+status_t BufferQueueProducer::queueBufferLocked(int slot, const QueueBufferInput& input,
+                                                QueueBufferOutput* output, QueuedBuffer* queued) {
+    const Region& surfaceDamage = input.getSurfaceDamage();
+    const HdrMetadata& hdrMetadata = input.getHdrMetadata();
+    const Rect& crop = queued->crop;
+    const uint32_t transform = queued->transform;
+    const int scalingMode = queued->scalingMode;
+    android_dataspace dataSpace = queued->dataSpace;
 
-        if (mCore->mIsAbandoned) {
-            BQ_LOGE("queueBuffer: BufferQueue has been abandoned");
-            return NO_INIT;
-        }
+    if (mCore->mIsAbandoned) {
+        BQ_LOGE("queueBuffer: BufferQueue has been abandoned");
+        return NO_INIT;
+    }
 
-        if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
-            BQ_LOGE("queueBuffer: BufferQueue has no connected producer");
-            return NO_INIT;
-        }
+    if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
+        BQ_LOGE("queueBuffer: BufferQueue has no connected producer");
+        return NO_INIT;
+    }
 
-        if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
-            BQ_LOGE("queueBuffer: slot index %d out of range [0, %d)",
-                    slot, BufferQueueDefs::NUM_BUFFER_SLOTS);
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mBufferState.isDequeued()) {
-            BQ_LOGE("queueBuffer: slot %d is not owned by the producer "
-                    "(state = %s)", slot, mSlots[slot].mBufferState.string());
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mRequestBufferCalled) {
-            BQ_LOGE("queueBuffer: slot %d was queued without requesting "
-                    "a buffer", slot);
-            return BAD_VALUE;
-        }
+    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        BQ_LOGE("queueBuffer: slot index %d out of range [0, %d)",
+                slot, BufferQueueDefs::NUM_BUFFER_SLOTS);
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mBufferState.isDequeued()) {
+        BQ_LOGE("queueBuffer: slot %d is not owned by the producer "
+                "(state = %s)", slot, mSlots[slot].mBufferState.string());
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mRequestBufferCalled) {
+        BQ_LOGE("queueBuffer: slot %d was queued without requesting "
+                "a buffer", slot);
+        return BAD_VALUE;
+    }
 
-        // If shared buffer mode has just been enabled, cache the slot of the
-        // first buffer that is queued and mark it as the shared buffer.
-        if (mCore->mSharedBufferMode && mCore->mSharedBufferSlot ==
-                BufferQueueCore::INVALID_BUFFER_SLOT) {
-            mCore->mSharedBufferSlot = slot;
-            mSlots[slot].mBufferState.mShared = true;
-        }
+    // If shared buffer mode has just been enabled, cache the slot of the
+    // first buffer that is queued and mark it as the shared buffer.
+    if (mCore->mSharedBufferMode && mCore->mSharedBufferSlot ==
+            BufferQueueCore::INVALID_BUFFER_SLOT) {
+        mCore->mSharedBufferSlot = slot;
+        mSlots[slot].mBufferState.mShared = true;
+        mCore->updateHasBufferToAcquireLocked();
+    }
 
-        BQ_LOGV("queueBuffer: slot=%d/%" PRIu64 " time=%" PRIu64 " dataSpace=%d"
-                " validHdrMetadataTypes=0x%x crop=[%d,%d,%d,%d] transform=%#x scale=%s",
-                slot, mCore->mFrameCounter + 1, requestedPresentTimestamp, dataSpace,
-                hdrMetadata.validTypes, crop.left, crop.top, crop.right, crop.bottom,
-                transform,
-                BufferItem::scalingModeName(static_cast<uint32_t>(scalingMode)));
-
-        const sp<GraphicBuffer>& graphicBuffer(mSlots[slot].mGraphicBuffer);
-        Rect bufferRect(graphicBuffer->getWidth(), graphicBuffer->getHeight());
-        Rect croppedRect(Rect::EMPTY_RECT);
-        crop.intersect(bufferRect, &croppedRect);
-        if (croppedRect != crop) {
-            BQ_LOGE("queueBuffer: crop rect is not contained within the "
-                    "buffer in slot %d", slot);
-            return BAD_VALUE;
-        }
+    BQ_LOGV("queueBuffer: slot=%d/%" PRIu64 " time=%" PRIu64 " dataSpace=%d"
+            " validHdrMetadataTypes=0x%x crop=[%d,%d,%d,%d] transform=%#x scale=%s",
+            slot, mCore->mFrameCounter + 1, queued->requestedPresentTimestamp, dataSpace,
+            hdrMetadata.validTypes, crop.left, crop.top, crop.right, crop.bottom,
+            transform,
+            BufferItem::scalingModeName(static_cast<uint32_t>(scalingMode)));
+
+    const sp<GraphicBuffer>& graphicBuffer(mSlots[slot].mGraphicBuffer);
+    Rect bufferRect(graphicBuffer->getWidth(), graphicBuffer->getHeight());
+    Rect croppedRect(Rect::EMPTY_RECT);
+    crop.intersect(bufferRect, &croppedRect);
+    if (croppedRect != crop) {
+        BQ_LOGE("queueBuffer: crop rect is not contained within the "
+                "buffer in slot %d", slot);
+        return BAD_VALUE;
+    }
 
-        // Override UNKNOWN dataspace with consumer default
-        if (dataSpace == HAL_DATASPACE_UNKNOWN) {
-            dataSpace = mCore->mDefaultBufferDataSpace;
-        }
+    // Override UNKNOWN dataspace with consumer default
+    if (dataSpace == HAL_DATASPACE_UNKNOWN) {
+        dataSpace = mCore->mDefaultBufferDataSpace;
+    }
 
-        mSlots[slot].mFence = acquireFence;
-        mSlots[slot].mBufferState.queue();
-
-        // Increment the frame counter and store a local version of it
-        // for use outside the lock on mCore->mMutex.
-        ++mCore->mFrameCounter;
-        currentFrameNumber = mCore->mFrameCounter;
-        mSlots[slot].mFrameNumber = currentFrameNumber;
-
-        item.mAcquireCalled = mSlots[slot].mAcquireCalled;
-        item.mGraphicBuffer = mSlots[slot].mGraphicBuffer;
-        item.mCrop = crop;
-        item.mTransform = transform &
-                ~static_cast<uint32_t>(NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY);
-        item.mTransformToDisplayInverse =
-                (transform & NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY) != 0;
-        item.mScalingMode = static_cast<uint32_t>(scalingMode);
-        item.mTimestamp = requestedPresentTimestamp;
-        item.mIsAutoTimestamp = isAutoTimestamp;
-        item.mDataSpace = dataSpace;
-        item.mHdrMetadata = hdrMetadata;
-        item.mFrameNumber = currentFrameNumber;
-        item.mSlot = slot;
-        item.mFence = acquireFence;
-        item.mFenceTime = acquireFenceTime;
-        item.mIsDroppable = mCore->mAsyncMode ||
-                (mConsumerIsSurfaceFlinger && mCore->mQueueBufferCanDrop) ||
-                (mCore->mLegacyBufferDrop && mCore->mQueueBufferCanDrop) ||
-                (mCore->mSharedBufferMode && mCore->mSharedBufferSlot == slot);
-        item.mSurfaceDamage = surfaceDamage;
-        item.mQueuedBuffer = true;
-        item.mAutoRefresh = mCore->mSharedBufferMode && mCore->mAutoRefresh;
-        item.mApi = mCore->mConnectedApi;
-
-        mStickyTransform = stickyTransform;
-
-        // Cache the shared buffer data so that the BufferItem can be recreated.
-        if (mCore->mSharedBufferMode) {
-            mCore->mSharedBufferCache.crop = crop;
-            mCore->mSharedBufferCache.transform = transform;
-            mCore->mSharedBufferCache.scalingMode = static_cast<uint32_t>(
-                    scalingMode);
-            mCore->mSharedBufferCache.dataspace = dataSpace;
-        }
+    mSlots[slot].mFence = queued->acquireFence;
+    mSlots[slot].mBufferState.queue();
 
-        output->bufferReplaced = false;
-        if (mCore->mQueue.empty()) {
-            // When the queue is empty, we can ignore mDequeueBufferCannotBlock
-            // and simply queue this buffer
-            mCore->mQueue.push_back(item);
-            frameAvailableListener = mCore->mConsumerListener;
-        } else {
-            // When the queue is not empty, we need to look at the last buffer
-            // in the queue to see if we need to replace it
-            const BufferItem& last = mCore->mQueue.itemAt(
-                    mCore->mQueue.size() - 1);
-            if (last.mIsDroppable) {
-
-                if (!last.mIsStale) {
-                    mSlots[last.mSlot].mBufferState.freeQueued();
-
-                    // After leaving shared buffer mode, the shared buffer will
-                    // still be around. Mark it as no longer shared if this
-                    // operation causes it to be free.
-                    if (!mCore->mSharedBufferMode &&
-                            mSlots[last.mSlot].mBufferState.isFree()) {
-                        mSlots[last.mSlot].mBufferState.mShared = false;
-                    }
-                    // Don't put the shared buffer on the free list.
-                    if (!mSlots[last.mSlot].mBufferState.isShared()) {
-                        mCore->mActiveBuffers.erase(last.mSlot);
-                        mCore->mFreeBuffers.push_back(last.mSlot);
-                        output->bufferReplaced = true;
-                    }
-                }
+    // Increment the frame counter and store a local version of it
+    // for use outside the lock on mCore->mMutex.
+    ++mCore->mFrameCounter;
+    queued->frameNumber = mCore->mFrameCounter;
+    mSlots[slot].mFrameNumber = queued->frameNumber;
+    if (mCore->mTelemetry.isEnabled()) {
+        mCore->mTelemetry.recordQueued(slot, systemTime());
+    }
 
-                // Make sure to merge the damage rect from the frame we're about
-                // to drop into the new frame's damage rect.
-                if (last.mSurfaceDamage.bounds() == Rect::INVALID_RECT ||
-                    item.mSurfaceDamage.bounds() == Rect::INVALID_RECT) {
-                    item.mSurfaceDamage = Region::INVALID_REGION;
-                } else {
-                    item.mSurfaceDamage |= last.mSurfaceDamage;
+    BufferItem& item = queued->item;
+    item.mAcquireCalled = mSlots[slot].mAcquireCalled;
+    item.mGraphicBuffer = mSlots[slot].mGraphicBuffer;
+    item.mCrop = crop;
+    item.mTransform = transform &
+            ~static_cast<uint32_t>(NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY);
+    item.mTransformToDisplayInverse =
+            (transform & NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY) != 0;
+    item.mScalingMode = static_cast<uint32_t>(scalingMode);
+    item.mTimestamp = queued->requestedPresentTimestamp;
+    item.mIsAutoTimestamp = queued->isAutoTimestamp;
+    item.mDataSpace = dataSpace;
+    item.mHdrMetadata = hdrMetadata;
+    item.mFrameNumber = queued->frameNumber;
+    item.mSlot = slot;
+    item.mFence = queued->acquireFence;
+    item.mFenceTime = queued->acquireFenceTime;
+    item.mIsDroppable = mCore->mAsyncMode ||
+            (mConsumerIsSurfaceFlinger && mCore->mQueueBufferCanDrop) ||
+            (mCore->mLegacyBufferDrop && mCore->mQueueBufferCanDrop) ||
+            (mCore->mSharedBufferMode && mCore->mSharedBufferSlot == slot);
+    item.mSurfaceDamage = surfaceDamage;
+    item.mQueuedBuffer = true;
+    item.mAutoRefresh = mCore->mSharedBufferMode && mCore->mAutoRefresh;
+    item.mApi = mCore->mConnectedApi;
+
+    mStickyTransform = queued->stickyTransform;
+
+    // Cache the shared buffer data so that the BufferItem can be recreated.
+    if (mCore->mSharedBufferMode) {
+        mCore->mSharedBufferCache.crop = crop;
+        mCore->mSharedBufferCache.transform = transform;
+        mCore->mSharedBufferCache.scalingMode = static_cast<uint32_t>(
+                scalingMode);
+        mCore->mSharedBufferCache.dataspace = dataSpace;
+    }
+
+    output->bufferReplaced = false;
+    if (mCore->mQueue.empty()) {
+        // When the queue is empty, we can ignore mDequeueBufferCannotBlock
+        // and simply queue this buffer
+        mCore->mQueue.push_back(item);
+        queued->frameAvailableListener = mCore->mConsumerListener;
+    } else {
+        // When the queue is not empty, we need to look at the last buffer
+        // in the queue to see if we need to replace it
+        const BufferItem& last = mCore->mQueue.itemAt(
+                mCore->mQueue.size() - 1);
+        if (last.mIsDroppable) {
+
+            if (!last.mIsStale) {
+                mSlots[last.mSlot].mBufferState.freeQueued();
+
+                // After leaving shared buffer mode, the shared buffer will
+                // still be around. Mark it as no longer shared if this
+                // operation causes it to be free.
+                if (!mCore->mSharedBufferMode &&
+                        mSlots[last.mSlot].mBufferState.isFree()) {
+                    mSlots[last.mSlot].mBufferState.mShared = false;
+                }
+                // Don't put the shared buffer on the free list.
+                if (!mSlots[last.mSlot].mBufferState.isShared()) {
+                    mCore->mActiveBuffers.erase(last.mSlot);
+                    mCore->mFreeBuffers.push_back(last.mSlot);
+                    output->bufferReplaced = true;
                 }
+            }
 
-                // Overwrite the droppable buffer with the incoming one
-                mCore->mQueue.editItemAt(mCore->mQueue.size() - 1) = item;
-                frameReplacedListener = mCore->mConsumerListener;
+            // Make sure to merge the damage rect from the frame we're about
+            // to drop into the new frame's damage rect.
+            if (last.mSurfaceDamage.bounds() == Rect::INVALID_RECT ||
+                item.mSurfaceDamage.bounds() == Rect::INVALID_RECT) {
+                item.mSurfaceDamage = Region::INVALID_REGION;
             } else {
-                mCore->mQueue.push_back(item);
-                frameAvailableListener = mCore->mConsumerListener;
+                item.mSurfaceDamage |= last.mSurfaceDamage;
             }
+
+            // Overwrite the droppable buffer with the incoming one
+            mCore->mQueue.editItemAt(mCore->mQueue.size() - 1) = item;
+            queued->frameReplacedListener = mCore->mConsumerListener;
+        } else {
+            mCore->mQueue.push_back(item);
+            queued->frameAvailableListener = mCore->mConsumerListener;
         }
+    }
 
-        mCore->mBufferHasBeenQueued = true;
-        mCore->mDequeueCondition.notify_all();
-        mCore->mLastQueuedSlot = slot;
+    mCore->updateHasBufferToAcquireLocked();
+    mCore->mBufferHasBeenQueued = true;
+    mCore->mDequeueCondition.notify_all();
+    mCore->mLastQueuedSlot = slot;
 
-        output->width = mCore->mDefaultWidth;
-        output->height = mCore->mDefaultHeight;
-        output->transformHint = mCore->mTransformHintInUse = mCore->mTransformHint;
-        output->numPendingBuffers = static_cast<uint32_t>(mCore->mQueue.size());
-        output->nextFrameNumber = mCore->mFrameCounter + 1;
+    output->width = mCore->mDefaultWidth;
+    output->height = mCore->mDefaultHeight;
+    output->transformHint = mCore->mTransformHintInUse = mCore->mTransformHint;
+    output->numPendingBuffers = static_cast<uint32_t>(mCore->mQueue.size());
+    output->nextFrameNumber = mCore->mFrameCounter + 1;
 
-        ATRACE_INT(mCore->mConsumerName.string(),
-                static_cast<int32_t>(mCore->mQueue.size()));
+    ATRACE_INT(mCore->mConsumerName.string(),
+            static_cast<int32_t>(mCore->mQueue.size()));
 #ifndef NO_BINDER
-        mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
+    mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
-        // Take a ticket for the callback functions
-        callbackTicket = mNextCallbackTicket++;
+    // Take a ticket for the callback functions
+    queued->callbackTicket = mNextCallbackTicket++;
 
-        VALIDATE_CONSISTENCY();
-    } // Autolock scope
+    VALIDATE_CONSISTENCY();
+    return NO_ERROR;
+}
+
+void BufferQueueProducer::notifyBufferQueued(QueuedBuffer& queued, QueueBufferOutput* output,
+                                             int* outConnectedApi, sp<Fence>* outLastQueuedFence) {
+    BufferItem& item = queued.item;
 
     // It is okay not to clear the GraphicBuffer when the consumer is SurfaceFlinger because
     // it is guaranteed that the BufferQueue is inside SurfaceFlinger's process and
@@ -1054,59 +1358,62 @@ status_t BufferQueueProducer::queueBuffer(int slot,
     // Update and get FrameEventHistory.
     nsecs_t postedTime = systemTime(SYSTEM_TIME_MONOTONIC);
     NewFrameEventsEntry newFrameEventsEntry = {
-        currentFrameNumber,
+        queued.frameNumber,
         postedTime,
-        requestedPresentTimestamp,
-        std::move(acquireFenceTime)
+        queued.requestedPresentTimestamp,
+        std::move(queued.acquireFenceTime)
     };
     addAndGetFrameTimestamps(&newFrameEventsEntry,
-            getFrameTimestamps ? &output->frameTimestamps : nullptr);
+            queued.getFrameTimestamps ? &output->frameTimestamps : nullptr);
 
     // Call back without the main BufferQueue lock held, but with the callback
     // lock held so we can ensure that callbacks occur in order
 
-    int connectedApi;
-    sp<Fence> lastQueuedFence;
-
     { // scope for the lock
         std::unique_lock<std::mutex> lock(mCallbackMutex);
-        while (callbackTicket != mCurrentCallbackTicket) {
+        while (queued.callbackTicket != mCurrentCallbackTicket) {
             mCallbackCondition.wait(lock);
         }
 
-        if (frameAvailableListener != nullptr) {
-            frameAvailableListener->onFrameAvailable(item);
-        } else if (frameReplacedListener != nullptr) {
-            frameReplacedListener->onFrameReplaced(item);
+        if (queued.frameAvailableListener != nullptr) {
+            queued.frameAvailableListener->onFrameAvailable(item);
+        } else if (queued.frameReplacedListener != nullptr) {
+            queued.frameReplacedListener->onFrameReplaced(item);
         }
 
-        connectedApi = mCore->mConnectedApi;
-        lastQueuedFence = std::move(mLastQueueBufferFence);
+        *outConnectedApi = mCore->mConnectedApi;
+        *outLastQueuedFence = std::move(mLastQueueBufferFence);
 
-        mLastQueueBufferFence = std::move(acquireFence);
+        mLastQueueBufferFence = std::move(queued.acquireFence);
         mLastQueuedCrop = item.mCrop;
         mLastQueuedTransform = item.mTransform;
 
         ++mCurrentCallbackTicket;
         mCallbackCondition.notify_all();
     }
-
-    // Wait without lock held
-    if (connectedApi == NATIVE_WINDOW_API_EGL) {
-        // Waiting here allows for two full buffers to be queued but not a
-        // third. In the event that frames take varying time, this makes a
-        // small trade-off in favor of latency rather than throughput.
-        lastQueuedFence->waitForever("Throttling EGL Production");
-    }
-
-    return NO_ERROR;
 }
 
 status_t BufferQueueProducer::cancelBuffer(int slot, const sp<Fence>& fence) {
     ATRACE_CALL();
     BQ_LOGV("cancelBuffer: slot %d", slot);
     std::lock_guard<std::mutex> lock(mCore->mMutex);
+    return cancelBufferLocked(slot, fence);
+}
+
+status_t BufferQueueProducer::cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+                                            std::vector<status_t>* results) {
+    ATRACE_CALL();
+    BQ_LOGV("cancelBuffers: %zu buffers", inputs.size());
+    results->clear();
+    results->reserve(inputs.size());
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    for (const CancelBufferInput& input : inputs) {
+        results->emplace_back(cancelBufferLocked(input.slot, input.fence));
+    }
+    return NO_ERROR;
+}
 
+status_t BufferQueueProducer::cancelBufferLocked(int slot, const sp<Fence>& fence) {
     if (mCore->mIsAbandoned) {
         BQ_LOGE("cancelBuffer: BufferQueue has been abandoned");
         return NO_INIT;
@@ -1376,6 +1683,7 @@ status_t BufferQueueProducer::disconnect(int api, DisconnectMode mode) {
 #endif
                     mCore->mSharedBufferSlot =
                             BufferQueueCore::INVALID_BUFFER_SLOT;
+                    mCore->updateHasBufferToAcquireLocked();
                     mCore->mLinkedToDeath = nullptr;
                     mCore->mConnectedProducerListener = nullptr;
                     mCore->mConnectedApi = BufferQueueCore::NO_CONNECTED_API;
@@ -1445,9 +1753,10 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
                 return;
             }
 
-            // Only allocate one buffer at a time to reduce risks of overlapping an allocation from
-            // both allocateBuffers and dequeueBuffer.
-            newBufferCount = mCore->mFreeSlots.empty() ? 0 : 1;
+            // Allocate the buffers of all of the free slots in a single call to the allocator. A
+            // dequeueBuffer that needs a buffer meanwhile waits for the batch, and takes one of its
+            // buffers.
+            newBufferCount = mCore->mFreeSlots.size();
             if (newBufferCount == 0) {
                 return;
             }
@@ -1466,23 +1775,18 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
             mCore->mIsAllocating = true;
         } // Autolock scope
 
-        Vector<sp<GraphicBuffer>> buffers;
-        for (size_t i = 0; i < newBufferCount; ++i) {
-            sp<GraphicBuffer> graphicBuffer = new GraphicBuffer(
-                    allocWidth, allocHeight, allocFormat, BQ_LAYER_COUNT,
-                    allocUsage, allocName);
-
-            status_t result = graphicBuffer->initCheck();
-
-            if (result != NO_ERROR) {
-                BQ_LOGE("allocateBuffers: failed to allocate buffer (%u x %u, format"
-                        " %u, usage %#" PRIx64 ")", width, height, format, usage);
-                std::lock_guard<std::mutex> lock(mCore->mMutex);
-                mCore->mIsAllocating = false;
-                mCore->mIsAllocatingCondition.notify_all();
-                return;
-            }
-            buffers.push_back(graphicBuffer);
+        std::vector<sp<GraphicBuffer>> buffers;
+        status_t result = GraphicBuffer::allocateBatch(allocWidth, allocHeight, allocFormat,
+                                                       BQ_LAYER_COUNT, allocUsage,
+                                                       static_cast<uint32_t>(newBufferCount),
+                                                       allocName, &buffers);
+        if (result != NO_ERROR) {
+            BQ_LOGE("allocateBuffers: failed to allocate %zu buffers (%u x %u, format"
+                    " %u, usage %#" PRIx64 ")", newBufferCount, width, height, format, usage);
+            std::lock_guard<std::mutex> lock(mCore->mMutex);
+            mCore->mIsAllocating = false;
+            mCore->mIsAllocatingCondition.notify_all();
+            return;
         }
 
         { // Autolock scope
@@ -1523,6 +1827,7 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
 
                 BQ_LOGV("allocateBuffers: allocated a new buffer in slot %d",
                         *slot);
+                mCore->mTelemetry.recordAllocation();
 
                 // Make sure the erase is done after all uses of the slot
                 // iterator since it will be invalid after this point.
@@ -1576,6 +1881,7 @@ status_t BufferQueueProducer::setSharedBufferMode(bool sharedBufferMode) {
         mCore->mSharedBufferSlot = BufferQueueCore::INVALID_BUFFER_SLOT;
     }
     mCore->mSharedBufferMode = sharedBufferMode;
+    mCore->updateHasBufferToAcquireLocked();
     return NO_ERROR;
 }
 
@@ -1586,6 +1892,7 @@ status_t BufferQueueProducer::setAutoRefresh(bool autoRefresh) {
     std::lock_guard<std::mutex> lock(mCore->mMutex);
 
     mCore->mAutoRefresh = autoRefresh;
+    mCore->updateHasBufferToAcquireLocked();
     return NO_ERROR;
 }
 
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <gui/BufferQueueTelemetry.h>
+
+#include <android-base/properties.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <iterator>
+
+namespace android {
+
+namespace {
+
+constexpr const char* kLatencyNames[] = {"dequeueWait", "queueToAcquire", "acquireToRelease"};
+static_assert(std::size(kLatencyNames) ==
+              static_cast<size_t>(BufferQueueTelemetry::Latency::COUNT));
+
+} // namespace
+
+void BufferQueueTelemetry::Histogram::record(nsecs_t duration) {
+    const auto bucket =
+            std::lower_bound(kBucketBounds.begin(), kBucketBounds.end(), duration) -
+            kBucketBounds.begin();
+    counts[static_cast<size_t>(bucket)]++;
+    total++;
+    sum += duration;
+    max = std::max(max, duration);
+}
+
+nsecs_t BufferQueueTelemetry::Histogram::percentile(uint32_t percent) const {
+    if (total == 0) {
+        return 0;
+    }
+    // The rank of the percentile, rounded up, from 1.
+    const uint64_t rank = std::max<uint64_t>(1, (total * percent + 99) / 100);
+    uint64_t count = 0;
+    for (size_t i = 0; i < kBucketBounds.size(); i++) {
+        count += counts[i];
+        if (count >= rank) {
+            return std::min(kBucketBounds[i], max);
+        }
+    }
+    return max;
+}
+
+bool BufferQueueTelemetry::isEnabledByProperty() {
+    return base::GetBoolProperty("debug.bq.telemetry", false);
+}
+
+void BufferQueueTelemetry::setName(const String8& consumerName) {
+    if (!mEnabled) {
+        return;
+    }
+    const std::string name(consumerName.string());
+    for (size_t i = 0; i < mTrackNames.size(); i++) {
+        mTrackNames[i] = name + ' ' + kLatencyNames[i];
+    }
+    mStarvationTrackName = name + " starvations";
+    mAllocationTrackName = name + " allocations";
+}
+
+void BufferQueueTelemetry::recordDequeueWait(nsecs_t duration) {
+    record(Latency::DequeueWait, duration);
+}
+
+void BufferQueueTelemetry::recordStarvation() {
+    if (!mEnabled) {
+        return;
+    }
+    mStarvationCount++;
+    if (CC_UNLIKELY(ATRACE_ENABLED())) {
+        ATRACE_INT64(mStarvationTrackName.c_str(), static_cast<int64_t>(mStarvationCount));
+    }
+}
+
+void BufferQueueTelemetry::recordAllocation() {
+    if (!mEnabled) {
+        return;
+    }
+    mAllocationCount++;
+    if (CC_UNLIKELY(ATRACE_ENABLED())) {
+        ATRACE_INT64(mAllocationTrackName.c_str(), static_cast<int64_t>(mAllocationCount));
+    }
+}
+
+void BufferQueueTelemetry::recordQueued(int slot, nsecs_t now) {
+    if (!mEnabled || slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        return;
+    }
+    mQueueTimes[static_cast<size_t>(slot)] = now;
+}
+
+void BufferQueueTelemetry::recordAcquired(int slot, nsecs_t now) {
+    if (!mEnabled || slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        return;
+    }
+    // The queue time is not set for the shared buffer when it is acquired again without being
+    // queued.
+    nsecs_t& queueTime = mQueueTimes[static_cast<size_t>(slot)];
+    if (queueTime != 0) {
+        record(Latency::QueueToAcquire, now - queueTime);
+        queueTime = 0;
+    }
+    mAcquireTimes[static_cast<size_t>(slot)] = now;
+}
+
+void BufferQueueTelemetry::recordReleased(int slot, nsecs_t now) {
+    if (!mEnabled || slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        return;
+    }
+    nsecs_t& acquireTime = mAcquireTimes[static_cast<size_t>(slot)];
+    if (acquireTime != 0) {
+        record(Latency::AcquireToRelease, now - acquireTime);
+        acquireTime = 0;
+    }
+}
+
+void BufferQueueTelemetry::recordCleared(int slot) {
+    if (!mEnabled || slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        return;
+    }
+    mQueueTimes[static_cast<size_t>(slot)] = 0;
+    mAcquireTimes[static_cast<size_t>(slot)] = 0;
+}
+
+void BufferQueueTelemetry::record(Latency latency, nsecs_t duration) {
+    if (!mEnabled) {
+        return;
+    }
+    const size_t index = static_cast<size_t>(latency);
+    mHistograms[index].record(duration);
+    if (CC_UNLIKELY(ATRACE_ENABLED())) {
+        ATRACE_INT64(mTrackNames[index].c_str(), duration);
+    }
+}
+
+void BufferQueueTelemetry::dump(const String8& prefix, String8* outResult) const {
+    if (!mEnabled) {
+        return;
+    }
+    outResult->appendFormat("%sTelemetry: starvations=%" PRIu64 " allocations=%" PRIu64 "\n",
+                            prefix.string(), mStarvationCount, mAllocationCount);
+    for (size_t i = 0; i < mHistograms.size(); i++) {
+        const Histogram& histogram = mHistograms[i];
+        const nsecs_t average =
+                histogram.total > 0 ? histogram.sum / static_cast<nsecs_t>(histogram.total) : 0;
+        outResult->appendFormat("%s  %s: count=%" PRIu64 " avg=%.3fms p50=%.3fms p90=%.3fms"
+                                " p99=%.3fms max=%.3fms\n",
+                                prefix.string(), kLatencyNames[i], histogram.total, average / 1e6,
+                                histogram.percentile(50) / 1e6, histogram.percentile(90) / 1e6,
+                                histogram.percentile(99) / 1e6, histogram.max / 1e6);
+        outResult->appendFormat("%s    buckets(ms):", prefix.string());
+        for (size_t bucket = 0; bucket < kBucketCount; bucket++) {
+            if (bucket < kBucketBounds.size()) {
+                outResult->appendFormat(" <=%.2f:%" PRIu64, kBucketBounds[bucket] / 1e6,
+                                        histogram.counts[bucket]);
+            } else {
+                outResult->appendFormat(" >%.2f:%" PRIu64, kBucketBounds.back() / 1e6,
+                                        histogram.counts[bucket]);
+            }
+        }
+        outResult->append("\n");
+    }
+}
+
+} // namespace android
@@ -21,6 +21,8 @@
 #include <gui/TraceUtils.h>
 #include <jni.h>
 
+#include <algorithm>
+
 #undef LOG_TAG
 #define LOG_TAG "AChoreographer"
 
@@ -145,7 +147,21 @@ void Choreographer::postFrameCallbackDelayed(AChoreographer_frameCallback cb,
                                              AChoreographer_vsyncCallback vsyncCallback, void* data,
                                              nsecs_t delay) {
     nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
-    FrameCallback callback{cb, cb64, vsyncCallback, data, now + delay};
+    postFrameCallback(FrameCallback{cb, cb64, vsyncCallback, data, now + delay}, now, delay);
+}
+
+void Choreographer::postVsyncCallback(AChoreographer_vsyncCallback vsyncCallback, void* data,
+                                      nsecs_t expectedCost, bool deferrable) {
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    postFrameCallback(FrameCallback{.vsyncCallback = vsyncCallback,
+                                    .data = data,
+                                    .dueTime = now,
+                                    .expectedCost = std::max<nsecs_t>(expectedCost, 0),
+                                    .deferrable = deferrable},
+                      now, 0);
+}
+
+void Choreographer::postFrameCallback(const FrameCallback& callback, nsecs_t now, nsecs_t delay) {
     {
         std::lock_guard<std::mutex> _l{mLock};
         mFrameCallbacks.push(callback);
@@ -297,18 +313,10 @@ void Choreographer::dispatchVsync(nsecs_t timestamp, PhysicalDisplayId, uint32_t
         }
     }
     mLastVsyncEventData = vsyncEventData;
+    orderCallbacksForFrame(callbacks);
     for (const auto& cb : callbacks) {
         if (cb.vsyncCallback != nullptr) {
-            ATRACE_FORMAT("AChoreographer_vsyncCallback %" PRId64,
-                          vsyncEventData.preferredVsyncId());
-            const ChoreographerFrameCallbackDataImpl frameCallbackData =
-                    createFrameCallbackData(timestamp);
-            registerStartTime();
-            mInCallback = true;
-            cb.vsyncCallback(reinterpret_cast<const AChoreographerFrameCallbackData*>(
-                                     &frameCallbackData),
-                             cb.data);
-            mInCallback = false;
+            dispatchVsyncCallback(cb, timestamp);
         } else if (cb.callback64 != nullptr) {
             ATRACE_FORMAT("AChoreographer_frameCallback64");
             cb.callback64(timestamp, cb.data);
@@ -319,6 +327,56 @@ void Choreographer::dispatchVsync(nsecs_t timestamp, PhysicalDisplayId, uint32_t
     }
 }
 
+void Choreographer::dispatchVsyncCallback(const FrameCallback& callback, nsecs_t timestamp) {
+    ChoreographerFrameCallbackDataImpl frameCallbackData = createFrameCallbackData(timestamp);
+    VsyncEventData& vsyncEventData = frameCallbackData.vsyncEventData;
+    if (callback.deferrable) {
+        const uint32_t index = selectFrameTimeline(vsyncEventData,
+                                                   systemTime(SYSTEM_TIME_MONOTONIC),
+                                                   callback.expectedCost);
+        if (index != vsyncEventData.preferredFrameTimelineIndex) {
+            vsyncEventData.preferredFrameTimelineIndex = index;
+            mDeferredCallbackCount++;
+        }
+    }
+
+    ATRACE_FORMAT("AChoreographer_vsyncCallback %" PRId64, vsyncEventData.preferredVsyncId());
+    registerStartTime();
+    mInCallback = true;
+    callback.vsyncCallback(reinterpret_cast<const AChoreographerFrameCallbackData*>(
+                                   &frameCallbackData),
+                           callback.data);
+    mInCallback = false;
+
+    if (systemTime(SYSTEM_TIME_MONOTONIC) > vsyncEventData.preferredDeadlineTimestamp()) {
+        mDeadlineOverrunCount++;
+        ATRACE_INT64("AChoreographer deadline overruns",
+                     static_cast<int64_t>(mDeadlineOverrunCount.load()));
+    }
+}
+
+void Choreographer::orderCallbacksForFrame(std::vector<FrameCallback>& callbacks) {
+    const auto deferrable = std::stable_partition(callbacks.begin(), callbacks.end(),
+                                                  [](const FrameCallback& callback) {
+                                                      return !callback.deferrable;
+                                                  });
+    std::stable_sort(deferrable, callbacks.end(),
+                     [](const FrameCallback& lhs, const FrameCallback& rhs) {
+                         return lhs.expectedCost < rhs.expectedCost;
+                     });
+}
+
+uint32_t Choreographer::selectFrameTimeline(const VsyncEventData& vsyncEventData, nsecs_t now,
+                                            nsecs_t expectedCost) {
+    const uint32_t preferred = vsyncEventData.preferredFrameTimelineIndex;
+    for (uint32_t i = preferred; i < vsyncEventData.frameTimelinesLength; i++) {
+        if (now + expectedCost <= vsyncEventData.frameTimelines[i].deadlineTimestamp) {
+            return i;
+        }
+    }
+    return preferred;
+}
+
 void Choreographer::dispatchHotplug(nsecs_t, PhysicalDisplayId displayId, bool connected) {
     ALOGV("choreographer %p ~ received hotplug event (displayId=%s, connected=%s), ignoring.", this,
           to_string(displayId).c_str(), toString(connected));
@@ -21,6 +21,7 @@
 #include <gui/CpuConsumer.h>
 
 #include <gui/BufferItem.h>
+#include <ui/GraphicBufferMapper.h>
 #include <utils/Log.h>
 
 #define CC_LOGV(x, ...) ALOGV("[%s] " x, mName.string(), ##__VA_ARGS__)
@@ -44,6 +45,10 @@ CpuConsumer::CpuConsumer(const sp<IGraphicBufferConsumer>& bq,
     mConsumer->setMaxAcquiredBufferCount(static_cast<int32_t>(maxLockedBuffers));
 }
 
+CpuConsumer::~CpuConsumer() {
+    setLockAheadDepth(0);
+}
+
 size_t CpuConsumer::findAcquiredBufferLocked(uintptr_t id) const {
     for (size_t i = 0; i < mMaxLockedBuffers; i++) {
         const auto& ab = mAcquiredBuffers[i];
@@ -149,6 +154,32 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
     return OK;
 }
 
+void CpuConsumer::setPersistentMapping(bool enabled) {
+    Mutex::Autolock _l(mMutex);
+    mPersistentMapping = enabled;
+}
+
+void CpuConsumer::mapPersistently(const GraphicBuffer& buffer) const {
+    // Map the buffer the way lockBufferItem locks it, or the mapping would be dropped by its
+    // first lock.
+    const PixelFormat format = buffer.getPixelFormat();
+    bool ycbcr;
+    if (format == HAL_PIXEL_FORMAT_YCbCr_420_888) {
+        ycbcr = true;
+    } else if (!isPossiblyYUV(format)) {
+        ycbcr = false;
+    } else {
+        return;
+    }
+
+    GraphicBufferMapper& mapper = GraphicBufferMapper::get();
+    if (!mapper.isPersistentlyMapped(buffer.handle)) {
+        const status_t err =
+                mapper.enablePersistentMapping(buffer.handle, GRALLOC_USAGE_SW_READ_OFTEN, ycbcr);
+        CC_LOGV("enablePersistentMapping: %s (%d)", strerror(-err), err);
+    }
+}
+
 status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     status_t err;
 
@@ -156,12 +187,24 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
 
     Mutex::Autolock _l(mMutex);
 
+    if (!mLockedAheadBuffers.empty()) {
+        *nativeBuffer = mLockedAheadBuffers.front();
+        mLockedAheadBuffers.pop_front();
+        mLockAheadCondition.signal();
+        return OK;
+    }
+
     if (mCurrentLockedBuffers == mMaxLockedBuffers) {
         CC_LOGW("Max buffers have been locked (%zd), cannot lock anymore.",
                 mMaxLockedBuffers);
         return NOT_ENOUGH_DATA;
     }
 
+    if (mLockAheadDepth > 0) {
+        // The next buffer is returned once mLockAheadThread has locked it.
+        return BAD_VALUE;
+    }
+
     BufferItem b;
     err = acquireBufferLocked(&b, 0);
     if (err != OK) {
@@ -177,28 +220,43 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
         b.mGraphicBuffer = mSlots[b.mSlot].mGraphicBuffer;
     }
 
+    if (mPersistentMapping) {
+        mapPersistently(*b.mGraphicBuffer);
+    }
+
     err = lockBufferItem(b, nativeBuffer);
     if (err != OK) {
         return err;
     }
 
+    trackLockedBufferLocked(b, *nativeBuffer);
+    mCurrentLockedBuffers++;
+
+    return OK;
+}
+
+void CpuConsumer::trackLockedBufferLocked(const BufferItem& item, const LockedBuffer& buffer) {
     // find an unused AcquiredBuffer
     size_t lockedIdx = findAcquiredBufferLocked(AcquiredBuffer::kUnusedId);
     ALOG_ASSERT(lockedIdx < mMaxLockedBuffers);
     AcquiredBuffer& ab = mAcquiredBuffers.editItemAt(lockedIdx);
 
-    ab.mSlot = b.mSlot;
-    ab.mGraphicBuffer = b.mGraphicBuffer;
-    ab.mLockedBufferId = getLockedBufferId(*nativeBuffer);
-
-    mCurrentLockedBuffers++;
-
-    return OK;
+    ab.mSlot = item.mSlot;
+    ab.mGraphicBuffer = item.mGraphicBuffer;
+    ab.mLockedBufferId = getLockedBufferId(buffer);
 }
 
 status_t CpuConsumer::unlockBuffer(const LockedBuffer &nativeBuffer) {
     Mutex::Autolock _l(mMutex);
 
+    status_t err = unlockBufferLocked(nativeBuffer);
+    if (err == OK) {
+        mLockAheadCondition.signal();
+    }
+    return err;
+}
+
+status_t CpuConsumer::unlockBufferLocked(const LockedBuffer& nativeBuffer) {
     uintptr_t id = getLockedBufferId(nativeBuffer);
     size_t lockedIdx =
         (id != AcquiredBuffer::kUnusedId) ? findAcquiredBufferLocked(id) : mMaxLockedBuffers;
@@ -228,4 +286,108 @@ status_t CpuConsumer::unlockBuffer(const LockedBuffer &nativeBuffer) {
     return OK;
 }
 
+status_t CpuConsumer::setLockAheadDepth(size_t depth) {
+    if (depth > mMaxLockedBuffers) {
+        CC_LOGE("%s: Depth %zu exceeds the max locked buffers (%zu)", __FUNCTION__, depth,
+                mMaxLockedBuffers);
+        return BAD_VALUE;
+    }
+
+    std::thread thread;
+    {
+        Mutex::Autolock _l(mMutex);
+        mLockAheadDepth = depth;
+        mLockAheadCondition.signal();
+        if (depth > 0) {
+            if (!mLockAheadThread.joinable()) {
+                mLockAheadThread = std::thread(&CpuConsumer::lockAheadLoop, this);
+            }
+            return OK;
+        }
+        thread = std::move(mLockAheadThread);
+    }
+
+    // The thread may be waiting for a fence, so join it outside of mMutex.
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    Mutex::Autolock _l(mMutex);
+    returnLockedAheadBuffersLocked();
+    return OK;
+}
+
+void CpuConsumer::returnLockedAheadBuffersLocked() {
+    for (const LockedBuffer& buffer : mLockedAheadBuffers) {
+        unlockBufferLocked(buffer);
+    }
+    mLockedAheadBuffers.clear();
+}
+
+bool CpuConsumer::canLockAheadLocked() const {
+    return !mAbandoned && mCurrentLockedBuffers < mMaxLockedBuffers &&
+            mLockingAheadCount + mLockedAheadBuffers.size() < mLockAheadDepth;
+}
+
+void CpuConsumer::lockAheadLoop() {
+    Mutex::Autolock _l(mMutex);
+
+    while (mLockAheadDepth > 0) {
+        BufferItem item;
+        if (!canLockAheadLocked() || acquireBufferLocked(&item, 0) != OK) {
+            mLockAheadCondition.wait(mMutex);
+            continue;
+        }
+
+        if (item.mGraphicBuffer == nullptr) {
+            item.mGraphicBuffer = mSlots[item.mSlot].mGraphicBuffer;
+        }
+        mCurrentLockedBuffers++;
+        mLockingAheadCount++;
+
+        // Map the buffer and wait for its fence without blocking the consumer, which can unlock
+        // buffers and take the buffers locked ahead in the meantime.
+        mMutex.unlock();
+        mapPersistently(*item.mGraphicBuffer);
+        LockedBuffer buffer;
+        const status_t err = lockBufferItem(item, &buffer);
+        mMutex.lock();
+
+        mLockingAheadCount--;
+        if (err != OK) {
+            releaseBufferLocked(item.mSlot, item.mGraphicBuffer);
+            mCurrentLockedBuffers--;
+            continue;
+        }
+
+        trackLockedBufferLocked(item, buffer);
+        mLockedAheadBuffers.push_back(buffer);
+
+        if (mLockAheadDepth > 0) {
+            mMutex.unlock();
+            ConsumerBase::onFrameAvailable(item);
+            mMutex.lock();
+        }
+    }
+}
+
+void CpuConsumer::onFrameAvailable(const BufferItem& item) {
+    {
+        Mutex::Autolock _l(mMutex);
+        if (mLockAheadDepth > 0) {
+            // The listener is called once the buffer is locked.
+            mLockAheadCondition.signal();
+            return;
+        }
+    }
+    ConsumerBase::onFrameAvailable(item);
+}
+
+void CpuConsumer::abandonLocked() {
+    mLockAheadDepth = 0;
+    mLockAheadCondition.signal();
+    returnLockedAheadBuffersLocked();
+    ConsumerBase::abandonLocked();
+}
+
 } // namespace android
@@ -203,7 +203,19 @@ bool DisplayEventDispatcher::processPendingEvents(nsecs_t* outTimestamp,
 
 status_t DisplayEventDispatcher::getLatestVsyncEventData(
         ParcelableVsyncEventData* outVsyncEventData) const {
+    if (const auto* mailbox = mReceiver.getVsyncMailbox()) {
+        // The timelines are only current until the preferred deadline passes.
+        if (const auto vsync = mailbox->read();
+            vsync && vsync->vsyncData.preferredDeadlineTimestamp() > systemTime()) {
+            outVsyncEventData->vsync = vsync->vsyncData;
+            return OK;
+        }
+    }
     return mReceiver.getLatestVsyncEventData(outVsyncEventData);
 }
 
+status_t DisplayEventDispatcher::enableVsyncMailbox() {
+    return mReceiver.enableVsyncMailbox();
+}
+
 } // namespace android
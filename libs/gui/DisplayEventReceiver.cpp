@@ -27,6 +27,8 @@
 
 #include <private/gui/BitTube.h>
 
+#include <binder/ParcelFileDescriptor.h>
+
 // ---------------------------------------------------------------------------
 
 namespace android {
@@ -107,6 +109,25 @@ status_t DisplayEventReceiver::getLatestVsyncEventData(
     return NO_INIT;
 }
 
+status_t DisplayEventReceiver::enableVsyncMailbox() {
+    if (mEventConnection == nullptr) {
+        return NO_INIT;
+    }
+    if (mVsyncMailbox != nullptr) {
+        return NO_ERROR;
+    }
+
+    os::ParcelFileDescriptor mailboxFd;
+    auto status = mEventConnection->getVsyncMailbox(&mailboxFd);
+    if (!status.isOk()) {
+        ALOGE("Failed to get vsync mailbox: %s", status.toString8().c_str());
+        return status.transactionError();
+    }
+
+    mVsyncMailbox = gui::VsyncMailbox::fromFd(mailboxFd.release());
+    return mVsyncMailbox != nullptr ? NO_ERROR : BAD_VALUE;
+}
+
 ssize_t DisplayEventReceiver::getEvents(DisplayEventReceiver::Event* events,
         size_t count) {
     return DisplayEventReceiver::getEvents(mDataChannel.get(), events, count);
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <private/gui/FrameTimestampRing.h>
+
+namespace android {
+
+void FrameTimestampRing::addFrame(uint64_t frameNumber, nsecs_t latchTime,
+                                  nsecs_t refreshStartTime, nsecs_t dequeueReadyTime,
+                                  const sp<Fence>& gpuCompositionDoneFence,
+                                  const sp<Fence>& displayPresentFence,
+                                  const sp<Fence>& releaseFence) {
+    const size_t index = frameNumber % kSize;
+    Timestamps& frame = mFrames[index];
+    PendingFences& fences = mPendingFences[index];
+    if (frame.frameNumber != frameNumber) {
+        frame = {.frameNumber = frameNumber};
+        fences = {};
+    }
+
+    frame.latchTime = latchTime;
+    if (frame.firstRefreshStartTime == FrameEvents::TIMESTAMP_PENDING) {
+        frame.firstRefreshStartTime = refreshStartTime;
+    }
+    frame.lastRefreshStartTime = refreshStartTime;
+    frame.dequeueReadyTime = dequeueReadyTime;
+    fences.gpuCompositionDone = gpuCompositionDoneFence;
+    fences.displayPresent = displayPresentFence;
+    fences.release = releaseFence;
+
+    // The fences of the previous frames typically signal by the time the next frame is reported.
+    for (size_t i = 0; i < kSize; i++) {
+        PendingFences& pending = mPendingFences[i];
+        bool changed = i == index;
+        changed |= updateSignalTime(pending.gpuCompositionDone, &mFrames[i].gpuCompositionDoneTime);
+        changed |= updateSignalTime(pending.displayPresent, &mFrames[i].displayPresentTime);
+        changed |= updateSignalTime(pending.release, &mFrames[i].releaseTime);
+        if (changed) {
+            publish(mFrames[i]);
+        }
+    }
+}
+
+bool FrameTimestampRing::updateSignalTime(sp<Fence>& fence, nsecs_t* signalTime) {
+    if (fence == nullptr) {
+        return false;
+    }
+    const nsecs_t time = fence->getSignalTime();
+    if (time == Fence::SIGNAL_TIME_PENDING) {
+        return false;
+    }
+    *signalTime = time;
+    fence = nullptr;
+    return true;
+}
+
+void FrameTimestampRing::publish(const Timestamps& timestamps) {
+    Entry& entry = mEntries[timestamps.frameNumber % kSize];
+    const uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry.frameNumber.store(timestamps.frameNumber, std::memory_order_relaxed);
+    const std::array<nsecs_t, kTimestampCount> times{timestamps.latchTime,
+                                                     timestamps.firstRefreshStartTime,
+                                                     timestamps.lastRefreshStartTime,
+                                                     timestamps.dequeueReadyTime,
+                                                     timestamps.gpuCompositionDoneTime,
+                                                     timestamps.displayPresentTime,
+                                                     timestamps.releaseTime};
+    for (size_t i = 0; i < kTimestampCount; i++) {
+        entry.times[i].store(times[i], std::memory_order_relaxed);
+    }
+
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::optional<FrameTimestampRing::Timestamps> FrameTimestampRing::getFrame(
+        uint64_t frameNumber) const {
+    const Entry& entry = mEntries[frameNumber % kSize];
+    while (true) {
+        const uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0) {
+            continue;
+        }
+
+        const uint64_t entryFrameNumber = entry.frameNumber.load(std::memory_order_relaxed);
+        std::array<nsecs_t, kTimestampCount> times;
+        for (size_t i = 0; i < kTimestampCount; i++) {
+            times[i] = entry.times[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+        if (sequence == 0 || entryFrameNumber != frameNumber) {
+            return std::nullopt;
+        }
+        return Timestamps{.frameNumber = frameNumber,
+                          .latchTime = times[0],
+                          .firstRefreshStartTime = times[1],
+                          .lastRefreshStartTime = times[2],
+                          .dequeueReadyTime = times[3],
+                          .gpuCompositionDoneTime = times[4],
+                          .displayPresentTime = times[5],
+                          .releaseTime = times[6]};
+    }
+}
+
+} // namespace android
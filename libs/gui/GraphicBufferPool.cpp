@@ -0,0 +1,275 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "GraphicBufferPool"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+//#define LOG_NDEBUG 0
+
+#include <private/gui/GraphicBufferPool.h>
+
+#include <android-base/properties.h>
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <iterator>
+#include <limits>
+
+namespace android {
+
+namespace {
+
+// The size of a buffer with the given attributes and stride, assuming 4 bytes per pixel for the
+// formats whose size per pixel is not known, e.g. YUV and compressed formats.
+size_t estimateBytes(const GraphicBufferPool::Key& key, uint32_t stride) {
+    const ssize_t bytesPerPixel = android::bytesPerPixel(key.format);
+    return static_cast<size_t>(std::max(stride, key.width)) * key.height * key.layerCount *
+            static_cast<size_t>(bytesPerPixel > 0 ? bytesPerPixel : 4);
+}
+
+} // namespace
+
+GraphicBufferPool::Key GraphicBufferPool::Key::from(const GraphicBuffer& buffer) {
+    return {.width = buffer.getWidth(),
+            .height = buffer.getHeight(),
+            .format = buffer.getPixelFormat(),
+            .layerCount = buffer.getLayerCount(),
+            .usage = buffer.getUsage()};
+}
+
+GraphicBufferPool& GraphicBufferPool::getInstance() {
+    // Never destroyed, so that BufferQueues can return their buffers while the process exits.
+    static GraphicBufferPool* const sPool =
+            new GraphicBufferPool(base::GetUintProperty<size_t>("debug.gui.buffer_pool_kb",
+                                                                kDefaultMaxBytes / 1024) *
+                                          1024,
+                                  kDefaultMaxAge);
+    return *sPool;
+}
+
+GraphicBufferPool::GraphicBufferPool(size_t maxBytes, nsecs_t maxAge)
+      : mMaxBytes(maxBytes), mMaxAge(maxAge) {}
+
+GraphicBufferPool::~GraphicBufferPool() {
+    std::optional<std::thread> thread;
+    {
+        std::lock_guard lock(mMutex);
+        mDone = true;
+        thread = std::move(mThread);
+    }
+    mCondition.notify_all();
+    if (thread && thread->joinable()) {
+        thread->join();
+    }
+}
+
+std::optional<GraphicBufferPool::Buffer> GraphicBufferPool::take(const Key& key) {
+    std::lock_guard lock(mMutex);
+    const auto bucket = mBuckets.find(key);
+    if (bucket == mBuckets.end()) {
+        return std::nullopt;
+    }
+
+    // The buffer returned first is the most likely to be done being read.
+    Entry entry = std::move(bucket->second.front());
+    bucket->second.pop_front();
+    if (bucket->second.empty()) {
+        mBuckets.erase(bucket);
+    }
+    mSizeBytes -= entry.bytes;
+    ALOGV("take: %ux%u format %d usage %#" PRIx64 ", %zu bytes left", key.width, key.height,
+          key.format, key.usage, mSizeBytes);
+    return std::move(entry.buffer);
+}
+
+void GraphicBufferPool::put(Buffer&& buffer) {
+    if (!isEnabled() || buffer.buffer == nullptr) {
+        return;
+    }
+
+    const Key key = Key::from(*buffer.buffer);
+    const size_t bytes = estimateBytes(key, buffer.buffer->getStride());
+    if (bytes > mMaxBytes) {
+        return;
+    }
+
+    std::lock_guard lock(mMutex);
+    makeRoomLocked(bytes);
+    mBuckets[key].push_back({.buffer = std::move(buffer),
+                             .bytes = bytes,
+                             .sequence = mNextSequence++,
+                             .returnedTime = systemTime()});
+    mSizeBytes += bytes;
+    ALOGV("put: %ux%u format %d usage %#" PRIx64 ", %zu bytes held", key.width, key.height,
+          key.format, key.usage, mSizeBytes);
+
+    // The thread drops the buffer once it expires.
+    if (!mThread) {
+        mThread.emplace(&GraphicBufferPool::threadMain, this);
+    }
+    mCondition.notify_all();
+}
+
+void GraphicBufferPool::preallocate(const Key& key, size_t count,
+                                    const std::string& requestorName) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    std::lock_guard lock(mMutex);
+    const auto bucket = mBuckets.find(key);
+    size_t available = bucket == mBuckets.end() ? 0 : bucket->second.size();
+    const auto pending = mPendingAllocations.find(key);
+    available += pending == mPendingAllocations.end() ? 0 : pending->second;
+    if (available >= count) {
+        return;
+    }
+
+    // Don't allocate buffers that would evict each other.
+    const size_t bytes = estimateBytes(key, key.width);
+    const size_t room = mMaxBytes > mSizeBytes ? mMaxBytes - mSizeBytes : 0;
+    const size_t allocations = std::min(count - available, bytes > 0 ? room / bytes : 0);
+    if (allocations == 0) {
+        return;
+    }
+
+    ALOGV("preallocate: %zu buffers of %ux%u format %d usage %#" PRIx64, allocations, key.width,
+          key.height, key.format, key.usage);
+    for (size_t i = 0; i < allocations; i++) {
+        mAllocations.push_back({.key = key, .requestorName = requestorName});
+    }
+    mPendingAllocations[key] += allocations;
+    if (!mThread) {
+        mThread.emplace(&GraphicBufferPool::threadMain, this);
+    }
+    mCondition.notify_all();
+}
+
+void GraphicBufferPool::clear() {
+    std::lock_guard lock(mMutex);
+    mBuckets.clear();
+    mSizeBytes = 0;
+}
+
+size_t GraphicBufferPool::getBufferCount() const {
+    std::lock_guard lock(mMutex);
+    size_t count = 0;
+    for (const auto& [key, entries] : mBuckets) {
+        count += entries.size();
+    }
+    return count;
+}
+
+size_t GraphicBufferPool::getSizeBytes() const {
+    std::lock_guard lock(mMutex);
+    return mSizeBytes;
+}
+
+void GraphicBufferPool::waitForPendingAllocations() {
+    std::unique_lock lock(mMutex);
+    while (!mPendingAllocations.empty()) {
+        mCondition.wait(lock);
+    }
+}
+
+void GraphicBufferPool::makeRoomLocked(size_t bytes) {
+    while (mSizeBytes + bytes > mMaxBytes && !mBuckets.empty()) {
+        const auto oldest =
+                std::min_element(mBuckets.begin(), mBuckets.end(),
+                                 [](const auto& lhs, const auto& rhs) {
+                                     return lhs.second.front().sequence <
+                                             rhs.second.front().sequence;
+                                 });
+        eraseLocked(oldest);
+    }
+}
+
+void GraphicBufferPool::dropExpiredLocked(nsecs_t now) {
+    for (auto bucket = mBuckets.begin(); bucket != mBuckets.end();) {
+        auto& entries = bucket->second;
+        while (!entries.empty() && entries.front().returnedTime + mMaxAge <= now) {
+            mSizeBytes -= entries.front().bytes;
+            entries.pop_front();
+        }
+        bucket = entries.empty() ? mBuckets.erase(bucket) : std::next(bucket);
+    }
+}
+
+void GraphicBufferPool::eraseLocked(std::map<Key, std::deque<Entry>>::iterator bucket) {
+    mSizeBytes -= bucket->second.front().bytes;
+    bucket->second.pop_front();
+    if (bucket->second.empty()) {
+        mBuckets.erase(bucket);
+    }
+}
+
+void GraphicBufferPool::threadMain() {
+    std::unique_lock lock(mMutex);
+    while (!mDone) {
+        dropExpiredLocked(systemTime());
+
+        if (!mAllocations.empty()) {
+            const Allocation allocation = std::move(mAllocations.front());
+            mAllocations.pop_front();
+            const Key& key = allocation.key;
+
+            lock.unlock();
+            sp<GraphicBuffer> buffer;
+            {
+                ATRACE_NAME("GraphicBufferPool::preallocate");
+                buffer = sp<GraphicBuffer>::make(key.width, key.height, key.format,
+                                                 key.layerCount, key.usage,
+                                                 allocation.requestorName);
+            }
+            const status_t error = buffer->initCheck();
+            lock.lock();
+
+            if (error == NO_ERROR) {
+                const size_t bytes = estimateBytes(key, buffer->getStride());
+                makeRoomLocked(bytes);
+                mBuckets[key].push_back({.buffer = {.buffer = std::move(buffer)},
+                                         .bytes = bytes,
+                                         .sequence = mNextSequence++,
+                                         .returnedTime = systemTime()});
+                mSizeBytes += bytes;
+            } else {
+                ALOGE("Failed to preallocate a %ux%u buffer of format %d: %d", key.width,
+                      key.height, key.format, error);
+            }
+            if (const auto pending = mPendingAllocations.find(key);
+                pending != mPendingAllocations.end() && --pending->second == 0) {
+                mPendingAllocations.erase(pending);
+            }
+            mCondition.notify_all();
+            continue;
+        }
+
+        if (mBuckets.empty()) {
+            mCondition.wait(lock);
+            continue;
+        }
+
+        nsecs_t nextExpiry = std::numeric_limits<nsecs_t>::max();
+        for (const auto& [key, entries] : mBuckets) {
+            nextExpiry = std::min(nextExpiry, entries.front().returnedTime + mMaxAge);
+        }
+        mCondition.wait_for(lock, std::chrono::nanoseconds(nextExpiry - systemTime()));
+    }
+}
+
+} // namespace android
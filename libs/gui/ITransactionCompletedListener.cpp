@@ -34,7 +34,8 @@ enum class Tag : uint32_t {
     ON_RELEASE_BUFFER,
     ON_TRANSACTION_QUEUE_STALLED,
     ON_TRUSTED_PRESENTATION_CHANGED,
-    LAST = ON_TRUSTED_PRESENTATION_CHANGED,
+    ON_RELEASE_BUFFERS,
+    LAST = ON_RELEASE_BUFFERS,
 };
 
 } // Anonymous namespace
@@ -303,6 +304,11 @@ public:
                                                            currentMaxAcquiredBufferCount);
     }
 
+    void onReleaseBuffers(std::vector<BufferReleaseStats> stats) override {
+        callRemoteAsync<decltype(&ITransactionCompletedListener::
+                                         onReleaseBuffers)>(Tag::ON_RELEASE_BUFFERS, stats);
+    }
+
     void onTransactionQueueStalled(const String8& reason) override {
         callRemoteAsync<
                 decltype(&ITransactionCompletedListener::
@@ -340,6 +346,8 @@ status_t BnTransactionCompletedListener::onTransact(uint32_t code, const Parcel&
         case Tag::ON_TRUSTED_PRESENTATION_CHANGED:
             return callLocalAsync(data, reply,
                                   &ITransactionCompletedListener::onTrustedPresentationChanged);
+        case Tag::ON_RELEASE_BUFFERS:
+            return callLocalAsync(data, reply, &ITransactionCompletedListener::onReleaseBuffers);
     }
 }
 
@@ -389,6 +397,21 @@ status_t ReleaseCallbackId::readFromParcel(const Parcel* input) {
     return NO_ERROR;
 }
 
+status_t BufferReleaseStats::writeToParcel(Parcel* output) const {
+    SAFE_PARCEL(output->writeParcelable, callbackId);
+    SAFE_PARCEL(output->write, releaseFence ? *releaseFence : *Fence::NO_FENCE);
+    SAFE_PARCEL(output->writeUint32, currentMaxAcquiredBufferCount);
+    return NO_ERROR;
+}
+
+status_t BufferReleaseStats::readFromParcel(const Parcel* input) {
+    SAFE_PARCEL(input->readParcelable, &callbackId);
+    releaseFence = sp<Fence>::make();
+    SAFE_PARCEL(input->read, *releaseFence);
+    SAFE_PARCEL(input->readUint32, &currentMaxAcquiredBufferCount);
+    return NO_ERROR;
+}
+
 const ReleaseCallbackId ReleaseCallbackId::INVALID_ID = ReleaseCallbackId(0, 0);
 
 }; // namespace android
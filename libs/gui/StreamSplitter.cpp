@@ -58,13 +58,14 @@ status_t StreamSplitter::createSplitter(
 
 StreamSplitter::StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue)
       : mIsAbandoned(false), mMutex(), mReleaseCondition(),
-        mOutstandingBuffers(0), mInput(inputQueue), mOutputs(), mBuffers() {}
+        mOutstandingBuffers(0), mMaxOutstandingBuffers(DEFAULT_MAX_OUTSTANDING_BUFFERS),
+        mInput(inputQueue), mOutputs(), mBuffers() {}
 
 StreamSplitter::~StreamSplitter() {
     mInput->consumerDisconnect();
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
+    Vector<Output>::iterator output = mOutputs.begin();
     for (; output != mOutputs.end(); ++output) {
-        (*output)->disconnect(NATIVE_WINDOW_API_CPU);
+        output->queue->disconnect(NATIVE_WINDOW_API_CPU);
     }
 
     if (mBuffers.size() > 0) {
@@ -73,7 +74,7 @@ StreamSplitter::~StreamSplitter() {
 }
 
 status_t StreamSplitter::addOutput(
-        const sp<IGraphicBufferProducer>& outputQueue) {
+        const sp<IGraphicBufferProducer>& outputQueue, OutputMode mode) {
     if (outputQueue == nullptr) {
         ALOGE("addOutput: outputQueue must not be NULL");
         return BAD_VALUE;
@@ -91,11 +92,33 @@ status_t StreamSplitter::addOutput(
         return status;
     }
 
-    mOutputs.push_back(outputQueue);
+    // In async mode, queueing a buffer replaces the one that is waiting
+    if (mode == OutputMode::LATEST_ONLY) {
+        status = outputQueue->setAsyncMode(true);
+        if (status != NO_ERROR) {
+            ALOGE("addOutput: failed to set async mode (%d)", status);
+            outputQueue->disconnect(NATIVE_WINDOW_API_CPU);
+            return status;
+        }
+    }
+
+    mOutputs.push_back({.queue = outputQueue, .mode = mode});
 
     return NO_ERROR;
 }
 
+status_t StreamSplitter::setMaxOutstandingBuffers(int count) {
+    if (count < 1) {
+        ALOGE("setMaxOutstandingBuffers: count must be at least 1 (%d)", count);
+        return BAD_VALUE;
+    }
+
+    Mutex::Autolock lock(mMutex);
+    mMaxOutstandingBuffers = count;
+    mReleaseCondition.broadcast();
+    return NO_ERROR;
+}
+
 void StreamSplitter::setName(const String8 &name) {
     Mutex::Autolock lock(mMutex);
     mInput->setConsumerName(name);
@@ -105,14 +128,15 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     ATRACE_CALL();
     Mutex::Autolock lock(mMutex);
 
-    // The current policy is that if any one consumer is consuming buffers too
-    // slowly, the splitter will stall the rest of the outputs by not acquiring
-    // any more buffers from the input. This will cause back pressure on the
-    // input queue, slowing down its producer.
+    // The current policy is that if any one FIFO consumer is consuming buffers
+    // too slowly, the splitter will stall the rest of the outputs by not
+    // acquiring any more buffers from the input. This will cause back pressure
+    // on the input queue, slowing down its producer. LATEST_ONLY outputs drop
+    // the buffers that their consumers did not acquire in time instead.
 
     // If there are too many outstanding buffers, we block until a buffer is
     // released back to the input in onBufferReleased
-    while (mOutstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
+    while (mOutstandingBuffers >= mMaxOutstandingBuffers) {
         mReleaseCondition.wait(mMutex);
 
         // If the splitter is abandoned while we are waiting, the release
@@ -149,10 +173,10 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             bufferItem.mTransform, bufferItem.mFence);
 
     // Attach and queue the buffer to each of the outputs
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
-    for (; output != mOutputs.end(); ++output) {
+    for (size_t i = 0; i < mOutputs.size(); ++i) {
+        const Output& output = mOutputs[i];
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
+        status = output.queue->attachBuffer(&slot, bufferItem.mGraphicBuffer);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
@@ -167,7 +191,7 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
         }
 
         IGraphicBufferProducer::QueueBufferOutput queueOutput;
-        status = (*output)->queueBuffer(slot, queueInput, &queueOutput);
+        status = output.queue->queueBuffer(slot, queueInput, &queueOutput);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
@@ -182,7 +206,15 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
         }
 
         ALOGV("queued buffer %#" PRIx64 " to output %p",
-                bufferItem.mGraphicBuffer->getId(), output->get());
+                bufferItem.mGraphicBuffer->getId(), output.queue.get());
+
+        // The buffer that was waiting in a LATEST_ONLY output was dropped. It
+        // is free in the output, but its consumer never released it, so there
+        // won't be a callback for it
+        if (queueOutput.bufferReplaced) {
+            ALOGV("output %p dropped a buffer", output.queue.get());
+            releaseBufferFromOutputLocked(output.queue);
+        }
     }
 }
 
@@ -190,7 +222,11 @@ void StreamSplitter::onBufferReleasedByOutput(
         const sp<IGraphicBufferProducer>& from) {
     ATRACE_CALL();
     Mutex::Autolock lock(mMutex);
+    releaseBufferFromOutputLocked(from);
+}
 
+void StreamSplitter::releaseBufferFromOutputLocked(
+        const sp<IGraphicBufferProducer>& from) {
     sp<GraphicBuffer> buffer;
     sp<Fence> fence;
     status_t status = from->detachNextBuffer(&buffer, &fence);
@@ -49,6 +49,7 @@
 #include <gui/LayerState.h>
 #include <private/gui/ComposerService.h>
 #include <private/gui/ComposerServiceAIDL.h>
+#include <private/gui/FrameTimestampRing.h>
 
 namespace android {
 
@@ -208,6 +209,7 @@ void Surface::enableFrameTimestamps(bool enable) {
         FrameEventHistoryDelta delta;
         mGraphicBufferProducer->getFrameTimestamps(&delta);
         mFrameEventHistory->applyDelta(delta);
+        mFrameTimestampRing = getFrameTimestampRing();
     }
     mEnableFrameTimestamps = enable;
 }
@@ -267,6 +269,42 @@ static bool checkConsumerForUpdates(
             checkForDisplayPresent || checkForDequeueReady || checkForRelease;
 }
 
+// Returns the requested timestamps from the ring, unless some are still pending there, so that
+// the consumer may know them already.
+static bool getFrameTimestampsFromRing(const FrameTimestampRing& ring, uint64_t frameNumber,
+                                       nsecs_t* outLatchTime, nsecs_t* outFirstRefreshStartTime,
+                                       nsecs_t* outLastRefreshStartTime,
+                                       nsecs_t* outGpuCompositionDoneTime,
+                                       nsecs_t* outDisplayPresentTime,
+                                       nsecs_t* outDequeueReadyTime, nsecs_t* outReleaseTime) {
+    const std::optional<FrameTimestampRing::Timestamps> timestamps = ring.getFrame(frameNumber);
+    if (!timestamps) {
+        return false;
+    }
+
+    const std::pair<nsecs_t*, nsecs_t> outputs[] = {
+            {outLatchTime, timestamps->latchTime},
+            {outFirstRefreshStartTime, timestamps->firstRefreshStartTime},
+            {outLastRefreshStartTime, timestamps->lastRefreshStartTime},
+            {outGpuCompositionDoneTime, timestamps->gpuCompositionDoneTime},
+            {outDisplayPresentTime, timestamps->displayPresentTime},
+            {outDequeueReadyTime, timestamps->dequeueReadyTime},
+            {outReleaseTime, timestamps->releaseTime},
+    };
+    for (const auto& [dst, src] : outputs) {
+        if (dst != nullptr && src == FrameEvents::TIMESTAMP_PENDING) {
+            return false;
+        }
+    }
+    // The pending and invalid times of the ring are those of ANativeWindow.
+    for (const auto& [dst, src] : outputs) {
+        if (dst != nullptr) {
+            *dst = src;
+        }
+    }
+    return true;
+}
+
 static void getFrameTimestamp(nsecs_t *dst, const nsecs_t& src) {
     if (dst != nullptr) {
         // We always get valid timestamps for these eventually.
@@ -319,6 +357,17 @@ status_t Surface::getFrameTimestamps(uint64_t frameNumber,
         return NAME_NOT_FOUND;
     }
 
+    // The requested present and acquire times are always known here.
+    if (mFrameTimestampRing != nullptr &&
+        getFrameTimestampsFromRing(*mFrameTimestampRing, frameNumber, outLatchTime,
+                                   outFirstRefreshStartTime, outLastRefreshStartTime,
+                                   outGpuCompositionDoneTime, outDisplayPresentTime,
+                                   outDequeueReadyTime, outReleaseTime)) {
+        getFrameTimestamp(outRequestedPresentTime, events->requestedPresentTime);
+        getFrameTimestampFence(outAcquireTime, events->acquireFence, events->hasAcquireInfo());
+        return NO_ERROR;
+    }
+
     // Update our cache of events if the requested events are not available.
     if (checkConsumerForUpdates(events, mLastFrameNumber,
             outLatchTime, outFirstRefreshStartTime, outLastRefreshStartTime,
@@ -385,7 +434,7 @@ int Surface::hook_setSwapInterval(ANativeWindow* window, int interval) {
 int Surface::hook_dequeueBuffer(ANativeWindow* window,
         ANativeWindowBuffer** buffer, int* fenceFd) {
     Surface* c = getSelf(window);
-    {
+    if (c->mHasInterceptors.load(std::memory_order_acquire)) {
         std::shared_lock<std::shared_mutex> lock(c->mInterceptorMutex);
         if (c->mDequeueInterceptor != nullptr) {
             auto interceptor = c->mDequeueInterceptor;
@@ -405,7 +454,7 @@ int Surface::dequeueBufferInternal(ANativeWindow* window, ANativeWindowBuffer**
 int Surface::hook_cancelBuffer(ANativeWindow* window,
         ANativeWindowBuffer* buffer, int fenceFd) {
     Surface* c = getSelf(window);
-    {
+    if (c->mHasInterceptors.load(std::memory_order_acquire)) {
         std::shared_lock<std::shared_mutex> lock(c->mInterceptorMutex);
         if (c->mCancelInterceptor != nullptr) {
             auto interceptor = c->mCancelInterceptor;
@@ -424,7 +473,7 @@ int Surface::cancelBufferInternal(ANativeWindow* window, ANativeWindowBuffer* bu
 int Surface::hook_queueBuffer(ANativeWindow* window,
         ANativeWindowBuffer* buffer, int fenceFd) {
     Surface* c = getSelf(window);
-    {
+    if (c->mHasInterceptors.load(std::memory_order_acquire)) {
         std::shared_lock<std::shared_mutex> lock(c->mInterceptorMutex);
         if (c->mQueueInterceptor != nullptr) {
             auto interceptor = c->mQueueInterceptor;
@@ -487,7 +536,8 @@ int Surface::hook_perform(ANativeWindow* window, int operation, ...) {
     // Don't acquire shared ownership of the interceptor mutex if we're going to
     // do interceptor registration, as otherwise we'll deadlock on acquiring
     // exclusive ownership.
-    if (!isInterceptorRegistrationOp(operation)) {
+    if (!isInterceptorRegistrationOp(operation) &&
+        c->mHasInterceptors.load(std::memory_order_acquire)) {
         std::shared_lock<std::shared_mutex> lock(c->mInterceptorMutex);
         if (c->mPerformInterceptor != nullptr) {
             result = c->mPerformInterceptor(window, Surface::performInternal,
@@ -508,7 +558,7 @@ int Surface::performInternal(ANativeWindow* window, int operation, va_list args)
 
 int Surface::hook_query(const ANativeWindow* window, int what, int* value) {
     const Surface* c = getSelf(window);
-    {
+    if (c->mHasInterceptors.load(std::memory_order_acquire)) {
         std::shared_lock<std::shared_mutex> lock(c->mInterceptorMutex);
         if (c->mQueryInterceptor != nullptr) {
             auto interceptor = c->mQueryInterceptor;
@@ -777,7 +827,8 @@ int Surface::dequeueBuffers(std::vector<BatchBuffer>* buffers) {
     for (const auto& output : dequeueOutput) {
         // Collect slots that needs requesting buffer
         sp<GraphicBuffer>& gbuf(mSlots[output.slot].buffer);
-        if ((result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) || gbuf == nullptr) {
+        if ((output.result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) ||
+            gbuf == nullptr) {
             if (mReportRemovedBuffers && (gbuf != nullptr)) {
                 mRemovedBuffers.push_back(gbuf);
             }
@@ -959,7 +1010,7 @@ void Surface::getQueueBufferInputLocked(android_native_buffer_t* buffer, int fen
 
     sp<Fence> fence(fenceFd >= 0 ? new Fence(fenceFd) : Fence::NO_FENCE);
     IGraphicBufferProducer::QueueBufferInput input(timestamp, isAutoTimestamp,
-            static_cast<android_dataspace>(mDataSpace), crop, mScalingMode,
+            static_cast<android_dataspace>(mDataSpace.load()), crop, mScalingMode,
             mTransform ^ mStickyTransform, fence, mStickyTransform,
             mEnableFrameTimestamps);
 
@@ -1160,6 +1211,7 @@ int Surface::queueBuffers(const std::vector<BatchQueuedBuffer>& buffers) {
         getQueueBufferInputLocked(
                 buffers[batchIdx].buffer, buffers[batchIdx].fenceFd, buffers[batchIdx].timestamp,
                 &input);
+        input.slot = i;
         bufferFences[batchIdx] = input.fence;
         queueBufferInputs[batchIdx] = input;
     }
@@ -1286,7 +1338,7 @@ int Surface::query(int what, int* value) const {
                 return NO_ERROR;
             }
             case NATIVE_WINDOW_DATASPACE: {
-                *value = static_cast<int>(mDataSpace);
+                *value = static_cast<int>(mDataSpace.load());
                 return NO_ERROR;
             }
             case NATIVE_WINDOW_MAX_BUFFER_COUNT: {
@@ -1692,6 +1744,7 @@ int Surface::dispatchAddCancelInterceptor(va_list args) {
     std::lock_guard<std::shared_mutex> lock(mInterceptorMutex);
     mCancelInterceptor = interceptor;
     mCancelInterceptorData = data;
+    mHasInterceptors.store(true, std::memory_order_release);
     return NO_ERROR;
 }
 
@@ -1702,6 +1755,7 @@ int Surface::dispatchAddDequeueInterceptor(va_list args) {
     std::lock_guard<std::shared_mutex> lock(mInterceptorMutex);
     mDequeueInterceptor = interceptor;
     mDequeueInterceptorData = data;
+    mHasInterceptors.store(true, std::memory_order_release);
     return NO_ERROR;
 }
 
@@ -1711,6 +1765,7 @@ int Surface::dispatchAddPerformInterceptor(va_list args) {
     std::lock_guard<std::shared_mutex> lock(mInterceptorMutex);
     mPerformInterceptor = interceptor;
     mPerformInterceptorData = data;
+    mHasInterceptors.store(true, std::memory_order_release);
     return NO_ERROR;
 }
 
@@ -1721,6 +1776,7 @@ int Surface::dispatchAddQueueInterceptor(va_list args) {
     std::lock_guard<std::shared_mutex> lock(mInterceptorMutex);
     mQueueInterceptor = interceptor;
     mQueueInterceptorData = data;
+    mHasInterceptors.store(true, std::memory_order_release);
     return NO_ERROR;
 }
 
@@ -1730,6 +1786,7 @@ int Surface::dispatchAddQueryInterceptor(va_list args) {
     std::lock_guard<std::shared_mutex> lock(mInterceptorMutex);
     mQueryInterceptor = interceptor;
     mQueryInterceptorData = data;
+    mHasInterceptors.store(true, std::memory_order_release);
     return NO_ERROR;
 }
 
@@ -2171,7 +2228,6 @@ int Surface::setBuffersStickyTransform(uint32_t transform)
 int Surface::setBuffersTimestamp(int64_t timestamp)
 {
     ALOGV("Surface::setBuffersTimestamp");
-    Mutex::Autolock lock(mMutex);
     mTimestamp = timestamp;
     return NO_ERROR;
 }
@@ -2179,7 +2235,6 @@ int Surface::setBuffersTimestamp(int64_t timestamp)
 int Surface::setBuffersDataSpace(Dataspace dataSpace)
 {
     ALOGV("Surface::setBuffersDataSpace");
-    Mutex::Autolock lock(mMutex);
     mDataSpace = dataSpace;
     return NO_ERROR;
 }
@@ -2226,7 +2281,6 @@ int Surface::setBuffersHdr10PlusMetadata(const size_t size, const uint8_t* metad
 
 Dataspace Surface::getBuffersDataSpace() {
     ALOGV("Surface::getBuffersDataSpace");
-    Mutex::Autolock lock(mMutex);
     return mDataSpace;
 }
 
@@ -2269,22 +2323,25 @@ status_t Surface::getAndFlushBuffersFromSlots(const std::vector<int32_t>& slots,
 void Surface::setSurfaceDamage(android_native_rect_t* rects, size_t numRects) {
     ATRACE_CALL();
     ALOGV("Surface::setSurfaceDamage");
-    Mutex::Autolock lock(mMutex);
-
-    if (mConnectedToCpu || numRects == 0) {
-        mDirtyRegion = Region::INVALID_REGION;
-        return;
-    }
 
-    mDirtyRegion.clear();
+    // Build the region before taking the lock, so that the other calls of the
+    // frame, e.g. queueBuffer from another thread, don't wait on it.
+    Region dirtyRegion;
     for (size_t r = 0; r < numRects; ++r) {
         // We intentionally flip top and bottom here, since because they're
         // specified with a bottom-left origin, top > bottom, which fails
         // validation in the Region class. We will fix this up when we flip to a
         // top-left origin in queueBuffer.
         Rect rect(rects[r].left, rects[r].bottom, rects[r].right, rects[r].top);
-        mDirtyRegion.orSelf(rect);
+        dirtyRegion.orSelf(rect);
+    }
+
+    Mutex::Autolock lock(mMutex);
+    if (mConnectedToCpu || numRects == 0) {
+        mDirtyRegion = Region::INVALID_REGION;
+        return;
     }
+    mDirtyRegion = std::move(dirtyRegion);
 }
 
 // ----------------------------------------------------------------------
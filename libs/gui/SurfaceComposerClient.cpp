@@ -58,8 +58,9 @@
 #include <private/gui/ComposerService.h>
 #include <private/gui/ComposerServiceAIDL.h>
 
-// This server size should always be smaller than the server cache size
-#define BUFFER_CACHE_MAX_SIZE 64
+// This client size must stay strictly smaller than the size of SurfaceFlinger's ClientCache, which
+// is 64, so that the server never evicts an entry before the client does.
+#define CLIENT_BUFFER_CACHE_MAX_SIZE 63
 
 namespace android {
 
@@ -528,6 +529,29 @@ void TransactionCompletedListener::onReleaseBuffer(ReleaseCallbackId callbackId,
     callback(callbackId, releaseFence, optionalMaxAcquiredBufferCount);
 }
 
+void TransactionCompletedListener::onReleaseBuffers(std::vector<BufferReleaseStats> stats) {
+    std::vector<ReleaseBufferCallback> callbacks;
+    callbacks.reserve(stats.size());
+    {
+        std::scoped_lock<std::mutex> lock(mMutex);
+        for (const auto& released : stats) {
+            callbacks.push_back(popReleaseBufferCallbackLocked(released.callbackId));
+        }
+    }
+    for (size_t i = 0; i < stats.size(); i++) {
+        if (!callbacks[i]) {
+            ALOGE("Could not call release buffer callback, buffer not found %s",
+                  stats[i].callbackId.to_string().c_str());
+            continue;
+        }
+        const uint32_t currentMaxAcquiredBufferCount = stats[i].currentMaxAcquiredBufferCount;
+        callbacks[i](stats[i].callbackId, stats[i].releaseFence,
+                     currentMaxAcquiredBufferCount == UINT_MAX
+                             ? std::nullopt
+                             : std::make_optional<uint32_t>(currentMaxAcquiredBufferCount));
+    }
+}
+
 ReleaseBufferCallback TransactionCompletedListener::popReleaseBufferCallbackLocked(
         const ReleaseCallbackId& callbackId) {
     ReleaseBufferCallback callback;
@@ -638,7 +662,7 @@ public:
                    std::optional<client_cache_t>& outUncacheBuffer) {
         std::lock_guard<std::mutex> lock(mMutex);
 
-        if (mBuffers.size() >= BUFFER_CACHE_MAX_SIZE) {
+        if (mBuffers.size() >= CLIENT_BUFFER_CACHE_MAX_SIZE) {
             outUncacheBuffer = findLeastRecentlyUsedBuffer();
             mBuffers.erase(outUncacheBuffer->id);
         }
@@ -713,6 +737,8 @@ SurfaceComposerClient::Transaction::Transaction(const Transaction& other)
         mApplyToken(other.mApplyToken) {
     mDisplayStates = other.mDisplayStates;
     mComposerStates = other.mComposerStates;
+    mComposerStateIndices = other.mComposerStateIndices;
+    mLastComposerStateIndex = other.mLastComposerStateIndex;
     mInputWindowCommands = other.mInputWindowCommands;
     mListenerCallbacks = other.mListenerCallbacks;
 }
@@ -799,8 +825,10 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     if (count > parcel->dataSize()) {
         return BAD_VALUE;
     }
-    std::unordered_map<sp<IBinder>, ComposerState, IBinderHash> composerStates;
+    std::vector<std::pair<sp<IBinder>, ComposerState>> composerStates;
+    std::unordered_map<IBinder*, size_t> composerStateIndices;
     composerStates.reserve(count);
+    composerStateIndices.reserve(count);
     for (size_t i = 0; i < count; i++) {
         sp<IBinder> surfaceControlHandle;
         SAFE_PARCEL(parcel->readStrongBinder, &surfaceControlHandle);
@@ -809,7 +837,15 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
         if (composerState.read(*parcel) == BAD_VALUE) {
             return BAD_VALUE;
         }
-        composerStates[surfaceControlHandle] = composerState;
+        const auto [it, inserted] =
+                composerStateIndices.try_emplace(surfaceControlHandle.get(),
+                                                 composerStates.size());
+        if (inserted) {
+            composerStates.emplace_back(std::move(surfaceControlHandle),
+                                        std::move(composerState));
+        } else {
+            composerStates[it->second].second = std::move(composerState);
+        }
     }
 
     InputWindowCommands inputWindowCommands;
@@ -847,7 +883,9 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     mFrameTimelineInfo = frameTimelineInfo;
     mDisplayStates = displayStates;
     mListenerCallbacks = listenerCallbacks;
-    mComposerStates = composerStates;
+    mComposerStates = std::move(composerStates);
+    mComposerStateIndices = std::move(composerStateIndices);
+    mLastComposerStateIndex = 0;
     mInputWindowCommands = inputWindowCommands;
     mApplyToken = applyToken;
     mUncacheBuffers = std::move(uncacheBuffers);
@@ -955,14 +993,17 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Tr
     }
     mMergedTransactionIds.insert(mMergedTransactionIds.begin(), other.mId);
 
-    for (auto const& [handle, composerState] : other.mComposerStates) {
-        if (mComposerStates.count(handle) == 0) {
-            mComposerStates[handle] = composerState;
+    mComposerStates.reserve(mComposerStates.size() + other.mComposerStates.size());
+    for (auto& [handle, composerState] : other.mComposerStates) {
+        ComposerState* current = findComposerState(handle);
+        if (current == nullptr) {
+            // other is cleared below.
+            addComposerState(handle, std::move(composerState));
         } else {
             if (composerState.state.what & layer_state_t::eBufferChanged) {
-                releaseBufferIfOverwriting(mComposerStates[handle].state);
+                releaseBufferIfOverwriting(current->state);
             }
-            mComposerStates[handle].state.merge(composerState.state);
+            current->state.merge(composerState.state);
         }
     }
 
@@ -1016,6 +1057,8 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Tr
 
 void SurfaceComposerClient::Transaction::clear() {
     mComposerStates.clear();
+    mComposerStateIndices.clear();
+    mLastComposerStateIndex = 0;
     mDisplayStates.clear();
     mListenerCallbacks.clear();
     mInputWindowCommands.clear();
@@ -1064,7 +1107,7 @@ void SurfaceComposerClient::Transaction::cacheBuffers() {
 
     size_t count = 0;
     for (auto& [handle, cs] : mComposerStates) {
-        layer_state_t* s = &(mComposerStates[handle].state);
+        layer_state_t* s = &cs.state;
         if (!(s->what & layer_state_t::eBufferChanged)) {
             continue;
         } else if (s->bufferData &&
@@ -1101,7 +1144,7 @@ void SurfaceComposerClient::Transaction::cacheBuffers() {
         // If we have more buffers than the size of the cache, we should stop caching so we don't
         // evict other buffers in this transaction
         count++;
-        if (count >= BUFFER_CACHE_MAX_SIZE) {
+        if (count >= CLIENT_BUFFER_CACHE_MAX_SIZE) {
             break;
         }
     }
@@ -1193,8 +1236,9 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay
     Vector<DisplayState> displayStates;
     uint32_t flags = 0;
 
-    for (auto const& kv : mComposerStates) {
-        composerStates.add(kv.second);
+    composerStates.setCapacity(mComposerStates.size());
+    for (auto const& [handle, composerState] : mComposerStates) {
+        composerStates.add(composerState);
     }
 
     displayStates = std::move(mDisplayStates);
@@ -1317,17 +1361,37 @@ void SurfaceComposerClient::Transaction::setEarlyWakeupEnd() {
 layer_state_t* SurfaceComposerClient::Transaction::getLayerState(const sp<SurfaceControl>& sc) {
     auto handle = sc->getLayerStateHandle();
 
-    if (mComposerStates.count(handle) == 0) {
-        // we don't have it, add an initialized layer_state to our list
-        ComposerState s;
+    if (ComposerState* composerState = findComposerState(handle)) {
+        return &composerState->state;
+    }
+
+    // we don't have it, add an initialized layer_state to our list
+    ComposerState s;
 
-        s.state.surface = handle;
-        s.state.layerId = sc->getLayerId();
+    s.state.surface = handle;
+    s.state.layerId = sc->getLayerId();
+
+    return &addComposerState(handle, std::move(s)).state;
+}
 
-        mComposerStates[handle] = s;
+ComposerState* SurfaceComposerClient::Transaction::findComposerState(const sp<IBinder>& handle) {
+    if (mLastComposerStateIndex < mComposerStates.size() &&
+        mComposerStates[mLastComposerStateIndex].first == handle) {
+        return &mComposerStates[mLastComposerStateIndex].second;
     }
+    const auto it = mComposerStateIndices.find(handle.get());
+    if (it == mComposerStateIndices.end()) {
+        return nullptr;
+    }
+    mLastComposerStateIndex = it->second;
+    return &mComposerStates[it->second].second;
+}
 
-    return &(mComposerStates[handle].state);
+ComposerState& SurfaceComposerClient::Transaction::addComposerState(const sp<IBinder>& handle,
+                                                                    ComposerState&& state) {
+    mLastComposerStateIndex = mComposerStates.size();
+    mComposerStateIndices.emplace(handle.get(), mLastComposerStateIndex);
+    return mComposerStates.emplace_back(handle, std::move(state)).second;
 }
 
 void SurfaceComposerClient::Transaction::registerSurfaceControlForCallback(
@@ -2926,6 +2990,16 @@ status_t SurfaceComposerClient::addRegionSamplingListener(
     return statusTFromBinderStatus(status);
 }
 
+status_t SurfaceComposerClient::addHdrLayerInfoListener(
+        const sp<IBinder>& displayToken, const sp<gui::IHdrLayerInfoListener>& listener,
+        std::chrono::nanoseconds minUpdateInterval, float hysteresis) {
+    binder::Status status =
+            ComposerServiceAIDL::getComposerService()
+                    ->addHdrLayerInfoListenerWithOptions(displayToken, listener,
+                                                         minUpdateInterval.count(), hysteresis);
+    return statusTFromBinderStatus(status);
+}
+
 status_t SurfaceComposerClient::removeRegionSamplingListener(
         const sp<IRegionSamplingListener>& listener) {
     binder::Status status =
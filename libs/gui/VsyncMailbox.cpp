@@ -0,0 +1,182 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VsyncMailbox"
+
+#include <gui/VsyncMailbox.h>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <type_traits>
+
+#include <cutils/ashmem.h>
+#include <log/log.h>
+
+namespace android::gui {
+
+static_assert(std::is_trivially_copyable_v<VsyncMailbox::Vsync>);
+
+// 32-bit words, so that atomic loads are plain loads of read-only memory for every ABI.
+static constexpr size_t kWordCount =
+        (sizeof(VsyncMailbox::Vsync) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+using Words = std::array<uint32_t, kWordCount>;
+
+// The sequence is odd while a VSYNC is being published, and zero until the first one is. It is
+// also the futex word that readers wait on.
+struct VsyncMailboxPage {
+    std::atomic<uint32_t> sequence;
+    std::array<std::atomic<uint32_t>, kWordCount> words;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+namespace {
+
+uint32_t* futexWord(VsyncMailboxPage* page) {
+    return reinterpret_cast<uint32_t*>(&page->sequence);
+}
+
+} // namespace
+
+std::unique_ptr<VsyncMailbox> VsyncMailbox::create() {
+    base::unique_fd fd(ashmem_create_region("VsyncMailbox", sizeof(VsyncMailboxPage)));
+    if (!fd.ok()) {
+        ALOGE("Failed to create mailbox: %s", strerror(errno));
+        return nullptr;
+    }
+
+    void* ptr = mmap(nullptr, sizeof(VsyncMailboxPage), PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd.get(), 0);
+    if (ptr == MAP_FAILED) {
+        ALOGE("Failed to map mailbox: %s", strerror(errno));
+        return nullptr;
+    }
+
+    // Mappings made after this point, including those of clients, are read-only.
+    if (ashmem_set_prot_region(fd.get(), PROT_READ) < 0) {
+        ALOGE("Failed to protect mailbox: %s", strerror(errno));
+        munmap(ptr, sizeof(VsyncMailboxPage));
+        return nullptr;
+    }
+
+    return std::unique_ptr<VsyncMailbox>(
+            new VsyncMailbox(std::move(fd), new (ptr) VsyncMailboxPage{}, true));
+}
+
+std::unique_ptr<VsyncMailbox> VsyncMailbox::fromFd(base::unique_fd fd) {
+    const int size = ashmem_get_size_region(fd.get());
+    if (size < 0 || static_cast<size_t>(size) < sizeof(VsyncMailboxPage)) {
+        ALOGE("Invalid mailbox of size %d", size);
+        return nullptr;
+    }
+
+    void* ptr = mmap(nullptr, sizeof(VsyncMailboxPage), PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (ptr == MAP_FAILED) {
+        ALOGE("Failed to map mailbox: %s", strerror(errno));
+        return nullptr;
+    }
+
+    return std::unique_ptr<VsyncMailbox>(
+            new VsyncMailbox(std::move(fd), static_cast<VsyncMailboxPage*>(ptr), false));
+}
+
+VsyncMailbox::VsyncMailbox(base::unique_fd fd, VsyncMailboxPage* page, bool writable)
+      : mFd(std::move(fd)), mPage(page), mWritable(writable) {}
+
+VsyncMailbox::~VsyncMailbox() {
+    munmap(mPage, sizeof(VsyncMailboxPage));
+}
+
+void VsyncMailbox::publish(const Vsync& vsync) {
+    LOG_ALWAYS_FATAL_IF(!mWritable, "%s: Mailbox is read-only", __func__);
+
+    Words words{};
+    std::memcpy(words.data(), &vsync, sizeof(Vsync));
+
+    // Storing the words with release semantics orders the odd sequence before them, so a reader
+    // that sees any new word also sees that the sequence changed.
+    const uint32_t sequence = mPage->sequence.load(std::memory_order_relaxed);
+    mPage->sequence.store(sequence + 1, std::memory_order_relaxed);
+    for (size_t i = 0; i < kWordCount; i++) {
+        mPage->words[i].store(words[i], std::memory_order_release);
+    }
+    mPage->sequence.store(sequence + 2, std::memory_order_release);
+
+    // Not FUTEX_PRIVATE_FLAG, since the waiters are in other processes.
+    syscall(SYS_futex, futexWord(mPage), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+std::optional<VsyncMailbox::Vsync> VsyncMailbox::read(uint32_t* outSequence) const {
+    constexpr int kMaxAttempts = 4;
+    for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
+        const uint32_t sequence = mPage->sequence.load(std::memory_order_acquire);
+        if (sequence == 0) {
+            return std::nullopt;
+        }
+        if (sequence & 1) {
+            continue;
+        }
+
+        Words words;
+        for (size_t i = 0; i < kWordCount; i++) {
+            words[i] = mPage->words[i].load(std::memory_order_acquire);
+        }
+        if (mPage->sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        if (outSequence) {
+            *outSequence = sequence;
+        }
+        Vsync vsync;
+        std::memcpy(&vsync, words.data(), sizeof(Vsync));
+        return vsync;
+    }
+    return std::nullopt;
+}
+
+bool VsyncMailbox::waitForNext(uint32_t sequence, std::chrono::nanoseconds timeout) const {
+    const nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) + timeout.count();
+    for (;;) {
+        const uint32_t current = mPage->sequence.load(std::memory_order_acquire);
+        if (current != sequence && !(current & 1)) {
+            return true;
+        }
+
+        const nsecs_t remaining = deadline - systemTime(SYSTEM_TIME_MONOTONIC);
+        if (remaining <= 0) {
+            return false;
+        }
+
+        // Returns early if the sequence is no longer `current`, or on a signal.
+        const timespec relative = {.tv_sec = static_cast<time_t>(remaining / 1'000'000'000),
+                                   .tv_nsec = static_cast<long>(remaining % 1'000'000'000)};
+        syscall(SYS_futex, futexWord(mPage), FUTEX_WAIT, current, &relative, nullptr, 0);
+    }
+}
+
+} // namespace android::gui
@@ -76,7 +76,10 @@ bool WindowInfo::operator==(const WindowInfo& info) const {
             info.inputConfig == inputConfig && info.displayId == displayId &&
             info.replaceTouchableRegionWithCrop == replaceTouchableRegionWithCrop &&
             info.applicationInfo == applicationInfo && info.layoutParamsType == layoutParamsType &&
-            info.layoutParamsFlags == layoutParamsFlags;
+            info.layoutParamsFlags == layoutParamsFlags && info.alpha == alpha &&
+            info.windowToken == windowToken &&
+            info.touchableRegionCropHandle == touchableRegionCropHandle &&
+            info.focusTransferTarget == focusTransferTarget;
 }
 
 status_t WindowInfo::writeToParcel(android::Parcel* parcel) const {
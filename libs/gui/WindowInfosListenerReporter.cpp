@@ -14,11 +14,15 @@
  * limitations under the License.
  */
 
+#define LOG_TAG "WindowInfosListenerReporter"
+
 #include <android/gui/ISurfaceComposer.h>
 #include <gui/AidlStatusUtil.h>
 #include <gui/WindowInfosListenerReporter.h>
 #include "gui/WindowInfosUpdate.h"
 
+#include <cinttypes>
+
 namespace android {
 
 using gui::DisplayInfo;
@@ -78,6 +82,7 @@ status_t WindowInfosListenerReporter::removeWindowInfosListener(
             // stale values
             mLastWindowInfos.clear();
             mLastDisplayInfos.clear();
+            mLastVersion.reset();
         }
 
         if (status == OK) {
@@ -92,19 +97,37 @@ binder::Status WindowInfosListenerReporter::onWindowInfosChanged(
         const gui::WindowInfosUpdate& update) {
     std::unordered_set<sp<WindowInfosListener>, gui::SpHash<WindowInfosListener>>
             windowInfosListeners;
+    // The listeners are always called with all the windows.
+    std::optional<gui::WindowInfosUpdate> appliedDelta;
+    const gui::WindowInfosUpdate* completeUpdate = &update;
 
     {
         std::scoped_lock lock(mListenersMutex);
+        if (update.isDelta()) {
+            appliedDelta = update;
+            if (mLastVersion != update.baseVersion ||
+                appliedDelta->applyDelta(mLastWindowInfos) != OK) {
+                ALOGW("Received window infos %" PRId64 " against %" PRId64
+                      ", asking for all the windows",
+                      update.version, *update.baseVersion);
+                mWindowInfosPublisher->ackWindowInfosReceived(update.vsyncId, mListenerId);
+                mWindowInfosPublisher->resyncWindowInfos(mListenerId);
+                return binder::Status::ok();
+            }
+            completeUpdate = &*appliedDelta;
+        }
+
         for (auto listener : mWindowInfosListeners) {
             windowInfosListeners.insert(listener);
         }
 
-        mLastWindowInfos = update.windowInfos;
-        mLastDisplayInfos = update.displayInfos;
+        mLastWindowInfos = completeUpdate->windowInfos;
+        mLastDisplayInfos = completeUpdate->displayInfos;
+        mLastVersion = completeUpdate->version;
     }
 
     for (auto listener : windowInfosListeners) {
-        listener->onWindowInfosChanged(update);
+        listener->onWindowInfosChanged(*completeUpdate);
     }
 
     mWindowInfosPublisher->ackWindowInfosReceived(update.vsyncId, mListenerId);
@@ -119,6 +142,7 @@ void WindowInfosListenerReporter::reconnect(const sp<gui::ISurfaceComposer>& com
         composerService->addWindowInfosListener(this, &listenerInfo);
         mWindowInfosPublisher = std::move(listenerInfo.windowInfosPublisher);
         mListenerId = listenerInfo.listenerId;
+        mLastVersion.reset();
     }
 }
 
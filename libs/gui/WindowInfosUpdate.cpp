@@ -17,6 +17,10 @@
 #include <gui/WindowInfosUpdate.h>
 #include <private/gui/ParcelUtils.h>
 
+#include <cinttypes>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace android::gui {
 
 status_t WindowInfosUpdate::readFromParcel(const android::Parcel* parcel) {
@@ -44,6 +48,19 @@ status_t WindowInfosUpdate::readFromParcel(const android::Parcel* parcel) {
     SAFE_PARCEL(parcel->readInt64, &vsyncId);
     SAFE_PARCEL(parcel->readInt64, &timestamp);
 
+    SAFE_PARCEL(parcel->readInt64, &version);
+    bool hasBaseVersion;
+    SAFE_PARCEL(parcel->readBool, &hasBaseVersion);
+    if (hasBaseVersion) {
+        int64_t tmpVersion;
+        SAFE_PARCEL(parcel->readInt64, &tmpVersion);
+        baseVersion = tmpVersion;
+        SAFE_PARCEL(parcel->readInt32Vector, &windowIds);
+    } else {
+        baseVersion.reset();
+        windowIds.clear();
+    }
+
     return OK;
 }
 
@@ -66,6 +83,85 @@ status_t WindowInfosUpdate::writeToParcel(android::Parcel* parcel) const {
     SAFE_PARCEL(parcel->writeInt64, vsyncId);
     SAFE_PARCEL(parcel->writeInt64, timestamp);
 
+    SAFE_PARCEL(parcel->writeInt64, version);
+    SAFE_PARCEL(parcel->writeBool, baseVersion.has_value());
+    if (baseVersion) {
+        SAFE_PARCEL(parcel->writeInt64, *baseVersion);
+        SAFE_PARCEL(parcel->writeInt32Vector, windowIds);
+    }
+
+    return OK;
+}
+
+std::optional<WindowInfosUpdate> WindowInfosUpdate::makeDelta(
+        const std::vector<WindowInfo>& baseWindowInfos, int64_t baseUpdateVersion) const {
+    if (windowInfos.empty()) {
+        return std::nullopt;
+    }
+
+    std::unordered_map<int32_t, const WindowInfo*> baseWindows;
+    baseWindows.reserve(baseWindowInfos.size());
+    for (const auto& windowInfo : baseWindowInfos) {
+        if (!baseWindows.emplace(windowInfo.id, &windowInfo).second) {
+            return std::nullopt;
+        }
+    }
+
+    WindowInfosUpdate delta{{}, displayInfos, vsyncId, timestamp};
+    delta.version = version;
+    delta.baseVersion = baseUpdateVersion;
+    delta.windowIds.reserve(windowInfos.size());
+    std::unordered_set<int32_t> ids;
+    ids.reserve(windowInfos.size());
+    for (const auto& windowInfo : windowInfos) {
+        if (!ids.insert(windowInfo.id).second) {
+            return std::nullopt;
+        }
+        delta.windowIds.push_back(windowInfo.id);
+
+        const auto it = baseWindows.find(windowInfo.id);
+        if (it == baseWindows.end() || !(*it->second == windowInfo)) {
+            // A delta where every window changed is larger than the update.
+            if (delta.windowInfos.size() + 1 == windowInfos.size()) {
+                return std::nullopt;
+            }
+            delta.windowInfos.push_back(windowInfo);
+        }
+    }
+    return delta;
+}
+
+status_t WindowInfosUpdate::applyDelta(const std::vector<WindowInfo>& baseWindowInfos) {
+    if (!baseVersion) {
+        return OK;
+    }
+
+    std::unordered_map<int32_t, const WindowInfo*> windows;
+    windows.reserve(baseWindowInfos.size() + windowInfos.size());
+    for (const auto& windowInfo : baseWindowInfos) {
+        windows.emplace(windowInfo.id, &windowInfo);
+    }
+    std::vector<WindowInfo> changedWindowInfos = std::move(windowInfos);
+    for (const auto& windowInfo : changedWindowInfos) {
+        windows.insert_or_assign(windowInfo.id, &windowInfo);
+    }
+
+    std::vector<WindowInfo> allWindowInfos;
+    allWindowInfos.reserve(windowIds.size());
+    for (int32_t id : windowIds) {
+        const auto it = windows.find(id);
+        if (it == windows.end()) {
+            ALOGE("%s: Window %" PRId32 " of update %" PRId64 " not found in update %" PRId64,
+                  __func__, id, version, *baseVersion);
+            windowInfos = std::move(changedWindowInfos);
+            return BAD_VALUE;
+        }
+        allWindowInfos.push_back(*it->second);
+    }
+
+    windowInfos = std::move(allWindowInfos);
+    baseVersion.reset();
+    windowIds.clear();
     return OK;
 }
 
@@ -143,6 +143,9 @@ public:
                 (const sp<IBinder>&, const gui::DisplayBrightness&), (override));
     MOCK_METHOD(binder::Status, addHdrLayerInfoListener,
                 (const sp<IBinder>&, const sp<gui::IHdrLayerInfoListener>&), (override));
+    MOCK_METHOD(binder::Status, addHdrLayerInfoListenerWithOptions,
+                (const sp<IBinder>&, const sp<gui::IHdrLayerInfoListener>&, int64_t, float),
+                (override));
     MOCK_METHOD(binder::Status, removeHdrLayerInfoListener,
                 (const sp<IBinder>&, const sp<gui::IHdrLayerInfoListener>&), (override));
     MOCK_METHOD(binder::Status, notifyPowerBoost, (int), (override));
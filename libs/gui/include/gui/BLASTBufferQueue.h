@@ -34,6 +34,7 @@ namespace android {
 
 class BLASTBufferQueue;
 class BufferItemConsumer;
+class FrameTimestampRing;
 
 class BLASTBufferItemConsumer : public BufferItemConsumer {
 public:
@@ -56,6 +57,9 @@ public:
 
     void resizeFrameEventHistory(size_t newSize);
 
+    // Returns the ring that the frame timestamps are also written to, creating it the first time.
+    std::shared_ptr<FrameTimestampRing> getFrameTimestampRing() EXCLUDES(mMutex);
+
 protected:
     void onSidebandStreamChanged() override EXCLUDES(mMutex);
 
@@ -66,6 +70,7 @@ private:
 
     Mutex mMutex;
     ConsumerFrameEventHistory mFrameEventHistory GUARDED_BY(mMutex);
+    std::shared_ptr<FrameTimestampRing> mFrameTimestampRing GUARDED_BY(mMutex);
     std::queue<uint64_t> mDisconnectEvents GUARDED_BY(mMutex);
     bool mCurrentlyConnected GUARDED_BY(mMutex);
     bool mPreviouslyConnected GUARDED_BY(mMutex);
@@ -81,6 +86,7 @@ public:
         return mProducer;
     }
     sp<Surface> getSurface(bool includeSurfaceControlHandle);
+    std::shared_ptr<FrameTimestampRing> getFrameTimestampRing();
     bool isSameSurfaceControl(const sp<SurfaceControl>& surfaceControl) const;
 
     void onFrameReplaced(const BufferItem& item) override;
@@ -20,6 +20,7 @@
 #include <gui/BufferItem.h>
 #include <gui/BufferQueueDefs.h>
 #include <gui/BufferSlot.h>
+#include <gui/BufferQueueTelemetry.h>
 #include <gui/OccupancyTracker.h>
 
 #include <utils/NativeHandle.h>
@@ -29,6 +30,7 @@
 #include <utils/Trace.h>
 #include <utils/Vector.h>
 
+#include <atomic>
 #include <list>
 #include <set>
 #include <mutex>
@@ -130,6 +132,10 @@ private:
     // waitWhileAllocatingLocked blocks until mIsAllocating is false.
     void waitWhileAllocatingLocked(std::unique_lock<std::mutex>& lock) const;
 
+    // updateHasBufferToAcquireLocked updates mHasBufferToAcquire. It must be
+    // called whenever mQueue or the shared buffer state changes.
+    void updateHasBufferToAcquireLocked();
+
 #if DEBUG_ONLY_CODE
     // validateConsistencyLocked ensures that the free lists are in sync with
     // the information stored in mSlots
@@ -200,6 +206,13 @@ private:
     // mQueue is a FIFO of queued buffers used in synchronous mode.
     Fifo mQueue;
 
+    // mHasBufferToAcquire is true if mQueue is not empty or a shared buffer
+    // can be acquired. It is only changed with mMutex held, but is read
+    // without it so that a consumer polling an empty queue, which is the
+    // common case for high frame rate streams, does not contend with the
+    // producer for mMutex.
+    std::atomic<bool> mHasBufferToAcquire;
+
     // mFreeSlots contains all of the slots which are FREE and do not currently
     // have a buffer attached.
     std::set<int> mFreeSlots;
@@ -297,6 +310,11 @@ private:
     // new buffers
     bool mAllowAllocation;
 
+    // mRecycleBuffers determines whether dequeueBuffer returns the buffers it reallocates to the
+    // process-wide GraphicBufferPool, and takes the buffers it allocates from it. It is set by
+    // BufferQueues whose producer and consumer are in the same process, e.g. BLASTBufferQueue.
+    bool mRecycleBuffers;
+
     // mBufferAge tracks the age of the contents of the most recently dequeued
     // buffer as the number of frames that have elapsed since it was last queued
     uint64_t mBufferAge;
@@ -344,6 +362,10 @@ private:
 
     OccupancyTracker mOccupancyTracker;
 
+    // Histograms of the dequeue, queue and hold times of the buffers, and counts of the
+    // starvations and allocations, when debug.bq.telemetry is set.
+    BufferQueueTelemetry mTelemetry;
+
     const uint64_t mUniqueId;
 
     // When buffer size is driven by the consumer and mTransformHint specifies
@@ -45,6 +45,11 @@ public:
     // flags indicating that previously-returned buffers are no longer valid.
     virtual status_t requestBuffer(int slot, sp<GraphicBuffer>* buf);
 
+    // See IGraphicBufferProducer::requestBuffers. The buffers are requested with the lock held
+    // once.
+    status_t requestBuffers(const std::vector<int32_t>& slots,
+                            std::vector<RequestBufferOutput>* outputs) override;
+
     // see IGraphicsBufferProducer::setMaxDequeuedBufferCount
     virtual status_t setMaxDequeuedBufferCount(int maxDequeuedBuffers);
 
@@ -91,6 +96,11 @@ public:
                                    uint64_t* outBufferAge,
                                    FrameEventHistoryDelta* outTimestamps) override;
 
+    // See IGraphicBufferProducer::dequeueBuffers. The slots are dequeued with the lock held once,
+    // and the buffers that need to be allocated are attached with the lock held once more.
+    status_t dequeueBuffers(const std::vector<DequeueBufferInput>& inputs,
+                            std::vector<DequeueBufferOutput>* outputs) override;
+
     // See IGraphicBufferProducer::detachBuffer
     virtual status_t detachBuffer(int slot);
 
@@ -119,6 +129,11 @@ public:
     virtual status_t queueBuffer(int slot,
             const QueueBufferInput& input, QueueBufferOutput* output);
 
+    // See IGraphicBufferProducer::queueBuffers. The buffers are queued with the lock held once,
+    // and an EGL producer is throttled once for the batch.
+    status_t queueBuffers(const std::vector<QueueBufferInput>& inputs,
+                          std::vector<QueueBufferOutput>* outputs) override;
+
     // cancelBuffer returns a dequeued buffer to the BufferQueue, but doesn't
     // queue it for use by the consumer.
     //
@@ -126,6 +141,11 @@ public:
     // will usually be the one obtained from dequeueBuffer.
     virtual status_t cancelBuffer(int slot, const sp<Fence>& fence);
 
+    // See IGraphicBufferProducer::cancelBuffers. The buffers are cancelled with the lock held
+    // once.
+    status_t cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+                           std::vector<status_t>* results) override;
+
     // Query native window attributes.  The "what" values are enumerated in
     // window.h (e.g. NATIVE_WINDOW_FORMAT).
     virtual int query(int what, int* outValue);
@@ -234,6 +254,38 @@ private:
     status_t waitForFreeSlotThenRelock(FreeSlotCaller caller, std::unique_lock<std::mutex>& lock,
             int* found) const;
 
+    // The single and batched buffer operations share these, so that a batch only takes
+    // mCore->mMutex once for all its buffers. The *Locked methods require mCore->mMutex.
+    status_t requestBufferLocked(int slot, sp<GraphicBuffer>* buf);
+    status_t cancelBufferLocked(int slot, const sp<Fence>& fence);
+
+    // A dequeue happens in up to three steps: dequeueSlotLocked picks the slot, the buffer is
+    // allocated without the lock held if it needs to be, or taken from the GraphicBufferPool if
+    // mCore->mRecycleBuffers is set, and attached to the slot, and finishDequeue waits for the
+    // EGL fence of the slot and returns the dequeue flags.
+    struct DequeuedBuffer;
+    status_t checkCanDequeueLocked();
+    void waitWhileAllocatingForDequeueLocked(std::unique_lock<std::mutex>& lock);
+    status_t dequeueSlotLocked(std::unique_lock<std::mutex>& lock, DequeuedBuffer* dequeued);
+    sp<GraphicBuffer> allocateDequeuedBuffer(DequeuedBuffer* dequeued);
+    // Returns the buffer of a slot that is being reallocated to the GraphicBufferPool, and asks
+    // the pool to allocate the buffers the other slots will need.
+    void recycleSlotBufferLocked(int slot, const DequeuedBuffer& dequeued);
+    status_t attachAllocatedBufferLocked(const DequeuedBuffer& dequeued,
+                                         const sp<GraphicBuffer>& graphicBuffer);
+    status_t finishDequeue(const DequeuedBuffer& dequeued, uint64_t* outBufferAge,
+                           FrameEventHistoryDelta* outTimestamps);
+
+    // A queue is validated without the lock held, queued by queueBufferLocked, and reported to
+    // the consumer by notifyBufferQueued, in the order of its callback ticket. notifyBufferQueued
+    // returns the fence of the buffer queued before it, which EGL producers are throttled on.
+    struct QueuedBuffer;
+    status_t parseQueueBufferInput(const QueueBufferInput& input, QueuedBuffer* queued);
+    status_t queueBufferLocked(int slot, const QueueBufferInput& input, QueueBufferOutput* output,
+                               QueuedBuffer* queued);
+    void notifyBufferQueued(QueuedBuffer& queued, QueueBufferOutput* output, int* outConnectedApi,
+                            sp<Fence>* outLastQueuedFence);
+
     sp<BufferQueueCore> mCore;
 
     // This references mCore->mSlots. Lock mCore->mMutex while accessing.
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/BufferQueueDefs.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace android {
+
+// Records where the buffers of a BufferQueue spend their time, so that pipeline-depth problems,
+// e.g. a producer that stalls on a consumer that holds its buffers for too long, can be found in
+// production. Unlike OccupancyTracker, which averages the number of queued buffers, it keeps
+// fixed-bucket histograms of:
+//  - the time the producer waits in dequeueBuffer for a free buffer,
+//  - the time buffers wait in the queue until they are acquired,
+//  - the time the consumer holds buffers from acquire to release,
+// and counts the dequeues that found no free buffer and the buffers that were allocated.
+//
+// The histograms are dumped with the BufferQueue, and each event is also reported as a counter
+// track named after the consumer while tracing.
+//
+// Telemetry is disabled unless debug.bq.telemetry is set when the BufferQueue is created. It is
+// accessed with the mutex of the BufferQueueCore held.
+class BufferQueueTelemetry {
+public:
+    enum class Latency : size_t {
+        DequeueWait,
+        QueueToAcquire,
+        AcquireToRelease,
+        COUNT,
+    };
+
+    // The upper bounds of the histogram buckets. The last bucket holds the longer times.
+    static constexpr std::array<nsecs_t, 11> kBucketBounds = {
+            us2ns(100), us2ns(250), us2ns(500), ms2ns(1),  ms2ns(2),  ms2ns(4),
+            ms2ns(8),   ms2ns(16),  ms2ns(33),  ms2ns(66), ms2ns(133),
+    };
+    static constexpr size_t kBucketCount = kBucketBounds.size() + 1;
+
+    struct Histogram {
+        std::array<uint64_t, kBucketCount> counts = {};
+        uint64_t total = 0;
+        nsecs_t sum = 0;
+        nsecs_t max = 0;
+
+        void record(nsecs_t duration);
+        // Returns the upper bound of the bucket that holds the given percentile, or max for the
+        // last bucket.
+        nsecs_t percentile(uint32_t percent) const;
+    };
+
+    // Returns whether debug.bq.telemetry is set.
+    static bool isEnabledByProperty();
+
+    explicit BufferQueueTelemetry(bool enabled) : mEnabled(enabled) {}
+
+    bool isEnabled() const { return mEnabled; }
+
+    // Sets the name of the counter tracks.
+    void setName(const String8& consumerName);
+
+    void recordDequeueWait(nsecs_t duration);
+    void recordStarvation();
+    void recordAllocation();
+    void recordQueued(int slot, nsecs_t now);
+    void recordAcquired(int slot, nsecs_t now);
+    void recordReleased(int slot, nsecs_t now);
+    // Forgets the times of a slot whose buffer was freed or detached.
+    void recordCleared(int slot);
+
+    const Histogram& getHistogram(Latency latency) const {
+        return mHistograms[static_cast<size_t>(latency)];
+    }
+    uint64_t getStarvationCount() const { return mStarvationCount; }
+    uint64_t getAllocationCount() const { return mAllocationCount; }
+
+    void dump(const String8& prefix, String8* outResult) const;
+
+private:
+    void record(Latency latency, nsecs_t duration);
+
+    const bool mEnabled;
+
+    std::array<Histogram, static_cast<size_t>(Latency::COUNT)> mHistograms;
+    uint64_t mStarvationCount = 0;
+    uint64_t mAllocationCount = 0;
+
+    // The times at which the buffer of each slot was queued and acquired, or 0.
+    std::array<nsecs_t, BufferQueueDefs::NUM_BUFFER_SLOTS> mQueueTimes = {};
+    std::array<nsecs_t, BufferQueueDefs::NUM_BUFFER_SLOTS> mAcquireTimes = {};
+
+    std::array<std::string, static_cast<size_t>(Latency::COUNT)> mTrackNames;
+    std::string mStarvationTrackName;
+    std::string mAllocationTrackName;
+};
+
+} // namespace android
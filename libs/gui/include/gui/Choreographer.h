@@ -21,9 +21,11 @@
 #include <jni.h>
 #include <utils/Looper.h>
 
+#include <atomic>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 namespace android {
 using gui::VsyncEventData;
@@ -34,6 +36,11 @@ struct FrameCallback {
     AChoreographer_vsyncCallback vsyncCallback;
     void* data;
     nsecs_t dueTime;
+    // The time the callback declares it takes to run, or 0 if unknown.
+    nsecs_t expectedCost = 0;
+    // Whether the callback may target a later frame timeline than the preferred one when it
+    // would not finish before the deadline of the preferred one.
+    bool deferrable = false;
 
     inline bool operator<(const FrameCallback& rhs) const {
         // Note that this is intentionally flipped because we want callbacks due sooner to be at
@@ -79,6 +86,12 @@ public:
                                   AChoreographer_frameCallback64 cb64,
                                   AChoreographer_vsyncCallback vsyncCallback, void* data,
                                   nsecs_t delay);
+    // Posts a vsync callback that declares how long it runs for. Deferrable callbacks run after
+    // the other callbacks of the frame, the cheapest first, and are given the earliest frame
+    // timeline whose deadline they can meet instead of the preferred one when they are at risk of
+    // missing it.
+    void postVsyncCallback(AChoreographer_vsyncCallback vsyncCallback, void* data,
+                           nsecs_t expectedCost, bool deferrable);
     void registerRefreshRateCallback(AChoreographer_refreshRateCallback cb, void* data)
             EXCLUDES(gChoreographers.lock);
     void unregisterRefreshRateCallback(AChoreographer_refreshRateCallback cb, void* data);
@@ -104,6 +117,21 @@ public:
     int64_t getFrameInterval() const;
     bool inCallback() const;
 
+    // The number of vsync callbacks that returned after the deadline of the frame timeline they
+    // were given, and the number of deferrable callbacks that were given a later frame timeline.
+    uint64_t getDeadlineOverrunCount() const { return mDeadlineOverrunCount; }
+    uint64_t getDeferredCallbackCount() const { return mDeferredCallbackCount; }
+
+    // Orders the callbacks that are due on a vsync: the callbacks that cannot be deferred first,
+    // in the order they were posted, then the deferrable ones by increasing expected cost.
+    static void orderCallbacksForFrame(std::vector<FrameCallback>& callbacks);
+
+    // Returns the index of the earliest frame timeline, from the preferred one, whose deadline is
+    // met by a callback that starts now and runs for expectedCost. Returns the preferred index if
+    // no deadline is met.
+    static uint32_t selectFrameTimeline(const VsyncEventData& vsyncEventData, nsecs_t now,
+                                        nsecs_t expectedCost);
+
 private:
     Choreographer(const Choreographer&) = delete;
 
@@ -116,9 +144,11 @@ private:
     void dispatchFrameRateOverrides(nsecs_t timestamp, PhysicalDisplayId displayId,
                                     std::vector<FrameRateOverride> overrides) override;
 
+    void postFrameCallback(const FrameCallback& callback, nsecs_t now, nsecs_t delay);
     void scheduleCallbacks();
 
     ChoreographerFrameCallbackDataImpl createFrameCallbackData(nsecs_t timestamp) const;
+    void dispatchVsyncCallback(const FrameCallback& callback, nsecs_t timestamp);
     void registerStartTime() const;
 
     std::mutex mLock;
@@ -129,6 +159,8 @@ private:
     nsecs_t mLatestVsyncPeriod = -1;
     VsyncEventData mLastVsyncEventData;
     bool mInCallback = false;
+    std::atomic<uint64_t> mDeadlineOverrunCount = 0;
+    std::atomic<uint64_t> mDeferredCallbackCount = 0;
 
     const sp<Looper> mLooper;
     const std::thread::id mThreadId;
@@ -22,8 +22,11 @@
 #include <gui/ConsumerBase.h>
 #include <gui/BufferQueue.h>
 
+#include <utils/Condition.h>
 #include <utils/Vector.h>
 
+#include <deque>
+#include <thread>
 
 namespace android {
 
@@ -94,6 +97,8 @@ class CpuConsumer : public ConsumerBase
     CpuConsumer(const sp<IGraphicBufferConsumer>& bq,
             size_t maxLockedBuffers, bool controlledByApp = false);
 
+    ~CpuConsumer() override;
+
     // Gets the next graphics buffer from the producer and locks it for CPU use,
     // filling out the passed-in locked buffer structure with the native pointer
     // and metadata. Returns BAD_VALUE if no new buffer is available, and
@@ -111,6 +116,23 @@ class CpuConsumer : public ConsumerBase
     // lockNextBuffer.
     status_t unlockBuffer(const LockedBuffer &nativeBuffer);
 
+    // Keeps the buffers mapped for the CPU between their locks, so that locking and unlocking
+    // them only waits for their fences and syncs the CPU caches, instead of mapping and
+    // unmapping them through gralloc every frame. Has no effect on the buffers of formats that
+    // are not known to be locked as either flexible YUV or not, and with gralloc HALs that
+    // don't support it. Disabled by default.
+    void setPersistentMapping(bool enabled);
+
+    // Locks up to `depth` buffers ahead of lockNextBuffer on a helper thread as they are queued,
+    // so that lockNextBuffer does not wait for acquire fences and gralloc on the caller thread.
+    // lockNextBuffer then returns the buffers locked ahead in queue order, and the frame
+    // available listener is called once a buffer is locked rather than when it is queued. The
+    // buffers are mapped persistently, as if by setPersistentMapping. The buffers locked ahead
+    // count against maxLockedBuffers. A depth of 0, the default, stops locking ahead and returns
+    // the buffers locked ahead to the queue. Returns BAD_VALUE if `depth` exceeds
+    // maxLockedBuffers. Must not be called from the frame available listener.
+    status_t setLockAheadDepth(size_t depth);
+
   private:
     // Maximum number of buffers that can be locked at a time
     const size_t mMaxLockedBuffers;
@@ -142,10 +164,35 @@ class CpuConsumer : public ConsumerBase
 
     status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const;
 
+    void mapPersistently(const GraphicBuffer& buffer) const;
+
+    void trackLockedBufferLocked(const BufferItem& item, const LockedBuffer& buffer);
+    status_t unlockBufferLocked(const LockedBuffer& nativeBuffer);
+
+    // ConsumerBase overrides:
+    void onFrameAvailable(const BufferItem& item) override;
+    void abandonLocked() override;
+
+    // Runs on mLockAheadThread until the depth is set to 0 or the consumer is abandoned.
+    void lockAheadLoop();
+    bool canLockAheadLocked() const;
+    void returnLockedAheadBuffersLocked();
+
     Vector<AcquiredBuffer> mAcquiredBuffers;
 
-    // Count of currently locked buffers
+    // Count of currently locked buffers, including the buffers locked ahead.
     size_t mCurrentLockedBuffers;
+
+    bool mPersistentMapping = false;
+
+    size_t mLockAheadDepth = 0;
+    // Buffers that are acquired and being locked by mLockAheadThread outside of mMutex.
+    size_t mLockingAheadCount = 0;
+    // Buffers that are locked ahead and not yet returned by lockNextBuffer.
+    std::deque<LockedBuffer> mLockedAheadBuffers;
+    // Signaled when a buffer is queued or unlocked, or the depth is changed.
+    Condition mLockAheadCondition;
+    std::thread mLockAheadThread;
 };
 
 } // namespace android
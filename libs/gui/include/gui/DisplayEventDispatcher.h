@@ -37,6 +37,10 @@ public:
     virtual int handleEvent(int receiveFd, int events, void* data);
     status_t getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) const;
 
+    // Reads getLatestVsyncEventData from shared memory when the latest dispatched vsync is still
+    // current, instead of asking SurfaceFlinger.
+    status_t enableVsyncMailbox();
+
 protected:
     virtual ~DisplayEventDispatcher() = default;
 
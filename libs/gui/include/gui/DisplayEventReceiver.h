@@ -29,6 +29,7 @@
 #include <android/gui/ISurfaceComposer.h>
 #include <binder/IInterface.h>
 #include <gui/VsyncEventData.h>
+#include <gui/VsyncMailbox.h>
 
 #include <ui/DisplayId.h>
 
@@ -176,9 +177,17 @@ public:
      */
     status_t getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) const;
 
+    /*
+     * enableVsyncMailbox() maps the shared memory mailbox holding the latest vsync event of this
+     * connection. Once enabled, getVsyncMailbox() returns it.
+     */
+    status_t enableVsyncMailbox();
+    const gui::VsyncMailbox* getVsyncMailbox() const { return mVsyncMailbox.get(); }
+
 private:
     sp<IDisplayEventConnection> mEventConnection;
     std::unique_ptr<gui::BitTube> mDataChannel;
+    std::unique_ptr<gui::VsyncMailbox> mVsyncMailbox;
     std::optional<status_t> mInitError;
 };
 
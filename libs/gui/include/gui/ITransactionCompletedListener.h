@@ -191,6 +191,24 @@ public:
     std::vector<TransactionStats> transactionStats;
 };
 
+// A buffer that SurfaceFlinger released, sent to the listener that set it.
+class BufferReleaseStats : public Parcelable {
+public:
+    status_t writeToParcel(Parcel* output) const override;
+    status_t readFromParcel(const Parcel* input) override;
+
+    BufferReleaseStats() = default;
+    BufferReleaseStats(const ReleaseCallbackId& callbackId, const sp<Fence>& releaseFence,
+                       uint32_t currentMaxAcquiredBufferCount)
+          : callbackId(callbackId),
+            releaseFence(releaseFence),
+            currentMaxAcquiredBufferCount(currentMaxAcquiredBufferCount) {}
+
+    ReleaseCallbackId callbackId;
+    sp<Fence> releaseFence = Fence::NO_FENCE;
+    uint32_t currentMaxAcquiredBufferCount = 0;
+};
+
 class ITransactionCompletedListener : public IInterface {
 public:
     DECLARE_META_INTERFACE(TransactionCompletedListener)
@@ -200,6 +218,9 @@ public:
     virtual void onReleaseBuffer(ReleaseCallbackId callbackId, sp<Fence> releaseFence,
                                  uint32_t currentMaxAcquiredBufferCount) = 0;
 
+    // Called with all the buffers of the listener that were released in a frame.
+    virtual void onReleaseBuffers(std::vector<BufferReleaseStats> stats) = 0;
+
     virtual void onTransactionQueueStalled(const String8& name) = 0;
 
     virtual void onTrustedPresentationChanged(int id, bool inTrustedPresentationState) = 0;
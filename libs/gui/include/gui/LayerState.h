@@ -219,6 +219,8 @@ struct layer_state_t {
     layer_state_t();
 
     void merge(const layer_state_t& other);
+    // Only the fields of the changes in what are written, and read. The other fields of the state
+    // read into keep their values, so states are read into a new layer_state_t.
     status_t write(Parcel& output) const;
     status_t read(const Parcel& input);
     // Compares two layer_state_t structs and returns a set of change flags describing all the
@@ -278,6 +280,26 @@ struct layer_state_t {
     static constexpr uint64_t VISIBLE_REGION_CHANGES =
             layer_state_t::GEOMETRY_CHANGES | layer_state_t::HIERARCHY_CHANGES;
 
+    // Changes whose fields are plain values. A state with only these changes, and no buffer,
+    // sideband stream or callbacks, is written to the parcel in one fixed layout block instead of
+    // field by field.
+    static constexpr uint64_t COMPACT_CHANGES = layer_state_t::ePositionChanged |
+            layer_state_t::eLayerChanged | layer_state_t::eAlphaChanged |
+            layer_state_t::eMatrixChanged | layer_state_t::eFlagsChanged |
+            layer_state_t::eLayerStackChanged | layer_state_t::eCachingHintChanged |
+            layer_state_t::eDimmingEnabledChanged | layer_state_t::eShadowRadiusChanged |
+            layer_state_t::eBufferCropChanged | layer_state_t::eColorChanged |
+            layer_state_t::eBufferTransformChanged |
+            layer_state_t::eTransformToDisplayInverseChanged | layer_state_t::eCropChanged |
+            layer_state_t::eDataspaceChanged | layer_state_t::eCornerRadiusChanged |
+            layer_state_t::eDestinationFrameChanged | layer_state_t::eColorSpaceAgnosticChanged |
+            layer_state_t::eFrameRateSelectionPriority |
+            layer_state_t::eBackgroundBlurRadiusChanged |
+            layer_state_t::eFixedTransformHintChanged | layer_state_t::eAutoRefreshChanged |
+            layer_state_t::eTrustedOverlayChanged | layer_state_t::eDropInputModeChanged |
+            layer_state_t::eExtendedRangeBrightnessChanged;
+    bool isCompact() const;
+
     bool hasValidBuffer() const;
     void sanitize(int32_t permissions);
 
@@ -50,6 +50,23 @@ public:
     static status_t createSplitter(const sp<IGraphicBufferConsumer>& inputQueue,
             sp<StreamSplitter>* outSplitter);
 
+    // OutputMode is how an output handles the buffers queued to it while its
+    // consumer is busy. Every output is queued the same GraphicBuffers, which
+    // are returned to the input once all of the outputs have released them.
+    enum class OutputMode {
+        // Every buffer waits in the output until its consumer acquires it. A
+        // consumer that is slower than the input holds on to the buffers, which
+        // stalls the input and the other outputs.
+        FIFO,
+        // Only the latest buffer waits in the output. Queueing a buffer drops
+        // the one that was waiting, which is released as if the consumer had
+        // released it. A consumer that is slower than the input misses frames,
+        // but holds at most the buffers it has acquired and one waiting buffer,
+        // so that it never stalls the other outputs, e.g. a preview next to an
+        // encoder.
+        LATEST_ONLY,
+    };
+
     // addOutput adds an output BufferQueue to the splitter. The splitter
     // connects to outputQueue as a CPU producer, and any buffers queued
     // to the input will be queued to each output. It is assumed that all of the
@@ -61,7 +78,18 @@ public:
     // outputQueue has not been added to the splitter. BAD_VALUE is returned if
     // outputQueue is NULL. See IGraphicBufferProducer::connect for explanations
     // of other error codes.
-    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue);
+    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue,
+                       OutputMode mode = OutputMode::FIFO);
+
+    // setMaxOutstandingBuffers sets how many buffers can be detached from the
+    // input, i.e. queued to or held by the outputs, before the splitter stops
+    // acquiring buffers from the input. It defaults to
+    // DEFAULT_MAX_OUTSTANDING_BUFFERS. Allowing more buffers lets FIFO outputs
+    // whose consumers hold a few buffers keep up with the input.
+    //
+    // BAD_VALUE is returned if count is less than 1.
+    static const int DEFAULT_MAX_OUTSTANDING_BUFFERS = 2;
+    status_t setMaxOutstandingBuffers(int count);
 
     // setName sets the consumer name of the input queue
     void setName(const String8& name);
@@ -97,6 +125,12 @@ private:
     // onFrameAvailable call to proceed.
     void onBufferReleasedByOutput(const sp<IGraphicBufferProducer>& from);
 
+    // Detaches the next free buffer of the output, i.e. a buffer that its
+    // consumer released or that it dropped, and releases it to the input if
+    // all of the outputs are done with it. This must be called with mMutex
+    // locked.
+    void releaseBufferFromOutputLocked(const sp<IGraphicBufferProducer>& from);
+
     // When this is called, the splitter disconnects from (i.e., abandons) its
     // input queue and signals any waiting onFrameAvailable calls to wake up.
     // It still processes callbacks from other outputs, but only detaches their
@@ -159,7 +193,10 @@ private:
     // Must be accessed through RefBase
     virtual ~StreamSplitter();
 
-    static const int MAX_OUTSTANDING_BUFFERS = 2;
+    struct Output {
+        sp<IGraphicBufferProducer> queue;
+        OutputMode mode;
+    };
 
     // mIsAbandoned is set to true when an output dies. Once the StreamSplitter
     // has been abandoned, it will continue to detach buffers from other
@@ -170,8 +207,9 @@ private:
     Mutex mMutex;
     Condition mReleaseCondition;
     int mOutstandingBuffers;
+    int mMaxOutstandingBuffers;
     sp<IGraphicBufferConsumer> mInput;
-    Vector<sp<IGraphicBufferProducer> > mOutputs;
+    Vector<Output> mOutputs;
 
     // Map of GraphicBuffer IDs (GraphicBuffer::getId()) to buffer tracking
     // objects (which are mostly for counting how many outputs have released the
@@ -30,6 +30,7 @@
 #include <utils/Mutex.h>
 #include <utils/RefBase.h>
 
+#include <atomic>
 #include <shared_mutex>
 #include <unordered_set>
 
@@ -39,6 +40,7 @@ namespace gui {
 class ISurfaceComposer;
 } // namespace gui
 
+class FrameTimestampRing;
 class ISurfaceComposer;
 
 using gui::FrameTimelineInfo;
@@ -223,6 +225,10 @@ protected:
     virtual sp<gui::ISurfaceComposer> composerServiceAIDL() const;
     virtual nsecs_t now() const;
 
+    // Returns the ring that the timestamps of the frames can be read from without calling the
+    // producer, if its BufferQueue keeps one. Called once frame timestamps are enabled.
+    virtual std::shared_ptr<FrameTimestampRing> getFrameTimestampRing() { return nullptr; }
+
 private:
     // can't be copied
     Surface& operator = (const Surface& rhs);
@@ -474,13 +480,15 @@ protected:
 
     // mTimestamp is the timestamp that will be used for the next buffer queue
     // operation. It defaults to NATIVE_WINDOW_TIMESTAMP_AUTO, which means that
-    // a timestamp is auto-generated when queueBuffer is called.
-    int64_t mTimestamp;
+    // a timestamp is auto-generated when queueBuffer is called. It is atomic
+    // rather than guarded by mMutex because it is set for every frame.
+    std::atomic<int64_t> mTimestamp;
 
     // mDataSpace is the buffer dataSpace that will be used for the next buffer
     // queue operation. It defaults to Dataspace::UNKNOWN, which
-    // means that the buffer contains some type of color data.
-    ui::Dataspace mDataSpace;
+    // means that the buffer contains some type of color data. Like mTimestamp,
+    // it is atomic because EGL and Vulkan set it for every frame.
+    std::atomic<ui::Dataspace> mDataSpace;
 
     // mHdrMetadata is the HDR metadata that will be used for the next buffer
     // queue operation.  There is no HDR metadata by default.
@@ -552,6 +560,9 @@ protected:
 
     // mInterceptorMutex is the mutex guarding interceptors.
     mutable std::shared_mutex mInterceptorMutex;
+    // Whether an interceptor was ever added, so that the hooks of the windows
+    // without interceptors, i.e. nearly all of them, skip mInterceptorMutex.
+    std::atomic<bool> mHasInterceptors = false;
 
     ANativeWindow_cancelBufferInterceptor mCancelInterceptor = nullptr;
     void* mCancelInterceptorData = nullptr;
@@ -618,6 +629,7 @@ protected:
     // A cached copy of the FrameEventHistory maintained by the consumer.
     bool mEnableFrameTimestamps = false;
     std::unique_ptr<ProducerFrameEventHistory> mFrameEventHistory;
+    std::shared_ptr<FrameTimestampRing> mFrameTimestampRing;
 
     // Reference to the SurfaceFlinger layer that was used to create this
     // surface. This is only populated when the Surface is created from
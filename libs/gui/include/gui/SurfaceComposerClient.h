@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <chrono>
 #include <set>
 #include <thread>
 #include <unordered_map>
@@ -274,6 +275,13 @@ public:
 
     static status_t addHdrLayerInfoListener(const sp<IBinder>& displayToken,
                                             const sp<gui::IHdrLayerInfoListener>& listener);
+    // Adds a listener which is called at most once per minUpdateInterval, unless HDR layers
+    // appear or disappear, and not for relative changes of the max HDR layer area or desired
+    // ratio within hysteresis.
+    static status_t addHdrLayerInfoListener(const sp<IBinder>& displayToken,
+                                            const sp<gui::IHdrLayerInfoListener>& listener,
+                                            std::chrono::nanoseconds minUpdateInterval,
+                                            float hysteresis);
     static status_t removeHdrLayerInfoListener(const sp<IBinder>& displayToken,
                                                const sp<gui::IHdrLayerInfoListener>& listener);
 
@@ -413,7 +421,11 @@ public:
         static void clearFrameTimelineInfo(FrameTimelineInfo& t);
 
     protected:
-        std::unordered_map<sp<IBinder>, ComposerState, IBinderHash> mComposerStates;
+        // The layer states with their handles, in the order the layers were added to the
+        // transaction. See findComposerState().
+        std::vector<std::pair<sp<IBinder>, ComposerState>> mComposerStates;
+        std::unordered_map<IBinder*, size_t> mComposerStateIndices;
+        size_t mLastComposerStateIndex = 0;
         SortedVector<DisplayState> mDisplayStates;
         std::unordered_map<sp<ITransactionCompletedListener>, CallbackInfo, TCLHash>
                 mListenerCallbacks;
@@ -462,7 +474,12 @@ public:
         InputWindowCommands mInputWindowCommands;
         int mStatus = NO_ERROR;
 
+        // The returned state is valid until the next layer is added to the transaction.
         layer_state_t* getLayerState(const sp<SurfaceControl>& sc);
+        // Returns null if the layer is not in the transaction. The layer of the last lookup is
+        // checked first, as the setters of a layer are usually called in a row.
+        ComposerState* findComposerState(const sp<IBinder>& handle);
+        ComposerState& addComposerState(const sp<IBinder>& handle, ComposerState&& state);
         DisplayState& getDisplayState(const sp<IBinder>& token);
 
         void cacheBuffers();
@@ -929,6 +946,7 @@ public:
     void onTransactionCompleted(ListenerStats stats) override;
     void onReleaseBuffer(ReleaseCallbackId, sp<Fence> releaseFence,
                          uint32_t currentMaxAcquiredBufferCount) override;
+    void onReleaseBuffers(std::vector<BufferReleaseStats> stats) override;
 
     void removeReleaseBufferCallback(const ReleaseCallbackId& callbackId);
 
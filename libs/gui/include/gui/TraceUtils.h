@@ -21,11 +21,10 @@
 #include <cutils/trace.h>
 #include <utils/Trace.h>
 
-#define ATRACE_FORMAT(fmt, ...)                                                 \
-    TraceUtils::TraceEnder traceEnder =                                         \
-            (CC_UNLIKELY(ATRACE_ENABLED()) &&                                   \
-                     (TraceUtils::atraceFormatBegin(fmt, ##__VA_ARGS__), true), \
-             TraceUtils::TraceEnder())
+#define ATRACE_FORMAT(fmt, ...)                                   \
+    TraceUtils::TraceEnder traceEnder(                            \
+            CC_UNLIKELY(ATRACE_ENABLED()) &&                      \
+            (TraceUtils::atraceFormatBegin(fmt, ##__VA_ARGS__), true))
 
 #define ATRACE_FORMAT_INSTANT(fmt, ...) \
     (CC_UNLIKELY(ATRACE_ENABLED()) && (TraceUtils::instantFormat(fmt, ##__VA_ARGS__), true))
@@ -40,9 +39,18 @@ namespace android {
 
 class TraceUtils {
 public:
+    // Ends the section only if it was begun, so that a section which was skipped because tracing
+    // was off does not cost a check of the tags on the way out, nor end an unrelated section if
+    // tracing was turned on meanwhile.
     class TraceEnder {
     public:
-        ~TraceEnder() { ATRACE_END(); }
+        explicit TraceEnder(bool began) : mBegan(began) {}
+        ~TraceEnder() {
+            if (mBegan) ATRACE_END();
+        }
+
+    private:
+        const bool mBegan;
     };
 
     static void atraceFormatBegin(const char* fmt, ...) {
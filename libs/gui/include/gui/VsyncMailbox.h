@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include <android-base/unique_fd.h>
+#include <gui/VsyncEventData.h>
+#include <utils/Timers.h>
+
+namespace android::gui {
+
+struct VsyncMailboxPage;
+
+// Shared memory through which SurfaceFlinger publishes the latest VSYNC of a display event
+// connection. Reading it does not need a syscall, so clients that only need the latest frame
+// timeline do not have to be woken for every VSYNC. Clients that need to wait for the next VSYNC
+// block on a futex in the shared memory.
+//
+// SurfaceFlinger maps the memory writable and publishes from a single thread. Clients can only
+// map it read-only.
+class VsyncMailbox {
+public:
+    // Laid out the same for 32-bit and 64-bit processes.
+    struct Vsync {
+        nsecs_t timestamp __attribute__((aligned(8)));
+        uint32_t count;
+        VsyncEventData vsyncData;
+    };
+
+    // Creates a mailbox to publish to. Returns nullptr on failure.
+    static std::unique_ptr<VsyncMailbox> create();
+
+    // Maps the mailbox created by another process. Returns nullptr if `fd` is not a mailbox.
+    static std::unique_ptr<VsyncMailbox> fromFd(base::unique_fd fd);
+
+    ~VsyncMailbox();
+
+    VsyncMailbox(const VsyncMailbox&) = delete;
+    VsyncMailbox& operator=(const VsyncMailbox&) = delete;
+
+    // The file descriptor to send to the client. OWNERSHIP IS RETAINED by the mailbox.
+    int getFd() const { return mFd.get(); }
+
+    // Publishes the VSYNC and wakes readers blocked in waitForNext. Only valid for a mailbox
+    // returned by create(), and must not be called concurrently.
+    void publish(const Vsync&);
+
+    // Returns the latest VSYNC, or nullopt if none has been published, or if every attempt to read
+    // overlapped a publish. If `outSequence` is set, it receives the sequence of the VSYNC read,
+    // for waitForNext.
+    std::optional<Vsync> read(uint32_t* outSequence = nullptr) const;
+
+    // Blocks until a VSYNC after the one with `sequence` is published. Returns false on timeout.
+    bool waitForNext(uint32_t sequence, std::chrono::nanoseconds timeout) const;
+
+private:
+    VsyncMailbox(base::unique_fd, VsyncMailboxPage*, bool writable);
+
+    const base::unique_fd mFd;
+    VsyncMailboxPage* const mPage;
+    const bool mWritable;
+};
+
+} // namespace android::gui
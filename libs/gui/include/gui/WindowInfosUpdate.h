@@ -20,6 +20,9 @@
 #include <gui/DisplayInfo.h>
 #include <gui/WindowInfo.h>
 
+#include <optional>
+#include <vector>
+
 namespace android::gui {
 
 struct WindowInfosUpdate : public Parcelable {
@@ -37,6 +40,26 @@ struct WindowInfosUpdate : public Parcelable {
     int64_t vsyncId;
     int64_t timestamp;
 
+    // The updates sent to a listener are numbered. An update that is a delta against the update
+    // numbered baseVersion only holds the windows that were added or changed since that update in
+    // windowInfos, and the ids of all of its windows, in z order, in windowIds. The windows whose
+    // ids are missing were removed. The display infos are always complete.
+    int64_t version = 0;
+    std::optional<int64_t> baseVersion;
+    std::vector<int32_t> windowIds;
+
+    bool isDelta() const { return baseVersion.has_value(); }
+
+    // Returns the delta that turns the windows of the update numbered baseUpdateVersion into
+    // the windows of this update, or nullopt if the ids of the windows aren't unique or if the
+    // delta wouldn't be smaller than this update.
+    std::optional<WindowInfosUpdate> makeDelta(const std::vector<WindowInfo>& baseWindowInfos,
+                                               int64_t baseUpdateVersion) const;
+
+    // Turns the delta into the complete update, taking the windows that didn't change from the
+    // windows of the base update. Returns BAD_VALUE if a window isn't found.
+    status_t applyDelta(const std::vector<WindowInfo>& baseWindowInfos);
+
     status_t writeToParcel(android::Parcel*) const override;
     status_t readFromParcel(const android::Parcel*) override;
 };
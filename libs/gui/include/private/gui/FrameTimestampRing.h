@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/FrameTimestamps.h>
+#include <ui/Fence.h>
+#include <utils/StrongPointer.h>
+#include <utils/Timers.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace android {
+
+// The timestamps of the last frames queued to a BLASTBufferQueue, that the queue writes as
+// SurfaceFlinger reports them, and that the Surface of the queue reads without taking the locks of
+// the queue, or building and applying a FrameEventHistoryDelta.
+//
+// Each entry is guarded by a sequence number that is odd while the entry is written, so readers
+// retry instead of blocking the writer. The ring is only created once the producer enables frame
+// timestamps.
+class FrameTimestampRing {
+public:
+    // As many frames as the producer's FrameEventHistory holds initially.
+    static constexpr size_t kSize = 8;
+
+    // The timestamps of a frame, FrameEvents::TIMESTAMP_PENDING until known. The times of the
+    // fences are Fence::SIGNAL_TIME_INVALID if there is no fence.
+    struct Timestamps {
+        uint64_t frameNumber = 0;
+        nsecs_t latchTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t firstRefreshStartTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t lastRefreshStartTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t dequeueReadyTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t gpuCompositionDoneTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t displayPresentTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t releaseTime = FrameEvents::TIMESTAMP_PENDING;
+    };
+
+    // Records the timestamps SurfaceFlinger reported for the frame, and the signal times of the
+    // fences of the frames that are known by now. Must not be called concurrently.
+    void addFrame(uint64_t frameNumber, nsecs_t latchTime, nsecs_t refreshStartTime,
+                  nsecs_t dequeueReadyTime, const sp<Fence>& gpuCompositionDoneFence,
+                  const sp<Fence>& displayPresentFence, const sp<Fence>& releaseFence);
+
+    // Returns the timestamps of the frame, or nullopt if they were never written or were
+    // overwritten by a later frame.
+    std::optional<Timestamps> getFrame(uint64_t frameNumber) const;
+
+private:
+    static constexpr size_t kTimestampCount = 7;
+
+    struct Entry {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint64_t> frameNumber{0};
+        std::array<std::atomic<int64_t>, kTimestampCount> times{};
+    };
+
+    // The fences of the frame that haven't signaled yet. Only used by the writer.
+    struct PendingFences {
+        sp<Fence> gpuCompositionDone;
+        sp<Fence> displayPresent;
+        sp<Fence> release;
+    };
+
+    void publish(const Timestamps& timestamps);
+    // Returns whether the signal time of the fence became known, and drops the fence if so.
+    static bool updateSignalTime(sp<Fence>& fence, nsecs_t* signalTime);
+
+    std::array<Entry, kSize> mEntries;
+
+    std::array<Timestamps, kSize> mFrames;
+    std::array<PendingFences, kSize> mPendingFences;
+};
+
+} // namespace android
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+#include <ui/PixelFormat.h>
+#include <utils/StrongPointer.h>
+#include <utils/Timers.h>
+
+#include <compare>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace android {
+
+// A process-wide pool of GraphicBuffers that BufferQueues have stopped using because the
+// attributes of their buffers changed, e.g. when a window resizes. Instead of freeing the buffers
+// and allocating new ones through gralloc on the producer's thread, BufferQueues that recycle their
+// buffers return the old buffers to the pool, and take a buffer from the pool when they need one,
+// if it holds one with the same attributes.
+//
+// A BufferQueue that needs a buffer of new attributes for one slot usually needs them for its
+// other slots soon after, so it can ask the pool to allocate those ahead of time, on the pool's
+// thread.
+//
+// The pool holds at most a fixed number of bytes, dropping the buffers that were returned first,
+// and drops the buffers that have not been taken for a while.
+class GraphicBufferPool {
+public:
+    // The attributes that a buffer must have to be taken from the pool. Buffers are kept in one
+    // bucket per set of attributes.
+    struct Key {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        PixelFormat format = PIXEL_FORMAT_NONE;
+        uint32_t layerCount = 1;
+        uint64_t usage = 0;
+
+        static Key from(const GraphicBuffer& buffer);
+        auto operator<=>(const Key&) const = default;
+    };
+
+    struct Buffer {
+        sp<GraphicBuffer> buffer;
+        // Signals when the last user of the buffer has stopped reading it.
+        sp<Fence> fence = Fence::NO_FENCE;
+    };
+
+    static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+    static constexpr nsecs_t kDefaultMaxAge = s2ns(2);
+
+    // Returns the pool of the process. Its cap is read from debug.gui.buffer_pool_kb, where 0
+    // disables the pool.
+    static GraphicBufferPool& getInstance();
+
+    GraphicBufferPool(size_t maxBytes, nsecs_t maxAge);
+    ~GraphicBufferPool();
+
+    bool isEnabled() const { return mMaxBytes > 0; }
+
+    // Returns a buffer with the given attributes, and the fence to wait on before writing to it,
+    // if the pool holds one.
+    std::optional<Buffer> take(const Key& key) EXCLUDES(mMutex);
+
+    // Returns a buffer that is no longer used to the pool. Buffers that do not fit within the cap
+    // are dropped.
+    void put(Buffer&& buffer) EXCLUDES(mMutex);
+
+    // Allocates buffers with the given attributes on the pool's thread until the pool holds, or is
+    // allocating, count of them.
+    void preallocate(const Key& key, size_t count, const std::string& requestorName)
+            EXCLUDES(mMutex);
+
+    void clear() EXCLUDES(mMutex);
+
+    size_t getBufferCount() const EXCLUDES(mMutex);
+    size_t getSizeBytes() const EXCLUDES(mMutex);
+
+    // Blocks until the buffers requested by preallocate have been allocated. Used by tests.
+    void waitForPendingAllocations() EXCLUDES(mMutex);
+
+private:
+    struct Entry {
+        Buffer buffer;
+        size_t bytes = 0;
+        uint64_t sequence = 0;
+        nsecs_t returnedTime = 0;
+    };
+
+    struct Allocation {
+        Key key;
+        std::string requestorName;
+    };
+
+    // Drops the buffers returned the longest ago until bytes more fit within the cap.
+    void makeRoomLocked(size_t bytes) REQUIRES(mMutex);
+    void dropExpiredLocked(nsecs_t now) REQUIRES(mMutex);
+    void eraseLocked(std::map<Key, std::deque<Entry>>::iterator bucket) REQUIRES(mMutex);
+    void threadMain() EXCLUDES(mMutex);
+
+    const size_t mMaxBytes;
+    const nsecs_t mMaxAge;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    // The buffers of each bucket, from the one returned first.
+    std::map<Key, std::deque<Entry>> mBuckets GUARDED_BY(mMutex);
+    size_t mSizeBytes GUARDED_BY(mMutex) = 0;
+    uint64_t mNextSequence GUARDED_BY(mMutex) = 0;
+
+    std::deque<Allocation> mAllocations GUARDED_BY(mMutex);
+    // The number of buffers of each bucket that are requested or being allocated.
+    std::map<Key, size_t> mPendingAllocations GUARDED_BY(mMutex);
+    bool mDone GUARDED_BY(mMutex) = false;
+    std::optional<std::thread> mThread GUARDED_BY(mMutex);
+};
+
+} // namespace android
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gui/BufferQueueTelemetry.h>
+
+#include <cstring>
+
+namespace android::test {
+
+using Latency = BufferQueueTelemetry::Latency;
+
+TEST(BufferQueueTelemetryTest, recordsLatenciesOfSlots) {
+    BufferQueueTelemetry telemetry(/*enabled=*/true);
+    telemetry.setName(String8("test"));
+
+    telemetry.recordQueued(1, ms2ns(10));
+    telemetry.recordAcquired(1, ms2ns(13));
+    telemetry.recordReleased(1, ms2ns(30));
+
+    const auto& queueToAcquire = telemetry.getHistogram(Latency::QueueToAcquire);
+    EXPECT_EQ(1u, queueToAcquire.total);
+    EXPECT_EQ(ms2ns(3), queueToAcquire.max);
+    // The percentile is the upper bound of its bucket, capped to the maximum.
+    EXPECT_EQ(ms2ns(3), queueToAcquire.percentile(50));
+
+    const auto& acquireToRelease = telemetry.getHistogram(Latency::AcquireToRelease);
+    EXPECT_EQ(1u, acquireToRelease.total);
+    EXPECT_EQ(ms2ns(17), acquireToRelease.max);
+
+    // Releasing again, or acquiring the shared buffer without queueing it, records nothing.
+    telemetry.recordReleased(1, ms2ns(40));
+    EXPECT_EQ(1u, telemetry.getHistogram(Latency::AcquireToRelease).total);
+    telemetry.recordAcquired(1, ms2ns(50));
+    EXPECT_EQ(1u, telemetry.getHistogram(Latency::QueueToAcquire).total);
+}
+
+TEST(BufferQueueTelemetryTest, forgetsClearedSlots) {
+    BufferQueueTelemetry telemetry(/*enabled=*/true);
+    telemetry.recordQueued(2, ms2ns(10));
+    telemetry.recordCleared(2);
+    telemetry.recordAcquired(2, ms2ns(20));
+    EXPECT_EQ(0u, telemetry.getHistogram(Latency::QueueToAcquire).total);
+}
+
+TEST(BufferQueueTelemetryTest, bucketsLatencies) {
+    BufferQueueTelemetry telemetry(/*enabled=*/true);
+    for (int i = 0; i < 9; i++) {
+        telemetry.recordDequeueWait(us2ns(50));
+    }
+    telemetry.recordDequeueWait(ms2ns(500));
+
+    const auto& dequeueWait = telemetry.getHistogram(Latency::DequeueWait);
+    EXPECT_EQ(9u, dequeueWait.counts.front());
+    EXPECT_EQ(1u, dequeueWait.counts.back());
+    EXPECT_EQ(us2ns(100), dequeueWait.percentile(50));
+    EXPECT_EQ(ms2ns(500), dequeueWait.percentile(99));
+}
+
+TEST(BufferQueueTelemetryTest, dumpsCounts) {
+    BufferQueueTelemetry telemetry(/*enabled=*/true);
+    telemetry.recordStarvation();
+    telemetry.recordAllocation();
+    telemetry.recordAllocation();
+
+    String8 result;
+    telemetry.dump(String8(), &result);
+    EXPECT_NE(nullptr, strstr(result.string(), "starvations=1 allocations=2"));
+    EXPECT_NE(nullptr, strstr(result.string(), "dequeueWait: count=0"));
+}
+
+TEST(BufferQueueTelemetryTest, recordsNothingWhenDisabled) {
+    BufferQueueTelemetry telemetry(/*enabled=*/false);
+    telemetry.recordStarvation();
+    telemetry.recordDequeueWait(ms2ns(1));
+    EXPECT_EQ(0u, telemetry.getStarvationCount());
+    EXPECT_EQ(0u, telemetry.getHistogram(Latency::DequeueWait).total);
+
+    String8 result;
+    telemetry.dump(String8(), &result);
+    EXPECT_EQ(0u, result.size());
+}
+
+} // namespace android::test
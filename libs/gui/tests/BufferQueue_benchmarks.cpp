@@ -0,0 +1,263 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IProducerListener.h>
+#include <gui/Surface.h>
+#include <ui/GraphicBuffer.h>
+
+#include "MockConsumer.h"
+
+namespace android {
+namespace {
+
+constexpr int kFramesPerIteration = 1000;
+
+// Measures how fast a producer can dequeue and queue buffers in async mode while the consumer
+// polls for buffers from another thread, the way camera and game streams drive a BufferQueue.
+// The consumer polls state.range(0) times between acquires, so that most of its calls find no
+// buffer to acquire, and contend with the producer unless they avoid the lock.
+void BM_AsyncQueueThroughput(benchmark::State& state) {
+    const auto pollsPerAcquire = static_cast<int>(state.range(0));
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(sp<MockConsumer>::make(), false);
+    IGraphicBufferProducer::QueueBufferOutput qbo;
+    if (producer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false, &qbo) !=
+        NO_ERROR) {
+        state.SkipWithError("Could not connect the producer");
+        return;
+    }
+    producer->setAsyncMode(true);
+
+    std::atomic<bool> stop = false;
+    std::atomic<int> acquired = 0;
+    std::thread consumerThread([&]() {
+        BufferItem item;
+        int polls = 0;
+        while (!stop) {
+            if (consumer->acquireBuffer(&item, 0) == NO_ERROR) {
+                consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                        EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+                acquired++;
+            } else if (++polls >= pollsPerAcquire) {
+                polls = 0;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    const IGraphicBufferProducer::QueueBufferInput qbi(0, false, HAL_DATASPACE_UNKNOWN,
+                                                       Rect(0, 0, 1, 1),
+                                                       NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                       Fence::NO_FENCE);
+    for (auto _ : state) {
+        for (int i = 0; i < kFramesPerIteration; i++) {
+            int slot;
+            sp<Fence> fence;
+            const status_t result =
+                    producer->dequeueBuffer(&slot, &fence, 1, 1, 0, GRALLOC_USAGE_SW_READ_OFTEN,
+                                            nullptr, nullptr);
+            if (result < 0) {
+                state.SkipWithError("dequeueBuffer failed");
+                break;
+            }
+            if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+                sp<GraphicBuffer> buffer;
+                producer->requestBuffer(slot, &buffer);
+            }
+            producer->queueBuffer(slot, qbi, &qbo);
+        }
+    }
+
+    stop = true;
+    consumerThread.join();
+    state.SetItemsProcessed(state.iterations() * kFramesPerIteration);
+    state.counters["acquired"] = acquired.load();
+    producer->disconnect(NATIVE_WINDOW_API_CPU);
+    consumer->consumerDisconnect();
+}
+
+BENCHMARK(BM_AsyncQueueThroughput)->Arg(1)->Arg(100)->UseRealTime();
+
+// Measures dequeueing and queueing state.range(0) buffers at a time, with the batched calls if
+// state.range(1) is set and with one call per buffer otherwise. The consumer acquires and
+// releases the buffers on the same thread, so only the cost of the producer calls differs.
+void BM_BatchDequeueQueue(benchmark::State& state) {
+    using DequeueBufferInput = IGraphicBufferProducer::DequeueBufferInput;
+    using DequeueBufferOutput = IGraphicBufferProducer::DequeueBufferOutput;
+    using QueueBufferInput = IGraphicBufferProducer::QueueBufferInput;
+    using QueueBufferOutput = IGraphicBufferProducer::QueueBufferOutput;
+    using RequestBufferOutput = IGraphicBufferProducer::RequestBufferOutput;
+
+    const auto batchSize = static_cast<size_t>(state.range(0));
+    const bool batched = state.range(1) != 0;
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(sp<MockConsumer>::make(), false);
+    consumer->setMaxAcquiredBufferCount(static_cast<int>(batchSize));
+    QueueBufferOutput qbo;
+    if (producer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false, &qbo) !=
+                NO_ERROR ||
+        producer->setMaxDequeuedBufferCount(static_cast<int>(batchSize)) != NO_ERROR) {
+        state.SkipWithError("Could not set up the BufferQueue");
+        return;
+    }
+
+    DequeueBufferInput dequeueInput;
+    dequeueInput.width = 1;
+    dequeueInput.height = 1;
+    dequeueInput.format = 0;
+    dequeueInput.usage = GRALLOC_USAGE_SW_READ_OFTEN;
+    dequeueInput.getTimestamps = false;
+    const std::vector<DequeueBufferInput> dequeueInputs(batchSize, dequeueInput);
+    std::vector<DequeueBufferOutput> dequeueOutputs(batchSize);
+    std::vector<QueueBufferInput> queueInputs(batchSize,
+                                              QueueBufferInput(0, false, HAL_DATASPACE_UNKNOWN,
+                                                               Rect(0, 0, 1, 1),
+                                                               NATIVE_WINDOW_SCALING_MODE_FREEZE,
+                                                               0, Fence::NO_FENCE));
+    std::vector<QueueBufferOutput> queueOutputs(batchSize);
+    std::vector<int32_t> requestSlots;
+    std::vector<RequestBufferOutput> requestOutputs;
+
+    for (auto _ : state) {
+        if (batched) {
+            producer->dequeueBuffers(dequeueInputs, &dequeueOutputs);
+        } else {
+            for (DequeueBufferOutput& output : dequeueOutputs) {
+                output.result =
+                        producer->dequeueBuffer(&output.slot, &output.fence, dequeueInput.width,
+                                                dequeueInput.height, dequeueInput.format,
+                                                dequeueInput.usage, nullptr, nullptr);
+            }
+        }
+
+        const bool dequeued =
+                std::all_of(dequeueOutputs.begin(), dequeueOutputs.end(),
+                            [](const DequeueBufferOutput& output) { return output.result >= 0; });
+        if (!dequeued) {
+            state.SkipWithError("dequeueBuffer failed");
+            break;
+        }
+
+        requestSlots.clear();
+        for (size_t i = 0; i < batchSize; i++) {
+            if (dequeueOutputs[i].result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+                requestSlots.push_back(dequeueOutputs[i].slot);
+            }
+            queueInputs[i].slot = dequeueOutputs[i].slot;
+        }
+        if (!requestSlots.empty()) {
+            producer->requestBuffers(requestSlots, &requestOutputs);
+        }
+
+        if (batched) {
+            producer->queueBuffers(queueInputs, &queueOutputs);
+        } else {
+            for (size_t i = 0; i < batchSize; i++) {
+                producer->queueBuffer(queueInputs[i].slot, queueInputs[i], &queueOutputs[i]);
+            }
+        }
+
+        state.PauseTiming();
+        BufferItem item;
+        while (consumer->acquireBuffer(&item, 0) == NO_ERROR) {
+            consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                    EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+        }
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batchSize));
+    producer->disconnect(NATIVE_WINDOW_API_CPU);
+    consumer->consumerDisconnect();
+}
+
+BENCHMARK(BM_BatchDequeueQueue)->Apply([](benchmark::internal::Benchmark* b) {
+    for (int batchSize = 2; batchSize <= 8; batchSize++) {
+        b->Args({batchSize, /*batched=*/0});
+        b->Args({batchSize, /*batched=*/1});
+    }
+});
+
+// Measures the per-frame calls that EGL and Vulkan swapchains make on their window, through the
+// ANativeWindow hooks of a Surface: the frame's timestamp, dataspace and damage, and, if
+// state.range(0) is set, dequeueing and queueing the buffer. The consumer acquires and releases
+// the buffers on the same thread.
+void BM_SwapchainFrame(benchmark::State& state) {
+    const bool queue = state.range(0) != 0;
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(sp<MockConsumer>::make(), false);
+    const sp<Surface> surface = sp<Surface>::make(producer);
+    ANativeWindow* window = surface.get();
+    if (native_window_api_connect(window, NATIVE_WINDOW_API_EGL) != NO_ERROR ||
+        native_window_set_buffers_dimensions(window, 1, 1) != NO_ERROR ||
+        native_window_set_usage(window, GRALLOC_USAGE_SW_READ_OFTEN) != NO_ERROR) {
+        state.SkipWithError("Could not set up the Surface");
+        return;
+    }
+
+    android_native_rect_t damage = {.left = 0, .top = 1, .right = 1, .bottom = 0};
+    int64_t timestamp = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < kFramesPerIteration; i++) {
+            native_window_set_buffers_timestamp(window, ++timestamp);
+            native_window_set_buffers_data_space(window, HAL_DATASPACE_SRGB);
+            native_window_set_surface_damage(window, &damage, 1);
+            if (!queue) {
+                continue;
+            }
+
+            ANativeWindowBuffer* buffer;
+            int fenceFd;
+            if (window->dequeueBuffer(window, &buffer, &fenceFd) != NO_ERROR) {
+                state.SkipWithError("dequeueBuffer failed");
+                break;
+            }
+            window->queueBuffer(window, buffer, fenceFd);
+
+            BufferItem item;
+            if (consumer->acquireBuffer(&item, 0) == NO_ERROR) {
+                consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                        EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * kFramesPerIteration);
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_EGL);
+    consumer->consumerDisconnect();
+}
+
+BENCHMARK(BM_SwapchainFrame)->Arg(/*queue=*/0)->Arg(/*queue=*/1);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gui/Choreographer.h>
+
+namespace android::test {
+
+namespace {
+
+FrameCallback makeCallback(void* data, nsecs_t expectedCost, bool deferrable) {
+    return FrameCallback{.data = data, .expectedCost = expectedCost, .deferrable = deferrable};
+}
+
+VsyncEventData makeVsyncEventData(std::initializer_list<nsecs_t> deadlines) {
+    VsyncEventData vsyncEventData{};
+    vsyncEventData.preferredFrameTimelineIndex = 0;
+    for (const nsecs_t deadline : deadlines) {
+        vsyncEventData.frameTimelines[vsyncEventData.frameTimelinesLength++].deadlineTimestamp =
+                deadline;
+    }
+    return vsyncEventData;
+}
+
+} // namespace
+
+TEST(ChoreographerTest, runsDeferrableCallbacksLastByCost) {
+    int a, b, c, d;
+    std::vector<FrameCallback> callbacks = {makeCallback(&a, ms2ns(4), true),
+                                            makeCallback(&b, ms2ns(8), false),
+                                            makeCallback(&c, ms2ns(1), true),
+                                            makeCallback(&d, 0, false)};
+    Choreographer::orderCallbacksForFrame(callbacks);
+
+    ASSERT_EQ(4u, callbacks.size());
+    EXPECT_EQ(&b, callbacks[0].data);
+    EXPECT_EQ(&d, callbacks[1].data);
+    EXPECT_EQ(&c, callbacks[2].data);
+    EXPECT_EQ(&a, callbacks[3].data);
+}
+
+TEST(ChoreographerTest, selectsEarliestFrameTimelineWhoseDeadlineIsMet) {
+    const VsyncEventData vsyncEventData = makeVsyncEventData({ms2ns(10), ms2ns(20), ms2ns(30)});
+
+    EXPECT_EQ(0u, Choreographer::selectFrameTimeline(vsyncEventData, ms2ns(5), ms2ns(5)));
+    EXPECT_EQ(1u, Choreographer::selectFrameTimeline(vsyncEventData, ms2ns(5), ms2ns(6)));
+    EXPECT_EQ(2u, Choreographer::selectFrameTimeline(vsyncEventData, ms2ns(15), ms2ns(10)));
+    // No deadline is met, so the preferred frame timeline is kept.
+    EXPECT_EQ(0u, Choreographer::selectFrameTimeline(vsyncEventData, ms2ns(25), ms2ns(10)));
+}
+
+TEST(ChoreographerTest, neverSelectsFrameTimelineBeforePreferredOne) {
+    VsyncEventData vsyncEventData = makeVsyncEventData({ms2ns(10), ms2ns(20), ms2ns(30)});
+    vsyncEventData.preferredFrameTimelineIndex = 1;
+
+    EXPECT_EQ(1u, Choreographer::selectFrameTimeline(vsyncEventData, 0, ms2ns(1)));
+    EXPECT_EQ(2u, Choreographer::selectFrameTimeline(vsyncEventData, ms2ns(15), ms2ns(10)));
+}
+
+} // namespace android::test
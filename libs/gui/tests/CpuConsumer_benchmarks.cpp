@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include <gui/BufferQueue.h>
+#include <gui/CpuConsumer.h>
+#include <gui/Surface.h>
+#include <system/window.h>
+
+namespace android {
+namespace {
+
+constexpr uint32_t kWidth = 3840;
+constexpr uint32_t kHeight = 2160;
+constexpr std::chrono::nanoseconds kFramePeriod{1'000'000'000 / 60};
+constexpr int kFramesPerIteration = 60;
+constexpr size_t kMaxLockedBuffers = 3;
+
+class FrameWaiter : public ConsumerBase::FrameAvailableListener {
+public:
+    void waitForFrame() {
+        std::unique_lock lock(mMutex);
+        mCondition.wait(lock, [this] { return mPendingFrames > 0; });
+        mPendingFrames--;
+    }
+
+    void onFrameAvailable(const BufferItem&) override {
+        std::lock_guard lock(mMutex);
+        mPendingFrames++;
+        mCondition.notify_one();
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    int mPendingFrames = 0;
+};
+
+// Reads a quarter of the luma samples, like a camera analysis pass on a downsampled image.
+uint64_t analyze(const CpuConsumer::LockedBuffer& buffer) {
+    uint64_t sum = 0;
+    for (uint32_t y = 0; y < buffer.height; y += 2) {
+        const uint8_t* row = buffer.data + static_cast<size_t>(y) * buffer.stride;
+        for (uint32_t x = 0; x < buffer.width; x += 2) {
+            sum += row[x];
+        }
+    }
+    return sum;
+}
+
+// Measures a CPU consumer of a 4K YUV stream locking, analyzing and unlocking each frame, with
+// state.range(0) buffers locked ahead on a helper thread, or locked by lockNextBuffer if 0. The
+// producer queues frames at 60 Hz if state.range(1), or as fast as they are released otherwise.
+// Reports the frame rate and the time spent in lockNextBuffer per frame.
+void BM_CpuConsumer4K(benchmark::State& state) {
+    const auto depth = static_cast<size_t>(state.range(0));
+    const bool paced = state.range(1);
+
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    const sp<CpuConsumer> cpuConsumer = sp<CpuConsumer>::make(consumer, kMaxLockedBuffers);
+    const sp<FrameWaiter> frames = sp<FrameWaiter>::make();
+    cpuConsumer->setFrameAvailableListener(frames);
+    if (cpuConsumer->setLockAheadDepth(depth) != OK) {
+        state.SkipWithError("Could not lock ahead");
+        return;
+    }
+
+    const sp<Surface> surface = sp<Surface>::make(producer);
+    ANativeWindow* const window = surface.get();
+    if (native_window_api_connect(window, NATIVE_WINDOW_API_CPU) != NO_ERROR ||
+        native_window_set_buffers_dimensions(window, kWidth, kHeight) != NO_ERROR ||
+        native_window_set_buffers_format(window, HAL_PIXEL_FORMAT_YCbCr_420_888) != NO_ERROR ||
+        native_window_set_usage(window, GRALLOC_USAGE_SW_WRITE_OFTEN) != NO_ERROR) {
+        state.SkipWithError("Could not configure the producer");
+        return;
+    }
+
+    std::atomic<bool> stop = false;
+    std::thread producerThread([&]() {
+        auto frameTime = std::chrono::steady_clock::now();
+        while (!stop) {
+            ANativeWindowBuffer* buffer;
+            if (native_window_dequeue_buffer_and_wait(window, &buffer) != NO_ERROR ||
+                window->queueBuffer(window, buffer, -1) != NO_ERROR) {
+                return;
+            }
+            if (paced) {
+                frameTime += kFramePeriod;
+                std::this_thread::sleep_until(frameTime);
+            }
+        }
+    });
+
+    std::chrono::nanoseconds lockDuration{0};
+    bool failed = false;
+    for (auto _ : state) {
+        for (int i = 0; i < kFramesPerIteration && !failed; i++) {
+            frames->waitForFrame();
+
+            CpuConsumer::LockedBuffer buffer;
+            const auto start = std::chrono::steady_clock::now();
+            failed = cpuConsumer->lockNextBuffer(&buffer) != OK;
+            lockDuration += std::chrono::steady_clock::now() - start;
+            if (!failed) {
+                benchmark::DoNotOptimize(analyze(buffer));
+                cpuConsumer->unlockBuffer(buffer);
+            }
+        }
+        if (failed) {
+            state.SkipWithError("Could not lock a buffer");
+            break;
+        }
+    }
+
+    // Abandoning the consumer unblocks the producer.
+    stop = true;
+    cpuConsumer->abandon();
+    producerThread.join();
+
+    const auto frameCount = static_cast<double>(state.iterations() * kFramesPerIteration);
+    state.counters["fps"] = benchmark::Counter(frameCount, benchmark::Counter::kIsRate);
+    state.counters["lockUs"] =
+            std::chrono::duration<double, std::micro>(lockDuration).count() / frameCount;
+}
+BENCHMARK(BM_CpuConsumer4K)
+        ->ArgNames({"lockAhead", "paced"})
+        ->Args({0, true})
+        ->Args({2, true})
+        ->Args({0, false})
+        ->Args({2, false})
+        ->UseRealTime();
+
+} // namespace
+} // namespace android
@@ -608,6 +608,57 @@ TEST_P(CpuConsumerTest, FromCpuManyInQueue) {
     }
 }
 
+TEST_P(CpuConsumerTest, FromCpuLockAhead) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+
+    const int numInQueue = 5;
+    // Set up
+
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, numInQueue));
+
+    sp<FrameWaiter> waiter = new FrameWaiter;
+    mCC->setFrameAvailableListener(waiter);
+
+    EXPECT_EQ(BAD_VALUE, mCC->setLockAheadDepth(params.maxLockedBuffers + 1));
+    ASSERT_EQ(OK, mCC->setLockAheadDepth(params.maxLockedBuffers));
+
+    // Produce
+
+    const int64_t time[numInQueue] = { 1L, 2L, 3L, 4L, 5L};
+    uint32_t stride[numInQueue];
+
+    for (int i = 0; i < numInQueue; i++) {
+        ALOGD("Producing frame %d", i);
+        ASSERT_NO_FATAL_FAILURE(produceOneFrame(mANW, params, time[i],
+                        &stride[i]));
+    }
+
+    // Consume, as the frames are locked ahead
+
+    for (int i = 0; i < numInQueue; i++) {
+        ALOGD("Consuming frame %d", i);
+        waiter->waitForFrame();
+
+        CpuConsumer::LockedBuffer b;
+        err = mCC->lockNextBuffer(&b);
+        ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+
+        ASSERT_TRUE(b.data != nullptr);
+        EXPECT_EQ(params.width,  b.width);
+        EXPECT_EQ(params.height, b.height);
+        EXPECT_EQ(params.format, b.format);
+        EXPECT_EQ(stride[i], b.stride);
+        EXPECT_EQ(time[i], b.timestamp);
+
+        checkAnyBuffer(b, GetParam().format);
+
+        mCC->unlockBuffer(b);
+    }
+
+    EXPECT_EQ(OK, mCC->setLockAheadDepth(0));
+}
+
 // This test is disabled because the HAL_PIXEL_FORMAT_RAW16 format is not
 // supported on all devices.
 TEST_P(CpuConsumerTest, FromCpuLockMax) {
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <private/gui/FrameTimestampRing.h>
+
+namespace android::test {
+
+TEST(FrameTimestampRingTest, returnsNothingForUnknownFrames) {
+    FrameTimestampRing ring;
+    EXPECT_FALSE(ring.getFrame(1));
+
+    ring.addFrame(1, 10, 20, 30, Fence::NO_FENCE, Fence::NO_FENCE, Fence::NO_FENCE);
+    EXPECT_FALSE(ring.getFrame(2));
+}
+
+TEST(FrameTimestampRingTest, returnsTimestampsOfFrame) {
+    FrameTimestampRing ring;
+    ring.addFrame(1, 10, 20, 30, Fence::NO_FENCE, Fence::NO_FENCE, Fence::NO_FENCE);
+
+    const auto timestamps = ring.getFrame(1);
+    ASSERT_TRUE(timestamps);
+    EXPECT_EQ(10, timestamps->latchTime);
+    EXPECT_EQ(20, timestamps->firstRefreshStartTime);
+    EXPECT_EQ(20, timestamps->lastRefreshStartTime);
+    EXPECT_EQ(30, timestamps->dequeueReadyTime);
+    // There are no fences to wait for.
+    EXPECT_EQ(Fence::SIGNAL_TIME_INVALID, timestamps->gpuCompositionDoneTime);
+    EXPECT_EQ(Fence::SIGNAL_TIME_INVALID, timestamps->displayPresentTime);
+    EXPECT_EQ(Fence::SIGNAL_TIME_INVALID, timestamps->releaseTime);
+}
+
+TEST(FrameTimestampRingTest, keepsFirstRefreshStartOfFrame) {
+    FrameTimestampRing ring;
+    ring.addFrame(1, 10, 20, 30, Fence::NO_FENCE, Fence::NO_FENCE, Fence::NO_FENCE);
+    ring.addFrame(1, 10, 40, 50, Fence::NO_FENCE, Fence::NO_FENCE, Fence::NO_FENCE);
+
+    const auto timestamps = ring.getFrame(1);
+    ASSERT_TRUE(timestamps);
+    EXPECT_EQ(20, timestamps->firstRefreshStartTime);
+    EXPECT_EQ(40, timestamps->lastRefreshStartTime);
+    EXPECT_EQ(50, timestamps->dequeueReadyTime);
+}
+
+TEST(FrameTimestampRingTest, dropsOverwrittenFrames) {
+    FrameTimestampRing ring;
+    for (uint64_t frameNumber = 1; frameNumber <= FrameTimestampRing::kSize + 1; frameNumber++) {
+        ring.addFrame(frameNumber, 10, 20, 30, Fence::NO_FENCE, Fence::NO_FENCE, Fence::NO_FENCE);
+    }
+
+    EXPECT_FALSE(ring.getFrame(1));
+    EXPECT_TRUE(ring.getFrame(2));
+    EXPECT_TRUE(ring.getFrame(FrameTimestampRing::kSize + 1));
+}
+
+} // namespace android::test
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <private/gui/GraphicBufferPool.h>
+
+namespace android::test {
+
+using Key = GraphicBufferPool::Key;
+
+constexpr uint64_t kUsage = GRALLOC_USAGE_HW_TEXTURE | GRALLOC_USAGE_HW_RENDER;
+constexpr Key kSmall{.width = 64, .height = 64, .format = PIXEL_FORMAT_RGBA_8888, .usage = kUsage};
+constexpr Key kLarge{.width = 128, .height = 128, .format = PIXEL_FORMAT_RGBA_8888,
+                     .usage = kUsage};
+
+sp<GraphicBuffer> allocate(const Key& key) {
+    return sp<GraphicBuffer>::make(key.width, key.height, key.format, key.layerCount, key.usage,
+                                   "GraphicBufferPoolTest");
+}
+
+TEST(GraphicBufferPoolTest, takesBufferWithSameAttributes) {
+    GraphicBufferPool pool(/*maxBytes=*/1024 * 1024, /*maxAge=*/s2ns(10));
+    const sp<GraphicBuffer> buffer = allocate(kSmall);
+    ASSERT_EQ(NO_ERROR, buffer->initCheck());
+    pool.put({.buffer = buffer});
+    EXPECT_EQ(1u, pool.getBufferCount());
+
+    EXPECT_FALSE(pool.take(kLarge));
+    EXPECT_FALSE(pool.take({.width = 64,
+                            .height = 64,
+                            .format = PIXEL_FORMAT_RGBX_8888,
+                            .usage = kUsage}));
+
+    const auto taken = pool.take(kSmall);
+    ASSERT_TRUE(taken);
+    EXPECT_EQ(buffer, taken->buffer);
+    EXPECT_EQ(0u, pool.getBufferCount());
+    EXPECT_EQ(0u, pool.getSizeBytes());
+}
+
+TEST(GraphicBufferPoolTest, dropsOldestBufferOverCap) {
+    const sp<GraphicBuffer> first = allocate(kSmall);
+    const sp<GraphicBuffer> second = allocate(kSmall);
+    const sp<GraphicBuffer> third = allocate(kSmall);
+    ASSERT_EQ(NO_ERROR, first->initCheck());
+
+    // Room for two of the buffers.
+    const size_t bufferBytes = size_t{first->getStride()} * kSmall.height * 4;
+    GraphicBufferPool pool(/*maxBytes=*/2 * bufferBytes + bufferBytes / 2, /*maxAge=*/s2ns(10));
+    pool.put({.buffer = first});
+    pool.put({.buffer = second});
+    pool.put({.buffer = third});
+    EXPECT_EQ(2u, pool.getBufferCount());
+    EXPECT_EQ(2 * bufferBytes, pool.getSizeBytes());
+
+    EXPECT_EQ(second, pool.take(kSmall)->buffer);
+    EXPECT_EQ(third, pool.take(kSmall)->buffer);
+
+    // A buffer larger than the pool is never kept.
+    pool.put({.buffer = allocate({.width = 512,
+                                  .height = 512,
+                                  .format = PIXEL_FORMAT_RGBA_8888,
+                                  .usage = kUsage})});
+    EXPECT_EQ(0u, pool.getBufferCount());
+}
+
+TEST(GraphicBufferPoolTest, dropsExpiredBuffers) {
+    GraphicBufferPool pool(/*maxBytes=*/1024 * 1024, /*maxAge=*/ms2ns(10));
+    pool.put({.buffer = allocate(kSmall)});
+    EXPECT_EQ(1u, pool.getBufferCount());
+
+    for (int i = 0; i < 100 && pool.getBufferCount() > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(0u, pool.getBufferCount());
+    EXPECT_EQ(0u, pool.getSizeBytes());
+}
+
+TEST(GraphicBufferPoolTest, preallocatesBuffers) {
+    GraphicBufferPool pool(/*maxBytes=*/1024 * 1024, /*maxAge=*/s2ns(10));
+    pool.put({.buffer = allocate(kLarge)});
+    pool.preallocate(kLarge, 3, "GraphicBufferPoolTest");
+    pool.waitForPendingAllocations();
+    EXPECT_EQ(3u, pool.getBufferCount());
+
+    // The buffers already held or being allocated count towards the request.
+    pool.preallocate(kLarge, 2, "GraphicBufferPoolTest");
+    pool.waitForPendingAllocations();
+    EXPECT_EQ(3u, pool.getBufferCount());
+
+    for (int i = 0; i < 3; i++) {
+        const auto taken = pool.take(kLarge);
+        ASSERT_TRUE(taken);
+        EXPECT_EQ(kLarge, Key::from(*taken->buffer));
+    }
+}
+
+TEST(GraphicBufferPoolTest, disabledPoolKeepsNothing) {
+    GraphicBufferPool pool(/*maxBytes=*/0, /*maxAge=*/s2ns(10));
+    EXPECT_FALSE(pool.isEnabled());
+    pool.put({.buffer = allocate(kSmall)});
+    pool.preallocate(kSmall, 2, "GraphicBufferPoolTest");
+    pool.waitForPendingAllocations();
+    EXPECT_EQ(0u, pool.getBufferCount());
+}
+
+} // namespace android::test
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <gui/LayerState.h>
+
+namespace android {
+namespace {
+
+constexpr size_t kLayerCount = 200;
+
+// Builds the states of a transaction that moves, fades and crops kLayerCount layers, the kind of
+// transaction system_server sends for window animations.
+std::vector<ComposerState> makeAnimationStates(bool compact) {
+    std::vector<ComposerState> states(kLayerCount);
+    for (size_t i = 0; i < kLayerCount; i++) {
+        layer_state_t& s = states[i].state;
+        s.surface = sp<BBinder>::make();
+        s.layerId = static_cast<int32_t>(i);
+        s.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged |
+                layer_state_t::eMatrixChanged | layer_state_t::eCropChanged |
+                layer_state_t::eCornerRadiusChanged;
+        s.x = static_cast<float>(i);
+        s.y = static_cast<float>(i) * 2;
+        s.color.a = 0.5f;
+        s.matrix = {.dsdx = 0.9f, .dtdx = 0, .dtdy = 0, .dsdy = 0.9f};
+        s.crop = Rect(0, 0, 1080, 2400);
+        s.cornerRadius = 16;
+        if (!compact) {
+            // Metadata has no fixed layout, so only the fields of the changes are written.
+            s.what |= layer_state_t::eMetadataChanged;
+        }
+    }
+    return states;
+}
+
+// Measures writing the layer states of a transaction to a parcel, the way
+// ISurfaceComposer::setTransactionState does, and reading them back, the way SurfaceFlinger does.
+// state.range(0) selects whether the states can use the compact layout.
+void BM_TransactionStateParcel(benchmark::State& state) {
+    const bool compact = state.range(0) != 0;
+    const std::vector<ComposerState> states = makeAnimationStates(compact);
+
+    size_t dataSize = 0;
+    for (auto _ : state) {
+        Parcel parcel;
+        for (const auto& s : states) {
+            if (s.write(parcel) != NO_ERROR) {
+                state.SkipWithError("Could not write the state");
+                return;
+            }
+        }
+        dataSize = parcel.dataSize();
+
+        parcel.setDataPosition(0);
+        for (size_t i = 0; i < states.size(); i++) {
+            ComposerState s;
+            if (s.read(parcel) != NO_ERROR) {
+                state.SkipWithError("Could not read the state");
+                return;
+            }
+            benchmark::DoNotOptimize(s);
+        }
+    }
+    state.counters["bytes"] = static_cast<double>(dataSize);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * states.size()));
+}
+BENCHMARK(BM_TransactionStateParcel)->Arg(0)->Arg(1);
+
+// Measures writing and reading the state of one layer whose position, alpha and matrix animate,
+// and, if state.range(0) is set, whose input info changes too, which can't use the compact layout.
+void BM_AnimationLayerStateParcel(benchmark::State& state) {
+    ComposerState composerState;
+    layer_state_t& s = composerState.state;
+    s.surface = sp<BBinder>::make();
+    s.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged |
+            layer_state_t::eMatrixChanged;
+    s.x = 10;
+    s.y = 20;
+    s.color.a = 0.5f;
+    s.matrix = {.dsdx = 0.9f, .dtdx = 0, .dtdy = 0, .dsdy = 0.9f};
+    if (state.range(0) != 0) {
+        s.what |= layer_state_t::eInputInfoChanged;
+        s.windowInfoHandle->editInfo()->name = "AnimatingWindow";
+    }
+
+    size_t dataSize = 0;
+    Parcel parcel;
+    for (auto _ : state) {
+        parcel.setDataSize(0);
+        if (composerState.write(parcel) != NO_ERROR) {
+            state.SkipWithError("Could not write the state");
+            return;
+        }
+        dataSize = parcel.dataSize();
+
+        parcel.setDataPosition(0);
+        ComposerState read;
+        if (read.read(parcel) != NO_ERROR) {
+            state.SkipWithError("Could not read the state");
+            return;
+        }
+        benchmark::DoNotOptimize(read);
+    }
+    state.counters["bytes"] = static_cast<double>(dataSize);
+}
+BENCHMARK(BM_AnimationLayerStateParcel)->Arg(0)->Arg(1);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
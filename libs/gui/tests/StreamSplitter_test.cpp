@@ -238,4 +238,88 @@ TEST_F(StreamSplitterTest, OutputAbandonment) {
                                            nullptr, nullptr));
 }
 
+TEST_F(StreamSplitterTest, LatestOnlyOutputDoesNotStallInput) {
+    const int NUM_FRAMES = 5;
+
+    sp<IGraphicBufferProducer> inputProducer;
+    sp<IGraphicBufferConsumer> inputConsumer;
+    BufferQueue::createBufferQueue(&inputProducer, &inputConsumer);
+
+    // The FIFO output consumes every frame, the LATEST_ONLY one none until the
+    // end
+    sp<IGraphicBufferProducer> fifoProducer;
+    sp<IGraphicBufferConsumer> fifoConsumer;
+    BufferQueue::createBufferQueue(&fifoProducer, &fifoConsumer);
+    ASSERT_EQ(OK, fifoConsumer->consumerConnect(new FakeListener, false));
+
+    sp<IGraphicBufferProducer> latestProducer;
+    sp<IGraphicBufferConsumer> latestConsumer;
+    BufferQueue::createBufferQueue(&latestProducer, &latestConsumer);
+    ASSERT_EQ(OK, latestConsumer->consumerConnect(new FakeListener, false));
+
+    sp<StreamSplitter> splitter;
+    ASSERT_EQ(OK, StreamSplitter::createSplitter(inputConsumer, &splitter));
+    ASSERT_EQ(OK, splitter->addOutput(fifoProducer));
+    ASSERT_EQ(OK, splitter->addOutput(latestProducer, StreamSplitter::OutputMode::LATEST_ONLY));
+    ASSERT_EQ(OK, fifoProducer->allowAllocation(false));
+    ASSERT_EQ(OK, latestProducer->allowAllocation(false));
+
+    IGraphicBufferProducer::QueueBufferOutput qbOutput;
+    ASSERT_EQ(OK,
+              inputProducer->connect(new StubProducerListener, NATIVE_WINDOW_API_CPU, false,
+                                     &qbOutput));
+
+    IGraphicBufferProducer::QueueBufferInput qbInput(0, false,
+            HAL_DATASPACE_UNKNOWN, Rect(0, 0, 1, 1),
+            NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, Fence::NO_FENCE);
+
+    // More frames than the splitter lets out at once go through, since the
+    // LATEST_ONLY output drops the frames it was not done with
+    for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+        int slot;
+        sp<Fence> fence;
+        sp<GraphicBuffer> buffer;
+        status_t result = inputProducer->dequeueBuffer(&slot, &fence, 0, 0, 0,
+                                                       GRALLOC_USAGE_SW_WRITE_OFTEN, nullptr,
+                                                       nullptr);
+        ASSERT_GE(result, OK);
+        ASSERT_EQ(OK, inputProducer->requestBuffer(slot, &buffer));
+
+        uint32_t* dataIn;
+        ASSERT_EQ(OK, buffer->lock(GraphicBuffer::USAGE_SW_WRITE_OFTEN,
+                reinterpret_cast<void**>(&dataIn)));
+        *dataIn = TEST_DATA + static_cast<uint32_t>(frame);
+        ASSERT_EQ(OK, buffer->unlock());
+        ASSERT_EQ(OK, inputProducer->queueBuffer(slot, qbInput, &qbOutput));
+
+        BufferItem item;
+        ASSERT_EQ(OK, fifoConsumer->acquireBuffer(&item, 0));
+        ASSERT_EQ(OK, fifoConsumer->releaseBuffer(item.mSlot, item.mFrameNumber,
+                EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+    }
+
+    // Only the latest frame is waiting in the LATEST_ONLY output
+    BufferItem item;
+    ASSERT_EQ(OK, latestConsumer->acquireBuffer(&item, 0));
+    uint32_t* dataOut;
+    ASSERT_EQ(OK, item.mGraphicBuffer->lock(GraphicBuffer::USAGE_SW_READ_OFTEN,
+            reinterpret_cast<void**>(&dataOut)));
+    ASSERT_EQ(TEST_DATA + static_cast<uint32_t>(NUM_FRAMES - 1), *dataOut);
+    ASSERT_EQ(OK, item.mGraphicBuffer->unlock());
+    ASSERT_EQ(OK, latestConsumer->releaseBuffer(item.mSlot, item.mFrameNumber,
+            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+    ASSERT_EQ(IGraphicBufferConsumer::NO_BUFFER_AVAILABLE, latestConsumer->acquireBuffer(&item, 0));
+}
+
+TEST_F(StreamSplitterTest, MaxOutstandingBuffersMustBePositive) {
+    sp<IGraphicBufferProducer> inputProducer;
+    sp<IGraphicBufferConsumer> inputConsumer;
+    BufferQueue::createBufferQueue(&inputProducer, &inputConsumer);
+
+    sp<StreamSplitter> splitter;
+    ASSERT_EQ(OK, StreamSplitter::createSplitter(inputConsumer, &splitter));
+    EXPECT_EQ(BAD_VALUE, splitter->setMaxOutstandingBuffers(0));
+    EXPECT_EQ(OK, splitter->setMaxOutstandingBuffers(4));
+}
+
 } // namespace android
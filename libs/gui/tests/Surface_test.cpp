@@ -965,6 +965,13 @@ public:
         return binder::Status::ok();
     }
 
+    binder::Status addHdrLayerInfoListenerWithOptions(
+            const sp<IBinder>& /*displayToken*/,
+            const sp<gui::IHdrLayerInfoListener>& /*listener*/, int64_t /*minUpdateIntervalNanos*/,
+            float /*hysteresis*/) override {
+        return binder::Status::ok();
+    }
+
     binder::Status removeHdrLayerInfoListener(
             const sp<IBinder>& /*displayToken*/,
             const sp<gui::IHdrLayerInfoListener>& /*listener*/) override {
@@ -2200,7 +2207,9 @@ TEST_F(SurfaceTest, BatchOperations) {
         queuedBuffers[i].fenceFd = buffers[i].fenceFd;
         queuedBuffers[i].timestamp = NATIVE_WINDOW_TIMESTAMP_AUTO;
     }
+    const uint64_t nextFrameNumber = surface->getNextFrameNumber();
     ASSERT_EQ(NO_ERROR, surface->queueBuffers(queuedBuffers));
+    EXPECT_EQ(nextFrameNumber + BATCH_SIZE, surface->getNextFrameNumber());
 
     ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
 }
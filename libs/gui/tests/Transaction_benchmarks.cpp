@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+
+namespace android {
+namespace {
+
+using Transaction = SurfaceComposerClient::Transaction;
+
+// Surface controls that are not backed by SurfaceFlinger layers, which transactions don't need
+// until they are applied.
+std::vector<sp<SurfaceControl>> makeSurfaceControls(size_t count) {
+    // Not connected to SurfaceFlinger, as no layer is created.
+    const auto client = sp<SurfaceComposerClient>::make(sp<ISurfaceComposerClient>());
+    std::vector<sp<SurfaceControl>> surfaceControls;
+    surfaceControls.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        surfaceControls.push_back(sp<SurfaceControl>::make(client, sp<BBinder>::make(),
+                                                           static_cast<int32_t>(i),
+                                                           "layer" + std::to_string(i)));
+    }
+    return surfaceControls;
+}
+
+// The setters of a window animation frame, in a row for each layer the way the clients call them.
+void animate(Transaction& t, const std::vector<sp<SurfaceControl>>& surfaceControls,
+             float progress) {
+    for (const auto& sc : surfaceControls) {
+        t.setPosition(sc, progress * 100, progress * 200);
+        t.setAlpha(sc, progress);
+        t.setMatrix(sc, progress, 0, 0, progress);
+        t.setCrop(sc, Rect(0, 0, 1080, 2400));
+        t.setCornerRadius(sc, 16);
+    }
+}
+
+// Measures building a transaction that animates state.range(0) layers.
+void BM_TransactionBuild(benchmark::State& state) {
+    const auto surfaceControls = makeSurfaceControls(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        Transaction t;
+        animate(t, surfaceControls, 0.5f);
+        benchmark::DoNotOptimize(t);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * surfaceControls.size()));
+}
+BENCHMARK(BM_TransactionBuild)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+// Measures merging a transaction that animates state.range(0) layers into one that animates the
+// same layers, like a client batching frames, and half of them appear in the merged transaction.
+void BM_TransactionMerge(benchmark::State& state) {
+    const auto surfaceControls = makeSurfaceControls(static_cast<size_t>(state.range(0)));
+    const std::vector<sp<SurfaceControl>> half(surfaceControls.begin(),
+                                               surfaceControls.begin() +
+                                                       static_cast<ptrdiff_t>(
+                                                               (surfaceControls.size() + 1) / 2));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        Transaction t;
+        animate(t, half, 0.25f);
+        Transaction other;
+        animate(other, surfaceControls, 0.5f);
+        state.ResumeTiming();
+
+        t.merge(std::move(other));
+        benchmark::DoNotOptimize(t);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * surfaceControls.size()));
+}
+BENCHMARK(BM_TransactionMerge)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+// Measures writing a transaction that animates state.range(0) layers to a parcel, and reading it
+// back, the way transactions are passed between processes.
+void BM_TransactionParcel(benchmark::State& state) {
+    const auto surfaceControls = makeSurfaceControls(static_cast<size_t>(state.range(0)));
+    Transaction t;
+    animate(t, surfaceControls, 0.5f);
+
+    size_t dataSize = 0;
+    for (auto _ : state) {
+        Parcel parcel;
+        if (t.writeToParcel(&parcel) != NO_ERROR) {
+            state.SkipWithError("Could not write the transaction");
+            return;
+        }
+        dataSize = parcel.dataSize();
+
+        parcel.setDataPosition(0);
+        Transaction read;
+        if (read.readFromParcel(&parcel) != NO_ERROR) {
+            state.SkipWithError("Could not read the transaction");
+            return;
+        }
+        benchmark::DoNotOptimize(read);
+    }
+    state.counters["bytes"] = static_cast<double>(dataSize);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * surfaceControls.size()));
+}
+BENCHMARK(BM_TransactionParcel)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+} // namespace
+} // namespace android
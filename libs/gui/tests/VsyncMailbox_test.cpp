@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include <gui/VsyncMailbox.h>
+
+namespace android::test {
+
+using namespace std::chrono_literals;
+using gui::VsyncMailbox;
+
+VsyncMailbox::Vsync makeVsync(uint32_t count) {
+    VsyncMailbox::Vsync vsync{};
+    vsync.timestamp = 1000 * count;
+    vsync.count = count;
+    vsync.vsyncData.frameInterval = 16'666'667;
+    vsync.vsyncData.preferredFrameTimelineIndex = 1;
+    vsync.vsyncData.frameTimelinesLength = 2;
+    vsync.vsyncData.frameTimelines[0] = {.vsyncId = count,
+                                         .deadlineTimestamp = 2000 * count,
+                                         .expectedPresentationTime = 3000 * count};
+    vsync.vsyncData.frameTimelines[1] = {.vsyncId = count + 1,
+                                         .deadlineTimestamp = 4000 * count,
+                                         .expectedPresentationTime = 5000 * count};
+    return vsync;
+}
+
+std::unique_ptr<VsyncMailbox> openClient(const VsyncMailbox& mailbox) {
+    return VsyncMailbox::fromFd(base::unique_fd(fcntl(mailbox.getFd(), F_DUPFD_CLOEXEC, 0)));
+}
+
+TEST(VsyncMailboxTest, readsLatestPublishedVsync) {
+    const auto mailbox = VsyncMailbox::create();
+    ASSERT_NE(nullptr, mailbox);
+    const auto client = openClient(*mailbox);
+    ASSERT_NE(nullptr, client);
+
+    EXPECT_FALSE(client->read());
+
+    mailbox->publish(makeVsync(1));
+    mailbox->publish(makeVsync(2));
+
+    const auto vsync = client->read();
+    ASSERT_TRUE(vsync);
+    EXPECT_EQ(2000, vsync->timestamp);
+    EXPECT_EQ(2u, vsync->count);
+    EXPECT_EQ(16'666'667, vsync->vsyncData.frameInterval);
+    EXPECT_EQ(2u, vsync->vsyncData.frameTimelinesLength);
+    EXPECT_EQ(3, vsync->vsyncData.preferredVsyncId());
+    EXPECT_EQ(8000, vsync->vsyncData.preferredDeadlineTimestamp());
+}
+
+TEST(VsyncMailboxTest, clientsCannotMapWritable) {
+    const auto mailbox = VsyncMailbox::create();
+    ASSERT_NE(nullptr, mailbox);
+
+    void* ptr = mmap(nullptr, getpagesize(), PROT_READ | PROT_WRITE, MAP_SHARED, mailbox->getFd(),
+                     0);
+    EXPECT_EQ(MAP_FAILED, ptr);
+}
+
+TEST(VsyncMailboxTest, rejectsOtherFileDescriptors) {
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    close(fds[1]);
+    EXPECT_EQ(nullptr, VsyncMailbox::fromFd(base::unique_fd(fds[0])));
+}
+
+TEST(VsyncMailboxTest, waitForNextTimesOut) {
+    const auto mailbox = VsyncMailbox::create();
+    ASSERT_NE(nullptr, mailbox);
+    mailbox->publish(makeVsync(1));
+
+    const auto client = openClient(*mailbox);
+    ASSERT_NE(nullptr, client);
+    uint32_t sequence = 0;
+    ASSERT_TRUE(client->read(&sequence));
+    EXPECT_FALSE(client->waitForNext(sequence, 10ms));
+
+    // A VSYNC published since the read is returned immediately.
+    mailbox->publish(makeVsync(2));
+    EXPECT_TRUE(client->waitForNext(sequence, 0ms));
+}
+
+TEST(VsyncMailboxTest, waitForNextWakesOnPublish) {
+    const auto mailbox = VsyncMailbox::create();
+    ASSERT_NE(nullptr, mailbox);
+    const auto client = openClient(*mailbox);
+    ASSERT_NE(nullptr, client);
+
+    std::thread publisher([&] {
+        std::this_thread::sleep_for(10ms);
+        mailbox->publish(makeVsync(7));
+    });
+
+    EXPECT_TRUE(client->waitForNext(0, 5s));
+    const auto vsync = client->read();
+    ASSERT_TRUE(vsync);
+    EXPECT_EQ(7u, vsync->count);
+    publisher.join();
+}
+
+} // namespace android::test
@@ -20,6 +20,7 @@
 #include <binder/Parcel.h>
 
 #include <gui/WindowInfo.h>
+#include <gui/WindowInfosUpdate.h>
 
 using std::chrono_literals::operator""s;
 
@@ -28,9 +29,22 @@ namespace android {
 using gui::InputApplicationInfo;
 using gui::TouchOcclusionMode;
 using gui::WindowInfo;
+using gui::WindowInfosUpdate;
 
 namespace test {
 
+namespace {
+
+WindowInfo makeWindowInfo(int32_t id, const std::string& name) {
+    WindowInfo info;
+    info.id = id;
+    info.name = name;
+    info.alpha = 1.0f;
+    return info;
+}
+
+} // namespace
+
 TEST(WindowInfo, ParcellingWithoutToken) {
     WindowInfo i, i2;
     i.token = nullptr;
@@ -119,5 +133,53 @@ TEST(InputApplicationInfo, Parcelling) {
     ASSERT_EQ(i, i2);
 }
 
+TEST(WindowInfosUpdate, DeltaHoldsChangedWindows) {
+    const std::vector<WindowInfo> baseWindowInfos{makeWindowInfo(1, "a"), makeWindowInfo(2, "b"),
+                                                  makeWindowInfo(3, "c")};
+    WindowInfosUpdate update{{makeWindowInfo(4, "d"), makeWindowInfo(1, "a"),
+                              makeWindowInfo(2, "b2")},
+                             {},
+                             /*vsyncId=*/10,
+                             /*timestamp=*/20};
+    update.version = 5;
+
+    std::optional<WindowInfosUpdate> delta = update.makeDelta(baseWindowInfos, 4);
+    ASSERT_TRUE(delta);
+    ASSERT_TRUE(delta->isDelta());
+    ASSERT_EQ(4, *delta->baseVersion);
+    ASSERT_EQ(5, delta->version);
+    ASSERT_EQ((std::vector<int32_t>{4, 1, 2}), delta->windowIds);
+    ASSERT_EQ(2u, delta->windowInfos.size());
+    ASSERT_EQ("d", delta->windowInfos[0].name);
+    ASSERT_EQ("b2", delta->windowInfos[1].name);
+
+    Parcel p;
+    ASSERT_EQ(OK, delta->writeToParcel(&p));
+    p.setDataPosition(0);
+    WindowInfosUpdate received;
+    ASSERT_EQ(OK, received.readFromParcel(&p));
+    ASSERT_EQ(10, received.vsyncId);
+    ASSERT_EQ(20, received.timestamp);
+
+    ASSERT_EQ(OK, received.applyDelta(baseWindowInfos));
+    ASSERT_FALSE(received.isDelta());
+    ASSERT_EQ(update.windowInfos, received.windowInfos);
+}
+
+TEST(WindowInfosUpdate, NoDeltaWhenAllWindowsChange) {
+    const std::vector<WindowInfo> baseWindowInfos{makeWindowInfo(1, "a")};
+    WindowInfosUpdate update{{makeWindowInfo(1, "a2")}, {}, 0, 0};
+    ASSERT_FALSE(update.makeDelta(baseWindowInfos, 0));
+}
+
+TEST(WindowInfosUpdate, ApplyDeltaFailsWithoutBaseWindow) {
+    const std::vector<WindowInfo> baseWindowInfos{makeWindowInfo(1, "a"), makeWindowInfo(2, "b")};
+    WindowInfosUpdate update{{makeWindowInfo(1, "a"), makeWindowInfo(2, "b2")}, {}, 0, 0};
+    std::optional<WindowInfosUpdate> delta = update.makeDelta(baseWindowInfos, 0);
+    ASSERT_TRUE(delta);
+
+    ASSERT_EQ(BAD_VALUE, delta->applyDelta({makeWindowInfo(2, "b")}));
+}
+
 } // namespace test
 } // namespace android
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/file.h>
+#include <android-base/mapped_file.h>
+#include <android-base/result.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace android {
+
+/*
+ * Helpers for the binary formats of the key layout and key character maps.
+ *
+ * A binary key map starts with a NUL byte, which a text key map cannot contain, followed by
+ * a per-format tag and a version, then holds 32-bit words in host byte order, since the files
+ * are generated for the device which reads them. The loaders accept the binary files at the
+ * same paths as the text ones, so that they can be generated at build time.
+ */
+namespace binarykeymap {
+
+constexpr size_t HEADER_SIZE = 8;
+
+inline std::array<uint8_t, HEADER_SIZE> makeHeader(const char (&tag)[4], uint32_t version) {
+    std::array<uint8_t, HEADER_SIZE> header{0, uint8_t(tag[0]), uint8_t(tag[1]), uint8_t(tag[2])};
+    memcpy(header.data() + 4, &version, sizeof(version));
+    return header;
+}
+
+class Writer {
+public:
+    explicit Writer(const std::array<uint8_t, HEADER_SIZE>& header)
+          : mData(header.begin(), header.end()) {}
+
+    void writeInt32(int32_t value) {
+        const size_t offset = mData.size();
+        mData.resize(offset + sizeof(value));
+        memcpy(mData.data() + offset, &value, sizeof(value));
+    }
+
+    void writeString(const std::string& value) {
+        writeInt32(static_cast<int32_t>(value.size()));
+        mData.insert(mData.end(), value.begin(), value.end());
+    }
+
+    std::vector<uint8_t> release() { return std::move(mData); }
+
+private:
+    std::vector<uint8_t> mData;
+};
+
+// Reads the words of a binary key map. The reads past the end of the data fail, and so do all
+// the following ones, so that a sequence of reads only has to be checked once with ok().
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : mData(data), mRemaining(size) {}
+
+    // Returns whether the data has the given header, and skips it if so.
+    bool readHeader(const std::array<uint8_t, HEADER_SIZE>& header) {
+        if (mRemaining < HEADER_SIZE || memcmp(mData, header.data(), HEADER_SIZE) != 0) {
+            return false;
+        }
+        mData += HEADER_SIZE;
+        mRemaining -= HEADER_SIZE;
+        return true;
+    }
+
+    int32_t readInt32() {
+        int32_t value = 0;
+        if (!mOk || mRemaining < sizeof(value)) {
+            mOk = false;
+            return 0;
+        }
+        memcpy(&value, mData, sizeof(value));
+        mData += sizeof(value);
+        mRemaining -= sizeof(value);
+        return value;
+    }
+
+    // Reads a count, which fails unless it is at most max and there are at least
+    // entrySize bytes left for each of the entries.
+    size_t readCount(size_t max, size_t entrySize) {
+        const int32_t count = readInt32();
+        if (count < 0 || static_cast<size_t>(count) > max ||
+            static_cast<size_t>(count) > mRemaining / entrySize) {
+            mOk = false;
+            return 0;
+        }
+        return static_cast<size_t>(count);
+    }
+
+    std::string readString() {
+        const size_t size = readCount(mRemaining, 1);
+        if (!mOk) {
+            return {};
+        }
+        std::string value(reinterpret_cast<const char*>(mData), size);
+        mData += size;
+        mRemaining -= size;
+        return value;
+    }
+
+    // Returns whether all the reads succeeded and all the data was read.
+    bool ok() const { return mOk && mRemaining == 0; }
+
+private:
+    const uint8_t* mData;
+    size_t mRemaining;
+    bool mOk = true;
+};
+
+// Maps the file read-only if it is a binary key map with the given header. Returns nullptr if
+// the file is a text key map, which is then parsed instead.
+inline base::Result<std::unique_ptr<base::MappedFile>> mapIfBinary(
+        const std::string& filename, const std::array<uint8_t, HEADER_SIZE>& header) {
+    base::unique_fd fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        return base::ErrnoError() << "Could not open " << filename;
+    }
+    uint8_t firstByte;
+    if (!base::ReadFully(fd, &firstByte, sizeof(firstByte)) || firstByte != header[0]) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return base::ErrnoError() << "Could not stat " << filename;
+    }
+    std::unique_ptr<base::MappedFile> file =
+            base::MappedFile::FromFd(fd, 0, static_cast<size_t>(st.st_size), PROT_READ);
+    if (file == nullptr) {
+        return base::ErrnoError() << "Could not map " << filename;
+    }
+    return file;
+}
+
+} // namespace binarykeymap
+} // namespace android
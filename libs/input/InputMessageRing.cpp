@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "InputMessageRing"
+
+#include "InputMessageRing.h"
+
+#include <fcntl.h>
+#include <log/log.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstring>
+
+namespace android {
+
+namespace {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "The ring positions are shared between processes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "The ring flags are shared between processes");
+
+// Each message is preceded by its size, and the messages are aligned to 8 bytes.
+constexpr size_t SIZE_FIELD_LENGTH = sizeof(uint32_t);
+constexpr size_t ALIGNMENT = 8;
+// Written instead of a size when a message does not fit before the end of the ring, to tell the
+// reader that the next message is at the start of the ring.
+constexpr uint32_t WRAP_MARKER = UINT32_MAX;
+
+constexpr size_t recordSize(size_t size) {
+    return (SIZE_FIELD_LENGTH + size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+constexpr size_t MEMORY_SIZE = (sizeof(InputMessageRing::Shared) * 2 + 4095) & ~size_t(4095);
+
+} // namespace
+
+// --- InputMessageRing ---
+
+InputMessageRing::InputMessageRing(Shared& shared)
+      : mShared(shared),
+        mWritePosition(shared.writePosition.load()),
+        mReadPosition(shared.readPosition.load()) {}
+
+status_t InputMessageRing::write(const void* message, size_t size, bool* outWakeReader) {
+    *outWakeReader = false;
+    const size_t length = recordSize(size);
+    if (length > CAPACITY) {
+        return BAD_VALUE;
+    }
+    const uint64_t readPosition = mShared.readPosition.load(std::memory_order_acquire);
+    if (readPosition > mWritePosition || mWritePosition - readPosition > CAPACITY) {
+        ALOGE("Invalid read position %" PRIu64 " for write position %" PRIu64, readPosition,
+              mWritePosition);
+        return BAD_VALUE;
+    }
+    const size_t used = mWritePosition - readPosition;
+    const size_t offset = mWritePosition % CAPACITY;
+    const size_t contiguous = CAPACITY - offset;
+    const size_t padding = contiguous < length ? contiguous : 0;
+    if (used + padding + length > CAPACITY) {
+        return WOULD_BLOCK;
+    }
+
+    uint64_t position = mWritePosition;
+    if (padding != 0) {
+        memcpy(mShared.data + offset, &WRAP_MARKER, SIZE_FIELD_LENGTH);
+        position += padding;
+    }
+    uint8_t* record = mShared.data + position % CAPACITY;
+    const uint32_t size32 = static_cast<uint32_t>(size);
+    memcpy(record, &size32, SIZE_FIELD_LENGTH);
+    memcpy(record + SIZE_FIELD_LENGTH, message, size);
+    mWritePosition = position + length;
+    mShared.writePosition.store(mWritePosition);
+    *outWakeReader = mShared.readerWaiting.exchange(0) != 0;
+    return OK;
+}
+
+status_t InputMessageRing::read(void* buffer, size_t capacity, size_t* outSize) {
+    const uint64_t writePosition = mShared.writePosition.load(std::memory_order_acquire);
+    if (mReadPosition > writePosition || writePosition - mReadPosition > CAPACITY) {
+        ALOGE("Invalid write position %" PRIu64 " for read position %" PRIu64, writePosition,
+              mReadPosition);
+        return BAD_VALUE;
+    }
+    uint64_t position = mReadPosition;
+    if (position == writePosition) {
+        return WOULD_BLOCK;
+    }
+
+    uint32_t size;
+    memcpy(&size, mShared.data + position % CAPACITY, SIZE_FIELD_LENGTH);
+    if (size == WRAP_MARKER) {
+        position += CAPACITY - position % CAPACITY;
+        if (position >= writePosition) {
+            return BAD_VALUE;
+        }
+        memcpy(&size, mShared.data, SIZE_FIELD_LENGTH);
+    }
+    const size_t offset = position % CAPACITY;
+    const size_t length = recordSize(size);
+    if (size > capacity || length > CAPACITY - offset || length > writePosition - position) {
+        ALOGE("Invalid message of size %" PRIu32 " in the ring", size);
+        return BAD_VALUE;
+    }
+    memcpy(buffer, mShared.data + offset + SIZE_FIELD_LENGTH, size);
+    *outSize = size;
+    mReadPosition = position + length;
+    mShared.readPosition.store(mReadPosition, std::memory_order_release);
+    return OK;
+}
+
+bool InputMessageRing::prepareToWait() {
+    // Sequentially consistent, so that either the writer sees the flag after it writes, or this
+    // sees its message.
+    mShared.readerWaiting.store(1);
+    return mShared.writePosition.load() == mReadPosition;
+}
+
+// --- InputChannelMemory ---
+
+std::shared_ptr<InputChannelMemory> InputChannelMemory::create(const std::string& name) {
+    base::unique_fd fd(memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd < 0) {
+        ALOGE("channel '%s' ~ Could not create the shared memory: %s", name.c_str(),
+              strerror(errno));
+        return nullptr;
+    }
+    // The peer must not be able to shrink the memory under the mappings of this process.
+    if (ftruncate(fd, MEMORY_SIZE) != 0 ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        ALOGE("channel '%s' ~ Could not set up the shared memory: %s", name.c_str(),
+              strerror(errno));
+        return nullptr;
+    }
+    std::shared_ptr<InputChannelMemory> memory = fromFd(std::move(fd));
+    if (memory != nullptr) {
+        // The readers have not looked at the rings yet, so they are woken up by the first write.
+        memory->mLayout->serverToClient.readerWaiting.store(1);
+        memory->mLayout->clientToServer.readerWaiting.store(1);
+    }
+    return memory;
+}
+
+std::shared_ptr<InputChannelMemory> InputChannelMemory::fromFd(base::unique_fd fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != static_cast<off_t>(MEMORY_SIZE)) {
+        ALOGE("Invalid input channel memory");
+        return nullptr;
+    }
+    const int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+        ALOGE("Input channel memory is not sealed");
+        return nullptr;
+    }
+    void* address = mmap(nullptr, MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        ALOGE("Could not map the input channel memory: %s", strerror(errno));
+        return nullptr;
+    }
+    // using 'new' to access a non-public constructor
+    return std::shared_ptr<InputChannelMemory>(
+            new InputChannelMemory(std::move(fd), static_cast<Layout*>(address)));
+}
+
+InputChannelMemory::InputChannelMemory(base::unique_fd fd, Layout* layout)
+      : mFd(std::move(fd)),
+        mLayout(layout),
+        mServerToClientRing(layout->serverToClient),
+        mClientToServerRing(layout->clientToServer) {}
+
+InputChannelMemory::~InputChannelMemory() {
+    munmap(mLayout, MEMORY_SIZE);
+}
+
+} // namespace android
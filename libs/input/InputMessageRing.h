@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <utils/Errors.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace android {
+
+/**
+ * A ring of variable-length messages in memory shared by two processes, with a single writer and
+ * a single reader.
+ *
+ * The positions of each end are kept locally and only published to the shared memory, so that a
+ * peer which corrupts the shared memory can only make the reads and writes fail, never make them
+ * access memory outside of the ring.
+ */
+class InputMessageRing {
+public:
+    static constexpr size_t CAPACITY = 32 * 1024;
+
+    // The part of the ring in the shared memory.
+    struct Shared {
+        // The positions only increase, so they never wrap around.
+        alignas(64) std::atomic<uint64_t> writePosition;
+        alignas(64) std::atomic<uint64_t> readPosition;
+        // Set by the reader when the ring is empty, and cleared by the writer when it writes, so
+        // that the writer knows when it has to wake up the reader.
+        std::atomic<uint32_t> readerWaiting;
+        alignas(64) uint8_t data[CAPACITY];
+    };
+
+    explicit InputMessageRing(Shared& shared);
+
+    /**
+     * Writes a message to the ring.
+     *
+     * Return OK on success, and sets outWakeReader if the reader is waiting for the message.
+     * Return WOULD_BLOCK if the ring is full.
+     * Return BAD_VALUE if the shared memory was corrupted.
+     */
+    status_t write(const void* message, size_t size, bool* outWakeReader);
+
+    /**
+     * Reads the next message of the ring into the buffer.
+     *
+     * Return OK on success, and sets outSize to the size of the message.
+     * Return WOULD_BLOCK if the ring is empty.
+     * Return BAD_VALUE if the shared memory was corrupted.
+     */
+    status_t read(void* buffer, size_t capacity, size_t* outSize);
+
+    // Marks the reader as waiting for the next message. Returns false if a message arrived
+    // meanwhile, which the reader then reads instead of waiting.
+    bool prepareToWait();
+
+private:
+    Shared& mShared;
+    uint64_t mWritePosition;
+    uint64_t mReadPosition;
+};
+
+/**
+ * The shared memory of an input channel, with one message ring for each direction.
+ */
+class InputChannelMemory {
+public:
+    // Creates the shared memory of a new pair of channels. Returns nullptr on failure.
+    static std::shared_ptr<InputChannelMemory> create(const std::string& name);
+    // Maps the shared memory created by the peer. Returns nullptr if it is not valid.
+    static std::shared_ptr<InputChannelMemory> fromFd(base::unique_fd fd);
+
+    ~InputChannelMemory();
+
+    const base::unique_fd& getFd() const { return mFd; }
+    InputMessageRing& getServerToClientRing() { return mServerToClientRing; }
+    InputMessageRing& getClientToServerRing() { return mClientToServerRing; }
+
+private:
+    struct Layout {
+        InputMessageRing::Shared serverToClient;
+        InputMessageRing::Shared clientToServer;
+    };
+
+    InputChannelMemory(base::unique_fd fd, Layout* layout);
+
+    base::unique_fd mFd;
+    Layout* mLayout;
+    InputMessageRing mServerToClientRing;
+    InputMessageRing mClientToServerRing;
+};
+
+} // namespace android
@@ -13,6 +13,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <binder/Parcel.h>
@@ -23,6 +25,8 @@
 
 #include <input/InputTransport.h>
 
+#include "InputMessageRing.h"
+
 namespace {
 
 /**
@@ -93,10 +97,6 @@ static const size_t SOCKET_BUFFER_SIZE = 32 * 1024;
 // Nanoseconds per milliseconds.
 static const nsecs_t NANOS_PER_MS = 1000000;
 
-// Latency added during resampling.  A few milliseconds doesn't hurt much but
-// reduces the impact of mispredicted touch positions.
-const std::chrono::duration RESAMPLE_LATENCY = 5ms;
-
 // Minimum time difference between consecutive samples before attempting to resample.
 static const nsecs_t RESAMPLE_MIN_DELTA = 2 * NANOS_PER_MS;
 
@@ -104,10 +104,6 @@ static const nsecs_t RESAMPLE_MIN_DELTA = 2 * NANOS_PER_MS;
 // by extrapolation.
 static const nsecs_t RESAMPLE_MAX_DELTA = 20 * NANOS_PER_MS;
 
-// Maximum time to predict forward from the last known state, to avoid predicting too
-// far into the future.  This time is further bounded by 50% of the last time delta.
-static const nsecs_t RESAMPLE_MAX_PREDICTION = 8 * NANOS_PER_MS;
-
 /**
  * System property for enabling / disabling touch resampling.
  * Resampling extrapolates / interpolates the reported touch event coordinates to better
@@ -120,6 +116,22 @@ static const nsecs_t RESAMPLE_MAX_PREDICTION = 8 * NANOS_PER_MS;
  */
 static const char* PROPERTY_RESAMPLING_ENABLED = "ro.input.resampling";
 
+/**
+ * System property for selecting the touch resampler.
+ * Set to "linear" to resample the touches along the line through their last two positions, with
+ * a fixed latency (default).
+ * Set to "quadratic" to resample them along the parabola through their last three positions, with
+ * a latency proportional to the interval between the reports of the device.
+ */
+static const char* PROPERTY_RESAMPLER = "ro.input.resampler";
+
+/**
+ * System property for making the input channels pass their messages through shared memory.
+ * Set to "1" to use shared memory when it can be set up.
+ * The channels use their sockets by default.
+ */
+static const char* PROPERTY_SHARED_MEMORY_CHANNELS = "ro.input.shared_memory_channels";
+
 /**
  * Crash if the events that are getting sent to the InputPublisher are inconsistent.
  * Enable this via "adb shell setprop log.tag.InputTransportVerifyEvents DEBUG"
@@ -128,15 +140,6 @@ static bool verifyEvents() {
     return __android_log_is_loggable(ANDROID_LOG_DEBUG, LOG_TAG "VerifyEvents", ANDROID_LOG_INFO);
 }
 
-template<typename T>
-inline static T min(const T& a, const T& b) {
-    return a < b ? a : b;
-}
-
-inline static float lerp(float a, float b, float alpha) {
-    return a + alpha * (b - a);
-}
-
 inline static bool isPointerEvent(int32_t source) {
     return (source & AINPUT_SOURCE_CLASS_POINTER) == AINPUT_SOURCE_CLASS_POINTER;
 }
@@ -162,9 +165,13 @@ bool InputMessage::isValid(size_t actualSize) const {
             return true;
         case Type::MOTION: {
             const bool valid =
-                    body.motion.pointerCount > 0 && body.motion.pointerCount <= MAX_POINTERS;
+                    body.motion.pointerCount > 0 && body.motion.pointerCount <= MAX_POINTERS &&
+                    body.motion.extraSampleCount < Body::Motion::MAX_SAMPLES &&
+                    (body.motion.extraSampleCount + 1) * body.motion.pointerCount <= MAX_POINTERS;
             if (!valid) {
-                ALOGE("Received invalid MOTION: pointerCount = %" PRIu32, body.motion.pointerCount);
+                ALOGE("Received invalid MOTION: pointerCount = %" PRIu32
+                      ", extraSampleCount = %" PRIu8,
+                      body.motion.pointerCount, body.motion.extraSampleCount);
             }
             return valid;
         }
@@ -283,6 +290,8 @@ void InputMessage::getSanitizedCopy(InputMessage* msg) const {
             msg->body.motion.buttonState = body.motion.buttonState;
             // MotionClassification classification
             msg->body.motion.classification = body.motion.classification;
+            // uint8_t extraSampleCount
+            msg->body.motion.extraSampleCount = body.motion.extraSampleCount;
             // int32_t edgeFlags
             msg->body.motion.edgeFlags = body.motion.edgeFlags;
             // nsecs_t downTime
@@ -312,7 +321,10 @@ void InputMessage::getSanitizedCopy(InputMessage* msg) const {
             msg->body.motion.tyRaw = body.motion.tyRaw;
 
             //struct Pointer pointers[MAX_POINTERS]
-            for (size_t i = 0; i < body.motion.pointerCount; i++) {
+            const size_t pointerSlotCount =
+                    std::min<size_t>(body.motion.pointerCount * (body.motion.extraSampleCount + 1),
+                                     MAX_POINTERS);
+            for (size_t i = 0; i < pointerSlotCount; i++) {
                 // PointerProperties properties
                 msg->body.motion.pointers[i].properties.id = body.motion.pointers[i].properties.id;
                 msg->body.motion.pointers[i].properties.toolType =
@@ -326,6 +338,15 @@ void InputMessage::getSanitizedCopy(InputMessage* msg) const {
                 msg->body.motion.pointers[i].coords.isResampled =
                         body.motion.pointers[i].coords.isResampled;
             }
+            //struct Sample extraSamples[MAX_SAMPLES - 1]
+            const size_t extraSampleCount = std::min<size_t>(body.motion.extraSampleCount,
+                                                             Body::Motion::MAX_SAMPLES - 1);
+            for (size_t i = 0; i < extraSampleCount; i++) {
+                msg->body.motion.extraSamples[i].seq = body.motion.extraSamples[i].seq;
+                msg->body.motion.extraSamples[i].eventId = body.motion.extraSamples[i].eventId;
+                msg->body.motion.extraSamples[i].eventTime = body.motion.extraSamples[i].eventTime;
+                msg->body.motion.extraSamples[i].hmac = body.motion.extraSamples[i].hmac;
+            }
             break;
         }
         case InputMessage::Type::FINISHED: {
@@ -390,6 +411,16 @@ InputChannel::~InputChannel() {
 status_t InputChannel::openInputChannelPair(const std::string& name,
                                             std::unique_ptr<InputChannel>& outServerChannel,
                                             std::unique_ptr<InputChannel>& outClientChannel) {
+    static const bool sUseSharedMemory =
+            property_get_bool(PROPERTY_SHARED_MEMORY_CHANNELS, false);
+    return openInputChannelPair(name, sUseSharedMemory ? Transport::SHARED_MEMORY
+                                                       : Transport::SOCKET,
+                                outServerChannel, outClientChannel);
+}
+
+status_t InputChannel::openInputChannelPair(const std::string& name, Transport transport,
+                                            std::unique_ptr<InputChannel>& outServerChannel,
+                                            std::unique_ptr<InputChannel>& outClientChannel) {
     int sockets[2];
     if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets)) {
         status_t result = -errno;
@@ -415,10 +446,21 @@ status_t InputChannel::openInputChannelPair(const std::string& name,
     std::string clientChannelName = name + " (client)";
     android::base::unique_fd clientFd(sockets[1]);
     outClientChannel = InputChannel::create(clientChannelName, std::move(clientFd), token);
+
+    if (transport == Transport::SHARED_MEMORY) {
+        // Keep using the socket if the memory cannot be set up.
+        std::shared_ptr<InputChannelMemory> memory = InputChannelMemory::create(name);
+        outServerChannel->mMemory = memory;
+        outServerChannel->mIsServer = true;
+        outClientChannel->mMemory = std::move(memory);
+    }
     return OK;
 }
 
 status_t InputChannel::sendMessage(const InputMessage* msg) {
+    if (mMemory != nullptr) {
+        return sendMessageToMemory(msg);
+    }
     const size_t msgLength = msg->size();
     InputMessage cleanMsg;
     msg->getSanitizedCopy(&cleanMsg);
@@ -453,6 +495,9 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
 }
 
 status_t InputChannel::receiveMessage(InputMessage* msg) {
+    if (mMemory != nullptr) {
+        return receiveMessageFromMemory(msg);
+    }
     ssize_t nRead;
     do {
         nRead = ::recv(getFd(), msg, sizeof(InputMessage), MSG_DONTWAIT);
@@ -487,15 +532,108 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
     return OK;
 }
 
+status_t InputChannel::sendMessageToMemory(const InputMessage* msg) {
+    const size_t msgLength = msg->size();
+    InputMessage cleanMsg;
+    msg->getSanitizedCopy(&cleanMsg);
+    InputMessageRing& ring =
+            mIsServer ? mMemory->getServerToClientRing() : mMemory->getClientToServerRing();
+    bool wakeReceiver;
+    const status_t status = ring.write(&cleanMsg, msgLength, &wakeReceiver);
+    if (status != OK) {
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ error writing message of type %s, %s",
+                 mName.c_str(), ftl::enum_string(msg->header.type).c_str(),
+                 statusToString(status).c_str());
+        return status == WOULD_BLOCK ? WOULD_BLOCK : DEAD_OBJECT;
+    }
+    ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ wrote message of type %s", mName.c_str(),
+             ftl::enum_string(msg->header.type).c_str());
+    if (!wakeReceiver) {
+        return OK;
+    }
+
+    // Wake up the receiver with a byte on the socket.
+    const uint8_t wakeup = 0;
+    ssize_t nWrite;
+    do {
+        nWrite = ::send(getFd(), &wakeup, sizeof(wakeup), MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (nWrite == -1 && errno == EINTR);
+    if (nWrite < 0) {
+        const int error = errno;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            // The receiver has not read its previous wakeups yet, so it will read the message.
+            return OK;
+        }
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
+            return DEAD_OBJECT;
+        }
+        return -error;
+    }
+    return OK;
+}
+
+status_t InputChannel::receiveMessageFromMemory(InputMessage* msg) {
+    InputMessageRing& ring =
+            mIsServer ? mMemory->getClientToServerRing() : mMemory->getServerToClientRing();
+    size_t size;
+    status_t status = ring.read(msg, sizeof(InputMessage), &size);
+    if (status == WOULD_BLOCK) {
+        // Read the wakeups, to find out whether the peer was closed, and so that the fd is not
+        // readable until the next wakeup.
+        uint8_t wakeups[16];
+        ssize_t nRead;
+        do {
+            nRead = ::recv(getFd(), wakeups, sizeof(wakeups), MSG_DONTWAIT);
+        } while (nRead > 0 || (nRead == -1 && errno == EINTR));
+        if (nRead == 0) {
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                     "channel '%s' ~ receive message failed because peer was closed",
+                     mName.c_str());
+            return DEAD_OBJECT;
+        }
+        const int error = errno;
+        if (error != EAGAIN && error != EWOULDBLOCK) {
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ receive wakeup failed, errno=%d",
+                     mName.c_str(), error);
+            return error == EPIPE || error == ENOTCONN || error == ECONNREFUSED ? DEAD_OBJECT
+                                                                                  : -error;
+        }
+        if (ring.prepareToWait()) {
+            return WOULD_BLOCK;
+        }
+        status = ring.read(msg, sizeof(InputMessage), &size);
+    }
+    if (status != OK) {
+        ALOGE("channel '%s' ~ could not read message from the shared memory, status=%s",
+              mName.c_str(), statusToString(status).c_str());
+        return BAD_VALUE;
+    }
+
+    if (!msg->isValid(size)) {
+        ALOGE("channel '%s' ~ received invalid message of size %zu", mName.c_str(), size);
+        return BAD_VALUE;
+    }
+
+    ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s", mName.c_str(),
+             ftl::enum_string(msg->header.type).c_str());
+    return OK;
+}
+
 std::unique_ptr<InputChannel> InputChannel::dup() const {
     base::unique_fd newFd(dupFd());
-    return InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    std::unique_ptr<InputChannel> channel =
+            InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    channel->mMemory = mMemory;
+    channel->mIsServer = mIsServer;
+    return channel;
 }
 
 void InputChannel::copyTo(InputChannel& outChannel) const {
     outChannel.mName = getName();
     outChannel.mFd = dupFd();
     outChannel.mToken = getConnectionToken();
+    outChannel.mMemory = mMemory;
+    outChannel.mIsServer = mIsServer;
 }
 
 status_t InputChannel::writeToParcel(android::Parcel* parcel) const {
@@ -503,8 +641,13 @@ status_t InputChannel::writeToParcel(android::Parcel* parcel) const {
         ALOGE("%s: Null parcel", __func__);
         return BAD_VALUE;
     }
-    return parcel->writeStrongBinder(mToken)
-            ?: parcel->writeUtf8AsUtf16(mName) ?: parcel->writeUniqueFileDescriptor(mFd);
+    status_t status = parcel->writeStrongBinder(mToken)
+            ?: parcel->writeUtf8AsUtf16(mName) ?: parcel->writeUniqueFileDescriptor(mFd)
+            ?: parcel->writeBool(mMemory != nullptr);
+    if (status != OK || mMemory == nullptr) {
+        return status;
+    }
+    return parcel->writeUniqueFileDescriptor(mMemory->getFd()) ?: parcel->writeBool(mIsServer);
 }
 
 status_t InputChannel::readFromParcel(const android::Parcel* parcel) {
@@ -513,7 +656,21 @@ status_t InputChannel::readFromParcel(const android::Parcel* parcel) {
         return BAD_VALUE;
     }
     mToken = parcel->readStrongBinder();
-    return parcel->readUtf8FromUtf16(&mName) ?: parcel->readUniqueFileDescriptor(&mFd);
+    bool usesSharedMemory;
+    status_t status = parcel->readUtf8FromUtf16(&mName) ?: parcel->readUniqueFileDescriptor(&mFd)
+            ?: parcel->readBool(&usesSharedMemory);
+    mMemory = nullptr;
+    mIsServer = false;
+    if (status != OK || !usesSharedMemory) {
+        return status;
+    }
+    base::unique_fd memoryFd;
+    status = parcel->readUniqueFileDescriptor(&memoryFd) ?: parcel->readBool(&mIsServer);
+    if (status != OK) {
+        return status;
+    }
+    mMemory = InputChannelMemory::fromFd(std::move(memoryFd));
+    return mMemory != nullptr ? OK : BAD_VALUE;
 }
 
 sp<IBinder> InputChannel::getConnectionToken() const {
@@ -598,16 +755,22 @@ status_t InputPublisher::publishMotionEvent(
         float yPrecision, float xCursorPosition, float yCursorPosition,
         const ui::Transform& rawTransform, nsecs_t downTime, nsecs_t eventTime,
         uint32_t pointerCount, const PointerProperties* pointerProperties,
-        const PointerCoords* pointerCoords) {
+        const PointerCoords* pointerCoords, const std::vector<MotionSample>& laterSamples) {
     if (ATRACE_ENABLED()) {
-        std::string message = StringPrintf("publishMotionEvent(inputChannel=%s, action=%s)",
-                                           mChannel->getName().c_str(),
-                                           MotionEvent::actionToString(action).c_str());
+        std::string message =
+                StringPrintf("publishMotionEvent(inputChannel=%s, action=%s, samples=%zu)",
+                             mChannel->getName().c_str(),
+                             MotionEvent::actionToString(action).c_str(),
+                             laterSamples.size() + 1);
         ATRACE_NAME(message.c_str());
     }
     if (verifyEvents()) {
         mInputVerifier.processMovement(deviceId, action, pointerCount, pointerProperties,
                                        pointerCoords, flags);
+        for (const MotionSample& sample : laterSamples) {
+            mInputVerifier.processMovement(deviceId, action, pointerCount, pointerProperties,
+                                           sample.pointerCoords, flags);
+        }
     }
     if (debugTransportPublisher()) {
         std::string transformString;
@@ -636,6 +799,22 @@ status_t InputPublisher::publishMotionEvent(
         return BAD_VALUE;
     }
 
+    if (laterSamples.size() + 1 > getMaxMotionSampleCount(pointerCount) ||
+        (!laterSamples.empty() && action != AMOTION_EVENT_ACTION_MOVE &&
+         action != AMOTION_EVENT_ACTION_HOVER_MOVE)) {
+        ALOGE("channel '%s' publisher ~ Invalid later samples provided: %zu samples of %" PRIu32
+              " pointers for action %s.",
+              mChannel->getName().c_str(), laterSamples.size(), pointerCount,
+              MotionEvent::actionToString(action).c_str());
+        return BAD_VALUE;
+    }
+    for (const MotionSample& sample : laterSamples) {
+        if (!sample.seq) {
+            ALOGE("Attempted to publish a motion sample with sequence number 0.");
+            return BAD_VALUE;
+        }
+    }
+
     InputMessage msg;
     msg.header.type = InputMessage::Type::MOTION;
     msg.header.seq = seq;
@@ -674,10 +853,31 @@ status_t InputPublisher::publishMotionEvent(
         msg.body.motion.pointers[i].properties.copyFrom(pointerProperties[i]);
         msg.body.motion.pointers[i].coords.copyFrom(pointerCoords[i]);
     }
+    msg.body.motion.extraSampleCount = static_cast<uint8_t>(laterSamples.size());
+    for (size_t s = 0; s < laterSamples.size(); s++) {
+        const MotionSample& sample = laterSamples[s];
+        msg.body.motion.extraSamples[s].seq = sample.seq;
+        msg.body.motion.extraSamples[s].eventId = sample.eventId;
+        msg.body.motion.extraSamples[s].eventTime = sample.eventTime;
+        msg.body.motion.extraSamples[s].hmac = sample.hmac;
+        InputMessage::Body::Motion::Pointer* pointers =
+                &msg.body.motion.pointers[(s + 1) * pointerCount];
+        for (uint32_t i = 0; i < pointerCount; i++) {
+            pointers[i].properties.copyFrom(pointerProperties[i]);
+            pointers[i].coords.copyFrom(sample.pointerCoords[i]);
+        }
+    }
 
     return mChannel->sendMessage(&msg);
 }
 
+size_t InputPublisher::getMaxMotionSampleCount(uint32_t pointerCount) {
+    if (pointerCount < 1 || pointerCount > MAX_POINTERS) {
+        return 0;
+    }
+    return std::min<size_t>(InputMessage::Body::Motion::MAX_SAMPLES, MAX_POINTERS / pointerCount);
+}
+
 status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool hasFocus) {
     if (ATRACE_ENABLED()) {
         std::string message = StringPrintf("publishFocusEvent(inputChannel=%s, hasFocus=%s)",
@@ -797,7 +997,11 @@ InputConsumer::InputConsumer(const std::shared_ptr<InputChannel>& channel)
 
 InputConsumer::InputConsumer(const std::shared_ptr<InputChannel>& channel,
                              bool enableTouchResampling)
-      : mResampleTouch(enableTouchResampling), mChannel(channel), mMsgDeferred(false) {}
+      : InputConsumer(channel, enableTouchResampling ? createTouchResampler() : nullptr) {}
+
+InputConsumer::InputConsumer(const std::shared_ptr<InputChannel>& channel,
+                             std::unique_ptr<TouchResampler> touchResampler)
+      : mTouchResampler(std::move(touchResampler)), mChannel(channel), mMsgDeferred(false) {}
 
 InputConsumer::~InputConsumer() {
 }
@@ -806,6 +1010,17 @@ bool InputConsumer::isTouchResamplingEnabled() {
     return property_get_bool(PROPERTY_RESAMPLING_ENABLED, true);
 }
 
+std::unique_ptr<TouchResampler> InputConsumer::createTouchResampler() {
+    const std::string resampler = android::base::GetProperty(PROPERTY_RESAMPLER, "linear");
+    if (resampler == "quadratic") {
+        return std::make_unique<QuadraticTouchResampler>();
+    }
+    if (resampler != "linear") {
+        ALOGW("Unknown touch resampler '%s', using the linear one", resampler.c_str());
+    }
+    return std::make_unique<LinearTouchResampler>();
+}
+
 status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consumeBatches,
                                 nsecs_t frameTime, uint32_t* outSeq, InputEvent** outEvent) {
     ALOGD_IF(DEBUG_TRANSPORT_CONSUMER,
@@ -822,14 +1037,22 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
             // mMsg contains a valid input message from the previous call to consume
             // that has not yet been processed.
             mMsgDeferred = false;
+        } else if (!mExtraSamples.empty()) {
+            // Handle the next sample of the last received message.
+            mMsg = mExtraSamples.front();
+            mExtraSamples.pop_front();
         } else {
             // Receive a fresh message.
             status_t result = mChannel->receiveMessage(&mMsg);
             if (result == OK) {
-                const auto [_, inserted] =
-                        mConsumeTimes.emplace(mMsg.header.seq, systemTime(SYSTEM_TIME_MONOTONIC));
+                const nsecs_t consumeTime = systemTime(SYSTEM_TIME_MONOTONIC);
+                const auto [_, inserted] = mConsumeTimes.emplace(mMsg.header.seq, consumeTime);
                 LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
                                     mMsg.header.seq);
+                if (mMsg.header.type == InputMessage::Type::MOTION &&
+                    mMsg.body.motion.extraSampleCount != 0) {
+                    splitSamples(consumeTime);
+                }
             }
             if (result) {
                 // Consume the next batched event unless batches are being held for later.
@@ -976,6 +1199,30 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
     return OK;
 }
 
+void InputConsumer::splitSamples(nsecs_t consumeTime) {
+    InputMessage::Body::Motion& motion = mMsg.body.motion;
+    const uint32_t pointerCount = motion.pointerCount;
+    for (size_t s = 0; s < motion.extraSampleCount; s++) {
+        const InputMessage::Body::Motion::Sample& sample = motion.extraSamples[s];
+        InputMessage& msg = mExtraSamples.emplace_back();
+        msg.header.type = InputMessage::Type::MOTION;
+        msg.header.seq = sample.seq;
+        // Only the fields before the pointers are the same for all the samples.
+        memcpy(&msg.body.motion, &motion, offsetof(InputMessage::Body::Motion, pointers));
+        msg.body.motion.eventId = sample.eventId;
+        msg.body.motion.eventTime = sample.eventTime;
+        msg.body.motion.hmac = sample.hmac;
+        msg.body.motion.extraSampleCount = 0;
+        std::copy_n(&motion.pointers[(s + 1) * pointerCount], pointerCount,
+                    msg.body.motion.pointers);
+
+        const auto [_, inserted] = mConsumeTimes.emplace(sample.seq, consumeTime);
+        LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
+                            sample.seq);
+    }
+    motion.extraSampleCount = 0;
+}
+
 status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
         nsecs_t frameTime, uint32_t* outSeq, InputEvent** outEvent) {
     status_t result;
@@ -989,8 +1236,11 @@ status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
         }
 
         nsecs_t sampleTime = frameTime;
-        if (mResampleTouch) {
-            sampleTime -= std::chrono::nanoseconds(RESAMPLE_LATENCY).count();
+        if (mTouchResampler != nullptr) {
+            const InputMessage& head = batch.samples[0];
+            ssize_t index = findTouchState(head.body.motion.deviceId, head.body.motion.source);
+            sampleTime -= mTouchResampler->getLatency(
+                    index >= 0 ? mTouchStates[index].reportInterval : 0);
         }
         ssize_t split = findSampleNoLaterThan(batch, sampleTime);
         if (split < 0) {
@@ -1005,7 +1255,7 @@ status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
         } else {
             next = &batch.samples[0];
         }
-        if (!result && mResampleTouch) {
+        if (!result && mTouchResampler != nullptr) {
             resampleTouchState(sampleTime, static_cast<MotionEvent*>(*outEvent), next);
         }
         return result;
@@ -1042,7 +1292,7 @@ status_t InputConsumer::consumeSamples(InputEventFactoryInterface* factory,
 }
 
 void InputConsumer::updateTouchState(InputMessage& msg) {
-    if (!mResampleTouch || !isPointerEvent(msg.body.motion.source)) {
+    if (mTouchResampler == nullptr || !isPointerEvent(msg.body.motion.source)) {
         return;
     }
 
@@ -1069,6 +1319,14 @@ void InputConsumer::updateTouchState(InputMessage& msg) {
         ssize_t index = findTouchState(deviceId, source);
         if (index >= 0) {
             TouchState& touchState = mTouchStates[index];
+            const nsecs_t delta = msg.body.motion.eventTime - touchState.getHistory(0)->eventTime;
+            if (delta >= RESAMPLE_MIN_DELTA && delta <= RESAMPLE_MAX_DELTA) {
+                // An exponential moving average, which follows the report rate of the device
+                // while smoothing out the jitter of the event times.
+                touchState.reportInterval = touchState.reportInterval == 0
+                        ? delta
+                        : touchState.reportInterval + (delta - touchState.reportInterval) / 8;
+            }
             touchState.addHistory(msg);
             rewriteMessage(touchState, msg);
         }
@@ -1152,7 +1410,7 @@ void InputConsumer::rewriteMessage(TouchState& state, InputMessage& msg) {
 
 void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
     const InputMessage* next) {
-    if (!mResampleTouch
+    if (mTouchResampler == nullptr
             || !(isPointerEvent(event->getSource()))
             || event->getAction() != AMOTION_EVENT_ACTION_MOVE) {
         return;
@@ -1181,10 +1439,11 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         }
     }
 
-    // Find the data to use for resampling.
+    // Find the data to use for resampling. The samples are resampled between or after the
+    // current and the other sample, and the sample before these refines the resampling.
     const History* other;
+    const History* previous = nullptr;
     History future;
-    float alpha;
     if (next) {
         // Interpolate between current sample and future sample.
         // So current->eventTime <= sampleTime <= future.eventTime.
@@ -1196,7 +1455,9 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
                      delta);
             return;
         }
-        alpha = float(sampleTime - current->eventTime) / delta;
+        if (touchState.historySize >= 2) {
+            previous = touchState.getHistory(1);
+        }
     } else if (touchState.historySize >= 2) {
         // Extrapolate future sample using current sample and past sample.
         // So other->eventTime <= current->eventTime <= sampleTime.
@@ -1211,7 +1472,7 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
                      delta);
             return;
         }
-        nsecs_t maxPredict = current->eventTime + min(delta / 2, RESAMPLE_MAX_PREDICTION);
+        nsecs_t maxPredict = current->eventTime + mTouchResampler->getMaxPrediction(delta);
         if (sampleTime > maxPredict) {
             ALOGD_IF(DEBUG_RESAMPLING,
                      "Sample time is too far in the future, adjusting prediction "
@@ -1219,7 +1480,9 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
                      sampleTime - current->eventTime, maxPredict - current->eventTime);
             sampleTime = maxPredict;
         }
-        alpha = float(current->eventTime - sampleTime) / delta;
+        if (touchState.historySize >= 3) {
+            previous = touchState.getHistory(2);
+        }
     } else {
         ALOGD_IF(DEBUG_RESAMPLING, "Not resampled, insufficient data.");
         return;
@@ -1258,16 +1521,27 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         resampledCoords.copyFrom(currentCoords);
         if (other->idBits.hasBit(id) && shouldResampleTool(event->getToolType(i))) {
             const PointerCoords& otherCoords = other->getPointerById(id);
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X,
-                                         lerp(currentCoords.getX(), otherCoords.getX(), alpha));
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y,
-                                         lerp(currentCoords.getY(), otherCoords.getY(), alpha));
+            // The samples of the pointer, from the oldest to the most recent one.
+            const History* histories[] = {previous, next ? current : other,
+                                          next ? other : current};
+            TouchResampler::Sample samples[3];
+            size_t sampleCount = 0;
+            for (const History* history : histories) {
+                if (history != nullptr && history->hasPointerId(id)) {
+                    const PointerCoords& coords = history->getPointerById(id);
+                    samples[sampleCount++] = {history->eventTime, coords.getX(), coords.getY()};
+                }
+            }
+            const TouchResampler::Sample resampled =
+                    mTouchResampler->resample(samples, sampleCount, sampleTime);
+            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X, resampled.x);
+            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, resampled.y);
             resampledCoords.isResampled = true;
             ALOGD_IF(DEBUG_RESAMPLING,
                      "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f), "
-                     "other (%0.3f, %0.3f), alpha %0.3f",
+                     "other (%0.3f, %0.3f), samples %zu",
                      id, resampledCoords.getX(), resampledCoords.getY(), currentCoords.getX(),
-                     currentCoords.getY(), otherCoords.getX(), otherCoords.getY(), alpha);
+                     currentCoords.getY(), otherCoords.getX(), otherCoords.getY(), sampleCount);
         } else {
             ALOGD_IF(DEBUG_RESAMPLING, "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f)", id,
                      resampledCoords.getX(), resampledCoords.getY(), currentCoords.getX(),
@@ -1497,12 +1771,14 @@ ssize_t InputConsumer::findSampleNoLaterThan(const Batch& batch, nsecs_t time) {
 
 std::string InputConsumer::dump() const {
     std::string out;
-    out = out + "mResampleTouch = " + toString(mResampleTouch) + "\n";
+    out = out + "mTouchResampler = " +
+            (mTouchResampler != nullptr ? mTouchResampler->getName() : "none") + "\n";
     out = out + "mChannel = " + mChannel->getName() + "\n";
     out = out + "mMsgDeferred: " + toString(mMsgDeferred) + "\n";
     if (mMsgDeferred) {
         out = out + "mMsg : " + ftl::enum_string(mMsg.header.type) + "\n";
     }
+    out += android::base::StringPrintf("mExtraSamples: %zu\n", mExtraSamples.size());
     out += "Batches:\n";
     for (const Batch& batch : mBatches) {
         out += "    Batch:\n";
@@ -27,6 +27,7 @@
 #include <input/InputEventLabels.h>
 #include <input/KeyCharacterMap.h>
 #include <input/Keyboard.h>
+#include <input/ParsedFileCache.h>
 
 #include <gui/constants.h>
 #include <utils/Errors.h>
@@ -34,6 +35,8 @@
 #include <utils/Timers.h>
 #include <utils/Tokenizer.h>
 
+#include "BinaryKeyMap.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -72,6 +75,10 @@ static const Modifier modifiers[] = {
         { "scrolllock", AMETA_SCROLL_LOCK_ON },
 };
 
+// The header of the binary key character maps, see toBinary().
+static const std::array<uint8_t, binarykeymap::HEADER_SIZE> BINARY_HEADER =
+        binarykeymap::makeHeader("kcm", 1);
+
 #if DEBUG_MAPPING
 static String8 toString(const char16_t* chars, size_t numChars) {
     String8 result;
@@ -89,23 +96,47 @@ KeyCharacterMap::KeyCharacterMap(const std::string& filename) : mLoadFileName(fi
 
 base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::string& filename,
                                                                      Format format) {
-    Tokenizer* tokenizer;
-    status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
-    if (status) {
-        return Errorf("Error {} opening key character map file {}.", status, filename.c_str());
-    }
-    std::shared_ptr<KeyCharacterMap> map =
-            std::shared_ptr<KeyCharacterMap>(new KeyCharacterMap(filename));
-    if (!map.get()) {
-        ALOGE("Error allocating key character map.");
-        return Errorf("Error allocating key character map.");
-    }
-    std::unique_ptr<Tokenizer> t(tokenizer);
-    status = map->load(t.get(), format);
-    if (status == OK) {
-        return map;
-    }
-    return Errorf("Load KeyCharacterMap failed {}.", status);
+    auto parse = [&]() -> base::Result<std::shared_ptr<const KeyCharacterMap>> {
+        base::Result<std::unique_ptr<base::MappedFile>> binary =
+                binarykeymap::mapIfBinary(filename, BINARY_HEADER);
+        if (!binary.ok()) {
+            return Errorf("Error opening key character map file {}: {}", filename.c_str(),
+                          binary.error().message());
+        }
+        if (*binary != nullptr) {
+            return fromBinary(filename, reinterpret_cast<const uint8_t*>((*binary)->data()),
+                              (*binary)->size(), format);
+        }
+        Tokenizer* tokenizer;
+        status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
+        if (status) {
+            return Errorf("Error {} opening key character map file {}.", status, filename.c_str());
+        }
+        std::shared_ptr<KeyCharacterMap> map =
+                std::shared_ptr<KeyCharacterMap>(new KeyCharacterMap(filename));
+        if (!map.get()) {
+            ALOGE("Error allocating key character map.");
+            return Errorf("Error allocating key character map.");
+        }
+        std::unique_ptr<Tokenizer> t(tokenizer);
+        status = map->load(t.get(), format);
+        if (status == OK) {
+            return map;
+        }
+        return Errorf("Load KeyCharacterMap failed {}.", status);
+    };
+
+    using Cache =
+            ParsedFileCache<std::shared_ptr<const KeyCharacterMap>, std::pair<std::string, Format>>;
+    static Cache* sCache = new Cache();
+    base::Result<std::shared_ptr<const KeyCharacterMap>> parsedMap =
+            sCache->getOrLoad({filename, format}, filename, parse);
+    if (!parsedMap.ok()) {
+        return parsedMap.error();
+    }
+    // The maps may be combined with overlays or have their keys remapped, so each caller gets
+    // its own copy.
+    return std::make_shared<KeyCharacterMap>(**parsedMap);
 }
 
 base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::loadContents(
@@ -158,15 +189,19 @@ void KeyCharacterMap::clear() {
 
 status_t KeyCharacterMap::reloadBaseFromFile() {
     clear();
-    Tokenizer* tokenizer;
-    status_t status = Tokenizer::open(String8(mLoadFileName.c_str()), &tokenizer);
-    if (status) {
-        ALOGE("Error %s opening key character map file %s.", statusToString(status).c_str(),
-              mLoadFileName.c_str());
-        return status;
-    }
-    std::unique_ptr<Tokenizer> t(tokenizer);
-    return load(t.get(), KeyCharacterMap::Format::BASE);
+    // The base map is usually cached, so that the overlays are applied without parsing it again.
+    base::Result<std::shared_ptr<KeyCharacterMap>> base =
+            load(mLoadFileName, KeyCharacterMap::Format::BASE);
+    if (!base.ok()) {
+        ALOGE("Error reloading key character map file %s: %s", mLoadFileName.c_str(),
+              base.error().message().c_str());
+        return UNKNOWN_ERROR;
+    }
+    mKeys = std::move((*base)->mKeys);
+    mType = (*base)->mType;
+    mKeysByScanCode = std::move((*base)->mKeysByScanCode);
+    mKeysByUsageCode = std::move((*base)->mKeysByUsageCode);
+    return OK;
 }
 
 void KeyCharacterMap::combine(const KeyCharacterMap& overlay) {
@@ -612,6 +647,85 @@ void KeyCharacterMap::addLockedMetaKey(Vector<KeyEvent>& outEvents,
     }
 }
 
+std::vector<uint8_t> KeyCharacterMap::toBinary() const {
+    binarykeymap::Writer writer(BINARY_HEADER);
+    writer.writeInt32(static_cast<int32_t>(mType));
+    // The keys are written sorted by key code, with their behaviors as resolved by the parser.
+    writer.writeInt32(static_cast<int32_t>(mKeys.size()));
+    for (const auto& [keyCode, key] : mKeys) {
+        writer.writeInt32(keyCode);
+        writer.writeInt32(key.label);
+        writer.writeInt32(key.number);
+        writer.writeInt32(static_cast<int32_t>(key.behaviors.size()));
+        for (const Behavior& behavior : key.behaviors) {
+            writer.writeInt32(behavior.metaState);
+            writer.writeInt32(behavior.character);
+            writer.writeInt32(behavior.fallbackKeyCode);
+            writer.writeInt32(behavior.replacementKeyCode);
+        }
+    }
+    for (const auto* keyMap : {&mKeysByScanCode, &mKeysByUsageCode}) {
+        writer.writeInt32(static_cast<int32_t>(keyMap->size()));
+        for (const auto& [fromCode, toAndroidKeyCode] : *keyMap) {
+            writer.writeInt32(fromCode);
+            writer.writeInt32(toAndroidKeyCode);
+        }
+    }
+    return writer.release();
+}
+
+base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::fromBinary(
+        const std::string& filename, const uint8_t* data, size_t size, Format format) {
+    binarykeymap::Reader reader(data, size);
+    if (!reader.readHeader(BINARY_HEADER)) {
+        return Errorf("{} is not a binary key character map of a supported version.",
+                      filename.c_str());
+    }
+    std::shared_ptr<KeyCharacterMap> map =
+            std::shared_ptr<KeyCharacterMap>(new KeyCharacterMap(filename));
+    map->mType = static_cast<KeyboardType>(reader.readInt32());
+    // Each key takes at least 4 words, the behaviors 4 more each, and the mappings 2.
+    const size_t numKeys = reader.readCount(MAX_KEYS, 4 * sizeof(int32_t));
+    for (size_t i = 0; i < numKeys; i++) {
+        const int32_t keyCode = reader.readInt32();
+        Key key{.label = static_cast<char16_t>(reader.readInt32()),
+                .number = static_cast<char16_t>(reader.readInt32())};
+        const size_t numBehaviors = reader.readCount(SIZE_MAX, 4 * sizeof(int32_t));
+        for (size_t j = 0; j < numBehaviors; j++) {
+            key.behaviors.push_back({
+                    .metaState = reader.readInt32(),
+                    .character = static_cast<char16_t>(reader.readInt32()),
+                    .fallbackKeyCode = reader.readInt32(),
+                    .replacementKeyCode = reader.readInt32(),
+            });
+        }
+        // The keys are sorted, so they are appended to the map without searching it.
+        if (!map->mKeys.empty() && keyCode <= map->mKeys.rbegin()->first) {
+            return Errorf("Key codes of binary key character map {} are not sorted.",
+                          filename.c_str());
+        }
+        map->mKeys.emplace_hint(map->mKeys.end(), keyCode, std::move(key));
+    }
+    for (auto* keyMap : {&map->mKeysByScanCode, &map->mKeysByUsageCode}) {
+        const size_t numMappings = reader.readCount(SIZE_MAX, 2 * sizeof(int32_t));
+        for (size_t i = 0; i < numMappings; i++) {
+            const int32_t fromCode = reader.readInt32();
+            keyMap->emplace_hint(keyMap->end(), fromCode, reader.readInt32());
+        }
+    }
+    if (!reader.ok()) {
+        return Errorf("Binary key character map {} is malformed.", filename.c_str());
+    }
+    // The binary maps are checked like the text ones are at the end of parsing.
+    if (map->mType == KeyboardType::UNKNOWN ||
+        (format == Format::BASE && map->mType == KeyboardType::OVERLAY) ||
+        (format == Format::OVERLAY && map->mType != KeyboardType::OVERLAY)) {
+        return Errorf("Binary key character map {} has keyboard type {}, which is not allowed.",
+                      filename.c_str(), static_cast<int32_t>(map->mType));
+    }
+    return map;
+}
+
 #ifdef __linux__
 std::shared_ptr<KeyCharacterMap> KeyCharacterMap::readFromParcel(Parcel* parcel) {
     if (parcel == nullptr) {
@@ -22,6 +22,7 @@
 #include <input/InputEventLabels.h>
 #include <input/KeyLayoutMap.h>
 #include <input/Keyboard.h>
+#include <input/ParsedFileCache.h>
 #include <log/log.h>
 #include <utils/Errors.h>
 #include <utils/Timers.h>
@@ -31,6 +32,9 @@
 #include <vintf/VintfObject.h>
 #endif
 
+#include "BinaryKeyMap.h"
+
+#include <algorithm>
 #include <cstdlib>
 #include <string_view>
 #include <unordered_map>
@@ -96,6 +100,19 @@ static const std::unordered_map<std::string_view, InputDeviceSensorType> SENSOR_
          sensorPair<InputDeviceSensorType::GYROSCOPE_UNCALIBRATED>(),
          sensorPair<InputDeviceSensorType::SIGNIFICANT_MOTION>()};
 
+// The header of the binary key layout maps, see toBinary().
+const std::array<uint8_t, binarykeymap::HEADER_SIZE> BINARY_HEADER =
+        binarykeymap::makeHeader("klm", 1);
+
+// Returns the entries of a map sorted by their codes, so that the binary maps are reproducible.
+template <typename T>
+std::vector<std::pair<int32_t, T>> sortedEntries(const std::unordered_map<int32_t, T>& map) {
+    std::vector<std::pair<int32_t, T>> entries(map.begin(), map.end());
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return entries;
+}
+
 bool kernelConfigsArePresent(const std::set<std::string>& configs) {
 #if defined(__ANDROID__)
     std::shared_ptr<const android::vintf::RuntimeInfo> runtimeInfo =
@@ -136,19 +153,47 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::loadContents(const std
 
 base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string& filename,
                                                                const char* contents) {
-    Tokenizer* tokenizer;
-    status_t status;
+    if (contents != nullptr) {
+        return parse(filename, contents);
+    }
+    // The maps are immutable, so the devices with the same layout share it.
+    static ParsedFileCache<std::shared_ptr<KeyLayoutMap>>* sCache =
+            new ParsedFileCache<std::shared_ptr<KeyLayoutMap>>();
+    return sCache->getOrLoad(filename, filename, [&] { return parse(filename, nullptr); });
+}
+
+base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::parse(const std::string& filename,
+                                                                const char* contents) {
+    std::unique_ptr<base::MappedFile> binary;
     if (contents == nullptr) {
-        status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
-    } else {
-        status = Tokenizer::fromContents(String8(filename.c_str()), contents, &tokenizer);
+        base::Result<std::unique_ptr<base::MappedFile>> mapped =
+                binarykeymap::mapIfBinary(filename, BINARY_HEADER);
+        if (!mapped.ok()) {
+            ALOGE("Error opening key layout map file %s: %s", filename.c_str(),
+                  mapped.error().message().c_str());
+            return Errorf("Error opening key layout map file {}: {}", filename.c_str(),
+                          mapped.error().message());
+        }
+        binary = std::move(*mapped);
     }
-    if (status) {
-        ALOGE("Error %d opening key layout map file %s.", status, filename.c_str());
-        return Errorf("Error {} opening key layout map file {}.", status, filename.c_str());
+    base::Result<std::shared_ptr<KeyLayoutMap>> ret = nullptr;
+    if (binary != nullptr) {
+        ret = fromBinary(reinterpret_cast<const uint8_t*>(binary->data()), binary->size());
+    } else {
+        Tokenizer* tokenizer;
+        status_t status;
+        if (contents == nullptr) {
+            status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
+        } else {
+            status = Tokenizer::fromContents(String8(filename.c_str()), contents, &tokenizer);
+        }
+        if (status) {
+            ALOGE("Error %d opening key layout map file %s.", status, filename.c_str());
+            return Errorf("Error {} opening key layout map file {}.", status, filename.c_str());
+        }
+        std::unique_ptr<Tokenizer> t(tokenizer);
+        ret = load(t.get());
     }
-    std::unique_ptr<Tokenizer> t(tokenizer);
-    auto ret = load(t.get());
     if (!ret.ok()) {
         return ret;
     }
@@ -187,6 +232,101 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(Tokenizer* tokeni
     return Errorf("Load KeyLayoutMap failed {}.", status);
 }
 
+std::vector<uint8_t> KeyLayoutMap::toBinary() const {
+    binarykeymap::Writer writer(BINARY_HEADER);
+    for (const auto* keys : {&mKeysByScanCode, &mKeysByUsageCode}) {
+        writer.writeInt32(static_cast<int32_t>(keys->size()));
+        for (const auto& [code, key] : sortedEntries(*keys)) {
+            writer.writeInt32(code);
+            writer.writeInt32(key.keyCode);
+            writer.writeInt32(static_cast<int32_t>(key.flags));
+        }
+    }
+    writer.writeInt32(static_cast<int32_t>(mAxes.size()));
+    for (const auto& [scanCode, axis] : sortedEntries(mAxes)) {
+        writer.writeInt32(scanCode);
+        writer.writeInt32(axis.mode);
+        writer.writeInt32(axis.axis);
+        writer.writeInt32(axis.highAxis);
+        writer.writeInt32(axis.splitValue);
+        writer.writeInt32(axis.flatOverride);
+    }
+    for (const auto* leds : {&mLedsByScanCode, &mLedsByUsageCode}) {
+        writer.writeInt32(static_cast<int32_t>(leds->size()));
+        for (const auto& [code, led] : sortedEntries(*leds)) {
+            writer.writeInt32(code);
+            writer.writeInt32(led.ledCode);
+        }
+    }
+    writer.writeInt32(static_cast<int32_t>(mSensorsByAbsCode.size()));
+    for (const auto& [absCode, sensor] : sortedEntries(mSensorsByAbsCode)) {
+        writer.writeInt32(absCode);
+        writer.writeInt32(static_cast<int32_t>(sensor.sensorType));
+        writer.writeInt32(sensor.sensorDataIndex);
+    }
+    // The kernel configs are written as they are checked when the binary map is loaded.
+    writer.writeInt32(static_cast<int32_t>(mRequiredKernelConfigs.size()));
+    for (const std::string& config : mRequiredKernelConfigs) {
+        writer.writeString(config);
+    }
+    return writer.release();
+}
+
+base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::fromBinary(const uint8_t* data,
+                                                                     size_t size) {
+    binarykeymap::Reader reader(data, size);
+    if (!reader.readHeader(BINARY_HEADER)) {
+        return Errorf("Not a binary key layout map of a supported version.");
+    }
+    std::shared_ptr<KeyLayoutMap> map = std::shared_ptr<KeyLayoutMap>(new KeyLayoutMap());
+    for (auto* keys : {&map->mKeysByScanCode, &map->mKeysByUsageCode}) {
+        const size_t numKeys = reader.readCount(SIZE_MAX, 3 * sizeof(int32_t));
+        keys->reserve(numKeys);
+        for (size_t i = 0; i < numKeys; i++) {
+            const int32_t code = reader.readInt32();
+            Key key{.keyCode = reader.readInt32(),
+                    .flags = static_cast<uint32_t>(reader.readInt32())};
+            keys->emplace(code, key);
+        }
+    }
+    const size_t numAxes = reader.readCount(SIZE_MAX, 6 * sizeof(int32_t));
+    map->mAxes.reserve(numAxes);
+    for (size_t i = 0; i < numAxes; i++) {
+        const int32_t scanCode = reader.readInt32();
+        AxisInfo axis;
+        axis.mode = static_cast<AxisInfo::Mode>(reader.readInt32());
+        axis.axis = reader.readInt32();
+        axis.highAxis = reader.readInt32();
+        axis.splitValue = reader.readInt32();
+        axis.flatOverride = reader.readInt32();
+        map->mAxes.emplace(scanCode, axis);
+    }
+    for (auto* leds : {&map->mLedsByScanCode, &map->mLedsByUsageCode}) {
+        const size_t numLeds = reader.readCount(SIZE_MAX, 2 * sizeof(int32_t));
+        leds->reserve(numLeds);
+        for (size_t i = 0; i < numLeds; i++) {
+            const int32_t code = reader.readInt32();
+            leds->emplace(code, Led{.ledCode = reader.readInt32()});
+        }
+    }
+    const size_t numSensors = reader.readCount(SIZE_MAX, 3 * sizeof(int32_t));
+    map->mSensorsByAbsCode.reserve(numSensors);
+    for (size_t i = 0; i < numSensors; i++) {
+        const int32_t absCode = reader.readInt32();
+        Sensor sensor{.sensorType = static_cast<InputDeviceSensorType>(reader.readInt32()),
+                      .sensorDataIndex = reader.readInt32()};
+        map->mSensorsByAbsCode.emplace(absCode, sensor);
+    }
+    const size_t numConfigs = reader.readCount(SIZE_MAX, sizeof(int32_t));
+    for (size_t i = 0; i < numConfigs; i++) {
+        map->mRequiredKernelConfigs.insert(reader.readString());
+    }
+    if (!reader.ok()) {
+        return Errorf("Malformed binary key layout map.");
+    }
+    return map;
+}
+
 status_t KeyLayoutMap::mapKey(int32_t scanCode, int32_t usageCode,
         int32_t* outKeyCode, uint32_t* outFlags) const {
     const Key* key = getKey(scanCode, usageCode);
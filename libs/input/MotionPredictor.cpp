@@ -88,14 +88,10 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
         mModel = TfLiteMotionPredictorModel::create();
     }
 
-    if (mBuffers == nullptr) {
-        mBuffers = std::make_unique<TfLiteMotionPredictorBuffers>(mModel->inputLength());
-    }
-
     const int32_t action = event.getActionMasked();
     if (action == AMOTION_EVENT_ACTION_UP || action == AMOTION_EVENT_ACTION_CANCEL) {
         ALOGD_IF(isDebug(), "End of event stream");
-        mBuffers->reset();
+        mBuffers.clear();
         mLastEvent.reset();
         return {};
     } else if (action != AMOTION_EVENT_ACTION_DOWN && action != AMOTION_EVENT_ACTION_MOVE) {
@@ -104,32 +100,37 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
         return {};
     }
 
-    if (event.getPointerCount() != 1) {
-        ALOGD_IF(isDebug(), "Prediction not supported for multiple pointers");
-        return {};
-    }
-
-    const ToolType toolType = event.getPointerProperties(0)->toolType;
-    if (toolType != ToolType::STYLUS) {
-        ALOGD_IF(isDebug(), "Prediction not supported for non-stylus tool: %s",
-                 ftl::enum_string(toolType).c_str());
-        return {};
+    for (size_t p = 0; p < event.getPointerCount(); ++p) {
+        const ToolType toolType = event.getPointerProperties(p)->toolType;
+        if (toolType != ToolType::STYLUS) {
+            ALOGD_IF(isDebug(), "Prediction not supported for non-stylus tool: %s",
+                     ftl::enum_string(toolType).c_str());
+            return {};
+        }
     }
 
-    for (size_t i = 0; i <= event.getHistorySize(); ++i) {
-        if (event.isResampled(0, i)) {
-            continue;
+    // The pointers which went up are no longer predicted.
+    std::erase_if(mBuffers,
+                  [&event](const auto& entry) { return event.findPointerIndex(entry.first) < 0; });
+
+    for (size_t p = 0; p < event.getPointerCount(); ++p) {
+        TfLiteMotionPredictorBuffers& buffers =
+                mBuffers.try_emplace(event.getPointerId(p), mModel->inputLength()).first->second;
+        for (size_t i = 0; i <= event.getHistorySize(); ++i) {
+            if (event.isResampled(p, i)) {
+                continue;
+            }
+            const PointerCoords* coords = event.getHistoricalRawPointerCoords(p, i);
+            buffers.pushSample(event.getHistoricalEventTime(i),
+                               {
+                                       .position.x = coords->getAxisValue(AMOTION_EVENT_AXIS_X),
+                                       .position.y = coords->getAxisValue(AMOTION_EVENT_AXIS_Y),
+                                       .pressure = event.getHistoricalPressure(p, i),
+                                       .tilt = event.getHistoricalAxisValue(
+                                               AMOTION_EVENT_AXIS_TILT, p, i),
+                                       .orientation = event.getHistoricalOrientation(p, i),
+                               });
         }
-        const PointerCoords* coords = event.getHistoricalRawPointerCoords(0, i);
-        mBuffers->pushSample(event.getHistoricalEventTime(i),
-                             {
-                                     .position.x = coords->getAxisValue(AMOTION_EVENT_AXIS_X),
-                                     .position.y = coords->getAxisValue(AMOTION_EVENT_AXIS_Y),
-                                     .pressure = event.getHistoricalPressure(0, i),
-                                     .tilt = event.getHistoricalAxisValue(AMOTION_EVENT_AXIS_TILT,
-                                                                          0, i),
-                                     .orientation = event.getHistoricalOrientation(0, i),
-                             });
     }
 
     if (!mLastEvent) {
@@ -140,25 +141,54 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
 }
 
 std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
-    if (mBuffers == nullptr || !mBuffers->isReady()) {
+    if (!mLastEvent) {
+        return nullptr;
+    }
+    const MotionEvent& event = *mLastEvent;
+
+    // The pointers which have enough samples for a prediction, in the order of the last event.
+    std::vector<const TfLiteMotionPredictorBuffers*> batch;
+    std::vector<PointerProperties> pointerProperties;
+    for (size_t p = 0; p < event.getPointerCount(); ++p) {
+        const auto it = mBuffers.find(event.getPointerId(p));
+        if (it != mBuffers.end() && it->second.isReady()) {
+            batch.push_back(&it->second);
+            pointerProperties.push_back(*event.getPointerProperties(p));
+        }
+    }
+    if (batch.empty()) {
         return nullptr;
     }
 
     LOG_ALWAYS_FATAL_IF(!mModel);
-    mBuffers->copyTo(*mModel);
+    if (!mModel->setBatchSize(batch.size())) {
+        ALOGD_IF(isDebug(), "Model cannot be batched, only predicting the first pointer");
+        batch.resize(1);
+        pointerProperties.resize(1);
+    }
+    for (size_t b = 0; b < batch.size(); ++b) {
+        batch[b]->copyTo(*mModel, b);
+    }
     LOG_ALWAYS_FATAL_IF(!mModel->invoke());
 
-    // Read out the predictions.
+    // Read out the predictions. Those of each pointer follow those of the previous one.
+    const size_t outputLength = mModel->outputLength();
     const std::span<const float> predictedR = mModel->outputR();
     const std::span<const float> predictedPhi = mModel->outputPhi();
     const std::span<const float> predictedPressure = mModel->outputPressure();
 
-    TfLiteMotionPredictorSample::Point axisFrom = mBuffers->axisFrom().position;
-    TfLiteMotionPredictorSample::Point axisTo = mBuffers->axisTo().position;
+    std::vector<TfLiteMotionPredictorSample::Point> axisFrom;
+    std::vector<TfLiteMotionPredictorSample::Point> axisTo;
+    for (const TfLiteMotionPredictorBuffers* buffers : batch) {
+        axisFrom.push_back(buffers->axisFrom().position);
+        axisTo.push_back(buffers->axisTo().position);
+    }
 
     if (isDebug()) {
-        ALOGD("axisFrom: %f, %f", axisFrom.x, axisFrom.y);
-        ALOGD("axisTo: %f, %f", axisTo.x, axisTo.y);
+        for (size_t b = 0; b < batch.size(); ++b) {
+            ALOGD("[%d] axisFrom: %f, %f", pointerProperties[b].id, axisFrom[b].x, axisFrom[b].y);
+            ALOGD("[%d] axisTo: %f, %f", pointerProperties[b].id, axisTo[b].x, axisTo[b].y);
+        }
         ALOGD("mInputR: %s", base::Join(mModel->inputR(), ", ").c_str());
         ALOGD("mInputPhi: %s", base::Join(mModel->inputPhi(), ", ").c_str());
         ALOGD("mInputPressure: %s", base::Join(mModel->inputPressure(), ", ").c_str());
@@ -169,25 +199,34 @@ std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
         ALOGD("predictedPressure: %s", base::Join(predictedPressure, ", ").c_str());
     }
 
-    LOG_ALWAYS_FATAL_IF(!mLastEvent);
-    const MotionEvent& event = *mLastEvent;
     bool hasPredictions = false;
     std::unique_ptr<MotionEvent> prediction = std::make_unique<MotionEvent>();
-    int64_t predictionTime = mBuffers->lastTimestamp();
+    // The samples of all the pointers of an event are recorded together, so they all have the
+    // same last timestamp.
+    int64_t predictionTime = batch[0]->lastTimestamp();
     const int64_t futureTime = timestamp + mPredictionTimestampOffsetNanos;
-
-    for (int i = 0; i < predictedR.size() && predictionTime <= futureTime; ++i) {
-        const TfLiteMotionPredictorSample::Point point =
-                convertPrediction(axisFrom, axisTo, predictedR[i], predictedPhi[i]);
-        // TODO(b/266747654): Stop predictions if confidence is < some threshold.
-
-        ALOGD_IF(isDebug(), "prediction %d: %f, %f", i, point.x, point.y);
-        PointerCoords coords;
-        coords.clear();
-        coords.setAxisValue(AMOTION_EVENT_AXIS_X, point.x);
-        coords.setAxisValue(AMOTION_EVENT_AXIS_Y, point.y);
-        // TODO(b/266747654): Stop predictions if predicted pressure is < some threshold.
-        coords.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, predictedPressure[i]);
+    std::vector<PointerCoords> pointerCoords(batch.size());
+
+    for (size_t i = 0; i < outputLength && predictionTime <= futureTime; ++i) {
+        for (size_t b = 0; b < batch.size(); ++b) {
+            const size_t index = b * outputLength + i;
+            const TfLiteMotionPredictorSample::Point point =
+                    convertPrediction(axisFrom[b], axisTo[b], predictedR[index],
+                                      predictedPhi[index]);
+            // TODO(b/266747654): Stop predictions if confidence is < some threshold.
+
+            ALOGD_IF(isDebug(), "[%d] prediction %zu: %f, %f", pointerProperties[b].id, i,
+                     point.x, point.y);
+            PointerCoords& coords = pointerCoords[b];
+            coords.clear();
+            coords.setAxisValue(AMOTION_EVENT_AXIS_X, point.x);
+            coords.setAxisValue(AMOTION_EVENT_AXIS_Y, point.y);
+            // TODO(b/266747654): Stop predictions if predicted pressure is < some threshold.
+            coords.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, predictedPressure[index]);
+
+            axisFrom[b] = axisTo[b];
+            axisTo[b] = point;
+        }
 
         predictionTime += PREDICTION_INTERVAL_NANOS;
         if (i == 0) {
@@ -200,13 +239,11 @@ std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
                                    event.getXPrecision(), event.getYPrecision(),
                                    event.getRawXCursorPosition(), event.getRawYCursorPosition(),
                                    event.getRawTransform(), event.getDownTime(), predictionTime,
-                                   event.getPointerCount(), event.getPointerProperties(), &coords);
+                                   pointerProperties.size(), pointerProperties.data(),
+                                   pointerCoords.data());
         } else {
-            prediction->addSample(predictionTime, &coords);
+            prediction->addSample(predictionTime, pointerCoords.data());
         }
-
-        axisFrom = axisTo;
-        axisTo = point;
     }
     // TODO(b/266747511): Interpolate to futureTime?
     if (!hasPredictions) {
@@ -18,6 +18,7 @@
 
 #include <cstdlib>
 
+#include <input/ParsedFileCache.h>
 #include <input/PropertyMap.h>
 #include <log/log.h>
 
@@ -125,32 +126,43 @@ void PropertyMap::addAll(const PropertyMap* map) {
 }
 
 android::base::Result<std::unique_ptr<PropertyMap>> PropertyMap::load(const char* filename) {
-    std::unique_ptr<PropertyMap> outMap = std::make_unique<PropertyMap>();
-    if (outMap == nullptr) {
-        return android::base::Error(NO_MEMORY) << "Error allocating property map.";
-    }
+    auto parse = [filename]() -> android::base::Result<std::shared_ptr<const PropertyMap>> {
+        std::unique_ptr<PropertyMap> outMap = std::make_unique<PropertyMap>();
+        if (outMap == nullptr) {
+            return android::base::Error(NO_MEMORY) << "Error allocating property map.";
+        }
 
-    Tokenizer* rawTokenizer;
-    status_t status = Tokenizer::open(String8(filename), &rawTokenizer);
-    if (status) {
-        return android::base::Error(-status) << "Could not open file: " << filename;
-    }
+        Tokenizer* rawTokenizer;
+        status_t status = Tokenizer::open(String8(filename), &rawTokenizer);
+        if (status) {
+            return android::base::Error(-status) << "Could not open file: " << filename;
+        }
 #if DEBUG_PARSER_PERFORMANCE
-    nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
 #endif
-    std::unique_ptr<Tokenizer> tokenizer(rawTokenizer);
-    Parser parser(outMap.get(), tokenizer.get());
-    status = parser.parse();
+        std::unique_ptr<Tokenizer> tokenizer(rawTokenizer);
+        Parser parser(outMap.get(), tokenizer.get());
+        status = parser.parse();
 #if DEBUG_PARSER_PERFORMANCE
-    nsecs_t elapsedTime = systemTime(SYSTEM_TIME_MONOTONIC) - startTime;
-    ALOGD("Parsed property file '%s' %d lines in %0.3fms.", tokenizer->getFilename().string(),
-          tokenizer->getLineNumber(), elapsedTime / 1000000.0);
+        nsecs_t elapsedTime = systemTime(SYSTEM_TIME_MONOTONIC) - startTime;
+        ALOGD("Parsed property file '%s' %d lines in %0.3fms.", tokenizer->getFilename().string(),
+              tokenizer->getLineNumber(), elapsedTime / 1000000.0);
 #endif
-    if (status) {
-        return android::base::Error(BAD_VALUE) << "Could not parse " << filename;
-    }
+        if (status) {
+            return android::base::Error(BAD_VALUE) << "Could not parse " << filename;
+        }
 
-    return std::move(outMap);
+        return std::shared_ptr<const PropertyMap>(std::move(outMap));
+    };
+
+    static ParsedFileCache<std::shared_ptr<const PropertyMap>>* sCache =
+            new ParsedFileCache<std::shared_ptr<const PropertyMap>>();
+    android::base::Result<std::shared_ptr<const PropertyMap>> parsedMap =
+            sCache->getOrLoad(filename, filename, parse);
+    if (!parsedMap.ok()) {
+        return parsedMap.error();
+    }
+    return std::make_unique<PropertyMap>(**parsedMap);
 }
 
 // --- PropertyMap::Parser ---
@@ -29,6 +29,7 @@
 #include <span>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
@@ -158,17 +159,24 @@ void TfLiteMotionPredictorBuffers::reset() {
     mAxisTo.reset();
 }
 
-void TfLiteMotionPredictorBuffers::copyTo(TfLiteMotionPredictorModel& model) const {
+void TfLiteMotionPredictorBuffers::copyTo(TfLiteMotionPredictorModel& model,
+                                          size_t batchIndex) const {
     LOG_ALWAYS_FATAL_IF(mInputR.size() != model.inputLength(),
                         "Buffer length %zu doesn't match model input length %zu", mInputR.size(),
                         model.inputLength());
+    LOG_ALWAYS_FATAL_IF(batchIndex >= model.batchSize(),
+                        "Batch index %zu is out of the model batch of %zu", batchIndex,
+                        model.batchSize());
     LOG_ALWAYS_FATAL_IF(!isReady(), "Buffers are incomplete");
 
-    std::copy(mInputR.begin(), mInputR.end(), model.inputR().begin());
-    std::copy(mInputPhi.begin(), mInputPhi.end(), model.inputPhi().begin());
-    std::copy(mInputPressure.begin(), mInputPressure.end(), model.inputPressure().begin());
-    std::copy(mInputTilt.begin(), mInputTilt.end(), model.inputTilt().begin());
-    std::copy(mInputOrientation.begin(), mInputOrientation.end(), model.inputOrientation().begin());
+    const size_t offset = batchIndex * mInputR.size();
+    std::copy(mInputR.begin(), mInputR.end(), model.inputR().begin() + offset);
+    std::copy(mInputPhi.begin(), mInputPhi.end(), model.inputPhi().begin() + offset);
+    std::copy(mInputPressure.begin(), mInputPressure.end(),
+              model.inputPressure().begin() + offset);
+    std::copy(mInputTilt.begin(), mInputTilt.end(), model.inputTilt().begin() + offset);
+    std::copy(mInputOrientation.begin(), mInputOrientation.end(),
+              model.inputOrientation().begin() + offset);
 }
 
 void TfLiteMotionPredictorBuffers::pushSample(int64_t timestamp,
@@ -295,9 +303,9 @@ void TfLiteMotionPredictorModel::allocateTensors() {
 
     const auto checkInputTensorSize = [this](const TfLiteTensor* tensor) {
         const size_t size = getTensorBuffer<const float>(tensor).size();
-        LOG_ALWAYS_FATAL_IF(size != inputLength(),
+        LOG_ALWAYS_FATAL_IF(size != inputLength() * mBatchSize,
                             "Tensor '%s' length %zu does not match input length %zu", tensor->name,
-                            size, inputLength());
+                            size, inputLength() * mBatchSize);
     };
 
     checkInputTensorSize(mInputR);
@@ -321,6 +329,33 @@ void TfLiteMotionPredictorModel::attachOutputTensors() {
     mOutputPressure = findOutputTensor(OUTPUT_PRESSURE, mRunner);
 }
 
+bool TfLiteMotionPredictorModel::setBatchSize(size_t batchSize) {
+    LOG_ALWAYS_FATAL_IF(batchSize == 0, "Batch size must be greater than 0");
+    if (batchSize == mBatchSize) {
+        return true;
+    }
+
+    // The inputs can only be batched if they have the shape [batch, inputLength].
+    const TfLiteTensor* inputs[] = {mInputR, mInputPhi, mInputPressure, mInputTilt,
+                                    mInputOrientation};
+    for (const TfLiteTensor* tensor : inputs) {
+        if (tensor->dims->size != 2) {
+            ALOGW("Input tensor '%s' has no batch dimension", tensor->name);
+            return false;
+        }
+    }
+
+    const std::vector<int> dims = {static_cast<int>(batchSize), static_cast<int>(inputLength())};
+    for (const char* name : {INPUT_R, INPUT_PHI, INPUT_PRESSURE, INPUT_TILT, INPUT_ORIENTATION}) {
+        if (mRunner->ResizeInputTensor(name, dims) != kTfLiteOk) {
+            LOG_ALWAYS_FATAL("Failed to resize input tensor '%s'", name);
+        }
+    }
+    mBatchSize = batchSize;
+    allocateTensors();
+    return true;
+}
+
 bool TfLiteMotionPredictorModel::invoke() {
     ATRACE_BEGIN("TfLiteMotionPredictorModel::invoke");
     TfLiteStatus result = mRunner->Invoke();
@@ -338,16 +373,20 @@ bool TfLiteMotionPredictorModel::invoke() {
         LOG_ALWAYS_FATAL("Output size mismatch: (r: %zu, phi: %zu, pressure: %zu)",
                          outputR().size(), outputPhi().size(), outputPressure().size());
     }
+    if (outputR().size() % mBatchSize != 0) {
+        LOG_ALWAYS_FATAL("Output size %zu is not a multiple of the batch size %zu",
+                         outputR().size(), mBatchSize);
+    }
 
     return true;
 }
 
 size_t TfLiteMotionPredictorModel::inputLength() const {
-    return getTensorBuffer<const float>(mInputR).size();
+    return getTensorBuffer<const float>(mInputR).size() / mBatchSize;
 }
 
 size_t TfLiteMotionPredictorModel::outputLength() const {
-    return getTensorBuffer<const float>(mOutputR).size();
+    return getTensorBuffer<const float>(mOutputR).size() / mBatchSize;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputR() {
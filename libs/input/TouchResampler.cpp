@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <input/TouchResampler.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace std::literals::chrono_literals;
+
+namespace android {
+
+namespace {
+
+// Latency added during resampling.  A few milliseconds doesn't hurt much but
+// reduces the impact of mispredicted touch positions.
+constexpr nsecs_t RESAMPLE_LATENCY = std::chrono::nanoseconds(5ms).count();
+
+// The latency of the quadratic resampling, as a fraction of the interval between the reports
+// of the device, and its minimum.
+constexpr nsecs_t QUADRATIC_LATENCY_DIVISOR = 4;
+constexpr nsecs_t QUADRATIC_MIN_LATENCY = std::chrono::nanoseconds(1ms).count();
+
+// Maximum time to predict forward from the last known state, to avoid predicting too
+// far into the future.
+constexpr nsecs_t RESAMPLE_MAX_PREDICTION = std::chrono::nanoseconds(8ms).count();
+
+// The range of the intervals between the reports which a parabola is fitted through. Closer
+// reports amplify the noise of their positions into the curvature, and further ones are not
+// from the same stroke of the touch.
+constexpr nsecs_t QUADRATIC_MIN_DELTA = std::chrono::nanoseconds(2ms).count();
+constexpr nsecs_t QUADRATIC_MAX_DELTA = std::chrono::nanoseconds(20ms).count();
+
+float lerp(float a, float b, float alpha) {
+    return a + alpha * (b - a);
+}
+
+} // namespace
+
+// --- LinearTouchResampler ---
+
+std::string LinearTouchResampler::getName() const {
+    return "linear";
+}
+
+nsecs_t LinearTouchResampler::getLatency(nsecs_t) const {
+    return RESAMPLE_LATENCY;
+}
+
+nsecs_t LinearTouchResampler::getMaxPrediction(nsecs_t delta) const {
+    // Bounded further by 50% of the last time delta.
+    return std::min(delta / 2, RESAMPLE_MAX_PREDICTION);
+}
+
+TouchResampler::Sample LinearTouchResampler::resample(const Sample* samples, size_t sampleCount,
+                                                      nsecs_t sampleTime) const {
+    const Sample& previous = samples[sampleCount - 2];
+    const Sample& last = samples[sampleCount - 1];
+    const nsecs_t delta = last.eventTime - previous.eventTime;
+    if (sampleTime <= last.eventTime) {
+        const float alpha = float(sampleTime - previous.eventTime) / delta;
+        return {sampleTime, lerp(previous.x, last.x, alpha), lerp(previous.y, last.y, alpha)};
+    }
+    const float alpha = float(last.eventTime - sampleTime) / delta;
+    return {sampleTime, lerp(last.x, previous.x, alpha), lerp(last.y, previous.y, alpha)};
+}
+
+// --- QuadraticTouchResampler ---
+
+std::string QuadraticTouchResampler::getName() const {
+    return "quadratic";
+}
+
+nsecs_t QuadraticTouchResampler::getLatency(nsecs_t reportInterval) const {
+    if (reportInterval <= 0) {
+        return RESAMPLE_LATENCY;
+    }
+    return std::clamp(reportInterval / QUADRATIC_LATENCY_DIVISOR, QUADRATIC_MIN_LATENCY,
+                      RESAMPLE_LATENCY);
+}
+
+nsecs_t QuadraticTouchResampler::getMaxPrediction(nsecs_t delta) const {
+    return std::min(delta, RESAMPLE_MAX_PREDICTION);
+}
+
+TouchResampler::Sample QuadraticTouchResampler::resample(const Sample* samples, size_t sampleCount,
+                                                         nsecs_t sampleTime) const {
+    if (sampleCount < 3) {
+        return LinearTouchResampler().resample(samples, sampleCount, sampleTime);
+    }
+    const Sample& s0 = samples[sampleCount - 3];
+    const Sample& s1 = samples[sampleCount - 2];
+    const Sample& s2 = samples[sampleCount - 1];
+    const nsecs_t delta01 = s1.eventTime - s0.eventTime;
+    const nsecs_t delta12 = s2.eventTime - s1.eventTime;
+    if (delta01 < QUADRATIC_MIN_DELTA || delta01 > QUADRATIC_MAX_DELTA ||
+        delta12 < QUADRATIC_MIN_DELTA) {
+        return LinearTouchResampler().resample(samples, sampleCount, sampleTime);
+    }
+
+    // The Newton form of the parabola through the three samples, with the times in milliseconds
+    // relative to the first sample to keep the divided differences well conditioned.
+    const double t1 = double(delta01) / 1e6;
+    const double t2 = double(s2.eventTime - s0.eventTime) / 1e6;
+    const double t = double(sampleTime - s0.eventTime) / 1e6;
+    const auto evaluate = [&](double p0, double p1, double p2) {
+        const double d01 = (p1 - p0) / t1;
+        const double d12 = (p2 - p1) / (t2 - t1);
+        const double d012 = (d12 - d01) / t2;
+        return float(p0 + t * d01 + t * (t - t1) * d012);
+    };
+    return {sampleTime, evaluate(s0.x, s1.x, s2.x), evaluate(s0.y, s1.y, s2.y)};
+}
+
+} // namespace android
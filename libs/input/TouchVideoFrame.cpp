@@ -17,17 +17,21 @@
 #include <input/DisplayViewport.h>
 #include <input/TouchVideoFrame.h>
 
+#include <algorithm>
+
 namespace android {
 
 TouchVideoFrame::TouchVideoFrame(uint32_t height, uint32_t width, std::vector<int16_t> data,
         const struct timeval& timestamp) :
-         mHeight(height), mWidth(width),mData(std::move(data)), mTimestamp(timestamp) {
+         mHeight(height), mWidth(width),
+         mData(std::make_shared<const std::vector<int16_t>>(std::move(data))),
+         mTimestamp(timestamp) {
 }
 
 bool TouchVideoFrame::operator==(const TouchVideoFrame& rhs) const {
     return mHeight == rhs.mHeight
             && mWidth == rhs.mWidth
-            && mData == rhs.mData
+            && (mData == rhs.mData || *mData == *rhs.mData)
             && mTimestamp.tv_sec == rhs.mTimestamp.tv_sec
             && mTimestamp.tv_usec == rhs.mTimestamp.tv_usec;
 }
@@ -36,7 +40,7 @@ uint32_t TouchVideoFrame::getHeight() const { return mHeight; }
 
 uint32_t TouchVideoFrame::getWidth() const { return mWidth; }
 
-const std::vector<int16_t>& TouchVideoFrame::getData() const { return mData; }
+const std::vector<int16_t>& TouchVideoFrame::getData() const { return *mData; }
 
 const struct timeval& TouchVideoFrame::getTimestamp() const { return mTimestamp; }
 
@@ -66,7 +70,8 @@ void TouchVideoFrame::rotate(ui::Rotation orientation) {
  *     An element at position (i, j) is rotated to (width - j - 1, i)
  */
 void TouchVideoFrame::rotateQuarterTurn(bool clockwise) {
-    std::vector<int16_t> rotated(mData.size());
+    const std::vector<int16_t>& data = *mData;
+    std::vector<int16_t> rotated(data.size());
     for (size_t i = 0; i < mHeight; i++) {
         for (size_t j = 0; j < mWidth; j++) {
             size_t iRotated, jRotated;
@@ -78,27 +83,50 @@ void TouchVideoFrame::rotateQuarterTurn(bool clockwise) {
                 jRotated = i;
             }
             size_t indexRotated = iRotated * mHeight + jRotated;
-            rotated[indexRotated] = mData[i * mWidth + j];
+            rotated[indexRotated] = data[i * mWidth + j];
         }
     }
-    mData = std::move(rotated);
+    mData = std::make_shared<const std::vector<int16_t>>(std::move(rotated));
     std::swap(mHeight, mWidth);
 }
 
 /**
  * An element at position (i, j) is rotated to (height - i - 1, width - j - 1)
- * This is equivalent to moving element [i] to position [height * width - i - 1]
- * Since element at [height * width - i - 1] would move to position [i],
- * we can just swap elements [i] and [height * width - i - 1].
+ * This is equivalent to moving element [i] to position [height * width - i - 1],
+ * so the rotated data is the data in reverse order.
  */
 void TouchVideoFrame::rotate180() {
-    if (mData.size() == 0) {
+    if (mData->size() == 0) {
         return;
     }
-    // Just need to swap elements i and (height * width - 1 - i)
-    for (size_t i = 0; i < mData.size() / 2; i++) {
-        std::swap(mData[i], mData[mHeight * mWidth - 1 - i]);
+    mData = std::make_shared<const std::vector<int16_t>>(mData->rbegin(), mData->rend());
+}
+
+void TouchVideoFrame::downsample(uint32_t factor) {
+    if (factor <= 1 || mData->size() == 0) {
+        return;
+    }
+    const std::vector<int16_t>& data = *mData;
+    const uint32_t height = (mHeight + factor - 1) / factor;
+    const uint32_t width = (mWidth + factor - 1) / factor;
+    std::vector<int16_t> downsampled(height * width);
+    for (uint32_t i = 0; i < height; i++) {
+        const uint32_t rowEnd = std::min((i + 1) * factor, mHeight);
+        for (uint32_t j = 0; j < width; j++) {
+            const uint32_t columnEnd = std::min((j + 1) * factor, mWidth);
+            int32_t sum = 0;
+            for (uint32_t row = i * factor; row < rowEnd; row++) {
+                for (uint32_t column = j * factor; column < columnEnd; column++) {
+                    sum += data[row * mWidth + column];
+                }
+            }
+            const int32_t count = (rowEnd - i * factor) * (columnEnd - j * factor);
+            downsampled[i * width + j] = static_cast<int16_t>(sum / count);
+        }
     }
+    mData = std::make_shared<const std::vector<int16_t>>(std::move(downsampled));
+    mHeight = height;
+    mWidth = width;
 }
 
 } // namespace android
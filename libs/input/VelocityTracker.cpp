@@ -210,6 +210,9 @@ std::unique_ptr<VelocityTrackerStrategy> VelocityTracker::createStrategy(
         case VelocityTracker::Strategy::LEGACY:
             return std::make_unique<LegacyVelocityTrackerStrategy>();
 
+        case VelocityTracker::Strategy::LSQ2_INCREMENTAL:
+            return std::make_unique<IncrementalLeastSquaresVelocityTrackerStrategy>();
+
         default:
             break;
     }
@@ -805,6 +808,130 @@ float LeastSquaresVelocityTrackerStrategy::chooseWeight(int32_t pointerId, uint3
     }
 }
 
+// --- IncrementalLeastSquaresVelocityTrackerStrategy ---
+
+IncrementalLeastSquaresVelocityTrackerStrategy::IncrementalLeastSquaresVelocityTrackerStrategy() {}
+
+IncrementalLeastSquaresVelocityTrackerStrategy::~IncrementalLeastSquaresVelocityTrackerStrategy() {}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::Sums::add(double time, double position,
+                                                              double sign) {
+    const double time2 = time * time;
+    t += sign * time;
+    t2 += sign * time2;
+    t3 += sign * time2 * time;
+    t4 += sign * time2 * time2;
+    p += sign * position;
+    tp += sign * time * position;
+    t2p += sign * time2 * position;
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::clearPointer(int32_t pointerId) {
+    mWindows.erase(pointerId);
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::addToSums(Window& window,
+                                                               const Movement& movement,
+                                                               double sign) const {
+    window.sums.add((movement.eventTime - window.referenceTime) * 0.000000001, movement.position,
+                    sign);
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::rebase(Window& window) const {
+    window.referenceTime = window.newest().eventTime;
+    window.sums = {};
+    for (uint32_t i = 0; i < window.size; i++) {
+        addToSums(window, window.movements[(window.start + i) % HISTORY_SIZE], 1);
+    }
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::addMovement(nsecs_t eventTime,
+                                                                 int32_t pointerId,
+                                                                 float position) {
+    Window& window = mWindows[pointerId];
+    if (window.size > 0 && window.newest().eventTime == eventTime) {
+        // Like LeastSquaresVelocityTrackerStrategy, a movement at the time of the last one
+        // replaces it, for the ACTION_MOVE which precedes an ACTION_POINTER_DOWN.
+        Movement& newest = window.movements[(window.start + window.size - 1) % HISTORY_SIZE];
+        addToSums(window, newest, -1);
+        newest.position = position;
+        addToSums(window, newest, 1);
+        return;
+    }
+
+    const auto removeOldest = [this, &window]() {
+        addToSums(window, window.movements[window.start], -1);
+        window.start = (window.start + 1) % HISTORY_SIZE;
+        window.size--;
+    };
+    if (window.size == HISTORY_SIZE) {
+        removeOldest();
+    }
+    Movement& movement = window.movements[(window.start + window.size) % HISTORY_SIZE];
+    movement.eventTime = eventTime;
+    movement.position = position;
+    window.size++;
+    while (window.size > 1 && eventTime - window.movements[window.start].eventTime > HORIZON) {
+        removeOldest();
+    }
+
+    if (window.size == 1 || eventTime - window.referenceTime > HORIZON) {
+        rebase(window);
+    } else {
+        addToSums(window, movement, 1);
+    }
+}
+
+std::optional<VelocityTracker::Estimator>
+IncrementalLeastSquaresVelocityTrackerStrategy::getEstimator(int32_t pointerId) const {
+    const auto it = mWindows.find(pointerId);
+    if (it == mWindows.end() || it->second.size == 0) {
+        return std::nullopt; // no data
+    }
+    const Window& window = it->second;
+    const Sums& s = window.sums;
+    const Movement& newest = window.newest();
+
+    VelocityTracker::Estimator estimator;
+    estimator.time = newest.eventTime;
+    estimator.confidence = 1;
+    // The sums are relative to the reference time, and the estimator to the newest movement.
+    const double shift = (newest.eventTime - window.referenceTime) * 0.000000001;
+    const double n = window.size;
+    const double sxx = s.t2 - s.t * s.t / n;
+    const double sxy = s.tp - s.t * s.p / n;
+    if (window.size >= 3) {
+        // The same solution as solveUnweightedLeastSquaresDeg2.
+        const double sxx2 = s.t3 - s.t * s.t2 / n;
+        const double sx2y = s.t2p - s.t2 * s.p / n;
+        const double sx2x2 = s.t4 - s.t2 * s.t2 / n;
+        const double denominator = sxx * sx2x2 - sxx2 * sxx2;
+        if (denominator > 0) {
+            const double a = (sx2y * sxx - sxy * sxx2) / denominator;
+            const double b = (sxy * sx2x2 - sx2y * sxx2) / denominator;
+            const double c = (s.p - b * s.t - a * s.t2) / n;
+            estimator.degree = 2;
+            estimator.coeff[0] = c + shift * (b + shift * a);
+            estimator.coeff[1] = b + 2 * a * shift;
+            estimator.coeff[2] = a;
+            return estimator;
+        }
+    } else if (window.size == 2 && sxx > 0) {
+        // The line through both movements.
+        const double b = sxy / sxx;
+        const double c = (s.p - b * s.t) / n;
+        estimator.degree = 1;
+        estimator.coeff[0] = c + b * shift;
+        estimator.coeff[1] = b;
+        return estimator;
+    }
+
+    // No velocity data available for this pointer, but we do have its current position.
+    estimator.coeff[0] = newest.position;
+    estimator.degree = 0;
+    return estimator;
+}
+
 // --- IntegratingVelocityTrackerStrategy ---
 
 IntegratingVelocityTrackerStrategy::IntegratingVelocityTrackerStrategy(uint32_t degree) :
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <input/InputTransport.h>
+#include <poll.h>
+
+#include <thread>
+
+namespace android {
+
+namespace {
+
+// The argument of the benchmarks: 0 for the socket transport, 1 for the shared memory transport.
+InputChannel::Transport getTransport(const benchmark::State& state) {
+    return state.range(0) != 0 ? InputChannel::Transport::SHARED_MEMORY
+                               : InputChannel::Transport::SOCKET;
+}
+
+InputMessage makeMotionMessage(uint32_t seq) {
+    InputMessage msg = {};
+    msg.header.type = InputMessage::Type::MOTION;
+    msg.header.seq = seq;
+    msg.body.motion.pointerCount = 2;
+    return msg;
+}
+
+// Waits for the channel to be readable, and receives a message. Returns false if the peer was
+// closed.
+bool waitAndReceive(InputChannel& channel, InputMessage* msg) {
+    while (true) {
+        const status_t status = channel.receiveMessage(msg);
+        if (status != WOULD_BLOCK) {
+            return status == OK;
+        }
+        pollfd fd = {.fd = channel.getFd(), .events = POLLIN};
+        poll(&fd, 1, -1);
+    }
+}
+
+} // namespace
+
+// Sends motion events to a consumer thread, which replies with a finished message to each of
+// them, like the dispatcher and an app. Measures the latency of a round trip, and the CPU time of
+// the sender.
+static void benchmarkRoundTrip(benchmark::State& state) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    InputChannel::openInputChannelPair("benchmark", getTransport(state), serverChannel,
+                                       clientChannel);
+    std::thread consumer([&clientChannel]() {
+        InputMessage msg;
+        while (waitAndReceive(*clientChannel, &msg)) {
+            InputMessage reply = {};
+            reply.header.type = InputMessage::Type::FINISHED;
+            reply.header.seq = msg.header.seq;
+            clientChannel->sendMessage(&reply);
+        }
+    });
+
+    uint32_t seq = 0;
+    InputMessage reply;
+    for (auto _ : state) {
+        const InputMessage msg = makeMotionMessage(++seq);
+        serverChannel->sendMessage(&msg);
+        if (!waitAndReceive(*serverChannel, &reply)) {
+            state.SkipWithError("The consumer closed its channel");
+            break;
+        }
+    }
+    serverChannel.reset();
+    consumer.join();
+}
+BENCHMARK(benchmarkRoundTrip)->ArgName("sharedMemory")->Arg(0)->Arg(1)->UseRealTime();
+
+// Sends a burst of motion events, and then receives them all on the same thread, so that only the
+// cost of the transport itself is measured.
+static void benchmarkBurst(benchmark::State& state) {
+    constexpr uint32_t BURST_SIZE = 32;
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    InputChannel::openInputChannelPair("benchmark", getTransport(state), serverChannel,
+                                       clientChannel);
+
+    uint32_t seq = 0;
+    InputMessage received;
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < BURST_SIZE; i++) {
+            const InputMessage msg = makeMotionMessage(++seq);
+            serverChannel->sendMessage(&msg);
+        }
+        while (clientChannel->receiveMessage(&received) == OK) {
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BURST_SIZE);
+}
+BENCHMARK(benchmarkBurst)->ArgName("sharedMemory")->Arg(0)->Arg(1);
+
+} // namespace android
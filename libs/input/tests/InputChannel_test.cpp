@@ -227,4 +227,107 @@ TEST_F(InputChannelTest, DuplicateChannelAndAssertEqual) {
     EXPECT_EQ(*serverChannel == *dupChan, true) << "inputchannel should be equal after duplication";
 }
 
+TEST_F(InputChannelTest, SharedMemory_SendAndReceive) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    ASSERT_EQ(OK,
+              InputChannel::openInputChannelPair("channel name",
+                                                 InputChannel::Transport::SHARED_MEMORY,
+                                                 serverChannel, clientChannel));
+    ASSERT_TRUE(serverChannel->usesSharedMemory());
+    ASSERT_TRUE(clientChannel->usesSharedMemory());
+
+    InputMessage clientMsg;
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+
+    // Enough messages to wrap around the rings many times.
+    for (uint32_t seq = 1; seq <= 1000; seq++) {
+        InputMessage serverMsg = {};
+        serverMsg.header.type = InputMessage::Type::MOTION;
+        serverMsg.header.seq = seq;
+        serverMsg.body.motion.pointerCount = 1 + seq % MAX_POINTERS;
+        ASSERT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+        EXPECT_EQ(InputMessage::Type::MOTION, clientMsg.header.type);
+        EXPECT_EQ(seq, clientMsg.header.seq);
+        EXPECT_EQ(serverMsg.body.motion.pointerCount, clientMsg.body.motion.pointerCount);
+
+        InputMessage finishedMsg = {};
+        finishedMsg.header.type = InputMessage::Type::FINISHED;
+        finishedMsg.header.seq = seq;
+        ASSERT_EQ(OK, clientChannel->sendMessage(&finishedMsg));
+        InputMessage serverReply;
+        ASSERT_EQ(OK, serverChannel->receiveMessage(&serverReply));
+        EXPECT_EQ(InputMessage::Type::FINISHED, serverReply.header.type);
+        EXPECT_EQ(seq, serverReply.header.seq);
+    }
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_EQ(WOULD_BLOCK, serverChannel->receiveMessage(&clientMsg));
+}
+
+TEST_F(InputChannelTest, SharedMemory_SendMessage_WhenTheRingIsFull_ReturnsWouldBlock) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    ASSERT_EQ(OK,
+              InputChannel::openInputChannelPair("channel name",
+                                                 InputChannel::Transport::SHARED_MEMORY,
+                                                 serverChannel, clientChannel));
+
+    InputMessage serverMsg = {};
+    serverMsg.header.type = InputMessage::Type::KEY;
+    status_t status;
+    uint32_t count = 0;
+    while ((status = serverChannel->sendMessage(&serverMsg)) == OK) {
+        count++;
+    }
+    EXPECT_EQ(WOULD_BLOCK, status);
+
+    InputMessage clientMsg;
+    for (uint32_t i = 0; i < count; i++) {
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+    }
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+}
+
+TEST_F(InputChannelTest, SharedMemory_ReceiveMessage_WhenPeerClosed_ReturnsDeadObject) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    ASSERT_EQ(OK,
+              InputChannel::openInputChannelPair("channel name",
+                                                 InputChannel::Transport::SHARED_MEMORY,
+                                                 serverChannel, clientChannel));
+
+    InputMessage msg = {};
+    msg.header.type = InputMessage::Type::KEY;
+    ASSERT_EQ(OK, serverChannel->sendMessage(&msg));
+    serverChannel.reset();
+
+    // The pending message is still received.
+    EXPECT_EQ(OK, clientChannel->receiveMessage(&msg));
+    EXPECT_EQ(DEAD_OBJECT, clientChannel->receiveMessage(&msg));
+}
+
+TEST_F(InputChannelTest, SharedMemory_ParcelAndUnparcel) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    ASSERT_EQ(OK,
+              InputChannel::openInputChannelPair("channel parceling",
+                                                 InputChannel::Transport::SHARED_MEMORY,
+                                                 serverChannel, clientChannel));
+
+    InputChannel chan;
+    Parcel parcel;
+    ASSERT_EQ(OK, clientChannel->writeToParcel(&parcel));
+    parcel.setDataPosition(0);
+    ASSERT_EQ(OK, chan.readFromParcel(&parcel));
+    EXPECT_TRUE(chan == *clientChannel);
+    ASSERT_TRUE(chan.usesSharedMemory());
+
+    // The unparceled channel receives through its own mapping of the memory.
+    InputMessage msg = {};
+    msg.header.type = InputMessage::Type::KEY;
+    msg.header.seq = 7;
+    ASSERT_EQ(OK, serverChannel->sendMessage(&msg));
+    InputMessage clientMsg;
+    ASSERT_EQ(OK, chan.receiveMessage(&clientMsg));
+    EXPECT_EQ(7u, clientMsg.header.seq);
+}
+
 } // namespace android
@@ -169,4 +169,89 @@ TEST(InputDeviceKeyLayoutTest, LoadsWhenRequiredKernelConfigIsPresent) {
     ASSERT_NE(nullptr, map) << "Map should be valid because CONFIG_UHID should always be present";
 }
 
+TEST(InputDeviceKeyLayoutTest, ParsedFilesAreCachedUntilTheyChange) {
+    TemporaryFile klFile;
+    ASSERT_TRUE(base::WriteStringToFile("key 1 ESCAPE\n", klFile.path));
+    base::Result<std::shared_ptr<KeyLayoutMap>> first = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(first.ok());
+    base::Result<std::shared_ptr<KeyLayoutMap>> second = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(second.ok());
+    // The maps are immutable, so the same map is shared.
+    ASSERT_EQ(*first, *second);
+
+    ASSERT_TRUE(base::WriteStringToFile("key 1 ESCAPE\nkey 2 1\n", klFile.path));
+    base::Result<std::shared_ptr<KeyLayoutMap>> changed = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(changed.ok());
+    ASSERT_NE(*first, *changed);
+    int32_t keyCode;
+    uint32_t flags;
+    ASSERT_EQ(OK, (*changed)->mapKey(2, 0, &keyCode, &flags));
+    ASSERT_EQ(AKEYCODE_1, keyCode);
+}
+
+TEST(InputDeviceKeyCharacterMapTest, CachedMapsAreCopied) {
+    std::string kcmPath = base::GetExecutableDirectory() + "/data/english_us.kcm";
+    base::Result<std::shared_ptr<KeyCharacterMap>> first =
+            KeyCharacterMap::load(kcmPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(first.ok());
+    base::Result<std::shared_ptr<KeyCharacterMap>> second =
+            KeyCharacterMap::load(kcmPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(second.ok());
+    // The maps can be changed by their users, so each one gets its own.
+    ASSERT_NE(*first, *second);
+    ASSERT_EQ(**first, **second);
+}
+
+TEST(InputDeviceKeyLayoutTest, BinaryMapsAreLoadedLikeTextOnes) {
+    TemporaryFile klFile;
+    ASSERT_TRUE(base::WriteStringToFile("key 1 ESCAPE\n"
+                                        "key usage 0x0c0067 WINDOW\n"
+                                        "axis 0x00 split 0x7f GAS BRAKE\n"
+                                        "led 0x00 NUM_LOCK\n"
+                                        "sensor 0x00 ACCELEROMETER X\n",
+                                        klFile.path));
+    base::Result<std::shared_ptr<KeyLayoutMap>> text = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(text.ok());
+    const std::vector<uint8_t> binary = (*text)->toBinary();
+
+    TemporaryFile binaryFile;
+    ASSERT_TRUE(base::WriteFully(binaryFile.fd, binary.data(), binary.size()));
+    base::Result<std::shared_ptr<KeyLayoutMap>> ret = KeyLayoutMap::load(binaryFile.path);
+    ASSERT_TRUE(ret.ok()) << ret.error();
+    ASSERT_EQ(binary, (*ret)->toBinary());
+    int32_t keyCode;
+    uint32_t flags;
+    ASSERT_EQ(OK, (*ret)->mapKey(0, 0x0c0067, &keyCode, &flags));
+    ASSERT_EQ(AKEYCODE_WINDOW, keyCode);
+    std::optional<AxisInfo> axis = (*ret)->mapAxis(0x00);
+    ASSERT_TRUE(axis.has_value());
+    ASSERT_EQ(AxisInfo::MODE_SPLIT, axis->mode);
+    ASSERT_EQ(0x7f, axis->splitValue);
+    ASSERT_TRUE((*ret)->mapSensor(0x00).ok());
+
+    // A truncated binary map is not loaded.
+    ASSERT_EQ(0, ftruncate(binaryFile.fd, static_cast<off_t>(binary.size() - 1)));
+    ASSERT_FALSE(KeyLayoutMap::load(binaryFile.path).ok());
+}
+
+TEST(InputDeviceKeyCharacterMapTest, BinaryMapsAreLoadedLikeTextOnes) {
+    std::string kcmPath = base::GetExecutableDirectory() + "/data/english_us.kcm";
+    base::Result<std::shared_ptr<KeyCharacterMap>> text =
+            KeyCharacterMap::load(kcmPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(text.ok());
+    const std::vector<uint8_t> binary = (*text)->toBinary();
+
+    TemporaryFile binaryFile;
+    ASSERT_TRUE(base::WriteFully(binaryFile.fd, binary.data(), binary.size()));
+    base::Result<std::shared_ptr<KeyCharacterMap>> ret =
+            KeyCharacterMap::load(binaryFile.path, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(ret.ok()) << ret.error();
+    ASSERT_EQ(binary, (*ret)->toBinary());
+    ASSERT_EQ((*text)->getCharacter(AKEYCODE_A, AMETA_SHIFT_ON),
+              (*ret)->getCharacter(AKEYCODE_A, AMETA_SHIFT_ON));
+
+    // The binary maps are checked against the expected format like the text ones.
+    ASSERT_FALSE(KeyCharacterMap::load(binaryFile.path, KeyCharacterMap::Format::BASE).ok());
+}
+
 } // namespace android
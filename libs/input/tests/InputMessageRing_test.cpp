@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../InputMessageRing.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace android {
+
+class InputMessageRingTest : public testing::Test {
+protected:
+    std::unique_ptr<InputMessageRing::Shared> mShared =
+            std::make_unique<InputMessageRing::Shared>();
+    InputMessageRing mWriter{*mShared};
+    InputMessageRing mReader{*mShared};
+};
+
+TEST_F(InputMessageRingTest, ReadsTheMessagesInOrderAcrossTheEndOfTheRing) {
+    std::array<uint8_t, 200> message;
+    std::array<uint8_t, 256> buffer;
+    // Enough messages to wrap around the ring many times, with a length which does not divide
+    // its capacity.
+    for (int i = 0; i < 2000; i++) {
+        const size_t size = 1 + i % message.size();
+        memset(message.data(), i & 0xff, size);
+        bool wakeReader;
+        ASSERT_EQ(OK, mWriter.write(message.data(), size, &wakeReader));
+
+        size_t readSize;
+        ASSERT_EQ(OK, mReader.read(buffer.data(), buffer.size(), &readSize));
+        ASSERT_EQ(size, readSize);
+        ASSERT_EQ(0, memcmp(message.data(), buffer.data(), size));
+    }
+    size_t readSize;
+    EXPECT_EQ(WOULD_BLOCK, mReader.read(buffer.data(), buffer.size(), &readSize));
+}
+
+TEST_F(InputMessageRingTest, Write_WhenTheRingIsFull_ReturnsWouldBlock) {
+    std::array<uint8_t, 1000> message{};
+    bool wakeReader;
+    status_t status;
+    int count = 0;
+    while ((status = mWriter.write(message.data(), message.size(), &wakeReader)) == OK) {
+        count++;
+    }
+    EXPECT_EQ(WOULD_BLOCK, status);
+    EXPECT_GT(count, 0);
+
+    // Reading a message makes room for another one.
+    std::array<uint8_t, 1000> buffer;
+    size_t readSize;
+    ASSERT_EQ(OK, mReader.read(buffer.data(), buffer.size(), &readSize));
+    EXPECT_EQ(OK, mWriter.write(message.data(), message.size(), &wakeReader));
+}
+
+TEST_F(InputMessageRingTest, Write_WakesTheReaderOnlyWhenItWaits) {
+    const uint32_t message = 1;
+    bool wakeReader;
+    ASSERT_EQ(OK, mWriter.write(&message, sizeof(message), &wakeReader));
+    EXPECT_FALSE(wakeReader);
+
+    // A message is pending, so the reader does not wait.
+    EXPECT_FALSE(mReader.prepareToWait());
+    uint32_t buffer;
+    size_t readSize;
+    ASSERT_EQ(OK, mReader.read(&buffer, sizeof(buffer), &readSize));
+    EXPECT_TRUE(mReader.prepareToWait());
+
+    ASSERT_EQ(OK, mWriter.write(&message, sizeof(message), &wakeReader));
+    EXPECT_TRUE(wakeReader);
+    ASSERT_EQ(OK, mWriter.write(&message, sizeof(message), &wakeReader));
+    EXPECT_FALSE(wakeReader);
+}
+
+TEST_F(InputMessageRingTest, Read_WhenThePositionsAreCorrupted_ReturnsBadValue) {
+    const uint32_t message = 1;
+    bool wakeReader;
+    ASSERT_EQ(OK, mWriter.write(&message, sizeof(message), &wakeReader));
+
+    // A write position beyond the capacity of the ring.
+    mShared->writePosition.store(InputMessageRing::CAPACITY * 2);
+    uint32_t buffer;
+    size_t readSize;
+    EXPECT_EQ(BAD_VALUE, mReader.read(&buffer, sizeof(buffer), &readSize));
+
+    // A read position beyond the write position.
+    mShared->readPosition.store(InputMessageRing::CAPACITY);
+    EXPECT_EQ(BAD_VALUE, mWriter.write(&message, sizeof(message), &wakeReader));
+}
+
+TEST_F(InputMessageRingTest, Read_WhenTheSizeIsCorrupted_ReturnsBadValue) {
+    const uint32_t message = 1;
+    bool wakeReader;
+    ASSERT_EQ(OK, mWriter.write(&message, sizeof(message), &wakeReader));
+
+    const uint32_t size = InputMessageRing::CAPACITY;
+    memcpy(mShared->data, &size, sizeof(size));
+    std::array<uint8_t, InputMessageRing::CAPACITY> buffer;
+    size_t readSize;
+    EXPECT_EQ(BAD_VALUE, mReader.read(buffer.data(), buffer.size(), &readSize));
+}
+
+} // namespace android
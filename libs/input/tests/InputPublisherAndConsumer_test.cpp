@@ -21,6 +21,8 @@
 #include <gui/constants.h>
 #include <input/InputTransport.h>
 
+#include <set>
+
 using android::base::Result;
 
 namespace android {
@@ -559,4 +561,222 @@ TEST_F(InputPublisherAndConsumerTest, PublishMultipleEvents_EndToEnd) {
     ASSERT_NO_FATAL_FAILURE(PublishAndConsumeTouchModeEvent());
 }
 
+namespace {
+
+struct MoveSample {
+    uint32_t seq;
+    nsecs_t eventTime;
+    float x;
+};
+
+std::array<uint8_t, 32> makeHmac(uint32_t seq) {
+    std::array<uint8_t, 32> hmac;
+    hmac.fill(static_cast<uint8_t>(seq));
+    return hmac;
+}
+
+int32_t getEventId(uint32_t seq) {
+    return static_cast<int32_t>(seq * 10);
+}
+
+// Publishes the MOVE samples of a touch, either all in one message, or one message per sample.
+status_t publishMoves(InputPublisher& publisher, int32_t action,
+                      const std::vector<MoveSample>& samples, bool inOneMessage) {
+    PointerProperties properties;
+    properties.clear();
+    properties.id = 0;
+    properties.toolType = ToolType::FINGER;
+    std::vector<PointerCoords> coords(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        coords[i].clear();
+        coords[i].setAxisValue(AMOTION_EVENT_AXIS_X, samples[i].x);
+        coords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, samples[i].x * 2);
+    }
+    const ui::Transform identityTransform;
+    auto publish = [&](size_t i, const std::vector<InputPublisher::MotionSample>& laterSamples) {
+        return publisher.publishMotionEvent(samples[i].seq, getEventId(samples[i].seq),
+                                            /*deviceId=*/1, AINPUT_SOURCE_TOUCHSCREEN,
+                                            ADISPLAY_ID_DEFAULT, makeHmac(samples[i].seq), action,
+                                            /*actionButton=*/0, /*flags=*/0, /*edgeFlags=*/0,
+                                            /*metaState=*/0, /*buttonState=*/0,
+                                            MotionClassification::NONE, identityTransform,
+                                            /*xPrecision=*/1, /*yPrecision=*/1,
+                                            AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                            AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                            identityTransform, /*downTime=*/0,
+                                            samples[i].eventTime, /*pointerCount=*/1, &properties,
+                                            &coords[i], laterSamples);
+    };
+    if (!inOneMessage) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            const status_t status = publish(i, {});
+            if (status != OK) {
+                return status;
+            }
+        }
+        return OK;
+    }
+    std::vector<InputPublisher::MotionSample> laterSamples;
+    for (size_t i = 1; i < samples.size(); i++) {
+        laterSamples.push_back({.seq = samples[i].seq,
+                                .eventId = getEventId(samples[i].seq),
+                                .hmac = makeHmac(samples[i].seq),
+                                .eventTime = samples[i].eventTime,
+                                .pointerCoords = &coords[i]});
+    }
+    return publish(0, laterSamples);
+}
+
+const std::vector<MoveSample> MOVE_SAMPLES = {
+        {.seq = 1, .eventTime = 10'000'000, .x = 10},
+        {.seq = 2, .eventTime = 20'000'000, .x = 20},
+        {.seq = 3, .eventTime = 30'000'000, .x = 40},
+};
+
+} // namespace
+
+TEST_F(InputPublisherAndConsumerTest, PublishMotionEvent_WithLaterSamples_ConsumesOneBatch) {
+    ASSERT_EQ(OK,
+              publishMoves(*mPublisher, AMOTION_EVENT_ACTION_MOVE, MOVE_SAMPLES,
+                           /*inOneMessage=*/true));
+
+    uint32_t consumeSeq;
+    InputEvent* event;
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1, &consumeSeq,
+                                 &event));
+    ASSERT_EQ(InputEventType::MOTION, event->getType());
+    const MotionEvent& motionEvent = static_cast<const MotionEvent&>(*event);
+    EXPECT_EQ(3u, consumeSeq);
+    EXPECT_EQ(getEventId(1), motionEvent.getId());
+    ASSERT_EQ(2u, motionEvent.getHistorySize());
+    for (size_t i = 0; i < 2; i++) {
+        EXPECT_EQ(MOVE_SAMPLES[i].eventTime, motionEvent.getHistoricalEventTime(i));
+        EXPECT_NEAR(MOVE_SAMPLES[i].x, motionEvent.getHistoricalX(0, i), EPSILON);
+        EXPECT_NEAR(MOVE_SAMPLES[i].x * 2, motionEvent.getHistoricalY(0, i), EPSILON);
+    }
+    EXPECT_EQ(MOVE_SAMPLES[2].eventTime, motionEvent.getEventTime());
+    EXPECT_NEAR(MOVE_SAMPLES[2].x, motionEvent.getX(0), EPSILON);
+    EXPECT_EQ(WOULD_BLOCK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1, &consumeSeq,
+                                 &event));
+
+    // Each sample is finished.
+    ASSERT_EQ(OK, mConsumer->sendFinishedSignal(3, true));
+    std::set<uint32_t> finishedSeqs;
+    for (size_t i = 0; i < MOVE_SAMPLES.size(); i++) {
+        Result<InputPublisher::ConsumerResponse> result = mPublisher->receiveConsumerResponse();
+        ASSERT_TRUE(result.ok());
+        ASSERT_TRUE(std::holds_alternative<InputPublisher::Finished>(*result));
+        finishedSeqs.insert(std::get<InputPublisher::Finished>(*result).seq);
+    }
+    EXPECT_EQ(std::set<uint32_t>({1, 2, 3}), finishedSeqs);
+}
+
+TEST_F(InputPublisherAndConsumerTest, PublishMotionEvent_WithLaterSamples_KeepsTheFieldsOfSamples) {
+    mConsumer = std::make_unique<InputConsumer>(mClientChannel, /*enableTouchResampling=*/false);
+    ASSERT_EQ(OK,
+              publishMoves(*mPublisher, AMOTION_EVENT_ACTION_MOVE, MOVE_SAMPLES,
+                           /*inOneMessage=*/true));
+
+    uint32_t consumeSeq;
+    InputEvent* event;
+    ASSERT_EQ(WOULD_BLOCK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/false, -1, &consumeSeq,
+                                 &event));
+    ASSERT_TRUE(mConsumer->hasPendingBatch());
+
+    // Only the first sample is before the frame.
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true,
+                                 MOVE_SAMPLES[0].eventTime, &consumeSeq, &event));
+    const MotionEvent* motionEvent = static_cast<const MotionEvent*>(event);
+    EXPECT_EQ(1u, consumeSeq);
+    EXPECT_EQ(getEventId(1), motionEvent->getId());
+    EXPECT_EQ(makeHmac(1), motionEvent->getHmac());
+    EXPECT_EQ(0u, motionEvent->getHistorySize());
+    EXPECT_EQ(MOVE_SAMPLES[0].eventTime, motionEvent->getEventTime());
+
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1, &consumeSeq,
+                                 &event));
+    motionEvent = static_cast<const MotionEvent*>(event);
+    EXPECT_EQ(3u, consumeSeq);
+    EXPECT_EQ(getEventId(2), motionEvent->getId());
+    EXPECT_EQ(makeHmac(2), motionEvent->getHmac());
+    ASSERT_EQ(1u, motionEvent->getHistorySize());
+    EXPECT_EQ(MOVE_SAMPLES[1].eventTime, motionEvent->getHistoricalEventTime(0));
+    EXPECT_EQ(MOVE_SAMPLES[2].eventTime, motionEvent->getEventTime());
+}
+
+TEST_F(InputPublisherAndConsumerTest,
+       PublishMotionEvent_WithLaterSamples_IsResampledLikeSeparateMessages) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    ASSERT_EQ(OK, InputChannel::openInputChannelPair("separate", serverChannel, clientChannel));
+    InputPublisher separatePublisher(std::move(serverChannel));
+    InputConsumer separateConsumer(std::move(clientChannel), /*enableTouchResampling=*/true);
+    mConsumer = std::make_unique<InputConsumer>(mClientChannel, /*enableTouchResampling=*/true);
+
+    ASSERT_EQ(OK,
+              publishMoves(*mPublisher, AMOTION_EVENT_ACTION_MOVE, MOVE_SAMPLES,
+                           /*inOneMessage=*/true));
+    ASSERT_EQ(OK,
+              publishMoves(separatePublisher, AMOTION_EVENT_ACTION_MOVE, MOVE_SAMPLES,
+                           /*inOneMessage=*/false));
+
+    // The frame is between the last two samples, once the resampling latency is accounted for,
+    // so that the event is resampled.
+    const nsecs_t frameTime = 32'000'000;
+    PreallocatedInputEventFactory separateEventFactory;
+    uint32_t seq, separateSeq;
+    InputEvent* event;
+    InputEvent* separateEvent;
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, frameTime, &seq,
+                                 &event));
+    ASSERT_EQ(OK,
+              separateConsumer.consume(&separateEventFactory, /*consumeBatches=*/true, frameTime,
+                                       &separateSeq, &separateEvent));
+    EXPECT_EQ(separateSeq, seq);
+    const MotionEvent& motionEvent = static_cast<const MotionEvent&>(*event);
+    const MotionEvent& separateMotionEvent = static_cast<const MotionEvent&>(*separateEvent);
+    ASSERT_EQ(separateMotionEvent.getHistorySize(), motionEvent.getHistorySize());
+    ASSERT_GT(motionEvent.getHistorySize(), 0u);
+    for (size_t i = 0; i < motionEvent.getHistorySize(); i++) {
+        EXPECT_EQ(separateMotionEvent.getHistoricalEventTime(i),
+                  motionEvent.getHistoricalEventTime(i));
+        EXPECT_EQ(separateMotionEvent.getHistoricalX(0, i), motionEvent.getHistoricalX(0, i));
+        EXPECT_EQ(separateMotionEvent.getHistoricalY(0, i), motionEvent.getHistoricalY(0, i));
+    }
+    EXPECT_EQ(separateMotionEvent.getEventTime(), motionEvent.getEventTime());
+    EXPECT_EQ(separateMotionEvent.getX(0), motionEvent.getX(0));
+    EXPECT_EQ(separateMotionEvent.getY(0), motionEvent.getY(0));
+    EXPECT_TRUE(motionEvent.isResampled(0, motionEvent.getHistorySize()));
+}
+
+TEST_F(InputPublisherAndConsumerTest, PublishMotionEvent_WithTooManyLaterSamples_ReturnsError) {
+    EXPECT_EQ(InputMessage::Body::Motion::MAX_SAMPLES, InputPublisher::getMaxMotionSampleCount(1));
+    EXPECT_EQ(5u, InputPublisher::getMaxMotionSampleCount(3));
+    EXPECT_EQ(1u, InputPublisher::getMaxMotionSampleCount(MAX_POINTERS));
+    EXPECT_EQ(0u, InputPublisher::getMaxMotionSampleCount(0));
+
+    std::vector<MoveSample> samples;
+    for (uint32_t seq = 1; seq <= InputMessage::Body::Motion::MAX_SAMPLES + 1; seq++) {
+        samples.push_back({.seq = seq, .eventTime = seq * 1'000'000, .x = 1});
+    }
+    EXPECT_EQ(BAD_VALUE,
+              publishMoves(*mPublisher, AMOTION_EVENT_ACTION_MOVE, samples,
+                           /*inOneMessage=*/true));
+    samples.pop_back();
+    EXPECT_EQ(OK,
+              publishMoves(*mPublisher, AMOTION_EVENT_ACTION_MOVE, samples,
+                           /*inOneMessage=*/true));
+}
+
+TEST_F(InputPublisherAndConsumerTest, PublishMotionEvent_WithLaterSamplesOfADown_ReturnsError) {
+    EXPECT_EQ(BAD_VALUE,
+              publishMoves(*mPublisher, AMOTION_EVENT_ACTION_DOWN, MOVE_SAMPLES,
+                           /*inOneMessage=*/true));
+}
+
 } // namespace android
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <fcntl.h>
+#include <input/KeyCharacterMap.h>
+#include <input/KeyLayoutMap.h>
+#include <sys/stat.h>
+
+namespace android {
+
+namespace {
+
+// A layout of the letter and digit keys, with the behaviors of a typical keyboard.
+std::string makeKeyCharacterMap() {
+    std::string contents = "type FULL\n";
+    for (char c = 'A'; c <= 'Z'; c++) {
+        base::StringAppendF(&contents,
+                            "key %c {\n"
+                            "    label: '%c'\n"
+                            "    base: '%c'\n"
+                            "    shift, capslock: '%c'\n"
+                            "    shift+capslock: '%c'\n"
+                            "    ralt: '%c'\n"
+                            "    ctrl, alt, meta: none\n"
+                            "}\n",
+                            c, c, c - 'A' + 'a', c, c - 'A' + 'a', c);
+    }
+    for (char c = '0'; c <= '9'; c++) {
+        base::StringAppendF(&contents,
+                            "key %c {\n"
+                            "    label, number: '%c'\n"
+                            "    base: '%c'\n"
+                            "    ctrl, alt, meta: none\n"
+                            "}\n",
+                            c, c, c);
+    }
+    return contents;
+}
+
+std::string makeKeyLayoutMap() {
+    std::string contents;
+    int32_t scanCode = 1;
+    for (char c = 'A'; c <= 'Z'; c++) {
+        base::StringAppendF(&contents, "key %d %c\n", scanCode++, c);
+    }
+    for (char c = '0'; c <= '9'; c++) {
+        base::StringAppendF(&contents, "key %d %c\n", scanCode++, c);
+    }
+    return contents;
+}
+
+// Changes the modification time of the file, so that it is not loaded from the cache of the
+// parsed files.
+void touch(const std::string& path, long* nanos) {
+    const timespec times[2] = {{.tv_sec = 0, .tv_nsec = UTIME_OMIT},
+                               {.tv_sec = 1, .tv_nsec = (*nanos)++ % 1000000000}};
+    utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+class KeyMapFiles {
+public:
+    KeyMapFiles() {
+        base::WriteStringToFile(makeKeyCharacterMap(), mKcmText.path);
+        base::WriteStringToFile(makeKeyLayoutMap(), mKlText.path);
+        std::vector<uint8_t> kcm =
+                (*KeyCharacterMap::load(mKcmText.path, KeyCharacterMap::Format::BASE))
+                        ->toBinary();
+        base::WriteFully(mKcmBinary.fd, kcm.data(), kcm.size());
+        std::vector<uint8_t> kl = (*KeyLayoutMap::load(mKlText.path))->toBinary();
+        base::WriteFully(mKlBinary.fd, kl.data(), kl.size());
+    }
+
+    const char* kcmPath(bool binary) const { return binary ? mKcmBinary.path : mKcmText.path; }
+    const char* klPath(bool binary) const { return binary ? mKlBinary.path : mKlText.path; }
+
+private:
+    TemporaryFile mKcmText;
+    TemporaryFile mKcmBinary;
+    TemporaryFile mKlText;
+    TemporaryFile mKlBinary;
+};
+
+const KeyMapFiles& getFiles() {
+    static const KeyMapFiles* sFiles = new KeyMapFiles();
+    return *sFiles;
+}
+
+// The argument selects the binary files rather than the text ones.
+void benchmarkLoadKeyCharacterMap(benchmark::State& state) {
+    const std::string path = getFiles().kcmPath(state.range(0));
+    long nanos = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        touch(path, &nanos);
+        state.ResumeTiming();
+        base::Result<std::shared_ptr<KeyCharacterMap>> map =
+                KeyCharacterMap::load(path, KeyCharacterMap::Format::BASE);
+        if (!map.ok()) {
+            state.SkipWithError(map.error().message().c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(*map);
+    }
+}
+BENCHMARK(benchmarkLoadKeyCharacterMap)->ArgName("binary")->Arg(0)->Arg(1);
+
+void benchmarkLoadKeyLayoutMap(benchmark::State& state) {
+    const std::string path = getFiles().klPath(state.range(0));
+    long nanos = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        touch(path, &nanos);
+        state.ResumeTiming();
+        base::Result<std::shared_ptr<KeyLayoutMap>> map = KeyLayoutMap::load(path);
+        if (!map.ok()) {
+            state.SkipWithError(map.error().message().c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(*map);
+    }
+}
+BENCHMARK(benchmarkLoadKeyLayoutMap)->ArgName("binary")->Arg(0)->Arg(1);
+
+// The files which did not change are loaded from the cache, which only takes a stat and a copy.
+void benchmarkLoadCachedKeyCharacterMap(benchmark::State& state) {
+    const std::string path = getFiles().kcmPath(/*binary=*/false);
+    for (auto _ : state) {
+        base::Result<std::shared_ptr<KeyCharacterMap>> map =
+                KeyCharacterMap::load(path, KeyCharacterMap::Format::BASE);
+        benchmark::DoNotOptimize(map);
+    }
+}
+BENCHMARK(benchmarkLoadCachedKeyCharacterMap);
+
+} // namespace
+
+} // namespace android
+
+BENCHMARK_MAIN();
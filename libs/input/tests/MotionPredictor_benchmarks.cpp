@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <input/TfLiteMotionPredictor.h>
+
+#include <vector>
+
+namespace android {
+
+namespace {
+
+// Fills the buffers of the given number of pointers, which move along parallel lines.
+std::vector<TfLiteMotionPredictorBuffers> createPointerBuffers(size_t pointerCount,
+                                                               size_t inputLength) {
+    std::vector<TfLiteMotionPredictorBuffers> buffers;
+    for (size_t p = 0; p < pointerCount; p++) {
+        TfLiteMotionPredictorBuffers& pointerBuffers = buffers.emplace_back(inputLength);
+        for (size_t i = 0; i <= inputLength; i++) {
+            pointerBuffers.pushSample(i * 4000000,
+                                      {.position = {.x = 100.f + p * 100, .y = 100.f + i * 10},
+                                       .pressure = 0.5});
+        }
+    }
+    return buffers;
+}
+
+} // namespace
+
+// Predicts the pointers one after the other, with one execution of the model for each of them.
+static void benchmarkPredictPerPointer(benchmark::State& state) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    const std::vector<TfLiteMotionPredictorBuffers> buffers =
+            createPointerBuffers(state.range(0), model->inputLength());
+    for (auto _ : state) {
+        for (const TfLiteMotionPredictorBuffers& pointerBuffers : buffers) {
+            pointerBuffers.copyTo(*model);
+            benchmark::DoNotOptimize(model->invoke());
+            benchmark::DoNotOptimize(model->outputR().data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * buffers.size());
+}
+BENCHMARK(benchmarkPredictPerPointer)->ArgName("pointers")->Arg(1)->Arg(2)->Arg(4)->Arg(10);
+
+// Predicts all the pointers with one execution of the model on a batch.
+static void benchmarkPredictBatched(benchmark::State& state) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    const std::vector<TfLiteMotionPredictorBuffers> buffers =
+            createPointerBuffers(state.range(0), model->inputLength());
+    if (!model->setBatchSize(buffers.size())) {
+        state.SkipWithError("The model cannot be batched");
+        return;
+    }
+    for (auto _ : state) {
+        for (size_t b = 0; b < buffers.size(); b++) {
+            buffers[b].copyTo(*model, b);
+        }
+        benchmark::DoNotOptimize(model->invoke());
+        benchmark::DoNotOptimize(model->outputR().data());
+    }
+    state.SetItemsProcessed(state.iterations() * buffers.size());
+}
+BENCHMARK(benchmarkPredictBatched)->ArgName("pointers")->Arg(1)->Arg(2)->Arg(4)->Arg(10);
+
+} // namespace android
@@ -127,6 +127,45 @@ TEST(MotionPredictorTest, IndividualGesturesFromDifferentDevicesAreSupported) {
     ASSERT_TRUE(predictor.record(getMotionEvent(MOVE, 100, 300, 50ms, /*deviceId=*/1)).ok());
 }
 
+TEST(MotionPredictorTest, MultiplePointersArePredictedTogether) {
+    MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/0,
+                              []() { return true /*enable prediction*/; });
+    // Two styluses which move down, the second one twice as fast as the first one.
+    const auto getTwoPointerEvent = [](int32_t action, float y, std::chrono::nanoseconds time) {
+        PointerProperties properties[2];
+        PointerCoords coords[2];
+        for (size_t i = 0; i < 2; i++) {
+            properties[i].clear();
+            properties[i].id = i;
+            properties[i].toolType = ToolType::STYLUS;
+            coords[i].clear();
+            coords[i].setAxisValue(AMOTION_EVENT_AXIS_X, 10 + i * 100);
+            coords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, y * (i + 1));
+        }
+        MotionEvent event;
+        ui::Transform identityTransform;
+        event.initialize(InputEvent::nextId(), /*deviceId=*/0, AINPUT_SOURCE_STYLUS,
+                         ADISPLAY_ID_DEFAULT, {0}, action, /*actionButton=*/0, /*flags=*/0,
+                         AMOTION_EVENT_EDGE_FLAG_NONE, AMETA_NONE, /*buttonState=*/0,
+                         MotionClassification::NONE, identityTransform, /*xPrecision=*/0.1,
+                         /*yPrecision=*/0.2, /*xCursorPosition=*/280, /*yCursorPosition=*/540,
+                         identityTransform, /*downTime=*/100, time.count(), /*pointerCount=*/2,
+                         properties, coords);
+        return event;
+    };
+
+    ASSERT_TRUE(predictor.record(getTwoPointerEvent(DOWN, 10, 10ms)).ok());
+    ASSERT_TRUE(predictor.record(getTwoPointerEvent(MOVE, 20, 20ms)).ok());
+    ASSERT_TRUE(predictor.record(getTwoPointerEvent(MOVE, 30, 30ms)).ok());
+    std::unique_ptr<MotionEvent> predicted = predictor.predict(40 * NSEC_PER_MSEC);
+    ASSERT_NE(nullptr, predicted);
+    ASSERT_EQ(2u, predicted->getPointerCount());
+    EXPECT_EQ(0, predicted->getPointerId(0));
+    EXPECT_EQ(1, predicted->getPointerId(1));
+    // Each pointer is predicted from its own samples.
+    EXPECT_LT(predicted->getY(0), predicted->getY(1));
+}
+
 TEST(MotionPredictorTest, FlagDisablesPrediction) {
     MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/0,
                               []() { return false /*disable prediction*/; });
@@ -61,7 +61,8 @@ void TestInputMessageAlignment() {
   CHECK_OFFSET(InputMessage::Body::Motion, metaState, 72);
   CHECK_OFFSET(InputMessage::Body::Motion, buttonState, 76);
   CHECK_OFFSET(InputMessage::Body::Motion, classification, 80);
-  CHECK_OFFSET(InputMessage::Body::Motion, empty2, 81);
+  CHECK_OFFSET(InputMessage::Body::Motion, extraSampleCount, 81);
+  CHECK_OFFSET(InputMessage::Body::Motion, empty2, 82);
   CHECK_OFFSET(InputMessage::Body::Motion, edgeFlags, 84);
   CHECK_OFFSET(InputMessage::Body::Motion, downTime, 88);
   CHECK_OFFSET(InputMessage::Body::Motion, dsdx, 96);
@@ -81,6 +82,12 @@ void TestInputMessageAlignment() {
   CHECK_OFFSET(InputMessage::Body::Motion, txRaw, 152);
   CHECK_OFFSET(InputMessage::Body::Motion, tyRaw, 156);
   CHECK_OFFSET(InputMessage::Body::Motion, pointers, 160);
+  CHECK_OFFSET(InputMessage::Body::Motion, extraSamples, 2464);
+
+  CHECK_OFFSET(InputMessage::Body::Motion::Sample, seq, 0);
+  CHECK_OFFSET(InputMessage::Body::Motion::Sample, eventId, 4);
+  CHECK_OFFSET(InputMessage::Body::Motion::Sample, eventTime, 8);
+  CHECK_OFFSET(InputMessage::Body::Motion::Sample, hmac, 16);
 
   CHECK_OFFSET(InputMessage::Body::Focus, eventId, 0);
   CHECK_OFFSET(InputMessage::Body::Focus, hasFocus, 4);
@@ -118,9 +125,14 @@ void TestHeaderSize() {
 void TestBodySize() {
     static_assert(sizeof(InputMessage::Body::Key) == 96);
     static_assert(sizeof(InputMessage::Body::Motion::Pointer) == 144);
-    static_assert(sizeof(InputMessage::Body::Motion) ==
+    static_assert(sizeof(InputMessage::Body::Motion::Sample) == 48);
+    static_assert(offsetof(InputMessage::Body::Motion, extraSamples) ==
                   offsetof(InputMessage::Body::Motion, pointers) +
                           sizeof(InputMessage::Body::Motion::Pointer) * MAX_POINTERS);
+    static_assert(sizeof(InputMessage::Body::Motion) ==
+                  offsetof(InputMessage::Body::Motion, extraSamples) +
+                          sizeof(InputMessage::Body::Motion::Sample) *
+                                  (InputMessage::Body::Motion::MAX_SAMPLES - 1));
     static_assert(sizeof(InputMessage::Body::Finished) == 16);
     static_assert(sizeof(InputMessage::Body::Focus) == 8);
     static_assert(sizeof(InputMessage::Body::Capture) == 8);
@@ -134,11 +146,9 @@ void TestBodySize() {
      * We cannot use the Body::size() method here because it is not static for
      * the Motion type, where "pointerCount" variable affects the size and can change at runtime.
      */
-    static_assert(sizeof(InputMessage::Body) ==
-                  offsetof(InputMessage::Body::Motion, pointers) +
-                          sizeof(InputMessage::Body::Motion::Pointer) * MAX_POINTERS);
-    static_assert(sizeof(InputMessage::Body) == 160 + 144 * 16);
-    static_assert(sizeof(InputMessage::Body) == 2464);
+    static_assert(sizeof(InputMessage::Body) == sizeof(InputMessage::Body::Motion));
+    static_assert(sizeof(InputMessage::Body) == 160 + 144 * 16 + 48 * 7);
+    static_assert(sizeof(InputMessage::Body) == 2800);
 }
 
 /**
@@ -148,8 +158,8 @@ void TestBodySize() {
  * still helpful to compute to get an idea of the sizes that are involved.
  */
 void TestWorstCaseInputMessageSize() {
-    static_assert(sizeof(InputMessage) == /*header*/ 8 + /*body*/ 2464);
-    static_assert(sizeof(InputMessage) == 2472);
+    static_assert(sizeof(InputMessage) == /*header*/ 8 + /*body*/ 2800);
+    static_assert(sizeof(InputMessage) == 2808);
 }
 
 /**
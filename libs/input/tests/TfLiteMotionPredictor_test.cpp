@@ -20,6 +20,7 @@
 #include <ios>
 #include <iterator>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -165,5 +166,41 @@ TEST(TfLiteMotionPredictorTest, ModelOutput) {
             std::all_of(model->outputPressure().begin(), model->outputPressure().end(), is_valid));
 }
 
+TEST(TfLiteMotionPredictorTest, ModelBatchMatchesSingleInputs) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    const size_t inputLength = model->inputLength();
+    TfLiteMotionPredictorBuffers first(inputLength);
+    first.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 200}, .pressure = 0.2});
+    first.pushSample(/*timestamp=*/2, {.position = {.x = 150, .y = 250}, .pressure = 0.4});
+    first.pushSample(/*timestamp=*/3, {.position = {.x = 180, .y = 280}, .pressure = 0.6});
+    TfLiteMotionPredictorBuffers second(inputLength);
+    second.pushSample(/*timestamp=*/1, {.position = {.x = 500, .y = 500}, .pressure = 0.8});
+    second.pushSample(/*timestamp=*/2, {.position = {.x = 490, .y = 520}, .pressure = 0.7});
+    second.pushSample(/*timestamp=*/3, {.position = {.x = 470, .y = 530}, .pressure = 0.6});
+
+    first.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+    const std::vector<float> firstR(model->outputR().begin(), model->outputR().end());
+    second.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+    const std::vector<float> secondR(model->outputR().begin(), model->outputR().end());
+
+    ASSERT_TRUE(model->setBatchSize(2));
+    ASSERT_EQ(2u, model->batchSize());
+    ASSERT_EQ(inputLength, model->inputLength());
+    ASSERT_EQ(2 * inputLength, model->inputR().size());
+    first.copyTo(*model, /*batchIndex=*/0);
+    second.copyTo(*model, /*batchIndex=*/1);
+    ASSERT_TRUE(model->invoke());
+
+    const size_t outputLength = model->outputLength();
+    ASSERT_EQ(firstR.size(), outputLength);
+    ASSERT_EQ(2 * outputLength, model->outputR().size());
+    for (size_t i = 0; i < outputLength; i++) {
+        EXPECT_THAT(model->outputR()[i], FloatNear(firstR[i], 1e-5));
+        EXPECT_THAT(model->outputR()[outputLength + i], FloatNear(secondR[i], 1e-5));
+    }
+}
+
 } // namespace
 } // namespace android
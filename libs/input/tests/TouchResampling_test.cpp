@@ -17,6 +17,7 @@
 #include "TestHelpers.h"
 
 #include <chrono>
+#include <cmath>
 #include <vector>
 
 #include <attestation/HmacKeyManager.h>
@@ -40,6 +41,14 @@ struct InputEventEntry {
     int32_t action;
 };
 
+// How far behind and how far off a resampled touch is from a known trajectory.
+struct TrajectoryMetrics {
+    // The mean time from the sample time of the last sample of each frame to the frame time.
+    std::chrono::nanoseconds meanLatency;
+    // The root mean square of the distance from the last sample of each frame to the trajectory.
+    float rmsError;
+};
+
 class TouchResamplingTest : public testing::Test {
 protected:
     std::unique_ptr<InputPublisher> mPublisher;
@@ -56,7 +65,7 @@ protected:
 
         mPublisher = std::make_unique<InputPublisher>(std::move(serverChannel));
         mConsumer = std::make_unique<InputConsumer>(std::move(clientChannel),
-                                                    /*enableTouchResampling=*/true);
+                                                    std::make_unique<LinearTouchResampler>());
     }
 
     status_t publishSimpleMotionEventWithCoords(int32_t action, nsecs_t eventTime,
@@ -68,6 +77,8 @@ protected:
     void consumeInputEventEntries(const std::vector<InputEventEntry>& entries,
                                   std::chrono::nanoseconds frameTime);
     void receiveResponseUntilSequence(uint32_t seq);
+    void measureTrajectory(std::unique_ptr<TouchResampler> resampler,
+                           TrajectoryMetrics* outMetrics);
 };
 
 status_t TouchResamplingTest::publishSimpleMotionEventWithCoords(
@@ -202,6 +213,61 @@ void TouchResamplingTest::consumeInputEventEntries(const std::vector<InputEventE
     receiveResponseUntilSequence(consumeSeq);
 }
 
+/**
+ * Publishes the touches of a finger which moves along a sine at 2 Hz, reported at 120 Hz, and
+ * consumes them for the frames of a 60 Hz display with the given resampler.
+ */
+void TouchResamplingTest::measureTrajectory(std::unique_ptr<TouchResampler> resampler,
+                                            TrajectoryMetrics* outMetrics) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    ASSERT_EQ(OK, InputChannel::openInputChannelPair("trajectory", serverChannel, clientChannel));
+    mPublisher = std::make_unique<InputPublisher>(std::move(serverChannel));
+    mConsumer = std::make_unique<InputConsumer>(std::move(clientChannel), std::move(resampler));
+
+    const auto trajectory = [](std::chrono::nanoseconds time) {
+        return 500 + 300 * std::sin(2 * M_PI * 2 * std::chrono::duration<double>(time).count());
+    };
+    const std::chrono::nanoseconds reportInterval = 8333333ns;
+    const std::chrono::nanoseconds frameInterval = 16666667ns;
+
+    publishSimpleMotionEvent(AMOTION_EVENT_ACTION_DOWN, 0, {{0, float(trajectory(0ms)), 100}});
+    consumeInputEventEntries({{0ms, {{0, float(trajectory(0ms)), 100}}, AMOTION_EVENT_ACTION_DOWN}},
+                             0ms);
+
+    std::chrono::nanoseconds nextReportTime = reportInterval;
+    std::chrono::nanoseconds totalLatency = 0ns;
+    double totalSquaredError = 0;
+    int64_t frameCount = 0;
+    for (std::chrono::nanoseconds frameTime = frameInterval + 3ms; frameTime < 1500ms;
+         frameTime += frameInterval) {
+        // The device reports its touches in between the frames.
+        for (; nextReportTime <= frameTime; nextReportTime += reportInterval) {
+            publishSimpleMotionEvent(AMOTION_EVENT_ACTION_MOVE, nextReportTime.count(),
+                                     {{0, float(trajectory(nextReportTime)), 100}});
+        }
+        uint32_t consumeSeq;
+        InputEvent* event;
+        status_t status = mConsumer->consume(&mEventFactory, /*consumeBatches=*/true,
+                                             frameTime.count(), &consumeSeq, &event);
+        if (status == WOULD_BLOCK) {
+            continue;
+        }
+        ASSERT_EQ(OK, status);
+        const MotionEvent& motionEvent = static_cast<const MotionEvent&>(*event);
+        const std::chrono::nanoseconds sampleTime(motionEvent.getEventTime());
+        totalLatency += frameTime - sampleTime;
+        const double error = motionEvent.getX(0) - trajectory(sampleTime);
+        totalSquaredError += error * error;
+        frameCount++;
+
+        ASSERT_EQ(OK, mConsumer->sendFinishedSignal(consumeSeq, true));
+        receiveResponseUntilSequence(consumeSeq);
+    }
+    ASSERT_GT(frameCount, 0);
+    outMetrics->meanLatency = totalLatency / frameCount;
+    outMetrics->rmsError = float(std::sqrt(totalSquaredError / frameCount));
+}
+
 /**
  * Timeline
  * ---------+------------------+------------------+--------+-----------------+----------------------
@@ -574,4 +640,24 @@ TEST_F(TouchResamplingTest, TwoPointersAreResampledIndependently) {
     consumeInputEventEntries(expectedEntries, frameTime);
 }
 
+/**
+ * The quadratic resampler samples the touches closer to the frames than the linear one, and
+ * follows their trajectory at least as closely.
+ */
+TEST_F(TouchResamplingTest, QuadraticResamplingHasLowerLatencyAtEqualError) {
+    TrajectoryMetrics linear;
+    ASSERT_NO_FATAL_FAILURE(measureTrajectory(std::make_unique<LinearTouchResampler>(), &linear));
+    TrajectoryMetrics quadratic;
+    ASSERT_NO_FATAL_FAILURE(
+            measureTrajectory(std::make_unique<QuadraticTouchResampler>(), &quadratic));
+
+    RecordProperty("linearMeanLatencyNs", std::to_string(linear.meanLatency.count()));
+    RecordProperty("linearRmsError", std::to_string(linear.rmsError));
+    RecordProperty("quadraticMeanLatencyNs", std::to_string(quadratic.meanLatency.count()));
+    RecordProperty("quadraticRmsError", std::to_string(quadratic.rmsError));
+
+    ASSERT_LT(quadratic.meanLatency, linear.meanLatency);
+    ASSERT_LE(quadratic.rmsError, linear.rmsError);
+}
+
 } // namespace android
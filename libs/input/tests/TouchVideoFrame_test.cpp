@@ -193,5 +193,57 @@ TEST(TouchVideoFrame, Rotate270_3x2_4times) {
     ASSERT_EQ(frame, frameOriginal);
 }
 
+// --- Copies ---
+
+TEST(TouchVideoFrame, CopiesShareData) {
+    TouchVideoFrame frame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP);
+    TouchVideoFrame copy(frame);
+    ASSERT_EQ(&frame.getData(), &copy.getData());
+}
+
+TEST(TouchVideoFrame, RotatingCopyKeepsOriginal) {
+    TouchVideoFrame frame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP);
+    TouchVideoFrame copy(frame);
+    copy.rotate(ui::ROTATION_180);
+    ASSERT_EQ(TouchVideoFrame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP), frame);
+    ASSERT_EQ(TouchVideoFrame(3, 2, {6, 5, 4, 3, 2, 1}, TIMESTAMP), copy);
+}
+
+// --- Downsample ---
+
+TEST(TouchVideoFrame, Downsample_Factor1) {
+    TouchVideoFrame frame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP);
+    frame.downsample(1);
+    ASSERT_EQ(TouchVideoFrame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP), frame);
+}
+
+TEST(TouchVideoFrame, Downsample_0x0) {
+    TouchVideoFrame frame(0, 0, {}, TIMESTAMP);
+    frame.downsample(2);
+    ASSERT_EQ(TouchVideoFrame(0, 0, {}, TIMESTAMP), frame);
+}
+
+TEST(TouchVideoFrame, Downsample_4x4) {
+    // clang-format off
+    TouchVideoFrame frame(4, 4, {1,  3,  5,  7,
+                                 1,  3,  5,  7,
+                                 -2, -2, 10, 20,
+                                 -2, -2, 30, 40}, TIMESTAMP);
+    // clang-format on
+    frame.downsample(2);
+    ASSERT_EQ(TouchVideoFrame(2, 2, {2, 6, -2, 25}, TIMESTAMP), frame);
+}
+
+TEST(TouchVideoFrame, Downsample_3x5) {
+    // The blocks at the edges average the values that remain.
+    // clang-format off
+    TouchVideoFrame frame(3, 5, {1, 1, 2, 2, 8,
+                                 1, 1, 2, 2, 4,
+                                 4, 6, 9, 9, 7}, TIMESTAMP);
+    // clang-format on
+    frame.downsample(2);
+    ASSERT_EQ(TouchVideoFrame(2, 3, {1, 2, 6, 5, 9, 7}, TIMESTAMP), frame);
+}
+
 } // namespace test
 } // namespace android
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <input/VelocityTracker.h>
+
+#include <cmath>
+
+namespace android {
+
+// Adds movements of a pointer on one axis, and gets its velocity after each of them, like an app
+// which tracks the velocity of a drag. The argument is the VelocityTracker::Strategy.
+static void benchmarkAddMovementAndGetVelocity(benchmark::State& state) {
+    VelocityTracker tracker(static_cast<VelocityTracker::Strategy>(state.range(0)));
+    nsecs_t eventTime = 0;
+    int i = 0;
+    for (auto _ : state) {
+        eventTime += 8 * 1000000;
+        tracker.addMovement(eventTime, /*pointerId=*/0, AMOTION_EVENT_AXIS_X,
+                            500 + 300 * sinf(i++ * 0.05f));
+        benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_X, /*pointerId=*/0));
+    }
+}
+BENCHMARK(benchmarkAddMovementAndGetVelocity)
+        ->ArgName("strategy")
+        ->Arg(static_cast<int>(VelocityTracker::Strategy::LSQ2))
+        ->Arg(static_cast<int>(VelocityTracker::Strategy::LSQ2_INCREMENTAL));
+
+} // namespace android
@@ -286,18 +286,24 @@ static void computeAndCheckAxisScrollVelocity(
 
 static void computeAndCheckQuadraticEstimate(const std::vector<PlanarMotionEventEntry>& motions,
                                              const std::array<float, 3>& coefficients) {
-    VelocityTracker vt(VelocityTracker::Strategy::LSQ2);
-    std::vector<MotionEvent> events = createTouchMotionEventStream(motions);
-    for (MotionEvent event : events) {
-        vt.addMovement(&event);
-    }
-    std::optional<VelocityTracker::Estimator> estimatorX = vt.getEstimator(AMOTION_EVENT_AXIS_X, 0);
-    std::optional<VelocityTracker::Estimator> estimatorY = vt.getEstimator(AMOTION_EVENT_AXIS_Y, 0);
-    EXPECT_TRUE(estimatorX);
-    EXPECT_TRUE(estimatorY);
-    for (size_t i = 0; i< coefficients.size(); i++) {
-        checkCoefficient((*estimatorX).coeff[i], coefficients[i]);
-        checkCoefficient((*estimatorY).coeff[i], coefficients[i]);
+    for (const VelocityTracker::Strategy strategy :
+         {VelocityTracker::Strategy::LSQ2, VelocityTracker::Strategy::LSQ2_INCREMENTAL}) {
+        SCOPED_TRACE(static_cast<int32_t>(strategy));
+        VelocityTracker vt(strategy);
+        std::vector<MotionEvent> events = createTouchMotionEventStream(motions);
+        for (MotionEvent event : events) {
+            vt.addMovement(&event);
+        }
+        std::optional<VelocityTracker::Estimator> estimatorX =
+                vt.getEstimator(AMOTION_EVENT_AXIS_X, 0);
+        std::optional<VelocityTracker::Estimator> estimatorY =
+                vt.getEstimator(AMOTION_EVENT_AXIS_Y, 0);
+        ASSERT_TRUE(estimatorX);
+        ASSERT_TRUE(estimatorY);
+        for (size_t i = 0; i< coefficients.size(); i++) {
+            checkCoefficient((*estimatorX).coeff[i], coefficients[i]);
+            checkCoefficient((*estimatorY).coeff[i], coefficients[i]);
+        }
     }
 }
 
@@ -1271,6 +1277,40 @@ TEST_F(VelocityTrackerTest, LeastSquaresVelocityTrackerStrategyEstimator_Parabol
 }
 
 // Recorded by hand on sailfish, but only the diffs are taken to test cumulative axis velocity.
+/*
+ * The incremental strategy keeps running sums instead of refitting its window each time, and
+ * gives the same velocities as LSQ2 while the window slides over a long gesture.
+ */
+TEST_F(VelocityTrackerTest, IncrementalLeastSquaresMatchesLeastSquares) {
+    VelocityTracker lsq2(VelocityTracker::Strategy::LSQ2);
+    VelocityTracker incremental(VelocityTracker::Strategy::LSQ2_INCREMENTAL);
+    nsecs_t eventTime = 0;
+    for (int i = 0; i < 2000; i++) {
+        SCOPED_TRACE(i);
+        // Irregular intervals, with a pause which stops the pointer every 300 movements.
+        eventTime += (4 + i % 7) * 1000000 + (i % 300 == 299 ? 200 * 1000000 : 0);
+        const float position = 500 + 300 * sinf(i * 0.05f) + i % 5;
+        lsq2.addMovement(eventTime, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, position);
+        incremental.addMovement(eventTime, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, position);
+        if (i % 7 == 0) {
+            // A movement at the same time replaces the previous one.
+            lsq2.addMovement(eventTime, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, position + 1);
+            incremental.addMovement(eventTime, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X,
+                                    position + 1);
+        }
+
+        const std::optional<float> expected =
+                lsq2.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+        const std::optional<float> actual =
+                incremental.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+        ASSERT_EQ(expected.has_value(), actual.has_value());
+        if (expected) {
+            // LSQ2 computes in single precision, with errors of up to about 0.3 px/s here.
+            ASSERT_NEAR(*expected, *actual, 1 + fabsf(*expected) * 0.001);
+        }
+    }
+}
+
 TEST_F(VelocityTrackerTest, AxisScrollVelocity) {
     std::vector<std::pair<std::chrono::nanoseconds, float>> motions = {
             {235089067457000ns, 0.00}, {235089084684000ns, -1.00}, {235089093349000ns, 0.00},
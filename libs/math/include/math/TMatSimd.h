@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <cmath>
+
+/*
+ * No user serviceable parts here.
+ *
+ * Don't use this file directly, instead include math/mat4.h
+ */
+
+// The SIMD code is not constexpr, so it is only enabled where the constant evaluations of the
+// constexpr operators can be told apart, and fall back to the generic code.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define MATH_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MATH_SIMD 1
+#endif
+#endif
+#endif
+
+#ifndef MATH_SIMD
+#define MATH_SIMD 0
+#endif
+
+#if MATH_SIMD
+
+namespace android {
+namespace details {
+namespace simd {
+// -------------------------------------------------------------------------------------
+
+/*
+ * 4x4 float matrix kernels, on 16 floats in column-major order.
+ *
+ * The kernels do the same operations in the same order as the generic code in TMatHelpers.h and
+ * mat4.h, one column at a time, without fused multiply-adds. Results match the generic code
+ * within the rounding of the operations the compiler may contract in the generic code.
+ */
+
+#if defined(__SSE__)
+
+typedef __m128 float4;
+
+inline float4 load(const float* p)          { return _mm_loadu_ps(p); }
+inline void store(float* p, float4 v)       { _mm_storeu_ps(p, v); }
+inline float4 zero()                        { return _mm_setzero_ps(); }
+inline float4 splat(float v)                { return _mm_set1_ps(v); }
+inline float4 add(float4 a, float4 b)       { return _mm_add_ps(a, b); }
+inline float4 sub(float4 a, float4 b)       { return _mm_sub_ps(a, b); }
+inline float4 mul(float4 a, float4 b)       { return _mm_mul_ps(a, b); }
+inline float4 div(float4 a, float4 b)       { return _mm_div_ps(a, b); }
+
+inline void transpose(float4& c0, float4& c1, float4& c2, float4& c3) {
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+}
+
+#else
+
+typedef float32x4_t float4;
+
+inline float4 load(const float* p)          { return vld1q_f32(p); }
+inline void store(float* p, float4 v)       { vst1q_f32(p, v); }
+inline float4 zero()                        { return vdupq_n_f32(0); }
+inline float4 splat(float v)                { return vdupq_n_f32(v); }
+inline float4 add(float4 a, float4 b)       { return vaddq_f32(a, b); }
+inline float4 sub(float4 a, float4 b)       { return vsubq_f32(a, b); }
+inline float4 mul(float4 a, float4 b)       { return vmulq_f32(a, b); }
+inline float4 div(float4 a, float4 b)       { return vdivq_f32(a, b); }
+
+inline void transpose(float4& c0, float4& c1, float4& c2, float4& c3) {
+    const float32x4x2_t t01 = vtrnq_f32(c0, c1);
+    const float32x4x2_t t23 = vtrnq_f32(c2, c3);
+    c0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    c1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    c2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    c3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#endif
+
+// out = lhs * rhs, where rhs has the given number of columns (4 for a matrix, 1 for a vector).
+// Each column of the result is accumulated from zero, like TMat44's operator*(mat, vec).
+inline void multiply(const float* lhs, const float* rhs, float* out, size_t columns) {
+    const float4 l0 = load(lhs);
+    const float4 l1 = load(lhs + 4);
+    const float4 l2 = load(lhs + 8);
+    const float4 l3 = load(lhs + 12);
+    for (size_t col = 0; col < columns; ++col, rhs += 4, out += 4) {
+        float4 r = zero();
+        r = add(r, mul(l0, splat(rhs[0])));
+        r = add(r, mul(l1, splat(rhs[1])));
+        r = add(r, mul(l2, splat(rhs[2])));
+        r = add(r, mul(l3, splat(rhs[3])));
+        store(out, r);
+    }
+}
+
+inline void transpose(const float* m, float* out) {
+    float4 c0 = load(m);
+    float4 c1 = load(m + 4);
+    float4 c2 = load(m + 8);
+    float4 c3 = load(m + 12);
+    transpose(c0, c1, c2, c3);
+    store(out, c0);
+    store(out + 4, c1);
+    store(out + 8, c2);
+    store(out + 12, c3);
+}
+
+// matrix::gaussJordanInverse() for a 4x4 matrix, whose row operations are done on whole columns.
+inline void inverse(const float* m, float* out) {
+    float tmp[16];
+    for (size_t col = 0; col < 4; ++col) {
+        store(tmp + col * 4, load(m + col * 4));
+        store(out + col * 4, zero());
+        out[col * 4 + col] = 1;
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        // look for largest element in i'th column
+        size_t swap = i;
+        float t = std::abs(tmp[i * 4 + i]);
+        for (size_t j = i + 1; j < 4; ++j) {
+            const float t2 = std::abs(tmp[j * 4 + i]);
+            if (t2 > t) {
+                swap = j;
+                t = t2;
+            }
+        }
+
+        const float4 denom = splat(tmp[swap * 4 + i]);
+        float4 ti = load(tmp + swap * 4);
+        float4 ii = load(out + swap * 4);
+        if (swap != i) {
+            // swap columns.
+            store(tmp + swap * 4, load(tmp + i * 4));
+            store(out + swap * 4, load(out + i * 4));
+        }
+
+        ti = div(ti, denom);
+        ii = div(ii, denom);
+        store(tmp + i * 4, ti);
+        store(out + i * 4, ii);
+
+        // Factor out the lower triangle
+        for (size_t j = 0; j < 4; ++j) {
+            if (j != i) {
+                const float4 d = splat(tmp[j * 4 + i]);
+                store(tmp + j * 4, sub(load(tmp + j * 4), mul(ti, d)));
+                store(out + j * 4, sub(load(out + j * 4), mul(ii, d)));
+            }
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------
+}  // namespace simd
+}  // namespace details
+}  // namespace android
+
+#endif  // MATH_SIMD
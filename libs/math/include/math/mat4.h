@@ -19,6 +19,7 @@
 #include <math/mat3.h>
 #include <math/quat.h>
 #include <math/TMatHelpers.h>
+#include <math/TMatSimd.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 
@@ -561,6 +562,72 @@ operator *(U lhs, const TMat44<T>& rhs) {
     return rhs * lhs;
 }
 
+// ----------------------------------------------------------------------------------------
+// SIMD specializations for mat4
+// ----------------------------------------------------------------------------------------
+
+#if MATH_SIMD
+
+/* The SIMD kernels are not constexpr, so constant evaluations use the same loops as the generic
+ * code instead.
+ */
+
+template <>
+inline CONSTEXPR TMat44<float>::col_type PURE operator *(
+        const TMat44<float>& lhs, const TVec4<float>& rhs) {
+    TMat44<float>::col_type result;
+    if (__builtin_is_constant_evaluated()) {
+        for (size_t col = 0; col < TMat44<float>::NUM_COLS; ++col) {
+            result += lhs[col] * rhs[col];
+        }
+    } else {
+        simd::multiply(lhs.asArray(), &rhs[0], &result[0], 1);
+    }
+    return result;
+}
+
+namespace matrix {
+
+template <>
+inline CONSTEXPR TMat44<float> PURE multiply<TMat44<float>>(
+        const TMat44<float>& lhs, const TMat44<float>& rhs) {
+    TMat44<float> res(TMat44<float>::NO_INIT);
+    if (__builtin_is_constant_evaluated()) {
+        for (size_t col = 0; col < TMat44<float>::NUM_COLS; ++col) {
+            res[col] = lhs * rhs[col];
+        }
+    } else {
+        simd::multiply(lhs.asArray(), rhs.asArray(), &res[0][0], TMat44<float>::NUM_COLS);
+    }
+    return res;
+}
+
+template <>
+inline CONSTEXPR TMat44<float> PURE transpose<TMat44<float>>(const TMat44<float>& m) {
+    TMat44<float> result(TMat44<float>::NO_INIT);
+    if (__builtin_is_constant_evaluated()) {
+        for (size_t col = 0; col < TMat44<float>::NUM_COLS; ++col) {
+            for (size_t row = 0; row < TMat44<float>::NUM_ROWS; ++row) {
+                result[col][row] = m[row][col];
+            }
+        }
+    } else {
+        simd::transpose(m.asArray(), &result[0][0]);
+    }
+    return result;
+}
+
+template <>
+inline TMat44<float> PURE gaussJordanInverse<TMat44<float>>(const TMat44<float>& src) {
+    TMat44<float> inverted(TMat44<float>::NO_INIT);
+    simd::inverse(src.asArray(), &inverted[0][0]);
+    return inverted;
+}
+
+}  // namespace matrix
+
+#endif  // MATH_SIMD
+
 // ----------------------------------------------------------------------------------------
 
 /* FIXME: this should go into TMatSquareFunctions<> but for some reason
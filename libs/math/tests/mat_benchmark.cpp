@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math/mat4.h>
+
+namespace android {
+namespace {
+
+// A color transform like the ones RenderEngine concatenates, which is invertible.
+mat4 makeMatrix(float offset) {
+    return mat4(1.10f + offset, 0.02f, -0.05f, 0.0f,
+                0.03f, 0.95f + offset, 0.01f, 0.0f,
+                -0.04f, 0.06f, 1.05f + offset, 0.0f,
+                0.10f, -0.20f, 0.05f, 1.0f);
+}
+
+void BM_Mat4Multiply(benchmark::State& state) {
+    mat4 lhs = makeMatrix(0.0f);
+    const mat4 rhs = makeMatrix(0.1f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs);
+        mat4 result = lhs * rhs;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_Mat4Multiply);
+
+void BM_Mat4MultiplyVec4(benchmark::State& state) {
+    mat4 matrix = makeMatrix(0.0f);
+    const vec4 vector(0.25f, 0.5f, 0.75f, 1.0f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix);
+        vec4 result = matrix * vector;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_Mat4MultiplyVec4);
+
+void BM_Mat4Inverse(benchmark::State& state) {
+    mat4 matrix = makeMatrix(0.0f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix);
+        mat4 result = inverse(matrix);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_Mat4Inverse);
+
+void BM_Mat4Transpose(benchmark::State& state) {
+    mat4 matrix = makeMatrix(0.0f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix);
+        mat4 result = transpose(matrix);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_Mat4Transpose);
+
+}  // namespace
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -163,6 +163,53 @@ TEST_F(MatTest, ElementAccess) {
     EXPECT_FLOAT_EQ(m(3, 2), 100);
 }
 
+// mat4 may have SIMD specializations, which must match the generic code used for mat4d.
+TEST_F(MatTest, MatchesGeneric) {
+    const mat4 m1(vec4(1.1f, 0.2f, -0.3f, 0.4f), vec4(0.5f, -1.6f, 0.7f, 0.8f),
+                  vec4(-0.9f, 1.1f, 1.2f, -0.3f), vec4(0.1f, 0.2f, 0.3f, 1.4f));
+    const mat4 m2(vec4(0.3f, -0.1f, 0.2f, 0.f), vec4(0.7f, 0.9f, -0.4f, 0.f),
+                  vec4(0.1f, 0.5f, 1.3f, 0.f), vec4(-2.f, 3.f, 0.5f, 1.f));
+    const vec4 v(0.25f, -0.5f, 0.75f, 1.f);
+
+    const mat4 product(mat4d(m1) * mat4d(m2));
+    const vec4 vecProduct(mat4d(m1) * double4(v));
+    mat4 m3 = m1;
+    m3 *= m2;
+    for (size_t c = 0; c < 4; ++c) {
+        for (size_t r = 0; r < 4; ++r) {
+            EXPECT_NEAR(product[c][r], (m1 * m2)[c][r], 1e-6);
+            EXPECT_NEAR(product[c][r], m3[c][r], 1e-6);
+            EXPECT_EQ(m1[r][c], transpose(m1)[c][r]);
+        }
+        EXPECT_NEAR(vecProduct[c], (m1 * v)[c], 1e-6);
+    }
+
+    std::default_random_engine engine(0);
+    std::uniform_real_distribution<double> distribution(-10, 10);
+    for (int i = 0; i < 100; ++i) {
+        // Swap the columns so that the pivots of the inverse are in any order.
+        mat4d md;
+        for (size_t c = 0; c < 4; ++c) {
+            for (size_t r = 0; r < 4; ++r) {
+                md[c][r] = static_cast<float>(distribution(engine));
+            }
+        }
+        std::swap(md[0], md[i % 4]);
+
+        const mat4 m(md);
+        const mat4 expected(inverse(md));
+        const mat4 actual = inverse(m);
+        const mat4 identity = m * actual;
+        for (size_t c = 0; c < 4; ++c) {
+            for (size_t r = 0; r < 4; ++r) {
+                EXPECT_NEAR(expected[c][r], actual[c][r],
+                            1e-4 * std::max(1.f, std::abs(expected[c][r])));
+                EXPECT_NEAR(c == r ? 1.f : 0.f, identity[c][r], 1e-4);
+            }
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 // MAT 3
 //------------------------------------------------------------------------------
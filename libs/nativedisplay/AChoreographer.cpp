@@ -129,6 +129,21 @@ int64_t AChoreographer_getFrameInterval(const AChoreographer* choreographer) {
     return AChoreographer_to_Choreographer(choreographer)->getFrameInterval();
 }
 
+void AChoreographer_postVsyncCallbackWithCost(AChoreographer* choreographer,
+                                              AChoreographer_vsyncCallback callback, void* data,
+                                              int64_t expectedCostNanos, bool deferrable) {
+    AChoreographer_to_Choreographer(choreographer)
+            ->postVsyncCallback(callback, data, expectedCostNanos, deferrable);
+}
+
+uint64_t AChoreographer_getDeadlineOverrunCount(const AChoreographer* choreographer) {
+    return AChoreographer_to_Choreographer(choreographer)->getDeadlineOverrunCount();
+}
+
+uint64_t AChoreographer_getDeferredCallbackCount(const AChoreographer* choreographer) {
+    return AChoreographer_to_Choreographer(choreographer)->getDeferredCallbackCount();
+}
+
 int64_t AChoreographer_getStartTimeNanosForVsyncId(AVsyncId vsyncId) {
     return Choreographer::getStartTimeNanosForVsyncId(vsyncId);
 }
@@ -34,6 +34,19 @@ void AChoreographer_signalRefreshRateCallbacks(int64_t vsyncPeriod);
 // Calling this function from anywhere else will return an undefined value.
 int64_t AChoreographer_getFrameInterval(const AChoreographer* choreographer);
 
+// Posts a vsync callback that declares how long it runs for. Callbacks that are deferrable run
+// after the other callbacks of their frame, and are given a later frame timeline than the
+// preferred one when they would miss its deadline.
+void AChoreographer_postVsyncCallbackWithCost(AChoreographer* choreographer,
+                                              AChoreographer_vsyncCallback callback, void* data,
+                                              int64_t expectedCostNanos, bool deferrable);
+
+// Returns the number of vsync callbacks that returned after the deadline of their frame timeline.
+uint64_t AChoreographer_getDeadlineOverrunCount(const AChoreographer* choreographer);
+
+// Returns the number of deferrable vsync callbacks that were given a later frame timeline.
+uint64_t AChoreographer_getDeferredCallbackCount(const AChoreographer* choreographer);
+
 // Trampoline functions allowing libandroid.so to define the NDK symbols without including
 // the entirety of libnativedisplay as a whole static lib. As libnativedisplay
 // maintains global state, libnativedisplay can never be directly statically
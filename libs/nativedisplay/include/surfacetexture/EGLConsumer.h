@@ -22,6 +22,9 @@
 #include <ui/FenceTime.h>
 #include <ui/GraphicBuffer.h>
 #include <utils/Mutex.h>
+#include <utils/String8.h>
+
+#include <unordered_map>
 
 namespace android {
 
@@ -101,16 +104,23 @@ public:
     /**
      * onFreeBufferLocked frees up the given buffer slot. If the slot has been
      * initialized this will release the reference to the GraphicBuffer in that
-     * slot and destroy the EGLImage in that slot.  Otherwise it has no effect.
+     * slot and to its EGLImage, which is only destroyed once it is evicted from
+     * the EGLImage cache.  Otherwise it has no effect.
      */
     void onFreeBufferLocked(int slotIndex);
 
     /**
      * onAbandonLocked amends the ConsumerBase method to clear
-     * mCurrentTextureImage in addition to the ConsumerBase behavior.
+     * mCurrentTextureImage and the EGLImage cache in addition to the
+     * ConsumerBase behavior.
      */
     void onAbandonLocked();
 
+    /**
+     * dumpLocked appends the EGLImage cache stats to the SurfaceTexture dump.
+     */
+    void dumpLocked(String8& result, const char* prefix) const;
+
 protected:
     struct PendingRelease {
         PendingRelease()
@@ -210,6 +220,12 @@ protected:
         Rect mCropRect;
     };
 
+    /**
+     * getEglImageLocked returns the cached EglImage of the buffer, or a new
+     * one that is added to the cache.
+     */
+    sp<EglImage> getEglImageLocked(const sp<GraphicBuffer>& graphicBuffer);
+
     /**
      * doGLFenceWaitLocked inserts a wait command into the OpenGL ES command
      * stream to ensure that it is safe for future OpenGL ES commands to
@@ -293,6 +309,29 @@ protected:
      */
     EglSlot mEglSlots[BufferQueueDefs::NUM_BUFFER_SLOTS];
 
+    /**
+     * mEglImageCache keeps the EglImages of the most recently acquired buffers
+     * by buffer id, so that a buffer that comes back in another slot or after
+     * the producer reconnects, e.g. a video decoder after a seek or a resolution
+     * toggle, reuses its EGLImage instead of creating a new one. The cache holds
+     * a reference to the buffers, so it is bounded to kEglImageCacheSize images
+     * and evicts the least recently used one. It is cleared on abandonment.
+     */
+    struct CachedEglImage {
+        sp<EglImage> image;
+        uint64_t lastUse;
+    };
+    static constexpr size_t kEglImageCacheSize = 32;
+    std::unordered_map<uint64_t, CachedEglImage> mEglImageCache;
+    uint64_t mEglImageCacheUses = 0;
+
+    struct EglImageCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+    EglImageCacheStats mEglImageCacheStats;
+
     /**
      * protects static initialization
      */
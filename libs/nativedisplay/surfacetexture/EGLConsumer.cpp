@@ -32,6 +32,8 @@
 #include <utils/String8.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+
 #define PROT_CONTENT_EXT_STR "EGL_EXT_protected_content"
 #define EGL_PROTECTED_CONTENT_EXT 0x32C0
 
@@ -217,8 +219,32 @@ void EGLConsumer::onAcquireBufferLocked(BufferItem* item, SurfaceTexture& st) {
     // replaces any old EglImage with a new one (using the new buffer).
     int slot = item->mSlot;
     if (item->mGraphicBuffer != nullptr || mEglSlots[slot].mEglImage.get() == nullptr) {
-        mEglSlots[slot].mEglImage = new EglImage(st.mSlots[slot].mGraphicBuffer);
+        mEglSlots[slot].mEglImage = getEglImageLocked(st.mSlots[slot].mGraphicBuffer);
+    }
+}
+
+sp<EGLConsumer::EglImage> EGLConsumer::getEglImageLocked(const sp<GraphicBuffer>& graphicBuffer) {
+    const uint64_t id = graphicBuffer->getId();
+    if (const auto it = mEglImageCache.find(id); it != mEglImageCache.end()) {
+        mEglImageCacheStats.hits++;
+        it->second.lastUse = ++mEglImageCacheUses;
+        return it->second.image;
+    }
+    mEglImageCacheStats.misses++;
+
+    if (mEglImageCache.size() >= kEglImageCacheSize) {
+        const auto lru = std::min_element(mEglImageCache.begin(), mEglImageCache.end(),
+                                          [](const auto& lhs, const auto& rhs) {
+                                              return lhs.second.lastUse < rhs.second.lastUse;
+                                          });
+        // The slots that still use the image keep it alive.
+        mEglImageCache.erase(lru);
+        mEglImageCacheStats.evictions++;
     }
+
+    sp<EglImage> image = new EglImage(graphicBuffer);
+    mEglImageCache.emplace(id, CachedEglImage{image, ++mEglImageCacheUses});
+    return image;
 }
 
 void EGLConsumer::onReleaseBufferLocked(int buf) {
@@ -434,7 +460,7 @@ status_t EGLConsumer::attachToContext(uint32_t tex, SurfaceTexture& st) {
     int slot = st.mCurrentTexture;
     if (slot != BufferItem::INVALID_BUFFER_SLOT) {
         if (!mEglSlots[slot].mEglImage.get()) {
-            mEglSlots[slot].mEglImage = new EglImage(st.mSlots[slot].mGraphicBuffer);
+            mEglSlots[slot].mEglImage = getEglImageLocked(st.mSlots[slot].mGraphicBuffer);
         }
         mCurrentTextureImage = mEglSlots[slot].mEglImage;
     }
@@ -602,6 +628,15 @@ void EGLConsumer::onFreeBufferLocked(int slotIndex) {
 
 void EGLConsumer::onAbandonLocked() {
     mCurrentTextureImage.clear();
+    mEglImageCache.clear();
+}
+
+void EGLConsumer::dumpLocked(String8& result, const char* prefix) const {
+    result.appendFormat("%sEGLImage cache: size=%zu/%zu hits=%" PRIu64 " misses=%" PRIu64
+                        " evictions=%" PRIu64 "\n",
+                        prefix, mEglImageCache.size(), kEglImageCacheSize,
+                        mEglImageCacheStats.hits, mEglImageCacheStats.misses,
+                        mEglImageCacheStats.evictions);
 }
 
 EGLConsumer::EglImage::EglImage(sp<GraphicBuffer> graphicBuffer)
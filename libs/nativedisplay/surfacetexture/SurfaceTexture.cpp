@@ -459,6 +459,7 @@ void SurfaceTexture::dumpLocked(String8& result, const char* prefix) const {
                         prefix, mTexName, mCurrentTexture, prefix, mCurrentCrop.left,
                         mCurrentCrop.top, mCurrentCrop.right, mCurrentCrop.bottom,
                         mCurrentTransform);
+    mEGLConsumer.dumpLocked(result, prefix);
 
     ConsumerBase::dumpLocked(result, prefix);
 }
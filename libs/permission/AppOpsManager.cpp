@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <bitset>
+#include <map>
 #include <mutex>
+#include <optional>
+#include <tuple>
 #include <binder/AppOpsManager.h>
 #include <binder/Binder.h>
 #include <binder/IServiceManager.h>
@@ -43,10 +47,109 @@ static const sp<IBinder>& getClientId() {
     return gClientId;
 }
 
-AppOpsManager::AppOpsManager()
+// Modes returned by checkOperation(), per (op, uid, package).
+//
+// The cache registers itself as the mode watcher of each op before caching its modes, with
+// WATCH_FOREGROUND_CHANGES as MODE_FOREGROUND ops depend on the state of the uid. The service
+// reports the changes under the switch op, which may group several ops, so any change clears
+// the whole cache: changes are rare compared to the checks.
+class AppOpsManager::ModeCache : public BnAppOpsCallback {
+public:
+    // Enough for the packages of the running apps, for the few ops a service checks.
+    static constexpr size_t kMaxEntries = 256;
+
+    std::optional<int32_t> get(int32_t op, int32_t uid, const String16& packageName) {
+        std::lock_guard<std::mutex> lock(mLock);
+        const auto it = mModes.find(Key(op, uid, packageName));
+        if (it == mModes.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    // Returns the generation to pass to put() when the mode from the service is received.
+    uint64_t getGeneration() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mGeneration;
+    }
+
+    // Caches the mode, unless the op is not watched or changes were reported since the
+    // generation was read, in which case the mode may already be stale.
+    void put(int32_t op, int32_t uid, const String16& packageName, int32_t mode,
+             uint64_t generation) {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (generation != mGeneration || !mWatchedOps.test(op)) {
+            return;
+        }
+        if (mModes.size() >= kMaxEntries) {
+            mModes.clear();
+        }
+        mModes[Key(op, uid, packageName)] = mode;
+    }
+
+    bool isWatching(int32_t op) {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mWatchedOps.test(op);
+    }
+
+    bool isWatchingAny() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mWatchedOps.any();
+    }
+
+    void setWatching(int32_t op) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mWatchedOps.set(op);
+    }
+
+    // Called when the service changed, which does not know about the previous watchers.
+    void reset() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mWatchedOps.reset();
+        clearLocked();
+    }
+
+    void opChanged(int32_t /*op*/, const String16& /*packageName*/) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        clearLocked();
+    }
+
+private:
+    using Key = std::tuple<int32_t, int32_t, String16>;
+
+    void clearLocked() {
+        mModes.clear();
+        mGeneration++;
+    }
+
+    std::mutex mLock;
+    std::map<Key, int32_t> mModes;
+    std::bitset<AppOpsManager::_NUM_OP> mWatchedOps;
+    uint64_t mGeneration = 0;
+};
+
+AppOpsManager::AppOpsManager(bool cacheModes)
+      : mModeCache(cacheModes ? sp<ModeCache>::make() : nullptr)
+{
+}
+
+AppOpsManager::AppOpsManager(const sp<IAppOpsService>& service, bool cacheModes)
+      : mService(service), mModeCache(cacheModes ? sp<ModeCache>::make() : nullptr)
 {
 }
 
+AppOpsManager::~AppOpsManager()
+{
+    if (mModeCache == nullptr || !mModeCache->isWatchingAny()) {
+        return;
+    }
+    // Without getService(), which may wait for the service.
+    std::lock_guard<Mutex> scoped_lock(mLock);
+    if (mService != nullptr && IInterface::asBinder(mService)->isBinderAlive()) {
+        mService->stopWatchingMode(mModeCache);
+    }
+}
+
 sp<IAppOpsService> AppOpsManager::getService()
 {
     static String16 _appops("appops");
@@ -70,6 +173,9 @@ sp<IAppOpsService> AppOpsManager::getService()
         } else {
             service = interface_cast<IAppOpsService>(binder);
             mService = service;
+            if (mModeCache != nullptr) {
+                mModeCache->reset();
+            }
         }
     }
     return service;
@@ -78,9 +184,26 @@ sp<IAppOpsService> AppOpsManager::getService()
 int32_t AppOpsManager::checkOp(int32_t op, int32_t uid, const String16& callingPackage)
 {
     sp<IAppOpsService> service = getService();
-    return service != nullptr
-            ? service->checkOperation(op, uid, callingPackage)
-            : AppOpsManager::MODE_IGNORED;
+    if (service == nullptr) {
+        return AppOpsManager::MODE_IGNORED;
+    }
+    if (mModeCache == nullptr || op < 0 || op >= AppOpsManager::_NUM_OP) {
+        return service->checkOperation(op, uid, callingPackage);
+    }
+
+    if (const std::optional<int32_t> mode = mModeCache->get(op, uid, callingPackage)) {
+        return *mode;
+    }
+    if (!mModeCache->isWatching(op)) {
+        // Concurrent registrations of the same callback are harmless.
+        service->startWatchingModeWithFlags(op, String16(), WATCH_FOREGROUND_CHANGES,
+                                            mModeCache);
+        mModeCache->setWatching(op);
+    }
+    const uint64_t generation = mModeCache->getGeneration();
+    const int32_t mode = service->checkOperation(op, uid, callingPackage);
+    mModeCache->put(op, uid, callingPackage, mode, generation);
+    return mode;
 }
 
 int32_t AppOpsManager::checkAudioOpNoThrow(int32_t op, int32_t usage, int32_t uid,
@@ -155,7 +155,13 @@ public:
         WATCH_FOREGROUND_CHANGES = 1 << 0
     };
 
-    AppOpsManager();
+    // If cacheModes is set, the modes returned by checkOp() are cached until the app ops
+    // service reports a mode change through an IAppOpsCallback. As the callback needs a binder
+    // thread, this is only for processes with a binder thread pool.
+    explicit AppOpsManager(bool cacheModes = false);
+    // Uses the given service rather than the "appops" service, e.g. for benchmarks.
+    AppOpsManager(const sp<IAppOpsService>& service, bool cacheModes);
+    ~AppOpsManager();
 
     int32_t checkOp(int32_t op, int32_t uid, const String16& callingPackage);
     int32_t checkAudioOpNoThrow(int32_t op, int32_t usage, int32_t uid,
@@ -185,8 +191,12 @@ public:
     void setCameraAudioRestriction(int32_t mode);
 
 private:
+    class ModeCache;
+
     Mutex mLock;
     sp<IAppOpsService> mService;
+    // Null unless cacheModes is set.
+    const sp<ModeCache> mModeCache;
 
     sp<IAppOpsService> getService();
     bool shouldCollectNotes(int32_t opCode);
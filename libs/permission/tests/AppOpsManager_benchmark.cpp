@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <binder/AppOpsManager.h>
+#include <utils/String8.h>
+
+#include <atomic>
+#include <vector>
+
+namespace android {
+namespace {
+
+// Counts the calls that would be binder transactions to the app ops service.
+class FakeAppOpsService : public BnAppOpsService {
+public:
+    size_t getCallCount() const { return mCallCount; }
+
+    sp<IAppOpsCallback> getWatcher() const { return mWatcher; }
+
+    int32_t checkOperation(int32_t, int32_t, const String16&) override {
+        mCallCount++;
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    int32_t noteOperation(int32_t, int32_t, const String16&, const std::optional<String16>&,
+                          bool, const String16&, bool) override {
+        mCallCount++;
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    int32_t startOperation(const sp<IBinder>&, int32_t, int32_t, const String16&,
+                           const std::optional<String16>&, bool, bool, const String16&,
+                           bool) override {
+        mCallCount++;
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    void finishOperation(const sp<IBinder>&, int32_t, int32_t, const String16&,
+                         const std::optional<String16>&) override {
+        mCallCount++;
+    }
+    void startWatchingMode(int32_t, const String16&, const sp<IAppOpsCallback>& callback) override {
+        mCallCount++;
+        mWatcher = callback;
+    }
+    void stopWatchingMode(const sp<IAppOpsCallback>&) override {
+        mCallCount++;
+        mWatcher = nullptr;
+    }
+    int32_t permissionToOpCode(const String16&) override {
+        mCallCount++;
+        return AppOpsManager::OP_NONE;
+    }
+    int32_t checkAudioOperation(int32_t, int32_t, int32_t, const String16&) override {
+        mCallCount++;
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    void setCameraAudioRestriction(int32_t) override { mCallCount++; }
+    bool shouldCollectNotes(int32_t) override {
+        mCallCount++;
+        return false;
+    }
+    void startWatchingModeWithFlags(int32_t, const String16&, int32_t,
+                                    const sp<IAppOpsCallback>& callback) override {
+        mCallCount++;
+        mWatcher = callback;
+    }
+
+private:
+    std::atomic<size_t> mCallCount = 0;
+    sp<IAppOpsCallback> mWatcher;
+};
+
+// The access checks of SensorService::canAccessSensor() as apps register listeners for body and
+// activity recognition sensors. Reports the app ops service calls per check, with a mode change
+// every range(1) checks, or none if 0.
+void BM_SensorAccessChecks(benchmark::State& state) {
+    const bool cacheModes = state.range(0);
+    const int64_t modeChangePeriod = state.range(1);
+
+    const sp<FakeAppOpsService> service = sp<FakeAppOpsService>::make();
+    AppOpsManager appOps(service, cacheModes);
+
+    constexpr int32_t kAppCount = 16;
+    std::vector<String16> packages;
+    for (int32_t i = 0; i < kAppCount; i++) {
+        packages.push_back(String16(String8::format("com.example.app%d", i)));
+    }
+    const int32_t ops[] = {AppOpsManager::OP_BODY_SENSORS, AppOpsManager::OP_ACTIVITY_RECOGNITION};
+
+    int64_t checks = 0;
+    for (auto _ : state) {
+        const int32_t app = static_cast<int32_t>(checks % kAppCount);
+        const int32_t op = ops[(checks / kAppCount) % 2];
+        benchmark::DoNotOptimize(appOps.checkOp(op, 10000 + app, packages[app]));
+
+        checks++;
+        if (modeChangePeriod > 0 && checks % modeChangePeriod == 0 &&
+            service->getWatcher() != nullptr) {
+            service->getWatcher()->opChanged(op, packages[app]);
+        }
+    }
+    state.counters["binderCalls"] =
+            benchmark::Counter(static_cast<double>(service->getCallCount()),
+                               benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SensorAccessChecks)
+        ->ArgNames({"cached", "modeChangePeriod"})
+        ->Args({false, 0})
+        ->Args({true, 0})
+        ->Args({true, 1000})
+        ->Args({true, 100});
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
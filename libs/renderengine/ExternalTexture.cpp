@@ -27,6 +27,10 @@ ExternalTexture::ExternalTexture(const sp<GraphicBuffer>& buffer,
       : mBuffer(buffer), mRenderEngine(renderEngine), mWritable(usage & WRITEABLE) {
     LOG_ALWAYS_FATAL_IF(buffer == nullptr,
                         "Attempted to bind a null buffer to an external texture!");
+    if (usage & DEFER_MAPPING) {
+        return;
+    }
+    mMapped = true;
     // GLESRenderEngine has a separate texture cache for output buffers,
     if (usage == WRITEABLE &&
         (mRenderEngine.getRenderEngineType() ==
@@ -39,11 +43,17 @@ ExternalTexture::ExternalTexture(const sp<GraphicBuffer>& buffer,
 }
 
 ExternalTexture::~ExternalTexture() {
-    mRenderEngine.unmapExternalTextureBuffer(std::move(mBuffer));
+    if (mMapped) {
+        mRenderEngine.unmapExternalTextureBuffer(std::move(mBuffer));
+    }
 }
 
 void ExternalTexture::remapBuffer() {
     ATRACE_CALL();
+    if (!mMapped) {
+        // The buffer will be mapped when it is first drawn.
+        return;
+    }
     {
         auto buf = mBuffer;
         mRenderEngine.unmapExternalTextureBuffer(std::move(buf));
@@ -51,4 +61,18 @@ void ExternalTexture::remapBuffer() {
     mRenderEngine.mapExternalTextureBuffer(mBuffer, mWritable);
 }
 
+bool ExternalTexture::mapDeferred() {
+    if (mMapped) {
+        return false;
+    }
+    bool mapped = false;
+    std::call_once(mDeferredMapping, [&] {
+        ATRACE_NAME("ExternalTexture::mapDeferred");
+        mRenderEngine.mapExternalTextureBuffer(mBuffer, mWritable);
+        mMapped = true;
+        mapped = true;
+    });
+    return mapped;
+}
+
 } // namespace android::renderengine::impl
@@ -43,14 +43,28 @@ std::unique_ptr<RenderEngine> RenderEngine::create(const RenderEngineCreationArg
             return renderengine::skia::SkiaVkRenderEngine::create(args);
         case RenderEngineType::SKIA_GL_THREADED: {
             ALOGD("Threaded RenderEngine with SkiaGL Backend");
+            renderengine::threaded::CreateInstanceFactory backgroundFactory;
+            if (args.enableBackgroundContext) {
+                ALOGD("Drawing deferrable work on a background SkiaGL context");
+                auto backgroundArgs = args;
+                backgroundArgs.contextPriority = ContextPriority::LOW;
+                backgroundArgs.enableBackgroundContext = false;
+                backgroundArgs.isBackgroundContext = true;
+                backgroundFactory = [backgroundArgs]() {
+                    return android::renderengine::skia::SkiaGLRenderEngine::create(backgroundArgs);
+                };
+            }
             return renderengine::threaded::RenderEngineThreaded::create(
                     [args]() {
                         return android::renderengine::skia::SkiaGLRenderEngine::create(args);
                     },
-                    args.renderEngineType);
+                    args.renderEngineType, std::move(backgroundFactory));
         }
         case RenderEngineType::SKIA_VK_THREADED:
             ALOGD("Threaded RenderEngine with SkiaVK Backend");
+            // All SkiaVk contexts submit to the same VkQueue, which is not thread-safe.
+            ALOGW_IF(args.enableBackgroundContext,
+                     "Background context is not supported with the SkiaVK Backend");
             return renderengine::threaded::RenderEngineThreaded::create(
                     [args]() {
                         return android::renderengine::skia::SkiaVkRenderEngine::create(args);
@@ -82,6 +96,7 @@ ftl::Future<FenceResult> RenderEngine::drawLayers(const DisplaySettings& display
                                                   base::unique_fd&& bufferFence) {
     const auto resultPromise = std::make_shared<std::promise<FenceResult>>();
     std::future<FenceResult> resultFuture = resultPromise->get_future();
+    mapDeferredTextures(layers);
     updateProtectedContext(layers, buffer);
     drawLayersInternal(std::move(resultPromise), display, layers, buffer, useFramebufferCache,
                        std::move(bufferFence));
@@ -99,5 +114,13 @@ void RenderEngine::updateProtectedContext(const std::vector<LayerSettings>& laye
     useProtectedContext(needsProtectedContext);
 }
 
+void RenderEngine::mapDeferredTextures(const std::vector<LayerSettings>& layers) {
+    for (const auto& layer : layers) {
+        if (const auto& buffer = layer.source.buffer.buffer) {
+            buffer->ensureMapped();
+        }
+    }
+}
+
 } // namespace renderengine
 } // namespace android
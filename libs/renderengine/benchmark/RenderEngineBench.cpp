@@ -16,6 +16,7 @@
 
 #include <RenderEngineBench.h>
 #include <android-base/file.h>
+#include <android-base/properties.h>
 #include <benchmark/benchmark.h>
 #include <gui/SurfaceComposerClient.h>
 #include <log/log.h>
@@ -23,8 +24,14 @@
 #include <renderengine/LayerSettings.h>
 #include <renderengine/RenderEngine.h>
 #include <renderengine/impl/ExternalTexture.h>
+#include <utils/Timers.h>
 
+#include <algorithm>
+#include <fstream>
 #include <mutex>
+#include <string>
+
+#include "../skia/SkiaVkRenderEngine.h"
 
 using namespace android;
 using namespace android::renderengine;
@@ -51,7 +58,7 @@ std::string RenderEngineTypeName(RenderEngine::RenderEngineType type) {
 }
 
 /**
- * Passed (indirectly - see RunSkiaGLThreaded) to Benchmark::Apply to create a
+ * Passed (indirectly - see RunSkiaThreaded) to Benchmark::Apply to create a
  * Benchmark which specifies which RenderEngineType it uses.
  *
  * This simplifies calling ->Arg(type)->Arg(type) and provides strings to make
@@ -67,10 +74,12 @@ static void AddRenderEngineType(benchmark::internal::Benchmark* b,
 }
 
 /**
- * Run a benchmark once using SKIA_GL_THREADED.
+ * Run a benchmark once using SKIA_GL_THREADED, then once using SKIA_VK_THREADED, so that
+ * regressions of either backend show up in the results.
  */
-static void RunSkiaGLThreaded(benchmark::internal::Benchmark* b) {
+static void RunSkiaThreaded(benchmark::internal::Benchmark* b) {
     AddRenderEngineType(b, RenderEngine::RenderEngineType::SKIA_GL_THREADED);
+    AddRenderEngineType(b, RenderEngine::RenderEngineType::SKIA_VK_THREADED);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -112,7 +121,15 @@ std::pair<uint32_t, uint32_t> getDisplaySize() {
 // GLESRenderEngine we can remove this, too.
 static constexpr const bool kUseFrameBufferCache = false;
 
+/**
+ * Returns nullptr if the device does not support the type, e.g. has no suitable Vulkan driver.
+ */
 static std::unique_ptr<RenderEngine> createRenderEngine(RenderEngine::RenderEngineType type) {
+    if ((type == RenderEngine::RenderEngineType::SKIA_VK ||
+         type == RenderEngine::RenderEngineType::SKIA_VK_THREADED) &&
+        !skia::SkiaVkRenderEngine::canSupportSkiaVkRenderEngine()) {
+        return nullptr;
+    }
     auto args = RenderEngineCreationArgs::Builder()
                         .setPixelFormat(static_cast<int>(ui::PixelFormat::RGBA_8888))
                         .setImageCacheSize(1)
@@ -181,6 +198,28 @@ static std::shared_ptr<ExternalTexture> copyBuffer(RenderEngine& re,
     return texture;
 }
 
+/**
+ * Resets the peak resident set size of the process, so that each benchmark reports its own.
+ */
+static void resetPeakMemory() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+/**
+ * Returns the peak resident set size of the process in kB, or 0 if it is unknown. This includes
+ * the graphics memory the driver maps into the process, but not memory only the GPU can access.
+ */
+static int64_t getPeakMemoryKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoll(line.substr(6));
+        }
+    }
+    return 0;
+}
+
 /**
  * Helper for timing calls to drawLayers.
  *
@@ -189,29 +228,61 @@ static std::shared_ptr<ExternalTexture> copyBuffer(RenderEngine& re,
  * drawLayers, and saving (if --save is used).
  *
  * This times both the CPU and GPU work initiated by drawLayers. All work done
- * outside of the for loop is excluded from the timing measurements.
+ * outside of the for loop is excluded from the timing measurements. It also
+ * reports, per frame:
+ * - cpu_submit_ms: the time until drawLayers finished recording and submitting
+ *   the GPU work.
+ * - gpu_ms: the time from then until the GPU signaled the fence, which is the
+ *   GPU time that was not overlapped with recording.
+ * - peak_mem_mb: the peak resident memory of the process while drawing.
+ *
+ * @param outputDataspace The dataspace of the display, e.g. to tone-map HDR layers.
+ * @param extraOutputUsage Usage of the output buffer, e.g. GRALLOC_USAGE_PROTECTED.
  */
 static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>& layers,
-                            benchmark::State& benchState, const char* saveFileName) {
+                            benchmark::State& benchState, const char* saveFileName,
+                            ui::Dataspace outputDataspace = ui::Dataspace::UNKNOWN,
+                            uint64_t extraOutputUsage = 0) {
     auto [width, height] = getDisplaySize();
-    auto outputBuffer = allocateBuffer(re, width, height);
+    auto outputBuffer = allocateBuffer(re, width, height, extraOutputUsage);
 
     const Rect displayRect(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height));
     DisplaySettings display{
             .physicalDisplay = displayRect,
             .clip = displayRect,
             .maxLuminance = 500,
+            .outputDataspace = outputDataspace,
     };
 
+    resetPeakMemory();
+    nsecs_t cpuTime = 0;
+    nsecs_t gpuTime = 0;
+
     // This loop starts and stops the timer.
     for (auto _ : benchState) {
+        const nsecs_t start = systemTime();
         sp<Fence> waitFence = re.drawLayers(display, layers, outputBuffer, kUseFrameBufferCache,
                                             base::unique_fd())
                                       .get()
                                       .value();
+        const nsecs_t submitted = systemTime();
         waitFence->waitForever(LOG_TAG);
+
+        cpuTime += submitted - start;
+        const nsecs_t signaled = waitFence->getSignalTime();
+        if (signaled != Fence::SIGNAL_TIME_INVALID && signaled != Fence::SIGNAL_TIME_PENDING) {
+            gpuTime += std::max<nsecs_t>(0, signaled - submitted);
+        }
     }
 
+    benchState.counters["cpu_submit_ms"] =
+            benchmark::Counter(static_cast<double>(cpuTime) / 1e6,
+                               benchmark::Counter::kAvgIterations);
+    benchState.counters["gpu_ms"] =
+            benchmark::Counter(static_cast<double>(gpuTime) / 1e6,
+                               benchmark::Counter::kAvgIterations);
+    benchState.counters["peak_mem_mb"] = static_cast<double>(getPeakMemoryKb()) / 1024;
+
     if (renderenginebench::save() && saveFileName) {
         // Copy to a CPU-accessible buffer so we can encode it.
         outputBuffer = copyBuffer(re, outputBuffer, GRALLOC_USAGE_SW_READ_OFTEN, "to_encode");
@@ -228,37 +299,112 @@ static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>&
 //  Benchmarks
 ///////////////////////////////////////////////////////////////////////////////
 
-void BM_blur(benchmark::State& benchState) {
-    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+/**
+ * Creates the RenderEngine the benchmark runs with, or skips the benchmark and returns nullptr if
+ * the device does not support it.
+ */
+static std::unique_ptr<RenderEngine> createRenderEngine(benchmark::State& benchState) {
+    const auto type = static_cast<RenderEngine::RenderEngineType>(benchState.range());
+    auto re = createRenderEngine(type);
+    if (!re) {
+        benchState.SkipWithError(
+                ("RenderEngine type " + RenderEngineTypeName(type) + " is not supported").c_str());
+    }
+    return re;
+}
 
+/**
+ * Decode the homescreen into a GPU-only buffer the size of the display.
+ */
+static std::shared_ptr<ExternalTexture> decodeHomescreen(RenderEngine& re,
+                                                         uint64_t extraUsageFlags = 0) {
     // Initially use cpu access so we can decode into it with AImageDecoder.
     auto [width, height] = getDisplaySize();
     auto srcBuffer =
-            allocateBuffer(*re, width, height, GRALLOC_USAGE_SW_WRITE_OFTEN, "decoded_source");
-    {
-        std::string srcImage = base::GetExecutableDirectory();
-        srcImage.append("/resources/homescreen.png");
-        renderenginebench::decode(srcImage.c_str(), srcBuffer->getBuffer());
-
-        // Now copy into GPU-only buffer for more realistic timing.
-        srcBuffer = copyBuffer(*re, srcBuffer, 0, "source");
+            allocateBuffer(re, width, height, GRALLOC_USAGE_SW_WRITE_OFTEN, "decoded_source");
+    std::string srcImage = base::GetExecutableDirectory();
+    srcImage.append("/resources/homescreen.png");
+    renderenginebench::decode(srcImage.c_str(), srcBuffer->getBuffer());
+
+    // Now copy into GPU-only buffer for more realistic timing.
+    return copyBuffer(re, srcBuffer, extraUsageFlags, "source");
+}
+
+/**
+ * Allocate a YUV buffer the size of the display, filled with a gradient, like a video frame.
+ */
+static std::shared_ptr<ExternalTexture> allocateYuvBuffer(RenderEngine& re) {
+    auto [width, height] = getDisplaySize();
+    auto buffer = sp<GraphicBuffer>::make(width, height, HAL_PIXEL_FORMAT_YCBCR_420_888, 1u,
+                                          GRALLOC_USAGE_HW_TEXTURE | GRALLOC_USAGE_SW_WRITE_OFTEN,
+                                          "yuv_source");
+    android_ycbcr ycbcr;
+    LOG_ALWAYS_FATAL_IF(buffer->lockYCbCr(GRALLOC_USAGE_SW_WRITE_OFTEN, &ycbcr) != NO_ERROR,
+                        "Failed to lock YUV buffer!");
+    for (uint32_t y = 0; y < height; y++) {
+        auto* row = static_cast<uint8_t*>(ycbcr.y) + y * ycbcr.ystride;
+        for (uint32_t x = 0; x < width; x++) {
+            row[x] = static_cast<uint8_t>((x + y) * 255 / (width + height));
+        }
+    }
+    for (uint32_t y = 0; y < height / 2; y++) {
+        auto* cbRow = static_cast<uint8_t*>(ycbcr.cb) + y * ycbcr.cstride;
+        auto* crRow = static_cast<uint8_t*>(ycbcr.cr) + y * ycbcr.cstride;
+        for (uint32_t x = 0; x < width / 2; x++) {
+            cbRow[x * ycbcr.chroma_step] = static_cast<uint8_t>(x * 255 / width);
+            crRow[x * ycbcr.chroma_step] = static_cast<uint8_t>(y * 255 / height);
+        }
     }
+    buffer->unlock();
 
-    const FloatRect layerRect(0, 0, width, height);
-    LayerSettings layer{
+    return std::make_shared<impl::ExternalTexture>(buffer, re,
+                                                   impl::ExternalTexture::Usage::READABLE);
+}
+
+static LayerSettings makeBufferLayer(const std::shared_ptr<ExternalTexture>& buffer) {
+    auto [width, height] = getDisplaySize();
+    return LayerSettings{
             .geometry =
                     Geometry{
-                            .boundaries = layerRect,
+                            .boundaries = FloatRect(0, 0, width, height),
                     },
             .source =
                     PixelSource{
                             .buffer =
                                     Buffer{
-                                            .buffer = srcBuffer,
+                                            .buffer = buffer,
                                     },
                     },
             .alpha = half(1.0f),
     };
+}
+
+/**
+ * Make a layer drawing the buffer scaled down around the center of the display, like a window in
+ * recents or in freeform mode.
+ */
+static LayerSettings makeWindowLayer(const std::shared_ptr<ExternalTexture>& buffer, float scale,
+                                     float cornerRadius) {
+    auto [width, height] = getDisplaySize();
+    LayerSettings layer = makeBufferLayer(buffer);
+    layer.geometry.positionTransform =
+            mat4::translate(vec4(width * (1 - scale) / 2, height * (1 - scale) / 2, 0, 0)) *
+            mat4::scale(vec4(scale, scale, 1, 1));
+    layer.geometry.roundedCornersRadius = {cornerRadius, cornerRadius};
+    layer.geometry.roundedCornersCrop = layer.geometry.boundaries;
+    return layer;
+}
+
+void BM_blur(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re);
+
+    auto [width, height] = getDisplaySize();
+    const FloatRect layerRect(0, 0, width, height);
+    LayerSettings layer = makeBufferLayer(srcBuffer);
     LayerSettings blurLayer{
             .geometry =
                     Geometry{
@@ -273,4 +419,222 @@ void BM_blur(benchmark::State& benchState) {
     benchDrawLayers(*re, layers, benchState, "blurred");
 }
 
-BENCHMARK(BM_blur)->Apply(RunSkiaGLThreaded);
+BENCHMARK(BM_blur)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a blurred dialog over the wallpaper. When the wallpaper is static, its frame number does
+ * not change, so the blur behind the dialog is only generated for the first frame and reused for
+ * the others. Otherwise the frame number is unknown, and the blur is generated for every frame.
+ */
+static void benchBlurredDialog(benchmark::State& benchState, bool staticWallpaper,
+                               const char* saveFileName) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re);
+
+    auto [width, height] = getDisplaySize();
+    LayerSettings wallpaper = makeBufferLayer(srcBuffer);
+    wallpaper.source.buffer.frameNumber = staticWallpaper ? 1u : 0u;
+    const FloatRect dialogRect(width * 0.1f, height * 0.3f, width * 0.9f, height * 0.7f);
+    LayerSettings dialog{
+            .geometry =
+                    Geometry{
+                            .boundaries = dialogRect,
+                            .roundedCornersRadius = {28.0f, 28.0f},
+                            .roundedCornersCrop = dialogRect,
+                    },
+            .source =
+                    PixelSource{
+                            .solidColor = half3(1.0f, 1.0f, 1.0f),
+                    },
+            .alpha = half(0.8f),
+            .backgroundBlurRadius = 60,
+    };
+
+    auto layers = std::vector<LayerSettings>{wallpaper, dialog};
+    benchDrawLayers(*re, layers, benchState, saveFileName);
+}
+
+void BM_blurredDialogOverStaticWallpaper(benchmark::State& benchState) {
+    benchBlurredDialog(benchState, /* staticWallpaper */ true, "blurred_dialog");
+}
+
+void BM_blurredDialogOverChangingWallpaper(benchmark::State& benchState) {
+    benchBlurredDialog(benchState, /* staticWallpaper */ false, nullptr);
+}
+
+BENCHMARK(BM_blurredDialogOverStaticWallpaper)->Apply(RunSkiaThreaded);
+BENCHMARK(BM_blurredDialogOverChangingWallpaper)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws windows with rounded corners over the wallpaper, like recents.
+ */
+void BM_roundedCorners(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re);
+
+    auto layers = std::vector<LayerSettings>{
+            makeBufferLayer(srcBuffer),
+            makeWindowLayer(srcBuffer, 0.8f, 120.0f),
+            makeWindowLayer(srcBuffer, 0.6f, 160.0f),
+            makeWindowLayer(srcBuffer, 0.4f, 240.0f),
+    };
+    benchDrawLayers(*re, layers, benchState, "rounded_corners");
+}
+
+BENCHMARK(BM_roundedCorners)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a window casting a shadow over the wallpaper, like a freeform window.
+ */
+void BM_shadows(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re);
+
+    auto [width, height] = getDisplaySize();
+    LayerSettings window = makeWindowLayer(srcBuffer, 0.7f, 40.0f);
+    window.shadow = ShadowSettings{
+            .boundaries = window.geometry.boundaries,
+            .ambientColor = vec4(0.0f, 0.0f, 0.0f, 0.04f),
+            .spotColor = vec4(0.0f, 0.0f, 0.0f, 0.2f),
+            .lightPos = vec3(width / 2.0f, 0.0f, 750.0f),
+            .lightRadius = 800.0f,
+            .length = 40.0f,
+    };
+
+    auto layers = std::vector<LayerSettings>{makeBufferLayer(srcBuffer), window};
+    benchDrawLayers(*re, layers, benchState, "shadows");
+}
+
+BENCHMARK(BM_shadows)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a PQ layer to an SDR display, which tone-maps it with a LinearEffect.
+ */
+void BM_hdrToneMapping(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re);
+
+    LayerSettings layer = makeBufferLayer(srcBuffer);
+    layer.sourceDataspace = ui::Dataspace::BT2020_ITU_PQ;
+    layer.source.buffer.maxLuminanceNits = 1000.0f;
+
+    auto layers = std::vector<LayerSettings>{layer};
+    benchDrawLayers(*re, layers, benchState, "hdr_tone_mapping", ui::Dataspace::DISPLAY_P3);
+}
+
+BENCHMARK(BM_hdrToneMapping)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a full screen HDR video layer to an SDR display, either sampling the tone mapping curve
+ * from a lookup table or evaluating it for each pixel, to compare the per-pixel cost of both.
+ */
+void BM_hdrVideo(benchmark::State& benchState, ui::Dataspace sourceDataspace,
+                 bool useToneMapLut) {
+    // SkiaRenderEngine reads the property when it is created.
+    const std::string previous = base::GetProperty(PROPERTY_DEBUG_RENDERENGINE_TONE_MAP_LUT, "");
+    base::SetProperty(PROPERTY_DEBUG_RENDERENGINE_TONE_MAP_LUT, useToneMapLut ? "true" : "false");
+    auto re = createRenderEngine(benchState);
+    if (re) {
+        // The threaded RenderEngine creates its backend asynchronously, so wait for it.
+        re->getMaxTextureSize();
+    }
+    base::SetProperty(PROPERTY_DEBUG_RENDERENGINE_TONE_MAP_LUT, previous);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = allocateYuvBuffer(*re);
+
+    LayerSettings layer = makeBufferLayer(srcBuffer);
+    layer.sourceDataspace = sourceDataspace;
+    layer.source.buffer.maxLuminanceNits = 1000.0f;
+
+    auto layers = std::vector<LayerSettings>{layer};
+    benchDrawLayers(*re, layers, benchState, "hdr_video", ui::Dataspace::DISPLAY_P3);
+}
+
+BENCHMARK_CAPTURE(BM_hdrVideo, pq_lut, ui::Dataspace::BT2020_ITU_PQ, true)
+        ->Apply(RunSkiaThreaded);
+BENCHMARK_CAPTURE(BM_hdrVideo, pq_per_pixel, ui::Dataspace::BT2020_ITU_PQ, false)
+        ->Apply(RunSkiaThreaded);
+BENCHMARK_CAPTURE(BM_hdrVideo, hlg_lut, ui::Dataspace::BT2020_ITU_HLG, true)
+        ->Apply(RunSkiaThreaded);
+BENCHMARK_CAPTURE(BM_hdrVideo, hlg_per_pixel, ui::Dataspace::BT2020_ITU_HLG, false)
+        ->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a layer stretched by overscrolling it.
+ */
+void BM_stretch(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re);
+
+    auto [width, height] = getDisplaySize();
+    LayerSettings layer = makeBufferLayer(srcBuffer);
+    layer.stretchEffect.width = static_cast<float>(width);
+    layer.stretchEffect.height = static_cast<float>(height);
+    layer.stretchEffect.vectorY = 0.5f;
+    layer.stretchEffect.maxAmountX = static_cast<float>(width);
+    layer.stretchEffect.maxAmountY = static_cast<float>(height);
+    layer.stretchEffect.mappedChildBounds = layer.geometry.boundaries;
+
+    auto layers = std::vector<LayerSettings>{layer};
+    benchDrawLayers(*re, layers, benchState, "stretch");
+}
+
+BENCHMARK(BM_stretch)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a protected layer to a protected buffer, which uses the protected context.
+ */
+void BM_protected(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    if (!re->supportsProtectedContent()) {
+        benchState.SkipWithError("Protected content is not supported");
+        return;
+    }
+    auto srcBuffer = decodeHomescreen(*re, GRALLOC_USAGE_PROTECTED);
+
+    auto layers = std::vector<LayerSettings>{makeBufferLayer(srcBuffer)};
+    // The protected output can not be read back to be saved.
+    benchDrawLayers(*re, layers, benchState, nullptr, ui::Dataspace::UNKNOWN,
+                    GRALLOC_USAGE_PROTECTED);
+}
+
+BENCHMARK(BM_protected)->Apply(RunSkiaThreaded);
+
+/**
+ * Draws a full screen YUV layer, like a video.
+ */
+void BM_yuv(benchmark::State& benchState) {
+    auto re = createRenderEngine(benchState);
+    if (!re) {
+        return;
+    }
+    auto srcBuffer = allocateYuvBuffer(*re);
+
+    LayerSettings layer = makeBufferLayer(srcBuffer);
+    layer.sourceDataspace = ui::Dataspace::BT709;
+
+    auto layers = std::vector<LayerSettings>{layer};
+    benchDrawLayers(*re, layers, benchState, "yuv", ui::Dataspace::SRGB);
+}
+
+BENCHMARK(BM_yuv)->Apply(RunSkiaThreaded);
@@ -89,6 +89,11 @@ struct DisplaySettings {
             aidl::android::hardware::graphics::composer3::RenderIntent::TONE_MAP_COLORIMETRIC;
 
     std::vector<renderengine::BorderRenderInfo> borderInfoList;
+
+    // Whether the output is not needed to present the next frame of a display, e.g. a screenshot
+    // or a cached set of the planner. RenderEngine may draw it on a lower priority context, so
+    // that composing displays never waits behind it.
+    bool isDeferrable = false;
 };
 
 static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings& rhs) {
@@ -101,7 +106,7 @@ static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings&
             lhs.orientation == rhs.orientation &&
             lhs.targetLuminanceNits == rhs.targetLuminanceNits &&
             lhs.dimmingStage == rhs.dimmingStage && lhs.renderIntent == rhs.renderIntent &&
-            lhs.borderInfoList == rhs.borderInfoList;
+            lhs.borderInfoList == rhs.borderInfoList && lhs.isDeferrable == rhs.isDeferrable;
 }
 
 static const char* orientation_to_string(uint32_t orientation) {
@@ -146,6 +151,7 @@ static inline void PrintTo(const DisplaySettings& settings, ::std::ostream* os)
         << aidl::android::hardware::graphics::composer3::toString(settings.dimmingStage).c_str();
     *os << "\n    .renderIntent = "
         << aidl::android::hardware::graphics::composer3::toString(settings.renderIntent).c_str();
+    *os << "\n    .isDeferrable = " << settings.isDeferrable;
     *os << "\n}";
 }
 
@@ -48,6 +48,10 @@ public:
 
     virtual void remapBuffer() = 0;
 
+    // Maps the buffer into GPU resources if that was deferred until the texture is drawn.
+    // RenderEngine calls this before drawing layers that sample the texture.
+    virtual void ensureMapped() {}
+
     Rect getBounds() const {
         return {0, 0, static_cast<int32_t>(getWidth()), static_cast<int32_t>(getHeight())};
     }
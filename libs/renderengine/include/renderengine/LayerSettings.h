@@ -68,6 +68,10 @@ struct Buffer {
     bool isY410BT2020 = false;
 
     float maxLuminanceNits = 0.0;
+
+    // Frame number of the content of the buffer, which identifies it together with the buffer id.
+    // 0 if unknown, in which case drawings of the buffer are never assumed to be identical.
+    uint64_t frameNumber = 0;
 };
 
 // Metadata describing the layer geometry.
@@ -190,7 +194,7 @@ static inline bool operator==(const Buffer& lhs, const Buffer& rhs) {
             lhs.textureTransform == rhs.textureTransform &&
             lhs.usePremultipliedAlpha == rhs.usePremultipliedAlpha &&
             lhs.isOpaque == rhs.isOpaque && lhs.isY410BT2020 == rhs.isY410BT2020 &&
-            lhs.maxLuminanceNits == rhs.maxLuminanceNits;
+            lhs.maxLuminanceNits == rhs.maxLuminanceNits && lhs.frameNumber == rhs.frameNumber;
 }
 
 static inline bool operator==(const Geometry& lhs, const Geometry& rhs) {
@@ -249,6 +253,7 @@ static inline void PrintTo(const Buffer& settings, ::std::ostream* os) {
     *os << "\n    .isOpaque = " << settings.isOpaque;
     *os << "\n    .isY410BT2020 = " << settings.isY410BT2020;
     *os << "\n    .maxLuminanceNits = " << settings.maxLuminanceNits;
+    *os << "\n    .frameNumber = " << settings.frameNumber;
     *os << "\n}";
 }
 
@@ -51,6 +51,40 @@
  */
 #define PROPERTY_DEBUG_RENDERENGINE_CAPTURE_FILENAME "debug.renderengine.capture_filename"
 
+/**
+ * Bounds the memory used by the textures SkiaRenderEngine caches for mapped buffers, in megabytes.
+ * When exceeded, the least recently drawn textures are evicted. 0 leaves the cache unbounded.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB \
+    "debug.renderengine.texture_cache_budget_mb"
+
+/**
+ * Path of the file SkiaRenderEngine records the shader keys of the layers it draws to. When set,
+ * priming the shader cache warms the keys recorded by previous boots instead of a hard-coded set
+ * of layers. The file must be writable by SurfaceFlinger.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_SHADER_KEYS_FILE "debug.renderengine.shader_keys_file"
+
+/**
+ * Selects the algorithm SkiaRenderEngine blurs with: "kawase" (default), "dual_kawase", whose
+ * number of passes grows with the log of the radius, or "gaussian".
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_BLUR_ALGORITHM "debug.renderengine.blur_algorithm"
+
+/**
+ * Setting this to false makes SkiaRenderEngine evaluate the tone mapping curve of HDR layers for
+ * each pixel, instead of sampling it from a lookup table built once per dataspace pair and
+ * luminance. Defaults to true.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_TONE_MAP_LUT "debug.renderengine.tone_map_lut"
+
+/**
+ * Enables drawing deferrable work, such as screenshots, region sampling and the cached sets of
+ * the planner, on a second, lower priority RenderEngine context and thread, so that composing
+ * displays never waits behind it. Only supported by the threaded SkiaGL backend.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_BACKGROUND_CONTEXT "debug.renderengine.background_context"
+
 /**
  * Allows recording of Skia drawing commands with systrace.
  */
@@ -247,6 +281,11 @@ protected:
     void updateProtectedContext(const std::vector<LayerSettings>&,
                                 const std::shared_ptr<ExternalTexture>&);
 
+    // Maps the layers' textures whose mapping was deferred until they were drawn. This must run
+    // before the layers are drawn, and on the thread that requested drawing them, so that the
+    // mapping is ordered before drawing.
+    static void mapDeferredTextures(const std::vector<LayerSettings>&);
+
     // Attempt to switch RenderEngine into and out of protectedContext mode
     virtual void useProtectedContext(bool useProtectedContext) = 0;
 
@@ -266,6 +305,11 @@ struct RenderEngineCreationArgs {
     bool supportsBackgroundBlur;
     RenderEngine::ContextPriority contextPriority;
     RenderEngine::RenderEngineType renderEngineType;
+    // Whether a threaded RenderEngine draws deferrable work, see DisplaySettings::isDeferrable, on
+    // a second, lower priority context and thread.
+    bool enableBackgroundContext;
+    // Set by RenderEngine::create for the instance that draws on the background context.
+    bool isBackgroundContext = false;
 
     struct Builder;
 
@@ -275,7 +319,8 @@ private:
                              bool _enableProtectedContext, bool _precacheToneMapperShaderOnly,
                              bool _supportsBackgroundBlur,
                              RenderEngine::ContextPriority _contextPriority,
-                             RenderEngine::RenderEngineType _renderEngineType)
+                             RenderEngine::RenderEngineType _renderEngineType,
+                             bool _enableBackgroundContext)
           : pixelFormat(_pixelFormat),
             imageCacheSize(_imageCacheSize),
             useColorManagement(_useColorManagement),
@@ -283,7 +328,8 @@ private:
             precacheToneMapperShaderOnly(_precacheToneMapperShaderOnly),
             supportsBackgroundBlur(_supportsBackgroundBlur),
             contextPriority(_contextPriority),
-            renderEngineType(_renderEngineType) {}
+            renderEngineType(_renderEngineType),
+            enableBackgroundContext(_enableBackgroundContext) {}
     RenderEngineCreationArgs() = delete;
 };
 
@@ -322,10 +368,15 @@ struct RenderEngineCreationArgs::Builder {
         this->renderEngineType = renderEngineType;
         return *this;
     }
+    Builder& setEnableBackgroundContext(bool enableBackgroundContext) {
+        this->enableBackgroundContext = enableBackgroundContext;
+        return *this;
+    }
     RenderEngineCreationArgs build() const {
         return RenderEngineCreationArgs(pixelFormat, imageCacheSize, useColorManagement,
                                         enableProtectedContext, precacheToneMapperShaderOnly,
-                                        supportsBackgroundBlur, contextPriority, renderEngineType);
+                                        supportsBackgroundBlur, contextPriority, renderEngineType,
+                                        enableBackgroundContext);
     }
 
 private:
@@ -339,6 +390,7 @@ private:
     RenderEngine::ContextPriority contextPriority = RenderEngine::ContextPriority::MEDIUM;
     RenderEngine::RenderEngineType renderEngineType =
             RenderEngine::RenderEngineType::SKIA_GL_THREADED;
+    bool enableBackgroundContext = false;
 };
 
 } // namespace renderengine
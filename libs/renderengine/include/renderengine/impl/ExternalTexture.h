@@ -20,6 +20,9 @@
 #include <renderengine/ExternalTexture.h>
 #include <ui/GraphicBuffer.h>
 
+#include <atomic>
+#include <mutex>
+
 namespace android::renderengine::impl {
 
 class RenderEngine;
@@ -35,6 +38,10 @@ public:
         // The buffer needs to be mapped as a 2D texture if set, otherwise must be mapped as an
         // external texture
         WRITEABLE = 1 << 1,
+
+        // The buffer is only mapped once RenderEngine first draws with it, which saves mapping
+        // buffers that are never sampled, such as buffers that are only scanned out by HWC
+        DEFER_MAPPING = 1 << 2,
     };
 
     // Creates an ExternalTexture for the provided buffer and RenderEngine instance, with the given
@@ -52,11 +59,21 @@ public:
         return getBuffer() == other.getBuffer();
     }
     void remapBuffer() override;
+    void ensureMapped() override { mapDeferred(); }
+
+    bool isMapped() const { return mMapped; }
+
+protected:
+    // Maps the buffer if mapping was deferred and hasn't happened yet. Returns true if this call
+    // mapped the buffer.
+    bool mapDeferred();
 
 private:
     sp<GraphicBuffer> mBuffer;
     android::renderengine::RenderEngine& mRenderEngine;
     const bool mWritable;
+    std::atomic<bool> mMapped = false;
+    std::once_flag mDeferredMapping;
 };
 
 } // namespace android::renderengine::impl
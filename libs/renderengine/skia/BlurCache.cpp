@@ -0,0 +1,212 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BlurCache.h"
+
+#include <android-base/stringprintf.h>
+#include <android/hardware_buffer.h>
+#include <renderengine/ExternalTexture.h>
+
+#include <cstring>
+#include <type_traits>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+using base::StringAppendF;
+
+namespace {
+
+// A collision would draw a stale blur, so the hash mixes all bits of each value, unlike
+// android::hashCombine.
+class ContentHasher {
+public:
+    template <typename T>
+    void add(const T& value) {
+        static_assert((std::is_arithmetic_v<T> || std::is_enum_v<T>) && sizeof(T) <= 8);
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        mHash = mix(mHash ^ (bits + 0x9e3779b97f4a7c15ull + (mHash << 6) + (mHash >> 2)));
+    }
+
+    void add(const FloatRect& rect) {
+        add(rect.left);
+        add(rect.top);
+        add(rect.right);
+        add(rect.bottom);
+    }
+
+    void add(const Rect& rect) {
+        add(rect.left);
+        add(rect.top);
+        add(rect.right);
+        add(rect.bottom);
+    }
+
+    void add(const mat4& matrix) {
+        for (size_t i = 0; i < 16; i++) {
+            add(matrix.asArray()[i]);
+        }
+    }
+
+    template <typename T, size_t N>
+    void addVector(const T& vector) {
+        for (size_t i = 0; i < N; i++) {
+            add(static_cast<float>(vector[i]));
+        }
+    }
+
+    uint64_t get() const { return mHash; }
+
+private:
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t mHash = 0;
+};
+
+} // namespace
+
+bool BlurCache::Key::operator==(const Key& other) const {
+    return contentHash == other.contentHash && radius == other.radius &&
+            blurRect == other.blurRect && context == other.context;
+}
+
+std::optional<uint64_t> BlurCache::hashContent(const DisplaySettings& display,
+                                               PixelFormat outputFormat, float displayDimmingRatio,
+                                               const std::vector<LayerSettings>& layers,
+                                               size_t layerCount) {
+    ContentHasher hasher;
+    hasher.add(display.physicalDisplay);
+    hasher.add(display.clip);
+    hasher.add(display.maxLuminance);
+    hasher.add(display.currentLuminanceNits);
+    hasher.add(display.outputDataspace);
+    hasher.add(display.colorTransform);
+    hasher.add(display.deviceHandlesColorTransform);
+    hasher.add(display.orientation);
+    hasher.add(display.targetLuminanceNits);
+    hasher.add(display.dimmingStage);
+    hasher.add(display.renderIntent);
+    hasher.add(outputFormat);
+    hasher.add(displayDimmingRatio);
+
+    for (size_t i = 0; i < layerCount && i < layers.size(); i++) {
+        const LayerSettings& layer = layers[i];
+        const Buffer& buffer = layer.source.buffer;
+        if (buffer.buffer) {
+            if (buffer.frameNumber == 0 ||
+                (buffer.buffer->getUsage() & AHARDWAREBUFFER_USAGE_FRONT_BUFFER)) {
+                return std::nullopt;
+            }
+            hasher.add(buffer.buffer->getId());
+            hasher.add(buffer.frameNumber);
+            hasher.add(buffer.useTextureFiltering);
+            hasher.add(buffer.textureTransform);
+            hasher.add(buffer.usePremultipliedAlpha);
+            hasher.add(buffer.isOpaque);
+            hasher.add(buffer.isY410BT2020);
+            hasher.add(buffer.maxLuminanceNits);
+        } else {
+            hasher.addVector<half3, 3>(layer.source.solidColor);
+        }
+
+        hasher.add(layer.geometry.boundaries);
+        hasher.add(layer.geometry.positionTransform);
+        hasher.addVector<vec2, 2>(layer.geometry.roundedCornersRadius);
+        hasher.add(layer.geometry.roundedCornersCrop);
+        hasher.add(static_cast<float>(layer.alpha));
+        hasher.add(layer.sourceDataspace);
+        hasher.add(layer.colorTransform);
+        hasher.add(layer.disableBlending);
+        hasher.add(layer.skipContentDraw);
+
+        hasher.add(layer.shadow.boundaries);
+        hasher.addVector<vec4, 4>(layer.shadow.ambientColor);
+        hasher.addVector<vec4, 4>(layer.shadow.spotColor);
+        hasher.addVector<vec3, 3>(layer.shadow.lightPos);
+        hasher.add(layer.shadow.lightRadius);
+        hasher.add(layer.shadow.length);
+        hasher.add(layer.shadow.casterIsTranslucent);
+
+        hasher.add(layer.backgroundBlurRadius);
+        hasher.add(layer.blurRegions.size());
+        for (const auto& region : layer.blurRegions) {
+            hasher.add(region.blurRadius);
+            hasher.add(region.cornerRadiusTL);
+            hasher.add(region.cornerRadiusTR);
+            hasher.add(region.cornerRadiusBL);
+            hasher.add(region.cornerRadiusBR);
+            hasher.add(region.alpha);
+            hasher.add(region.left);
+            hasher.add(region.top);
+            hasher.add(region.right);
+            hasher.add(region.bottom);
+        }
+        hasher.add(layer.blurRegionTransform);
+
+        const auto& stretch = layer.stretchEffect;
+        hasher.add(stretch.width);
+        hasher.add(stretch.height);
+        hasher.add(stretch.vectorX);
+        hasher.add(stretch.vectorY);
+        hasher.add(stretch.maxAmountX);
+        hasher.add(stretch.maxAmountY);
+        hasher.add(stretch.mappedChildBounds);
+
+        hasher.add(layer.whitePointNits);
+    }
+    return hasher.get();
+}
+
+sk_sp<SkImage> BlurCache::get(const Key& key) {
+    for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+        if (it->first == key) {
+            mEntries.splice(mEntries.begin(), mEntries, it);
+            mStats.hits++;
+            return mEntries.front().second;
+        }
+    }
+    mStats.misses++;
+    return nullptr;
+}
+
+void BlurCache::insert(const Key& key, sk_sp<SkImage> image) {
+    if (!image) {
+        return;
+    }
+    mEntries.emplace_front(key, std::move(image));
+    if (mEntries.size() > kMaxEntries) {
+        mEntries.pop_back();
+    }
+}
+
+void BlurCache::clear() {
+    mEntries.clear();
+}
+
+void BlurCache::dump(std::string& result) const {
+    StringAppendF(&result, "Blur cache: %zu/%zu entries, hits/misses/uncacheable: %zu/%zu/%zu\n",
+                  mEntries.size(), kMaxEntries, mStats.hits, mStats.misses, mStats.uncacheable);
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkImage.h>
+#include <SkRect.h>
+#include <renderengine/DisplaySettings.h>
+#include <renderengine/LayerSettings.h>
+#include <ui/PixelFormat.h>
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <vector>
+
+class GrRecordingContext;
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * Caches the blurred, downsampled images generated by the BlurFilter across frames, so that e.g.
+ * a dialog over a static wallpaper is only blurred once. The blurred content is identified by a
+ * hash of the settings of the display and of the layers drawn below the blur, where buffers are
+ * identified by their id and frame number. Content drawn from a buffer without a frame number, or
+ * from a front buffer, which may change without a new frame, is never cached.
+ */
+class BlurCache {
+public:
+    // Blurs are usually drawn for a single layer per display, so only few need to be kept.
+    static constexpr size_t kMaxEntries = 4;
+
+    struct Key {
+        uint64_t contentHash = 0;
+        uint32_t radius = 0;
+        // Bounds of the blurred content, in the coordinate space of the blur input.
+        SkRect blurRect = SkRect::MakeEmpty();
+        // Images are only valid for the context that generated them, e.g. protected or not.
+        const GrRecordingContext* context = nullptr;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        // Blurs whose input could not be identified.
+        size_t uncacheable = 0;
+    };
+
+    // Hashes the content drawn by the first layerCount layers, or returns std::nullopt if it can
+    // not be identified. The dimming ratio depends on all layers, so it is passed separately.
+    static std::optional<uint64_t> hashContent(const DisplaySettings& display,
+                                               PixelFormat outputFormat, float displayDimmingRatio,
+                                               const std::vector<LayerSettings>& layers,
+                                               size_t layerCount);
+
+    // Returns the image cached for the key, or nullptr if there is none.
+    sk_sp<SkImage> get(const Key& key);
+    // Caches the image, evicting the least recently used one if the cache is full.
+    void insert(const Key& key, sk_sp<SkImage> image);
+    void countUncacheable() { mStats.uncacheable++; }
+
+    void clear();
+
+    size_t size() const { return mEntries.size(); }
+    const Stats& getStats() const { return mStats; }
+
+    void dump(std::string& result) const;
+
+private:
+    // Most recently used first.
+    std::list<std::pair<Key, sk_sp<SkImage>>> mEntries;
+    Stats mStats;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
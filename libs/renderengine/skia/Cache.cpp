@@ -26,6 +26,8 @@
 #include "ui/Rect.h"
 #include "utils/Timers.h"
 
+#include <unordered_map>
+
 namespace android::renderengine::skia {
 
 namespace {
@@ -324,6 +326,120 @@ static void drawHolePunchLayer(SkiaRenderEngine* renderengine, const DisplaySett
     renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache, base::unique_fd());
 }
 
+static DisplaySettings makeDisplay(const ShaderKey& key, const Rect& displayRect) {
+    using aidl::android::hardware::graphics::composer3::DimmingStage;
+    return DisplaySettings{
+            .physicalDisplay = displayRect,
+            .clip = displayRect,
+            .maxLuminance = 500,
+            .outputDataspace = key.outputDataspace,
+            .colorTransform = key.hasDisplayColorTransform ? kScaleAsymmetric : mat4(),
+            .deviceHandlesColorTransform = false,
+            .targetLuminanceNits = key.isDimmed ? 500.f : -1.f,
+            .dimmingStage = key.dimsInGammaSpace ? DimmingStage::GAMMA_OETF : DimmingStage::LINEAR,
+    };
+}
+
+// Rebuilds a layer that Skia draws with the same shaders as the layers the key was recorded from.
+static LayerSettings makeLayer(const ShaderKey& key, const Rect& displayRect,
+                               const std::shared_ptr<ExternalTexture>& srcTexture) {
+    FloatRect rect(0, 0, displayRect.width(), displayRect.height());
+    LayerSettings layer{
+            .geometry =
+                    Geometry{
+                            .boundaries = rect,
+                            .roundedCornersCrop = rect,
+                    },
+            .alpha = key.isTransparent ? 0.f : key.isTranslucent ? 0.5f : 1.f,
+            .sourceDataspace = key.sourceDataspace,
+            .disableBlending = key.disableBlending,
+    };
+
+    switch (key.source) {
+        case ShaderKey::Source::None:
+            layer.skipContentDraw = true;
+            break;
+        case ShaderKey::Source::SolidColor:
+            layer.source.solidColor = half3(0.1f, 0.2f, 0.3f);
+            break;
+        case ShaderKey::Source::Buffer:
+            layer.source.buffer = Buffer{
+                    .buffer = srcTexture,
+                    .usePremultipliedAlpha = key.usePremultipliedAlpha,
+                    .isOpaque = key.isOpaque,
+                    .maxLuminanceNits = 1000.f,
+            };
+            break;
+    }
+
+    switch (key.transform) {
+        case ShaderKey::Transform::Identity:
+            break;
+        case ShaderKey::Transform::ScaleAndTranslate:
+            layer.geometry.positionTransform = kScaleAndTranslate;
+            break;
+        case ShaderKey::Transform::AsymmetricScale:
+            layer.geometry.positionTransform = kScaleAsymmetric;
+            break;
+        case ShaderKey::Transform::Rotation:
+            layer.geometry.positionTransform = kFlip;
+            break;
+    }
+
+    switch (key.corners) {
+        case ShaderKey::Corners::None:
+            break;
+        case ShaderKey::Corners::Circular:
+            layer.geometry.roundedCornersRadius = {27.f, 27.f};
+            break;
+        case ShaderKey::Corners::Elliptical:
+            layer.geometry.roundedCornersRadius = {27.f, 40.f};
+            break;
+    }
+    if (key.clipsCorners) {
+        // See drawClippedLayers.
+        layer.geometry.boundaries = FloatRect(0, 0, displayRect.width(), displayRect.height() - 20);
+    }
+
+    if (key.hasColorTransform) {
+        layer.colorTransform = kScaleAsymmetric;
+    }
+    if (key.hasShadow) {
+        layer.shadow = ShadowSettings{
+                .boundaries = rect,
+                .ambientColor = vec4(0, 0, 0, 0.00935997f),
+                .spotColor = vec4(0, 0, 0, 0.0455841f),
+                .lightPos = vec3(500.f, -1500.f, 1500.f),
+                .lightRadius = 2500.0f,
+                .length = 15.f,
+        };
+    }
+    if (key.hasStretch) {
+        layer.stretchEffect = StretchEffect{
+                .width = rect.getWidth(),
+                .height = rect.getHeight(),
+                .vectorX = 0.5f,
+                .maxAmountX = 0.5f,
+                .mappedChildBounds = rect,
+        };
+    }
+    switch (key.blur) {
+        case ShaderKey::Blur::None:
+            break;
+        case ShaderKey::Blur::Small:
+            layer.backgroundBlurRadius = 9;
+            break;
+        case ShaderKey::Blur::Large:
+            layer.backgroundBlurRadius = 60;
+            break;
+    }
+    if (key.isDimmed) {
+        // Dimmed relative to the display's target luminance.
+        layer.whitePointNits = 200.f;
+    }
+    return layer;
+}
+
 //
 // The collection of shaders cached here were found by using perfetto to record shader compiles
 // during actions that involve RenderEngine, logging the layer settings, and the shader code
@@ -447,4 +563,79 @@ void Cache::primeShaderCache(SkiaRenderEngine* renderengine) {
     }
 }
 
+
+void Cache::primeShaderCache(SkiaRenderEngine* renderengine, const std::vector<ShaderKey>& keys) {
+    const int previousCount = renderengine->reportShadersCompiled();
+    const nsecs_t timeBefore = systemTime();
+    const Rect displayRect(0, 0, 128, 128);
+
+    const int64_t usage = GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
+    sp<GraphicBuffer> dstBuffer =
+            sp<GraphicBuffer>::make(displayRect.width(), displayRect.height(),
+                                    PIXEL_FORMAT_RGBA_8888, 1, usage, "primeShaderCache_dst");
+    const auto dstTexture =
+            std::make_shared<impl::ExternalTexture>(dstBuffer, *renderengine,
+                                                    impl::ExternalTexture::Usage::WRITEABLE);
+
+    // Source textures of each recorded format, or nullptr if the format cannot be allocated.
+    std::unordered_map<PixelFormat, std::shared_ptr<ExternalTexture>> srcTextures;
+    const auto getSrcTexture = [&](PixelFormat format) {
+        auto [it, inserted] = srcTextures.try_emplace(format);
+        if (inserted) {
+            // GRALLOC_USAGE_HW_TEXTURE should be the same as
+            // AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE.
+            sp<GraphicBuffer> srcBuffer =
+                    sp<GraphicBuffer>::make(displayRect.width(), displayRect.height(), format, 1,
+                                            GRALLOC_USAGE_HW_TEXTURE, "primeShaderCache_src");
+            if (srcBuffer->initCheck() == NO_ERROR) {
+                it->second = std::make_shared<
+                        impl::ExternalTexture>(srcBuffer, *renderengine,
+                                               impl::ExternalTexture::Usage::READABLE);
+            }
+        }
+        return it->second;
+    };
+
+    size_t keysDrawn = 0;
+    for (const auto& key : keys) {
+        if (key.source == ShaderKey::Source::None && !key.hasShadow &&
+            key.blur == ShaderKey::Blur::None) {
+            continue;
+        }
+        if (key.blur != ShaderKey::Blur::None && !renderengine->supportsBackgroundBlur()) {
+            continue;
+        }
+        std::shared_ptr<ExternalTexture> srcTexture;
+        if (key.source == ShaderKey::Source::Buffer) {
+            srcTexture = getSrcTexture(key.bufferFormat);
+            if (!srcTexture) {
+                continue;
+            }
+        }
+        const auto layers = std::vector<LayerSettings>{makeLayer(key, displayRect, srcTexture)};
+        renderengine->drawLayers(makeDisplay(key, displayRect), layers, dstTexture,
+                                 kUseFrameBufferCache, base::unique_fd());
+        keysDrawn++;
+    }
+
+    // draw one final layer synchronously to force GL submit
+    const DisplaySettings display{
+            .physicalDisplay = displayRect,
+            .clip = displayRect,
+            .maxLuminance = 500,
+            .outputDataspace = kDestDataSpace,
+    };
+    const auto layers = std::vector<LayerSettings>{LayerSettings{
+            .source = PixelSource{.solidColor = half3(0.f, 0.f, 0.f)},
+    }};
+    // call get() to make it synchronous
+    renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache, base::unique_fd())
+            .get();
+
+    const float compileTimeMs = static_cast<float>(systemTime() - timeBefore) / 1.0E6;
+    const int shadersCompiled = renderengine->reportShadersCompiled() - previousCount;
+    ALOGD("Shader cache generated %d shaders for %zu of %zu recorded keys in %f ms\n",
+          shadersCompiled, keysDrawn, keys.size(), compileTimeMs);
+}
+
 } // namespace android::renderengine::skia
@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include <vector>
+
+#include "ShaderKeyCache.h"
+
 namespace android::renderengine::skia {
 
 class SkiaRenderEngine;
@@ -23,6 +27,8 @@ class SkiaRenderEngine;
 class Cache {
 public:
     static void primeShaderCache(SkiaRenderEngine*);
+    // Warms only the shaders of the keys, in order, rather than the default set.
+    static void primeShaderCache(SkiaRenderEngine*, const std::vector<ShaderKey>& keys);
 
 private:
     Cache() = default;
@@ -0,0 +1,370 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "RenderEngine"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "ShaderKeyCache.h"
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <log/log.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+
+#include "debug/CommonPool.h"
+
+namespace android::renderengine::skia {
+
+using base::StringAppendF;
+
+namespace {
+
+constexpr const char* kHeader = "# RenderEngine shader keys v1";
+
+// Bit layout of ShaderKey::getFlags().
+constexpr int kSourceShift = 0;
+constexpr int kTransformShift = 2;
+constexpr int kCornersShift = 4;
+constexpr int kBlurShift = 6;
+constexpr uint32_t kEnumMask = 0x3;
+constexpr uint32_t kIsOpaque = 1 << 8;
+constexpr uint32_t kUsePremultipliedAlpha = 1 << 9;
+constexpr uint32_t kClipsCorners = 1 << 10;
+constexpr uint32_t kIsTranslucent = 1 << 11;
+constexpr uint32_t kIsTransparent = 1 << 12;
+constexpr uint32_t kDisableBlending = 1 << 13;
+constexpr uint32_t kHasColorTransform = 1 << 14;
+constexpr uint32_t kHasDisplayColorTransform = 1 << 15;
+constexpr uint32_t kHasShadow = 1 << 16;
+constexpr uint32_t kHasStretch = 1 << 17;
+constexpr uint32_t kIsDimmed = 1 << 18;
+constexpr uint32_t kDimsInGammaSpace = 1 << 19;
+constexpr uint32_t kValidFlags = (1 << 20) - 1;
+
+template <typename Enum>
+uint32_t packEnum(Enum value, int shift) {
+    return (static_cast<uint32_t>(value) & kEnumMask) << shift;
+}
+
+template <typename Enum>
+Enum unpackEnum(uint32_t flags, int shift) {
+    return static_cast<Enum>((flags >> shift) & kEnumMask);
+}
+
+ShaderKey::Transform getTransform(const mat4& transform) {
+    if (transform == mat4()) {
+        return ShaderKey::Transform::Identity;
+    }
+    if (transform[0][1] != 0.f || transform[1][0] != 0.f) {
+        return ShaderKey::Transform::Rotation;
+    }
+    return transform[0][0] == transform[1][1] ? ShaderKey::Transform::ScaleAndTranslate
+                                              : ShaderKey::Transform::AsymmetricScale;
+}
+
+ShaderKey::Blur getBlur(const LayerSettings& layer) {
+    int radius = layer.backgroundBlurRadius;
+    for (const auto& region : layer.blurRegions) {
+        radius = std::max(radius, static_cast<int>(region.blurRadius));
+    }
+    if (radius <= 0) {
+        return ShaderKey::Blur::None;
+    }
+    return radius < ShaderKey::kSmallBlurRadius ? ShaderKey::Blur::Small : ShaderKey::Blur::Large;
+}
+
+} // namespace
+
+ShaderKey ShaderKey::from(const DisplaySettings& display, const LayerSettings& layer,
+                          bool isDimmed) {
+    ShaderKey key;
+    if (layer.skipContentDraw) {
+        key.source = Source::None;
+    } else if (const auto& buffer = layer.source.buffer; buffer.buffer) {
+        key.source = Source::Buffer;
+        key.bufferFormat = buffer.buffer->getPixelFormat();
+        key.isOpaque = buffer.isOpaque;
+        key.usePremultipliedAlpha = buffer.usePremultipliedAlpha;
+    } else {
+        key.source = Source::SolidColor;
+    }
+    key.sourceDataspace = layer.sourceDataspace;
+    key.outputDataspace = display.outputDataspace;
+
+    const auto& geometry = layer.geometry;
+    key.transform = getTransform(geometry.positionTransform);
+    if (geometry.roundedCornersRadius.x > 0.f || geometry.roundedCornersRadius.y > 0.f) {
+        key.corners = geometry.roundedCornersRadius.x == geometry.roundedCornersRadius.y
+                ? Corners::Circular
+                : Corners::Elliptical;
+        key.clipsCorners = !(geometry.boundaries == geometry.roundedCornersCrop);
+    }
+
+    key.isTransparent = layer.alpha == 0.f;
+    key.isTranslucent = !key.isTransparent && layer.alpha < 1.f;
+    key.disableBlending = layer.disableBlending;
+    key.hasColorTransform = layer.colorTransform != mat4();
+    key.hasDisplayColorTransform =
+            display.colorTransform != mat4() && !display.deviceHandlesColorTransform;
+    key.hasShadow = layer.shadow.length > 0.f;
+    key.hasStretch = layer.stretchEffect.hasEffect();
+    key.blur = getBlur(layer);
+    key.isDimmed = isDimmed;
+    key.dimsInGammaSpace = display.dimmingStage ==
+            aidl::android::hardware::graphics::composer3::DimmingStage::GAMMA_OETF;
+    return key;
+}
+
+uint32_t ShaderKey::getFlags() const {
+    return packEnum(source, kSourceShift) | packEnum(transform, kTransformShift) |
+            packEnum(corners, kCornersShift) | packEnum(blur, kBlurShift) |
+            (isOpaque ? kIsOpaque : 0) | (usePremultipliedAlpha ? kUsePremultipliedAlpha : 0) |
+            (clipsCorners ? kClipsCorners : 0) | (isTranslucent ? kIsTranslucent : 0) |
+            (isTransparent ? kIsTransparent : 0) | (disableBlending ? kDisableBlending : 0) |
+            (hasColorTransform ? kHasColorTransform : 0) |
+            (hasDisplayColorTransform ? kHasDisplayColorTransform : 0) |
+            (hasShadow ? kHasShadow : 0) | (hasStretch ? kHasStretch : 0) |
+            (isDimmed ? kIsDimmed : 0) | (dimsInGammaSpace ? kDimsInGammaSpace : 0);
+}
+
+bool ShaderKey::operator==(const ShaderKey& other) const {
+    return getFlags() == other.getFlags() && bufferFormat == other.bufferFormat &&
+            sourceDataspace == other.sourceDataspace && outputDataspace == other.outputDataspace;
+}
+
+size_t ShaderKey::Hasher::operator()(const ShaderKey& key) const {
+    size_t hash = std::hash<uint32_t>{}(key.getFlags());
+    hash = hash * 31 + std::hash<int32_t>{}(key.bufferFormat);
+    hash = hash * 31 + std::hash<int32_t>{}(static_cast<int32_t>(key.sourceDataspace));
+    return hash * 31 + std::hash<int32_t>{}(static_cast<int32_t>(key.outputDataspace));
+}
+
+std::string ShaderKey::toString() const {
+    return base::StringPrintf("%" PRIx32 " %" PRId32 " %" PRId32 " %" PRId32, getFlags(),
+                              bufferFormat, static_cast<int32_t>(sourceDataspace),
+                              static_cast<int32_t>(outputDataspace));
+}
+
+std::optional<ShaderKey> ShaderKey::fromString(std::string_view string) {
+    const std::string terminated(string);
+    uint32_t flags;
+    int32_t bufferFormat;
+    int32_t sourceDataspace;
+    int32_t outputDataspace;
+    if (std::sscanf(terminated.c_str(), "%" SCNx32 " %" SCNd32 " %" SCNd32 " %" SCNd32, &flags,
+                    &bufferFormat, &sourceDataspace, &outputDataspace) != 4 ||
+        (flags & ~kValidFlags) != 0) {
+        return std::nullopt;
+    }
+
+    ShaderKey key;
+    key.source = unpackEnum<Source>(flags, kSourceShift);
+    key.transform = unpackEnum<Transform>(flags, kTransformShift);
+    key.corners = unpackEnum<Corners>(flags, kCornersShift);
+    key.blur = unpackEnum<Blur>(flags, kBlurShift);
+    key.isOpaque = flags & kIsOpaque;
+    key.usePremultipliedAlpha = flags & kUsePremultipliedAlpha;
+    key.clipsCorners = flags & kClipsCorners;
+    key.isTranslucent = flags & kIsTranslucent;
+    key.isTransparent = flags & kIsTransparent;
+    key.disableBlending = flags & kDisableBlending;
+    key.hasColorTransform = flags & kHasColorTransform;
+    key.hasDisplayColorTransform = flags & kHasDisplayColorTransform;
+    key.hasShadow = flags & kHasShadow;
+    key.hasStretch = flags & kHasStretch;
+    key.isDimmed = flags & kIsDimmed;
+    key.dimsInGammaSpace = flags & kDimsInGammaSpace;
+    key.bufferFormat = bufferFormat;
+    key.sourceDataspace = static_cast<ui::Dataspace>(sourceDataspace);
+    key.outputDataspace = static_cast<ui::Dataspace>(outputDataspace);
+    if (key.getFlags() != flags) {
+        // An enum is out of range.
+        return std::nullopt;
+    }
+    return key;
+}
+
+ShaderKeyCache::ShaderKeyCache(std::string path) : mPath(std::move(path)) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::string contents;
+    if (!base::ReadFileToString(mPath, &contents)) {
+        ALOGI("No shader keys recorded at %s yet", mPath.c_str());
+        return;
+    }
+    deserialize(contents);
+    ALOGI("Loaded %zu shader keys from %s", mLoadedKeys, mPath.c_str());
+}
+
+std::vector<ShaderKey> ShaderKeyCache::getWarmUpKeys() const {
+    std::vector<std::pair<ShaderKey, uint64_t>> counts(mCounts.begin(), mCounts.end());
+    std::stable_sort(counts.begin(), counts.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+    std::vector<ShaderKey> keys;
+    keys.reserve(counts.size());
+    for (const auto& [key, count] : counts) {
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+void ShaderKeyCache::record(const ShaderKey& key) {
+    if (!isEnabled() || mWarmingUp) {
+        return;
+    }
+    if (const auto it = mCounts.find(key); it != mCounts.end()) {
+        it->second++;
+        return;
+    }
+    if (mCounts.size() >= kMaxKeys) {
+        mCounts.erase(std::min_element(mCounts.begin(), mCounts.end(),
+                                       [](const auto& lhs, const auto& rhs) {
+                                           return lhs.second < rhs.second;
+                                       }));
+    }
+    mCounts.emplace(key, 1);
+    mNewKeys++;
+    mDirty = true;
+}
+
+void ShaderKeyCache::onWarmUpFinished(size_t keysWarmed, nsecs_t duration,
+                                      int totalShadersCompiled) {
+    mKeysWarmed = keysWarmed;
+    mWarmUpDuration = duration;
+    mShadersCompiledAtWarmUp = totalShadersCompiled;
+}
+
+ShaderKeyCache::BootStats ShaderKeyCache::getBootStats(int totalShadersCompiled) const {
+    return {.shaderCacheMisses = totalShadersCompiled - mShadersCompiledAtWarmUp.value_or(0),
+            .newKeys = mNewKeys};
+}
+
+void ShaderKeyCache::saveIfNeeded(int totalShadersCompiled) {
+    if (!isEnabled()) {
+        return;
+    }
+    const int shaderCacheMisses = getBootStats(totalShadersCompiled).shaderCacheMisses;
+    if (!mDirty && shaderCacheMisses == mSavedShaderCacheMisses) {
+        return;
+    }
+    const nsecs_t now = systemTime();
+    if (mLastSaveTime != 0 && now - mLastSaveTime < kMinSaveInterval) {
+        return;
+    }
+    mDirty = false;
+    mLastSaveTime = now;
+    mSavedShaderCacheMisses = shaderCacheMisses;
+
+    CommonPool::post([path = mPath, contents = serialize(totalShadersCompiled)] {
+        ATRACE_NAME("ShaderKeyCache::save");
+        // Write to a temporary file first, so that the keys are never partially written.
+        const std::string tempPath = path + ".tmp";
+        if (!base::WriteStringToFile(contents, tempPath) ||
+            std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            ALOGW("Failed to save shader keys to %s", path.c_str());
+        }
+    });
+}
+
+std::string ShaderKeyCache::serialize(int totalShadersCompiled) const {
+    std::string result = kHeader;
+    result += '\n';
+
+    auto boots = mPreviousBoots;
+    boots.push_back(getBootStats(totalShadersCompiled));
+    while (boots.size() > kMaxBoots) {
+        boots.pop_front();
+    }
+    for (const auto& boot : boots) {
+        StringAppendF(&result, "boot %d %zu\n", boot.shaderCacheMisses, boot.newKeys);
+    }
+
+    std::vector<std::pair<ShaderKey, uint64_t>> counts(mCounts.begin(), mCounts.end());
+    std::sort(counts.begin(), counts.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+    for (const auto& [key, count] : counts) {
+        StringAppendF(&result, "key %" PRIu64 " %s\n", count, key.toString().c_str());
+    }
+    return result;
+}
+
+void ShaderKeyCache::deserialize(std::string_view contents) {
+    mCounts.clear();
+    mPreviousBoots.clear();
+
+    const auto lines = base::Split(std::string(contents), "\n");
+    if (lines.empty() || lines.front() != kHeader) {
+        ALOGW("Ignoring shader keys in an unknown format");
+        mLoadedKeys = 0;
+        return;
+    }
+    for (const auto& line : lines) {
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        if (base::StartsWith(line, "boot ")) {
+            BootStats boot;
+            if (std::sscanf(line.c_str(), "boot %d %zu", &boot.shaderCacheMisses,
+                            &boot.newKeys) == 2) {
+                mPreviousBoots.push_back(boot);
+            }
+        } else if (base::StartsWith(line, "key ")) {
+            uint64_t count;
+            int offset = 0;
+            if (std::sscanf(line.c_str(), "key %" SCNu64 " %n", &count, &offset) != 1 ||
+                offset == 0) {
+                continue;
+            }
+            if (const auto key = ShaderKey::fromString(std::string_view(line).substr(offset));
+                key && mCounts.size() < kMaxKeys) {
+                mCounts[*key] = std::max<uint64_t>(count / 2, 1);
+            }
+        }
+    }
+    while (mPreviousBoots.size() >= kMaxBoots) {
+        mPreviousBoots.pop_front();
+    }
+    mLoadedKeys = mCounts.size();
+}
+
+void ShaderKeyCache::dump(std::string& result, int totalShadersCompiled) const {
+    if (!isEnabled()) {
+        return;
+    }
+    const auto stats = getBootStats(totalShadersCompiled);
+    StringAppendF(&result, "Shader key cache (%s): %zu keys, %zu loaded, %zu new this boot\n",
+                  mPath.c_str(), mCounts.size(), mLoadedKeys, stats.newKeys);
+    if (mShadersCompiledAtWarmUp) {
+        StringAppendF(&result, "  Warmed %zu keys in %.3f ms\n", mKeysWarmed,
+                      mWarmUpDuration / 1e6f);
+    }
+    StringAppendF(&result, "  Shader cache misses this boot: %d\n", stats.shaderCacheMisses);
+    StringAppendF(&result, "  Previous boots (least recent first, misses/new keys):");
+    for (const auto& boot : mPreviousBoots) {
+        StringAppendF(&result, " %d/%zu", boot.shaderCacheMisses, boot.newKeys);
+    }
+    StringAppendF(&result, "\n");
+}
+
+} // namespace android::renderengine::skia
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <renderengine/DisplaySettings.h>
+#include <renderengine/LayerSettings.h>
+#include <ui/GraphicTypes.h>
+#include <ui/PixelFormat.h>
+#include <utils/Timers.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace android::renderengine::skia {
+
+// The subset of the settings of a layer, and of the display it is drawn to, that selects the
+// shaders Skia compiles to draw it. Layers with equal keys are drawn with the same shaders, so
+// drawing a layer rebuilt from the key warms the shader cache for all of them.
+struct ShaderKey {
+    enum class Source : uint8_t { None, SolidColor, Buffer };
+    enum class Transform : uint8_t { Identity, ScaleAndTranslate, AsymmetricScale, Rotation };
+    enum class Corners : uint8_t { None, Circular, Elliptical };
+    // Blurs of small radii are cross-faded with the unblurred content.
+    enum class Blur : uint8_t { None, Small, Large };
+    static constexpr int kSmallBlurRadius = 30;
+
+    Source source = Source::None;
+    PixelFormat bufferFormat = PIXEL_FORMAT_NONE;
+    bool isOpaque = false;
+    bool usePremultipliedAlpha = false;
+    ui::Dataspace sourceDataspace = ui::Dataspace::UNKNOWN;
+    ui::Dataspace outputDataspace = ui::Dataspace::UNKNOWN;
+    Transform transform = Transform::Identity;
+    Corners corners = Corners::None;
+    // Whether the rounded corners crop extends beyond the layer bounds, which clips differently.
+    bool clipsCorners = false;
+    bool isTranslucent = false;
+    bool isTransparent = false;
+    bool disableBlending = false;
+    bool hasColorTransform = false;
+    bool hasDisplayColorTransform = false;
+    bool hasShadow = false;
+    bool hasStretch = false;
+    Blur blur = Blur::None;
+    bool isDimmed = false;
+    bool dimsInGammaSpace = false;
+
+    static ShaderKey from(const DisplaySettings&, const LayerSettings&, bool isDimmed);
+
+    bool operator==(const ShaderKey&) const;
+    bool operator!=(const ShaderKey& other) const { return !(*this == other); }
+
+    // Packs the enums and flags of the key.
+    uint32_t getFlags() const;
+
+    std::string toString() const;
+    static std::optional<ShaderKey> fromString(std::string_view);
+
+    struct Hasher {
+        size_t operator()(const ShaderKey& key) const;
+    };
+};
+
+// Records the shader keys of the layers drawn in production to a file, so that the next boot can
+// warm the shader cache with exactly the keys that devices draw, most frequently drawn first,
+// instead of a hard-coded set of layers. The file also keeps the number of shader cache misses,
+// meaning shaders compiled after warming the cache, of the most recent boots.
+//
+// This class is not thread-safe; it is only used on the thread that draws.
+class ShaderKeyCache {
+public:
+    static constexpr size_t kMaxKeys = 512;
+    static constexpr size_t kMaxBoots = 8;
+    // New keys are usually drawn in bursts, e.g. when an app launches, so saving is throttled.
+    static constexpr nsecs_t kMinSaveInterval = s2ns(10);
+
+    struct BootStats {
+        int shaderCacheMisses = 0;
+        size_t newKeys = 0;
+    };
+
+    // Loads the keys recorded by previous boots. An empty path disables recording.
+    explicit ShaderKeyCache(std::string path);
+
+    bool isEnabled() const { return !mPath.empty(); }
+
+    // Returns the keys recorded by previous boots, most frequently drawn first.
+    std::vector<ShaderKey> getWarmUpKeys() const;
+
+    // Records the key of a drawn layer, unless the cache is being warmed.
+    void record(const ShaderKey& key);
+
+    // Excludes the layers drawn to warm the shader cache from the recorded keys.
+    void setWarmingUp(bool warmingUp) { mWarmingUp = warmingUp; }
+    // Shaders compiled after warm-up finishes are counted as cache misses.
+    void onWarmUpFinished(size_t keysWarmed, nsecs_t duration, int totalShadersCompiled);
+
+    // Writes the recorded keys asynchronously if new keys were drawn since they were last written.
+    void saveIfNeeded(int totalShadersCompiled);
+
+    BootStats getBootStats(int totalShadersCompiled) const;
+
+    void dump(std::string& result, int totalShadersCompiled) const;
+
+    // Exposed for testing.
+    std::string serialize(int totalShadersCompiled) const;
+    void deserialize(std::string_view contents);
+
+private:
+    const std::string mPath;
+
+    // Draw counts of the keys. Counts loaded from previous boots are halved, so that the warm-up
+    // order follows what devices drew most recently.
+    std::unordered_map<ShaderKey, uint64_t, ShaderKey::Hasher> mCounts;
+    size_t mLoadedKeys = 0;
+    size_t mNewKeys = 0;
+    // Stats of previous boots, least recent first.
+    std::deque<BootStats> mPreviousBoots;
+
+    bool mWarmingUp = false;
+    std::optional<int> mShadersCompiledAtWarmUp;
+    size_t mKeysWarmed = 0;
+    nsecs_t mWarmUpDuration = 0;
+
+    bool mDirty = false;
+    nsecs_t mLastSaveTime = 0;
+    int mSavedShaderCacheMisses = 0;
+};
+
+} // namespace android::renderengine::skia
@@ -51,6 +51,7 @@
 #include <SkString.h>
 #include <SkSurface.h>
 #include <SkTileMode.h>
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <gui/FenceMonitor.h>
 #include <gui/TraceUtils.h>
@@ -72,6 +73,7 @@
 #include "Cache.h"
 #include "ColorSpaces.h"
 #include "filters/BlurFilter.h"
+#include "filters/DualKawaseBlurFilter.h"
 #include "filters/GaussianBlurFilter.h"
 #include "filters/KawaseBlurFilter.h"
 #include "filters/LinearEffect.h"
@@ -242,7 +244,17 @@ namespace skia {
 using base::StringAppendF;
 
 std::future<void> SkiaRenderEngine::primeCache() {
-    Cache::primeShaderCache(this);
+    const nsecs_t timeBefore = systemTime();
+    const auto keys = mShaderKeyCache.getWarmUpKeys();
+    mShaderKeyCache.setWarmingUp(true);
+    if (keys.empty()) {
+        Cache::primeShaderCache(this);
+    } else {
+        Cache::primeShaderCache(this, keys);
+    }
+    mShaderKeyCache.setWarmingUp(false);
+    mShaderKeyCache.onWarmUpFinished(keys.size(), systemTime() - timeBefore,
+                                     reportShadersCompiled());
     return {};
 }
 
@@ -267,14 +279,41 @@ void SkiaRenderEngine::setEnableTracing(bool tracingEnabled) {
     SkAndroidFrameworkTraceUtil::setEnableTracing(tracingEnabled);
 }
 
+static size_t getTextureCacheBudget() {
+    const int budgetMb =
+            base::GetIntProperty(PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB, 0);
+    return static_cast<size_t>(std::max(budgetMb, 0)) * 1024 * 1024;
+}
+
+static BlurFilter* createBlurFilter() {
+    const std::string algorithm =
+            base::GetProperty(PROPERTY_DEBUG_RENDERENGINE_BLUR_ALGORITHM, "kawase");
+    if (algorithm == "dual_kawase") {
+        return new DualKawaseBlurFilter();
+    }
+    if (algorithm == "gaussian") {
+        return new GaussianBlurFilter();
+    }
+    ALOGE_IF(algorithm != "kawase", "Unknown blur algorithm %s, using kawase", algorithm.c_str());
+    return new KawaseBlurFilter();
+}
+
 SkiaRenderEngine::SkiaRenderEngine(RenderEngineType type, PixelFormat pixelFormat,
-                                   bool useColorManagement, bool supportsBackgroundBlur)
+                                   bool useColorManagement, bool supportsBackgroundBlur,
+                                   bool isBackgroundContext)
       : RenderEngine(type),
         mDefaultPixelFormat(pixelFormat),
-        mUseColorManagement(useColorManagement) {
+        mUseColorManagement(useColorManagement),
+        mUseToneMapLut(base::GetBoolProperty(PROPERTY_DEBUG_RENDERENGINE_TONE_MAP_LUT, true)),
+        mTextureCache(getTextureCacheBudget()),
+        // The shader keys are recorded by the main context, which draws all layers displayed.
+        mShaderKeyCache(isBackgroundContext
+                                ? ""
+                                : base::GetProperty(PROPERTY_DEBUG_RENDERENGINE_SHADER_KEYS_FILE,
+                                                    "")) {
     if (supportsBackgroundBlur) {
         ALOGD("Background Blurs Enabled");
-        mBlurFilter = new KawaseBlurFilter();
+        mBlurFilter = createBlurFilter();
     }
     mCapture = std::make_unique<SkiaCapture>();
 }
@@ -288,6 +327,7 @@ void SkiaRenderEngine::finishRenderingAndAbandonContext() {
     if (mBlurFilter) {
         delete mBlurFilter;
     }
+    mBlurCache.clear();
 
     if (mGrContext) {
         mGrContext->flushAndSubmit(true);
@@ -416,12 +456,13 @@ void SkiaRenderEngine::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer,
     std::lock_guard<std::mutex> lock(mRenderingMutex);
     mGraphicBufferExternalRefs[buffer->getId()]++;
 
-    if (const auto& iter = cache.find(buffer->getId()); iter == cache.end()) {
+    if (!cache.contains(buffer->getId())) {
         std::shared_ptr<AutoBackendTexture::LocalRef> imageTextureRef =
                 std::make_shared<AutoBackendTexture::LocalRef>(grContext,
                                                                buffer->toAHardwareBuffer(),
                                                                isRenderable, mTextureCleanupMgr);
-        cache.insert({buffer->getId(), imageTextureRef});
+        cache.insert(buffer->getId(), imageTextureRef, TextureCache::estimateBytes(*buffer),
+                     isRenderable);
     }
 }
 
@@ -467,8 +508,20 @@ std::shared_ptr<AutoBackendTexture::LocalRef> SkiaRenderEngine::getOrCreateBacke
         const sp<GraphicBuffer>& buffer, bool isOutputBuffer) {
     // Do not lookup the buffer in the cache for protected contexts
     if (!isProtected()) {
-        if (const auto& it = mTextureCache.find(buffer->getId()); it != mTextureCache.end()) {
-            return it->second;
+        if (auto texture = mTextureCache.get(buffer->getId())) {
+            return texture;
+        }
+        // If the texture of a mapped buffer was evicted to stay within the cache budget, cache it
+        // again now that it is drawn, evicting textures that were drawn less recently instead.
+        if (const auto isRenderable = mTextureCache.getEvictedRenderability(buffer->getId())) {
+            auto texture =
+                    std::make_shared<AutoBackendTexture::LocalRef>(getActiveGrContext(),
+                                                                   buffer->toAHardwareBuffer(),
+                                                                   *isRenderable || isOutputBuffer,
+                                                                   mTextureCleanupMgr);
+            mTextureCache.insert(buffer->getId(), texture, TextureCache::estimateBytes(*buffer),
+                                 *isRenderable || isOutputBuffer);
+            return texture;
         }
     }
     return std::make_shared<AutoBackendTexture::LocalRef>(getActiveGrContext(),
@@ -487,6 +540,12 @@ void SkiaRenderEngine::cleanupPostRender() {
     mTextureCleanupMgr.cleanup();
 }
 
+void SkiaRenderEngine::cleanFramebufferCache() {
+    std::lock_guard<std::mutex> lock(mRenderingMutex);
+    mBlurCache.clear();
+    mToneMapLutCache.clear();
+}
+
 sk_sp<SkShader> SkiaRenderEngine::createRuntimeEffectShader(
         const RuntimeEffectShaderParameters& parameters) {
     // The given surface will be stretched by HWUI via matrix transformation
@@ -504,10 +563,14 @@ sk_sp<SkShader> SkiaRenderEngine::createRuntimeEffectShader(
     }
 
     if (parameters.requiresLinearEffect) {
+        const bool useToneMapLut = mUseToneMapLut &&
+                shaders::canUseToneMapLut(parameters.layer.sourceDataspace,
+                                          parameters.outputDataSpace);
         auto effect =
                 shaders::LinearEffect{.inputDataspace = parameters.layer.sourceDataspace,
                                       .outputDataspace = parameters.outputDataSpace,
-                                      .undoPremultipliedAlpha = parameters.undoPremultipliedAlpha};
+                                      .undoPremultipliedAlpha = parameters.undoPremultipliedAlpha,
+                                      .useToneMapLut = useToneMapLut};
 
         auto effectIter = mRuntimeEffects.find(effect);
         sk_sp<SkRuntimeEffect> runtimeEffect = nullptr;
@@ -527,11 +590,19 @@ sk_sp<SkShader> SkiaRenderEngine::createRuntimeEffectShader(
         const auto targetBuffer = parameters.layer.source.buffer.buffer;
         const auto graphicBuffer = targetBuffer ? targetBuffer->getBuffer() : nullptr;
         const auto hardwareBuffer = graphicBuffer ? graphicBuffer->toAHardwareBuffer() : nullptr;
+        const auto toneMapLut = useToneMapLut
+                ? mToneMapLutCache.get(
+                          shaders::getToneMapLut(effect, parameters.display.maxLuminance,
+                                                 parameters.display.currentLuminanceNits,
+                                                 parameters.layer.source.buffer.maxLuminanceNits,
+                                                 parameters.display.renderIntent))
+                : nullptr;
         return createLinearEffectShader(parameters.shader, effect, runtimeEffect,
                                         std::move(colorTransform), parameters.display.maxLuminance,
                                         parameters.display.currentLuminanceNits,
                                         parameters.layer.source.buffer.maxLuminanceNits,
-                                        hardwareBuffer, parameters.display.renderIntent);
+                                        hardwareBuffer, parameters.display.renderIntent,
+                                        toneMapLut);
     }
     return parameters.shader;
 }
@@ -805,12 +876,6 @@ void SkiaRenderEngine::drawLayersInternal(
         if (mBlurFilter && layerHasBlur(layer, ctModifiesAlpha)) {
             std::unordered_map<uint32_t, sk_sp<SkImage>> cachedBlurs;
 
-            // if multiple layers have blur, then we need to take a snapshot now because
-            // only the lowest layer will have blurImage populated earlier
-            if (!blurInput) {
-                blurInput = activeSurface->makeImageSnapshot();
-            }
-
             // rect to be blurred in the coordinate space of blurInput
             SkRect blurRect = canvas->getTotalMatrix().mapRect(bounds.rect());
 
@@ -834,26 +899,70 @@ void SkiaRenderEngine::drawLayersInternal(
 
             // TODO(b/182216890): Filter out empty layers earlier
             if (blurRect.width() > 0 && blurRect.height() > 0) {
+                // Reuse the blurs generated by previous frames if the content below this layer
+                // did not change. The unblurred input is then only needed to cross-fade small
+                // radii.
+                const auto contentHash =
+                        BlurCache::hashContent(display, buffer->getBuffer()->getPixelFormat(),
+                                               displayDimmingRatio, layers,
+                                               static_cast<size_t>(&layer - layers.data()));
+                const auto getBlurKey = [&](uint32_t radius) {
+                    return BlurCache::Key{.contentHash = *contentHash,
+                                          .radius = radius,
+                                          .blurRect = blurRect,
+                                          .context = grContext};
+                };
+
+                std::vector<uint32_t> radii;
                 if (layer.backgroundBlurRadius > 0) {
-                    ATRACE_NAME("BackgroundBlur");
-                    auto blurredImage = mBlurFilter->generate(grContext, layer.backgroundBlurRadius,
-                                                              blurInput, blurRect);
+                    radii.push_back(static_cast<uint32_t>(layer.backgroundBlurRadius));
+                }
+                for (const auto& region : layer.blurRegions) {
+                    radii.push_back(region.blurRadius);
+                }
+                bool needsInput = false;
+                for (const uint32_t radius : radii) {
+                    needsInput |= radius < mBlurFilter->getMaxCrossFadeRadius();
+                    if (cachedBlurs.count(radius)) {
+                        continue;
+                    }
+                    sk_sp<SkImage> blurredImage;
+                    if (contentHash) {
+                        blurredImage = mBlurCache.get(getBlurKey(radius));
+                    } else {
+                        mBlurCache.countUncacheable();
+                    }
+                    needsInput |= blurredImage == nullptr;
+                    cachedBlurs[radius] = std::move(blurredImage);
+                }
 
-                    cachedBlurs[layer.backgroundBlurRadius] = blurredImage;
+                // if multiple layers have blur, then we need to take a snapshot now because
+                // only the lowest layer will have blurImage populated earlier. Skip it when
+                // possible, since drawing to a surface that has a snapshot copies the surface.
+                if (needsInput && !blurInput) {
+                    blurInput = activeSurface->makeImageSnapshot();
+                }
+
+                for (auto& [radius, blurredImage] : cachedBlurs) {
+                    if (blurredImage == nullptr) {
+                        ATRACE_NAME("GenerateBlur");
+                        blurredImage =
+                                mBlurFilter->generate(grContext, radius, blurInput, blurRect);
+                        if (contentHash) {
+                            mBlurCache.insert(getBlurKey(radius), blurredImage);
+                        }
+                    }
+                }
 
+                if (layer.backgroundBlurRadius > 0) {
+                    ATRACE_NAME("BackgroundBlur");
                     mBlurFilter->drawBlurRegion(canvas, bounds, layer.backgroundBlurRadius, 1.0f,
-                                                blurRect, blurredImage, blurInput);
+                                                blurRect, cachedBlurs[layer.backgroundBlurRadius],
+                                                blurInput);
                 }
 
                 canvas->concat(getSkM44(layer.blurRegionTransform).asM33());
                 for (auto region : layer.blurRegions) {
-                    if (cachedBlurs[region.blurRadius] == nullptr) {
-                        ATRACE_NAME("BlurRegion");
-                        cachedBlurs[region.blurRadius] =
-                                mBlurFilter->generate(grContext, region.blurRadius, blurInput,
-                                                      blurRect);
-                    }
-
                     mBlurFilter->drawBlurRegion(canvas, getBlurRRect(region), region.blurRadius,
                                                 region.alpha, blurRect,
                                                 cachedBlurs[region.blurRadius], blurInput);
@@ -919,6 +1028,11 @@ void SkiaRenderEngine::drawLayersInternal(
                 (dimInLinearSpace && !equalsWithinMargin(1.f, layerDimmingRatio)) ||
                 (!dimInLinearSpace && isExtendedHdr);
 
+        if (mShaderKeyCache.isEnabled()) {
+            mShaderKeyCache.record(
+                    ShaderKey::from(display, layer, !equalsWithinMargin(1.f, layerDimmingRatio)));
+        }
+
         // quick abort from drawing the remaining portion of the layer
         if (layer.skipContentDraw ||
             (layer.alpha == 0 && !requiresLinearEffect && !layer.disableBlending &&
@@ -1148,6 +1262,7 @@ void SkiaRenderEngine::drawLayersInternal(
     }
 
     auto drawFence = sp<Fence>::make(flushAndSubmit(grContext));
+    mShaderKeyCache.saveIfNeeded(mSkSLCacheMonitor.totalShadersCompiled());
 
     if (ATRACE_ENABLED()) {
         static gui::FenceMonitor sMonitor("RE Completion");
@@ -1209,6 +1324,7 @@ void SkiaRenderEngine::dump(std::string& result) {
     StringAppendF(&result, "RenderEngine is in protected context: %d\n", mInProtectedContext);
     StringAppendF(&result, "RenderEngine shaders cached since last dump/primeCache: %d\n",
                   mSkSLCacheMonitor.shadersCachedSinceLastCall());
+    mShaderKeyCache.dump(result, mSkSLCacheMonitor.totalShadersCompiled());
 
     std::vector<ResourcePair> cpuResourceMap = {
             {"skia/sk_resource_cache/bitmap_", "Bitmaps"},
@@ -1246,14 +1362,8 @@ void SkiaRenderEngine::dump(std::string& result) {
         for (const auto& [id, refCounts] : mGraphicBufferExternalRefs) {
             StringAppendF(&result, "- 0x%" PRIx64 " - %d refs \n", id, refCounts);
         }
-        StringAppendF(&result, "RenderEngine AHB/BackendTexture cache size: %zu\n",
-                      mTextureCache.size());
-        StringAppendF(&result, "Dumping buffer ids...\n");
-        // TODO(178539829): It would be nice to know which layer these are coming from and what
-        // the texture sizes are.
-        for (const auto& [id, unused] : mTextureCache) {
-            StringAppendF(&result, "- 0x%" PRIx64 "\n", id);
-        }
+        mTextureCache.dump(result);
+        mBlurCache.dump(result);
         StringAppendF(&result, "\n");
 
         SkiaMemoryReporter gpuProtectedReporter(gpuResourceMap, true);
@@ -1279,7 +1389,10 @@ void SkiaRenderEngine::dump(std::string& result) {
                                   .c_str());
             StringAppendF(&result, "undoPremultipliedAlpha: %s\n",
                           linearEffect.undoPremultipliedAlpha ? "true" : "false");
+            StringAppendF(&result, "useToneMapLut: %s\n",
+                          linearEffect.useToneMapLut ? "true" : "false");
         }
+        mToneMapLutCache.dump(result);
     }
     StringAppendF(&result, "\n");
 }
@@ -32,9 +32,13 @@
 #include <unordered_map>
 
 #include "AutoBackendTexture.h"
+#include "BlurCache.h"
 #include "GrContextOptions.h"
 #include "SkImageInfo.h"
+#include "ShaderKeyCache.h"
 #include "SkiaRenderEngine.h"
+#include "TextureCache.h"
+#include "ToneMapLutCache.h"
 #include "android-base/macros.h"
 #include "debug/SkiaCapture.h"
 #include "filters/BlurFilter.h"
@@ -62,12 +66,13 @@ public:
     SkiaRenderEngine(RenderEngineType type,
                      PixelFormat pixelFormat,
                      bool useColorManagement,
-                     bool supportsBackgroundBlur);
+                     bool supportsBackgroundBlur,
+                     bool isBackgroundContext);
     ~SkiaRenderEngine() override;
 
     std::future<void> primeCache() override final;
     void cleanupPostRender() override final;
-    void cleanFramebufferCache() override final{ }
+    void cleanFramebufferCache() override final;
     bool supportsBackgroundBlur() override final {
         return mBlurFilter != nullptr;
     }
@@ -162,6 +167,8 @@ private:
 
     const PixelFormat mDefaultPixelFormat;
     const bool mUseColorManagement;
+    // Whether LinearEffects that tone map sample the curve from a lookup table.
+    const bool mUseToneMapLut;
 
     // Identifier used for various mappings of layers to various
     // textures or shaders
@@ -173,16 +180,17 @@ private:
     // For GL, this cache is shared between protected and unprotected contexts. For Vulkan, it is
     // only used for the unprotected context, because Vulkan does not allow sharing between
     // contexts, and protected is less common.
-    std::unordered_map<GraphicBufferId, std::shared_ptr<AutoBackendTexture::LocalRef>> mTextureCache
-            GUARDED_BY(mRenderingMutex);
+    TextureCache mTextureCache GUARDED_BY(mRenderingMutex);
     std::unordered_map<shaders::LinearEffect, sk_sp<SkRuntimeEffect>, shaders::LinearEffectHasher>
             mRuntimeEffects;
+    ToneMapLutCache mToneMapLutCache;
     AutoBackendTexture::CleanupManager mTextureCleanupMgr GUARDED_BY(mRenderingMutex);
 
     StretchShaderFactory mStretchShaderFactory;
 
     sp<Fence> mLastDrawFence;
     BlurFilter* mBlurFilter = nullptr;
+    BlurCache mBlurCache GUARDED_BY(mRenderingMutex);
 
     // Object to capture commands send to Skia.
     std::unique_ptr<SkiaCapture> mCapture;
@@ -191,6 +199,7 @@ private:
     // rendering that is potentially modified by multiple threads is guaranteed thread-safe.
     mutable std::mutex mRenderingMutex;
     SkSLCacheMonitor mSkSLCacheMonitor;
+    ShaderKeyCache mShaderKeyCache;
 
     // Graphics context used for creating surfaces and submitting commands
     sk_sp<GrDirectContext> mGrContext;
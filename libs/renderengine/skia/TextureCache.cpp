@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCache.h"
+
+#include <android-base/stringprintf.h>
+#include <ui/PixelFormat.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+using base::StringAppendF;
+
+TextureCache::TextureRef TextureCache::get(BufferId id) {
+    const auto it = mEntries.find(id);
+    if (it == mEntries.end()) {
+        return nullptr;
+    }
+    mLru.splice(mLru.begin(), mLru, it->second.lruPosition);
+    return it->second.texture;
+}
+
+void TextureCache::insert(BufferId id, TextureRef texture, size_t bytes, bool isRenderable) {
+    if (const auto it = mEntries.find(id); it != mEntries.end()) {
+        mBytes -= it->second.bytes;
+        mLru.erase(it->second.lruPosition);
+        mEntries.erase(it);
+    }
+    if (mEvicted.erase(id) > 0) {
+        mStats.reimports++;
+    }
+
+    mLru.push_front(id);
+    mEntries.emplace(id, Entry{std::move(texture), bytes, isRenderable, mLru.begin()});
+    mBytes += bytes;
+
+    evictToBudget(id);
+}
+
+std::optional<bool> TextureCache::getEvictedRenderability(BufferId id) const {
+    if (const auto it = mEvicted.find(id); it != mEvicted.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+void TextureCache::erase(BufferId id) {
+    mEvicted.erase(id);
+    if (const auto it = mEntries.find(id); it != mEntries.end()) {
+        mBytes -= it->second.bytes;
+        mLru.erase(it->second.lruPosition);
+        mEntries.erase(it);
+    }
+}
+
+void TextureCache::evictToBudget(BufferId keep) {
+    if (mBudgetBytes == 0) {
+        return;
+    }
+    while (mBytes > mBudgetBytes && !mLru.empty() && mLru.back() != keep) {
+        const BufferId id = mLru.back();
+        const auto it = mEntries.find(id);
+        mEvicted.emplace(id, it->second.isRenderable);
+        mStats.evictions++;
+        mStats.evictedBytes += it->second.bytes;
+        mBytes -= it->second.bytes;
+        mEntries.erase(it);
+        mLru.pop_back();
+    }
+}
+
+size_t TextureCache::estimateBytes(const GraphicBuffer& buffer) {
+    const size_t pixels = static_cast<size_t>(buffer.getStride()) * buffer.getHeight() *
+            std::max(buffer.getLayerCount(), 1u);
+    const uint32_t bytesPerPixel = android::bytesPerPixel(buffer.getPixelFormat());
+    // Formats without a fixed pixel size are mostly YUV, which use 12 bits per pixel.
+    return bytesPerPixel > 0 ? pixels * bytesPerPixel : pixels * 3 / 2;
+}
+
+void TextureCache::dump(std::string& result) const {
+    StringAppendF(&result, "RenderEngine AHB/BackendTexture cache size: %zu (%zu KiB", size(),
+                  mBytes / 1024);
+    if (mBudgetBytes > 0) {
+        StringAppendF(&result, " of %zu KiB budget", mBudgetBytes / 1024);
+    }
+    StringAppendF(&result, "), %zu evictions (%zu KiB), %zu reimports\n", mStats.evictions,
+                  mStats.evictedBytes / 1024, mStats.reimports);
+    StringAppendF(&result, "Dumping buffer ids, most recently used first...\n");
+    // TODO(178539829): It would be nice to know which layer these are coming from.
+    for (const BufferId id : mLru) {
+        StringAppendF(&result, "- 0x%" PRIx64 " - %zu KiB\n", id, mEntries.at(id).bytes / 1024);
+    }
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
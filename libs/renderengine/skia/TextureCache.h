@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ui/GraphicBuffer.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "AutoBackendTexture.h"
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * Caches the backend textures of buffers mapped into RenderEngine, keyed by buffer id. The cache
+ * may be bounded by an estimate of the memory its textures use, in which case the least recently
+ * drawn textures are evicted first. Evicting a texture does not unmap its buffer: the texture is
+ * imported again the next time the buffer is drawn, which is counted as a reimport.
+ */
+class TextureCache {
+public:
+    using BufferId = uint64_t;
+    using TextureRef = std::shared_ptr<AutoBackendTexture::LocalRef>;
+
+    struct Stats {
+        size_t evictions = 0;
+        size_t evictedBytes = 0;
+        // Textures imported again after being evicted while their buffer was still mapped.
+        size_t reimports = 0;
+    };
+
+    // A budget of 0 leaves the cache unbounded.
+    explicit TextureCache(size_t budgetBytes = 0) : mBudgetBytes(budgetBytes) {}
+
+    // Returns the texture cached for the buffer, or nullptr if there is none, and marks it as the
+    // most recently used.
+    TextureRef get(BufferId id);
+    bool contains(BufferId id) const { return mEntries.count(id) > 0; }
+
+    // Caches the texture, then evicts the least recently used textures until the cache is within
+    // its budget. The inserted texture is never evicted, even if it exceeds the budget by itself.
+    void insert(BufferId id, TextureRef texture, size_t bytes, bool isRenderable);
+    // Removes the texture of a buffer that is no longer mapped.
+    void erase(BufferId id);
+    // If the texture of the buffer was evicted since it was last inserted, returns whether it was
+    // renderable, so that the texture can be imported again the same way.
+    std::optional<bool> getEvictedRenderability(BufferId id) const;
+
+    size_t size() const { return mEntries.size(); }
+    size_t getBytes() const { return mBytes; }
+    size_t getBudget() const { return mBudgetBytes; }
+    const Stats& getStats() const { return mStats; }
+
+    // Estimates the memory the texture of a buffer uses.
+    static size_t estimateBytes(const GraphicBuffer& buffer);
+
+    void dump(std::string& result) const;
+
+private:
+    void evictToBudget(BufferId keep);
+
+    struct Entry {
+        TextureRef texture;
+        size_t bytes = 0;
+        bool isRenderable = false;
+        std::list<BufferId>::iterator lruPosition;
+    };
+
+    const size_t mBudgetBytes;
+    size_t mBytes = 0;
+
+    std::unordered_map<BufferId, Entry> mEntries;
+    // Most recently used first.
+    std::list<BufferId> mLru;
+    // Buffers that are still mapped, but whose texture was evicted, and whether it was renderable.
+    std::unordered_map<BufferId, bool> mEvicted;
+
+    Stats mStats;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ToneMapLutCache.h"
+
+#include <SkBitmap.h>
+#include <SkColor.h>
+#include <SkImageInfo.h>
+#include <android-base/stringprintf.h>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+using base::StringAppendF;
+
+sk_sp<SkImage> ToneMapLutCache::get(const std::shared_ptr<const LookupTable>& table) {
+    if (!table) {
+        return nullptr;
+    }
+    for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+        if (it->first == table) {
+            mEntries.splice(mEntries.begin(), mEntries, it);
+            mStats.hits++;
+            return mEntries.front().second;
+        }
+    }
+    mStats.misses++;
+
+    auto image = makeImage(table->gains);
+    mEntries.emplace_front(table, image);
+    if (mEntries.size() > kMaxEntries) {
+        mEntries.pop_back();
+    }
+    return image;
+}
+
+sk_sp<SkImage> ToneMapLutCache::makeImage(const std::vector<float>& gains) {
+    // Half floats keep about three significant digits, which is plenty for a gain, and unlike
+    // 32-bit floats they can be sampled with linear filtering on all devices.
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::Make(static_cast<int>(gains.size()), 1,
+                                         kRGBA_F16_SkColorType, kPremul_SkAlphaType));
+    for (size_t i = 0; i < gains.size(); i++) {
+        bitmap.erase(SkColor4f{gains[i], gains[i], gains[i], 1.f},
+                     SkIRect::MakeXYWH(static_cast<int>(i), 0, 1, 1));
+    }
+    bitmap.setImmutable();
+    return bitmap.asImage();
+}
+
+void ToneMapLutCache::clear() {
+    mEntries.clear();
+}
+
+void ToneMapLutCache::dump(std::string& result) const {
+    StringAppendF(&result, "Tone map LUT cache: %zu/%zu entries, hits/misses: %zu/%zu\n",
+                  mEntries.size(), kMaxEntries, mStats.hits, mStats.misses);
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkImage.h>
+#include <tonemap/tonemap.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * Caches the images of the tone mapping lookup tables of the LinearEffects that use one, which
+ * are bound to the effect as a child shader. libtonemap returns the same table for as long as the
+ * dataspaces and the luminance of the display and of the content do not change, e.g. for all
+ * frames of an HDR video, so the image is identified by its table, and Skia uploads it to a
+ * texture only once.
+ */
+class ToneMapLutCache {
+public:
+    using LookupTable = tonemap::ToneMapper::LookupTable;
+
+    // Most devices draw few HDR dataspaces, to few displays.
+    static constexpr size_t kMaxEntries = 8;
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    // Returns the image of the lookup table, creating it if it is not cached, or nullptr if there
+    // is no table.
+    sk_sp<SkImage> get(const std::shared_ptr<const LookupTable>& table);
+
+    // Stores the gains in the red channel of a width x 1 half float image.
+    static sk_sp<SkImage> makeImage(const std::vector<float>& gains);
+
+    void clear();
+
+    size_t size() const { return mEntries.size(); }
+    const Stats& getStats() const { return mStats; }
+
+    void dump(std::string& result) const;
+
+private:
+    // Most recently used first. The tables are kept, so that their addresses are not reused.
+    std::list<std::pair<std::shared_ptr<const LookupTable>, sk_sp<SkImage>>> mEntries;
+    Stats mStats;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "DualKawaseBlurFilter.h"
+#include <SkCanvas.h>
+#include <SkRuntimeEffect.h>
+#include <SkString.h>
+#include <log/log.h>
+#include <utils/Trace.h>
+
+#include <cmath>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+static sk_sp<SkRuntimeEffect> makeEffect(const char* sksl) {
+    auto [effect, error] = SkRuntimeEffect::MakeForShader(SkString(sksl));
+    if (!effect) {
+        LOG_ALWAYS_FATAL("RuntimeShader error: %s", error.c_str());
+    }
+    return effect;
+}
+
+DualKawaseBlurFilter::DualKawaseBlurFilter() : BlurFilter() {
+    // The child is sampled at twice the resolution of the output.
+    mDownsampleEffect = makeEffect(R"(
+        uniform shader child;
+        uniform float in_blurOffset;
+
+        half4 main(float2 xy) {
+            half4 c = child.eval(xy) * 4.0;
+            c += child.eval(xy + float2(+in_blurOffset, +in_blurOffset));
+            c += child.eval(xy + float2(+in_blurOffset, -in_blurOffset));
+            c += child.eval(xy + float2(-in_blurOffset, -in_blurOffset));
+            c += child.eval(xy + float2(-in_blurOffset, +in_blurOffset));
+            return half4(c.rgb * 0.125, 1.0);
+        }
+    )");
+
+    // The child is sampled at half the resolution of the output.
+    mUpsampleEffect = makeEffect(R"(
+        uniform shader child;
+        uniform float in_blurOffset;
+
+        half4 main(float2 xy) {
+            half4 c = child.eval(xy + float2(-2.0 * in_blurOffset, 0.0));
+            c += child.eval(xy + float2(0.0, +2.0 * in_blurOffset));
+            c += child.eval(xy + float2(+2.0 * in_blurOffset, 0.0));
+            c += child.eval(xy + float2(0.0, -2.0 * in_blurOffset));
+            c += child.eval(xy + float2(-in_blurOffset, +in_blurOffset)) * 2.0;
+            c += child.eval(xy + float2(+in_blurOffset, +in_blurOffset)) * 2.0;
+            c += child.eval(xy + float2(+in_blurOffset, -in_blurOffset)) * 2.0;
+            c += child.eval(xy + float2(-in_blurOffset, -in_blurOffset)) * 2.0;
+            return half4(c.rgb / 12.0, 1.0);
+        }
+    )");
+}
+
+uint32_t DualKawaseBlurFilter::getPasses(uint32_t radius, float* offset) {
+    // A pass at 1/2^k of the resolution spreads the samples by 2^k times its offset, so the passes
+    // down to 1/2^n and back up to kInputScale spread them by the offset times:
+    // (2 + ... + 2^n) + (2^(n-1) + ... + 4) = 3 * 2^n - 6
+    const auto spread = [](uint32_t passes) { return 3.0f * static_cast<float>(1 << passes) - 6; };
+    uint32_t passes = kMinPasses;
+    while (passes < kMaxPasses && radius > kMaxOffset * spread(passes)) {
+        passes++;
+    }
+    *offset = static_cast<float>(radius) / spread(passes);
+    return passes;
+}
+
+static SkImageInfo getPassInfo(const sk_sp<SkImage>& input, const SkRect& blurRect,
+                               uint32_t pass) {
+    const float scale = 1.0f / static_cast<float>(1 << pass);
+    return input->imageInfo().makeWH(std::max(1.0f, std::ceil(blurRect.width() * scale)),
+                                     std::max(1.0f, std::ceil(blurRect.height() * scale)));
+}
+
+sk_sp<SkImage> DualKawaseBlurFilter::generate(GrRecordingContext* context,
+                                              const uint32_t blurRadius,
+                                              const sk_sp<SkImage> input,
+                                              const SkRect& blurRect) const {
+    float offset;
+    const uint32_t passes = getPasses(blurRadius, &offset);
+
+    // For sampling Skia's API expects the inverse of what logically seems appropriate, see
+    // KawaseBlurFilter.
+    SkMatrix blurMatrix = SkMatrix::Translate(-blurRect.fLeft, -blurRect.fTop);
+    blurMatrix.postScale(0.5f, 0.5f);
+
+    SkSamplingOptions linear(SkFilterMode::kLinear, SkMipmapMode::kNone);
+    SkRuntimeShaderBuilder downsampleBuilder(mDownsampleEffect);
+    downsampleBuilder.child("child") =
+            input->makeShader(SkTileMode::kClamp, SkTileMode::kClamp, linear, blurMatrix);
+    downsampleBuilder.uniform("in_blurOffset") = offset;
+    sk_sp<SkImage> tmpBlur(
+            downsampleBuilder.makeImage(context, nullptr, getPassInfo(input, blurRect, 1), false));
+
+    for (uint32_t pass = 2; pass <= passes; pass++) {
+        downsampleBuilder.child("child") =
+                tmpBlur->makeShader(SkTileMode::kClamp, SkTileMode::kClamp, linear,
+                                    SkMatrix::Scale(0.5f, 0.5f));
+        tmpBlur = downsampleBuilder.makeImage(context, nullptr,
+                                              getPassInfo(input, blurRect, pass), false);
+    }
+
+    SkRuntimeShaderBuilder upsampleBuilder(mUpsampleEffect);
+    upsampleBuilder.uniform("in_blurOffset") = offset;
+    for (uint32_t pass = passes - 1; pass >= kMinPasses; pass--) {
+        upsampleBuilder.child("child") =
+                tmpBlur->makeShader(SkTileMode::kClamp, SkTileMode::kClamp, linear,
+                                    SkMatrix::Scale(2.0f, 2.0f));
+        tmpBlur = upsampleBuilder.makeImage(context, nullptr, getPassInfo(input, blurRect, pass),
+                                            false);
+    }
+
+    return tmpBlur;
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "BlurFilter.h"
+#include <SkCanvas.h>
+#include <SkImage.h>
+#include <SkRuntimeEffect.h>
+#include <SkSurface.h>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * This is an implementation of the dual filter Kawase blur, as described in the same notes as
+ * KawaseBlurFilter. Each pass halves the resolution on the way down, then doubles it on the way
+ * up, so the number of passes grows with the log of the radius and large radii are blurred at a
+ * small fraction of the cost of blurring them at kInputScale. The passes stop going up at
+ * kInputScale, which is the resolution drawBlurRegion expects.
+ */
+class DualKawaseBlurFilter : public BlurFilter {
+public:
+    // Number of passes down to kInputScale
+    static constexpr uint32_t kMinPasses = 2;
+    // Maximum number of passes down, so at most 1/64 of the resolution
+    static constexpr uint32_t kMaxPasses = 6;
+    // Maximum sample offset at each resolution before an extra pass is used, in pixels
+    static constexpr float kMaxOffset = 2.0f;
+
+    explicit DualKawaseBlurFilter();
+    virtual ~DualKawaseBlurFilter() {}
+
+    // Execute blur, saving it to a texture
+    sk_sp<SkImage> generate(GrRecordingContext* context, const uint32_t radius,
+                            const sk_sp<SkImage> blurInput, const SkRect& blurRect) const override;
+
+    // Returns the number of passes down used for a radius, and sets the sample offset of each
+    // pass, in pixels at the resolution of the pass.
+    static uint32_t getPasses(uint32_t radius, float* offset);
+
+private:
+    sk_sp<SkRuntimeEffect> mDownsampleEffect;
+    sk_sp<SkRuntimeEffect> mUpsampleEffect;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
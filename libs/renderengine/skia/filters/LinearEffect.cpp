@@ -44,11 +44,19 @@ sk_sp<SkShader> createLinearEffectShader(
         sk_sp<SkShader> shader, const shaders::LinearEffect& linearEffect,
         sk_sp<SkRuntimeEffect> runtimeEffect, const mat4& colorTransform, float maxDisplayLuminance,
         float currentDisplayLuminanceNits, float maxLuminance, AHardwareBuffer* buffer,
-        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent) {
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent,
+        sk_sp<SkImage> toneMapLut) {
     ATRACE_CALL();
     SkRuntimeShaderBuilder effectBuilder(runtimeEffect);
 
     effectBuilder.child("child") = shader;
+    if (linearEffect.useToneMapLut) {
+        LOG_ALWAYS_FATAL_IF(!toneMapLut, "Missing the tone mapping lookup table");
+        // The gains must not be color managed.
+        effectBuilder.child("in_toneMapLut") =
+                toneMapLut->makeRawShader(SkTileMode::kClamp, SkTileMode::kClamp,
+                                          SkSamplingOptions(SkFilterMode::kLinear));
+    }
 
     const auto uniforms =
             shaders::buildLinearEffectUniforms(linearEffect, colorTransform, maxDisplayLuminance,
@@ -21,6 +21,7 @@
 #include <optional>
 
 #include <shaders/shaders.h>
+#include "SkImage.h"
 #include "SkRuntimeEffect.h"
 #include "SkShader.h"
 #include "ui/GraphicTypes.h"
@@ -44,11 +45,13 @@ sk_sp<SkRuntimeEffect> buildRuntimeEffect(const shaders::LinearEffect& linearEff
 // communicating any HDR metadata.
 // * A RenderIntent that communicates the downstream renderintent for a physical display, for image
 // quality compensation.
+// * The tone mapping lookup table built for the above, if the effect uses one.
 sk_sp<SkShader> createLinearEffectShader(
         sk_sp<SkShader> inputShader, const shaders::LinearEffect& linearEffect,
         sk_sp<SkRuntimeEffect> runtimeEffect, const mat4& colorTransform, float maxDisplayLuminance,
         float currentDisplayLuminanceNits, float maxLuminance, AHardwareBuffer* buffer,
-        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent);
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent,
+        sk_sp<SkImage> toneMapLut = nullptr);
 } // namespace skia
 } // namespace renderengine
 } // namespace android
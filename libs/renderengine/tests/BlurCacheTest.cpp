@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SkSurface.h>
+#include <gtest/gtest.h>
+#include <renderengine/mock/FakeExternalTexture.h>
+
+#include "../skia/BlurCache.h"
+#include "../skia/filters/DualKawaseBlurFilter.h"
+
+namespace android {
+namespace {
+
+using renderengine::DisplaySettings;
+using renderengine::LayerSettings;
+using renderengine::skia::BlurCache;
+using renderengine::skia::DualKawaseBlurFilter;
+
+constexpr PixelFormat kOutputFormat = PIXEL_FORMAT_RGBA_8888;
+
+LayerSettings makeBufferLayer(uint64_t id, uint64_t frameNumber, uint64_t usage = 0) {
+    LayerSettings layer;
+    layer.geometry.boundaries = FloatRect(0, 0, 100, 100);
+    layer.source.buffer.buffer =
+            std::make_shared<renderengine::mock::FakeExternalTexture>(100, 100, id,
+                                                                      kOutputFormat, usage);
+    layer.source.buffer.frameNumber = frameNumber;
+    layer.alpha = 1.f;
+    return layer;
+}
+
+LayerSettings makeBlurLayer() {
+    LayerSettings layer;
+    layer.geometry.boundaries = FloatRect(10, 10, 50, 50);
+    layer.alpha = 1.f;
+    layer.skipContentDraw = true;
+    layer.backgroundBlurRadius = 60;
+    return layer;
+}
+
+std::optional<uint64_t> hashBelowLast(const std::vector<LayerSettings>& layers,
+                                      const DisplaySettings& display = DisplaySettings()) {
+    return BlurCache::hashContent(display, kOutputFormat, 1.f, layers, layers.size() - 1);
+}
+
+sk_sp<SkImage> makeImage() {
+    return SkSurface::MakeRaster(SkImageInfo::MakeN32Premul(1, 1))->makeImageSnapshot();
+}
+
+BlurCache::Key makeKey(uint64_t contentHash) {
+    return BlurCache::Key{.contentHash = contentHash,
+                          .radius = 60,
+                          .blurRect = SkRect::MakeWH(100, 100)};
+}
+
+TEST(BlurCacheTest, hashIgnoresLayersAboveBlur) {
+    const auto layers = std::vector<LayerSettings>{makeBufferLayer(1, 1), makeBlurLayer()};
+    auto layersWithDialog = layers;
+    layersWithDialog.push_back(makeBufferLayer(2, 7));
+
+    const auto hash = hashBelowLast(layers);
+    ASSERT_TRUE(hash);
+    EXPECT_EQ(hash, BlurCache::hashContent(DisplaySettings(), kOutputFormat, 1.f,
+                                           layersWithDialog, 1));
+}
+
+TEST(BlurCacheTest, hashChangesWithContentBelowBlur) {
+    const auto layers = std::vector<LayerSettings>{makeBufferLayer(1, 1), makeBlurLayer()};
+    const auto hash = hashBelowLast(layers);
+    ASSERT_TRUE(hash);
+
+    auto nextFrame = layers;
+    nextFrame[0].source.buffer.frameNumber = 2;
+    EXPECT_NE(hash, hashBelowLast(nextFrame));
+
+    auto otherBuffer = layers;
+    otherBuffer[0] = makeBufferLayer(2, 1);
+    EXPECT_NE(hash, hashBelowLast(otherBuffer));
+
+    auto moved = layers;
+    moved[0].geometry.positionTransform = mat4::translate(vec4(1, 0, 0, 0));
+    EXPECT_NE(hash, hashBelowLast(moved));
+
+    DisplaySettings dimmed;
+    dimmed.targetLuminanceNits = 100.f;
+    EXPECT_NE(hash, hashBelowLast(layers, dimmed));
+}
+
+TEST(BlurCacheTest, unidentifiedContentIsNotHashed) {
+    EXPECT_FALSE(hashBelowLast({makeBufferLayer(1, 0), makeBlurLayer()}));
+    EXPECT_FALSE(hashBelowLast(
+            {makeBufferLayer(1, 1, AHARDWAREBUFFER_USAGE_FRONT_BUFFER), makeBlurLayer()}));
+
+    LayerSettings color;
+    color.source.solidColor = half3(1.f, 0.f, 0.f);
+    color.alpha = 1.f;
+    EXPECT_TRUE(hashBelowLast({color, makeBlurLayer()}));
+}
+
+TEST(BlurCacheTest, evictsLeastRecentlyUsed) {
+    BlurCache cache;
+    for (uint64_t hash = 0; hash < BlurCache::kMaxEntries; hash++) {
+        cache.insert(makeKey(hash), makeImage());
+    }
+    EXPECT_NE(nullptr, cache.get(makeKey(0)));
+
+    cache.insert(makeKey(BlurCache::kMaxEntries), makeImage());
+
+    EXPECT_EQ(BlurCache::kMaxEntries, cache.size());
+    EXPECT_NE(nullptr, cache.get(makeKey(0)));
+    EXPECT_EQ(nullptr, cache.get(makeKey(1)));
+    EXPECT_EQ(2u, cache.getStats().hits);
+    EXPECT_EQ(1u, cache.getStats().misses);
+}
+
+TEST(BlurCacheTest, keyIncludesRadiusAndBounds) {
+    BlurCache cache;
+    cache.insert(makeKey(1), makeImage());
+
+    auto otherRadius = makeKey(1);
+    otherRadius.radius = 30;
+    EXPECT_EQ(nullptr, cache.get(otherRadius));
+
+    auto otherBounds = makeKey(1);
+    otherBounds.blurRect = SkRect::MakeWH(50, 100);
+    EXPECT_EQ(nullptr, cache.get(otherBounds));
+
+    cache.clear();
+    EXPECT_EQ(nullptr, cache.get(makeKey(1)));
+}
+
+TEST(BlurCacheTest, dualKawasePassesGrowWithRadius) {
+    float offset;
+    EXPECT_EQ(DualKawaseBlurFilter::kMinPasses, DualKawaseBlurFilter::getPasses(4, &offset));
+    EXPECT_FLOAT_EQ(4.f / 6.f, offset);
+
+    uint32_t previousPasses = 0;
+    for (uint32_t radius = 1; radius <= 400; radius++) {
+        const uint32_t passes = DualKawaseBlurFilter::getPasses(radius, &offset);
+        EXPECT_GE(passes, previousPasses);
+        EXPECT_LE(passes, DualKawaseBlurFilter::kMaxPasses);
+        if (passes < DualKawaseBlurFilter::kMaxPasses) {
+            EXPECT_LE(offset, DualKawaseBlurFilter::kMaxOffset);
+        }
+        previousPasses = passes;
+    }
+}
+
+} // namespace
+} // namespace android
@@ -66,4 +66,13 @@ TEST(DisplaySettingsTest, renderIntent) {
 
     ASSERT_FALSE(a == b);
 }
+
+TEST(DisplaySettingsTest, isDeferrable) {
+    DisplaySettings a, b;
+    ASSERT_EQ(a, b);
+
+    a.isDeferrable = true;
+
+    ASSERT_FALSE(a == b);
+}
 } // namespace android::renderengine
@@ -165,6 +165,42 @@ TEST_F(RenderEngineThreadedTest, drawLayers) {
     ASSERT_TRUE(result.ok());
 }
 
+TEST_F(RenderEngineThreadedTest, drawLayers_mapsDeferredTextures) {
+    renderengine::DisplaySettings settings;
+    using Usage = renderengine::impl::ExternalTexture::Usage;
+    auto layerTexture =
+            std::make_shared<renderengine::impl::ExternalTexture>(sp<GraphicBuffer>::make(),
+                                                                  *mRenderEngine,
+                                                                  Usage::READABLE |
+                                                                          Usage::DEFER_MAPPING);
+    ASSERT_FALSE(layerTexture->isMapped());
+    renderengine::LayerSettings layer;
+    layer.source.buffer.buffer = layerTexture;
+    std::vector<renderengine::LayerSettings> layers = {std::move(layer)};
+    std::shared_ptr<renderengine::ExternalTexture> buffer = std::make_shared<
+            renderengine::impl::
+                    ExternalTexture>(sp<GraphicBuffer>::make(), *mRenderEngine,
+                                     renderengine::impl::ExternalTexture::Usage::READABLE |
+                                             renderengine::impl::ExternalTexture::Usage::WRITEABLE);
+
+    base::unique_fd bufferFence;
+
+    EXPECT_CALL(*mRenderEngine, useProtectedContext(false));
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) { resultPromise->set_value(Fence::NO_FENCE); });
+
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers(settings, layers, buffer, false, std::move(bufferFence));
+    ASSERT_TRUE(future.valid());
+    auto result = future.get();
+    ASSERT_TRUE(result.ok());
+    EXPECT_TRUE(layerTexture->isMapped());
+}
+
 TEST_F(RenderEngineThreadedTest, drawLayers_protectedLayer) {
     renderengine::DisplaySettings settings;
     auto layerBuffer = sp<GraphicBuffer>::make();
@@ -226,4 +262,202 @@ TEST_F(RenderEngineThreadedTest, drawLayers_protectedOutputBuffer) {
     ASSERT_TRUE(result.ok());
 }
 
+TEST_F(RenderEngineThreadedTest, unmapCancelsPendingImport) {
+    renderengine::DisplaySettings settings;
+    std::vector<renderengine::LayerSettings> layers;
+    using Usage = renderengine::impl::ExternalTexture::Usage;
+    std::shared_ptr<renderengine::ExternalTexture> buffer =
+            std::make_shared<renderengine::impl::ExternalTexture>(sp<GraphicBuffer>::make(),
+                                                                  *mRenderEngine,
+                                                                  Usage::READABLE |
+                                                                          Usage::WRITEABLE);
+
+    // Keep the thread busy drawing, so that it cannot import the buffer before it is unmapped.
+    std::promise<void> unblock;
+    EXPECT_CALL(*mRenderEngine, useProtectedContext(false));
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) {
+                unblock.get_future().wait();
+                resultPromise->set_value(Fence::NO_FENCE);
+            });
+
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers(settings, layers, buffer, false, base::unique_fd());
+    {
+        // Maps the buffer on creation, and unmaps it on destruction.
+        renderengine::impl::ExternalTexture texture(sp<GraphicBuffer>::make(), *mThreadedRE,
+                                                    Usage::READABLE);
+    }
+    unblock.set_value();
+    ASSERT_TRUE(future.get().ok());
+
+    const auto stats = mThreadedRE->getPreImportStats();
+    EXPECT_EQ(0u, stats.idleImports);
+    EXPECT_EQ(0u, stats.drawImports);
+    EXPECT_EQ(1u, stats.cancelledImports);
+}
+
+TEST_F(RenderEngineThreadedTest, drawLayers_importsPendingBuffers) {
+    renderengine::DisplaySettings settings;
+    std::vector<renderengine::LayerSettings> layers;
+    using Usage = renderengine::impl::ExternalTexture::Usage;
+    std::shared_ptr<renderengine::ExternalTexture> buffer =
+            std::make_shared<renderengine::impl::ExternalTexture>(sp<GraphicBuffer>::make(),
+                                                                  *mRenderEngine,
+                                                                  Usage::READABLE |
+                                                                          Usage::WRITEABLE);
+
+    std::promise<void> unblock;
+    EXPECT_CALL(*mRenderEngine, useProtectedContext(false)).Times(2);
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) {
+                unblock.get_future().wait();
+                resultPromise->set_value(Fence::NO_FENCE);
+            })
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) { resultPromise->set_value(Fence::NO_FENCE); });
+
+    ftl::Future<FenceResult> blockingFuture =
+            mThreadedRE->drawLayers(settings, layers, buffer, false, base::unique_fd());
+
+    renderengine::LayerSettings layer;
+    layer.source.buffer.buffer =
+            std::make_shared<renderengine::impl::ExternalTexture>(sp<GraphicBuffer>::make(),
+                                                                  *mThreadedRE, Usage::READABLE);
+    layers.push_back(std::move(layer));
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers(settings, layers, buffer, false, base::unique_fd());
+    unblock.set_value();
+    ASSERT_TRUE(blockingFuture.get().ok());
+    ASSERT_TRUE(future.get().ok());
+
+    const auto stats = mThreadedRE->getPreImportStats();
+    EXPECT_EQ(0u, stats.idleImports);
+    EXPECT_EQ(1u, stats.drawImports);
+    EXPECT_EQ(0u, stats.cancelledImports);
+}
+
+struct RenderEngineThreadedBackgroundTest : public ::testing::Test {
+    void SetUp() override {
+        mThreadedRE = renderengine::threaded::RenderEngineThreaded::create(
+                [this]() { return std::unique_ptr<renderengine::RenderEngine>(mRenderEngine); },
+                renderengine::RenderEngine::RenderEngineType::THREADED, [this]() {
+                    return std::unique_ptr<renderengine::RenderEngine>(mBackgroundRenderEngine);
+                });
+    }
+
+    std::shared_ptr<renderengine::ExternalTexture> createBuffer() {
+        using Usage = renderengine::impl::ExternalTexture::Usage;
+        return std::make_shared<renderengine::impl::ExternalTexture>(sp<GraphicBuffer>::make(),
+                                                                     *mRenderEngine,
+                                                                     Usage::READABLE |
+                                                                             Usage::WRITEABLE);
+    }
+
+    std::unique_ptr<renderengine::threaded::RenderEngineThreaded> mThreadedRE;
+    renderengine::mock::RenderEngine* mRenderEngine = new renderengine::mock::RenderEngine();
+    renderengine::mock::RenderEngine* mBackgroundRenderEngine =
+            new renderengine::mock::RenderEngine();
+};
+
+TEST_F(RenderEngineThreadedBackgroundTest, drawsDeferrableWorkInBackground) {
+    const renderengine::DisplaySettings settings{.isDeferrable = true};
+    std::vector<renderengine::LayerSettings> layers;
+
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal).Times(0);
+    EXPECT_CALL(*mBackgroundRenderEngine, useProtectedContext(false));
+    EXPECT_CALL(*mBackgroundRenderEngine, canSkipPostRenderCleanup()).WillOnce(Return(false));
+    EXPECT_CALL(*mBackgroundRenderEngine, cleanupPostRender());
+    EXPECT_CALL(*mBackgroundRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings& display,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) {
+                EXPECT_TRUE(display.isDeferrable);
+                resultPromise->set_value(Fence::NO_FENCE);
+            });
+
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers(settings, layers, createBuffer(), false, base::unique_fd());
+    ASSERT_TRUE(future.get().ok());
+
+    const auto stats = mThreadedRE->getBackgroundQueueStats();
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(1u, stats->started);
+    EXPECT_EQ(0u, stats->depth);
+}
+
+TEST_F(RenderEngineThreadedBackgroundTest, displayIsNotBlockedByDeferrableWork) {
+    std::vector<renderengine::LayerSettings> layers;
+    const auto buffer = createBuffer();
+
+    // Keep the background thread busy until the display has been drawn.
+    std::promise<void> unblock;
+    EXPECT_CALL(*mBackgroundRenderEngine, useProtectedContext(false));
+    EXPECT_CALL(*mBackgroundRenderEngine, canSkipPostRenderCleanup()).WillOnce(Return(true));
+    EXPECT_CALL(*mBackgroundRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) {
+                unblock.get_future().wait();
+                resultPromise->set_value(Fence::NO_FENCE);
+            });
+    EXPECT_CALL(*mRenderEngine, useProtectedContext(false));
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) { resultPromise->set_value(Fence::NO_FENCE); });
+
+    ftl::Future<FenceResult> deferredFuture =
+            mThreadedRE->drawLayers({.isDeferrable = true}, layers, buffer, false,
+                                    base::unique_fd());
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers({}, layers, buffer, false, base::unique_fd());
+    ASSERT_TRUE(future.get().ok());
+    unblock.set_value();
+    ASSERT_TRUE(deferredFuture.get().ok());
+
+    EXPECT_EQ(1u, mThreadedRE->getQueueStats().started);
+}
+
+TEST_F(RenderEngineThreadedTest, drawsDeferrableWorkWithoutBackgroundContext) {
+    const renderengine::DisplaySettings settings{.isDeferrable = true};
+    std::vector<renderengine::LayerSettings> layers;
+    using Usage = renderengine::impl::ExternalTexture::Usage;
+    std::shared_ptr<renderengine::ExternalTexture> buffer =
+            std::make_shared<renderengine::impl::ExternalTexture>(sp<GraphicBuffer>::make(),
+                                                                  *mRenderEngine,
+                                                                  Usage::READABLE |
+                                                                          Usage::WRITEABLE);
+
+    EXPECT_CALL(*mRenderEngine, useProtectedContext(false));
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal)
+            .WillOnce([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                          const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) { resultPromise->set_value(Fence::NO_FENCE); });
+
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers(settings, layers, buffer, false, base::unique_fd());
+    ASSERT_TRUE(future.get().ok());
+    EXPECT_FALSE(mThreadedRE->getBackgroundQueueStats());
+}
+
 } // namespace android
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../skia/ShaderKeyCache.h"
+
+namespace android {
+namespace {
+
+using renderengine::DisplaySettings;
+using renderengine::LayerSettings;
+using renderengine::skia::ShaderKey;
+using renderengine::skia::ShaderKeyCache;
+
+// The tests never save, so the file is only read, and does not exist.
+constexpr const char* kPath = "/data/local/tmp/ShaderKeyCacheTest_keys";
+
+ShaderKey makeKey(ui::Dataspace sourceDataspace) {
+    ShaderKey key;
+    key.source = ShaderKey::Source::SolidColor;
+    key.sourceDataspace = sourceDataspace;
+    key.outputDataspace = ui::Dataspace::SRGB;
+    return key;
+}
+
+TEST(ShaderKeyCacheTest, keyFromLayerSettings) {
+    const DisplaySettings display{.outputDataspace = ui::Dataspace::DISPLAY_P3};
+    const LayerSettings layer{
+            .geometry =
+                    renderengine::Geometry{
+                            .boundaries = FloatRect(0, 0, 100, 80),
+                            .roundedCornersRadius = {10.f, 20.f},
+                            .roundedCornersCrop = FloatRect(0, 0, 100, 100),
+                    },
+            .alpha = 0.5f,
+            .sourceDataspace = ui::Dataspace::SRGB,
+            .backgroundBlurRadius = 60,
+    };
+
+    const auto key = ShaderKey::from(display, layer, true);
+    EXPECT_EQ(ShaderKey::Source::SolidColor, key.source);
+    EXPECT_EQ(ShaderKey::Transform::Identity, key.transform);
+    EXPECT_EQ(ShaderKey::Corners::Elliptical, key.corners);
+    EXPECT_TRUE(key.clipsCorners);
+    EXPECT_TRUE(key.isTranslucent);
+    EXPECT_FALSE(key.isTransparent);
+    EXPECT_EQ(ShaderKey::Blur::Large, key.blur);
+    EXPECT_TRUE(key.isDimmed);
+    EXPECT_EQ(ui::Dataspace::SRGB, key.sourceDataspace);
+    EXPECT_EQ(ui::Dataspace::DISPLAY_P3, key.outputDataspace);
+
+    EXPECT_EQ(key, ShaderKey::from(display, layer, true));
+    EXPECT_NE(key, ShaderKey::from(display, layer, false));
+}
+
+TEST(ShaderKeyCacheTest, keyRoundTripsThroughString) {
+    ShaderKey key = makeKey(ui::Dataspace::BT2020_PQ);
+    key.source = ShaderKey::Source::Buffer;
+    key.bufferFormat = PIXEL_FORMAT_RGBA_FP16;
+    key.isOpaque = true;
+    key.transform = ShaderKey::Transform::Rotation;
+    key.corners = ShaderKey::Corners::Circular;
+    key.hasStretch = true;
+    key.dimsInGammaSpace = true;
+
+    const auto parsed = ShaderKey::fromString(key.toString());
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(key, *parsed);
+
+    EXPECT_FALSE(ShaderKey::fromString("not a key"));
+    EXPECT_FALSE(ShaderKey::fromString("ffffffff 1 0 0"));
+}
+
+TEST(ShaderKeyCacheTest, warmsMostFrequentlyDrawnKeysFirst) {
+    ShaderKeyCache cache(kPath);
+    ASSERT_TRUE(cache.isEnabled());
+    const auto rare = makeKey(ui::Dataspace::SRGB);
+    const auto common = makeKey(ui::Dataspace::DISPLAY_P3);
+    cache.record(rare);
+    for (int i = 0; i < 4; i++) {
+        cache.record(common);
+    }
+
+    ShaderKeyCache nextBoot(kPath);
+    nextBoot.deserialize(cache.serialize(0));
+
+    const auto keys = nextBoot.getWarmUpKeys();
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_EQ(common, keys[0]);
+    EXPECT_EQ(rare, keys[1]);
+}
+
+TEST(ShaderKeyCacheTest, doesNotRecordWarmUp) {
+    ShaderKeyCache cache(kPath);
+    cache.setWarmingUp(true);
+    cache.record(makeKey(ui::Dataspace::SRGB));
+    cache.setWarmingUp(false);
+
+    EXPECT_TRUE(cache.getWarmUpKeys().empty());
+    EXPECT_EQ(0u, cache.getBootStats(0).newKeys);
+}
+
+TEST(ShaderKeyCacheTest, disabledWithoutPath) {
+    ShaderKeyCache cache("");
+    EXPECT_FALSE(cache.isEnabled());
+    cache.record(makeKey(ui::Dataspace::SRGB));
+    EXPECT_TRUE(cache.getWarmUpKeys().empty());
+}
+
+TEST(ShaderKeyCacheTest, countsCacheMissesPerBoot) {
+    ShaderKeyCache cache(kPath);
+    cache.record(makeKey(ui::Dataspace::SRGB));
+    cache.onWarmUpFinished(1, ms2ns(5), 10);
+
+    auto stats = cache.getBootStats(13);
+    EXPECT_EQ(3, stats.shaderCacheMisses);
+    EXPECT_EQ(1u, stats.newKeys);
+
+    ShaderKeyCache nextBoot(kPath);
+    nextBoot.deserialize(cache.serialize(13));
+    nextBoot.record(makeKey(ui::Dataspace::SRGB));
+    stats = nextBoot.getBootStats(0);
+    EXPECT_EQ(0, stats.shaderCacheMisses);
+    EXPECT_EQ(0u, stats.newKeys);
+
+    std::string dump;
+    nextBoot.dump(dump, 0);
+    EXPECT_NE(std::string::npos, dump.find("misses/new keys): 3/1\n"));
+}
+
+TEST(ShaderKeyCacheTest, ignoresUnknownFormat) {
+    ShaderKeyCache cache(kPath);
+    cache.deserialize("# some other file\nkey 1 0 0 0 0\n");
+    EXPECT_TRUE(cache.getWarmUpKeys().empty());
+}
+
+} // namespace
+} // namespace android
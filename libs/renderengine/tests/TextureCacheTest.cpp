@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../skia/TextureCache.h"
+
+namespace android {
+namespace {
+
+using renderengine::skia::TextureCache;
+
+// The tests only track which buffers are cached, so they do not import any textures.
+constexpr size_t kTextureBytes = 1024;
+
+TEST(TextureCacheTest, unboundedCacheDoesNotEvict) {
+    TextureCache cache;
+    for (uint64_t id = 0; id < 100; id++) {
+        cache.insert(id, nullptr, kTextureBytes, false);
+    }
+
+    EXPECT_EQ(100u, cache.size());
+    EXPECT_EQ(100 * kTextureBytes, cache.getBytes());
+    EXPECT_EQ(0u, cache.getStats().evictions);
+}
+
+TEST(TextureCacheTest, evictsLeastRecentlyUsedToStayWithinBudget) {
+    TextureCache cache(3 * kTextureBytes);
+    cache.insert(1, nullptr, kTextureBytes, false);
+    cache.insert(2, nullptr, kTextureBytes, true);
+    cache.insert(3, nullptr, kTextureBytes, false);
+    cache.get(1);
+
+    cache.insert(4, nullptr, kTextureBytes, false);
+
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(3 * kTextureBytes, cache.getBytes());
+    EXPECT_TRUE(cache.contains(1));
+    EXPECT_FALSE(cache.contains(2));
+    EXPECT_TRUE(cache.contains(3));
+    EXPECT_TRUE(cache.contains(4));
+
+    const auto isRenderable = cache.getEvictedRenderability(2);
+    ASSERT_TRUE(isRenderable);
+    EXPECT_TRUE(*isRenderable);
+    EXPECT_FALSE(cache.getEvictedRenderability(1));
+    EXPECT_EQ(1u, cache.getStats().evictions);
+    EXPECT_EQ(kTextureBytes, cache.getStats().evictedBytes);
+}
+
+TEST(TextureCacheTest, keepsTextureLargerThanBudget) {
+    TextureCache cache(2 * kTextureBytes);
+    cache.insert(1, nullptr, kTextureBytes, false);
+    cache.insert(2, nullptr, 4 * kTextureBytes, false);
+
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_TRUE(cache.contains(2));
+    EXPECT_EQ(4 * kTextureBytes, cache.getBytes());
+}
+
+TEST(TextureCacheTest, countsReimportsOfEvictedTextures) {
+    TextureCache cache(kTextureBytes);
+    cache.insert(1, nullptr, kTextureBytes, false);
+    cache.insert(2, nullptr, kTextureBytes, false);
+    cache.insert(1, nullptr, kTextureBytes, false);
+
+    EXPECT_EQ(2u, cache.getStats().evictions);
+    EXPECT_EQ(1u, cache.getStats().reimports);
+    EXPECT_TRUE(cache.contains(1));
+    EXPECT_FALSE(cache.getEvictedRenderability(1));
+    EXPECT_TRUE(cache.getEvictedRenderability(2));
+}
+
+TEST(TextureCacheTest, eraseForgetsEvictedTextures) {
+    TextureCache cache(kTextureBytes);
+    cache.insert(1, nullptr, kTextureBytes, false);
+    cache.insert(2, nullptr, kTextureBytes, false);
+    cache.erase(1);
+    cache.erase(2);
+
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.getBytes());
+    EXPECT_FALSE(cache.getEvictedRenderability(1));
+
+    cache.insert(1, nullptr, kTextureBytes, false);
+    EXPECT_EQ(0u, cache.getStats().reimports);
+}
+
+TEST(TextureCacheTest, estimatesBytesFromFormat) {
+    const auto rgba = sp<GraphicBuffer>::make(100u, 10u, PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+    const auto fp16 = sp<GraphicBuffer>::make(100u, 10u, PIXEL_FORMAT_RGBA_FP16, 1u, 0u);
+    if (rgba->initCheck() != NO_ERROR || fp16->initCheck() != NO_ERROR) {
+        GTEST_SKIP() << "Could not allocate buffers";
+    }
+
+    EXPECT_EQ(static_cast<size_t>(rgba->getStride()) * 10 * 4,
+              TextureCache::estimateBytes(*rgba));
+    EXPECT_EQ(static_cast<size_t>(fp16->getStride()) * 10 * 8,
+              TextureCache::estimateBytes(*fp16));
+}
+
+} // namespace
+} // namespace android
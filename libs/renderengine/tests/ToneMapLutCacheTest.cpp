@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../skia/ToneMapLutCache.h"
+
+namespace android {
+namespace {
+
+using renderengine::skia::ToneMapLutCache;
+
+std::shared_ptr<const ToneMapLutCache::LookupTable> makeTable(float gain) {
+    auto table = std::make_shared<ToneMapLutCache::LookupTable>();
+    table->gains.assign(tonemap::ToneMapper::kLookupTableSize, gain);
+    return table;
+}
+
+TEST(ToneMapLutCacheTest, reusesImageOfSameTable) {
+    ToneMapLutCache cache;
+    const auto table = makeTable(0.5f);
+    const auto lut = cache.get(table);
+    ASSERT_TRUE(lut);
+    EXPECT_EQ(static_cast<int>(tonemap::ToneMapper::kLookupTableSize), lut->width());
+    EXPECT_EQ(1, lut->height());
+
+    EXPECT_EQ(lut, cache.get(table));
+    EXPECT_NE(lut, cache.get(makeTable(0.5f)));
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(1u, cache.getStats().hits);
+    EXPECT_EQ(2u, cache.getStats().misses);
+}
+
+TEST(ToneMapLutCacheTest, evictsLeastRecentlyUsed) {
+    ToneMapLutCache cache;
+    std::vector<std::shared_ptr<const ToneMapLutCache::LookupTable>> tables;
+    for (size_t i = 0; i <= ToneMapLutCache::kMaxEntries; i++) {
+        tables.push_back(makeTable(1.f));
+    }
+    const auto first = cache.get(tables[0]);
+    for (size_t i = 1; i < ToneMapLutCache::kMaxEntries; i++) {
+        cache.get(tables[i]);
+    }
+    EXPECT_EQ(first, cache.get(tables[0]));
+
+    // Evicts the second table, which is now the least recently used.
+    cache.get(tables.back());
+    EXPECT_EQ(ToneMapLutCache::kMaxEntries, cache.size());
+    EXPECT_EQ(first, cache.get(tables[0]));
+    const auto misses = cache.getStats().misses;
+    cache.get(tables[1]);
+    EXPECT_EQ(misses + 1, cache.getStats().misses);
+}
+
+TEST(ToneMapLutCacheTest, ignoresMissingTable) {
+    ToneMapLutCache cache;
+    EXPECT_FALSE(cache.get(nullptr));
+    EXPECT_EQ(0u, cache.size());
+
+    cache.get(makeTable(1.f));
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+}
+
+} // namespace
+} // namespace android
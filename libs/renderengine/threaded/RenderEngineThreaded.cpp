@@ -19,6 +19,7 @@
 #include "RenderEngineThreaded.h"
 
 #include <sched.h>
+#include <algorithm>
 #include <chrono>
 #include <future>
 
@@ -35,26 +36,40 @@ namespace android {
 namespace renderengine {
 namespace threaded {
 
-std::unique_ptr<RenderEngineThreaded> RenderEngineThreaded::create(CreateInstanceFactory factory,
-                                                                   RenderEngineType type) {
-    return std::make_unique<RenderEngineThreaded>(std::move(factory), type);
+std::unique_ptr<RenderEngineThreaded> RenderEngineThreaded::create(
+        CreateInstanceFactory factory, RenderEngineType type,
+        CreateInstanceFactory backgroundFactory) {
+    return std::make_unique<RenderEngineThreaded>(std::move(factory), type,
+                                                  std::move(backgroundFactory));
 }
 
-RenderEngineThreaded::RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type)
-      : RenderEngine(type) {
+RenderEngineThreaded::RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type,
+                                           CreateInstanceFactory backgroundFactory)
+      : RenderEngine(type), mHasBackgroundContext(backgroundFactory != nullptr) {
     ATRACE_CALL();
 
-    std::lock_guard lockThread(mThreadMutex);
-    mThread = std::thread(&RenderEngineThreaded::threadMain, this, factory);
+    {
+        std::lock_guard lockThread(mThreadMutex);
+        mThread = std::thread(&RenderEngineThreaded::threadMain, this, factory);
+    }
+    if (mHasBackgroundContext) {
+        std::lock_guard lockThread(mBackgroundMutex);
+        mBackgroundThread =
+                std::thread(&RenderEngineThreaded::backgroundThreadMain, this, backgroundFactory);
+    }
 }
 
 RenderEngineThreaded::~RenderEngineThreaded() {
     mRunning = false;
     mCondition.notify_one();
+    mBackgroundCondition.notify_one();
 
     if (mThread.joinable()) {
         mThread.join();
     }
+    if (mBackgroundThread.joinable()) {
+        mBackgroundThread.join();
+    }
 }
 
 status_t RenderEngineThreaded::setSchedFifo(bool enabled) {
@@ -103,9 +118,16 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
         const auto getNextTask = [this]() -> std::optional<Work> {
             std::scoped_lock lock(mThreadMutex);
             if (!mFunctionCalls.empty()) {
-                Work task = mFunctionCalls.front();
-                mFunctionCalls.pop();
-                return std::make_optional<Work>(task);
+                return std::make_optional<Work>(popWork(mFunctionCalls, mQueueStats));
+            }
+            if (!mPendingImports.empty()) {
+                PendingImport import = std::move(mPendingImports.front());
+                mPendingImports.pop_front();
+                mPreImportStats.idleImports++;
+                return std::make_optional<Work>([import](renderengine::RenderEngine& instance) {
+                    ATRACE_NAME("REThreaded::preImportExternalTextureBuffer");
+                    instance.mapExternalTextureBuffer(import.buffer, import.isRenderable);
+                });
             }
             return std::nullopt;
         };
@@ -118,7 +140,7 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
 
         std::unique_lock<std::mutex> lock(mThreadMutex);
         mCondition.wait(lock, [this]() REQUIRES(mThreadMutex) {
-            return !mRunning || !mFunctionCalls.empty();
+            return !mRunning || !mFunctionCalls.empty() || !mPendingImports.empty();
         });
     }
 
@@ -126,6 +148,63 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
     mRenderEngine.reset();
 }
 
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void RenderEngineThreaded::backgroundThreadMain(CreateInstanceFactory factory)
+        NO_THREAD_SAFETY_ANALYSIS {
+    ATRACE_CALL();
+
+    // The thread inherits the policy of the thread that created RenderEngine, which may be
+    // SCHED_FIFO, but it must not preempt composition.
+    if (setSchedFifo(false) != NO_ERROR) {
+        ALOGW("Couldn't set SCHED_OTHER for the background thread");
+    }
+
+    mBackgroundRenderEngine = factory();
+
+    pthread_setname_np(pthread_self(), mBackgroundThreadName);
+
+    while (mRunning) {
+        std::unique_lock<std::mutex> lock(mBackgroundMutex);
+        mBackgroundCondition.wait(lock, [this]() REQUIRES(mBackgroundMutex) {
+            return !mRunning || !mBackgroundFunctionCalls.empty();
+        });
+        if (!mRunning) {
+            break;
+        }
+        const Work task = popWork(mBackgroundFunctionCalls, mBackgroundQueueStats);
+        lock.unlock();
+
+        task(*mBackgroundRenderEngine);
+    }
+
+    // we must release the RenderEngine on the thread that created it
+    mBackgroundRenderEngine.reset();
+}
+
+RenderEngineThreaded::Work RenderEngineThreaded::popWork(std::queue<QueuedWork>& calls,
+                                                         QueueStats& stats) {
+    stats.maxDepth = std::max(stats.maxDepth, calls.size());
+    QueuedWork queued = std::move(calls.front());
+    calls.pop();
+
+    const nsecs_t wait = systemTime() - queued.queueTime;
+    stats.started++;
+    stats.totalWait += wait;
+    stats.maxWait = std::max(stats.maxWait, wait);
+    return std::move(queued.work);
+}
+
+void RenderEngineThreaded::queueBackgroundWork(Work work) {
+    if (!mHasBackgroundContext) {
+        return;
+    }
+    {
+        std::lock_guard lock(mBackgroundMutex);
+        mBackgroundFunctionCalls.push(std::move(work));
+    }
+    mBackgroundCondition.notify_one();
+}
+
 void RenderEngineThreaded::waitUntilInitialized() const {
     std::unique_lock<std::mutex> lock(mInitializedMutex);
     mInitializedCondition.wait(lock, [=] { return mIsInitialized; });
@@ -173,6 +252,48 @@ void RenderEngineThreaded::dump(std::string& result) {
     mCondition.notify_one();
     // Note: This is an rvalue.
     result.assign(resultFuture.get());
+
+    const auto stats = getPreImportStats();
+    base::StringAppendF(&result,
+                        "RenderEngine pre-imports: %zu while idle, %zu before drawing, %zu "
+                        "cancelled\n",
+                        stats.idleImports, stats.drawImports, stats.cancelledImports);
+
+    const auto dumpQueueStats = [&result](const char* name, const QueueStats& stats) {
+        base::StringAppendF(&result,
+                            "RenderEngine %s queue: %zu queued (max %zu), %zu started, waited "
+                            "%.3f ms on average, %.3f ms at most\n",
+                            name, stats.depth, stats.maxDepth, stats.started,
+                            stats.started ? ns2us(stats.totalWait / stats.started) / 1000.f : 0.f,
+                            ns2us(stats.maxWait) / 1000.f);
+    };
+    dumpQueueStats("main", getQueueStats());
+    if (const auto backgroundStats = getBackgroundQueueStats()) {
+        dumpQueueStats("background", *backgroundStats);
+    }
+}
+
+RenderEngineThreaded::PreImportStats RenderEngineThreaded::getPreImportStats() const {
+    std::lock_guard lock(mThreadMutex);
+    return mPreImportStats;
+}
+
+RenderEngineThreaded::QueueStats RenderEngineThreaded::getQueueStats() const {
+    std::lock_guard lock(mThreadMutex);
+    QueueStats stats = mQueueStats;
+    stats.depth = mFunctionCalls.size();
+    return stats;
+}
+
+std::optional<RenderEngineThreaded::QueueStats> RenderEngineThreaded::getBackgroundQueueStats()
+        const {
+    if (!mHasBackgroundContext) {
+        return std::nullopt;
+    }
+    std::lock_guard lock(mBackgroundMutex);
+    QueueStats stats = mBackgroundQueueStats;
+    stats.depth = mBackgroundFunctionCalls.size();
+    return stats;
 }
 
 void RenderEngineThreaded::genTextures(size_t count, uint32_t* names) {
@@ -222,10 +343,7 @@ void RenderEngineThreaded::mapExternalTextureBuffer(const sp<GraphicBuffer>& buf
     // for the futures.
     {
         std::lock_guard lock(mThreadMutex);
-        mFunctionCalls.push([=](renderengine::RenderEngine& instance) {
-            ATRACE_NAME("REThreaded::mapExternalTextureBuffer");
-            instance.mapExternalTextureBuffer(buffer, isRenderable);
-        });
+        mPendingImports.push_back({buffer, isRenderable});
     }
     mCondition.notify_one();
 }
@@ -236,6 +354,16 @@ void RenderEngineThreaded::unmapExternalTextureBuffer(sp<GraphicBuffer>&& buffer
     // for the futures.
     {
         std::lock_guard lock(mThreadMutex);
+        // If the buffer is still waiting to be imported, it needs neither the import nor the unmap.
+        if (const auto it = std::find_if(mPendingImports.begin(), mPendingImports.end(),
+                                         [&buffer](const PendingImport& import) {
+                                             return import.buffer == buffer;
+                                         });
+            it != mPendingImports.end()) {
+            mPendingImports.erase(it);
+            mPreImportStats.cancelledImports++;
+            return;
+        }
         mFunctionCalls.push(
                 [=, buffer = std::move(buffer)](renderengine::RenderEngine& instance) mutable {
                     ATRACE_NAME("REThreaded::unmapExternalTextureBuffer");
@@ -296,14 +424,39 @@ ftl::Future<FenceResult> RenderEngineThreaded::drawLayers(
         const std::shared_ptr<ExternalTexture>& buffer, const bool useFramebufferCache,
         base::unique_fd&& bufferFence) {
     ATRACE_CALL();
+    // Queues mapping any deferred textures ahead of drawing them.
+    mapDeferredTextures(layers);
     const auto resultPromise = std::make_shared<std::promise<FenceResult>>();
     std::future<FenceResult> resultFuture = resultPromise->get_future();
     int fd = bufferFence.release();
+    if (display.isDeferrable && mHasBackgroundContext) {
+        {
+            std::lock_guard lock(mBackgroundMutex);
+            mBackgroundFunctionCalls.push([resultPromise, display, layers, buffer,
+                                           useFramebufferCache,
+                                           fd](renderengine::RenderEngine& instance) {
+                ATRACE_NAME("REThreaded::drawLayersInBackground");
+                instance.updateProtectedContext(layers, buffer);
+                instance.drawLayersInternal(std::move(resultPromise), display, layers, buffer,
+                                            useFramebufferCache, base::unique_fd(fd));
+                // Nothing else is queued to clean up the background context, so do it now.
+                if (!instance.canSkipPostRenderCleanup()) {
+                    instance.cleanupPostRender();
+                }
+            });
+        }
+        mBackgroundCondition.notify_one();
+        return resultFuture;
+    }
     {
         std::lock_guard lock(mThreadMutex);
-        mFunctionCalls.push([resultPromise, display, layers, buffer, useFramebufferCache,
-                             fd](renderengine::RenderEngine& instance) {
+        auto imports = takePendingImports(layers, buffer);
+        mFunctionCalls.push([resultPromise, display, layers, buffer, useFramebufferCache, fd,
+                             imports = std::move(imports)](renderengine::RenderEngine& instance) {
             ATRACE_NAME("REThreaded::drawLayers");
+            for (const auto& import : imports) {
+                instance.mapExternalTextureBuffer(import.buffer, import.isRenderable);
+            }
             instance.updateProtectedContext(layers, buffer);
             instance.drawLayersInternal(std::move(resultPromise), display, layers, buffer,
                                         useFramebufferCache, base::unique_fd(fd));
@@ -313,6 +466,32 @@ ftl::Future<FenceResult> RenderEngineThreaded::drawLayers(
     return resultFuture;
 }
 
+std::vector<RenderEngineThreaded::PendingImport> RenderEngineThreaded::takePendingImports(
+        const std::vector<LayerSettings>& layers, const std::shared_ptr<ExternalTexture>& buffer) {
+    std::vector<PendingImport> imports;
+    if (mPendingImports.empty()) {
+        return imports;
+    }
+    const auto isDrawn = [&](const sp<GraphicBuffer>& pending) {
+        if (buffer && buffer->getBuffer() == pending) {
+            return true;
+        }
+        return std::any_of(layers.begin(), layers.end(), [&pending](const LayerSettings& layer) {
+            return layer.source.buffer.buffer && layer.source.buffer.buffer->getBuffer() == pending;
+        });
+    };
+    for (auto it = mPendingImports.begin(); it != mPendingImports.end();) {
+        if (isDrawn(it->buffer)) {
+            imports.push_back(std::move(*it));
+            it = mPendingImports.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    mPreImportStats.drawImports += imports.size();
+    return imports;
+}
+
 void RenderEngineThreaded::cleanFramebufferCache() {
     ATRACE_CALL();
     // This function is designed so it can run asynchronously, so we do not need to wait
@@ -325,6 +504,10 @@ void RenderEngineThreaded::cleanFramebufferCache() {
         });
     }
     mCondition.notify_one();
+    queueBackgroundWork([](renderengine::RenderEngine& instance) {
+        ATRACE_NAME("REThreaded::cleanFramebufferCache");
+        instance.cleanFramebufferCache();
+    });
 }
 
 int RenderEngineThreaded::getContextPriority() {
@@ -358,6 +541,10 @@ void RenderEngineThreaded::onActiveDisplaySizeChanged(ui::Size size) {
         });
     }
     mCondition.notify_one();
+    queueBackgroundWork([size](renderengine::RenderEngine& instance) {
+        ATRACE_NAME("REThreaded::onActiveDisplaySizeChanged");
+        instance.onActiveDisplaySizeChanged(size);
+    });
 }
 
 std::optional<pid_t> RenderEngineThreaded::getRenderEngineTid() const {
@@ -385,6 +572,10 @@ void RenderEngineThreaded::setEnableTracing(bool tracingEnabled) {
         });
     }
     mCondition.notify_one();
+    queueBackgroundWork([tracingEnabled](renderengine::RenderEngine& instance) {
+        ATRACE_NAME("REThreaded::setEnableTracing");
+        instance.setEnableTracing(tracingEnabled);
+    });
 }
 } // namespace threaded
 } // namespace renderengine
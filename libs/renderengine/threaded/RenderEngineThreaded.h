@@ -17,10 +17,15 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include <utils/Timers.h>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "renderengine/RenderEngine.h"
 
@@ -34,13 +39,20 @@ using CreateInstanceFactory = std::function<std::unique_ptr<renderengine::Render
  * This class extends a basic RenderEngine class. It contains a thread. Each time a function of
  * this class is called, we create a lambda function that is put on a queue. The main thread then
  * executes the functions in order.
+ *
+ * If a background factory is given, deferrable draws (see DisplaySettings::isDeferrable) are
+ * instead queued to a second thread, which draws them with the RenderEngine it creates, usually
+ * on a lower priority context. Composing displays then never waits behind them. The background
+ * RenderEngine does not import the buffers mapped into RenderEngineThreaded ahead of time.
  */
 class RenderEngineThreaded : public RenderEngine {
 public:
-    static std::unique_ptr<RenderEngineThreaded> create(CreateInstanceFactory factory,
-                                                        RenderEngineType type);
+    static std::unique_ptr<RenderEngineThreaded> create(
+            CreateInstanceFactory factory, RenderEngineType type,
+            CreateInstanceFactory backgroundFactory = nullptr);
 
-    RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type);
+    RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type,
+                         CreateInstanceFactory backgroundFactory = nullptr);
     ~RenderEngineThreaded() override;
     std::future<void> primeCache() override;
 
@@ -67,6 +79,30 @@ public:
     std::optional<pid_t> getRenderEngineTid() const override;
     void setEnableTracing(bool tracingEnabled) override;
 
+    struct PreImportStats {
+        // Buffers imported while the thread had no other work.
+        size_t idleImports = 0;
+        // Buffers imported just before the draw that needed them, as the thread did not idle
+        // before it.
+        size_t drawImports = 0;
+        // Buffers unmapped before they were imported, which skipped importing them altogether.
+        size_t cancelledImports = 0;
+    };
+    PreImportStats getPreImportStats() const;
+
+    struct QueueStats {
+        // Work queued, but not started yet.
+        size_t depth = 0;
+        size_t maxDepth = 0;
+        // Work started, and how long it was queued before it started.
+        size_t started = 0;
+        nsecs_t totalWait = 0;
+        nsecs_t maxWait = 0;
+    };
+    QueueStats getQueueStats() const;
+    // Returns std::nullopt if there is no background context.
+    std::optional<QueueStats> getBackgroundQueueStats() const;
+
 protected:
     void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable) override;
     void unmapExternalTextureBuffer(sp<GraphicBuffer>&& buffer) override;
@@ -79,6 +115,7 @@ protected:
 
 private:
     void threadMain(CreateInstanceFactory factory);
+    void backgroundThreadMain(CreateInstanceFactory factory);
     void waitUntilInitialized() const;
     static status_t setSchedFifo(bool enabled);
 
@@ -95,8 +132,35 @@ private:
     std::atomic<bool> mRunning = true;
 
     using Work = std::function<void(renderengine::RenderEngine&)>;
-    mutable std::queue<Work> mFunctionCalls GUARDED_BY(mThreadMutex);
+    struct QueuedWork {
+        template <typename F,
+                  typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, QueuedWork>>>
+        QueuedWork(F&& work) : work(std::forward<F>(work)), queueTime(systemTime()) {}
+
+        Work work;
+        nsecs_t queueTime;
+    };
+    mutable std::queue<QueuedWork> mFunctionCalls GUARDED_BY(mThreadMutex);
     mutable std::condition_variable mCondition;
+    QueueStats mQueueStats GUARDED_BY(mThreadMutex);
+
+    // Pops the next work of the queue, and records how long it was queued.
+    static Work popWork(std::queue<QueuedWork>& calls, QueueStats& stats);
+
+    // Importing a newly mapped buffer is deferred until the thread idles, rather than delaying
+    // the work queued after it. Imports still pending when a draw is queued run at the start of
+    // the draw, and imports still pending when their buffer is unmapped are dropped.
+    struct PendingImport {
+        sp<GraphicBuffer> buffer;
+        bool isRenderable;
+    };
+    std::deque<PendingImport> mPendingImports GUARDED_BY(mThreadMutex);
+    PreImportStats mPreImportStats GUARDED_BY(mThreadMutex);
+
+    // Removes the pending imports of the buffers the draw uses, so it can import them first.
+    std::vector<PendingImport> takePendingImports(const std::vector<LayerSettings>& layers,
+                                                  const std::shared_ptr<ExternalTexture>& buffer)
+            REQUIRES(mThreadMutex);
 
     // Used to allow select thread safe methods to be accessed without requiring the
     // method to be invoked on the RenderEngine thread
@@ -104,10 +168,25 @@ private:
     mutable std::mutex mInitializedMutex;
     mutable std::condition_variable mInitializedCondition;
 
+    /* ------------------------------------------------------------------------
+     * Background context
+     */
+    const char* const mBackgroundThreadName = "REBackground";
+    const bool mHasBackgroundContext;
+    mutable std::mutex mBackgroundMutex;
+    std::thread mBackgroundThread GUARDED_BY(mBackgroundMutex);
+    std::queue<QueuedWork> mBackgroundFunctionCalls GUARDED_BY(mBackgroundMutex);
+    std::condition_variable mBackgroundCondition;
+    QueueStats mBackgroundQueueStats GUARDED_BY(mBackgroundMutex);
+
+    // Queues work to keep the state of the background RenderEngine in sync, if there is one.
+    void queueBackgroundWork(Work work);
+
     /* ------------------------------------------------------------------------
      * Render Engine
      */
     std::unique_ptr<renderengine::RenderEngine> mRenderEngine;
+    std::unique_ptr<renderengine::RenderEngine> mBackgroundRenderEngine;
 };
 } // namespace threaded
 } // namespace renderengine
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <utils/RefBase.h>
 #include <utils/Looper.h>
@@ -38,8 +39,8 @@ namespace android {
 // ----------------------------------------------------------------------------
 
 SensorEventQueue::SensorEventQueue(const sp<ISensorEventConnection>& connection)
-    : mSensorEventConnection(connection), mRecBuffer(nullptr), mAvailable(0), mConsumed(0),
-      mNumAcksToSend(0) {
+    : mSensorEventConnection(connection), mRecBuffer(nullptr), mRecBufferPacketCount(1),
+      mAvailable(0), mConsumed(0), mNumAcksToSend(0) {
     mRecBuffer = new ASensorEvent[MAX_RECEIVE_BUFFER_EVENT_COUNT];
 }
 
@@ -65,13 +66,10 @@ ssize_t SensorEventQueue::write(const sp<BitTube>& tube,
 
 ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
     if (mAvailable == 0) {
-        ssize_t err = BitTube::recvObjects(mSensorChannel,
-                mRecBuffer, MAX_RECEIVE_BUFFER_EVENT_COUNT);
+        ssize_t err = receiveEvents(1);
         if (err < 0) {
             return err;
         }
-        mAvailable = static_cast<size_t>(err);
-        mConsumed = 0;
     }
     size_t count = min(numEvents, mAvailable);
     memcpy(events, mRecBuffer + mConsumed, count * sizeof(ASensorEvent));
@@ -80,6 +78,87 @@ ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
     return static_cast<ssize_t>(count);
 }
 
+ssize_t SensorEventQueue::readInPlace(ASensorEvent const** events) {
+    if (mAvailable == 0) {
+        if (mRecBufferPacketCount < 2) {
+            resizeReceiveBuffer(2);
+        }
+        ssize_t err = receiveEvents(mRecBufferPacketCount);
+        if (err < 0) {
+            return err;
+        }
+    }
+    *events = mRecBuffer + mConsumed;
+    const size_t count = mAvailable;
+    mAvailable = 0;
+    mConsumed += count;
+    return static_cast<ssize_t>(count);
+}
+
+ssize_t SensorEventQueue::receiveEvents(size_t packetCount) {
+    mAvailable = 0;
+    mConsumed = 0;
+#if defined(__linux__)
+    if (packetCount > 1) {
+        constexpr size_t packetSize = MAX_RECEIVE_BUFFER_EVENT_COUNT * sizeof(ASensorEvent);
+        iovec iovecs[MAX_RECEIVE_BUFFER_PACKET_COUNT];
+        mmsghdr messages[MAX_RECEIVE_BUFFER_PACKET_COUNT] = {};
+        for (size_t i = 0; i < packetCount; i++) {
+            iovecs[i].iov_base = mRecBuffer + i * MAX_RECEIVE_BUFFER_EVENT_COUNT;
+            iovecs[i].iov_len = packetSize;
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int received;
+        do {
+            received = ::recvmmsg(mSensorChannel->getFd(), messages, packetCount, MSG_DONTWAIT,
+                                  nullptr);
+        } while (received < 0 && errno == EINTR);
+        if (received < 0) {
+            // Like BitTube::read, there being no events is not an error.
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -errno;
+        }
+        // Pack the events of the packets behind the events of the first one.
+        size_t count = 0;
+        for (int i = 0; i < received; i++) {
+            const size_t size = messages[i].msg_len;
+            // should never happen because of SOCK_SEQPACKET
+            LOG_ALWAYS_FATAL_IF(size % sizeof(ASensorEvent),
+                                "SensorEventQueue::receiveEvents(size=%zu) partial events were "
+                                "received!", size);
+            ASensorEvent* packet = mRecBuffer + i * MAX_RECEIVE_BUFFER_EVENT_COUNT;
+            if (packet != mRecBuffer + count) {
+                memmove(mRecBuffer + count, packet, size);
+            }
+            count += size / sizeof(ASensorEvent);
+        }
+        mAvailable = count;
+        if (static_cast<size_t>(received) == mRecBufferPacketCount &&
+            mRecBufferPacketCount < MAX_RECEIVE_BUFFER_PACKET_COUNT) {
+            // More packets are likely waiting, the next receive gets them as well.
+            resizeReceiveBuffer(std::min<size_t>(mRecBufferPacketCount * 2,
+                                                 MAX_RECEIVE_BUFFER_PACKET_COUNT));
+        }
+        return static_cast<ssize_t>(count);
+    }
+#endif
+    ssize_t err = BitTube::recvObjects(mSensorChannel, mRecBuffer, MAX_RECEIVE_BUFFER_EVENT_COUNT);
+    if (err < 0) {
+        return err;
+    }
+    mAvailable = static_cast<size_t>(err);
+    return err;
+}
+
+void SensorEventQueue::resizeReceiveBuffer(size_t packetCount) {
+    ASensorEvent* buffer = new ASensorEvent[packetCount * MAX_RECEIVE_BUFFER_EVENT_COUNT];
+    memcpy(buffer, mRecBuffer + mConsumed, mAvailable * sizeof(ASensorEvent));
+    delete[] mRecBuffer;
+    mRecBuffer = buffer;
+    mRecBufferPacketCount = packetCount;
+    mConsumed = 0;
+}
+
 sp<Looper> SensorEventQueue::getLooper() const
 {
     Mutex::Autolock _l(mLock);
@@ -52,6 +52,9 @@ class SensorEventQueue : public ASensorEventQueue, public RefBase
 public:
 
     enum { MAX_RECEIVE_BUFFER_EVENT_COUNT = 256 };
+    // The maximum number of packets of events which readInPlace receives with a single system
+    // call. Every packet holds up to MAX_RECEIVE_BUFFER_EVENT_COUNT events.
+    enum { MAX_RECEIVE_BUFFER_PACKET_COUNT = 8 };
 
     /**
      * Typical sensor delay (sample period) in microseconds.
@@ -76,6 +79,18 @@ public:
 
     ssize_t read(ASensorEvent* events, size_t numEvents);
 
+    /**
+     * Returns all the events received and not read yet, and sets events to point to them in the
+     * receive buffer, without copying them. The events stay valid until the next call to read or
+     * readInPlace. Returns 0 if there are no events, or a negative error.
+     *
+     * When all the events were read, as many packets of events as are available are received
+     * with a single system call. The receive buffer starts with two packets, and doubles up to
+     * MAX_RECEIVE_BUFFER_PACKET_COUNT packets whenever a receive fills it, so that the clients of
+     * fast sensors, which find many packets at each read, need fewer system calls.
+     */
+    ssize_t readInPlace(ASensorEvent const** events);
+
     status_t waitForEvent() const;
     status_t wake() const;
 
@@ -102,11 +117,18 @@ public:
 
 private:
     sp<Looper> getLooper() const;
+    // Receives up to packetCount packets of events into the empty receive buffer, and returns the
+    // number of events received.
+    ssize_t receiveEvents(size_t packetCount);
+    void resizeReceiveBuffer(size_t packetCount);
+
     sp<ISensorEventConnection> mSensorEventConnection;
     sp<BitTube> mSensorChannel;
     mutable Mutex mLock;
     mutable sp<Looper> mLooper;
     ASensorEvent* mRecBuffer;
+    // The number of packets of MAX_RECEIVE_BUFFER_EVENT_COUNT events which mRecBuffer holds.
+    size_t mRecBufferPacketCount;
     size_t mAvailable;
     size_t mConsumed;
     uint32_t mNumAcksToSend;
@@ -21,6 +21,8 @@
 
 #include <android/sensor.h>
 #include <hardware/sensors-base.h>
+#include <sensor/BitTube.h>
+#include <sensor/ISensorEventConnection.h>
 #include <sensor/SensorManager.h>
 #include <sensor/SensorEventQueue.h>
 
@@ -169,4 +171,93 @@ TEST_F(SensorEventQueueTest, FilterEvents_ReconfigureAdditionalInfo) {
     runFilterTest(events);
 }
 
+// A connection which only provides the channel of the events, so that the reads of the queue are
+// tested without the sensor service.
+class FakeSensorEventConnection : public ISensorEventConnection {
+public:
+    // Large enough for the backlogs of the tests.
+    static constexpr size_t SOCKET_BUFFER_SIZE = 64 * 1024;
+
+    FakeSensorEventConnection() : mChannel(sp<BitTube>::make(SOCKET_BUFFER_SIZE)) {}
+
+    sp<BitTube> getSensorChannel() const override { return mChannel; }
+    status_t enableDisable(int, bool, nsecs_t, nsecs_t, int) override { return OK; }
+    status_t setEventRate(int, nsecs_t) override { return OK; }
+    status_t flush() override { return OK; }
+    int32_t configureChannel(int32_t, int32_t) override { return INVALID_OPERATION; }
+
+protected:
+    void destroy() override {}
+    IBinder* onAsBinder() override { return nullptr; }
+
+private:
+    const sp<BitTube> mChannel;
+};
+
+class SensorEventQueueReadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mConnection = sp<FakeSensorEventConnection>::make();
+        mQueue = sp<SensorEventQueue>::make(mConnection);
+    }
+
+    // Sends a packet of events with consecutive timestamps.
+    void sendEvents(size_t count) {
+        std::vector<ASensorEvent> events(count);
+        for (ASensorEvent& event : events) {
+            event.type = SENSOR_TYPE_ACCELEROMETER;
+            event.timestamp = mNextTimestamp++;
+        }
+        ASSERT_EQ(static_cast<ssize_t>(count),
+                  SensorEventQueue::write(mConnection->getSensorChannel(), events.data(), count));
+    }
+
+    sp<FakeSensorEventConnection> mConnection;
+    sp<SensorEventQueue> mQueue;
+    int64_t mNextTimestamp = 0;
+};
+
+TEST_F(SensorEventQueueReadTest, ReadInPlace_NoEvents) {
+    ASensorEvent const* events = nullptr;
+    EXPECT_EQ(0, mQueue->readInPlace(&events));
+}
+
+TEST_F(SensorEventQueueReadTest, ReadInPlace_ReceivesSeveralPackets) {
+    sendEvents(3);
+    sendEvents(5);
+    ASensorEvent const* events = nullptr;
+    ASSERT_EQ(8, mQueue->readInPlace(&events));
+    for (int64_t i = 0; i < 8; i++) {
+        EXPECT_EQ(i, events[i].timestamp);
+    }
+    EXPECT_EQ(0, mQueue->readInPlace(&events));
+}
+
+TEST_F(SensorEventQueueReadTest, ReadInPlace_GrowsWithTheBacklog) {
+    for (int i = 0; i < 20; i++) {
+        sendEvents(2);
+    }
+    // The buffer starts with two packets, and doubles whenever a receive fills it.
+    ASensorEvent const* events = nullptr;
+    int64_t timestamp = 0;
+    for (ssize_t expected : {4, 8, 16, 12}) {
+        ASSERT_EQ(expected, mQueue->readInPlace(&events));
+        for (ssize_t i = 0; i < expected; i++) {
+            EXPECT_EQ(timestamp++, events[i].timestamp);
+        }
+    }
+    EXPECT_EQ(0, mQueue->readInPlace(&events));
+}
+
+TEST_F(SensorEventQueueReadTest, ReadInPlace_ReturnsTheEventsLeftByRead) {
+    sendEvents(4);
+    ASensorEvent event;
+    ASSERT_EQ(1, mQueue->read(&event, 1));
+    EXPECT_EQ(0, event.timestamp);
+    ASensorEvent const* events = nullptr;
+    ASSERT_EQ(3, mQueue->readInPlace(&events));
+    EXPECT_EQ(1, events[0].timestamp);
+    EXPECT_EQ(3, events[2].timestamp);
+}
+
 } // namespace android
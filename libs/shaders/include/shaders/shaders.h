@@ -20,6 +20,8 @@
 #include <tonemap/tonemap.h>
 #include <ui/GraphicTypes.h>
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 namespace android::shaders {
 
@@ -68,12 +70,18 @@ struct LinearEffect {
 
     enum SkSLType { Shader, ColorFilter };
     SkSLType type = Shader;
+
+    // Sets whether the tone mapping gain is sampled from a lookup table built by
+    // buildToneMapLut(), which is bound to the child shader in_toneMapLut, instead of evaluating
+    // the tone mapping curve for each pixel. See canUseToneMapLut().
+    bool useToneMapLut = false;
 };
 
 static inline bool operator==(const LinearEffect& lhs, const LinearEffect& rhs) {
     return lhs.inputDataspace == rhs.inputDataspace && lhs.outputDataspace == rhs.outputDataspace &&
             lhs.undoPremultipliedAlpha == rhs.undoPremultipliedAlpha &&
-            lhs.fakeOutputDataspace == rhs.fakeOutputDataspace;
+            lhs.fakeOutputDataspace == rhs.fakeOutputDataspace &&
+            lhs.useToneMapLut == rhs.useToneMapLut;
 }
 
 struct LinearEffectHasher {
@@ -86,7 +94,8 @@ struct LinearEffectHasher {
         size_t result = std::hash<ui::Dataspace>{}(le.inputDataspace);
         result = HashCombine(result, std::hash<ui::Dataspace>{}(le.outputDataspace));
         result = HashCombine(result, std::hash<bool>{}(le.undoPremultipliedAlpha));
-        return HashCombine(result, std::hash<ui::Dataspace>{}(le.fakeOutputDataspace));
+        result = HashCombine(result, std::hash<ui::Dataspace>{}(le.fakeOutputDataspace));
+        return HashCombine(result, std::hash<bool>{}(le.useToneMapLut));
     }
 };
 
@@ -103,4 +112,25 @@ std::vector<tonemap::ShaderUniform> buildLinearEffectUniforms(
         aidl::android::hardware::graphics::composer3::RenderIntent renderIntent =
                 aidl::android::hardware::graphics::composer3::RenderIntent::TONE_MAP_COLORIMETRIC);
 
+// Number of gains in a tone mapping lookup table.
+constexpr size_t kToneMapLutSize = tonemap::ToneMapper::kLookupTableSize;
+// Luminance in nits of the brightest color a tone mapping lookup table is sampled at. Brighter
+// colors use the gain of the last entry.
+constexpr float kToneMapLutMaxNits = tonemap::ToneMapper::kLookupTableMaxNits;
+
+// Returns whether the tone mapping curve between the dataspaces may be sampled into a lookup table,
+// which is the case for the common pairs that tone map HDR content, i.e. PQ or HLG content drawn
+// to an SDR output or to an output with the other HDR transfer function, with tone mappers that
+// support it. Pairs that do not tone map evaluate a trivial curve, so they do not use one.
+bool canUseToneMapLut(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace);
+
+// Returns the tone mapping lookup table of an effect for which useToneMapLut is set, see
+// tonemap::ToneMapper::getLookupTable(). The curve does not depend on the buffer, so the same table
+// is returned for all layers drawn with the same arguments.
+std::shared_ptr<const tonemap::ToneMapper::LookupTable> getToneMapLut(
+        const LinearEffect& linearEffect, float maxDisplayLuminance,
+        float currentDisplayLuminanceNits, float maxLuminance,
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent =
+                aidl::android::hardware::graphics::composer3::RenderIntent::TONE_MAP_COLORIMETRIC);
+
 } // namespace android::shaders
@@ -78,7 +78,7 @@ void generateLuminanceScalesForOOTF(ui::Dataspace inputDataspace, std::string& s
 
 // Normalizes from absolute light back to relative light (maps from [0, maxNits] back to [0, 1])
 static void generateLuminanceNormalizationForOOTF(ui::Dataspace inputDataspace,
-                                                  ui::Dataspace outputDataspace,
+                                                  ui::Dataspace outputDataspace, bool useToneMapLut,
                                                   std::string& shader) {
     switch (outputDataspace & HAL_DATASPACE_TRANSFER_MASK) {
         case HAL_DATASPACE_TRANSFER_ST2084:
@@ -121,12 +121,21 @@ static void generateLuminanceNormalizationForOOTF(ui::Dataspace inputDataspace,
                 case HAL_DATASPACE_TRANSFER_HLG:
                 case HAL_DATASPACE_TRANSFER_ST2084:
                     // libtonemap outputs a range [0, in_libtonemap_displayMaxLuminance], so
-                    // normalize back to [0, 1] when the output is SDR.
-                    shader.append(R"(
-                        float3 NormalizeLuminance(float3 xyz) {
-                            return xyz / in_libtonemap_displayMaxLuminance;
-                        }
-                    )");
+                    // normalize back to [0, 1] when the output is SDR. The uniforms of libtonemap
+                    // are not bound when the gain is sampled from a lookup table.
+                    if (useToneMapLut) {
+                        shader.append(R"(
+                            float3 NormalizeLuminance(float3 xyz) {
+                                return xyz / in_displayMaxLuminance;
+                            }
+                        )");
+                    } else {
+                        shader.append(R"(
+                            float3 NormalizeLuminance(float3 xyz) {
+                                return xyz / in_libtonemap_displayMaxLuminance;
+                            }
+                        )");
+                    }
                     break;
                 default:
                     // Otherwise normalize back down to the range [0, 1]
@@ -141,15 +150,51 @@ static void generateLuminanceNormalizationForOOTF(ui::Dataspace inputDataspace,
     }
 }
 
-void generateOOTF(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace,
+// Samples the tone mapping gain from the lookup table returned by getToneMapLut(), whose entries
+// are spaced by the square root of the luminance they are sampled at.
+void generateToneMapLut(std::string& shader) {
+    // canUseToneMapLut() only allows lookup tables for tone mappers that support them.
+    const auto gainInput = tonemap::getToneMapper()->getLookupTableGainInput().value_or(
+            tonemap::ToneMapper::GainInput::MaxRGB);
+    shader.append(R"(
+        uniform shader in_toneMapLut;
+        uniform float in_displayMaxLuminance;
+        float LookupToneMapGain(float3 linearRGB, float3 xyz) {
+    )");
+    switch (gainInput) {
+        case tonemap::ToneMapper::GainInput::Luminance:
+            shader.append(R"(
+                float nits = xyz.y;
+            )");
+            break;
+        case tonemap::ToneMapper::GainInput::MaxRGB:
+            shader.append(R"(
+                float nits = max(linearRGB.r, max(linearRGB.g, linearRGB.b));
+            )");
+            break;
+    }
+    shader.append("float maxNits = " + std::to_string(kToneMapLutMaxNits) + ";\n");
+    shader.append("float lastIndex = " + std::to_string(kToneMapLutSize - 1) + ".0;\n");
+    shader.append(R"(
+            float index = sqrt(clamp(nits / maxNits, 0.0, 1.0)) * lastIndex;
+            return in_toneMapLut.eval(float2(index + 0.5, 0.5)).r;
+        }
+    )");
+}
+
+void generateOOTF(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace, bool useToneMapLut,
                   std::string& shader) {
-    shader.append(tonemap::getToneMapper()
-                          ->generateTonemapGainShaderSkSL(toAidlDataspace(inputDataspace),
-                                                          toAidlDataspace(outputDataspace))
-                          .c_str());
+    if (useToneMapLut) {
+        generateToneMapLut(shader);
+    } else {
+        shader.append(tonemap::getToneMapper()
+                              ->generateTonemapGainShaderSkSL(toAidlDataspace(inputDataspace),
+                                                              toAidlDataspace(outputDataspace))
+                              .c_str());
+    }
 
     generateLuminanceScalesForOOTF(inputDataspace, shader);
-    generateLuminanceNormalizationForOOTF(inputDataspace, outputDataspace, shader);
+    generateLuminanceNormalizationForOOTF(inputDataspace, outputDataspace, useToneMapLut, shader);
 
     // Some tonemappers operate on CIE luminance, other tonemappers operate on linear rgb
     // luminance in the source gamut.
@@ -157,9 +202,17 @@ void generateOOTF(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace,
             float3 OOTF(float3 linearRGB) {
                 float3 scaledLinearRGB = ScaleLuminance(linearRGB);
                 float3 scaledXYZ = ToXYZ(scaledLinearRGB);
-
+    )");
+    if (useToneMapLut) {
+        shader.append(R"(
+                float gain = LookupToneMapGain(ToSrcRGB(scaledXYZ), scaledXYZ);
+        )");
+    } else {
+        shader.append(R"(
                 float gain = libtonemap_LookupTonemapGain(ToSrcRGB(scaledXYZ), scaledXYZ);
-
+        )");
+    }
+    shader.append(R"(
                 return NormalizeLuminance(scaledXYZ * gain);
             }
         )");
@@ -228,12 +281,29 @@ std::vector<uint8_t> buildUniformValue(T value) {
     return result;
 }
 
+tonemap::Metadata buildToneMapMetadata(
+        float maxDisplayLuminance, float currentDisplayLuminanceNits, float maxLuminance,
+        AHardwareBuffer* buffer,
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent) {
+    return {.displayMaxLuminance = maxDisplayLuminance,
+            // If the input luminance is unknown, use display luminance (aka,
+            // no-op any luminance changes).
+            // This is expected to only be meaningful for PQ content
+            .contentMaxLuminance = maxLuminance > 0 ? maxLuminance : maxDisplayLuminance,
+            .currentDisplayLuminance = currentDisplayLuminanceNits > 0
+                    ? currentDisplayLuminanceNits
+                    : maxDisplayLuminance,
+            .buffer = buffer,
+            .renderIntent = renderIntent};
+}
+
 } // namespace
 
 std::string buildLinearEffectSkSL(const LinearEffect& linearEffect) {
     std::string shaderString;
     generateXYZTransforms(shaderString);
-    generateOOTF(linearEffect.inputDataspace, linearEffect.outputDataspace, shaderString);
+    generateOOTF(linearEffect.inputDataspace, linearEffect.outputDataspace,
+                 linearEffect.useToneMapLut, shaderString);
 
     const bool needsCustomOETF = (linearEffect.fakeOutputDataspace & HAL_DATASPACE_TRANSFER_MASK) ==
             HAL_DATASPACE_TRANSFER_GAMMA2_2;
@@ -297,18 +367,15 @@ std::vector<tonemap::ShaderUniform> buildLinearEffectUniforms(
                                 mat4(outputColorSpace.getRGBtoXYZ()) * colorTransform *
                                 mat4(outputColorSpace.getXYZtoRGB()))});
 
-    tonemap::Metadata metadata{.displayMaxLuminance = maxDisplayLuminance,
-                               // If the input luminance is unknown, use display luminance (aka,
-                               // no-op any luminance changes).
-                               // This is expected to only be meaningful for PQ content
-                               .contentMaxLuminance =
-                                       maxLuminance > 0 ? maxLuminance : maxDisplayLuminance,
-                               .currentDisplayLuminance = currentDisplayLuminanceNits > 0
-                                       ? currentDisplayLuminanceNits
-                                       : maxDisplayLuminance,
-                               .buffer = buffer,
-                               .renderIntent = renderIntent};
+    if (linearEffect.useToneMapLut) {
+        // The tone mapping curve is baked into the lookup table.
+        uniforms.push_back({.name = "in_displayMaxLuminance",
+                            .value = buildUniformValue<float>(maxDisplayLuminance)});
+        return uniforms;
+    }
 
+    const auto metadata = buildToneMapMetadata(maxDisplayLuminance, currentDisplayLuminanceNits,
+                                               maxLuminance, buffer, renderIntent);
     for (const auto uniform : tonemap::getToneMapper()->generateShaderSkSLUniforms(metadata)) {
         uniforms.push_back(uniform);
     }
@@ -316,4 +383,26 @@ std::vector<tonemap::ShaderUniform> buildLinearEffectUniforms(
     return uniforms;
 }
 
+bool canUseToneMapLut(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace) {
+    const auto inputTransfer = inputDataspace & HAL_DATASPACE_TRANSFER_MASK;
+    const auto outputTransfer = outputDataspace & HAL_DATASPACE_TRANSFER_MASK;
+    if (inputTransfer != HAL_DATASPACE_TRANSFER_ST2084 &&
+        inputTransfer != HAL_DATASPACE_TRANSFER_HLG) {
+        return false;
+    }
+    return inputTransfer != outputTransfer &&
+            tonemap::getToneMapper()->getLookupTableGainInput().has_value();
+}
+
+std::shared_ptr<const tonemap::ToneMapper::LookupTable> getToneMapLut(
+        const LinearEffect& linearEffect, float maxDisplayLuminance,
+        float currentDisplayLuminanceNits, float maxLuminance,
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent) {
+    const auto metadata = buildToneMapMetadata(maxDisplayLuminance, currentDisplayLuminanceNits,
+                                               maxLuminance, nullptr, renderIntent);
+    return tonemap::getToneMapper()->getLookupTable(toAidlDataspace(linearEffect.inputDataspace),
+                                                    toAidlDataspace(linearEffect.outputDataspace),
+                                                    metadata);
+}
+
 } // namespace android::shaders
@@ -26,6 +26,7 @@ namespace android {
 
 using testing::Contains;
 using testing::HasSubstr;
+using testing::Not;
 
 struct ShadersTest : public ::testing::Test {};
 
@@ -93,4 +94,55 @@ TEST_F(ShadersTest, buildLinearEffectUniforms_selectsGamutTransformMatrices) {
     EXPECT_THAT(uniforms, Contains(UniformNameEq("in_colorTransform")));
 }
 
+TEST_F(ShadersTest, buildLinearEffectSkSL_samplesToneMapLut) {
+    const auto effect = shaders::LinearEffect{.inputDataspace = ui::Dataspace::BT2020_ITU_PQ,
+                                              .outputDataspace = ui::Dataspace::DISPLAY_P3,
+                                              .useToneMapLut = true};
+    ASSERT_TRUE(shaders::canUseToneMapLut(effect.inputDataspace, effect.outputDataspace));
+
+    const auto shader = shaders::buildLinearEffectSkSL(effect);
+    EXPECT_THAT(shader, HasSubstr("uniform shader in_toneMapLut;"));
+    EXPECT_THAT(shader, Not(HasSubstr("libtonemap_")));
+
+    const auto uniforms = shaders::buildLinearEffectUniforms(effect, mat4(), 500.f, 250.f, 1000.f);
+    EXPECT_THAT(uniforms, Contains(UniformEq("in_displayMaxLuminance", buildUniformValue(500.f))));
+    EXPECT_THAT(uniforms, Not(Contains(UniformNameEq("in_libtonemap_displayMaxLuminance"))));
+}
+
+TEST_F(ShadersTest, canUseToneMapLut_onlyForHdrInputThatIsToneMapped) {
+    EXPECT_TRUE(shaders::canUseToneMapLut(ui::Dataspace::BT2020_ITU_PQ, ui::Dataspace::SRGB));
+    EXPECT_TRUE(shaders::canUseToneMapLut(ui::Dataspace::BT2020_ITU_HLG, ui::Dataspace::SRGB));
+    EXPECT_TRUE(
+            shaders::canUseToneMapLut(ui::Dataspace::BT2020_ITU_HLG, ui::Dataspace::BT2020_ITU_PQ));
+    EXPECT_FALSE(
+            shaders::canUseToneMapLut(ui::Dataspace::BT2020_ITU_PQ, ui::Dataspace::BT2020_ITU_PQ));
+    EXPECT_FALSE(shaders::canUseToneMapLut(ui::Dataspace::SRGB, ui::Dataspace::DISPLAY_P3));
+}
+
+TEST_F(ShadersTest, getToneMapLut_matchesToneMapCurve) {
+    const auto effect = shaders::LinearEffect{.inputDataspace = ui::Dataspace::BT2020_ITU_PQ,
+                                              .outputDataspace = ui::Dataspace::SRGB,
+                                              .useToneMapLut = true};
+    const auto lut = shaders::getToneMapLut(effect, 500.f, 500.f, 1000.f);
+    ASSERT_NE(nullptr, lut);
+    ASSERT_EQ(shaders::kToneMapLutSize, lut->gains.size());
+    EXPECT_EQ(lut, shaders::getToneMapLut(effect, 500.f, 500.f, 1000.f));
+
+    // Dark colors are not tone mapped, while the brightest are mapped to the display luminance.
+    EXPECT_FLOAT_EQ(1.f, lut->gains.front());
+    EXPECT_FLOAT_EQ(1.f, lut->gains[10]);
+    EXPECT_NEAR(500.f / shaders::kToneMapLutMaxNits, lut->gains.back(), 1e-6f);
+
+    const size_t index = shaders::kToneMapLutSize / 2;
+    const float position = static_cast<float>(index) / (shaders::kToneMapLutSize - 1);
+    const float nits = shaders::kToneMapLutMaxNits * position * position;
+    const auto gains = tonemap::getToneMapper()->lookupTonemapGain(
+            aidl::android::hardware::graphics::common::Dataspace::BT2020_ITU_PQ,
+            aidl::android::hardware::graphics::common::Dataspace::SRGB,
+            {{.linearRGB = vec3(nits), .xyz = vec3(nits)}},
+            {.displayMaxLuminance = 500.f, .contentMaxLuminance = 1000.f,
+             .currentDisplayLuminance = 500.f});
+    EXPECT_NEAR(gains[0], lut->gains[index], 1e-6f);
+}
+
 } // namespace android
@@ -21,6 +21,10 @@
 #include <android/hardware_buffer.h>
 #include <math/vec3.h>
 
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -148,6 +152,66 @@ public:
             aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
             aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
             const std::vector<Color>& colors, const Metadata& metadata) = 0;
+
+    // The value of a color that the tonemapping gain is a function of.
+    enum class GainInput {
+        // The Y component of the color in XYZ.
+        Luminance,
+        // The largest component of the color in linear RGB.
+        MaxRGB,
+    };
+
+    // If the tonemapping gain is a function of a single value of a color, and of the metadata other
+    // than the buffer, returns that value. The curve may then be sampled ahead of time with
+    // getLookupTable(), which shaders index with that value instead of evaluating the curve for
+    // each pixel. Returns std::nullopt otherwise.
+    virtual std::optional<GainInput> getLookupTableGainInput() const { return std::nullopt; }
+
+    // Number of gains in a lookup table.
+    static constexpr size_t kLookupTableSize = 256;
+    // Value of the gain input in nits of the brightest color a lookup table is sampled at.
+    // Brighter colors use the gain of the last entry.
+    static constexpr float kLookupTableMaxNits = 10000.f;
+
+    // The tonemapping curve between two dataspaces, for some metadata, sampled ahead of time.
+    struct LookupTable {
+        GainInput gainInput = GainInput::MaxRGB;
+        // Entry i is the gain of a color whose gain input is
+        // kLookupTableMaxNits * (i / (kLookupTableSize - 1))^2 nits, which spends more entries on
+        // the darker colors that most content is made of. Values in between may be interpolated
+        // linearly.
+        std::vector<float> gains;
+    };
+
+    // Returns the tonemapping curve sampled into a lookup table, or nullptr if
+    // getLookupTableGainInput() returns std::nullopt. The buffer of the metadata is ignored.
+    //
+    // Tables are cached by a hash of their parameters, so that e.g. the frames of an HDR video,
+    // which are drawn with the same metadata, are only sampled once. This is thread-safe.
+    std::shared_ptr<const LookupTable> getLookupTable(
+            aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+            aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+            const Metadata& metadata);
+
+private:
+    struct LookupTableKey {
+        aidl::android::hardware::graphics::common::Dataspace sourceDataspace;
+        aidl::android::hardware::graphics::common::Dataspace destinationDataspace;
+        float displayMaxLuminance;
+        float contentMaxLuminance;
+        float currentDisplayLuminance;
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent;
+        size_t hash;
+
+        bool operator==(const LookupTableKey& other) const;
+    };
+
+    // Tables are usually drawn for few dataspaces, on few displays.
+    static constexpr size_t kMaxLookupTables = 8;
+
+    std::mutex mLookupTableMutex;
+    // Most recently used first.
+    std::list<std::pair<LookupTableKey, std::shared_ptr<const LookupTable>>> mLookupTables;
 };
 
 // Retrieves a tonemapper instance.
@@ -85,4 +85,50 @@ TEST_F(TonemapTest, generateTonemapGainShaderSkSL_containsEntryPointForHLG) {
     EXPECT_THAT(shader, HasSubstr("float libtonemap_LookupTonemapGain(vec3 linearRGB, vec3 xyz)"));
 }
 
+TEST_F(TonemapTest, getLookupTable_samplesCurve) {
+    using aidl::android::hardware::graphics::common::Dataspace;
+    const tonemap::Metadata metadata{.displayMaxLuminance = 500.f,
+                                     .contentMaxLuminance = 1000.f,
+                                     .currentDisplayLuminance = 500.f};
+    auto* toneMapper = tonemap::getToneMapper();
+    ASSERT_TRUE(toneMapper->getLookupTableGainInput());
+
+    const auto table =
+            toneMapper->getLookupTable(Dataspace::BT2020_ITU_PQ, Dataspace::SRGB, metadata);
+    ASSERT_NE(nullptr, table);
+    ASSERT_EQ(tonemap::ToneMapper::kLookupTableSize, table->gains.size());
+    EXPECT_EQ(*toneMapper->getLookupTableGainInput(), table->gainInput);
+
+    const size_t index = tonemap::ToneMapper::kLookupTableSize / 2;
+    const float position = static_cast<float>(index) / (tonemap::ToneMapper::kLookupTableSize - 1);
+    const float nits = tonemap::ToneMapper::kLookupTableMaxNits * position * position;
+    const auto gains = toneMapper->lookupTonemapGain(Dataspace::BT2020_ITU_PQ, Dataspace::SRGB,
+                                                     {{.linearRGB = vec3(nits), .xyz = vec3(nits)}},
+                                                     metadata);
+    EXPECT_NEAR(gains[0], table->gains[index], 1e-6);
+}
+
+TEST_F(TonemapTest, getLookupTable_cachesByParameters) {
+    using aidl::android::hardware::graphics::common::Dataspace;
+    tonemap::Metadata metadata{.displayMaxLuminance = 600.f,
+                               .contentMaxLuminance = 1000.f,
+                               .currentDisplayLuminance = 300.f};
+    auto* toneMapper = tonemap::getToneMapper();
+    const auto table =
+            toneMapper->getLookupTable(Dataspace::BT2020_ITU_HLG, Dataspace::SRGB, metadata);
+    ASSERT_NE(nullptr, table);
+
+    // The buffer does not change the curve.
+    metadata.buffer = reinterpret_cast<AHardwareBuffer*>(0x1);
+    EXPECT_EQ(table,
+              toneMapper->getLookupTable(Dataspace::BT2020_ITU_HLG, Dataspace::SRGB, metadata));
+
+    metadata.currentDisplayLuminance = 400.f;
+    EXPECT_NE(table,
+              toneMapper->getLookupTable(Dataspace::BT2020_ITU_HLG, Dataspace::SRGB, metadata));
+    EXPECT_NE(table,
+              toneMapper->getLookupTable(Dataspace::BT2020_ITU_HLG, Dataspace::DISPLAY_P3,
+                                         metadata));
+}
+
 } // namespace android
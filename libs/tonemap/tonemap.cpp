@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <mutex>
 #include <type_traits>
 
@@ -64,6 +65,11 @@ float computeHlgGamma(float currentDisplayBrightnessNits) {
     return 1.2 + 0.42 * std::log10(currentDisplayBrightnessNits / 1000);
 }
 
+// This is what boost::hash_combine does.
+size_t hashCombine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
 class ToneMapperO : public ToneMapper {
 public:
     std::string generateTonemapGainShaderSkSL(
@@ -432,6 +438,10 @@ public:
         }
         return gains;
     }
+
+    std::optional<GainInput> getLookupTableGainInput() const override {
+        return GainInput::Luminance;
+    }
 };
 
 class ToneMapper13 : public ToneMapper {
@@ -726,10 +736,80 @@ public:
         }
         return gains;
     }
+
+    std::optional<GainInput> getLookupTableGainInput() const override { return GainInput::MaxRGB; }
 };
 
 } // namespace
 
+bool ToneMapper::LookupTableKey::operator==(const LookupTableKey& other) const {
+    return hash == other.hash && sourceDataspace == other.sourceDataspace &&
+            destinationDataspace == other.destinationDataspace &&
+            displayMaxLuminance == other.displayMaxLuminance &&
+            contentMaxLuminance == other.contentMaxLuminance &&
+            currentDisplayLuminance == other.currentDisplayLuminance &&
+            renderIntent == other.renderIntent;
+}
+
+std::shared_ptr<const ToneMapper::LookupTable> ToneMapper::getLookupTable(
+        aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+        aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+        const Metadata& metadata) {
+    const auto gainInput = getLookupTableGainInput();
+    if (!gainInput) {
+        return nullptr;
+    }
+
+    LookupTableKey key{.sourceDataspace = sourceDataspace,
+                       .destinationDataspace = destinationDataspace,
+                       .displayMaxLuminance = metadata.displayMaxLuminance,
+                       .contentMaxLuminance = metadata.contentMaxLuminance,
+                       .currentDisplayLuminance = metadata.currentDisplayLuminance,
+                       .renderIntent = metadata.renderIntent,
+                       .hash = 0};
+    size_t hash = std::hash<int32_t>{}(static_cast<int32_t>(sourceDataspace));
+    hash = hashCombine(hash, std::hash<int32_t>{}(static_cast<int32_t>(destinationDataspace)));
+    hash = hashCombine(hash, std::hash<float>{}(key.displayMaxLuminance));
+    hash = hashCombine(hash, std::hash<float>{}(key.contentMaxLuminance));
+    hash = hashCombine(hash, std::hash<float>{}(key.currentDisplayLuminance));
+    key.hash = hashCombine(hash, std::hash<int32_t>{}(static_cast<int32_t>(key.renderIntent)));
+
+    {
+        std::lock_guard lock(mLookupTableMutex);
+        for (auto it = mLookupTables.begin(); it != mLookupTables.end(); it++) {
+            if (it->first == key) {
+                mLookupTables.splice(mLookupTables.begin(), mLookupTables, it);
+                return mLookupTables.front().second;
+            }
+        }
+    }
+
+    // Gray colors, whose luminance and largest component are the same, so that the gains are the
+    // same whichever of them the curve is a function of.
+    std::vector<Color> colors;
+    colors.reserve(kLookupTableSize);
+    for (size_t i = 0; i < kLookupTableSize; i++) {
+        const float position = static_cast<float>(i) / (kLookupTableSize - 1);
+        const float nits = kLookupTableMaxNits * position * position;
+        colors.push_back({.linearRGB = vec3(nits), .xyz = vec3(nits)});
+    }
+    Metadata sampledMetadata = metadata;
+    sampledMetadata.buffer = nullptr;
+    const auto gains =
+            lookupTonemapGain(sourceDataspace, destinationDataspace, colors, sampledMetadata);
+
+    auto table = std::make_shared<LookupTable>();
+    table->gainInput = *gainInput;
+    table->gains.assign(gains.begin(), gains.end());
+
+    std::lock_guard lock(mLookupTableMutex);
+    mLookupTables.emplace_front(key, table);
+    if (mLookupTables.size() > kMaxLookupTables) {
+        mLookupTables.pop_back();
+    }
+    return table;
+}
+
 ToneMapper* getToneMapper() {
     static std::once_flag sOnce;
     static std::unique_ptr<ToneMapper> sToneMapper;
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FenceSignalWatcher"
+//#define LOG_NDEBUG 0
+
+#include <ui/FenceSignalWatcher.h>
+
+#include <android-base/properties.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace android {
+
+namespace {
+
+// The epoll data of mWakeFd. The fences are identified by ids starting at 1.
+constexpr uint64_t kWakeId = 0;
+constexpr size_t kMaxEvents = 16;
+
+} // namespace
+
+FenceSignalWatcher& FenceSignalWatcher::getInstance() {
+    // Never destroyed, so that FenceTimes can be created while the process exits.
+    static FenceSignalWatcher* const sWatcher =
+            new FenceSignalWatcher(base::GetBoolProperty("debug.ui.fence_watcher", true));
+    return *sWatcher;
+}
+
+FenceSignalWatcher::FenceSignalWatcher(bool enabled) {
+    if (!enabled) {
+        return;
+    }
+
+    base::unique_fd epollFd(epoll_create1(EPOLL_CLOEXEC));
+    base::unique_fd wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!epollFd.ok() || !wakeFd.ok()) {
+        ALOGE("Failed to create the file descriptors of the watcher: %s", strerror(errno));
+        return;
+    }
+
+    epoll_event event = {.events = EPOLLIN, .data = {.u64 = kWakeId}};
+    if (epoll_ctl(epollFd.get(), EPOLL_CTL_ADD, wakeFd.get(), &event) < 0) {
+        ALOGE("Failed to watch the wake file descriptor: %s", strerror(errno));
+        return;
+    }
+
+    mEpollFd = std::move(epollFd);
+    mWakeFd = std::move(wakeFd);
+}
+
+FenceSignalWatcher::~FenceSignalWatcher() {
+    std::optional<std::thread> thread;
+    {
+        std::lock_guard lock(mMutex);
+        thread = std::move(mThread);
+    }
+    if (thread && thread->joinable()) {
+        const uint64_t value = 1;
+        if (TEMP_FAILURE_RETRY(write(mWakeFd.get(), &value, sizeof(value))) < 0) {
+            ALOGE("Failed to wake up the watcher: %s", strerror(errno));
+        }
+        thread->join();
+    }
+
+    std::lock_guard lock(mMutex);
+    for (auto& [id, entry] : mEntries) {
+        if (const auto fenceTime = entry.fenceTime.lock()) {
+            fenceTime->stopWatching(Fence::SIGNAL_TIME_PENDING);
+        }
+    }
+    mEntries.clear();
+}
+
+bool FenceSignalWatcher::watch(const std::shared_ptr<FenceTime>& fenceTime) {
+    if (!isEnabled() || !fenceTime ||
+        fenceTime->getCachedSignalTime() != Fence::SIGNAL_TIME_PENDING) {
+        return false;
+    }
+
+    std::lock_guard lock(mMutex);
+    if (mEntries.size() >= kMaxFences) {
+        removeExpiredLocked();
+        if (mEntries.size() >= kMaxFences) {
+            ALOGV("watch: %zu fences are already watched", mEntries.size());
+            return false;
+        }
+    }
+
+    sp<Fence> fence = fenceTime->startWatching();
+    if (!fence) {
+        return false;
+    }
+
+    // The fence is added before it is registered, so that the thread finds it when it signals.
+    const uint64_t id = mNextId++;
+    epoll_event event = {.events = EPOLLIN | EPOLLONESHOT, .data = {.u64 = id}};
+    const int fd = fence->get();
+    mEntries.emplace(id, Entry{.fence = std::move(fence), .fenceTime = fenceTime});
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, fd, &event) < 0) {
+        ALOGE("Failed to watch fence %d: %s", fd, strerror(errno));
+        mEntries.erase(id);
+        fenceTime->stopWatching(Fence::SIGNAL_TIME_PENDING);
+        return false;
+    }
+
+    if (!mThread) {
+        mThread.emplace(&FenceSignalWatcher::threadMain, this);
+    }
+    return true;
+}
+
+size_t FenceSignalWatcher::getWatchedCount() const {
+    std::lock_guard lock(mMutex);
+    return mEntries.size();
+}
+
+void FenceSignalWatcher::waitForWatchedFences() {
+    std::unique_lock lock(mMutex);
+    mCondition.wait(lock, [this]() REQUIRES(mMutex) { return mEntries.empty(); });
+}
+
+void FenceSignalWatcher::removeExpiredLocked() {
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if (!it->second.fenceTime.expired()) {
+            ++it;
+            continue;
+        }
+        epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, it->second.fence->get(), nullptr);
+        it = mEntries.erase(it);
+    }
+}
+
+void FenceSignalWatcher::threadMain() {
+    std::array<epoll_event, kMaxEvents> events;
+    std::vector<std::pair<uint64_t, sp<Fence>>> signaled;
+    while (true) {
+        const int count =
+                TEMP_FAILURE_RETRY(epoll_wait(mEpollFd.get(), events.data(), kMaxEvents, -1));
+        if (count < 0) {
+            ALOGE("epoll_wait failed: %s", strerror(errno));
+            return;
+        }
+
+        {
+            std::lock_guard lock(mMutex);
+            for (int i = 0; i < count; i++) {
+                const uint64_t id = events[i].data.u64;
+                if (id == kWakeId) {
+                    return;
+                }
+                // The fence may have been removed because its FenceTime was destroyed.
+                if (const auto it = mEntries.find(id); it != mEntries.end()) {
+                    signaled.emplace_back(id, it->second.fence);
+                }
+            }
+        }
+
+        // Make the system calls without the lock held.
+        std::vector<nsecs_t> signalTimes;
+        signalTimes.reserve(signaled.size());
+        for (const auto& [id, fence] : signaled) {
+            signalTimes.push_back(fence->getSignalTime());
+        }
+
+        std::lock_guard lock(mMutex);
+        for (size_t i = 0; i < signaled.size(); i++) {
+            const auto it = mEntries.find(signaled[i].first);
+            if (it == mEntries.end()) {
+                continue;
+            }
+            epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, it->second.fence->get(), nullptr);
+            if (const auto fenceTime = it->second.fenceTime.lock()) {
+                fenceTime->stopWatching(signalTimes[i]);
+            }
+            mEntries.erase(it);
+        }
+        signaled.clear();
+        mCondition.notify_all();
+    }
+}
+
+} // namespace android
@@ -132,6 +132,11 @@ nsecs_t FenceTime::getSignalTime() {
         return signalTime;
     }
 
+    // The watcher sets the signal time once the fence signals.
+    if (mWatched.load(std::memory_order_acquire)) {
+        return Fence::SIGNAL_TIME_PENDING;
+    }
+
     // Hold a reference to the fence on the stack in case the class'
     // reference is removed by another thread. This prevents the
     // fence from being destroyed until the end of this method, where
@@ -203,6 +208,25 @@ FenceTime::FenceTime(const sp<Fence>& fence, bool forceValidForTest)
             Fence::SIGNAL_TIME_INVALID : Fence::SIGNAL_TIME_PENDING) {
 }
 
+sp<Fence> FenceTime::startWatching() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mState != State::VALID || !mFence.get() || !mFence->isValid() ||
+        mWatched.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    mWatched.store(true, std::memory_order_relaxed);
+    return mFence;
+}
+
+void FenceTime::stopWatching(nsecs_t signalTime) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (signalTime != Fence::SIGNAL_TIME_PENDING && mFence.get()) {
+        mFence.clear();
+        mSignalTime.store(signalTime, std::memory_order_release);
+    }
+    mWatched.store(false, std::memory_order_release);
+}
+
 void FenceTime::signalForTest(nsecs_t signalTime) {
     // To be realistic, this should really set a hidden value that
     // gets picked up in the next call to getSignalTime, but this should
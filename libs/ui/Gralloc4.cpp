@@ -471,6 +471,42 @@ int Gralloc4Mapper::unlock(buffer_handle_t bufferHandle) const {
     return releaseFence;
 }
 
+status_t Gralloc4Mapper::flushLockedBuffer(buffer_handle_t bufferHandle,
+                                          int* outReleaseFence) const {
+    auto buffer = const_cast<native_handle_t*>(bufferHandle);
+
+    *outReleaseFence = -1;
+    Error error;
+    auto ret = mMapper->flushLockedBuffer(buffer,
+                                          [&](const auto& tmpError, const auto& tmpReleaseFence) {
+                                              error = tmpError;
+                                              if (error != Error::NONE) {
+                                                  return;
+                                              }
+
+                                              auto fenceHandle = tmpReleaseFence.getNativeHandle();
+                                              if (fenceHandle && fenceHandle->numFds == 1) {
+                                                  *outReleaseFence = dup(fenceHandle->data[0]);
+                                                  if (*outReleaseFence < 0) {
+                                                      sync_wait(fenceHandle->data[0], -1);
+                                                  }
+                                              }
+                                          });
+
+    error = (ret.isOk()) ? error : kTransactionError;
+    ALOGE_IF(error != Error::NONE, "flushLockedBuffer(%p) failed with %d", buffer, error);
+    return static_cast<status_t>(error);
+}
+
+status_t Gralloc4Mapper::rereadLockedBuffer(buffer_handle_t bufferHandle) const {
+    auto buffer = const_cast<native_handle_t*>(bufferHandle);
+
+    auto ret = mMapper->rereadLockedBuffer(buffer);
+    const Error error = (ret.isOk()) ? static_cast<Error>(ret) : kTransactionError;
+    ALOGE_IF(error != Error::NONE, "rereadLockedBuffer(%p) failed with %d", buffer, error);
+    return static_cast<status_t>(error);
+}
+
 status_t Gralloc4Mapper::isSupported(uint32_t width, uint32_t height, PixelFormat format,
                                      uint32_t layerCount, uint64_t usage,
                                      bool* outSupported) const {
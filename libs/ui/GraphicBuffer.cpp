@@ -183,23 +183,57 @@ status_t GraphicBuffer::initWithSize(uint32_t inWidth, uint32_t inHeight,
 {
     GraphicBufferAllocator& allocator = GraphicBufferAllocator::get();
     uint32_t outStride = 0;
+    buffer_handle_t outHandle = nullptr;
     status_t err = allocator.allocate(inWidth, inHeight, inFormat, inLayerCount,
-            inUsage, &handle, &outStride, mId,
+            inUsage, &outHandle, &outStride, mId,
             std::move(requestorName));
     if (err == NO_ERROR) {
-        mBufferMapper.getTransportSize(handle, &mTransportNumFds, &mTransportNumInts);
-
-        width = static_cast<int>(inWidth);
-        height = static_cast<int>(inHeight);
-        format = inFormat;
-        layerCount = inLayerCount;
-        usage = inUsage;
-        usage_deprecated = int(usage);
-        stride = static_cast<int>(outStride);
+        initWithAllocatedHandle(outHandle, inWidth, inHeight, inFormat, inLayerCount, inUsage,
+                                outStride);
     }
     return err;
 }
 
+void GraphicBuffer::initWithAllocatedHandle(buffer_handle_t inHandle, uint32_t inWidth,
+                                            uint32_t inHeight, PixelFormat inFormat,
+                                            uint32_t inLayerCount, uint64_t inUsage,
+                                            uint32_t inStride) {
+    handle = inHandle;
+    mBufferMapper.getTransportSize(handle, &mTransportNumFds, &mTransportNumInts);
+
+    width = static_cast<int>(inWidth);
+    height = static_cast<int>(inHeight);
+    format = inFormat;
+    layerCount = inLayerCount;
+    usage = inUsage;
+    usage_deprecated = int(usage);
+    stride = static_cast<int>(inStride);
+}
+
+status_t GraphicBuffer::allocateBatch(uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
+                                      uint32_t inLayerCount, uint64_t inUsage, uint32_t count,
+                                      std::string requestorName,
+                                      std::vector<sp<GraphicBuffer>>* outBuffers) {
+    std::vector<buffer_handle_t> handles(count);
+    uint32_t outStride = 0;
+    status_t err = GraphicBufferAllocator::get().allocateBatch(inWidth, inHeight, inFormat,
+                                                               inLayerCount, inUsage, count,
+                                                               handles.data(), &outStride,
+                                                               std::move(requestorName));
+    if (err != NO_ERROR) {
+        return err;
+    }
+
+    outBuffers->reserve(outBuffers->size() + count);
+    for (buffer_handle_t handle : handles) {
+        sp<GraphicBuffer> buffer = sp<GraphicBuffer>::make();
+        buffer->initWithAllocatedHandle(handle, inWidth, inHeight, inFormat, inLayerCount,
+                                        inUsage, outStride);
+        outBuffers->push_back(std::move(buffer));
+    }
+    return NO_ERROR;
+}
+
 status_t GraphicBuffer::initWithHandle(const native_handle_t* inHandle, HandleWrapMethod method,
                                        uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
                                        uint32_t inLayerCount, uint64_t inUsage, uint32_t inStride) {
@@ -23,6 +23,8 @@
 #include <limits.h>
 #include <stdio.h>
 
+#include <algorithm>
+
 #include <grallocusage/GrallocUsageConversion.h>
 
 #include <android-base/stringprintf.h>
@@ -72,7 +74,18 @@ GraphicBufferAllocator::GraphicBufferAllocator() : mMapper(GraphicBufferMapper::
                         mMapper.getMapperVersion());
 }
 
-GraphicBufferAllocator::~GraphicBufferAllocator() {}
+GraphicBufferAllocator::~GraphicBufferAllocator() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard lock(mTaskMutex);
+        mDone = true;
+        threads = std::move(mAllocatorThreads);
+    }
+    mTaskCondition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
 
 uint64_t GraphicBufferAllocator::getTotalSize() const {
     Mutex::Autolock _l(sLock);
@@ -103,6 +116,7 @@ void GraphicBufferAllocator::dump(std::string& result, bool less) const {
     }
     StringAppendF(&result, "Total allocated by GraphicBufferAllocator (estimate): %.2f KB\n",
                   static_cast<double>(total) / 1024.0);
+    mMapper.dumpMetadataCache(result);
 
     result.append(mAllocator->dumpDebugInfo(less));
 }
@@ -115,8 +129,9 @@ void GraphicBufferAllocator::dumpToSystemLog(bool less) {
 
 status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height, PixelFormat format,
                                                 uint32_t layerCount, uint64_t usage,
-                                                buffer_handle_t* handle, uint32_t* stride,
-                                                std::string requestorName, bool importBuffer) {
+                                                uint32_t count, buffer_handle_t* handles,
+                                                uint32_t* stride, std::string requestorName,
+                                                bool importBuffer) {
     ATRACE_CALL();
 
     // make sure to not allocate a N x 0 or 0 x N buffer, since this is
@@ -141,11 +156,11 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     usage &= ~static_cast<uint64_t>((1 << 10) | (1 << 13));
 
     status_t error = mAllocator->allocate(requestorName, width, height, format, layerCount, usage,
-                                          1, stride, handle, importBuffer);
+                                          count, stride, handles, importBuffer);
     if (error != NO_ERROR) {
-        ALOGE("Failed to allocate (%u x %u) layerCount %u format %d "
+        ALOGE("Failed to allocate %u (%u x %u) layerCount %u format %d "
               "usage %" PRIx64 ": %d",
-              width, height, layerCount, format, usage, error);
+              count, width, height, layerCount, format, usage, error);
         return error;
     }
 
@@ -174,7 +189,9 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     rec.usage = usage;
     rec.size = bufSize;
     rec.requestorName = std::move(requestorName);
-    list.add(*handle, rec);
+    for (uint32_t i = 0; i < count; i++) {
+        list.add(handles[i], rec);
+    }
 
     return NO_ERROR;
 }
@@ -182,16 +199,70 @@ status_t GraphicBufferAllocator::allocate(uint32_t width, uint32_t height, Pixel
                                           uint32_t layerCount, uint64_t usage,
                                           buffer_handle_t* handle, uint32_t* stride,
                                           std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          true);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, true);
 }
 
 status_t GraphicBufferAllocator::allocateRawHandle(uint32_t width, uint32_t height,
                                                    PixelFormat format, uint32_t layerCount,
                                                    uint64_t usage, buffer_handle_t* handle,
                                                    uint32_t* stride, std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          false);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, false);
+}
+
+status_t GraphicBufferAllocator::allocateBatch(uint32_t width, uint32_t height, PixelFormat format,
+                                               uint32_t layerCount, uint64_t usage, uint32_t count,
+                                               buffer_handle_t* outHandles, uint32_t* outStride,
+                                               std::string requestorName) {
+    if (count == 0) {
+        return BAD_VALUE;
+    }
+    return allocateHelper(width, height, format, layerCount, usage, count, outHandles, outStride,
+                          std::move(requestorName), true);
+}
+
+std::future<GraphicBufferAllocator::AllocationBatch> GraphicBufferAllocator::allocateBatchAsync(
+        uint32_t width, uint32_t height, PixelFormat format, uint32_t layerCount, uint64_t usage,
+        uint32_t count, std::string requestorName) {
+    std::packaged_task<AllocationBatch()> task(
+            [=, this, requestorName = std::move(requestorName)]() mutable {
+                AllocationBatch batch;
+                batch.handles.resize(count);
+                batch.status = allocateBatch(width, height, format, layerCount, usage, count,
+                                             batch.handles.data(), &batch.stride,
+                                             std::move(requestorName));
+                if (batch.status != NO_ERROR) {
+                    batch.handles.clear();
+                }
+                return batch;
+            });
+    std::future<AllocationBatch> future = task.get_future();
+
+    std::lock_guard lock(mTaskMutex);
+    mTasks.emplace_back(std::move(task));
+    if (mAllocatorThreads.size() < std::min(mTasks.size(), kAllocatorThreadCount)) {
+        mAllocatorThreads.emplace_back(&GraphicBufferAllocator::allocatorThreadMain, this);
+    }
+    mTaskCondition.notify_one();
+    return future;
+}
+
+void GraphicBufferAllocator::allocatorThreadMain() {
+    std::unique_lock lock(mTaskMutex);
+    while (true) {
+        mTaskCondition.wait(lock,
+                            [this]() REQUIRES(mTaskMutex) { return mDone || !mTasks.empty(); });
+        if (mTasks.empty()) {
+            return;
+        }
+        std::packaged_task<void()> task = std::move(mTasks.front());
+        mTasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
 }
 
 // DEPRECATED
@@ -199,8 +270,8 @@ status_t GraphicBufferAllocator::allocate(uint32_t width, uint32_t height, Pixel
                                           uint32_t layerCount, uint64_t usage,
                                           buffer_handle_t* handle, uint32_t* stride,
                                           uint64_t /*graphicBufferId*/, std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          true);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, true);
 }
 
 status_t GraphicBufferAllocator::free(buffer_handle_t handle)
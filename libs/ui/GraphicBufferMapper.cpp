@@ -29,6 +29,7 @@
 #include <sync/sync.h>
 #pragma clang diagnostic pop
 
+#include <android-base/stringprintf.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
@@ -41,6 +42,9 @@
 
 #include <system/graphics.h>
 
+#include <inttypes.h>
+#include <unistd.h>
+
 namespace android {
 // ---------------------------------------------------------------------------
 
@@ -130,6 +134,14 @@ status_t GraphicBufferMapper::freeBuffer(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
+    {
+        std::lock_guard lock(mMetadataMutex);
+        mMetadataCache.erase(handle);
+    }
+    if (mPersistentMappingCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard lock(mMappingMutex);
+        eraseMappingLocked(handle);
+    }
     mMapper->freeBuffer(handle);
 
     return NO_ERROR;
@@ -173,6 +185,10 @@ status_t GraphicBufferMapper::lockAsync(buffer_handle_t handle, uint64_t produce
 
     const uint64_t usage = static_cast<uint64_t>(
             android_convertGralloc1To0Usage(producerUsage, consumerUsage));
+    if (const auto result = lockPersistent(handle, usage, /*ycbcr=*/false, fenceFd, vaddr, nullptr,
+                                           outBytesPerPixel, outBytesPerStride)) {
+        return *result;
+    }
     return mMapper->lock(handle, usage, bounds, fenceFd, vaddr, outBytesPerPixel,
                          outBytesPerStride);
 }
@@ -182,6 +198,10 @@ status_t GraphicBufferMapper::lockAsyncYCbCr(buffer_handle_t handle,
 {
     ATRACE_CALL();
 
+    if (const auto result = lockPersistent(handle, usage, /*ycbcr=*/true, fenceFd, nullptr, ycbcr,
+                                           nullptr, nullptr)) {
+        return *result;
+    }
     return mMapper->lock(handle, usage, bounds, fenceFd, ycbcr);
 }
 
@@ -189,11 +209,195 @@ status_t GraphicBufferMapper::unlockAsync(buffer_handle_t handle, int *fenceFd)
 {
     ATRACE_CALL();
 
+    if (const auto result = unlockPersistent(handle, fenceFd)) {
+        return *result;
+    }
     *fenceFd = mMapper->unlock(handle);
 
     return NO_ERROR;
 }
 
+namespace {
+
+constexpr uint64_t kCpuUsageMask = GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK;
+
+void closeFence(int fenceFd) {
+    if (fenceFd >= 0) {
+        close(fenceFd);
+    }
+}
+
+} // namespace
+
+status_t GraphicBufferMapper::enablePersistentMapping(buffer_handle_t handle, uint64_t usage,
+                                                      bool ycbcr) {
+    ATRACE_CALL();
+
+    if (mMapperVersion < GRALLOC_4) {
+        return INVALID_OPERATION;
+    }
+    usage &= kCpuUsageMask;
+    if (usage == 0) {
+        return BAD_VALUE;
+    }
+
+    // Map the whole buffer. The bounds of the locks of the users are only hints to the mapper.
+    uint64_t width = 0;
+    uint64_t height = 0;
+    if (const status_t error = getWidth(handle, &width); error != NO_ERROR) {
+        return error;
+    }
+    if (const status_t error = getHeight(handle, &height); error != NO_ERROR) {
+        return error;
+    }
+    const Rect bounds(static_cast<int32_t>(width), static_cast<int32_t>(height));
+
+    std::lock_guard lock(mMappingMutex);
+    if (const auto it = mPersistentMappings.find(handle); it != mPersistentMappings.end()) {
+        if (it->second.lockedUsage) {
+            return INVALID_OPERATION;
+        }
+        eraseMappingLocked(handle);
+    }
+
+    PersistentMapping mapping = {.usage = usage, .ycbcr = ycbcr};
+    status_t error = ycbcr ? mMapper->lock(handle, usage, bounds, -1, &mapping.ycbcrLayout)
+                           : mMapper->lock(handle, usage, bounds, -1, &mapping.vaddr,
+                                           &mapping.bytesPerPixel, &mapping.bytesPerStride);
+    if (error != NO_ERROR) {
+        return error;
+    }
+
+    // Make sure that the mapper can keep the buffer coherent while it stays locked.
+    error = mMapper->rereadLockedBuffer(handle);
+    if (error != NO_ERROR) {
+        closeFence(mMapper->unlock(handle));
+        return error;
+    }
+
+    mPersistentMappings.emplace(handle, mapping);
+    mPersistentMappingCount++;
+    return NO_ERROR;
+}
+
+void GraphicBufferMapper::disablePersistentMapping(buffer_handle_t handle) {
+    std::lock_guard lock(mMappingMutex);
+    const auto it = mPersistentMappings.find(handle);
+    if (it == mPersistentMappings.end()) {
+        return;
+    }
+    if (it->second.lockedUsage) {
+        // Keep the buffer mapped for the user that has it locked, unlockPersistent unmaps it.
+        it->second.usage = 0;
+        return;
+    }
+    eraseMappingLocked(handle);
+}
+
+bool GraphicBufferMapper::isPersistentlyMapped(buffer_handle_t handle) const {
+    std::lock_guard lock(mMappingMutex);
+    const auto it = mPersistentMappings.find(handle);
+    return it != mPersistentMappings.end() && it->second.usage != 0;
+}
+
+std::optional<status_t> GraphicBufferMapper::lockPersistent(
+        buffer_handle_t handle, uint64_t usage, bool ycbcr, int fenceFd, void** outVaddr,
+        android_ycbcr* outYcbcr, int32_t* outBytesPerPixel, int32_t* outBytesPerStride) {
+    if (mPersistentMappingCount.load(std::memory_order_relaxed) == 0) {
+        return std::nullopt;
+    }
+
+    std::unique_lock lock(mMappingMutex);
+    const auto it = mPersistentMappings.find(handle);
+    if (it == mPersistentMappings.end()) {
+        return std::nullopt;
+    }
+
+    PersistentMapping& mapping = it->second;
+    if (mapping.lockedUsage) {
+        // Let the mapper reject the second lock, as it does for buffers that are not mapped.
+        return std::nullopt;
+    }
+    usage &= kCpuUsageMask;
+    if (ycbcr != mapping.ycbcr || usage == 0 || (usage & ~mapping.usage) != 0) {
+        ALOGD("lockPersistent(%p): unmapping the buffer for a lock with usage %#" PRIx64,
+              handle, usage);
+        eraseMappingLocked(handle);
+        return std::nullopt;
+    }
+    mapping.lockedUsage = usage;
+    const PersistentMapping locked = mapping;
+    lock.unlock();
+
+    if (fenceFd >= 0) {
+        sync_wait(fenceFd, -1);
+        close(fenceFd);
+    }
+    if (usage & GRALLOC_USAGE_SW_READ_MASK) {
+        if (const status_t error = mMapper->rereadLockedBuffer(handle); error != NO_ERROR) {
+            lock.lock();
+            if (const auto current = mPersistentMappings.find(handle);
+                current != mPersistentMappings.end()) {
+                current->second.lockedUsage.reset();
+            }
+            return error;
+        }
+    }
+
+    if (ycbcr) {
+        *outYcbcr = locked.ycbcrLayout;
+    } else {
+        *outVaddr = locked.vaddr;
+        if (outBytesPerPixel) *outBytesPerPixel = locked.bytesPerPixel;
+        if (outBytesPerStride) *outBytesPerStride = locked.bytesPerStride;
+    }
+    return NO_ERROR;
+}
+
+std::optional<status_t> GraphicBufferMapper::unlockPersistent(buffer_handle_t handle,
+                                                              int* outFenceFd) {
+    if (mPersistentMappingCount.load(std::memory_order_relaxed) == 0) {
+        return std::nullopt;
+    }
+
+    std::unique_lock lock(mMappingMutex);
+    const auto it = mPersistentMappings.find(handle);
+    if (it == mPersistentMappings.end() || !it->second.lockedUsage) {
+        return std::nullopt;
+    }
+
+    const uint64_t lockedUsage = *it->second.lockedUsage;
+    it->second.lockedUsage.reset();
+    if (it->second.usage == 0) {
+        // The mapping was disabled while the buffer was locked. Unmapping it flushes it.
+        *outFenceFd = mMapper->unlock(handle);
+        mPersistentMappings.erase(it);
+        mPersistentMappingCount--;
+        return NO_ERROR;
+    }
+    lock.unlock();
+
+    *outFenceFd = -1;
+    if (lockedUsage & GRALLOC_USAGE_SW_WRITE_MASK) {
+        return mMapper->flushLockedBuffer(handle, outFenceFd);
+    }
+    return NO_ERROR;
+}
+
+void GraphicBufferMapper::eraseMappingLocked(buffer_handle_t handle) {
+    const auto it = mPersistentMappings.find(handle);
+    if (it == mPersistentMappings.end()) {
+        return;
+    }
+    const int fenceFd = mMapper->unlock(handle);
+    if (fenceFd >= 0) {
+        sync_wait(fenceFd, -1);
+        close(fenceFd);
+    }
+    mPersistentMappings.erase(it);
+    mPersistentMappingCount--;
+}
+
 status_t GraphicBufferMapper::isSupported(uint32_t width, uint32_t height,
                                           android::PixelFormat format, uint32_t layerCount,
                                           uint64_t usage, bool* outSupported) {
@@ -201,52 +405,77 @@ status_t GraphicBufferMapper::isSupported(uint32_t width, uint32_t height,
 }
 
 status_t GraphicBufferMapper::getBufferId(buffer_handle_t bufferHandle, uint64_t* outBufferId) {
-    return mMapper->getBufferId(bufferHandle, outBufferId);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::bufferId, outBufferId,
+                             [&](auto* value) {
+                                 return mMapper->getBufferId(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getName(buffer_handle_t bufferHandle, std::string* outName) {
-    return mMapper->getName(bufferHandle, outName);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::name, outName,
+                             [&](auto* value) { return mMapper->getName(bufferHandle, value); });
 }
 
 status_t GraphicBufferMapper::getWidth(buffer_handle_t bufferHandle, uint64_t* outWidth) {
-    return mMapper->getWidth(bufferHandle, outWidth);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::width, outWidth,
+                             [&](auto* value) { return mMapper->getWidth(bufferHandle, value); });
 }
 
 status_t GraphicBufferMapper::getHeight(buffer_handle_t bufferHandle, uint64_t* outHeight) {
-    return mMapper->getHeight(bufferHandle, outHeight);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::height, outHeight,
+                             [&](auto* value) { return mMapper->getHeight(bufferHandle, value); });
 }
 
 status_t GraphicBufferMapper::getLayerCount(buffer_handle_t bufferHandle, uint64_t* outLayerCount) {
-    return mMapper->getLayerCount(bufferHandle, outLayerCount);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::layerCount, outLayerCount,
+                             [&](auto* value) {
+                                 return mMapper->getLayerCount(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getPixelFormatRequested(buffer_handle_t bufferHandle,
                                                       ui::PixelFormat* outPixelFormatRequested) {
-    return mMapper->getPixelFormatRequested(bufferHandle, outPixelFormatRequested);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::pixelFormatRequested,
+                             outPixelFormatRequested, [&](auto* value) {
+                                 return mMapper->getPixelFormatRequested(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getPixelFormatFourCC(buffer_handle_t bufferHandle,
                                                    uint32_t* outPixelFormatFourCC) {
-    return mMapper->getPixelFormatFourCC(bufferHandle, outPixelFormatFourCC);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::pixelFormatFourCC,
+                             outPixelFormatFourCC, [&](auto* value) {
+                                 return mMapper->getPixelFormatFourCC(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getPixelFormatModifier(buffer_handle_t bufferHandle,
                                                      uint64_t* outPixelFormatModifier) {
-    return mMapper->getPixelFormatModifier(bufferHandle, outPixelFormatModifier);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::pixelFormatModifier,
+                             outPixelFormatModifier, [&](auto* value) {
+                                 return mMapper->getPixelFormatModifier(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getUsage(buffer_handle_t bufferHandle, uint64_t* outUsage) {
-    return mMapper->getUsage(bufferHandle, outUsage);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::usage, outUsage,
+                             [&](auto* value) { return mMapper->getUsage(bufferHandle, value); });
 }
 
 status_t GraphicBufferMapper::getAllocationSize(buffer_handle_t bufferHandle,
                                                 uint64_t* outAllocationSize) {
-    return mMapper->getAllocationSize(bufferHandle, outAllocationSize);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::allocationSize, outAllocationSize,
+                             [&](auto* value) {
+                                 return mMapper->getAllocationSize(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getProtectedContent(buffer_handle_t bufferHandle,
                                                   uint64_t* outProtectedContent) {
-    return mMapper->getProtectedContent(bufferHandle, outProtectedContent);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::protectedContent,
+                             outProtectedContent, [&](auto* value) {
+                                 return mMapper->getProtectedContent(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getCompression(
@@ -257,7 +486,10 @@ status_t GraphicBufferMapper::getCompression(
 
 status_t GraphicBufferMapper::getCompression(buffer_handle_t bufferHandle,
                                              ui::Compression* outCompression) {
-    return mMapper->getCompression(bufferHandle, outCompression);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::compression, outCompression,
+                             [&](auto* value) {
+                                 return mMapper->getCompression(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getInterlaced(
@@ -268,7 +500,10 @@ status_t GraphicBufferMapper::getInterlaced(
 
 status_t GraphicBufferMapper::getInterlaced(buffer_handle_t bufferHandle,
                                             ui::Interlaced* outInterlaced) {
-    return mMapper->getInterlaced(bufferHandle, outInterlaced);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::interlaced, outInterlaced,
+                             [&](auto* value) {
+                                 return mMapper->getInterlaced(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getChromaSiting(
@@ -279,12 +514,18 @@ status_t GraphicBufferMapper::getChromaSiting(
 
 status_t GraphicBufferMapper::getChromaSiting(buffer_handle_t bufferHandle,
                                               ui::ChromaSiting* outChromaSiting) {
-    return mMapper->getChromaSiting(bufferHandle, outChromaSiting);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::chromaSiting, outChromaSiting,
+                             [&](auto* value) {
+                                 return mMapper->getChromaSiting(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getPlaneLayouts(buffer_handle_t bufferHandle,
                                               std::vector<ui::PlaneLayout>* outPlaneLayouts) {
-    return mMapper->getPlaneLayouts(bufferHandle, outPlaneLayouts);
+    return getCachedMetadata(bufferHandle, &ImmutableMetadata::planeLayouts, outPlaneLayouts,
+                             [&](auto* value) {
+                                 return mMapper->getPlaneLayouts(bufferHandle, value);
+                             });
 }
 
 status_t GraphicBufferMapper::getDataspace(buffer_handle_t bufferHandle,
@@ -341,5 +582,53 @@ status_t GraphicBufferMapper::setSmpte2094_10(buffer_handle_t bufferHandle,
     return mMapper->setSmpte2094_10(bufferHandle, smpte2094_10);
 }
 
+GraphicBufferMapper::MetadataCacheStats GraphicBufferMapper::getMetadataCacheStats() const {
+    std::lock_guard lock(mMetadataMutex);
+    return {.bufferCount = mMetadataCache.size(),
+            .hits = mMetadataCacheHits,
+            .misses = mMetadataCacheMisses};
+}
+
+void GraphicBufferMapper::dumpMetadataCache(std::string& result) const {
+    const MetadataCacheStats stats = getMetadataCacheStats();
+    base::StringAppendF(&result,
+                        "GraphicBufferMapper metadata cache: %zu buffers, %" PRIu64
+                        " hits, %" PRIu64 " misses\n",
+                        stats.bufferCount, stats.hits, stats.misses);
+}
+
+template <typename T, typename Fetch>
+status_t GraphicBufferMapper::getCachedMetadata(buffer_handle_t bufferHandle,
+                                                std::optional<T> ImmutableMetadata::*field,
+                                                T* outValue, Fetch&& fetch) {
+    {
+        std::lock_guard lock(mMetadataMutex);
+        const auto it = mMetadataCache.find(bufferHandle);
+        if (it != mMetadataCache.end() && (it->second.*field).has_value()) {
+            *outValue = *(it->second.*field);
+            mMetadataCacheHits++;
+            return NO_ERROR;
+        }
+    }
+
+    // Make the call to the mapper without the lock held.
+    mMetadataCacheMisses++;
+    T value;
+    const status_t error = fetch(&value);
+    if (error != NO_ERROR) {
+        return error;
+    }
+
+    {
+        std::lock_guard lock(mMetadataMutex);
+        if (mMetadataCache.size() >= kMaxCachedBuffers && !mMetadataCache.contains(bufferHandle)) {
+            mMetadataCache.clear();
+        }
+        mMetadataCache[bufferHandle].*field = value;
+    }
+    *outValue = std::move(value);
+    return NO_ERROR;
+}
+
 // ---------------------------------------------------------------------------
 }; // namespace android
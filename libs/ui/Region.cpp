@@ -27,6 +27,7 @@
 #include <ui/Rect.h>
 #include <ui/Region.h>
 #include <ui/RegionHelper.h>
+#include <ui/RegionSimd.h>
 
 // ----------------------------------------------------------------------------
 
@@ -64,6 +65,10 @@ enum {
 
 const Region Region::INVALID_REGION(Rect::INVALID_RECT);
 
+// Same inline capacity as Region::mStorage, so that scratch buffers and spans of small regions
+// stay off the heap too.
+using RectStorage = FatVector<Rect, Region::kInlineRectCount + 1>;
+
 // ----------------------------------------------------------------------------
 
 Region::Region() {
@@ -101,7 +106,7 @@ Region::~Region()
  * final, correctly ordered region buffer. Each rectangle will be compared with the span directly
  * above it, and subdivided to resolve any remaining T-junctions.
  */
-static void reverseRectsResolvingJunctions(const Rect* begin, const Rect* end, FatVector<Rect>& dst,
+static void reverseRectsResolvingJunctions(const Rect* begin, const Rect* end, RectStorage& dst,
                                            int spanDirection) {
     dst.clear();
 
@@ -202,7 +207,7 @@ Region Region::createTJunctionFreeRegion(const Region& r) {
     if (r.isEmpty()) return r;
     if (r.isRect()) return r;
 
-    FatVector<Rect> reversed;
+    RectStorage reversed;
     reverseRectsResolvingJunctions(r.begin(), r.end(), reversed, direction_RTL);
 
     Region outputRegion;
@@ -249,15 +254,8 @@ bool Region::contains(const Point& point) const {
 }
 
 bool Region::contains(int x, int y) const {
-    const_iterator cur = begin();
-    const_iterator const tail = end();
-    while (cur != tail) {
-        if (y >= cur->top && y < cur->bottom && x >= cur->left && x < cur->right) {
-            return true;
-        }
-        cur++;
-    }
-    return false;
+    const_iterator const head = begin();
+    return region_simd::activeOps().contains(head, static_cast<size_t>(end() - head), x, y);
 }
 
 void Region::clear()
@@ -470,10 +468,10 @@ const Region Region::operation(const Region& rhs, int dx, int dy, uint32_t op) c
 class Region::rasterizer : public region_operator<Rect>::region_rasterizer
 {
     Rect bounds;
-    FatVector<Rect>& storage;
+    RectStorage& storage;
     Rect* head;
     Rect* tail;
-    FatVector<Rect> span;
+    RectStorage span;
     Rect* cur;
 public:
     explicit rasterizer(Region& reg)
@@ -799,13 +797,8 @@ void Region::translate(Region& reg, int dx, int dy)
 #if defined(VALIDATE_REGIONS)
         validate(reg, "translate (before)");
 #endif
-        size_t count = reg.mStorage.size();
-        Rect* rects = reg.mStorage.data();
-        while (count) {
-            rects->offsetBy(dx, dy);
-            rects++;
-            count--;
-        }
+        // The trailing bounds rect, if any, is translated along with the others.
+        region_simd::activeOps().offset(reg.mStorage.data(), reg.mStorage.size(), dx, dy);
 #if defined(VALIDATE_REGIONS)
         validate(reg, "translate (after)");
 #endif
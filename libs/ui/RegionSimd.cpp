@@ -0,0 +1,197 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/RegionSimd.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define REGION_SIMD_NEON 1
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#define REGION_SIMD_SSE2 1
+#if (defined(__clang__) || defined(__GNUC__)) && !defined(_WIN32)
+#define REGION_SIMD_AVX2 1
+#endif
+#endif
+
+namespace android::region_simd {
+
+// The vector kernels load a Rect as four consecutive int32_t lanes.
+static_assert(sizeof(Rect) == 4 * sizeof(int32_t));
+static_assert(offsetof(ARect, left) == 0 && offsetof(ARect, top) == 4 &&
+              offsetof(ARect, right) == 8 && offsetof(ARect, bottom) == 12);
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// scalar
+
+void offsetScalar(Rect* rects, size_t count, int32_t dx, int32_t dy) {
+    for (size_t i = 0; i < count; i++) {
+        rects[i].offsetBy(dx, dy);
+    }
+}
+
+bool containsScalar(const Rect* rects, size_t count, int32_t x, int32_t y) {
+    for (size_t i = 0; i < count; i++) {
+        const Rect& r = rects[i];
+        if (y >= r.top && y < r.bottom && x >= r.left && x < r.right) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// NEON
+
+#if defined(REGION_SIMD_NEON)
+
+void offsetNeon(Rect* rects, size_t count, int32_t dx, int32_t dy) {
+    const int32_t delta[4] = {dx, dy, dx, dy};
+    const int32x4_t d = vld1q_s32(delta);
+    int32_t* p = reinterpret_cast<int32_t*>(rects);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, p += 8) {
+        vst1q_s32(p, vaddq_s32(vld1q_s32(p), d));
+        vst1q_s32(p + 4, vaddq_s32(vld1q_s32(p + 4), d));
+    }
+    if (i < count) {
+        vst1q_s32(p, vaddq_s32(vld1q_s32(p), d));
+    }
+}
+
+bool containsNeon(const Rect* rects, size_t count, int32_t x, int32_t y) {
+    // (x, y) is inside (l, t, r, b) iff l > x and t > y are false while r > x and b > y are true.
+    const int32_t point[4] = {x, y, x, y};
+    const uint32_t expected[4] = {0u, 0u, ~0u, ~0u};
+    const int32x4_t pt = vld1q_s32(point);
+    const uint32x4_t want = vld1q_u32(expected);
+    const int32_t* p = reinterpret_cast<const int32_t*>(rects);
+    for (size_t i = 0; i < count; i++, p += 4) {
+        const uint32x4_t hit = vceqq_u32(vcgtq_s32(vld1q_s32(p), pt), want);
+        if (vminvq_u32(hit) == ~0u) {
+            return true;
+        }
+    }
+    return false;
+}
+
+constexpr RectOps kNeonOps = {offsetNeon, containsNeon, "neon"};
+
+#endif // REGION_SIMD_NEON
+
+// ----------------------------------------------------------------------------
+// SSE2 / AVX2
+
+#if defined(REGION_SIMD_SSE2)
+
+void offsetSse2(Rect* rects, size_t count, int32_t dx, int32_t dy) {
+    const __m128i d = _mm_setr_epi32(dx, dy, dx, dy);
+    __m128i* p = reinterpret_cast<__m128i*>(rects);
+    for (size_t i = 0; i < count; i++) {
+        _mm_storeu_si128(p + i, _mm_add_epi32(_mm_loadu_si128(p + i), d));
+    }
+}
+
+bool containsSse2(const Rect* rects, size_t count, int32_t x, int32_t y) {
+    // See containsNeon: the greater-than mask of a hit is exactly (0, 0, ~0, ~0).
+    const __m128i pt = _mm_setr_epi32(x, y, x, y);
+    const __m128i* p = reinterpret_cast<const __m128i*>(rects);
+    for (size_t i = 0; i < count; i++) {
+        const __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128(p + i), pt);
+        if (_mm_movemask_ps(_mm_castsi128_ps(gt)) == 0xc) {
+            return true;
+        }
+    }
+    return false;
+}
+
+constexpr RectOps kSse2Ops = {offsetSse2, containsSse2, "sse2"};
+
+#if defined(REGION_SIMD_AVX2)
+
+__attribute__((target("avx2"))) void offsetAvx2(Rect* rects, size_t count, int32_t dx,
+                                                  int32_t dy) {
+    const __m256i d = _mm256_setr_epi32(dx, dy, dx, dy, dx, dy, dx, dy);
+    int32_t* p = reinterpret_cast<int32_t*>(rects);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, p += 8) {
+        __m256i* v = reinterpret_cast<__m256i*>(p);
+        _mm256_storeu_si256(v, _mm256_add_epi32(_mm256_loadu_si256(v), d));
+    }
+    if (i < count) {
+        __m128i* v = reinterpret_cast<__m128i*>(p);
+        _mm_storeu_si128(v, _mm_add_epi32(_mm_loadu_si128(v), _mm256_castsi256_si128(d)));
+    }
+}
+
+__attribute__((target("avx2"))) bool containsAvx2(const Rect* rects, size_t count, int32_t x,
+                                                    int32_t y) {
+    const __m256i pt = _mm256_setr_epi32(x, y, x, y, x, y, x, y);
+    const int32_t* p = reinterpret_cast<const int32_t*>(rects);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, p += 8) {
+        const __m256i gt =
+                _mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), pt);
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(gt));
+        if ((mask & 0xf) == 0xc || (mask >> 4) == 0xc) {
+            return true;
+        }
+    }
+    if (i < count) {
+        const __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                           _mm256_castsi256_si128(pt));
+        return _mm_movemask_ps(_mm_castsi128_ps(gt)) == 0xc;
+    }
+    return false;
+}
+
+constexpr RectOps kAvx2Ops = {offsetAvx2, containsAvx2, "avx2"};
+
+#endif // REGION_SIMD_AVX2
+#endif // REGION_SIMD_SSE2
+
+constexpr RectOps kScalarOps = {offsetScalar, containsScalar, "scalar"};
+
+const RectOps& selectOps() {
+#if defined(REGION_SIMD_NEON)
+    // Advanced SIMD is mandatory on arm64.
+    return kNeonOps;
+#elif defined(REGION_SIMD_SSE2)
+#if defined(REGION_SIMD_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return kAvx2Ops;
+    }
+#endif
+    return kSse2Ops;
+#else
+    return kScalarOps;
+#endif
+}
+
+} // namespace
+
+const RectOps& scalarOps() {
+    return kScalarOps;
+}
+
+const RectOps& activeOps() {
+    static const RectOps& sOps = selectOps();
+    return sOps;
+}
+
+} // namespace android::region_simd
@@ -19,6 +19,11 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
 #include <android-base/stringprintf.h>
 #include <cutils/compiler.h>
 #include <ui/Region.h>
@@ -51,6 +56,58 @@ bool Transform::absIsOne(float f) {
     return isZero(fabs(f) - 1.0f);
 }
 
+namespace {
+
+// A transform that maps integer coordinates to integer coordinates exactly: a translation by whole
+// pixels combined with flips and rotations by multiples of 90 degrees, which is what most layers
+// and displays use. Its rects are transformed with integer arithmetic instead of through floats,
+// which lose precision past 2^24 and need to be rounded.
+struct IntegerTransform {
+    int64_t a, b, c, d, x, y;
+
+    static std::optional<IntegerTransform> from(float a, float b, float c, float d, float x,
+                                                float y) {
+        const auto isUnit = [](float f) { return f == 0.0f || f == 1.0f || f == -1.0f; };
+        const auto isInteger = [](float f) {
+            return f == truncf(f) && fabsf(f) <= 0x1p31f;
+        };
+        if (!isUnit(a) || !isUnit(b) || !isUnit(c) || !isUnit(d) || !isInteger(x) ||
+            !isInteger(y)) {
+            return std::nullopt;
+        }
+        // Only flips and rotations map rects to rects.
+        const bool axisAligned = b == 0.0f && c == 0.0f && a != 0.0f && d != 0.0f;
+        const bool swapsAxes = a == 0.0f && d == 0.0f && b != 0.0f && c != 0.0f;
+        if (!axisAligned && !swapsAxes) {
+            return std::nullopt;
+        }
+        return IntegerTransform{static_cast<int64_t>(a), static_cast<int64_t>(b),
+                                static_cast<int64_t>(c), static_cast<int64_t>(d),
+                                static_cast<int64_t>(x), static_cast<int64_t>(y)};
+    }
+
+    Rect transform(const Rect& r) const {
+        // The opposite corners of the rect are mapped to opposite corners.
+        const int64_t x0 = a * r.left + b * r.top + x;
+        const int64_t y0 = c * r.left + d * r.top + y;
+        const int64_t x1 = a * r.right + b * r.bottom + x;
+        const int64_t y1 = c * r.right + d * r.bottom + y;
+        return Rect(clamp(std::min(x0, x1)), clamp(std::min(y0, y1)), clamp(std::max(x0, x1)),
+                    clamp(std::max(y0, y1)));
+    }
+
+    static int32_t clamp(int64_t v) {
+        return static_cast<int32_t>(std::clamp<int64_t>(v, std::numeric_limits<int32_t>::min(),
+                                                        std::numeric_limits<int32_t>::max()));
+    }
+};
+
+} // namespace
+
+bool Transform::isAffine() const {
+    return mMatrix[0][2] == 0.0f && mMatrix[1][2] == 0.0f && mMatrix[2][2] == 1.0f;
+}
+
 bool Transform::operator==(const Transform& other) const {
     return mMatrix[0][0] == other.mMatrix[0][0] && mMatrix[0][1] == other.mMatrix[0][1] &&
             mMatrix[0][2] == other.mMatrix[0][2] && mMatrix[1][0] == other.mMatrix[1][0] &&
@@ -67,7 +124,27 @@ Transform Transform::operator*(const Transform& rhs) const {
     if (rhs.mType == IDENTITY)
         return r;
 
-    // TODO: we could use mType to optimize the matrix multiply
+    // Composing with a translation only moves the translation of the other transform, which
+    // gives the same result as the full multiply below without its 27 multiplications.
+    const uint32_t lhsType = type();
+    const uint32_t rhsType = rhs.type();
+    if (isAffine() && rhs.isAffine()) {
+        if (!(lhsType & ~TRANSLATE & 0xFF)) {
+            r = rhs;
+            r.mMatrix[2][0] = mMatrix[2][0] + rhs.mMatrix[2][0];
+            r.mMatrix[2][1] = mMatrix[2][1] + rhs.mMatrix[2][1];
+            r.updateTranslateType(rhsType);
+            return r;
+        }
+        if (!(rhsType & ~TRANSLATE & 0xFF)) {
+            const vec2 t = transform(rhs.mMatrix[2][0], rhs.mMatrix[2][1]);
+            r.mMatrix[2][0] = t.x;
+            r.mMatrix[2][1] = t.y;
+            r.updateTranslateType(lhsType);
+            return r;
+        }
+    }
+
     const mat33& A(mMatrix);
     const mat33& B(rhs.mMatrix);
           mat33& D(r.mMatrix);
@@ -87,6 +164,13 @@ Transform Transform::operator*(const Transform& rhs) const {
     return r;
 }
 
+void Transform::updateTranslateType(uint32_t type) {
+    mType = type & ~TRANSLATE;
+    if (!isZero(mMatrix[2][0]) || !isZero(mMatrix[2][1])) {
+        mType |= TRANSLATE;
+    }
+}
+
 Transform Transform::operator * (float value) const {
     Transform r(*this);
     const mat33& M(mMatrix);
@@ -247,11 +331,58 @@ vec2 Transform::transform(float x, float y) const {
     return transform(vec2(x, y));
 }
 
+void Transform::transform(const vec2* points, size_t count, vec2* outPoints) const {
+    const mat33& M(mMatrix);
+    const float tx = M[2][0];
+    const float ty = M[2][1];
+    if (!(type() & ~TRANSLATE & 0xFF)) {
+        for (size_t i = 0; i < count; i++) {
+            outPoints[i] = vec2(points[i].x + tx, points[i].y + ty);
+        }
+        return;
+    }
+
+    // Loads the matrix once rather than per point, so that the loop can be vectorized.
+    const float a = M[0][0];
+    const float b = M[1][0];
+    const float c = M[0][1];
+    const float d = M[1][1];
+    for (size_t i = 0; i < count; i++) {
+        const float x = points[i].x;
+        const float y = points[i].y;
+        outPoints[i] = vec2(a * x + b * y + tx, c * x + d * y + ty);
+    }
+}
+
+void Transform::transform(const Rect* rects, size_t count, Rect* outRects,
+                          bool roundOutwards) const {
+    const mat33& M(mMatrix);
+    if (const auto integer = IntegerTransform::from(M[0][0], M[1][0], M[0][1], M[1][1], M[2][0],
+                                                     M[2][1])) {
+        for (size_t i = 0; i < count; i++) {
+            outRects[i] = integer->transform(rects[i]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        outRects[i] = transformFloat(rects[i], roundOutwards);
+    }
+}
+
 Rect Transform::makeBounds(int w, int h) const {
     return transform( Rect(w, h) );
 }
 
 Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
+    const mat33& M(mMatrix);
+    if (const auto integer = IntegerTransform::from(M[0][0], M[1][0], M[0][1], M[1][1], M[2][0],
+                                                     M[2][1])) {
+        return integer->transform(bounds);
+    }
+    return transformFloat(bounds, roundOutwards);
+}
+
+Rect Transform::transformFloat(const Rect& bounds, bool roundOutwards) const {
     Rect r;
     vec2 lt( bounds.left,  bounds.top    );
     vec2 rt( bounds.right, bounds.top    );
@@ -279,6 +410,15 @@ Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
 }
 
 FloatRect Transform::transform(const FloatRect& bounds) const {
+    if (!(type() & ~TRANSLATE & 0xFF)) {
+        const float x = tx();
+        const float y = ty();
+        return FloatRect(std::min(bounds.left, bounds.right) + x,
+                         std::min(bounds.top, bounds.bottom) + y,
+                         std::max(bounds.left, bounds.right) + x,
+                         std::max(bounds.top, bounds.bottom) + y);
+    }
+
     vec2 lt(bounds.left, bounds.top);
     vec2 rt(bounds.right, bounds.top);
     vec2 lb(bounds.left, bounds.bottom);
@@ -302,10 +442,12 @@ Region Transform::transform(const Region& reg) const {
     Region out;
     if (CC_UNLIKELY(type() > TRANSLATE)) {
         if (CC_LIKELY(preserveRects())) {
-            Region::const_iterator it = reg.begin();
-            Region::const_iterator const end = reg.end();
-            while (it != end) {
-                out.orSelf(transform(*it++));
+            size_t count = 0;
+            const Rect* const rects = reg.getArray(&count);
+            std::vector<Rect> transformed(count);
+            transform(rects, count, transformed.data());
+            for (const Rect& rect : transformed) {
+                out.orSelf(rect);
             }
         } else {
             out.set(transform(reg.bounds()));
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+#include <ui/Fence.h>
+#include <ui/FenceTime.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+namespace android {
+
+// Watches the fences of FenceTimes on one thread per process, and stores their signal time into
+// the FenceTimes once they signal.
+//
+// A FenceTime whose fence is not watched reads the signal time of the fence with a sync_file_info
+// ioctl every time it is queried while pending, and the same fence is usually queried by several
+// users each frame, e.g. FrameTimeline, TimeStats and the frame timestamps of the producer. A
+// watched FenceTime instead returns SIGNAL_TIME_PENDING from an atomic load until the watcher's
+// thread, woken by epoll once the fence signals, reads the signal time with a single ioctl.
+//
+// Fences that cannot be watched, e.g. because the watcher is full, keep being polled by their
+// FenceTimes.
+class FenceSignalWatcher {
+public:
+    // The number of fences that can be watched at once.
+    static constexpr size_t kMaxFences = 256;
+
+    // Returns the watcher of the process. Setting debug.ui.fence_watcher to false disables it.
+    static FenceSignalWatcher& getInstance();
+
+    explicit FenceSignalWatcher(bool enabled);
+    ~FenceSignalWatcher();
+
+    bool isEnabled() const { return mEpollFd.ok(); }
+
+    // Starts watching the fence of a pending FenceTime. Returns false if the fence is not watched,
+    // in which case the FenceTime keeps polling it.
+    bool watch(const std::shared_ptr<FenceTime>& fenceTime) EXCLUDES(mMutex);
+
+    size_t getWatchedCount() const EXCLUDES(mMutex);
+
+    // Blocks until the watched fences have signaled and their signal times have been stored.
+    // Used by tests and benchmarks.
+    void waitForWatchedFences() EXCLUDES(mMutex);
+
+private:
+    struct Entry {
+        // Keeps the file descriptor that is registered with epoll open.
+        sp<Fence> fence;
+        std::weak_ptr<FenceTime> fenceTime;
+    };
+
+    // Stops watching the fences of the FenceTimes that were destroyed.
+    void removeExpiredLocked() REQUIRES(mMutex);
+    void threadMain() EXCLUDES(mMutex);
+
+    base::unique_fd mEpollFd;
+    // Wakes up the thread when the watcher is destroyed.
+    base::unique_fd mWakeFd;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::unordered_map<uint64_t, Entry> mEntries GUARDED_BY(mMutex);
+    uint64_t mNextId GUARDED_BY(mMutex) = 1;
+    std::optional<std::thread> mThread GUARDED_BY(mMutex);
+};
+
+} // namespace android
@@ -29,12 +29,14 @@
 
 namespace android {
 
+class FenceSignalWatcher;
 class FenceToFenceTimeMap;
 
 // A wrapper around fence that only implements isValid and getSignalTime.
 // It automatically closes the fence in a thread-safe manner once the signal
 // time is known.
 class FenceTime {
+friend class FenceSignalWatcher;
 friend class FenceToFenceTimeMap;
 public:
     // An atomic snapshot of the FenceTime that is flattenable.
@@ -103,7 +105,9 @@ public:
     bool isValid() const;
 
     // Attempts to get the timestamp from the Fence if the timestamp isn't
-    // already cached. Otherwise, it returns the cached value.
+    // already cached. Otherwise, it returns the cached value. Fences that are
+    // watched by FenceSignalWatcher are not queried, since the watcher caches
+    // the timestamp once the fence signals.
     nsecs_t getSignalTime();
 
     // Gets the cached timestamp without attempting to query the Fence.
@@ -132,6 +136,13 @@ private:
         FORCED_VALID_FOR_TEST,
     };
 
+    // Used by FenceSignalWatcher. startWatching returns the fence to watch,
+    // or nullptr if the signal time is known or the fence cannot be watched.
+    // stopWatching caches the signal time of the fence, unless it is
+    // SIGNAL_TIME_PENDING, and lets getSignalTime query the fence again.
+    sp<Fence> startWatching();
+    void stopWatching(nsecs_t signalTime);
+
     const State mState{State::INVALID};
 
     // mMutex guards mFence and mSignalTime.
@@ -140,6 +151,8 @@ private:
     mutable std::mutex mMutex;
     sp<Fence> mFence{Fence::NO_FENCE};
     std::atomic<nsecs_t> mSignalTime{Fence::SIGNAL_TIME_INVALID};
+    // Whether FenceSignalWatcher is watching mFence.
+    std::atomic<bool> mWatched{false};
 };
 
 // A queue of FenceTimes that are expected to signal in FIFO order.
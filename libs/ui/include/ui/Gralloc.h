@@ -71,6 +71,20 @@ public:
     // owned by the caller
     virtual int unlock(buffer_handle_t bufferHandle) const = 0;
 
+    // Makes what the CPU wrote to a locked buffer visible to the other users of the buffer,
+    // without unlocking it. outReleaseFence is set to a fence sync object owned by the caller,
+    // or -1. Supported by gralloc 4.0+.
+    virtual status_t flushLockedBuffer(buffer_handle_t /*bufferHandle*/,
+                                       int* /*outReleaseFence*/) const {
+        return INVALID_OPERATION;
+    }
+
+    // Makes what the other users of a locked buffer wrote to it visible to the CPU, without
+    // locking it again. Supported by gralloc 4.0+.
+    virtual status_t rereadLockedBuffer(buffer_handle_t /*bufferHandle*/) const {
+        return INVALID_OPERATION;
+    }
+
     // isSupported queries whether or not a buffer with the given width, height,
     // format, layer count, and usage can be allocated on the device.  If
     // *outSupported is set to true, a buffer with the given specifications may be successfully
@@ -143,6 +143,13 @@ public:
     GraphicBuffer(uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
             uint32_t inUsage, std::string requestorName = "<Unknown>");
 
+    // Allocates count buffers with the same attributes in a single call to the allocator,
+    // and appends them to outBuffers. This function is privileged.  See reallocate for details.
+    static status_t allocateBatch(uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
+                                  uint32_t inLayerCount, uint64_t inUsage, uint32_t count,
+                                  std::string requestorName,
+                                  std::vector<sp<GraphicBuffer>>* outBuffers);
+
     // return status
     status_t initCheck() const;
 
@@ -249,6 +256,11 @@ private:
                             uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
                             uint32_t inLayerCount, uint64_t inUsage, uint32_t inStride);
 
+    // Takes a handle allocated and imported by GraphicBufferAllocator.
+    void initWithAllocatedHandle(buffer_handle_t inHandle, uint32_t inWidth, uint32_t inHeight,
+                                 PixelFormat inFormat, uint32_t inLayerCount, uint64_t inUsage,
+                                 uint32_t inStride);
+
     void free_handle();
 
     GraphicBufferMapper& mBufferMapper;
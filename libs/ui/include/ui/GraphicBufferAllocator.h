@@ -20,9 +20,16 @@
 
 #include <stdint.h>
 
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <android-base/thread_annotations.h>
 #include <cutils/native_handle.h>
 
 #include <ui/PixelFormat.h>
@@ -62,6 +69,35 @@ public:
                                uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
                                std::string requestorName);
 
+    /**
+     * Allocates and imports count gralloc buffers with the same attributes in a single call to
+     * the allocator HAL, which returns the same stride for all of them. outHandles must point to
+     * space for count handles.
+     *
+     * Each handle must be freed with GraphicBufferAllocator::free() when no longer needed.
+     */
+    status_t allocateBatch(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
+                           uint64_t usage, uint32_t count, buffer_handle_t* outHandles,
+                           uint32_t* outStride, std::string requestorName);
+
+    struct AllocationBatch {
+        status_t status = NO_INIT;
+        uint32_t stride = 0;
+        std::vector<buffer_handle_t> handles;
+    };
+
+    /**
+     * Like allocateBatch, but allocates the buffers on one of the allocator threads, so that the
+     * caller does not block on the allocator HAL until it needs the buffers.
+     *
+     * The handles of the batch must be freed even if the caller no longer needs them, so the
+     * future must not be dropped before it completes.
+     */
+    std::future<AllocationBatch> allocateBatchAsync(uint32_t w, uint32_t h, PixelFormat format,
+                                                    uint32_t layerCount, uint64_t usage,
+                                                    uint32_t count, std::string requestorName)
+            EXCLUDES(mTaskMutex);
+
     /**
      * DEPRECATED: GraphicBufferAllocator does not use the graphicBufferId.
      */
@@ -90,8 +126,13 @@ protected:
     };
 
     status_t allocateHelper(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
-                            uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
-                            std::string requestorName, bool importBuffer);
+                            uint64_t usage, uint32_t count, buffer_handle_t* handles,
+                            uint32_t* stride, std::string requestorName, bool importBuffer);
+
+    // The number of threads that allocateBatchAsync allocates on.
+    static constexpr size_t kAllocatorThreadCount = 2;
+
+    void allocatorThreadMain() EXCLUDES(mTaskMutex);
 
     static Mutex sLock;
     static KeyedVector<buffer_handle_t, alloc_rec_t> sAllocList;
@@ -102,6 +143,12 @@ protected:
 
     GraphicBufferMapper& mMapper;
     std::unique_ptr<const GrallocAllocator> mAllocator;
+
+    std::mutex mTaskMutex;
+    std::condition_variable mTaskCondition;
+    std::deque<std::packaged_task<void()>> mTasks GUARDED_BY(mTaskMutex);
+    std::vector<std::thread> mAllocatorThreads GUARDED_BY(mTaskMutex);
+    bool mDone GUARDED_BY(mTaskMutex) = false;
 };
 
 // ---------------------------------------------------------------------------
@@ -20,8 +20,15 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include <android-base/thread_annotations.h>
 #include <ui/GraphicTypes.h>
 #include <ui/PixelFormat.h>
 #include <ui/Rect.h>
@@ -88,6 +95,24 @@ public:
 
     status_t unlockAsync(buffer_handle_t handle, int *fenceFd);
 
+    /**
+     * Keeps the buffer mapped for the CPU with the given usage until it is freed or the mapping
+     * is disabled, for the CPU pipelines that lock the same buffers every frame.
+     *
+     * While the buffer is persistently mapped, locking it for a subset of that usage, with lock
+     * if ycbcr is false and with lockYCbCr otherwise, only waits for the acquire fence and
+     * rereads the buffer into the CPU caches if the lock is for reading. Unlocking it only
+     * flushes the CPU caches if the lock was for writing. Neither maps nor unmaps the buffer
+     * through the mapper. Locks that need another usage or the other kind of lock disable the
+     * persistent mapping and lock the buffer as usual.
+     *
+     * This is supported by gralloc 4.0+, and fails with INVALID_OPERATION otherwise.
+     */
+    status_t enablePersistentMapping(buffer_handle_t handle, uint64_t usage, bool ycbcr)
+            EXCLUDES(mMappingMutex);
+    void disablePersistentMapping(buffer_handle_t handle) EXCLUDES(mMappingMutex);
+    bool isPersistentlyMapped(buffer_handle_t handle) const EXCLUDES(mMappingMutex);
+
     status_t isSupported(uint32_t width, uint32_t height, android::PixelFormat format,
                          uint32_t layerCount, uint64_t usage, bool* outSupported);
 
@@ -95,6 +120,11 @@ public:
      * Gets the gralloc metadata associated with the buffer.
      *
      * These functions are supported by gralloc 4.0+.
+     *
+     * The standard metadata that cannot change after the buffer is allocated, e.g. its usage and
+     * plane layouts, is only read from the mapper once per imported buffer, and cached until the
+     * buffer is freed. The metadata that can be set, e.g. the dataspace, is always read from the
+     * mapper, since it may be set through the mapper of another process.
      */
     status_t getBufferId(buffer_handle_t bufferHandle, uint64_t* outBufferId);
     status_t getName(buffer_handle_t bufferHandle, std::string* outName);
@@ -144,14 +174,86 @@ public:
 
     Version getMapperVersion() const { return mMapperVersion; }
 
+    struct MetadataCacheStats {
+        size_t bufferCount = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    MetadataCacheStats getMetadataCacheStats() const EXCLUDES(mMetadataMutex);
+    void dumpMetadataCache(std::string& result) const EXCLUDES(mMetadataMutex);
+
 private:
     friend class Singleton<GraphicBufferMapper>;
 
+    // The standard metadata of a buffer that is fixed at allocation, decoded.
+    struct ImmutableMetadata {
+        std::optional<uint64_t> bufferId;
+        std::optional<std::string> name;
+        std::optional<uint64_t> width;
+        std::optional<uint64_t> height;
+        std::optional<uint64_t> layerCount;
+        std::optional<ui::PixelFormat> pixelFormatRequested;
+        std::optional<uint32_t> pixelFormatFourCC;
+        std::optional<uint64_t> pixelFormatModifier;
+        std::optional<uint64_t> usage;
+        std::optional<uint64_t> allocationSize;
+        std::optional<uint64_t> protectedContent;
+        std::optional<ui::Compression> compression;
+        std::optional<ui::Interlaced> interlaced;
+        std::optional<ui::ChromaSiting> chromaSiting;
+        std::optional<std::vector<ui::PlaneLayout>> planeLayouts;
+    };
+
+    // Bounds the cache if buffers are freed without going through freeBuffer.
+    static constexpr size_t kMaxCachedBuffers = 1024;
+
+    // A buffer that stays locked by the mapper between the locks of its users.
+    struct PersistentMapping {
+        uint64_t usage = 0;
+        bool ycbcr = false;
+        void* vaddr = nullptr;
+        int32_t bytesPerPixel = -1;
+        int32_t bytesPerStride = -1;
+        android_ycbcr ycbcrLayout = {};
+        // The usage of the current lock of a user, if the buffer is locked by one.
+        std::optional<uint64_t> lockedUsage;
+    };
+
     GraphicBufferMapper();
 
+    // Returns the cached value of the field, or reads the value with fetch and caches it.
+    template <typename T, typename Fetch>
+    status_t getCachedMetadata(buffer_handle_t bufferHandle,
+                               std::optional<T> ImmutableMetadata::*field, T* outValue,
+                               Fetch&& fetch) EXCLUDES(mMetadataMutex);
+
+    // Locks a persistently mapped buffer. Returns nullopt if the buffer is not persistently
+    // mapped, or no longer is because the lock does not match its mapping, in which case the
+    // buffer is to be locked through the mapper and fenceFd is left open.
+    std::optional<status_t> lockPersistent(buffer_handle_t handle, uint64_t usage, bool ycbcr,
+                                           int fenceFd, void** outVaddr, android_ycbcr* outYcbcr,
+                                           int32_t* outBytesPerPixel, int32_t* outBytesPerStride)
+            EXCLUDES(mMappingMutex);
+    std::optional<status_t> unlockPersistent(buffer_handle_t handle, int* outFenceFd)
+            EXCLUDES(mMappingMutex);
+    // Unlocks the mapping of the buffer, if it has one.
+    void eraseMappingLocked(buffer_handle_t handle) REQUIRES(mMappingMutex);
+
     std::unique_ptr<const GrallocMapper> mMapper;
 
     Version mMapperVersion;
+
+    mutable std::mutex mMetadataMutex;
+    std::unordered_map<buffer_handle_t, ImmutableMetadata> mMetadataCache
+            GUARDED_BY(mMetadataMutex);
+    std::atomic<uint64_t> mMetadataCacheHits = 0;
+    std::atomic<uint64_t> mMetadataCacheMisses = 0;
+
+    mutable std::mutex mMappingMutex;
+    std::unordered_map<buffer_handle_t, PersistentMapping> mPersistentMappings
+            GUARDED_BY(mMappingMutex);
+    // Lets the locks of the processes without persistent mappings skip mMappingMutex.
+    std::atomic<size_t> mPersistentMappingCount = 0;
 };
 
 // ---------------------------------------------------------------------------
@@ -39,6 +39,10 @@ class Region : public LightFlattenable<Region>
 public:
     static const Region INVALID_REGION;
 
+    // Number of rects a region can hold without allocating. Non-rectangular regions also store
+    // their bounds, so the inline buffer is one rect larger than this.
+    static constexpr size_t kInlineRectCount = 4;
+
                         Region();
                         Region(const Region& rhs);
     explicit            Region(const Rect& rhs);
@@ -181,7 +185,8 @@ private:
     // with an extra Rect as the last element which is set to the
     // bounds of the region. However, if the region is
     // a simple Rect then mStorage contains only that rect.
-    FatVector<Rect> mStorage;
+    // The flattened form is unaffected by the inline capacity.
+    FatVector<Rect, kInlineRectCount + 1> mStorage;
 };
 
 
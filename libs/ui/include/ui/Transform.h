@@ -103,6 +103,12 @@ public:
     vec2 transform(const vec2& v) const;
     vec3 transform(const vec3& v) const;
 
+    // Transform count points or rects at once, dispatching on the type of the transform once
+    // rather than for each of them. The output may alias the input.
+    void transform(const vec2* points, size_t count, vec2* outPoints) const;
+    void transform(const Rect* rects, size_t count, Rect* outRects,
+                   bool roundOutwards = false) const;
+
     // Expands from the internal 3x3 matrix to an equivalent 4x4 matrix
     mat4 asMatrix4() const;
 
@@ -125,6 +131,11 @@ private:
     enum { UNKNOWN_TYPE = 0x80000000 };
 
     uint32_t type() const;
+    // Whether the last row is < 0 , 0 , 1 >.
+    bool isAffine() const;
+    // Sets the type to the one of a transform that only differs from this one by its translation.
+    void updateTranslateType(uint32_t type);
+    Rect transformFloat(const Rect& bounds, bool roundOutwards) const;
     static bool absIsOne(float f);
     static bool isZero(float f);
 
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ui/Rect.h>
+
+namespace android::region_simd {
+
+// Per-rect kernels used by Region. A Rect is four packed int32_t (left, top, right, bottom), so
+// one rect fits a 128-bit lane and the kernels below can process one or more rects per
+// instruction. Every backend must produce results identical to the scalar one.
+struct RectOps {
+    // Adds (dx, dy) to every rect in [rects, rects + count).
+    void (*offset)(Rect* rects, size_t count, int32_t dx, int32_t dy);
+
+    // Returns true if any rect in [rects, rects + count) contains (x, y).
+    bool (*contains)(const Rect* rects, size_t count, int32_t x, int32_t y);
+
+    const char* name;
+};
+
+// The portable reference implementation.
+const RectOps& scalarOps();
+
+// The fastest backend supported by the CPU we're running on. Selected once, on first use, and
+// falls back to scalarOps() when no vector unit is available.
+const RectOps& activeOps();
+
+} // namespace android::region_simd
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <ui/Fence.h>
+#include <unistd.h>
+#include <utils/Timers.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace android::test {
+
+// A fence backed by an eventfd, which becomes readable once the fence is signaled, since sync
+// files cannot be signaled from user space. Counts the queries of its signal time, each of which
+// would be a sync_file_info ioctl for a sync file.
+class EventFence : public Fence {
+public:
+    EventFence() : Fence(base::unique_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))) {}
+    ~EventFence() override = default;
+
+    void signal(nsecs_t signalTime) {
+        mSignalTime = signalTime;
+        const uint64_t value = 1;
+        (void)write(get(), &value, sizeof(value));
+    }
+
+    nsecs_t getSignalTime() const override {
+        mQueryCount++;
+        pollfd fd = {.fd = get(), .events = POLLIN};
+        return poll(&fd, 1, 0) == 1 ? mSignalTime.load() : SIGNAL_TIME_PENDING;
+    }
+
+    uint64_t getQueryCount() const { return mQueryCount; }
+
+private:
+    std::atomic<nsecs_t> mSignalTime = SIGNAL_TIME_PENDING;
+    mutable std::atomic<uint64_t> mQueryCount = 0;
+};
+
+} // namespace android::test
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ui/FenceSignalWatcher.h>
+#include <ui/FenceTime.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "EventFence.h"
+
+namespace android::test {
+namespace {
+
+// Each frame has an acquire, a GPU composition done and a present fence, which stay pending for
+// kPendingFrames frames while kQueriesPerFrame users query them each frame, the way
+// FrameTimeline, TimeStats and the frame timestamps of the producer do.
+constexpr size_t kFencesPerFrame = 3;
+constexpr size_t kPendingFrames = 2;
+constexpr size_t kQueriesPerFrame = 3;
+
+struct InFlightFrame {
+    std::array<sp<EventFence>, kFencesPerFrame> fences;
+    std::array<std::shared_ptr<FenceTime>, kFencesPerFrame> fenceTimes;
+};
+
+// Arg 0 polls the fences from their FenceTimes, arg 1 watches them with a FenceSignalWatcher.
+void BM_FenceTimeQueriesPerFrame(benchmark::State& state) {
+    const bool watch = state.range(0) != 0;
+    FenceSignalWatcher watcher(/*enabled=*/true);
+    std::array<InFlightFrame, kPendingFrames + 1> frames;
+    uint64_t queryCount = 0;
+    int64_t frameCount = 0;
+
+    for (auto _ : state) {
+        InFlightFrame& frame = frames[frameCount % frames.size()];
+        for (size_t i = 0; i < kFencesPerFrame; i++) {
+            frame.fences[i] = sp<EventFence>::make();
+            frame.fenceTimes[i] = std::make_shared<FenceTime>(frame.fences[i]);
+            if (watch) {
+                watcher.watch(frame.fenceTimes[i]);
+            }
+        }
+
+        // The fences of the oldest frame in flight signal.
+        const InFlightFrame& oldest = frames[(frameCount + 1) % frames.size()];
+        if (frameCount >= static_cast<int64_t>(kPendingFrames)) {
+            for (const auto& fence : oldest.fences) {
+                fence->signal(frameCount);
+            }
+            if (watch) {
+                watcher.waitForWatchedFences();
+            }
+        }
+
+        for (size_t query = 0; query < kQueriesPerFrame; query++) {
+            for (const auto& inFlight : frames) {
+                for (const auto& fenceTime : inFlight.fenceTimes) {
+                    if (fenceTime) {
+                        benchmark::DoNotOptimize(fenceTime->getSignalTime());
+                    }
+                }
+            }
+        }
+
+        if (frameCount >= static_cast<int64_t>(kPendingFrames)) {
+            for (const auto& fence : oldest.fences) {
+                queryCount += fence->getQueryCount();
+            }
+        }
+        frameCount++;
+    }
+
+    state.counters["ioctls/frame"] =
+            benchmark::Counter(static_cast<double>(queryCount) /
+                               static_cast<double>(std::max<int64_t>(
+                                       1, frameCount - static_cast<int64_t>(kPendingFrames))));
+}
+BENCHMARK(BM_FenceTimeQueriesPerFrame)->Arg(0)->Arg(1);
+
+} // namespace
+} // namespace android::test
+
+BENCHMARK_MAIN();
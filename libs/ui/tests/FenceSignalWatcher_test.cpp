@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/FenceSignalWatcher.h>
+#include <ui/FenceTime.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "EventFence.h"
+
+namespace android::test {
+
+class FenceSignalWatcherTest : public testing::Test {
+protected:
+    FenceSignalWatcher mWatcher{/*enabled=*/true};
+};
+
+TEST_F(FenceSignalWatcherTest, storesSignalTimeWithoutPolling) {
+    const auto fence = sp<EventFence>::make();
+    const auto fenceTime = std::make_shared<FenceTime>(fence);
+    ASSERT_TRUE(mWatcher.watch(fenceTime));
+    EXPECT_EQ(1u, mWatcher.getWatchedCount());
+
+    // A watched fence is not queried while it is pending.
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTime->getSignalTime());
+    }
+    EXPECT_EQ(0u, fence->getQueryCount());
+
+    fence->signal(1234);
+    mWatcher.waitForWatchedFences();
+    EXPECT_EQ(1234, fenceTime->getCachedSignalTime());
+    EXPECT_EQ(1234, fenceTime->getSignalTime());
+    EXPECT_EQ(1u, fence->getQueryCount());
+    EXPECT_EQ(0u, mWatcher.getWatchedCount());
+}
+
+TEST_F(FenceSignalWatcherTest, doesNotWatchKnownOrInvalidFences) {
+    EXPECT_FALSE(mWatcher.watch(nullptr));
+    EXPECT_FALSE(mWatcher.watch(FenceTime::NO_FENCE));
+    EXPECT_FALSE(mWatcher.watch(std::make_shared<FenceTime>(nsecs_t(5))));
+
+    const auto fenceTime = std::make_shared<FenceTime>(sp<EventFence>::make());
+    ASSERT_TRUE(mWatcher.watch(fenceTime));
+    EXPECT_FALSE(mWatcher.watch(fenceTime));
+    EXPECT_EQ(1u, mWatcher.getWatchedCount());
+}
+
+TEST_F(FenceSignalWatcherTest, disabledWatcherLeavesPollingToFenceTime) {
+    FenceSignalWatcher watcher(/*enabled=*/false);
+    EXPECT_FALSE(watcher.isEnabled());
+
+    const auto fence = sp<EventFence>::make();
+    const auto fenceTime = std::make_shared<FenceTime>(fence);
+    EXPECT_FALSE(watcher.watch(fenceTime));
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTime->getSignalTime());
+    fence->signal(42);
+    EXPECT_EQ(42, fenceTime->getSignalTime());
+    EXPECT_EQ(2u, fence->getQueryCount());
+}
+
+TEST_F(FenceSignalWatcherTest, removesDestroyedFenceTimesWhenFull) {
+    std::vector<std::shared_ptr<FenceTime>> fenceTimes;
+    for (size_t i = 0; i < FenceSignalWatcher::kMaxFences; i++) {
+        fenceTimes.push_back(std::make_shared<FenceTime>(sp<EventFence>::make()));
+        ASSERT_TRUE(mWatcher.watch(fenceTimes.back()));
+    }
+
+    const auto fenceTime = std::make_shared<FenceTime>(sp<EventFence>::make());
+    EXPECT_FALSE(mWatcher.watch(fenceTime));
+
+    fenceTimes.pop_back();
+    EXPECT_TRUE(mWatcher.watch(fenceTime));
+    EXPECT_EQ(FenceSignalWatcher::kMaxFences, mWatcher.getWatchedCount());
+}
+
+} // namespace android::test
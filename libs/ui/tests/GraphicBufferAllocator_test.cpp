@@ -25,6 +25,7 @@
 #include "mock/MockGrallocAllocator.h"
 
 #include <algorithm>
+#include <array>
 #include <limits>
 
 namespace android {
@@ -38,9 +39,11 @@ constexpr uint64_t kTestUsage = GraphicBuffer::USAGE_SW_WRITE_OFTEN;
 
 } // namespace
 
+using ::testing::_;
 using ::testing::DoAll;
 using ::testing::Return;
 using ::testing::SetArgPointee;
+using ::testing::SetArrayArgument;
 
 class TestableGraphicBufferAllocator : public GraphicBufferAllocator {
 public:
@@ -53,6 +56,14 @@ public:
                     allocate)
                 .WillOnce(DoAll(SetArgPointee<7>(stride), Return(err)));
     }
+    void setUpAllocateBatchExpectations(uint32_t stride, const buffer_handle_t* handles,
+                                        uint32_t count) {
+        EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(mAllocator.get())),
+                    allocate(_, _, _, _, _, _, count, _, _, true))
+                .WillOnce(DoAll(SetArgPointee<7>(stride),
+                                SetArrayArgument<8>(handles, handles + count),
+                                Return(NO_ERROR)));
+    }
     std::unique_ptr<const GrallocAllocator>& getAllocator() { return mAllocator; }
 };
 
@@ -113,4 +124,46 @@ TEST_F(GraphicBufferAllocatorTest, AllocateLargeStride) {
     ASSERT_EQ(NO_ERROR, err);
     ASSERT_EQ(expectedStride, stride);
 }
+
+TEST_F(GraphicBufferAllocatorTest, AllocateBatchInOneCall) {
+    static std::array<native_handle_t, 3> sHandles;
+    const std::array<buffer_handle_t, 3> expectedHandles = {&sHandles[0], &sHandles[1],
+                                                            &sHandles[2]};
+    mAllocator.setUpAllocateBatchExpectations(kTestWidth, expectedHandles.data(),
+                                              expectedHandles.size());
+
+    std::array<buffer_handle_t, 3> handles = {};
+    uint32_t stride = 0;
+    status_t err = mAllocator.allocateBatch(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                            kTestLayerCount, kTestUsage, handles.size(),
+                                            handles.data(), &stride, "GraphicBufferAllocatorTest");
+    ASSERT_EQ(NO_ERROR, err);
+    EXPECT_EQ(kTestWidth, stride);
+    EXPECT_EQ(expectedHandles, handles);
+}
+
+TEST_F(GraphicBufferAllocatorTest, AllocateBatchOfNoBuffersFails) {
+    uint32_t stride = 0;
+    EXPECT_EQ(BAD_VALUE,
+              mAllocator.allocateBatch(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                       kTestLayerCount, kTestUsage, 0, nullptr, &stride,
+                                       "GraphicBufferAllocatorTest"));
+}
+
+TEST_F(GraphicBufferAllocatorTest, AllocateBatchAsync) {
+    static std::array<native_handle_t, 2> sHandles;
+    const std::array<buffer_handle_t, 2> expectedHandles = {&sHandles[0], &sHandles[1]};
+    mAllocator.setUpAllocateBatchExpectations(kTestWidth, expectedHandles.data(),
+                                              expectedHandles.size());
+
+    auto future = mAllocator.allocateBatchAsync(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                                kTestLayerCount, kTestUsage,
+                                                expectedHandles.size(),
+                                                "GraphicBufferAllocatorTest");
+    const GraphicBufferAllocator::AllocationBatch batch = future.get();
+    ASSERT_EQ(NO_ERROR, batch.status);
+    EXPECT_EQ(kTestWidth, batch.stride);
+    EXPECT_EQ(std::vector<buffer_handle_t>(expectedHandles.begin(), expectedHandles.end()),
+              batch.handles);
+}
 } // namespace android
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ui/GraphicBuffer.h>
+#include <ui/GraphicBufferMapper.h>
+
+namespace android {
+namespace {
+
+constexpr uint64_t kUsage =
+        GraphicBuffer::USAGE_SW_READ_OFTEN | GraphicBuffer::USAGE_SW_WRITE_OFTEN;
+
+// Locks a YUV buffer of state.range(0) x state.range(1) pixels for reading and unlocks it, the
+// way CPU image analysis consumes camera frames, with the buffer persistently mapped if
+// state.range(2) is set.
+void BM_LockYCbCr(benchmark::State& state) {
+    const auto width = static_cast<uint32_t>(state.range(0));
+    const auto height = static_cast<uint32_t>(state.range(1));
+    const bool persistent = state.range(2) != 0;
+    const sp<GraphicBuffer> buffer =
+            sp<GraphicBuffer>::make(width, height, HAL_PIXEL_FORMAT_YCbCr_420_888, 1, kUsage,
+                                    "BM_LockYCbCr");
+    if (buffer->initCheck() != NO_ERROR) {
+        state.SkipWithError("Could not allocate the buffer");
+        return;
+    }
+    if (persistent &&
+        GraphicBufferMapper::get().enablePersistentMapping(buffer->handle, kUsage,
+                                                           /*ycbcr=*/true) != NO_ERROR) {
+        state.SkipWithError("The mapper does not support persistent mappings");
+        return;
+    }
+
+    for (auto _ : state) {
+        android_ycbcr ycbcr;
+        if (buffer->lockYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN, &ycbcr) != NO_ERROR) {
+            state.SkipWithError("lockYCbCr failed");
+            break;
+        }
+        const uint8_t y = *static_cast<volatile uint8_t*>(ycbcr.y);
+        benchmark::DoNotOptimize(y);
+        buffer->unlock();
+    }
+}
+
+// Locks an RGBA buffer for writing and unlocks it, the way CPU rendering produces frames.
+void BM_LockRgba(benchmark::State& state) {
+    const auto width = static_cast<uint32_t>(state.range(0));
+    const auto height = static_cast<uint32_t>(state.range(1));
+    const bool persistent = state.range(2) != 0;
+    const sp<GraphicBuffer> buffer =
+            sp<GraphicBuffer>::make(width, height, PIXEL_FORMAT_RGBA_8888, 1, kUsage,
+                                    "BM_LockRgba");
+    if (buffer->initCheck() != NO_ERROR) {
+        state.SkipWithError("Could not allocate the buffer");
+        return;
+    }
+    if (persistent &&
+        GraphicBufferMapper::get().enablePersistentMapping(buffer->handle, kUsage,
+                                                           /*ycbcr=*/false) != NO_ERROR) {
+        state.SkipWithError("The mapper does not support persistent mappings");
+        return;
+    }
+
+    for (auto _ : state) {
+        void* data = nullptr;
+        if (buffer->lock(GraphicBuffer::USAGE_SW_WRITE_OFTEN, &data) != NO_ERROR) {
+            state.SkipWithError("lock failed");
+            break;
+        }
+        *static_cast<volatile uint8_t*>(data) = 0;
+        buffer->unlock();
+    }
+}
+
+void sizeArgs(benchmark::internal::Benchmark* b) {
+    for (int persistent = 0; persistent <= 1; persistent++) {
+        b->Args({1920, 1080, persistent});
+        b->Args({3840, 2160, persistent});
+    }
+}
+
+BENCHMARK(BM_LockYCbCr)->Apply(sizeArgs);
+BENCHMARK(BM_LockRgba)->Apply(sizeArgs);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
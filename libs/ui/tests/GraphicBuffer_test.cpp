@@ -17,6 +17,7 @@
 #define LOG_TAG "GraphicBufferTest"
 
 #include <ui/GraphicBuffer.h>
+#include <ui/GraphicBufferMapper.h>
 
 #include <gtest/gtest.h>
 
@@ -66,4 +67,69 @@ TEST_F(GraphicBufferTest, AllocateBadDimensions) {
     ASSERT_EQ(BAD_VALUE, gb2->initCheck());
 }
 
+TEST_F(GraphicBufferTest, MapperCachesImmutableMetadata) {
+    sp<GraphicBuffer> gb(new GraphicBuffer(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                           kTestLayerCount, kTestUsage, std::string("test")));
+    ASSERT_EQ(NO_ERROR, gb->initCheck());
+
+    GraphicBufferMapper& mapper = GraphicBufferMapper::get();
+    uint64_t usage = 0;
+    if (mapper.getUsage(gb->getNativeBuffer()->handle, &usage) != NO_ERROR) {
+        GTEST_SKIP() << "The mapper does not support metadata";
+    }
+    const auto stats = mapper.getMetadataCacheStats();
+
+    uint64_t cachedUsage = 0;
+    ASSERT_EQ(NO_ERROR, mapper.getUsage(gb->getNativeBuffer()->handle, &cachedUsage));
+    EXPECT_EQ(usage, cachedUsage);
+    EXPECT_EQ(stats.hits + 1, mapper.getMetadataCacheStats().hits);
+    EXPECT_EQ(stats.misses, mapper.getMetadataCacheStats().misses);
+
+    // The cached metadata of a buffer is dropped when it is freed.
+    const size_t bufferCount = mapper.getMetadataCacheStats().bufferCount;
+    gb.clear();
+    EXPECT_EQ(bufferCount - 1, mapper.getMetadataCacheStats().bufferCount);
+}
+
+TEST_F(GraphicBufferTest, PersistentMappingKeepsBufferMapped) {
+    sp<GraphicBuffer> gb(new GraphicBuffer(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                           kTestLayerCount,
+                                           kTestUsage | GraphicBuffer::USAGE_SW_READ_OFTEN,
+                                           std::string("test")));
+    ASSERT_EQ(NO_ERROR, gb->initCheck());
+
+    GraphicBufferMapper& mapper = GraphicBufferMapper::get();
+    const buffer_handle_t handle = gb->getNativeBuffer()->handle;
+    if (mapper.enablePersistentMapping(handle,
+                                       GraphicBuffer::USAGE_SW_READ_OFTEN |
+                                               GraphicBuffer::USAGE_SW_WRITE_OFTEN,
+                                       /*ycbcr=*/false) != NO_ERROR) {
+        GTEST_SKIP() << "The mapper does not support persistent mappings";
+    }
+    EXPECT_TRUE(mapper.isPersistentlyMapped(handle));
+
+    uint32_t* data = nullptr;
+    ASSERT_EQ(NO_ERROR,
+              gb->lock(GraphicBuffer::USAGE_SW_WRITE_OFTEN, reinterpret_cast<void**>(&data)));
+    ASSERT_NE(nullptr, data);
+    data[0] = 0xdeadbeef;
+    ASSERT_EQ(NO_ERROR, gb->unlock());
+
+    // The buffer is still mapped at the same address.
+    uint32_t* readData = nullptr;
+    ASSERT_EQ(NO_ERROR,
+              gb->lock(GraphicBuffer::USAGE_SW_READ_OFTEN, reinterpret_cast<void**>(&readData)));
+    EXPECT_EQ(data, readData);
+    EXPECT_EQ(0xdeadbeef, readData[0]);
+    ASSERT_EQ(NO_ERROR, gb->unlock());
+    EXPECT_TRUE(mapper.isPersistentlyMapped(handle));
+
+    // A lock for YCbCr does not match the mapping, which is disabled.
+    android_ycbcr ycbcr;
+    if (gb->lockYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN, &ycbcr) == NO_ERROR) {
+        gb->unlock();
+    }
+    EXPECT_FALSE(mapper.isPersistentlyMapped(handle));
+}
+
 } // namespace android
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/RegionSimd.h>
+
+namespace android {
+namespace {
+
+constexpr int32_t kWidth = 1080;
+constexpr int32_t kHeight = 2400;
+
+// A full-screen region with all four corners rounded to the given radius, built one scanline at
+// a time the way a rasterized corner mask ends up in a Region.
+Region roundedCornerMask(int32_t radius) {
+    Region region(Rect(0, radius, kWidth, kHeight - radius));
+    for (int32_t y = 0; y < radius; y++) {
+        const float dy = static_cast<float>(radius - y) - 0.5f;
+        const auto inset = static_cast<int32_t>(
+                std::ceil(static_cast<float>(radius) -
+                          std::sqrt(static_cast<float>(radius * radius) - dy * dy)));
+        region.orSelf(Rect(inset, y, kWidth - inset, y + 1));
+        region.orSelf(Rect(inset, kHeight - y - 1, kWidth - inset, kHeight - y));
+    }
+    return region;
+}
+
+// The rounded-corner mask with a rounded camera notch cut out of the top edge.
+Region notchMask(int32_t radius) {
+    constexpr int32_t kNotchWidth = 320;
+    constexpr int32_t kNotchHeight = 80;
+    Region region = roundedCornerMask(radius);
+    const int32_t left = (kWidth - kNotchWidth) / 2;
+    for (int32_t y = 0; y < kNotchHeight; y++) {
+        // Taper the bottom of the notch so every scanline is distinct.
+        const int32_t taper = y > kNotchHeight - 20 ? (y - (kNotchHeight - 20)) * 2 : 0;
+        region.subtractSelf(Rect(left + taper, y, left + kNotchWidth - taper, y + 1));
+    }
+    return region;
+}
+
+Region maskFor(int64_t shape) {
+    return shape == 0 ? roundedCornerMask(96) : notchMask(96);
+}
+
+void shapeArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"notch"})->Arg(0)->Arg(1);
+}
+
+void BM_Contains(benchmark::State& state, const region_simd::RectOps& ops) {
+    const Region region = maskFor(state.range(0));
+    size_t count = 0;
+    const Rect* rects = region.getArray(&count);
+    state.counters["rects"] = static_cast<double>(count);
+
+    // Probe along the diagonal so hits land throughout the rect list.
+    int32_t i = 0;
+    for (auto _ : state) {
+        const int32_t y = (i * 7) % kHeight;
+        const int32_t x = (i * 3) % kWidth;
+        benchmark::DoNotOptimize(ops.contains(rects, count, x, y));
+        i++;
+    }
+    state.SetLabel(ops.name);
+}
+
+void BM_Offset(benchmark::State& state, const region_simd::RectOps& ops) {
+    const Region region = maskFor(state.range(0));
+    std::vector<Rect> rects(region.begin(), region.end());
+    state.counters["rects"] = static_cast<double>(rects.size());
+
+    int32_t d = 1;
+    for (auto _ : state) {
+        ops.offset(rects.data(), rects.size(), d, -d);
+        benchmark::ClobberMemory();
+        d = -d;
+    }
+    state.SetLabel(ops.name);
+}
+
+void BM_Contains_Scalar(benchmark::State& state) {
+    BM_Contains(state, region_simd::scalarOps());
+}
+void BM_Contains_Active(benchmark::State& state) {
+    BM_Contains(state, region_simd::activeOps());
+}
+void BM_Offset_Scalar(benchmark::State& state) {
+    BM_Offset(state, region_simd::scalarOps());
+}
+void BM_Offset_Active(benchmark::State& state) {
+    BM_Offset(state, region_simd::activeOps());
+}
+
+// End-to-end Region operations, which pick up the active backend.
+void BM_RegionTranslateSelf(benchmark::State& state) {
+    Region region = maskFor(state.range(0));
+    int32_t d = 1;
+    for (auto _ : state) {
+        region.translateSelf(d, -d);
+        benchmark::ClobberMemory();
+        d = -d;
+    }
+}
+
+void BM_RegionSubtract(benchmark::State& state) {
+    const Region region = maskFor(state.range(0));
+    const Rect occluder(0, kHeight / 3, kWidth, 2 * kHeight / 3);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(occluder));
+    }
+}
+
+BENCHMARK(BM_Contains_Scalar)->Apply(shapeArgs);
+BENCHMARK(BM_Contains_Active)->Apply(shapeArgs);
+BENCHMARK(BM_Offset_Scalar)->Apply(shapeArgs);
+BENCHMARK(BM_Offset_Active)->Apply(shapeArgs);
+BENCHMARK(BM_RegionTranslateSelf)->Apply(shapeArgs);
+BENCHMARK(BM_RegionSubtract)->Apply(shapeArgs);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
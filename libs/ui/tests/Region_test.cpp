@@ -17,8 +17,10 @@
 #define LOG_TAG "RegionTest"
 
 #include <stdlib.h>
+#include <vector>
 #include <ui/Region.h>
 #include <ui/Rect.h>
+#include <ui/RegionSimd.h>
 #include <gtest/gtest.h>
 
 namespace android {
@@ -152,6 +154,103 @@ TEST_F(RegionTest, Random_TJunction) {
     }
 }
 
+TEST_F(RegionTest, ContainsIgnoresBoundsRect) {
+    // An L shape: its bounds cover (15, 15) but the region does not.
+    Region r(Rect(0, 0, 20, 10));
+    r.orSelf(Rect(0, 10, 10, 20));
+
+    EXPECT_TRUE(r.contains(5, 15));
+    EXPECT_TRUE(r.contains(19, 9));
+    EXPECT_FALSE(r.contains(15, 15));
+    EXPECT_FALSE(r.contains(20, 0));
+    EXPECT_FALSE(r.contains(0, 20));
+}
+
+TEST_F(RegionTest, Random_ContainsMatchesScalar) {
+    const auto& ops = region_simd::activeOps();
+    const auto& scalar = region_simd::scalarOps();
+    srandom(12345);
+
+    for (int iter = 0; iter < ITER_MAX; iter++) {
+        Region r;
+        for (int i = 0; i < X_MAX; i++) {
+            for (int j = 0; j < Y_MAX; j++) {
+                if (random() % 2) {
+                    r.orSelf(Rect(i, j, i + 1, j + 1));
+                }
+            }
+        }
+        size_t count = 0;
+        const Rect* rects = r.getArray(&count);
+        for (int x = -1; x <= X_MAX; x++) {
+            for (int y = -1; y <= Y_MAX; y++) {
+                ASSERT_EQ(scalar.contains(rects, count, x, y), r.contains(x, y))
+                        << ops.name << " at (" << x << ", " << y << ")";
+            }
+        }
+    }
+}
+
+TEST_F(RegionTest, Random_TranslateMatchesScalar) {
+    const auto& scalar = region_simd::scalarOps();
+    srandom(12345);
+
+    for (int iter = 0; iter < ITER_MAX; iter++) {
+        Region r;
+        for (int i = 0; i < X_MAX; i++) {
+            for (int j = 0; j < Y_MAX; j++) {
+                if (random() % 2) {
+                    r.orSelf(Rect(i, j, i + 1, j + 1));
+                }
+            }
+        }
+        const int dx = static_cast<int>(random() % 200) - 100;
+        const int dy = static_cast<int>(random() % 200) - 100;
+
+        const Region expected(r);
+        std::vector<Rect> rects(r.begin(), r.end());
+        scalar.offset(rects.data(), rects.size(), dx, dy);
+
+        r.translateSelf(dx, dy);
+        ASSERT_EQ(rects.size(), static_cast<size_t>(r.end() - r.begin()));
+        for (size_t i = 0; i < rects.size(); i++) {
+            ASSERT_EQ(rects[i], r.begin()[i]);
+        }
+        Rect bounds = expected.getBounds();
+        bounds.offsetBy(dx, dy);
+        ASSERT_EQ(bounds, r.getBounds());
+    }
+}
+
+TEST_F(RegionTest, SmallRegionsUseInlineStorage) {
+    auto isInline = [](const Region& r) {
+        const auto* self = reinterpret_cast<const char*>(&r);
+        const auto* rects = reinterpret_cast<const char*>(r.begin());
+        return rects >= self && rects < self + sizeof(Region);
+    };
+
+    // Four disjoint rects plus the bounds rect fit inline.
+    Region r;
+    for (int i = 0; i < static_cast<int>(Region::kInlineRectCount); i++) {
+        r.orSelf(Rect(i * 10, i * 10, i * 10 + 5, i * 10 + 5));
+    }
+    ASSERT_EQ(Region::kInlineRectCount, static_cast<size_t>(r.end() - r.begin()));
+    EXPECT_TRUE(isInline(r));
+
+    const Region copy(r);
+    EXPECT_TRUE(isInline(copy));
+    EXPECT_TRUE(copy.hasSameRects(r));
+
+    Region translated = r.translate(3, 4);
+    EXPECT_TRUE(isInline(translated));
+
+    // One more rect spills to the heap without changing the contents.
+    r.orSelf(Rect(100, 100, 105, 105));
+    EXPECT_EQ(Region::kInlineRectCount + 1, static_cast<size_t>(r.end() - r.begin()));
+    EXPECT_TRUE(r.contains(102, 102));
+    EXPECT_TRUE(r.contains(2, 2));
+}
+
 TEST_F(RegionTest, EqualsToSelf) {
     Region touchableRegion;
     touchableRegion.orSelf(Rect(0, 0, 100, 100));
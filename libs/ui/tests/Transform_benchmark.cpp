@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <ui/FloatRect.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/Transform.h>
+
+namespace android::ui {
+namespace {
+
+constexpr int32_t kWidth = 1080;
+constexpr int32_t kHeight = 2400;
+
+// The transforms of a layer in a rotated display: 0 translates, 1 rotates by 90 degrees and 2
+// scales, which takes the general path.
+Transform transformFor(int64_t kind) {
+    Transform t;
+    switch (kind) {
+        case 0:
+            t.set(12, 34);
+            return t;
+        case 1:
+            return Transform(Transform::ROT_90, kWidth, kHeight);
+        default:
+            t.set(1.5f, 0.0f, 0.0f, 1.5f);
+            return t;
+    }
+}
+
+void kindArgs(benchmark::internal::Benchmark* b) {
+    b->Arg(0)->Arg(1)->Arg(2);
+}
+
+// A scanline-per-row region, e.g. a rounded corner of a touchable region.
+Region roundedRegion() {
+    Region region(Rect(0, 64, kWidth, kHeight - 64));
+    for (int32_t y = 0; y < 64; y++) {
+        region.orSelf(Rect(64 - y, y, kWidth - 64 + y, y + 1));
+    }
+    return region;
+}
+
+void BM_TransformRect(benchmark::State& state) {
+    const Transform t = transformFor(state.range(0));
+    const Rect rect(10, 20, 300, 400);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t.transform(rect));
+    }
+}
+
+void BM_TransformFloatRect(benchmark::State& state) {
+    const Transform t = transformFor(state.range(0));
+    const FloatRect rect(10.5f, 20.0f, 300.0f, 400.25f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t.transform(rect));
+    }
+}
+
+void BM_TransformRects(benchmark::State& state) {
+    const Transform t = transformFor(state.range(0));
+    const std::vector<Rect> rects(256, Rect(10, 20, 300, 400));
+    std::vector<Rect> outRects(rects.size());
+    for (auto _ : state) {
+        t.transform(rects.data(), rects.size(), outRects.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rects.size()));
+}
+
+void BM_TransformPoints(benchmark::State& state) {
+    const Transform t = transformFor(state.range(0));
+    const std::vector<vec2> points(256, vec2(10.5f, 20.25f));
+    std::vector<vec2> outPoints(points.size());
+    for (auto _ : state) {
+        t.transform(points.data(), points.size(), outPoints.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(points.size()));
+}
+
+void BM_TransformRegion(benchmark::State& state) {
+    const Transform t = transformFor(state.range(0));
+    const Region region = roundedRegion();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t.transform(region));
+    }
+}
+
+void BM_Compose(benchmark::State& state) {
+    const Transform t = transformFor(state.range(0));
+    Transform translation;
+    translation.set(5, 7);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t * translation);
+        benchmark::DoNotOptimize(translation * t);
+    }
+}
+
+BENCHMARK(BM_TransformRect)->Apply(kindArgs);
+BENCHMARK(BM_TransformFloatRect)->Apply(kindArgs);
+BENCHMARK(BM_TransformRects)->Apply(kindArgs);
+BENCHMARK(BM_TransformPoints)->Apply(kindArgs);
+BENCHMARK(BM_TransformRegion)->Apply(kindArgs);
+BENCHMARK(BM_Compose)->Apply(kindArgs);
+
+} // namespace
+} // namespace android::ui
+
+BENCHMARK_MAIN();
@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+#include <ui/Region.h>
 #include <ui/Transform.h>
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 namespace android::ui {
 
 TEST(TransformTest, inverseRotation_hasCorrectType) {
@@ -46,4 +49,72 @@ TEST(TransformTest, inverseRotation_hasCorrectType) {
     testRotationFlagsForInverse(Transform::FLIP_V, Transform::FLIP_V, false);
 }
 
+TEST(TransformTest, rotatedIntegerRect_isExact) {
+    // Past 2^24 not every integer can be represented as a float.
+    constexpr int32_t kLarge = (1 << 24) + 1;
+    constexpr int32_t kWidth = 1 << 25;
+    const Transform t(Transform::ROT_90, kWidth, 0);
+    EXPECT_EQ(Rect(kWidth - 1, 1, kWidth, kLarge), t.transform(Rect(1, 0, kLarge, 1)));
+
+    Transform translate;
+    translate.set(1 << 24, 0);
+    EXPECT_EQ(Rect(kLarge, 0, kLarge + 2, 1), translate.transform(Rect(1, 0, 3, 1)));
+}
+
+TEST(TransformTest, composeWithTranslation_matchesMatrixMultiply) {
+    const Transform rotation(Transform::ROT_90, 100, 200);
+    Transform translation;
+    translation.set(3.5f, -7.0f);
+
+    const auto expectComposition = [](const Transform& lhs, const Transform& rhs) {
+        const Transform composed = lhs * rhs;
+        for (size_t col = 0; col < 3; col++) {
+            for (size_t row = 0; row < 3; row++) {
+                const float expected = lhs[0][row] * rhs[col][0] + lhs[1][row] * rhs[col][1] +
+                        lhs[2][row] * rhs[col][2];
+                EXPECT_EQ(expected, composed[col][row]);
+            }
+        }
+    };
+    expectComposition(rotation, translation);
+    EXPECT_EQ(Transform::ROT_90, (rotation * translation).getOrientation());
+    EXPECT_EQ(Transform::ROT_90, (translation * rotation).getOrientation());
+    EXPECT_TRUE((translation * rotation).getType() & Transform::TRANSLATE);
+
+    Transform inverse;
+    inverse.set(-3.5f, 7.0f);
+    EXPECT_EQ(Transform::IDENTITY, (translation * inverse).getType());
+}
+
+TEST(TransformTest, transformBatch_matchesTransformOne) {
+    Transform scale;
+    scale.set(2.0f, 0.5f, 0.25f, 1.5f);
+    const std::vector<Transform> transforms = {Transform(Transform::ROT_270, 50, 30),
+                                               Transform(Transform::FLIP_H, 40, 0), scale};
+    const std::vector<Rect> rects = {Rect(0, 0, 10, 10), Rect(-5, 3, 7, 9), Rect(4, 4)};
+    const std::vector<vec2> points = {vec2(0.0f, 0.0f), vec2(1.5f, -2.25f), vec2(30.0f, 7.0f)};
+
+    for (const Transform& t : transforms) {
+        std::vector<Rect> outRects(rects.size());
+        t.transform(rects.data(), rects.size(), outRects.data(), /*roundOutwards=*/true);
+        std::vector<vec2> outPoints(points.size());
+        t.transform(points.data(), points.size(), outPoints.data());
+        for (size_t i = 0; i < rects.size(); i++) {
+            EXPECT_EQ(t.transform(rects[i], /*roundOutwards=*/true), outRects[i]);
+            EXPECT_EQ(t.transform(points[i]), outPoints[i]);
+        }
+    }
+}
+
+TEST(TransformTest, rotatedRegion_isExact) {
+    Region region(Rect(0, 0, 10, 5));
+    region.orSelf(Rect(20, 10, 30, 20));
+    const Transform t(Transform::ROT_180, 30, 20);
+
+    Region expected(Rect(20, 15, 30, 20));
+    expected.orSelf(Rect(0, 0, 10, 10));
+    EXPECT_TRUE(t.transform(region).subtract(expected).isEmpty());
+    EXPECT_TRUE(expected.subtract(t.transform(region)).isEmpty());
+}
+
 } // namespace android::ui
@@ -15,7 +15,13 @@
  */
 
 #include <cmath>
+#include <cstring>
 #include <vector>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <ultrahdr/gainmapmath.h>
 
 namespace android::ultrahdr {
@@ -614,6 +620,94 @@ Color getYuv420Pixel(jr_uncompressed_ptr image, size_t x, size_t y) {
              (static_cast<float>(v_uint) - 128.0f) / 255.0f }}};
 }
 
+void yuv420RowToRgb601(jr_uncompressed_ptr image, size_t y, float* r, float* g, float* b) {
+  const size_t width = image->width;
+  const size_t pixel_count = width * image->height;
+  const uint8_t* y_row = reinterpret_cast<uint8_t*>(image->data) + y * width;
+  const uint8_t* u_row =
+      reinterpret_cast<uint8_t*>(image->data) + pixel_count + (y / 2) * (width / 2);
+  const uint8_t* v_row =
+      reinterpret_cast<uint8_t*>(image->data) + pixel_count * 5 / 4 + (y / 2) * (width / 2);
+
+  size_t x = 0;
+#if defined(__aarch64__)
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t one = vdupq_n_f32(kMaxPixelFloat);
+  const float32x4_t bias = vdupq_n_f32(128.0f);
+  const float32x4_t scale = vdupq_n_f32(255.0f);
+  for (; x + 8 <= width; x += 8) {
+    const uint16x8_t y_u16 = vmovl_u8(vld1_u8(y_row + x));
+    // Each chroma sample covers two pixels of the row.
+    uint32_t u4, v4;
+    memcpy(&u4, u_row + x / 2, sizeof(u4));
+    memcpy(&v4, v_row + x / 2, sizeof(v4));
+    const uint8x8_t u_u8 = vreinterpret_u8_u32(vdup_n_u32(u4));
+    const uint8x8_t v_u8 = vreinterpret_u8_u32(vdup_n_u32(v4));
+    const uint8x8x2_t u_zip = vzip_u8(u_u8, u_u8);
+    const uint8x8x2_t v_zip = vzip_u8(v_u8, v_u8);
+    const uint16x8_t u_u16 = vmovl_u8(u_zip.val[0]);
+    const uint16x8_t v_u16 = vmovl_u8(v_zip.val[0]);
+    for (int half = 0; half < 2; half++) {
+      const uint32x4_t y_u32 = half ? vmovl_high_u16(y_u16) : vmovl_u16(vget_low_u16(y_u16));
+      const uint32x4_t u_u32 = half ? vmovl_high_u16(u_u16) : vmovl_u16(vget_low_u16(u_u16));
+      const uint32x4_t v_u32 = half ? vmovl_high_u16(v_u16) : vmovl_u16(vget_low_u16(v_u16));
+      const float32x4_t yf = vdivq_f32(vcvtq_f32_u32(y_u32), scale);
+      const float32x4_t uf = vdivq_f32(vsubq_f32(vcvtq_f32_u32(u_u32), bias), scale);
+      const float32x4_t vf = vdivq_f32(vsubq_f32(vcvtq_f32_u32(v_u32), bias), scale);
+      const float32x4_t rf = vaddq_f32(yf, vmulq_n_f32(vf, kP3Cr));
+      const float32x4_t gf =
+          vsubq_f32(vsubq_f32(yf, vmulq_n_f32(uf, kP3GCb)), vmulq_n_f32(vf, kP3GCr));
+      const float32x4_t bf = vaddq_f32(yf, vmulq_n_f32(uf, kP3Cb));
+      vst1q_f32(r + x + half * 4, vminq_f32(vmaxq_f32(rf, zero), one));
+      vst1q_f32(g + x + half * 4, vminq_f32(vmaxq_f32(gf, zero), one));
+      vst1q_f32(b + x + half * 4, vminq_f32(vmaxq_f32(bf, zero), one));
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128 zero = _mm_set1_ps(0.0f);
+  const __m128 one = _mm_set1_ps(kMaxPixelFloat);
+  const __m128 bias = _mm_set1_ps(128.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+  const __m128i zero_i = _mm_setzero_si128();
+  for (; x + 8 <= width; x += 8) {
+    const __m128i y_u16 =
+        _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y_row + x)), zero_i);
+    // Each chroma sample covers two pixels of the row.
+    int32_t u4, v4;
+    memcpy(&u4, u_row + x / 2, sizeof(u4));
+    memcpy(&v4, v_row + x / 2, sizeof(v4));
+    const __m128i u_u8 = _mm_cvtsi32_si128(u4);
+    const __m128i v_u8 = _mm_cvtsi32_si128(v4);
+    const __m128i u_u16 = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u_u8, u_u8), zero_i);
+    const __m128i v_u16 = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v_u8, v_u8), zero_i);
+    for (int half = 0; half < 2; half++) {
+      const __m128i y_u32 = half ? _mm_unpackhi_epi16(y_u16, zero_i)
+                                 : _mm_unpacklo_epi16(y_u16, zero_i);
+      const __m128i u_u32 = half ? _mm_unpackhi_epi16(u_u16, zero_i)
+                                 : _mm_unpacklo_epi16(u_u16, zero_i);
+      const __m128i v_u32 = half ? _mm_unpackhi_epi16(v_u16, zero_i)
+                                 : _mm_unpacklo_epi16(v_u16, zero_i);
+      const __m128 yf = _mm_div_ps(_mm_cvtepi32_ps(y_u32), scale);
+      const __m128 uf = _mm_div_ps(_mm_sub_ps(_mm_cvtepi32_ps(u_u32), bias), scale);
+      const __m128 vf = _mm_div_ps(_mm_sub_ps(_mm_cvtepi32_ps(v_u32), bias), scale);
+      const __m128 rf = _mm_add_ps(yf, _mm_mul_ps(vf, _mm_set1_ps(kP3Cr)));
+      const __m128 gf = _mm_sub_ps(_mm_sub_ps(yf, _mm_mul_ps(uf, _mm_set1_ps(kP3GCb))),
+                                   _mm_mul_ps(vf, _mm_set1_ps(kP3GCr)));
+      const __m128 bf = _mm_add_ps(yf, _mm_mul_ps(uf, _mm_set1_ps(kP3Cb)));
+      _mm_storeu_ps(r + x + half * 4, _mm_min_ps(_mm_max_ps(rf, zero), one));
+      _mm_storeu_ps(g + x + half * 4, _mm_min_ps(_mm_max_ps(gf, zero), one));
+      _mm_storeu_ps(b + x + half * 4, _mm_min_ps(_mm_max_ps(bf, zero), one));
+    }
+  }
+#endif
+  for (; x < width; ++x) {
+    Color rgb = p3YuvToRgb(getYuv420Pixel(image, x, y));
+    r[x] = rgb.r;
+    g[x] = rgb.g;
+    b[x] = rgb.b;
+  }
+}
+
 Color getP010Pixel(jr_uncompressed_ptr image, size_t x, size_t y) {
   size_t luma_stride = image->luma_stride;
   size_t chroma_stride = image->chroma_stride;
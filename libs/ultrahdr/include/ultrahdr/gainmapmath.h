@@ -440,6 +440,13 @@ Color applyGainLUT(Color e, float gain, GainLUT& gainLUT);
  */
 Color getYuv420Pixel(jr_uncompressed_ptr image, size_t x, size_t y);
 
+/*
+ * Converts the row y of a YUV 420 image to gamma RGB with the Rec.601 coefficients, like
+ * p3YuvToRgb(getYuv420Pixel(image, x, y)) for each pixel of the row, into the r, g and b rows of
+ * the width of the image. Converts 8 pixels at a time with NEON or SSE2 when available.
+ */
+void yuv420RowToRgb601(jr_uncompressed_ptr image, size_t y, float* r, float* g, float* b);
+
 /*
  * Helper for sampling from P010 images.
  *
@@ -41,9 +41,12 @@ public:
     /*
      * Decompresses JPEG image to raw image (YUV420planer, grey-scale or RGBA) format. After
      * calling this method, call getDecompressedImage() to get the image.
+     * The image is downscaled by the DCT of libjpeg if downscale, which can be 1, 2, 4 or 8, is
+     * greater than 1. A downscaled YUV420 image is cropped to an even width and height.
      * Returns false if decompressing the image fails.
      */
-    bool decompressImage(const void* image, int length, bool decodeToRGBA = false);
+    bool decompressImage(const void* image, int length, bool decodeToRGBA = false,
+                         int downscale = 1);
     /*
      * Returns the decompressed raw image buffer pointer. This method must be called only after
      * calling decompressImage().
@@ -100,10 +103,12 @@ public:
                                       std::vector<uint8_t>* exifData);
 
 private:
-    bool decode(const void* image, int length, bool decodeToRGBA);
+    bool decode(const void* image, int length, bool decodeToRGBA, int downscale);
     // Returns false if errors occur.
     bool decompress(jpeg_decompress_struct* cinfo, const uint8_t* dest, bool isSingleChannel);
     bool decompressYUV(jpeg_decompress_struct* cinfo, const uint8_t* dest);
+    // Decompresses the scanlines of a downscaled YCbCr image and subsamples their chroma.
+    bool decompressYUVScanlines(jpeg_decompress_struct* cinfo, const uint8_t* dest);
     bool decompressRGBA(jpeg_decompress_struct* cinfo, const uint8_t* dest);
     bool decompressSingleChannel(jpeg_decompress_struct* cinfo, const uint8_t* dest);
     // Process 16 lines of Y and 16 lines of U/V each time.
@@ -21,6 +21,9 @@
 #include "jpegrerrorcode.h"
 #include "ultrahdr.h"
 
+#include <memory>
+#include <mutex>
+
 #ifndef FLT_MAX
 #define FLT_MAX 0x1.fffffep127f
 #endif
@@ -91,8 +94,13 @@ typedef struct jpegr_compressed_struct* jr_compressed_ptr;
 typedef struct jpegr_exif_struct* jr_exif_ptr;
 typedef struct jpegr_info_struct* jr_info_ptr;
 
+class WorkerPool;
+
 class JpegR {
 public:
+    JpegR();
+    ~JpegR();
+
     /*
      * Experimental only
      *
@@ -256,6 +264,12 @@ public:
                        decoder will do nothing about it. If configured not NULL the decoder will
                        write metadata into this structure. the format of metadata is defined in
                        {@code ultrahdr_metadata_struct}.
+     * @param downscale factor by which the image is downscaled, which must be 1, 2, 4 or 8. The
+                        primary image and the gain map are both decoded at the reduced size by the
+                        DCT of libjpeg, and the gain map is applied at that size, which is much
+                        faster than decoding the full image for a thumbnail. The width and height
+                        of the output are rounded down to even numbers, and the decoded gain map
+                        is downscaled as well. The default value is 1.
      * @return NO_ERROR if decoding succeeds, error code if error occurs.
      */
     status_t decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
@@ -264,7 +278,8 @@ public:
                          jr_exif_ptr exif = nullptr,
                          ultrahdr_output_format output_format = ULTRAHDR_OUTPUT_HDR_LINEAR,
                          jr_uncompressed_ptr gain_map = nullptr,
-                         ultrahdr_metadata_ptr metadata = nullptr);
+                         ultrahdr_metadata_ptr metadata = nullptr,
+                         int downscale = 1);
 
     /*
     * Gets Info from JPEGR file without decoding it.
@@ -317,6 +332,8 @@ protected:
      *                      which is SDR. Default value is JPEGR_OUTPUT_HDR_LINEAR.
      * @param max_display_boost the maximum available boost supported by a display
      * @param dest reconstructed HDR image
+     * @param downscale the factor by which both the SDR image and the gain map were downscaled
+     *                  when they were decoded, which rounds their dimensions separately
      * @return NO_ERROR if calculation succeeds, error code if error occurs.
      */
     status_t applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
@@ -324,9 +341,16 @@ protected:
                           ultrahdr_metadata_ptr metadata,
                           ultrahdr_output_format output_format,
                           float max_display_boost,
-                          jr_uncompressed_ptr dest);
+                          jr_uncompressed_ptr dest,
+                          int downscale = 1);
 
 private:
+    /*
+     * Returns the threads which the gain map is generated and applied with, which are started
+     * the first time that they are needed and then kept for the next images.
+     */
+    WorkerPool& getWorkerPool();
+
     /*
      * This method is called in the encoding pipeline. It will encode the gain map.
      *
@@ -446,6 +470,9 @@ private:
                                      ultrahdr_transfer_function hdr_tf,
                                      jr_compressed_ptr dest,
                                      int quality);
+
+    std::once_flag mWorkerPoolOnce;
+    std::unique_ptr<WorkerPool> mWorkerPool;
 };
 
 } // namespace android::ultrahdr
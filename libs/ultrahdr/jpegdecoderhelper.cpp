@@ -98,15 +98,20 @@ JpegDecoderHelper::JpegDecoderHelper() {
 JpegDecoderHelper::~JpegDecoderHelper() {
 }
 
-bool JpegDecoderHelper::decompressImage(const void* image, int length, bool decodeToRGBA) {
+bool JpegDecoderHelper::decompressImage(const void* image, int length, bool decodeToRGBA,
+                                        int downscale) {
     if (image == nullptr || length <= 0) {
         ALOGE("Image size can not be handled: %d", length);
         return false;
     }
+    if (downscale != 1 && downscale != 2 && downscale != 4 && downscale != 8) {
+        ALOGE("Image downscale can not be handled: %d", downscale);
+        return false;
+    }
 
     mResultBuffer.clear();
     mXMPBuffer.clear();
-    if (!decode(image, length, decodeToRGBA)) {
+    if (!decode(image, length, decodeToRGBA, downscale)) {
         return false;
     }
 
@@ -153,7 +158,8 @@ size_t JpegDecoderHelper::getDecompressedImageHeight() {
     return mHeight;
 }
 
-bool JpegDecoderHelper::decode(const void* image, int length, bool decodeToRGBA) {
+bool JpegDecoderHelper::decode(const void* image, int length, bool decodeToRGBA,
+                               int downscale) {
     jpeg_decompress_struct cinfo;
     jpegr_source_mgr mgr(static_cast<const uint8_t*>(image), length);
     jpegrerror_mgr myerr;
@@ -225,6 +231,13 @@ bool JpegDecoderHelper::decode(const void* image, int length, bool decodeToRGBA)
 
     mWidth = cinfo.image_width;
     mHeight = cinfo.image_height;
+    if (downscale > 1) {
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = downscale;
+        jpeg_calc_output_dimensions(&cinfo);
+        mWidth = cinfo.output_width;
+        mHeight = cinfo.output_height;
+    }
 
     if (decodeToRGBA) {
         if (cinfo.jpeg_color_space == JCS_GRAYSCALE) {
@@ -234,7 +247,7 @@ bool JpegDecoderHelper::decode(const void* image, int length, bool decodeToRGBA)
             goto CleanUp;
         }
         // 4 bytes per pixel
-        mResultBuffer.resize(cinfo.image_width * cinfo.image_height * 4);
+        mResultBuffer.resize(mWidth * mHeight * 4);
         cinfo.out_color_space = JCS_EXT_RGBA;
     } else {
         if (cinfo.jpeg_color_space == JCS_YCbCr) {
@@ -248,12 +261,23 @@ bool JpegDecoderHelper::decode(const void* image, int length, bool decodeToRGBA)
                 ALOGE("%s: decoding to YUV only supports 4:2:0 subsampling", __func__);
                 goto CleanUp;
             }
-            mResultBuffer.resize(cinfo.image_width * cinfo.image_height * 3 / 2, 0);
+            if (downscale > 1) {
+                mWidth &= ~size_t(1);
+                mHeight &= ~size_t(1);
+                if (mWidth == 0 || mHeight == 0) {
+                    status = false;
+                    ALOGE("%s: image is too small to be downscaled", __func__);
+                    goto CleanUp;
+                }
+            }
+            mResultBuffer.resize(mWidth * mHeight * 3 / 2, 0);
         } else if (cinfo.jpeg_color_space == JCS_GRAYSCALE) {
-            mResultBuffer.resize(cinfo.image_width * cinfo.image_height, 0);
+            mResultBuffer.resize(mWidth * mHeight, 0);
         }
         cinfo.out_color_space = cinfo.jpeg_color_space;
-        cinfo.raw_data_out = TRUE;
+        // When downscaling, libjpeg scales the chroma planes up with the DCT rather than leaving
+        // them subsampled, so the raw data does not have the 4:2:0 layout.
+        cinfo.raw_data_out = downscale == 1 ? TRUE : FALSE;
     }
 
     cinfo.dct_method = JDCT_IFAST;
@@ -280,6 +304,8 @@ bool JpegDecoderHelper::decompress(jpeg_decompress_struct* cinfo, const uint8_t*
     }
     if (cinfo->out_color_space == JCS_EXT_RGBA)
         return decompressRGBA(cinfo, dest);
+    else if (!cinfo->raw_data_out)
+        return decompressYUVScanlines(cinfo, dest);
     else
         return decompressYUV(cinfo, dest);
 }
@@ -357,15 +383,15 @@ bool JpegDecoderHelper::decompressRGBA(jpeg_decompress_struct* cinfo, const uint
     JSAMPLE* decodeDst = (JSAMPLE*) dest;
     uint32_t lines = 0;
     // TODO: use batches for more effectiveness
-    while (lines < cinfo->image_height) {
+    while (lines < cinfo->output_height) {
         uint32_t ret = jpeg_read_scanlines(cinfo, &decodeDst, 1);
         if (ret == 0) {
             break;
         }
-        decodeDst += cinfo->image_width * 4;
+        decodeDst += cinfo->output_width * 4;
         lines++;
     }
-    return lines == cinfo->image_height;
+    return lines == cinfo->output_height;
 }
 
 bool JpegDecoderHelper::decompressYUV(jpeg_decompress_struct* cinfo, const uint8_t* dest) {
@@ -448,7 +474,62 @@ bool JpegDecoderHelper::decompressYUV(jpeg_decompress_struct* cinfo, const uint8
     return true;
 }
 
+bool JpegDecoderHelper::decompressYUVScanlines(jpeg_decompress_struct* cinfo,
+                                               const uint8_t* dest) {
+    // Two scanlines of YCbCr at a time, one for each row of the subsampled chroma.
+    const size_t row_size = cinfo->output_width * 3;
+    std::unique_ptr<uint8_t[]> rows = std::make_unique<uint8_t[]>(row_size * 2);
+    uint8_t* y_plane = const_cast<uint8_t*>(dest);
+    uint8_t* u_plane = y_plane + mWidth * mHeight;
+    uint8_t* v_plane = u_plane + mWidth * mHeight / 4;
+
+    for (size_t y = 0; y < mHeight; y += 2) {
+        for (size_t i = 0; i < 2; ++i) {
+            JSAMPROW row = rows.get() + i * row_size;
+            if (jpeg_read_scanlines(cinfo, &row, 1) != 1) {
+                ALOGE("Number of processed lines does not equal input lines.");
+                return false;
+            }
+        }
+        const uint8_t* top = rows.get();
+        const uint8_t* bottom = top + row_size;
+        uint8_t* y_top = y_plane + y * mWidth;
+        uint8_t* y_bottom = y_top + mWidth;
+        uint8_t* u_row = u_plane + y / 2 * (mWidth / 2);
+        uint8_t* v_row = v_plane + y / 2 * (mWidth / 2);
+        for (size_t x = 0; x < mWidth; x += 2) {
+            const uint8_t* p = top + x * 3;
+            const uint8_t* q = bottom + x * 3;
+            y_top[x] = p[0];
+            y_top[x + 1] = p[3];
+            y_bottom[x] = q[0];
+            y_bottom[x + 1] = q[3];
+            u_row[x / 2] = (p[1] + p[4] + q[1] + q[4] + 2) / 4;
+            v_row[x / 2] = (p[2] + p[5] + q[2] + q[5] + 2) / 4;
+        }
+    }
+    // An odd last scanline of the downscaled image is cropped.
+    if (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW row = rows.get();
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+    return true;
+}
+
 bool JpegDecoderHelper::decompressSingleChannel(jpeg_decompress_struct* cinfo, const uint8_t* dest) {
+    if (!cinfo->raw_data_out) {
+        // A downscaled image, which has no padding to the size of the blocks.
+        JSAMPROW row = const_cast<uint8_t*>(dest);
+        while (cinfo->output_scanline < cinfo->output_height) {
+            if (jpeg_read_scanlines(cinfo, &row, 1) != 1) {
+                ALOGE("Number of processed lines does not equal input lines.");
+                return false;
+            }
+            row += cinfo->output_width;
+        }
+        return true;
+    }
+
     JSAMPROW y[kCompressBatchSize];
     JSAMPARRAY planes[1] {y};
 
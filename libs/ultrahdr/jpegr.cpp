@@ -36,8 +36,11 @@
 #include <cmath>
 #include <condition_variable>
 #include <deque>
+#include <functional>
+#include <future>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <unistd.h>
 
 using namespace std;
@@ -96,6 +99,112 @@ int GetCPUCoreCount() {
   return cpuCoreCount;
 }
 
+// The threads which the gain maps of a JpegR instance are generated and applied with, so that
+// they are not created again for each image.
+class WorkerPool {
+ public:
+  // Starts one thread less than the threads used for an image, as the calling thread works too.
+  WorkerPool() : mThreads(std::clamp(GetCPUCoreCount(), 1, 4)) {
+    for (int th = 0; th < mThreads - 1; th++) {
+      mWorkers.push_back(std::thread([this]() { work(); }));
+    }
+  }
+
+  ~WorkerPool() {
+    std::unique_lock<std::mutex> lock{mMutex};
+    mStopping = true;
+    lock.unlock();
+    mCv.notify_all();
+    std::for_each(mWorkers.begin(), mWorkers.end(), [](std::thread& t) { t.join(); });
+  }
+
+  // The number of threads, including the calling thread, to split the work of an image between.
+  int threads() const { return mThreads; }
+
+  // Runs the task on a worker, or on the calling thread if there are no workers.
+  std::future<void> async(std::function<void()> task) {
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+    if (mWorkers.empty()) {
+      packagedTask();
+      return future;
+    }
+    std::unique_lock<std::mutex> lock{mMutex};
+    mTasks.push_back(std::move(packagedTask));
+    lock.unlock();
+    mCv.notify_one();
+    return future;
+  }
+
+  // Runs the task on the calling thread and on every worker which is free meanwhile, and waits
+  // for all of them. The task has to share out the work, such as the jobs of a JobQueue, and to
+  // return only once there is none left, so that the workers which are still busy with other
+  // tasks when the calling thread is done are not waited for.
+  void runOnAll(const std::function<void()>& task) {
+    struct Run {
+      std::mutex mutex;
+      std::condition_variable cv;
+      bool done = false;
+      int running = 0;
+    };
+    auto run = std::make_shared<Run>();
+    std::unique_lock<std::mutex> lock{mMutex};
+    for (size_t th = 0; th < mWorkers.size(); th++) {
+      mTasks.emplace_back([run, &task]() {
+        std::unique_lock<std::mutex> runLock{run->mutex};
+        if (run->done) {
+          return;
+        }
+        run->running++;
+        runLock.unlock();
+        task();
+        runLock.lock();
+        run->running--;
+        runLock.unlock();
+        run->cv.notify_all();
+      });
+    }
+    lock.unlock();
+    mCv.notify_all();
+    task();
+    std::unique_lock<std::mutex> runLock{run->mutex};
+    run->done = true;
+    run->cv.wait(runLock, [&run]() { return run->running == 0; });
+  }
+
+ private:
+  void work() {
+    std::unique_lock<std::mutex> lock{mMutex};
+    while (true) {
+      mCv.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+      if (mTasks.empty()) {
+        return;
+      }
+      std::packaged_task<void()> task = std::move(mTasks.front());
+      mTasks.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+
+  const int mThreads;
+  std::vector<std::thread> mWorkers;
+  std::deque<std::packaged_task<void()>> mTasks;
+  bool mStopping = false;
+  std::mutex mMutex;
+  std::condition_variable mCv;
+};
+
+JpegR::JpegR() = default;
+
+JpegR::~JpegR() = default;
+
+WorkerPool& JpegR::getWorkerPool() {
+  std::call_once(mWorkerPoolOnce, [this]() { mWorkerPool = std::make_unique<WorkerPool>(); });
+  return *mWorkerPool;
+}
+
 status_t JpegR::areInputArgumentsValid(jr_uncompressed_ptr uncompressed_p010_image,
                                        jr_uncompressed_ptr uncompressed_yuv_420_image,
                                        ultrahdr_transfer_function hdr_tf,
@@ -247,28 +356,37 @@ status_t JpegR::encodeJPEGR(jr_uncompressed_ptr uncompressed_p010_image,
   std::unique_ptr<uint8_t[]> map_data;
   map_data.reset(reinterpret_cast<uint8_t*>(map.data));
 
+  // The gain map is compressed on a worker while the primary image is compressed here.
   JpegEncoderHelper jpeg_encoder_gainmap;
-  JPEGR_CHECK(compressGainMap(&map, &jpeg_encoder_gainmap));
-  jpegr_compressed_struct compressed_map;
-  compressed_map.maxLength = jpeg_encoder_gainmap.getCompressedImageSize();
-  compressed_map.length = compressed_map.maxLength;
-  compressed_map.data = jpeg_encoder_gainmap.getCompressedImagePtr();
-  compressed_map.colorGamut = ULTRAHDR_COLORGAMUT_UNSPECIFIED;
+  status_t map_status = NO_ERROR;
+  std::future<void> map_compressed = getWorkerPool().async(
+      [&]() { map_status = compressGainMap(&map, &jpeg_encoder_gainmap); });
 
   sp<DataStruct> icc = IccHelper::writeIccProfile(ULTRAHDR_TF_SRGB,
                                                   uncompressed_yuv_420_image.colorGamut);
 
   // Convert to Bt601 YUV encoding for JPEG encode
-  JPEGR_CHECK(convertYuv(&uncompressed_yuv_420_image, uncompressed_yuv_420_image.colorGamut,
-                         ULTRAHDR_COLORGAMUT_P3));
-
   JpegEncoderHelper jpeg_encoder;
-  if (!jpeg_encoder.compressImage(uncompressed_yuv_420_image.data,
+  status_t primary_status = convertYuv(&uncompressed_yuv_420_image,
+                                       uncompressed_yuv_420_image.colorGamut,
+                                       ULTRAHDR_COLORGAMUT_P3);
+  if (primary_status == NO_ERROR &&
+      !jpeg_encoder.compressImage(uncompressed_yuv_420_image.data,
                                   uncompressed_yuv_420_image.width,
                                   uncompressed_yuv_420_image.height, quality,
                                   icc->getData(), icc->getLength())) {
-    return ERROR_JPEGR_ENCODE_ERROR;
+    primary_status = ERROR_JPEGR_ENCODE_ERROR;
   }
+  map_compressed.wait();
+  JPEGR_CHECK(primary_status);
+  JPEGR_CHECK(map_status);
+
+  jpegr_compressed_struct compressed_map;
+  compressed_map.maxLength = jpeg_encoder_gainmap.getCompressedImageSize();
+  compressed_map.length = compressed_map.maxLength;
+  compressed_map.data = jpeg_encoder_gainmap.getCompressedImagePtr();
+  compressed_map.colorGamut = ULTRAHDR_COLORGAMUT_UNSPECIFIED;
+
   jpegr_compressed_struct jpeg;
   jpeg.data = jpeg_encoder.getCompressedImagePtr();
   jpeg.length = jpeg_encoder.getCompressedImageSize();
@@ -306,19 +424,21 @@ status_t JpegR::encodeJPEGR(jr_uncompressed_ptr uncompressed_p010_image,
   ultrahdr_metadata_struct metadata;
   metadata.version = kJpegrVersion;
 
+  // The primary image does not depend on the gain map, so the gain map is generated and
+  // compressed on the workers while the primary image is compressed here.
   jpegr_uncompressed_struct map;
-  JPEGR_CHECK(generateGainMap(
-      uncompressed_yuv_420_image, uncompressed_p010_image, hdr_tf, &metadata, &map));
   std::unique_ptr<uint8_t[]> map_data;
-  map_data.reset(reinterpret_cast<uint8_t*>(map.data));
-
   JpegEncoderHelper jpeg_encoder_gainmap;
-  JPEGR_CHECK(compressGainMap(&map, &jpeg_encoder_gainmap));
-  jpegr_compressed_struct compressed_map;
-  compressed_map.maxLength = jpeg_encoder_gainmap.getCompressedImageSize();
-  compressed_map.length = compressed_map.maxLength;
-  compressed_map.data = jpeg_encoder_gainmap.getCompressedImagePtr();
-  compressed_map.colorGamut = ULTRAHDR_COLORGAMUT_UNSPECIFIED;
+  status_t map_status = NO_ERROR;
+  std::future<void> map_compressed = getWorkerPool().async([&]() {
+    map_status = generateGainMap(
+        uncompressed_yuv_420_image, uncompressed_p010_image, hdr_tf, &metadata, &map);
+    if (map_status != NO_ERROR) {
+      return;
+    }
+    map_data.reset(reinterpret_cast<uint8_t*>(map.data));
+    map_status = compressGainMap(&map, &jpeg_encoder_gainmap);
+  });
 
   sp<DataStruct> icc = IccHelper::writeIccProfile(ULTRAHDR_TF_SRGB,
                                                   uncompressed_yuv_420_image->colorGamut);
@@ -332,16 +452,26 @@ status_t JpegR::encodeJPEGR(jr_uncompressed_ptr uncompressed_p010_image,
   jpegr_uncompressed_struct yuv_420_bt601_image = {
     yuv_420_bt601_data.get(), uncompressed_yuv_420_image->width, uncompressed_yuv_420_image->height,
     uncompressed_yuv_420_image->colorGamut };
-  JPEGR_CHECK(convertYuv(&yuv_420_bt601_image, yuv_420_bt601_image.colorGamut,
-                         ULTRAHDR_COLORGAMUT_P3));
-
   JpegEncoderHelper jpeg_encoder;
-  if (!jpeg_encoder.compressImage(yuv_420_bt601_image.data,
+  status_t primary_status = convertYuv(&yuv_420_bt601_image, yuv_420_bt601_image.colorGamut,
+                                       ULTRAHDR_COLORGAMUT_P3);
+  if (primary_status == NO_ERROR &&
+      !jpeg_encoder.compressImage(yuv_420_bt601_image.data,
                                   yuv_420_bt601_image.width,
                                   yuv_420_bt601_image.height, quality,
                                   icc->getData(), icc->getLength())) {
-    return ERROR_JPEGR_ENCODE_ERROR;
+    primary_status = ERROR_JPEGR_ENCODE_ERROR;
   }
+  map_compressed.wait();
+  JPEGR_CHECK(primary_status);
+  JPEGR_CHECK(map_status);
+
+  jpegr_compressed_struct compressed_map;
+  compressed_map.maxLength = jpeg_encoder_gainmap.getCompressedImageSize();
+  compressed_map.length = compressed_map.maxLength;
+  compressed_map.data = jpeg_encoder_gainmap.getCompressedImagePtr();
+  compressed_map.colorGamut = ULTRAHDR_COLORGAMUT_UNSPECIFIED;
+
   jpegr_compressed_struct jpeg;
   jpeg.data = jpeg_encoder.getCompressedImagePtr();
   jpeg.length = jpeg_encoder.getCompressedImageSize();
@@ -560,7 +690,8 @@ status_t JpegR::decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
                             jr_exif_ptr exif,
                             ultrahdr_output_format output_format,
                             jr_uncompressed_ptr gain_map,
-                            ultrahdr_metadata_ptr metadata) {
+                            ultrahdr_metadata_ptr metadata,
+                            int downscale) {
   if (compressed_jpegr_image == nullptr || compressed_jpegr_image->data == nullptr) {
     ALOGE("received nullptr for compressed jpegr image");
     return ERROR_JPEGR_INVALID_NULL_PTR;
@@ -586,10 +717,15 @@ status_t JpegR::decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
     return ERROR_JPEGR_INVALID_INPUT_TYPE;
   }
 
+  if (downscale != 1 && downscale != 2 && downscale != 4 && downscale != 8) {
+    ALOGE("received bad value for downscale %d", downscale);
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
   if (output_format == ULTRAHDR_OUTPUT_SDR) {
     JpegDecoderHelper jpeg_decoder;
     if (!jpeg_decoder.decompressImage(compressed_jpegr_image->data, compressed_jpegr_image->length,
-                                      true)) {
+                                      true, downscale)) {
         return ERROR_JPEGR_DECODE_ERROR;
     }
     jpegr_uncompressed_struct uncompressed_rgba_image;
@@ -624,7 +760,8 @@ status_t JpegR::decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
   JPEGR_CHECK(extractGainMap(compressed_jpegr_image, &compressed_map));
 
   JpegDecoderHelper gain_map_decoder;
-  if (!gain_map_decoder.decompressImage(compressed_map.data, compressed_map.length)) {
+  if (!gain_map_decoder.decompressImage(compressed_map.data, compressed_map.length,
+                                        /* decodeToRGBA */ false, downscale)) {
     return ERROR_JPEGR_DECODE_ERROR;
   }
   if ((gain_map_decoder.getDecompressedImageWidth() *
@@ -663,7 +800,8 @@ status_t JpegR::decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
   }
 
   JpegDecoderHelper jpeg_decoder;
-  if (!jpeg_decoder.decompressImage(compressed_jpegr_image->data, compressed_jpegr_image->length)) {
+  if (!jpeg_decoder.decompressImage(compressed_jpegr_image->data, compressed_jpegr_image->length,
+                                    /* decodeToRGBA */ false, downscale)) {
     return ERROR_JPEGR_DECODE_ERROR;
   }
   if ((jpeg_decoder.getDecompressedImageWidth() *
@@ -696,7 +834,7 @@ status_t JpegR::decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
       jpeg_decoder.getICCPtr(), jpeg_decoder.getICCSize());
 
   JPEGR_CHECK(applyGainMap(&uncompressed_yuv_420_image, &map, &uhdr_metadata, output_format,
-                           max_display_boost, dest));
+                           max_display_boost, dest, downscale));
   return NO_ERROR;
 }
 
@@ -896,9 +1034,8 @@ status_t JpegR::generateGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
       return ERROR_JPEGR_INVALID_COLORGAMUT;
   }
 
-  std::mutex mutex;
-  const int threads = std::clamp(GetCPUCoreCount(), 1, 4);
-  size_t rowStep = threads == 1 ? image_height : kJobSzInRows;
+  WorkerPool& workerPool = getWorkerPool();
+  const int threads = workerPool.threads();
   JobQueue jobQueue;
 
   std::function<void()> generateMap = [uncompressed_yuv_420_image, uncompressed_p010_image,
@@ -937,20 +1074,14 @@ status_t JpegR::generateGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
   };
 
   // generate map
-  std::vector<std::thread> workers;
-  for (int th = 0; th < threads - 1; th++) {
-    workers.push_back(std::thread(generateMap));
-  }
-
-  rowStep = (threads == 1 ? image_height : kJobSzInRows) / kMapDimensionScaleFactor;
+  const size_t rowStep = (threads == 1 ? image_height : kJobSzInRows) / kMapDimensionScaleFactor;
   for (size_t rowStart = 0; rowStart < map_height;) {
     size_t rowEnd = std::min(rowStart + rowStep, map_height);
     jobQueue.enqueueJob(rowStart, rowEnd);
     rowStart = rowEnd;
   }
   jobQueue.markQueueForEnd();
-  generateMap();
-  std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+  workerPool.runOnAll(generateMap);
 
   map_data.release();
   return NO_ERROR;
@@ -961,7 +1092,8 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
                              ultrahdr_metadata_ptr metadata,
                              ultrahdr_output_format output_format,
                              float max_display_boost,
-                             jr_uncompressed_ptr dest) {
+                             jr_uncompressed_ptr dest,
+                             int downscale) {
   if (uncompressed_yuv_420_image == nullptr
    || uncompressed_gain_map == nullptr
    || metadata == nullptr
@@ -997,8 +1129,11 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
   map_width = static_cast<size_t>(
           floor((map_width + kJpegBlock - 1) / kJpegBlock)) * kJpegBlock;
   map_height = ((map_height + 1) >> 1) << 1;
-  if (map_width != uncompressed_gain_map->width
-   || map_height != uncompressed_gain_map->height) {
+  // The sampling of the gain map clamps to its edges, so the dimensions of a downscaled gain map
+  // only need to be about a quarter of the ones of the image.
+  if (downscale == 1
+   && (map_width != uncompressed_gain_map->width
+    || map_height != uncompressed_gain_map->height)) {
     ALOGE("gain map dimensions and primary image dimensions are not to scale");
     return ERROR_JPEGR_INVALID_INPUT_TYPE;
   }
@@ -1016,13 +1151,15 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
     size_t width = uncompressed_yuv_420_image->width;
     size_t height = uncompressed_yuv_420_image->height;
 
+    std::vector<float> row_r(width), row_g(width), row_b(width);
     size_t rowStart, rowEnd;
     while (jobQueue.dequeueJob(rowStart, rowEnd)) {
       for (size_t y = rowStart; y < rowEnd; ++y) {
+        // Assuming the sdr image is a decoded JPEG, we should always use Rec.601 YUV coefficients
+        yuv420RowToRgb601(uncompressed_yuv_420_image, y, row_r.data(), row_g.data(),
+                          row_b.data());
         for (size_t x = 0; x < width; ++x) {
-          Color yuv_gamma_sdr = getYuv420Pixel(uncompressed_yuv_420_image, x, y);
-          // Assuming the sdr image is a decoded JPEG, we should always use Rec.601 YUV coefficients
-          Color rgb_gamma_sdr = p3YuvToRgb(yuv_gamma_sdr);
+          Color rgb_gamma_sdr = {{{ row_r[x], row_g[x], row_b[x] }}};
           // We are assuming the SDR base image is always sRGB transfer.
 #if USE_SRGB_INVOETF_LUT
           Color rgb_sdr = srgbInvOetfLUT(rgb_gamma_sdr);
@@ -1089,11 +1226,7 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
     }
   };
 
-  const int threads = std::clamp(GetCPUCoreCount(), 1, 4);
-  std::vector<std::thread> workers;
-  for (int th = 0; th < threads - 1; th++) {
-    workers.push_back(std::thread(applyRecMap));
-  }
+  const int threads = getWorkerPool().threads();
   const int rowStep = threads == 1 ? uncompressed_yuv_420_image->height : kJobSzInRows;
   for (int rowStart = 0; rowStart < uncompressed_yuv_420_image->height;) {
     int rowEnd = std::min(rowStart + rowStep, uncompressed_yuv_420_image->height);
@@ -1101,8 +1234,7 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
     rowStart = rowEnd;
   }
   jobQueue.markQueueForEnd();
-  applyRecMap();
-  std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+  getWorkerPool().runOnAll(applyRecMap);
   return NO_ERROR;
 }
 
@@ -15,6 +15,7 @@
  */
 
 #include <cmath>
+#include <vector>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <ultrahdr/gainmapmath.h>
@@ -1053,6 +1054,24 @@ TEST_F(GainMapMathTest, GetYuv420Pixel) {
   }
 }
 
+TEST_F(GainMapMathTest, Yuv420RowToRgb601) {
+  // Wide enough for the vectorized conversion and the remaining pixels.
+  const size_t width = 20, height = 4;
+  std::vector<uint8_t> pixels(width * height * 3 / 2);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = static_cast<uint8_t>(i * 37);
+  }
+  jpegr_uncompressed_struct image{pixels.data(), width, height, ULTRAHDR_COLORGAMUT_P3};
+
+  std::vector<float> r(width), g(width), b(width);
+  for (size_t y = 0; y < height; ++y) {
+    yuv420RowToRgb601(&image, y, r.data(), g.data(), b.data());
+    for (size_t x = 0; x < width; ++x) {
+      EXPECT_RGB_NEAR((Color{{{r[x], g[x], b[x]}}}), p3YuvToRgb(getYuv420Pixel(&image, x, y)));
+    }
+  }
+}
+
 TEST_F(GainMapMathTest, GetP010Pixel) {
   jpegr_uncompressed_struct image = P010Image();
   Color (*colors)[4] = P010Colors();
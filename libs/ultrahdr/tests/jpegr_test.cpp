@@ -904,6 +904,11 @@ TEST_F(JpegRTest, decodeAPIForInvalidArgs) {
         static_cast<ultrahdr_output_format>(ULTRAHDR_OUTPUT_MAX + 1)))
         << "fail, API allows invalid output format";
 
+  // test downscale
+  EXPECT_NE(OK, jpegRCodec.decodeJPEGR(
+        &jpegR, &mRawP010Image, FLT_MAX, nullptr, ULTRAHDR_OUTPUT_HDR_LINEAR, nullptr, nullptr,
+        3)) << "fail, API allows invalid downscale";
+
   free(jpegR.data);
 }
 
@@ -1069,6 +1074,52 @@ TEST_F(JpegRTest, encodeFromP010ThenDecode) {
   free(decodedJpegR.data);
 }
 
+/* Test Encode API-0 and decode downscaled */
+TEST_F(JpegRTest, encodeFromP010ThenDecodeDownscaled) {
+  int ret;
+
+  // Load input files.
+  if (!loadFile(RAW_P010_IMAGE, mRawP010Image.data, nullptr)) {
+    FAIL() << "Load file " << RAW_P010_IMAGE << " failed";
+  }
+  mRawP010Image.width = TEST_IMAGE_WIDTH;
+  mRawP010Image.height = TEST_IMAGE_HEIGHT;
+  mRawP010Image.colorGamut = ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100;
+
+  JpegR jpegRCodec;
+
+  jpegr_compressed_struct jpegR;
+  jpegR.maxLength = TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * sizeof(uint8_t);
+  jpegR.data = malloc(jpegR.maxLength);
+  ret = jpegRCodec.encodeJPEGR(
+      &mRawP010Image, ultrahdr_transfer_function::ULTRAHDR_TF_HLG, &jpegR, DEFAULT_JPEG_QUALITY,
+      nullptr);
+  if (ret != OK) {
+    FAIL() << "Error code is " << ret;
+  }
+
+  jpegr_uncompressed_struct decodedJpegR;
+  int decodedJpegRSize = TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * 8;
+  decodedJpegR.data = malloc(decodedJpegRSize);
+  for (int downscale : {1, 2, 4, 8}) {
+    Timer decodeTime;
+    timerStart(&decodeTime);
+    ret = jpegRCodec.decodeJPEGR(&jpegR, &decodedJpegR, FLT_MAX, nullptr,
+                                 ULTRAHDR_OUTPUT_HDR_LINEAR, nullptr, nullptr, downscale);
+    timerStop(&decodeTime);
+    if (ret != OK) {
+      FAIL() << "Error code is " << ret << " for downscale " << downscale;
+    }
+    EXPECT_EQ(decodedJpegR.width, (TEST_IMAGE_WIDTH + downscale - 1) / downscale & ~1);
+    EXPECT_EQ(decodedJpegR.height, (TEST_IMAGE_HEIGHT + downscale - 1) / downscale & ~1);
+    ALOGE("Decode JPEG/R:- Res = %i x %i, downscale = %i, time = %f ms", decodedJpegR.width,
+          decodedJpegR.height, downscale, elapsedTime(&decodeTime) / 1000.f);
+  }
+
+  free(jpegR.data);
+  free(decodedJpegR.data);
+}
+
 /* Test Encode API-0 (with stride) and decode */
 TEST_F(JpegRTest, encodeFromP010WithStrideThenDecode) {
   int ret;
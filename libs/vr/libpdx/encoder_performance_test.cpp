@@ -3,14 +3,18 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <array>
 #include <chrono>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <vector>
 
 #include <pdx/rpc/argument_encoder.h>
 #include <pdx/rpc/message_buffer.h>
 #include <pdx/rpc/payload.h>
+#include <pdx/rpc/serializable.h>
 #include <pdx/utility.h>
 
 using namespace android::pdx::rpc;
@@ -26,6 +30,23 @@ namespace {
 
 constexpr size_t kMaxStaticBufferSize = 20480;
 
+// A pose sample, whose members all have fixed-size encodings.
+struct PoseSample {
+  std::array<float, 3> position;
+  std::array<float, 4> orientation;
+  double timestamp;
+  bool valid;
+
+  bool operator==(const PoseSample& other) const {
+    return position == other.position && orientation == other.orientation &&
+           timestamp == other.timestamp && valid == other.valid;
+  }
+  bool operator!=(const PoseSample& other) const { return !(*this == other); }
+
+ private:
+  PDX_SERIALIZABLE_MEMBERS(PoseSample, position, orientation, timestamp, valid);
+};
+
 // Provide numpunct facet that formats numbers with ',' as thousands separators.
 class CommaNumPunct : public std::numpunct<char> {
  protected:
@@ -447,6 +468,21 @@ int main(int /*argc*/, char** /*argv*/) {
                         std::move(int_vector));
   }
 
+  for (size_t len : {0, 1, 8, 64, 256}) {
+    std::vector<float> float_vector(len);
+    std::iota(float_vector.begin(), float_vector.end(), 0.5f);
+    test_runner.AddTest(GenerateContainerName("vector<float>", len),
+                        std::move(float_vector));
+  }
+
+  const PoseSample pose{{1, 2, 3}, {0, 0, 0, 1}, 0.5, true};
+  test_runner.AddTest("PoseSample", pose);
+  for (size_t len : {1, 8, 64}) {
+    std::vector<PoseSample> samples(len, pose);
+    test_runner.AddTest(GenerateContainerName("vector<PoseSample>", len),
+                        std::move(samples));
+  }
+
   std::vector<std::string> vector_of_strings = {
       "012345678901234567890123456789", "012345678901234567890123456789",
       "012345678901234567890123456789", "012345678901234567890123456789",
@@ -34,6 +34,8 @@ template <typename Type, typename Class, Type Class::*Pointer>
 struct MemberPointer<Type Class::*, Pointer> {
   // Type of the member pointer this type represents.
   using PointerType = Type Class::*;
+  // Type of the member.
+  using ValueType = Type;
 
   // Resolves a pointer to member with the given instance, yielding a
   // reference to the member in that instance.
@@ -59,6 +61,12 @@ struct SerializableMembersType {
   // Accessor for individual member pointer types.
   template <std::size_t Index>
   using At = typename std::tuple_element<Index, Members>::type;
+
+  // Serialized size of the described members, if they all have fixed-size
+  // encodings, and 0 otherwise.
+  static constexpr std::size_t GetFixedSerializedSize() {
+    return GetFixedArraySize<typename MemberPointers::ValueType...>();
+  }
 };
 
 // Classes must do the following to correctly define a serializable type:
@@ -90,12 +98,21 @@ struct SerializableMembersType {
 template <typename T>
 class SerializableTraits {
  public:
-  // Gets the serialized size of type T.
+  // Gets the serialized size of type T, without visiting the members if they
+  // all have fixed-size encodings.
   static std::size_t GetSerializedSize(const T& value) {
+    if (GetFixedSerializedSize() != 0)
+      return GetFixedSerializedSize();
     return GetEncodingSize(EncodeArrayType(SerializableMembers::MemberCount)) +
            GetMembersSize<SerializableMembers>(value);
   }
 
+  // Gets the serialized size of every value of type T, or 0 if it depends on
+  // the values of the members.
+  static constexpr std::size_t GetFixedSerializedSize() {
+    return SerializableMembers::GetFixedSerializedSize();
+  }
+
   // Serializes type T.
   static void SerializeObject(const T& value, MessageWriter* writer,
                               void*& buffer) {
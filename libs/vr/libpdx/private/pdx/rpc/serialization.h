@@ -1,6 +1,8 @@
 #ifndef ANDROID_PDX_RPC_SERIALIZATION_H_
 #define ANDROID_PDX_RPC_SERIALIZATION_H_
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
@@ -195,6 +197,81 @@ class ErrorType {
   };
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Fixed Size Encodings //
+///////////////////////////////////////////////////////////////////////////////
+
+// FixedSerializedSize<T>::value is the serialized size of every value of type
+// T, for types whose encoding does not depend on the value, and 0 otherwise.
+// Integers are encoded in the smallest format that fits the value, so only
+// bool, floating point types and aggregates of those have fixed-size encodings.
+// Containers of these types are sized without visiting their elements.
+template <typename T, typename Enabled = void>
+struct FixedSerializedSize : std::integral_constant<std::size_t, 0> {};
+
+template <>
+struct FixedSerializedSize<bool>
+    : std::integral_constant<std::size_t,
+                             GetEncodingSize(ENCODING_TYPE_TRUE)> {};
+template <>
+struct FixedSerializedSize<float>
+    : std::integral_constant<std::size_t,
+                             GetEncodingSize(ENCODING_TYPE_FLOAT32)> {};
+template <>
+struct FixedSerializedSize<double>
+    : std::integral_constant<std::size_t,
+                             GetEncodingSize(ENCODING_TYPE_FLOAT64)> {};
+
+// Gets the size of the array encoding of values of the given types, or 0 if
+// any of the types does not have a fixed-size encoding.
+template <typename... T>
+inline constexpr std::size_t GetFixedArraySize() {
+  const std::array<std::size_t, sizeof...(T)> element_sizes{
+      {FixedSerializedSize<T>::value...}};
+  std::size_t size = GetEncodingSize(EncodeArrayType(sizeof...(T)));
+  for (const std::size_t element_size : element_sizes) {
+    if (element_size == 0)
+      return 0;
+    size += element_size;
+  }
+  return size;
+}
+
+template <typename T, std::size_t Size>
+struct FixedSerializedSize<std::array<T, Size>>
+    : std::integral_constant<
+          std::size_t, Size != 0 && FixedSerializedSize<T>::value == 0
+                           ? 0
+                           : GetEncodingSize(EncodeArrayType(Size)) +
+                                 Size * FixedSerializedSize<T>::value> {};
+template <typename T, typename U>
+struct FixedSerializedSize<std::pair<T, U>>
+    : std::integral_constant<std::size_t, GetFixedArraySize<T, U>()> {};
+template <typename... T>
+struct FixedSerializedSize<std::tuple<T...>>
+    : std::integral_constant<std::size_t, GetFixedArraySize<T...>()> {};
+template <typename T>
+struct FixedSerializedSize<T, EnableIfHasSerializableMembers<T>>
+    : std::integral_constant<std::size_t,
+                             SerializableTraits<T>::GetFixedSerializedSize()> {
+};
+
+// Arrays of float and double are serialized and deserialized in bulk: each
+// element is a type byte followed by the native representation of the value.
+template <typename T>
+struct IsBulkArrayElement
+    : std::integral_constant<bool, std::is_same<T, float>::value ||
+                                       std::is_same<T, double>::value> {};
+
+template <typename ArrayType, typename ReturnType = void>
+using EnableIfBulkArray = typename std::enable_if<
+    IsBulkArrayElement<typename ArrayType::value_type>::value,
+    ReturnType>::type;
+template <typename ArrayType, typename ReturnType = void>
+using EnableIfNotBulkArray = typename std::enable_if<
+    !IsBulkArrayElement<typename ArrayType::value_type>::value,
+    ReturnType>::type;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Object Size //
 ///////////////////////////////////////////////////////////////////////////////
@@ -346,6 +423,10 @@ inline constexpr std::size_t GetSerializedSize(
 // Overload for standard vector types.
 template <typename T, typename Allocator>
 inline std::size_t GetSerializedSize(const std::vector<T, Allocator>& v) {
+  if (FixedSerializedSize<T>::value != 0) {
+    return GetEncodingSize(EncodeType(v)) +
+           v.size() * FixedSerializedSize<T>::value;
+  }
   return std::accumulate(v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
                          [](const std::size_t& sum, const T& object) {
                            return sum + GetSerializedSize(object);
@@ -380,6 +461,10 @@ inline std::size_t GetSerializedSize(
 // Overload for ArrayWrapper types.
 template <typename T>
 inline std::size_t GetSerializedSize(const ArrayWrapper<T>& v) {
+  if (FixedSerializedSize<T>::value != 0) {
+    return GetEncodingSize(EncodeType(v)) +
+           v.size() * FixedSerializedSize<T>::value;
+  }
   return std::accumulate(v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
                          [](const std::size_t& sum, const T& object) {
                            return sum + GetSerializedSize(object);
@@ -389,6 +474,10 @@ inline std::size_t GetSerializedSize(const ArrayWrapper<T>& v) {
 // Overload for std::array types.
 template <typename T, std::size_t Size>
 inline std::size_t GetSerializedSize(const std::array<T, Size>& v) {
+  if (FixedSerializedSize<T>::value != 0) {
+    return GetEncodingSize(EncodeType(v)) +
+           v.size() * FixedSerializedSize<T>::value;
+  }
   return std::accumulate(v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
                          [](const std::size_t& sum, const T& object) {
                            return sum + GetSerializedSize(object);
@@ -398,6 +487,8 @@ inline std::size_t GetSerializedSize(const std::array<T, Size>& v) {
 // Overload for std::pair.
 template <typename T, typename U>
 inline std::size_t GetSerializedSize(const std::pair<T, U>& p) {
+  if (FixedSerializedSize<std::pair<T, U>>::value != 0)
+    return FixedSerializedSize<std::pair<T, U>>::value;
   return GetEncodingSize(EncodeType(p)) + GetSerializedSize(p.first) +
          GetSerializedSize(p.second);
 }
@@ -419,6 +510,8 @@ inline std::size_t GetTupleSize(const std::tuple<T...>& tuple, Index<index>) {
 // through the elements.
 template <typename... T>
 inline std::size_t GetSerializedSize(const std::tuple<T...>& tuple) {
+  if (FixedSerializedSize<std::tuple<T...>>::value != 0)
+    return FixedSerializedSize<std::tuple<T...>>::value;
   return GetEncodingSize(EncodeType(tuple)) +
          GetTupleSize(tuple, Index<sizeof...(T)>());
 }
@@ -961,13 +1054,36 @@ inline void SerializeObject(const StringWrapper<T>& s,
   SerializeString(s, buffer);
 }
 
+// Serializes the elements of array types.
+template <typename ArrayType>
+inline EnableIfNotBulkArray<ArrayType> SerializeArrayElements(
+    const ArrayType& v, MessageWriter* writer, void*& buffer) {
+  for (const auto& element : v)
+    SerializeObject(element, writer, buffer);
+}
+
+// Serializes the elements of float and double arrays in one pass, as they all
+// have the same encoding.
+template <typename ArrayType>
+inline EnableIfBulkArray<ArrayType> SerializeArrayElements(
+    const ArrayType& v, MessageWriter* /*writer*/, void*& buffer) {
+  using T = typename ArrayType::value_type;
+  constexpr EncodingType encoding = EncodeType(T{});
+  std::uint8_t* data = static_cast<std::uint8_t*>(buffer);
+  for (const T& element : v) {
+    *data = encoding;
+    memcpy(data + sizeof(encoding), &element, sizeof(T));
+    data += sizeof(encoding) + sizeof(T);
+  }
+  buffer = data;
+}
+
 // Serializes the payload of array types.
 template <typename ArrayType>
 inline void SerializeArray(const ArrayType& v, MessageWriter* writer,
                            void*& buffer) {
   SerializeType(v, buffer);
-  for (const auto& element : v)
-    SerializeObject(element, writer, buffer);
+  SerializeArrayElements(v, writer, buffer);
 }
 
 // Serializes the payload for map types.
@@ -1712,6 +1828,46 @@ inline ErrorType DeserializeMapType(EncodingType* encoding, std::size_t* size,
   }
 }
 
+// Deserializes the elements of array types, which are already sized.
+template <typename ArrayType>
+inline EnableIfNotBulkArray<ArrayType, ErrorType> DeserializeArrayElements(
+    ArrayType* value, std::size_t size, MessageReader* reader,
+    const void*& start, const void*& end) {
+  for (std::size_t i = 0; i < size; i++) {
+    if (const auto error = DeserializeObject(&(*value)[i], reader, start, end))
+      return error;
+  }
+  return ErrorCode::NO_ERROR;
+}
+
+// Deserializes the elements of float and double arrays. The leading elements
+// that have the encoding of the element type are read with a single bounds
+// check. The others, such as floats in an array of doubles, and any encoding
+// or size errors are left to the per-element path.
+template <typename ArrayType>
+inline EnableIfBulkArray<ArrayType, ErrorType> DeserializeArrayElements(
+    ArrayType* value, std::size_t size, MessageReader* reader,
+    const void*& start, const void*& end) {
+  using T = typename ArrayType::value_type;
+  constexpr EncodingType encoding = EncodeType(T{});
+  constexpr std::size_t element_size = sizeof(encoding) + sizeof(T);
+  const std::size_t available =
+      std::min(size, static_cast<std::size_t>(PointerDistance(end, start)) /
+                         element_size);
+
+  const std::uint8_t* data = static_cast<const std::uint8_t*>(start);
+  std::size_t i = 0;
+  for (; i < available && *data == encoding; i++, data += element_size)
+    memcpy(&(*value)[i], data + sizeof(encoding), sizeof(T));
+  start = data;
+
+  for (; i < size; i++) {
+    if (const auto error = DeserializeObject(&(*value)[i], reader, start, end))
+      return error;
+  }
+  return ErrorCode::NO_ERROR;
+}
+
 // Overload for std::vector types.
 template <typename T, typename Allocator>
 inline ErrorType DeserializeObject(std::vector<T, Allocator>* value,
@@ -1725,10 +1881,9 @@ inline ErrorType DeserializeObject(std::vector<T, Allocator>* value,
     return error;
 
   std::vector<T, Allocator> result(size);
-  for (std::size_t i = 0; i < size; i++) {
-    if (const auto error = DeserializeObject(&result[i], reader, start, end))
-      return error;
-  }
+  if (const auto error =
+          DeserializeArrayElements(&result, size, reader, start, end))
+    return error;
 
   *value = std::move(result);
   return ErrorCode::NO_ERROR;
@@ -1857,12 +2012,7 @@ inline ErrorType DeserializeObject(ArrayWrapper<T>* value,
   if (size > value->capacity())
     return ErrorCode::INSUFFICIENT_DESTINATION_SIZE;
 
-  for (std::size_t i = 0; i < size; i++) {
-    if (const auto error = DeserializeObject(&(*value)[i], reader, start, end))
-      return error;
-  }
-
-  return ErrorCode::NO_ERROR;
+  return DeserializeArrayElements(value, size, reader, start, end);
 }
 
 // Overload for std::array types.
@@ -1881,12 +2031,7 @@ inline ErrorType DeserializeObject(std::array<T, Size>* value,
   if (size != Size)
     return ErrorCode::INSUFFICIENT_DESTINATION_SIZE;
 
-  for (std::size_t i = 0; i < size; i++) {
-    if (const auto error = DeserializeObject(&(*value)[i], reader, start, end))
-      return error;
-  }
-
-  return ErrorCode::NO_ERROR;
+  return DeserializeArrayElements(value, size, reader, start, end);
 }
 
 // Deserializes std::pair types.
@@ -65,6 +65,20 @@ struct TestType {
   PDX_SERIALIZABLE_MEMBERS(TestType, a, b, c, d);
 };
 
+// Type whose members all have fixed-size encodings.
+struct TestFixedType {
+  float a;
+  std::array<double, 2> b;
+  bool c;
+
+  bool operator==(const TestFixedType& other) const {
+    return a == other.a && b == other.b && c == other.c;
+  }
+
+ private:
+  PDX_SERIALIZABLE_MEMBERS(TestFixedType, a, b, c);
+};
+
 template <typename FileHandleType>
 struct TestTemplateType {
   FileHandleType fd;
@@ -1233,6 +1247,32 @@ TEST(SerializationTest, Serializable) {
   EXPECT_EQ(expected, result);
 }
 
+TEST(SerializationTest, FixedSerializedSize) {
+  static_assert(FixedSerializedSize<bool>::value == 1, "");
+  static_assert(FixedSerializedSize<float>::value == 5, "");
+  static_assert(FixedSerializedSize<double>::value == 9, "");
+  static_assert(FixedSerializedSize<std::array<float, 3>>::value == 16, "");
+  static_assert(FixedSerializedSize<std::pair<bool, double>>::value == 11, "");
+  static_assert(FixedSerializedSize<std::tuple<>>::value == 1, "");
+  static_assert(FixedSerializedSize<TestFixedType>::value == 26, "");
+
+  // Integers are encoded according to their value.
+  static_assert(FixedSerializedSize<int32_t>::value == 0, "");
+  static_assert(FixedSerializedSize<std::array<int32_t, 3>>::value == 0, "");
+  static_assert(FixedSerializedSize<std::tuple<float, int>>::value == 0, "");
+  static_assert(FixedSerializedSize<TestType>::value == 0, "");
+
+  Payload result;
+  std::vector<TestFixedType> v(20, TestFixedType{1.0f, {{2.0, 3.0}}, true});
+  Serialize(v, &result);
+  EXPECT_EQ(3u + 20u * 26u, GetSerializedSize(v));
+  EXPECT_EQ(GetSerializedSize(v), result.Size());
+
+  std::vector<TestFixedType> v2;
+  EXPECT_EQ(ErrorCode::NO_ERROR, Deserialize(&v2, &result));
+  EXPECT_EQ(v, v2);
+}
+
 TEST(SerializationTest, Variant) {
   Payload result;
   Payload expected;
@@ -2044,6 +2084,43 @@ TEST(DeserializationTest, vector) {
   EXPECT_EQ(expected, result);
 }
 
+TEST(DeserializationTest, FloatingPointArray) {
+  Payload buffer;
+  std::vector<double> result;
+  ErrorType error;
+
+  // Mixed FLOAT64 and FLOAT32 elements.
+  buffer = {ENCODING_TYPE_FIXARRAY_MIN + 3,
+            ENCODING_TYPE_FLOAT64, kOneDoubleBytes[0], kOneDoubleBytes[1],
+            kOneDoubleBytes[2],    kOneDoubleBytes[3], kOneDoubleBytes[4],
+            kOneDoubleBytes[5],    kOneDoubleBytes[6], kOneDoubleBytes[7],
+            ENCODING_TYPE_FLOAT32, kOneFloatBytes[0],  kOneFloatBytes[1],
+            kOneFloatBytes[2],     kOneFloatBytes[3],
+            ENCODING_TYPE_FLOAT64, kZeroDoubleBytes[0], kZeroDoubleBytes[1],
+            kZeroDoubleBytes[2],   kZeroDoubleBytes[3], kZeroDoubleBytes[4],
+            kZeroDoubleBytes[5],   kZeroDoubleBytes[6], kZeroDoubleBytes[7]};
+  error = Deserialize(&result, &buffer);
+  EXPECT_EQ(ErrorCode::NO_ERROR, error);
+  EXPECT_EQ((std::vector<double>{kOneDouble, kOneDouble, kZeroDouble}), result);
+
+  // Truncated element.
+  buffer = {ENCODING_TYPE_FIXARRAY_MIN + 2,
+            ENCODING_TYPE_FLOAT64, kOneDoubleBytes[0], kOneDoubleBytes[1],
+            kOneDoubleBytes[2],    kOneDoubleBytes[3], kOneDoubleBytes[4],
+            kOneDoubleBytes[5],    kOneDoubleBytes[6], kOneDoubleBytes[7],
+            ENCODING_TYPE_FLOAT64, kOneDoubleBytes[0]};
+  error = Deserialize(&result, &buffer);
+  EXPECT_EQ(ErrorCode::INSUFFICIENT_BUFFER, error);
+
+  // Unexpected element encoding.
+  std::array<float, 2> array_result;
+  buffer = {ENCODING_TYPE_FIXARRAY_MIN + 2, ENCODING_TYPE_FLOAT32,
+            kOneFloatBytes[0], kOneFloatBytes[1], kOneFloatBytes[2],
+            kOneFloatBytes[3], ENCODING_TYPE_POSITIVE_FIXINT_MIN + 1};
+  error = Deserialize(&array_result, &buffer);
+  EXPECT_EQ(ErrorCode::UNEXPECTED_ENCODING, error);
+}
+
 TEST(DeserializationTest, map) {
   Payload buffer;
   std::map<std::uint32_t, std::uint32_t> result;
@@ -0,0 +1,352 @@
+/*
+ ** Copyright 2026, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#include "DriverSymbolCache.h"
+
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "FileBlobCache.h"
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kDriverSymbolCacheMagic = 'EDS1';
+
+// The cache is read and written in the byte order of the device, like the blob caches
+class Writer {
+public:
+    template <typename T>
+    void write(T value) {
+        mData.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeString(const std::string& value) {
+        write<uint32_t>(value.size());
+        mData.append(value);
+    }
+
+    const std::string& data() const { return mData; }
+
+private:
+    std::string mData;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string& data) : mData(data) {}
+
+    template <typename T>
+    bool read(T* outValue) {
+        if (mData.size() - mOffset < sizeof(T)) {
+            return false;
+        }
+        memcpy(outValue, mData.data() + mOffset, sizeof(T));
+        mOffset += sizeof(T);
+        return true;
+    }
+
+    bool readString(std::string* outValue) {
+        uint32_t size;
+        if (!read(&size) || mData.size() - mOffset < size) {
+            return false;
+        }
+        outValue->assign(mData, mOffset, size);
+        mOffset += size;
+        return true;
+    }
+
+    bool done() const { return mOffset == mData.size(); }
+
+private:
+    const std::string& mData;
+    size_t mOffset = 0;
+};
+
+// The library of the cache itself, whose API names the slots of the tables follow
+std::string getOwnLibraryPath() {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&getOwnLibraryPath), &info) == 0 ||
+        info.dli_fname == nullptr) {
+        return "";
+    }
+    return info.dli_fname;
+}
+
+} // namespace
+
+DriverSymbolCache::DriverSymbolCache(std::string filename,
+                                     std::vector<FunctionPointer> localFunctions)
+      : mFilename(std::move(filename)), mLocalFunctions(std::move(localFunctions)) {
+    read();
+}
+
+void DriverSymbolCache::read() {
+    int fd = open(mFilename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+    std::string data;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = TEMP_FAILURE_RETRY(::read(fd, buffer, sizeof(buffer)))) > 0) {
+        data.append(buffer, size);
+    }
+    close(fd);
+
+    uint32_t magic;
+    uint32_t crc;
+    Reader header(data);
+    if (size < 0 || !header.read(&magic) || !header.read(&crc) ||
+        magic != kDriverSymbolCacheMagic) {
+        ALOGW("Ignoring the driver symbol cache %s with a bad header", mFilename.c_str());
+        return;
+    }
+    std::string contents = data.substr(2 * sizeof(uint32_t));
+    if (crc != crc32c(reinterpret_cast<const uint8_t*>(contents.data()), contents.size())) {
+        ALOGW("Ignoring the damaged driver symbol cache %s", mFilename.c_str());
+        return;
+    }
+
+    Reader reader(contents);
+    std::map<uint32_t, Table> tables;
+    uint32_t tableCount;
+    if (!reader.read(&tableCount)) {
+        return;
+    }
+    for (uint32_t i = 0; i < tableCount; i++) {
+        uint32_t id;
+        uint32_t libraryCount;
+        Table table;
+        if (!reader.read(&id) || !reader.readString(&table.stamp) ||
+            !reader.read(&libraryCount)) {
+            return;
+        }
+        for (uint32_t j = 0; j < libraryCount; j++) {
+            Library library;
+            if (!reader.readString(&library.path) || !reader.readString(&library.anchorName) ||
+                !reader.read(&library.anchorOffset)) {
+                return;
+            }
+            table.libraries.push_back(std::move(library));
+        }
+        uint32_t slotCount;
+        if (!reader.read(&slotCount) || slotCount > contents.size()) {
+            return;
+        }
+        table.slots.resize(slotCount);
+        for (Slot& slot : table.slots) {
+            if (!reader.read(&slot.kind) || !reader.read(&slot.index) ||
+                !reader.read(&slot.offset)) {
+                return;
+            }
+        }
+        tables[id] = std::move(table);
+    }
+    if (reader.done()) {
+        mTables = std::move(tables);
+    }
+}
+
+std::string DriverSymbolCache::getStamp(const std::vector<Library>& libraries) const {
+    std::string stamp = base::GetProperty("ro.build.fingerprint", "");
+    std::vector<std::string> paths = {getOwnLibraryPath()};
+    for (const Library& library : libraries) {
+        paths.push_back(library.path);
+    }
+    for (const std::string& path : paths) {
+        // The libraries of the updatable drivers are loaded from their package
+        const std::string file = path.substr(0, path.find("!/"));
+        struct stat st;
+        if (file.empty() || stat(file.c_str(), &st) != 0) {
+            return "";
+        }
+        stamp += base::StringPrintf("|%s:%llu:%llu:%lld:%lld.%09ld", path.c_str(),
+                                    static_cast<unsigned long long>(st.st_dev),
+                                    static_cast<unsigned long long>(st.st_ino),
+                                    static_cast<long long>(st.st_size),
+                                    static_cast<long long>(st.st_mtim.tv_sec),
+                                    static_cast<long>(st.st_mtim.tv_nsec));
+    }
+    return stamp;
+}
+
+bool DriverSymbolCache::fill(uint32_t tableId, void* dso, const char* const* names,
+                             FunctionPointer* slots, GetProcAddress getProcAddress) const {
+    auto it = mTables.find(tableId);
+    if (it == mTables.end()) {
+        return false;
+    }
+    const Table& table = it->second;
+    // The tables which only have some of the names stop at the last of their names
+    size_t nameCount = 0;
+    while (names[nameCount]) {
+        nameCount++;
+    }
+    const size_t slotCount = table.slots.size();
+    if (slotCount > nameCount || table.stamp.empty() ||
+        table.stamp != getStamp(table.libraries)) {
+        return false;
+    }
+
+    // Find where the libraries are loaded, and check that they are the libraries of the cache
+    std::vector<uintptr_t> bases;
+    for (const Library& library : table.libraries) {
+        void* anchor = dlsym(dso, library.anchorName.c_str());
+        Dl_info info;
+        if (anchor == nullptr || dladdr(anchor, &info) == 0 || info.dli_fname == nullptr ||
+            library.path != info.dli_fname ||
+            reinterpret_cast<uintptr_t>(anchor) - reinterpret_cast<uintptr_t>(info.dli_fbase) !=
+                    library.anchorOffset) {
+            ALOGW("The driver symbol cache is out of date for %s", library.path.c_str());
+            return false;
+        }
+        bases.push_back(reinterpret_cast<uintptr_t>(info.dli_fbase));
+    }
+    for (const Slot& slot : table.slots) {
+        if ((slot.kind == SlotKind::SYMBOL && slot.index >= bases.size()) ||
+            (slot.kind == SlotKind::LOCAL && slot.index >= mLocalFunctions.size())) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < slotCount; i++) {
+        const Slot& slot = table.slots[i];
+        switch (slot.kind) {
+            case SlotKind::SYMBOL:
+                slots[i] = reinterpret_cast<FunctionPointer>(bases[slot.index] + slot.offset);
+                break;
+            case SlotKind::PROC_ADDRESS:
+                slots[i] = getProcAddress ? getProcAddress(names[i]) : nullptr;
+                break;
+            case SlotKind::LOCAL:
+                slots[i] = mLocalFunctions[slot.index];
+                break;
+        }
+    }
+    return true;
+}
+
+void DriverSymbolCache::record(uint32_t tableId, FunctionPointer f, Source source,
+                               const char* symbolName) {
+    Table& table = mRecordedTables[tableId];
+    Slot slot = {SlotKind::LOCAL, 0, 0};
+    switch (source) {
+        case Source::DLSYM: {
+            Dl_info info;
+            if (symbolName == nullptr || dladdr(reinterpret_cast<void*>(f), &info) == 0 ||
+                info.dli_fname == nullptr) {
+                table.complete = false;
+                break;
+            }
+            const uint64_t offset =
+                    reinterpret_cast<uintptr_t>(f) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+            auto library = std::find_if(table.libraries.begin(), table.libraries.end(),
+                                        [&info](const Library& library) {
+                                            return library.path == info.dli_fname;
+                                        });
+            if (library == table.libraries.end()) {
+                library = table.libraries.insert(table.libraries.end(),
+                                                 Library{info.dli_fname, symbolName, offset});
+            }
+            slot = {SlotKind::SYMBOL,
+                    static_cast<uint32_t>(library - table.libraries.begin()), offset};
+            break;
+        }
+        case Source::PROC_ADDRESS: {
+            slot.kind = SlotKind::PROC_ADDRESS;
+            break;
+        }
+        case Source::LOCAL: {
+            auto local = std::find(mLocalFunctions.begin(), mLocalFunctions.end(), f);
+            if (local == mLocalFunctions.end()) {
+                table.complete = false;
+                break;
+            }
+            slot.index = local - mLocalFunctions.begin();
+            break;
+        }
+    }
+    table.slots.push_back(slot);
+}
+
+void DriverSymbolCache::save() {
+    if (mRecordedTables.empty()) {
+        return;
+    }
+    for (auto& [id, table] : mRecordedTables) {
+        table.stamp = table.complete ? getStamp(table.libraries) : "";
+        if (table.stamp.empty()) {
+            mTables.erase(id);
+        } else {
+            mTables[id] = std::move(table);
+        }
+    }
+    mRecordedTables.clear();
+
+    Writer writer;
+    writer.write<uint32_t>(mTables.size());
+    for (const auto& [id, table] : mTables) {
+        writer.write(id);
+        writer.writeString(table.stamp);
+        writer.write<uint32_t>(table.libraries.size());
+        for (const Library& library : table.libraries) {
+            writer.writeString(library.path);
+            writer.writeString(library.anchorName);
+            writer.write(library.anchorOffset);
+        }
+        writer.write<uint32_t>(table.slots.size());
+        for (const Slot& slot : table.slots) {
+            writer.write(slot.kind);
+            writer.write(slot.index);
+            writer.write(slot.offset);
+        }
+    }
+    const std::string& contents = writer.data();
+    const uint32_t header[] = {kDriverSymbolCacheMagic,
+                               crc32c(reinterpret_cast<const uint8_t*>(contents.data()),
+                                      contents.size())};
+
+    // Write a temporary file and rename it, so that the cache is never partially written
+    const std::string tempFilename = mFilename + ".tmp";
+    int fd = open(tempFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        ALOGW("Unable to create the driver symbol cache %s: %s", tempFilename.c_str(),
+              strerror(errno));
+        return;
+    }
+    const bool written = write(fd, header, sizeof(header)) == sizeof(header) &&
+            write(fd, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size());
+    close(fd);
+    if (!written || rename(tempFilename.c_str(), mFilename.c_str()) != 0) {
+        ALOGW("Unable to write the driver symbol cache %s: %s", mFilename.c_str(),
+              strerror(errno));
+        unlink(tempFilename.c_str());
+    }
+}
+
+}; // namespace android
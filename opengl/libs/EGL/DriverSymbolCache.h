@@ -0,0 +1,110 @@
+/*
+ ** Copyright 2026, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#ifndef ANDROID_DRIVER_SYMBOL_CACHE_H
+#define ANDROID_DRIVER_SYMBOL_CACHE_H
+
+#include <EGL/egl.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace android {
+
+/*
+ * Caches how the entry points of the API tables were resolved in the libraries of a driver, so
+ * that the next processes fill the tables without looking every entry point up with dlsym.
+ *
+ * The entry points found with dlsym are stored as offsets in the library which contains them.
+ * When a table is filled, a single symbol of each library is looked up to find where the library
+ * is loaded, and to check that it is still the library of the cache. The cache is only used for
+ * the same build of the platform and the same files of the libraries.
+ */
+class DriverSymbolCache {
+public:
+    using FunctionPointer = __eglMustCastToProperFunctionPointerType;
+    using GetProcAddress = FunctionPointer (*)(const char*);
+
+    // How the entry point of a slot was found
+    enum class Source : uint8_t {
+        // With dlsym in the driver
+        DLSYM,
+        // With eglGetProcAddress of the driver, which is called again when the table is filled
+        PROC_ADDRESS,
+        // One of the local functions of libEGL, or nullptr
+        LOCAL,
+    };
+
+    // Reads the cache from the file. The local functions are the ones of libEGL which can fill
+    // the slots of the entry points which the driver does not have.
+    DriverSymbolCache(std::string filename, std::vector<FunctionPointer> localFunctions);
+
+    // Fills the slots of a table from the cache. Returns false, without changing the slots, if
+    // the cache has no up to date resolution of the table for these libraries.
+    bool fill(uint32_t table, void* dso, const char* const* names, FunctionPointer* slots,
+              GetProcAddress getProcAddress) const;
+
+    // Records how the next slot of a table was resolved. The symbol name is the name which dlsym
+    // found the entry point with.
+    void record(uint32_t table, FunctionPointer f, Source source, const char* symbolName);
+
+    // Writes the tables recorded since the cache was read, if there are any.
+    void save();
+
+private:
+    enum class SlotKind : uint8_t {
+        SYMBOL,
+        PROC_ADDRESS,
+        LOCAL,
+    };
+
+    struct Library {
+        std::string path;
+        // The symbol which finds where the library is loaded, and its offset in the library
+        std::string anchorName;
+        uint64_t anchorOffset;
+    };
+
+    struct Slot {
+        SlotKind kind;
+        // The library of a SYMBOL, or the index of a LOCAL function
+        uint32_t index;
+        uint64_t offset;
+    };
+
+    struct Table {
+        // The builds the table was recorded with, see getStamp
+        std::string stamp;
+        std::vector<Library> libraries;
+        std::vector<Slot> slots;
+        // Whether every slot could be recorded
+        bool complete = true;
+    };
+
+    void read();
+    // Identifies the builds of the platform and of the files of the libraries
+    std::string getStamp(const std::vector<Library>& libraries) const;
+
+    const std::string mFilename;
+    const std::vector<FunctionPointer> mLocalFunctions;
+    std::map<uint32_t, Table> mTables;
+    std::map<uint32_t, Table> mRecordedTables;
+};
+
+}; // namespace android
+
+#endif // ANDROID_DRIVER_SYMBOL_CACHE_H
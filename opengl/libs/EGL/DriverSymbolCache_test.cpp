@@ -0,0 +1,120 @@
+/*
+ ** Copyright 2026, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#include "DriverSymbolCache.h"
+
+#include <android-base/test_utils.h>
+#include <dlfcn.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <memory>
+
+namespace android {
+
+using FunctionPointer = DriverSymbolCache::FunctionPointer;
+using Source = DriverSymbolCache::Source;
+
+constexpr uint32_t kTable = 1;
+
+void localFunction() {}
+void unknownFunction() {}
+
+class DriverSymbolCacheTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        mTempFile.reset(new TemporaryFile());
+        // The cache only reads files which it wrote itself
+        unlink(&mTempFile->path[0]);
+        mDso = dlopen("libc.so", RTLD_NOW);
+        ASSERT_NE(nullptr, mDso);
+    }
+
+    virtual void TearDown() { dlclose(mDso); }
+
+    std::unique_ptr<DriverSymbolCache> createCache() {
+        return std::make_unique<DriverSymbolCache>(&mTempFile->path[0],
+                                                   std::vector<FunctionPointer>{
+                                                           nullptr,
+                                                           (FunctionPointer)localFunction,
+                                                   });
+    }
+
+    FunctionPointer lookUp(const char* name) { return (FunctionPointer)dlsym(mDso, name); }
+
+    void recordTable(DriverSymbolCache* cache) {
+        cache->record(kTable, lookUp("malloc"), Source::DLSYM, "malloc");
+        cache->record(kTable, lookUp("strlen"), Source::DLSYM, "strlen");
+        cache->record(kTable, (FunctionPointer)localFunction, Source::LOCAL, nullptr);
+        cache->record(kTable, nullptr, Source::LOCAL, nullptr);
+        cache->save();
+    }
+
+    const char* const mNames[5] = {"malloc", "strlen", "notAnEntryPoint", "neither", nullptr};
+    std::unique_ptr<TemporaryFile> mTempFile;
+    void* mDso = nullptr;
+};
+
+TEST_F(DriverSymbolCacheTest, EmptyCacheDoesNotFill) {
+    FunctionPointer slots[4] = {};
+    ASSERT_FALSE(createCache()->fill(kTable, mDso, mNames, slots, nullptr));
+}
+
+TEST_F(DriverSymbolCacheTest, RecordedTableIsFilled) {
+    recordTable(createCache().get());
+
+    FunctionPointer slots[4] = {};
+    ASSERT_TRUE(createCache()->fill(kTable, mDso, mNames, slots, nullptr));
+    ASSERT_EQ(lookUp("malloc"), slots[0]);
+    ASSERT_EQ(lookUp("strlen"), slots[1]);
+    ASSERT_EQ((FunctionPointer)localFunction, slots[2]);
+    ASSERT_EQ(nullptr, slots[3]);
+}
+
+TEST_F(DriverSymbolCacheTest, OtherTableIsNotFilled) {
+    recordTable(createCache().get());
+
+    FunctionPointer slots[4] = {};
+    ASSERT_FALSE(createCache()->fill(kTable + 1, mDso, mNames, slots, nullptr));
+}
+
+TEST_F(DriverSymbolCacheTest, TableWithUnknownFunctionIsNotSaved) {
+    std::unique_ptr<DriverSymbolCache> cache = createCache();
+    cache->record(kTable, lookUp("malloc"), Source::DLSYM, "malloc");
+    cache->record(kTable, (FunctionPointer)unknownFunction, Source::LOCAL, nullptr);
+    cache->save();
+
+    FunctionPointer slots[4] = {};
+    ASSERT_FALSE(createCache()->fill(kTable, mDso, mNames, slots, nullptr));
+}
+
+TEST_F(DriverSymbolCacheTest, DamagedCacheIsIgnored) {
+    recordTable(createCache().get());
+
+    FILE* file = fopen(&mTempFile->path[0], "r+");
+    ASSERT_NE(nullptr, file);
+    fseek(file, -1, SEEK_END);
+    int c = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(c ^ 0xff, file);
+    fclose(file);
+
+    FunctionPointer slots[4] = {};
+    ASSERT_FALSE(createCache()->fill(kTable, mDso, mNames, slots, nullptr));
+}
+
+} // namespace android
@@ -0,0 +1,108 @@
+/*
+ ** Copyright 2026, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#include "LazyGLHooks.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace android {
+
+namespace {
+
+using FunctionPointer = LazyGLHooks::FunctionPointer;
+
+constexpr size_t kSlotCount = sizeof(gl_hooks_t::gl_t) / sizeof(FunctionPointer);
+
+// The call of the entry point replaces the call of the trampoline, which then does not add a
+// frame to the stack of the app
+#if defined(__clang__) && __has_cpp_attribute(clang::musttail)
+#define LAZY_GL_TAIL_CALL [[clang::musttail]]
+#else
+#define LAZY_GL_TAIL_CALL
+#endif
+
+template <size_t Slot, typename F>
+struct Trampoline;
+
+template <size_t Slot, typename R, typename... Args>
+struct Trampoline<Slot, R (*)(Args...)> {
+    static R call(Args... args) {
+        const auto f = reinterpret_cast<R (*)(Args...)>(
+                LazyGLHooks::resolve(Slot, reinterpret_cast<FunctionPointer>(&call)));
+        LAZY_GL_TAIL_CALL return f(args...);
+    }
+};
+
+#undef GL_ENTRY
+#define GL_ENTRY(_r, _api, ...)                                                              \
+    reinterpret_cast<FunctionPointer>(                                                       \
+            &Trampoline<offsetof(gl_hooks_t::gl_t, _api) / sizeof(FunctionPointer),          \
+                        decltype(gl_hooks_t::gl_t::_api)>::call),
+
+const FunctionPointer kTrampolines[] = {
+#include "../entries.in"
+};
+
+#undef GL_ENTRY
+
+static_assert(sizeof(kTrampolines) / sizeof(*kTrampolines) == kSlotCount,
+              "There must be a trampoline for each hook");
+
+std::mutex sMutex;
+FunctionPointer* sHooks = nullptr;
+const char* const* sNames = nullptr;
+LazyGLHooks::Resolver sResolver;
+std::atomic<FunctionPointer> sResolved[kSlotCount];
+
+} // namespace
+
+void LazyGLHooks::install(gl_hooks_t::gl_t* hooks, const char* const* names, Resolver resolver) {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sHooks = reinterpret_cast<FunctionPointer*>(hooks);
+    sNames = names;
+    sResolver = std::move(resolver);
+    for (size_t slot = 0; slot < kSlotCount; slot++) {
+        sResolved[slot].store(nullptr, std::memory_order_relaxed);
+        sHooks[slot] = kTrampolines[slot];
+    }
+}
+
+FunctionPointer LazyGLHooks::resolve(size_t slot, FunctionPointer trampoline) {
+    FunctionPointer f = sResolved[slot].load(std::memory_order_acquire);
+    if (f != nullptr) {
+        return f;
+    }
+
+    // The threads which call the entry point for the first time at once wait for the first of
+    // them, so that the driver is only asked once for each entry point
+    std::lock_guard<std::mutex> lock(sMutex);
+    f = sResolved[slot].load(std::memory_order_relaxed);
+    if (f == nullptr) {
+        f = sResolver(sNames[slot]);
+        sResolved[slot].store(f, std::memory_order_release);
+        // The other threads read the hooks without synchronization, and see either the
+        // trampoline or the entry point, which both call the entry point. A hook which was
+        // replaced, by a layer or by the platform, is left as it is.
+        FunctionPointer expected = trampoline;
+        __atomic_compare_exchange_n(&sHooks[slot], &expected, f, false, __ATOMIC_RELEASE,
+                                    __ATOMIC_RELAXED);
+    }
+    return f;
+}
+
+} // namespace android
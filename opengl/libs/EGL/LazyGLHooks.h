@@ -0,0 +1,52 @@
+/*
+ ** Copyright 2026, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#ifndef ANDROID_LAZY_GL_HOOKS_H
+#define ANDROID_LAZY_GL_HOOKS_H
+
+#include <functional>
+
+#include "../hooks.h"
+
+namespace android {
+
+/*
+ * Fills the GLES 2+ hooks with a trampoline per entry point, which resolves the entry point in
+ * the driver on its first call, patches the hook with it and tail calls it. Only the entry points
+ * which the app calls are then resolved, instead of all of them when the driver is loaded.
+ *
+ * The trampolines resolve their entry point without the thread specific hooks, so that they can
+ * also be called by the layers, which keep them as the next entry points of their chain. A hook
+ * is only patched while it still holds its trampoline.
+ */
+class LazyGLHooks {
+public:
+    using FunctionPointer = __eglMustCastToProperFunctionPointerType;
+    // Returns the entry point of a name in the driver, which must not be nullptr.
+    using Resolver = std::function<FunctionPointer(const char* name)>;
+
+    // Fills the hooks with the trampolines, which resolve the names of the hooks, in the order of
+    // entries.in, with the resolver. Replaces the hooks and resolver of a previous driver.
+    static void install(gl_hooks_t::gl_t* hooks, const char* const* names, Resolver resolver);
+
+    // Returns the entry point of a slot of the hooks, resolving it on the first call. Called by
+    // the trampolines.
+    static FunctionPointer resolve(size_t slot, FunctionPointer trampoline);
+};
+
+} // namespace android
+
+#endif // ANDROID_LAZY_GL_HOOKS_H
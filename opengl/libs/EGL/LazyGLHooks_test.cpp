@@ -0,0 +1,120 @@
+/*
+ ** Copyright 2026, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#include "LazyGLHooks.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+using FunctionPointer = LazyGLHooks::FunctionPointer;
+
+#undef GL_ENTRY
+#define GL_ENTRY(_r, _api, ...) #_api,
+
+const char* const kNames[] = {
+#include "../entries.in"
+        nullptr};
+
+#undef GL_ENTRY
+
+GLenum sActiveTexture = 0;
+
+void fakeActiveTexture(GLenum texture) {
+    sActiveTexture = texture;
+}
+
+GLenum fakeGetError() {
+    return GL_OUT_OF_MEMORY;
+}
+
+void fakeUnimplemented() {}
+
+void replacedActiveTexture(GLenum) {}
+
+class LazyGLHooksTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        sActiveTexture = 0;
+        // The resolver is called with the lock of the hooks held
+        LazyGLHooks::install(&mHooks.gl, kNames, [this](const char* name) {
+            mResolvedNames.push_back(name);
+            if (strcmp(name, "glActiveTexture") == 0) {
+                return reinterpret_cast<FunctionPointer>(fakeActiveTexture);
+            }
+            if (strcmp(name, "glGetError") == 0) {
+                return reinterpret_cast<FunctionPointer>(fakeGetError);
+            }
+            return reinterpret_cast<FunctionPointer>(fakeUnimplemented);
+        });
+    }
+
+    gl_hooks_t mHooks = {};
+    std::vector<std::string> mResolvedNames;
+};
+
+TEST_F(LazyGLHooksTest, HookIsResolvedOnFirstCall) {
+    ASSERT_TRUE(mResolvedNames.empty());
+    mHooks.gl.glActiveTexture(GL_TEXTURE3);
+    ASSERT_EQ(GLenum(GL_TEXTURE3), sActiveTexture);
+    ASSERT_EQ(std::vector<std::string>{"glActiveTexture"}, mResolvedNames);
+    ASSERT_EQ(reinterpret_cast<FunctionPointer>(fakeActiveTexture),
+              reinterpret_cast<FunctionPointer>(mHooks.gl.glActiveTexture));
+
+    mHooks.gl.glActiveTexture(GL_TEXTURE4);
+    ASSERT_EQ(GLenum(GL_TEXTURE4), sActiveTexture);
+    ASSERT_EQ(size_t(1), mResolvedNames.size());
+}
+
+TEST_F(LazyGLHooksTest, ReturnValueIsForwarded) {
+    ASSERT_EQ(GLenum(GL_OUT_OF_MEMORY), mHooks.gl.glGetError());
+}
+
+TEST_F(LazyGLHooksTest, ReplacedHookIsNotPatched) {
+    // Like a layer, which calls the trampoline as the next entry point of its chain
+    auto trampoline = mHooks.gl.glActiveTexture;
+    mHooks.gl.glActiveTexture = replacedActiveTexture;
+
+    trampoline(GL_TEXTURE5);
+    trampoline(GL_TEXTURE6);
+    ASSERT_EQ(GLenum(GL_TEXTURE6), sActiveTexture);
+    ASSERT_EQ(size_t(1), mResolvedNames.size());
+    ASSERT_EQ(reinterpret_cast<FunctionPointer>(replacedActiveTexture),
+              reinterpret_cast<FunctionPointer>(mHooks.gl.glActiveTexture));
+}
+
+TEST_F(LazyGLHooksTest, ConcurrentFirstCallsResolveOnce) {
+    auto trampoline = mHooks.gl.glGetError;
+    std::vector<std::thread> threads;
+    std::vector<GLenum> errors(8);
+    for (GLenum& error : errors) {
+        threads.emplace_back([trampoline, &error]() { error = trampoline(); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (GLenum error : errors) {
+        ASSERT_EQ(GLenum(GL_OUT_OF_MEMORY), error);
+    }
+    ASSERT_EQ(std::vector<std::string>{"glGetError"}, mResolvedNames);
+}
+
+} // namespace android
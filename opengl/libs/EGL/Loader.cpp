@@ -32,6 +32,8 @@
 #include <string>
 
 #include "EGL/eglext_angle.h"
+#include "LazyGLHooks.h"
+#include "egl_cache.h"
 #include "egl_platform_entries.h"
 #include "egl_trace.h"
 #include "egldefs.h"
@@ -218,6 +220,17 @@ void* Loader::open(egl_connection_t* cnx)
         return cnx->dso;
     }
 
+    // The API tables are filled from the resolution of the previous processes of the app, which
+    // is stored next to its blob cache
+    const std::string cacheFilename = egl_cache_t::get()->getCacheFilename();
+    if (!cacheFilename.empty()) {
+        symbolCache = std::make_unique<DriverSymbolCache>(
+                cacheFilename + ".driver_symbols",
+                std::vector<__eglMustCastToProperFunctionPointerType>{
+                        nullptr, (__eglMustCastToProperFunctionPointerType)gl_unimplemented,
+                        (__eglMustCastToProperFunctionPointerType)gl_noop});
+    }
+
     // Firstly, try to load ANGLE driver.
     driver_t* hnd = attempt_to_load_angle(cnx);
 
@@ -307,6 +320,11 @@ void* Loader::open(egl_connection_t* cnx)
     LOG_ALWAYS_FATAL_IF(!cnx->libGles2 || !cnx->libGles1,
                         "couldn't load system OpenGL ES wrapper libraries");
 
+    if (symbolCache) {
+        symbolCache->save();
+        symbolCache.reset();
+    }
+
     android::GraphicsEnv::getInstance().setDriverLoaded(android::GpuStatsInfo::Api::API_GL, true,
                                                         systemTime() - openTime);
 
@@ -326,64 +344,37 @@ void Loader::init_api(void* dso,
         char const * const * api,
         char const * const * ref_api,
         __eglMustCastToProperFunctionPointerType* curr,
-        getProcAddressType getProcAddress)
+        getProcAddressType getProcAddress,
+        DriverSymbolCache* cache, uint32_t table)
 {
     ATRACE_CALL();
 
-    const ssize_t SIZE = 256;
-    char scrap[SIZE];
+    // The slots follow the reference names, when there are some
+    if (cache && cache->fill(table, dso, ref_api ? ref_api : api, curr, getProcAddress)) {
+        ALOGV("Filled API table %u from the driver symbol cache", table);
+        return;
+    }
+
     while (*api) {
         char const * name = *api;
         if (ref_api) {
             char const * ref_name = *ref_api;
             if (std::strcmp(name, ref_name) != 0) {
                 *curr++ = nullptr;
+                if (cache) {
+                    cache->record(table, nullptr, DriverSymbolCache::Source::LOCAL, nullptr);
+                }
                 ref_api++;
                 continue;
             }
         }
 
+        DriverSymbolCache::Source source;
+        std::string symbolName;
         __eglMustCastToProperFunctionPointerType f =
-            (__eglMustCastToProperFunctionPointerType)dlsym(dso, name);
-        if (f == nullptr) {
-            // couldn't find the entry-point, use eglGetProcAddress()
-            f = getProcAddress(name);
-        }
-        if (f == nullptr) {
-            // Try without the OES postfix
-            ssize_t index = ssize_t(strlen(name)) - 3;
-            if ((index>0 && (index<SIZE-1)) && (!strcmp(name+index, "OES"))) {
-                strncpy(scrap, name, index);
-                scrap[index] = 0;
-                f = (__eglMustCastToProperFunctionPointerType)dlsym(dso, scrap);
-                //ALOGD_IF(f, "found <%s> instead", scrap);
-            }
-        }
-        if (f == nullptr) {
-            // Try with the OES postfix
-            ssize_t index = ssize_t(strlen(name)) - 3;
-            if (index>0 && strcmp(name+index, "OES")) {
-                snprintf(scrap, SIZE, "%sOES", name);
-                f = (__eglMustCastToProperFunctionPointerType)dlsym(dso, scrap);
-                //ALOGD_IF(f, "found <%s> instead", scrap);
-            }
-        }
-        if (f == nullptr) {
-            //ALOGD("%s", name);
-            f = (__eglMustCastToProperFunctionPointerType)gl_unimplemented;
-
-            /*
-             * GL_EXT_debug_marker is special, we always report it as
-             * supported, it's handled by GLES_trace. If GLES_trace is not
-             * enabled, then these are no-ops.
-             */
-            if (!strcmp(name, "glInsertEventMarkerEXT")) {
-                f = (__eglMustCastToProperFunctionPointerType)gl_noop;
-            } else if (!strcmp(name, "glPushGroupMarkerEXT")) {
-                f = (__eglMustCastToProperFunctionPointerType)gl_noop;
-            } else if (!strcmp(name, "glPopGroupMarkerEXT")) {
-                f = (__eglMustCastToProperFunctionPointerType)gl_noop;
-            }
+            resolve_api(dso, name, getProcAddress, &source, &symbolName);
+        if (cache) {
+            cache->record(table, f, source, symbolName.empty() ? name : symbolName.c_str());
         }
         *curr++ = f;
         api++;
@@ -391,6 +382,66 @@ void Loader::init_api(void* dso,
     }
 }
 
+__eglMustCastToProperFunctionPointerType Loader::resolve_api(void* dso,
+        char const * name,
+        getProcAddressType getProcAddress,
+        DriverSymbolCache::Source* outSource,
+        std::string* outSymbolName)
+{
+    const ssize_t SIZE = 256;
+    char scrap[SIZE];
+    *outSource = DriverSymbolCache::Source::DLSYM;
+    __eglMustCastToProperFunctionPointerType f =
+        (__eglMustCastToProperFunctionPointerType)dlsym(dso, name);
+    if (f == nullptr) {
+        // couldn't find the entry-point, use eglGetProcAddress()
+        f = getProcAddress(name);
+        *outSource = DriverSymbolCache::Source::PROC_ADDRESS;
+    }
+    if (f == nullptr) {
+        // Try without the OES postfix
+        ssize_t index = ssize_t(strlen(name)) - 3;
+        if ((index>0 && (index<SIZE-1)) && (!strcmp(name+index, "OES"))) {
+            strncpy(scrap, name, index);
+            scrap[index] = 0;
+            f = (__eglMustCastToProperFunctionPointerType)dlsym(dso, scrap);
+            *outSource = DriverSymbolCache::Source::DLSYM;
+            *outSymbolName = scrap;
+            //ALOGD_IF(f, "found <%s> instead", scrap);
+        }
+    }
+    if (f == nullptr) {
+        // Try with the OES postfix
+        ssize_t index = ssize_t(strlen(name)) - 3;
+        if (index>0 && strcmp(name+index, "OES")) {
+            snprintf(scrap, SIZE, "%sOES", name);
+            f = (__eglMustCastToProperFunctionPointerType)dlsym(dso, scrap);
+            *outSource = DriverSymbolCache::Source::DLSYM;
+            *outSymbolName = scrap;
+            //ALOGD_IF(f, "found <%s> instead", scrap);
+        }
+    }
+    if (f == nullptr) {
+        //ALOGD("%s", name);
+        f = (__eglMustCastToProperFunctionPointerType)gl_unimplemented;
+        *outSource = DriverSymbolCache::Source::LOCAL;
+
+        /*
+         * GL_EXT_debug_marker is special, we always report it as
+         * supported, it's handled by GLES_trace. If GLES_trace is not
+         * enabled, then these are no-ops.
+         */
+        if (!strcmp(name, "glInsertEventMarkerEXT")) {
+            f = (__eglMustCastToProperFunctionPointerType)gl_noop;
+        } else if (!strcmp(name, "glPushGroupMarkerEXT")) {
+            f = (__eglMustCastToProperFunctionPointerType)gl_noop;
+        } else if (!strcmp(name, "glPopGroupMarkerEXT")) {
+            f = (__eglMustCastToProperFunctionPointerType)gl_noop;
+        }
+    }
+    return f;
+}
+
 static void* load_system_driver(const char* kind, const char* suffix, const bool exact) {
     ATRACE_CALL();
     class MatchFile {
@@ -648,17 +699,28 @@ void Loader::initialize_api(void* dso, egl_connection_t* cnx, uint32_t mask) {
         __eglMustCastToProperFunctionPointerType* curr =
             (__eglMustCastToProperFunctionPointerType*)egl;
         char const * const * api = egl_names;
-        while (*api) {
+        DriverSymbolCache* cache = symbolCache.get();
+        if (cache && cache->fill(EGL, dso, api, curr, getProcAddress)) {
+            ALOGV("Filled the EGL API table from the driver symbol cache");
+            api = nullptr;
+        }
+        while (api && *api) {
             char const * name = *api;
+            DriverSymbolCache::Source source = DriverSymbolCache::Source::DLSYM;
             __eglMustCastToProperFunctionPointerType f =
                 (__eglMustCastToProperFunctionPointerType)dlsym(dso, name);
             if (f == nullptr) {
                 // couldn't find the entry-point, use eglGetProcAddress()
                 f = getProcAddress(name);
+                source = DriverSymbolCache::Source::PROC_ADDRESS;
                 if (f == nullptr) {
                     f = (__eglMustCastToProperFunctionPointerType)nullptr;
+                    source = DriverSymbolCache::Source::LOCAL;
                 }
             }
+            if (cache) {
+                cache->record(EGL, f, source, name);
+            }
             *curr++ = f;
             api++;
         }
@@ -668,14 +730,27 @@ void Loader::initialize_api(void* dso, egl_connection_t* cnx, uint32_t mask) {
         init_api(dso, gl_names_1, gl_names,
             (__eglMustCastToProperFunctionPointerType*)
                 &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl,
-            getProcAddress);
+            getProcAddress, symbolCache.get(), GLESv1_CM);
     }
 
     if (mask & GLESv2) {
-        init_api(dso, gl_names, nullptr,
-            (__eglMustCastToProperFunctionPointerType*)
-                &cnx->hooks[egl_connection_t::GLESv2_INDEX]->gl,
-            getProcAddress);
+        if (base::GetBoolProperty("ro.egl.lazy_gl_hooks", false)) {
+            // The entry points are resolved on their first call instead, the GLES 1 entry points
+            // are few and the layers only use the GLES 2+ hooks
+            ATRACE_NAME("LazyGLHooks::install");
+            LazyGLHooks::install(&cnx->hooks[egl_connection_t::GLESv2_INDEX]->gl, gl_names,
+                                 [dso, getProcAddress = getProcAddress](const char* name) {
+                                     DriverSymbolCache::Source source;
+                                     std::string symbolName;
+                                     return resolve_api(dso, name, getProcAddress, &source,
+                                                        &symbolName);
+                                 });
+        } else {
+            init_api(dso, gl_names, nullptr,
+                (__eglMustCastToProperFunctionPointerType*)
+                    &cnx->hooks[egl_connection_t::GLESv2_INDEX]->gl,
+                getProcAddress, symbolCache.get(), GLESv2);
+        }
     }
 }
 
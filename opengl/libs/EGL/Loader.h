@@ -20,6 +20,11 @@
 #include <EGL/egl.h>
 #include <stdint.h>
 
+#include <memory>
+#include <string>
+
+#include "DriverSymbolCache.h"
+
 namespace android {
 
 struct egl_connection_t;
@@ -43,6 +48,9 @@ class Loader {
 
     getProcAddressType getProcAddress;
 
+    // The resolution of the API tables of the driver, while it is loaded
+    std::unique_ptr<DriverSymbolCache> symbolCache;
+
 public:
     static Loader& getInstance();
     ~Loader();
@@ -62,7 +70,11 @@ private:
     static __attribute__((noinline)) void init_api(void* dso, const char* const* api,
                                                    const char* const* ref_api,
                                                    __eglMustCastToProperFunctionPointerType* curr,
-                                                   getProcAddressType getProcAddress);
+                                                   getProcAddressType getProcAddress,
+                                                   DriverSymbolCache* cache, uint32_t table);
+    static __eglMustCastToProperFunctionPointerType resolve_api(
+            void* dso, const char* name, getProcAddressType getProcAddress,
+            DriverSymbolCache::Source* outSource, std::string* outSymbolName);
 };
 
 }; // namespace android
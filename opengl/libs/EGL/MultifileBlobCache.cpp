@@ -34,14 +34,23 @@
 #include <chrono>
 #include <limits>
 #include <locale>
+#include <memory>
 
+#include <lz4.h>
 #include <utils/JenkinsHash.h>
 
 using namespace std::literals;
 
 constexpr uint32_t kMultifileMagic = 'MFB$';
+// The entries with a MultifileValueHeader after their key
+constexpr uint32_t kMultifileValueMagic = 'MFV$';
+constexpr uint32_t kMultifileIndexMagic = 'MFI$';
 constexpr uint32_t kCrcPlaceholder = 0;
 
+// The number of changes to the entries after which the index is written again, so that it stays
+// mostly up to date even when the cache is never finished
+constexpr size_t kIndexWriteInterval = 32;
+
 namespace {
 
 // Helper function to close entries or free them
@@ -58,20 +67,88 @@ void freeHotCacheEntry(android::MultifileHotCache& entry) {
     }
 }
 
+// The value header follows the key, so it may not be aligned
+android::MultifileValueHeader getValueHeader(const uint8_t* entryBuffer) {
+    const android::MultifileHeader* header =
+            reinterpret_cast<const android::MultifileHeader*>(entryBuffer);
+    android::MultifileValueHeader valueHeader;
+    memcpy(&valueHeader, entryBuffer + sizeof(android::MultifileHeader) + header->keySize,
+           sizeof(android::MultifileValueHeader));
+    return valueHeader;
+}
+
+// Returns whether the sizes in the header of an entry are consistent with the size of the entry
+bool hasValidLayout(const uint8_t* entryBuffer, size_t entrySize) {
+    const android::MultifileHeader* header =
+            reinterpret_cast<const android::MultifileHeader*>(entryBuffer);
+    if (header->keySize <= 0 || header->valueSize <= 0) {
+        return false;
+    }
+    const size_t valueOffset = sizeof(android::MultifileHeader) + header->keySize;
+    if (header->magic == kMultifileMagic) {
+        return valueOffset + header->valueSize == entrySize;
+    }
+    if (header->magic != kMultifileValueMagic ||
+        valueOffset + sizeof(android::MultifileValueHeader) > entrySize) {
+        return false;
+    }
+    android::MultifileValueHeader valueHeader = getValueHeader(entryBuffer);
+    if (valueOffset + sizeof(android::MultifileValueHeader) + valueHeader.storedSize != entrySize) {
+        return false;
+    }
+    switch (valueHeader.storage) {
+        case android::MultifileValueStorage::Raw:
+            return valueHeader.storedSize == header->valueSize;
+        case android::MultifileValueStorage::Lz4:
+            return valueHeader.storedSize > 0;
+        case android::MultifileValueStorage::Reference:
+            return valueHeader.storedSize == 0;
+    }
+    return false;
+}
+
+// Returns whether an entry stores a value which other entries can reference, and the hash of the
+// value
+bool storesValue(const uint8_t* entryBuffer, uint32_t* outValueHash) {
+    const android::MultifileHeader* header =
+            reinterpret_cast<const android::MultifileHeader*>(entryBuffer);
+    if (header->magic != kMultifileValueMagic) {
+        return false;
+    }
+    android::MultifileValueHeader valueHeader = getValueHeader(entryBuffer);
+    *outValueHash = valueHeader.valueHash;
+    return valueHeader.storage != android::MultifileValueStorage::Reference;
+}
+
+// Returns whether a mapped entry has a good header and CRC
+bool isValidEntry(const uint8_t* entryBuffer, size_t entrySize) {
+    if (entrySize < sizeof(android::MultifileHeader) || !hasValidLayout(entryBuffer, entrySize)) {
+        return false;
+    }
+    const android::MultifileHeader* header =
+            reinterpret_cast<const android::MultifileHeader*>(entryBuffer);
+    return header->crc ==
+            android::crc32c(entryBuffer + sizeof(android::MultifileHeader),
+                            entrySize - sizeof(android::MultifileHeader));
+}
+
 } // namespace
 
 namespace android {
 
 MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize,
-                                       const std::string& baseDir)
+                                       const std::string& baseDir, size_t workerCount,
+                                       bool compressValues)
       : mInitialized(false),
+        mChangesSinceIndexWrite(0),
         mMaxKeySize(maxKeySize),
         mMaxValueSize(maxValueSize),
         mMaxTotalSize(maxTotalSize),
         mTotalCacheSize(0),
         mHotCacheLimit(0),
         mHotCacheSize(0),
-        mWorkerThreadIdle(true) {
+        mCompressValues(compressValues),
+        mWorkers(std::max<size_t>(workerCount, 1)) {
     if (baseDir.empty()) {
         ALOGV("INIT: no baseDir provided in MultifileBlobCache constructor, returning early.");
         return;
@@ -79,6 +156,7 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
 
     // Establish the name of our multifile directory
     mMultifileDirName = baseDir + ".multifile";
+    mIndexFileName = baseDir + ".multifile_index";
 
     // Set the hotcache limit to be large enough to contain one max entry
     // This ensure the hot cache is always large enough for single entry
@@ -90,12 +168,19 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
     // Initialize our cache with the contents of the directory
     mTotalCacheSize = 0;
 
-    // Create the worker thread
-    mTaskThread = std::thread(&MultifileBlobCache::processTasks, this);
+    // Create the worker threads
+    for (MultifileWorker& worker : mWorkers) {
+        worker.thread = std::thread(&MultifileBlobCache::processTasks, this, &worker);
+    }
 
     // See if the dir exists, and initialize using its contents
     struct stat st;
     if (stat(mMultifileDirName.c_str(), &st) == 0) {
+        // The entries of the index are only tracked if their file is still present, and they are
+        // checked when they are first loaded. The other files are read and checked now.
+        std::unordered_map<uint32_t, MultifileIndexEntry> indexEntries = readIndex();
+        std::vector<MultifileIndexEntry> preloadEntries;
+
         // Read all the files and gather details, then preload their contents
         DIR* dir;
         struct dirent* entry;
@@ -111,8 +196,26 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                 // The filename is the same as the entryHash
                 uint32_t entryHash = static_cast<uint32_t>(strtoul(entry->d_name, nullptr, 10));
 
+                auto indexEntry = indexEntries.find(entryHash);
+                if (indexEntry != indexEntries.end()) {
+                    ALOGV("INIT: Entry %u is in the index, tracking it now.", entryHash);
+                    const MultifileIndexEntry& stats = indexEntry->second;
+                    trackEntry(entryHash, stats.valueSize, stats.fileSize, stats.accessTime,
+                               stats.valueHash);
+                    if (stats.valueHash != 0) {
+                        mValueOwners[stats.valueHash] = entryHash;
+                    }
+                    increaseTotalCacheSize(stats.fileSize);
+                    mUncheckedEntries.insert(entryHash);
+                    preloadEntries.push_back(stats);
+                    continue;
+                }
+
                 ALOGV("INIT: Checking entry %u", entryHash);
 
+                // The index has to be written again to list this entry
+                mChangesSinceIndexWrite++;
+
                 // Look up the details of the file
                 struct stat st;
                 if (stat(fullPath.c_str(), &st) != 0) {
@@ -147,7 +250,7 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                 }
 
                 // Verify header magic
-                if (header.magic != kMultifileMagic) {
+                if (header.magic != kMultifileMagic && header.magic != kMultifileValueMagic) {
                     ALOGE("INIT: Entry %u has bad magic (%u)! Removing.", entryHash, header.magic);
                     if (remove(fullPath.c_str()) != 0) {
                         ALOGE("Error removing %s: %s", fullPath.c_str(), std::strerror(errno));
@@ -178,7 +281,7 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                 }
 
                 // If the cache entry is damaged or no good, remove it
-                if (header.keySize <= 0 || header.valueSize <= 0) {
+                if (!hasValidLayout(mappedEntry, fileSize)) {
                     ALOGE("INIT: Entry %u has a bad header keySize (%lu) or valueSize (%lu), "
                           "removing.",
                           entryHash, header.keySize, header.valueSize);
@@ -191,7 +294,13 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                 ALOGV("INIT: Entry %u is good, tracking it now.", entryHash);
 
                 // Track details for rapid lookup later
-                trackEntry(entryHash, header.valueSize, fileSize, st.st_atime);
+                uint32_t valueHash = 0;
+                if (storesValue(mappedEntry, &valueHash)) {
+                    mValueOwners[valueHash] = entryHash;
+                } else {
+                    valueHash = 0;
+                }
+                trackEntry(entryHash, header.valueSize, fileSize, st.st_atime, valueHash);
 
                 // Track the total size
                 increaseTotalCacheSize(fileSize);
@@ -219,6 +328,14 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
         } else {
             ALOGE("Unable to open filename: %s", mMultifileDirName.c_str());
         }
+
+        // Entries of the index which no longer have a file
+        if (preloadEntries.size() != indexEntries.size()) {
+            mChangesSinceIndexWrite++;
+        }
+
+        // Map the entries of the index in the background, instead of before the first use
+        queuePreload(std::move(preloadEntries));
     } else {
         // If the multifile directory does not exist, create it and start from scratch
         if (mkdir(mMultifileDirName.c_str(), 0755) != 0 && (errno != EEXIST)) {
@@ -234,17 +351,26 @@ MultifileBlobCache::~MultifileBlobCache() {
         return;
     }
 
-    // Inform the worker thread we're done
-    ALOGV("DESCTRUCTOR: Shutting down worker thread");
-    DeferredTask task(TaskCommand::Exit);
-    queueTask(std::move(task));
+    // Keep the index up to date for the next instance of the cache
+    queueWriteIndex();
+
+    // Inform the worker threads we're done
+    ALOGV("DESCTRUCTOR: Shutting down worker threads");
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        DeferredTask task(TaskCommand::Exit);
+        queueTask(std::move(task), i);
+    }
 
-    // Wait for it to complete
-    ALOGV("DESCTRUCTOR: Waiting for worker thread to complete");
+    // Wait for them to complete
+    ALOGV("DESCTRUCTOR: Waiting for worker threads to complete");
     waitForWorkComplete();
-    if (mTaskThread.joinable()) {
-        mTaskThread.join();
+    for (MultifileWorker& worker : mWorkers) {
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
     }
+
+    freePreloadedEntries();
 }
 
 // Set will add the entry to hot cache and start a deferred process to write it to disk
@@ -264,7 +390,8 @@ void MultifileBlobCache::set(const void* key, EGLsizeiANDROID keySize, const voi
     // Generate a hash of the key and use it to track this entry
     uint32_t entryHash = android::JenkinsHashMixBytes(0, static_cast<const uint8_t*>(key), keySize);
 
-    size_t fileSize = sizeof(MultifileHeader) + keySize + valueSize;
+    // This is the largest the entry can be
+    size_t fileSize = sizeof(MultifileHeader) + keySize + sizeof(MultifileValueHeader) + valueSize;
 
     // If we're going to be over the cache limit, kick off a trim to clear space
     if (getTotalSize() + fileSize > mMaxTotalSize) {
@@ -274,22 +401,61 @@ void MultifileBlobCache::set(const void* key, EGLsizeiANDROID keySize, const voi
 
     ALOGV("SET: Add %u to cache", entryHash);
 
-    uint8_t* buffer = new uint8_t[fileSize];
+    // Reference the entry which already stores this value if there is one, otherwise store the
+    // value, compressed if that makes it smaller
+    uint32_t valueHash =
+            android::JenkinsHashMixBytes(0, static_cast<const uint8_t*>(value), valueSize);
+    MultifileValueHeader valueHeader = {valueHash, MultifileValueStorage::Raw, 0,
+                                        static_cast<uint32_t>(valueSize)};
+    uint32_t ownerHash = findValueOwner(valueHash, value, valueSize);
+    size_t storedSizeLimit = valueSize;
+    if (ownerHash != 0 && ownerHash != entryHash) {
+        ALOGV("SET: Referencing entry %u with the same value", ownerHash);
+        valueHeader.storage = MultifileValueStorage::Reference;
+        valueHeader.referencedEntryHash = ownerHash;
+        valueHeader.storedSize = 0;
+        storedSizeLimit = 0;
+    } else if (mCompressValues) {
+        storedSizeLimit = std::max<size_t>(valueSize, LZ4_compressBound(valueSize));
+    }
+
+    const size_t valueOffset = sizeof(MultifileHeader) + keySize + sizeof(MultifileValueHeader);
+    uint8_t* buffer = new uint8_t[valueOffset + storedSizeLimit];
+    if (valueHeader.storage == MultifileValueStorage::Raw && mCompressValues) {
+        int compressedSize = LZ4_compress_default(static_cast<const char*>(value),
+                                                  reinterpret_cast<char*>(buffer + valueOffset),
+                                                  static_cast<int>(valueSize),
+                                                  static_cast<int>(storedSizeLimit));
+        if (compressedSize > 0 && compressedSize < valueSize) {
+            valueHeader.storage = MultifileValueStorage::Lz4;
+            valueHeader.storedSize = compressedSize;
+        }
+    }
+    if (valueHeader.storage == MultifileValueStorage::Raw) {
+        memcpy(static_cast<void*>(buffer + valueOffset), static_cast<const void*>(value),
+               valueSize);
+    }
+    fileSize = valueOffset + valueHeader.storedSize;
 
     // Write placeholders for magic and CRC until deferred thread completes the write
-    android::MultifileHeader header = {kMultifileMagic, kCrcPlaceholder, keySize, valueSize};
+    android::MultifileHeader header = {kMultifileValueMagic, kCrcPlaceholder, keySize, valueSize};
     memcpy(static_cast<void*>(buffer), static_cast<const void*>(&header),
            sizeof(android::MultifileHeader));
-    // Write the key and value after the header
+    // Write the key and the description of the value after the header
     memcpy(static_cast<void*>(buffer + sizeof(MultifileHeader)), static_cast<const void*>(key),
            keySize);
     memcpy(static_cast<void*>(buffer + sizeof(MultifileHeader) + keySize),
-           static_cast<const void*>(value), valueSize);
+           static_cast<const void*>(&valueHeader), sizeof(MultifileValueHeader));
 
     std::string fullPath = mMultifileDirName + "/" + std::to_string(entryHash);
 
     // Track the size and access time for quick recall
-    trackEntry(entryHash, valueSize, fileSize, time(0));
+    const bool ownsValue = valueHeader.storage != MultifileValueStorage::Reference;
+    trackEntry(entryHash, valueSize, fileSize, time(0), ownsValue ? valueHash : 0);
+    mUncheckedEntries.erase(entryHash);
+    if (ownsValue) {
+        mValueOwners[valueHash] = entryHash;
+    }
 
     // Update the overall cache size
     increaseTotalCacheSize(fileSize);
@@ -312,11 +478,16 @@ void MultifileBlobCache::set(const void* key, EGLsizeiANDROID keySize, const voi
         mDeferredWrites.insert(std::make_pair(entryHash, buffer));
     }
 
-    // Create deferred task to write to storage
+    // Create deferred task to write to storage, always on the same worker for an entry so that
+    // its writes stay in order
     ALOGV("SET: Adding task to queue.");
     DeferredTask task(TaskCommand::WriteToDisk);
     task.initWriteToDisk(entryHash, fullPath, buffer, fileSize);
-    queueTask(std::move(task));
+    queueTask(std::move(task), entryHash % mWorkers.size());
+
+    if (++mChangesSinceIndexWrite >= kIndexWriteInterval) {
+        queueWriteIndex();
+    }
 }
 
 // Get will check the hot cache, then load it from disk if needed
@@ -365,15 +536,53 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
         return 0;
     }
 
+    uint8_t* cacheEntry = loadEntry(entryHash);
+    if (cacheEntry == nullptr) {
+        return 0;
+    }
+
+    // Ensure the header matches
+    MultifileHeader* header = reinterpret_cast<MultifileHeader*>(cacheEntry);
+    if (header->keySize != keySize || header->valueSize != valueSize) {
+        ALOGW("Mismatch on keySize(%ld vs. cached %ld) or valueSize(%ld vs. cached %ld) compared "
+              "to cache header values for entry: %u",
+              keySize, header->keySize, valueSize, header->valueSize, entryHash);
+        removeFromHotCache(entryHash);
+        return 0;
+    }
+
+    // Compare the incoming key with our stored version (the beginning of the entry)
+    uint8_t* cachedKey = cacheEntry + sizeof(MultifileHeader);
+    int compare = memcmp(cachedKey, key, keySize);
+    if (compare != 0) {
+        ALOGW("Cached key and new key do not match! This is a hash collision or modified file");
+        removeFromHotCache(entryHash);
+        return 0;
+    }
+
+    // Remaining entry following the key is the value
+    if (!readValue(cacheEntry, value, cachedValueSize)) {
+        ALOGW("GET: Unable to read the value of entry %u, removing it", entryHash);
+        removeEntry(entryHash);
+        return 0;
+    }
+
+    return cachedValueSize;
+}
+
+uint8_t* MultifileBlobCache::loadEntry(uint32_t entryHash) {
+    size_t fileSize = getEntryStats(entryHash).fileSize;
     std::string fullPath = mMultifileDirName + "/" + std::to_string(entryHash);
 
-    // Open the hashed filename path
-    uint8_t* cacheEntry = 0;
+    uint8_t* cacheEntry = nullptr;
 
     // Check hot cache
     if (mHotCache.find(entryHash) != mHotCache.end()) {
         ALOGV("GET: HotCache HIT for entry %u", entryHash);
         cacheEntry = mHotCache[entryHash].entryBuffer;
+    } else if (addPreloadedToHotCache(entryHash)) {
+        ALOGV("GET: Preload HIT for entry %u", entryHash);
+        cacheEntry = mHotCache[entryHash].entryBuffer;
     } else {
         ALOGV("GET: HotCache MISS for entry: %u", entryHash);
 
@@ -395,7 +604,7 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
         if (fd == -1) {
             ALOGE("Cache error - failed to open fullPath: %s, error: %s", fullPath.c_str(),
                   std::strerror(errno));
-            return 0;
+            return nullptr;
         }
 
         // Memory map the file
@@ -404,42 +613,98 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
         if (cacheEntry == MAP_FAILED) {
             ALOGE("Failed to mmap cacheEntry, error: %s", std::strerror(errno));
             close(fd);
-            return 0;
+            return nullptr;
+        }
+
+        // Check the entries of the index the first time they are loaded
+        if (mUncheckedEntries.erase(entryHash) != 0 && !isValidEntry(cacheEntry, fileSize)) {
+            ALOGE("GET: Entry %u from the index failed its checks! Removing.", entryHash);
+            munmap(cacheEntry, fileSize);
+            close(fd);
+            removeEntry(entryHash);
+            return nullptr;
         }
 
         ALOGV("GET: Adding %u to hot cache", entryHash);
         if (!addToHotCache(entryHash, fd, cacheEntry, fileSize)) {
             ALOGE("GET: Failed to add %u to hot cache", entryHash);
-            return 0;
+            return nullptr;
         }
 
         cacheEntry = mHotCache[entryHash].entryBuffer;
     }
 
-    // Ensure the header matches
-    MultifileHeader* header = reinterpret_cast<MultifileHeader*>(cacheEntry);
-    if (header->keySize != keySize || header->valueSize != valueSize) {
-        ALOGW("Mismatch on keySize(%ld vs. cached %ld) or valueSize(%ld vs. cached %ld) compared "
-              "to cache header values for fullPath: %s",
-              keySize, header->keySize, valueSize, header->valueSize, fullPath.c_str());
-        removeFromHotCache(entryHash);
-        return 0;
+    return cacheEntry;
+}
+
+bool MultifileBlobCache::readValue(const uint8_t* entryBuffer, void* value,
+                                   EGLsizeiANDROID valueSize) {
+    const MultifileHeader* header = reinterpret_cast<const MultifileHeader*>(entryBuffer);
+    const uint8_t* storedValue = entryBuffer + sizeof(MultifileHeader) + header->keySize;
+    if (header->magic == kMultifileMagic) {
+        memcpy(value, storedValue, valueSize);
+        return true;
     }
 
-    // Compare the incoming key with our stored version (the beginning of the entry)
-    uint8_t* cachedKey = cacheEntry + sizeof(MultifileHeader);
-    int compare = memcmp(cachedKey, key, keySize);
-    if (compare != 0) {
-        ALOGW("Cached key and new key do not match! This is a hash collision or modified file");
-        removeFromHotCache(entryHash);
-        return 0;
+    MultifileValueHeader valueHeader = getValueHeader(entryBuffer);
+    storedValue += sizeof(MultifileValueHeader);
+    switch (valueHeader.storage) {
+        case MultifileValueStorage::Raw: {
+            memcpy(value, storedValue, valueSize);
+            return true;
+        }
+        case MultifileValueStorage::Lz4: {
+            return LZ4_decompress_safe(reinterpret_cast<const char*>(storedValue),
+                                       static_cast<char*>(value), valueHeader.storedSize,
+                                       static_cast<int>(valueSize)) == valueSize;
+        }
+        case MultifileValueStorage::Reference: {
+            // The referenced entry may have been replaced or removed since
+            uint32_t ownerHash = valueHeader.referencedEntryHash;
+            if (!contains(ownerHash) ||
+                getEntryStats(ownerHash).valueHash != valueHeader.valueHash ||
+                getEntryStats(ownerHash).valueSize != valueSize) {
+                return false;
+            }
+            // Loading the referenced entry can evict this one from the hot cache
+            const uint8_t* ownerBuffer = loadEntry(ownerHash);
+            uint32_t ownerValueHash;
+            if (ownerBuffer == nullptr || !storesValue(ownerBuffer, &ownerValueHash) ||
+                ownerValueHash != valueHeader.valueHash) {
+                return false;
+            }
+            return readValue(ownerBuffer, value, valueSize);
+        }
     }
+    return false;
+}
 
-    // Remaining entry following the key is the value
-    uint8_t* cachedValue = cacheEntry + (keySize + sizeof(MultifileHeader));
-    memcpy(value, cachedValue, cachedValueSize);
+uint32_t MultifileBlobCache::findValueOwner(uint32_t valueHash, const void* value,
+                                            EGLsizeiANDROID valueSize) {
+    auto owner = mValueOwners.find(valueHash);
+    if (owner == mValueOwners.end()) {
+        return 0;
+    }
+    uint32_t ownerHash = owner->second;
+    if (!contains(ownerHash) || getEntryStats(ownerHash).valueHash != valueHash ||
+        getEntryStats(ownerHash).valueSize != valueSize) {
+        mValueOwners.erase(owner);
+        return 0;
+    }
 
-    return cachedValueSize;
+    // Compare the values, as different values can have the same hash
+    const uint8_t* ownerBuffer = loadEntry(ownerHash);
+    uint32_t ownerValueHash;
+    if (ownerBuffer == nullptr || !storesValue(ownerBuffer, &ownerValueHash) ||
+        ownerValueHash != valueHash) {
+        return 0;
+    }
+    std::unique_ptr<uint8_t[]> ownerValue(new uint8_t[valueSize]);
+    if (!readValue(ownerBuffer, ownerValue.get(), valueSize) ||
+        memcmp(ownerValue.get(), value, valueSize) != 0) {
+        return 0;
+    }
+    return ownerHash;
 }
 
 void MultifileBlobCache::finish() {
@@ -447,10 +712,15 @@ void MultifileBlobCache::finish() {
         return;
     }
 
+    // Keep the index up to date for the next instance of the cache
+    queueWriteIndex();
+
     // Wait for all deferred writes to complete
     ALOGV("FINISH: Waiting for work to complete.");
     waitForWorkComplete();
 
+    freePreloadedEntries();
+
     // Close all entries in the hot cache
     for (auto hotCacheIter = mHotCache.begin(); hotCacheIter != mHotCache.end();) {
         uint32_t entryHash = hotCacheIter->first;
@@ -464,9 +734,30 @@ void MultifileBlobCache::finish() {
 }
 
 void MultifileBlobCache::trackEntry(uint32_t entryHash, EGLsizeiANDROID valueSize, size_t fileSize,
-                                    time_t accessTime) {
+                                    time_t accessTime, uint32_t valueHash) {
     mEntries.insert(entryHash);
-    mEntryStats[entryHash] = {valueSize, fileSize, accessTime};
+    mEntryStats[entryHash] = {valueSize, fileSize, accessTime, valueHash};
+}
+
+bool MultifileBlobCache::removeEntry(uint32_t entryHash) {
+    if (!contains(entryHash)) {
+        return false;
+    }
+
+    // Remove it from hot cache if present, which waits for its pending writes
+    removeFromHotCache(entryHash);
+
+    std::string entryPath = mMultifileDirName + "/" + std::to_string(entryHash);
+    if (remove(entryPath.c_str()) != 0) {
+        ALOGE("Error removing %s: %s", entryPath.c_str(), std::strerror(errno));
+    }
+
+    decreaseTotalCacheSize(getEntryStats(entryHash).fileSize);
+    mEntries.erase(entryHash);
+    mEntryStats.erase(entryHash);
+    mUncheckedEntries.erase(entryHash);
+    mChangesSinceIndexWrite++;
+    return true;
 }
 
 bool MultifileBlobCache::contains(uint32_t hashEntry) const {
@@ -576,6 +867,9 @@ bool MultifileBlobCache::applyLRU(size_t cacheLimit) {
         cacheEntryIter++;
 
         // Delete the entry from our tracking
+        mEntries.erase(entryHash);
+        mUncheckedEntries.erase(entryHash);
+        mChangesSinceIndexWrite++;
         size_t count = mEntryStats.erase(entryHash);
         if (count != 1) {
             ALOGE("LRU: Failed to remove entryHash (%u) from mEntryStats", entryHash);
@@ -612,8 +906,185 @@ void MultifileBlobCache::trimCache() {
     }
 }
 
-// This function performs a task.  It only knows how to write files to disk,
-// but it could be expanded if needed.
+std::unordered_map<uint32_t, MultifileIndexEntry> MultifileBlobCache::readIndex() {
+    std::unordered_map<uint32_t, MultifileIndexEntry> indexEntries;
+
+    int fd = open(mIndexFileName.c_str(), O_RDONLY);
+    if (fd == -1) {
+        ALOGV("INIT: No index at %s", mIndexFileName.c_str());
+        return indexEntries;
+    }
+
+    MultifileIndexHeader header;
+    std::vector<MultifileIndexEntry> entries;
+    bool valid = read(fd, &header, sizeof(header)) == sizeof(header) &&
+            header.magic == kMultifileIndexMagic &&
+            header.entryCount <= mMaxTotalSize / sizeof(MultifileHeader);
+    if (valid) {
+        entries.resize(header.entryCount);
+        const size_t entriesSize = entries.size() * sizeof(MultifileIndexEntry);
+        valid = read(fd, entries.data(), entriesSize) == static_cast<ssize_t>(entriesSize) &&
+                header.crc == crc32c(reinterpret_cast<uint8_t*>(entries.data()), entriesSize);
+    }
+    close(fd);
+
+    if (!valid) {
+        ALOGE("INIT: Index %s is damaged, checking all the entries", mIndexFileName.c_str());
+        return indexEntries;
+    }
+
+    for (const MultifileIndexEntry& entry : entries) {
+        indexEntries[entry.entryHash] = entry;
+    }
+    return indexEntries;
+}
+
+void MultifileBlobCache::queueWriteIndex() {
+    if (mChangesSinceIndexWrite == 0) {
+        return;
+    }
+    mChangesSinceIndexWrite = 0;
+
+    std::vector<MultifileIndexEntry> indexEntries;
+    indexEntries.reserve(mEntryStats.size());
+    for (const auto& [entryHash, stats] : mEntryStats) {
+        indexEntries.push_back(
+                {entryHash, stats.valueSize, stats.fileSize, stats.accessTime, stats.valueHash});
+    }
+
+    DeferredTask task(TaskCommand::WriteIndex);
+    task.initWriteIndex(mIndexFileName, std::move(indexEntries));
+    queueTask(std::move(task), 0);
+}
+
+// The index is only a hint: an entry of the index is only tracked if its file is present, and it
+// is checked when it is loaded. So it can be written while the writes of the entries are pending.
+void MultifileBlobCache::writeIndex(const std::string& fullPath,
+                                    const std::vector<MultifileIndexEntry>& entries) {
+    const size_t entriesSize = entries.size() * sizeof(MultifileIndexEntry);
+    MultifileIndexHeader header = {kMultifileIndexMagic,
+                                   crc32c(reinterpret_cast<const uint8_t*>(entries.data()),
+                                          entriesSize),
+                                   static_cast<uint32_t>(entries.size())};
+
+    // Write a temporary file and rename it, so that the index is never partially written
+    std::string tempPath = fullPath + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        ALOGE("Cache error - failed to open index: %s, error: %s", tempPath.c_str(),
+              std::strerror(errno));
+        return;
+    }
+    bool written = write(fd, &header, sizeof(header)) == sizeof(header) &&
+            write(fd, entries.data(), entriesSize) == static_cast<ssize_t>(entriesSize);
+    close(fd);
+
+    if (!written || rename(tempPath.c_str(), fullPath.c_str()) != 0) {
+        ALOGE("Error writing index (%s): %s", fullPath.c_str(), std::strerror(errno));
+        remove(tempPath.c_str());
+        return;
+    }
+    ALOGV("DEFERRED: Wrote index of %zu entries", entries.size());
+}
+
+void MultifileBlobCache::queuePreload(std::vector<MultifileIndexEntry> indexEntries) {
+    // Preload the most recently used entries which fit in the hot cache
+    std::sort(indexEntries.begin(), indexEntries.end(),
+              [](const MultifileIndexEntry& lhs, const MultifileIndexEntry& rhs) {
+                  return lhs.accessTime > rhs.accessTime;
+              });
+    std::vector<std::vector<MultifileIndexEntry>> workerEntries(mWorkers.size());
+    size_t preloadSize = mHotCacheSize;
+    for (const MultifileIndexEntry& entry : indexEntries) {
+        if (preloadSize + entry.fileSize >= mHotCacheLimit) {
+            break;
+        }
+        preloadSize += entry.fileSize;
+        workerEntries[entry.entryHash % mWorkers.size()].push_back(entry);
+    }
+
+    // Spread them over the workers, so that they are read in parallel
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        if (workerEntries[i].empty()) {
+            continue;
+        }
+        DeferredTask task(TaskCommand::Preload);
+        task.initPreload(std::move(workerEntries[i]));
+        queueTask(std::move(task), i);
+    }
+}
+
+void MultifileBlobCache::preload(const std::vector<MultifileIndexEntry>& indexEntries) {
+    for (const MultifileIndexEntry& entry : indexEntries) {
+        std::string fullPath = mMultifileDirName + "/" + std::to_string(entry.entryHash);
+        int fd = open(fullPath.c_str(), O_RDONLY);
+        if (fd == -1) {
+            continue;
+        }
+
+        uint8_t* mappedEntry = reinterpret_cast<uint8_t*>(
+                mmap(nullptr, entry.fileSize, PROT_READ, MAP_PRIVATE, fd, 0));
+        if (mappedEntry == MAP_FAILED) {
+            close(fd);
+            continue;
+        }
+
+        // A damaged entry is left for the main thread to find and remove when it loads it
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != entry.fileSize ||
+            !isValidEntry(mappedEntry, entry.fileSize)) {
+            munmap(mappedEntry, entry.fileSize);
+            close(fd);
+            continue;
+        }
+
+        ALOGV("DEFERRED: Preloaded entry %u", entry.entryHash);
+        MultifileHotCache preloaded = {fd, mappedEntry, entry.fileSize};
+        std::lock_guard<std::mutex> lock(mPreloadMutex);
+        auto [it, inserted] = mPreloadedEntries.try_emplace(entry.entryHash, preloaded);
+        if (!inserted) {
+            freeHotCacheEntry(preloaded);
+        }
+    }
+}
+
+bool MultifileBlobCache::addPreloadedToHotCache(uint32_t entryHash) {
+    MultifileHotCache preloaded;
+    {
+        std::lock_guard<std::mutex> lock(mPreloadMutex);
+        auto it = mPreloadedEntries.find(entryHash);
+        if (it == mPreloadedEntries.end()) {
+            return false;
+        }
+        preloaded = it->second;
+        mPreloadedEntries.erase(it);
+    }
+
+    // The preloaded contents are only still current if the entry was not set since the cache was
+    // initialized
+    if (mUncheckedEntries.erase(entryHash) == 0) {
+        freeHotCacheEntry(preloaded);
+        return false;
+    }
+
+    if (!addToHotCache(entryHash, preloaded.entryFd, preloaded.entryBuffer, preloaded.entrySize)) {
+        ALOGE("GET: Failed to add preloaded %u to hot cache", entryHash);
+        freeHotCacheEntry(preloaded);
+        return false;
+    }
+    return true;
+}
+
+void MultifileBlobCache::freePreloadedEntries() {
+    std::lock_guard<std::mutex> lock(mPreloadMutex);
+    for (auto& [entryHash, entry] : mPreloadedEntries) {
+        freeHotCacheEntry(entry);
+    }
+    mPreloadedEntries.clear();
+}
+
+// This function performs a task: writing the entries and the index to disk, or preloading
+// entries.
 void MultifileBlobCache::processTask(DeferredTask& task) {
     switch (task.getTaskCommand()) {
         case TaskCommand::Exit: {
@@ -670,6 +1141,14 @@ void MultifileBlobCache::processTask(DeferredTask& task) {
 
             return;
         }
+        case TaskCommand::WriteIndex: {
+            writeIndex(task.getFullPath(), task.getIndexEntries());
+            return;
+        }
+        case TaskCommand::Preload: {
+            preload(task.getIndexEntries());
+            return;
+        }
         default: {
             ALOGE("DEFERRED: Unhandled task type");
             return;
@@ -677,59 +1156,61 @@ void MultifileBlobCache::processTask(DeferredTask& task) {
     }
 }
 
-// This function will wait until tasks arrive, then execute them
+// This function will wait until tasks arrive, then execute them. All the tasks queued meanwhile
+// are taken at once, so that the lock is not taken for each of them.
 // If the exit command is submitted, the loop will terminate
-void MultifileBlobCache::processTasksImpl(bool* exitThread) {
+void MultifileBlobCache::processTasks(MultifileWorker* worker) {
+    std::queue<DeferredTask> tasks;
     while (true) {
-        std::unique_lock<std::mutex> lock(mWorkerMutex);
-        if (mTasks.empty()) {
-            ALOGV("WORKER: No tasks available, waiting");
-            mWorkerThreadIdle = true;
-            mWorkerIdleCondition.notify_all();
-            // Only wake if notified and command queue is not empty
-            mWorkAvailableCondition.wait(lock, [this] { return !mTasks.empty(); });
-        }
-
-        ALOGV("WORKER: Task available, waking up.");
-        mWorkerThreadIdle = false;
-        DeferredTask task = std::move(mTasks.front());
-        mTasks.pop();
-
-        if (task.getTaskCommand() == TaskCommand::Exit) {
-            ALOGV("WORKER: Exiting work loop.");
-            *exitThread = true;
-            mWorkerThreadIdle = true;
-            mWorkerIdleCondition.notify_one();
-            return;
+        {
+            std::unique_lock<std::mutex> lock(mWorkerMutex);
+            if (worker->tasks.empty()) {
+                ALOGV("WORKER: No tasks available, waiting");
+                worker->idle = true;
+                mWorkerIdleCondition.notify_all();
+                // Only wake if notified and command queue is not empty
+                worker->workAvailableCondition.wait(lock,
+                                                    [worker] { return !worker->tasks.empty(); });
+            }
+
+            ALOGV("WORKER: Tasks available, waking up.");
+            worker->idle = false;
+            std::swap(tasks, worker->tasks);
         }
 
-        lock.unlock();
-        processTask(task);
-    }
-}
+        while (!tasks.empty()) {
+            DeferredTask task = std::move(tasks.front());
+            tasks.pop();
 
-// Process tasks until the exit task is submitted
-void MultifileBlobCache::processTasks() {
-    while (true) {
-        bool exitThread = false;
-        processTasksImpl(&exitThread);
-        if (exitThread) {
-            break;
+            if (task.getTaskCommand() == TaskCommand::Exit) {
+                ALOGV("WORKER: Exiting work loop.");
+                std::lock_guard<std::mutex> lock(mWorkerMutex);
+                worker->idle = true;
+                mWorkerIdleCondition.notify_all();
+                return;
+            }
+
+            processTask(task);
         }
     }
 }
 
-// Add a task to the queue to be processed by the worker thread
-void MultifileBlobCache::queueTask(DeferredTask&& task) {
+// Add a task to the queue to be processed by a worker thread
+void MultifileBlobCache::queueTask(DeferredTask&& task, size_t workerIndex) {
     std::lock_guard<std::mutex> queueLock(mWorkerMutex);
-    mTasks.emplace(std::move(task));
-    mWorkAvailableCondition.notify_one();
+    MultifileWorker& worker = mWorkers[workerIndex];
+    worker.tasks.emplace(std::move(task));
+    worker.workAvailableCondition.notify_one();
 }
 
 // Wait until all tasks have been completed
 void MultifileBlobCache::waitForWorkComplete() {
     std::unique_lock<std::mutex> lock(mWorkerMutex);
-    mWorkerIdleCondition.wait(lock, [this] { return (mTasks.empty() && mWorkerThreadIdle); });
+    mWorkerIdleCondition.wait(lock, [this] {
+        return std::all_of(mWorkers.begin(), mWorkers.end(), [](const MultifileWorker& worker) {
+            return worker.tasks.empty() && worker.idle;
+        });
+    });
 }
 
 }; // namespace android
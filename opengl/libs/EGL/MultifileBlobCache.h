@@ -28,6 +28,7 @@
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "FileBlobCache.h"
 
@@ -40,10 +41,47 @@ struct MultifileHeader {
     EGLsizeiANDROID valueSize;
 };
 
+// How the value of an entry is stored after its key
+enum class MultifileValueStorage : uint32_t {
+    Raw = 0,
+    Lz4,
+    // The value is stored by another entry, which is referenced instead
+    Reference,
+};
+
+// Follows the key of the entries written with kMultifileValueMagic, and precedes the stored value
+struct MultifileValueHeader {
+    // The hash of the uncompressed value, which finds the entries with the same value
+    uint32_t valueHash;
+    MultifileValueStorage storage;
+    // The entry storing the value, for a Reference
+    uint32_t referencedEntryHash;
+    uint32_t storedSize;
+};
+
 struct MultifileEntryStats {
     EGLsizeiANDROID valueSize;
     size_t fileSize;
     time_t accessTime;
+    // The hash of the value stored by the entry, or 0 if it does not store a value which other
+    // entries can reference
+    uint32_t valueHash;
+};
+
+// The index of the entries of the cache, which is written next to the multifile directory so that
+// the entries it lists do not have to be read again when the cache is initialized.
+struct MultifileIndexHeader {
+    uint32_t magic;
+    uint32_t crc;
+    uint32_t entryCount;
+};
+
+struct MultifileIndexEntry {
+    uint32_t entryHash;
+    EGLsizeiANDROID valueSize;
+    size_t fileSize;
+    time_t accessTime;
+    uint32_t valueHash;
 };
 
 struct MultifileHotCache {
@@ -55,6 +93,8 @@ struct MultifileHotCache {
 enum class TaskCommand {
     Invalid = 0,
     WriteToDisk,
+    WriteIndex,
+    Preload,
     Exit,
 };
 
@@ -74,10 +114,22 @@ public:
         mBufferSize = bufferSize;
     }
 
+    void initWriteIndex(std::string fullPath, std::vector<MultifileIndexEntry> indexEntries) {
+        mCommand = TaskCommand::WriteIndex;
+        mFullPath = std::move(fullPath);
+        mIndexEntries = std::move(indexEntries);
+    }
+
+    void initPreload(std::vector<MultifileIndexEntry> indexEntries) {
+        mCommand = TaskCommand::Preload;
+        mIndexEntries = std::move(indexEntries);
+    }
+
     uint32_t getEntryHash() { return mEntryHash; }
     std::string& getFullPath() { return mFullPath; }
     uint8_t* getBuffer() { return mBuffer; }
     size_t getBufferSize() { return mBufferSize; };
+    std::vector<MultifileIndexEntry>& getIndexEntries() { return mIndexEntries; }
 
 private:
     TaskCommand mCommand;
@@ -87,12 +139,32 @@ private:
     std::string mFullPath;
     uint8_t* mBuffer;
     size_t mBufferSize;
+
+    // Parameters for WriteIndex and Preload
+    std::vector<MultifileIndexEntry> mIndexEntries;
+};
+
+// A worker thread with its own queue of tasks
+struct MultifileWorker {
+    std::thread thread;
+    std::queue<DeferredTask> tasks;
+
+    // This condition will block the worker thread until a task is queued
+    std::condition_variable workAvailableCondition;
+
+    // This bool will track whether the worker has completed all of its tasks
+    bool idle = true;
 };
 
 class MultifileBlobCache {
 public:
+    // The writes of the entries are spread over workerCount threads. All the writes of an entry
+    // are done by the same thread, in order. The values are compressed with LZ4 if
+    // compressValues is set. The values which are already stored by another entry are always
+    // stored as references to that entry.
     MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize,
-                       const std::string& baseDir);
+                       const std::string& baseDir, size_t workerCount = 1,
+                       bool compressValues = false);
     ~MultifileBlobCache();
 
     void set(const void* key, EGLsizeiANDROID keySize, const void* value,
@@ -106,7 +178,7 @@ public:
 
 private:
     void trackEntry(uint32_t entryHash, EGLsizeiANDROID valueSize, size_t fileSize,
-                    time_t accessTime);
+                    time_t accessTime, uint32_t valueHash);
     bool contains(uint32_t entryHash) const;
     bool removeEntry(uint32_t entryHash);
     MultifileEntryStats getEntryStats(uint32_t entryHash);
@@ -120,11 +192,44 @@ private:
     bool addToHotCache(uint32_t entryHash, int fd, uint8_t* entryBufer, size_t entrySize);
     bool removeFromHotCache(uint32_t entryHash);
 
+    // Returns the contents of a tracked entry from the hot cache, after loading it from disk if
+    // needed, or nullptr if it could not be loaded. This can evict the other entries from the
+    // hot cache.
+    uint8_t* loadEntry(uint32_t entryHash);
+    // Copies the value of a loaded entry, which has been checked to have a valueSize value, and
+    // returns false if it could not be read.
+    bool readValue(const uint8_t* entryBuffer, void* value, EGLsizeiANDROID valueSize);
+    // Returns the entry which stores this value, and which a new entry can reference, or 0
+    uint32_t findValueOwner(uint32_t valueHash, const void* value, EGLsizeiANDROID valueSize);
+
     void trimCache();
     bool applyLRU(size_t cacheLimit);
 
+    // Reads the index written by a previous instance of the cache, returns an empty map if there
+    // is no valid index.
+    std::unordered_map<uint32_t, MultifileIndexEntry> readIndex();
+    // Queues a task to write the index of the current entries, if they changed since it was last
+    // written.
+    void queueWriteIndex();
+    void writeIndex(const std::string& fullPath, const std::vector<MultifileIndexEntry>& entries);
+
+    // Queues tasks to map and check the most recently used entries in the background, up to the
+    // size of the hot cache.
+    void queuePreload(std::vector<MultifileIndexEntry> indexEntries);
+    void preload(const std::vector<MultifileIndexEntry>& indexEntries);
+    // Moves an entry mapped by the workers to the hot cache. Returns false if it was not mapped.
+    bool addPreloadedToHotCache(uint32_t entryHash);
+    void freePreloadedEntries();
+
     bool mInitialized;
     std::string mMultifileDirName;
+    std::string mIndexFileName;
+
+    // The entries listed by the index when the cache was initialized, which have not been checked
+    // since. They are checked when they are first loaded.
+    std::unordered_set<uint32_t> mUncheckedEntries;
+    // The number of changes to the entries since the index was last written
+    size_t mChangesSinceIndexWrite;
 
     std::unordered_set<uint32_t> mEntries;
     std::unordered_map<uint32_t, MultifileEntryStats> mEntryStats;
@@ -137,6 +242,10 @@ private:
     size_t mHotCacheLimit;
     size_t mHotCacheEntryLimit;
     size_t mHotCacheSize;
+    bool mCompressValues;
+
+    // The entries storing each value, by the hash of the value
+    std::unordered_map<uint32_t, uint32_t> mValueOwners;
 
     // Below are the components used for deferred writes
 
@@ -144,29 +253,26 @@ private:
     std::mutex mDeferredWriteStatusMutex;
     std::multimap<uint32_t, uint8_t*> mDeferredWrites GUARDED_BY(mDeferredWriteStatusMutex);
 
+    // The entries mapped and checked by the workers, until they move to the hot cache
+    std::mutex mPreloadMutex;
+    std::unordered_map<uint32_t, MultifileHotCache> mPreloadedEntries GUARDED_BY(mPreloadMutex);
+
     // Functions to work through tasks in the queue
-    void processTasks();
-    void processTasksImpl(bool* exitThread);
+    void processTasks(MultifileWorker* worker);
     void processTask(DeferredTask& task);
 
-    // Used by main thread to create work for the worker thread
-    void queueTask(DeferredTask&& task);
+    // Used by main thread to create work for a worker thread
+    void queueTask(DeferredTask&& task, size_t workerIndex);
 
-    // Used by main thread to wait for worker thread to complete all outstanding work.
+    // Used by main thread to wait for the worker threads to complete all outstanding work.
     void waitForWorkComplete();
 
-    std::thread mTaskThread;
-    std::queue<DeferredTask> mTasks;
+    // Never resized once the workers are started
+    std::vector<MultifileWorker> mWorkers;
     std::mutex mWorkerMutex;
 
-    // This condition will block the worker thread until a task is queued
-    std::condition_variable mWorkAvailableCondition;
-
-    // This condition will block the main thread while the worker thread still has tasks
+    // This condition will block the main thread while the worker threads still have tasks
     std::condition_variable mWorkerIdleCondition;
-
-    // This bool will track whether all tasks have been completed
-    bool mWorkerThreadIdle;
 };
 
 }; // namespace android
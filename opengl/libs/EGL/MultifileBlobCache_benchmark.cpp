@@ -0,0 +1,109 @@
+/*
+ ** Copyright 2023, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#include <android-base/test_utils.h>
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MultifileBlobCache.h"
+
+namespace android {
+
+constexpr size_t kMaxKeySize = 2 * 1024;
+constexpr size_t kMaxValueSize = 64 * 1024;
+constexpr size_t kMaxTotalSize = 1 * 1024 * 1024;
+
+// The shaders of the simulated app, whose binaries add up to more than the limit of the cache
+constexpr int kShaderCount = 400;
+constexpr size_t kShaderBinarySize = 4 * 1024;
+// Every fourth shader compiles to the same binary as the previous one
+constexpr int kDuplicateInterval = 4;
+
+// Generates a shader binary, which repeats blocks of instructions like the binaries of the
+// drivers, so that it compresses to about half of its size
+std::vector<uint8_t> makeShaderBinary(int shader) {
+    constexpr size_t kBlockSize = 32;
+    std::vector<uint8_t> binary(kShaderBinarySize);
+    uint32_t random = shader + 1;
+    auto next = [&random] {
+        random = random * 1103515245 + 12345;
+        return random >> 16;
+    };
+    for (size_t block = 0; block < binary.size(); block += kBlockSize) {
+        const bool repeat = block > 0 && next() % 2 == 0;
+        const size_t source = repeat ? (next() % (block / kBlockSize)) * kBlockSize : 0;
+        for (size_t i = block; i < block + kBlockSize; i++) {
+            binary[i] = repeat ? binary[source + i - block] : next();
+        }
+    }
+    return binary;
+}
+
+// Launches the app a few times, each time loading its shaders from the cache and compiling the
+// ones which are missing, and reports the fraction of the shaders which were found in the cache.
+static void benchmarkShaderCompileHitRate(benchmark::State& state) {
+    const bool compressValues = state.range(0) != 0;
+    constexpr int kLaunchCount = 3;
+
+    std::vector<std::vector<uint8_t>> binaries;
+    for (int shader = 0; shader < kShaderCount; shader++) {
+        binaries.push_back(shader % kDuplicateInterval == kDuplicateInterval - 1
+                                   ? binaries.back()
+                                   : makeShaderBinary(shader));
+    }
+
+    std::vector<uint8_t> buffer(kShaderBinarySize);
+    int64_t hits = 0;
+    int64_t lookups = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        TemporaryFile tempFile;
+        state.ResumeTiming();
+
+        for (int launch = 0; launch < kLaunchCount; launch++) {
+            MultifileBlobCache cache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, &tempFile.path[0],
+                                     /*workerCount=*/2, compressValues);
+            for (int shader = 0; shader < kShaderCount; shader++) {
+                std::string key = "shader" + std::to_string(shader);
+                lookups++;
+                if (cache.get(key.data(), key.size(), buffer.data(), buffer.size()) ==
+                    static_cast<EGLsizeiANDROID>(binaries[shader].size())) {
+                    hits++;
+                    continue;
+                }
+                // Compile the shader
+                cache.set(key.data(), key.size(), binaries[shader].data(),
+                          binaries[shader].size());
+            }
+            cache.finish();
+        }
+
+        state.PauseTiming();
+        std::string dirName = std::string(&tempFile.path[0]) + ".multifile";
+        std::string command = "rm -rf " + dirName + " " + dirName + "_index";
+        system(command.c_str());
+        state.ResumeTiming();
+    }
+    state.counters["hit_rate"] = lookups > 0 ? static_cast<double>(hits) / lookups : 0;
+}
+BENCHMARK(benchmarkShaderCompileHitRate)->ArgName("compress")->Arg(0)->Arg(1);
+
+} // namespace android
+
+BENCHMARK_MAIN();
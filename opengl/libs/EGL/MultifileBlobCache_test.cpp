@@ -17,11 +17,15 @@
 #include "MultifileBlobCache.h"
 
 #include <android-base/test_utils.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <gtest/gtest.h>
 #include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <memory>
+#include <vector>
 
 namespace android {
 
@@ -216,4 +220,186 @@ TEST_F(MultifileBlobCacheTest, CacheMinKeyAndValueSizeSucceeds) {
     ASSERT_EQ('y', buf[0]);
 }
 
+TEST_F(MultifileBlobCacheTest, EntriesAreLoadedFromTheIndex) {
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->set("ijkl", 4, "mnop", 4);
+    mMBC->finish();
+    mMBC.reset();
+
+    struct stat st;
+    ASSERT_EQ(0, stat((std::string(&mTempFile->path[0]) + ".multifile_index").c_str(), &st));
+
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    ASSERT_EQ(size_t(16 + 2 * (sizeof(MultifileHeader) + sizeof(MultifileValueHeader))),
+              mMBC->getTotalSize());
+    ASSERT_EQ(size_t(4), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ('e', buf[0]);
+    ASSERT_EQ('h', buf[3]);
+    ASSERT_EQ(size_t(4), mMBC->get("ijkl", 4, buf, 4));
+    ASSERT_EQ('m', buf[0]);
+    ASSERT_EQ('p', buf[3]);
+}
+
+TEST_F(MultifileBlobCacheTest, EntriesMissingFromTheIndexAreLoaded) {
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->finish();
+    mMBC.reset();
+
+    // Add an entry without updating the index
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    mMBC->set("ijkl", 4, "mnop", 4);
+    mMBC->finish();
+    mMBC.reset();
+    ASSERT_EQ(0, remove((std::string(&mTempFile->path[0]) + ".multifile_index").c_str()));
+
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    ASSERT_EQ(size_t(4), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ('e', buf[0]);
+    ASSERT_EQ(size_t(4), mMBC->get("ijkl", 4, buf, 4));
+    ASSERT_EQ('m', buf[0]);
+}
+
+TEST_F(MultifileBlobCacheTest, DamagedEntryOfTheIndexIsNotReturned) {
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->finish();
+    mMBC.reset();
+
+    // Corrupt the value of every entry
+    std::string dirName = std::string(&mTempFile->path[0]) + ".multifile";
+    DIR* dir = opendir(dirName.c_str());
+    ASSERT_NE(nullptr, dir);
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        int fd = open((dirName + "/" + entry->d_name).c_str(), O_WRONLY);
+        ASSERT_NE(-1, fd);
+        ASSERT_EQ(1, pwrite(fd, "x", 1, sizeof(MultifileHeader) + 4));
+        close(fd);
+    }
+    closedir(dir);
+
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    ASSERT_EQ(size_t(0), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ(size_t(0), mMBC->getTotalSize());
+}
+
+TEST_F(MultifileBlobCacheTest, CacheWithSeveralWorkersSucceeds) {
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0], /*workerCount=*/4));
+    for (char i = 0; i < 16; i++) {
+        char key[2] = {'k', static_cast<char>('a' + i)};
+        mMBC->set(key, 2, "v1", 2);
+        mMBC->set(key, 2, &key[1], 1);
+    }
+    mMBC->finish();
+    mMBC.reset();
+
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0], /*workerCount=*/4));
+    for (char i = 0; i < 16; i++) {
+        SCOPED_TRACE(i);
+        char key[2] = {'k', static_cast<char>('a' + i)};
+        char value = 0;
+        ASSERT_EQ(size_t(1), mMBC->get(key, 2, &value, 1));
+        ASSERT_EQ(key[1], value);
+    }
+}
+
+TEST_F(MultifileBlobCacheTest, CompressedValuesSucceed) {
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0], /*workerCount=*/1,
+                                      /*compressValues=*/true));
+    std::vector<uint8_t> value(kMaxValueSize);
+    for (size_t i = 0; i < value.size(); i++) {
+        value[i] = i % 16;
+    }
+    mMBC->set("abcd", 4, value.data(), value.size());
+    ASSERT_LT(mMBC->getTotalSize(), value.size() / 2);
+
+    std::vector<uint8_t> buf(kMaxValueSize, 0xee);
+    ASSERT_EQ(value.size(), mMBC->get("abcd", 4, buf.data(), buf.size()));
+    ASSERT_EQ(value, buf);
+
+    // Read it back from disk, through the index and through a scan of the directory
+    for (bool removeIndex : {false, true}) {
+        SCOPED_TRACE(removeIndex);
+        mMBC->finish();
+        mMBC.reset();
+        if (removeIndex) {
+            ASSERT_EQ(0,
+                      remove((std::string(&mTempFile->path[0]) + ".multifile_index").c_str()));
+        }
+        mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                          &mTempFile->path[0]));
+        std::fill(buf.begin(), buf.end(), 0xee);
+        ASSERT_EQ(value.size(), mMBC->get("abcd", 4, buf.data(), buf.size()));
+        ASSERT_EQ(value, buf);
+    }
+}
+
+TEST_F(MultifileBlobCacheTest, IncompressibleValuesAreStoredRaw) {
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0], /*workerCount=*/1,
+                                      /*compressValues=*/true));
+    std::vector<uint8_t> value(1024);
+    uint32_t random = 1;
+    for (uint8_t& byte : value) {
+        random = random * 1103515245 + 12345;
+        byte = random >> 24;
+    }
+    mMBC->set("abcd", 4, value.data(), value.size());
+    ASSERT_EQ(sizeof(MultifileHeader) + 4 + sizeof(MultifileValueHeader) + value.size(),
+              mMBC->getTotalSize());
+
+    std::vector<uint8_t> buf(value.size(), 0xee);
+    ASSERT_EQ(value.size(), mMBC->get("abcd", 4, buf.data(), buf.size()));
+    ASSERT_EQ(value, buf);
+}
+
+TEST_F(MultifileBlobCacheTest, IdenticalValuesAreStoredOnce) {
+    std::vector<uint8_t> value(4 * 1024, 'v');
+    mMBC->set("abcd", 4, value.data(), value.size());
+    mMBC->set("efgh", 4, value.data(), value.size());
+    ASSERT_LT(mMBC->getTotalSize(), value.size() + 256);
+
+    std::vector<uint8_t> buf(value.size(), 0xee);
+    ASSERT_EQ(value.size(), mMBC->get("efgh", 4, buf.data(), buf.size()));
+    ASSERT_EQ(value, buf);
+
+    // The values are still shared after the entries are read back from disk
+    mMBC->finish();
+    mMBC.reset();
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    mMBC->set("ijkl", 4, value.data(), value.size());
+    ASSERT_LT(mMBC->getTotalSize(), value.size() + 256);
+    for (const char* key : {"abcd", "efgh", "ijkl"}) {
+        SCOPED_TRACE(key);
+        std::fill(buf.begin(), buf.end(), 0xee);
+        ASSERT_EQ(value.size(), mMBC->get(key, 4, buf.data(), buf.size()));
+        ASSERT_EQ(value, buf);
+    }
+}
+
+TEST_F(MultifileBlobCacheTest, ReferenceToReplacedValueIsNotReturned) {
+    std::vector<uint8_t> value(1024, 'v');
+    std::vector<uint8_t> otherValue(1024, 'w');
+    mMBC->set("abcd", 4, value.data(), value.size());
+    mMBC->set("efgh", 4, value.data(), value.size());
+    mMBC->set("abcd", 4, otherValue.data(), otherValue.size());
+
+    std::vector<uint8_t> buf(value.size(), 0xee);
+    ASSERT_EQ(size_t(0), mMBC->get("efgh", 4, buf.data(), buf.size()));
+    ASSERT_EQ(otherValue.size(), mMBC->get("abcd", 4, buf.data(), buf.size()));
+    ASSERT_EQ(otherValue, buf);
+}
+
 } // namespace android
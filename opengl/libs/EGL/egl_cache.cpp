@@ -42,6 +42,9 @@ constexpr uint32_t kMaxMultifileKeySize = 1 * 1024 * 1024;
 constexpr uint32_t kMaxMultifileValueSize = 8 * 1024 * 1024;
 constexpr uint32_t kMaxMultifileTotalSize = 32 * 1024 * 1024;
 
+// The number of threads writing the multifile cache entries
+constexpr uint32_t kMultifileWorkerCount = 2;
+
 namespace android {
 
 #define BC_EXT_STR "EGL_ANDROID_blob_cache"
@@ -68,7 +71,11 @@ static EGLsizeiANDROID getBlob(const void* key, EGLsizeiANDROID keySize, void* v
 // egl_cache_t definition
 //
 egl_cache_t::egl_cache_t()
-      : mInitialized(false), mMultifileMode(false), mCacheByteLimit(kMaxMonolithicTotalSize) {}
+      : mInitialized(false),
+        mMultifileMode(false),
+        mCacheByteLimit(kMaxMonolithicTotalSize),
+        mMultifileWorkerCount(kMultifileWorkerCount),
+        mMultifileCompression(true) {}
 
 egl_cache_t::~egl_cache_t() {}
 
@@ -195,6 +202,11 @@ void egl_cache_t::setCacheFilename(const char* filename) {
     mFilename = filename;
 }
 
+std::string egl_cache_t::getCacheFilename() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFilename;
+}
+
 void egl_cache_t::setCacheLimit(int64_t cacheByteLimit) {
     std::lock_guard<std::mutex> lock(mMutex);
 
@@ -262,6 +274,14 @@ void egl_cache_t::updateMode() {
         }
 
         ALOGV("Using multifile EGL blobcache limit of %zu bytes", mCacheByteLimit);
+
+        mMultifileWorkerCount = static_cast<size_t>(
+                base::GetUintProperty<uint32_t>("ro.egl.blobcache.multifile_workers",
+                                                kMultifileWorkerCount));
+
+        // The drivers which compress their binaries can turn off the compression of the values
+        mMultifileCompression =
+                base::GetBoolProperty("ro.egl.blobcache.multifile_compression", true);
     }
 }
 
@@ -277,7 +297,8 @@ MultifileBlobCache* egl_cache_t::getMultifileBlobCacheLocked() {
     if (mMultifileBlobCache == nullptr) {
         mMultifileBlobCache.reset(new MultifileBlobCache(kMaxMultifileKeySize,
                                                          kMaxMultifileValueSize, mCacheByteLimit,
-                                                         mFilename));
+                                                         mFilename, mMultifileWorkerCount,
+                                                         mMultifileCompression));
     }
     return mMultifileBlobCache.get();
 }
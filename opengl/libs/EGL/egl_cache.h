@@ -70,6 +70,10 @@ public:
     // cache contents from one program invocation to another.
     void setCacheFilename(const char* filename);
 
+    // getCacheFilename returns the name set by setCacheFilename, or an empty
+    // string if the cache is not stored on disk.
+    std::string getCacheFilename() const;
+
     // Allow setting monolithic or multifile modes
     void setCacheMode(EGLCacheMode cacheMode);
 
@@ -142,6 +146,12 @@ private:
 
     // Cache limit
     size_t mCacheByteLimit;
+
+    // The number of threads writing the multifile cache entries
+    size_t mMultifileWorkerCount;
+
+    // Whether the multifile cache entries are compressed
+    bool mMultifileCompression;
 };
 
 }; // namespace android
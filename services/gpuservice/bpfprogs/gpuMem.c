@@ -14,13 +14,9 @@
  * limitations under the License.
  */
 
-#include <bpf_helpers.h>
+#include "include/gpumem/gpuMemTotal.h"
 
-/*
- * On Android the number of active processes using gpu is limited.
- * So this is assumed to be true: SUM(num_procs_using_gpu[i]) <= 1024
- */
-#define GPU_MEM_TOTAL_MAP_SIZE 1024
+#include <bpf_helpers.h>
 
 /*
  * This map maintains the global and per process gpu memory total counters.
@@ -29,9 +25,25 @@
  * Use HASH type here since key is not int.
  * Pass AID_GRAPHICS as gid since gpuservice is in the graphics group.
  */
-DEFINE_BPF_MAP_GRO(gpu_mem_total_map, HASH, uint64_t, uint64_t, GPU_MEM_TOTAL_MAP_SIZE,
+DEFINE_BPF_MAP_GRO(gpu_mem_total_map, HASH, uint64_t, uint64_t, kGpuMemTotalMapSize,
                    AID_GRAPHICS);
 
+/*
+ * The changes of |gpu_mem_total_map|, so that gpuservice can keep a copy of the map up to date
+ * without iterating the whole map. Ring buffers need kernel 5.8, so the map and the program that
+ * writes it are only loaded there.
+ *
+ * gpuservice needs write access to consume the ring buffer.
+ */
+DEFINE_BPF_RINGBUF(gpu_mem_total_ringbuf, GpuMemTotalEvent, 64 * 1024, AID_ROOT, AID_GRAPHICS,
+                   0660);
+
+/*
+ * The number of events that did not fit into |gpu_mem_total_ringbuf|. gpuservice reloads its copy
+ * of |gpu_mem_total_map| when it changes.
+ */
+DEFINE_BPF_MAP_GRO(gpu_mem_total_dropped_map, ARRAY, uint32_t, uint64_t, 1, AID_GRAPHICS);
+
 /* This struct aligns with the fields offsets of the raw tracepoint format */
 struct gpu_mem_total_args {
     uint64_t ignore;
@@ -42,32 +54,58 @@ struct gpu_mem_total_args {
 };
 
 /*
- * This program parses the gpu_mem/gpu_mem_total tracepoint's data into
- * {KEY, VAL} pair used to update the corresponding bpf map.
- *
- * Pass AID_GRAPHICS as gid since gpuservice is in the graphics group.
+ * Updates the corresponding bpf map with the new size, and returns whether the map changed.
  * Upon seeing size 0, the corresponding KEY needs to be cleaned up.
  */
-DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_gpu_mem_total)
-(struct gpu_mem_total_args* args) {
-    uint64_t key = 0;
-    uint64_t cur_val = 0;
+static __always_inline int update_gpu_mem_total(uint64_t key, uint64_t cur_val) {
     uint64_t* prev_val = NULL;
 
-    /* The upper 32 bits are for gpu_id while the lower is the pid */
-    key = ((uint64_t)args->gpu_id << 32) | args->pid;
-    cur_val = args->size;
-
     if (!cur_val) {
-        bpf_gpu_mem_total_map_delete_elem(&key);
-        return 0;
+        return !bpf_gpu_mem_total_map_delete_elem(&key);
     }
 
     prev_val = bpf_gpu_mem_total_map_lookup_elem(&key);
     if (prev_val) {
+        if (*prev_val == cur_val) return 0;
         *prev_val = cur_val;
-    } else {
-        bpf_gpu_mem_total_map_update_elem(&key, &cur_val, BPF_NOEXIST);
+        return 1;
+    }
+    return !bpf_gpu_mem_total_map_update_elem(&key, &cur_val, BPF_NOEXIST);
+}
+
+/*
+ * This program parses the gpu_mem/gpu_mem_total tracepoint's data into
+ * {KEY, VAL} pair used to update the corresponding bpf map.
+ *
+ * Pass AID_GRAPHICS as gid since gpuservice is in the graphics group.
+ */
+DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_gpu_mem_total)
+(struct gpu_mem_total_args* args) {
+    /* The upper 32 bits are for gpu_id while the lower is the pid */
+    update_gpu_mem_total(((uint64_t)args->gpu_id << 32) | args->pid, args->size);
+    return 0;
+}
+
+/*
+ * Same as tp_gpu_mem_total, and also emits the changes of the map to |gpu_mem_total_ringbuf|.
+ * gpuservice attaches this program to the tracepoint instead of tp_gpu_mem_total when it is
+ * loaded.
+ */
+DEFINE_BPF_PROG_KVER("tracepoint/gpu_mem/gpu_mem_total_events", AID_ROOT, AID_GRAPHICS,
+                     tp_gpu_mem_total_events, KVER(5, 8, 0))
+(struct gpu_mem_total_args* args) {
+    GpuMemTotalEvent event = {
+            .key = ((uint64_t)args->gpu_id << 32) | args->pid,
+            .size = args->size,
+    };
+    uint32_t zero = 0;
+    uint64_t* dropped = NULL;
+
+    if (!update_gpu_mem_total(event.key, event.size)) return 0;
+
+    if (bpf_gpu_mem_total_ringbuf_output(&event)) {
+        dropped = bpf_gpu_mem_total_dropped_map_lookup_elem(&zero);
+        if (dropped) __sync_fetch_and_add(dropped, 1);
     }
     return 0;
 }
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+namespace android {
+namespace gpumem {
+#endif
+
+// A change of the gpu memory total of a (gpu_id, pid) pair, as emitted by the
+// bpf program to the |gpu_mem_total_ringbuf| ring buffer. A size of 0 means
+// that the total was removed from |gpu_mem_total_map|.
+typedef struct {
+    // ((gpu_id << 32) | pid), as in |gpu_mem_total_map|.
+    uint64_t key;
+    uint64_t size;
+} GpuMemTotalEvent;
+
+// On Android the number of active processes using gpu is limited.
+// So this is assumed to be true: SUM(num_procs_using_gpu[i]) <= 1024
+static const uint32_t kGpuMemTotalMapSize = 1024;
+
+#ifdef __cplusplus
+} // namespace gpumem
+} // namespace android
+#endif
@@ -35,6 +35,26 @@ namespace android {
 
 using base::StringAppendF;
 
+namespace {
+
+void forEachMapEntry(const bpf::BpfMap<uint64_t, uint64_t>& map,
+                     const std::function<void(uint64_t key, uint64_t size)>& callback) {
+    auto res = map.getFirstKey();
+    if (!res.ok()) return;
+    uint64_t key = res.value();
+    while (true) {
+        res = map.readValue(key);
+        if (!res.ok()) break;
+        callback(key, res.value());
+
+        res = map.getNextKey(key);
+        if (!res.ok()) break;
+        key = res.value();
+    }
+}
+
+} // namespace
+
 GpuMem::~GpuMem() {
     bpf_detach_tracepoint(kGpuMemTraceGroup, kGpuMemTotalTracepoint);
 }
@@ -43,8 +63,24 @@ void GpuMem::initialize() {
     // Make sure bpf programs are loaded
     bpf::waitForProgsLoaded();
 
+    // The program which also emits the changes of the totals is only loaded on kernels which
+    // support ring buffers.
+    std::unique_ptr<GpuMemTotalEvents> events;
+    int fd = bpf::retrieveProgram(kGpuMemTotalEventsProgPath);
+    if (fd >= 0) {
+        auto ringbuf = GpuMemTotalEvents::Create(kGpuMemTotalRingbufPath);
+        if (ringbuf.ok()) {
+            events = std::move(ringbuf.value());
+        } else {
+            ALOGW("Failed to create ring buffer from %s: %s", kGpuMemTotalRingbufPath,
+                  ringbuf.error().message().c_str());
+            close(fd);
+            fd = -1;
+        }
+    }
+
     errno = 0;
-    int fd = bpf::retrieveProgram(kGpuMemTotalProgPath);
+    if (fd < 0) fd = bpf::retrieveProgram(kGpuMemTotalProgPath);
     if (fd < 0) {
         ALOGE("Failed to retrieve pinned program from %s [%d(%s)]", kGpuMemTotalProgPath, errno,
               strerror(errno));
@@ -74,6 +110,18 @@ void GpuMem::initialize() {
     }
     setGpuMemTotalMap(map);
 
+    if (events) {
+        errno = 0;
+        auto droppedMap = bpf::BpfMapRO<uint32_t, uint64_t>(kGpuMemTotalDroppedMapPath);
+        if (droppedMap.isValid()) {
+            setGpuMemTotalEvents(std::move(events), droppedMap);
+        } else {
+            // Without the count of the lost changes, the cache could silently go stale.
+            ALOGW("Failed to create bpf map from %s [%d(%s)]", kGpuMemTotalDroppedMapPath, errno,
+                  strerror(errno));
+        }
+    }
+
     mInitialized.store(true);
 }
 
@@ -81,6 +129,72 @@ void GpuMem::setGpuMemTotalMap(bpf::BpfMap<uint64_t, uint64_t>& map) {
     mGpuMemTotalMap = std::move(map);
 }
 
+void GpuMem::setGpuMemTotalEvents(std::unique_ptr<GpuMemTotalEvents> events,
+                                  bpf::BpfMap<uint32_t, uint64_t>& droppedMap) {
+    mGpuMemTotalEvents = std::move(events);
+    mGpuMemTotalDroppedMap = std::move(droppedMap);
+    mGpuMemTotalsCached = true;
+}
+
+void GpuMem::forEachGpuMemTotal(
+        const std::function<void(uint64_t key, uint64_t size)>& callback) {
+    if (!mGpuMemTotalsCached) {
+        forEachMapEntry(mGpuMemTotalMap, callback);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mGpuMemTotalsMutex);
+    updateGpuMemTotalsLocked();
+    for (const auto& [key, size] : mGpuMemTotals) {
+        callback(key, size);
+    }
+}
+
+void GpuMem::updateGpuMemTotalsLocked() {
+    if (mGpuMemTotalEvents) {
+        auto& totals = mGpuMemTotals;
+        bool full = false;
+        auto res = mGpuMemTotalEvents->ConsumeAll([&](const gpumem::GpuMemTotalEvent& event) {
+            if (!event.size) {
+                totals.erase(event.key);
+            } else if (totals.size() < gpumem::kGpuMemTotalMapSize ||
+                       totals.count(event.key)) {
+                totals[event.key] = event.size;
+            } else {
+                full = true;
+            }
+        });
+        if (!res.ok()) {
+            ALOGE("Failed to read the gpu memory total changes: %s",
+                  res.error().message().c_str());
+            mGpuMemTotalsStale = true;
+        }
+        // The map cannot hold more totals either, so the cache missed a removal.
+        if (full) mGpuMemTotalsStale = true;
+    }
+
+    // The dropped count is read after the ring buffer is drained, so that the changes which are
+    // lost meanwhile are recovered by reloading the map, either now or on the next update.
+    if (mGpuMemTotalDroppedMap.isValid()) {
+        auto dropped = mGpuMemTotalDroppedMap.readValue(0);
+        if (dropped.ok() && dropped.value() != mGpuMemTotalsDropped) {
+            mGpuMemTotalsDropped = dropped.value();
+            mGpuMemTotalsStale = true;
+        }
+    }
+
+    if (mGpuMemTotalsStale) reloadGpuMemTotalsLocked();
+}
+
+void GpuMem::reloadGpuMemTotalsLocked() {
+    ATRACE_CALL();
+
+    mGpuMemTotals.clear();
+    auto& totals = mGpuMemTotals;
+    forEachMapEntry(mGpuMemTotalMap, [&](uint64_t key, uint64_t size) { totals[key] = size; });
+    mGpuMemTotalsStale = false;
+}
+
 // Dump the snapshots of global and per process memory usage on all gpus
 void GpuMem::dump(const Vector<String16>& /* args */, std::string* result) {
     ATRACE_CALL();
@@ -90,27 +204,16 @@ void GpuMem::dump(const Vector<String16>& /* args */, std::string* result) {
         return;
     }
 
-    auto res = mGpuMemTotalMap.getFirstKey();
-    if (!res.ok()) {
-        result->append("GPU memory total usage map is empty\n");
-        return;
-    }
-    uint64_t key = res.value();
     // unordered_map<gpu_id, vector<pair<pid, size>>>
     std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint64_t>>> dumpMap;
-    while (true) {
+    forEachGpuMemTotal([&](uint64_t key, uint64_t size) {
         uint32_t gpu_id = key >> 32;
         uint32_t pid = key;
-
-        res = mGpuMemTotalMap.readValue(key);
-        if (!res.ok()) break;
-        uint64_t size = res.value();
-
         dumpMap[gpu_id].emplace_back(pid, size);
-
-        res = mGpuMemTotalMap.getNextKey(key);
-        if (!res.ok()) break;
-        key = res.value();
+    });
+    if (dumpMap.empty()) {
+        result->append("GPU memory total usage map is empty\n");
+        return;
     }
 
     for (auto& gpu : dumpMap) {
@@ -136,22 +239,11 @@ void GpuMem::dump(const Vector<String16>& /* args */, std::string* result) {
 
 void GpuMem::traverseGpuMemTotals(const std::function<void(int64_t ts, uint32_t gpuId, uint32_t pid,
                                                            uint64_t size)>& callback) {
-    auto res = mGpuMemTotalMap.getFirstKey();
-    if (!res.ok()) return;
-    uint64_t key = res.value();
-    while (true) {
+    forEachGpuMemTotal([&](uint64_t key, uint64_t size) {
         uint32_t gpu_id = key >> 32;
         uint32_t pid = key;
-
-        res = mGpuMemTotalMap.readValue(key);
-        if (!res.ok()) break;
-        uint64_t size = res.value();
-
         callback(systemTime(), gpu_id, pid, size);
-        res = mGpuMemTotalMap.getNextKey(key);
-        if (!res.ok()) break;
-        key = res.value();
-    }
+    });
 }
 
 } // namespace android
@@ -16,11 +16,17 @@
 
 #pragma once
 
+#include <android-base/thread_annotations.h>
 #include <bpf/BpfMap.h>
+#include <bpf/BpfRingbuf.h>
+#include <gpumem/gpuMemTotal.h>
 #include <utils/String16.h>
 #include <utils/Vector.h>
 
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace android {
 
@@ -35,7 +41,9 @@ public:
     void dump(const Vector<String16>& args, std::string* result);
     bool isInitialized() { return mInitialized.load(); }
 
-    // Traverse the gpu memory total map to feed the callback function.
+    // Traverse the gpu memory totals to feed the callback function. When the kernel emits the
+    // changes of the totals, they are read from a cache which only applies the changes, instead of
+    // from the whole map.
     void traverseGpuMemTotals(const std::function<void(int64_t ts, uint32_t gpuId, uint32_t pid,
                                                        uint64_t size)>& callback);
 
@@ -43,13 +51,39 @@ private:
     // Friend class for testing.
     friend class TestableGpuMem;
 
+    using GpuMemTotalEvents = bpf::BpfRingbuf<gpumem::GpuMemTotalEvent>;
+
     // set gpu memory total map
     void setGpuMemTotalMap(bpf::BpfMap<uint64_t, uint64_t>& map);
+    // set the ring buffer of the changes of the gpu memory totals, and the count of the changes
+    // which did not fit into it, and enable the cache of the totals
+    void setGpuMemTotalEvents(std::unique_ptr<GpuMemTotalEvents> events,
+                              bpf::BpfMap<uint32_t, uint64_t>& droppedMap);
+    // Calls the callback for each (key, size) of the gpu memory total map, from the cache when it
+    // is enabled.
+    void forEachGpuMemTotal(const std::function<void(uint64_t key, uint64_t size)>& callback);
+    // Applies the pending changes to the cache, or reloads it from the map if changes were lost.
+    void updateGpuMemTotalsLocked() REQUIRES(mGpuMemTotalsMutex);
+    void reloadGpuMemTotalsLocked() REQUIRES(mGpuMemTotalsMutex);
 
     // indicate whether ebpf has been initialized
     std::atomic<bool> mInitialized = false;
     // bpf map for GPU memory total data
     android::bpf::BpfMap<uint64_t, uint64_t> mGpuMemTotalMap;
+    // whether the gpu memory totals are read from mGpuMemTotals
+    bool mGpuMemTotalsCached = false;
+    // ring buffer of the changes of the gpu memory totals, if the kernel supports it
+    std::unique_ptr<GpuMemTotalEvents> mGpuMemTotalEvents;
+    // bpf map for the count of the changes which did not fit into the ring buffer
+    android::bpf::BpfMap<uint32_t, uint64_t> mGpuMemTotalDroppedMap;
+
+    std::mutex mGpuMemTotalsMutex;
+    // copy of the gpu memory total map, bounded by the size of the map
+    std::unordered_map<uint64_t, uint64_t> mGpuMemTotals GUARDED_BY(mGpuMemTotalsMutex);
+    // whether mGpuMemTotals has to be reloaded from the map
+    bool mGpuMemTotalsStale GUARDED_BY(mGpuMemTotalsMutex) = true;
+    // value of the dropped count when mGpuMemTotals was last updated
+    uint64_t mGpuMemTotalsDropped GUARDED_BY(mGpuMemTotalsMutex) = 0;
 
     // gpu memory tracepoint event category
     static constexpr char kGpuMemTraceGroup[] = "gpu_mem";
@@ -58,8 +92,18 @@ private:
     // pinned gpu memory total bpf c program path in bpf sysfs
     static constexpr char kGpuMemTotalProgPath[] =
             "/sys/fs/bpf/prog_gpuMem_tracepoint_gpu_mem_gpu_mem_total";
+    // pinned gpu memory total bpf c program path in bpf sysfs, which also emits the changes of
+    // the totals
+    static constexpr char kGpuMemTotalEventsProgPath[] =
+            "/sys/fs/bpf/prog_gpuMem_tracepoint_gpu_mem_gpu_mem_total_events";
     // pinned gpu memory total bpf map path in bpf sysfs
     static constexpr char kGpuMemTotalMapPath[] = "/sys/fs/bpf/map_gpuMem_gpu_mem_total_map";
+    // pinned ring buffer of the changes of the gpu memory totals in bpf sysfs
+    static constexpr char kGpuMemTotalRingbufPath[] =
+            "/sys/fs/bpf/map_gpuMem_gpu_mem_total_ringbuf";
+    // pinned bpf map path of the count of the changes which did not fit into the ring buffer
+    static constexpr char kGpuMemTotalDroppedMapPath[] =
+            "/sys/fs/bpf/map_gpuMem_gpu_mem_total_dropped_map";
     // 30 seconds timeout for trying to attach bpf program to tracepoint
     static constexpr int kGpuWaitTimeout = 30;
 };
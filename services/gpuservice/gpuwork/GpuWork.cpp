@@ -28,6 +28,7 @@
 #include <random>
 #include <stats_event.h>
 #include <statslog.h>
+#include <time.h>
 #include <unistd.h>
 #include <utils/Timers.h>
 #include <utils/Trace.h>
@@ -38,6 +39,7 @@
 #include <limits>
 #include <map>
 #include <mutex>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -139,6 +141,16 @@ void GpuWork::initialize() {
         mPreviousMapClearTimePoint = std::chrono::steady_clock::now();
     }
 
+    // The activity map is only used for dumps, so we carry on without it.
+    errno = 0;
+    mGpuWorkActivityMap = bpf::BpfMapRO<GpuIdUidSecond, uint64_t>(
+            "/sys/fs/bpf/map_gpuWork_gpu_work_activity_map");
+    if (!mGpuWorkActivityMap.isValid()) {
+        ALOGW("Failed to create bpf map from /sys/fs/bpf/map_gpuWork_gpu_work_activity_map "
+              "[%d(%s)]",
+              errno, strerror(errno));
+    }
+
     // Attach the tracepoint.
     if (!attachTracepoint("/sys/fs/bpf/prog_gpuWork_tracepoint_power_gpu_work_period", "power",
                           "gpu_work_period")) {
@@ -221,6 +233,54 @@ void GpuWork::dump(const Vector<String16>& /* args */, std::string* result) {
                       idToUidInfo.second.total_active_duration_ns,
                       idToUidInfo.second.total_inactive_duration_ns);
     }
+
+    dumpActivity(result);
+}
+
+void GpuWork::dumpActivity(std::string* result) {
+    if (!mGpuWorkActivityMap.isValid()) {
+        result->append("GPU activity map is not available.\n");
+        return;
+    }
+
+    // The seconds of the buckets are CLOCK_MONOTONIC_RAW seconds, as the
+    // periods of the tracepoint.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    const uint64_t nowSecond = static_cast<uint64_t>(now.tv_sec);
+
+    // Ordered map ensures output data is sorted by GPU ID, UID and second.
+    std::map<std::tuple<uint32_t, Uid, uint32_t>, uint64_t> dumpMap;
+
+    // Each bucket is only read once per dump, and only the buckets of the
+    // last seconds are kept, so the iteration does not need to be reliable.
+    mGpuWorkActivityMap.iterateWithValue(
+            [&dumpMap, nowSecond](const GpuIdUidSecond& key, const uint64_t& value,
+                                  const android::bpf::BpfMap<GpuIdUidSecond, uint64_t>&)
+                    -> base::Result<void> {
+                if (uint64_t{key.second} + kActivityDumpDurationSeconds > nowSecond) {
+                    dumpMap[{key.gpu_id, key.uid, key.second}] = value;
+                }
+                return {};
+            });
+
+    // Dump activity information.
+    // E.g.
+    // GPU activity information for the last 60 seconds, at second 12345.
+    // gpu_id uid second active_duration_us
+    // 0 10123 12340 152000
+    // 0 10123 12341 148500
+
+    StringAppendF(result,
+                  "GPU activity information for the last %" PRIu32 " seconds, at second %" PRIu64
+                  ".\ngpu_id uid second active_duration_us\n",
+                  kActivityDumpDurationSeconds, nowSecond);
+
+    for (const auto& [key, activeDurationNs] : dumpMap) {
+        const auto& [gpuId, uid, second] = key;
+        StringAppendF(result, "%" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu64 "\n", gpuId, uid,
+                      second, activeDurationNs / 1000);
+    }
 }
 
 bool GpuWork::attachTracepoint(const char* programPath, const char* tracepointGroup,
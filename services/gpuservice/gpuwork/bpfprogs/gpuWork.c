@@ -36,6 +36,13 @@ DEFINE_BPF_MAP_GRW(gpu_work_map, HASH, GpuIdUid, UidTrackingInfo, kMaxTrackedGpu
 // A map containing a single entry of |GlobalData|.
 DEFINE_BPF_MAP_GRW(gpu_work_global_data, ARRAY, uint32_t, GlobalData, 1, AID_GRAPHICS);
 
+// A map from GpuIdUidSecond (GPU ID, application UID and second) to the time
+// the GPU was active for the UID during the second, in nanoseconds. Unlike
+// |gpu_work_map|, it is never cleared by gpuservice; the least recently updated
+// seconds are evicted when it is full.
+DEFINE_BPF_MAP_GRO(gpu_work_activity_map, LRU_HASH, GpuIdUidSecond, uint64_t,
+                   kMaxTrackedActivityBuckets, AID_GRAPHICS);
+
 // Defines the structure of the kernel tracepoint:
 //
 //  /sys/kernel/tracing/events/power/gpu_work_period/
@@ -178,6 +185,54 @@ _Static_assert(offsetof(GpuWorkPeriodEvent, gpu_id) == 8 &&
                "must match the tracepoint field offsets found via adb shell cat "
                "/sys/kernel/tracing/events/power/gpu_work_period/format");
 
+// Adds |active_duration_ns| to the bucket of |second| for the GPU ID and UID.
+static __always_inline void add_activity(const GpuIdUid* gpu_id_and_uid, uint64_t second,
+                                         uint64_t active_duration_ns) {
+    if (active_duration_ns == 0) {
+        return;
+    }
+
+    GpuIdUidSecond key;
+    __builtin_memset(&key, 0, sizeof(key));
+    key.gpu_id = gpu_id_and_uid->gpu_id;
+    key.uid = gpu_id_and_uid->uid;
+    key.second = (uint32_t)second;
+
+    uint64_t* bucket = bpf_gpu_work_activity_map_lookup_elem(&key);
+    if (bucket) {
+        __sync_fetch_and_add(bucket, active_duration_ns);
+        return;
+    }
+    if (0 == bpf_gpu_work_activity_map_update_elem(&key, &active_duration_ns, BPF_NOEXIST)) {
+        return;
+    }
+    // The bucket was added meanwhile.
+    bucket = bpf_gpu_work_activity_map_lookup_elem(&key);
+    if (bucket) {
+        __sync_fetch_and_add(bucket, active_duration_ns);
+    }
+}
+
+// Adds the active time of a valid period to the buckets of the seconds it
+// covers. A period is at most 1 second long, so it covers at most two seconds,
+// and its active time is split between them in proportion to their overlap
+// with the period.
+static __always_inline void record_activity(const GpuIdUid* gpu_id_and_uid,
+                                            const GpuWorkPeriodEvent* period,
+                                            uint64_t active_duration_ns) {
+    const uint64_t start_second = period->start_time_ns / S_IN_NS;
+    const uint64_t end_second = (period->end_time_ns - 1) / S_IN_NS;
+    if (start_second == end_second) {
+        add_activity(gpu_id_and_uid, start_second, active_duration_ns);
+        return;
+    }
+    const uint64_t boundary_ns = end_second * S_IN_NS;
+    const uint64_t first_active_duration_ns = active_duration_ns *
+            (boundary_ns - period->start_time_ns) / (period->end_time_ns - period->start_time_ns);
+    add_activity(gpu_id_and_uid, start_second, first_active_duration_ns);
+    add_activity(gpu_id_and_uid, end_second, active_duration_ns - first_active_duration_ns);
+}
+
 DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_gpu_work_period)
 (GpuWorkPeriodEvent* const period) {
     // Note: In eBPF programs, |__sync_fetch_and_add| is translated to an atomic
@@ -270,8 +325,10 @@ DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_g
     // it must not be larger than |period_duration_ns|.
     if (period->total_active_duration_ns > period_duration_ns) {
         __sync_fetch_and_add(&uid_tracking_info->error_count, 1);
+        record_activity(&gpu_id_and_uid, period, period_duration_ns);
     } else {
         period_total_inactive_time_ns = period_duration_ns - period->total_active_duration_ns;
+        record_activity(&gpu_id_and_uid, period, period->total_active_duration_ns);
     }
 
     // Update |uid_tracking_info->total_inactive_duration_ns| by adding the
@@ -63,6 +63,21 @@ typedef struct {
 // The maximum number of tracked GPU ID and UID pairs (|GpuIdUid|).
 static const uint32_t kMaxTrackedGpuIdUids = 512;
 
+typedef struct {
+    uint32_t gpu_id;
+    uint32_t uid;
+    // The second covered by the bucket, in CLOCK_MONOTONIC_RAW seconds.
+    uint32_t second;
+    // Needed to make 32-bit arch struct size match 64-bit BPF arch struct size.
+    uint32_t padding0;
+} GpuIdUidSecond;
+
+// The maximum number of tracked one second buckets of GPU activity
+// (|GpuIdUidSecond|). The least recently updated buckets are evicted first, so
+// this covers the last minute for up to ~64 GPU ID and UID pairs that are
+// active at the same time.
+static const uint32_t kMaxTrackedActivityBuckets = 4096;
+
 #ifdef __cplusplus
 } // namespace gpuwork
 } // namespace android
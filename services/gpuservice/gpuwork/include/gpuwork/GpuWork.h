@@ -57,6 +57,10 @@ private:
 
     AStatsManager_PullAtomCallbackReturn pullWorkAtoms(AStatsEventList* data);
 
+    // Dumps the GPU active time of each UID for each of the last
+    // |kActivityDumpDurationSeconds| seconds.
+    void dumpActivity(std::string* result);
+
     // Periodically calls |clearMapIfNeeded| to clear the |mGpuWorkMap| map, if
     // needed.
     //
@@ -93,6 +97,10 @@ private:
     // BPF map containing a single element for global data.
     bpf::BpfMap<uint32_t, GlobalData> mGpuWorkGlobalDataMap GUARDED_BY(mMutex);
 
+    // BPF map for the per-UID GPU active time of each second. It is only read,
+    // and it is set before |mInitialized|, so it does not need |mMutex|.
+    bpf::BpfMapRO<GpuIdUidSecond, uint64_t> mGpuWorkActivityMap;
+
     // When true, we are being destructed, so |mMapClearerThread| should stop.
     bool mIsTerminating GUARDED_BY(mMutex);
 
@@ -120,6 +128,9 @@ private:
     // then we don't log any stats.
     static constexpr size_t kNumGpusHardLimit = 32;
 
+    // The number of seconds of GPU activity that are dumped.
+    static constexpr uint32_t kActivityDumpDurationSeconds = 60;
+
     // The minimum GPU time needed to actually log stats for a UID.
     static constexpr uint64_t kMinGpuTimeNanoseconds = 30U * 1000000000U; // 30 seconds.
 
@@ -34,6 +34,7 @@ namespace {
 
 using base::StringPrintf;
 using testing::HasSubstr;
+using testing::Not;
 
 constexpr uint32_t TEST_MAP_SIZE = 10;
 constexpr uint64_t TEST_GLOBAL_KEY = 0;
@@ -72,6 +73,9 @@ public:
 
         EXPECT_EQ(0, errno);
         EXPECT_TRUE(mTestMap.isValid());
+
+        mTestDroppedMap = std::move(bpf::BpfMap<uint32_t, uint64_t>(BPF_MAP_TYPE_ARRAY, 1, 0));
+        EXPECT_TRUE(mTestDroppedMap.isValid());
     }
 
     std::string dumpsys() {
@@ -84,6 +88,7 @@ public:
     std::unique_ptr<GpuMem> mGpuMem;
     TestableGpuMem mTestableGpuMem;
     bpf::BpfMap<uint64_t, uint64_t> mTestMap;
+    bpf::BpfMap<uint32_t, uint64_t> mTestDroppedMap;
 };
 
 TEST_F(GpuMemTest, validGpuMemTotalBpfPaths) {
@@ -92,6 +97,12 @@ TEST_F(GpuMemTest, validGpuMemTotalBpfPaths) {
     EXPECT_EQ(mTestableGpuMem.getGpuMemTotalProgPath(),
               "/sys/fs/bpf/prog_gpuMem_tracepoint_gpu_mem_gpu_mem_total");
     EXPECT_EQ(mTestableGpuMem.getGpuMemTotalMapPath(), "/sys/fs/bpf/map_gpuMem_gpu_mem_total_map");
+    EXPECT_EQ(mTestableGpuMem.getGpuMemTotalEventsProgPath(),
+              "/sys/fs/bpf/prog_gpuMem_tracepoint_gpu_mem_gpu_mem_total_events");
+    EXPECT_EQ(mTestableGpuMem.getGpuMemTotalRingbufPath(),
+              "/sys/fs/bpf/map_gpuMem_gpu_mem_total_ringbuf");
+    EXPECT_EQ(mTestableGpuMem.getGpuMemTotalDroppedMapPath(),
+              "/sys/fs/bpf/map_gpuMem_gpu_mem_total_dropped_map");
 }
 
 TEST_F(GpuMemTest, bpfInitializationFailed) {
@@ -168,5 +179,40 @@ TEST_F(GpuMemTest, traverseGpuMemTotals) {
     EXPECT_EQ(sCount, TEST_KEY_COUNT);
 }
 
+TEST_F(GpuMemTest, cachedGpuMemTotals) {
+    ASSERT_RESULT_OK(mTestMap.writeValue(TEST_GLOBAL_KEY, TEST_GLOBAL_VAL, BPF_ANY));
+    ASSERT_RESULT_OK(mTestMap.writeValue(TEST_PROC_KEY_1, TEST_PROC_VAL_1, BPF_ANY));
+    mTestableGpuMem.setGpuMemTotalMap(mTestMap);
+    mTestableGpuMem.setGpuMemTotalDroppedMap(mTestDroppedMap);
+
+    EXPECT_THAT(dumpsys(),
+                HasSubstr(StringPrintf("Proc %u total: %" PRIu64 "\n", (uint32_t)TEST_PROC_KEY_1,
+                                       TEST_PROC_VAL_1)));
+
+    // Without lost changes, the totals are served from the cache without reading the map again.
+    ASSERT_RESULT_OK(mTestableGpuMem.getGpuMemTotalMap().writeValue(TEST_PROC_KEY_2,
+                                                                     TEST_PROC_VAL_2, BPF_ANY));
+    EXPECT_THAT(dumpsys(),
+                Not(HasSubstr(StringPrintf("Proc %u total:", (uint32_t)TEST_PROC_KEY_2))));
+}
+
+TEST_F(GpuMemTest, cachedGpuMemTotalsReloadedAfterDroppedChanges) {
+    ASSERT_RESULT_OK(mTestMap.writeValue(TEST_PROC_KEY_1, TEST_PROC_VAL_1, BPF_ANY));
+    mTestableGpuMem.setGpuMemTotalMap(mTestMap);
+    mTestableGpuMem.setGpuMemTotalDroppedMap(mTestDroppedMap);
+
+    uint32_t count = 0;
+    mGpuMem->traverseGpuMemTotals([&](int64_t, uint32_t, uint32_t, uint64_t) { count++; });
+    EXPECT_EQ(count, 1u);
+
+    ASSERT_RESULT_OK(mTestableGpuMem.getGpuMemTotalMap().writeValue(TEST_PROC_KEY_2,
+                                                                     TEST_PROC_VAL_2, BPF_ANY));
+    ASSERT_RESULT_OK(mTestableGpuMem.getGpuMemTotalDroppedMap().writeValue(0, 1, BPF_ANY));
+
+    count = 0;
+    mGpuMem->traverseGpuMemTotals([&](int64_t, uint32_t, uint32_t, uint64_t) { count++; });
+    EXPECT_EQ(count, 2u);
+}
+
 } // namespace
 } // namespace android
@@ -32,6 +32,18 @@ public:
         mGpuMem->setGpuMemTotalMap(map);
     }
 
+    // Enables the cache of the totals without a ring buffer, so that it is only reloaded when the
+    // dropped count changes.
+    void setGpuMemTotalDroppedMap(bpf::BpfMap<uint32_t, uint64_t>& map) {
+        mGpuMem->setGpuMemTotalEvents(nullptr, map);
+    }
+
+    bpf::BpfMap<uint64_t, uint64_t>& getGpuMemTotalMap() { return mGpuMem->mGpuMemTotalMap; }
+
+    bpf::BpfMap<uint32_t, uint64_t>& getGpuMemTotalDroppedMap() {
+        return mGpuMem->mGpuMemTotalDroppedMap;
+    }
+
     std::string getGpuMemTraceGroup() { return mGpuMem->kGpuMemTraceGroup; }
 
     std::string getGpuMemTotalTracepoint() { return mGpuMem->kGpuMemTotalTracepoint; }
@@ -40,6 +52,12 @@ public:
 
     std::string getGpuMemTotalMapPath() { return mGpuMem->kGpuMemTotalMapPath; }
 
+    std::string getGpuMemTotalEventsProgPath() { return mGpuMem->kGpuMemTotalEventsProgPath; }
+
+    std::string getGpuMemTotalRingbufPath() { return mGpuMem->kGpuMemTotalRingbufPath; }
+
+    std::string getGpuMemTotalDroppedMapPath() { return mGpuMem->kGpuMemTotalDroppedMapPath; }
+
 private:
     GpuMem *mGpuMem;
 };
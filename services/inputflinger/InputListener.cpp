@@ -116,6 +116,11 @@ void QueuedInputListener::notifyPointerCaptureChanged(const NotifyPointerCapture
     mArgsQueue.emplace_back(args);
 }
 
+void QueuedInputListener::notify(NotifyArgs&& args) {
+    std::visit([](const auto& a) { traceEvent("notify", a.id); }, args);
+    mArgsQueue.emplace_back(std::move(args));
+}
+
 void QueuedInputListener::flush() {
     for (const NotifyArgs& args : mArgsQueue) {
         mInnerListener.notify(args);
@@ -447,7 +447,7 @@ void InputProcessor::notifyMotion(const NotifyMotionArgs& args) {
                                 motionClassificationToString(newClassification),
                                 motionClassificationToString(args.classification));
             newArgs.classification = newClassification;
-            mQueuedListener.notifyMotion(newArgs);
+            mQueuedListener.notify(std::move(newArgs));
         }
     } // release lock
     mQueuedListener.flush();
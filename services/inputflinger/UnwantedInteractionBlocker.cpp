@@ -343,10 +343,10 @@ void UnwantedInteractionBlocker::notifyMotion(const NotifyMotionArgs& args) {
     ALOGD_IF(DEBUG_INBOUND_MOTION, "%s: %s", __func__, args.dump().c_str());
     { // acquire lock
         std::scoped_lock lock(mLock);
-        const std::vector<NotifyMotionArgs> processedArgs =
+        std::vector<NotifyMotionArgs> processedArgs =
                 mPreferStylusOverTouchBlocker.processMotion(args);
-        for (const NotifyMotionArgs& loopArgs : processedArgs) {
-            notifyMotionLocked(loopArgs);
+        for (NotifyMotionArgs& loopArgs : processedArgs) {
+            notifyMotionLocked(std::move(loopArgs));
         }
     } // release lock
 
@@ -354,22 +354,22 @@ void UnwantedInteractionBlocker::notifyMotion(const NotifyMotionArgs& args) {
     mQueuedListener.flush();
 }
 
-void UnwantedInteractionBlocker::enqueueOutboundMotionLocked(const NotifyMotionArgs& args) {
+void UnwantedInteractionBlocker::enqueueOutboundMotionLocked(NotifyMotionArgs&& args) {
     ALOGD_IF(DEBUG_OUTBOUND_MOTION, "%s: %s", __func__, args.dump().c_str());
-    mQueuedListener.notifyMotion(args);
+    mQueuedListener.notify(std::move(args));
 }
 
-void UnwantedInteractionBlocker::notifyMotionLocked(const NotifyMotionArgs& args) {
+void UnwantedInteractionBlocker::notifyMotionLocked(NotifyMotionArgs&& args) {
     auto it = mPalmRejectors.find(args.deviceId);
     const bool sendToPalmRejector = it != mPalmRejectors.end() && isFromTouchscreen(args.source);
     if (!sendToPalmRejector) {
-        enqueueOutboundMotionLocked(args);
+        enqueueOutboundMotionLocked(std::move(args));
         return;
     }
 
     std::vector<NotifyMotionArgs> processedArgs = it->second.processMotion(args);
-    for (const NotifyMotionArgs& loopArgs : processedArgs) {
-        enqueueOutboundMotionLocked(loopArgs);
+    for (NotifyMotionArgs& loopArgs : processedArgs) {
+        enqueueOutboundMotionLocked(std::move(loopArgs));
     }
 }
 
@@ -565,86 +565,112 @@ PalmRejector::PalmRejector(const AndroidPalmFilterDeviceInfo& info,
                                                                       mSharedPalmState.get());
 }
 
-std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
-                                                   const AndroidPalmFilterDeviceInfo& deviceInfo,
-                                                   const SlotState& oldSlotState,
-                                                   const SlotState& newSlotState) {
-    std::vector<::ui::InProgressTouchEvdev> touches;
+/**
+ * Convert the pointer at the given index to a linux-like 'InProgressTouchEvdev' in the given slot.
+ */
+static ::ui::InProgressTouchEvdev createTouch(const NotifyMotionArgs& args, size_t pointerIndex,
+                                              size_t slot) {
+    const size_t i = pointerIndex;
+    ::ui::InProgressTouchEvdev touch;
+    touch.major = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR);
+    touch.minor = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR);
+    // The field 'tool_type' is not used for palm rejection
 
-    for (size_t i = 0; i < args.pointerCount; i++) {
-        const int32_t pointerId = args.pointerProperties[i].id;
-        touches.emplace_back(::ui::InProgressTouchEvdev());
-        touches.back().major = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR);
-        touches.back().minor = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR);
-        // The field 'tool_type' is not used for palm rejection
+    // Whether there is new information for the touch.
+    touch.altered = true;
 
-        // Whether there is new information for the touch.
-        touches.back().altered = true;
+    // Whether the touch was cancelled. Touch events should be ignored till a
+    // new touch is initiated.
+    touch.was_cancelled = false;
 
-        // Whether the touch was cancelled. Touch events should be ignored till a
-        // new touch is initiated.
-        touches.back().was_cancelled = false;
+    // Whether the touch is going to be canceled.
+    touch.cancelled = false;
 
-        // Whether the touch is going to be canceled.
-        touches.back().cancelled = false;
+    // Whether the touch is delayed at first appearance. Will not be reported yet.
+    touch.delayed = false;
 
-        // Whether the touch is delayed at first appearance. Will not be reported yet.
-        touches.back().delayed = false;
+    // Whether the touch was delayed before.
+    touch.was_delayed = false;
 
-        // Whether the touch was delayed before.
-        touches.back().was_delayed = false;
+    // Whether the touch is held until end or no longer held.
+    touch.held = false;
 
-        // Whether the touch is held until end or no longer held.
-        touches.back().held = false;
+    // Whether this touch was held before being sent.
+    touch.was_held = false;
 
-        // Whether this touch was held before being sent.
-        touches.back().was_held = false;
+    const int32_t resolvedAction = resolveActionForPointer(i, args.action);
+    const bool isDown = resolvedAction == AMOTION_EVENT_ACTION_POINTER_DOWN ||
+            resolvedAction == AMOTION_EVENT_ACTION_DOWN;
+    touch.was_touching = !isDown;
 
-        const int32_t resolvedAction = resolveActionForPointer(i, args.action);
-        const bool isDown = resolvedAction == AMOTION_EVENT_ACTION_POINTER_DOWN ||
-                resolvedAction == AMOTION_EVENT_ACTION_DOWN;
-        touches.back().was_touching = !isDown;
+    const bool isUpOrCancel = resolvedAction == AMOTION_EVENT_ACTION_CANCEL ||
+            resolvedAction == AMOTION_EVENT_ACTION_UP ||
+            resolvedAction == AMOTION_EVENT_ACTION_POINTER_UP;
 
-        const bool isUpOrCancel = resolvedAction == AMOTION_EVENT_ACTION_CANCEL ||
-                resolvedAction == AMOTION_EVENT_ACTION_UP ||
-                resolvedAction == AMOTION_EVENT_ACTION_POINTER_UP;
+    touch.x = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_X);
+    touch.y = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_Y);
 
-        touches.back().x = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_X);
-        touches.back().y = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_Y);
+    touch.slot = slot;
+    touch.tracking_id = (!isUpOrCancel) ? args.pointerProperties[i].id : -1;
+    touch.touching = !isUpOrCancel;
 
+    // The fields 'radius_x' and 'radius_x' are not used for palm rejection
+    touch.pressure = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_PRESSURE);
+    touch.tool_code = getLinuxToolCode(args.pointerProperties[i].toolType);
+    // The field 'orientation' is not used for palm rejection
+    // The fields 'tilt_x' and 'tilt_y' are not used for palm rejection
+    // The field 'reported_tool_type' is not used for palm rejection
+    touch.stylus_button = false;
+    return touch;
+}
+
+std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
+                                                   const AndroidPalmFilterDeviceInfo& deviceInfo,
+                                                   const SlotState& oldSlotState,
+                                                   const SlotState& newSlotState) {
+    std::vector<::ui::InProgressTouchEvdev> touches;
+    touches.reserve(args.pointerCount);
+    for (size_t i = 0; i < args.pointerCount; i++) {
+        const int32_t pointerId = args.pointerProperties[i].id;
         std::optional<size_t> slot = newSlotState.getSlotForPointerId(pointerId);
         if (!slot) {
             slot = oldSlotState.getSlotForPointerId(pointerId);
         }
         LOG_ALWAYS_FATAL_IF(!slot, "Could not find slot for pointer %d", pointerId);
-        touches.back().slot = *slot;
-        touches.back().tracking_id = (!isUpOrCancel) ? pointerId : -1;
-        touches.back().touching = !isUpOrCancel;
-
-        // The fields 'radius_x' and 'radius_x' are not used for palm rejection
-        touches.back().pressure = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_PRESSURE);
-        touches.back().tool_code = getLinuxToolCode(args.pointerProperties[i].toolType);
-        // The field 'orientation' is not used for palm rejection
-        // The fields 'tilt_x' and 'tilt_y' are not used for palm rejection
-        // The field 'reported_tool_type' is not used for palm rejection
-        touches.back().stylus_button = false;
+        touches.push_back(createTouch(args, i, *slot));
     }
     return touches;
 }
 
-std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args) {
-    std::bitset<::ui::kNumTouchEvdevSlots> slotsToHold;
-    std::bitset<::ui::kNumTouchEvdevSlots> slotsToSuppress;
-
-    // Store the slot state before we call getTouches and update it. This way, we can find
-    // the slots that have been removed due to the incoming event.
-    SlotState oldSlotState = mSlotState;
-    mSlotState.update(args);
+bool PalmRejector::isFastPathEligible(const NotifyMotionArgs& args) const {
+    if (args.pointerCount != 1 || mDeviceInfo.x_res <= 0 || mDeviceInfo.y_res <= 0 ||
+        mDeviceInfo.touch_major_res <= 0) {
+        return false;
+    }
+    const float marginX = FAST_PATH_EDGE_MARGIN_MM * mDeviceInfo.x_res;
+    const float marginY = FAST_PATH_EDGE_MARGIN_MM * mDeviceInfo.y_res;
+    const float x = args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_X);
+    const float y = args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_Y);
+    if (x < marginX || x > mDeviceInfo.max_x - marginX || y < marginY ||
+        y > mDeviceInfo.max_y - marginY) {
+        return false;
+    }
+    return args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR) <=
+            FAST_PATH_MAX_TOUCH_MAJOR_MM * mDeviceInfo.touch_major_res;
+}
 
-    std::vector<::ui::InProgressTouchEvdev> touches =
-            getTouches(args, mDeviceInfo, oldSlotState, mSlotState);
-    ::base::TimeTicks chromeTimestamp = toChromeTimestamp(args.eventTime);
+void PalmRejector::leaveFastPath() {
+    mFastPath = false;
+    std::bitset<::ui::kNumTouchEvdevSlots> slotsToSuppress;
+    for (const auto& [time, touch] : mHeldTouches) {
+        filter({touch}, time, &slotsToSuppress);
+    }
+    mHeldTouches.clear();
+}
 
+void PalmRejector::filter(const std::vector<::ui::InProgressTouchEvdev>& touches,
+                          ::base::TimeTicks time,
+                          std::bitset<::ui::kNumTouchEvdevSlots>* slotsToSuppress) {
     if (DEBUG_MODEL) {
         std::stringstream touchesStream;
         for (const ::ui::InProgressTouchEvdev& touch : touches) {
@@ -653,16 +679,71 @@ std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args)
         ALOGD("Filter: touches = %s", touchesStream.str().c_str());
     }
 
-    mPalmDetectionFilter->Filter(touches, chromeTimestamp, &slotsToHold, &slotsToSuppress);
+    std::bitset<::ui::kNumTouchEvdevSlots> slotsToHold;
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    mPalmDetectionFilter->Filter(touches, time, &slotsToHold, slotsToSuppress);
+    const nsecs_t filterTime = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    mTotalFilterTime += filterTime;
+    mMaxFilterTime = std::max(mMaxFilterTime, filterTime);
 
     ALOGD_IF(DEBUG_MODEL, "Response: slotsToHold = %s, slotsToSuppress = %s",
-             slotsToHold.to_string().c_str(), slotsToSuppress.to_string().c_str());
+             slotsToHold.to_string().c_str(), slotsToSuppress->to_string().c_str());
+}
+
+std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args) {
+    // Look up the slots before the slot state is updated with the incoming event, so that the
+    // slots of the pointers which are removed by the event can be found.
+    mOldSlots.clear();
+    for (size_t i = 0; i < args.pointerCount; i++) {
+        mOldSlots.push_back(mSlotState.getSlotForPointerId(args.pointerProperties[i].id));
+    }
+    mSlotState.update(args);
+
+    mTouches.clear();
+    for (size_t i = 0; i < args.pointerCount; i++) {
+        const int32_t pointerId = args.pointerProperties[i].id;
+        std::optional<size_t> slot = mSlotState.getSlotForPointerId(pointerId);
+        if (!slot) {
+            slot = mOldSlots[i];
+        }
+        LOG_ALWAYS_FATAL_IF(!slot, "Could not find slot for pointer %d", pointerId);
+        mTouches.push_back(createTouch(args, i, *slot));
+    }
+    ::base::TimeTicks chromeTimestamp = toChromeTimestamp(args.eventTime);
+
+    const int32_t actionMasked = MotionEvent::getActionMasked(args.action);
+    if (actionMasked == AMOTION_EVENT_ACTION_DOWN) {
+        mFastPath = isFastPathEligible(args);
+        mHoldTouches = mFastPath;
+        mHeldTouches.clear();
+    } else if (mFastPath && !isFastPathEligible(args)) {
+        leaveFastPath();
+    }
+    if (mFastPath) {
+        mSkippedEventCount++;
+        if (actionMasked == AMOTION_EVENT_ACTION_UP ||
+            actionMasked == AMOTION_EVENT_ACTION_CANCEL) {
+            // The gesture has ended without the filter.
+            mFastPath = false;
+            mHeldTouches.clear();
+        } else if (mHoldTouches && mHeldTouches.size() < FAST_PATH_MAX_HELD_TOUCHES) {
+            mHeldTouches.emplace_back(chromeTimestamp, mTouches[0]);
+        } else {
+            mHoldTouches = false;
+            mHeldTouches.clear();
+        }
+        return {};
+    }
+
+    mFilteredEventCount++;
+    std::bitset<::ui::kNumTouchEvdevSlots> slotsToSuppress;
+    filter(mTouches, chromeTimestamp, &slotsToSuppress);
 
     // Now that we know which slots should be suppressed, let's convert those to pointer id's.
     std::set<int32_t> newSuppressedIds;
     for (size_t i = 0; i < args.pointerCount; i++) {
         const int32_t pointerId = args.pointerProperties[i].id;
-        std::optional<size_t> slot = oldSlotState.getSlotForPointerId(pointerId);
+        std::optional<size_t> slot = mOldSlots[i];
         if (!slot) {
             slot = mSlotState.getSlotForPointerId(pointerId);
             LOG_ALWAYS_FATAL_IF(!slot, "Could not find slot for pointer id %" PRId32, pointerId);
@@ -696,6 +777,10 @@ std::vector<NotifyMotionArgs> PalmRejector::processMotion(const NotifyMotionArgs
     std::swap(oldSuppressedIds, mSuppressedPointerIds);
 
     std::optional<NotifyMotionArgs> touchOnlyArgs = removeStylusPointerIds(args);
+    if (mFastPath && (!touchOnlyArgs || touchOnlyArgs->pointerCount != args.pointerCount)) {
+        // The touches are always filtered while a stylus is used, when palms are the most likely.
+        leaveFastPath();
+    }
     if (touchOnlyArgs) {
         mSuppressedPointerIds = detectPalmPointers(*touchOnlyArgs);
     } else {
@@ -740,6 +825,15 @@ std::string PalmRejector::dump() const {
     std::stringstream state;
     state << *mSharedPalmState;
     out += "mSharedPalmState: " + state.str() + "\n";
+    out += StringPrintf("mFastPath: %s, %zu held touches\n", toString(mFastPath),
+                        mHeldTouches.size());
+    out += StringPrintf("Filter cost: %zu events filtered, %zu events skipped, average %.1fus, "
+                        "max %.1fus\n",
+                        mFilteredEventCount, mSkippedEventCount,
+                        mFilteredEventCount == 0
+                                ? 0.0
+                                : mTotalFilterTime / 1000.0 / mFilteredEventCount,
+                        mMaxFilterTime / 1000.0);
     std::stringstream filter;
     filter << static_cast<const PalmFilterImplementation&>(*mPalmDetectionFilter);
     out += "mPalmDetectionFilter:\n";
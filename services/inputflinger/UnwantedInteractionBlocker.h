@@ -119,10 +119,10 @@ private:
     // Use a separate palm rejector for every touch device.
     std::map<int32_t /*deviceId*/, PalmRejector> mPalmRejectors GUARDED_BY(mLock);
     // TODO(b/210159205): delete this when simultaneous stylus and touch is supported
-    void notifyMotionLocked(const NotifyMotionArgs& args) REQUIRES(mLock);
+    void notifyMotionLocked(NotifyMotionArgs&& args) REQUIRES(mLock);
 
     // Call this function for outbound events so that they can be logged when logging is enabled.
-    void enqueueOutboundMotionLocked(const NotifyMotionArgs& args) REQUIRES(mLock);
+    void enqueueOutboundMotionLocked(NotifyMotionArgs&& args) REQUIRES(mLock);
 
     void onInputDevicesChanged(const std::vector<InputDeviceInfo>& inputDevices);
 };
@@ -183,6 +183,15 @@ private:
      * the incoming args! Also, it will call Filter(..), which has side-effects.
      */
     std::set<int32_t> detectPalmPointers(const NotifyMotionArgs& args);
+    // Whether the filter can be skipped for this event of a gesture with a single touch, because
+    // the touch is small and far from the edges of the screen, where the palms or the grip of
+    // the hand touch the screen.
+    bool isFastPathEligible(const NotifyMotionArgs& args) const;
+    // Sends the touches held on the fast path to the filter, for the gestures which stop being
+    // eligible for it, so that the filter sees their whole stroke.
+    void leaveFastPath();
+    void filter(const std::vector<::ui::InProgressTouchEvdev>& touches, ::base::TimeTicks time,
+                std::bitset<::ui::kNumTouchEvdevSlots>* slotsToSuppress);
     std::unique_ptr<::ui::SharedPalmDetectionFilterState> mSharedPalmState;
     AndroidPalmFilterDeviceInfo mDeviceInfo;
     std::unique_ptr<::ui::PalmDetectionFilter> mPalmDetectionFilter;
@@ -190,6 +199,21 @@ private:
 
     // Used to help convert an Android touch stream to Linux input stream.
     SlotState mSlotState;
+    // Reused for every event, so that converting an event does not allocate.
+    std::vector<std::optional<size_t>> mOldSlots;
+    std::vector<::ui::InProgressTouchEvdev> mTouches;
+
+    // Whether the current gesture is on the fast path, and the touches which were not sent to the
+    // filter because of it, as long as they are held.
+    bool mFastPath = false;
+    bool mHoldTouches = false;
+    std::vector<std::pair<::base::TimeTicks, ::ui::InProgressTouchEvdev>> mHeldTouches;
+
+    // The cost of the filter, for dumpsys.
+    size_t mFilteredEventCount = 0;
+    size_t mSkippedEventCount = 0;
+    nsecs_t mTotalFilterTime = 0;
+    nsecs_t mMaxFilterTime = 0;
 };
 
 } // namespace android
@@ -19,8 +19,26 @@
 #include <android/os/IInputConstants.h>
 #include <binder/Binder.h>
 #include <gui/constants.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include "../dispatcher/InputDispatcher.h"
 
+// Counts the allocations of all the threads, so that the benchmarks report the allocations made
+// to dispatch each event.
+static std::atomic<int64_t> gAllocationCount = 0;
+
+void* operator new(size_t size) {
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size);
+    LOG_ALWAYS_FATAL_IF(p == nullptr, "Could not allocate %zu bytes", size);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
 using android::base::Result;
 using android::gui::WindowInfo;
 using android::gui::WindowInfoHandle;
@@ -44,6 +62,14 @@ static nsecs_t now() {
     return systemTime(SYSTEM_TIME_MONOTONIC);
 }
 
+// Reports the allocations made since the given allocation count, per event sent by the benchmark.
+static void reportAllocationsPerEvent(benchmark::State& state, int64_t startAllocationCount,
+                                      int64_t eventsPerIteration) {
+    const int64_t allocationCount = gAllocationCount.load() - startAllocationCount;
+    state.counters["allocs/event"] =
+            static_cast<double>(allocationCount) / (state.iterations() * eventsPerIteration);
+}
+
 // --- FakeInputDispatcherPolicy ---
 
 class FakeInputDispatcherPolicy : public InputDispatcherPolicyInterface {
@@ -171,8 +197,9 @@ public:
     static const int32_t HEIGHT = 200;
 
     FakeWindowHandle(const std::shared_ptr<InputApplicationHandle>& inputApplicationHandle,
-                     InputDispatcher& dispatcher, const std::string name)
-          : FakeInputReceiver(dispatcher, name), mFrame(Rect(0, 0, WIDTH, HEIGHT)) {
+                     InputDispatcher& dispatcher, const std::string name,
+                     const Rect& frame = Rect(0, 0, WIDTH, HEIGHT))
+          : FakeInputReceiver(dispatcher, name), mFrame(frame) {
         inputApplicationHandle->updateInfo();
         updateInfo();
         mInfo.applicationInfo = *inputApplicationHandle->getInfo();
@@ -194,6 +221,11 @@ public:
         mInfo.displayId = ADISPLAY_ID_DEFAULT;
     }
 
+    void setSpy() {
+        mInfo.setInputConfig(WindowInfo::InputConfig::SPY, true);
+        mInfo.setInputConfig(WindowInfo::InputConfig::TRUSTED_OVERLAY, true);
+    }
+
 protected:
     Rect mFrame;
 };
@@ -269,6 +301,7 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
 
     NotifyMotionArgs motionArgs = generateMotionArgs();
 
+    const int64_t startAllocationCount = gAllocationCount.load();
     for (auto _ : state) {
         // Send ACTION_DOWN
         motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
@@ -284,6 +317,117 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
         window->consumeEvent();
         window->consumeEvent();
     }
+    reportAllocationsPerEvent(state, startAllocationCount, /*eventsPerIteration=*/2);
+
+    dispatcher.stop();
+}
+
+// Sends the touches to a window behind the given number of small windows, which tile the display
+// away from the touches, so that the dispatcher has to find the touched window among them.
+static void benchmarkNotifyMotionManyWindows(benchmark::State& state) {
+    static constexpr int32_t DISPLAY_WIDTH = 1080;
+    static constexpr int32_t DISPLAY_HEIGHT = 2340;
+    static constexpr int32_t TILE_SIZE = 50;
+    const int32_t tileCount = static_cast<int32_t>(state.range(0));
+
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    InputDispatcher dispatcher(fakePolicy);
+    dispatcher.setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher.start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<WindowInfoHandle>> windows;
+    // The tiles start below the touches, which are at (100, 100).
+    static constexpr int32_t COLUMNS = DISPLAY_WIDTH / TILE_SIZE;
+    for (int32_t i = 0; i < tileCount; i++) {
+        const int32_t left = (i % COLUMNS) * TILE_SIZE;
+        const int32_t top = HEIGHT + ((i / COLUMNS) * TILE_SIZE) % (DISPLAY_HEIGHT - HEIGHT);
+        windows.push_back(sp<FakeWindowHandle>::make(application, dispatcher,
+                                                     "Tile " + std::to_string(i),
+                                                     Rect(left, top, left + TILE_SIZE,
+                                                          top + TILE_SIZE)));
+    }
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Fake Window",
+                                       Rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    windows.push_back(window);
+
+    dispatcher.setInputWindows({{ADISPLAY_ID_DEFAULT, windows}});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+
+    const int64_t startAllocationCount = gAllocationCount.load();
+    for (auto _ : state) {
+        // Send ACTION_DOWN
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher.notifyMotion(motionArgs);
+
+        // Send ACTION_UP
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        dispatcher.notifyMotion(motionArgs);
+
+        window->consumeEvent();
+        window->consumeEvent();
+    }
+    reportAllocationsPerEvent(state, startAllocationCount, /*eventsPerIteration=*/2);
+
+    dispatcher.stop();
+}
+
+// Measures how long notifyMotion blocks the caller, while the dispatcher thread sends the previous
+// events to a window and the given number of spy windows.
+static void benchmarkNotifyMotionLatency(benchmark::State& state) {
+    const int32_t spyWindowCount = static_cast<int32_t>(state.range(0));
+
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    InputDispatcher dispatcher(fakePolicy);
+    dispatcher.setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher.start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<FakeWindowHandle>> windows;
+    for (int32_t i = 0; i < spyWindowCount; i++) {
+        sp<FakeWindowHandle> spy =
+                sp<FakeWindowHandle>::make(application, dispatcher, "Spy " + std::to_string(i));
+        spy->setSpy();
+        windows.push_back(spy);
+    }
+    windows.push_back(sp<FakeWindowHandle>::make(application, dispatcher, "Fake Window"));
+    dispatcher.setInputWindows(
+            {{ADISPLAY_ID_DEFAULT, std::vector<sp<WindowInfoHandle>>(windows.begin(),
+                                                                     windows.end())}});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+
+    std::vector<nsecs_t> latencies;
+    for (auto _ : state) {
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher.notifyMotion(motionArgs);
+
+        // The dispatcher thread dispatches the ACTION_DOWN while the ACTION_UP is notified.
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        const nsecs_t notifyStartTime = now();
+        dispatcher.notifyMotion(motionArgs);
+        latencies.push_back(now() - notifyStartTime);
+
+        for (const sp<FakeWindowHandle>& window : windows) {
+            window->consumeEvent();
+            window->consumeEvent();
+        }
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p50_notify_ns"] = latencies[latencies.size() / 2];
+        state.counters["p99_notify_ns"] = latencies[latencies.size() * 99 / 100];
+    }
 
     dispatcher.stop();
 }
@@ -302,6 +446,7 @@ static void benchmarkInjectMotion(benchmark::State& state) {
 
     dispatcher.setInputWindows({{ADISPLAY_ID_DEFAULT, {window}}});
 
+    const int64_t startAllocationCount = gAllocationCount.load();
     for (auto _ : state) {
         MotionEvent event = generateMotionEvent();
         // Send ACTION_DOWN
@@ -318,6 +463,7 @@ static void benchmarkInjectMotion(benchmark::State& state) {
         window->consumeEvent();
         window->consumeEvent();
     }
+    reportAllocationsPerEvent(state, startAllocationCount, /*eventsPerIteration=*/2);
 
     dispatcher.stop();
 }
@@ -349,6 +495,8 @@ static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
 }
 
 BENCHMARK(benchmarkNotifyMotion);
+BENCHMARK(benchmarkNotifyMotionManyWindows)->ArgName("windows")->Arg(10)->Arg(100)->Arg(500);
+BENCHMARK(benchmarkNotifyMotionLatency)->ArgName("spies")->Arg(0)->Arg(10);
 BENCHMARK(benchmarkInjectMotion);
 BENCHMARK(benchmarkOnWindowInfosChanged);
 
@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <gui/constants.h>
+#include <linux/input.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#include "FakeEventHub.h"
+#include "FakeInputReaderPolicy.h"
+#include "FakePointerController.h"
+#include "InstrumentedInputReader.h"
+
+// Counts the heap allocations of the process, to report those made for each event.
+static std::atomic<size_t> gAllocationCount = 0;
+
+void* operator new(size_t size) {
+    gAllocationCount++;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+namespace android {
+
+// An arbitrary event hub device id.
+constexpr int32_t EVENTHUB_ID = 1;
+
+constexpr int32_t DISPLAY_WIDTH = 1080;
+constexpr int32_t DISPLAY_HEIGHT = 2340;
+
+// --- NullInputListener ---
+
+// Drops the notifications of the reader, so that only the reader itself is measured.
+class NullInputListener : public InputListenerInterface {
+public:
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs&) override {}
+    void notifyConfigurationChanged(const NotifyConfigurationChangedArgs&) override {}
+    void notifyKey(const NotifyKeyArgs&) override {}
+    void notifyMotion(const NotifyMotionArgs&) override {}
+    void notifySwitch(const NotifySwitchArgs&) override {}
+    void notifySensor(const NotifySensorArgs&) override {}
+    void notifyVibratorState(const NotifyVibratorStateArgs&) override {}
+    void notifyDeviceReset(const NotifyDeviceResetArgs&) override {}
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs&) override {}
+};
+
+// --- PassThroughStage ---
+
+// Queues the notifications and flushes them to the next listener, like the stages between the
+// reader and the dispatcher do with the events they don't change.
+class PassThroughStage : public InputListenerInterface {
+public:
+    explicit PassThroughStage(InputListenerInterface& listener) : mQueuedListener(listener) {}
+
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) override {
+        mQueuedListener.notifyInputDevicesChanged(args);
+        mQueuedListener.flush();
+    }
+    void notifyConfigurationChanged(const NotifyConfigurationChangedArgs& args) override {
+        mQueuedListener.notifyConfigurationChanged(args);
+        mQueuedListener.flush();
+    }
+    void notifyKey(const NotifyKeyArgs& args) override {
+        mQueuedListener.notifyKey(args);
+        mQueuedListener.flush();
+    }
+    void notifyMotion(const NotifyMotionArgs& args) override {
+        mQueuedListener.notifyMotion(args);
+        mQueuedListener.flush();
+    }
+    void notifySwitch(const NotifySwitchArgs& args) override {
+        mQueuedListener.notifySwitch(args);
+        mQueuedListener.flush();
+    }
+    void notifySensor(const NotifySensorArgs& args) override {
+        mQueuedListener.notifySensor(args);
+        mQueuedListener.flush();
+    }
+    void notifyVibratorState(const NotifyVibratorStateArgs& args) override {
+        mQueuedListener.notifyVibratorState(args);
+        mQueuedListener.flush();
+    }
+    void notifyDeviceReset(const NotifyDeviceResetArgs& args) override {
+        mQueuedListener.notifyDeviceReset(args);
+        mQueuedListener.flush();
+    }
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs& args) override {
+        mQueuedListener.notifyPointerCaptureChanged(args);
+        mQueuedListener.flush();
+    }
+
+private:
+    QueuedInputListener mQueuedListener;
+};
+
+// --- CountingInputListener ---
+
+// Counts the motion events that reach the end of the pipeline.
+class CountingInputListener : public NullInputListener {
+public:
+    void notifyMotion(const NotifyMotionArgs&) override { mMotionCount++; }
+
+    size_t getMotionCount() const { return mMotionCount; }
+
+private:
+    size_t mMotionCount = 0;
+};
+
+// --- Touchpad recordings ---
+
+constexpr int32_t TOUCHPAD_WIDTH = 2000;
+constexpr int32_t TOUCHPAD_HEIGHT = 1000;
+constexpr nsecs_t TOUCHPAD_FRAME_PERIOD = 10 * 1000000; // 100Hz
+
+// An evdev event as recorded from a touchpad, e.g. with getevent -lt.
+struct RecordedEvent {
+    nsecs_t when;
+    int32_t type;
+    int32_t code;
+    int32_t value;
+};
+
+// A stream in the shape of a touchpad recording with the slot protocol: the given number of fingers
+// touch down, move together across the touchpad for the given number of frames, and lift. One
+// finger moves the pointer, two scroll and three swipe.
+static std::vector<RecordedEvent> recordTouchpadSwipe(int32_t fingerCount, int32_t frameCount) {
+    static constexpr int32_t TOOL_CODES[] = {BTN_TOOL_FINGER, BTN_TOOL_DOUBLETAP,
+                                             BTN_TOOL_TRIPLETAP};
+    const int32_t toolCode = TOOL_CODES[fingerCount - 1];
+
+    std::vector<RecordedEvent> events;
+    for (int32_t frame = 0; frame <= frameCount; frame++) {
+        const nsecs_t when = frame * TOUCHPAD_FRAME_PERIOD;
+        for (int32_t finger = 0; finger < fingerCount; finger++) {
+            events.push_back({when, EV_ABS, ABS_MT_SLOT, finger});
+            if (frame == frameCount) {
+                events.push_back({when, EV_ABS, ABS_MT_TRACKING_ID, -1});
+                continue;
+            }
+            if (frame == 0) {
+                events.push_back({when, EV_ABS, ABS_MT_TRACKING_ID, finger});
+            }
+            events.push_back({when, EV_ABS, ABS_MT_POSITION_X, 200 + finger * 300 + frame * 12});
+            events.push_back({when, EV_ABS, ABS_MT_POSITION_Y, 300 + frame * 5});
+            events.push_back({when, EV_ABS, ABS_MT_PRESSURE, 60 + finger});
+        }
+        if (frame == 0 || frame == frameCount) {
+            const int32_t down = frame == 0 ? 1 : 0;
+            events.push_back({when, EV_KEY, BTN_TOUCH, down});
+            events.push_back({when, EV_KEY, toolCode, down});
+        }
+        events.push_back({when, EV_MSC, MSC_TIMESTAMP, static_cast<int32_t>(when / 1000)});
+        events.push_back({when, EV_SYN, SYN_REPORT, 0});
+    }
+    return events;
+}
+
+// --- Benchmarks ---
+
+// Sends frames of a multi-touch gesture with the given number of pointers through the reader,
+// which accumulates, cooks and dispatches the pointers of each frame.
+static void benchmarkMultiTouchFrames(benchmark::State& state) {
+    const int32_t pointerCount = state.range(0);
+
+    std::shared_ptr<FakeEventHub> eventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    policy->addDisplayViewport(ADISPLAY_ID_DEFAULT, DISPLAY_WIDTH, DISPLAY_HEIGHT, ui::ROTATION_0,
+                               /*isActive=*/true, "local:0", /*physicalPort=*/std::nullopt,
+                               ViewportType::INTERNAL);
+    NullInputListener listener;
+    InstrumentedInputReader reader(eventHub, policy, listener);
+
+    eventHub->addDevice(EVENTHUB_ID, "touchscreen",
+                        InputDeviceClass::TOUCH | InputDeviceClass::TOUCH_MT);
+    eventHub->addConfigurationProperty(EVENTHUB_ID, "touch.deviceType", "touchScreen");
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_X, 0, DISPLAY_WIDTH - 1, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_Y, 0, DISPLAY_HEIGHT - 1, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TOUCH_MAJOR, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_PRESSURE, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TRACKING_ID, 0, MAX_POINTER_ID, 0, 0);
+    eventHub->finishDeviceScan();
+    reader.loopOnce();
+
+    nsecs_t when = 0;
+    int32_t frame = 0;
+    for (auto _ : state) {
+        when += 4 * 1000000; // 250Hz
+        const int32_t offset = frame++ % 100;
+        for (int32_t i = 0; i < pointerCount; i++) {
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_TRACKING_ID, i);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_POSITION_X,
+                                   100 + i * 80 + offset);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_POSITION_Y,
+                                   200 + i * 150 + offset);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_TOUCH_MAJOR,
+                                   20 + i);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_PRESSURE, 100 + i);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_SYN, SYN_MT_REPORT, 0);
+        }
+        eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_SYN, SYN_REPORT, 0);
+        reader.loopOnce();
+    }
+}
+BENCHMARK(benchmarkMultiTouchFrames)->ArgName("pointers")->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+
+// Sends MOVE events of a touch with the given number of pointers through the reader and two
+// stages that pass them along, like the blocker and the processor do for most events. Reports the
+// heap allocations made for each MOVE event from the evdev frame to the end of the pipeline,
+// including those of the fake event hub queueing the frame.
+static void benchmarkMovePipeline(benchmark::State& state) {
+    const int32_t pointerCount = state.range(0);
+
+    std::shared_ptr<FakeEventHub> eventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    policy->addDisplayViewport(ADISPLAY_ID_DEFAULT, DISPLAY_WIDTH, DISPLAY_HEIGHT, ui::ROTATION_0,
+                               /*isActive=*/true, "local:0", /*physicalPort=*/std::nullopt,
+                               ViewportType::INTERNAL);
+    CountingInputListener listener;
+    PassThroughStage processor(listener);
+    PassThroughStage blocker(processor);
+    InstrumentedInputReader reader(eventHub, policy, blocker);
+
+    eventHub->addDevice(EVENTHUB_ID, "touchscreen",
+                        InputDeviceClass::TOUCH | InputDeviceClass::TOUCH_MT);
+    eventHub->addConfigurationProperty(EVENTHUB_ID, "touch.deviceType", "touchScreen");
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_X, 0, DISPLAY_WIDTH - 1, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_Y, 0, DISPLAY_HEIGHT - 1, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TRACKING_ID, 0, MAX_POINTER_ID, 0, 0);
+    eventHub->finishDeviceScan();
+    reader.loopOnce();
+
+    // Put the pointers down, so that every following frame is a MOVE.
+    auto enqueueFrame = [&](nsecs_t when, int32_t offset) {
+        for (int32_t i = 0; i < pointerCount; i++) {
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_TRACKING_ID, i);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_POSITION_X,
+                                   100 + i * 80 + offset);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_POSITION_Y,
+                                   200 + i * 150 + offset);
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_SYN, SYN_MT_REPORT, 0);
+        }
+        eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_SYN, SYN_REPORT, 0);
+        reader.loopOnce();
+    };
+    nsecs_t when = 0;
+    enqueueFrame(when, 0);
+    const size_t firstMotion = listener.getMotionCount();
+
+    int32_t frame = 0;
+    size_t allocationCount = 0;
+    for (auto _ : state) {
+        when += 4 * 1000000; // 250Hz
+        const size_t allocationsBefore = gAllocationCount;
+        enqueueFrame(when, 1 + frame++ % 100);
+        allocationCount += gAllocationCount - allocationsBefore;
+    }
+
+    const auto moveCount = static_cast<double>(listener.getMotionCount() - firstMotion);
+    state.counters["allocsPerMove"] = static_cast<double>(allocationCount) / moveCount;
+    state.SetItemsProcessed(static_cast<int64_t>(moveCount));
+}
+BENCHMARK(benchmarkMovePipeline)->ArgName("pointers")->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+
+// Replays a touchpad recording with the given number of fingers through the reader, which converts
+// each frame into a HardwareState for the gestures library, and its gestures into motion events.
+static void benchmarkTouchpadStream(benchmark::State& state) {
+    const int32_t fingerCount = state.range(0);
+    constexpr int32_t FRAME_COUNT = 100;
+
+    std::shared_ptr<FakeEventHub> eventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    policy->addDisplayViewport(ADISPLAY_ID_DEFAULT, DISPLAY_WIDTH, DISPLAY_HEIGHT, ui::ROTATION_0,
+                               /*isActive=*/true, "local:0", /*physicalPort=*/std::nullopt,
+                               ViewportType::INTERNAL);
+    std::shared_ptr<FakePointerController> pointerController =
+            std::make_shared<FakePointerController>();
+    pointerController->setBounds(0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+    policy->setPointerController(pointerController);
+    NullInputListener listener;
+    InstrumentedInputReader reader(eventHub, policy, listener);
+
+    eventHub->addDevice(EVENTHUB_ID, "touchpad",
+                        InputDeviceClass::TOUCH | InputDeviceClass::TOUCH_MT |
+                                InputDeviceClass::TOUCHPAD);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_SLOT, 0, 4, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_X, 0, TOUCHPAD_WIDTH, 0, 0,
+                              /*resolution=*/24);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_Y, 0, TOUCHPAD_HEIGHT, 0, 0,
+                              /*resolution=*/24);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_PRESSURE, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TRACKING_ID, 0, 65535, 0, 0);
+    for (int32_t scanCode : {BTN_LEFT, BTN_TOUCH, BTN_TOOL_FINGER, BTN_TOOL_DOUBLETAP,
+                             BTN_TOOL_TRIPLETAP}) {
+        eventHub->addKey(EVENTHUB_ID, scanCode, /*usageCode=*/0, AKEYCODE_UNKNOWN, /*flags=*/0);
+    }
+    eventHub->finishDeviceScan();
+    reader.loopOnce();
+
+    const std::vector<RecordedEvent> recording = recordTouchpadSwipe(fingerCount, FRAME_COUNT);
+    // The recording replays after itself, after a frame without touches.
+    const nsecs_t recordingDuration = recording.back().when + 2 * TOUCHPAD_FRAME_PERIOD;
+
+    nsecs_t offset = 0;
+    for (auto _ : state) {
+        for (const RecordedEvent& event : recording) {
+            const nsecs_t when = offset + event.when;
+            // The hardware timestamps keep increasing across replays, in microseconds.
+            const int32_t value = event.type == EV_MSC && event.code == MSC_TIMESTAMP
+                    ? static_cast<int32_t>(when / 1000)
+                    : event.value;
+            eventHub->enqueueEvent(when, when, EVENTHUB_ID, event.type, event.code, value);
+            if (event.type == EV_SYN && event.code == SYN_REPORT) {
+                reader.loopOnce();
+            }
+        }
+        offset += recordingDuration;
+    }
+    state.SetItemsProcessed(state.iterations() * (FRAME_COUNT + 1));
+}
+BENCHMARK(benchmarkTouchpadStream)->ArgName("fingers")->Arg(1)->Arg(2)->Arg(3);
+
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -52,6 +52,11 @@ public:
     // application consumes some of the input.
     bool responsive = true;
 
+    // True while the dispatcher thread publishes events to this connection without holding the
+    // dispatcher lock. The dispatch cycle is restarted once the events are published, so that the
+    // events enqueued meanwhile are published after them.
+    bool publishing = false;
+
     // Queue of events that need to be published to the connection.
     std::deque<DispatchEntry*> outboundQueue;
 
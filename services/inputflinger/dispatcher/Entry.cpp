@@ -20,6 +20,7 @@
 
 #include "Connection.h"
 #include "DebugConfig.h"
+#include "EntryPool.h"
 
 #include <android-base/stringprintf.h>
 #include <cutils/atomic.h>
@@ -332,6 +333,21 @@ uint32_t DispatchEntry::nextSeq() {
     return seq;
 }
 
+void* DispatchEntry::operator new(size_t size) {
+    if (size != sizeof(DispatchEntry)) {
+        return ::operator new(size);
+    }
+    return getFixedSizePool<sizeof(DispatchEntry)>().allocate();
+}
+
+void DispatchEntry::operator delete(void* p, size_t size) {
+    if (size != sizeof(DispatchEntry)) {
+        ::operator delete(p);
+        return;
+    }
+    getFixedSizePool<sizeof(DispatchEntry)>().deallocate(p);
+}
+
 std::ostream& operator<<(std::ostream& out, const DispatchEntry& entry) {
     out << "DispatchEntry{resolvedAction=";
     switch (entry.eventEntry->type) {
@@ -248,6 +248,11 @@ struct DispatchEntry {
 
     inline bool isSplit() const { return targetFlags.test(InputTarget::Flags::SPLIT); }
 
+    // A dispatch entry is created for every target of every event, so they are allocated from a
+    // pool.
+    static void* operator new(size_t size);
+    static void operator delete(void* p, size_t size);
+
 private:
     static volatile int32_t sNextSeqAtomic;
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EntryPool.h"
+
+#include <new>
+
+namespace android::inputdispatcher {
+
+FixedSizePool::FixedSizePool(size_t blockSize) : mBlockSize(blockSize) {
+    // Releasing a block never allocates.
+    mFreeBlocks.reserve(MAX_FREE_BLOCKS);
+}
+
+FixedSizePool::~FixedSizePool() {
+    for (void* block : mFreeBlocks) {
+        ::operator delete(block);
+    }
+}
+
+void* FixedSizePool::allocate() {
+    {
+        std::scoped_lock lock(mLock);
+        if (!mFreeBlocks.empty()) {
+            void* block = mFreeBlocks.back();
+            mFreeBlocks.pop_back();
+            return block;
+        }
+    }
+    return ::operator new(mBlockSize);
+}
+
+void FixedSizePool::deallocate(void* block) {
+    {
+        std::scoped_lock lock(mLock);
+        if (mFreeBlocks.size() < MAX_FREE_BLOCKS) {
+            mFreeBlocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+size_t FixedSizePool::getFreeBlockCount() const {
+    std::scoped_lock lock(mLock);
+    return mFreeBlocks.size();
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * A pool of memory blocks of a fixed size, for the entries which the dispatcher allocates and
+ * releases for every event.
+ *
+ * The released blocks are kept, up to a maximum number, for the next allocations, so that a
+ * stream of events reuses the same few blocks rather than going through the heap for each of
+ * its events. The entries are created on the threads which notify the dispatcher and released
+ * on the dispatcher thread, so the pool is thread-safe.
+ */
+class FixedSizePool {
+public:
+    explicit FixedSizePool(size_t blockSize);
+    ~FixedSizePool();
+
+    void* allocate();
+    void deallocate(void* block);
+
+    // The number of released blocks which the pool keeps for the next allocations.
+    size_t getFreeBlockCount() const;
+
+private:
+    static constexpr size_t MAX_FREE_BLOCKS = 64;
+
+    const size_t mBlockSize;
+    mutable std::mutex mLock;
+    std::vector<void*> mFreeBlocks GUARDED_BY(mLock);
+};
+
+// Returns the pool of the blocks of the given size. The pools are never destroyed, since the
+// entries can be released by the destructors of other static objects.
+template <size_t BlockSize>
+FixedSizePool& getFixedSizePool() {
+    static FixedSizePool* sPool = new FixedSizePool(BlockSize);
+    return *sPool;
+}
+
+/**
+ * An allocator which allocates the single objects from the pool of their size, for use with
+ * std::allocate_shared, so that an entry and the control block of its shared pointer take a
+ * single pool block.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Pool blocks are not aligned enough");
+
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n != 1) {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(getFixedSizePool<sizeof(T)>().allocate());
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n != 1) {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        getFixedSizePool<sizeof(T)>().deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const {
+        return false;
+    }
+};
+
+// Creates the entry, together with its shared pointer control block, in a pool block.
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooledEntry(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace android::inputdispatcher
@@ -39,6 +39,7 @@
 #include <cerrno>
 #include <cinttypes>
 #include <climits>
+#include <cmath>
 #include <cstddef>
 #include <ctime>
 #include <queue>
@@ -46,6 +47,7 @@
 
 #include "Connection.h"
 #include "DebugConfig.h"
+#include "EntryPool.h"
 #include "InputDispatcher.h"
 
 #define INDENT "  "
@@ -379,18 +381,18 @@ std::unique_ptr<DispatchEntry> createDispatchEntry(
         pointerCoords[pointerIndex].transform(inverseFirstTransform);
     }
 
-    std::unique_ptr<MotionEntry> combinedMotionEntry =
-            std::make_unique<MotionEntry>(motionEntry.id, motionEntry.eventTime,
-                                          motionEntry.deviceId, motionEntry.source,
-                                          motionEntry.displayId, motionEntry.policyFlags,
-                                          motionEntry.action, motionEntry.actionButton,
-                                          motionEntry.flags, motionEntry.metaState,
-                                          motionEntry.buttonState, motionEntry.classification,
-                                          motionEntry.edgeFlags, motionEntry.xPrecision,
-                                          motionEntry.yPrecision, motionEntry.xCursorPosition,
-                                          motionEntry.yCursorPosition, motionEntry.downTime,
-                                          motionEntry.pointerCount, motionEntry.pointerProperties,
-                                          pointerCoords.data());
+    std::shared_ptr<MotionEntry> combinedMotionEntry =
+            makePooledEntry<MotionEntry>(motionEntry.id, motionEntry.eventTime,
+                                         motionEntry.deviceId, motionEntry.source,
+                                         motionEntry.displayId, motionEntry.policyFlags,
+                                         motionEntry.action, motionEntry.actionButton,
+                                         motionEntry.flags, motionEntry.metaState,
+                                         motionEntry.buttonState, motionEntry.classification,
+                                         motionEntry.edgeFlags, motionEntry.xPrecision,
+                                         motionEntry.yPrecision, motionEntry.xCursorPosition,
+                                         motionEntry.yCursorPosition, motionEntry.downTime,
+                                         motionEntry.pointerCount, motionEntry.pointerProperties,
+                                         pointerCoords.data());
 
     if (motionEntry.injectionState) {
         combinedMotionEntry->injectionState = motionEntry.injectionState;
@@ -512,9 +514,10 @@ bool isUserActivityEvent(const EventEntry& eventEntry) {
     }
 }
 
-// Returns true if the given window can accept pointer events at the given display location.
-bool windowAcceptsTouchAt(const WindowInfo& windowInfo, int32_t displayId, float x, float y,
-                          bool isStylus, const ui::Transform& displayTransform) {
+// Returns true if the given window can accept pointer events on the given display. Whether its
+// touchable region contains the location of the events is tested with a hit test, see
+// TouchableWindowIndex.
+bool windowAcceptsTouch(const WindowInfo& windowInfo, int32_t displayId, bool isStylus) {
     const auto inputConfig = windowInfo.inputConfig;
     if (windowInfo.displayId != displayId ||
         inputConfig.test(WindowInfo::InputConfig::NOT_VISIBLE)) {
@@ -524,19 +527,6 @@ bool windowAcceptsTouchAt(const WindowInfo& windowInfo, int32_t displayId, float
     if (inputConfig.test(WindowInfo::InputConfig::NOT_TOUCHABLE) && !windowCanInterceptTouch) {
         return false;
     }
-
-    // Window Manager works in the logical display coordinate space. When it specifies bounds for a
-    // window as (l, t, r, b), the range of x in [l, r) and y in [t, b) are considered to be inside
-    // the window. Points on the right and bottom edges should not be inside the window, so we need
-    // to be careful about performing a hit test when the display is rotated, since the "right" and
-    // "bottom" of the window will be different in the display (un-rotated) space compared to in the
-    // logical display in which WM determined the bounds. Perform the hit test in the logical
-    // display space to ensure these edges are considered correctly in all orientations.
-    const auto touchableRegion = displayTransform.transform(windowInfo.touchableRegion);
-    const auto p = displayTransform.transform(x, y);
-    if (!touchableRegion.contains(std::floor(p.x), std::floor(p.y))) {
-        return false;
-    }
     return true;
 }
 
@@ -708,6 +698,73 @@ void filterUntrustedTargets(TouchState& touchState, std::vector<InputTarget>& ta
     });
 }
 
+// The cursor positions of the events without a cursor are not numbers.
+bool isSameCursorPosition(float position, float otherPosition) {
+    return position == otherPosition || (std::isnan(position) && std::isnan(otherPosition));
+}
+
+// Whether the next entry can be published as a later sample in the message of the entry, which
+// only differs from it by its time and coordinates.
+bool canPublishAsLaterSample(const DispatchEntry& entry, const DispatchEntry& next) {
+    if (entry.eventEntry->type != EventEntry::Type::MOTION ||
+        next.eventEntry->type != EventEntry::Type::MOTION ||
+        (entry.resolvedAction != AMOTION_EVENT_ACTION_MOVE &&
+         entry.resolvedAction != AMOTION_EVENT_ACTION_HOVER_MOVE) ||
+        next.resolvedAction != entry.resolvedAction || next.resolvedFlags != entry.resolvedFlags ||
+        next.targetFlags != entry.targetFlags || !(next.transform == entry.transform) ||
+        !(next.rawTransform == entry.rawTransform) ||
+        next.globalScaleFactor != entry.globalScaleFactor) {
+        return false;
+    }
+    const MotionEntry& motionEntry = static_cast<const MotionEntry&>(*entry.eventEntry);
+    const MotionEntry& nextEntry = static_cast<const MotionEntry&>(*next.eventEntry);
+    if (nextEntry.deviceId != motionEntry.deviceId || nextEntry.source != motionEntry.source ||
+        nextEntry.displayId != motionEntry.displayId ||
+        nextEntry.actionButton != motionEntry.actionButton ||
+        nextEntry.edgeFlags != motionEntry.edgeFlags ||
+        nextEntry.metaState != motionEntry.metaState ||
+        nextEntry.buttonState != motionEntry.buttonState ||
+        nextEntry.classification != motionEntry.classification ||
+        nextEntry.xPrecision != motionEntry.xPrecision ||
+        nextEntry.yPrecision != motionEntry.yPrecision ||
+        !isSameCursorPosition(nextEntry.xCursorPosition, motionEntry.xCursorPosition) ||
+        !isSameCursorPosition(nextEntry.yCursorPosition, motionEntry.yCursorPosition) ||
+        nextEntry.downTime != motionEntry.downTime ||
+        nextEntry.eventTime < motionEntry.eventTime ||
+        nextEntry.pointerCount != motionEntry.pointerCount) {
+        return false;
+    }
+    for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
+        if (nextEntry.pointerProperties[i] != motionEntry.pointerProperties[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the entries which directly follow a MOVE entry, from begin to end, and which are
+// published as the later samples of its message. The app batches these samples anyway, so while
+// it is busy with the previous events, they are sent together.
+template <typename Iterator>
+std::vector<DispatchEntry*> getLaterMotionSamples(const DispatchEntry& dispatchEntry,
+                                                  Iterator begin, Iterator end) {
+    std::vector<DispatchEntry*> laterSamples;
+    if (dispatchEntry.eventEntry->type != EventEntry::Type::MOTION) {
+        return laterSamples;
+    }
+    const MotionEntry& motionEntry = static_cast<const MotionEntry&>(*dispatchEntry.eventEntry);
+    const size_t maxLaterSampleCount =
+            InputPublisher::getMaxMotionSampleCount(motionEntry.pointerCount) - 1;
+    for (Iterator it = begin; it != end && laterSamples.size() < maxLaterSampleCount; it++) {
+        const DispatchEntry* previous = laterSamples.empty() ? &dispatchEntry : laterSamples.back();
+        if (!canPublishAsLaterSample(*previous, **it)) {
+            break;
+        }
+        laterSamples.push_back(*it);
+    }
+    return laterSamples;
+}
+
 } // namespace
 
 // --- InputDispatcher ---
@@ -733,7 +790,10 @@ InputDispatcher::InputDispatcher(InputDispatcherPolicyInterface& policy,
         mWindowTokenWithPointerCapture(nullptr),
         mStaleEventTimeout(staleEventTimeout),
         mLatencyAggregator(),
-        mLatencyTracker(&mLatencyAggregator) {
+        mLatencyHistograms([this](const sp<IBinder>& connectionToken) REQUIRES(mLock) {
+            return getConnectionNameLocked(connectionToken);
+        }),
+        mLatencyTracker({&mLatencyAggregator, &mLatencyHistograms}) {
     mLooper = sp<Looper>::make(false);
     mReporter = createInputReporter();
 
@@ -778,10 +838,15 @@ status_t InputDispatcher::stop() {
 
 void InputDispatcher::dispatchOnce() {
     nsecs_t nextWakeupTime = LLONG_MAX;
+    std::vector<PendingPublish> pendingPublishes;
     { // acquire lock
         std::scoped_lock _l(mLock);
         mDispatcherIsAlive.notify_all();
 
+        // Writing the events to the sockets of the connections is left until the lock is released,
+        // so that the threads notifying the dispatcher are not blocked behind it.
+        mDeferPublishing = true;
+
         // Run a dispatch loop if there are no pending commands.
         // The dispatch loop might enqueue commands to run afterwards.
         if (!haveCommandsLocked()) {
@@ -799,13 +864,31 @@ void InputDispatcher::dispatchOnce() {
         const nsecs_t nextAnrCheck = processAnrsLocked();
         nextWakeupTime = std::min(nextWakeupTime, nextAnrCheck);
 
+        mDeferPublishing = false;
+        pendingPublishes = takePendingPublishesLocked();
+
         // We are about to enter an infinitely long sleep, because we have no commands or
         // pending or queued events
-        if (nextWakeupTime == LLONG_MAX) {
+        if (nextWakeupTime == LLONG_MAX && pendingPublishes.empty()) {
             mDispatcherEnteredIdle.notify_all();
         }
     } // release lock
 
+    if (!pendingPublishes.empty()) {
+        publishPendingEntries(pendingPublishes);
+
+        std::scoped_lock _l(mLock);
+        finishPendingPublishesLocked(now(), pendingPublishes);
+        // The published events have to be checked for ANRs, and broken connections post commands.
+        if (haveCommandsLocked()) {
+            nextWakeupTime = LLONG_MIN;
+        }
+        nextWakeupTime = std::min(nextWakeupTime, processAnrsLocked());
+        if (nextWakeupTime == LLONG_MAX) {
+            mDispatcherEnteredIdle.notify_all();
+        }
+    }
+
     // Wait for callback or timeout or wake.  (make sure we round up, not down)
     nsecs_t currentTime = now();
     int timeoutMillis = toMillisecondTimeoutDelay(currentTime, nextWakeupTime);
@@ -1149,7 +1232,7 @@ bool InputDispatcher::shouldPruneInboundQueueLocked(const MotionEntry& motionEnt
     return false;
 }
 
-bool InputDispatcher::enqueueInboundEventLocked(std::unique_ptr<EventEntry> newEntry) {
+bool InputDispatcher::enqueueInboundEventLocked(std::shared_ptr<EventEntry> newEntry) {
     bool needWake = mInboundQueue.empty();
     mInboundQueue.push_back(std::move(newEntry));
     EventEntry& entry = *(mInboundQueue.back());
@@ -1238,14 +1321,16 @@ InputDispatcher::findTouchedWindowAtLocked(int32_t displayId, float x, float y,
     // Traverse windows from front to back to find touched window.
     std::vector<InputTarget> outsideTargets;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    TouchableWindowIndex::HitTest hitTest = hitTestWindowsLocked(displayId, x, y);
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[i];
         if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
             continue;
         }
 
         const WindowInfo& info = *windowHandle->getInfo();
-        if (!info.isSpy() &&
-            windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+        if (!info.isSpy() && windowAcceptsTouch(info, displayId, isStylus) &&
+            hitTest.touchableRegionContains(i)) {
             return {windowHandle, outsideTargets};
         }
 
@@ -1263,10 +1348,12 @@ std::vector<sp<WindowInfoHandle>> InputDispatcher::findTouchedSpyWindowsAtLocked
     // Traverse windows from front to back and gather the touched spy windows.
     std::vector<sp<WindowInfoHandle>> spyWindows;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    TouchableWindowIndex::HitTest hitTest = hitTestWindowsLocked(displayId, x, y);
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[i];
         const WindowInfo& info = *windowHandle->getInfo();
 
-        if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+        if (!windowAcceptsTouch(info, displayId, isStylus) || !hitTest.touchableRegionContains(i)) {
             continue;
         }
         if (!info.isSpy()) {
@@ -3500,37 +3587,64 @@ void InputDispatcher::dispatchPointerDownOutsideFocus(uint32_t source, int32_t a
     postCommandLocked(std::move(command));
 }
 
-status_t InputDispatcher::publishMotionEvent(Connection& connection,
-                                             DispatchEntry& dispatchEntry) const {
+status_t InputDispatcher::publishMotionEvent(
+        Connection& connection, DispatchEntry& dispatchEntry,
+        const std::vector<DispatchEntry*>& laterSamples) const {
     const EventEntry& eventEntry = *(dispatchEntry.eventEntry);
     const MotionEntry& motionEntry = static_cast<const MotionEntry&>(eventEntry);
 
+    // The coordinates of the samples, one after the other, which are only copied if they are
+    // scaled or cleared.
     PointerCoords scaledCoords[MAX_POINTERS];
     const PointerCoords* usingCoords = motionEntry.pointerCoords;
+    const uint32_t pointerCount = motionEntry.pointerCount;
+    const size_t sampleCount = laterSamples.size() + 1;
+    auto getEntry = [&](size_t sample) -> const MotionEntry& {
+        return sample == 0 ? motionEntry
+                           : static_cast<const MotionEntry&>(*laterSamples[sample - 1]->eventEntry);
+    };
+    bool copiedCoords = false;
 
     // Set the X and Y offset and X and Y scale depending on the input source.
     if ((motionEntry.source & AINPUT_SOURCE_CLASS_POINTER) &&
         !(dispatchEntry.targetFlags.test(InputTarget::Flags::ZERO_COORDS))) {
         float globalScaleFactor = dispatchEntry.globalScaleFactor;
         if (globalScaleFactor != 1.0f) {
-            for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
-                scaledCoords[i] = motionEntry.pointerCoords[i];
-                // Don't apply window scale here since we don't want scale to affect raw
-                // coordinates. The scale will be sent back to the client and applied
-                // later when requesting relative coordinates.
-                scaledCoords[i].scale(globalScaleFactor, /*windowXScale=*/1, /*windowYScale=*/1);
+            for (size_t sample = 0; sample < sampleCount; sample++) {
+                for (uint32_t i = 0; i < pointerCount; i++) {
+                    PointerCoords& coords = scaledCoords[sample * pointerCount + i];
+                    coords = getEntry(sample).pointerCoords[i];
+                    // Don't apply window scale here since we don't want scale to affect raw
+                    // coordinates. The scale will be sent back to the client and applied
+                    // later when requesting relative coordinates.
+                    coords.scale(globalScaleFactor, /*windowXScale=*/1, /*windowYScale=*/1);
+                }
             }
             usingCoords = scaledCoords;
+            copiedCoords = true;
         }
     } else if (dispatchEntry.targetFlags.test(InputTarget::Flags::ZERO_COORDS)) {
         // We don't want the dispatch target to know the coordinates
-        for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
+        for (size_t i = 0; i < sampleCount * pointerCount; i++) {
             scaledCoords[i].clear();
         }
         usingCoords = scaledCoords;
+        copiedCoords = true;
     }
 
     std::array<uint8_t, 32> hmac = getSignature(motionEntry, dispatchEntry);
+    std::vector<InputPublisher::MotionSample> samples;
+    samples.reserve(laterSamples.size());
+    for (size_t sample = 1; sample < sampleCount; sample++) {
+        const DispatchEntry& laterEntry = *laterSamples[sample - 1];
+        const MotionEntry& laterMotionEntry = getEntry(sample);
+        samples.push_back({.seq = laterEntry.seq,
+                           .eventId = laterEntry.resolvedEventId,
+                           .hmac = getSignature(laterMotionEntry, laterEntry),
+                           .eventTime = laterMotionEntry.eventTime,
+                           .pointerCoords = copiedCoords ? &scaledCoords[sample * pointerCount]
+                                                         : laterMotionEntry.pointerCoords});
+    }
 
     // Publish the motion event.
     return connection.inputPublisher
@@ -3545,7 +3659,75 @@ status_t InputDispatcher::publishMotionEvent(Connection& connection,
                                 motionEntry.yCursorPosition, dispatchEntry.rawTransform,
                                 motionEntry.downTime, motionEntry.eventTime,
                                 motionEntry.pointerCount, motionEntry.pointerProperties,
-                                usingCoords);
+                                usingCoords, samples);
+}
+
+status_t InputDispatcher::publishDispatchEntry(
+        Connection& connection, DispatchEntry& dispatchEntry,
+        const std::vector<DispatchEntry*>& laterSamples) const {
+    const EventEntry& eventEntry = *(dispatchEntry.eventEntry);
+    switch (eventEntry.type) {
+        case EventEntry::Type::KEY: {
+            const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
+            std::array<uint8_t, 32> hmac = getSignature(keyEntry, dispatchEntry);
+            if (DEBUG_OUTBOUND_EVENT_DETAILS) {
+                LOG(DEBUG) << "Publishing " << dispatchEntry << " to "
+                           << connection.getInputChannelName();
+            }
+
+            // Publish the key event.
+            return connection.inputPublisher
+                    .publishKeyEvent(dispatchEntry.seq, dispatchEntry.resolvedEventId,
+                                     keyEntry.deviceId, keyEntry.source, keyEntry.displayId,
+                                     std::move(hmac), dispatchEntry.resolvedAction,
+                                     dispatchEntry.resolvedFlags, keyEntry.keyCode,
+                                     keyEntry.scanCode, keyEntry.metaState, keyEntry.repeatCount,
+                                     keyEntry.downTime, keyEntry.eventTime);
+        }
+
+        case EventEntry::Type::MOTION: {
+            if (DEBUG_OUTBOUND_EVENT_DETAILS) {
+                LOG(DEBUG) << "Publishing " << dispatchEntry << " to "
+                           << connection.getInputChannelName();
+            }
+            return publishMotionEvent(connection, dispatchEntry, laterSamples);
+        }
+
+        case EventEntry::Type::FOCUS: {
+            const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
+            return connection.inputPublisher.publishFocusEvent(dispatchEntry.seq, focusEntry.id,
+                                                               focusEntry.hasFocus);
+        }
+
+        case EventEntry::Type::TOUCH_MODE_CHANGED: {
+            const TouchModeEntry& touchModeEntry = static_cast<const TouchModeEntry&>(eventEntry);
+            return connection.inputPublisher.publishTouchModeEvent(dispatchEntry.seq,
+                                                                   touchModeEntry.id,
+                                                                   touchModeEntry.inTouchMode);
+        }
+
+        case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
+            const auto& captureEntry = static_cast<const PointerCaptureChangedEntry&>(eventEntry);
+            return connection.inputPublisher
+                    .publishCaptureEvent(dispatchEntry.seq, captureEntry.id,
+                                         captureEntry.pointerCaptureRequest.enable);
+        }
+
+        case EventEntry::Type::DRAG: {
+            const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
+            return connection.inputPublisher.publishDragEvent(dispatchEntry.seq, dragEntry.id,
+                                                              dragEntry.x, dragEntry.y,
+                                                              dragEntry.isExiting);
+        }
+
+        case EventEntry::Type::CONFIGURATION_CHANGED:
+        case EventEntry::Type::DEVICE_RESET:
+        case EventEntry::Type::SENSOR: {
+            LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
+                             ftl::enum_string(eventEntry.type).c_str());
+            return BAD_VALUE;
+        }
+    }
 }
 
 void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
@@ -3558,6 +3740,10 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
     if (DEBUG_DISPATCH_CYCLE) {
         ALOGD("channel '%s' ~ startDispatchCycle", connection->getInputChannelName().c_str());
     }
+    if (connection->publishing && !mDeferPublishing) {
+        // The dispatcher thread restarts the cycle once it published its events.
+        return;
+    }
 
     while (connection->status == Connection::Status::NORMAL && !connection->outboundQueue.empty()) {
         DispatchEntry* dispatchEntry = connection->outboundQueue.front();
@@ -3565,126 +3751,166 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
         const std::chrono::nanoseconds timeout = getDispatchingTimeoutLocked(connection);
         dispatchEntry->timeoutTime = currentTime + timeout.count();
 
-        // Publish the event.
-        status_t status;
-        const EventEntry& eventEntry = *(dispatchEntry->eventEntry);
-        switch (eventEntry.type) {
-            case EventEntry::Type::KEY: {
-                const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
-                std::array<uint8_t, 32> hmac = getSignature(keyEntry, *dispatchEntry);
-                if (DEBUG_OUTBOUND_EVENT_DETAILS) {
-                    LOG(DEBUG) << "Publishing " << *dispatchEntry << " to "
-                               << connection->getInputChannelName();
-                }
-
-                // Publish the key event.
-                status = connection->inputPublisher
-                                 .publishKeyEvent(dispatchEntry->seq,
-                                                  dispatchEntry->resolvedEventId, keyEntry.deviceId,
-                                                  keyEntry.source, keyEntry.displayId,
-                                                  std::move(hmac), dispatchEntry->resolvedAction,
-                                                  dispatchEntry->resolvedFlags, keyEntry.keyCode,
-                                                  keyEntry.scanCode, keyEntry.metaState,
-                                                  keyEntry.repeatCount, keyEntry.downTime,
-                                                  keyEntry.eventTime);
-                break;
-            }
+        if (mDeferPublishing) {
+            connection->outboundQueue.pop_front();
+            traceOutboundQueueLength(*connection);
+            deferPublishLocked(connection, dispatchEntry);
+            continue;
+        }
 
-            case EventEntry::Type::MOTION: {
-                if (DEBUG_OUTBOUND_EVENT_DETAILS) {
-                    LOG(DEBUG) << "Publishing " << *dispatchEntry << " to "
-                               << connection->getInputChannelName();
-                }
-                status = publishMotionEvent(*connection, *dispatchEntry);
-                break;
-            }
+        // Publish the event, with the MOVE events which follow it while the app is busy.
+        std::vector<DispatchEntry*> laterSamples;
+        if (!connection->waitQueue.empty()) {
+            laterSamples = getLaterMotionSamples(*dispatchEntry,
+                                                 connection->outboundQueue.begin() + 1,
+                                                 connection->outboundQueue.end());
+        }
+        const status_t status = publishDispatchEntry(*connection, *dispatchEntry, laterSamples);
+        if (status) {
+            onPublishFailedLocked(currentTime, connection, status);
+            return;
+        }
 
-            case EventEntry::Type::FOCUS: {
-                const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
-                status = connection->inputPublisher.publishFocusEvent(dispatchEntry->seq,
-                                                                      focusEntry.id,
-                                                                      focusEntry.hasFocus);
-                break;
-            }
+        connection->outboundQueue.erase(std::remove(connection->outboundQueue.begin(),
+                                                    connection->outboundQueue.end(),
+                                                    dispatchEntry));
+        onDispatchEntryPublishedLocked(connection, dispatchEntry);
+        for (DispatchEntry* laterSample : laterSamples) {
+            laterSample->deliveryTime = dispatchEntry->deliveryTime;
+            laterSample->timeoutTime = dispatchEntry->timeoutTime;
+            connection->outboundQueue.pop_front();
+            onDispatchEntryPublishedLocked(connection, laterSample);
+        }
+        traceOutboundQueueLength(*connection);
+    }
+}
 
-            case EventEntry::Type::TOUCH_MODE_CHANGED: {
-                const TouchModeEntry& touchModeEntry =
-                        static_cast<const TouchModeEntry&>(eventEntry);
-                status = connection->inputPublisher
-                                 .publishTouchModeEvent(dispatchEntry->seq, touchModeEntry.id,
-                                                        touchModeEntry.inTouchMode);
+void InputDispatcher::onDispatchEntryPublishedLocked(const std::shared_ptr<Connection>& connection,
+                                                     DispatchEntry* dispatchEntry) {
+    // Re-enqueue the event on the wait queue.
+    connection->waitQueue.push_back(dispatchEntry);
+    if (connection->responsive) {
+        mAnrTracker.insert(dispatchEntry->timeoutTime,
+                           connection->inputChannel->getConnectionToken());
+    }
+    traceWaitQueueLength(*connection);
+}
 
-                break;
+void InputDispatcher::onPublishFailedLocked(nsecs_t currentTime,
+                                            const std::shared_ptr<Connection>& connection,
+                                            status_t status) {
+    if (status == WOULD_BLOCK) {
+        if (connection->waitQueue.empty()) {
+            ALOGE("channel '%s' ~ Could not publish event because the pipe is full. "
+                  "This is unexpected because the wait queue is empty, so the pipe "
+                  "should be empty and we shouldn't have any problems writing an "
+                  "event to it, status=%s(%d)",
+                  connection->getInputChannelName().c_str(), statusToString(status).c_str(),
+                  status);
+            abortBrokenDispatchCycleLocked(currentTime, connection, /*notify=*/true);
+        } else {
+            // Pipe is full and we are waiting for the app to finish process some events
+            // before sending more events to it.
+            if (DEBUG_DISPATCH_CYCLE) {
+                ALOGD("channel '%s' ~ Could not publish event because the pipe is full, "
+                      "waiting for the application to catch up",
+                      connection->getInputChannelName().c_str());
             }
+        }
+    } else {
+        ALOGE("channel '%s' ~ Could not publish event due to an unexpected error, "
+              "status=%s(%d)",
+              connection->getInputChannelName().c_str(), statusToString(status).c_str(), status);
+        abortBrokenDispatchCycleLocked(currentTime, connection, /*notify=*/true);
+    }
+}
 
-            case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
-                const auto& captureEntry =
-                        static_cast<const PointerCaptureChangedEntry&>(eventEntry);
-                status = connection->inputPublisher
-                                 .publishCaptureEvent(dispatchEntry->seq, captureEntry.id,
-                                                      captureEntry.pointerCaptureRequest.enable);
-                break;
+void InputDispatcher::deferPublishLocked(const std::shared_ptr<Connection>& connection,
+                                         DispatchEntry* dispatchEntry) {
+    if (connection->publishing) {
+        for (PendingPublish& pendingPublish : mPendingPublishes) {
+            if (pendingPublish.connection == connection) {
+                pendingPublish.dispatchEntries.push_back(dispatchEntry);
+                return;
             }
+        }
+    }
+    connection->publishing = true;
+    mPendingPublishes.push_back({.connection = connection, .dispatchEntries = {dispatchEntry}});
+}
 
-            case EventEntry::Type::DRAG: {
-                const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
-                status = connection->inputPublisher.publishDragEvent(dispatchEntry->seq,
-                                                                     dragEntry.id, dragEntry.x,
-                                                                     dragEntry.y,
-                                                                     dragEntry.isExiting);
-                break;
+std::vector<InputDispatcher::PendingPublish> InputDispatcher::takePendingPublishesLocked() {
+    std::vector<PendingPublish> pendingPublishes;
+    for (PendingPublish& pendingPublish : mPendingPublishes) {
+        if (pendingPublish.connection->status != Connection::Status::NORMAL) {
+            // The connection broke or was removed since the entries were taken off its queue.
+            pendingPublish.connection->publishing = false;
+            for (DispatchEntry* dispatchEntry : pendingPublish.dispatchEntries) {
+                releaseDispatchEntry(dispatchEntry);
             }
+            continue;
+        }
+        pendingPublish.hadUnfinishedEvents = !pendingPublish.connection->waitQueue.empty();
+        pendingPublishes.push_back(std::move(pendingPublish));
+    }
+    mPendingPublishes.clear();
+    return pendingPublishes;
+}
 
-            case EventEntry::Type::CONFIGURATION_CHANGED:
-            case EventEntry::Type::DEVICE_RESET:
-            case EventEntry::Type::SENSOR: {
-                LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
-                                 ftl::enum_string(eventEntry.type).c_str());
-                return;
+void InputDispatcher::publishPendingEntries(std::vector<PendingPublish>& pendingPublishes) const {
+    ATRACE_CALL();
+    // The entries are owned by the pending publishes, and the connections are only published to
+    // by this thread while they are marked as publishing, so they can be used without the lock.
+    for (PendingPublish& pendingPublish : pendingPublishes) {
+        const std::vector<DispatchEntry*>& dispatchEntries = pendingPublish.dispatchEntries;
+        // Once an entry is published, the app has an unfinished event.
+        bool packMotionSamples = pendingPublish.hadUnfinishedEvents;
+        while (pendingPublish.publishedCount < dispatchEntries.size()) {
+            const auto it = dispatchEntries.begin() + pendingPublish.publishedCount;
+            std::vector<DispatchEntry*> laterSamples;
+            if (packMotionSamples) {
+                laterSamples = getLaterMotionSamples(**it, it + 1, dispatchEntries.end());
+            }
+            pendingPublish.status =
+                    publishDispatchEntry(*pendingPublish.connection, **it, laterSamples);
+            if (pendingPublish.status) {
+                break;
             }
+            pendingPublish.publishedCount += laterSamples.size() + 1;
+            packMotionSamples = true;
         }
+    }
+}
 
-        // Check the result.
-        if (status) {
-            if (status == WOULD_BLOCK) {
-                if (connection->waitQueue.empty()) {
-                    ALOGE("channel '%s' ~ Could not publish event because the pipe is full. "
-                          "This is unexpected because the wait queue is empty, so the pipe "
-                          "should be empty and we shouldn't have any problems writing an "
-                          "event to it, status=%s(%d)",
-                          connection->getInputChannelName().c_str(), statusToString(status).c_str(),
-                          status);
-                    abortBrokenDispatchCycleLocked(currentTime, connection, /*notify=*/true);
-                } else {
-                    // Pipe is full and we are waiting for the app to finish process some events
-                    // before sending more events to it.
-                    if (DEBUG_DISPATCH_CYCLE) {
-                        ALOGD("channel '%s' ~ Could not publish event because the pipe is full, "
-                              "waiting for the application to catch up",
-                              connection->getInputChannelName().c_str());
-                    }
-                }
-            } else {
-                ALOGE("channel '%s' ~ Could not publish event due to an unexpected error, "
-                      "status=%s(%d)",
-                      connection->getInputChannelName().c_str(), statusToString(status).c_str(),
-                      status);
-                abortBrokenDispatchCycleLocked(currentTime, connection, /*notify=*/true);
+void InputDispatcher::finishPendingPublishesLocked(nsecs_t currentTime,
+                                                   std::vector<PendingPublish>& pendingPublishes) {
+    for (PendingPublish& pendingPublish : pendingPublishes) {
+        const std::shared_ptr<Connection>& connection = pendingPublish.connection;
+        std::vector<DispatchEntry*>& dispatchEntries = pendingPublish.dispatchEntries;
+        connection->publishing = false;
+        if (connection->status != Connection::Status::NORMAL) {
+            for (DispatchEntry* dispatchEntry : dispatchEntries) {
+                releaseDispatchEntry(dispatchEntry);
             }
-            return;
+            continue;
         }
 
-        // Re-enqueue the event on the wait queue.
-        connection->outboundQueue.erase(std::remove(connection->outboundQueue.begin(),
-                                                    connection->outboundQueue.end(),
-                                                    dispatchEntry));
-        traceOutboundQueueLength(*connection);
-        connection->waitQueue.push_back(dispatchEntry);
-        if (connection->responsive) {
-            mAnrTracker.insert(dispatchEntry->timeoutTime,
-                               connection->inputChannel->getConnectionToken());
+        for (size_t i = 0; i < pendingPublish.publishedCount; i++) {
+            onDispatchEntryPublishedLocked(connection, dispatchEntries[i]);
         }
-        traceWaitQueueLength(*connection);
+        if (pendingPublish.status) {
+            // The entries which were not published go back to the front of the outbound queue, in
+            // their order.
+            connection->outboundQueue.insert(connection->outboundQueue.begin(),
+                                             dispatchEntries.begin() +
+                                                     pendingPublish.publishedCount,
+                                             dispatchEntries.end());
+            traceOutboundQueueLength(*connection);
+            onPublishFailedLocked(currentTime, connection, pendingPublish.status);
+            continue;
+        }
+        // Publish the entries which were enqueued while the pending ones were published.
+        startDispatchCycleLocked(currentTime, connection);
     }
 }
 
@@ -4278,10 +4504,10 @@ void InputDispatcher::notifyKey(const NotifyKeyArgs& args) {
             mLock.lock();
         }
 
-        std::unique_ptr<KeyEntry> newEntry =
-                std::make_unique<KeyEntry>(args.id, args.eventTime, args.deviceId, args.source,
-                                           args.displayId, policyFlags, args.action, flags, keyCode,
-                                           args.scanCode, metaState, repeatCount, args.downTime);
+        std::shared_ptr<KeyEntry> newEntry =
+                makePooledEntry<KeyEntry>(args.id, args.eventTime, args.deviceId, args.source,
+                                          args.displayId, policyFlags, args.action, flags, keyCode,
+                                          args.scanCode, metaState, repeatCount, args.downTime);
 
         needWake = enqueueInboundEventLocked(std::move(newEntry));
         mLock.unlock();
@@ -4332,6 +4558,7 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
         return;
     }
 
+    const nsecs_t cookedTime = now();
     uint32_t policyFlags = args.policyFlags;
     policyFlags |= POLICY_FLAG_TRUSTED;
 
@@ -4383,21 +4610,22 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
         }
 
         // Just enqueue a new motion event.
-        std::unique_ptr<MotionEntry> newEntry =
-                std::make_unique<MotionEntry>(args.id, args.eventTime, args.deviceId, args.source,
-                                              args.displayId, policyFlags, args.action,
-                                              args.actionButton, args.flags, args.metaState,
-                                              args.buttonState, args.classification, args.edgeFlags,
-                                              args.xPrecision, args.yPrecision,
-                                              args.xCursorPosition, args.yCursorPosition,
-                                              args.downTime, args.pointerCount,
-                                              args.pointerProperties, args.pointerCoords);
+        std::shared_ptr<MotionEntry> newEntry =
+                makePooledEntry<MotionEntry>(args.id, args.eventTime, args.deviceId, args.source,
+                                             args.displayId, policyFlags, args.action,
+                                             args.actionButton, args.flags, args.metaState,
+                                             args.buttonState, args.classification, args.edgeFlags,
+                                             args.xPrecision, args.yPrecision,
+                                             args.xCursorPosition, args.yCursorPosition,
+                                             args.downTime, args.pointerCount,
+                                             args.pointerProperties, args.pointerCoords);
 
         if (args.id != android::os::IInputConstants::INVALID_INPUT_EVENT_ID &&
             IdGenerator::getSource(args.id) == IdGenerator::Source::INPUT_READER &&
             !mInputFilterEnabled) {
             const bool isDown = args.action == AMOTION_EVENT_ACTION_DOWN;
-            mLatencyTracker.trackListener(args.id, isDown, args.eventTime, args.readTime);
+            mLatencyTracker.trackListener(args.id, isDown, args.eventTime, args.readTime,
+                                          args.deviceId, cookedTime, /*enqueueTime=*/now());
         }
 
         needWake = enqueueInboundEventLocked(std::move(newEntry));
@@ -4914,6 +5142,37 @@ ui::Transform InputDispatcher::getTransformLocked(int32_t displayId) const {
                                                 : kIdentityTransform;
 }
 
+void InputDispatcher::updateTouchableWindowIndexLocked(int32_t displayId) {
+    const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    if (windowHandles.empty()) {
+        mTouchableWindowIndexByDisplay.erase(displayId);
+        return;
+    }
+    const ui::Transform displayTransform = getTransformLocked(displayId);
+    auto it = mTouchableWindowIndexByDisplay.find(displayId);
+    if (it != mTouchableWindowIndexByDisplay.end() &&
+        it->second.isFor(windowHandles, displayTransform)) {
+        return;
+    }
+    mTouchableWindowIndexByDisplay.insert_or_assign(displayId,
+                                                    TouchableWindowIndex(windowHandles,
+                                                                         displayTransform));
+}
+
+TouchableWindowIndex::HitTest InputDispatcher::hitTestWindowsLocked(int32_t displayId, float x,
+                                                                    float y) const {
+    const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    const ui::Transform displayTransform = getTransformLocked(displayId);
+    // The window handles can be changed in place, so the index is only used if it is still up to
+    // date with them.
+    auto it = mTouchableWindowIndexByDisplay.find(displayId);
+    if (it != mTouchableWindowIndexByDisplay.end() &&
+        it->second.isFor(windowHandles, displayTransform)) {
+        return it->second.hitTest(x, y);
+    }
+    return TouchableWindowIndex::HitTest(windowHandles, displayTransform, x, y);
+}
+
 bool InputDispatcher::canWindowReceiveMotionLocked(const sp<WindowInfoHandle>& window,
                                                    const MotionEntry& motionEntry) const {
     const WindowInfo& info = *window->getInfo();
@@ -4983,6 +5242,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     if (windowInfoHandles.empty()) {
         // Remove all handles on a display if there are no windows left.
         mWindowHandlesByDisplay.erase(displayId);
+        mTouchableWindowIndexByDisplay.erase(displayId);
         return;
     }
 
@@ -5028,6 +5288,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
 
     // Insert or replace
     mWindowHandlesByDisplay[displayId] = newHandles;
+    updateTouchableWindowIndexLocked(displayId);
 }
 
 void InputDispatcher::setInputWindows(
@@ -5050,6 +5311,25 @@ void InputDispatcher::setInputWindows(
  * For focused handle, check if need to change and send a cancel event to previous one.
  * For removed handle, check if need to send a cancel event if already in touch.
  */
+bool InputDispatcher::hasSameWindowsLocked(const std::vector<const WindowInfo*>& windowInfos,
+                                           int32_t displayId) const {
+    const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    if (windowHandles.size() != windowInfos.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < windowInfos.size(); i++) {
+        const WindowInfo& info = *windowHandles[i]->getInfo();
+        if (!(info == *windowInfos[i])) {
+            return false;
+        }
+        // Setting the windows again would drop the windows whose input channel was removed.
+        if (info.token != nullptr && getInputChannelLocked(info.token) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void InputDispatcher::setInputWindowsLocked(
         const std::vector<sp<WindowInfoHandle>>& windowInfoHandles, int32_t displayId) {
     if (DEBUG_FOCUS) {
@@ -5785,6 +6065,7 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
                          ns2ms(mConfig.keyRepeatTimeout));
     dump += mLatencyTracker.dump(INDENT2);
     dump += mLatencyAggregator.dump(INDENT2);
+    dump += mLatencyHistograms.dump(INDENT2);
 }
 
 void InputDispatcher::dumpMonitors(std::string& dump, const std::vector<Monitor>& monitors) const {
@@ -6685,10 +6966,9 @@ void InputDispatcher::displayRemoved(int32_t displayId) {
 void InputDispatcher::onWindowInfosChanged(const gui::WindowInfosUpdate& update) {
     // The listener sends the windows as a flattened array. Separate the windows by display for
     // more convenient parsing.
-    std::unordered_map<int32_t, std::vector<sp<WindowInfoHandle>>> handlesPerDisplay;
+    std::unordered_map<int32_t, std::vector<const WindowInfo*>> infosPerDisplay;
     for (const auto& info : update.windowInfos) {
-        handlesPerDisplay.emplace(info.displayId, std::vector<sp<WindowInfoHandle>>());
-        handlesPerDisplay[info.displayId].push_back(sp<WindowInfoHandle>::make(info));
+        infosPerDisplay[info.displayId].push_back(&info);
     }
 
     { // acquire lock
@@ -6697,7 +6977,7 @@ void InputDispatcher::onWindowInfosChanged(const gui::WindowInfosUpdate& update)
         // Ensure that we have an entry created for all existing displays so that if a displayId has
         // no windows, we can tell that the windows were removed from the display.
         for (const auto& [displayId, _] : mWindowHandlesByDisplay) {
-            handlesPerDisplay[displayId];
+            infosPerDisplay[displayId];
         }
 
         mDisplayInfos.clear();
@@ -6705,10 +6985,25 @@ void InputDispatcher::onWindowInfosChanged(const gui::WindowInfosUpdate& update)
             mDisplayInfos.emplace(displayInfo.displayId, displayInfo);
         }
 
-        for (const auto& [displayId, handles] : handlesPerDisplay) {
+        // Most updates only change the windows of some of the displays, so only the displays whose
+        // windows changed are updated.
+        for (const auto& [displayId, infos] : infosPerDisplay) {
+            if (hasSameWindowsLocked(infos, displayId)) {
+                continue;
+            }
+            std::vector<sp<WindowInfoHandle>> handles;
+            handles.reserve(infos.size());
+            for (const WindowInfo* info : infos) {
+                handles.push_back(sp<WindowInfoHandle>::make(*info));
+            }
             setInputWindowsLocked(handles, displayId);
         }
 
+        // The transforms of the displays whose windows did not change may have changed.
+        for (const auto& [displayId, _] : mWindowHandlesByDisplay) {
+            updateTouchableWindowIndexLocked(displayId);
+        }
+
         if (update.vsyncId < mWindowInfosVsyncId) {
             ALOGE("Received out of order window infos update. Last update vsync id: %" PRId64
                   ", current update vsync id: %" PRId64,
@@ -29,9 +29,11 @@
 #include "InputTarget.h"
 #include "InputThread.h"
 #include "LatencyAggregator.h"
+#include "LatencyHistograms.h"
 #include "LatencyTracker.h"
 #include "Monitor.h"
 #include "TouchState.h"
+#include "TouchableWindowIndex.h"
 #include "TouchedWindow.h"
 
 #include <attestation/HmacKeyManager.h>
@@ -214,7 +216,7 @@ private:
     void dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) REQUIRES(mLock);
 
     // Enqueues an inbound event.  Returns true if mLooper->wake() should be called.
-    bool enqueueInboundEventLocked(std::unique_ptr<EventEntry> entry) REQUIRES(mLock);
+    bool enqueueInboundEventLocked(std::shared_ptr<EventEntry> entry) REQUIRES(mLock);
 
     // Cleans up input state when dropping an inbound event.
     void dropInboundEventLocked(const EventEntry& entry, DropReason dropReason) REQUIRES(mLock);
@@ -368,9 +370,22 @@ private:
             mWindowHandlesByDisplay GUARDED_BY(mLock);
     std::unordered_map<int32_t /*displayId*/, android::gui::DisplayInfo> mDisplayInfos
             GUARDED_BY(mLock);
+    // The touchable regions of the windows of each display, indexed for the touch hit tests.
+    std::unordered_map<int32_t /*displayId*/, TouchableWindowIndex> mTouchableWindowIndexByDisplay
+            GUARDED_BY(mLock);
+    // Rebuilds the index of the display if its windows or its transform changed.
+    void updateTouchableWindowIndexLocked(int32_t displayId) REQUIRES(mLock);
+    // Returns the hit test of the point against the windows of the display, which uses the index
+    // of the display if it is up to date with the windows.
+    TouchableWindowIndex::HitTest hitTestWindowsLocked(int32_t displayId, float x, float y) const
+            REQUIRES(mLock);
     void setInputWindowsLocked(
             const std::vector<sp<android::gui::WindowInfoHandle>>& inputWindowHandles,
             int32_t displayId) REQUIRES(mLock);
+    // Whether the windows of the display are already the given ones, in the same order, so that
+    // setting them again would change nothing.
+    bool hasSameWindowsLocked(const std::vector<const android::gui::WindowInfo*>& windowInfos,
+                              int32_t displayId) const REQUIRES(mLock);
     // Get a reference to window handles by display, return an empty vector if not found.
     const std::vector<sp<android::gui::WindowInfoHandle>>& getWindowHandlesLocked(
             int32_t displayId) const REQUIRES(mLock);
@@ -610,9 +625,44 @@ private:
     void enqueueDispatchEntryLocked(const std::shared_ptr<Connection>& connection,
                                     std::shared_ptr<EventEntry>, const InputTarget& inputTarget,
                                     ftl::Flags<InputTarget::Flags> dispatchMode) REQUIRES(mLock);
-    status_t publishMotionEvent(Connection& connection, DispatchEntry& dispatchEntry) const;
+    // Publishes the entry, with the later samples in the same message, see
+    // getLaterMotionSamples.
+    status_t publishMotionEvent(Connection& connection, DispatchEntry& dispatchEntry,
+                                const std::vector<DispatchEntry*>& laterSamples) const;
+    status_t publishDispatchEntry(Connection& connection, DispatchEntry& dispatchEntry,
+                                  const std::vector<DispatchEntry*>& laterSamples) const;
     void startDispatchCycleLocked(nsecs_t currentTime,
                                   const std::shared_ptr<Connection>& connection) REQUIRES(mLock);
+    void onDispatchEntryPublishedLocked(const std::shared_ptr<Connection>& connection,
+                                        DispatchEntry* dispatchEntry) REQUIRES(mLock);
+    void onPublishFailedLocked(nsecs_t currentTime, const std::shared_ptr<Connection>& connection,
+                               status_t status) REQUIRES(mLock);
+
+    // The dispatch entries which the dispatcher thread took off the outbound queue of a
+    // connection, to publish them once it released the lock.
+    struct PendingPublish {
+        std::shared_ptr<Connection> connection;
+        std::vector<DispatchEntry*> dispatchEntries;
+        // The number of entries which were published, and the status of the first entry which
+        // could not be published.
+        size_t publishedCount = 0;
+        status_t status = OK;
+        // Whether the connection had unfinished events, so that the MOVE events are packed.
+        bool hadUnfinishedEvents = false;
+    };
+    // Whether the dispatch cycles put the entries in mPendingPublishes rather than publishing them
+    // right away. Only set while the dispatcher thread runs a dispatch loop.
+    bool mDeferPublishing GUARDED_BY(mLock) = false;
+    std::vector<PendingPublish> mPendingPublishes GUARDED_BY(mLock);
+    void deferPublishLocked(const std::shared_ptr<Connection>& connection,
+                            DispatchEntry* dispatchEntry) REQUIRES(mLock);
+    std::vector<PendingPublish> takePendingPublishesLocked() REQUIRES(mLock);
+    // Publishes the pending entries. Only called by the dispatcher thread, without the lock.
+    void publishPendingEntries(std::vector<PendingPublish>& pendingPublishes) const
+            EXCLUDES(mLock);
+    void finishPendingPublishesLocked(nsecs_t currentTime,
+                                      std::vector<PendingPublish>& pendingPublishes)
+            REQUIRES(mLock);
     void finishDispatchCycleLocked(nsecs_t currentTime,
                                    const std::shared_ptr<Connection>& connection, uint32_t seq,
                                    bool handled, nsecs_t consumeTime) REQUIRES(mLock);
@@ -696,6 +746,7 @@ private:
 
     // Statistics gathering.
     LatencyAggregator mLatencyAggregator GUARDED_BY(mLock);
+    LatencyHistograms mLatencyHistograms GUARDED_BY(mLock);
     LatencyTracker mLatencyTracker GUARDED_BY(mLock);
     void traceInboundQueueLengthLocked() REQUIRES(mLock);
     void traceOutboundQueueLength(const Connection& connection);
@@ -73,10 +73,14 @@ private:
 };
 
 struct InputEventTimeline {
-    InputEventTimeline(bool isDown, nsecs_t eventTime, nsecs_t readTime);
+    InputEventTimeline(bool isDown, nsecs_t eventTime, nsecs_t readTime, int32_t deviceId = 0,
+                       nsecs_t cookedTime = 0, nsecs_t enqueueTime = 0);
     const bool isDown; // True if this is an ACTION_DOWN event
     const nsecs_t eventTime;
     const nsecs_t readTime;
+    const int32_t deviceId;
+    const nsecs_t cookedTime;  // time at which the dispatcher was notified of the event
+    const nsecs_t enqueueTime; // time at which the event was added to the inbound queue
 
     struct IBinderHash {
         std::size_t operator()(const sp<IBinder>& b) const {
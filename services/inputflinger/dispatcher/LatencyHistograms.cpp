@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistograms.h"
+
+#include <inttypes.h>
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <cmath>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// The upper bound of the first bucket. Each of the next buckets is twice as wide, and the last
+// one has no upper bound.
+constexpr nsecs_t FIRST_BUCKET_LATENCY = 250'000;
+
+nsecs_t getBucketUpperBound(size_t bucket) {
+    return FIRST_BUCKET_LATENCY << bucket;
+}
+
+// Adds the latency between the two times to the histogram of the stage. A time is 0 if it is not
+// known, for the timelines which were not created by the dispatcher.
+void addLatency(LatencyHistograms::StageHistograms& histograms, LatencyStage stage, nsecs_t start,
+                nsecs_t end) {
+    if (start == 0 || end == 0) {
+        return;
+    }
+    histograms[static_cast<size_t>(stage)].add(end - start);
+}
+
+void addDeviceLatencies(LatencyHistograms::StageHistograms& histograms,
+                        const InputEventTimeline& timeline) {
+    addLatency(histograms, LatencyStage::KERNEL_TO_READ, timeline.eventTime, timeline.readTime);
+    addLatency(histograms, LatencyStage::READ_TO_COOKED, timeline.readTime, timeline.cookedTime);
+    addLatency(histograms, LatencyStage::COOKED_TO_ENQUEUED, timeline.cookedTime,
+               timeline.enqueueTime);
+}
+
+void addConnectionLatencies(LatencyHistograms::StageHistograms& histograms,
+                            const InputEventTimeline& timeline,
+                            const ConnectionTimeline& connectionTimeline) {
+    const nsecs_t presentTime = connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
+    addLatency(histograms, LatencyStage::ENQUEUED_TO_PUBLISHED, timeline.enqueueTime,
+               connectionTimeline.deliveryTime);
+    addLatency(histograms, LatencyStage::PUBLISHED_TO_CONSUMED, connectionTimeline.deliveryTime,
+               connectionTimeline.consumeTime);
+    addLatency(histograms, LatencyStage::CONSUMED_TO_FINISHED, connectionTimeline.consumeTime,
+               connectionTimeline.finishTime);
+    addLatency(histograms, LatencyStage::FINISHED_TO_PRESENTED, connectionTimeline.finishTime,
+               presentTime);
+    addLatency(histograms, LatencyStage::END_TO_END, timeline.eventTime, presentTime);
+}
+
+std::string dumpStageHistograms(const LatencyHistograms::StageHistograms& histograms,
+                                const char* prefix) {
+    std::string dump;
+    for (LatencyStage stage : ftl::enum_range<LatencyStage>()) {
+        const LatencyHistogram& histogram = histograms[static_cast<size_t>(stage)];
+        if (histogram.getCount() == 0) {
+            continue;
+        }
+        dump += StringPrintf("%s%s: %s\n", prefix, ftl::enum_string(stage).c_str(),
+                             histogram.dump().c_str());
+    }
+    return dump;
+}
+
+} // namespace
+
+// --- LatencyHistogram ---
+
+void LatencyHistogram::add(nsecs_t latency) {
+    // The clocks of the apps and of the display can make a stage look negative.
+    latency = std::max<nsecs_t>(latency, 0);
+    size_t bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && latency > getBucketUpperBound(bucket)) {
+        bucket++;
+    }
+    mBucketCounts[bucket]++;
+    mCount++;
+    mMax = std::max(mMax, latency);
+}
+
+nsecs_t LatencyHistogram::getPercentile(float percentile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    const size_t rank = std::max<size_t>(1, std::ceil(mCount * percentile / 100));
+    size_t count = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT - 1; bucket++) {
+        count += mBucketCounts[bucket];
+        if (count >= rank) {
+            return std::min(getBucketUpperBound(bucket), mMax);
+        }
+    }
+    return mMax;
+}
+
+std::string LatencyHistogram::dump() const {
+    std::string dump = StringPrintf("count=%zu, p50<=%.1fms, p90<=%.1fms, p99<=%.1fms, "
+                                    "max=%.1fms, buckets=[",
+                                    mCount, getPercentile(50) / 1E6, getPercentile(90) / 1E6,
+                                    getPercentile(99) / 1E6, mMax / 1E6);
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        dump += (bucket == 0 ? "" : ", ") + std::to_string(mBucketCounts[bucket]);
+    }
+    return dump + "]";
+}
+
+// --- LatencyHistograms ---
+
+LatencyHistograms::LatencyHistograms(
+        std::function<std::string(const sp<IBinder>&)> getConnectionName)
+      : mGetConnectionName(std::move(getConnectionName)) {}
+
+void LatencyHistograms::processTimeline(const InputEventTimeline& timeline) {
+    StageHistograms& deviceHistograms = mDeviceHistograms[timeline.deviceId];
+    addDeviceLatencies(deviceHistograms, timeline);
+
+    for (const auto& [connectionToken, connectionTimeline] : timeline.connectionTimelines) {
+        if (!connectionTimeline.isComplete()) {
+            continue;
+        }
+        addConnectionLatencies(deviceHistograms, timeline, connectionTimeline);
+
+        auto it = mWindowHistograms.find(connectionToken);
+        if (it == mWindowHistograms.end()) {
+            if (mWindowHistograms.size() >= MAX_WINDOWS) {
+                mWindowHistograms.erase(
+                        std::min_element(mWindowHistograms.begin(), mWindowHistograms.end(),
+                                         [](const auto& lhs, const auto& rhs) {
+                                             return lhs.second.lastEventTime <
+                                                     rhs.second.lastEventTime;
+                                         }));
+            }
+            it = mWindowHistograms.emplace(connectionToken, WindowHistograms{}).first;
+            it->second.name = mGetConnectionName(connectionToken);
+        }
+        WindowHistograms& window = it->second;
+        window.lastEventTime = timeline.eventTime;
+        addDeviceLatencies(window.histograms, timeline);
+        addConnectionLatencies(window.histograms, timeline, connectionTimeline);
+    }
+}
+
+const LatencyHistograms::StageHistograms* LatencyHistograms::getDeviceHistograms(
+        int32_t deviceId) const {
+    const auto it = mDeviceHistograms.find(deviceId);
+    return it != mDeviceHistograms.end() ? &it->second : nullptr;
+}
+
+const LatencyHistograms::StageHistograms* LatencyHistograms::getWindowHistograms(
+        const sp<IBinder>& connectionToken) const {
+    const auto it = mWindowHistograms.find(connectionToken);
+    return it != mWindowHistograms.end() ? &it->second.histograms : nullptr;
+}
+
+std::string LatencyHistograms::dump(const char* prefix) const {
+    std::string dump = StringPrintf("%sLatencyHistograms:\n", prefix);
+    const std::string stagePrefix = StringPrintf("%s    ", prefix);
+    for (const auto& [deviceId, histograms] : mDeviceHistograms) {
+        dump += StringPrintf("%s  Device %" PRId32 ":\n", prefix, deviceId);
+        dump += dumpStageHistograms(histograms, stagePrefix.c_str());
+    }
+    for (const auto& [_, window] : mWindowHistograms) {
+        dump += StringPrintf("%s  Window '%s':\n", prefix, window.name.c_str());
+        dump += dumpStageHistograms(window.histograms, stagePrefix.c_str());
+    }
+    return dump;
+}
+
+} // namespace android::inputdispatcher
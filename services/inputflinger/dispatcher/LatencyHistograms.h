@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include <binder/IBinder.h>
+#include <ftl/enum.h>
+#include <utils/Timers.h>
+
+#include "InputEventTimeline.h"
+
+namespace android::inputdispatcher {
+
+/**
+ * The stages of the input pipeline, between two consecutive times of the timeline of an event.
+ */
+enum class LatencyStage : size_t {
+    KERNEL_TO_READ,         // eventTime -> readTime, in the kernel and EventHub
+    READ_TO_COOKED,         // readTime -> cookedTime, in InputReader and the stages after it
+    COOKED_TO_ENQUEUED,     // cookedTime -> enqueueTime, in the policy of the dispatcher
+    ENQUEUED_TO_PUBLISHED,  // enqueueTime -> deliveryTime, in the queues of the dispatcher
+    PUBLISHED_TO_CONSUMED,  // deliveryTime -> consumeTime, until the app reads the event
+    CONSUMED_TO_FINISHED,   // consumeTime -> finishTime, while the app handles the event
+    FINISHED_TO_PRESENTED,  // finishTime -> presentTime, until the frame is on the screen
+    END_TO_END,             // eventTime -> presentTime
+    ftl_last = END_TO_END
+};
+
+/**
+ * A histogram of latencies, with exponential buckets from 250us to 512ms.
+ */
+class LatencyHistogram {
+public:
+    void add(nsecs_t latency);
+    size_t getCount() const { return mCount; }
+    // Returns an upper bound of the given percentile of the latencies, or 0 if there are none.
+    nsecs_t getPercentile(float percentile) const;
+    std::string dump() const;
+
+private:
+    static constexpr size_t BUCKET_COUNT = 13;
+    std::array<size_t, BUCKET_COUNT> mBucketCounts{};
+    size_t mCount = 0;
+    nsecs_t mMax = 0;
+};
+
+/**
+ * Keeps histograms of the latency of each stage of the input pipeline, for each device and for
+ * each window, from the complete event timelines. Unlike the sketches of LatencyAggregator, the
+ * histograms are never reset nor capped, so that they are always available in dumpsys.
+ */
+class LatencyHistograms final : public InputEventTimelineProcessor {
+public:
+    using StageHistograms = std::array<LatencyHistogram, ftl::enum_size_v<LatencyStage>>;
+
+    // The names of the connections are looked up when their first timeline is processed.
+    explicit LatencyHistograms(std::function<std::string(const sp<IBinder>&)> getConnectionName);
+
+    void processTimeline(const InputEventTimeline& timeline) override;
+
+    const StageHistograms* getDeviceHistograms(int32_t deviceId) const;
+    const StageHistograms* getWindowHistograms(const sp<IBinder>& connectionToken) const;
+
+    std::string dump(const char* prefix) const;
+
+private:
+    // The histograms of the windows which were the least recently updated are dropped after
+    // this many.
+    static constexpr size_t MAX_WINDOWS = 32;
+
+    struct WindowHistograms {
+        std::string name;
+        nsecs_t lastEventTime = 0;
+        StageHistograms histograms;
+    };
+
+    const std::function<std::string(const sp<IBinder>&)> mGetConnectionName;
+    std::map<int32_t /*deviceId*/, StageHistograms> mDeviceHistograms;
+    std::unordered_map<sp<IBinder>, WindowHistograms, InputEventTimeline::IBinderHash>
+            mWindowHistograms;
+};
+
+} // namespace android::inputdispatcher
@@ -15,6 +15,7 @@
  */
 
 #define LOG_TAG "LatencyTracker"
+#define ATRACE_TAG ATRACE_TAG_INPUT
 #include "LatencyTracker.h"
 
 #include <inttypes.h>
@@ -24,6 +25,9 @@
 #include <android/os/IInputConstants.h>
 #include <input/Input.h>
 #include <log/log.h>
+#include <utils/Trace.h>
+
+#include "LatencyHistograms.h"
 
 using android::base::HwTimeoutMultiplier;
 using android::base::StringPrintf;
@@ -60,13 +64,41 @@ static void eraseByValue(std::multimap<K, V>& map, const V& value) {
     }
 }
 
+/**
+ * Trace the latency of a stage of the pipeline as a counter, so that each stage has its own track
+ * in the traces. A time is 0 if it is not known.
+ */
+static void traceLatency(LatencyStage stage, nsecs_t start, nsecs_t end) {
+    if (!ATRACE_ENABLED() || start == 0 || end == 0) {
+        return;
+    }
+    const std::string counterName = "latency:" + ftl::enum_string(stage);
+    ATRACE_INT64(counterName.c_str(), end - start);
+}
+
+static void tracePresentLatency(const InputEventTimeline& timeline,
+                                const ConnectionTimeline& connectionTimeline) {
+    if (!connectionTimeline.isComplete()) {
+        return;
+    }
+    const nsecs_t presentTime = connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
+    traceLatency(LatencyStage::FINISHED_TO_PRESENTED, connectionTimeline.finishTime, presentTime);
+    traceLatency(LatencyStage::END_TO_END, timeline.eventTime, presentTime);
+}
+
 LatencyTracker::LatencyTracker(InputEventTimelineProcessor* processor)
-      : mTimelineProcessor(processor) {
-    LOG_ALWAYS_FATAL_IF(processor == nullptr);
+      : LatencyTracker(std::vector<InputEventTimelineProcessor*>{processor}) {}
+
+LatencyTracker::LatencyTracker(std::vector<InputEventTimelineProcessor*> processors)
+      : mTimelineProcessors(std::move(processors)) {
+    for (const InputEventTimelineProcessor* processor : mTimelineProcessors) {
+        LOG_ALWAYS_FATAL_IF(processor == nullptr);
+    }
 }
 
 void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t eventTime,
-                                   nsecs_t readTime) {
+                                   nsecs_t readTime, int32_t deviceId, nsecs_t cookedTime,
+                                   nsecs_t enqueueTime) {
     reportAndPruneMatureRecords(eventTime);
     const auto it = mTimelines.find(inputEventId);
     if (it != mTimelines.end()) {
@@ -78,8 +110,13 @@ void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t ev
         eraseByValue(mEventTimes, inputEventId);
         return;
     }
-    mTimelines.emplace(inputEventId, InputEventTimeline(isDown, eventTime, readTime));
+    mTimelines.emplace(inputEventId,
+                       InputEventTimeline(isDown, eventTime, readTime, deviceId, cookedTime,
+                                          enqueueTime));
     mEventTimes.emplace(eventTime, inputEventId);
+    traceLatency(LatencyStage::KERNEL_TO_READ, eventTime, readTime);
+    traceLatency(LatencyStage::READ_TO_COOKED, readTime, cookedTime);
+    traceLatency(LatencyStage::COOKED_TO_ENQUEUED, cookedTime, enqueueTime);
 }
 
 void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
@@ -94,6 +131,9 @@ void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>&
     }
 
     InputEventTimeline& timeline = it->second;
+    traceLatency(LatencyStage::ENQUEUED_TO_PUBLISHED, timeline.enqueueTime, deliveryTime);
+    traceLatency(LatencyStage::PUBLISHED_TO_CONSUMED, deliveryTime, consumeTime);
+    traceLatency(LatencyStage::CONSUMED_TO_FINISHED, consumeTime, finishTime);
     const auto connectionIt = timeline.connectionTimelines.find(connectionToken);
     if (connectionIt == timeline.connectionTimelines.end()) {
         // Most likely case: app calls 'finishInputEvent' before it reports the graphics timeline
@@ -109,7 +149,9 @@ void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>&
             // We are receiving unreliable data from the app. Just delete the entire connection
             // timeline for this event
             timeline.connectionTimelines.erase(connectionIt);
+            return;
         }
+        tracePresentLatency(timeline, connectionTimeline);
     }
 }
 
@@ -136,7 +178,9 @@ void LatencyTracker::trackGraphicsLatency(
             // We are receiving unreliable data from the app. Just delete the entire connection
             // timeline for this event
             timeline.connectionTimelines.erase(connectionIt);
+            return;
         }
+        tracePresentLatency(timeline, connectionTimeline);
     }
 }
 
@@ -155,7 +199,9 @@ void LatencyTracker::reportAndPruneMatureRecords(nsecs_t newEventTime) {
                                 "Event %" PRId32 " is in mEventTimes, but not in mTimelines",
                                 oldestInputEventId);
             const InputEventTimeline& timeline = it->second;
-            mTimelineProcessor->processTimeline(timeline);
+            for (InputEventTimelineProcessor* processor : mTimelineProcessors) {
+                processor->processTimeline(timeline);
+            }
             mTimelines.erase(it);
             mEventTimes.erase(mEventTimes.begin());
         } else {
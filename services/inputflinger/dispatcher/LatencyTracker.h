@@ -18,6 +18,7 @@
 
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <input/Input.h>
@@ -40,6 +41,8 @@ public:
      * param reportingFunction: the function that will be called in order to report full latency.
      */
     LatencyTracker(InputEventTimelineProcessor* processor);
+    // Report the full latency to each of the processors, in order.
+    LatencyTracker(std::vector<InputEventTimelineProcessor*> processors);
     /**
      * Start keeping track of an event identified by inputEventId. This must be called first.
      * If duplicate events are encountered (events that have the same eventId), none of them will be
@@ -48,8 +51,11 @@ public:
      * eventTime. Even if eventTime was provided, there would still be a possibility of having
      * duplicate events that happen to have the same eventTime and inputEventId. Therefore, we
      * must drop all duplicate data.
+     * The device and the times at which the dispatcher was notified of the event and enqueued it
+     * are only used to break down the latency into the stages of the pipeline.
      */
-    void trackListener(int32_t inputEventId, bool isDown, nsecs_t eventTime, nsecs_t readTime);
+    void trackListener(int32_t inputEventId, bool isDown, nsecs_t eventTime, nsecs_t readTime,
+                       int32_t deviceId = 0, nsecs_t cookedTime = 0, nsecs_t enqueueTime = 0);
     void trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
                             nsecs_t deliveryTime, nsecs_t consumeTime, nsecs_t finishTime);
     void trackGraphicsLatency(int32_t inputEventId, const sp<IBinder>& connectionToken,
@@ -75,7 +81,7 @@ private:
      */
     std::multimap<nsecs_t /*eventTime*/, int32_t /*inputEventId*/> mEventTimes;
 
-    InputEventTimelineProcessor* mTimelineProcessor;
+    std::vector<InputEventTimelineProcessor*> mTimelineProcessors;
     void reportAndPruneMatureRecords(nsecs_t newEventTime);
 };
 
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TouchableWindowIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+using android::gui::WindowInfoHandle;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+const std::vector<uint32_t> NO_CANDIDATES;
+
+// Window Manager works in the logical display coordinate space, where a window with the bounds
+// (l, t, r, b) contains the points with x in [l, r) and y in [t, b). The points are tested in
+// this space, see windowAcceptsTouchAt in InputDispatcher.cpp.
+std::pair<int32_t, int32_t> toLogicalPoint(const ui::Transform& displayTransform, float x,
+                                           float y) {
+    const vec2 p = displayTransform.transform(x, y);
+    return {static_cast<int32_t>(std::floor(p.x)), static_cast<int32_t>(std::floor(p.y))};
+}
+
+} // namespace
+
+// --- TouchableWindowIndex ---
+
+TouchableWindowIndex::TouchableWindowIndex(const std::vector<sp<WindowInfoHandle>>& windowHandles,
+                                           const ui::Transform& displayTransform)
+      : mDisplayTransform(displayTransform) {
+    mWindows.reserve(windowHandles.size());
+    bool haveBounds = false;
+    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+        const Region& touchableRegion = windowHandle->getInfo()->touchableRegion;
+        Window& window = mWindows.emplace_back(Window{
+                .handle = windowHandle.get(),
+                .touchableRegion = touchableRegion,
+                .logicalTouchableRegion = displayTransform.transform(touchableRegion),
+        });
+        const Rect bounds = window.logicalTouchableRegion.getBounds();
+        if (bounds.isEmpty()) {
+            continue;
+        }
+        if (!haveBounds) {
+            mBounds = bounds;
+            haveBounds = true;
+            continue;
+        }
+        mBounds.left = std::min(mBounds.left, bounds.left);
+        mBounds.top = std::min(mBounds.top, bounds.top);
+        mBounds.right = std::max(mBounds.right, bounds.right);
+        mBounds.bottom = std::max(mBounds.bottom, bounds.bottom);
+    }
+    if (!haveBounds) {
+        mBounds = Rect::EMPTY_RECT;
+        return;
+    }
+
+    // The bounds may span the whole range of the coordinates, so the cells are computed with
+    // 64-bit integers.
+    mCellWidth = std::max<int64_t>(1, (int64_t(mBounds.right) - mBounds.left + GRID_SIZE - 1) /
+                                              GRID_SIZE);
+    mCellHeight = std::max<int64_t>(1, (int64_t(mBounds.bottom) - mBounds.top + GRID_SIZE - 1) /
+                                               GRID_SIZE);
+    mCells.resize(GRID_SIZE * GRID_SIZE);
+    for (uint32_t i = 0; i < mWindows.size(); i++) {
+        const Rect bounds = mWindows[i].logicalTouchableRegion.getBounds();
+        if (bounds.isEmpty()) {
+            continue;
+        }
+        const int32_t lastColumn = getColumn(bounds.right - 1);
+        const int32_t lastRow = getRow(bounds.bottom - 1);
+        for (int32_t row = getRow(bounds.top); row <= lastRow; row++) {
+            for (int32_t column = getColumn(bounds.left); column <= lastColumn; column++) {
+                mCells[row * GRID_SIZE + column].push_back(i);
+            }
+        }
+    }
+}
+
+int32_t TouchableWindowIndex::getColumn(int32_t x) const {
+    return static_cast<int32_t>((int64_t(x) - mBounds.left) / mCellWidth);
+}
+
+int32_t TouchableWindowIndex::getRow(int32_t y) const {
+    return static_cast<int32_t>((int64_t(y) - mBounds.top) / mCellHeight);
+}
+
+bool TouchableWindowIndex::isFor(const std::vector<sp<WindowInfoHandle>>& windowHandles,
+                                 const ui::Transform& displayTransform) const {
+    if (windowHandles.size() != mWindows.size() || !(displayTransform == mDisplayTransform)) {
+        return false;
+    }
+    // The window infos are only updated with the windows of the display, when the index is
+    // rebuilt, but the touchable regions are checked as well, so that the hit tests never use
+    // stale regions.
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        if (windowHandles[i].get() != mWindows[i].handle ||
+            !windowHandles[i]->getInfo()->touchableRegion.hasSameRects(
+                    mWindows[i].touchableRegion)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TouchableWindowIndex::HitTest TouchableWindowIndex::hitTest(float x, float y) const {
+    const auto [logicalX, logicalY] = toLogicalPoint(mDisplayTransform, x, y);
+    if (logicalX < mBounds.left || logicalX >= mBounds.right || logicalY < mBounds.top ||
+        logicalY >= mBounds.bottom) {
+        return HitTest(*this, NO_CANDIDATES, logicalX, logicalY);
+    }
+    return HitTest(*this, mCells[getRow(logicalY) * GRID_SIZE + getColumn(logicalX)], logicalX,
+                   logicalY);
+}
+
+// --- TouchableWindowIndex::HitTest ---
+
+TouchableWindowIndex::HitTest::HitTest(const std::vector<sp<WindowInfoHandle>>& windowHandles,
+                                       const ui::Transform& displayTransform, float x, float y)
+      : mWindowHandles(&windowHandles), mDisplayTransform(displayTransform) {
+    std::tie(mLogicalX, mLogicalY) = toLogicalPoint(displayTransform, x, y);
+}
+
+TouchableWindowIndex::HitTest::HitTest(const TouchableWindowIndex& index,
+                                       const std::vector<uint32_t>& candidates, int32_t logicalX,
+                                       int32_t logicalY)
+      : mIndex(&index), mCandidates(&candidates), mLogicalX(logicalX), mLogicalY(logicalY) {}
+
+bool TouchableWindowIndex::HitTest::touchableRegionContains(size_t windowIndex) {
+    if (mIndex == nullptr) {
+        const Region touchableRegion =
+                mDisplayTransform.transform((*mWindowHandles)[windowIndex]->getInfo()
+                                                    ->touchableRegion);
+        return touchableRegion.contains(mLogicalX, mLogicalY);
+    }
+    while (mNextCandidate < mCandidates->size() &&
+           (*mCandidates)[mNextCandidate] < windowIndex) {
+        mNextCandidate++;
+    }
+    if (mNextCandidate == mCandidates->size() || (*mCandidates)[mNextCandidate] != windowIndex) {
+        return false;
+    }
+    return mIndex->mWindows[windowIndex].logicalTouchableRegion.contains(mLogicalX, mLogicalY);
+}
+
+} // namespace android::inputdispatcher
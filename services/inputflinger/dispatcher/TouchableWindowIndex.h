@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/WindowInfo.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/Transform.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * A spatial index of the touchable regions of the windows of a display, so that the windows
+ * touched at a point are found without transforming and testing the touchable region of every
+ * window for every touch.
+ *
+ * The touchable regions are transformed into the logical display space once, when the index is
+ * built. A grid over the display then lists for each of its cells the windows, in z order, whose
+ * touchable region intersects the cell, so that a hit test only tests the windows of the cell of
+ * the point.
+ */
+class TouchableWindowIndex {
+public:
+    TouchableWindowIndex(const std::vector<sp<gui::WindowInfoHandle>>& windowHandles,
+                         const ui::Transform& displayTransform);
+
+    // Returns whether the index was built for these windows, with their current touchable
+    // regions, and for this display transform.
+    bool isFor(const std::vector<sp<gui::WindowInfoHandle>>& windowHandles,
+               const ui::Transform& displayTransform) const;
+
+    /**
+     * The hit test of a point in display coordinates against the touchable regions of the
+     * windows of a display, which are tested from front to back.
+     */
+    class HitTest {
+    public:
+        // Tests the windows without an index, for the windows which it is not up to date with.
+        HitTest(const std::vector<sp<gui::WindowInfoHandle>>& windowHandles,
+                const ui::Transform& displayTransform, float x, float y);
+
+        // Returns whether the touchable region of the window at the index, in the z order of the
+        // windows, contains the point. The windows have to be tested in increasing order.
+        bool touchableRegionContains(size_t windowIndex);
+
+    private:
+        friend class TouchableWindowIndex;
+        HitTest(const TouchableWindowIndex& index, const std::vector<uint32_t>& candidates,
+                int32_t logicalX, int32_t logicalY);
+
+        // Either the index and the candidate windows of the cell of the point, or the windows
+        // which are tested one by one.
+        const TouchableWindowIndex* mIndex = nullptr;
+        const std::vector<uint32_t>* mCandidates = nullptr;
+        size_t mNextCandidate = 0;
+        const std::vector<sp<gui::WindowInfoHandle>>* mWindowHandles = nullptr;
+        ui::Transform mDisplayTransform;
+        // The point in the logical display space.
+        int32_t mLogicalX;
+        int32_t mLogicalY;
+    };
+
+    HitTest hitTest(float x, float y) const;
+
+private:
+    // The number of cells of the grid along each axis.
+    static constexpr int32_t GRID_SIZE = 16;
+
+    struct Window {
+        const gui::WindowInfoHandle* handle;
+        // The touchable region as set by the window manager, which the index is up to date with.
+        Region touchableRegion;
+        Region logicalTouchableRegion;
+    };
+
+    ui::Transform mDisplayTransform;
+    std::vector<Window> mWindows;
+    // The bounds of the touchable regions of all the windows, which the grid covers.
+    Rect mBounds;
+    int64_t mCellWidth = 1;
+    int64_t mCellHeight = 1;
+    // The indices of the windows of each cell, row by row, in increasing order.
+    std::vector<std::vector<uint32_t>> mCells;
+
+    int32_t getColumn(int32_t x) const;
+    int32_t getRow(int32_t y) const;
+};
+
+} // namespace android::inputdispatcher
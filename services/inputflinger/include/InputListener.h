@@ -69,6 +69,10 @@ public:
     void notifyVibratorState(const NotifyVibratorStateArgs& args) override;
     void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs& args) override;
 
+    using InputListenerInterface::notify;
+    // Queues the args by moving them, for the stages that don't need them after queueing them.
+    void notify(NotifyArgs&& args);
+
     void flush();
 
 private:
@@ -132,7 +132,10 @@ struct NotifyMotionArgs {
                      const std::vector<TouchVideoFrame>& videoFrames);
 
     NotifyMotionArgs(const NotifyMotionArgs& other);
+    // Takes the video frames of the other args, which stages pass along without copying them.
+    NotifyMotionArgs(NotifyMotionArgs&& other);
     NotifyMotionArgs& operator=(const android::NotifyMotionArgs&) = default;
+    NotifyMotionArgs& operator=(android::NotifyMotionArgs&&) = default;
 
     bool operator==(const NotifyMotionArgs& rhs) const;
 
@@ -29,6 +29,7 @@
 #include <sys/epoll.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
+#include <sys/poll.h>
 #include <sys/stat.h>
 #include <sys/sysmacros.h>
 #include <unistd.h>
@@ -39,6 +40,7 @@
 #include <android-base/file.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
+#include <android-base/unique_fd.h>
 #include <cutils/properties.h>
 #include <ftl/enum.h>
 #include <input/KeyCharacterMap.h>
@@ -51,9 +53,13 @@
 #include <utils/Log.h>
 #include <utils/Timers.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <optional>
 #include <regex>
+#include <thread>
 #include <utility>
 
 #include "EventHub.h"
@@ -67,6 +73,7 @@ using android::base::StringPrintf;
 namespace android {
 
 using namespace ftl::flag_operators;
+using namespace std::chrono_literals;
 
 static const char* DEVICE_INPUT_PATH = "/dev/input";
 // v4l2 devices go directly into /dev
@@ -224,6 +231,18 @@ static bool isV4lScanningEnabled() {
     return property_get_bool("ro.input.video_enabled", /*default_value=*/true);
 }
 
+// The number of threads which load the configuration files of the devices found by a scan.
+static constexpr size_t MAX_DEVICE_SCAN_THREADS = 4;
+
+// Longer windows would delay the events by a noticeable part of a frame.
+static constexpr std::chrono::microseconds MAX_EVENT_BATCH_WINDOW = 4ms;
+
+static std::chrono::microseconds getEventBatchWindow() {
+    const std::chrono::microseconds window{
+            property_get_int32("ro.input.event_batch_window_us", /*default_value=*/0)};
+    return std::clamp(window, 0us, MAX_EVENT_BATCH_WINDOW);
+}
+
 static nsecs_t processEventTimestamp(const struct input_event& event) {
     // Use the time specified in the event instead of the current time
     // so that downstream code can get more accurate estimates of
@@ -620,6 +639,22 @@ void EventHub::Device::configureFd() {
     ALOGI("usingClockIoctl=%s", toString(usingClockIoctl));
 }
 
+void EventHub::Device::ReadStats::recordRead(size_t count, bool full, nsecs_t now) {
+    readCount++;
+    eventCount += count;
+    if (full) {
+        fullReadCount++;
+    }
+    if (now - rateWindowStart >= s2ns(1)) {
+        if (rateWindowStart != 0) {
+            eventRate = rateWindowEventCount * 1e9f / (now - rateWindowStart);
+        }
+        rateWindowStart = now;
+        rateWindowEventCount = 0;
+    }
+    rateWindowEventCount += count;
+}
+
 bool EventHub::Device::hasKeycodeLocked(int keycode) const {
     if (!keyMap.haveKeyLayout()) {
         return false;
@@ -789,7 +824,8 @@ EventHub::EventHub(void)
         mNeedToScanDevices(true),
         mPendingEventCount(0),
         mPendingEventIndex(0),
-        mPendingINotify(false) {
+        mPendingINotify(false),
+        mEventBatchWindow(getEventBatchWindow()) {
     ensureProcessCanBlockSuspend();
 
     mEpollFd = epoll_create1(EPOLL_CLOEXEC);
@@ -1913,6 +1949,7 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                     const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
 
                     const size_t count = size_t(readSize) / sizeof(struct input_event);
+                    device->readStats.recordRead(count, count == readBuffer.size(), now);
                     for (size_t i = 0; i < count; i++) {
                         struct input_event& iev = readBuffer[i];
                         events.push_back({
@@ -1980,6 +2017,26 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
         mLock.unlock(); // release lock before poll
 
         int pollResult = epoll_wait(mEpollFd, mPendingEventItems, EPOLL_MAX_EVENTS, timeoutMillis);
+        bool batched = false;
+        if (pollResult > 0 && mEventBatchWindow > 0us &&
+            std::none_of(mPendingEventItems, mPendingEventItems + pollResult,
+                         [this](const epoll_event& item) {
+                             return item.data.fd == mWakeReadPipeFd ||
+                                     item.data.fd == mINotifyFd;
+                         })) {
+            // The devices stay readable until they are read, so they are all reported again
+            // after the window, with the ones which became readable meanwhile.
+            struct pollfd wakeFd = {.fd = mWakeReadPipeFd, .events = POLLIN};
+            const timespec window = {.tv_sec = 0,
+                                     .tv_nsec = static_cast<long>(
+                                             std::chrono::nanoseconds(mEventBatchWindow).count())};
+            ppoll(&wakeFd, 1, &window, nullptr);
+            const int batchResult = epoll_wait(mEpollFd, mPendingEventItems, EPOLL_MAX_EVENTS, 0);
+            if (batchResult > 0) {
+                pollResult = batchResult;
+                batched = true;
+            }
+        }
 
         mLock.lock(); // reacquire lock after poll
 
@@ -2002,6 +2059,10 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
         } else {
             // Some events occurred.
             mPendingEventCount = size_t(pollResult);
+            mWakeupCount++;
+            if (batched) {
+                mBatchedWakeupCount++;
+            }
         }
     }
 
@@ -2494,6 +2555,13 @@ bool EventHub::tryAddVideoDeviceLocked(EventHub::Device& device,
         return false;
     }
     device.videoDevice = std::move(videoDevice);
+    if (device.configuration) {
+        std::optional<int32_t> downsampleFactor =
+                device.configuration->getInt("video.downsampleFactor");
+        if (downsampleFactor.has_value() && *downsampleFactor > 0) {
+            device.videoDevice->setDownsampleFactor(static_cast<uint32_t>(*downsampleFactor));
+        }
+    }
     if (device.enabled) {
         registerVideoDeviceForEpollLocked(*device.videoDevice);
     }
@@ -2733,9 +2801,86 @@ void EventHub::handleNotifyEventLocked(const inotify_event& event) {
     }
 }
 
+// Loads the files which openDeviceLocked would load for the device, so that they are parsed
+// once into the caches of the input libraries (see ParsedFileCache) before the device is opened.
+static void preloadDeviceConfiguration(const std::string& devicePath) {
+    base::unique_fd fd(open(devicePath.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK));
+    if (fd < 0) {
+        return;
+    }
+
+    InputDeviceIdentifier identifier;
+    char buffer[80];
+    struct input_id inputId;
+    if (ioctl(fd.get(), EVIOCGNAME(sizeof(buffer) - 1), &buffer) < 1 ||
+        ioctl(fd.get(), EVIOCGID, &inputId)) {
+        return;
+    }
+    buffer[sizeof(buffer) - 1] = '\0';
+    identifier.name = buffer;
+    identifier.bus = inputId.bustype;
+    identifier.product = inputId.product;
+    identifier.vendor = inputId.vendor;
+    identifier.version = inputId.version;
+
+    std::unique_ptr<PropertyMap> configuration;
+    const std::string configurationFile =
+            getInputDeviceConfigurationFilePathByDeviceIdentifier(identifier,
+                                                                  InputDeviceConfigurationFileType::
+                                                                          CONFIGURATION);
+    if (!configurationFile.empty()) {
+        if (auto propertyMap = PropertyMap::load(configurationFile.c_str()); propertyMap.ok()) {
+            configuration = std::move(*propertyMap);
+        }
+    }
+
+    // The key map is only loaded for keyboards, joysticks and sensors, which report keys or
+    // are accelerometers.
+    BitArray<EV_MAX> evBitmask;
+    BitArray<INPUT_PROP_MAX> propBitmask;
+    typename BitArray<EV_MAX>::Buffer evBuffer = {};
+    typename BitArray<INPUT_PROP_MAX>::Buffer propBuffer = {};
+    if (ioctl(fd.get(), EVIOCGBIT(0, sizeof(evBuffer)), evBuffer.data()) >= 0) {
+        evBitmask.loadFromBuffer(evBuffer);
+    }
+    if (ioctl(fd.get(), EVIOCGPROP(sizeof(propBuffer)), propBuffer.data()) >= 0) {
+        propBitmask.loadFromBuffer(propBuffer);
+    }
+    if (evBitmask.test(EV_KEY) || propBitmask.test(INPUT_PROP_ACCELEROMETER)) {
+        KeyMap keyMap;
+        keyMap.load(identifier, configuration.get());
+    }
+}
+
 status_t EventHub::scanDirLocked(const std::string& dirname) {
+    std::vector<std::string> devicePaths;
     for (const auto& entry : std::filesystem::directory_iterator(dirname)) {
-        openDeviceLocked(entry.path());
+        devicePaths.push_back(entry.path());
+    }
+
+    // Most of the time of opening a device is spent loading its configuration files, which
+    // doesn't depend on the state of the EventHub, so they are loaded on a few threads first.
+    // The devices are still opened in order, and get the same ids as without the preloading.
+    const size_t threadCount = std::min<size_t>({devicePaths.size(), MAX_DEVICE_SCAN_THREADS,
+                                                 std::thread::hardware_concurrency()});
+    if (threadCount > 1) {
+        std::atomic<size_t> nextDevice = 0;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&devicePaths, &nextDevice]() {
+                for (size_t device = nextDevice++; device < devicePaths.size();
+                     device = nextDevice++) {
+                    preloadDeviceConfiguration(devicePaths[device]);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    for (const std::string& devicePath : devicePaths) {
+        openDeviceLocked(devicePath);
     }
     return 0;
 }
@@ -2767,6 +2912,10 @@ void EventHub::dump(std::string& dump) const {
         std::scoped_lock _l(mLock);
 
         dump += StringPrintf(INDENT "BuiltInKeyboardId: %d\n", mBuiltInKeyboardId);
+        dump += StringPrintf(INDENT "EventBatchWindow: %" PRId64 "us\n",
+                             static_cast<int64_t>(mEventBatchWindow.count()));
+        dump += StringPrintf(INDENT "Wakeups: %" PRIu64 " (batched: %" PRIu64 ")\n",
+                             mWakeupCount, mBatchedWakeupCount);
 
         dump += INDENT "Devices:\n";
 
@@ -2809,6 +2958,11 @@ void EventHub::dump(std::string& dump) const {
                                  device->associatedDevice
                                          ? device->associatedDevice->sysfsRootPath.c_str()
                                          : "<none>");
+            const Device::ReadStats& readStats = device->readStats;
+            dump += StringPrintf(INDENT3 "ReadStats: reads=%" PRIu64 ", fullReads=%" PRIu64
+                                         ", events=%" PRIu64 ", eventRate=%.1f/s\n",
+                                 readStats.readCount, readStats.fullReadCount,
+                                 readStats.eventCount, readStats.eventRate);
         }
 
         dump += INDENT "Unattached video devices:\n";
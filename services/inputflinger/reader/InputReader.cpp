@@ -426,8 +426,8 @@ void InputReader::refreshConfigurationLocked(ConfigurationChanges changes) {
 }
 
 void InputReader::notifyAll(std::list<NotifyArgs>&& argsList) {
-    for (const NotifyArgs& args : argsList) {
-        mQueuedListener.notify(args);
+    for (NotifyArgs& args : argsList) {
+        mQueuedListener.notify(std::move(args));
     }
 }
 
@@ -211,6 +211,8 @@ std::optional<TouchVideoFrame> TouchVideoDevice::readFrame() {
     if (result == -1) {
         ALOGE("VIDIOC_QBUF failed: %s", strerror(errno));
     }
+    // Downsample once the buffer is back with the driver.
+    frame.downsample(mDownsampleFactor);
     return std::make_optional(std::move(frame));
 }
 
@@ -248,9 +250,9 @@ TouchVideoDevice::~TouchVideoDevice() {
 
 std::string TouchVideoDevice::dump() const {
     return StringPrintf("Video device %s (%s) : height=%" PRIu32 ", width=%" PRIu32
-                        ", fd=%i, hasValidFd=%s",
-                        mName.c_str(), mPath.c_str(), mHeight, mWidth, mFd.get(),
-                        hasValidFd() ? "true" : "false");
+                        ", downsampleFactor=%" PRIu32 ", fd=%i, hasValidFd=%s",
+                        mName.c_str(), mPath.c_str(), mHeight, mWidth, mDownsampleFactor,
+                        mFd.get(), hasValidFd() ? "true" : "false");
 }
 
 } // namespace android
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <bitset>
+#include <chrono>
 #include <climits>
 #include <filesystem>
 #include <ostream>
@@ -625,6 +626,21 @@ private:
 
         int32_t controllerNumber;
 
+        // Counters of the reads of the device fd, reported by dump.
+        struct ReadStats {
+            uint64_t readCount = 0;
+            uint64_t eventCount = 0;
+            // Reads which filled the read buffer, so that more events may have been pending.
+            uint64_t fullReadCount = 0;
+            // The events per second, measured over windows of at least a second.
+            nsecs_t rateWindowStart = 0;
+            uint64_t rateWindowEventCount = 0;
+            float eventRate = 0;
+
+            void recordRead(size_t count, bool full, nsecs_t now);
+        };
+        ReadStats readStats;
+
         Device(int fd, int32_t id, std::string path, InputDeviceIdentifier identifier,
                std::shared_ptr<const AssociatedDevice> assocDev);
         ~Device();
@@ -767,6 +783,13 @@ private:
     size_t mPendingEventCount;
     size_t mPendingEventIndex;
     bool mPendingINotify;
+
+    // How long to wait after a device becomes readable for other devices, and more events of
+    // that device, before reading them, so that fast devices are read in fewer wakeups. The
+    // window ends early on wake(). Zero if the devices are read as soon as they are readable.
+    const std::chrono::microseconds mEventBatchWindow;
+    uint64_t mWakeupCount = 0;
+    uint64_t mBatchedWakeupCount = 0;
 };
 
 } // namespace android
@@ -60,6 +60,11 @@ public:
      * Get the width of the heatmap frame
      */
     uint32_t getWidth() const { return mWidth; }
+    /**
+     * Downsample the frames by the given factor as they are read, which makes the frames that are
+     * passed along with the motion events smaller. A factor of 1 keeps the frames as they are.
+     */
+    void setDownsampleFactor(uint32_t factor) { mDownsampleFactor = factor; }
     /**
      * Direct read of the frame. Stores the frame into internal buffer.
      * Return the number of frames that were successfully read.
@@ -88,6 +93,7 @@ private:
 
     uint32_t mHeight;
     uint32_t mWidth;
+    uint32_t mDownsampleFactor = 1;
 
     static constexpr int INVALID_FD = -1;
     /**
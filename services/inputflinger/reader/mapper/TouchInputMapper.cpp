@@ -2280,177 +2280,51 @@ void TouchInputMapper::cookPointerData() {
         mCurrentCookedState.buttonState = mCurrentRawState.buttonState;
     }
 
-    // Walk through the the active pointers and map device coordinates onto
-    // display coordinates and adjust for display orientation.
+    // The pointers are cooked one axis at a time, each step running over all the pointers, so
+    // that the branches on the calibration are taken once per frame and the arithmetic steps
+    // can be vectorized. Each pointer goes through the same operations, in the same order, as
+    // when it is cooked on its own.
+    CookingAxes axes{};
+    cookPointerSizes(currentPointerCount, axes);
+    cookPointerPressures(currentPointerCount, axes);
+    cookPointerOrientations(currentPointerCount, axes);
+    cookPointerDistances(currentPointerCount, axes);
+
+    // Adjust X,Y coords for device calibration and convert to the natural display coordinates.
     for (uint32_t i = 0; i < currentPointerCount; i++) {
         const RawPointerData::Pointer& in = mCurrentRawState.rawPointerData.pointers[i];
-
-        // Size
-        float touchMajor, touchMinor, toolMajor, toolMinor, size;
-        switch (mCalibration.sizeCalibration) {
-            case Calibration::SizeCalibration::GEOMETRIC:
-            case Calibration::SizeCalibration::DIAMETER:
-            case Calibration::SizeCalibration::BOX:
-            case Calibration::SizeCalibration::AREA:
-                if (mRawPointerAxes.touchMajor.valid && mRawPointerAxes.toolMajor.valid) {
-                    touchMajor = in.touchMajor;
-                    touchMinor = mRawPointerAxes.touchMinor.valid ? in.touchMinor : in.touchMajor;
-                    toolMajor = in.toolMajor;
-                    toolMinor = mRawPointerAxes.toolMinor.valid ? in.toolMinor : in.toolMajor;
-                    size = mRawPointerAxes.touchMinor.valid ? avg(in.touchMajor, in.touchMinor)
-                                                            : in.touchMajor;
-                } else if (mRawPointerAxes.touchMajor.valid) {
-                    toolMajor = touchMajor = in.touchMajor;
-                    toolMinor = touchMinor =
-                            mRawPointerAxes.touchMinor.valid ? in.touchMinor : in.touchMajor;
-                    size = mRawPointerAxes.touchMinor.valid ? avg(in.touchMajor, in.touchMinor)
-                                                            : in.touchMajor;
-                } else if (mRawPointerAxes.toolMajor.valid) {
-                    touchMajor = toolMajor = in.toolMajor;
-                    touchMinor = toolMinor =
-                            mRawPointerAxes.toolMinor.valid ? in.toolMinor : in.toolMajor;
-                    size = mRawPointerAxes.toolMinor.valid ? avg(in.toolMajor, in.toolMinor)
-                                                           : in.toolMajor;
-                } else {
-                    ALOG_ASSERT(false,
-                                "No touch or tool axes.  "
-                                "Size calibration should have been resolved to NONE.");
-                    touchMajor = 0;
-                    touchMinor = 0;
-                    toolMajor = 0;
-                    toolMinor = 0;
-                    size = 0;
-                }
-
-                if (mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed) {
-                    uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
-                    if (touchingCount > 1) {
-                        touchMajor /= touchingCount;
-                        touchMinor /= touchingCount;
-                        toolMajor /= touchingCount;
-                        toolMinor /= touchingCount;
-                        size /= touchingCount;
-                    }
-                }
-
-                if (mCalibration.sizeCalibration == Calibration::SizeCalibration::GEOMETRIC) {
-                    touchMajor *= mGeometricScale;
-                    touchMinor *= mGeometricScale;
-                    toolMajor *= mGeometricScale;
-                    toolMinor *= mGeometricScale;
-                } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::AREA) {
-                    touchMajor = touchMajor > 0 ? sqrtf(touchMajor) : 0;
-                    touchMinor = touchMajor;
-                    toolMajor = toolMajor > 0 ? sqrtf(toolMajor) : 0;
-                    toolMinor = toolMajor;
-                } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::DIAMETER) {
-                    touchMinor = touchMajor;
-                    toolMinor = toolMajor;
-                }
-
-                mCalibration.applySizeScaleAndBias(touchMajor);
-                mCalibration.applySizeScaleAndBias(touchMinor);
-                mCalibration.applySizeScaleAndBias(toolMajor);
-                mCalibration.applySizeScaleAndBias(toolMinor);
-                size *= mSizeScale;
-                break;
-            case Calibration::SizeCalibration::DEFAULT:
-                LOG_ALWAYS_FATAL("Resolution should not be 'DEFAULT' at this point");
-                break;
-            case Calibration::SizeCalibration::NONE:
-                touchMajor = 0;
-                touchMinor = 0;
-                toolMajor = 0;
-                toolMinor = 0;
-                size = 0;
-                break;
-        }
-
-        // Pressure
-        float pressure;
-        switch (mCalibration.pressureCalibration) {
-            case Calibration::PressureCalibration::PHYSICAL:
-            case Calibration::PressureCalibration::AMPLITUDE:
-                pressure = in.pressure * mPressureScale;
-                break;
-            default:
-                pressure = in.isHovering ? 0 : 1;
-                break;
-        }
-
-        // Tilt and Orientation
-        float tilt;
-        float orientation;
-        if (mHaveTilt) {
-            float tiltXAngle = (in.tiltX - mTiltXCenter) * mTiltXScale;
-            float tiltYAngle = (in.tiltY - mTiltYCenter) * mTiltYScale;
-            orientation = transformAngle(mRawRotation, atan2f(-sinf(tiltXAngle), sinf(tiltYAngle)));
-            tilt = acosf(cosf(tiltXAngle) * cosf(tiltYAngle));
-        } else {
-            tilt = 0;
-
-            switch (mCalibration.orientationCalibration) {
-                case Calibration::OrientationCalibration::INTERPOLATED:
-                    orientation = transformAngle(mRawRotation, in.orientation * mOrientationScale);
-                    break;
-                case Calibration::OrientationCalibration::VECTOR: {
-                    int32_t c1 = signExtendNybble((in.orientation & 0xf0) >> 4);
-                    int32_t c2 = signExtendNybble(in.orientation & 0x0f);
-                    if (c1 != 0 || c2 != 0) {
-                        orientation = transformAngle(mRawRotation, atan2f(c1, c2) * 0.5f);
-                        float confidence = hypotf(c1, c2);
-                        float scale = 1.0f + confidence / 16.0f;
-                        touchMajor *= scale;
-                        touchMinor /= scale;
-                        toolMajor *= scale;
-                        toolMinor /= scale;
-                    } else {
-                        orientation = 0;
-                    }
-                    break;
-                }
-                default:
-                    orientation = 0;
-            }
-        }
-
-        // Distance
-        float distance;
-        switch (mCalibration.distanceCalibration) {
-            case Calibration::DistanceCalibration::SCALED:
-                distance = in.distance * mDistanceScale;
-                break;
-            default:
-                distance = 0;
-        }
-
-        // Adjust X,Y coords for device calibration and convert to the natural display coordinates.
         vec2 transformed = {in.x, in.y};
         mAffineTransform.applyTo(transformed.x /*byRef*/, transformed.y /*byRef*/);
         transformed = mRawToDisplay.transform(transformed);
+        axes.x[i] = transformed.x;
+        axes.y[i] = transformed.y;
+    }
 
-        // Write output coords.
+    for (uint32_t i = 0; i < currentPointerCount; i++) {
+        const RawPointerData::Pointer& in = mCurrentRawState.rawPointerData.pointers[i];
+
+        // Write output coords, in the order of the axes so that each one is appended.
         PointerCoords& out = mCurrentCookedState.cookedPointerData.pointerCoords[i];
         out.clear();
-        out.setAxisValue(AMOTION_EVENT_AXIS_X, transformed.x);
-        out.setAxisValue(AMOTION_EVENT_AXIS_Y, transformed.y);
-        out.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, pressure);
-        out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
-        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor);
+        out.setAxisValue(AMOTION_EVENT_AXIS_X, axes.x[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_Y, axes.y[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, axes.pressure[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, axes.size[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, axes.touchMajor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, axes.touchMinor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, axes.toolMajor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, axes.toolMinor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, axes.orientation[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, axes.distance[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, axes.tilt[i]);
 
         // Write output relative fields if applicable.
         uint32_t id = in.id;
         if (mSource == AINPUT_SOURCE_TOUCHPAD &&
             mLastCookedState.cookedPointerData.hasPointerCoordsForId(id)) {
             const PointerCoords& p = mLastCookedState.cookedPointerData.pointerCoordsForId(id);
-            float dx = transformed.x - p.getAxisValue(AMOTION_EVENT_AXIS_X);
-            float dy = transformed.y - p.getAxisValue(AMOTION_EVENT_AXIS_Y);
+            float dx = axes.x[i] - p.getAxisValue(AMOTION_EVENT_AXIS_X);
+            float dy = axes.y[i] - p.getAxisValue(AMOTION_EVENT_AXIS_Y);
             out.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X, dx);
             out.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y, dy);
         }
@@ -2467,6 +2341,164 @@ void TouchInputMapper::cookPointerData() {
     }
 }
 
+void TouchInputMapper::cookPointerSizes(uint32_t count, CookingAxes& axes) const {
+    const RawPointerData::Pointer* in = mCurrentRawState.rawPointerData.pointers;
+    switch (mCalibration.sizeCalibration) {
+        case Calibration::SizeCalibration::GEOMETRIC:
+        case Calibration::SizeCalibration::DIAMETER:
+        case Calibration::SizeCalibration::BOX:
+        case Calibration::SizeCalibration::AREA:
+            break;
+        case Calibration::SizeCalibration::DEFAULT:
+            LOG_ALWAYS_FATAL("Resolution should not be 'DEFAULT' at this point");
+            return;
+        case Calibration::SizeCalibration::NONE:
+            // The axes are already zero.
+            return;
+    }
+
+    const bool hasTouchMinor = mRawPointerAxes.touchMinor.valid;
+    const bool hasToolMinor = mRawPointerAxes.toolMinor.valid;
+    if (mRawPointerAxes.touchMajor.valid && mRawPointerAxes.toolMajor.valid) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.touchMajor[i] = in[i].touchMajor;
+            axes.touchMinor[i] = hasTouchMinor ? in[i].touchMinor : in[i].touchMajor;
+            axes.toolMajor[i] = in[i].toolMajor;
+            axes.toolMinor[i] = hasToolMinor ? in[i].toolMinor : in[i].toolMajor;
+            axes.size[i] = hasTouchMinor ? avg(in[i].touchMajor, in[i].touchMinor)
+                                         : in[i].touchMajor;
+        }
+    } else if (mRawPointerAxes.touchMajor.valid) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.toolMajor[i] = axes.touchMajor[i] = in[i].touchMajor;
+            axes.toolMinor[i] = axes.touchMinor[i] =
+                    hasTouchMinor ? in[i].touchMinor : in[i].touchMajor;
+            axes.size[i] = hasTouchMinor ? avg(in[i].touchMajor, in[i].touchMinor)
+                                         : in[i].touchMajor;
+        }
+    } else if (mRawPointerAxes.toolMajor.valid) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.touchMajor[i] = axes.toolMajor[i] = in[i].toolMajor;
+            axes.touchMinor[i] = axes.toolMinor[i] =
+                    hasToolMinor ? in[i].toolMinor : in[i].toolMajor;
+            axes.size[i] = hasToolMinor ? avg(in[i].toolMajor, in[i].toolMinor) : in[i].toolMajor;
+        }
+    } else {
+        ALOG_ASSERT(false,
+                    "No touch or tool axes.  "
+                    "Size calibration should have been resolved to NONE.");
+    }
+
+    if (mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed) {
+        uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
+        if (touchingCount > 1) {
+            for (uint32_t i = 0; i < count; i++) {
+                axes.touchMajor[i] /= touchingCount;
+                axes.touchMinor[i] /= touchingCount;
+                axes.toolMajor[i] /= touchingCount;
+                axes.toolMinor[i] /= touchingCount;
+                axes.size[i] /= touchingCount;
+            }
+        }
+    }
+
+    if (mCalibration.sizeCalibration == Calibration::SizeCalibration::GEOMETRIC) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.touchMajor[i] *= mGeometricScale;
+            axes.touchMinor[i] *= mGeometricScale;
+            axes.toolMajor[i] *= mGeometricScale;
+            axes.toolMinor[i] *= mGeometricScale;
+        }
+    } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::AREA) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.touchMajor[i] = axes.touchMajor[i] > 0 ? sqrtf(axes.touchMajor[i]) : 0;
+            axes.touchMinor[i] = axes.touchMajor[i];
+            axes.toolMajor[i] = axes.toolMajor[i] > 0 ? sqrtf(axes.toolMajor[i]) : 0;
+            axes.toolMinor[i] = axes.toolMajor[i];
+        }
+    } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::DIAMETER) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.touchMinor[i] = axes.touchMajor[i];
+            axes.toolMinor[i] = axes.toolMajor[i];
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        mCalibration.applySizeScaleAndBias(axes.touchMajor[i]);
+        mCalibration.applySizeScaleAndBias(axes.touchMinor[i]);
+        mCalibration.applySizeScaleAndBias(axes.toolMajor[i]);
+        mCalibration.applySizeScaleAndBias(axes.toolMinor[i]);
+        axes.size[i] *= mSizeScale;
+    }
+}
+
+void TouchInputMapper::cookPointerPressures(uint32_t count, CookingAxes& axes) const {
+    const RawPointerData::Pointer* in = mCurrentRawState.rawPointerData.pointers;
+    switch (mCalibration.pressureCalibration) {
+        case Calibration::PressureCalibration::PHYSICAL:
+        case Calibration::PressureCalibration::AMPLITUDE:
+            for (uint32_t i = 0; i < count; i++) {
+                axes.pressure[i] = in[i].pressure * mPressureScale;
+            }
+            break;
+        default:
+            for (uint32_t i = 0; i < count; i++) {
+                axes.pressure[i] = in[i].isHovering ? 0 : 1;
+            }
+            break;
+    }
+}
+
+void TouchInputMapper::cookPointerOrientations(uint32_t count, CookingAxes& axes) const {
+    const RawPointerData::Pointer* in = mCurrentRawState.rawPointerData.pointers;
+    // The tilt stays zero unless the device reports it.
+    if (mHaveTilt) {
+        for (uint32_t i = 0; i < count; i++) {
+            float tiltXAngle = (in[i].tiltX - mTiltXCenter) * mTiltXScale;
+            float tiltYAngle = (in[i].tiltY - mTiltYCenter) * mTiltYScale;
+            axes.orientation[i] =
+                    transformAngle(mRawRotation, atan2f(-sinf(tiltXAngle), sinf(tiltYAngle)));
+            axes.tilt[i] = acosf(cosf(tiltXAngle) * cosf(tiltYAngle));
+        }
+        return;
+    }
+
+    switch (mCalibration.orientationCalibration) {
+        case Calibration::OrientationCalibration::INTERPOLATED:
+            for (uint32_t i = 0; i < count; i++) {
+                axes.orientation[i] =
+                        transformAngle(mRawRotation, in[i].orientation * mOrientationScale);
+            }
+            break;
+        case Calibration::OrientationCalibration::VECTOR:
+            for (uint32_t i = 0; i < count; i++) {
+                int32_t c1 = signExtendNybble((in[i].orientation & 0xf0) >> 4);
+                int32_t c2 = signExtendNybble(in[i].orientation & 0x0f);
+                if (c1 != 0 || c2 != 0) {
+                    axes.orientation[i] = transformAngle(mRawRotation, atan2f(c1, c2) * 0.5f);
+                    float confidence = hypotf(c1, c2);
+                    float scale = 1.0f + confidence / 16.0f;
+                    axes.touchMajor[i] *= scale;
+                    axes.touchMinor[i] /= scale;
+                    axes.toolMajor[i] *= scale;
+                    axes.toolMinor[i] /= scale;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void TouchInputMapper::cookPointerDistances(uint32_t count, CookingAxes& axes) const {
+    const RawPointerData::Pointer* in = mCurrentRawState.rawPointerData.pointers;
+    if (mCalibration.distanceCalibration == Calibration::DistanceCalibration::SCALED) {
+        for (uint32_t i = 0; i < count; i++) {
+            axes.distance[i] = in[i].distance * mDistanceScale;
+        }
+    }
+}
+
 std::list<NotifyArgs> TouchInputMapper::dispatchPointerUsage(nsecs_t when, nsecs_t readTime,
                                                              uint32_t policyFlags,
                                                              PointerUsage pointerUsage) {
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <optional>
 #include <string>
 
@@ -749,6 +750,28 @@ private:
                                                                      nsecs_t readTime);
     const BitSet32& findActiveIdBits(const CookedPointerData& cookedPointerData);
     void cookPointerData();
+
+    // The cooked axes of the pointers of the current frame, stored axis by axis so that each
+    // step of cooking runs over all the pointers together.
+    struct CookingAxes {
+        std::array<float, MAX_POINTERS> x;
+        std::array<float, MAX_POINTERS> y;
+        std::array<float, MAX_POINTERS> pressure;
+        std::array<float, MAX_POINTERS> size;
+        std::array<float, MAX_POINTERS> touchMajor;
+        std::array<float, MAX_POINTERS> touchMinor;
+        std::array<float, MAX_POINTERS> toolMajor;
+        std::array<float, MAX_POINTERS> toolMinor;
+        std::array<float, MAX_POINTERS> orientation;
+        std::array<float, MAX_POINTERS> distance;
+        std::array<float, MAX_POINTERS> tilt;
+    };
+    // The steps of cookPointerData(). The axes start out as zero, which is left as it is for
+    // the axes that the device does not report.
+    void cookPointerSizes(uint32_t count, CookingAxes& axes) const;
+    void cookPointerPressures(uint32_t count, CookingAxes& axes) const;
+    void cookPointerOrientations(uint32_t count, CookingAxes& axes) const;
+    void cookPointerDistances(uint32_t count, CookingAxes& axes) const;
     [[nodiscard]] std::list<NotifyArgs> abortTouches(nsecs_t when, nsecs_t readTime,
                                                      uint32_t policyFlags);
 
@@ -17,6 +17,7 @@
 #include "../Macros.h"
 
 #include <chrono>
+#include <iterator>
 #include <limits>
 #include <optional>
 
@@ -329,7 +330,7 @@ std::list<NotifyArgs> TouchpadInputMapper::process(const RawEvent* rawEvent) {
     if (mPointerCaptured) {
         return mCapturedEventConverter.process(*rawEvent);
     }
-    std::optional<SelfContainedHardwareState> state = mStateConverter.processRawEvent(rawEvent);
+    const SelfContainedHardwareState* state = mStateConverter.processRawEvent(rawEvent);
     if (state) {
         return sendHardwareState(rawEvent->when, rawEvent->readTime, *state);
     } else {
@@ -337,11 +338,13 @@ std::list<NotifyArgs> TouchpadInputMapper::process(const RawEvent* rawEvent) {
     }
 }
 
-std::list<NotifyArgs> TouchpadInputMapper::sendHardwareState(nsecs_t when, nsecs_t readTime,
-                                                             SelfContainedHardwareState schs) {
+std::list<NotifyArgs> TouchpadInputMapper::sendHardwareState(
+        nsecs_t when, nsecs_t readTime, const SelfContainedHardwareState& schs) {
     ALOGD_IF(DEBUG_TOUCHPAD_GESTURES, "New hardware state: %s", schs.state.String().c_str());
+    // The fingers stay owned by the converter.
+    HardwareState state = schs.state;
     mProcessing = true;
-    mGestureInterpreter->PushHardwareState(&schs.state);
+    mGestureInterpreter->PushHardwareState(&state);
     mProcessing = false;
 
     return processGestures(when, readTime);
@@ -363,9 +366,20 @@ void TouchpadInputMapper::consumeGesture(const Gesture* gesture) {
 
 std::list<NotifyArgs> TouchpadInputMapper::processGestures(nsecs_t when, nsecs_t readTime) {
     std::list<NotifyArgs> out = {};
-    for (Gesture& gesture : mGesturesToProcess) {
+    for (auto it = mGesturesToProcess.begin(); it != mGesturesToProcess.end(); ++it) {
+        Gesture& gesture = *it;
+        // Consecutive moves of a frame are reported as one move of their total distance, as they
+        // would all be delivered with the same event time anyway.
+        while (gesture.type == kGestureTypeMove && std::next(it) != mGesturesToProcess.end() &&
+               std::next(it)->type == kGestureTypeMove) {
+            ++it;
+            gesture.details.move.dx += it->details.move.dx;
+            gesture.details.move.dy += it->details.move.dy;
+            gesture.end_time = it->end_time;
+        }
         out += mGestureConverter.handleGesture(when, readTime, gesture);
     }
+    // Keeps the capacity for the gestures of the next frames.
     mGesturesToProcess.clear();
     return out;
 }
@@ -16,7 +16,6 @@
 
 #pragma once
 
-#include <optional>
 #include <set>
 
 #include <utils/Timers.h>
@@ -44,17 +43,21 @@ public:
     HardwareStateConverter(const InputDeviceContext& deviceContext,
                            MultiTouchMotionAccumulator& motionAccumulator);
 
-    std::optional<SelfContainedHardwareState> processRawEvent(const RawEvent* event);
+    // Returns the HardwareState of the frame that the event completes, if any. The state is reused
+    // for every frame, so that its fingers are not reallocated, and is only valid until the next
+    // call.
+    const SelfContainedHardwareState* processRawEvent(const RawEvent* event);
     void reset();
 
 private:
-    SelfContainedHardwareState produceHardwareState(nsecs_t when);
+    void produceHardwareState(nsecs_t when);
 
     const InputDeviceContext& mDeviceContext;
     CursorButtonAccumulator mCursorButtonAccumulator;
     MultiTouchMotionAccumulator& mMotionAccumulator;
     TouchButtonAccumulator mTouchButtonAccumulator;
     int32_t mMscTimestamp = 0;
+    SelfContainedHardwareState mState;
 };
 
 } // namespace android
@@ -218,6 +218,20 @@ TEST_F(EventHubTest, InputEvent_TimestampIsMonotonic) {
     }
 }
 
+/**
+ * Ensure that the reads of the device are counted in the dump of the EventHub.
+ */
+TEST_F(EventHubTest, InputEvent_ReadsAreDumped) {
+    ASSERT_NO_FATAL_FAILURE(mKeyboard->pressAndReleaseHomeKey());
+
+    std::vector<RawEvent> events = getEvents(4);
+    ASSERT_EQ(4U, events.size()) << "Expected to receive 2 keys and 2 syncs, total of 4 events";
+
+    std::string dump;
+    mEventHub->dump(dump);
+    ASSERT_NE(std::string::npos, dump.find(", events=4, eventRate=")) << dump;
+}
+
 // --- BitArrayTest ---
 class BitArrayTest : public testing::Test {
 protected:
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/LatencyHistograms.h"
+
+#include <binder/Binder.h>
+#include <gtest/gtest.h>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+constexpr int32_t DEVICE_ID = 5;
+
+size_t getCount(const LatencyHistograms::StageHistograms& histograms, LatencyStage stage) {
+    return histograms[static_cast<size_t>(stage)].getCount();
+}
+
+nsecs_t getMedian(const LatencyHistograms::StageHistograms& histograms, LatencyStage stage) {
+    return histograms[static_cast<size_t>(stage)].getPercentile(50);
+}
+
+// A timeline with the given connection, where each stage takes 1ms longer than the previous one.
+InputEventTimeline createTimeline(const sp<IBinder>& connectionToken, bool withGraphics) {
+    InputEventTimeline timeline(/*isDown=*/false, /*eventTime=*/1'000'000, /*readTime=*/2'000'000,
+                                DEVICE_ID, /*cookedTime=*/4'000'000, /*enqueueTime=*/7'000'000);
+    ConnectionTimeline connectionTimeline(/*deliveryTime=*/11'000'000, /*consumeTime=*/16'000'000,
+                                          /*finishTime=*/22'000'000);
+    if (withGraphics) {
+        std::array<nsecs_t, GraphicsTimeline::SIZE> graphicsTimeline;
+        graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME] = 25'000'000;
+        graphicsTimeline[GraphicsTimeline::PRESENT_TIME] = 29'000'000;
+        connectionTimeline.setGraphicsTimeline(std::move(graphicsTimeline));
+    }
+    timeline.connectionTimelines.emplace(connectionToken, std::move(connectionTimeline));
+    return timeline;
+}
+
+} // namespace
+
+TEST(LatencyHistogramTest, PercentilesAreBucketUpperBounds) {
+    LatencyHistogram histogram;
+    ASSERT_EQ(0, histogram.getPercentile(50));
+    for (int i = 0; i < 50; i++) {
+        histogram.add(100'000);
+    }
+    for (int i = 0; i < 40; i++) {
+        histogram.add(3'000'000);
+    }
+    for (int i = 0; i < 10; i++) {
+        histogram.add(100'000'000);
+    }
+    ASSERT_EQ(100u, histogram.getCount());
+    ASSERT_EQ(250'000, histogram.getPercentile(50));
+    ASSERT_EQ(4'000'000, histogram.getPercentile(90));
+    // The bucket of the slowest latencies goes up to 128ms, but none of them are above 100ms.
+    ASSERT_EQ(100'000'000, histogram.getPercentile(99));
+}
+
+TEST(LatencyHistogramTest, NegativeAndVeryLongLatencies) {
+    LatencyHistogram histogram;
+    histogram.add(-1'000'000);
+    ASSERT_EQ(0, histogram.getPercentile(100));
+    histogram.add(10'000'000'000);
+    ASSERT_EQ(2u, histogram.getCount());
+    ASSERT_EQ(10'000'000'000, histogram.getPercentile(100));
+}
+
+TEST(LatencyHistogramsTest, StagesAreRecordedPerDeviceAndPerWindow) {
+    const sp<IBinder> connectionToken = sp<BBinder>::make();
+    size_t nameLookups = 0;
+    LatencyHistograms histograms([&](const sp<IBinder>& token) {
+        EXPECT_EQ(connectionToken, token);
+        nameLookups++;
+        return std::string("window");
+    });
+    histograms.processTimeline(createTimeline(connectionToken, /*withGraphics=*/true));
+    histograms.processTimeline(createTimeline(connectionToken, /*withGraphics=*/true));
+    ASSERT_EQ(1u, nameLookups);
+
+    const LatencyHistograms::StageHistograms* device = histograms.getDeviceHistograms(DEVICE_ID);
+    const LatencyHistograms::StageHistograms* window =
+            histograms.getWindowHistograms(connectionToken);
+    ASSERT_NE(nullptr, device);
+    ASSERT_NE(nullptr, window);
+    for (const LatencyHistograms::StageHistograms* stages : {device, window}) {
+        for (LatencyStage stage : ftl::enum_range<LatencyStage>()) {
+            SCOPED_TRACE(ftl::enum_string(stage));
+            ASSERT_EQ(2u, getCount(*stages, stage));
+        }
+        ASSERT_EQ(2'000'000, getMedian(*stages, LatencyStage::READ_TO_COOKED));
+        ASSERT_EQ(4'000'000, getMedian(*stages, LatencyStage::ENQUEUED_TO_PUBLISHED));
+        ASSERT_EQ(6'000'000, getMedian(*stages, LatencyStage::CONSUMED_TO_FINISHED));
+        ASSERT_EQ(28'000'000, getMedian(*stages, LatencyStage::END_TO_END));
+    }
+    ASSERT_EQ(nullptr, histograms.getDeviceHistograms(DEVICE_ID + 1));
+    ASSERT_NE(std::string::npos, histograms.dump("").find("Window 'window'"));
+}
+
+/**
+ * The stages of a window are only recorded once the app has reported the whole timeline, but the
+ * stages before the dispatch of the event are recorded for its device.
+ */
+TEST(LatencyHistogramsTest, IncompleteConnectionTimelineIsNotRecorded) {
+    const sp<IBinder> connectionToken = sp<BBinder>::make();
+    LatencyHistograms histograms([](const sp<IBinder>&) { return std::string("window"); });
+    histograms.processTimeline(createTimeline(connectionToken, /*withGraphics=*/false));
+
+    const LatencyHistograms::StageHistograms* device = histograms.getDeviceHistograms(DEVICE_ID);
+    ASSERT_NE(nullptr, device);
+    ASSERT_EQ(1u, getCount(*device, LatencyStage::KERNEL_TO_READ));
+    ASSERT_EQ(1u, getCount(*device, LatencyStage::COOKED_TO_ENQUEUED));
+    ASSERT_EQ(0u, getCount(*device, LatencyStage::ENQUEUED_TO_PUBLISHED));
+    ASSERT_EQ(nullptr, histograms.getWindowHistograms(connectionToken));
+}
+
+} // namespace android::inputdispatcher
@@ -143,6 +143,18 @@ TEST_F(LatencyTrackerTest, TrackListener_DoesNotTriggerReporting) {
     assertReceivedTimeline(InputEventTimeline{false, 2, 3});
 }
 
+/**
+ * The device and the times at which the dispatcher received and enqueued the event are kept in
+ * the reported timeline.
+ */
+TEST_F(LatencyTrackerTest, TrackListener_KeepsDeviceAndDispatcherTimes) {
+    mTracker->trackListener(/*inputEventId=*/1, /*isDown=*/false, /*eventTime=*/2,
+                            /*readTime=*/3, /*deviceId=*/4, /*cookedTime=*/5,
+                            /*enqueueTime=*/6);
+    triggerEventReporting(/*eventTime=*/2);
+    assertReceivedTimeline(InputEventTimeline{false, 2, 3, 4, 5, 6});
+}
+
 /**
  * A single call to trackFinishedEvent should not cause a timeline to be reported.
  */
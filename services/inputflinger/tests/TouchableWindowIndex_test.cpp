@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../dispatcher/TouchableWindowIndex.h"
+
+// atest inputflinger_tests:TouchableWindowIndexTest
+
+using android::gui::WindowInfoHandle;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+class FakeWindowHandle : public WindowInfoHandle {
+public:
+    explicit FakeWindowHandle(const Region& touchableRegion) {
+        mInfo.touchableRegion = touchableRegion;
+    }
+
+    void setTouchableRegion(const Region& touchableRegion) {
+        mInfo.touchableRegion = touchableRegion;
+    }
+};
+
+// Returns the windows whose touchable regions contain the point, front to back.
+std::vector<size_t> getTouchedWindows(TouchableWindowIndex::HitTest hitTest, size_t windowCount) {
+    std::vector<size_t> touchedWindows;
+    for (size_t i = 0; i < windowCount; i++) {
+        if (hitTest.touchableRegionContains(i)) {
+            touchedWindows.push_back(i);
+        }
+    }
+    return touchedWindows;
+}
+
+} // namespace
+
+TEST(TouchableWindowIndexTest, HitTestMatchesTouchableRegions) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    windows.push_back(sp<FakeWindowHandle>::make(Region(Rect(0, 0, 100, 100))));
+    windows.push_back(sp<FakeWindowHandle>::make(Region(Rect(50, 50, 1080, 2340))));
+    windows.push_back(sp<FakeWindowHandle>::make(Region()));
+    Region region(Rect(0, 1000, 200, 1100));
+    region.orSelf(Rect(900, 1000, 1080, 1100));
+    windows.push_back(sp<FakeWindowHandle>::make(region));
+    const ui::Transform identity;
+    TouchableWindowIndex index(windows, identity);
+    ASSERT_TRUE(index.isFor(windows, identity));
+
+    EXPECT_EQ(std::vector<size_t>({0}), getTouchedWindows(index.hitTest(10, 10), windows.size()));
+    EXPECT_EQ(std::vector<size_t>({0, 1}),
+              getTouchedWindows(index.hitTest(60, 60), windows.size()));
+    // The right and bottom edges of the touchable regions are outside of them.
+    EXPECT_EQ(std::vector<size_t>({1}),
+              getTouchedWindows(index.hitTest(100, 99.5), windows.size()));
+    EXPECT_EQ(std::vector<size_t>({1, 3}),
+              getTouchedWindows(index.hitTest(1000, 1050), windows.size()));
+    EXPECT_EQ(std::vector<size_t>({1}),
+              getTouchedWindows(index.hitTest(500, 1050), windows.size()));
+    EXPECT_EQ(std::vector<size_t>(), getTouchedWindows(index.hitTest(-1, 10), windows.size()));
+    EXPECT_EQ(std::vector<size_t>(),
+              getTouchedWindows(index.hitTest(1080, 2340), windows.size()));
+}
+
+TEST(TouchableWindowIndexTest, HitTestMatchesFallback) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int32_t> position(-100, 1200);
+    std::uniform_int_distribution<int32_t> size(0, 600);
+    std::vector<sp<WindowInfoHandle>> windows;
+    for (int i = 0; i < 50; i++) {
+        const int32_t left = position(random);
+        const int32_t top = position(random);
+        windows.push_back(sp<FakeWindowHandle>::make(
+                Region(Rect(left, top, left + size(random), top + size(random)))));
+    }
+    ui::Transform transform;
+    transform.set(ui::Transform::ROT_90, 1080, 2340);
+    TouchableWindowIndex index(windows, transform);
+
+    std::uniform_real_distribution<float> coordinate(-200, 1400);
+    for (int i = 0; i < 1000; i++) {
+        const float x = coordinate(random);
+        const float y = coordinate(random);
+        ASSERT_EQ(getTouchedWindows(TouchableWindowIndex::HitTest(windows, transform, x, y),
+                                    windows.size()),
+                  getTouchedWindows(index.hitTest(x, y), windows.size()))
+                << "at (" << x << ", " << y << ")";
+    }
+}
+
+TEST(TouchableWindowIndexTest, IsOnlyForTheWindowsItWasBuiltFor) {
+    sp<FakeWindowHandle> window = sp<FakeWindowHandle>::make(Region(Rect(0, 0, 100, 100)));
+    std::vector<sp<WindowInfoHandle>> windows{window};
+    const ui::Transform identity;
+    TouchableWindowIndex index(windows, identity);
+    ASSERT_TRUE(index.isFor(windows, identity));
+
+    ui::Transform rotation;
+    rotation.set(ui::Transform::ROT_90, 1080, 2340);
+    EXPECT_FALSE(index.isFor(windows, rotation));
+
+    std::vector<sp<WindowInfoHandle>> otherWindows{
+            sp<FakeWindowHandle>::make(Region(Rect(0, 0, 100, 100)))};
+    EXPECT_FALSE(index.isFor(otherWindows, identity));
+
+    window->setTouchableRegion(Region(Rect(0, 0, 50, 50)));
+    EXPECT_FALSE(index.isFor(windows, identity));
+}
+
+} // namespace android::inputdispatcher
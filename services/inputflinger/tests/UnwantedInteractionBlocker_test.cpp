@@ -520,6 +520,19 @@ TEST_F(UnwantedInteractionBlockerTest, NoResetIfDeviceInfoChanges) {
     mBlocker->notifyMotion(generateMotionArgs(/*downTime=*/0, /*eventTime=*/4, MOVE, {{7, 8, 9}}));
 }
 
+/**
+ * The events are moved between the stages of the blocker. Make sure that the video frames of a
+ * touch are still sent to the next listener.
+ */
+TEST_F(UnwantedInteractionBlockerTest, VideoFramesArePassedToNextListener) {
+    mBlocker->notifyInputDevicesChanged({/*id=*/0, {generateTestDeviceInfo()}});
+    NotifyMotionArgs args = generateMotionArgs(/*downTime=*/0, /*eventTime=*/0, DOWN, {{1, 2, 3}});
+    args.videoFrames = {TouchVideoFrame(2, 2, {1, 2, 3, 4}, {1, 1})};
+    mBlocker->notifyMotion(args);
+    ASSERT_NO_FATAL_FAILURE(mTestListener.assertNotifyMotionWasCalled(
+            testing::Field(&NotifyMotionArgs::videoFrames, args.videoFrames)));
+}
+
 /**
  * Send a touch event, and then a stylus event. Make sure that both work.
  */
@@ -876,12 +889,15 @@ TEST_F(PalmRejectorTest, TwoPointersAreCanceled) {
 class TestFilter : public ::ui::PalmDetectionFilter {
 public:
     TestFilter(::ui::SharedPalmDetectionFilterState* state,
-               std::vector<std::pair<float, float>>& suppressedPointers)
-          : ::ui::PalmDetectionFilter(state), mSuppressedPointers(suppressedPointers) {}
+               std::vector<std::pair<float, float>>& suppressedPointers, size_t& filterCallCount)
+          : ::ui::PalmDetectionFilter(state),
+            mSuppressedPointers(suppressedPointers),
+            mFilterCallCount(filterCallCount) {}
 
     void Filter(const std::vector<::ui::InProgressTouchEvdev>& touches, ::base::TimeTicks time,
                 std::bitset<::ui::kNumTouchEvdevSlots>* slots_to_hold,
                 std::bitset<::ui::kNumTouchEvdevSlots>* slots_to_suppress) override {
+        mFilterCallCount++;
         updateSuppressedSlots(touches);
         *slots_to_suppress = mSuppressedSlots;
     }
@@ -904,6 +920,7 @@ private:
 
     std::bitset<::ui::kNumTouchEvdevSlots> mSuppressedSlots;
     std::vector<std::pair<float, float>>& mSuppressedPointers;
+    size_t& mFilterCallCount;
 };
 
 class PalmRejectorFakeFilterTest : public testing::Test {
@@ -912,13 +929,16 @@ protected:
 
     void SetUp() override {
         std::unique_ptr<::ui::PalmDetectionFilter> filter =
-                std::make_unique<TestFilter>(&mSharedPalmState, /*byref*/ mSuppressedPointers);
+                std::make_unique<TestFilter>(&mSharedPalmState, /*byref*/ mSuppressedPointers,
+                                             /*byref*/ mFilterCallCount);
         mPalmRejector =
                 std::make_unique<PalmRejector>(generatePalmFilterDeviceInfo(), std::move(filter));
     }
 
     void suppressPointerAtPosition(float x, float y) { mSuppressedPointers.push_back({x, y}); }
 
+    size_t mFilterCallCount = 0;
+
 private:
     std::vector<std::pair<float, float>> mSuppressedPointers;
     ::ui::SharedPalmDetectionFilterState mSharedPalmState; // unused, but we must retain ownership
@@ -1094,4 +1114,76 @@ TEST_F(PalmRejectorFakeFilterTest, CancelTwoPointers) {
     ASSERT_EQ(CANCEL, argsList[0].action);
 }
 
+/**
+ * A small touch far from the edges of the screen is not sent to the filter.
+ */
+TEST_F(PalmRejectorFakeFilterTest, FilterIsSkippedForSmallTouchFarFromEdges) {
+    std::vector<NotifyMotionArgs> argsList;
+    constexpr nsecs_t downTime = 0;
+
+    argsList = mPalmRejector->processMotion(
+            generateMotionArgs(downTime, downTime, DOWN, {{800.0, 1200.0, 5.0}}));
+    ASSERT_EQ(1u, argsList.size());
+    ASSERT_EQ(DOWN, argsList[0].action);
+    argsList = mPalmRejector->processMotion(
+            generateMotionArgs(downTime, RESAMPLE_PERIOD, MOVE, {{810.0, 1210.0, 6.0}}));
+    ASSERT_EQ(1u, argsList.size());
+    ASSERT_EQ(MOVE, argsList[0].action);
+    argsList = mPalmRejector->processMotion(
+            generateMotionArgs(downTime, 2 * RESAMPLE_PERIOD, UP, {{810.0, 1210.0, 6.0}}));
+    ASSERT_EQ(1u, argsList.size());
+    ASSERT_EQ(UP, argsList[0].action);
+    ASSERT_EQ(0u, mFilterCallCount);
+
+    // A touch near the edge is filtered.
+    const nsecs_t secondDownTime = 3 * RESAMPLE_PERIOD;
+    mPalmRejector->processMotion(
+            generateMotionArgs(secondDownTime, secondDownTime, DOWN, {{50.0, 1200.0, 5.0}}));
+    ASSERT_EQ(1u, mFilterCallCount);
+}
+
+/**
+ * When a second pointer goes down, the touches of the gesture which were not sent to the filter
+ * are sent before the new event, and the first pointer is canceled if the filter finds that it is
+ * a palm.
+ */
+TEST_F(PalmRejectorFakeFilterTest, HeldTouchesAreFilteredWhenSecondPointerGoesDown) {
+    std::vector<NotifyMotionArgs> argsList;
+    constexpr nsecs_t downTime = 0;
+
+    mPalmRejector->processMotion(
+            generateMotionArgs(downTime, downTime, DOWN, {{800.0, 1200.0, 5.0}}));
+    mPalmRejector->processMotion(
+            generateMotionArgs(downTime, RESAMPLE_PERIOD, MOVE, {{810.0, 1210.0, 6.0}}));
+    ASSERT_EQ(0u, mFilterCallCount);
+
+    suppressPointerAtPosition(800, 1200);
+    argsList = mPalmRejector->processMotion(
+            generateMotionArgs(downTime, 2 * RESAMPLE_PERIOD, POINTER_1_DOWN,
+                               {{820.0, 1220.0, 6.0}, {300.0, 400.0, 5.0}}));
+    ASSERT_EQ(3u, mFilterCallCount);
+    ASSERT_EQ(2u, argsList.size());
+    ASSERT_EQ(POINTER_0_UP, argsList[0].action);
+    ASSERT_EQ(FLAG_CANCELED, argsList[0].flags);
+    ASSERT_EQ(DOWN, argsList[1].action);
+    ASSERT_EQ(1u, argsList[1].pointerCount);
+    ASSERT_EQ(300, argsList[1].pointerCoords[0].getX());
+}
+
+/**
+ * A touch which grows to the size of a palm is sent to the filter from then on.
+ */
+TEST_F(PalmRejectorFakeFilterTest, LargeTouchIsFiltered) {
+    constexpr nsecs_t downTime = 0;
+
+    mPalmRejector->processMotion(
+            generateMotionArgs(downTime, downTime, DOWN, {{800.0, 1200.0, 5.0}}));
+    mPalmRejector->processMotion(
+            generateMotionArgs(downTime, RESAMPLE_PERIOD, MOVE, {{800.0, 1200.0, 40.0}}));
+    ASSERT_EQ(2u, mFilterCallCount);
+    mPalmRejector->processMotion(
+            generateMotionArgs(downTime, 2 * RESAMPLE_PERIOD, MOVE, {{800.0, 1200.0, 5.0}}));
+    ASSERT_EQ(3u, mFilterCallCount);
+}
+
 } // namespace android
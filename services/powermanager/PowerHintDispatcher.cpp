@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *                        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PowerHintDispatcher"
+#include <powermanager/PowerHintDispatcher.h>
+#include <pthread.h>
+#include <utils/Log.h>
+
+#include <cerrno>
+
+using namespace android::hardware::power;
+using namespace std::chrono_literals;
+
+namespace android {
+
+namespace power {
+
+// -------------------------------------------------------------------------------------------------
+
+namespace {
+
+// Returns the bit of the hint in the masks, or 0 if its value does not fit in the masks.
+template <typename T>
+uint64_t bitOf(T hint) {
+    const auto index = static_cast<uint64_t>(hint);
+    return index < 64 ? uint64_t(1) << index : 0;
+}
+
+template <typename Function>
+void forEachBit(uint64_t mask, Function function) {
+    while (mask != 0) {
+        const int index = __builtin_ctzll(mask);
+        mask &= mask - 1;
+        function(index, uint64_t(1) << index);
+    }
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+
+PowerHintDispatcher::PowerHintDispatcher(HalWrapper& hal,
+                                         std::chrono::nanoseconds coalescingWindow)
+      : mHal(hal), mCoalescingWindow(coalescingWindow) {
+    sem_init(&mWakeup, /* pshared= */ 0, /* value= */ 0);
+    mWorkDurationBatch.reserve(WORK_DURATION_CAPACITY);
+    mThread = std::thread([this] { threadMain(); });
+}
+
+PowerHintDispatcher::~PowerHintDispatcher() {
+    mStopping.store(true);
+    sem_post(&mWakeup);
+    mThread.join();
+    sem_destroy(&mWakeup);
+}
+
+void PowerHintDispatcher::setBoost(Boost boost, int32_t durationMs) {
+    const uint64_t bit = bitOf(boost);
+    if (bit == 0) {
+        mHal.setBoost(boost, durationMs);
+        return;
+    }
+    mBoostDurationsMs[static_cast<size_t>(boost)].store(durationMs, std::memory_order_relaxed);
+    mPendingBoosts.fetch_or(bit, std::memory_order_release);
+    wake();
+}
+
+void PowerHintDispatcher::setMode(Mode mode, bool enabled) {
+    const uint64_t bit = bitOf(mode);
+    if (bit == 0) {
+        mHal.setMode(mode, enabled);
+        return;
+    }
+    if (enabled) {
+        mEnabledModes.fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        mEnabledModes.fetch_and(~bit, std::memory_order_relaxed);
+    }
+    mPendingModes.fetch_or(bit, std::memory_order_release);
+    wake();
+}
+
+bool PowerHintDispatcher::isSupported(Boost boost) const {
+    return (mUnsupportedBoosts.load(std::memory_order_relaxed) & bitOf(boost)) == 0;
+}
+
+bool PowerHintDispatcher::isSupported(Mode mode) const {
+    return (mUnsupportedModes.load(std::memory_order_relaxed) & bitOf(mode)) == 0;
+}
+
+void PowerHintDispatcher::setHintSession(sp<IPowerHintSession> session) {
+    std::lock_guard<std::mutex> lock(mHintSessionMutex);
+    mHintSession = std::move(session);
+    mHintSessionGeneration++;
+    mHintSessionFailed.store(false);
+}
+
+void PowerHintDispatcher::sendHint(SessionHint hint) {
+    const uint64_t bit = bitOf(hint);
+    if (bit == 0) {
+        ALOGE("Session hint %d is not supported", static_cast<int32_t>(hint));
+        return;
+    }
+    mPendingSessionHints.fetch_or(bit, std::memory_order_release);
+    wake();
+}
+
+void PowerHintDispatcher::updateTargetWorkDuration(int64_t targetDurationNanos) {
+    if (targetDurationNanos <= 0) {
+        return;
+    }
+    mPendingTargetDurationNanos.store(targetDurationNanos, std::memory_order_release);
+    wake();
+}
+
+bool PowerHintDispatcher::reportActualWorkDuration(const WorkDuration& duration) {
+    const uint64_t tail = mWorkDurationsTail.load(std::memory_order_relaxed);
+    if (tail - mWorkDurationsHead.load(std::memory_order_acquire) == WORK_DURATION_CAPACITY) {
+        return false;
+    }
+    mWorkDurations[tail % WORK_DURATION_CAPACITY] = duration;
+    mWorkDurationsTail.store(tail + 1, std::memory_order_release);
+    wake();
+    return true;
+}
+
+bool PowerHintDispatcher::takeHintSessionFailure() {
+    return mHintSessionFailed.exchange(false);
+}
+
+void PowerHintDispatcher::flush() {
+    std::unique_lock<std::mutex> lock(mFlushMutex);
+    const uint64_t request = mFlushRequested.fetch_add(1) + 1;
+    wake();
+    mFlushCondition.wait(lock, [&] { return mFlushCompleted >= request; });
+}
+
+void PowerHintDispatcher::wake() {
+    // Only the first hint after the thread started delivering the hints wakes it up, so that the
+    // other ones do not even make a system call.
+    if (!mWakeupPending.exchange(true)) {
+        sem_post(&mWakeup);
+    }
+}
+
+void PowerHintDispatcher::threadMain() {
+    pthread_setname_np(pthread_self(), "PowerHints");
+    while (true) {
+        while (sem_wait(&mWakeup) != 0 && errno == EINTR) {
+        }
+        const bool stopping = mStopping.load();
+        if (!stopping && mCoalescingWindow > 0ns) {
+            std::this_thread::sleep_for(mCoalescingWindow);
+        }
+        // Cleared before the hints are read, so that any hint recorded from now on wakes the
+        // thread up again.
+        mWakeupPending.exchange(false);
+        const uint64_t flushRequested = mFlushRequested.load();
+
+        deliverHints();
+
+        {
+            std::lock_guard<std::mutex> lock(mFlushMutex);
+            mFlushCompleted = flushRequested;
+        }
+        mFlushCondition.notify_all();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void PowerHintDispatcher::deliverHints() {
+    const uint64_t boosts = mPendingBoosts.exchange(0, std::memory_order_acquire);
+    forEachBit(boosts, [this](int index, uint64_t bit) {
+        const int32_t durationMs = mBoostDurationsMs[index].load(std::memory_order_relaxed);
+        if (mHal.setBoost(static_cast<Boost>(index), durationMs).isUnsupported()) {
+            mUnsupportedBoosts.fetch_or(bit, std::memory_order_relaxed);
+        }
+    });
+
+    const uint64_t modes = mPendingModes.exchange(0, std::memory_order_acquire);
+    const uint64_t enabledModes = mEnabledModes.load(std::memory_order_relaxed);
+    forEachBit(modes, [&](int index, uint64_t bit) {
+        const uint64_t enabled = enabledModes & bit;
+        // A mode which went back to the state last sent within the window is not sent again.
+        if ((mKnownModes & bit) != 0 && (mSentModes & bit) == enabled) {
+            return;
+        }
+        auto result = mHal.setMode(static_cast<Mode>(index), enabled != 0);
+        if (result.isUnsupported()) {
+            mUnsupportedModes.fetch_or(bit, std::memory_order_relaxed);
+        } else if (result.isOk()) {
+            mKnownModes |= bit;
+            mSentModes = (mSentModes & ~bit) | enabled;
+        }
+    });
+
+    deliverSessionHints();
+}
+
+void PowerHintDispatcher::deliverSessionHints() {
+    sp<IPowerHintSession> session;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mHintSessionMutex);
+        session = mHintSession;
+        generation = mHintSessionGeneration;
+    }
+    const uint64_t hints = mPendingSessionHints.exchange(0, std::memory_order_acquire);
+    const int64_t targetDurationNanos =
+            mPendingTargetDurationNanos.exchange(0, std::memory_order_acquire);
+    mWorkDurationBatch.clear();
+    const uint64_t tail = mWorkDurationsTail.load(std::memory_order_acquire);
+    for (uint64_t head = mWorkDurationsHead.load(std::memory_order_relaxed); head != tail;
+         head++) {
+        mWorkDurationBatch.push_back(mWorkDurations[head % WORK_DURATION_CAPACITY]);
+    }
+    mWorkDurationsHead.store(tail, std::memory_order_release);
+    if (session == nullptr) {
+        return;
+    }
+
+    binder::Status status;
+    forEachBit(hints, [&](int index, uint64_t) {
+        if (status.isOk()) {
+            status = session->sendHint(static_cast<SessionHint>(index));
+        }
+    });
+    if (status.isOk() && targetDurationNanos != 0 &&
+        (targetDurationNanos != mSentTargetDurationNanos ||
+         generation != mSentTargetSessionGeneration)) {
+        status = session->updateTargetWorkDuration(targetDurationNanos);
+        if (status.isOk()) {
+            mSentTargetDurationNanos = targetDurationNanos;
+            mSentTargetSessionGeneration = generation;
+        }
+    }
+    if (status.isOk() && !mWorkDurationBatch.empty()) {
+        status = session->reportActualWorkDuration(mWorkDurationBatch);
+    }
+    if (!status.isOk()) {
+        ALOGW("Power hint session call failed: %s", status.exceptionMessage().c_str());
+        std::lock_guard<std::mutex> lock(mHintSessionMutex);
+        if (mHintSessionGeneration == generation) {
+            mHintSession = nullptr;
+            mHintSessionFailed.store(true);
+        }
+    }
+}
+
+} // namespace power
+
+} // namespace android
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *            http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PowerHintDispatcherBenchmarks"
+
+#include <android/hardware/power/Boost.h>
+#include <android/hardware/power/Mode.h>
+#include <android/hardware/power/WorkDuration.h>
+#include <benchmark/benchmark.h>
+#include <powermanager/PowerHalController.h>
+#include <powermanager/PowerHintDispatcher.h>
+#include <unistd.h>
+
+using android::hardware::power::Boost;
+using android::hardware::power::Mode;
+using android::hardware::power::WorkDuration;
+using android::power::PowerHalController;
+using android::power::PowerHintDispatcher;
+
+using namespace android;
+
+// These benchmarks measure the latency seen by the callers of the dispatcher, which only record
+// the hints, to compare with the synchronous calls of PowerHalControllerBenchmarks. The
+// dispatcher delivers the hints to the Power HAL in the background meanwhile.
+
+static void BM_PowerHintDispatcherBenchmarks_setBoost(benchmark::State& state) {
+    PowerHalController controller;
+    controller.init();
+    PowerHintDispatcher dispatcher(controller);
+    while (state.KeepRunning()) {
+        dispatcher.setBoost(Boost::INTERACTION, 0);
+    }
+    dispatcher.flush();
+}
+
+static void BM_PowerHintDispatcherBenchmarks_setMode(benchmark::State& state) {
+    PowerHalController controller;
+    controller.init();
+    PowerHintDispatcher dispatcher(controller);
+    bool enabled = false;
+    while (state.KeepRunning()) {
+        dispatcher.setMode(Mode::EXPENSIVE_RENDERING, enabled);
+        enabled = !enabled;
+    }
+    dispatcher.flush();
+    dispatcher.setMode(Mode::EXPENSIVE_RENDERING, false);
+}
+
+// The hint session calls of each frame of SurfaceFlinger. They are recorded and then dropped if
+// the HAL does not support hint sessions.
+static void BM_PowerHintDispatcherBenchmarks_frameHints(benchmark::State& state) {
+    PowerHalController controller;
+    controller.init();
+    PowerHintDispatcher dispatcher(controller);
+    auto session = controller.createHintSession(getpid(), static_cast<int32_t>(getuid()),
+                                                {gettid()}, 16'666'666);
+    if (session.isOk()) {
+        dispatcher.setHintSession(session.value());
+    }
+    WorkDuration duration;
+    duration.durationNanos = 8'000'000;
+    int64_t frame = 0;
+    while (state.KeepRunning()) {
+        dispatcher.updateTargetWorkDuration(16'666'666);
+        duration.timeStampNanos = ++frame;
+        if (!dispatcher.reportActualWorkDuration(duration)) {
+            // Throttled like the frames are, instead of dropping the durations.
+            state.PauseTiming();
+            dispatcher.flush();
+            state.ResumeTiming();
+        }
+    }
+    dispatcher.flush();
+    if (session.isOk()) {
+        session.value()->close();
+    }
+}
+
+BENCHMARK(BM_PowerHintDispatcherBenchmarks_setBoost);
+BENCHMARK(BM_PowerHintDispatcherBenchmarks_setMode);
+BENCHMARK(BM_PowerHintDispatcherBenchmarks_frameHints);
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *            http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PowerHintDispatcherTest"
+
+#include <android/hardware/power/Boost.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/Mode.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <powermanager/PowerHintDispatcher.h>
+#include <utils/Log.h>
+
+#include <thread>
+
+using android::binder::Status;
+using android::hardware::power::Boost;
+using android::hardware::power::IPowerHintSession;
+using android::hardware::power::Mode;
+using android::hardware::power::SessionHint;
+using android::hardware::power::WorkDuration;
+
+using namespace android;
+using namespace android::power;
+using namespace std::chrono_literals;
+using namespace testing;
+
+// -------------------------------------------------------------------------------------------------
+
+class MockHalWrapper : public HalWrapper {
+public:
+    MOCK_METHOD(HalResult<void>, setBoost, (Boost boost, int32_t durationMs), (override));
+    MOCK_METHOD(HalResult<void>, setMode, (Mode mode, bool enabled), (override));
+    MOCK_METHOD(HalResult<sp<IPowerHintSession>>, createHintSession,
+                (int32_t tgid, int32_t uid, const std::vector<int32_t>& threadIds,
+                 int64_t durationNanos),
+                (override));
+    MOCK_METHOD(HalResult<int64_t>, getHintSessionPreferredRate, (), (override));
+};
+
+class MockIPowerHintSession : public IPowerHintSession {
+public:
+    MOCK_METHOD(IBinder*, onAsBinder, (), (override));
+    MOCK_METHOD(Status, pause, (), (override));
+    MOCK_METHOD(Status, resume, (), (override));
+    MOCK_METHOD(Status, close, (), (override));
+    MOCK_METHOD(int32_t, getInterfaceVersion, (), (override));
+    MOCK_METHOD(std::string, getInterfaceHash, (), (override));
+    MOCK_METHOD(Status, updateTargetWorkDuration, (int64_t targetDurationNanos), (override));
+    MOCK_METHOD(Status, reportActualWorkDuration, (const std::vector<WorkDuration>& durations),
+                (override));
+    MOCK_METHOD(Status, sendHint, (SessionHint hint), (override));
+    MOCK_METHOD(Status, setThreads, (const std::vector<int32_t>& threadIds), (override));
+};
+
+// -------------------------------------------------------------------------------------------------
+
+class PowerHintDispatcherTest : public Test {
+public:
+    void SetUp() override {
+        // Long enough for all the hints of a test to be recorded within the same window.
+        mDispatcher = std::make_unique<PowerHintDispatcher>(mMockHal, 50ms);
+        mMockSession = new StrictMock<MockIPowerHintSession>();
+    }
+
+protected:
+    StrictMock<MockHalWrapper> mMockHal;
+    sp<StrictMock<MockIPowerHintSession>> mMockSession = nullptr;
+    std::unique_ptr<PowerHintDispatcher> mDispatcher = nullptr;
+};
+
+static WorkDuration workDuration(int64_t durationNanos) {
+    WorkDuration duration;
+    duration.durationNanos = durationNanos;
+    duration.timeStampNanos = durationNanos;
+    return duration;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_F(PowerHintDispatcherTest, TestBoostsAreCoalesced) {
+    EXPECT_CALL(mMockHal, setBoost(Eq(Boost::INTERACTION), Eq(300)))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+    EXPECT_CALL(mMockHal, setBoost(Eq(Boost::DISPLAY_UPDATE_IMMINENT), Eq(0)))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+
+    mDispatcher->setBoost(Boost::INTERACTION, 100);
+    mDispatcher->setBoost(Boost::DISPLAY_UPDATE_IMMINENT, 0);
+    mDispatcher->setBoost(Boost::INTERACTION, 200);
+    mDispatcher->setBoost(Boost::INTERACTION, 300);
+    mDispatcher->flush();
+}
+
+TEST_F(PowerHintDispatcherTest, TestModeBackToTheStateSentIsNotSent) {
+    EXPECT_CALL(mMockHal, setMode(Eq(Mode::EXPENSIVE_RENDERING), Eq(true)))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+
+    mDispatcher->setMode(Mode::EXPENSIVE_RENDERING, true);
+    mDispatcher->flush();
+    mDispatcher->setMode(Mode::EXPENSIVE_RENDERING, false);
+    mDispatcher->setMode(Mode::EXPENSIVE_RENDERING, true);
+    mDispatcher->flush();
+}
+
+TEST_F(PowerHintDispatcherTest, TestFailedModeIsSentAgain) {
+    {
+        InSequence seq;
+        EXPECT_CALL(mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+                .Times(Exactly(1))
+                .WillRepeatedly(Return(HalResult<void>::failed("Test failure")));
+        EXPECT_CALL(mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+                .Times(Exactly(1))
+                .WillRepeatedly(Return(HalResult<void>::ok()));
+    }
+
+    mDispatcher->setMode(Mode::LAUNCH, true);
+    mDispatcher->flush();
+    mDispatcher->setMode(Mode::LAUNCH, true);
+    mDispatcher->flush();
+}
+
+TEST_F(PowerHintDispatcherTest, TestUnsupportedHintsAreRemembered) {
+    EXPECT_CALL(mMockHal, setBoost(Eq(Boost::CAMERA_SHOT), _))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::unsupported()));
+    EXPECT_CALL(mMockHal, setMode(Eq(Mode::LOW_POWER), _))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::unsupported()));
+
+    EXPECT_TRUE(mDispatcher->isSupported(Boost::CAMERA_SHOT));
+    EXPECT_TRUE(mDispatcher->isSupported(Mode::LOW_POWER));
+    mDispatcher->setBoost(Boost::CAMERA_SHOT, 0);
+    mDispatcher->setMode(Mode::LOW_POWER, true);
+    mDispatcher->flush();
+
+    EXPECT_FALSE(mDispatcher->isSupported(Boost::CAMERA_SHOT));
+    EXPECT_FALSE(mDispatcher->isSupported(Mode::LOW_POWER));
+    EXPECT_TRUE(mDispatcher->isSupported(Boost::INTERACTION));
+}
+
+TEST_F(PowerHintDispatcherTest, TestSessionHintsAreCoalesced) {
+    std::vector<WorkDuration> durations = {workDuration(10), workDuration(20), workDuration(30)};
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMockSession.get(), sendHint(Eq(SessionHint::CPU_LOAD_RESET)))
+                .Times(Exactly(1));
+        EXPECT_CALL(*mMockSession.get(), updateTargetWorkDuration(Eq(16'000'000)))
+                .Times(Exactly(1));
+        EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(Eq(durations)))
+                .Times(Exactly(1));
+    }
+
+    mDispatcher->setHintSession(mMockSession);
+    mDispatcher->sendHint(SessionHint::CPU_LOAD_RESET);
+    mDispatcher->sendHint(SessionHint::CPU_LOAD_RESET);
+    mDispatcher->updateTargetWorkDuration(8'000'000);
+    mDispatcher->updateTargetWorkDuration(16'000'000);
+    for (const WorkDuration& duration : durations) {
+        EXPECT_TRUE(mDispatcher->reportActualWorkDuration(duration));
+    }
+    mDispatcher->flush();
+
+    // The target work duration is only sent when it changes.
+    mDispatcher->updateTargetWorkDuration(16'000'000);
+    mDispatcher->flush();
+    EXPECT_FALSE(mDispatcher->takeHintSessionFailure());
+}
+
+TEST_F(PowerHintDispatcherTest, TestTargetWorkDurationIsSentToNewSession) {
+    sp<StrictMock<MockIPowerHintSession>> newSession = new StrictMock<MockIPowerHintSession>();
+    EXPECT_CALL(*mMockSession.get(), updateTargetWorkDuration(Eq(16'000'000))).Times(Exactly(1));
+    EXPECT_CALL(*newSession.get(), updateTargetWorkDuration(Eq(16'000'000))).Times(Exactly(1));
+
+    mDispatcher->setHintSession(mMockSession);
+    mDispatcher->updateTargetWorkDuration(16'000'000);
+    mDispatcher->flush();
+    mDispatcher->setHintSession(newSession);
+    mDispatcher->updateTargetWorkDuration(16'000'000);
+    mDispatcher->flush();
+}
+
+TEST_F(PowerHintDispatcherTest, TestSessionFailureDropsTheSession) {
+    EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(_))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(Status::fromExceptionCode(Status::EX_ILLEGAL_STATE)));
+
+    mDispatcher->setHintSession(mMockSession);
+    EXPECT_TRUE(mDispatcher->reportActualWorkDuration(workDuration(10)));
+    mDispatcher->flush();
+    EXPECT_TRUE(mDispatcher->takeHintSessionFailure());
+    EXPECT_FALSE(mDispatcher->takeHintSessionFailure());
+
+    // The durations are dropped until the session is set again.
+    EXPECT_TRUE(mDispatcher->reportActualWorkDuration(workDuration(20)));
+    mDispatcher->flush();
+}
+
+TEST_F(PowerHintDispatcherTest, TestWorkDurationsAreDroppedWhenFull) {
+    EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(SizeIs(64))).Times(Exactly(1));
+
+    mDispatcher->setHintSession(mMockSession);
+    int reported = 0;
+    for (int i = 0; i < 100; i++) {
+        reported += mDispatcher->reportActualWorkDuration(workDuration(i)) ? 1 : 0;
+    }
+    EXPECT_EQ(64, reported);
+    mDispatcher->flush();
+}
+
+TEST_F(PowerHintDispatcherTest, TestDestructorDeliversPendingHints) {
+    EXPECT_CALL(mMockHal, setBoost(Eq(Boost::INTERACTION), Eq(100)))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+
+    mDispatcher->setBoost(Boost::INTERACTION, 100);
+    mDispatcher = nullptr;
+}
+
+TEST_F(PowerHintDispatcherTest, TestHintsFromMultipleThreads) {
+    EXPECT_CALL(mMockHal, setBoost(Eq(Boost::INTERACTION), _))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+    EXPECT_CALL(mMockHal, setMode(Eq(Mode::LAUNCH), _))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 10; i++) {
+        threads.push_back(std::thread([&, i]() {
+            for (int j = 0; j < 1000; j++) {
+                mDispatcher->setBoost(Boost::INTERACTION, j);
+                mDispatcher->setMode(Mode::LAUNCH, (i + j) % 2 == 0);
+            }
+        }));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // The last state of the mode is sent.
+    mDispatcher->setMode(Mode::LAUNCH, false);
+    mDispatcher->flush();
+    EXPECT_CALL(mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+            .Times(Exactly(1))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+    mDispatcher->setMode(Mode::LAUNCH, true);
+    mDispatcher->flush();
+}
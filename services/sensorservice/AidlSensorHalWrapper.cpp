@@ -122,6 +122,7 @@ bool AidlSensorHalWrapper::connect(SensorDeviceCallback *callback) {
             mWakeLockQueue = std::make_unique<AidlMessageQueue<
                     int32_t, SynchronizedReadWrite>>(MAX_RECEIVE_BUFFER_EVENT_COUNT,
                                                      /*configureEventFlagWord=*/true);
+            mPendingWakeLockAcks = 0;
             if (mEventQueueFlag != nullptr) {
                 EventFlag::deleteEventFlag(&mEventQueueFlag);
             }
@@ -181,18 +182,20 @@ ssize_t AidlSensorHalWrapper::pollFmq(sensors_event_t *buffer, size_t maxNumEven
         }
     }
 
-    size_t eventsToRead = std::min({availableEvents, maxNumEventsToRead, mEventBuffer.size()});
+    size_t eventsToRead = std::min(availableEvents, maxNumEventsToRead);
     if (eventsToRead > 0) {
-        if (mEventQueue->read(mEventBuffer.data(), eventsToRead)) {
+        // Convert the events where they are in the FMQ, rather than copying them out of it first.
+        AidlMessageQueue<Event, SynchronizedReadWrite>::MemTransaction transaction;
+        if (mEventQueue->beginRead(eventsToRead, &transaction)) {
+            for (size_t i = 0; i < eventsToRead; i++) {
+                convertToSensorEvent(*transaction.getSlot(i), &buffer[i]);
+            }
+            mEventQueue->commitRead(eventsToRead);
             // Notify the Sensors HAL that sensor events have been read. This is required to support
             // the use of writeBlocking by the Sensors HAL.
             if (mEventQueueFlag != nullptr) {
                 mEventQueueFlag->wake(asBaseType(ISensors::EVENT_QUEUE_FLAG_BITS_EVENTS_READ));
             }
-
-            for (size_t i = 0; i < eventsToRead; i++) {
-                convertToSensorEvent(mEventBuffer[i], &buffer[i]);
-            }
             eventsRead = eventsToRead;
         } else {
             ALOGW("Failed to read %zu events, currently %zu events available", eventsToRead,
@@ -313,11 +316,15 @@ status_t AidlSensorHalWrapper::configureDirectChannel(int32_t sensorHandle, int3
 }
 
 void AidlSensorHalWrapper::writeWakeLockHandled(uint32_t count) {
-    int signedCount = (int)count;
+    // The events handled since the last successful write are acknowledged together, so that the
+    // HAL does not hold its wake lock forever for the acknowledgements which could not be written.
+    mPendingWakeLockAcks += count;
+    int signedCount = (int)mPendingWakeLockAcks;
     if (mWakeLockQueue->write(&signedCount)) {
+        mPendingWakeLockAcks = 0;
         mWakeLockQueueFlag->wake(asBaseType(ISensors::WAKE_LOCK_QUEUE_FLAG_BITS_DATA_WRITTEN));
     } else {
-        ALOGW("Failed to write wake lock handled");
+        ALOGW("Failed to write wake lock handled, %u events pending", mPendingWakeLockAcks);
     }
 }
 
@@ -85,9 +85,8 @@ private:
     ::android::hardware::EventFlag *mEventQueueFlag;
     ::android::hardware::EventFlag *mWakeLockQueueFlag;
     SensorDeviceCallback *mSensorDeviceCallback;
-    std::array<::aidl::android::hardware::sensors::Event,
-               ::android::SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT>
-            mEventBuffer;
+    // The number of handled wake up events which were not acknowledged to the HAL yet.
+    uint32_t mPendingWakeLockAcks = 0;
 
     ndk::ScopedAIBinder_DeathRecipient mDeathRecipient;
 };
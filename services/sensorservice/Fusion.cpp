@@ -487,7 +487,21 @@ void Fusion::predict(const vec3_t& w, float dT) {
     if (x0.w < 0)
         x0 = -x0;
 
-    P = Phi*P*transpose(Phi) + GQGt;
+    // P = Phi*P*transpose(Phi) + GQGt, with the blocks of Phi which are 0 and I33 left out of
+    // the products:
+    //
+    //  Phi*P = | Phi00*P00 + Phi10*P01  Phi00*P10 + Phi10*P11 |
+    //          |          P01                     P11         |
+    //
+    // This takes 8 products of 3x3 matrices instead of 16, and gives the same result.
+    const mat33_t Phi00t(transpose(Phi[0][0]));
+    const mat33_t Phi10t(transpose(Phi[1][0]));
+    const mat33_t PhiP00(Phi[0][0]*P[0][0] + Phi[1][0]*P[0][1]);
+    const mat33_t PhiP10(Phi[0][0]*P[1][0] + Phi[1][0]*P[1][1]);
+    P[0][0] = PhiP00*Phi00t + PhiP10*Phi10t + GQGt[0][0];
+    P[0][1] = P[0][1]*Phi00t + P[1][1]*Phi10t + GQGt[0][1];
+    P[1][0] = PhiP10 + GQGt[1][0];
+    P[1][1] += GQGt[1][1];
 
     checkState();
 }
@@ -32,17 +32,26 @@ namespace {
     constexpr size_t LOG_SIZE_LARGE = 50;  // larger samples for debugging
 }// unnamed namespace
 
-RecentEventLogger::RecentEventLogger(int sensorType) :
+RecentEventLogger::RecentEventLogger(int sensorType, nsecs_t minLogIntervalNs, size_t logSize) :
         mSensorType(sensorType), mEventSize(eventSizeBySensorType(mSensorType)),
-        mRecentEvents(logSizeBySensorType(sensorType)), mMaskData(false),
+        mMinLogIntervalNs(minLogIntervalNs),
+        mRecentEvents(logSize != 0 ? logSize : logSizeBySensorType(sensorType)), mMaskData(false),
         mIsLastEventCurrent(false) {
     // blank
 }
 
 void RecentEventLogger::addEvent(const sensors_event_t& event) {
-    std::lock_guard<std::mutex> lk(mLock);
-    mRecentEvents.emplace(event);
+    mLastEvent = event;
     mIsLastEventCurrent = true;
+    if (mMinLogIntervalNs > 0 && mRecentEvents.size() != 0) {
+        // The events which go back in time, after a reset of the sensor, are still recorded.
+        const int64_t lastTimestamp = mRecentEvents[0].mEvent.timestamp;
+        if (event.timestamp >= lastTimestamp &&
+            event.timestamp - lastTimestamp < mMinLogIntervalNs) {
+            return;
+        }
+    }
+    mRecentEvents.emplace(event);
 }
 
 bool RecentEventLogger::isEmpty() const {
@@ -50,17 +59,18 @@ bool RecentEventLogger::isEmpty() const {
 }
 
 void RecentEventLogger::setLastEventStale() {
-    std::lock_guard<std::mutex> lk(mLock);
     mIsLastEventCurrent = false;
 }
 
 std::string RecentEventLogger::dump() const {
-    std::lock_guard<std::mutex> lk(mLock);
-
     //TODO: replace String8 with std::string completely in this function
     String8 buffer;
 
-    buffer.appendFormat("last %zu events\n", mRecentEvents.size());
+    buffer.appendFormat("last %zu events", mRecentEvents.size());
+    if (mMinLogIntervalNs > 0) {
+        buffer.appendFormat(", at most one every %" PRId64 "ms", ns2ms(mMinLogIntervalNs));
+    }
+    buffer.append("\n");
     int j = 0;
     for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
         const auto& ev = mRecentEvents[i];
@@ -95,7 +105,6 @@ std::string RecentEventLogger::dump() const {
  */
 void RecentEventLogger::dump(util::ProtoOutputStream* proto) const {
     using namespace service::SensorEventsProto;
-    std::lock_guard<std::mutex> lk(mLock);
 
     proto->write(RecentEventsLog::RECENT_EVENTS_COUNT, int(mRecentEvents.size()));
     for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
@@ -129,11 +138,8 @@ void RecentEventLogger::setFormat(std::string format) {
 }
 
 bool RecentEventLogger::populateLastEventIfCurrent(sensors_event_t *event) const {
-    std::lock_guard<std::mutex> lk(mLock);
-
     if (mIsLastEventCurrent && mRecentEvents.size()) {
-        // Index 0 contains the latest event emplace()'ed
-        *event = mRecentEvents[0].mEvent;
+        *event = mLastEvent;
         return true;
     } else {
         return false;
@@ -22,8 +22,7 @@
 
 #include <hardware/sensors.h>
 #include <utils/String8.h>
-
-#include <mutex>
+#include <utils/Timers.h>
 
 namespace android {
 namespace SensorServiceUtil {
@@ -33,9 +32,17 @@ namespace SensorServiceUtil {
 // generated from the sensor are stored in this buffer.  The buffer is NOT cleared when the sensor
 // unregisters and as a result very old data in the dumpsys output can be seen, which is an intended
 // behavior.
+//
+// The events of the fast sensors can be decimated, so that the sensor thread does not spend time
+// recording every event of every sensor for the dumps only: with a minimum log interval, an event
+// is only recorded if its timestamp is at least that interval after the last recorded event. The
+// last event is always kept, for populateLastEventIfCurrent().
+//
+// The logger is not thread safe, SensorService only accesses it with its lock held.
 class RecentEventLogger : public Dumpable {
 public:
-    explicit RecentEventLogger(int sensorType);
+    // A log size of 0 uses the size of the sensor type.
+    explicit RecentEventLogger(int sensorType, nsecs_t minLogIntervalNs = 0, size_t logSize = 0);
     void addEvent(const sensors_event_t& event);
 
     // Populate event with the last recorded sensor event if it is not stale. An event is
@@ -60,9 +67,11 @@ protected:
 
     const int mSensorType;
     const size_t mEventSize;
+    const nsecs_t mMinLogIntervalNs;
 
-    mutable std::mutex mLock;
     RingBuffer<SensorEventLog> mRecentEvents;
+    // The last event added, which may not have been recorded in mRecentEvents.
+    sensors_event_t mLastEvent;
 
     bool mMaskData;
     bool mIsLastEventCurrent;
@@ -128,7 +128,7 @@ void SensorDevice::initializeSensorList() {
         // Only disable all sensors on HAL 1.0 since HAL 2.0
         // handles this in its initialize method
         if (!mHalWrapper->supportsMessageQueues()) {
-            mHalWrapper->activate(list[i].handle, 0 /* enabled */);
+            doActivateHardwareLocked(list[i].handle, false /* enabled */);
         }
     }
 }
@@ -270,6 +270,10 @@ std::string SensorDevice::dump() const {
                         mSensorList.size(), mActivationCount.size(), mDisabledClients.size());
 
     Mutex::Autolock _l(mLock);
+    result.appendFormat("HAL calls: %" PRIu32 " batch, %" PRIu32 " activate; %" PRIu32
+                        " batch calls skipped, %" PRIu32 " deferred\n",
+                        mHalBatchCount, mHalActivateCount, mSkippedBatchCount,
+                        mDeferredBatchCount);
     for (const auto& s : mSensorList) {
         int32_t handle = s.handle;
         const Info& info = mActivationCount.valueFor(handle);
@@ -389,6 +393,16 @@ ssize_t SensorDevice::poll(sensors_event_t* buffer, size_t count) {
         }
     }
 
+    // The deferred batch parameters are sent once the HAL returns events, which an active sensor
+    // does at least as often as the clients of the sensor still need.
+    if (mNextRelaxedBatchParamsDeadline.load(std::memory_order_relaxed) != INT64_MAX) {
+        const nsecs_t now = systemTime(SYSTEM_TIME_BOOTTIME);
+        if (now >= mNextRelaxedBatchParamsDeadline.load(std::memory_order_relaxed)) {
+            Mutex::Autolock _l(mLock);
+            applyRelaxedBatchParamsLocked(now);
+        }
+    }
+
     return eventsRead;
 }
 
@@ -431,6 +445,8 @@ void SensorDevice::autoDisable(void* ident, int handle) {
     info.removeBatchParamsForIdent(ident);
     if (info.numActiveClients() == 0) {
         info.isActive = false;
+        info.appliedBatchParams.reset();
+        info.relaxedBatchParamsDeadline.reset();
     }
 }
 
@@ -492,10 +508,7 @@ status_t SensorDevice::activateLocked(void* ident, int handle, int enabled) {
                 // Call batch for this sensor with the previously calculated best effort
                 // batch_rate and timeout. One of the apps has unregistered for sensor
                 // events, and the best effort batch parameters might have changed.
-                ALOGD_IF(DEBUG_CONNECTIONS, "\t>>> actuating h/w batch 0x%08x %" PRId64 " %" PRId64,
-                         handle, info.bestBatchParams.mTSample, info.bestBatchParams.mTBatch);
-                mHalWrapper->batch(handle, info.bestBatchParams.mTSample,
-                                   info.bestBatchParams.mTBatch);
+                applyBatchParamsLocked(handle, info);
             }
         } else {
             // sensor wasn't enabled for this ident
@@ -526,9 +539,19 @@ status_t SensorDevice::activateLocked(void* ident, int handle, int enabled) {
 status_t SensorDevice::doActivateHardwareLocked(int handle, bool enabled) {
     ALOGD_IF(DEBUG_CONNECTIONS, "\t>>> actuating h/w activate handle=%d enabled=%d", handle,
              enabled);
+    mHalActivateCount++;
     status_t err = mHalWrapper->activate(handle, enabled);
     ALOGE_IF(err, "Error %s sensor %d (%s)", enabled ? "activating" : "disabling", handle,
              strerror(-err));
+    if (!enabled) {
+        // The batch parameters are sent again when the sensor is activated again.
+        ssize_t activationIndex = mActivationCount.indexOfKey(handle);
+        if (activationIndex >= 0) {
+            Info& info = mActivationCount.editValueAt(activationIndex);
+            info.appliedBatchParams.reset();
+            info.relaxedBatchParamsDeadline.reset();
+        }
+    }
     return err;
 }
 
@@ -590,15 +613,72 @@ status_t SensorDevice::updateBatchParamsLocked(int handle, Info& info) {
              prevBestBatchParams.mTSample, info.bestBatchParams.mTSample,
              prevBestBatchParams.mTBatch, info.bestBatchParams.mTBatch);
 
-    status_t err(NO_ERROR);
-    // If the min period or min timeout has changed since the last batch call, call batch.
-    if (prevBestBatchParams != info.bestBatchParams && info.numActiveClients() > 0) {
-        ALOGD_IF(DEBUG_CONNECTIONS, "\t>>> actuating h/w BATCH 0x%08x %" PRId64 " %" PRId64, handle,
-                 info.bestBatchParams.mTSample, info.bestBatchParams.mTBatch);
-        err = mHalWrapper->batch(handle, info.bestBatchParams.mTSample,
-                                 info.bestBatchParams.mTBatch);
+    return applyBatchParamsLocked(handle, info);
+}
+
+status_t SensorDevice::applyBatchParamsLocked(int handle, Info& info) {
+    if (info.numActiveClients() == 0) {
+        return NO_ERROR;
+    }
+    const BatchParams& best = info.bestBatchParams;
+    if (info.appliedBatchParams.has_value()) {
+        const BatchParams& applied = *info.appliedBatchParams;
+        if (!(best != applied)) {
+            // Either nothing changed, or the clients came back before the deferred parameters
+            // were sent.
+            mSkippedBatchCount++;
+            info.relaxedBatchParamsDeadline.reset();
+            return NO_ERROR;
+        }
+        // A sensor which runs faster and with a shorter latency than its clients need still
+        // delivers every event they need on time, so the HAL is only reconfigured later, by
+        // which time the clients may need the current parameters again.
+        if (info.isActive && best.mTSample >= applied.mTSample && best.mTBatch >= applied.mTBatch) {
+            mDeferredBatchCount++;
+            if (!info.relaxedBatchParamsDeadline.has_value()) {
+                const nsecs_t deadline =
+                        systemTime(SYSTEM_TIME_BOOTTIME) + RELAXED_BATCH_PARAMS_DELAY;
+                info.relaxedBatchParamsDeadline = deadline;
+                if (deadline < mNextRelaxedBatchParamsDeadline.load(std::memory_order_relaxed)) {
+                    mNextRelaxedBatchParamsDeadline.store(deadline, std::memory_order_relaxed);
+                }
+            }
+            return NO_ERROR;
+        }
     }
+    return doBatchHardwareLocked(handle, info);
+}
 
+void SensorDevice::applyRelaxedBatchParamsLocked(nsecs_t now) {
+    nsecs_t nextDeadline = INT64_MAX;
+    for (size_t i = 0; i < mActivationCount.size(); ++i) {
+        Info& info = mActivationCount.editValueAt(i);
+        if (!info.relaxedBatchParamsDeadline.has_value()) {
+            continue;
+        }
+        if (*info.relaxedBatchParamsDeadline > now) {
+            nextDeadline = std::min(nextDeadline, *info.relaxedBatchParamsDeadline);
+            continue;
+        }
+        const int handle = mActivationCount.keyAt(i);
+        status_t err = doBatchHardwareLocked(handle, info);
+        ALOGE_IF(err, "Error calling batch on sensor %d (%s)", handle, strerror(-err));
+    }
+    mNextRelaxedBatchParamsDeadline.store(nextDeadline, std::memory_order_relaxed);
+}
+
+status_t SensorDevice::doBatchHardwareLocked(int handle, Info& info) {
+    const BatchParams& best = info.bestBatchParams;
+    ALOGD_IF(DEBUG_CONNECTIONS, "\t>>> actuating h/w BATCH 0x%08x %" PRId64 " %" PRId64, handle,
+             best.mTSample, best.mTBatch);
+    mHalBatchCount++;
+    info.relaxedBatchParamsDeadline.reset();
+    status_t err = mHalWrapper->batch(handle, best.mTSample, best.mTBatch);
+    if (err == NO_ERROR) {
+        info.appliedBatchParams = best;
+    } else {
+        info.appliedBatchParams.reset();
+    }
     return err;
 }
 
@@ -713,13 +793,11 @@ void SensorDevice::enableAllSensors() {
         const int sensor_handle = mActivationCount.keyAt(i);
         ALOGD_IF(DEBUG_CONNECTIONS, "\t>> reenable actuating h/w sensor enable handle=%d ",
                  sensor_handle);
-        status_t err = mHalWrapper->batch(sensor_handle, info.bestBatchParams.mTSample,
-                                          info.bestBatchParams.mTBatch);
+        status_t err = doBatchHardwareLocked(sensor_handle, info);
         ALOGE_IF(err, "Error calling batch on sensor %d (%s)", sensor_handle, strerror(-err));
 
         if (err == NO_ERROR) {
-            err = mHalWrapper->activate(sensor_handle, 1 /* enabled */);
-            ALOGE_IF(err, "Error activating sensor %d (%s)", sensor_handle, strerror(-err));
+            err = doActivateHardwareLocked(sensor_handle, true /* enabled */);
         }
 
         if (err == NO_ERROR) {
@@ -738,7 +816,7 @@ void SensorDevice::disableAllSensors() {
             const int sensor_handle = mActivationCount.keyAt(i);
             ALOGD_IF(DEBUG_CONNECTIONS, "\t>> actuating h/w sensor disable handle=%d ",
                      sensor_handle);
-            mHalWrapper->activate(sensor_handle, 0 /* enabled */);
+            doActivateHardwareLocked(sensor_handle, false /* enabled */);
 
             // Add all the connections that were registered for this sensor to the disabled
             // clients list.
@@ -35,6 +35,8 @@
 #include <utils/Timers.h>
 
 #include <algorithm> //std::max std::min
+#include <atomic>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -122,6 +124,9 @@ private:
     static constexpr std::chrono::seconds MAX_DYN_SENSOR_WAIT{5};
 
     static const nsecs_t MINIMUM_EVENTS_PERIOD = 1000000; // 1000 Hz
+    // How long the HAL keeps running an active sensor with more demanding batch parameters than
+    // its clients need, so that clients which come back right away do not cost two batch calls.
+    static const nsecs_t RELAXED_BATCH_PARAMS_DELAY = 200000000; // 200ms
     mutable Mutex mLock;                                  // protect mActivationCount[].batchParams
     // fixed-size array after construction
 
@@ -131,7 +136,7 @@ private:
         nsecs_t mTSample, mTBatch;
         BatchParams() : mTSample(INT64_MAX), mTBatch(INT64_MAX) {}
         BatchParams(nsecs_t tSample, nsecs_t tBatch) : mTSample(tSample), mTBatch(tBatch) {}
-        bool operator!=(const BatchParams& other) {
+        bool operator!=(const BatchParams& other) const {
             return !(mTSample == other.mTSample && mTBatch == other.mTBatch);
         }
         // Merge another parameter with this one. The updated mTSample will be the min of the two.
@@ -158,6 +163,13 @@ private:
         // Flag to track if the sensor is active
         bool isActive = false;
 
+        // The batch parameters last sent to the HAL, if the HAL is known to have them. The HAL is
+        // only called when bestBatchParams differ from these.
+        std::optional<BatchParams> appliedBatchParams;
+        // Set when bestBatchParams are less demanding than the applied ones, to the time at which
+        // they are sent to the HAL.
+        std::optional<nsecs_t> relaxedBatchParamsDeadline;
+
         // Sets batch parameters for this ident. Returns error if this ident is not already present
         // in the KeyedVector above.
         status_t setBatchParamsForIdent(void* ident, int flags, int64_t samplingPeriodNs,
@@ -181,6 +193,17 @@ private:
 
     int mTotalHidlTransportErrors;
 
+    // The numbers of reconfigurations of the sensors by the HAL, and of the batch calls which were
+    // skipped because the HAL already had the parameters, or deferred because the parameters were
+    // less demanding. Protected by mLock.
+    uint32_t mHalBatchCount = 0;
+    uint32_t mHalActivateCount = 0;
+    uint32_t mSkippedBatchCount = 0;
+    uint32_t mDeferredBatchCount = 0;
+    // The earliest relaxedBatchParamsDeadline of the sensors, so that poll only takes mLock when
+    // there are deferred batch parameters to send.
+    std::atomic<nsecs_t> mNextRelaxedBatchParamsDeadline{INT64_MAX};
+
     /**
      * Enums describing the reason why a client was disabled.
      */
@@ -214,6 +237,13 @@ private:
                          int64_t maxBatchReportLatencyNs);
 
     status_t updateBatchParamsLocked(int handle, Info& info);
+    // Sends bestBatchParams of the sensor to the HAL, unless the HAL already has them, or they
+    // are less demanding than the parameters of the HAL and the sensor is active, in which case
+    // they are sent once RELAXED_BATCH_PARAMS_DELAY has elapsed.
+    status_t applyBatchParamsLocked(int handle, Info& info);
+    // Sends the deferred batch parameters whose deadline has passed.
+    void applyRelaxedBatchParamsLocked(nsecs_t now);
+    status_t doBatchHardwareLocked(int handle, Info& info);
     status_t doActivateHardwareLocked(int handle, bool enable);
 
     bool isClientDisabled(void* ident) const;
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <inttypes.h>
 #include <log/log.h>
 #include <sys/socket.h>
 #include <utils/threads.h>
@@ -30,6 +31,9 @@
 #define UNUSED(x) (void)(x)
 
 namespace android {
+
+using SensorServiceUtil::SensorLatencyStage;
+
 namespace {
 
 // Used as the default value for the target SDK until it's obtained via getTargetSdkVersion.
@@ -77,6 +81,7 @@ bool SensorService::SensorEventConnection::needsWakeLock() {
 void SensorService::SensorEventConnection::resetWakeLockRefCount() {
     Mutex::Autolock _l(mConnectionLock);
     mWakeLockRefCount = 0;
+    mFirstUnackedWakeUpTime = 0;
 }
 
 void SensorService::SensorEventConnection::dump(String8& result) {
@@ -113,6 +118,20 @@ void SensorService::SensorEventConnection::dump(String8& result) {
 #endif
 }
 
+void SensorService::SensorEventConnection::dumpLatency(String8& result) {
+    Mutex::Autolock _l(mConnectionLock);
+    result.appendFormat("%s | uid %d | events cached %" PRIu64 " | dropped %" PRIu64
+                        " | flush complete events resent %" PRIu64 "\n",
+                        mPackageName.string(), mUid, mTotalEventsCached, mTotalEventsDropped,
+                        mTotalFlushEventsResent);
+    result.append(mLatencyHistograms
+                          .dump("  ",
+                                [this](int32_t handle) {
+                                    return std::string(mService->getSensorName(handle).string());
+                                })
+                          .c_str());
+}
+
 /**
  * Dump debugging information as android.service.SensorEventConnectionProto protobuf message using
  * ProtoOutputStream.
@@ -173,10 +192,10 @@ bool SensorService::SensorEventConnection::addSensor(int32_t handle) {
 
 bool SensorService::SensorEventConnection::removeSensor(int32_t handle) {
     Mutex::Autolock _l(mConnectionLock);
-    if (mSensorInfo.erase(handle) >= 0) {
-        return true;
+    if (mSensorInfo.erase(handle) > 0) {
+        mService->invalidateEventRoutes();
     }
-    return false;
+    return true;
 }
 
 std::vector<int32_t> SensorService::SensorEventConnection::getActiveSensorHandles() const {
@@ -287,6 +306,46 @@ bool SensorService::SensorEventConnection::incrementPendingFlushCountIfHasAccess
     }
 }
 
+bool SensorService::SensorEventConnection::filterEventLocked(
+        sensors_event_t const& event,
+        wp<const SensorEventConnection> const& flushEventConnection) {
+    int32_t sensor_handle = event.sensor;
+    if (event.type == SENSOR_TYPE_META_DATA) {
+        ALOGD_IF(DEBUG_CONNECTIONS, "flush complete event sensor==%d ", event.meta_data.sensor);
+        // Setting sensor_handle to the correct sensor to ensure the sensor events per
+        // connection are filtered correctly.  event.sensor is zero for meta_data events.
+        sensor_handle = event.meta_data.sensor;
+    }
+
+    // Check if this connection has registered for this sensor.
+    auto it = mSensorInfo.find(sensor_handle);
+    if (it == mSensorInfo.end()) {
+        return false;
+    }
+
+    FlushInfo& flushInfo = it->second;
+    // Check if there is a pending flush_complete event for this sensor on this connection.
+    if (event.type == SENSOR_TYPE_META_DATA && flushInfo.mFirstFlushPending == true &&
+            flushEventConnection == this) {
+        flushInfo.mFirstFlushPending = false;
+        ALOGD_IF(DEBUG_CONNECTIONS, "First flush event for sensor==%d ", event.meta_data.sensor);
+        return false;
+    }
+
+    // If there is a pending flush complete event for this sensor on this connection,
+    // ignore the event and proceed to the next.
+    if (flushInfo.mFirstFlushPending) {
+        return false;
+    }
+
+    // Send the flush_complete_events only to the connection which is mapped to them, and the
+    // regular sensor events after checking the AppOp.
+    if (event.type == SENSOR_TYPE_META_DATA) {
+        return flushEventConnection == this;
+    }
+    return hasSensorAccess() && noteOpIfRequired(event);
+}
+
 status_t SensorService::SensorEventConnection::sendEvents(
         sensors_event_t const* buffer, size_t numEvents,
         sensors_event_t* scratch,
@@ -298,64 +357,10 @@ status_t SensorService::SensorEventConnection::sendEvents(
     int count = 0;
     Mutex::Autolock _l(mConnectionLock);
     if (scratch) {
-        size_t i=0;
-        while (i<numEvents) {
-            int32_t sensor_handle = buffer[i].sensor;
-            if (buffer[i].type == SENSOR_TYPE_META_DATA) {
-                ALOGD_IF(DEBUG_CONNECTIONS, "flush complete event sensor==%d ",
-                        buffer[i].meta_data.sensor);
-                // Setting sensor_handle to the correct sensor to ensure the sensor events per
-                // connection are filtered correctly.  buffer[i].sensor is zero for meta_data
-                // events.
-                sensor_handle = buffer[i].meta_data.sensor;
-            }
-
-            // Check if this connection has registered for this sensor. If not continue to the
-            // next sensor_event.
-            if (mSensorInfo.count(sensor_handle) == 0) {
-                ++i;
-                continue;
+        for (size_t i = 0; i < numEvents; i++) {
+            if (filterEventLocked(buffer[i], mapFlushEventsToConnections[i])) {
+                scratch[count++] = buffer[i];
             }
-
-            FlushInfo& flushInfo = mSensorInfo[sensor_handle];
-            // Check if there is a pending flush_complete event for this sensor on this connection.
-            if (buffer[i].type == SENSOR_TYPE_META_DATA && flushInfo.mFirstFlushPending == true &&
-                    mapFlushEventsToConnections[i] == this) {
-                flushInfo.mFirstFlushPending = false;
-                ALOGD_IF(DEBUG_CONNECTIONS, "First flush event for sensor==%d ",
-                        buffer[i].meta_data.sensor);
-                ++i;
-                continue;
-            }
-
-            // If there is a pending flush complete event for this sensor on this connection,
-            // ignore the event and proceed to the next.
-            if (flushInfo.mFirstFlushPending) {
-                ++i;
-                continue;
-            }
-
-            do {
-                // Keep copying events into the scratch buffer as long as they are regular
-                // sensor_events are from the same sensor_handle OR they are flush_complete_events
-                // from the same sensor_handle AND the current connection is mapped to the
-                // corresponding flush_complete_event.
-                if (buffer[i].type == SENSOR_TYPE_META_DATA) {
-                    if (mapFlushEventsToConnections[i] == this) {
-                        scratch[count++] = buffer[i];
-                    }
-                } else {
-                    // Regular sensor event, just copy it to the scratch buffer after checking
-                    // the AppOp.
-                    if (hasSensorAccess() && noteOpIfRequired(buffer[i])) {
-                        scratch[count++] = buffer[i];
-                    }
-                }
-                i++;
-            } while ((i<numEvents) && ((buffer[i].sensor == sensor_handle &&
-                                        buffer[i].type != SENSOR_TYPE_META_DATA) ||
-                                       (buffer[i].type == SENSOR_TYPE_META_DATA  &&
-                                        buffer[i].meta_data.sensor == sensor_handle)));
         }
     } else {
         if (hasSensorAccess()) {
@@ -371,7 +376,25 @@ status_t SensorService::SensorEventConnection::sendEvents(
             }
         }
     }
+    return sendFilteredEventsLocked(scratch, count);
+}
 
+status_t SensorService::SensorEventConnection::sendRoutedEvents(
+        sensors_event_t const* buffer, const std::vector<uint32_t>& eventIndices,
+        sensors_event_t* scratch,
+        wp<const SensorEventConnection> const * mapFlushEventsToConnections) {
+    int count = 0;
+    Mutex::Autolock _l(mConnectionLock);
+    for (uint32_t i : eventIndices) {
+        if (filterEventLocked(buffer[i], mapFlushEventsToConnections[i])) {
+            scratch[count++] = buffer[i];
+        }
+    }
+    return sendFilteredEventsLocked(scratch, count);
+}
+
+status_t SensorService::SensorEventConnection::sendFilteredEventsLocked(sensors_event_t* scratch,
+                                                                        int count) {
     sendPendingFlushEventsLocked();
     // Early return if there are no events for this connection.
     if (count == 0) {
@@ -436,10 +459,26 @@ status_t SensorService::SensorEventConnection::sendEvents(
         mEventsSent += count;
     }
 #endif
+    recordWrittenEventsLocked(scratch, count, index_wake_up_event);
 
     return size < 0 ? status_t(size) : status_t(NO_ERROR);
 }
 
+void SensorService::SensorEventConnection::recordWrittenEventsLocked(
+        sensors_event_t const* events, int count, int wakeUpEventIndex) {
+    const nsecs_t now = systemTime(SYSTEM_TIME_BOOTTIME);
+    for (int i = 0; i < count; i++) {
+        if (events[i].type != SENSOR_TYPE_META_DATA) {
+            mLatencyHistograms.add(events[i].sensor, SensorLatencyStage::EVENT_TO_WRITTEN,
+                                   now - events[i].timestamp);
+        }
+    }
+    if (wakeUpEventIndex >= 0 && mFirstUnackedWakeUpTime == 0) {
+        mFirstUnackedWakeUpTime = now;
+        mFirstUnackedWakeUpHandle = events[wakeUpEventIndex].sensor;
+    }
+}
+
 bool SensorService::SensorEventConnection::hasSensorAccess() {
     return mService->isUidActive(mUid)
         && !mService->mSensorPrivacyPolicy->isSensorPrivacyEnabled();
@@ -499,7 +538,9 @@ void SensorService::SensorEventConnection::appendEventsToCacheLocked(sensors_eve
                                                                      int count) {
     if (count <= 0) {
         return;
-    } else if (mCacheSize + count <= mMaxCacheSize) {
+    }
+    mTotalEventsCached += count;
+    if (mCacheSize + count <= mMaxCacheSize) {
         // The events fit within the current cache: add them
         memcpy(&mEventCache[mCacheSize], events, count * sizeof(sensors_event_t));
         mCacheSize += count;
@@ -530,6 +571,7 @@ void SensorService::SensorEventConnection::appendEventsToCacheLocked(sensors_eve
             // Record the number dropped
             mEventsDropped += cachedEventsToDrop + newEventsToDrop;
         }
+        mTotalEventsDropped += cachedEventsToDrop + newEventsToDrop;
 
         // Check for any flush complete events in the events that will be dropped
         countFlushCompleteEventsLocked(mEventCache, cachedEventsToDrop);
@@ -628,6 +670,8 @@ void SensorService::SensorEventConnection::writeToSocketFromCache() {
             mCacheSize -= numEventsSent;
             return;
         }
+        recordWrittenEventsLocked(mEventCache + numEventsSent, numEventsToWrite,
+                                  index_wake_up_event);
         numEventsSent += numEventsToWrite;
 #if DEBUG_CONNECTIONS
         mEventsSentFromCache += numEventsToWrite;
@@ -656,6 +700,7 @@ void SensorService::SensorEventConnection::countFlushCompleteEventsLocked(
 
             FlushInfo& flushInfo = mSensorInfo[scratch[j].meta_data.sensor];
             flushInfo.mPendingFlushEventsToSend++;
+            mTotalFlushEventsResent++;
             ALOGD_IF(DEBUG_CONNECTIONS, "increment pendingFlushCount %d",
                      flushInfo.mPendingFlushEventsToSend);
         }
@@ -828,6 +873,7 @@ int SensorService::SensorEventConnection::handleEvent(int fd, int events, void*
             Mutex::Autolock _l(mConnectionLock);
             mDead = true;
             mWakeLockRefCount = 0;
+            mFirstUnackedWakeUpTime = 0;
             updateLooperRegistrationLocked(mService->getLooper());
         }
         mService->checkWakeLockState();
@@ -885,9 +931,17 @@ int SensorService::SensorEventConnection::handleEvent(int fd, int events, void*
 #if DEBUG_CONNECTIONS
                 mTotalAcksReceived += numAcks;
 #endif
+                if (mWakeLockRefCount == 0 && mFirstUnackedWakeUpTime != 0) {
+                    mLatencyHistograms.add(mFirstUnackedWakeUpHandle,
+                                           SensorLatencyStage::WRITTEN_TO_ACKED,
+                                           systemTime(SYSTEM_TIME_BOOTTIME) -
+                                                   mFirstUnackedWakeUpTime);
+                    mFirstUnackedWakeUpTime = 0;
+                }
            } else {
                // Read error, reset wakelock refcount.
                mWakeLockRefCount = 0;
+               mFirstUnackedWakeUpTime = 0;
            }
         }
         // Check if wakelock can be released by sensorservice. mConnectionLock needs to be released
@@ -38,6 +38,7 @@
 #include <sensor/ISensorServer.h>
 #include <sensor/ISensorEventConnection.h>
 
+#include "SensorLatencyHistograms.h"
 #include "SensorService.h"
 
 namespace android {
@@ -56,6 +57,11 @@ public:
 
     status_t sendEvents(sensors_event_t const* buffer, size_t count, sensors_event_t* scratch,
                         wp<const SensorEventConnection> const * mapFlushEventsToConnections = nullptr);
+    // Sends the events of the buffer at the given indices, which were routed to this connection by
+    // the sensors it registered for.
+    status_t sendRoutedEvents(sensors_event_t const* buffer,
+                              const std::vector<uint32_t>& eventIndices, sensors_event_t* scratch,
+                              wp<const SensorEventConnection> const* mapFlushEventsToConnections);
     bool hasSensor(int32_t handle) const;
     bool hasAnySensor() const;
     bool hasOneShotSensors() const;
@@ -65,6 +71,9 @@ public:
     void setFirstFlushPending(int32_t handle, bool value);
     void dump(String8& result);
     void dump(util::ProtoOutputStream* proto) const;
+    // Dumps the latency histograms of the events sent to this connection, and the numbers of
+    // events which went through the cache.
+    void dumpLatency(String8& result);
     bool needsWakeLock();
     void resetWakeLockRefCount();
     String8 getPackageName() const;
@@ -85,6 +94,20 @@ private:
     virtual int32_t configureChannel(int handle, int rateLevel);
     virtual void destroy();
 
+    // Returns whether the event is for this connection, given the connection mapped to it if it is
+    // a flush complete event. Consumes the first flush complete event of the sensors which have one
+    // pending.
+    bool filterEventLocked(sensors_event_t const& event,
+                           wp<const SensorEventConnection> const& flushEventConnection);
+
+    // Sends the events filtered into the scratch buffer, after the pending flush complete events.
+    status_t sendFilteredEventsLocked(sensors_event_t* scratch, int count);
+
+    // Records the latencies of the events which were written to the socket, and the time of the
+    // write if the wake up event at the index is the first one which needs to be acked.
+    void recordWrittenEventsLocked(sensors_event_t const* events, int count,
+                                   int wakeUpEventIndex);
+
     // Count the number of flush complete events which are about to be dropped in the buffer.
     // Increment mPendingFlushEventsToSend in mSensorInfo. These flush complete events will be sent
     // separately before the next batch of events.
@@ -183,6 +206,17 @@ private:
     int mCacheSize, mMaxCacheSize;
     int64_t mTimeOfLastEventDrop;
     int mEventsDropped;
+    // The latencies of the events sent to this connection, the numbers of events written to the
+    // cache because the socket was full and dropped because the cache was full, and the number of
+    // dropped flush complete events which were sent separately. Protected by mConnectionLock.
+    SensorServiceUtil::SensorLatencyHistograms mLatencyHistograms;
+    uint64_t mTotalEventsCached = 0;
+    uint64_t mTotalEventsDropped = 0;
+    uint64_t mTotalFlushEventsResent = 0;
+    // The time of the write of the first wake up event which is not acked yet, or 0, and its
+    // sensor.
+    nsecs_t mFirstUnackedWakeUpTime = 0;
+    int32_t mFirstUnackedWakeUpHandle = 0;
     String8 mPackageName;
     const String16 mOpPackageName;
     const String16 mAttributionTag;
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorEventRouter.h"
+
+#include <algorithm>
+
+namespace android {
+namespace SensorServiceUtil {
+
+namespace {
+
+const std::vector<uint32_t> NO_GROUPS;
+
+} // namespace
+
+void SensorEventRouter::setRoutes(const std::vector<std::vector<int32_t>>& handlesByConnection) {
+    mRoutes.clear();
+    mGroupByConnection.clear();
+    std::map<std::vector<int32_t>, uint32_t> groups;
+    for (std::vector<int32_t> handles : handlesByConnection) {
+        std::sort(handles.begin(), handles.end());
+        handles.erase(std::unique(handles.begin(), handles.end()), handles.end());
+        const auto [it, inserted] =
+                groups.emplace(std::move(handles), static_cast<uint32_t>(groups.size()));
+        if (inserted) {
+            for (int32_t handle : it->first) {
+                mRoutes[handle].push_back(it->second);
+            }
+        }
+        mGroupByConnection.push_back(it->second);
+    }
+    mBatches.resize(groups.size());
+}
+
+void SensorEventRouter::route(const sensors_event_t* buffer, size_t count) {
+    for (std::vector<uint32_t>& batch : mBatches) {
+        batch.clear();
+    }
+    // The events of a sensor usually come in runs, so the route of the previous event is reused
+    // while the sensor does not change.
+    const std::vector<uint32_t>* groups = nullptr;
+    int32_t previousHandle = 0;
+    for (size_t i = 0; i < count; i++) {
+        const int32_t handle = buffer[i].type == SENSOR_TYPE_META_DATA
+                ? buffer[i].meta_data.sensor
+                : buffer[i].sensor;
+        if (groups == nullptr || handle != previousHandle) {
+            auto it = mRoutes.find(handle);
+            groups = it != mRoutes.end() ? &it->second : &NO_GROUPS;
+            previousHandle = handle;
+        }
+        for (uint32_t group : *groups) {
+            mBatches[group].push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+} // namespace SensorServiceUtil
+} // namespace android
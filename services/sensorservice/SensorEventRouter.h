@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_SERVICE_UTIL_SENSOR_EVENT_ROUTER_H
+#define ANDROID_SENSOR_SERVICE_UTIL_SENSOR_EVENT_ROUTER_H
+
+#include <hardware/sensors.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace SensorServiceUtil {
+
+// Routes the events polled from the sensors to the connections which registered for them, so that
+// a buffer of events is scattered once into a batch per connection, instead of being filtered
+// whole by every connection.
+//
+// The connections are identified by their index in the list given to setRoutes(), and the batches
+// hold the indices of the events of the buffer, in the order of the buffer.
+//
+// Many connections usually register for the same popular sensors, so the connections registered
+// for the same sensors share a single batch, which the events are scattered into once.
+class SensorEventRouter {
+public:
+    // Sets the handles of the sensors which each connection registered for.
+    void setRoutes(const std::vector<std::vector<int32_t>>& handlesByConnection);
+
+    // Scatters the events of the buffer into the batches of the connections registered for the
+    // sensor of each event. The flush complete events are routed by the sensor they flushed.
+    void route(const sensors_event_t* buffer, size_t count);
+
+    size_t getConnectionCount() const { return mGroupByConnection.size(); }
+    const std::vector<uint32_t>& getBatch(size_t connectionIndex) const {
+        return mBatches[mGroupByConnection[connectionIndex]];
+    }
+    // Returns the number of distinct sets of sensors that the connections registered for.
+    size_t getGroupCount() const { return mBatches.size(); }
+
+private:
+    // The indices of the groups registered for each sensor handle.
+    std::unordered_map<int32_t, std::vector<uint32_t>> mRoutes;
+    // The group of the connections registered for the same sensors, by connection.
+    std::vector<uint32_t> mGroupByConnection;
+    // The batch of each group.
+    std::vector<std::vector<uint32_t>> mBatches;
+};
+
+} // namespace SensorServiceUtil
+} // namespace android
+
+#endif // ANDROID_SENSOR_SERVICE_UTIL_SENSOR_EVENT_ROUTER_H
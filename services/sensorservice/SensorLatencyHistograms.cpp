@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorLatencyHistograms.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace SensorServiceUtil {
+
+namespace {
+
+// The upper bound of the first bucket. Each of the next buckets is twice as wide, and the last
+// one has no upper bound.
+constexpr nsecs_t FIRST_BUCKET_LATENCY = 250'000;
+
+nsecs_t getBucketUpperBound(size_t bucket) {
+    return FIRST_BUCKET_LATENCY << bucket;
+}
+
+} // namespace
+
+const char* toString(SensorLatencyStage stage) {
+    switch (stage) {
+        case SensorLatencyStage::EVENT_TO_POLLED:
+            return "EVENT_TO_POLLED";
+        case SensorLatencyStage::EVENT_TO_WRITTEN:
+            return "EVENT_TO_WRITTEN";
+        case SensorLatencyStage::WRITTEN_TO_ACKED:
+            return "WRITTEN_TO_ACKED";
+        case SensorLatencyStage::COUNT:
+            break;
+    }
+    return "UNKNOWN";
+}
+
+void LatencyHistogram::add(nsecs_t latency) {
+    // The HALs which do not timestamp the events in the boot time base can make them look like
+    // they come from the future.
+    latency = std::max<nsecs_t>(latency, 0);
+    size_t bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && latency > getBucketUpperBound(bucket)) {
+        bucket++;
+    }
+    mBucketCounts[bucket]++;
+    mCount++;
+    mMax = std::max(mMax, latency);
+}
+
+nsecs_t LatencyHistogram::getPercentile(float percentile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    const size_t rank = std::max<size_t>(1, std::ceil(mCount * percentile / 100));
+    size_t count = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT - 1; bucket++) {
+        count += mBucketCounts[bucket];
+        if (count >= rank) {
+            return std::min(getBucketUpperBound(bucket), mMax);
+        }
+    }
+    return mMax;
+}
+
+std::string LatencyHistogram::dump() const {
+    std::string dump = StringPrintf("count=%zu, p50<=%.1fms, p90<=%.1fms, p99<=%.1fms, "
+                                    "max=%.1fms, buckets=[",
+                                    mCount, getPercentile(50) / 1E6, getPercentile(90) / 1E6,
+                                    getPercentile(99) / 1E6, mMax / 1E6);
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        dump += (bucket == 0 ? "" : ", ") + std::to_string(mBucketCounts[bucket]);
+    }
+    return dump + "]";
+}
+
+std::string SensorLatencyHistograms::dump(
+        const char* prefix, const std::function<std::string(int32_t)>& getSensorName) const {
+    std::string dump;
+    for (const auto& [handle, histograms] : mHistograms) {
+        dump += StringPrintf("%s%s (handle=0x%08" PRIx32 "):\n", prefix,
+                             getSensorName(handle).c_str(), handle);
+        for (size_t stage = 0; stage < histograms.size(); stage++) {
+            if (histograms[stage].getCount() == 0) {
+                continue;
+            }
+            dump += StringPrintf("%s  %s: %s\n", prefix,
+                                 toString(static_cast<SensorLatencyStage>(stage)),
+                                 histograms[stage].dump().c_str());
+        }
+    }
+    return dump;
+}
+
+} // namespace SensorServiceUtil
+} // namespace android
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_SERVICE_UTIL_SENSOR_LATENCY_HISTOGRAMS_H
+#define ANDROID_SENSOR_SERVICE_UTIL_SENSOR_LATENCY_HISTOGRAMS_H
+
+#include <utils/Timers.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace android {
+namespace SensorServiceUtil {
+
+// The stages of the delivery of a sensor event, measured from the timestamp of the event, which
+// is in the boot time base.
+enum class SensorLatencyStage : size_t {
+    EVENT_TO_POLLED,  // timestamp -> return of the poll of the HAL, in the sensor hub and the HAL
+    EVENT_TO_WRITTEN, // timestamp -> write to the socket of the connection, including the cache
+    WRITTEN_TO_ACKED, // write of a wake up event -> ack of all the wake up events by the client
+    COUNT,
+};
+
+const char* toString(SensorLatencyStage stage);
+
+// A histogram of latencies, with exponential buckets from 250us to 4s.
+class LatencyHistogram {
+public:
+    void add(nsecs_t latency);
+    size_t getCount() const { return mCount; }
+    // Returns an upper bound of the given percentile of the latencies, or 0 if there are none.
+    nsecs_t getPercentile(float percentile) const;
+    std::string dump() const;
+
+private:
+    static constexpr size_t BUCKET_COUNT = 16;
+    std::array<size_t, BUCKET_COUNT> mBucketCounts{};
+    size_t mCount = 0;
+    nsecs_t mMax = 0;
+};
+
+// Histograms of the latency of each stage of the delivery of the events, for each sensor. This
+// class is not thread safe, its users hold the lock of their state when they use it.
+class SensorLatencyHistograms {
+public:
+    void add(int32_t handle, SensorLatencyStage stage, nsecs_t latency) {
+        mHistograms[handle][static_cast<size_t>(stage)].add(latency);
+    }
+
+    // Dumps the histograms of the stages which have latencies, each line starting with the
+    // prefix.
+    std::string dump(const char* prefix,
+                     const std::function<std::string(int32_t)>& getSensorName) const;
+
+private:
+    using StageHistograms =
+            std::array<LatencyHistogram, static_cast<size_t>(SensorLatencyStage::COUNT)>;
+    std::map<int32_t, StageHistograms> mHistograms;
+};
+
+} // namespace SensorServiceUtil
+} // namespace android
+
+#endif // ANDROID_SENSOR_SERVICE_UTIL_SENSOR_LATENCY_HISTOGRAMS_H
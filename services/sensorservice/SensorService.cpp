@@ -13,6 +13,8 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#define ATRACE_TAG ATRACE_TAG_SYSTEM_SERVER
+
 #include <aidl/android/hardware/sensors/ISensors.h>
 #include <android-base/strings.h>
 #include <android/content/pm/IPackageManagerNative.h>
@@ -35,6 +37,7 @@
 #include <sensor/SensorEventQueue.h>
 #include <sensorprivacy/SensorPrivacyManager.h>
 #include <utils/SystemClock.h>
+#include <utils/Trace.h>
 
 #include "BatteryService.h"
 #include "CorrectedGyroSensor.h"
@@ -90,7 +93,9 @@ std::map<String16, int> SensorService::sPackageTargetVersion;
 Mutex SensorService::sPackageTargetVersionLock;
 String16 SensorService::sSensorInterfaceDescriptorPrefix =
         String16("android.frameworks.sensorservice@");
-AppOpsManager SensorService::sAppOpsManager;
+// checkOp() runs on each sensor access check, and system_server has binder threads for the
+// mode change callbacks.
+AppOpsManager SensorService::sAppOpsManager(/*cacheModes=*/true);
 std::atomic_uint64_t SensorService::curProxCallbackSeq(0);
 std::atomic_uint64_t SensorService::completedCallbackSeq(0);
 
@@ -116,6 +121,23 @@ int32_t nextRuntimeSensorHandle() {
     return nextHandle++;
 }
 
+// The events of the continuous sensors which are recorded for the dumps are decimated to at most
+// one every RECENT_EVENTS_LOG_INTERVAL_MS, unless the debug.sensors.recent_events_interval_ms
+// property overrides it. The debug.sensors.recent_events_depth property overrides the number of
+// events recorded for each sensor.
+constexpr int32_t RECENT_EVENTS_LOG_INTERVAL_MS = 10;
+
+SensorServiceUtil::RecentEventLogger* createRecentEventLogger(const Sensor& sensor) {
+    nsecs_t minLogIntervalNs = 0;
+    if (sensor.getReportingMode() == AREPORTING_MODE_CONTINUOUS) {
+        minLogIntervalNs = ms2ns(property_get_int32("debug.sensors.recent_events_interval_ms",
+                                                    RECENT_EVENTS_LOG_INTERVAL_MS));
+    }
+    const int32_t logSize = property_get_int32("debug.sensors.recent_events_depth", 0);
+    return new SensorServiceUtil::RecentEventLogger(sensor.getType(), minLogIntervalNs,
+                                                    logSize > 0 ? logSize : 0);
+}
+
 class RuntimeSensorCallbackProxy : public RuntimeSensor::SensorCallback {
  public:
     RuntimeSensorCallbackProxy(sp<SensorService::RuntimeSensorCallback> callback)
@@ -519,11 +541,12 @@ bool SensorService::hasSensorAccessLocked(uid_t uid, const String16& opPackageNa
 bool SensorService::registerSensor(std::shared_ptr<SensorInterface> s, bool isDebug, bool isVirtual,
                                    int deviceId) {
     const int handle = s->getSensor().getHandle();
-    const int type = s->getSensor().getType();
+    SensorServiceUtil::RecentEventLogger* logger = createRecentEventLogger(s->getSensor());
     if (mSensors.add(handle, std::move(s), isDebug, isVirtual, deviceId)) {
-        mRecentEvent.emplace(handle, new SensorServiceUtil::RecentEventLogger(type));
+        mRecentEvent.emplace(handle, logger);
         return true;
     } else {
+        delete logger;
         LOG_FATAL("Failed to register sensor with handle %d", handle);
         return false;
     }
@@ -585,6 +608,8 @@ status_t SensorService::dump(int fd, const Vector<String16>& args) {
         // argument parsing.
         if (args.size() == 1 && args[0] == String16("--proto")) {
             return dumpProtoLocked(fd, &connLock);
+        } else if (args.size() == 1 && args[0] == String16("--latency")) {
+            dumpLatencyLocked(result, &connLock);
         } else if (!mSensors.hasAnySensor()) {
             result.append("No Sensors on the device\n");
             result.appendFormat("devInitCheck : %d\n", SensorDevice::getInstance().initCheck());
@@ -695,6 +720,20 @@ status_t SensorService::dump(int fd, const Vector<String16>& args) {
     return NO_ERROR;
 }
 
+void SensorService::dumpLatencyLocked(String8& result, ConnectionSafeAutolock* connLock) const {
+    const auto getSensorName = [this](int32_t handle) {
+        return std::string(getSensorName(handle).string());
+    };
+    result.append("Latencies of the sensor events from their timestamp to the poll of the HAL:\n");
+    result.append(mPollLatencyHistograms.dump("  ", getSensorName).c_str());
+    const auto& activeConnections = connLock->getActiveConnections();
+    result.appendFormat("Latencies of the sensor events sent to the %zu active connections:\n",
+                        activeConnections.size());
+    for (const sp<SensorEventConnection>& connection : activeConnections) {
+        connection->dumpLatency(result);
+    }
+}
+
 /**
  * Dump debugging information as android.service.SensorServiceProto protobuf message using
  * ProtoOutputStream.
@@ -1062,6 +1101,8 @@ bool SensorService::threadLoop() {
             }
         }
 
+        const nsecs_t pollTime = systemTime(SYSTEM_TIME_BOOTTIME);
+
         // Reset sensors_event_t.flags to zero for all events in the buffer.
         for (int i = 0; i < count; i++) {
              mSensorEventBuffer[i].flags = 0;
@@ -1074,10 +1115,23 @@ bool SensorService::threadLoop() {
         // not be interleaved with decrementing SensorEventConnection::mWakeLockRefCount and
         // releasing the wakelock.
         uint32_t wakeEvents = 0;
+        nsecs_t maxPollLatency = 0;
         for (int i = 0; i < count; i++) {
             if (isWakeUpSensorEvent(mSensorEventBuffer[i])) {
                 wakeEvents++;
             }
+            if (mSensorEventBuffer[i].type != SENSOR_TYPE_META_DATA &&
+                mSensorEventBuffer[i].type != SENSOR_TYPE_DYNAMIC_SENSOR_META &&
+                mSensorEventBuffer[i].type != SENSOR_TYPE_ADDITIONAL_INFO) {
+                const nsecs_t latency = pollTime - mSensorEventBuffer[i].timestamp;
+                mPollLatencyHistograms.add(mSensorEventBuffer[i].sensor,
+                                           SensorServiceUtil::SensorLatencyStage::EVENT_TO_POLLED,
+                                           latency);
+                maxPollLatency = std::max(maxPollLatency, latency);
+            }
+        }
+        if (count > 0 && ATRACE_ENABLED()) {
+            ATRACE_INT64("SensorPollLatencyUs", ns2us(maxPollLatency));
         }
 
         if (wakeEvents > 0) {
@@ -1095,13 +1149,27 @@ bool SensorService::threadLoop() {
             if (!mActiveVirtualSensors.empty()) {
                 size_t k = 0;
                 SensorFusion& fusion(SensorFusion::getInstance());
-                if (fusion.isEnabled()) {
-                    for (size_t i=0 ; i<size_t(count) ; i++) {
-                        fusion.process(event[i]);
+                const bool fusionEnabled = fusion.isEnabled();
+                // Look up the virtual sensors once for the whole buffer, rather than for each
+                // event.
+                mActiveVirtualSensorInterfaces.clear();
+                for (int handle : mActiveVirtualSensors) {
+                    std::shared_ptr<SensorInterface> si = getSensorInterfaceFromHandle(handle);
+                    if (si == nullptr) {
+                        ALOGE("handle %d is not an valid virtual sensor", handle);
+                        continue;
                     }
+                    mActiveVirtualSensorInterfaces.push_back(std::move(si));
                 }
-                for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
-                    for (int handle : mActiveVirtualSensors) {
+                // The fusion and the virtual sensors process the buffer in a single pass, so that
+                // the output of the virtual sensors for each event is computed from the fusion
+                // state at that event, rather than from its state at the end of the buffer.
+                for (size_t i=0 ; i<size_t(count) ; i++) {
+                    if (fusionEnabled) {
+                        fusion.process(event[i]);
+                    }
+                    for (const std::shared_ptr<SensorInterface>& si :
+                            mActiveVirtualSensorInterfaces) {
                         if (count + k >= minBufferSize) {
                             ALOGE("buffer too small to hold all events: "
                                     "count=%zd, k=%zu, size=%zu",
@@ -1109,18 +1177,13 @@ bool SensorService::threadLoop() {
                             break;
                         }
                         sensors_event_t out;
-                        std::shared_ptr<SensorInterface> si = getSensorInterfaceFromHandle(handle);
-                        if (si == nullptr) {
-                            ALOGE("handle %d is not an valid virtual sensor", handle);
-                            continue;
-                        }
-
                         if (si->process(&out, event[i])) {
                             mSensorEventBuffer[count + k] = out;
                             k++;
                         }
                     }
                 }
+                mActiveVirtualSensorInterfaces.clear();
                 if (k) {
                     // record the last synthesized values
                     recordLastValueLocked(&mSensorEventBuffer[count], k);
@@ -1229,12 +1292,19 @@ bool SensorService::threadLoop() {
             }
         }
 
+        // Scatter the events once into the batches of the connections registered for their sensors.
+        updateEventRoutesLocked(activeConnections);
+        mEventRouter.route(mSensorEventBuffer, count);
+
         // Send our events to clients. Check the state of wake lock for each client and release the
         // lock if none of the clients need it.
         bool needsWakeLock = false;
-        for (const sp<SensorEventConnection>& connection : activeConnections) {
-            connection->sendEvents(mSensorEventBuffer, count, mSensorEventScratch,
-                    mMapFlushEventsToConnections);
+        for (size_t i = 0; i < activeConnections.size(); ++i) {
+            const sp<SensorEventConnection>& connection = activeConnections[i];
+            // Connections without events are still given the chance to send their pending flush
+            // complete events.
+            connection->sendRoutedEvents(mSensorEventBuffer, mEventRouter.getBatch(i),
+                    mSensorEventScratch, mMapFlushEventsToConnections);
             needsWakeLock |= connection->needsWakeLock();
             // If the connection has one-shot sensors, it may be cleaned up after first trigger.
             // Early check for one-shot sensors.
@@ -1253,6 +1323,29 @@ bool SensorService::threadLoop() {
     return false;
 }
 
+void SensorService::updateEventRoutesLocked(
+        const std::vector<sp<SensorEventConnection>>& activeConnections) {
+    const uint64_t generation = mEventRoutesGeneration.load();
+    bool upToDate = generation == mRoutedGeneration &&
+            activeConnections.size() == mRoutedConnections.size();
+    for (size_t i = 0; upToDate && i < activeConnections.size(); ++i) {
+        upToDate = activeConnections[i].get() == mRoutedConnections[i];
+    }
+    if (upToDate) {
+        return;
+    }
+
+    std::vector<std::vector<int32_t>> handlesByConnection;
+    handlesByConnection.reserve(activeConnections.size());
+    mRoutedConnections.clear();
+    for (const sp<SensorEventConnection>& connection : activeConnections) {
+        handlesByConnection.push_back(connection->getActiveSensorHandles());
+        mRoutedConnections.push_back(connection.get());
+    }
+    mEventRouter.setRoutes(handlesByConnection);
+    mRoutedGeneration = generation;
+}
+
 sp<Looper> SensorService::getLooper() const {
     return mLooper;
 }
@@ -19,6 +19,8 @@
 
 #include "SensorList.h"
 #include "RecentEventLogger.h"
+#include "SensorEventRouter.h"
+#include "SensorLatencyHistograms.h"
 
 #include <android-base/macros.h>
 #include <binder/AppOpsManager.h>
@@ -42,6 +44,7 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <atomic>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -384,6 +387,7 @@ private:
     virtual status_t dump(int fd, const Vector<String16>& args);
 
     status_t dumpProtoLocked(int fd, ConnectionSafeAutolock* connLock) const;
+    void dumpLatencyLocked(String8& result, ConnectionSafeAutolock* connLock) const;
     String8 getSensorName(int handle) const;
     String8 getSensorStringType(int handle) const;
     bool isVirtualSensor(int handle) const;
@@ -401,6 +405,12 @@ private:
     status_t cleanupWithoutDisableLocked(const sp<SensorEventConnection>& connection, int handle);
     void cleanupAutoDisabledSensorLocked(const sp<SensorEventConnection>& connection,
             sensors_event_t const* buffer, const int count);
+    // Called when the sensors of a connection change, so that the routes of the events to the
+    // connections are rebuilt before the next events are sent.
+    void invalidateEventRoutes() { mEventRoutesGeneration++; }
+    // Rebuilds the routes of the events if the active connections or their sensors changed since
+    // they were built. mLock must be held to invoke this method.
+    void updateEventRoutesLocked(const std::vector<sp<SensorEventConnection>>& activeConnections);
     bool canAccessSensor(const Sensor& sensor, const char* operation,
             const String16& opPackageName);
     void addSensorIfAccessible(const String16& opPackageName, const Sensor& sensor,
@@ -517,13 +527,24 @@ private:
     mutable Mutex mLock;
     DefaultKeyedVector<int, SensorRecord*> mActiveSensors;
     std::unordered_set<int> mActiveVirtualSensors;
+    // The interfaces of mActiveVirtualSensors, while they process a buffer of polled events.
+    std::vector<std::shared_ptr<SensorInterface>> mActiveVirtualSensorInterfaces;
     SensorConnectionHolder mConnectionHolder;
     bool mWakeLockAcquired;
     sensors_event_t *mSensorEventBuffer, *mSensorEventScratch;
     // WARNING: these SensorEventConnection instances must not be promoted to sp, except via
     // modification to add support for them in ConnectionSafeAutolock
     wp<const SensorEventConnection> * mMapFlushEventsToConnections;
+    // The routes of the polled events to the active connections, which are only compared by
+    // their address to detect when the routes have to be rebuilt.
+    SensorServiceUtil::SensorEventRouter mEventRouter;
+    std::vector<const SensorEventConnection*> mRoutedConnections;
+    uint64_t mRoutedGeneration = 0;
+    std::atomic<uint64_t> mEventRoutesGeneration{1};
     std::unordered_map<int, SensorServiceUtil::RecentEventLogger*> mRecentEvent;
+    // The latencies between the timestamps of the events and the return of the poll of the HAL,
+    // by sensor. Protected by mLock.
+    SensorServiceUtil::SensorLatencyHistograms mPollLatencyHistograms;
     Mode mCurrentOperatingMode;
     std::queue<sensors_event_t> mRuntimeSensorEventQueue;
     std::unordered_map</*deviceId*/int, sp<RuntimeSensorCallback>> mRuntimeSensorCallbacks;
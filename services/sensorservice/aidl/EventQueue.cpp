@@ -35,7 +35,7 @@ public:
           : mQueue(queue), mCallback(callback) {}
 
     int handleEvent(int /* fd */, int /* events */, void* /* data */) {
-        ASensorEvent event;
+        ASensorEvent const* events;
         ssize_t actual;
 
         auto internalQueue = mQueue.promote();
@@ -43,12 +43,14 @@ public:
             return 1;
         }
 
-        while ((actual = internalQueue->read(&event, 1)) > 0) {
-            internalQueue->sendAck(&event, actual);
-            ndk::ScopedAStatus ret = mCallback->onEvent(convertEvent(event));
-            if (!ret.isOk()) {
-                LOG(ERROR) << "Failed to envoke EventQueueCallback: " << ret;
+        while ((actual = internalQueue->readInPlace(&events)) > 0) {
+            for (ssize_t i = 0; i < actual; i++) {
+                ndk::ScopedAStatus ret = mCallback->onEvent(convertEvent(events[i]));
+                if (!ret.isOk()) {
+                    LOG(ERROR) << "Failed to envoke EventQueueCallback: " << ret;
+                }
             }
+            internalQueue->sendAck(events, actual);
         }
 
         return 1; // continue to receive callbacks
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+
+#include "Fusion.h"
+
+namespace android {
+
+namespace {
+
+// The gyroscope and the accelerometer report at 1kHz, and the magnetometer at 100Hz.
+constexpr int IMU_RATE_HZ = 1000;
+constexpr int MAG_DECIMATION = 10;
+constexpr float DT = 1.0f / IMU_RATE_HZ;
+
+// A device lying flat, which slowly turns around the vertical axis.
+constexpr float YAW_RATE = 0.5f; // rad/s
+
+vec3_t vector(float x, float y, float z) {
+    vec3_t v;
+    v.x = x;
+    v.y = y;
+    v.z = z;
+    return v;
+}
+
+} // namespace
+
+// Feeds one second of samples to the fusion of the given mode, after it was initialized.
+static void benchmarkFusion(benchmark::State& state) {
+    const int mode = state.range(0);
+    Fusion fusion;
+    fusion.init(mode);
+
+    int sample = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < IMU_RATE_HZ; i++, sample++) {
+            const float yaw = YAW_RATE * sample * DT;
+            fusion.handleGyro(vector(0.001f, -0.002f, YAW_RATE), DT);
+            fusion.handleAcc(vector(0.02f, -0.01f, 9.81f), DT);
+            if (sample % MAG_DECIMATION == 0) {
+                fusion.handleMag(vector(20 * sinf(yaw), 20 * cosf(yaw), -40));
+            }
+        }
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * IMU_RATE_HZ);
+}
+BENCHMARK(benchmarkFusion)
+        ->ArgName("mode")
+        ->Arg(FUSION_9AXIS)
+        ->Arg(FUSION_NOMAG)
+        ->Arg(FUSION_NOGYRO);
+
+} // namespace android
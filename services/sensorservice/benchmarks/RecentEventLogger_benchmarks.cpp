@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "RecentEventLogger.h"
+
+namespace android {
+
+using SensorServiceUtil::RecentEventLogger;
+
+namespace {
+
+// An accelerometer reporting at 400Hz.
+constexpr nsecs_t EVENT_PERIOD_NS = 2'500'000;
+
+} // namespace
+
+// Adds the events of an accelerometer to its logger, which records them all with a log interval
+// of 0, or at most one every interval.
+static void benchmarkAddEvent(benchmark::State& state) {
+    RecentEventLogger logger(SENSOR_TYPE_ACCELEROMETER, ms2ns(state.range(0)));
+    sensors_event_t event{};
+    event.version = sizeof(sensors_event_t);
+    event.type = SENSOR_TYPE_ACCELEROMETER;
+    for (auto _ : state) {
+        event.timestamp += EVENT_PERIOD_NS;
+        event.data[0] = event.timestamp % 10;
+        logger.addEvent(event);
+    }
+    benchmark::DoNotOptimize(logger.isEmpty());
+}
+BENCHMARK(benchmarkAddEvent)->ArgName("intervalMs")->Arg(0)->Arg(10)->Arg(100);
+
+} // namespace android
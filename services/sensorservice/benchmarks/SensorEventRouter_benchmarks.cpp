@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <unordered_set>
+#include <vector>
+
+#include "SensorEventRouter.h"
+
+namespace android {
+
+using SensorServiceUtil::SensorEventRouter;
+
+namespace {
+
+constexpr int32_t ACCELEROMETER = 1;
+constexpr int32_t GYROSCOPE = 2;
+constexpr int32_t MAGNETOMETER = 3;
+constexpr int32_t GAME_ROTATION_VECTOR = 4;
+
+// The time between two polls of the sensors.
+constexpr int64_t POLL_PERIOD_NS = 20'000'000;
+// The accelerometer and the gyroscope report at 400Hz, and the other sensors at 100Hz.
+constexpr int64_t IMU_PERIOD_NS = 2'500'000;
+constexpr int64_t PERIOD_NS = 10'000'000;
+
+// The events of a poll, sorted by time as the events that the service sends.
+std::vector<sensors_event_t> createPolledEvents() {
+    std::vector<sensors_event_t> events;
+    for (int64_t t = 0; t < POLL_PERIOD_NS; t += IMU_PERIOD_NS) {
+        for (int32_t handle : {ACCELEROMETER, GYROSCOPE}) {
+            sensors_event_t& event = events.emplace_back();
+            event.sensor = handle;
+            event.timestamp = t;
+        }
+        if (t % PERIOD_NS == 0) {
+            for (int32_t handle : {MAGNETOMETER, GAME_ROTATION_VECTOR}) {
+                sensors_event_t& event = events.emplace_back();
+                event.sensor = handle;
+                event.timestamp = t;
+            }
+        }
+    }
+    return events;
+}
+
+// Every connection registers for the accelerometer, and for one of the other sensors.
+std::vector<std::vector<int32_t>> createRegistrations(int64_t connectionCount) {
+    std::vector<std::vector<int32_t>> registrations;
+    for (int64_t i = 0; i < connectionCount; i++) {
+        registrations.push_back({ACCELEROMETER, static_cast<int32_t>(GYROSCOPE + i % 3)});
+    }
+    return registrations;
+}
+
+} // namespace
+
+// Filters the whole buffer of events for every connection, which is how the events were sent
+// before they were routed.
+static void benchmarkFilterPerConnection(benchmark::State& state) {
+    const std::vector<sensors_event_t> events = createPolledEvents();
+    std::vector<std::unordered_set<int32_t>> connections;
+    for (const std::vector<int32_t>& handles : createRegistrations(state.range(0))) {
+        connections.emplace_back(handles.begin(), handles.end());
+    }
+    std::vector<sensors_event_t> scratch(events.size());
+
+    for (auto _ : state) {
+        for (const std::unordered_set<int32_t>& handles : connections) {
+            size_t count = 0;
+            for (const sensors_event_t& event : events) {
+                if (handles.count(event.sensor) > 0) {
+                    scratch[count++] = event;
+                }
+            }
+            benchmark::DoNotOptimize(scratch.data());
+            benchmark::DoNotOptimize(count);
+        }
+    }
+}
+BENCHMARK(benchmarkFilterPerConnection)->ArgName("connections")->Arg(1)->Arg(10)->Arg(50);
+
+// Scatters the buffer of events once into the batches of the connections.
+static void benchmarkRoute(benchmark::State& state) {
+    const std::vector<sensors_event_t> events = createPolledEvents();
+    SensorEventRouter router;
+    router.setRoutes(createRegistrations(state.range(0)));
+    std::vector<sensors_event_t> scratch(events.size());
+
+    for (auto _ : state) {
+        router.route(events.data(), events.size());
+        for (size_t i = 0; i < router.getConnectionCount(); i++) {
+            size_t count = 0;
+            for (uint32_t index : router.getBatch(i)) {
+                scratch[count++] = events[index];
+            }
+            benchmark::DoNotOptimize(scratch.data());
+            benchmark::DoNotOptimize(count);
+        }
+    }
+}
+BENCHMARK(benchmarkRoute)->ArgName("connections")->Arg(1)->Arg(10)->Arg(50);
+
+} // namespace android
+
+BENCHMARK_MAIN();
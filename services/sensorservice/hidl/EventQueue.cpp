@@ -34,7 +34,7 @@ public:
 
     int handleEvent(__unused int fd, __unused int events, __unused void* data) {
 
-        ASensorEvent event;
+        ASensorEvent const* events;
         ssize_t actual;
 
         auto internalQueue = mQueue.promote();
@@ -42,10 +42,12 @@ public:
             return 1;
         }
 
-        while ((actual = internalQueue->read(&event, 1 /* count */)) > 0) {
-            internalQueue->sendAck(&event, actual);
-            Return<void> ret = mCallback->onEvent(convertEvent(event));
-            (void)ret.isOk(); // ignored
+        while ((actual = internalQueue->readInPlace(&events)) > 0) {
+            for (ssize_t i = 0; i < actual; i++) {
+                Return<void> ret = mCallback->onEvent(convertEvent(events[i]));
+                (void)ret.isOk(); // ignored
+            }
+            internalQueue->sendAck(events, actual);
         }
 
         return 1; // continue to receive callbacks
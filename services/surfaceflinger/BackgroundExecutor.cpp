@@ -19,7 +19,11 @@
 #define LOG_TAG "BackgroundExecutor"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <android-base/stringprintf.h>
+#include <ftl/enum.h>
 #include <utils/Log.h>
+#include <algorithm>
+#include <cinttypes>
 #include <mutex>
 
 #include "BackgroundExecutor.h"
@@ -31,47 +35,146 @@ ANDROID_SINGLETON_STATIC_INSTANCE(BackgroundExecutor);
 BackgroundExecutor::BackgroundExecutor() : Singleton<BackgroundExecutor>() {
     // mSemaphore must be initialized before any calls to
     // BackgroundExecutor::sendCallbacks. For this reason, we initialize it
-    // within the constructor instead of within mThread.
+    // within the constructor instead of within the worker threads.
     LOG_ALWAYS_FATAL_IF(sem_init(&mSemaphore, 0, 0), "sem_init failed");
-    mThread = std::thread([&]() {
-        while (!mDone) {
-            LOG_ALWAYS_FATAL_IF(sem_wait(&mSemaphore), "sem_wait failed (%d)", errno);
-            auto callbacks = mCallbacksQueue.pop();
-            if (!callbacks) {
-                continue;
-            }
-            for (auto& callback : *callbacks) {
-                callback();
-            }
-        }
-    });
+    for (auto& thread : mThreads) {
+        thread = std::thread([this]() { workerLoop(); });
+    }
 }
 
 BackgroundExecutor::~BackgroundExecutor() {
     mDone = true;
-    LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
-    if (mThread.joinable()) {
-        mThread.join();
+    for (size_t i = 0; i < kWorkerCount; i++) {
+        LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
+    }
+    {
+        std::scoped_lock lock(mWorkerMutex);
+        mLaneReleased.notify_all();
+    }
+    bool joined = false;
+    for (auto& thread : mThreads) {
+        if (thread.joinable()) {
+            thread.join();
+            joined = true;
+        }
+    }
+    if (joined) {
         LOG_ALWAYS_FATAL_IF(sem_destroy(&mSemaphore), "sem_destroy failed");
     }
 }
 
-void BackgroundExecutor::sendCallbacks(Callbacks&& tasks) {
-    mCallbacksQueue.push(std::move(tasks));
+void BackgroundExecutor::workerLoop() {
+    while (!mDone) {
+        // Every token stands for one queued batch, though not necessarily one this worker can
+        // take yet: it may be queued behind a batch that another worker is running on its lane.
+        LOG_ALWAYS_FATAL_IF(sem_wait(&mSemaphore), "sem_wait failed (%d)", errno);
+
+        std::optional<size_t> laneIndex;
+        {
+            std::unique_lock lock(mWorkerMutex);
+            base::ScopedLockAssertion assumeLocked(mWorkerMutex);
+            mLaneReleased.wait(lock, [&]() REQUIRES(mWorkerMutex) {
+                laneIndex = claimLaneLocked();
+                return laneIndex || mDone;
+            });
+        }
+        if (!laneIndex) {
+            continue;
+        }
+
+        runBatch(mLanes[*laneIndex]);
+
+        std::scoped_lock lock(mWorkerMutex);
+        mLaneBusy[*laneIndex] = false;
+        mLaneReleased.notify_all();
+    }
+}
+
+std::optional<size_t> BackgroundExecutor::claimLaneLocked() {
+    // Lanes are declared in priority order.
+    for (size_t i = 0; i < kLaneCount; i++) {
+        if (!mLaneBusy[i] && !mLanes[i].queue.isEmpty()) {
+            mLaneBusy[i] = true;
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+void BackgroundExecutor::runBatch(LaneState& lane) {
+    auto batch = lane.queue.pop();
+    LOG_ALWAYS_FATAL_IF(!batch, "Claimed an empty lane");
+    lane.depth.fetch_sub(1, std::memory_order_relaxed);
+
+    const nsecs_t latency = systemTime() - batch->enqueueTime;
+    const auto bucket = static_cast<size_t>(
+            std::upper_bound(kLatencyBucketLimits.begin(), kLatencyBucketLimits.end(), latency) -
+            kLatencyBucketLimits.begin());
+    lane.latencyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    lane.batchCount.fetch_add(1, std::memory_order_relaxed);
+
+    for (auto& callback : batch->callbacks) {
+        callback();
+    }
+}
+
+void BackgroundExecutor::sendCallbacks(Callbacks&& tasks, Lane lane) {
+    // Callers such as TransactionCallbackInvoker send every frame, usually with nothing to do.
+    // Pushing would allocate a queue node and wake a worker for no work.
+    if (tasks.empty()) {
+        return;
+    }
+
+    LaneState& state = mLanes[static_cast<size_t>(lane)];
+    state.queue.push({std::move(tasks), systemTime()});
+    const size_t depth = state.depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t maxDepth = state.maxDepth.load(std::memory_order_relaxed);
+    while (depth > maxDepth &&
+           !state.maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {
+    }
     LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
 }
 
 void BackgroundExecutor::flushQueue() {
+    // Lanes run their batches in order, so a marker in every lane runs after everything that
+    // was sent before it.
     std::mutex mutex;
     std::condition_variable cv;
-    bool flushComplete = false;
-    sendCallbacks({[&]() {
-        std::scoped_lock lock{mutex};
-        flushComplete = true;
-        cv.notify_one();
-    }});
+    size_t flushedLanes = 0;
+    for (const auto lane : ftl::enum_range<Lane>()) {
+        sendCallbacks({[&]() {
+                          std::scoped_lock lock{mutex};
+                          flushedLanes++;
+                          cv.notify_one();
+                      }},
+                      lane);
+    }
     std::unique_lock<std::mutex> lock{mutex};
-    cv.wait(lock, [&]() { return flushComplete; });
+    cv.wait(lock, [&]() { return flushedLanes == kLaneCount; });
+}
+
+void BackgroundExecutor::dump(std::string& result) const {
+    result.append("BackgroundExecutor:\n");
+    for (const auto lane : ftl::enum_range<Lane>()) {
+        const LaneState& state = mLanes[static_cast<size_t>(lane)];
+        base::StringAppendF(&result, "  %s: depth=%zu maxDepth=%zu batches=%" PRIu64 "\n",
+                            ftl::enum_string(lane).c_str(),
+                            state.depth.load(std::memory_order_relaxed),
+                            state.maxDepth.load(std::memory_order_relaxed),
+                            state.batchCount.load(std::memory_order_relaxed));
+        result.append("    queue latency:");
+        for (size_t i = 0; i < kLatencyBucketCount; i++) {
+            const uint64_t count = state.latencyHistogram[i].load(std::memory_order_relaxed);
+            if (i < kLatencyBucketLimits.size()) {
+                base::StringAppendF(&result, " <%" PRId64 "us=%" PRIu64,
+                                    ns2us(kLatencyBucketLimits[i]), count);
+            } else {
+                base::StringAppendF(&result, " >=%" PRId64 "us=%" PRIu64,
+                                    ns2us(kLatencyBucketLimits.back()), count);
+            }
+        }
+        result.append("\n");
+    }
 }
 
 } // namespace android
@@ -16,9 +16,18 @@
 
 #pragma once
 
+#include <android-base/thread_annotations.h>
 #include <ftl/small_vector.h>
 #include <semaphore.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
 
 #include "LocklessQueue.h"
@@ -26,22 +35,72 @@
 namespace android {
 
 // Executes tasks off the main thread.
+//
+// Tasks are queued on one of several lanes. Within a lane, batches run in the order they were
+// sent and never concurrently, which callers rely on for ordering and for state that is only
+// touched from background callbacks. Different lanes run in parallel on a small pool of workers,
+// and an idle worker takes over whichever lane has work, highest priority first, so a slow bulk
+// callback cannot hold up buffer releases.
 class BackgroundExecutor : public Singleton<BackgroundExecutor> {
 public:
+    enum class Lane : uint8_t {
+        // Work that gates frames or input, such as transaction callbacks and release fences.
+        LatencyCritical,
+        // Work that can be late, such as tracing, stats and deferred destruction.
+        Bulk,
+
+        ftl_last = Bulk
+    };
+    static constexpr size_t kLaneCount = static_cast<size_t>(Lane::ftl_last) + 1;
+
     BackgroundExecutor();
     ~BackgroundExecutor();
     using Callbacks = ftl::SmallVector<std::function<void()>, 10>;
     // Queues callbacks onto a work queue to be executed by a background thread.
     // This is safe to call from multiple threads.
-    void sendCallbacks(Callbacks&& tasks);
+    void sendCallbacks(Callbacks&& tasks, Lane lane = Lane::LatencyCritical);
+    // Blocks until every batch sent before the call has run, on all lanes.
     void flushQueue();
 
+    void dump(std::string& result) const;
+
 private:
+    struct Batch {
+        Callbacks callbacks;
+        nsecs_t enqueueTime = 0;
+    };
+
+    // Buckets of the time a batch waited between sendCallbacks and starting to run. The last
+    // bucket is unbounded.
+    static constexpr std::array<nsecs_t, 7> kLatencyBucketLimits = {
+            us2ns(100), us2ns(500), ms2ns(1), ms2ns(2), ms2ns(4), ms2ns(8), ms2ns(16)};
+    static constexpr size_t kLatencyBucketCount = kLatencyBucketLimits.size() + 1;
+
+    struct LaneState {
+        LocklessQueue<Batch> queue;
+        std::atomic<size_t> depth = 0;
+        std::atomic<size_t> maxDepth = 0;
+        std::atomic<uint64_t> batchCount = 0;
+        std::array<std::atomic<uint64_t>, kLatencyBucketCount> latencyHistogram = {};
+    };
+
+    static constexpr size_t kWorkerCount = kLaneCount;
+
+    void workerLoop();
+    std::optional<size_t> claimLaneLocked() REQUIRES(mWorkerMutex);
+    void runBatch(LaneState&);
+
     sem_t mSemaphore;
     std::atomic_bool mDone = false;
 
-    LocklessQueue<Callbacks> mCallbacksQueue;
-    std::thread mThread;
+    mutable std::mutex mWorkerMutex;
+    // Signaled when a lane is released, for workers waiting on work queued behind a busy lane.
+    std::condition_variable mLaneReleased;
+    // Whether a worker currently owns each lane. Only the owner pops from the lane's queue.
+    std::array<bool, kLaneCount> mLaneBusy GUARDED_BY(mWorkerMutex) = {};
+    std::array<LaneState, kLaneCount> mLanes;
+
+    std::array<std::thread, kWorkerCount> mThreads;
 };
 
 } // namespace android
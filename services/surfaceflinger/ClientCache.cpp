@@ -31,6 +31,39 @@ namespace android {
 
 ANDROID_SINGLETON_STATIC_INSTANCE(ClientCache);
 
+// A texture that defers importing its buffer into RenderEngine until it is drawn, and records
+// whether and how that import happened.
+class ClientCache::Texture : public renderengine::impl::ExternalTexture {
+public:
+    Texture(const sp<GraphicBuffer>& buffer, renderengine::RenderEngine& renderEngine,
+            ImportStats& stats)
+          : renderengine::impl::ExternalTexture(buffer, renderEngine,
+                                                Usage::READABLE | Usage::DEFER_MAPPING),
+            mStats(stats) {
+        mStats.addedBuffers++;
+    }
+
+    ~Texture() override {
+        if (!isMapped()) {
+            mStats.skippedImports++;
+        }
+    }
+
+    void ensureMapped() override {
+        if (isMapped()) {
+            return;
+        }
+        const nsecs_t start = systemTime();
+        if (mapDeferred()) {
+            mStats.deferredImports++;
+            mStats.deferredImportTime += systemTime() - start;
+        }
+    }
+
+private:
+    ImportStats& mStats;
+};
+
 ClientCache::ClientCache() : mDeathRecipient(sp<CacheDeathRecipient>::make()) {}
 
 bool ClientCache::getBuffer(const client_cache_t& cacheId,
@@ -112,10 +145,8 @@ ClientCache::add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer)
                         "Attempted to build the ClientCache before a RenderEngine instance was "
                         "ready!");
 
-    return (processBuffers[id].buffer = std::make_shared<
-                    renderengine::impl::ExternalTexture>(buffer, *mRenderEngine,
-                                                         renderengine::impl::ExternalTexture::
-                                                                 Usage::READABLE));
+    return (processBuffers[id].buffer =
+                    std::make_shared<Texture>(buffer, *mRenderEngine, mImportStats));
 }
 
 sp<GraphicBuffer> ClientCache::erase(const client_cache_t& cacheId) {
@@ -222,6 +253,14 @@ void ClientCache::CacheDeathRecipient::binderDied(const wp<IBinder>& who) {
 }
 
 void ClientCache::dump(std::string& result) {
+    base::StringAppendF(&result,
+                        " Buffer imports: %" PRIu64 " buffers added, %" PRIu64
+                        " imported when first drawn (%.3f ms total), %" PRIu64
+                        " released without import\n",
+                        mImportStats.addedBuffers.load(), mImportStats.deferredImports.load(),
+                        static_cast<double>(mImportStats.deferredImportTime.load()) / 1e6,
+                        mImportStats.skippedImports.load());
+
     std::lock_guard lock(mMutex);
     for (const auto& [_, cache] : mBuffers) {
         base::StringAppendF(&result, " Cache owner: %p\n", cache.first.get());
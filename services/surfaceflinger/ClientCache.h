@@ -23,12 +23,17 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/RefBase.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <set>
 #include <unordered_map>
 
+// The number of buffers each client process can have cached. It is kept small since every cached
+// buffer holds file descriptors and a mapper import in SurfaceFlinger. The cache of the clients in
+// libgui is smaller, so that they evict their least recently used buffer before this one is full.
 #define BUFFER_CACHE_MAX_SIZE 64
 
 namespace android {
@@ -75,7 +80,21 @@ public:
 
     void dump(std::string& result);
 
+    // Cached buffers are only imported into RenderEngine once they are drawn, since buffers that
+    // HWC scans out are never sampled.
+    struct ImportStats {
+        std::atomic<uint64_t> addedBuffers = 0;
+        // Buffers imported when they were first drawn, and the time spent importing them on the
+        // threads that drew them.
+        std::atomic<uint64_t> deferredImports = 0;
+        std::atomic<nsecs_t> deferredImportTime = 0;
+        // Buffers released without ever being imported.
+        std::atomic<uint64_t> skippedImports = 0;
+    };
+
 private:
+    class Texture;
+
     std::mutex mMutex;
 
     struct ClientCacheBuffer {
@@ -95,6 +114,8 @@ private:
     sp<CacheDeathRecipient> mDeathRecipient;
     renderengine::RenderEngine* mRenderEngine = nullptr;
 
+    ImportStats mImportStats;
+
     bool getBuffer(const client_cache_t& cacheId, ClientCacheBuffer** outClientCacheBuffer)
             REQUIRES(mMutex);
 };
@@ -55,6 +55,10 @@ struct CompositionRefreshArgs {
     // All graphic buffers that will no longer be used and should be removed from caches.
     std::vector<uint64_t> bufferIdsToUncache;
 
+    // Buffers that were newly cached for layers, which tracking HWC buffer caches can send to HWC
+    // before the frame that displays them.
+    BuffersToPrefetch buffersToPrefetch;
+
     // Controls how the color mode is chosen for an output
     OutputColorSetting outputColorSetting{OutputColorSetting::kEnhanced};
 
@@ -96,6 +100,14 @@ struct CompositionRefreshArgs {
     std::vector<BorderRenderInfo> borderInfoList;
 
     bool hasTrustedPresentationListener = false;
+
+    // If true, outputs that share no layers, and support it, are presented concurrently. Must only
+    // be set if RenderEngine serializes its work on its own thread.
+    bool parallelPresent{false};
+
+    // If true, the outputs record the time spent on each of their layers, and on HWC validate and
+    // present, in their composition state.
+    bool recordLayerCosts{false};
 };
 
 } // namespace android::compositionengine
@@ -59,6 +59,14 @@ public:
     // Sends the brightness setting to HWC
     virtual void applyDisplayBrightness(const bool applyImmediately) = 0;
 
+    // Enables choosing between presentOrValidate and validate for each layer stack based on how
+    // often presentOrValidate presented it
+    virtual void setPredictSkipValidate(bool) = 0;
+
+    // Enables HWC buffer caches that learn each layer's buffer cycle, and that accept buffers ahead
+    // of the frame that displays them
+    virtual void setHwcBufferCacheTracking(bool) = 0;
+
 protected:
     ~Display() = default;
 };
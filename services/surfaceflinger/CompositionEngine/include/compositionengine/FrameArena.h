@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace android::compositionengine {
+
+// A monotonic allocator for containers that live for a single composition pass. Allocation bumps
+// a pointer, deallocation is a no-op, and reset() releases everything at once at the end of the
+// frame.
+//
+// The arena grows by adding blocks. On reset(), if more than one block was needed, the blocks
+// are replaced by a single block large enough for the whole frame. Steady-state frames therefore
+// do not touch the heap at all, which the allocation counters make observable.
+//
+// Not thread safe; an arena belongs to the thread that composites.
+class FrameArena {
+public:
+    static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+    explicit FrameArena(size_t initialBlockSize = kDefaultBlockSize);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+
+    // Called at the end of a frame. Every allocation made since the previous reset is released.
+    void reset();
+
+    struct Stats {
+        // Heap allocations made by the arena since the last reset.
+        size_t heapAllocationsThisFrame = 0;
+        // Heap allocations made by the arena during the previous frame.
+        size_t heapAllocationsLastFrame = 0;
+        size_t bytesUsedLastFrame = 0;
+        size_t capacity = 0;
+    };
+    const Stats& getStats() const { return mStats; }
+
+    void dump(std::string& result) const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    void addBlock(size_t size);
+
+    std::vector<Block> mBlocks;
+    size_t mCurrentBlock = 0;
+    size_t mOffset = 0;
+    // Bytes handed out since the last reset, including alignment padding.
+    size_t mBytesUsed = 0;
+    Stats mStats;
+};
+
+// Standard allocator that draws from a FrameArena. A default-constructed allocator has no arena
+// and uses the heap, so containers using it can still be created outside of a frame.
+template <typename T>
+class FrameArenaAllocator {
+public:
+    using value_type = T;
+
+    FrameArenaAllocator() = default;
+    explicit FrameArenaAllocator(FrameArena* arena) : mArena(arena) {}
+
+    template <typename U>
+    FrameArenaAllocator(const FrameArenaAllocator<U>& other) : mArena(other.getArena()) {}
+
+    T* allocate(size_t n) {
+        if (mArena) {
+            return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+        if (!mArena) {
+            ::operator delete(p);
+        }
+    }
+
+    FrameArena* getArena() const { return mArena; }
+
+    template <typename U>
+    bool operator==(const FrameArenaAllocator<U>& other) const {
+        return mArena == other.getArena();
+    }
+    template <typename U>
+    bool operator!=(const FrameArenaAllocator<U>& other) const {
+        return !(*this == other);
+    }
+
+private:
+    FrameArena* mArena = nullptr;
+};
+
+} // namespace android::compositionengine
@@ -31,6 +31,7 @@
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
 #pragma clang diagnostic pop // ignored "-Wconversion -Wextra"
 
+#include <compositionengine/FrameArena.h>
 #include <ftl/future.h>
 #include <ui/FenceResult.h>
 #include <utils/RefBase.h>
@@ -162,7 +163,9 @@ struct LayerFESpHash {
     size_t operator()(const sp<LayerFE>& p) const { return std::hash<LayerFE*>()(p.get()); }
 };
 
-using LayerFESet = std::unordered_set<sp<LayerFE>, LayerFESpHash>;
+// Usually allocated from the CompositionEngine's FrameArena, as it only lives for one frame.
+using LayerFESet = std::unordered_set<sp<LayerFE>, LayerFESpHash, std::equal_to<sp<LayerFE>>,
+                                      FrameArenaAllocator<sp<LayerFE>>>;
 
 static inline bool operator==(const LayerFE::ClientCompositionTargetSettings& lhs,
                               const LayerFE::ClientCompositionTargetSettings& rhs) {
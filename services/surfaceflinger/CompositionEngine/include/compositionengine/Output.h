@@ -60,6 +60,9 @@ struct OutputCompositionState;
 struct GpuCompositionResult;
 } // namespace impl
 
+// Buffers that arrived for layers ahead of being displayed, keyed by LayerFE::getSequence().
+using BuffersToPrefetch = std::unordered_map<int32_t, std::vector<sp<GraphicBuffer>>>;
+
 /**
  * Encapsulates all the state involved with composing layers for an output
  */
@@ -267,17 +270,26 @@ public:
     // Presents the output, finalizing all composition details
     virtual void present(const CompositionRefreshArgs&) = 0;
 
+    // Returns whether the output may be presented concurrently with other outputs, as long as they
+    // share no layers.
+    virtual bool supportsParallelPresent() = 0;
+
     // Enables predicting composition strategy to run client composition earlier
     virtual void setPredictCompositionStrategy(bool) = 0;
 
     // Enables overriding the 170M trasnfer function as sRGB
     virtual void setTreat170mAsSrgb(bool) = 0;
 
+    // Enables reusing the previous frame's visible regions for layers that are not affected by
+    // the geometry changes of the current frame
+    virtual void setIncrementalVisibilityEnabled(bool) = 0;
+
 protected:
     virtual void setDisplayColorProfile(std::unique_ptr<DisplayColorProfile>) = 0;
     virtual void setRenderSurface(std::unique_ptr<RenderSurface>) = 0;
 
     virtual void uncacheBuffers(const std::vector<uint64_t>&) = 0;
+    virtual void prefetchBuffers(const BuffersToPrefetch&) = 0;
     virtual void rebuildLayerStacks(const CompositionRefreshArgs&, LayerFESet&) = 0;
     virtual void collectVisibleLayers(const CompositionRefreshArgs&, CoverageState&) = 0;
     virtual void ensureOutputLayerIfVisible(sp<LayerFE>&, CoverageState&) = 0;
@@ -316,6 +328,9 @@ protected:
     virtual void setExpensiveRenderingExpected(bool enabled) = 0;
     virtual void setHintSessionGpuFence(std::unique_ptr<FenceTime>&& gpuFence) = 0;
     virtual bool isPowerHintSessionEnabled() = 0;
+    // Tells the power hint session whether the frame is expected to use client composition,
+    // before it is composed.
+    virtual void setHintSessionExpectedClientComposition(bool expected) = 0;
     virtual void cacheClientCompositionRequests(uint32_t cacheSize) = 0;
     virtual bool canPredictCompositionStrategy(const CompositionRefreshArgs&) = 0;
 };
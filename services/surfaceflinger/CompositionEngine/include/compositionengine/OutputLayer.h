@@ -86,6 +86,9 @@ public:
     // longer cares about.
     virtual void uncacheBuffers(const std::vector<uint64_t>& bufferIdsToUncache) = 0;
 
+    // Sends buffers that are expected to be displayed soon to the HWC cache ahead of time.
+    virtual void prefetchBuffers(const std::vector<sp<GraphicBuffer>>& buffers) = 0;
+
     // Recalculates the state of the output layer from the output-independent
     // layer. If includeGeometry is false, the geometry state can be skipped.
     // internalDisplayRotationFlags must be set to the rotation flags for the
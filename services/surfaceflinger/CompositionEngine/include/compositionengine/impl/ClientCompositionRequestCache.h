@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <deque>
+#include <string>
 
 #include <compositionengine/LayerFE.h>
 #include <renderengine/DisplaySettings.h>
@@ -37,18 +38,33 @@ namespace compositionengine::impl {
 // the composition request. We need to make sure the request, including the order of the
 // layers, do not change from call to call. The snapshot removes strong references to the
 // client buffer id so we don't extend the lifetime of the buffer by storing it in the cache.
+//
+// Only the request last rendered into a buffer can be reused, since that is what the buffer holds.
+// When the cache is smaller than the number of buffers the RenderSurface cycles through, the least
+// recently used buffer is evicted.
 class ClientCompositionRequestCache {
 public:
     explicit ClientCompositionRequestCache(uint32_t cacheSize) : mMaxCacheSize(cacheSize){};
     ~ClientCompositionRequestCache() = default;
+    // Returns whether the request was the last one rendered into the buffer, and counts the
+    // lookup as a hit or miss.
     bool exists(uint64_t bufferId, const renderengine::DisplaySettings& display,
-                const std::vector<LayerFE::LayerSettings>& layerSettings) const;
+                const std::vector<LayerFE::LayerSettings>& layerSettings);
     void add(uint64_t bufferId, const renderengine::DisplaySettings& display,
              const std::vector<LayerFE::LayerSettings>& layerSettings);
     void remove(uint64_t bufferId);
 
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+    const Stats& getStats() const { return mStats; }
+
+    void dump(std::string& out) const;
+
 private:
     uint32_t mMaxCacheSize;
+    Stats mStats;
     struct ClientCompositionRequest {
         renderengine::DisplaySettings display;
         std::vector<LayerFE::LayerSettings> layerSettings;
@@ -58,7 +74,7 @@ private:
                     const std::vector<LayerFE::LayerSettings>& _layerSettings) const;
     };
 
-    // Cache of requests, keyed by corresponding GraphicBuffer ID.
+    // Cache of requests, keyed by corresponding GraphicBuffer ID. Most recently used last.
     std::deque<std::pair<uint64_t /* bufferId */, ClientCompositionRequest>> mCache;
 };
 
@@ -17,9 +17,16 @@
 #pragma once
 
 #include <compositionengine/CompositionEngine.h>
+#include <compositionengine/FrameArena.h>
+#include <utils/Timers.h>
+
+#include <memory>
+#include <vector>
 
 namespace android::compositionengine::impl {
 
+class HwcAsyncWorker;
+
 class CompositionEngine : public compositionengine::CompositionEngine {
 public:
     CompositionEngine();
@@ -53,15 +60,32 @@ public:
     // Debugging
     void dump(std::string&) const override;
 
+    struct ParallelPresentStats {
+        // Frames that presented more than one group of outputs concurrently.
+        size_t frames = 0;
+        // Time the main thread would have spent presenting the outputs of the other groups.
+        nsecs_t timeSaved = 0;
+    };
+    const ParallelPresentStats& getParallelPresentStats() const { return mParallelPresentStats; }
+
     // Testing
     void setNeedsAnotherUpdateForTest(bool);
+    const FrameArena& getFrameArenaForTest() const { return mFrameArena; }
 
 private:
+    void presentOutputsInParallel(CompositionRefreshArgs&);
+
     std::unique_ptr<HWComposer> mHwComposer;
     renderengine::RenderEngine* mRenderEngine;
     std::shared_ptr<TimeStats> mTimeStats;
     bool mNeedsAnotherUpdate = false;
     nsecs_t mRefreshStartTime = 0;
+    // Backs containers that only live for one present() call. Reset at the end of each frame.
+    FrameArena mFrameArena;
+
+    // Present the groups of outputs that are not presented on the main thread.
+    std::vector<std::unique_ptr<HwcAsyncWorker>> mPresentWorkers;
+    ParallelPresentStats mParallelPresentStats;
 };
 
 std::unique_ptr<compositionengine::CompositionEngine> createCompositionEngine();
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+
+#include "DisplayHardware/HWComposer.h"
+
+namespace android::compositionengine::impl {
+
+// Remembers the composition strategy that HWC chose for the most recently composed layer stacks,
+// keyed by OutputCompositionState::outputLayerHash. This lets the output predict the strategy,
+// and start client composition in parallel with HWC validation, when it returns to a layer stack
+// it composed a few frames ago, and not only when the layer stack is unchanged from the previous
+// frame.
+class CompositionStrategyHistory {
+public:
+    struct Strategy {
+        std::optional<android::HWComposer::DeviceRequestedChanges> changes;
+        bool success = false;
+        // Whether the strategy needed client composition, and thus GPU work to predict.
+        bool usesClientComposition = false;
+    };
+
+    explicit CompositionStrategyHistory(size_t capacity) : mCapacity(capacity) {}
+
+    // Returns the strategy recorded for the layer stack, or nullptr if there is none. The pointer
+    // is invalidated by the next call to a non-const method.
+    const Strategy* get(uint64_t layerStackHash);
+    void record(uint64_t layerStackHash, Strategy);
+    void clear() { mStrategies.clear(); }
+    size_t size() const { return mStrategies.size(); }
+
+    // Records whether a predicted strategy matched the one HWC chose. `recalled` is set if the
+    // prediction came from a layer stack other than the previous frame's.
+    void recordPrediction(bool succeeded, bool recalled);
+
+    struct PredictionStats {
+        size_t predictions = 0;
+        size_t hits = 0;
+        size_t recalledPredictions = 0;
+        size_t recalledHits = 0;
+    };
+    const PredictionStats& getPredictionStats() const { return mStats; }
+
+    void dump(std::string& out) const;
+
+private:
+    const size_t mCapacity;
+
+    // Most recently used first.
+    std::deque<std::pair<uint64_t /* layerStackHash */, Strategy>> mStrategies;
+
+    PredictionStats mStats;
+};
+
+} // namespace android::compositionengine::impl
@@ -24,6 +24,7 @@
 #include <compositionengine/RenderSurface.h>
 #include <compositionengine/impl/GpuCompositionResult.h>
 #include <compositionengine/impl/Output.h>
+#include <compositionengine/impl/SkipValidateHistory.h>
 #include <ui/PixelFormat.h>
 #include <ui/Size.h>
 
@@ -62,6 +63,7 @@ public:
     compositionengine::Output::FrameFences presentAndGetFrameFences() override;
     void setExpensiveRenderingExpected(bool) override;
     void finishFrame(GpuCompositionResult&&) override;
+    bool supportsParallelPresent() override;
 
     // compositionengine::Display overrides
     DisplayId getId() const override;
@@ -73,6 +75,8 @@ public:
     void createRenderSurface(const compositionengine::RenderSurfaceCreationArgs&) override;
     void createClientCompositionCache(uint32_t cacheSize) override;
     void applyDisplayBrightness(const bool applyImmediately) override;
+    void setPredictSkipValidate(bool) override;
+    void setHwcBufferCacheTracking(bool) override;
 
     // Internal helpers used by chooseCompositionStrategy()
     using ChangedTypes = android::HWComposer::DeviceRequestedChanges::ChangedTypes;
@@ -92,9 +96,16 @@ public:
 private:
     bool isPowerHintSessionEnabled() override;
     void setHintSessionGpuFence(std::unique_ptr<FenceTime>&& gpuFence) override;
+    void setHintSessionExpectedClientComposition(bool expected) override;
     DisplayId mId;
     bool mIsDisconnected = false;
     Hwc2::PowerAdvisor* mPowerAdvisor = nullptr;
+
+    static constexpr size_t kSkipValidateHistorySize = 8;
+    bool mPredictSkipValidate = false;
+    SkipValidateHistory mSkipValidateHistory{kSkipValidateHistorySize};
+
+    bool mHwcBufferCacheTracking = false;
 };
 
 // This template factory function standardizes the implementation details of the
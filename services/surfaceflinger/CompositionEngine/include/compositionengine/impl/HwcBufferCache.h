@@ -17,6 +17,8 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <optional>
 #include <stack>
 #include <unordered_map>
 
@@ -68,6 +70,16 @@ public:
 
     HwcBufferCache();
 
+    //
+    // In tracking mode, a full cache evicts the buffer that the producer is predicted to need last,
+    // based on the number of buffers it cycles through, rather than the least recently used one.
+    // Buffers that fell out of the cycle are evicted first, so the slots in use match the cycle.
+    // When a producer cycles through more buffers than there are slots, the least recently used
+    // buffer is the one it needs next, and would otherwise have its handle re-imported every time.
+    //
+    void setTracking(bool tracking) { mTracking = tracking; }
+    bool isTracking() const { return mTracking; }
+
     //
     // Given a buffer, return the HWC cache slot and buffer to send to HWC.
     //
@@ -85,6 +97,16 @@ public:
     //
     HwcSlotAndBuffer getOverrideHwcSlotAndBuffer(const sp<GraphicBuffer>& buffer);
 
+    //
+    // In tracking mode, assigns a slot to a buffer expected to be sent to this layer soon, so its
+    // handle can be sent to HWC ahead of the frame that displays it. The buffer is then returned
+    // as null from getHwcSlotAndBuffer.
+    //
+    // Returns nullopt if the buffer is already cached, if no buffer was sent to this layer yet, or
+    // if caching it would evict a buffer that the producer is still cycling through.
+    //
+    std::optional<HwcSlotAndBuffer> prefetch(const sp<GraphicBuffer>& buffer);
+
     //
     // When a client process discards a buffer, it needs to be purged from the HWC cache.
     //
@@ -92,22 +114,57 @@ public:
     //
     uint32_t uncache(uint64_t graphicBufferId);
 
-private:
-    uint32_t cache(const sp<GraphicBuffer>& buffer);
-    uint32_t getLeastRecentlyUsedSlot();
+    // The number of distinct buffers the producer is observed to cycle through.
+    uint32_t getCycleLength() const { return mCycleLength; }
+    // The number of times a buffer handle was sent to HWC again after its slot had been reused.
+    uint32_t getReimportCount() const { return mReimportCount; }
+    // The number of buffer handles sent to HWC ahead of being displayed, and how many of those
+    // buffers were later displayed.
+    uint32_t getPrefetchCount() const { return mPrefetchCount; }
+    uint32_t getPrefetchHitCount() const { return mPrefetchHitCount; }
 
+private:
     struct Cache {
         sp<GraphicBuffer> buffer;
         uint32_t slot;
         // Cache entries are evicted according to least-recently-used when more than
         // kMaxLayerBufferCount unique buffers have been sent to a layer.
         uint64_t lruCounter;
+        // The value of mBufferChangeCounter when the buffer was last sent to the layer.
+        uint64_t lastBufferChange;
+        // Set until a prefetched buffer is first sent to the layer.
+        bool prefetched;
     };
+    using CacheMap = std::unordered_map<uint64_t, Cache>;
 
-    std::unordered_map<uint64_t, Cache> mCacheByBufferId;
+    uint32_t cache(const sp<GraphicBuffer>& buffer);
+    uint32_t getLeastRecentlyUsedSlot();
+    CacheMap::iterator getPredictedLastNeeded();
+    bool isOutsideCycle(const Cache& cache) const;
+    void evict(CacheMap::iterator cacheToEvict);
+    void recordReuse(uint64_t previousBufferChange);
+
+    CacheMap mCacheByBufferId;
     sp<GraphicBuffer> mLastOverrideBuffer;
     std::stack<uint32_t> mFreeSlots;
     uint64_t mLeastRecentlyUsedCounter;
+
+    bool mTracking = false;
+    // The buffer most recently sent to the layer, which must not be evicted in tracking mode since
+    // it may still be on screen.
+    std::optional<uint64_t> mLastBufferId;
+    // Counts the times the layer's buffer changed, as a clock for the producer's buffer cycle.
+    uint64_t mBufferChangeCounter = 0;
+    uint32_t mCycleLength = 0;
+
+    // Recently evicted buffers, most recent first, with the value of mBufferChangeCounter when
+    // they were last sent, to detect re-imports and learn cycles longer than the cache.
+    std::deque<std::pair<uint64_t /* bufferId */, uint64_t /* lastBufferChange */>>
+            mEvictedBuffers;
+
+    uint32_t mReimportCount = 0;
+    uint32_t mPrefetchCount = 0;
+    uint32_t mPrefetchHitCount = 0;
 };
 
 } // namespace compositionengine::impl
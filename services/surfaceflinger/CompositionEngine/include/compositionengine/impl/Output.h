@@ -20,6 +20,7 @@
 #include <compositionengine/LayerFECompositionState.h>
 #include <compositionengine/Output.h>
 #include <compositionengine/impl/ClientCompositionRequestCache.h>
+#include <compositionengine/impl/CompositionStrategyHistory.h>
 #include <compositionengine/impl/GpuCompositionResult.h>
 #include <compositionengine/impl/HwcAsyncWorker.h>
 #include <compositionengine/impl/OutputCompositionState.h>
@@ -81,8 +82,10 @@ public:
 
     void prepare(const CompositionRefreshArgs&, LayerFESet&) override;
     void present(const CompositionRefreshArgs&) override;
+    bool supportsParallelPresent() override;
 
     void uncacheBuffers(const std::vector<uint64_t>& bufferIdsToUncache) override;
+    void prefetchBuffers(const BuffersToPrefetch& buffersToPrefetch) override;
     void rebuildLayerStacks(const CompositionRefreshArgs&, LayerFESet&) override;
     void collectVisibleLayers(const CompositionRefreshArgs&,
                               compositionengine::Output::CoverageState&) override;
@@ -108,13 +111,20 @@ public:
     bool canPredictCompositionStrategy(const CompositionRefreshArgs&) override;
     void setPredictCompositionStrategy(bool) override;
     void setTreat170mAsSrgb(bool) override;
+    void setIncrementalVisibilityEnabled(bool) override;
 
     // Testing
     const ReleasedLayers& getReleasedLayersForTest() const;
     void setDisplayColorProfileForTest(std::unique_ptr<compositionengine::DisplayColorProfile>);
     void setRenderSurfaceForTest(std::unique_ptr<compositionengine::RenderSurface>);
     bool plannerEnabled() const { return mPlanner != nullptr; }
+    CompositionStrategyHistory& getCompositionStrategyHistoryForTest() {
+        return mCompositionStrategyHistory;
+    }
     virtual bool anyLayersRequireClientComposition() const;
+    // Whether the frame is expected to use client composition, from the layers which require it
+    // and from the strategy HWC chose the last time the output layers were composed.
+    bool expectsClientComposition();
     virtual void updateProtectedContentState();
     virtual bool dequeueRenderBuffer(base::unique_fd*,
                                      std::shared_ptr<renderengine::ExternalTexture>*);
@@ -142,6 +152,7 @@ protected:
     void setExpensiveRenderingExpected(bool enabled) override;
     void setHintSessionGpuFence(std::unique_ptr<FenceTime>&& gpuFence) override;
     bool isPowerHintSessionEnabled() override;
+    void setHintSessionExpectedClientComposition(bool expected) override;
     void dumpBase(std::string&) const;
 
     // Implemented by the final implementation for the final state it uses.
@@ -154,6 +165,12 @@ protected:
 
     bool mustRecompose() const;
 
+    // Computes the visible layers reusing the previous frame's coverage for layers that do not
+    // overlap any layer whose geometry changed. Returns false without modifying any state if the
+    // previous frame's results cannot be reused, such as when the output geometry changed.
+    bool collectVisibleLayersIncrementally(const CompositionRefreshArgs&,
+                                           compositionengine::Output::CoverageState&);
+
     const std::string& getNamePlusId() const { return mNamePlusId; }
 
 private:
@@ -167,6 +184,8 @@ private:
 
     std::string mName;
     std::string mNamePlusId;
+    // Formatted once here rather than on every composeSurfaces call.
+    std::string mHasClientCompositionTraceName;
 
     std::unique_ptr<compositionengine::DisplayColorProfile> mDisplayColorProfile;
     std::unique_ptr<compositionengine::RenderSurface> mRenderSurface;
@@ -177,8 +196,33 @@ private:
     std::unique_ptr<planner::Planner> mPlanner;
     std::unique_ptr<HwcAsyncWorker> mHwComposerAsyncWorker;
 
+    // The strategies HWC chose for recent layer stacks, to predict from.
+    static constexpr size_t kCompositionStrategyHistorySize = 8;
+    CompositionStrategyHistory mCompositionStrategyHistory{kCompositionStrategyHistorySize};
+    // Whether this frame's prediction is for a layer stack other than the previous frame's.
+    bool mPredictingRecalledStrategy = false;
+
     // Whether the content must be recomposed this frame.
     bool mMustRecompose = false;
+
+    // The output geometry the current output layers' visible regions were computed with.
+    struct VisibilityOutputGeometry {
+        ui::Transform transform;
+        Rect layerStackSpaceContent;
+        Rect displaySpaceBounds;
+        ui::LayerFilter layerFilter;
+
+        bool operator==(const VisibilityOutputGeometry& other) const {
+            return transform == other.transform &&
+                    layerStackSpaceContent == other.layerStackSpaceContent &&
+                    displaySpaceBounds == other.displaySpaceBounds &&
+                    layerFilter.layerStack == other.layerFilter.layerStack &&
+                    layerFilter.toInternalDisplay == other.layerFilter.toInternalDisplay;
+        }
+        bool operator!=(const VisibilityOutputGeometry& other) const { return !(*this == other); }
+    };
+    bool mIncrementalVisibilityEnabled = false;
+    std::optional<VisibilityOutputGeometry> mVisibilityOutputGeometry;
 };
 
 // This template factory function standardizes the implementation details of the
@@ -118,6 +118,8 @@ struct OutputCompositionState {
     // Current target dataspace
     ui::Dataspace targetDataspace{ui::Dataspace::UNKNOWN};
 
+    // The strategy HWC chose for the previous frame, replaced by the one predicted for this frame
+    // when composition strategy prediction is enabled.
     std::optional<android::HWComposer::DeviceRequestedChanges> previousDeviceRequestedChanges{};
 
     bool previousDeviceRequestedSuccess = false;
@@ -167,6 +169,15 @@ struct OutputCompositionState {
     uint64_t lastOutputLayerHash = 0;
     uint64_t outputLayerHash = 0;
 
+    // Set from CompositionRefreshArgs::recordLayerCosts for the current frame.
+    bool recordLayerCosts = false;
+
+    // Costs of the last frame, only recorded if recordLayerCosts is set. The render engine start
+    // time is when the client composition was submitted, or 0 if nothing was drawn.
+    nsecs_t renderEngineStartTime = 0;
+    nsecs_t hwcValidateDuration = 0;
+    nsecs_t hwcPresentDuration = 0;
+
     // Debugging
     void dump(std::string& result) const;
 };
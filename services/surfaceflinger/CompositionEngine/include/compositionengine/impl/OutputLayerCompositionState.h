@@ -100,6 +100,25 @@ struct OutputLayerCompositionState {
     // order to save power.
     Region outputSpaceBlockingRegionHint;
 
+    // The layer state the coverage regions above were computed from. Only set if incremental
+    // visibility is enabled on the output, in which case the regions are reused by later frames
+    // as long as neither this layer nor any layer overlapping it changes.
+    struct VisibilityInputs {
+        ui::Transform geomLayerTransform;
+        FloatRect geomLayerBounds;
+        float shadowRadius{0.f};
+        bool isOpaque{false};
+        Region transparentRegionHint;
+        aidl::android::hardware::graphics::composer3::Composition compositionType{
+                aidl::android::hardware::graphics::composer3::Composition::INVALID};
+
+        // The footprint of the layer including its shadow, and the opaque portion of it, in
+        // layer stack space.
+        Rect footprint;
+        Rect opaqueRect;
+    };
+    std::optional<VisibilityInputs> visibilityInputs;
+
     // Overrides the buffer, acquire fence, and display frame stored in LayerFECompositionState
     struct {
         std::shared_ptr<renderengine::ExternalTexture> buffer = nullptr;
@@ -163,6 +182,10 @@ struct OutputLayerCompositionState {
     // Timestamp for when the layer is queued for client composition
     nsecs_t clientCompositionTimestamp{0};
 
+    // Main thread time spent on the layer in the last frame of the output. Only recorded if
+    // OutputCompositionState::recordLayerCosts is set.
+    nsecs_t cpuCost{0};
+
     static constexpr float kDefaultWhitePointNits = 200.f;
     float whitePointNits = kDefaultWhitePointNits;
     // Dimming ratio of the layer from [0, 1]
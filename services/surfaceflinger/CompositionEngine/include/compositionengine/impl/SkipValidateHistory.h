@@ -0,0 +1,86 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utils/Timers.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+
+namespace android::compositionengine::impl {
+
+// Remembers whether presentOrValidate presented the most recently composed layer stacks of a
+// display, keyed by OutputCompositionState::outputLayerHash. A successful presentOrValidate saves
+// a HWC round trip, while a failed one costs about as much as validating, so the display attempts
+// it whenever the layer stack was presented by most recent attempts, and otherwise goes straight
+// to validate.
+class SkipValidateHistory {
+public:
+    // Number of most recent attempts a prediction is based on.
+    static constexpr uint8_t kOutcomeCount = 8;
+    // A layer stack predicted to fail is still attempted once every this many frames, so that the
+    // prediction recovers if HWC starts accepting it.
+    static constexpr uint32_t kRetryInterval = 16;
+
+    explicit SkipValidateHistory(size_t capacity) : mCapacity(capacity) {}
+
+    // Returns whether presentOrValidate should be attempted for the layer stack.
+    bool shouldAttempt(uint64_t layerStackHash);
+    // Records whether presentOrValidate presented the layer stack.
+    void recordAttempt(uint64_t layerStackHash, bool presented);
+    // Records how long a present that followed validate took, which is the round trip that a
+    // successful presentOrValidate saves.
+    void recordPresentDuration(nsecs_t duration);
+
+    void clear() { mEntries.clear(); }
+    size_t size() const { return mEntries.size(); }
+
+    struct Stats {
+        size_t attempts = 0;
+        size_t successes = 0;
+        // Frames that went straight to validate because presentOrValidate was predicted to fail.
+        size_t avoided = 0;
+        nsecs_t latencySaved = 0;
+    };
+    const Stats& getStats() const { return mStats; }
+
+    void dump(std::string& out) const;
+
+private:
+    struct Entry {
+        // Most recent outcome in the lowest bit, set if presentOrValidate presented.
+        uint8_t outcomes = 0;
+        uint8_t outcomeCount = 0;
+        uint32_t framesSinceAttempt = 0;
+    };
+
+    // Returns the entry of the layer stack, marking it most recently used, or nullptr if there is
+    // none. The pointer is invalidated by the next call to a non-const method.
+    Entry* get(uint64_t layerStackHash);
+
+    const size_t mCapacity;
+
+    // Most recently used first.
+    std::deque<std::pair<uint64_t /* layerStackHash */, Entry>> mEntries;
+
+    std::optional<nsecs_t> mPresentDuration;
+    Stats mStats;
+};
+
+} // namespace android::compositionengine::impl
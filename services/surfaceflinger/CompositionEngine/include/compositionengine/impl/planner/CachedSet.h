@@ -23,6 +23,7 @@
 #include <renderengine/RenderEngine.h>
 
 #include <chrono>
+#include <optional>
 
 namespace android {
 
@@ -46,6 +47,9 @@ public:
         const sp<GraphicBuffer>& getBuffer() const {
             return mState->getOutputLayer()->getLayerFE().getCompositionState()->buffer;
         }
+        uint64_t getFrameNumber() const {
+            return mState->getOutputLayer()->getLayerFE().getCompositionState()->frameNumber;
+        }
         int64_t getFramesSinceBufferUpdate() const { return mState->getFramesSinceBufferUpdate(); }
         NonBufferHash getHash() const { return mHash; }
         std::chrono::steady_clock::time_point getLastUpdate() const { return mLastUpdate; }
@@ -65,9 +69,8 @@ public:
     size_t getLayerCount() const { return mLayers.size(); }
     const Layer& getFirstLayer() const { return mLayers[0]; }
     const Rect& getBounds() const { return mBounds; }
-    Rect getTextureBounds() const {
-        return mTexture ? mTexture->get()->getBuffer()->getBounds() : Rect::INVALID_RECT;
-    }
+    // The framebuffer space rect the rendered texture covers.
+    Rect getTextureBounds() const { return mTexture ? mTextureBounds : Rect::INVALID_RECT; }
     const Region& getVisibleRegion() const { return mVisibleRegion; }
     size_t getAge() const { return mAge; }
     std::shared_ptr<renderengine::ExternalTexture> getBuffer() const {
@@ -114,8 +117,15 @@ public:
     size_t getSkipCount() { return mSkipCount; }
 
     // Renders the cached set with the supplied output composition state.
+    // If `previous` was rendered from the same layers with the same geometry, only the tiles of
+    // the texture covering layers whose buffers changed since are rendered, and the rest is copied
+    // from the texture of `previous`.
     void render(renderengine::RenderEngine& re, TexturePool& texturePool,
-                const OutputCompositionState& outputState, bool deviceHandlesColorTransform);
+                const OutputCompositionState& outputState, bool deviceHandlesColorTransform,
+                const CachedSet* previous = nullptr);
+
+    // Whether the last render only rendered the tiles that changed since the previous one.
+    bool wasPartiallyRendered() const { return mPartiallyRendered; }
 
     void dump(std::string& result) const;
 
@@ -153,6 +163,22 @@ public:
     bool cachingHintExcludesLayers() const;
 
 private:
+    // Returns the framebuffer space rect to render into a texture smaller than the display, or
+    // nullopt if the layers must be rendered into a display-sized texture.
+    std::optional<Rect> getPartialTextureBounds(const TexturePool&,
+                                                const OutputCompositionState&) const;
+
+    // Returns the framebuffer space region of the texture that needs to be rendered again since
+    // `previous` was rendered with `displaySettings`, aligned to tiles of kDirtyTileSize, or
+    // nullopt if all of it does.
+    std::optional<Region> getDirtyRegionSince(const CachedSet& previous,
+                                              const OutputCompositionState&,
+                                              const renderengine::DisplaySettings& displaySettings,
+                                              const Rect& textureBounds) const;
+
+    static constexpr int32_t kDirtyTileSize = 64;
+    static constexpr size_t kMaxDirtyRects = 4;
+
     const NonBufferHash mFingerprint;
     std::chrono::steady_clock::time_point mLastUpdate = std::chrono::steady_clock::now();
     std::vector<Layer> mLayers;
@@ -168,11 +194,23 @@ private:
     // TODO(b/190411067): This is a shared pointer only because CachedSets are copied into different
     // containers in the Flattener. Logically this should have unique ownership otherwise.
     std::shared_ptr<TexturePool::AutoTexture> mTexture;
+    Rect mTextureBounds = Rect::INVALID_RECT;
     sp<Fence> mDrawFence;
     ProjectionSpace mOutputSpace;
     ui::Dataspace mOutputDataspace;
     ui::Transform::RotationFlags mOrientation = ui::Transform::ROT_0;
 
+    // What the texture was rendered from, to find what changed since.
+    struct RenderedLayer {
+        int32_t id;
+        size_t hash;
+        uint64_t bufferId;
+        uint64_t frameNumber;
+    };
+    std::vector<RenderedLayer> mRenderedLayers;
+    renderengine::DisplaySettings mRenderedDisplaySettings;
+    bool mPartiallyRendered = false;
+
     static const bool sDebugHighlighLayers;
 };
 
@@ -18,6 +18,7 @@
 
 #include <compositionengine/Output.h>
 #include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/FlattenerCostModel.h>
 #include <compositionengine/impl/planner/LayerState.h>
 
 #include <chrono>
@@ -225,7 +226,13 @@ private:
 
     std::vector<Run> findCandidateRuns(std::chrono::steady_clock::time_point now) const;
 
-    std::optional<Run> findBestRun(std::vector<Run>& runs) const;
+    // Estimates the savings of flattening the run with mCostModel.
+    FlattenerCostModel::Estimate estimateRun(const Run& run,
+                                             std::chrono::steady_clock::time_point now) const;
+
+    // Returns the run with the largest estimated savings, or nullopt if none saves anything.
+    std::optional<Run> findBestRun(std::vector<Run>& runs,
+                                   std::chrono::steady_clock::time_point now) const;
 
     void buildCachedSets(std::chrono::steady_clock::time_point now);
 
@@ -246,6 +253,14 @@ private:
 
     std::vector<CachedSet> mLayers;
 
+    FlattenerCostModel mCostModel;
+    // When mNewCachedSet was queued for rendering, to learn how long the GPU takes.
+    nsecs_t mNewCachedSetRenderStart = 0;
+
+    // The most recently decomposed cached set, whose texture may be partially reused to render the
+    // next cached set.
+    std::optional<CachedSet> mDecomposedCachedSet;
+
     // Statistics
     size_t mUnflattenedDisplayCost = 0;
     size_t mFlattenedDisplayCost = 0;
@@ -253,6 +268,8 @@ private:
     std::unordered_map<size_t, size_t> mFinalLayerCounts;
     size_t mCachedSetCreationCount = 0;
     size_t mCachedSetCreationCost = 0;
+    size_t mFullCachedSetRenderCount = 0;
+    size_t mPartialCachedSetRenderCount = 0;
     std::unordered_map<size_t, size_t> mInvalidatedCachedSetAges;
 };
 
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <compositionengine/impl/planner/CachedSet.h>
+#include <utils/Timers.h>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace android::compositionengine::impl::planner {
+using namespace std::chrono_literals;
+
+// Estimates whether flattening layers into a cached set pays off. All costs are expressed as bytes
+// of memory traffic: the DPU saves bandwidth on every frame the cached set is displayed instead of
+// its layers, and pays once for the GPU to render it. GPU time is converted to an equivalent
+// amount of traffic, and the number of frames the savings accrue over is predicted from how long
+// the layers have been idle and the frame rate LayerHistory measured for them.
+class FlattenerCostModel {
+public:
+    // Fixed cost of each layer the DPU composes, such as fetching its metadata and keeping a pipe
+    // powered, which merging layers saves regardless of their size.
+    static constexpr int64_t kLayerOverheadBytes = 64 * 1024;
+    // Rough energy equivalent of one nanosecond of GPU work in memory traffic.
+    static constexpr int64_t kGpuBusyBytesPerNs = 32;
+    // Assumes that rendering a screen-sized cached set of two layers takes about 1.5ms. See
+    // Flattener::Tunables::RenderScheduling::kDefaultCachedSetRenderDuration.
+    static constexpr float kDefaultGpuNsPerPixel = 0.3f;
+    static constexpr std::chrono::nanoseconds kDefaultFrameInterval = 16'666'667ns;
+    // Longer predictions are too unreliable to justify rendering anything.
+    static constexpr std::chrono::nanoseconds kMaxExpectedIdle = 10s;
+
+    struct Estimate {
+        // DPU traffic saved on each frame the cached set is displayed instead of its layers.
+        int64_t frameSavings = 0;
+        // One-off cost of rendering the cached set.
+        int64_t renderCost = 0;
+        // How long the layers are expected to remain unchanged.
+        std::chrono::nanoseconds expectedIdle = 0ns;
+
+        int64_t netSavings = 0;
+    };
+
+    // Records that a frame was composed, to learn how often frames are composed.
+    void recordFrame(std::chrono::steady_clock::time_point now);
+
+    // Estimates the savings of flattening the cached sets into one.
+    Estimate estimate(const std::vector<const CachedSet*>& sets,
+                      std::chrono::steady_clock::time_point now) const;
+
+    // Records the prediction made for a new cached set.
+    void recordPredictedSavings(const Estimate& estimate);
+    // Records that a rendered cached set was displayed for a frame instead of its layers.
+    void recordDisplayedFrame(const CachedSet& cachedSet);
+    // Records the cost of rendering the cached set, learning the GPU cost from its draw fence if
+    // it has signaled. `renderStart` is the time rendering was queued.
+    void recordRender(const CachedSet& cachedSet, nsecs_t renderStart);
+
+    std::chrono::nanoseconds getFrameInterval() const { return mFrameInterval; }
+    float getGpuNsPerPixel() const { return mGpuNsPerPixel; }
+    int64_t getPredictedSavings() const { return mPredictedSavings; }
+    int64_t getRealizedSavings() const { return mRealizedSavings; }
+
+    void dump(std::string& result) const;
+
+private:
+    static int64_t getLayerBytes(const CachedSet::Layer& layer);
+    static int64_t getFrameSavings(const std::vector<const CachedSet*>& sets,
+                                   const Rect& textureBounds);
+    static std::chrono::nanoseconds getExpectedIdle(const CachedSet& cachedSet,
+                                                    std::chrono::steady_clock::time_point now);
+    int64_t getRenderCost(const std::vector<const CachedSet*>& sets, const Rect& textureBounds,
+                          std::optional<std::chrono::nanoseconds> gpuDuration) const;
+
+    std::optional<std::chrono::steady_clock::time_point> mLastFrameTime;
+    std::chrono::nanoseconds mFrameInterval = kDefaultFrameInterval;
+
+    float mGpuNsPerPixel = kDefaultGpuNsPerPixel;
+    size_t mMeasuredRenderCount = 0;
+
+    size_t mPredictionCount = 0;
+    int64_t mPredictedSavings = 0;
+    int64_t mRealizedSavings = 0;
+};
+
+} // namespace android::compositionengine::impl::planner
@@ -27,12 +27,13 @@
 
 namespace android::compositionengine::impl::planner {
 
-// A pool of textures that only manages textures of a single size.
-// While it is possible to define a texture pool supporting variable-sized textures to save on
-// memory, it is a simpler implementation to only manage screen-sized textures. The texture pool is
-// unbounded - there are a minimum number of textures preallocated. Under heavy system load, new
-// textures may be allocated, but only a maximum number of retained once those textures are no
-// longer necessary.
+// A pool of textures for rendering cached sets into.
+// Screen-sized textures are pooled separately from smaller ones: there are a minimum number of
+// screen-sized textures preallocated, and under heavy system load new textures may be allocated,
+// but only a maximum number of retained once those textures are no longer necessary.
+// Cached sets that only cover part of the screen can borrow a smaller texture instead. Their sizes
+// are rounded up to power-of-two dimensions, so that textures can be reused by cached sets of
+// similar sizes, and a few of the most recently returned ones are retained.
 class TexturePool {
 public:
     // RAII class helping with managing textures from the texture pool
@@ -79,6 +80,13 @@ public:
     // to the pool.
     std::shared_ptr<AutoTexture> borrowTexture();
 
+    // Returns the size of the smallest texture the pool hands out that fits `minSize`, which is
+    // at most the display size.
+    ui::Size getTextureSize(ui::Size minSize) const;
+
+    // Borrows a texture of `size`, which must have been returned by getTextureSize.
+    std::shared_ptr<AutoTexture> borrowTexture(ui::Size size);
+
     // Enables or disables the pool. When the pool is disabled, no buffers will
     // be held by the pool. This is useful when the active display changes.
     void setEnabled(bool enable);
@@ -89,16 +97,21 @@ protected:
     // Proteted visibility so that they can be used for testing
     const static constexpr size_t kMinPoolSize = 3;
     const static constexpr size_t kMaxPoolSize = 4;
+    const static constexpr size_t kMaxTilePoolSize = 4;
+    const static constexpr int32_t kMinTileDimension = 64;
 
     struct Entry {
         std::shared_ptr<renderengine::ExternalTexture> texture;
         sp<Fence> fence;
     };
 
+    // Screen-sized textures.
     std::deque<Entry> mPool;
+    // Smaller textures of any size, most recently returned last.
+    std::deque<Entry> mTilePool;
 
 private:
-    std::shared_ptr<renderengine::ExternalTexture> genTexture();
+    std::shared_ptr<renderengine::ExternalTexture> genTexture(ui::Size size);
     // Returns a previously borrowed texture to the pool.
     void returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
                        const sp<Fence>& fence);
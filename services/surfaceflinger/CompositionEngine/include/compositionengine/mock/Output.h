@@ -81,8 +81,10 @@ public:
 
     MOCK_METHOD2(prepare, void(const compositionengine::CompositionRefreshArgs&, LayerFESet&));
     MOCK_METHOD1(present, void(const compositionengine::CompositionRefreshArgs&));
+    MOCK_METHOD0(supportsParallelPresent, bool());
 
     MOCK_METHOD1(uncacheBuffers, void(const std::vector<uint64_t>&));
+    MOCK_METHOD1(prefetchBuffers, void(const BuffersToPrefetch&));
     MOCK_METHOD2(rebuildLayerStacks,
                  void(const compositionengine::CompositionRefreshArgs&, LayerFESet&));
     MOCK_METHOD2(collectVisibleLayers,
@@ -131,8 +133,10 @@ public:
     MOCK_METHOD1(canPredictCompositionStrategy, bool(const CompositionRefreshArgs&));
     MOCK_METHOD1(setPredictCompositionStrategy, void(bool));
     MOCK_METHOD1(setTreat170mAsSrgb, void(bool));
+    MOCK_METHOD1(setIncrementalVisibilityEnabled, void(bool));
     MOCK_METHOD(void, setHintSessionGpuFence, (std::unique_ptr<FenceTime> && gpuFence));
     MOCK_METHOD(bool, isPowerHintSessionEnabled, ());
+    MOCK_METHOD(void, setHintSessionExpectedClientComposition, (bool expected));
 };
 
 } // namespace android::compositionengine::mock
@@ -36,6 +36,7 @@ public:
     MOCK_METHOD1(setHwcLayer, void(std::shared_ptr<HWC2::Layer>));
 
     MOCK_METHOD1(uncacheBuffers, void(const std::vector<uint64_t>&));
+    MOCK_METHOD1(prefetchBuffers, void(const std::vector<sp<GraphicBuffer>>&));
 
     MOCK_CONST_METHOD0(getOutput, const compositionengine::Output&());
     MOCK_CONST_METHOD0(getLayerFE, compositionengine::LayerFE&());
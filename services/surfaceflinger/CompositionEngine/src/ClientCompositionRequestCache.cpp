@@ -15,7 +15,9 @@
  */
 
 #include <algorithm>
+#include <cinttypes>
 
+#include <android-base/stringprintf.h>
 #include <compositionengine/impl/ClientCompositionRequestCache.h>
 #include <renderengine/DisplaySettings.h>
 #include <renderengine/LayerSettings.h>
@@ -88,31 +90,35 @@ bool ClientCompositionRequestCache::ClientCompositionRequest::equals(
 
 bool ClientCompositionRequestCache::exists(
         uint64_t bufferId, const renderengine::DisplaySettings& display,
-        const std::vector<LayerFE::LayerSettings>& layerSettings) const {
-    for (const auto& [cachedBufferId, cachedRequest] : mCache) {
-        if (cachedBufferId == bufferId) {
-            return cachedRequest.equals(display, layerSettings);
+        const std::vector<LayerFE::LayerSettings>& layerSettings) {
+    for (auto it = mCache.begin(); it != mCache.end(); it++) {
+        if (it->first != bufferId) {
+            continue;
+        }
+        if (!it->second.equals(display, layerSettings)) {
+            break;
         }
+        mStats.hits++;
+        if (std::next(it) != mCache.end()) {
+            auto entry = std::move(*it);
+            mCache.erase(it);
+            mCache.push_back(std::move(entry));
+        }
+        return true;
     }
+    mStats.misses++;
     return false;
 }
 
 void ClientCompositionRequestCache::add(uint64_t bufferId,
                                         const renderengine::DisplaySettings& display,
                                         const std::vector<LayerFE::LayerSettings>& layerSettings) {
-    const ClientCompositionRequest request(display, layerSettings);
-    for (auto& [cachedBufferId, cachedRequest] : mCache) {
-        if (cachedBufferId == bufferId) {
-            cachedRequest = std::move(request);
-            return;
-        }
-    }
-
+    remove(bufferId);
     if (mCache.size() >= mMaxCacheSize) {
         mCache.pop_front();
     }
 
-    mCache.emplace_back(bufferId, std::move(request));
+    mCache.emplace_back(bufferId, ClientCompositionRequest(display, layerSettings));
 }
 
 void ClientCompositionRequestCache::remove(uint64_t bufferId) {
@@ -124,4 +130,15 @@ void ClientCompositionRequestCache::remove(uint64_t bufferId) {
     }
 }
 
+void ClientCompositionRequestCache::dump(std::string& out) const {
+    const size_t lookups = mStats.hits + mStats.misses;
+    const float hitRate = lookups == 0
+            ? 0.f
+            : 100.f * static_cast<float>(mStats.hits) / static_cast<float>(lookups);
+    base::StringAppendF(&out,
+                        "   Client composition cache: %zu/%zu hits (%.1f%%), %zu/%" PRIu32
+                        " buffers\n",
+                        mStats.hits, lookups, hitRate, mCache.size(), mMaxCacheSize);
+}
+
 } // namespace android::compositionengine::impl
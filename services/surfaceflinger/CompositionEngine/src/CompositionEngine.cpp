@@ -20,10 +20,18 @@
 #include <compositionengine/OutputLayer.h>
 #include <compositionengine/impl/CompositionEngine.h>
 #include <compositionengine/impl/Display.h>
+#include <compositionengine/impl/HwcAsyncWorker.h>
 
+#include <android-base/stringprintf.h>
 #include <renderengine/RenderEngine.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -98,16 +106,124 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
         // latchedLayers is used to track the set of front-end layer state that
         // has been latched across all outputs for the prepare step, and is not
         // needed for anything else.
-        LayerFESet latchedLayers;
+        LayerFESet latchedLayers(0, LayerFESpHash(), std::equal_to<sp<LayerFE>>(),
+                                 FrameArenaAllocator<sp<LayerFE>>(&mFrameArena));
 
         for (const auto& output : args.outputs) {
             output->prepare(args, latchedLayers);
         }
     }
 
-    for (const auto& output : args.outputs) {
-        output->present(args);
+    if (args.parallelPresent && args.outputs.size() > 1) {
+        presentOutputsInParallel(args);
+    } else {
+        for (const auto& output : args.outputs) {
+            output->present(args);
+        }
+    }
+
+    mFrameArena.reset();
+}
+
+void CompositionEngine::presentOutputsInParallel(CompositionRefreshArgs& args) {
+    ATRACE_CALL();
+
+    // Outputs that share a layer are presented in order on the same thread, as presenting an
+    // output updates the state of its layers. So are outputs that are not safe to present
+    // concurrently, which are presented on the main thread.
+    const size_t outputCount = args.outputs.size();
+    std::vector<size_t> parents(outputCount);
+    std::iota(parents.begin(), parents.end(), 0);
+    const auto find = [&parents](size_t index) {
+        while (parents[index] != index) {
+            index = parents[index] = parents[parents[index]];
+        }
+        return index;
+    };
+    const auto unite = [&](size_t a, size_t b) {
+        const size_t rootA = find(a);
+        const size_t rootB = find(b);
+        parents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+    };
+
+    std::optional<size_t> mainThreadOutput;
+    std::unordered_map<const LayerFE*, size_t> layerOwners;
+    for (size_t i = 0; i < outputCount; i++) {
+        const auto& output = args.outputs[i];
+        if (!output->supportsParallelPresent()) {
+            if (mainThreadOutput) {
+                unite(*mainThreadOutput, i);
+            } else {
+                mainThreadOutput = i;
+            }
+        }
+        for (const auto* layer : output->getOutputLayersOrderedByZ()) {
+            const auto [it, inserted] = layerOwners.emplace(&layer->getLayerFE(), i);
+            if (!inserted) {
+                unite(it->second, i);
+            }
+        }
+    }
+
+    std::vector<std::vector<compositionengine::Output*>> groups;
+    std::unordered_map<size_t, size_t> groupIndices;
+    if (mainThreadOutput) {
+        groupIndices.emplace(find(*mainThreadOutput), 0);
+        groups.emplace_back();
+    }
+    for (size_t i = 0; i < outputCount; i++) {
+        const auto [it, inserted] = groupIndices.emplace(find(i), groups.size());
+        if (inserted) {
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(args.outputs[i].get());
+    }
+
+    if (groups.size() == 1) {
+        for (auto* output : groups.front()) {
+            output->present(args);
+        }
+        return;
+    }
+
+    while (mPresentWorkers.size() < groups.size() - 1) {
+        mPresentWorkers.push_back(std::make_unique<HwcAsyncWorker>());
     }
+
+    // Each group records how long it took, to measure the time saved on the main thread.
+    std::vector<nsecs_t> durations(groups.size());
+    const auto presentGroup = [&](size_t index) {
+        const nsecs_t start = systemTime();
+        for (auto* output : groups[index]) {
+            output->present(args);
+        }
+        durations[index] = systemTime() - start;
+        return true;
+    };
+
+    const nsecs_t start = systemTime();
+    std::vector<std::future<bool>> presentFutures;
+    presentFutures.reserve(groups.size() - 1);
+    for (size_t i = 1; i < groups.size(); i++) {
+        presentFutures.push_back(mPresentWorkers[i - 1]->send([&presentGroup, i] {
+            ATRACE_NAME("present outputs in parallel");
+            return presentGroup(i);
+        }));
+    }
+    presentGroup(0);
+    {
+        ATRACE_NAME("wait for parallel present");
+        for (auto& future : presentFutures) {
+            future.get();
+        }
+    }
+    const nsecs_t elapsed = systemTime() - start;
+
+    const nsecs_t serialDuration = std::accumulate(durations.begin(), durations.end(), nsecs_t{0});
+    const nsecs_t timeSaved = std::max(serialDuration - elapsed, nsecs_t{0});
+    mParallelPresentStats.frames++;
+    mParallelPresentStats.timeSaved += timeSaved;
+    ATRACE_INT64("ParallelPresentTimeSaved", timeSaved);
 }
 
 void CompositionEngine::updateCursorAsync(CompositionRefreshArgs& args) {
@@ -144,8 +260,13 @@ FeatureFlags CompositionEngine::getFeatureFlags() const {
     return {};
 }
 
-void CompositionEngine::dump(std::string&) const {
-    // The base class has no state to dump, but derived classes might.
+void CompositionEngine::dump(std::string& result) const {
+    mFrameArena.dump(result);
+
+    base::StringAppendF(&result,
+                        "Parallel output present: %zu frames, %.3f ms of main thread time saved\n",
+                        mParallelPresentStats.frames,
+                        static_cast<double>(mParallelPresentStats.timeSaved) / 1e6);
 }
 
 void CompositionEngine::setNeedsAnotherUpdateForTest(bool value) {
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/impl/CompositionStrategyHistory.h>
+
+namespace android::compositionengine::impl {
+
+namespace {
+float percent(size_t count, size_t total) {
+    return total == 0 ? 0.f : 100.f * static_cast<float>(count) / static_cast<float>(total);
+}
+} // namespace
+
+const CompositionStrategyHistory::Strategy* CompositionStrategyHistory::get(
+        uint64_t layerStackHash) {
+    const auto it = std::find_if(mStrategies.begin(), mStrategies.end(),
+                                 [layerStackHash](const auto& entry) {
+                                     return entry.first == layerStackHash;
+                                 });
+    if (it == mStrategies.end()) {
+        return nullptr;
+    }
+    if (it != mStrategies.begin()) {
+        auto entry = std::move(*it);
+        mStrategies.erase(it);
+        mStrategies.push_front(std::move(entry));
+    }
+    return &mStrategies.front().second;
+}
+
+void CompositionStrategyHistory::record(uint64_t layerStackHash, Strategy strategy) {
+    const auto it = std::find_if(mStrategies.begin(), mStrategies.end(),
+                                 [layerStackHash](const auto& entry) {
+                                     return entry.first == layerStackHash;
+                                 });
+    if (it != mStrategies.end()) {
+        mStrategies.erase(it);
+    } else if (mStrategies.size() >= mCapacity) {
+        mStrategies.pop_back();
+    }
+    mStrategies.emplace_front(layerStackHash, std::move(strategy));
+}
+
+void CompositionStrategyHistory::recordPrediction(bool succeeded, bool recalled) {
+    mStats.predictions++;
+    mStats.hits += succeeded;
+    if (recalled) {
+        mStats.recalledPredictions++;
+        mStats.recalledHits += succeeded;
+    }
+}
+
+void CompositionStrategyHistory::dump(std::string& out) const {
+    base::StringAppendF(&out,
+                        "   Composition strategy prediction: %zu/%zu hits (%.1f%%), recalled layer "
+                        "stacks %zu/%zu hits (%.1f%%), %zu layer stacks recorded\n",
+                        mStats.hits, mStats.predictions, percent(mStats.hits, mStats.predictions),
+                        mStats.recalledHits, mStats.recalledPredictions,
+                        percent(mStats.recalledHits, mStats.recalledPredictions),
+                        mStrategies.size());
+}
+
+} // namespace android::compositionengine::impl
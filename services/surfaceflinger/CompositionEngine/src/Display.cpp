@@ -138,6 +138,10 @@ void Display::dump(std::string& out) const {
 
     out.append("\n   Composition Display State:\n");
     Output::dumpBase(out);
+
+    if (mPredictSkipValidate) {
+        mSkipValidateHistory.dump(out);
+    }
 }
 
 void Display::createDisplayColorProfile(const DisplayColorProfileCreationArgs& args) {
@@ -153,6 +157,22 @@ void Display::createClientCompositionCache(uint32_t cacheSize) {
     cacheClientCompositionRequests(cacheSize);
 }
 
+void Display::setPredictSkipValidate(bool predict) {
+    mPredictSkipValidate = predict;
+    if (!mPredictSkipValidate) {
+        mSkipValidateHistory.clear();
+    }
+}
+
+void Display::setHwcBufferCacheTracking(bool tracking) {
+    mHwcBufferCacheTracking = tracking;
+    for (auto* outputLayer : getOutputLayersOrderedByZ()) {
+        if (auto& hwcState = outputLayer->editState().hwc) {
+            hwcState->hwcBufferCache.setTracking(tracking);
+        }
+    }
+}
+
 std::unique_ptr<compositionengine::OutputLayer> Display::createOutputLayer(
         const sp<compositionengine::LayerFE>& layerFE) const {
     auto outputLayer = impl::createOutputLayer(*this, layerFE);
@@ -164,6 +184,9 @@ std::unique_ptr<compositionengine::OutputLayer> Display::createOutputLayer(
         ALOGE_IF(!hwcLayer, "Failed to create a HWC layer for a HWC supported display %s",
                  getName().c_str());
         outputLayer->setHwcLayer(std::move(hwcLayer));
+        if (auto& hwcState = outputLayer->editState().hwc) {
+            hwcState->hwcBufferCache.setTracking(mHwcBufferCacheTracking);
+        }
     }
     return outputLayer;
 }
@@ -258,18 +281,38 @@ bool Display::chooseCompositionStrategy(
         mPowerAdvisor->setRequiresClientComposition(mId, requiresClientComposition);
     }
 
+    using SkipValidatePolicy = android::HWComposer::SkipValidatePolicy;
+    const uint64_t layerStackHash = getState().outputLayerHash;
+    auto skipValidatePolicy = SkipValidatePolicy::Default;
+    if (mPredictSkipValidate && !requiresClientComposition) {
+        skipValidatePolicy = mSkipValidateHistory.shouldAttempt(layerStackHash)
+                ? SkipValidatePolicy::Attempt
+                : SkipValidatePolicy::Avoid;
+    }
+
     const TimePoint hwcValidateStartTime = TimePoint::now();
 
     if (status_t result =
                 hwc.getDeviceCompositionChanges(*halDisplayId, requiresClientComposition,
                                                 getState().earliestPresentTime,
-                                                getState().expectedPresentTime, outChanges);
+                                                getState().expectedPresentTime, skipValidatePolicy,
+                                                outChanges);
         result != NO_ERROR) {
         ALOGE("chooseCompositionStrategy failed for %s: %d (%s)", getName().c_str(), result,
               strerror(-result));
         return false;
     }
 
+    // This may run on the HWC worker thread, while the main thread does not access the field.
+    if (getState().recordLayerCosts) {
+        editState().hwcValidateDuration = (TimePoint::now() - hwcValidateStartTime).ns();
+    }
+
+    if (skipValidatePolicy == SkipValidatePolicy::Attempt) {
+        mSkipValidateHistory.recordAttempt(layerStackHash,
+                                           hwc.getValidateSkipped(*halDisplayId));
+    }
+
     if (isPowerHintSessionEnabled()) {
         mPowerAdvisor->setHwcValidateTiming(mId, hwcValidateStartTime, TimePoint::now());
         if (auto halDisplayId = HalDisplayId::tryCast(mId)) {
@@ -378,6 +421,7 @@ compositionengine::Output::FrameFences Display::presentAndGetFrameFences() {
     auto& hwc = getCompositionEngine().getHwComposer();
 
     const TimePoint startTime = TimePoint::now();
+    const auto presentStartTime = std::chrono::steady_clock::now();
 
     if (isPowerHintSessionEnabled() && getState().earliestPresentTime) {
         mPowerAdvisor->setHwcPresentDelayedTime(mId, *getState().earliestPresentTime);
@@ -385,6 +429,19 @@ compositionengine::Output::FrameFences Display::presentAndGetFrameFences() {
 
     hwc.presentAndGetReleaseFences(*halDisplayIdOpt, getState().earliestPresentTime);
 
+    // Waiting for the earliest present time is not part of the round trip.
+    const auto roundTripStartTime =
+            std::max(presentStartTime, getState().earliestPresentTime.value_or(presentStartTime));
+    const nsecs_t roundTripDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now() - roundTripStartTime)
+                                              .count();
+    if (mPredictSkipValidate && !hwc.getValidateSkipped(*halDisplayIdOpt)) {
+        mSkipValidateHistory.recordPresentDuration(roundTripDuration);
+    }
+    if (getState().recordLayerCosts) {
+        editState().hwcPresentDuration = roundTripDuration;
+    }
+
     if (isPowerHintSessionEnabled()) {
         mPowerAdvisor->setHwcPresentTiming(mId, startTime, TimePoint::now());
     }
@@ -406,6 +463,12 @@ compositionengine::Output::FrameFences Display::presentAndGetFrameFences() {
     return fences;
 }
 
+bool Display::supportsParallelPresent() {
+    // HWC displays share the composer's command reader, and the power advisor's per-display timing
+    // is not thread safe, so only GPU virtual displays are presented concurrently.
+    return GpuVirtualDisplayId::tryCast(mId) && !isPowerHintSessionEnabled();
+}
+
 void Display::setExpensiveRenderingExpected(bool enabled) {
     Output::setExpensiveRenderingExpected(enabled);
 
@@ -422,6 +485,10 @@ void Display::setHintSessionGpuFence(std::unique_ptr<FenceTime>&& gpuFence) {
     mPowerAdvisor->setGpuFenceTime(mId, std::move(gpuFence));
 }
 
+void Display::setHintSessionExpectedClientComposition(bool expected) {
+    mPowerAdvisor->setExpectedClientComposition(mId, expected);
+}
+
 void Display::finishFrame(GpuCompositionResult&& result) {
     // We only need to actually compose the display if:
     // 1) It is being handled by hardware composer, which may need this to
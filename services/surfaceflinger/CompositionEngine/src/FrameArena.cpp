@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/FrameArena.h>
+
+namespace android::compositionengine {
+
+FrameArena::FrameArena(size_t initialBlockSize) {
+    addBlock(initialBlockSize);
+    // The initial block is not part of any frame.
+    mStats.heapAllocationsThisFrame = 0;
+}
+
+FrameArena::~FrameArena() = default;
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        Block& block = mBlocks[mCurrentBlock];
+        const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+        const uintptr_t aligned = (base + mOffset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        const size_t end = static_cast<size_t>(aligned - base) + bytes;
+        if (end <= block.size) {
+            mBytesUsed += end - mOffset;
+            mOffset = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Account for the unused tail so the next frame's single block is large enough.
+        mBytesUsed += block.size - mOffset;
+        if (mCurrentBlock + 1 == mBlocks.size()) {
+            addBlock(std::max(block.size * 2, bytes + alignment));
+        }
+        mCurrentBlock++;
+        mOffset = 0;
+    }
+}
+
+void FrameArena::reset() {
+    if (mBlocks.size() > 1) {
+        // Collapse to one block that fits everything this frame needed.
+        size_t total = 0;
+        for (const auto& block : mBlocks) {
+            total += block.size;
+        }
+        mBlocks.clear();
+        addBlock(total);
+    }
+
+    mStats.heapAllocationsLastFrame = mStats.heapAllocationsThisFrame;
+    mStats.heapAllocationsThisFrame = 0;
+    mStats.bytesUsedLastFrame = mBytesUsed;
+    mCurrentBlock = 0;
+    mOffset = 0;
+    mBytesUsed = 0;
+}
+
+void FrameArena::addBlock(size_t size) {
+    mStats.capacity = mBlocks.empty() ? size : mStats.capacity + size;
+    mStats.heapAllocationsThisFrame++;
+    // Left uninitialized on purpose; containers construct their own elements.
+    mBlocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+}
+
+void FrameArena::dump(std::string& result) const {
+    base::StringAppendF(&result,
+                        "FrameArena: capacity=%zu bytesUsedLastFrame=%zu "
+                        "heapAllocationsLastFrame=%zu\n",
+                        mStats.capacity, mStats.bytesUsedLastFrame, mStats.heapAllocationsLastFrame);
+}
+
+} // namespace android::compositionengine
@@ -19,8 +19,16 @@
 #include <gui/BufferQueue.h>
 #include <ui/GraphicBuffer.h>
 
+#include <algorithm>
+
 namespace android::compositionengine::impl {
 
+namespace {
+// Evicted buffers are remembered for as many evictions as there are slots, so longer cycles can't
+// be observed.
+constexpr uint64_t kMaxCycleLength = 2 * BufferQueue::NUM_BUFFER_SLOTS;
+} // namespace
+
 HwcBufferCache::HwcBufferCache() {
     for (uint32_t i = kMaxLayerBufferCount; i-- > 0;) {
         mFreeSlots.push(i);
@@ -28,13 +36,40 @@ HwcBufferCache::HwcBufferCache() {
 }
 
 HwcSlotAndBuffer HwcBufferCache::getHwcSlotAndBuffer(const sp<GraphicBuffer>& buffer) {
-    if (auto i = mCacheByBufferId.find(buffer->getId()); i != mCacheByBufferId.end()) {
+    const uint64_t bufferId = buffer->getId();
+    const bool bufferChanged = bufferId != mLastBufferId;
+    if (bufferChanged) {
+        mBufferChangeCounter++;
+    }
+
+    HwcSlotAndBuffer slotAndBuffer;
+    if (auto i = mCacheByBufferId.find(bufferId); i != mCacheByBufferId.end()) {
         Cache& cache = i->second;
         // mark this cache slot as more recently used so it won't get evicted anytime soon
         cache.lruCounter = mLeastRecentlyUsedCounter++;
-        return {cache.slot, nullptr};
+        if (bufferChanged) {
+            if (cache.prefetched) {
+                cache.prefetched = false;
+                mPrefetchHitCount++;
+            } else {
+                recordReuse(cache.lastBufferChange);
+            }
+            cache.lastBufferChange = mBufferChangeCounter;
+        }
+        slotAndBuffer = {cache.slot, nullptr};
+    } else {
+        const auto evicted =
+                std::find_if(mEvictedBuffers.begin(), mEvictedBuffers.end(),
+                             [bufferId](const auto& entry) { return entry.first == bufferId; });
+        if (evicted != mEvictedBuffers.end()) {
+            mReimportCount++;
+            recordReuse(evicted->second);
+            mEvictedBuffers.erase(evicted);
+        }
+        slotAndBuffer = {cache(buffer), buffer};
     }
-    return {cache(buffer), buffer};
+    mLastBufferId = bufferId;
+    return slotAndBuffer;
 }
 
 HwcSlotAndBuffer HwcBufferCache::getOverrideHwcSlotAndBuffer(const sp<GraphicBuffer>& buffer) {
@@ -45,7 +80,32 @@ HwcSlotAndBuffer HwcBufferCache::getOverrideHwcSlotAndBuffer(const sp<GraphicBuf
     return {kOverrideBufferSlot, buffer};
 }
 
+std::optional<HwcSlotAndBuffer> HwcBufferCache::prefetch(const sp<GraphicBuffer>& buffer) {
+    if (!mTracking || !mLastBufferId || mCacheByBufferId.count(buffer->getId()) > 0) {
+        return std::nullopt;
+    }
+    if (mFreeSlots.empty()) {
+        const auto cacheToEvict = getPredictedLastNeeded();
+        if (cacheToEvict == mCacheByBufferId.end() || !isOutsideCycle(cacheToEvict->second)) {
+            return std::nullopt;
+        }
+        evict(cacheToEvict);
+    }
+    const uint32_t slot = mFreeSlots.top();
+    mFreeSlots.pop();
+    mCacheByBufferId.emplace(buffer->getId(),
+                             Cache{.buffer = buffer,
+                                   .slot = slot,
+                                   .lruCounter = mLeastRecentlyUsedCounter++,
+                                   .lastBufferChange = mBufferChangeCounter,
+                                   .prefetched = true});
+    mPrefetchCount++;
+    return HwcSlotAndBuffer{slot, buffer};
+}
+
 uint32_t HwcBufferCache::uncache(uint64_t bufferId) {
+    std::erase_if(mEvictedBuffers,
+                  [bufferId](const auto& entry) { return entry.first == bufferId; });
     if (auto i = mCacheByBufferId.find(bufferId); i != mCacheByBufferId.end()) {
         uint32_t slot = i->second.slot;
         mCacheByBufferId.erase(i);
@@ -63,6 +123,8 @@ uint32_t HwcBufferCache::cache(const sp<GraphicBuffer>& buffer) {
     Cache cache;
     cache.slot = getLeastRecentlyUsedSlot();
     cache.lruCounter = mLeastRecentlyUsedCounter++;
+    cache.lastBufferChange = mBufferChangeCounter;
+    cache.prefetched = false;
     cache.buffer = buffer;
     mCacheByBufferId.emplace(buffer->getId(), cache);
     return cache.slot;
@@ -71,20 +133,70 @@ uint32_t HwcBufferCache::cache(const sp<GraphicBuffer>& buffer) {
 uint32_t HwcBufferCache::getLeastRecentlyUsedSlot() {
     if (mFreeSlots.empty()) {
         assert(!mCacheByBufferId.empty());
-        // evict the least recently used cache entry
-        auto cacheToErase = mCacheByBufferId.begin();
-        for (auto i = cacheToErase; i != mCacheByBufferId.end(); ++i) {
-            if (i->second.lruCounter < cacheToErase->second.lruCounter) {
-                cacheToErase = i;
+        auto cacheToErase = mTracking ? getPredictedLastNeeded() : mCacheByBufferId.end();
+        if (cacheToErase == mCacheByBufferId.end()) {
+            // evict the least recently used cache entry
+            cacheToErase = mCacheByBufferId.begin();
+            for (auto i = cacheToErase; i != mCacheByBufferId.end(); ++i) {
+                if (i->second.lruCounter < cacheToErase->second.lruCounter) {
+                    cacheToErase = i;
+                }
             }
         }
-        uint32_t slot = cacheToErase->second.slot;
-        mCacheByBufferId.erase(cacheToErase);
-        mFreeSlots.push(slot);
+        evict(cacheToErase);
     }
     uint32_t slot = mFreeSlots.top();
     mFreeSlots.pop();
     return slot;
 }
 
+HwcBufferCache::CacheMap::iterator HwcBufferCache::getPredictedLastNeeded() {
+    // Buffers outside the cycle are ranked above those in it, the oldest first. Buffers in the
+    // cycle are needed again in the order they were last sent, so the most recent is needed last.
+    const auto rank = [this](const Cache& cache) -> uint64_t {
+        const uint64_t age = mBufferChangeCounter - cache.lastBufferChange;
+        if (isOutsideCycle(cache)) {
+            return mCycleLength + age;
+        }
+        // A prefetched buffer is about to join the cycle.
+        return cache.prefetched ? 0 : mCycleLength - age;
+    };
+    auto predictedLastNeeded = mCacheByBufferId.end();
+    for (auto i = mCacheByBufferId.begin(); i != mCacheByBufferId.end(); ++i) {
+        if (i->first == mLastBufferId) {
+            continue;
+        }
+        if (predictedLastNeeded == mCacheByBufferId.end() ||
+            rank(i->second) > rank(predictedLastNeeded->second)) {
+            predictedLastNeeded = i;
+        }
+    }
+    return predictedLastNeeded;
+}
+
+bool HwcBufferCache::isOutsideCycle(const Cache& cache) const {
+    return mBufferChangeCounter - cache.lastBufferChange > mCycleLength;
+}
+
+void HwcBufferCache::evict(CacheMap::iterator cacheToEvict) {
+    // A prefetched buffer was never sent to the layer, so it has no place in the cycle to learn.
+    if (!cacheToEvict->second.prefetched) {
+        mEvictedBuffers.emplace_front(cacheToEvict->first, cacheToEvict->second.lastBufferChange);
+        if (mEvictedBuffers.size() > kMaxLayerBufferCount) {
+            mEvictedBuffers.pop_back();
+        }
+    }
+    mFreeSlots.push(cacheToEvict->second.slot);
+    mCacheByBufferId.erase(cacheToEvict);
+}
+
+void HwcBufferCache::recordReuse(uint64_t previousBufferChange) {
+    // Grow the cycle as soon as a buffer takes longer to come back, but shrink it gradually, since
+    // producers don't always return their buffers in the same order.
+    const uint64_t reuseDistance =
+            std::min(mBufferChangeCounter - previousBufferChange, kMaxCycleLength);
+    mCycleLength = std::max(static_cast<uint32_t>(reuseDistance),
+                            mCycleLength > 0 ? mCycleLength - 1 : 0u);
+}
+
 } // namespace android::compositionengine::impl
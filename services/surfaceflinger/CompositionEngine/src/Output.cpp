@@ -95,6 +95,46 @@ ScaleVector getScale(const Rect& from, const Rect& to) {
             .y = static_cast<float>(to.height()) / from.height()};
 }
 
+using VisibilityInputs = OutputLayerCompositionState::VisibilityInputs;
+
+Rect getVisibilityFootprint(const LayerFECompositionState& layerFEState) {
+    Rect footprint(layerFEState.geomLayerTransform.transform(layerFEState.geomLayerBounds));
+    if (layerFEState.shadowRadius > 0.0f) {
+        const auto inset = static_cast<int32_t>(ceilf(layerFEState.shadowRadius) * -1.0f);
+        footprint.inset(inset, inset, inset, inset);
+    }
+    return footprint;
+}
+
+bool visibilityInputsMatch(const VisibilityInputs& inputs,
+                           const LayerFECompositionState& layerFEState) {
+    return inputs.geomLayerTransform == layerFEState.geomLayerTransform &&
+            inputs.geomLayerBounds == layerFEState.geomLayerBounds &&
+            inputs.shadowRadius == layerFEState.shadowRadius &&
+            inputs.isOpaque == layerFEState.isOpaque &&
+            inputs.compositionType == layerFEState.compositionType &&
+            inputs.transparentRegionHint.hasSameRects(layerFEState.transparentRegionHint);
+}
+
+// Adds the time spent in its scope to the CPU cost of a layer, if the output records layer costs.
+class ScopedLayerCost {
+public:
+    ScopedLayerCost(const OutputCompositionState& outputState,
+                    compositionengine::OutputLayer* layer)
+          : mLayer(outputState.recordLayerCosts ? layer : nullptr),
+            mStartTime(mLayer ? systemTime() : 0) {}
+
+    ~ScopedLayerCost() {
+        if (mLayer) {
+            mLayer->editState().cpuCost += systemTime() - mStartTime;
+        }
+    }
+
+private:
+    compositionengine::OutputLayer* const mLayer;
+    const nsecs_t mStartTime;
+};
+
 } // namespace
 
 std::shared_ptr<Output> createOutput(
@@ -123,6 +163,7 @@ void Output::setName(const std::string& name) {
     mNamePlusId = displayIdOpt ? base::StringPrintf("%s (%s)", mName.c_str(),
                                      to_string(*displayIdOpt).c_str())
                                : mName;
+    mHasClientCompositionTraceName = "hasClientComposition " + mNamePlusId;
 }
 
 void Output::setCompositionEnabled(bool enabled) {
@@ -311,6 +352,16 @@ void Output::dumpBase(std::string& out) const {
     dumpState(out);
     out += '\n';
 
+    if (mHwComposerAsyncWorker) {
+        mCompositionStrategyHistory.dump(out);
+        out += '\n';
+    }
+
+    if (mClientCompositionRequestCache) {
+        mClientCompositionRequestCache->dump(out);
+        out += '\n';
+    }
+
     if (mDisplayColorProfile) {
         mDisplayColorProfile->dump(out);
     } else {
@@ -432,12 +483,24 @@ void Output::prepare(const compositionengine::CompositionRefreshArgs& refreshArg
 
     rebuildLayerStacks(refreshArgs, geomSnapshots);
     uncacheBuffers(refreshArgs.bufferIdsToUncache);
+    prefetchBuffers(refreshArgs.buffersToPrefetch);
 }
 
 void Output::present(const compositionengine::CompositionRefreshArgs& refreshArgs) {
     ATRACE_FORMAT("%s for %s", __func__, mNamePlusId.c_str());
     ALOGV(__FUNCTION__);
 
+    editState().recordLayerCosts = refreshArgs.recordLayerCosts;
+    if (refreshArgs.recordLayerCosts) {
+        auto& outputState = editState();
+        outputState.renderEngineStartTime = 0;
+        outputState.hwcValidateDuration = 0;
+        outputState.hwcPresentDuration = 0;
+        for (auto* layer : getOutputLayersOrderedByZ()) {
+            layer->editState().cpuCost = 0;
+        }
+    }
+
     updateColorProfile(refreshArgs);
     updateCompositionState(refreshArgs);
     planComposition();
@@ -447,6 +510,9 @@ void Output::present(const compositionengine::CompositionRefreshArgs& refreshArg
 
     GpuCompositionResult result;
     const bool predictCompositionStrategy = canPredictCompositionStrategy(refreshArgs);
+    if (isPowerHintSessionEnabled()) {
+        setHintSessionExpectedClientComposition(expectsClientComposition());
+    }
     if (predictCompositionStrategy) {
         result = prepareFrameAsync();
     } else {
@@ -459,6 +525,12 @@ void Output::present(const compositionengine::CompositionRefreshArgs& refreshArg
     renderCachedSets(refreshArgs);
 }
 
+bool Output::supportsParallelPresent() {
+    // Implementations opt in once they know they share no state with other outputs beyond their
+    // layers.
+    return false;
+}
+
 void Output::uncacheBuffers(std::vector<uint64_t> const& bufferIdsToUncache) {
     if (bufferIdsToUncache.empty()) {
         return;
@@ -468,6 +540,18 @@ void Output::uncacheBuffers(std::vector<uint64_t> const& bufferIdsToUncache) {
     }
 }
 
+void Output::prefetchBuffers(const BuffersToPrefetch& buffersToPrefetch) {
+    if (buffersToPrefetch.empty()) {
+        return;
+    }
+    for (auto outputLayer : getOutputLayersOrderedByZ()) {
+        if (const auto it = buffersToPrefetch.find(outputLayer->getLayerFE().getSequence());
+            it != buffersToPrefetch.end()) {
+            outputLayer->prefetchBuffers(it->second);
+        }
+    }
+}
+
 void Output::rebuildLayerStacks(const compositionengine::CompositionRefreshArgs& refreshArgs,
                                 LayerFESet& layerFESet) {
     ATRACE_CALL();
@@ -498,15 +582,18 @@ void Output::rebuildLayerStacks(const compositionengine::CompositionRefreshArgs&
 
 void Output::collectVisibleLayers(const compositionengine::CompositionRefreshArgs& refreshArgs,
                                   compositionengine::Output::CoverageState& coverage) {
-    // Evaluate the layers from front to back to determine what is visible. This
-    // also incrementally calculates the coverage information for each layer as
-    // well as the entire output.
-    for (auto layer : reversed(refreshArgs.layers)) {
-        // Incrementally process the coverage for each layer
-        ensureOutputLayerIfVisible(layer, coverage);
-
-        // TODO(b/121291683): Stop early if the output is completely covered and
-        // no more layers could even be visible underneath the ones on top.
+    if (!mIncrementalVisibilityEnabled ||
+        !collectVisibleLayersIncrementally(refreshArgs, coverage)) {
+        // Evaluate the layers from front to back to determine what is visible. This
+        // also incrementally calculates the coverage information for each layer as
+        // well as the entire output.
+        for (auto layer : reversed(refreshArgs.layers)) {
+            // Incrementally process the coverage for each layer
+            ensureOutputLayerIfVisible(layer, coverage);
+
+            // TODO(b/121291683): Stop early if the output is completely covered and
+            // no more layers could even be visible underneath the ones on top.
+        }
     }
 
     setReleasedLayers(refreshArgs);
@@ -514,6 +601,120 @@ void Output::collectVisibleLayers(const compositionengine::CompositionRefreshArg
     finalizePendingOutputLayers();
 }
 
+bool Output::collectVisibleLayersIncrementally(
+        const compositionengine::CompositionRefreshArgs& refreshArgs,
+        compositionengine::Output::CoverageState& coverage) {
+    ATRACE_CALL();
+    const auto& outputState = getState();
+    const VisibilityOutputGeometry outputGeometry{
+            .transform = outputState.transform,
+            .layerStackSpaceContent = outputState.layerStackSpace.getContent(),
+            .displaySpaceBounds = outputState.displaySpace.getBoundsAsRect(),
+            .layerFilter = outputState.layerFilter};
+    const bool outputGeometryChanged =
+            !mVisibilityOutputGeometry || *mVisibilityOutputGeometry != outputGeometry;
+    mVisibilityOutputGeometry = outputGeometry;
+    if (outputGeometryChanged || coverage.aboveCoveredLayersExcludingOverlays) {
+        return false;
+    }
+
+    std::unordered_map<const LayerFE*, size_t> prevOutputLayerIndices;
+    prevOutputLayerIndices.reserve(getOutputLayerCount());
+    for (size_t i = 0; i < getOutputLayerCount(); i++) {
+        if (const auto* outputLayer = getOutputLayerOrderedByZByIndex(i)) {
+            prevOutputLayerIndices.emplace(&outputLayer->getLayerFE(), i);
+        }
+    }
+
+    // First pass: find the layers whose coverage inputs changed since the last frame, and the
+    // area affected by those changes. Layers are evaluated from front to back.
+    struct Candidate {
+        sp<LayerFE> layerFE;
+        std::optional<size_t> prevIndex;
+        Rect footprint;
+        bool dirty = true;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(refreshArgs.layers.size());
+    std::vector<bool> prevOutputLayerMatched(getOutputLayerCount(), false);
+    std::optional<size_t> lastPrevIndex;
+    Region affectedRegion;
+    for (const auto& layerFE : reversed(refreshArgs.layers)) {
+        Candidate& candidate = candidates.emplace_back(Candidate{.layerFE = layerFE});
+        const auto* layerFEState = layerFE->getCompositionState();
+        if (!layerFEState || !layerFEState->isVisible || !includesLayer(layerFE)) {
+            continue;
+        }
+
+        candidate.footprint = getVisibilityFootprint(*layerFEState);
+        const VisibilityInputs* prevInputs = nullptr;
+        if (const auto it = prevOutputLayerIndices.find(layerFE.get());
+            it != prevOutputLayerIndices.end()) {
+            // The previous frame's coverage is only valid if the z-order is unchanged.
+            if (lastPrevIndex && it->second > *lastPrevIndex) {
+                return false;
+            }
+            lastPrevIndex = it->second;
+            candidate.prevIndex = it->second;
+            prevOutputLayerMatched[it->second] = true;
+            const auto& prevState = getOutputLayerOrderedByZByIndex(it->second)->getState();
+            prevInputs = prevState.visibilityInputs ? &*prevState.visibilityInputs : nullptr;
+        }
+
+        candidate.dirty = !prevInputs || !visibilityInputsMatch(*prevInputs, *layerFEState);
+        if (candidate.dirty) {
+            affectedRegion.orSelf(candidate.footprint);
+            if (prevInputs) {
+                affectedRegion.orSelf(prevInputs->footprint);
+            }
+        }
+    }
+
+    // Layers that were visible on the last frame but are no longer candidates uncover the area
+    // they used to cover.
+    for (size_t i = 0; i < prevOutputLayerMatched.size(); i++) {
+        if (prevOutputLayerMatched[i]) {
+            continue;
+        }
+        const auto* outputLayer = getOutputLayerOrderedByZByIndex(i);
+        if (!outputLayer || !outputLayer->getState().visibilityInputs) {
+            return false;
+        }
+        affectedRegion.orSelf(outputLayer->getState().visibilityInputs->footprint);
+    }
+
+    // Second pass: recompute the coverage of the layers in the affected area and reuse the
+    // previous frame's coverage for the remaining layers.
+    const Rect affectedBounds = affectedRegion.getBounds();
+    for (auto& candidate : candidates) {
+        Rect unused;
+        const bool reusable = !candidate.dirty && candidate.prevIndex &&
+                (!candidate.footprint.intersect(affectedBounds, &unused) ||
+                 affectedRegion.intersect(candidate.footprint).isEmpty());
+        if (!reusable) {
+            ensureOutputLayerIfVisible(candidate.layerFE, coverage);
+            continue;
+        }
+
+        coverage.latchedLayers.insert(candidate.layerFE);
+        auto* outputLayer = ensureOutputLayer(candidate.prevIndex, candidate.layerFE);
+        const auto& outputLayerState = outputLayer->getState();
+        const auto& inputs = *outputLayerState.visibilityInputs;
+
+        // This matches the dirty region ensureOutputLayerIfVisible computes when the visible and
+        // covered regions are unchanged.
+        Region dirty = candidate.layerFE->getCompositionState()->contentDirty
+                ? outputLayerState.visibleRegion
+                : outputLayerState.visibleRegion.intersect(outputLayerState.coveredRegion);
+        dirty.subtractSelf(coverage.aboveOpaqueLayers);
+        coverage.dirtyRegion.orSelf(dirty);
+
+        coverage.aboveCoveredLayers.orSelf(inputs.footprint);
+        coverage.aboveOpaqueLayers.orSelf(inputs.opaqueRect);
+    }
+    return true;
+}
+
 void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
                                         compositionengine::Output::CoverageState& coverage) {
     // Ensure we have a snapshot of the basic geometry layer state. Limit the
@@ -654,6 +855,9 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
         opaqueRegion.set(visibleRect);
     }
 
+    // The full footprint of the layer, before subtracting the opaque layers above
+    const Rect coverageFootprint = visibleRegion.getBounds();
+
     // Clip the covered region to the visible region
     coveredRegion = coverage.aboveCoveredLayers.intersect(visibleRegion);
 
@@ -756,6 +960,19 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
         outputLayerState.coveredRegionExcludingDisplayOverlays =
                 std::move(coveredRegionExcludingDisplayOverlays);
     }
+    if (mIncrementalVisibilityEnabled) {
+        outputLayerState.visibilityInputs = OutputLayerCompositionState::VisibilityInputs{
+                .geomLayerTransform = tr,
+                .geomLayerBounds = layerFEState->geomLayerBounds,
+                .shadowRadius = layerFEState->shadowRadius,
+                .isOpaque = layerFEState->isOpaque,
+                .transparentRegionHint = layerFEState->transparentRegionHint,
+                .compositionType = layerFEState->compositionType,
+                .footprint = coverageFootprint,
+                .opaqueRect = opaqueRegion.getBounds()};
+    } else {
+        outputLayerState.visibilityInputs.reset();
+    }
 }
 
 void Output::setReleasedLayers(const compositionengine::CompositionRefreshArgs&) {
@@ -774,6 +991,7 @@ void Output::updateCompositionState(const compositionengine::CompositionRefreshA
     bool forceClientComposition = mLayerRequestingBackgroundBlur != nullptr;
 
     for (auto* layer : getOutputLayersOrderedByZ()) {
+        const ScopedLayerCost cost(getState(), layer);
         layer->updateCompositionState(refreshArgs.updatingGeometryThisFrame,
                                       refreshArgs.devOptForceClientComposition ||
                                               forceClientComposition,
@@ -875,6 +1093,7 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
                     overrideZ = true;
                     includeGeometry = true;
                     constexpr bool isPeekingThrough = true;
+                    const ScopedLayerCost cost(getState(), peekThroughLayer);
                     peekThroughLayer->writeStateToHWC(includeGeometry, false, z++, overrideZ,
                                                       isPeekingThrough);
                     outputLayerHash ^= android::hashCombine(
@@ -888,7 +1107,10 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
         }
 
         constexpr bool isPeekingThrough = false;
-        layer->writeStateToHWC(includeGeometry, skipLayer, z++, overrideZ, isPeekingThrough);
+        {
+            const ScopedLayerCost cost(getState(), layer);
+            layer->writeStateToHWC(includeGeometry, skipLayer, z++, overrideZ, isPeekingThrough);
+        }
         if (!skipLayer) {
             outputLayerHash ^= android::hashCombine(
                     reinterpret_cast<uint64_t>(&layer->getLayerFE()),
@@ -1096,6 +1318,11 @@ void Output::prepareFrame() {
     if (success) {
         applyCompositionStrategy(changes);
     }
+    if (mHwComposerAsyncWorker) {
+        mCompositionStrategyHistory.record(outputState.outputLayerHash,
+                                           {std::move(changes), success,
+                                            outputState.usesClientComposition});
+    }
     finishPrepareFrame();
 }
 
@@ -1147,6 +1374,10 @@ GpuCompositionResult Output::prepareFrameAsync() {
     } else {
         ATRACE_NAME("CompositionStrategyPredictionHit");
     }
+    mCompositionStrategyHistory.recordPrediction(predictionSucceeded, mPredictingRecalledStrategy);
+    mCompositionStrategyHistory.record(state.outputLayerHash,
+                                       {changes, chooseCompositionSuccess,
+                                        state.usesClientComposition});
     state.previousDeviceRequestedChanges = std::move(changes);
     state.previousDeviceRequestedSuccess = chooseCompositionSuccess;
     return compositionResult;
@@ -1260,9 +1491,8 @@ std::optional<base::unique_fd> Output::composeSurfaces(
     ALOGV(__FUNCTION__);
 
     const auto& outputState = getState();
-    const TracedOrdinal<bool> hasClientComposition = {
-        base::StringPrintf("hasClientComposition %s", mNamePlusId.c_str()),
-        outputState.usesClientComposition};
+    const TracedOrdinal<bool> hasClientComposition = {mHasClientCompositionTraceName.c_str(),
+                                                      outputState.usesClientComposition};
     if (!hasClientComposition) {
         setExpensiveRenderingExpected(false);
         return base::unique_fd();
@@ -1331,6 +1561,9 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                    });
 
     const nsecs_t renderEngineStart = systemTime();
+    if (outputState.recordLayerCosts) {
+        outputCompositionState.renderEngineStartTime = renderEngineStart;
+    }
     // Only use the framebuffer cache when rendering to an internal display
     // TODO(b/173560331): This is only to help mitigate memory leaks from virtual displays because
     // right now we don't have a concrete eviction policy for output buffers: GLESRenderEngine
@@ -1421,6 +1654,7 @@ std::vector<LayerFE::LayerSettings> Output::generateClientCompositionRequests(
     uint64_t previousOverrideBufferId = 0;
 
     for (auto* layer : getOutputLayersOrderedByZ()) {
+        const ScopedLayerCost cost(outputState, layer);
         const auto& layerState = layer->getState();
         const auto* layerFEState = layer->getLayerFE().getCompositionState();
         auto& layerFE = layer->getLayerFE();
@@ -1533,6 +1767,10 @@ bool Output::isPowerHintSessionEnabled() {
     return false;
 }
 
+void Output::setHintSessionExpectedClientComposition(bool) {
+    // The base class does nothing with this call.
+}
+
 void Output::postFramebuffer() {
     ATRACE_FORMAT("%s for %s", __func__, mNamePlusId.c_str());
     ALOGV(__FUNCTION__);
@@ -1627,6 +1865,7 @@ void Output::setPredictCompositionStrategy(bool predict) {
         mHwComposerAsyncWorker = std::make_unique<HwcAsyncWorker>();
     } else {
         mHwComposerAsyncWorker.reset(nullptr);
+        mCompositionStrategyHistory.clear();
     }
 }
 
@@ -1634,17 +1873,31 @@ void Output::setTreat170mAsSrgb(bool enable) {
     editState().treat170mAsSrgb = enable;
 }
 
+void Output::setIncrementalVisibilityEnabled(bool enabled) {
+    mIncrementalVisibilityEnabled = enabled;
+    mVisibilityOutputGeometry.reset();
+}
+
 bool Output::canPredictCompositionStrategy(const CompositionRefreshArgs& refreshArgs) {
     uint64_t lastOutputLayerHash = getState().lastOutputLayerHash;
     uint64_t outputLayerHash = getState().outputLayerHash;
     editState().lastOutputLayerHash = outputLayerHash;
+    mPredictingRecalledStrategy = false;
 
     if (!getState().isEnabled || !mHwComposerAsyncWorker) {
         ALOGV("canPredictCompositionStrategy disabled");
         return false;
     }
 
-    if (!getState().previousDeviceRequestedChanges) {
+    // Predict the strategy HWC chose the last time these output layers were composed, which is
+    // the previous frame unless the output layers changed.
+    const auto* strategy = mCompositionStrategyHistory.get(outputLayerHash);
+    if (!strategy) {
+        ALOGV("canPredictCompositionStrategy no strategy recorded for output layers");
+        return false;
+    }
+
+    if (!strategy->changes) {
         ALOGV("canPredictCompositionStrategy previous changes not available");
         return false;
     }
@@ -1659,21 +1912,31 @@ bool Output::canPredictCompositionStrategy(const CompositionRefreshArgs& refresh
         return false;
     }
 
-    if (lastOutputLayerHash != outputLayerHash) {
-        ALOGV("canPredictCompositionStrategy output layers changed");
-        return false;
-    }
-
-    // If no layer uses clientComposition, then don't predict composition strategy
-    // because we have less work to do in parallel.
-    if (!anyLayersRequireClientComposition()) {
+    // If no layer uses clientComposition, and HWC did not fall back to it either, then don't
+    // predict composition strategy because we have less work to do in parallel.
+    if (!strategy->usesClientComposition && !anyLayersRequireClientComposition()) {
         ALOGV("canPredictCompositionStrategy no layer uses clientComposition");
         return false;
     }
 
+    editState().previousDeviceRequestedChanges = strategy->changes;
+    editState().previousDeviceRequestedSuccess = strategy->success;
+    mPredictingRecalledStrategy = lastOutputLayerHash != outputLayerHash;
     return true;
 }
 
+bool Output::expectsClientComposition() {
+    if (anyLayersRequireClientComposition()) {
+        return true;
+    }
+    if (const auto* strategy = mCompositionStrategyHistory.get(getState().outputLayerHash)) {
+        return strategy->usesClientComposition;
+    }
+    // The output layers were not composed recently, so assume they are composed like the
+    // previous frame was.
+    return getState().usesClientComposition;
+}
+
 bool Output::anyLayersRequireClientComposition() const {
     const auto layers = getOutputLayersOrderedByZ();
     return std::any_of(layers.begin(), layers.end(),
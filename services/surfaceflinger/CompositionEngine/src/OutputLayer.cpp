@@ -663,6 +663,42 @@ void OutputLayer::uncacheBuffers(const std::vector<uint64_t>& bufferIdsToUncache
     }
 }
 
+void OutputLayer::prefetchBuffers(const std::vector<sp<GraphicBuffer>>& buffers) {
+    auto& state = editState();
+    if (!state.hwc || !state.hwc->hwcBufferCache.isTracking()) {
+        return;
+    }
+
+    bool prefetched = false;
+    for (const auto& buffer : buffers) {
+        const auto hwcSlotAndBuffer = state.hwc->hwcBufferCache.prefetch(buffer);
+        if (!hwcSlotAndBuffer) {
+            continue;
+        }
+        if (auto error = state.hwc->hwcLayer->setBuffer(hwcSlotAndBuffer->slot,
+                                                        hwcSlotAndBuffer->buffer, Fence::NO_FENCE);
+            error != hal::Error::NONE) {
+            ALOGE("[%s] Failed to prefetch buffer %p: %s (%d)", getLayerFE().getDebugName(),
+                  hwcSlotAndBuffer->buffer->handle, to_string(error).c_str(),
+                  static_cast<int32_t>(error));
+            continue;
+        }
+        prefetched = true;
+    }
+
+    // Sending a buffer to a slot also makes it the layer's buffer, so restore the active buffer,
+    // the same way clearing buffer slots does.
+    if (prefetched) {
+        if (auto error = state.hwc->hwcLayer->setBuffer(state.hwc->activeBufferSlot, nullptr,
+                                                        Fence::NO_FENCE);
+            error != hal::Error::NONE) {
+            ALOGE("[%s] Failed to restore the active buffer: %s (%d)",
+                  getLayerFE().getDebugName(), to_string(error).c_str(),
+                  static_cast<int32_t>(error));
+        }
+    }
+}
+
 void OutputLayer::writeBufferStateToHWC(HWC2::Layer* hwcLayer,
                                         const LayerFECompositionState& outputIndependentState,
                                         bool skipLayer) {
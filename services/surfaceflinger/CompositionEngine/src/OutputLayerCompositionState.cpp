@@ -40,6 +40,14 @@ void dumpHwc(const OutputLayerCompositionState::Hwc& hwc, std::string& out) {
     }
 
     dumpVal(out, "composition", toString(hwc.hwcCompositionType), hwc.hwcCompositionType);
+
+    const auto& cache = hwc.hwcBufferCache;
+    dumpVal(out, "bufferCycle", cache.getCycleLength());
+    dumpVal(out, "bufferReimports", cache.getReimportCount());
+    if (cache.isTracking()) {
+        dumpVal(out, "prefetchedBuffers", cache.getPrefetchCount());
+        dumpVal(out, "prefetchHits", cache.getPrefetchHitCount());
+    }
 }
 
 } // namespace
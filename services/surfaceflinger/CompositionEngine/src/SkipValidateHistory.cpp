@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <bit>
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/impl/SkipValidateHistory.h>
+
+namespace android::compositionengine::impl {
+
+SkipValidateHistory::Entry* SkipValidateHistory::get(uint64_t layerStackHash) {
+    const auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                                 [layerStackHash](const auto& entry) {
+                                     return entry.first == layerStackHash;
+                                 });
+    if (it == mEntries.end()) {
+        return nullptr;
+    }
+    if (it != mEntries.begin()) {
+        auto entry = *it;
+        mEntries.erase(it);
+        mEntries.push_front(entry);
+    }
+    return &mEntries.front().second;
+}
+
+bool SkipValidateHistory::shouldAttempt(uint64_t layerStackHash) {
+    Entry* entry = get(layerStackHash);
+    if (!entry) {
+        return true;
+    }
+    if (2 * std::popcount(entry->outcomes) >= entry->outcomeCount) {
+        return true;
+    }
+    if (++entry->framesSinceAttempt >= kRetryInterval) {
+        return true;
+    }
+    mStats.avoided++;
+    return false;
+}
+
+void SkipValidateHistory::recordAttempt(uint64_t layerStackHash, bool presented) {
+    Entry* entry = get(layerStackHash);
+    if (!entry) {
+        if (mEntries.size() >= mCapacity) {
+            mEntries.pop_back();
+        }
+        entry = &mEntries.emplace_front(layerStackHash, Entry{}).second;
+    }
+    entry->outcomes = static_cast<uint8_t>((entry->outcomes << 1) | (presented ? 1 : 0));
+    if (entry->outcomeCount < kOutcomeCount) {
+        entry->outcomeCount++;
+    }
+    entry->framesSinceAttempt = 0;
+
+    mStats.attempts++;
+    if (presented) {
+        mStats.successes++;
+        mStats.latencySaved += mPresentDuration.value_or(0);
+    }
+}
+
+void SkipValidateHistory::recordPresentDuration(nsecs_t duration) {
+    // Smooths out outliers, such as a present that waited on a previous frame.
+    mPresentDuration = mPresentDuration ? (*mPresentDuration * 7 + duration) / 8 : duration;
+}
+
+void SkipValidateHistory::dump(std::string& out) const {
+    const float successRate = mStats.attempts == 0
+            ? 0.f
+            : 100.f * static_cast<float>(mStats.successes) / static_cast<float>(mStats.attempts);
+    base::StringAppendF(&out,
+                        "   Skip validate prediction: %zu/%zu attempts presented (%.1f%%), %zu "
+                        "frames validated directly, %.3f ms of HWC round trips saved, %zu layer "
+                        "stacks recorded\n",
+                        mStats.successes, mStats.attempts, successRate, mStats.avoided,
+                        static_cast<double>(mStats.latencySaved) / 1e6, mEntries.size());
+}
+
+} // namespace android::compositionengine::impl
@@ -158,9 +158,183 @@ void CachedSet::updateAge(std::chrono::steady_clock::time_point now) {
     }
 }
 
+std::optional<Rect> CachedSet::getPartialTextureBounds(
+        const TexturePool& texturePool, const OutputCompositionState& outputState) const {
+    // The bounds are in display space, so the texture can only be positioned in framebuffer
+    // space without scaling if the two match.
+    if (!(outputState.displaySpace == outputState.framebufferSpace)) {
+        return std::nullopt;
+    }
+
+    // The visible region covers shadows, which may extend past the display frames.
+    Region region(mBounds);
+    region.orSelf(mVisibleRegion);
+    const Rect& content = outputState.framebufferSpace.getContent();
+    Rect bounds;
+    if (!region.getBounds().intersect(content, &bounds)) {
+        return std::nullopt;
+    }
+
+    const ui::Size size = texturePool.getTextureSize(ui::Size(bounds.width(), bounds.height()));
+    if (size == outputState.framebufferSpace.getBounds() || size.width > content.width() ||
+        size.height > content.height()) {
+        return std::nullopt;
+    }
+
+    // Grow the bounds to the texture size, keeping them within the content.
+    const int32_t left = std::min(bounds.left, content.right - size.width);
+    const int32_t top = std::min(bounds.top, content.bottom - size.height);
+    return Rect(left, top, left + size.width, top + size.height);
+}
+
+namespace {
+// Whether the layer can be drawn into part of the texture by cropping its geometry. Layers drawing
+// outside of their boundaries, or sampling what is behind them, need the whole texture rendered.
+bool canClipLayerSettings(const renderengine::LayerSettings& layer) {
+    if (layer.shadow.length > 0.f || layer.backgroundBlurRadius > 0 ||
+        !layer.blurRegions.empty() || layer.stretchEffect.hasEffect() || layer.skipContentDraw) {
+        return false;
+    }
+
+    // Only scales and translations map a crop in layer stack space back to a rect.
+    const mat4& transform = layer.geometry.positionTransform;
+    return transform[0][1] == 0.f && transform[1][0] == 0.f && transform[0][3] == 0.f &&
+            transform[1][3] == 0.f && transform[3][3] == 1.f && transform[0][0] != 0.f &&
+            transform[1][1] != 0.f;
+}
+
+// Crops the layer to the layer stack space rect, keeping its buffer and rounded corners where they
+// were drawn before. Returns nullopt if nothing of the layer is left.
+std::optional<renderengine::LayerSettings> clipLayerSettings(
+        const renderengine::LayerSettings& layer, const FloatRect& clip) {
+    const mat4 inverseTransform = inverse(layer.geometry.positionTransform);
+    const vec4 leftTop = inverseTransform * vec4(clip.left, clip.top, 0.f, 1.f);
+    const vec4 rightBottom = inverseTransform * vec4(clip.right, clip.bottom, 0.f, 1.f);
+    const FloatRect localClip(std::min(leftTop.x, rightBottom.x),
+                              std::min(leftTop.y, rightBottom.y),
+                              std::max(leftTop.x, rightBottom.x),
+                              std::max(leftTop.y, rightBottom.y));
+
+    const FloatRect& bounds = layer.geometry.boundaries;
+    const FloatRect clippedBounds = bounds.intersect(localClip);
+    if (clippedBounds.isEmpty()) {
+        return std::nullopt;
+    }
+
+    renderengine::LayerSettings clipped = layer;
+    clipped.geometry.boundaries = clippedBounds;
+    if (clipped.geometry.roundedCornersRadius.x > 0.f &&
+        clipped.geometry.roundedCornersRadius.y > 0.f &&
+        clipped.geometry.roundedCornersCrop.isEmpty()) {
+        // The corners are rounded along the boundaries when there is no crop.
+        clipped.geometry.roundedCornersCrop = bounds;
+    }
+    if (clipped.source.buffer.buffer) {
+        // The texture transform applies to coordinates normalized to the boundaries, so map the
+        // clipped boundaries back to the part of the original ones they cover.
+        const float width = bounds.getWidth();
+        const float height = bounds.getHeight();
+        clipped.source.buffer.textureTransform = layer.source.buffer.textureTransform *
+                mat4::translate(vec4((clippedBounds.left - bounds.left) / width,
+                                     (clippedBounds.top - bounds.top) / height, 0.f, 1.f)) *
+                mat4::scale(vec4(clippedBounds.getWidth() / width,
+                                 clippedBounds.getHeight() / height, 1.f, 1.f));
+    }
+    return clipped;
+}
+
+Rect alignToTiles(const Rect& rect, const Rect& textureBounds, int32_t tileSize) {
+    const auto alignDown = [tileSize](int32_t value, int32_t origin) {
+        return origin + (value - origin) / tileSize * tileSize;
+    };
+    const auto alignUp = [tileSize](int32_t value, int32_t origin) {
+        return origin + (value - origin + tileSize - 1) / tileSize * tileSize;
+    };
+    return Rect(alignDown(rect.left, textureBounds.left), alignDown(rect.top, textureBounds.top),
+                std::min(alignUp(rect.right, textureBounds.left), textureBounds.right),
+                std::min(alignUp(rect.bottom, textureBounds.top), textureBounds.bottom));
+}
+} // namespace
+
+std::optional<Region> CachedSet::getDirtyRegionSince(
+        const CachedSet& previous, const OutputCompositionState& outputState,
+        const renderengine::DisplaySettings& displaySettings, const Rect& textureBounds) const {
+    // The previous texture is copied as is, so it must cover the same part of the same display and
+    // have been rendered the same way. Only the recorded state of `previous` is used, since its
+    // layers may have been destroyed since.
+    if (!previous.mTexture || previous.mTextureBounds != textureBounds ||
+        !(previous.mRenderedDisplaySettings == displaySettings)) {
+        return std::nullopt;
+    }
+    if (!previous.mDrawFence || previous.mDrawFence->getStatus() != Fence::Status::Signaled) {
+        return std::nullopt;
+    }
+    // Display frames are in display space, so the dirty rects can only be placed within the
+    // texture if it matches framebuffer space.
+    if (!(outputState.displaySpace == outputState.framebufferSpace)) {
+        return std::nullopt;
+    }
+    // The copy of the previous texture must come out unchanged: no display color transform
+    // applied on top, no HDR tone mapping and no dimming relative to the brightest layer.
+    if ((!displaySettings.deviceHandlesColorTransform &&
+         displaySettings.colorTransform != mat4()) ||
+        displaySettings.targetLuminanceNits <= 0.f) {
+        return std::nullopt;
+    }
+    const auto transfer = static_cast<ui::Dataspace>(displaySettings.outputDataspace &
+                                                     ui::Dataspace::TRANSFER_MASK);
+    if (transfer == ui::Dataspace::TRANSFER_ST2084 || transfer == ui::Dataspace::TRANSFER_HLG) {
+        return std::nullopt;
+    }
+    // Hole punches and blurs depend on what is drawn around them.
+    if (mHolePunchLayer || mBlurLayer || previous.mHolePunchLayer || previous.mBlurLayer ||
+        sDebugHighlighLayers) {
+        return std::nullopt;
+    }
+    if (previous.mRenderedLayers.size() != mLayers.size()) {
+        return std::nullopt;
+    }
+
+    Region dirtyRegion;
+    for (size_t i = 0; i < mLayers.size(); ++i) {
+        const Layer& layer = mLayers[i];
+        const RenderedLayer& rendered = previous.mRenderedLayers[i];
+        if (rendered.id != layer.getState()->getId() ||
+            rendered.hash != layer.getState()->getHash()) {
+            return std::nullopt;
+        }
+
+        const auto& buffer = layer.getBuffer();
+        const uint64_t bufferId = buffer ? buffer->getId() : 0;
+        if (rendered.bufferId != bufferId || rendered.frameNumber != layer.getFrameNumber()) {
+            Rect dirty;
+            if (layer.getDisplayFrame().intersect(textureBounds, &dirty)) {
+                dirtyRegion.orSelf(alignToTiles(dirty, textureBounds, kDirtyTileSize));
+            }
+        }
+    }
+
+    if (static_cast<size_t>(std::distance(dirtyRegion.begin(), dirtyRegion.end())) >
+        kMaxDirtyRects) {
+        dirtyRegion = Region(dirtyRegion.getBounds());
+    }
+
+    // Past half of the texture, drawing everything once is cheaper than copying and redrawing.
+    int64_t dirtyArea = 0;
+    for (const Rect& rect : dirtyRegion) {
+        dirtyArea += static_cast<int64_t>(rect.getWidth()) * rect.getHeight();
+    }
+    const int64_t textureArea =
+            static_cast<int64_t>(textureBounds.getWidth()) * textureBounds.getHeight();
+    if (dirtyArea * 2 > textureArea) {
+        return std::nullopt;
+    }
+    return dirtyRegion;
+}
+
 void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& texturePool,
                        const OutputCompositionState& outputState,
-                       bool deviceHandlesColorTransform) {
+                       bool deviceHandlesColorTransform, const CachedSet* previous) {
     ATRACE_CALL();
     const Rect& viewport = outputState.layerStackSpace.getContent();
     const ui::Dataspace& outputDataspace = outputState.dataspace;
@@ -175,8 +349,20 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
             .deviceHandlesColorTransform = deviceHandlesColorTransform,
             .orientation = orientation,
             .targetLuminanceNits = outputState.displayBrightnessNits,
+            // The display keeps drawing the layers of the set until it is rendered.
+            .isDeferrable = true,
     };
 
+    // Render only the part of the framebuffer the layers cover if a smaller texture fits it.
+    const auto partialTextureBounds = getPartialTextureBounds(texturePool, outputState);
+    if (partialTextureBounds) {
+        displaySettings.physicalDisplay =
+                Rect(partialTextureBounds->width(), partialTextureBounds->height());
+        displaySettings.clip =
+                outputState.framebufferSpace.getTransform(outputState.layerStackSpace)
+                        .transform(*partialTextureBounds);
+    }
+
     LayerFE::ClientCompositionTargetSettings targetSettings{
             .clip = Region(viewport),
             .needsFiltering = false,
@@ -259,7 +445,10 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         layerSettings.emplace_back(highlight);
     }
 
-    auto texture = texturePool.borrowTexture();
+    auto texture = partialTextureBounds
+            ? texturePool.borrowTexture(
+                      ui::Size(partialTextureBounds->width(), partialTextureBounds->height()))
+            : texturePool.borrowTexture();
     LOG_ALWAYS_FATAL_IF(texture->get()->getBuffer()->initCheck() != OK);
 
     base::unique_fd bufferFence;
@@ -271,6 +460,55 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         bufferFence.reset(texture->getReadyFence()->dup());
     }
 
+    // If only some layers changed since `previous` was rendered, copy its texture and draw only
+    // the tiles covering them. RenderEngine has no scissor, so each layer is cropped to each tile.
+    const Rect textureBounds =
+            partialTextureBounds.value_or(texture->get()->getBuffer()->getBounds());
+    std::optional<Region> dirtyRegion;
+    if (previous &&
+        std::all_of(layerSettings.cbegin(), layerSettings.cend(), canClipLayerSettings)) {
+        dirtyRegion = getDirtyRegionSince(*previous, outputState, displaySettings, textureBounds);
+    }
+    if (dirtyRegion) {
+        const ui::Transform layerStackTransform =
+                outputState.framebufferSpace.getTransform(outputState.layerStackSpace);
+
+        renderengine::LayerSettings previousTextureSettings;
+        previousTextureSettings.name = std::string("previous cached set");
+        previousTextureSettings.geometry.boundaries = displaySettings.clip.toFloatRect();
+        previousTextureSettings.source.buffer.buffer = previous->getBuffer();
+        previousTextureSettings.source.buffer.textureTransform =
+                ui::Transform(layerStackTransform.inverse().getOrientation(), 1, 1).asMatrix4();
+        previousTextureSettings.sourceDataspace = outputDataspace;
+        previousTextureSettings.alpha = 1.0f;
+        previousTextureSettings.disableBlending = true;
+        previousTextureSettings.whitePointNits = displaySettings.targetLuminanceNits;
+
+        std::vector<renderengine::LayerSettings> partialLayerSettings;
+        partialLayerSettings.push_back(std::move(previousTextureSettings));
+        for (const Rect& dirtyRect : *dirtyRegion) {
+            const FloatRect clip = layerStackTransform.transform(dirtyRect).toFloatRect();
+
+            // This mimics Layer::prepareClearClientComposition
+            renderengine::LayerSettings clearSettings;
+            clearSettings.name = std::string("dirty tile clear");
+            clearSettings.geometry.boundaries = clip;
+            clearSettings.source.solidColor = half3(0.0f, 0.0f, 0.0f);
+            clearSettings.alpha = 0.0f;
+            clearSettings.disableBlending = true;
+            partialLayerSettings.push_back(std::move(clearSettings));
+
+            for (const auto& settings : layerSettings) {
+                if (auto clipped = clipLayerSettings(settings, clip)) {
+                    partialLayerSettings.push_back(std::move(*clipped));
+                }
+            }
+        }
+        ATRACE_FORMAT("Rendering %zu dirty rects",
+                      static_cast<size_t>(std::distance(dirtyRegion->begin(), dirtyRegion->end())));
+        layerSettings = std::move(partialLayerSettings);
+    }
+
     constexpr bool kUseFramebufferCache = false;
 
     auto fenceResult = renderEngine
@@ -283,12 +521,24 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         mOutputSpace = outputState.framebufferSpace;
         mTexture = texture;
         mTexture->setReadyFence(mDrawFence);
+        mTextureBounds = textureBounds;
         mOutputSpace.setOrientation(outputState.framebufferSpace.getOrientation());
         mOutputDataspace = outputDataspace;
         mOrientation = orientation;
         mSkipCount = 0;
+        mRenderedDisplaySettings = displaySettings;
+        mRenderedLayers.clear();
+        for (const auto& layer : mLayers) {
+            const auto& buffer = layer.getBuffer();
+            mRenderedLayers.push_back({.id = layer.getState()->getId(),
+                                       .hash = layer.getState()->getHash(),
+                                       .bufferId = buffer ? buffer->getId() : 0,
+                                       .frameNumber = layer.getFrameNumber()});
+        }
+        mPartiallyRendered = dirtyRegion.has_value();
     } else {
         mTexture.reset();
+        mPartiallyRendered = false;
     }
 }
 
@@ -25,6 +25,8 @@
 
 #include <gui/TraceUtils.h>
 
+#include <cinttypes>
+
 using time_point = std::chrono::steady_clock::time_point;
 using namespace std::chrono_literals;
 
@@ -66,6 +68,7 @@ Flattener::Flattener(renderengine::RenderEngine& renderEngine, const Tunables& t
 NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& layers,
                                        NonBufferHash hash, time_point now) {
     ATRACE_CALL();
+    mCostModel.recordFrame(now);
     const size_t unflattenedDisplayCost = calculateDisplayCost(layers);
     mUnflattenedDisplayCost += unflattenedDisplayCost;
 
@@ -137,7 +140,17 @@ void Flattener::renderCachedSets(
         }
     }
 
-    mNewCachedSet->render(mRenderEngine, mTexturePool, outputState, deviceHandlesColorTransform);
+    mNewCachedSetRenderStart = systemTime();
+    mNewCachedSet->render(mRenderEngine, mTexturePool, outputState, deviceHandlesColorTransform,
+                          mDecomposedCachedSet ? &*mDecomposedCachedSet : nullptr);
+    if (mNewCachedSet->hasRenderedBuffer()) {
+        if (mNewCachedSet->wasPartiallyRendered()) {
+            ++mPartialCachedSetRenderCount;
+        } else {
+            ++mFullCachedSetRenderCount;
+        }
+        mDecomposedCachedSet = std::nullopt;
+    }
 }
 
 void Flattener::dumpLayers(std::string& result) const {
@@ -188,6 +201,8 @@ void Flattener::dump(std::string& result) const {
     base::StringAppendF(&result, "\n    Cached sets created: %zd\n", mCachedSetCreationCount);
     base::StringAppendF(&result, "    Cost: %.2f\n",
                         static_cast<float>(mCachedSetCreationCost) / displayArea);
+    base::StringAppendF(&result, "    Renders: %zd full, %zd of changed tiles only\n",
+                        mFullCachedSetRenderCount, mPartialCachedSetRenderCount);
 
     const auto lastUpdate =
             std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastGeometryUpdate);
@@ -196,6 +211,9 @@ void Flattener::dump(std::string& result) const {
 
     dumpLayers(result);
 
+    base::StringAppendF(&result, "\n");
+    mCostModel.dump(result);
+
     base::StringAppendF(&result, "\n");
     mTexturePool.dump(result);
 }
@@ -245,6 +263,7 @@ void Flattener::resetActivities(NonBufferHash hash, time_point now) {
         ++mInvalidatedCachedSetAges[mNewCachedSet->getAge()];
         mNewCachedSet = std::nullopt;
     }
+    mDecomposedCachedSet = std::nullopt;
 }
 
 NonBufferHash Flattener::computeLayersHash() const{
@@ -305,6 +324,7 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
                 mNewCachedSet = std::nullopt;
             } else if (mNewCachedSet->hasReadyBuffer()) {
                 ALOGV("[%s] Found ready buffer", __func__);
+                mCostModel.recordRender(*mNewCachedSet, mNewCachedSetRenderStart);
                 size_t skipCount = mNewCachedSet->getLayerCount();
                 while (skipCount != 0) {
                     auto* peekThroughLayer = mNewCachedSet->getHolePunchLayer();
@@ -370,6 +390,11 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
         } else if (currentLayerIter->getLayerCount() > 1) {
             // Break the current layer into its constituent layers
             ++mInvalidatedCachedSetAges[currentLayerIter->getAge()];
+            // Keep its texture so that the same layers can be flattened again by only rendering
+            // what changed since.
+            if (currentLayerIter->hasRenderedBuffer()) {
+                mDecomposedCachedSet.emplace(*currentLayerIter);
+            }
             for (CachedSet& layer : currentLayerIter->decompose()) {
                 bool disableBlur =
                         priorBlurLayer && priorBlurLayer == (*incomingLayerIter)->getOutputLayer();
@@ -396,6 +421,9 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
 
     for (const CachedSet& layer : merged) {
         mFlattenedDisplayCost += layer.getDisplayCost();
+        if (layer.getLayerCount() > 1 && layer.hasRenderedBuffer()) {
+            mCostModel.recordDisplayedFrame(layer);
+        }
     }
 
     mLayers = std::move(merged);
@@ -472,13 +500,40 @@ std::vector<Flattener::Run> Flattener::findCandidateRuns(time_point now) const {
     return runs;
 }
 
-std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>& runs) const {
-    if (runs.empty()) {
-        return std::nullopt;
+FlattenerCostModel::Estimate Flattener::estimateRun(const Run& run, time_point now) const {
+    std::vector<const CachedSet*> sets;
+    size_t layerCount = 0;
+    for (auto set = run.getStart(); layerCount < run.getLayerLength(); ++set) {
+        sets.push_back(&(*set));
+        layerCount += set->getLayerCount();
     }
+    return mCostModel.estimate(sets, now);
+}
 
-    // TODO (b/181192467): Choose the best run, instead of just the first.
-    return runs[0];
+std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>& runs,
+                                                     time_point now) const {
+    std::optional<Run> bestRun;
+    int64_t bestSavings = 0;
+    for (const Run& run : runs) {
+        const auto estimate = estimateRun(run, now);
+        ALOGV("[%s] Run of %zu layers: %" PRId64 " bytes saved per frame, %" PRId64
+              " bytes to render, idle for %" PRId64 " ns, net savings %" PRId64,
+              __func__, run.getLayerLength(), estimate.frameSavings, estimate.renderCost,
+              static_cast<int64_t>(estimate.expectedIdle.count()), estimate.netSavings);
+
+        // The cost model does not account for what a hole punch saves, which is keeping the
+        // punched through layer on its own DPU plane, so such runs are always worth flattening.
+        const bool requiresHolePunch =
+                run.getHolePunchCandidate() && run.getHolePunchCandidate()->requiresHolePunch();
+        if (estimate.netSavings <= 0 && !requiresHolePunch) {
+            continue;
+        }
+        if (!bestRun || estimate.netSavings > bestSavings) {
+            bestRun.emplace(run);
+            bestSavings = estimate.netSavings;
+        }
+    }
+    return bestRun;
 }
 
 void Flattener::buildCachedSets(time_point now) {
@@ -510,9 +565,10 @@ void Flattener::buildCachedSets(time_point now) {
 
     std::vector<Run> runs = findCandidateRuns(now);
 
-    std::optional<Run> bestRun = findBestRun(runs);
+    std::optional<Run> bestRun = findBestRun(runs, now);
 
     if (!bestRun) {
+        ATRACE_NAME("no run saves enough to flatten");
         return;
     }
 
@@ -541,6 +597,7 @@ void Flattener::buildCachedSets(time_point now) {
 
     ++mCachedSetCreationCount;
     mCachedSetCreationCost += mNewCachedSet->getCreationCost();
+    mCostModel.recordPredictedSavings(estimateRun(*bestRun, now));
 
     // note the compiler should strip the follow no-op statements when ALOGV is off
     const auto dumper = [&] {
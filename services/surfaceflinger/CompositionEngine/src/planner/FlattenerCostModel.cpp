@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "Planner"
+// #define LOG_NDEBUG 0
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/impl/planner/FlattenerCostModel.h>
+#include <ui/PixelFormat.h>
+
+#include <algorithm>
+
+namespace android::compositionengine::impl::planner {
+
+namespace {
+// Cached sets are rendered into RGBA_8888 textures.
+constexpr int64_t kTextureBytesPerPixel = 4;
+// Weight of the newest sample in the running averages.
+constexpr float kLearningRate = 0.25f;
+
+int64_t getArea(const Rect& rect) {
+    return rect.isValid() ? static_cast<int64_t>(rect.getWidth()) * rect.getHeight() : 0;
+}
+
+float toMegabytes(int64_t bytes) {
+    return static_cast<float>(bytes) / (1024.f * 1024.f);
+}
+} // namespace
+
+void FlattenerCostModel::recordFrame(std::chrono::steady_clock::time_point now) {
+    if (mLastFrameTime && now > *mLastFrameTime) {
+        const auto interval = std::clamp<std::chrono::nanoseconds>(now - *mLastFrameTime, 1ms, 1s);
+        mFrameInterval = std::chrono::nanoseconds(static_cast<int64_t>(
+                kLearningRate * static_cast<float>(interval.count()) +
+                (1.f - kLearningRate) * static_cast<float>(mFrameInterval.count())));
+    }
+    mLastFrameTime = now;
+}
+
+FlattenerCostModel::Estimate FlattenerCostModel::estimate(
+        const std::vector<const CachedSet*>& sets,
+        std::chrono::steady_clock::time_point now) const {
+    Estimate estimate;
+    if (sets.empty()) {
+        return estimate;
+    }
+
+    Region bounds;
+    estimate.expectedIdle = kMaxExpectedIdle;
+    for (const CachedSet* set : sets) {
+        bounds.orSelf(set->getBounds());
+        estimate.expectedIdle = std::min(estimate.expectedIdle, getExpectedIdle(*set, now));
+    }
+    const Rect textureBounds = bounds.getBounds();
+
+    estimate.frameSavings = getFrameSavings(sets, textureBounds);
+    estimate.renderCost = getRenderCost(sets, textureBounds, std::nullopt);
+
+    const float expectedFrames = static_cast<float>(estimate.expectedIdle.count()) /
+            static_cast<float>(mFrameInterval.count());
+    estimate.netSavings =
+            static_cast<int64_t>(expectedFrames * static_cast<float>(estimate.frameSavings)) -
+            estimate.renderCost;
+    return estimate;
+}
+
+void FlattenerCostModel::recordPredictedSavings(const Estimate& estimate) {
+    ++mPredictionCount;
+    mPredictedSavings += estimate.netSavings;
+}
+
+void FlattenerCostModel::recordDisplayedFrame(const CachedSet& cachedSet) {
+    mRealizedSavings += getFrameSavings({&cachedSet}, cachedSet.getTextureBounds());
+}
+
+void FlattenerCostModel::recordRender(const CachedSet& cachedSet, nsecs_t renderStart) {
+    const nsecs_t signalTime = cachedSet.getDrawFence() ? cachedSet.getDrawFence()->getSignalTime()
+                                                        : Fence::SIGNAL_TIME_INVALID;
+    std::optional<std::chrono::nanoseconds> gpuDuration;
+    if (signalTime != Fence::SIGNAL_TIME_INVALID && signalTime != Fence::SIGNAL_TIME_PENDING &&
+        signalTime > renderStart) {
+        gpuDuration = std::chrono::nanoseconds(signalTime - renderStart);
+    }
+
+    const Rect& textureBounds = cachedSet.getTextureBounds();
+    if (gpuDuration) {
+        int64_t pixels = getArea(textureBounds);
+        for (const auto& layer : cachedSet.getConstituentLayers()) {
+            pixels += getArea(layer.getDisplayFrame());
+        }
+        if (pixels > 0) {
+            const float nsPerPixel =
+                    static_cast<float>(gpuDuration->count()) / static_cast<float>(pixels);
+            mGpuNsPerPixel = kLearningRate * nsPerPixel + (1.f - kLearningRate) * mGpuNsPerPixel;
+            ++mMeasuredRenderCount;
+        }
+    }
+
+    mRealizedSavings -= getRenderCost({&cachedSet}, textureBounds, gpuDuration);
+}
+
+void FlattenerCostModel::dump(std::string& result) const {
+    result.append("  Cost model:\n");
+    base::StringAppendF(&result, "    Frame interval: %.2f ms\n",
+                        static_cast<float>(mFrameInterval.count()) / 1e6f);
+    base::StringAppendF(&result, "    GPU render cost: %.3f ns/pixel (%zu renders measured)\n",
+                        mGpuNsPerPixel, mMeasuredRenderCount);
+    base::StringAppendF(&result, "    Predicted savings: %.2f MB over %zu cached sets\n",
+                        toMegabytes(mPredictedSavings), mPredictionCount);
+    base::StringAppendF(&result, "    Realized savings:  %.2f MB\n",
+                        toMegabytes(mRealizedSavings));
+}
+
+int64_t FlattenerCostModel::getLayerBytes(const CachedSet::Layer& layer) {
+    // Solid color layers are generated by the DPU without reading memory.
+    const auto& buffer = layer.getBuffer();
+    if (!buffer) {
+        return 0;
+    }
+    // The size of multi-planar formats isn't known, so assume they are as large as RGBA_8888.
+    const uint32_t bytesPerPixel = android::bytesPerPixel(buffer->getPixelFormat());
+    return getArea(layer.getDisplayFrame()) *
+            (bytesPerPixel > 0 ? static_cast<int64_t>(bytesPerPixel) : kTextureBytesPerPixel);
+}
+
+int64_t FlattenerCostModel::getFrameSavings(const std::vector<const CachedSet*>& sets,
+                                            const Rect& textureBounds) {
+    int64_t savings = -(getArea(textureBounds) * kTextureBytesPerPixel + kLayerOverheadBytes);
+    for (const CachedSet* set : sets) {
+        for (const auto& layer : set->getConstituentLayers()) {
+            savings += getLayerBytes(layer) + kLayerOverheadBytes;
+        }
+    }
+    return savings;
+}
+
+std::chrono::nanoseconds FlattenerCostModel::getExpectedIdle(
+        const CachedSet& cachedSet, std::chrono::steady_clock::time_point now) {
+    const auto idle = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - cachedSet.getLastUpdate());
+
+    float fps = 0.f;
+    for (const auto& layer : cachedSet.getConstituentLayers()) {
+        fps = std::max(fps, layer.getState()->getFps());
+    }
+
+    // If LayerHistory expects the next frame, the layers will be idle until then. Otherwise they
+    // are expected to stay idle for as long as they have been.
+    std::chrono::nanoseconds expectedIdle = idle;
+    if (fps > 0.f) {
+        const auto period = std::chrono::nanoseconds(static_cast<int64_t>(1e9f / fps));
+        if (period > idle) {
+            expectedIdle = period - idle;
+        }
+    }
+    return std::min(expectedIdle, kMaxExpectedIdle);
+}
+
+int64_t FlattenerCostModel::getRenderCost(
+        const std::vector<const CachedSet*>& sets, const Rect& textureBounds,
+        std::optional<std::chrono::nanoseconds> gpuDuration) const {
+    int64_t pixels = getArea(textureBounds);
+    int64_t traffic = pixels * kTextureBytesPerPixel;
+    for (const CachedSet* set : sets) {
+        for (const auto& layer : set->getConstituentLayers()) {
+            pixels += getArea(layer.getDisplayFrame());
+            traffic += getLayerBytes(layer);
+        }
+    }
+
+    const int64_t gpuNs = gpuDuration
+            ? gpuDuration->count()
+            : static_cast<int64_t>(mGpuNsPerPixel * static_cast<float>(pixels));
+    return traffic + gpuNs * kGpuBusyBytesPerNs;
+}
+
+} // namespace android::compositionengine::impl::planner
@@ -19,18 +19,38 @@
 #undef LOG_TAG
 #define LOG_TAG "Planner"
 
+#include <algorithm>
+
 #include <compositionengine/impl/planner/TexturePool.h>
 #include <renderengine/impl/ExternalTexture.h>
 #include <utils/Log.h>
 
 namespace android::compositionengine::impl::planner {
 
+namespace {
+
+int32_t roundUpToPowerOfTwo(int32_t value) {
+    int32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+bool isSize(const renderengine::ExternalTexture& texture, ui::Size size) {
+    return static_cast<int32_t>(texture.getBuffer()->getWidth()) == size.getWidth() &&
+            static_cast<int32_t>(texture.getBuffer()->getHeight()) == size.getHeight();
+}
+
+} // namespace
+
 void TexturePool::allocatePool() {
     mPool.clear();
+    mTilePool.clear();
     if (mEnabled && mSize.isValid()) {
         mPool.resize(kMinPoolSize);
         std::generate_n(mPool.begin(), kMinPoolSize, [&]() {
-            return Entry{genTexture(), nullptr};
+            return Entry{genTexture(mSize), nullptr};
         });
     }
 }
@@ -45,7 +65,7 @@ void TexturePool::setDisplaySize(ui::Size size) {
 
 std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture() {
     if (mPool.empty()) {
-        return std::make_shared<AutoTexture>(*this, genTexture(), nullptr);
+        return std::make_shared<AutoTexture>(*this, genTexture(mSize), nullptr);
     }
 
     const auto entry = mPool.front();
@@ -53,6 +73,33 @@ std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture() {
     return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
 }
 
+ui::Size TexturePool::getTextureSize(ui::Size minSize) const {
+    const auto roundUp = [](int32_t dimension, int32_t displayDimension) {
+        return std::min(roundUpToPowerOfTwo(std::max(dimension, kMinTileDimension)),
+                        displayDimension);
+    };
+    return ui::Size(roundUp(minSize.getWidth(), mSize.getWidth()),
+                    roundUp(minSize.getHeight(), mSize.getHeight()));
+}
+
+std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture(ui::Size size) {
+    if (size == mSize) {
+        return borrowTexture();
+    }
+
+    // Prefer the most recently returned texture, which is the most likely to be in cache.
+    const auto it =
+            std::find_if(mTilePool.rbegin(), mTilePool.rend(),
+                         [size](const Entry& entry) { return isSize(*entry.texture, size); });
+    if (it == mTilePool.rend()) {
+        return std::make_shared<AutoTexture>(*this, genTexture(size), nullptr);
+    }
+
+    const auto entry = *it;
+    mTilePool.erase(std::next(it).base());
+    return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
+}
+
 void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
                                 const sp<Fence>& fence) {
     // Drop the texture on the floor if the pool is not enabled
@@ -60,9 +107,18 @@ void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&&
         return;
     }
 
+    const ui::Size size(static_cast<int32_t>(texture->getBuffer()->getWidth()),
+                        static_cast<int32_t>(texture->getBuffer()->getHeight()));
+    if (size != mSize && getTextureSize(size) == size) {
+        if (mTilePool.size() == kMaxTilePoolSize) {
+            mTilePool.pop_front();
+        }
+        mTilePool.push_back({std::move(texture), fence});
+        return;
+    }
+
     // Or the texture on the floor if the pool is no longer tracking textures of the same size.
-    if (static_cast<int32_t>(texture->getBuffer()->getWidth()) != mSize.getWidth() ||
-        static_cast<int32_t>(texture->getBuffer()->getHeight()) != mSize.getHeight()) {
+    if (size != mSize) {
         ALOGV("Deallocating texture from Planner's pool - display size changed (previous: (%dx%d), "
               "current: (%dx%d))",
               texture->getBuffer()->getWidth(), texture->getBuffer()->getHeight(), mSize.getWidth(),
@@ -80,13 +136,13 @@ void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&&
     mPool.push_back({std::move(texture), fence});
 }
 
-std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
-    LOG_ALWAYS_FATAL_IF(!mSize.isValid(), "Attempted to generate texture with invalid size");
+std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture(ui::Size size) {
+    LOG_ALWAYS_FATAL_IF(!size.isValid(), "Attempted to generate texture with invalid size");
     return std::make_shared<
             renderengine::impl::
                     ExternalTexture>(sp<GraphicBuffer>::
-                                             make(static_cast<uint32_t>(mSize.getWidth()),
-                                                  static_cast<uint32_t>(mSize.getHeight()),
+                                             make(static_cast<uint32_t>(size.getWidth()),
+                                                  static_cast<uint32_t>(size.getHeight()),
                                                   HAL_PIXEL_FORMAT_RGBA_8888, 1U,
                                                   static_cast<uint64_t>(
                                                           GraphicBuffer::USAGE_HW_RENDER |
@@ -105,8 +161,15 @@ void TexturePool::setEnabled(bool enabled) {
 
 void TexturePool::dump(std::string& out) const {
     base::StringAppendF(&out,
-                        "TexturePool (%s) has %zu buffers of size [%" PRId32 ", %" PRId32 "]\n",
-                        mEnabled ? "enabled" : "disabled", mPool.size(), mSize.width, mSize.height);
+                        "TexturePool (%s) has %zu buffers of size [%" PRId32 ", %" PRId32
+                        "] and %zu smaller buffers\n",
+                        mEnabled ? "enabled" : "disabled", mPool.size(), mSize.width, mSize.height,
+                        mTilePool.size());
+    for (const auto& entry : mTilePool) {
+        base::StringAppendF(&out, "    [%" PRIu32 ", %" PRIu32 "]\n",
+                            entry.texture->getBuffer()->getWidth(),
+                            entry.texture->getBuffer()->getHeight());
+    }
 }
 
 } // namespace android::compositionengine::impl::planner
\ No newline at end of file
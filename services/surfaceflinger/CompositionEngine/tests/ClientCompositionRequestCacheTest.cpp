@@ -0,0 +1,77 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/ClientCompositionRequestCache.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+namespace {
+
+using impl::ClientCompositionRequestCache;
+
+std::vector<LayerFE::LayerSettings> makeLayers(float left) {
+    LayerFE::LayerSettings layer;
+    layer.geometry.boundaries = FloatRect{left, 0, left + 10, 10};
+    return {layer};
+}
+
+TEST(ClientCompositionRequestCacheTest, matchesRequestRenderedIntoBuffer) {
+    ClientCompositionRequestCache cache(3);
+    const renderengine::DisplaySettings display;
+
+    EXPECT_FALSE(cache.exists(1, display, makeLayers(0)));
+    cache.add(1, display, makeLayers(0));
+    cache.add(2, display, makeLayers(5));
+
+    EXPECT_TRUE(cache.exists(1, display, makeLayers(0)));
+    EXPECT_FALSE(cache.exists(1, display, makeLayers(5)));
+    EXPECT_TRUE(cache.exists(2, display, makeLayers(5)));
+
+    // The buffer now holds the newer request.
+    cache.add(1, display, makeLayers(5));
+    EXPECT_FALSE(cache.exists(1, display, makeLayers(0)));
+    EXPECT_TRUE(cache.exists(1, display, makeLayers(5)));
+
+    EXPECT_EQ(3u, cache.getStats().hits);
+    EXPECT_EQ(3u, cache.getStats().misses);
+}
+
+TEST(ClientCompositionRequestCacheTest, evictsLeastRecentlyUsedBuffer) {
+    ClientCompositionRequestCache cache(2);
+    const renderengine::DisplaySettings display;
+
+    cache.add(1, display, makeLayers(0));
+    cache.add(2, display, makeLayers(0));
+    ASSERT_TRUE(cache.exists(1, display, makeLayers(0)));
+
+    cache.add(3, display, makeLayers(0));
+
+    EXPECT_TRUE(cache.exists(1, display, makeLayers(0)));
+    EXPECT_FALSE(cache.exists(2, display, makeLayers(0)));
+    EXPECT_TRUE(cache.exists(3, display, makeLayers(0)));
+}
+
+TEST(ClientCompositionRequestCacheTest, removesBuffer) {
+    ClientCompositionRequestCache cache(2);
+    const renderengine::DisplaySettings display;
+
+    cache.add(1, display, makeLayers(0));
+    cache.remove(1);
+    EXPECT_FALSE(cache.exists(1, display, makeLayers(0)));
+}
+
+} // namespace
+} // namespace android::compositionengine
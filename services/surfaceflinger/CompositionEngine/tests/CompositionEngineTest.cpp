@@ -23,12 +23,21 @@
 #include <gtest/gtest.h>
 #include <renderengine/mock/RenderEngine.h>
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "MockHWComposer.h"
 #include "TimeStats/TimeStats.h"
 
 namespace android::compositionengine {
 namespace {
 
+using namespace std::chrono_literals;
+
 using ::testing::_;
 using ::testing::DoAll;
 using ::testing::InSequence;
@@ -116,6 +125,106 @@ TEST_F(CompositionEnginePresentTest, worksAsExpected) {
     mEngine.present(mRefreshArgs);
 }
 
+struct CompositionEngineParallelPresentTest : public CompositionEnginePresentTest {
+    static constexpr std::chrono::milliseconds kPresentDuration = 20ms;
+
+    CompositionEngineParallelPresentTest() {
+        EXPECT_CALL(mEngine, preComposition(Ref(mRefreshArgs)));
+        for (const auto& output : {mOutput1, mOutput2, mOutput3}) {
+            EXPECT_CALL(*output, prepare(Ref(mRefreshArgs), _));
+            EXPECT_CALL(*output, getOutputLayerCount()).WillRepeatedly(Return(0u));
+            EXPECT_CALL(*output, present(Ref(mRefreshArgs)))
+                    .WillOnce([this, output = output.get()](const CompositionRefreshArgs&) {
+                        std::this_thread::sleep_for(kPresentDuration);
+                        std::scoped_lock lock(mMutex);
+                        mPresentThreads[output] = std::this_thread::get_id();
+                        mPresentOrder.push_back(output);
+                    });
+        }
+
+        mRefreshArgs.outputs = {mOutput1, mOutput2, mOutput3};
+        mRefreshArgs.parallelPresent = true;
+    }
+
+    std::thread::id getPresentThread(const std::shared_ptr<mock::Output>& output) {
+        std::scoped_lock lock(mMutex);
+        return mPresentThreads.at(output.get());
+    }
+
+    std::mutex mMutex;
+    std::unordered_map<mock::Output*, std::thread::id> mPresentThreads;
+    std::vector<mock::Output*> mPresentOrder;
+};
+
+TEST_F(CompositionEngineParallelPresentTest, presentsIndependentOutputsConcurrently) {
+    EXPECT_CALL(*mOutput1, supportsParallelPresent()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mOutput2, supportsParallelPresent()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mOutput3, supportsParallelPresent()).WillRepeatedly(Return(true));
+
+    const auto start = std::chrono::steady_clock::now();
+    mEngine.present(mRefreshArgs);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Presenting the outputs one after the other takes at least 3 * kPresentDuration.
+    EXPECT_LT(elapsed, 3 * kPresentDuration);
+
+    const auto mainThread = std::this_thread::get_id();
+    EXPECT_EQ(mainThread, getPresentThread(mOutput1));
+    EXPECT_NE(mainThread, getPresentThread(mOutput2));
+    EXPECT_NE(mainThread, getPresentThread(mOutput3));
+    EXPECT_NE(getPresentThread(mOutput2), getPresentThread(mOutput3));
+
+    const auto& stats = mEngine.getParallelPresentStats();
+    EXPECT_EQ(1u, stats.frames);
+    // Each output spent at least kPresentDuration presenting, which the main thread would have
+    // spent presenting them serially.
+    EXPECT_GE(std::chrono::nanoseconds(stats.timeSaved), 3 * kPresentDuration - elapsed);
+}
+
+TEST_F(CompositionEngineParallelPresentTest, presentsOutputsSharingLayersInOrderOnOneThread) {
+    EXPECT_CALL(*mOutput1, supportsParallelPresent()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mOutput2, supportsParallelPresent()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mOutput3, supportsParallelPresent()).WillRepeatedly(Return(true));
+
+    sp<StrictMock<mock::LayerFE>> layerFE = sp<StrictMock<mock::LayerFE>>::make();
+    StrictMock<mock::OutputLayer> output1Layer;
+    StrictMock<mock::OutputLayer> output2Layer;
+    EXPECT_CALL(output1Layer, getLayerFE()).WillRepeatedly(ReturnRef(*layerFE));
+    EXPECT_CALL(output2Layer, getLayerFE()).WillRepeatedly(ReturnRef(*layerFE));
+    EXPECT_CALL(*mOutput1, getOutputLayerCount()).WillRepeatedly(Return(1u));
+    EXPECT_CALL(*mOutput1, getOutputLayerOrderedByZByIndex(0))
+            .WillRepeatedly(Return(&output1Layer));
+    EXPECT_CALL(*mOutput2, getOutputLayerCount()).WillRepeatedly(Return(1u));
+    EXPECT_CALL(*mOutput2, getOutputLayerOrderedByZByIndex(0))
+            .WillRepeatedly(Return(&output2Layer));
+
+    mEngine.present(mRefreshArgs);
+
+    const auto mainThread = std::this_thread::get_id();
+    EXPECT_EQ(mainThread, getPresentThread(mOutput1));
+    EXPECT_EQ(mainThread, getPresentThread(mOutput2));
+    EXPECT_NE(mainThread, getPresentThread(mOutput3));
+
+    std::scoped_lock lock(mMutex);
+    const auto output1 = std::find(mPresentOrder.begin(), mPresentOrder.end(), mOutput1.get());
+    const auto output2 = std::find(mPresentOrder.begin(), mPresentOrder.end(), mOutput2.get());
+    EXPECT_LT(output1, output2);
+}
+
+TEST_F(CompositionEngineParallelPresentTest, presentsUnsupportedOutputsOnMainThread) {
+    EXPECT_CALL(*mOutput1, supportsParallelPresent()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mOutput2, supportsParallelPresent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mOutput3, supportsParallelPresent()).WillRepeatedly(Return(false));
+
+    mEngine.present(mRefreshArgs);
+
+    const auto mainThread = std::this_thread::get_id();
+    EXPECT_NE(mainThread, getPresentThread(mOutput1));
+    EXPECT_EQ(mainThread, getPresentThread(mOutput2));
+    EXPECT_EQ(mainThread, getPresentThread(mOutput3));
+    EXPECT_EQ(1u, mEngine.getParallelPresentStats().frames);
+}
+
 /*
  * CompositionEngine::updateCursorAsync
  */
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/CompositionStrategyHistory.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+namespace {
+
+using impl::CompositionStrategyHistory;
+
+CompositionStrategyHistory::Strategy makeStrategy(bool usesClientComposition) {
+    return {.changes = std::make_optional<android::HWComposer::DeviceRequestedChanges>({}),
+            .success = true,
+            .usesClientComposition = usesClientComposition};
+}
+
+TEST(CompositionStrategyHistoryTest, returnsRecordedStrategy) {
+    CompositionStrategyHistory history(4);
+    EXPECT_EQ(nullptr, history.get(1));
+
+    history.record(1, makeStrategy(true));
+    history.record(2, makeStrategy(false));
+
+    const auto* strategy = history.get(1);
+    ASSERT_NE(nullptr, strategy);
+    EXPECT_TRUE(strategy->usesClientComposition);
+    strategy = history.get(2);
+    ASSERT_NE(nullptr, strategy);
+    EXPECT_FALSE(strategy->usesClientComposition);
+}
+
+TEST(CompositionStrategyHistoryTest, recordReplacesStrategy) {
+    CompositionStrategyHistory history(4);
+    history.record(1, makeStrategy(true));
+    history.record(1, makeStrategy(false));
+
+    EXPECT_EQ(1u, history.size());
+    const auto* strategy = history.get(1);
+    ASSERT_NE(nullptr, strategy);
+    EXPECT_FALSE(strategy->usesClientComposition);
+}
+
+TEST(CompositionStrategyHistoryTest, evictsLeastRecentlyUsed) {
+    CompositionStrategyHistory history(2);
+    history.record(1, makeStrategy(true));
+    history.record(2, makeStrategy(true));
+    ASSERT_NE(nullptr, history.get(1));
+
+    history.record(3, makeStrategy(true));
+
+    EXPECT_EQ(2u, history.size());
+    EXPECT_NE(nullptr, history.get(1));
+    EXPECT_EQ(nullptr, history.get(2));
+    EXPECT_NE(nullptr, history.get(3));
+}
+
+TEST(CompositionStrategyHistoryTest, countsPredictions) {
+    CompositionStrategyHistory history(2);
+    history.recordPrediction(true, false);
+    history.recordPrediction(false, false);
+    history.recordPrediction(true, true);
+    history.recordPrediction(false, true);
+    history.recordPrediction(false, true);
+
+    const auto& stats = history.getPredictionStats();
+    EXPECT_EQ(5u, stats.predictions);
+    EXPECT_EQ(2u, stats.hits);
+    EXPECT_EQ(3u, stats.recalledPredictions);
+    EXPECT_EQ(1u, stats.recalledHits);
+
+    std::string dump;
+    history.dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("2/5 hits"));
+    EXPECT_NE(std::string::npos, dump.find("1/3 hits"));
+}
+
+} // namespace
+} // namespace android::compositionengine
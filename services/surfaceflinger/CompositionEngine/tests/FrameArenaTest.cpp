@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include <compositionengine/FrameArena.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+namespace {
+
+using IntVector = std::vector<int, FrameArenaAllocator<int>>;
+
+void fillFrame(FrameArena& arena, size_t count) {
+    IntVector values{FrameArenaAllocator<int>(&arena)};
+    for (size_t i = 0; i < count; i++) {
+        values.push_back(static_cast<int>(i));
+    }
+    std::unordered_set<int, std::hash<int>, std::equal_to<int>, FrameArenaAllocator<int>>
+            set(0, std::hash<int>(), std::equal_to<int>(), FrameArenaAllocator<int>(&arena));
+    set.insert(values.begin(), values.end());
+    EXPECT_EQ(count, set.size());
+}
+
+TEST(FrameArenaTest, allocationsAreAligned) {
+    FrameArena arena(256);
+    for (size_t alignment : {1u, 2u, 4u, 8u, 16u, 64u}) {
+        arena.allocate(1, 1);
+        const auto address = reinterpret_cast<uintptr_t>(arena.allocate(3, alignment));
+        EXPECT_EQ(0u, address % alignment);
+    }
+}
+
+TEST(FrameArenaTest, growsWithinAFrame) {
+    FrameArena arena(64);
+    arena.allocate(48, 8);
+    arena.allocate(48, 8);
+    arena.allocate(1024, 8);
+
+    EXPECT_EQ(2u, arena.getStats().heapAllocationsThisFrame);
+    EXPECT_GE(arena.getStats().capacity, 64u + 1024u);
+}
+
+TEST(FrameArenaTest, steadyStateFramesDoNotAllocate) {
+    FrameArena arena(64);
+
+    fillFrame(arena, 500);
+    arena.reset();
+    EXPECT_GT(arena.getStats().heapAllocationsLastFrame, 0u);
+
+    // After one frame the arena is a single block sized for the whole frame.
+    for (int frame = 0; frame < 3; frame++) {
+        fillFrame(arena, 500);
+        arena.reset();
+        EXPECT_EQ(0u, arena.getStats().heapAllocationsLastFrame);
+        EXPECT_GT(arena.getStats().bytesUsedLastFrame, 0u);
+        EXPECT_LE(arena.getStats().bytesUsedLastFrame, arena.getStats().capacity);
+    }
+}
+
+TEST(FrameArenaTest, smallerFramesReuseCapacity) {
+    FrameArena arena(64);
+    fillFrame(arena, 500);
+    arena.reset();
+    const size_t capacity = arena.getStats().capacity;
+
+    fillFrame(arena, 10);
+    arena.reset();
+    EXPECT_EQ(0u, arena.getStats().heapAllocationsLastFrame);
+    EXPECT_EQ(capacity, arena.getStats().capacity);
+}
+
+TEST(FrameArenaTest, allocatorWithoutArenaUsesHeap) {
+    IntVector values;
+    values.assign(100, 7);
+    EXPECT_EQ(nullptr, values.get_allocator().getArena());
+    EXPECT_EQ(100u, values.size());
+}
+
+TEST(FrameArenaTest, allocatorsCompareByArena) {
+    FrameArena arena;
+    FrameArena other;
+    EXPECT_EQ(FrameArenaAllocator<int>(&arena), FrameArenaAllocator<char>(&arena));
+    EXPECT_NE(FrameArenaAllocator<int>(&arena), FrameArenaAllocator<int>(&other));
+    EXPECT_NE(FrameArenaAllocator<int>(&arena), FrameArenaAllocator<int>());
+}
+
+TEST(FrameArenaTest, dumpReportsLastFrame) {
+    FrameArena arena(128);
+    arena.allocate(32, 8);
+    arena.reset();
+
+    std::string result;
+    arena.dump(result);
+    EXPECT_EQ("FrameArena: capacity=128 bytesUsedLastFrame=32 heapAllocationsLastFrame=0\n", result);
+}
+
+} // namespace
+} // namespace android::compositionengine
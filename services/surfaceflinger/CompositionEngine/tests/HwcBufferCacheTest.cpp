@@ -190,5 +190,111 @@ TEST_F(HwcBufferCacheTest, uncache_whenOverrideUncached_returnsInvalidSlotNumber
     EXPECT_EQ(cache.uncache(mBuffer2->getId()), UINT32_MAX);
 }
 
+std::vector<sp<GraphicBuffer>> makeBuffers(size_t count) {
+    std::vector<sp<GraphicBuffer>> buffers;
+    for (size_t i = 0; i < count; ++i) {
+        buffers.push_back(sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u));
+    }
+    return buffers;
+}
+
+uint32_t cycleThroughBuffers(HwcBufferCache& cache, const std::vector<sp<GraphicBuffer>>& buffers,
+                             int cycles) {
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        for (const auto& buffer : buffers) {
+            cache.getHwcSlotAndBuffer(buffer);
+        }
+    }
+    return cache.getReimportCount();
+}
+
+TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_learnsCycleLength) {
+    HwcBufferCache cache;
+    const auto buffers = makeBuffers(3);
+
+    cycleThroughBuffers(cache, buffers, 3);
+    EXPECT_EQ(3u, cache.getCycleLength());
+
+    // sending the same buffer again doesn't shorten the cycle
+    cache.getHwcSlotAndBuffer(buffers.back());
+    EXPECT_EQ(3u, cache.getCycleLength());
+    EXPECT_EQ(0u, cache.getReimportCount());
+}
+
+TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_whenTracking_reimportsFewerBuffersOfLongCycles) {
+    HwcBufferCache lruCache;
+    HwcBufferCache trackingCache;
+    trackingCache.setTracking(true);
+    const auto buffers = makeBuffers(BufferQueue::NUM_BUFFER_SLOTS + 6);
+
+    const uint32_t lruReimports = cycleThroughBuffers(lruCache, buffers, 10);
+    const uint32_t trackingReimports = cycleThroughBuffers(trackingCache, buffers, 10);
+
+    // the least recently used buffer is always the next one in the cycle
+    EXPECT_EQ(9 * buffers.size(), lruReimports);
+    EXPECT_LT(trackingReimports, lruReimports / 4);
+    EXPECT_EQ(buffers.size(), trackingCache.getCycleLength());
+}
+
+TEST_F(HwcBufferCacheTest, prefetch_whenNotTracking_returnsNullopt) {
+    HwcBufferCache cache;
+    cache.getHwcSlotAndBuffer(mBuffer1);
+
+    EXPECT_FALSE(cache.prefetch(mBuffer2));
+}
+
+TEST_F(HwcBufferCacheTest, prefetch_whenNoBufferSent_returnsNullopt) {
+    HwcBufferCache cache;
+    cache.setTracking(true);
+
+    EXPECT_FALSE(cache.prefetch(mBuffer1));
+}
+
+TEST_F(HwcBufferCacheTest, prefetch_returnsSlotAndBuffer_andBufferIsNotSentAgain) {
+    HwcBufferCache cache;
+    cache.setTracking(true);
+    HwcSlotAndBuffer slotAndBufferFor1 = cache.getHwcSlotAndBuffer(mBuffer1);
+
+    const auto prefetched = cache.prefetch(mBuffer2);
+    ASSERT_TRUE(prefetched);
+    EXPECT_NE(prefetched->slot, slotAndBufferFor1.slot);
+    EXPECT_EQ(prefetched->buffer, mBuffer2);
+    EXPECT_FALSE(cache.prefetch(mBuffer2));
+
+    HwcSlotAndBuffer slotAndBufferFor2 = cache.getHwcSlotAndBuffer(mBuffer2);
+    EXPECT_EQ(slotAndBufferFor2.slot, prefetched->slot);
+    EXPECT_EQ(slotAndBufferFor2.buffer, nullptr);
+    EXPECT_EQ(1u, cache.getPrefetchCount());
+    EXPECT_EQ(1u, cache.getPrefetchHitCount());
+}
+
+TEST_F(HwcBufferCacheTest, prefetch_whenSlotsFull_evictsOnlyBuffersOutsideCycle) {
+    HwcBufferCache cache;
+    cache.setTracking(true);
+    const auto buffers = makeBuffers(BufferQueue::NUM_BUFFER_SLOTS);
+    cycleThroughBuffers(cache, buffers, 1);
+
+    // the producer now only cycles through the last two buffers
+    const std::vector<sp<GraphicBuffer>> lastBuffers(buffers.end() - 2, buffers.end());
+    cycleThroughBuffers(cache, lastBuffers, 4);
+    ASSERT_EQ(2u, cache.getCycleLength());
+
+    const auto prefetched = cache.prefetch(mBuffer1);
+    ASSERT_TRUE(prefetched);
+    // the oldest buffer was evicted
+    EXPECT_EQ(cache.uncache(buffers.front()->getId()), UINT32_MAX);
+    EXPECT_EQ(cache.uncache(mBuffer1->getId()), prefetched->slot);
+}
+
+TEST_F(HwcBufferCacheTest, prefetch_whenSlotsFullWithCycle_returnsNullopt) {
+    HwcBufferCache cache;
+    cache.setTracking(true);
+    const auto buffers = makeBuffers(BufferQueue::NUM_BUFFER_SLOTS);
+    cycleThroughBuffers(cache, buffers, 2);
+    ASSERT_EQ(buffers.size(), cache.getCycleLength());
+
+    EXPECT_FALSE(cache.prefetch(mBuffer1));
+}
+
 } // namespace
 } // namespace android::compositionengine
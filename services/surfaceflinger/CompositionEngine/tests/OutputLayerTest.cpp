@@ -1411,6 +1411,55 @@ TEST_F(OutputLayerUncacheBufferTest, canUncacheAndReuseSlot) {
     Mock::VerifyAndClearExpectations(&mHwcLayer);
 }
 
+/*
+ * OutputLayer::prefetchBuffers
+ */
+using OutputLayerPrefetchBuffersTest = OutputLayerUncacheBufferTest;
+
+TEST_F(OutputLayerPrefetchBuffersTest, whenNotTracking_doesNothing) {
+    mLayerFEState.buffer = kBuffer1;
+    EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 0, kBuffer1, kFence));
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+
+    EXPECT_CALL(mHwcLayer, setBuffer(_, _, _)).Times(0);
+    mOutputLayer.prefetchBuffers({kBuffer2});
+}
+
+TEST_F(OutputLayerPrefetchBuffersTest, sendsBuffersAndRestoresActiveBuffer) {
+    mOutputLayer.editState().hwc->hwcBufferCache.setTracking(true);
+
+    // Buffer1 is stored in slot 0
+    mLayerFEState.buffer = kBuffer1;
+    EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 0, kBuffer1, kFence));
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+
+    // Buffer2 and Buffer3 are sent ahead of time, and then Buffer1 is made active again
+    sp<GraphicBuffer> nullBuffer = nullptr;
+    {
+        InSequence seq;
+        EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 1, kBuffer2, _));
+        EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 2, kBuffer3, _));
+        EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 0, nullBuffer, _));
+    }
+    mOutputLayer.prefetchBuffers({kBuffer2, kBuffer3});
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+
+    // Buffer1 is already cached, so nothing is sent
+    EXPECT_CALL(mHwcLayer, setBuffer(_, _, _)).Times(0);
+    mOutputLayer.prefetchBuffers({kBuffer1});
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+
+    // Buffer2 becomes active without sending its handle again
+    mLayerFEState.buffer = kBuffer2;
+    EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 1, nullBuffer, kFence));
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+}
+
 /*
  * OutputLayer::writeCursorPositionToHWC()
  */
@@ -1164,6 +1164,38 @@ TEST_F(OutputPrepareFrameAsyncTest, predictionMiss) {
     EXPECT_TRUE(result.bufferAvailable());
 }
 
+TEST_F(OutputPrepareFrameAsyncTest, recordsChosenStrategyForLayerStack) {
+    mOutput.editState().isEnabled = true;
+    mOutput.editState().usesClientComposition = false;
+    mOutput.editState().usesDeviceComposition = true;
+    mOutput.editState().outputLayerHash = 42;
+    mOutput.editState().previousDeviceRequestedChanges =
+            std::make_optional<android::HWComposer::DeviceRequestedChanges>({});
+    std::promise<bool> p;
+    p.set_value(true);
+
+    EXPECT_CALL(mOutput, resetCompositionStrategy()).Times(1);
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+    EXPECT_CALL(mOutput, updateProtectedContentState());
+    EXPECT_CALL(mOutput, dequeueRenderBuffer(_, _)).WillOnce(Return(true));
+    EXPECT_CALL(*mRenderSurface, prepareFrame(false, true)).Times(1);
+    EXPECT_CALL(mOutput, chooseCompositionStrategyAsync(_))
+            .WillOnce(DoAll(SetArgPointee<0>(mOutput.editState().previousDeviceRequestedChanges),
+                            Return(ByMove(p.get_future()))));
+    EXPECT_CALL(mOutput, composeSurfaces(_, _, _));
+
+    mOutput.prepareFrameAsync();
+
+    auto& history = mOutput.getCompositionStrategyHistoryForTest();
+    const auto* strategy = history.get(42);
+    ASSERT_NE(nullptr, strategy);
+    EXPECT_TRUE(strategy->success);
+    EXPECT_TRUE(strategy->changes);
+    EXPECT_FALSE(strategy->usesClientComposition);
+    EXPECT_EQ(1u, history.getPredictionStats().predictions);
+    EXPECT_EQ(1u, history.getPredictionStats().hits);
+}
+
 /*
  * Output::prepare()
  */
@@ -1224,6 +1256,22 @@ TEST_F(OutputPrepareTest, skipsUncacheBuffersIfEmptyAndThenRebuildsLayerStacks)
     mOutput.prepare(mRefreshArgs, mGeomSnapshots);
 }
 
+TEST_F(OutputPrepareTest, prefetchesBuffersOnMatchingOutputLayers) {
+    const sp<GraphicBuffer> buffer =
+            sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+    mRefreshArgs.buffersToPrefetch[2] = {buffer};
+
+    EXPECT_CALL(mOutput, rebuildLayerStacks(Ref(mRefreshArgs), Ref(mGeomSnapshots)));
+    EXPECT_CALL(mLayer1.outputLayer, getLayerFE()).WillRepeatedly(ReturnRef(*mLayer1.layerFE));
+    EXPECT_CALL(mLayer2.outputLayer, getLayerFE()).WillRepeatedly(ReturnRef(*mLayer2.layerFE));
+    EXPECT_CALL(*mLayer1.layerFE, getSequence()).WillRepeatedly(Return(1));
+    EXPECT_CALL(*mLayer2.layerFE, getSequence()).WillRepeatedly(Return(2));
+    EXPECT_CALL(mLayer1.outputLayer, prefetchBuffers(_)).Times(0);
+    EXPECT_CALL(mLayer2.outputLayer, prefetchBuffers(Ref(mRefreshArgs.buffersToPrefetch[2])));
+
+    mOutput.prepare(mRefreshArgs, mGeomSnapshots);
+}
+
 /*
  * Output::rebuildLayerStacks()
  */
@@ -1422,6 +1470,114 @@ TEST_F(OutputCollectVisibleLayersTest, processesCandidateLayersReversedAndSetsOu
     mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
 }
 
+/*
+ * Output::collectVisibleLayers() with incremental visibility
+ */
+
+struct OutputCollectVisibleLayersIncrementallyTest : public testing::Test {
+    struct OutputPartialMock : public OutputPartialMockBase {
+        // Sets up the helper functions called by the function under test to use
+        // mock implementations.
+        MOCK_METHOD(bool, includesLayer, (const sp<compositionengine::LayerFE>&),
+                    (const, override));
+        MOCK_METHOD2(ensureOutputLayerIfVisible,
+                     void(sp<compositionengine::LayerFE>&,
+                          compositionengine::Output::CoverageState&));
+        MOCK_METHOD1(setReleasedLayers, void(const compositionengine::CompositionRefreshArgs&));
+    };
+
+    OutputCollectVisibleLayersIncrementallyTest() {
+        mOutput.mState.displaySpace.setBounds(ui::Size(1000, 1000));
+        mOutput.mState.layerStackSpace.setContent(Rect(0, 0, 1000, 1000));
+        mOutput.mState.transform = ui::Transform(TR_IDENT, 1000, 1000);
+        mOutput.setIncrementalVisibilityEnabled(true);
+
+        const Rect bounds[] = {Rect(0, 0, 100, 100), Rect(500, 500, 600, 600),
+                               Rect(0, 0, 50, 50)};
+        for (size_t i = 0; i < kLayerCount; i++) {
+            NonInjectedLayer& layer = *mLayers[i];
+            layer.layerFEState.isVisible = true;
+            layer.layerFEState.geomLayerBounds = bounds[i].toFloatRect();
+            layer.layerFEState.geomLayerTransform = ui::Transform();
+            layer.outputLayerState.visibleRegion = Region(bounds[i]);
+            layer.outputLayerState.visibilityInputs =
+                    impl::OutputLayerCompositionState::VisibilityInputs{
+                            .geomLayerTransform = ui::Transform(),
+                            .geomLayerBounds = bounds[i].toFloatRect(),
+                            .footprint = bounds[i]};
+            mRefreshArgs.layers.push_back(layer.layerFE);
+        }
+
+        // The first frame records the output geometry and does a full pass.
+        setUpOutputExpectations();
+        EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(_, _)).Times(3);
+        mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
+        Mock::VerifyAndClearExpectations(&mOutput);
+        setUpOutputExpectations();
+    }
+
+    void setUpOutputExpectations() {
+        EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(kLayerCount));
+        EXPECT_CALL(mOutput, includesLayer(_)).WillRepeatedly(Return(true));
+        for (size_t i = 0; i < kLayerCount; i++) {
+            EXPECT_CALL(mOutput, getOutputLayerOrderedByZByIndex(i))
+                    .WillRepeatedly(Return(&mLayers[i]->outputLayer));
+        }
+        EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs))).WillRepeatedly(Return());
+        EXPECT_CALL(mOutput, finalizePendingOutputLayers()).WillRepeatedly(Return());
+    }
+
+    static constexpr size_t kLayerCount = 3;
+
+    StrictMock<OutputPartialMock> mOutput;
+    CompositionRefreshArgs mRefreshArgs;
+    LayerFESet mGeomSnapshots;
+    Output::CoverageState mCoverageState{mGeomSnapshots};
+    NonInjectedLayer mLayer1;
+    NonInjectedLayer mLayer2;
+    NonInjectedLayer mLayer3;
+    NonInjectedLayer* mLayers[kLayerCount] = {&mLayer1, &mLayer2, &mLayer3};
+};
+
+TEST_F(OutputCollectVisibleLayersIncrementallyTest, reusesLayersOutsideOfChangedArea) {
+    mLayer2.layerFEState.geomLayerBounds = FloatRect{500, 500, 700, 700};
+
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer1.layerFE)))
+            .WillOnce(Return(&mLayer1.outputLayer));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer2.layerFE), Ref(mCoverageState)));
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(2u), Eq(mLayer3.layerFE)))
+            .WillOnce(Return(&mLayer3.outputLayer));
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+
+    mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
+
+    EXPECT_THAT(mCoverageState.aboveCoveredLayers, RegionEq(Region(Rect(0, 0, 100, 100))));
+}
+
+TEST_F(OutputCollectVisibleLayersIncrementallyTest, recomputesLayersOverlappingChangedArea) {
+    mLayer3.layerFEState.geomLayerBounds = FloatRect{0, 0, 80, 80};
+
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer1.layerFE), Ref(mCoverageState)));
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(1u), Eq(mLayer2.layerFE)))
+            .WillOnce(Return(&mLayer2.outputLayer));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer3.layerFE), Ref(mCoverageState)));
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+
+    mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
+}
+
+TEST_F(OutputCollectVisibleLayersIncrementallyTest, fullRebuildIfOutputGeometryChanges) {
+    mOutput.mState.transform = ui::Transform(TR_ROT_90, 1000, 1000);
+
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(_, Ref(mCoverageState))).Times(3);
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+
+    mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
+}
+
 /*
  * Output::ensureOutputLayerIfVisible()
  */
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/SkipValidateHistory.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+namespace {
+
+using impl::SkipValidateHistory;
+
+TEST(SkipValidateHistoryTest, attemptsUnknownLayerStacks) {
+    SkipValidateHistory history(4);
+    EXPECT_TRUE(history.shouldAttempt(1));
+
+    history.recordAttempt(1, false);
+    EXPECT_TRUE(history.shouldAttempt(2));
+}
+
+TEST(SkipValidateHistoryTest, predictsFromRecentAttempts) {
+    SkipValidateHistory history(4);
+    history.recordAttempt(1, true);
+    history.recordAttempt(1, false);
+    EXPECT_TRUE(history.shouldAttempt(1));
+
+    history.recordAttempt(1, false);
+    EXPECT_FALSE(history.shouldAttempt(1));
+
+    history.recordAttempt(1, true);
+    history.recordAttempt(1, true);
+    EXPECT_TRUE(history.shouldAttempt(1));
+}
+
+TEST(SkipValidateHistoryTest, forgetsOldAttempts) {
+    SkipValidateHistory history(4);
+    for (uint8_t i = 0; i < SkipValidateHistory::kOutcomeCount; i++) {
+        history.recordAttempt(1, true);
+    }
+    for (uint8_t i = 0; i < SkipValidateHistory::kOutcomeCount / 2 + 1; i++) {
+        history.recordAttempt(1, false);
+    }
+    EXPECT_FALSE(history.shouldAttempt(1));
+}
+
+TEST(SkipValidateHistoryTest, retriesLayerStacksPredictedToFail) {
+    SkipValidateHistory history(4);
+    history.recordAttempt(1, false);
+
+    for (uint32_t i = 1; i < SkipValidateHistory::kRetryInterval; i++) {
+        EXPECT_FALSE(history.shouldAttempt(1));
+    }
+    EXPECT_TRUE(history.shouldAttempt(1));
+
+    history.recordAttempt(1, false);
+    EXPECT_FALSE(history.shouldAttempt(1));
+    EXPECT_EQ(SkipValidateHistory::kRetryInterval, history.getStats().avoided);
+}
+
+TEST(SkipValidateHistoryTest, evictsLeastRecentlyUsed) {
+    SkipValidateHistory history(2);
+    history.recordAttempt(1, false);
+    history.recordAttempt(2, false);
+    EXPECT_FALSE(history.shouldAttempt(1));
+
+    history.recordAttempt(3, false);
+
+    EXPECT_EQ(2u, history.size());
+    EXPECT_FALSE(history.shouldAttempt(1));
+    EXPECT_TRUE(history.shouldAttempt(2));
+    EXPECT_FALSE(history.shouldAttempt(3));
+}
+
+TEST(SkipValidateHistoryTest, countsLatencySaved) {
+    SkipValidateHistory history(4);
+    // Nothing is known to be saved before a separate present was measured.
+    history.recordAttempt(1, true);
+    history.recordPresentDuration(800);
+    history.recordPresentDuration(1600);
+    history.recordAttempt(1, true);
+    history.recordAttempt(1, false);
+
+    const auto& stats = history.getStats();
+    EXPECT_EQ(3u, stats.attempts);
+    EXPECT_EQ(2u, stats.successes);
+    EXPECT_EQ(900, stats.latencySaved);
+
+    std::string dump;
+    history.dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("2/3 attempts presented"));
+}
+
+} // namespace
+} // namespace android::compositionengine
@@ -32,11 +32,13 @@ namespace android::compositionengine {
 using namespace std::chrono_literals;
 
 using testing::_;
+using testing::ByMove;
 using testing::DoAll;
 using testing::Invoke;
 using testing::Return;
 using testing::ReturnRef;
 using testing::SetArgPointee;
+using testing::SizeIs;
 
 using impl::planner::CachedSet;
 using impl::planner::LayerState;
@@ -382,6 +384,128 @@ TEST_F(CachedSetTest, renderUnsecureOutput) {
     cachedSet.append(CachedSet(layer3));
 }
 
+TEST_F(CachedSetTest, renderIntoPartialTexture) {
+    const ui::Size displaySize(512, 512);
+    mTexturePool.setDisplaySize(displaySize);
+    mOutputState.framebufferSpace = ProjectionSpace(displaySize, Rect(displaySize));
+    mOutputState.displaySpace = mOutputState.framebufferSpace;
+    mOutputState.layerStackSpace = mOutputState.framebufferSpace;
+
+    CachedSet::Layer& layer1 = *mTestLayers[1]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE1 = mTestLayers[1]->layerFE;
+    CachedSet::Layer& layer2 = *mTestLayers[2]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE2 = mTestLayers[2]->layerFE;
+
+    CachedSet cachedSet(layer1);
+    cachedSet.append(CachedSet(layer2));
+
+    // The layers and their visible regions span [1, 4), which fits the smallest texture.
+    const Rect expectedTextureBounds(1, 1, 65, 65);
+    const auto drawLayers = [&](const renderengine::DisplaySettings& displaySettings,
+                                const std::vector<renderengine::LayerSettings>&,
+                                const std::shared_ptr<renderengine::ExternalTexture>& texture,
+                                const bool, base::unique_fd&&) -> ftl::Future<FenceResult> {
+        EXPECT_EQ(Rect(64, 64), displaySettings.physicalDisplay);
+        EXPECT_EQ(expectedTextureBounds, displaySettings.clip);
+        EXPECT_EQ(64u, texture->getBuffer()->getWidth());
+        EXPECT_EQ(64u, texture->getBuffer()->getHeight());
+        return ftl::yield<FenceResult>(Fence::NO_FENCE);
+    };
+
+    EXPECT_CALL(*layerFE1, prepareClientComposition(_))
+            .WillOnce(Return(std::optional<compositionengine::LayerFE::LayerSettings>()));
+    EXPECT_CALL(*layerFE2, prepareClientComposition(_))
+            .WillOnce(Return(std::optional<compositionengine::LayerFE::LayerSettings>()));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _, _)).WillOnce(Invoke(drawLayers));
+    cachedSet.render(mRenderEngine, mTexturePool, mOutputState, true);
+    expectReadyBuffer(cachedSet);
+
+    EXPECT_EQ(expectedTextureBounds, cachedSet.getTextureBounds());
+}
+
+TEST_F(CachedSetTest, rerenderOnlyChangedTiles) {
+    const ui::Size displaySize(1024, 1024);
+    mTexturePool.setDisplaySize(displaySize);
+    mOutputState.framebufferSpace = ProjectionSpace(displaySize, Rect(displaySize));
+    mOutputState.displaySpace = mOutputState.framebufferSpace;
+    mOutputState.layerStackSpace = mOutputState.framebufferSpace;
+    mOutputState.displayBrightnessNits = 400.f;
+
+    // A small layer over a larger one, which fit in a 256x256 texture.
+    const Rect bottomFrame(0, 0, 256, 256);
+    const Rect topFrame(0, 0, 64, 64);
+    for (const auto& [testLayer, frame] : {std::pair{mTestLayers[1].get(), bottomFrame},
+                                           std::pair{mTestLayers[2].get(), topFrame}}) {
+        testLayer->outputLayerCompositionState.displayFrame = frame;
+        testLayer->outputLayerCompositionState.visibleRegion = Region(frame);
+        testLayer->layerState->update(&testLayer->outputLayer);
+        testLayer->cachedSetLayer =
+                std::make_unique<CachedSet::Layer>(testLayer->layerState.get(), kStartTime);
+    }
+    sp<mock::LayerFE> layerFE1 = mTestLayers[1]->layerFE;
+    sp<mock::LayerFE> layerFE2 = mTestLayers[2]->layerFE;
+
+    std::optional<compositionengine::LayerFE::LayerSettings> clientComp1;
+    clientComp1.emplace();
+    clientComp1->geometry.boundaries = bottomFrame.toFloatRect();
+    clientComp1->alpha = 1.f;
+    std::optional<compositionengine::LayerFE::LayerSettings> clientComp2;
+    clientComp2.emplace();
+    clientComp2->geometry.boundaries = topFrame.toFloatRect();
+    clientComp2->alpha = 1.f;
+    EXPECT_CALL(*layerFE1, prepareClientComposition(_)).WillRepeatedly(Return(clientComp1));
+    EXPECT_CALL(*layerFE2, prepareClientComposition(_)).WillRepeatedly(Return(clientComp2));
+
+    CachedSet previous(*mTestLayers[1]->cachedSetLayer);
+    previous.append(CachedSet(*mTestLayers[2]->cachedSetLayer));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(Fence::NO_FENCE))));
+    previous.render(mRenderEngine, mTexturePool, mOutputState, true);
+    expectReadyBuffer(previous);
+    EXPECT_FALSE(previous.wasPartiallyRendered());
+    EXPECT_EQ(bottomFrame, previous.getTextureBounds());
+
+    // Only the top layer gets a new frame, so only its tile is drawn over the previous texture.
+    mTestLayers[2]->layerFECompositionState.frameNumber++;
+    CachedSet cachedSet(*mTestLayers[1]->cachedSetLayer);
+    cachedSet.append(CachedSet(*mTestLayers[2]->cachedSetLayer));
+
+    const auto drawLayers = [&](const renderengine::DisplaySettings& displaySettings,
+                                const std::vector<renderengine::LayerSettings>& layers,
+                                const std::shared_ptr<renderengine::ExternalTexture>& texture,
+                                const bool, base::unique_fd&&) -> ftl::Future<FenceResult> {
+        EXPECT_EQ(Rect(256, 256), displaySettings.physicalDisplay);
+        EXPECT_NE(previous.getBuffer(), texture);
+        EXPECT_EQ(4u, layers.size());
+        if (layers.size() == 4u) {
+            EXPECT_EQ(previous.getBuffer(), layers[0].source.buffer.buffer);
+            EXPECT_EQ(bottomFrame.toFloatRect(), layers[0].geometry.boundaries);
+            EXPECT_TRUE(layers[0].disableBlending);
+            EXPECT_EQ(topFrame.toFloatRect(), layers[1].geometry.boundaries);
+            EXPECT_EQ(0.f, layers[1].alpha);
+            EXPECT_TRUE(layers[1].disableBlending);
+            EXPECT_EQ(topFrame.toFloatRect(), layers[2].geometry.boundaries);
+            EXPECT_EQ(topFrame.toFloatRect(), layers[3].geometry.boundaries);
+        }
+        return ftl::yield<FenceResult>(Fence::NO_FENCE);
+    };
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _, _)).WillOnce(Invoke(drawLayers));
+    cachedSet.render(mRenderEngine, mTexturePool, mOutputState, true, &previous);
+    expectReadyBuffer(cachedSet);
+    EXPECT_TRUE(cachedSet.wasPartiallyRendered());
+    EXPECT_EQ(bottomFrame, cachedSet.getTextureBounds());
+
+    // When the bottom layer changes too, most of the texture is dirty and it is drawn in full.
+    mTestLayers[1]->layerFECompositionState.frameNumber++;
+    CachedSet next(*mTestLayers[1]->cachedSetLayer);
+    next.append(CachedSet(*mTestLayers[2]->cachedSetLayer));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, SizeIs(2), _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(Fence::NO_FENCE))));
+    next.render(mRenderEngine, mTexturePool, mOutputState, true, &cachedSet);
+    expectReadyBuffer(next);
+    EXPECT_FALSE(next.wasPartiallyRendered());
+}
+
 TEST_F(CachedSetTest, renderSecureOutput) {
     // Skip the 0th layer to ensure that the bounding box of the layers is offset from (0, 0)
     CachedSet::Layer& layer1 = *mTestLayers[1]->cachedSetLayer.get();
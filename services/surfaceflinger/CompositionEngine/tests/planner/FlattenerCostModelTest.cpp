@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/OutputCompositionState.h>
+#include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/FlattenerCostModel.h>
+#include <compositionengine/impl/planner/LayerState.h>
+#include <compositionengine/mock/LayerFE.h>
+#include <compositionengine/mock/OutputLayer.h>
+#include <gtest/gtest.h>
+#include <renderengine/mock/RenderEngine.h>
+#include <ui/MockFence.h>
+
+namespace android::compositionengine {
+using namespace std::chrono_literals;
+
+using testing::_;
+using testing::ByMove;
+using testing::Return;
+using testing::ReturnRef;
+
+using impl::planner::CachedSet;
+using impl::planner::FlattenerCostModel;
+using impl::planner::LayerState;
+using impl::planner::TexturePool;
+
+namespace {
+
+const ui::Size kDisplaySize = ui::Size(1000, 1000);
+
+class FlattenerCostModelTest : public testing::Test {
+public:
+    void SetUp() override;
+
+protected:
+    const std::chrono::steady_clock::time_point kStartTime = std::chrono::steady_clock::now();
+
+    struct TestLayer {
+        mock::OutputLayer outputLayer;
+        impl::OutputLayerCompositionState outputLayerCompositionState;
+        // LayerFE inherits from RefBase and must be held by an sp<>
+        sp<mock::LayerFE> layerFE;
+        LayerFECompositionState layerFECompositionState;
+
+        std::unique_ptr<LayerState> layerState;
+    };
+
+    static constexpr size_t kNumLayers = 2;
+    std::vector<std::unique_ptr<TestLayer>> mTestLayers;
+
+    FlattenerCostModel mCostModel;
+};
+
+void FlattenerCostModelTest::SetUp() {
+    for (size_t i = 0; i < kNumLayers; i++) {
+        auto testLayer = std::make_unique<TestLayer>();
+        // Screen-sized layers on top of each other.
+        testLayer->outputLayerCompositionState.displayFrame = Rect(kDisplaySize);
+        testLayer->outputLayerCompositionState.visibleRegion = Region(Rect(kDisplaySize));
+
+        const auto kUsageFlags =
+                static_cast<uint64_t>(GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN |
+                                      GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE);
+        testLayer->layerFECompositionState.buffer =
+                sp<GraphicBuffer>::make(100u, 100u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, kUsageFlags,
+                                        "output");
+
+        testLayer->layerFE = sp<mock::LayerFE>::make();
+
+        EXPECT_CALL(*testLayer->layerFE, getSequence)
+                .WillRepeatedly(Return(static_cast<int32_t>(i)));
+        EXPECT_CALL(*testLayer->layerFE, getDebugName).WillRepeatedly(Return("testLayer"));
+        EXPECT_CALL(*testLayer->layerFE, getCompositionState)
+                .WillRepeatedly(Return(&testLayer->layerFECompositionState));
+        EXPECT_CALL(testLayer->outputLayer, getLayerFE)
+                .WillRepeatedly(ReturnRef(*testLayer->layerFE));
+        EXPECT_CALL(testLayer->outputLayer, getState)
+                .WillRepeatedly(ReturnRef(testLayer->outputLayerCompositionState));
+
+        testLayer->layerState = std::make_unique<LayerState>(&testLayer->outputLayer);
+        testLayer->layerState->incrementFramesSinceBufferUpdate();
+
+        mTestLayers.emplace_back(std::move(testLayer));
+    }
+}
+
+// Each screen-sized RGBA_8888 layer merged into the cached set saves reading it and its overhead.
+constexpr int64_t kLayerFrameSavings = 1000 * 1000 * 4 + FlattenerCostModel::kLayerOverheadBytes;
+
+TEST_F(FlattenerCostModelTest, idleOverlappingLayersAreWorthFlattening) {
+    const CachedSet set1(mTestLayers[0]->layerState.get(), kStartTime);
+    const CachedSet set2(mTestLayers[1]->layerState.get(), kStartTime);
+
+    const auto estimate = mCostModel.estimate({&set1, &set2}, kStartTime + 1s);
+
+    EXPECT_EQ(kLayerFrameSavings, estimate.frameSavings);
+    EXPECT_EQ(1s, estimate.expectedIdle);
+    EXPECT_GT(estimate.renderCost, 0);
+    EXPECT_GT(estimate.netSavings, 0);
+}
+
+TEST_F(FlattenerCostModelTest, recentlyUpdatedLayersAreNotWorthFlattening) {
+    const CachedSet set1(mTestLayers[0]->layerState.get(), kStartTime);
+    const CachedSet set2(mTestLayers[1]->layerState.get(), kStartTime);
+
+    const auto estimate = mCostModel.estimate({&set1, &set2}, kStartTime);
+
+    EXPECT_EQ(0ns, estimate.expectedIdle);
+    EXPECT_EQ(-estimate.renderCost, estimate.netSavings);
+}
+
+TEST_F(FlattenerCostModelTest, expectsIdleUntilNextFrameFromLayerHistory) {
+    mTestLayers[1]->layerFECompositionState.fps = 2.f;
+    const CachedSet set1(mTestLayers[0]->layerState.get(), kStartTime);
+    const CachedSet set2(mTestLayers[1]->layerState.get(), kStartTime);
+
+    EXPECT_EQ(400ms, mCostModel.estimate({&set1, &set2}, kStartTime + 100ms).expectedIdle);
+    // Past its frame period, the layer is expected to stay idle for as long as it has been.
+    EXPECT_EQ(2s, mCostModel.estimate({&set1, &set2}, kStartTime + 2s).expectedIdle);
+}
+
+TEST_F(FlattenerCostModelTest, learnsFrameInterval) {
+    EXPECT_EQ(FlattenerCostModel::kDefaultFrameInterval, mCostModel.getFrameInterval());
+
+    auto now = kStartTime;
+    for (int i = 0; i < 50; i++) {
+        mCostModel.recordFrame(now);
+        now += 100ms;
+    }
+    EXPECT_NEAR(100.0, static_cast<double>(mCostModel.getFrameInterval().count()) / 1e6, 1.0);
+
+    // Fewer expected frames reduce the savings.
+    const CachedSet set1(mTestLayers[0]->layerState.get(), kStartTime);
+    const CachedSet set2(mTestLayers[1]->layerState.get(), kStartTime);
+    FlattenerCostModel defaultCostModel;
+    EXPECT_LT(mCostModel.estimate({&set1, &set2}, kStartTime + 1s).netSavings,
+              defaultCostModel.estimate({&set1, &set2}, kStartTime + 1s).netSavings);
+}
+
+TEST_F(FlattenerCostModelTest, learnsGpuCostFromDrawFence) {
+    renderengine::mock::RenderEngine renderEngine;
+    TexturePool texturePool(renderEngine);
+    texturePool.setDisplaySize(kDisplaySize);
+
+    impl::OutputCompositionState outputState;
+    outputState.dataspace = ui::Dataspace::SRGB;
+    outputState.framebufferSpace = ProjectionSpace(kDisplaySize, Rect(kDisplaySize));
+    outputState.displaySpace = outputState.framebufferSpace;
+    outputState.layerStackSpace = outputState.framebufferSpace;
+
+    CachedSet cachedSet(mTestLayers[0]->layerState.get(), kStartTime);
+    cachedSet.addLayer(mTestLayers[1]->layerState.get(), kStartTime);
+
+    const nsecs_t renderStart = systemTime();
+    // Rendering the two layers and writing the texture takes 3M pixels.
+    const auto drawFence = sp<android::mock::MockFence>::make();
+    EXPECT_CALL(*drawFence, getSignalTime).WillRepeatedly(Return(renderStart + 3'000'000));
+    for (const auto& testLayer : mTestLayers) {
+        EXPECT_CALL(*testLayer->layerFE, prepareClientComposition(_))
+                .WillOnce(Return(std::optional<compositionengine::LayerFE::LayerSettings>()));
+    }
+    EXPECT_CALL(renderEngine, drawLayers(_, _, _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(sp<Fence>(drawFence)))));
+    cachedSet.render(renderEngine, texturePool, outputState, true);
+    ASSERT_TRUE(cachedSet.hasRenderedBuffer());
+
+    mCostModel.recordRender(cachedSet, renderStart);
+    EXPECT_FLOAT_EQ(0.25f * 1.f + 0.75f * FlattenerCostModel::kDefaultGpuNsPerPixel,
+                    mCostModel.getGpuNsPerPixel());
+    EXPECT_LT(mCostModel.getRealizedSavings(), 0);
+
+    const int64_t realizedSavings = mCostModel.getRealizedSavings();
+    mCostModel.recordDisplayedFrame(cachedSet);
+    EXPECT_EQ(realizedSavings + kLayerFrameSavings, mCostModel.getRealizedSavings());
+
+    std::string dump;
+    mCostModel.dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("1 renders measured"));
+}
+
+} // namespace
+} // namespace android::compositionengine
@@ -35,6 +35,8 @@ public:
     size_t getMinPoolSize() const { return kMinPoolSize; }
     size_t getMaxPoolSize() const { return kMaxPoolSize; }
     size_t getPoolSize() const { return mPool.size(); }
+    size_t getMaxTilePoolSize() const { return kMaxTilePoolSize; }
+    size_t getTilePoolSize() const { return mTilePool.size(); }
 };
 
 struct TexturePoolTest : public testing::Test {
@@ -170,5 +172,46 @@ TEST_F(TexturePoolTest, reallocatesWhenReEnabled) {
     EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
 }
 
+TEST_F(TexturePoolTest, roundsTextureSizesUpToPowersOfTwo) {
+    mTexturePool.setDisplaySize(ui::Size(1000, 300));
+
+    EXPECT_EQ(ui::Size(64, 128), mTexturePool.getTextureSize(ui::Size(10, 100)));
+    EXPECT_EQ(ui::Size(512, 256), mTexturePool.getTextureSize(ui::Size(512, 129)));
+    EXPECT_EQ(ui::Size(1000, 64), mTexturePool.getTextureSize(ui::Size(900, 1)));
+    EXPECT_EQ(ui::Size(1000, 300), mTexturePool.getTextureSize(ui::Size(513, 257)));
+}
+
+TEST_F(TexturePoolTest, reusesSmallerTextures) {
+    mTexturePool.setDisplaySize(ui::Size(1000, 300));
+    const ui::Size size = mTexturePool.getTextureSize(ui::Size(10, 100));
+
+    auto texture = mTexturePool.borrowTexture(size);
+    EXPECT_EQ(size.getWidth(), static_cast<int32_t>(texture->get()->getBuffer()->getWidth()));
+    EXPECT_EQ(size.getHeight(), static_cast<int32_t>(texture->get()->getBuffer()->getHeight()));
+    const uint64_t bufferId = texture->get()->getBuffer()->getId();
+    texture.reset();
+    EXPECT_EQ(1u, mTexturePool.getTilePoolSize());
+    EXPECT_EQ(mTexturePool.getMinPoolSize(), mTexturePool.getPoolSize());
+
+    texture = mTexturePool.borrowTexture(size);
+    EXPECT_EQ(bufferId, texture->get()->getBuffer()->getId());
+    EXPECT_EQ(0u, mTexturePool.getTilePoolSize());
+}
+
+TEST_F(TexturePoolTest, boundsSmallerTextures) {
+    mTexturePool.setDisplaySize(ui::Size(1000, 300));
+
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < mTexturePool.getMaxTilePoolSize() + 2; i++) {
+        textures.emplace_back(mTexturePool.borrowTexture(ui::Size(64, 64)));
+    }
+    textures.clear();
+    EXPECT_EQ(mTexturePool.getMaxTilePoolSize(), mTexturePool.getTilePoolSize());
+
+    // Smaller textures are dropped along with the screen-sized ones when the display size changes.
+    mTexturePool.setDisplaySize(ui::Size(500, 300));
+    EXPECT_EQ(0u, mTexturePool.getTilePoolSize());
+}
+
 } // namespace
 } // namespace android::compositionengine::impl::planner
@@ -89,7 +89,10 @@ DisplayDevice::DisplayDevice(DisplayDeviceCreationArgs& args)
     }
 
     mCompositionDisplay->setPredictCompositionStrategy(mFlinger->mPredictCompositionStrategy);
+    mCompositionDisplay->setPredictSkipValidate(mFlinger->mPredictSkipValidate);
+    mCompositionDisplay->setHwcBufferCacheTracking(mFlinger->mHwcBufferCacheTracking);
     mCompositionDisplay->setTreat170mAsSrgb(mFlinger->mTreat170mAsSrgb);
+    mCompositionDisplay->setIncrementalVisibilityEnabled(mFlinger->mIncrementalVisibleRegions);
     mCompositionDisplay->createDisplayColorProfile(
             compositionengine::DisplayColorProfileCreationArgsBuilder()
                     .setHasWideColorGamut(args.hasWideColorGamut)
@@ -27,9 +27,11 @@
 #include "HWC2.h"
 
 #include <android/configuration.h>
+#include <ftl/concat.h>
 #include <ui/Fence.h>
 #include <ui/FloatRect.h>
 #include <ui/GraphicBuffer.h>
+#include <utils/Trace.h>
 
 #include <algorithm>
 #include <cinttypes>
@@ -514,6 +516,7 @@ Error Display::validate(nsecs_t expectedPresentTime, uint32_t* outNumTypes,
     uint32_t numTypes = 0;
     uint32_t numRequests = 0;
     auto intError = mComposer.validateDisplay(mId, expectedPresentTime, &numTypes, &numRequests);
+    onLayerCommandsFlushed();
     auto error = static_cast<Error>(intError);
     if (error != Error::NONE && !hasChangesError(error)) {
         return error;
@@ -532,6 +535,7 @@ Error Display::presentOrValidate(nsecs_t expectedPresentTime, uint32_t* outNumTy
     int32_t presentFenceFd = -1;
     auto intError = mComposer.presentOrValidateDisplay(mId, expectedPresentTime, &numTypes,
                                                        &numRequests, &presentFenceFd, state);
+    onLayerCommandsFlushed();
     auto error = static_cast<Error>(intError);
     if (error != Error::NONE && !hasChangesError(error)) {
         return error;
@@ -548,6 +552,23 @@ Error Display::presentOrValidate(nsecs_t expectedPresentTime, uint32_t* outNumTy
     return error;
 }
 
+void Display::onLayerCommandsFlushed() {
+    mLastFrameLayerCommandStats = {};
+    for (const auto& [_, weakLayer] : mLayers) {
+        if (const auto layer = weakLayer.lock()) {
+            mLastFrameLayerCommandStats += layer->takeCommandStats();
+        }
+    }
+    mLayerCommandStats += mLastFrameLayerCommandStats;
+
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT64(ftl::Concat("HWC_LAYER_COMMANDS_SENT_", mId).c_str(),
+                     static_cast<int64_t>(mLastFrameLayerCommandStats.sent));
+        ATRACE_INT64(ftl::Concat("HWC_LAYER_COMMANDS_SUPPRESSED_", mId).c_str(),
+                     static_cast<int64_t>(mLastFrameLayerCommandStats.suppressed));
+    }
+}
+
 ftl::Future<Error> Display::setDisplayBrightness(
         float brightness, float brightnessNits,
         const Hwc2::Composer::DisplayBrightnessOptions& options) {
@@ -690,12 +711,33 @@ void Layer::onOwningDisplayDestroyed() {
     mDisplay = nullptr;
 }
 
+template <typename T>
+bool Layer::isCached(const std::optional<T>& cached, const T& value) {
+    if (cached == value) {
+        onCommandSuppressed();
+        return true;
+    }
+    onCommandSent();
+    return false;
+}
+
+template <typename T>
+Error Layer::updateCache(std::optional<T>& cached, const T& value, Error error) {
+    if (error == Error::NONE) {
+        cached = value;
+    } else {
+        cached.reset();
+    }
+    return error;
+}
+
 Error Layer::setCursorPosition(int32_t x, int32_t y)
 {
     if (CC_UNLIKELY(!mDisplay)) {
         return Error::BAD_DISPLAY;
     }
 
+    onCommandSent();
     auto intError = mComposer.setCursorPosition(mDisplay->getId(), mId, x, y);
     return static_cast<Error>(intError);
 }
@@ -708,9 +750,11 @@ Error Layer::setBuffer(uint32_t slot, const sp<GraphicBuffer>& buffer,
     }
 
     if (buffer == nullptr && mBufferSlot == slot) {
+        onCommandSuppressed();
         return Error::NONE;
     }
     mBufferSlot = slot;
+    onCommandSent();
 
     int32_t fenceFd = acquireFence->dup();
     auto intError = mComposer.setLayerBuffer(mDisplay->getId(), mId, slot, buffer, fenceFd);
@@ -722,6 +766,7 @@ Error Layer::setBufferSlotsToClear(const std::vector<uint32_t>& slotsToClear,
     if (CC_UNLIKELY(!mDisplay)) {
         return Error::BAD_DISPLAY;
     }
+    onCommandSent();
     auto intError = mComposer.setLayerBufferSlotsToClear(mDisplay->getId(), mId, slotsToClear,
                                                          activeBufferSlot);
     return static_cast<Error>(intError);
@@ -735,9 +780,11 @@ Error Layer::setSurfaceDamage(const Region& damage)
 
     if (damage.isRect() && mDamageRegion.isRect() &&
         (damage.getBounds() == mDamageRegion.getBounds())) {
+        onCommandSuppressed();
         return Error::NONE;
     }
     mDamageRegion = damage;
+    onCommandSent();
 
     // We encode default full-screen damage as INVALID_RECT upstream, but as 0
     // rects for HWC
@@ -759,8 +806,11 @@ Error Layer::setBlendMode(BlendMode mode)
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mBlendMode, mode)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBlendMode(mDisplay->getId(), mId, mode);
-    return static_cast<Error>(intError);
+    return updateCache(mBlendMode, mode, static_cast<Error>(intError));
 }
 
 Error Layer::setColor(Color color) {
@@ -768,8 +818,11 @@ Error Layer::setColor(Color color) {
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mColor, color)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerColor(mDisplay->getId(), mId, color);
-    return static_cast<Error>(intError);
+    return updateCache(mColor, color, static_cast<Error>(intError));
 }
 
 Error Layer::setCompositionType(Composition type)
@@ -778,6 +831,8 @@ Error Layer::setCompositionType(Composition type)
         return Error::BAD_DISPLAY;
     }
 
+    // Not cached, as the composer may change the composition type when validating.
+    onCommandSent();
     auto intError = mComposer.setLayerCompositionType(mDisplay->getId(), mId, type);
     return static_cast<Error>(intError);
 }
@@ -789,9 +844,11 @@ Error Layer::setDataspace(Dataspace dataspace)
     }
 
     if (dataspace == mDataSpace) {
+        onCommandSuppressed();
         return Error::NONE;
     }
     mDataSpace = dataspace;
+    onCommandSent();
     auto intError = mComposer.setLayerDataspace(mDisplay->getId(), mId, mDataSpace);
     return static_cast<Error>(intError);
 }
@@ -804,10 +861,12 @@ Error Layer::setPerFrameMetadata(const int32_t supportedPerFrameMetadata,
     }
 
     if (metadata == mHdrMetadata) {
+        onCommandSuppressed();
         return Error::NONE;
     }
 
     mHdrMetadata = metadata;
+    onCommandSent();
     int validTypes = mHdrMetadata.validTypes & supportedPerFrameMetadata;
     std::vector<Hwc2::PerFrameMetadata> perFrameMetadatas;
     if (validTypes & HdrMetadata::SMPTE2086) {
@@ -868,10 +927,13 @@ Error Layer::setDisplayFrame(const Rect& frame)
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mDisplayFrame, frame)) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::Rect hwcRect{frame.left, frame.top,
         frame.right, frame.bottom};
     auto intError = mComposer.setLayerDisplayFrame(mDisplay->getId(), mId, hwcRect);
-    return static_cast<Error>(intError);
+    return updateCache(mDisplayFrame, frame, static_cast<Error>(intError));
 }
 
 Error Layer::setPlaneAlpha(float alpha)
@@ -880,8 +942,11 @@ Error Layer::setPlaneAlpha(float alpha)
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mPlaneAlpha, alpha)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerPlaneAlpha(mDisplay->getId(), mId, alpha);
-    return static_cast<Error>(intError);
+    return updateCache(mPlaneAlpha, alpha, static_cast<Error>(intError));
 }
 
 Error Layer::setSidebandStream(const native_handle_t* stream)
@@ -895,6 +960,7 @@ Error Layer::setSidebandStream(const native_handle_t* stream)
                 "device supports sideband streams");
         return Error::UNSUPPORTED;
     }
+    onCommandSent();
     auto intError = mComposer.setLayerSidebandStream(mDisplay->getId(), mId, stream);
     return static_cast<Error>(intError);
 }
@@ -905,10 +971,13 @@ Error Layer::setSourceCrop(const FloatRect& crop)
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mSourceCrop, crop)) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::FRect hwcRect{
         crop.left, crop.top, crop.right, crop.bottom};
     auto intError = mComposer.setLayerSourceCrop(mDisplay->getId(), mId, hwcRect);
-    return static_cast<Error>(intError);
+    return updateCache(mSourceCrop, crop, static_cast<Error>(intError));
 }
 
 Error Layer::setTransform(Transform transform)
@@ -917,9 +986,12 @@ Error Layer::setTransform(Transform transform)
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mTransform, transform)) {
+        return Error::NONE;
+    }
     auto intTransform = static_cast<Hwc2::Transform>(transform);
     auto intError = mComposer.setLayerTransform(mDisplay->getId(), mId, intTransform);
-    return static_cast<Error>(intError);
+    return updateCache(mTransform, transform, static_cast<Error>(intError));
 }
 
 Error Layer::setVisibleRegion(const Region& region)
@@ -930,9 +1002,11 @@ Error Layer::setVisibleRegion(const Region& region)
 
     if (region.isRect() && mVisibleRegion.isRect() &&
         (region.getBounds() == mVisibleRegion.getBounds())) {
+        onCommandSuppressed();
         return Error::NONE;
     }
     mVisibleRegion = region;
+    onCommandSent();
     const auto hwcRects = convertRegionToHwcRects(region);
     auto intError = mComposer.setLayerVisibleRegion(mDisplay->getId(), mId, hwcRects);
     return static_cast<Error>(intError);
@@ -944,8 +1018,11 @@ Error Layer::setZOrder(uint32_t z)
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mZOrder, z)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerZOrder(mDisplay->getId(), mId, z);
-    return static_cast<Error>(intError);
+    return updateCache(mZOrder, z, static_cast<Error>(intError));
 }
 
 // Composer HAL 2.3
@@ -955,8 +1032,10 @@ Error Layer::setColorTransform(const android::mat4& matrix) {
     }
 
     if (matrix == mColorMatrix) {
+        onCommandSuppressed();
         return Error::NONE;
     }
+    onCommandSent();
     auto intError = mComposer.setLayerColorTransform(mDisplay->getId(), mId, matrix.asArray());
     Error error = static_cast<Error>(intError);
     if (error != Error::NONE) {
@@ -973,6 +1052,7 @@ Error Layer::setLayerGenericMetadata(const std::string& name, bool mandatory,
         return Error::BAD_DISPLAY;
     }
 
+    onCommandSent();
     auto intError =
             mComposer.setLayerGenericMetadata(mDisplay->getId(), mId, name, mandatory, value);
     return static_cast<Error>(intError);
@@ -984,8 +1064,11 @@ Error Layer::setBrightness(float brightness) {
         return Error::BAD_DISPLAY;
     }
 
+    if (isCached(mBrightness, brightness)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBrightness(mDisplay->getId(), mId, brightness);
-    return static_cast<Error>(intError);
+    return updateCache(mBrightness, brightness, static_cast<Error>(intError));
 }
 
 Error Layer::setBlockingRegion(const Region& region) {
@@ -995,9 +1078,11 @@ Error Layer::setBlockingRegion(const Region& region) {
 
     if (region.isRect() && mBlockingRegion.isRect() &&
         (region.getBounds() == mBlockingRegion.getBounds())) {
+        onCommandSuppressed();
         return Error::NONE;
     }
     mBlockingRegion = region;
+    onCommandSent();
     const auto hwcRects = convertRegionToHwcRects(region);
     const auto intError = mComposer.setLayerBlockingRegion(mDisplay->getId(), mId, hwcRects);
     return static_cast<Error>(intError);
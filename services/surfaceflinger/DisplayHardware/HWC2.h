@@ -21,6 +21,7 @@
 #include <ftl/future.h>
 #include <gui/HdrMetadata.h>
 #include <math/mat4.h>
+#include <ui/FloatRect.h>
 #include <ui/HdrCapabilities.h>
 #include <ui/Region.h>
 #include <ui/StaticDisplayInfo.h>
@@ -29,9 +30,11 @@
 #include <utils/Timers.h>
 
 #include <functional>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "ComposerHal.h"
@@ -86,6 +89,19 @@ protected:
     ~ComposerCallback() = default;
 };
 
+// Counts of the layer state commands sent to the composer, and of those suppressed because they
+// would have set state that the composer already has.
+struct LayerCommandStats {
+    uint64_t sent = 0;
+    uint64_t suppressed = 0;
+
+    LayerCommandStats& operator+=(const LayerCommandStats& other) {
+        sent += other.sent;
+        suppressed += other.suppressed;
+        return *this;
+    }
+};
+
 // Convenience C++ class to access per display functions directly.
 class Display {
 public:
@@ -178,6 +194,10 @@ public:
     [[nodiscard]] virtual hal::Error setIdleTimerEnabled(std::chrono::milliseconds timeout) = 0;
     [[nodiscard]] virtual hal::Error getPhysicalDisplayOrientation(
             Hwc2::AidlTransform* outTransform) const = 0;
+
+    // Layer state commands of all frames, and of the frame last validated or presented.
+    virtual LayerCommandStats getLayerCommandStats() const = 0;
+    virtual LayerCommandStats getLastFrameLayerCommandStats() const = 0;
 };
 
 namespace impl {
@@ -270,8 +290,15 @@ public:
     bool hasDisplayIdleTimerCapability() const override;
     void onLayerDestroyed(hal::HWLayerId layerId) override;
     hal::Error getPhysicalDisplayOrientation(Hwc2::AidlTransform* outTransform) const override;
+    LayerCommandStats getLayerCommandStats() const override { return mLayerCommandStats; }
+    LayerCommandStats getLastFrameLayerCommandStats() const override {
+        return mLastFrameLayerCommandStats;
+    }
 
 private:
+    // Collects the layer state commands issued since the previous frame, once they have been
+    // flushed to the composer by validate or presentOrValidate.
+    void onLayerCommandsFlushed();
 
     // This may fail (and return a null pointer) if no layer with this ID exists
     // on this display
@@ -295,6 +322,9 @@ private:
     using Layers = std::unordered_map<hal::HWLayerId, std::weak_ptr<HWC2::impl::Layer>>;
     Layers mLayers;
 
+    LayerCommandStats mLayerCommandStats;
+    LayerCommandStats mLastFrameLayerCommandStats;
+
     mutable std::mutex mDisplayCapabilitiesMutex;
     std::once_flag mDisplayCapabilityQueryFlag;
     std::optional<
@@ -396,7 +426,20 @@ public:
     hal::Error setBrightness(float brightness) override;
     hal::Error setBlockingRegion(const android::Region& region) override;
 
+    // Returns the commands issued since the previous call.
+    LayerCommandStats takeCommandStats() { return std::exchange(mCommandStats, {}); }
+
 private:
+    // Returns whether the composer already has `value`, in which case the command is suppressed.
+    template <typename T>
+    bool isCached(const std::optional<T>& cached, const T& value);
+    // Caches `value` if the composer accepted it, or forgets the cached value otherwise.
+    template <typename T>
+    hal::Error updateCache(std::optional<T>& cached, const T& value, hal::Error error);
+
+    void onCommandSent() { mCommandStats.sent++; }
+    void onCommandSuppressed() { mCommandStats.suppressed++; }
+
     // These are references to data owned by HWComposer, which will outlive
     // this HWC2::Layer, so these references are guaranteed to be valid for
     // the lifetime of this object.
@@ -416,6 +459,16 @@ private:
     android::HdrMetadata mHdrMetadata;
     android::mat4 mColorMatrix;
     uint32_t mBufferSlot;
+    std::optional<android::Rect> mDisplayFrame;
+    std::optional<android::FloatRect> mSourceCrop;
+    std::optional<uint32_t> mZOrder;
+    std::optional<hal::Transform> mTransform;
+    std::optional<hal::BlendMode> mBlendMode;
+    std::optional<float> mPlaneAlpha;
+    std::optional<aidl::android::hardware::graphics::composer3::Color> mColor;
+    std::optional<float> mBrightness;
+
+    LayerCommandStats mCommandStats;
 };
 
 } // namespace impl
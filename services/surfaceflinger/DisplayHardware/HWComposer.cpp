@@ -27,6 +27,7 @@
 #include "HWComposer.h"
 
 #include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <compositionengine/Output.h>
 #include <compositionengine/OutputLayer.h>
 #include <compositionengine/impl/OutputLayerCompositionState.h>
@@ -396,7 +397,7 @@ status_t HWComposer::setClientTarget(HalDisplayId displayId, uint32_t slot,
 status_t HWComposer::getDeviceCompositionChanges(
         HalDisplayId displayId, bool frameUsesClientComposition,
         std::optional<std::chrono::steady_clock::time_point> earliestPresentTime,
-        nsecs_t expectedPresentTime,
+        nsecs_t expectedPresentTime, SkipValidatePolicy skipValidatePolicy,
         std::optional<android::HWComposer::DeviceRequestedChanges>* outChanges) {
     ATRACE_CALL();
 
@@ -424,12 +425,22 @@ status_t HWComposer::getDeviceCompositionChanges(
             return false;
         }
 
+        if (skipValidatePolicy == SkipValidatePolicy::Avoid) {
+            return false;
+        }
+
         // If composer supports getting the expected present time, we can skip
         // as composer will make sure to prevent early presentation
         if (!earliestPresentTime) {
             return true;
         }
 
+        // The caller expects skipping validate to pay off even if we need to
+        // wait for the earliest present time first.
+        if (skipValidatePolicy == SkipValidatePolicy::Attempt) {
+            return true;
+        }
+
         // composer doesn't support getting the expected present time. We can only
         // skip validate if we know that we are not going to present early.
         return std::chrono::steady_clock::now() >= *earliestPresentTime;
@@ -437,6 +448,11 @@ status_t HWComposer::getDeviceCompositionChanges(
 
     displayData.validateWasSkipped = false;
     if (canSkipValidate) {
+        if (earliestPresentTime && std::chrono::steady_clock::now() < *earliestPresentTime) {
+            ATRACE_NAME("wait for earliest present time");
+            std::this_thread::sleep_until(*earliestPresentTime);
+        }
+
         sp<Fence> outPresentFence;
         uint32_t state = UINT32_MAX;
         error = hwcDisplay->presentOrValidate(expectedPresentTime, &numTypes, &numRequests,
@@ -879,6 +895,24 @@ const std::unordered_map<std::string, bool>& HWComposer::getSupportedLayerGeneri
 
 void HWComposer::dump(std::string& result) const {
     result.append(mComposer->dumpDebugInfo());
+
+    for (const auto& [displayId, displayData] : mDisplayData) {
+        if (!displayData.hwcDisplay) {
+            continue;
+        }
+        const auto stats = displayData.hwcDisplay->getLayerCommandStats();
+        const auto lastFrameStats = displayData.hwcDisplay->getLastFrameLayerCommandStats();
+        const uint64_t total = stats.sent + stats.suppressed;
+        base::StringAppendF(&result,
+                            "HWC display %" PRIu64 " layer commands: %" PRIu64 " sent, %" PRIu64
+                            " suppressed as unchanged (%.1f%%); last frame %" PRIu64
+                            " sent, %" PRIu64 " suppressed\n",
+                            displayData.hwcDisplay->getId(), stats.sent, stats.suppressed,
+                            total == 0 ? 0.f
+                                       : 100.f * static_cast<float>(stats.suppressed) /
+                                               static_cast<float>(total),
+                            lastFrameStats.sent, lastFrameStats.suppressed);
+    }
 }
 
 std::optional<PhysicalDisplayId> HWComposer::toPhysicalDisplayId(
@@ -22,11 +22,13 @@
 #define LOG_TAG "PowerAdvisor"
 
 #include <unistd.h>
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 #include <optional>
 
 #include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <utils/Log.h>
 #include <utils/Mutex.h>
 #include <utils/Trace.h>
@@ -76,7 +78,10 @@ void traceExpensiveRendering(bool enabled) {
 } // namespace
 
 PowerAdvisor::PowerAdvisor(SurfaceFlinger& flinger)
-      : mPowerHal(std::make_unique<power::PowerHalController>()), mFlinger(flinger) {
+      : mPowerHal(std::make_unique<power::PowerHalController>()),
+        mFlinger(flinger),
+        mUsePredictedWorkDuration(
+                base::GetBoolProperty(std::string("debug.sf.predict_work_duration"), false)) {
     if (getUpdateTimeout() > 0ms) {
         mScreenUpdateTimer.emplace("UpdateImminentTimer", getUpdateTimeout(),
                                    /* resetCallback */ nullptr,
@@ -125,6 +130,20 @@ void PowerAdvisor::setExpensiveRenderingExpected(DisplayId displayId, bool expec
 
     const bool expectsExpensiveRendering = !mExpensiveDisplays.empty();
     if (mNotifiedExpensiveRendering != expectsExpensiveRendering) {
+        if (power::PowerHintDispatcher* dispatcher = getHintDispatcher()) {
+            if (!dispatcher->isSupported(Mode::EXPENSIVE_RENDERING)) {
+                mHasExpensiveRendering = false;
+                if (mNotifiedExpensiveRendering) {
+                    mNotifiedExpensiveRendering = false;
+                    traceExpensiveRendering(false);
+                }
+                return;
+            }
+            dispatcher->setMode(Mode::EXPENSIVE_RENDERING, expectsExpensiveRendering);
+            mNotifiedExpensiveRendering = expectsExpensiveRendering;
+            traceExpensiveRendering(mNotifiedExpensiveRendering);
+            return;
+        }
         auto ret = getPowerHal().setMode(Mode::EXPENSIVE_RENDERING, expectsExpensiveRendering);
         if (!ret.isOk()) {
             if (ret.isUnsupported()) {
@@ -147,16 +166,14 @@ void PowerAdvisor::notifyDisplayUpdateImminentAndCpuReset() {
 
     if (mSendUpdateImminent.exchange(false)) {
         ALOGV("AIDL notifyDisplayUpdateImminentAndCpuReset");
-        if (usePowerHintSession() && ensurePowerHintSessionRunning()) {
-            std::lock_guard lock(mHintSessionMutex);
-            auto ret = mHintSession->sendHint(SessionHint::CPU_LOAD_RESET);
-            if (!ret.isOk()) {
-                mHintSessionRunning = false;
-            }
-        }
+        power::PowerHintDispatcher* dispatcher = getHintDispatcher();
+        sendHintSessionHint(SessionHint::CPU_LOAD_RESET);
 
         if (!mHasDisplayUpdateImminent) {
             ALOGV("Skipped sending DISPLAY_UPDATE_IMMINENT because HAL doesn't support it");
+        } else if (dispatcher != nullptr) {
+            dispatcher->setBoost(Boost::DISPLAY_UPDATE_IMMINENT, 0);
+            mHasDisplayUpdateImminent = dispatcher->isSupported(Boost::DISPLAY_UPDATE_IMMINENT);
         } else {
             auto ret = getPowerHal().setBoost(Boost::DISPLAY_UPDATE_IMMINENT, 0);
             if (ret.isUnsupported()) {
@@ -178,6 +195,21 @@ void PowerAdvisor::notifyDisplayUpdateImminentAndCpuReset() {
     }
 }
 
+void PowerAdvisor::sendHintSessionHint(SessionHint hint) {
+    if (!usePowerHintSession() || !ensurePowerHintSessionRunning()) {
+        return;
+    }
+    if (power::PowerHintDispatcher* dispatcher = getHintDispatcher()) {
+        dispatcher->sendHint(hint);
+        return;
+    }
+    std::lock_guard lock(mHintSessionMutex);
+    auto ret = mHintSession->sendHint(hint);
+    if (!ret.isOk()) {
+        mHintSessionRunning = false;
+    }
+}
+
 // checks both if it supports and if it's enabled
 bool PowerAdvisor::usePowerHintSession() {
     // uses cached value since the underlying support and flag are unlikely to change at runtime
@@ -193,6 +225,10 @@ bool PowerAdvisor::supportsPowerHintSession() {
 }
 
 bool PowerAdvisor::ensurePowerHintSessionRunning() {
+    if (mHintSessionRunning && mHintDispatcher != nullptr &&
+        mHintDispatcher->takeHintSessionFailure()) {
+        mHintSessionRunning = false;
+    }
     if (!mHintSessionRunning && !mHintSessionThreadIds.empty() && usePowerHintSession()) {
         startPowerHintSession(mHintSessionThreadIds);
     }
@@ -211,6 +247,10 @@ void PowerAdvisor::updateTargetWorkDuration(Duration targetDuration) {
         if (ensurePowerHintSessionRunning() && (targetDuration != mLastTargetDurationSent)) {
             ALOGV("Sending target time: %" PRId64 "ns", targetDuration.ns());
             mLastTargetDurationSent = targetDuration;
+            if (power::PowerHintDispatcher* dispatcher = getHintDispatcher()) {
+                dispatcher->updateTargetWorkDuration(targetDuration.ns());
+                return;
+            }
             std::lock_guard lock(mHintSessionMutex);
             auto ret = mHintSession->updateTargetWorkDuration(targetDuration.ns());
             if (!ret.isOk()) {
@@ -235,10 +275,21 @@ void PowerAdvisor::reportActualWorkDuration() {
     }
     actualDuration = std::make_optional(*actualDuration + sTargetSafetyMargin);
     mActualDuration = actualDuration;
+    if (mUsePredictedWorkDuration) {
+        const bool usedClientComposition =
+                std::any_of(mDisplayIds.begin(), mDisplayIds.end(), [&](DisplayId id) {
+                    const auto it = mDisplayTimingData.find(id);
+                    return it != mDisplayTimingData.end() && it->second.usedClientComposition;
+                });
+        mWorkDurationPrediction.update(*actualDuration, usedClientComposition, mTargetDuration);
+    }
     WorkDuration duration;
     duration.durationNanos = actualDuration->ns();
     duration.timeStampNanos = TimePoint::now().ns();
-    mHintSessionQueue.push_back(duration);
+    power::PowerHintDispatcher* dispatcher = getHintDispatcher();
+    if (dispatcher == nullptr) {
+        mHintSessionQueue.push_back(duration);
+    }
 
     if (sTraceHintSessionData) {
         ATRACE_INT64("Measured duration", actualDuration->ns());
@@ -254,6 +305,12 @@ void PowerAdvisor::reportActualWorkDuration() {
           actualDuration->ns(), mLastTargetDurationSent.ns(),
           Duration{*actualDuration - mLastTargetDurationSent}.ns());
 
+    if (dispatcher != nullptr) {
+        if (!dispatcher->reportActualWorkDuration(duration)) {
+            ALOGW("Dropped an actual work duration, the power hint session is falling behind");
+        }
+        return;
+    }
     {
         std::lock_guard lock(mHintSessionMutex);
         auto ret = mHintSession->reportActualWorkDuration(mHintSessionQueue);
@@ -296,6 +353,9 @@ bool PowerAdvisor::startPowerHintSession(const std::vector<int32_t>& threadIds)
             mHintSessionRunning = true;
             mHintSession = ret.value();
         }
+        if (power::PowerHintDispatcher* dispatcher = getHintDispatcher()) {
+            dispatcher->setHintSession(mHintSession);
+        }
     }
     return mHintSessionRunning;
 }
@@ -339,6 +399,31 @@ void PowerAdvisor::setHwcPresentTiming(DisplayId displayId, TimePoint presentSta
     displayData.hwcPresentEndTime = presentEndTime;
 }
 
+void PowerAdvisor::setExpectedClientComposition(DisplayId /* displayId */, bool expected) {
+    if (!mUsePredictedWorkDuration) {
+        return;
+    }
+    WorkDurationPrediction& prediction = mWorkDurationPrediction;
+    // The frame is predicted to use client composition if any of its displays is expected to
+    prediction.expectsClientComposition |= expected;
+    prediction.predictedDuration = prediction.predict();
+    if (!prediction.predictedDuration || prediction.sentLoadUpHint) {
+        return;
+    }
+    if (sTraceHintSessionData) {
+        ATRACE_INT64("Predicted duration", prediction.predictedDuration->ns());
+    }
+    // The actual work durations already tell the governor about the frames which keep going over
+    // the target, so only a frame predicted to go over it after one which did not is hinted.
+    if (*prediction.predictedDuration > mTargetDuration &&
+        mActualDuration.value_or(Duration{0ns}) <= mTargetDuration) {
+        ATRACE_NAME("PredictedWorkDurationOverTarget");
+        sendHintSessionHint(SessionHint::CPU_LOAD_UP);
+        prediction.sentLoadUpHint = true;
+        prediction.loadUpHints++;
+    }
+}
+
 void PowerAdvisor::setSkippedValidate(DisplayId displayId, bool skipped) {
     mDisplayTimingData[displayId].skippedValidate = skipped;
 }
@@ -367,6 +452,10 @@ void PowerAdvisor::setHwcPresentDelayedTime(DisplayId displayId, TimePoint earli
 
 void PowerAdvisor::setCommitStart(TimePoint commitStartTime) {
     mCommitStartTimes.append(commitStartTime);
+    // A new frame starts, which has not been predicted yet
+    mWorkDurationPrediction.expectsClientComposition = false;
+    mWorkDurationPrediction.predictedDuration.reset();
+    mWorkDurationPrediction.sentLoadUpHint = false;
 }
 
 void PowerAdvisor::setCompositeEnd(TimePoint compositeEndTime) {
@@ -381,6 +470,61 @@ void PowerAdvisor::setTotalFrameTargetWorkDuration(Duration targetDuration) {
     mTotalFrameTargetDuration = targetDuration;
 }
 
+void PowerAdvisor::dump(std::string& result) const {
+    const WorkDurationPrediction& prediction = mWorkDurationPrediction;
+    base::StringAppendF(&result, "PowerAdvisor: predicted work duration %s\n",
+                  mUsePredictedWorkDuration ? "enabled" : "disabled");
+    if (!mUsePredictedWorkDuration) {
+        return;
+    }
+    const auto toUs = [](std::optional<Duration> duration) {
+        return duration ? ticks<std::micro, float>(*duration) : 0.f;
+    };
+    base::StringAppendF(&result,
+                  "    average work duration: client composition %.1fus, device composition "
+                  "%.1fus\n",
+                  toUs(prediction.clientCompositionDuration),
+                  toUs(prediction.deviceCompositionDuration));
+    base::StringAppendF(&result, "    predictions: %zu, mean absolute error %.1fus\n",
+                  prediction.predictions,
+                  prediction.predictions == 0
+                          ? 0.f
+                          : ticks<std::micro, float>(prediction.totalAbsoluteError) /
+                                  prediction.predictions);
+    base::StringAppendF(&result,
+                  "    frames over target: %zu, predicted %zu, falsely predicted %zu, "
+                  "CPU_LOAD_UP hints %zu\n",
+                  prediction.framesOverTarget, prediction.predictedFramesOverTarget,
+                  prediction.falsePredictionsOverTarget, prediction.loadUpHints);
+}
+
+std::optional<Duration> PowerAdvisor::WorkDurationPrediction::predict() const {
+    return expectsClientComposition ? clientCompositionDuration : deviceCompositionDuration;
+}
+
+void PowerAdvisor::WorkDurationPrediction::update(Duration actualDuration,
+                                                  bool usedClientComposition,
+                                                  Duration targetDuration) {
+    const bool overTarget = actualDuration > targetDuration;
+    framesOverTarget += overTarget ? 1 : 0;
+    if (predictedDuration) {
+        predictions++;
+        totalAbsoluteError += actualDuration > *predictedDuration
+                ? actualDuration - *predictedDuration
+                : *predictedDuration - actualDuration;
+        if (*predictedDuration > targetDuration) {
+            predictedFramesOverTarget += overTarget ? 1 : 0;
+            falsePredictionsOverTarget += overTarget ? 0 : 1;
+        }
+    }
+    predictedDuration.reset();
+
+    // Weighted towards the recent frames, with a weight of 1/8 for the last one
+    std::optional<Duration>& average =
+            usedClientComposition ? clientCompositionDuration : deviceCompositionDuration;
+    average = average ? Duration{*average + (actualDuration - *average) / 8} : actualDuration;
+}
+
 std::vector<DisplayId> PowerAdvisor::getOrderedDisplayIds(
         std::optional<TimePoint> DisplayTimingData::*sortBy) {
     std::vector<DisplayId> sortedDisplays;
@@ -567,12 +711,25 @@ const Duration PowerAdvisor::sTargetSafetyMargin = std::chrono::microseconds(
 const bool PowerAdvisor::sUseReportActualDuration =
         base::GetBoolProperty(std::string("debug.adpf.use_report_actual_duration"), true);
 
+const bool PowerAdvisor::sUseAsyncPowerHints =
+        base::GetBoolProperty(std::string("debug.sf.async_power_hints"), false);
+
 power::PowerHalController& PowerAdvisor::getPowerHal() {
     static std::once_flag halFlag;
     std::call_once(halFlag, [this] { mPowerHal->init(); });
     return *mPowerHal;
 }
 
+power::PowerHintDispatcher* PowerAdvisor::getHintDispatcher() {
+    if (!sUseAsyncPowerHints) {
+        return nullptr;
+    }
+    std::call_once(mHintDispatcherFlag, [this] {
+        mHintDispatcher = std::make_unique<power::PowerHintDispatcher>(getPowerHal());
+    });
+    return mHintDispatcher.get();
+}
+
 } // namespace impl
 } // namespace Hwc2
 } // namespace android
@@ -18,6 +18,8 @@
 
 #include <atomic>
 #include <chrono>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -28,6 +30,7 @@
 #include <android/hardware/power/IPower.h>
 #include <compositionengine/impl/OutputCompositionState.h>
 #include <powermanager/PowerHalController.h>
+#include <powermanager/PowerHintDispatcher.h>
 #include <scheduler/Time.h>
 #include <ui/DisplayIdentification.h>
 #include "../Scheduler/OneShotTimer.h"
@@ -78,6 +81,9 @@ public:
     // Reports whether a display used client composition this frame
     virtual void setRequiresClientComposition(DisplayId displayId,
                                               bool requiresClientComposition) = 0;
+    // Reports whether a display is expected to use client composition this frame, as predicted
+    // before its composition strategy is chosen
+    virtual void setExpectedClientComposition(DisplayId displayId, bool expected) = 0;
     // Reports whether a given display skipped validation this frame
     virtual void setSkippedValidate(DisplayId displayId, bool skipped) = 0;
     // Reports when a hwc present is delayed, and the time that it will resume
@@ -93,6 +99,8 @@ public:
     virtual void setDisplays(std::vector<DisplayId>& displayIds) = 0;
     // Sets the target duration for the entire pipeline including the gpu
     virtual void setTotalFrameTargetWorkDuration(Duration targetDuration) = 0;
+    // Dumps the state of the predicted work durations
+    virtual void dump(std::string& result) const = 0;
 };
 
 namespace impl {
@@ -123,6 +131,7 @@ public:
                              TimePoint presentEndTime) override;
     void setSkippedValidate(DisplayId displayId, bool skipped) override;
     void setRequiresClientComposition(DisplayId displayId, bool requiresClientComposition) override;
+    void setExpectedClientComposition(DisplayId displayId, bool expected) override;
     void setExpectedPresentTime(TimePoint expectedPresentTime) override;
     void setSfPresentTiming(TimePoint presentFenceTime, TimePoint presentEndTime) override;
     void setHwcPresentDelayedTime(DisplayId displayId, TimePoint earliestFrameStartTime) override;
@@ -132,6 +141,7 @@ public:
     void setCompositeEnd(TimePoint compositeEndTime) override;
     void setDisplays(std::vector<DisplayId>& displayIds) override;
     void setTotalFrameTargetWorkDuration(Duration targetDuration) override;
+    void dump(std::string& result) const override;
 
 private:
     friend class PowerAdvisorTest;
@@ -209,6 +219,39 @@ private:
         }
     };
 
+    // Predicts the work duration of a frame before it is composed, from the recent frames which
+    // used the same kind of composition, so that the CPU can ramp up ahead of the heavy frames.
+    struct WorkDurationPrediction {
+        // Moving averages of the actual work durations of the frames with and without client
+        // composition
+        std::optional<Duration> clientCompositionDuration;
+        std::optional<Duration> deviceCompositionDuration;
+        // The state of the frame being composed
+        bool expectsClientComposition = false;
+        std::optional<Duration> predictedDuration;
+        bool sentLoadUpHint = false;
+
+        // Accuracy of the predictions, compared with the actual work durations
+        size_t predictions = 0;
+        Duration totalAbsoluteError{0ns};
+        // The frames which went over the target, and how many of them were predicted to
+        size_t framesOverTarget = 0;
+        size_t predictedFramesOverTarget = 0;
+        // The frames predicted to go over the target which did not
+        size_t falsePredictionsOverTarget = 0;
+        size_t loadUpHints = 0;
+
+        std::optional<Duration> predict() const;
+        void update(Duration actualDuration, bool usedClientComposition, Duration targetDuration);
+    };
+    // Whether the hint session is sent a CPU_LOAD_UP hint before the frames predicted to go over
+    // the target duration
+    bool mUsePredictedWorkDuration;
+    WorkDurationPrediction mWorkDurationPrediction;
+
+    // Sends a hint to the hint session, if it is running
+    void sendHintSessionHint(hardware::power::SessionHint hint);
+
     // Filter and sort the display ids by a given property
     std::vector<DisplayId> getOrderedDisplayIds(
             std::optional<TimePoint> DisplayTimingData::*sortBy);
@@ -239,6 +282,13 @@ private:
 
     // Ensure powerhal connection is initialized
     power::PowerHalController& getPowerHal();
+    // Returns the dispatcher which delivers the hints of the frames from its own thread, or
+    // nullptr if the hints are sent synchronously.
+    power::PowerHintDispatcher* getHintDispatcher();
+
+    std::once_flag mHintDispatcherFlag;
+    // Declared after the controller, which it delivers the hints through until it is destroyed.
+    std::unique_ptr<power::PowerHintDispatcher> mHintDispatcher;
 
     std::optional<bool> mHintSessionEnabled;
     std::optional<bool> mSupportsHintSession;
@@ -272,6 +322,9 @@ private:
     // Whether we should send reportActualWorkDuration calls
     static const bool sUseReportActualDuration;
 
+    // Whether the hints are delivered asynchronously, by a PowerHintDispatcher
+    static const bool sUseAsyncPowerHints;
+
     // How long we expect hwc to run after the present call until it waits for the fence
     static constexpr const Duration kFenceWaitStartDelayValidated{150us};
     static constexpr const Duration kFenceWaitStartDelaySkippedValidate{250us};
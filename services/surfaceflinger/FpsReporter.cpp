@@ -26,6 +26,114 @@
 
 namespace android {
 
+using surfaceflinger::frontend::UNASSIGNED_LAYER_ID;
+
+void TaskLayerTracker::onLayerAdded(const RequestedLayerState& layer) {
+    mNodes.try_emplace(layer.id);
+    onLayerChanged(layer);
+}
+
+void TaskLayerTracker::onLayerChanged(const RequestedLayerState& layer) {
+    auto it = mNodes.find(layer.id);
+    if (it == mNodes.end()) {
+        return;
+    }
+    if (it->second.parentId != layer.parentId) {
+        setParent(layer.id, layer.parentId);
+    }
+    const std::optional<int32_t> taskId = layer.metadata.has(gui::METADATA_TASK_ID)
+            ? std::make_optional(layer.metadata.getInt32(gui::METADATA_TASK_ID, 0))
+            : std::nullopt;
+    Node& node = it->second;
+    if (node.taskId != taskId) {
+        if (node.taskId) {
+            updateTaskLayers(layer.id, *node.taskId, -1);
+        }
+        node.taskId = taskId;
+        if (taskId) {
+            updateTaskLayers(layer.id, *taskId, 1);
+        }
+    }
+}
+
+void TaskLayerTracker::onLayerDestroyed(const RequestedLayerState& layer) {
+    auto it = mNodes.find(layer.id);
+    if (it == mNodes.end()) {
+        return;
+    }
+    setParent(layer.id, UNASSIGNED_LAYER_ID);
+    if (it->second.taskId) {
+        updateTaskLayers(layer.id, *it->second.taskId, -1);
+    }
+    for (uint32_t childId : it->second.children) {
+        if (auto child = mNodes.find(childId); child != mNodes.end()) {
+            child->second.parentId = UNASSIGNED_LAYER_ID;
+        }
+    }
+    mNodes.erase(it);
+}
+
+const std::unordered_set<int32_t>* TaskLayerTracker::getTaskLayers(int32_t taskId) const {
+    const auto it = mTasks.find(taskId);
+    return it == mTasks.end() ? nullptr : &it->second.layerIds;
+}
+
+void TaskLayerTracker::setParent(uint32_t id, uint32_t parentId) {
+    Node& node = mNodes[id];
+    forEachTaskOf(node.parentId, [&](int32_t taskId) { updateTaskLayers(id, taskId, -1); });
+    if (auto parent = mNodes.find(node.parentId); parent != mNodes.end()) {
+        auto& siblings = parent->second.children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), id), siblings.end());
+    }
+    node.parentId = parentId;
+    if (auto parent = mNodes.find(parentId); parent != mNodes.end()) {
+        parent->second.children.push_back(id);
+    }
+    forEachTaskOf(parentId, [&](int32_t taskId) { updateTaskLayers(id, taskId, 1); });
+}
+
+void TaskLayerTracker::updateTaskLayers(uint32_t id, int32_t taskId, int delta) {
+    TaskLayers& task = mTasks[taskId];
+    std::vector<uint32_t> pending = {id};
+    // A loop in the parents, which is a client error, must not hang the main thread.
+    for (size_t visited = 0; !pending.empty() && visited <= mNodes.size(); visited++) {
+        const uint32_t layerId = pending.back();
+        pending.pop_back();
+        const auto it = mNodes.find(layerId);
+        if (it == mNodes.end()) {
+            continue;
+        }
+        const auto layerIdInt = static_cast<int32_t>(layerId);
+        if (delta > 0) {
+            if (task.counts[layerIdInt]++ == 0) {
+                task.layerIds.insert(layerIdInt);
+            }
+        } else if (auto count = task.counts.find(layerIdInt);
+                   count != task.counts.end() && --count->second == 0) {
+            task.counts.erase(count);
+            task.layerIds.erase(layerIdInt);
+        }
+        pending.insert(pending.end(), it->second.children.begin(), it->second.children.end());
+    }
+    if (task.layerIds.empty()) {
+        mTasks.erase(taskId);
+    }
+}
+
+template <typename F>
+void TaskLayerTracker::forEachTaskOf(uint32_t id, F f) const {
+    for (size_t depth = 0; id != UNASSIGNED_LAYER_ID && depth <= mNodes.size(); depth++) {
+        const auto it = mNodes.find(id);
+        if (it == mNodes.end()) {
+            return;
+        }
+        if (it->second.taskId) {
+            f(*it->second.taskId);
+        }
+        id = it->second.parentId;
+    }
+}
+
 FpsReporter::FpsReporter(frametimeline::FrameTimeline& frameTimeline, SurfaceFlinger& flinger,
                          std::unique_ptr<Clock> clock)
       : mFrameTimeline(frameTimeline), mFlinger(flinger), mClock(std::move(clock)) {
@@ -51,6 +159,16 @@ void FpsReporter::dispatchLayerFps() {
                        });
     }
 
+    if (mTaskLayerTracker) {
+        for (const TrackedListener& listener : localListeners) {
+            if (const auto* layerIds = mTaskLayerTracker->getTaskLayers(listener.taskId)) {
+                listener.listener->onFpsReported(mFrameTimeline.computeFps(*layerIds));
+            }
+        }
+        mLastDispatch = now;
+        return;
+    }
+
     std::unordered_set<int32_t> seenTasks;
     std::vector<std::pair<TrackedListener, sp<Layer>>> listenersAndLayersToReport;
 
@@ -84,6 +202,11 @@ void FpsReporter::dispatchLayerFps() {
     mLastDispatch = now;
 }
 
+std::shared_ptr<TaskLayerTracker> FpsReporter::trackTaskLayers() {
+    mTaskLayerTracker = std::make_shared<TaskLayerTracker>();
+    return mTaskLayerTracker;
+}
+
 void FpsReporter::binderDied(const wp<IBinder>& who) {
     std::scoped_lock lock(mMutex);
     mListeners.erase(who);
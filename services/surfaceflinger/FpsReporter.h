@@ -20,10 +20,13 @@
 #include <android/gui/IFpsListener.h>
 #include <binder/IBinder.h>
 
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "Clock.h"
 #include "FrameTimeline/FrameTimeline.h"
+#include "FrontEnd/LayerLifecycleManager.h"
 #include "WpHash.h"
 
 namespace android {
@@ -31,6 +34,45 @@ namespace android {
 class Layer;
 class SurfaceFlinger;
 
+// Keeps the ids of the layers in the tree of each task, which are the layers with the task id
+// metadata and their descendants, from the layer lifecycle of the new frontend. The layers of a
+// task are then known without traversing all the layers. Only used from the main thread.
+class TaskLayerTracker
+      : public surfaceflinger::frontend::LayerLifecycleManager::ILifecycleListener {
+public:
+    using RequestedLayerState = surfaceflinger::frontend::RequestedLayerState;
+
+    void onLayerAdded(const RequestedLayerState&) override;
+    void onLayerDestroyed(const RequestedLayerState&) override;
+    void onLayerChanged(const RequestedLayerState&) override;
+
+    // Returns the ids of the layers of the task, or nullptr if it has none.
+    const std::unordered_set<int32_t>* getTaskLayers(int32_t taskId) const;
+
+private:
+    struct Node {
+        uint32_t parentId = surfaceflinger::frontend::UNASSIGNED_LAYER_ID;
+        std::optional<int32_t> taskId;
+        std::vector<uint32_t> children;
+    };
+
+    struct TaskLayers {
+        std::unordered_set<int32_t> layerIds;
+        // The number of layers with the task id metadata that each layer descends from, or is.
+        std::unordered_map<int32_t, uint32_t> counts;
+    };
+
+    void setParent(uint32_t id, uint32_t parentId);
+    // Adds the tree of the layer to the task if delta is 1, or removes it if delta is -1.
+    void updateTaskLayers(uint32_t id, int32_t taskId, int delta);
+    // Calls f with the task id of the layer and of its ancestors which have one.
+    template <typename F>
+    void forEachTaskOf(uint32_t id, F f) const;
+
+    std::unordered_map<uint32_t, Node> mNodes;
+    std::unordered_map<int32_t, TaskLayers> mTasks;
+};
+
 class FpsReporter : public IBinder::DeathRecipient {
 public:
     FpsReporter(frametimeline::FrameTimeline& frameTimeline, SurfaceFlinger& flinger,
@@ -44,6 +86,11 @@ public:
     // Override for IBinder::DeathRecipient
     void binderDied(const wp<IBinder>&) override;
 
+    // Finds the layers of the tasks from the layer lifecycle of the new frontend, instead of
+    // traversing the layers on each dispatch. The returned listener must be registered before
+    // any layer is added.
+    std::shared_ptr<TaskLayerTracker> trackTaskLayers();
+
     // Registers an Fps listener that listens to fps updates for the provided layer
     void addListener(const sp<gui::IFpsListener>& listener, int32_t taskId);
     // Deregisters an Fps listener
@@ -63,6 +110,7 @@ private:
             std::chrono::milliseconds(500);
     std::unique_ptr<Clock> mClock;
     std::chrono::steady_clock::time_point mLastDispatch;
+    std::shared_ptr<TaskLayerTracker> mTaskLayerTracker;
     std::unordered_map<wp<IBinder>, TrackedListener, WpHash> mListeners GUARDED_BY(mMutex);
 };
 
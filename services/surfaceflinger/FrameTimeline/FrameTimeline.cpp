@@ -21,9 +21,11 @@
 #include "FrameTimeline.h"
 
 #include <android-base/stringprintf.h>
+#include <android-base/thread_annotations.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cinttypes>
 #include <numeric>
@@ -743,32 +745,52 @@ namespace impl {
 int64_t TokenManager::generateTokenForPredictions(TimelineItem&& predictions) {
     ATRACE_CALL();
     std::scoped_lock lock(mMutex);
-    while (mPredictions.size() >= kMaxTokens) {
-        mPredictions.erase(mPredictions.begin());
-    }
     const int64_t assignedToken = mCurrentToken++;
-    mPredictions[assignedToken] = predictions;
+    mPredictions[static_cast<size_t>(assignedToken) % kMaxTokens] = {assignedToken, predictions};
     return assignedToken;
 }
 
 std::optional<TimelineItem> TokenManager::getPredictionsForToken(int64_t token) const {
+    if (token < 0) {
+        return {};
+    }
     std::scoped_lock lock(mMutex);
-    auto predictionsIterator = mPredictions.find(token);
-    if (predictionsIterator != mPredictions.end()) {
-        return predictionsIterator->second;
+    const Prediction& prediction = mPredictions[static_cast<size_t>(token) % kMaxTokens];
+    if (prediction.token == token) {
+        return prediction.predictions;
     }
     return {};
 }
 
 FrameTimeline::FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
-                             JankClassificationThresholds thresholds, bool useBootTimeClock)
+                             JankClassificationThresholds thresholds, bool useBootTimeClock,
+                             bool pipelinedPresent)
       : mUseBootTimeClock(useBootTimeClock),
+        mPipelinedPresent(pipelinedPresent),
         mMaxDisplayFrames(kDefaultMaxDisplayFrames),
         mTimeStats(std::move(timeStats)),
         mSurfaceFlingerPid(surfaceFlingerPid),
         mJankClassificationThresholds(thresholds) {
     mCurrentDisplayFrame =
             std::make_shared<DisplayFrame>(mTimeStats, thresholds, &mTraceCookieCounter);
+    if (mPipelinedPresent) {
+        std::scoped_lock lock(mPresentThreadLock);
+        mPresentThread = std::thread(&FrameTimeline::presentLoop, this);
+    }
+}
+
+FrameTimeline::~FrameTimeline() {
+    std::thread thread;
+    {
+        std::scoped_lock lock(mPresentThreadLock);
+        mPresentThreadDone = true;
+        mPresentsQueuedCv.notify_all();
+        mPresentsFlushedCv.notify_all();
+        thread = std::move(mPresentThread);
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
 }
 
 void FrameTimeline::onBootFinished() {
@@ -842,11 +864,88 @@ void FrameTimeline::setSfPresent(nsecs_t sfPresentTime,
     std::scoped_lock lock(mMutex);
     mCurrentDisplayFrame->setActualEndTime(sfPresentTime);
     mCurrentDisplayFrame->setGpuFence(gpuFence);
-    mPendingPresentFences.emplace_back(std::make_pair(presentFence, mCurrentDisplayFrame));
-    flushPendingPresentFences();
+    if (mPipelinedPresent) {
+        queuePresent({presentFence, mCurrentDisplayFrame});
+    } else {
+        mPendingPresentFences.emplace_back(std::make_pair(presentFence, mCurrentDisplayFrame));
+        flushPendingPresentFences();
+    }
     finalizeCurrentDisplayFrame();
 }
 
+void FrameTimeline::queuePresent(PresentRecord&& record) {
+    mPresentQueue.push(std::move(record));
+    mPresentsQueued++;
+    // The lock is only taken so that the worker cannot miss the notification between checking
+    // mPresentsQueued and waiting.
+    { std::scoped_lock lock(mPresentThreadLock); }
+    mPresentsQueuedCv.notify_one();
+}
+
+void FrameTimeline::presentLoop() {
+    std::shared_ptr<FenceTime> pendingFence;
+    while (true) {
+        if (pendingFence) {
+            pendingFence->wait(kPresentFenceTimeoutMs);
+        }
+        {
+            std::unique_lock<std::mutex> lock(mPresentThreadLock);
+            base::ScopedLockAssertion assumeLocked(mPresentThreadLock);
+            const auto hasWork = [&]() REQUIRES(mPresentThreadLock) {
+                return mPresentThreadDone || mPresentsQueued != mPresentsFlushed;
+            };
+            if (!pendingFence) {
+                mPresentsQueuedCv.wait(lock, hasWork);
+            } else if (pendingFence->getSignalTime() == Fence::SIGNAL_TIME_PENDING) {
+                // The fence timed out or cannot be waited on, so poll it again when the next frame
+                // is queued, or after the timeout.
+                mPresentsQueuedCv.wait_for(lock, std::chrono::milliseconds(kPresentFenceTimeoutMs),
+                                           hasWork);
+            }
+            if (mPresentThreadDone) {
+                return;
+            }
+        } // unlock mPresentThreadLock
+
+        pendingFence = flushPresentQueue();
+    }
+}
+
+std::shared_ptr<FenceTime> FrameTimeline::flushPresentQueue() {
+    ATRACE_CALL();
+    uint64_t dequeued = 0;
+    std::vector<std::shared_ptr<DisplayFrame>> presentedFrames;
+    std::shared_ptr<FenceTime> pendingFence;
+    {
+        std::scoped_lock lock(mMutex);
+        while (auto record = mPresentQueue.pop()) {
+            mPendingPresentFences.emplace_back(std::move(record->presentFence),
+                                               std::move(record->displayFrame));
+            dequeued++;
+        }
+        flushPendingPresentFences(&presentedFrames);
+        if (!mPendingPresentFences.empty()) {
+            pendingFence = mPendingPresentFences.front().first;
+        }
+    }
+
+    traceDisplayFrames(presentedFrames);
+
+    std::scoped_lock lock(mPresentThreadLock);
+    mPresentsFlushed += dequeued;
+    mPresentsFlushedCv.notify_all();
+    return pendingFence;
+}
+
+void FrameTimeline::waitForPresentQueue() {
+    const uint64_t queued = mPresentsQueued;
+    std::unique_lock<std::mutex> lock(mPresentThreadLock);
+    base::ScopedLockAssertion assumeLocked(mPresentThreadLock);
+    mPresentsFlushedCv.wait(lock, [&]() REQUIRES(mPresentThreadLock) {
+        return !mPresentThread.joinable() || mPresentsFlushed >= queued;
+    });
+}
+
 void FrameTimeline::DisplayFrame::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
     mSurfaceFrames.push_back(surfaceFrame);
 }
@@ -1126,46 +1225,44 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
         return 0.0f;
     }
 
-    std::vector<nsecs_t> presentTimes;
+    std::vector<LayerPresent> presents;
     {
         std::scoped_lock lock(mMutex);
-        presentTimes.reserve(mDisplayFrames.size());
-        for (size_t i = 0; i < mDisplayFrames.size(); i++) {
-            const auto& displayFrame = mDisplayFrames[i];
-            if (displayFrame->getActuals().presentTime <= 0) {
+        const uint64_t firstPresentIndex =
+                mPresentCount > mMaxDisplayFrames ? mPresentCount - mMaxDisplayFrames + 1 : 1;
+        for (const int32_t layerId : layerIds) {
+            const auto it = mLayerPresents.find(layerId);
+            if (it == mLayerPresents.end()) {
                 continue;
             }
-            for (const auto& surfaceFrame : displayFrame->getSurfaceFrames()) {
-                if (surfaceFrame->getPresentState() == SurfaceFrame::PresentState::Presented &&
-                    layerIds.count(surfaceFrame->getLayerId()) > 0) {
-                    // We're looking for DisplayFrames that presents at least one layer from
-                    // layerIds, so push the present time and skip looking through the rest of the
-                    // SurfaceFrames.
-                    presentTimes.push_back(displayFrame->getActuals().presentTime);
-                    break;
+            const auto& ring = it->second.ring;
+            const size_t count = std::min<uint64_t>(it->second.count, ring.size());
+            for (size_t i = 0; i < count; i++) {
+                if (ring[i].presentIndex >= firstPresentIndex) {
+                    presents.push_back(ring[i]);
                 }
             }
         }
     }
 
+    // We're looking for DisplayFrames that presents at least one layer from layerIds, so the
+    // presents of the layers are merged by display frame.
+    std::sort(presents.begin(), presents.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.presentIndex < rhs.presentIndex;
+    });
+    presents.erase(std::unique(presents.begin(), presents.end(),
+                               [](const auto& lhs, const auto& rhs) {
+                                   return lhs.presentIndex == rhs.presentIndex;
+                               }),
+                   presents.end());
+
     // FPS can't be computed when there's fewer than 2 presented frames.
-    if (presentTimes.size() <= 1) {
+    if (presents.size() <= 1) {
         return 0.0f;
     }
 
-    nsecs_t priorPresentTime = -1;
-    nsecs_t totalPresentToPresentWalls = 0;
-
-    for (const nsecs_t presentTime : presentTimes) {
-        if (priorPresentTime == -1) {
-            priorPresentTime = presentTime;
-            continue;
-        }
-
-        totalPresentToPresentWalls += (presentTime - priorPresentTime);
-        priorPresentTime = presentTime;
-    }
-
+    const nsecs_t totalPresentToPresentWalls =
+            presents.back().presentTime - presents.front().presentTime;
     if (CC_UNLIKELY(totalPresentToPresentWalls <= 0)) {
         ALOGW("Invalid total present-to-present duration when computing fps: %" PRId64,
               totalPresentToPresentWalls);
@@ -1176,7 +1273,7 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
             std::chrono::duration_cast<std::chrono::nanoseconds>(1s).count();
     // (10^9 nanoseconds / second) * (N present deltas) / (total nanoseconds in N present deltas) =
     // M frames / second
-    return kOneSecond * static_cast<nsecs_t>((presentTimes.size() - 1)) /
+    return kOneSecond * static_cast<nsecs_t>((presents.size() - 1)) /
             static_cast<float>(totalPresentToPresentWalls);
 }
 
@@ -1191,7 +1288,8 @@ std::optional<size_t> FrameTimeline::getFirstSignalFenceIndex() const {
     return {};
 }
 
-void FrameTimeline::flushPendingPresentFences() {
+void FrameTimeline::flushPendingPresentFences(
+        std::vector<std::shared_ptr<DisplayFrame>>* presentedFrames) {
     const auto firstSignaledFence = getFirstSignalFenceIndex();
     if (!firstSignaledFence.has_value()) {
         return;
@@ -1202,6 +1300,13 @@ void FrameTimeline::flushPendingPresentFences() {
     const auto monoBootOffset = mUseBootTimeClock
             ? (systemTime(SYSTEM_TIME_BOOTTIME) - systemTime(SYSTEM_TIME_MONOTONIC))
             : 0;
+    const auto trace = [&](const std::shared_ptr<DisplayFrame>& displayFrame) {
+        if (presentedFrames) {
+            presentedFrames->push_back(displayFrame);
+        } else {
+            displayFrame->trace(mSurfaceFlingerPid, monoBootOffset);
+        }
+    };
 
     // Present fences are expected to be signaled in order. Mark all the previous
     // pending fences as errors.
@@ -1210,7 +1315,7 @@ void FrameTimeline::flushPendingPresentFences() {
         const nsecs_t signalTime = Fence::SIGNAL_TIME_INVALID;
         auto& displayFrame = pendingPresentFence.second;
         displayFrame->onPresent(signalTime, mPreviousPresentTime);
-        displayFrame->trace(mSurfaceFlingerPid, monoBootOffset);
+        trace(displayFrame);
         mPendingPresentFences.erase(mPendingPresentFences.begin());
     }
 
@@ -1226,7 +1331,8 @@ void FrameTimeline::flushPendingPresentFences() {
 
         auto& displayFrame = pendingPresentFence.second;
         displayFrame->onPresent(signalTime, mPreviousPresentTime);
-        displayFrame->trace(mSurfaceFlingerPid, monoBootOffset);
+        recordLayerPresents(*displayFrame);
+        trace(displayFrame);
         mPreviousPresentTime = signalTime;
 
         mPendingPresentFences.erase(mPendingPresentFences.begin() + static_cast<int>(i));
@@ -1234,6 +1340,49 @@ void FrameTimeline::flushPendingPresentFences() {
     }
 }
 
+void FrameTimeline::traceDisplayFrames(
+        const std::vector<std::shared_ptr<DisplayFrame>>& displayFrames) const {
+    if (displayFrames.empty()) {
+        return;
+    }
+    const auto monoBootOffset = mUseBootTimeClock
+            ? (systemTime(SYSTEM_TIME_BOOTTIME) - systemTime(SYSTEM_TIME_MONOTONIC))
+            : 0;
+    for (const auto& displayFrame : displayFrames) {
+        displayFrame->trace(mSurfaceFlingerPid, monoBootOffset);
+    }
+}
+
+void FrameTimeline::recordLayerPresents(const DisplayFrame& displayFrame) {
+    const nsecs_t presentTime = displayFrame.getActuals().presentTime;
+    if (presentTime <= 0 || mMaxDisplayFrames == 0) {
+        return;
+    }
+    const uint64_t presentIndex = ++mPresentCount;
+    for (const auto& surfaceFrame : displayFrame.getSurfaceFrames()) {
+        if (surfaceFrame->getPresentState() != SurfaceFrame::PresentState::Presented) {
+            continue;
+        }
+        auto& [ring, count] = mLayerPresents[surfaceFrame->getLayerId()];
+        if (ring.empty()) {
+            ring.resize(mMaxDisplayFrames);
+        }
+        if (count > 0 && ring[(count - 1) % ring.size()].presentIndex == presentIndex) {
+            continue;
+        }
+        ring[count++ % ring.size()] = {presentIndex, presentTime};
+    }
+
+    // Drop the layers that were not presented within the window, such as the destroyed ones, once
+    // per window.
+    if (presentIndex % mMaxDisplayFrames == 0) {
+        std::erase_if(mLayerPresents, [&](const auto& entry) {
+            const auto& [ring, count] = entry.second;
+            return ring[(count - 1) % ring.size()].presentIndex + mMaxDisplayFrames <= presentIndex;
+        });
+    }
+}
+
 void FrameTimeline::finalizeCurrentDisplayFrame() {
     while (mDisplayFrames.size() >= mMaxDisplayFrames) {
         // We maintain only a fixed number of frames' data. Pop older frames
@@ -1350,6 +1499,7 @@ void FrameTimeline::setMaxDisplayFrames(uint32_t size) {
     // The size can either increase or decrease, clear everything, to be consistent
     mDisplayFrames.clear();
     mPendingPresentFences.clear();
+    mLayerPresents.clear();
     mMaxDisplayFrames = size;
 }
 
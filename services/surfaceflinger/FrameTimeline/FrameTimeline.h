@@ -16,13 +16,17 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #include <gui/ISurfaceComposer.h>
 #include <gui/JankInfo.h>
@@ -37,6 +41,7 @@
 
 #include <scheduler/Fps.h>
 
+#include "../LocklessRingQueue.h"
 #include "../TimeStats/TimeStats.h"
 
 namespace android::frametimeline {
@@ -339,12 +344,20 @@ private:
     // Friend class for testing
     friend class android::frametimeline::FrameTimelineTest;
 
-    void flushTokens(nsecs_t flushTime) REQUIRES(mMutex);
+    struct Prediction {
+        int64_t token = FrameTimelineInfo::INVALID_VSYNC_ID;
+        TimelineItem predictions;
+    };
+
+    static constexpr size_t kMaxTokens = 512;
+    static_assert((kMaxTokens & (kMaxTokens - 1)) == 0, "kMaxTokens must be a power of two");
 
-    std::map<int64_t, TimelineItem> mPredictions GUARDED_BY(mMutex);
+    // Ring of predictions indexed by token modulo kMaxTokens, so that storing and looking up
+    // predictions does not allocate. Generating a token overwrites the predictions of the token
+    // generated kMaxTokens tokens earlier, which expires.
+    std::array<Prediction, kMaxTokens> mPredictions GUARDED_BY(mMutex);
     int64_t mCurrentToken GUARDED_BY(mMutex);
     mutable std::mutex mMutex;
-    static constexpr size_t kMaxTokens = 500;
 };
 
 class FrameTimeline : public android::frametimeline::FrameTimeline {
@@ -443,9 +456,12 @@ public:
         TraceCookieCounter& mTraceCookieCounter;
     };
 
+    // If pipelinedPresent is set, setSfPresent only queues the display frame, and a worker thread
+    // waits for its present fence, classifies the jank, updates TimeStats and traces the frame.
     FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
-                  JankClassificationThresholds thresholds = {}, bool useBootTimeClock = true);
-    ~FrameTimeline() = default;
+                  JankClassificationThresholds thresholds = {}, bool useBootTimeClock = true,
+                  bool pipelinedPresent = false);
+    ~FrameTimeline() override;
 
     frametimeline::TokenManager* getTokenManager() override { return &mTokenManager; }
     std::shared_ptr<SurfaceFrame> createSurfaceFrameForToken(
@@ -473,26 +489,78 @@ private:
     // Friend class for testing
     friend class android::frametimeline::FrameTimelineTest;
 
-    void flushPendingPresentFences() REQUIRES(mMutex);
+    struct PresentRecord {
+        std::shared_ptr<FenceTime> presentFence;
+        // Holds the token and the SurfaceFrames of the frame. The main thread no longer changes it
+        // once it is queued.
+        std::shared_ptr<DisplayFrame> displayFrame;
+    };
+
+    // Classifies the display frames whose present fence signaled. If presentedFrames is set, the
+    // frames are added to it so that the caller traces them after releasing mMutex.
+    void flushPendingPresentFences(
+            std::vector<std::shared_ptr<DisplayFrame>>* presentedFrames = nullptr) REQUIRES(mMutex);
+    void traceDisplayFrames(const std::vector<std::shared_ptr<DisplayFrame>>& displayFrames) const;
     std::optional<size_t> getFirstSignalFenceIndex() const REQUIRES(mMutex);
     void finalizeCurrentDisplayFrame() REQUIRES(mMutex);
+    // Records the present time of the display frame for the layers it presented.
+    void recordLayerPresents(const DisplayFrame& displayFrame) REQUIRES(mMutex);
     void dumpAll(std::string& result);
     void dumpJank(std::string& result);
 
+    void queuePresent(PresentRecord&& record) EXCLUDES(mPresentThreadLock);
+    void presentLoop() EXCLUDES(mMutex, mPresentThreadLock);
+    // Moves the queued display frames to mPendingPresentFences and flushes them. Returns the
+    // oldest present fence that is still pending.
+    std::shared_ptr<FenceTime> flushPresentQueue() EXCLUDES(mMutex, mPresentThreadLock);
+    // Waits until the worker has flushed the display frames queued so far.
+    void waitForPresentQueue() EXCLUDES(mPresentThreadLock);
+
     // Sliding window of display frames. TODO(b/168072834): compare perf with fixed size array
     std::deque<std::shared_ptr<DisplayFrame>> mDisplayFrames GUARDED_BY(mMutex);
     std::vector<std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>>
             mPendingPresentFences GUARDED_BY(mMutex);
     std::shared_ptr<DisplayFrame> mCurrentDisplayFrame GUARDED_BY(mMutex);
+
+    // The display frames that presented a layer, within the last mMaxDisplayFrames presented
+    // display frames, so that computeFps only looks at the layers it is asked for instead of the
+    // surface frames of every display frame.
+    struct LayerPresent {
+        // The index of the display frame in the order of presentation, starting at 1.
+        uint64_t presentIndex = 0;
+        nsecs_t presentTime = 0;
+    };
+    struct LayerPresents {
+        // A ring of mMaxDisplayFrames presents, and the number of presents recorded into it.
+        std::vector<LayerPresent> ring;
+        uint64_t count = 0;
+    };
+    std::unordered_map<int32_t, LayerPresents> mLayerPresents GUARDED_BY(mMutex);
+    uint64_t mPresentCount GUARDED_BY(mMutex) = 0;
+
     TokenManager mTokenManager;
     TraceCookieCounter mTraceCookieCounter;
     mutable std::mutex mMutex;
     const bool mUseBootTimeClock;
+    const bool mPipelinedPresent;
     uint32_t mMaxDisplayFrames;
     std::shared_ptr<TimeStats> mTimeStats;
     const pid_t mSurfaceFlingerPid;
     nsecs_t mPreviousPresentTime = 0;
     const JankClassificationThresholds mJankClassificationThresholds;
+
+    static constexpr size_t kPresentQueueCapacity = 16;
+    // How long the worker waits for a present fence before it polls the fence again.
+    static constexpr int kPresentFenceTimeoutMs = 100;
+    LocklessRingQueue<PresentRecord, kPresentQueueCapacity> mPresentQueue;
+    std::atomic<uint64_t> mPresentsQueued = 0;
+    std::mutex mPresentThreadLock;
+    std::thread mPresentThread GUARDED_BY(mPresentThreadLock);
+    bool mPresentThreadDone GUARDED_BY(mPresentThreadLock) = false;
+    uint64_t mPresentsFlushed GUARDED_BY(mPresentThreadLock) = 0;
+    std::condition_variable mPresentsQueuedCv;
+    std::condition_variable mPresentsFlushedCv;
+
     static constexpr uint32_t kDefaultMaxDisplayFrames = 64;
     // The initial container size for the vector<SurfaceFrames> inside display frame. Although
     // this number doesn't represent any bounds on the number of surface frames that can go in a
@@ -129,6 +129,7 @@ void LayerLifecycleManager::onHandlesDestroyed(const std::vector<uint32_t>& dest
             };
             if (linkedLayer->parentId == layer.id) {
                 linkedLayer->parentId = UNASSIGNED_LAYER_ID;
+                mChangedLayers.emplace_back(linkedLayer->id);
                 if (linkedLayer->canBeDestroyed()) {
                     linkedLayer->changes |= RequestedLayerState::Changes::Destroyed;
                     layersToBeDestroyed.emplace_back(linkedLayer->id);
@@ -243,6 +244,10 @@ void LayerLifecycleManager::applyTransactions(const std::vector<TransactionState
                     updateDisplayMirrorLayers(*layer);
                 }
             }
+            if (oldParentId != layer->parentId ||
+                (clientState.what & layer_state_t::eMetadataChanged)) {
+                mChangedLayers.emplace_back(layer->id);
+            }
             if (layer->what & layer_state_t::eLayerStackChanged && layer->isRoot()) {
                 updateDisplayMirrorLayers(*layer);
             }
@@ -268,6 +273,17 @@ void LayerLifecycleManager::commitChanges() {
     }
     mAddedLayers.clear();
 
+    for (uint32_t layerId : mChangedLayers) {
+        const RequestedLayerState* layer = getLayerFromId(layerId);
+        if (!layer || layer->changes.test(RequestedLayerState::Changes::Created)) {
+            continue;
+        }
+        for (auto& listener : mListeners) {
+            listener->onLayerChanged(*layer);
+        }
+    }
+    mChangedLayers.clear();
+
     for (auto& layer : mLayers) {
         layer->clearChanges();
     }
@@ -71,6 +71,9 @@ public:
         // Called on commitChanges when a layer has been destroyed. The callback
         // includes the final state before the layer was destroyed.
         virtual void onLayerDestroyed(const RequestedLayerState&) = 0;
+        // Called on commitChanges when the parent or the metadata of a layer changed, unless
+        // the layer was added or destroyed since changes were last committed.
+        virtual void onLayerChanged(const RequestedLayerState&) {}
     };
     void addLifecycleListener(std::shared_ptr<ILifecycleListener>);
     void removeLifecycleListener(std::shared_ptr<ILifecycleListener>);
@@ -111,6 +114,8 @@ private:
     // Keeps track of all the layers that were added in order. Changes will be cleared once
     // committed.
     std::vector<RequestedLayerState*> mAddedLayers;
+    // Layers whose parent or metadata changed. Cleared once changes are committed.
+    std::vector<uint32_t> mChangedLayers;
 };
 
 } // namespace android::surfaceflinger::frontend
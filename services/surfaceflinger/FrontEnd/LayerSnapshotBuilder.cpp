@@ -23,6 +23,7 @@
 #include <gui/TraceUtils.h>
 #include <ui/FloatRect.h>
 
+#include <algorithm>
 #include <numeric>
 #include <optional>
 
@@ -39,6 +40,8 @@ namespace android::surfaceflinger::frontend {
 using namespace ftl::flag_operators;
 
 namespace {
+constexpr unsigned kMaxWorkerThreads = 4;
+
 FloatRect getMaxDisplayBounds(
         const display::DisplayMap<ui::LayerStack, frontend::DisplayInfo>& displays) {
     const ui::Size maxSize = [&displays] {
@@ -372,6 +375,7 @@ LayerSnapshotBuilder::LayerSnapshotBuilder() : mRootSnapshot(getRootSnapshot())
 LayerSnapshotBuilder::LayerSnapshotBuilder(Args args) : LayerSnapshotBuilder() {
     args.forceUpdate = ForceUpdateFlags::ALL;
     updateSnapshots(args);
+    updateHotFields();
 }
 
 bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
@@ -438,7 +442,7 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root, args.root.getLayer()->id,
                                                                 LayerHierarchy::Variant::Attached);
         updateSnapshotsInHierarchy(args, args.root, root, mRootSnapshot);
-    } else {
+    } else if (!tryParallelUpdate(args)) {
         for (auto& [childHierarchy, variant] : args.root.mChildren) {
             LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
                                                                     childHierarchy->getLayer()->id,
@@ -483,15 +487,148 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
     }
 }
 
+bool LayerSnapshotBuilder::tryParallelUpdate(const Args& args) {
+    if (!args.parallelSubtrees || args.root.mChildren.size() < 2) {
+        return false;
+    }
+    ATRACE_NAME("ParallelUpdate");
+
+    // Create all the snapshots up front and check that the subtrees are independent. Layers that
+    // are relatively parented or mirrored across subtrees are visited by more than one subtree
+    // and in that case we fall back to the serial walk.
+    std::unordered_map<uint32_t, size_t> layerIdToSubtree;
+    std::vector<SubtreeInfo> infos(args.root.mChildren.size());
+    for (size_t i = 0; i < args.root.mChildren.size(); i++) {
+        auto& [childHierarchy, variant] = args.root.mChildren[i];
+        LayerHierarchy::TraversalPath root = LayerHierarchy::TraversalPath::ROOT;
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        if (!prepareSubtree(*childHierarchy, root, mRootSnapshot, i, layerIdToSubtree, infos[i])) {
+            ALOGV("%s subtrees are not independent, falling back to serial update", __func__);
+            return false;
+        }
+    }
+
+    const bool updateAll = args.forceUpdate != ForceUpdateFlags::NONE || args.displayChanges ||
+            mRootSnapshot.changes.get() != 0 || !args.excludeLayerIds.empty();
+
+    if (!mWorkerPool) {
+        const size_t numThreads =
+                std::clamp(std::thread::hardware_concurrency() / 2, 1u, kMaxWorkerThreads);
+        mWorkerPool = std::make_unique<WorkerPool>(numThreads);
+    }
+
+    std::vector<SubtreeTiming> timings(args.root.mChildren.size());
+    std::vector<WorkerPool::Task> tasks;
+    tasks.reserve(args.root.mChildren.size());
+    for (size_t i = 0; i < args.root.mChildren.size(); i++) {
+        auto& [childHierarchy, variant] = args.root.mChildren[i];
+        timings[i].rootLayerId = childHierarchy->getLayer()->id;
+        timings[i].name = childHierarchy->getLayer()->getDebugStringShort();
+        if (!updateAll && !infos[i].hasChanges) {
+            timings[i].skipped = true;
+            continue;
+        }
+        tasks.emplace_back([this, &args, &timing = timings[i], hierarchy = childHierarchy,
+                            variant = variant]() {
+            const nsecs_t start = systemTime();
+            LayerHierarchy::TraversalPath root = LayerHierarchy::TraversalPath::ROOT;
+            LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
+                                                                    hierarchy->getLayer()->id,
+                                                                    variant);
+            updateSnapshotsInHierarchy(args, *hierarchy, root, mRootSnapshot);
+            timing.duration = systemTime() - start;
+        });
+    }
+    mWorkerPool->run(tasks);
+
+    std::scoped_lock lock(mSubtreeTimingsMutex);
+    mSubtreeTimings = std::move(timings);
+    return true;
+}
+
+bool LayerSnapshotBuilder::prepareSubtree(const LayerHierarchy& hierarchy,
+                                          LayerHierarchy::TraversalPath& traversalPath,
+                                          const LayerSnapshot& parentSnapshot, size_t subtreeIndex,
+                                          std::unordered_map<uint32_t, size_t>& layerIdToSubtree,
+                                          SubtreeInfo& outInfo) {
+    const RequestedLayerState* layer = hierarchy.getLayer();
+    const auto [it, inserted] = layerIdToSubtree.emplace(layer->id, subtreeIndex);
+    if (!inserted && it->second != subtreeIndex) {
+        return false;
+    }
+
+    outInfo.hasChanges |= layer->changes.get() != 0;
+    LayerSnapshot* snapshot = getSnapshot(traversalPath);
+    if (!snapshot) {
+        snapshot = createSnapshot(traversalPath, *layer, parentSnapshot);
+        outInfo.hasChanges = true;
+    }
+
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        if (!prepareSubtree(*childHierarchy, traversalPath, *snapshot, subtreeIndex,
+                            layerIdToSubtree, outInfo)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LayerSnapshotBuilder::dumpSubtreeTimings(std::string& out) const {
+    std::scoped_lock lock(mSubtreeTimingsMutex);
+    if (mSubtreeTimings.empty()) {
+        return;
+    }
+    base::StringAppendF(&out, "LayerSnapshotBuilder subtrees (workers=%zu):\n",
+                        mWorkerPool ? mWorkerPool->getThreadCount() : 0);
+    for (const auto& timing : mSubtreeTimings) {
+        if (timing.skipped) {
+            base::StringAppendF(&out, "  %s skipped\n", timing.name.c_str());
+        } else {
+            base::StringAppendF(&out, "  %s %.3fms\n", timing.name.c_str(),
+                                static_cast<float>(timing.duration) / 1e6f);
+        }
+    }
+}
+
 void LayerSnapshotBuilder::update(const Args& args) {
     for (auto& snapshot : mSnapshots) {
         clearChanges(*snapshot);
     }
 
-    if (tryFastUpdate(args)) {
-        return;
+    if (!tryFastUpdate(args)) {
+        updateSnapshots(args);
+    }
+    updateHotFields();
+}
+
+void LayerSnapshotBuilder::HotFields::resize(size_t size) {
+    alpha.resize(size);
+    transformedBounds.resize(size);
+    geomLayerTransform.resize(size);
+    layerStack.resize(size);
+    sequence.resize(size);
+    isVisible.resize(size);
+    hasInputInfo.resize(size);
+}
+
+void LayerSnapshotBuilder::updateHotFields() {
+    ATRACE_NAME("UpdateHotFields");
+    mHotFields.resize(mSnapshots.size());
+    for (size_t i = 0; i < mSnapshots.size(); i++) {
+        const LayerSnapshot& snapshot = *mSnapshots[i];
+        mHotFields.alpha[i] = snapshot.alpha;
+        mHotFields.transformedBounds[i] = snapshot.transformedBounds;
+        mHotFields.geomLayerTransform[i] = snapshot.geomLayerTransform;
+        mHotFields.layerStack[i] = snapshot.outputFilter.layerStack;
+        mHotFields.sequence[i] = static_cast<uint32_t>(snapshot.sequence);
+        mHotFields.isVisible[i] = snapshot.isVisible;
+        mHotFields.hasInputInfo[i] = snapshot.hasInputInfo();
     }
-    updateSnapshots(args);
 }
 
 const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
@@ -1053,7 +1190,7 @@ void LayerSnapshotBuilder::updateInput(LayerSnapshot& snapshot,
 
     auto cropLayerSnapshot = getSnapshot(requested.touchCropId);
     if (cropLayerSnapshot) {
-        mNeedsTouchableRegionCrop.insert(path);
+        addNeedsTouchableRegionCrop(path);
     } else if (snapshot.inputInfo.replaceTouchableRegionWithCrop) {
         FloatRect inputBounds = getInputBounds(snapshot, /*fillParentBounds=*/true).first;
         Rect inputBoundsInDisplaySpace =
@@ -1075,19 +1212,23 @@ void LayerSnapshotBuilder::updateInput(LayerSnapshot& snapshot,
         // WM or the client.
         snapshot.inputInfo.inputConfig.clear(gui::WindowInfo::InputConfig::WATCH_OUTSIDE_TOUCH);
 
-        mNeedsTouchableRegionCrop.insert(path);
+        addNeedsTouchableRegionCrop(path);
     }
 }
 
+void LayerSnapshotBuilder::addNeedsTouchableRegionCrop(const LayerHierarchy::TraversalPath& path) {
+    std::scoped_lock lock(mNeedsTouchableRegionCropMutex);
+    mNeedsTouchableRegionCrop.insert(path);
+}
+
 std::vector<std::unique_ptr<LayerSnapshot>>& LayerSnapshotBuilder::getSnapshots() {
     return mSnapshots;
 }
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor) const {
     for (int i = 0; i < mNumInterestingSnapshots; i++) {
-        LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
-        if (!snapshot.isVisible) continue;
-        visitor(snapshot);
+        if (!mHotFields.isVisible[(size_t)i]) continue;
+        visitor(*mSnapshots[(size_t)i]);
     }
 }
 
@@ -1107,17 +1248,25 @@ void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor,
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const Visitor& visitor) {
     for (int i = 0; i < mNumInterestingSnapshots; i++) {
-        std::unique_ptr<LayerSnapshot>& snapshot = mSnapshots.at((size_t)i);
-        if (!snapshot->isVisible) continue;
-        visitor(snapshot);
+        if (!mHotFields.isVisible[(size_t)i]) continue;
+        visitor(mSnapshots.at((size_t)i));
+    }
+}
+
+void LayerSnapshotBuilder::forEachVisibleSnapshot(ui::LayerStack layerStack,
+                                                  const Visitor& visitor) {
+    for (int i = 0; i < mNumInterestingSnapshots; i++) {
+        if (!mHotFields.isVisible[(size_t)i] || mHotFields.layerStack[(size_t)i] != layerStack) {
+            continue;
+        }
+        visitor(mSnapshots.at((size_t)i));
     }
 }
 
 void LayerSnapshotBuilder::forEachInputSnapshot(const ConstVisitor& visitor) const {
     for (int i = mNumInterestingSnapshots - 1; i >= 0; i--) {
-        LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
-        if (!snapshot.hasInputInfo()) continue;
-        visitor(snapshot);
+        if (!mHotFields.hasInputInfo[(size_t)i]) continue;
+        visitor(*mSnapshots[(size_t)i]);
     }
 }
 
@@ -16,12 +16,18 @@
 
 #pragma once
 
+#include <android-base/thread_annotations.h>
+#include <utils/Timers.h>
+#include <atomic>
+#include <mutex>
+
 #include "Display/DisplayMap.h"
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerLifecycleManager.h"
 #include "LayerHierarchy.h"
 #include "LayerSnapshot.h"
 #include "RequestedLayerState.h"
+#include "WorkerPool.h"
 
 namespace android::surfaceflinger::frontend {
 
@@ -55,6 +61,9 @@ public:
         std::unordered_set<uint32_t> excludeLayerIds;
         const std::unordered_map<std::string, bool>& supportedLayerGenericMetadata;
         const std::unordered_map<std::string, uint32_t>& genericLayerMetadataKeyMap;
+        // If set, the subtrees of the root's children are updated on a worker pool when they do
+        // not share any layers with each other. Subtrees without any changes are skipped.
+        bool parallelSubtrees = false;
     };
     LayerSnapshotBuilder();
 
@@ -70,6 +79,25 @@ public:
     LayerSnapshot* getSnapshot(uint32_t layerId) const;
     LayerSnapshot* getSnapshot(const LayerHierarchy::TraversalPath& id) const;
 
+    // Structure of arrays copy of the snapshot fields that are read on every frame. The arrays
+    // are indexed by the snapshot's position in getSnapshots() (its globalZ) and are refreshed at
+    // the end of every update so z-order passes can filter snapshots without loading each
+    // LayerSnapshot.
+    struct HotFields {
+        std::vector<float> alpha;
+        std::vector<FloatRect> transformedBounds;
+        std::vector<ui::Transform> geomLayerTransform;
+        std::vector<ui::LayerStack> layerStack;
+        std::vector<uint32_t> sequence;
+        // Stored as bytes to avoid the bit packing of std::vector<bool> in hot loops.
+        std::vector<uint8_t> isVisible;
+        std::vector<uint8_t> hasInputInfo;
+
+        size_t size() const { return sequence.size(); }
+        void resize(size_t size);
+    };
+    const HotFields& getHotFields() const { return mHotFields; }
+
     typedef std::function<void(const LayerSnapshot& snapshot)> ConstVisitor;
 
     // Visit each visible snapshot in z-order
@@ -82,9 +110,16 @@ public:
     // Visit each visible snapshot in z-order and move the snapshot if needed
     void forEachVisibleSnapshot(const Visitor& visitor);
 
+    // Visit each visible snapshot on the given layer stack in z-order and move the snapshot if
+    // needed
+    void forEachVisibleSnapshot(ui::LayerStack layerStack, const Visitor& visitor);
+
     // Visit each snapshot interesting to input reverse z-order
     void forEachInputSnapshot(const ConstVisitor& visitor) const;
 
+    // Dump the per subtree timings of the last parallel update.
+    void dumpSubtreeTimings(std::string& out) const;
+
 private:
     friend class LayerSnapshotTest;
     static LayerSnapshot getRootSnapshot();
@@ -95,6 +130,22 @@ private:
 
     void updateSnapshots(const Args& args);
 
+    // Return true if the root's children were updated as independent subtrees on the worker
+    // pool. Returns false without updating any snapshots if the subtrees could not be split.
+    bool tryParallelUpdate(const Args& args);
+
+    struct SubtreeInfo {
+        bool hasChanges = false;
+    };
+    // Creates any missing snapshots in the subtree ahead of the update pass, so the update pass
+    // does not need to modify the snapshot list. Returns false if the subtree shares a layer with
+    // another subtree.
+    bool prepareSubtree(const LayerHierarchy& hierarchy,
+                        LayerHierarchy::TraversalPath& traversalPath,
+                        const LayerSnapshot& parentSnapshot, size_t subtreeIndex,
+                        std::unordered_map<uint32_t, size_t>& layerIdToSubtree,
+                        SubtreeInfo& outInfo);
+
     const LayerSnapshot& updateSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
                                                     LayerHierarchy::TraversalPath& traversalPath,
                                                     const LayerSnapshot& parentSnapshot);
@@ -120,17 +171,32 @@ private:
     void updateChildState(LayerSnapshot& snapshot, const LayerSnapshot& childSnapshot,
                           const Args& args);
     void updateTouchableRegionCrop(const Args& args);
+    void updateHotFields();
+    void addNeedsTouchableRegionCrop(const LayerHierarchy::TraversalPath& path);
 
     std::unordered_map<LayerHierarchy::TraversalPath, LayerSnapshot*,
                        LayerHierarchy::TraversalPathHash>
             mIdToSnapshot;
     // Track snapshots that needs touchable region crop from other snapshots
+    std::mutex mNeedsTouchableRegionCropMutex;
     std::unordered_set<LayerHierarchy::TraversalPath, LayerHierarchy::TraversalPathHash>
             mNeedsTouchableRegionCrop;
     std::vector<std::unique_ptr<LayerSnapshot>> mSnapshots;
     LayerSnapshot mRootSnapshot;
-    bool mResortSnapshots = false;
+    // Written from the worker pool threads during parallel updates.
+    std::atomic<bool> mResortSnapshots = false;
     int mNumInterestingSnapshots = 0;
+    HotFields mHotFields;
+
+    std::unique_ptr<WorkerPool> mWorkerPool;
+    struct SubtreeTiming {
+        uint32_t rootLayerId;
+        std::string name;
+        nsecs_t duration = 0;
+        bool skipped = false;
+    };
+    mutable std::mutex mSubtreeTimingsMutex;
+    std::vector<SubtreeTiming> mSubtreeTimings GUARDED_BY(mSubtreeTimingsMutex);
 };
 
 } // namespace android::surfaceflinger::frontend
@@ -19,14 +19,23 @@
 #define LOG_TAG "TransactionHandler"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <android-base/stringprintf.h>
 #include <cutils/trace.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <cinttypes>
+
 #include "TransactionHandler.h"
 
 namespace android::surfaceflinger::frontend {
 
+namespace {
+// Matches the merge history kept by SurfaceComposerClient::Transaction::merge.
+constexpr size_t kMaxMergeHistoryLength = 10u;
+} // namespace
+
 void TransactionHandler::queueTransaction(TransactionState&& state) {
     mLocklessTransactionQueue.push(std::move(state));
     mPendingTransactionCount.fetch_add(1);
@@ -39,7 +48,7 @@ std::vector<TransactionState> TransactionHandler::flushTransactions() {
         if (!maybeTransaction.has_value()) {
             break;
         }
-        auto transaction = maybeTransaction.value();
+        auto transaction = std::move(*maybeTransaction);
         mPendingTransactionQueues[transaction.applyToken].emplace(std::move(transaction));
     }
 
@@ -69,9 +78,125 @@ std::vector<TransactionState> TransactionHandler::flushTransactions() {
 
     mPendingTransactionCount.fetch_sub(transactions.size());
     ATRACE_INT("TransactionQueue", static_cast<int>(mPendingTransactionCount.load()));
+    if (mCoalescingEnabled) {
+        coalesceTransactions(transactions);
+    }
+    mAppliedTransactionCount.fetch_add(transactions.size(), std::memory_order_relaxed);
     return transactions;
 }
 
+void TransactionHandler::coalesceTransactions(std::vector<TransactionState>& transactions) {
+    if (transactions.size() < 2) {
+        return;
+    }
+
+    ATRACE_CALL();
+    // Only neighbours are merged so the relative order of transactions from different apply
+    // tokens is preserved.
+    size_t coalesced = 0;
+    auto into = transactions.begin();
+    for (auto from = std::next(into); from != transactions.end(); from++) {
+        if (canCoalesce(*into, *from)) {
+            coalesce(*into, std::move(*from));
+            coalesced++;
+            continue;
+        }
+        into++;
+        if (into != from) {
+            *into = std::move(*from);
+        }
+    }
+    transactions.erase(std::next(into), transactions.end());
+
+    if (coalesced > 0) {
+        ATRACE_INT("CoalescedTransactions", static_cast<int>(coalesced));
+        mCoalescedTransactionCount.fetch_add(coalesced, std::memory_order_relaxed);
+    }
+}
+
+bool TransactionHandler::canCoalesce(const TransactionState& into, const TransactionState& from) {
+    if (!into.applyToken || into.applyToken != from.applyToken) {
+        return false;
+    }
+
+    // Transactions with different origins are subject to different permission checks.
+    if (into.originPid != from.originPid || into.originUid != from.originUid) {
+        return false;
+    }
+
+    // Keep frame timeline attribution and present time semantics intact.
+    if (into.frameTimelineInfo.vsyncId != from.frameTimelineInfo.vsyncId ||
+        into.frameTimelineInfo.inputEventId != from.frameTimelineInfo.inputEventId ||
+        !into.isAutoTimestamp || !from.isAutoTimestamp) {
+        return false;
+    }
+
+    if (!into.displays.empty() || !from.displays.empty()) {
+        return false;
+    }
+
+    // A buffer overwritten by the merge would never be released, and barriers are expressed in
+    // terms of buffer frame numbers, so leave any transaction with buffer changes alone.
+    const auto hasBufferChanges = [](const TransactionState& transaction) {
+        return std::any_of(transaction.states.begin(), transaction.states.end(),
+                           [](const ResolvedComposerState& state) {
+                               return state.state.hasBufferChanges();
+                           });
+    };
+    return !hasBufferChanges(into) && !hasBufferChanges(from);
+}
+
+void TransactionHandler::coalesce(TransactionState& into, TransactionState&& from) {
+    for (auto& state : from.states) {
+        auto it = std::find_if(into.states.begin(), into.states.end(),
+                               [&](const ResolvedComposerState& existing) {
+                                   return state.state.surface &&
+                                           existing.state.surface == state.state.surface;
+                               });
+        if (it == into.states.end()) {
+            into.states.emplace_back(std::move(state));
+            continue;
+        }
+
+        // Last writer wins for every field the newer state sets.
+        const uint64_t what = state.state.what;
+        it->state.merge(state.state);
+        it->state.listeners.insert(it->state.listeners.end(),
+                                   std::make_move_iterator(state.state.listeners.begin()),
+                                   std::make_move_iterator(state.state.listeners.end()));
+        if (what & layer_state_t::eReparent) {
+            it->parentId = state.parentId;
+        }
+        if (what & layer_state_t::eRelativeLayerChanged) {
+            it->relativeParentId = state.relativeParentId;
+        }
+        if (what & layer_state_t::eInputInfoChanged) {
+            it->touchCropId = state.touchCropId;
+        }
+    }
+
+    into.flags |= from.flags;
+    into.inputWindowCommands.merge(from.inputWindowCommands);
+    into.uncacheBufferIds.insert(into.uncacheBufferIds.end(), from.uncacheBufferIds.begin(),
+                                 from.uncacheBufferIds.end());
+    into.hasListenerCallbacks |= from.hasListenerCallbacks;
+    into.listenerCallbacks.insert(into.listenerCallbacks.end(),
+                                  std::make_move_iterator(from.listenerCallbacks.begin()),
+                                  std::make_move_iterator(from.listenerCallbacks.end()));
+
+    into.mergedTransactionIds.insert(into.mergedTransactionIds.begin(),
+                                     from.mergedTransactionIds.begin(),
+                                     from.mergedTransactionIds.end());
+    into.mergedTransactionIds.insert(into.mergedTransactionIds.begin(), from.id);
+    if (into.mergedTransactionIds.size() > kMaxMergeHistoryLength) {
+        into.mergedTransactionIds.resize(kMaxMergeHistoryLength);
+    }
+    into.coalescedTransactionIds.push_back(from.id);
+    into.coalescedTransactionIds.insert(into.coalescedTransactionIds.end(),
+                                        from.coalescedTransactionIds.begin(),
+                                        from.coalescedTransactionIds.end());
+}
+
 void TransactionHandler::applyUnsignaledBufferTransaction(
         std::vector<TransactionState>& transactions, TransactionFlushState& flushState) {
     if (!flushState.queueWithUnsignaledBuffer) {
@@ -185,6 +310,16 @@ bool TransactionHandler::hasPendingTransactions() {
     return !mPendingTransactionQueues.empty() || !mLocklessTransactionQueue.isEmpty();
 }
 
+void TransactionHandler::dump(std::string& result) const {
+    const uint64_t applied = mAppliedTransactionCount.load(std::memory_order_relaxed);
+    const uint64_t coalesced = mCoalescedTransactionCount.load(std::memory_order_relaxed);
+    base::StringAppendF(&result,
+                        "TransactionHandler: coalescing=%s applied=%" PRIu64 " coalesced=%" PRIu64
+                        " queueOverflows=%" PRIu64 "\n",
+                        mCoalescingEnabled ? "enabled" : "disabled", applied, coalesced,
+                        mLocklessTransactionQueue.getOverflowPushCount());
+}
+
 void TransactionHandler::onTransactionQueueStalled(uint64_t transactionId,
                                                    sp<ITransactionCompletedListener>& listener,
                                                    const std::string& reason) {
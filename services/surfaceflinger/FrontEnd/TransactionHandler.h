@@ -18,9 +18,10 @@
 
 #include <semaphore.h>
 #include <cstdint>
+#include <string>
 #include <vector>
 
-#include <LocklessQueue.h>
+#include <LocklessRingQueue.h>
 #include <TransactionState.h>
 #include <android-base/thread_annotations.h>
 #include <ftl/small_map.h>
@@ -65,6 +66,12 @@ public:
                                    const std::string& reason);
     void removeFromStalledTransactions(uint64_t transactionId);
 
+    // When enabled, consecutive ready transactions from the same apply token are merged into a
+    // single TransactionState before they are returned by flushTransactions. Only transactions
+    // without buffers, display changes or a desired present time are merged.
+    void setCoalescingEnabled(bool enabled) { mCoalescingEnabled = enabled; }
+    void dump(std::string& result) const;
+
 private:
     // For unit tests
     friend class ::android::TestableSurfaceFlinger;
@@ -74,12 +81,23 @@ private:
     void popTransactionFromPending(std::vector<TransactionState>&, TransactionFlushState&,
                                    std::queue<TransactionState>&);
     TransactionReadiness applyFilters(TransactionFlushState&);
+    void coalesceTransactions(std::vector<TransactionState>&);
+    static bool canCoalesce(const TransactionState& into, const TransactionState& from);
+    static void coalesce(TransactionState& into, TransactionState&& from);
     std::unordered_map<sp<IBinder>, std::queue<TransactionState>, IListenerHash>
             mPendingTransactionQueues;
-    LocklessQueue<TransactionState> mLocklessTransactionQueue;
+    // Sized for a burst of transactions from many clients within one frame; anything beyond that
+    // spills into an allocating list.
+    static constexpr size_t kTransactionQueueCapacity = 64;
+    LocklessRingQueue<TransactionState, kTransactionQueueCapacity> mLocklessTransactionQueue;
     std::atomic<size_t> mPendingTransactionCount = 0;
     ftl::SmallVector<TransactionFilter, 2> mTransactionReadyFilters;
     std::vector<uint64_t> mStalledTransactions;
+
+    bool mCoalescingEnabled = false;
+    // Written on the main thread, read by dump.
+    std::atomic<uint64_t> mAppliedTransactionCount = 0;
+    std::atomic<uint64_t> mCoalescedTransactionCount = 0;
 };
 } // namespace surfaceflinger::frontend
 } // namespace android
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "WorkerPool"
+
+#include <pthread.h>
+#include <string>
+
+#include "WorkerPool.h"
+
+namespace android::surfaceflinger::frontend {
+
+WorkerPool::WorkerPool(size_t numThreads) {
+    mThreads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        mThreads.emplace_back(&WorkerPool::loop, this);
+        const std::string name = "SfFrontEnd" + std::to_string(i);
+        pthread_setname_np(mThreads.back().native_handle(), name.c_str());
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::scoped_lock lock(mMutex);
+        mDone = true;
+    }
+    mWorkCv.notify_all();
+    for (auto& thread : mThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void WorkerPool::run(std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    std::unique_lock lock(mMutex);
+    mTasks = &tasks;
+    mNextTask = 0;
+    mPendingTasks = tasks.size();
+    mWorkCv.notify_all();
+
+    while (runNextTaskLocked(lock)) {
+    }
+    mDoneCv.wait(lock, [this]() REQUIRES(mMutex) { return mPendingTasks == 0; });
+    mTasks = nullptr;
+}
+
+bool WorkerPool::runNextTaskLocked(std::unique_lock<std::mutex>& lock) {
+    if (!mTasks || mNextTask >= mTasks->size()) {
+        return false;
+    }
+    Task& task = (*mTasks)[mNextTask++];
+    lock.unlock();
+    task();
+    lock.lock();
+    if (--mPendingTasks == 0) {
+        mDoneCv.notify_all();
+    }
+    return true;
+}
+
+void WorkerPool::loop() {
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mWorkCv.wait(lock, [this]() REQUIRES(mMutex) {
+            return mDone || (mTasks && mNextTask < mTasks->size());
+        });
+        if (mDone) {
+            return;
+        }
+        runNextTaskLocked(lock);
+    }
+}
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::surfaceflinger::frontend {
+
+// A small pool of persistent threads used to run a batch of independent tasks. The calling
+// thread participates in running the batch and run() only returns once every task in the batch
+// has completed, so tasks may safely reference state owned by the caller.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    // Creates a pool with numThreads additional threads. The calling thread of run() is always
+    // used as well, so a pool with zero threads runs every task serially.
+    explicit WorkerPool(size_t numThreads);
+    ~WorkerPool();
+
+    // Runs all tasks and blocks until they are complete. Tasks are started in order but may
+    // complete in any order. Must not be called concurrently or from within a task.
+    void run(std::vector<Task>& tasks);
+
+    size_t getThreadCount() const { return mThreads.size(); }
+
+private:
+    void loop();
+    // Claims and runs the next pending task. Returns false if there are no tasks left to claim.
+    bool runNextTaskLocked(std::unique_lock<std::mutex>& lock) REQUIRES(mMutex);
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCv;
+    std::condition_variable mDoneCv;
+    std::vector<Task>* mTasks GUARDED_BY(mMutex) = nullptr;
+    size_t mNextTask GUARDED_BY(mMutex) = 0;
+    size_t mPendingTasks GUARDED_BY(mMutex) = 0;
+    bool mDone GUARDED_BY(mMutex) = false;
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android::surfaceflinger::frontend
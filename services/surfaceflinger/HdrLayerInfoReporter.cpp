@@ -18,23 +18,85 @@
 #define LOG_TAG "HdrLayerInfoReporter"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <log/log.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "HdrLayerInfoReporter.h"
 
 namespace android {
 
-void HdrLayerInfoReporter::dispatchHdrLayerInfo(const HdrLayerInfo& info) {
+HdrLayerInfoReporter::HdrLayerInfoReporter(std::unique_ptr<Clock> clock)
+      : mClock(std::move(clock)) {
+    LOG_ALWAYS_FATAL_IF(mClock == nullptr,
+                        "Passed in null clock when constructing HdrLayerInfoReporter!");
+}
+
+HdrLayerInfoReporter::HdrLayerInfo HdrLayerInfoReporter::getHdrLayerInfo() const {
+    HdrLayerInfo info;
+    int64_t maxArea = 0;
+    for (const auto& [id, layer] : mHdrLayers) {
+        info.numberOfHdrLayers++;
+        info.mergeDesiredRatio(layer.desiredHdrSdrRatio);
+        const int64_t area = int64_t(layer.width) * layer.height;
+        if (area > maxArea) {
+            maxArea = area;
+            info.maxW = layer.width;
+            info.maxH = layer.height;
+        }
+    }
+    return info;
+}
+
+bool HdrLayerInfoReporter::exceedsHysteresis(const TrackedListener& tracked,
+                                             const HdrLayerInfo& info) {
+    const HdrLayerInfo& last = tracked.lastInfo;
+    const float hysteresis = tracked.options.hysteresis;
+    if (hysteresis <= 0.f || info.numberOfHdrLayers != last.numberOfHdrLayers ||
+        info.flags != last.flags) {
+        return true;
+    }
+    const auto exceeds = [hysteresis](double from, double to) {
+        if (std::isinf(from) || std::isinf(to)) {
+            return from != to;
+        }
+        return std::abs(to - from) > hysteresis * from;
+    };
+    return exceeds(double(last.maxW) * last.maxH, double(info.maxW) * info.maxH) ||
+            exceeds(last.maxDesiredHdrSdrRatio, info.maxDesiredHdrSdrRatio);
+}
+
+std::optional<std::chrono::nanoseconds> HdrLayerInfoReporter::dispatchHdrLayerInfo(
+        const HdrLayerInfo& info) {
     ATRACE_CALL();
+    const auto now = mClock->now();
     std::vector<sp<gui::IHdrLayerInfoListener>> toInvoke;
+    std::optional<std::chrono::nanoseconds> pendingDelay;
     {
         std::scoped_lock lock(mMutex);
+        mLastInfo = info;
+        std::optional<std::chrono::steady_clock::time_point> nextDispatch;
         toInvoke.reserve(mListeners.size());
         for (auto& [key, it] : mListeners) {
-            if (it.lastInfo != info) {
-                it.lastInfo = info;
-                toInvoke.push_back(it.listener);
+            if (it.lastInfo == info || !exceedsHysteresis(it, info)) {
+                continue;
+            }
+            const bool hdrToggled =
+                    (it.lastInfo.numberOfHdrLayers == 0) != (info.numberOfHdrLayers == 0);
+            const auto due = it.lastDispatch + it.options.minUpdateInterval;
+            if (!hdrToggled && now < due) {
+                nextDispatch = nextDispatch ? std::min(*nextDispatch, due) : due;
+                continue;
             }
+            it.lastInfo = info;
+            it.lastDispatch = now;
+            toInvoke.push_back(it.listener);
+        }
+        if (nextDispatch && (!mPendingDispatch || *nextDispatch < *mPendingDispatch)) {
+            mPendingDispatch = nextDispatch;
+            pendingDelay = *nextDispatch - now;
         }
     }
 
@@ -43,6 +105,17 @@ void HdrLayerInfoReporter::dispatchHdrLayerInfo(const HdrLayerInfo& info) {
         listener->onHdrLayerInfoChanged(info.numberOfHdrLayers, info.maxW, info.maxH, info.flags,
                                         info.maxDesiredHdrSdrRatio);
     }
+    return pendingDelay;
+}
+
+std::optional<std::chrono::nanoseconds> HdrLayerInfoReporter::dispatchPendingHdrLayerInfo() {
+    HdrLayerInfo info;
+    {
+        std::scoped_lock lock(mMutex);
+        mPendingDispatch.reset();
+        info = mLastInfo;
+    }
+    return dispatchHdrLayerInfo(info);
 }
 
 void HdrLayerInfoReporter::binderDied(const wp<IBinder>& who) {
@@ -50,11 +123,15 @@ void HdrLayerInfoReporter::binderDied(const wp<IBinder>& who) {
     mListeners.erase(who);
 }
 
-void HdrLayerInfoReporter::addListener(const sp<gui::IHdrLayerInfoListener>& listener) {
+void HdrLayerInfoReporter::addListener(const sp<gui::IHdrLayerInfoListener>& listener,
+                                       const ListenerOptions& options) {
     sp<IBinder> asBinder = IInterface::asBinder(listener);
     asBinder->linkToDeath(sp<DeathRecipient>::fromExisting(this));
     std::lock_guard lock(mMutex);
-    mListeners.emplace(wp<IBinder>(asBinder), TrackedListener{listener, HdrLayerInfo{}});
+    TrackedListener tracked;
+    tracked.listener = listener;
+    tracked.options = options;
+    mListeners.emplace(wp<IBinder>(asBinder), std::move(tracked));
 }
 
 void HdrLayerInfoReporter::removeListener(const sp<gui::IHdrLayerInfoListener>& listener) {
@@ -20,8 +20,12 @@
 #include <android/gui/IHdrLayerInfoListener.h>
 #include <binder/IBinder.h>
 
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 
+#include "Clock.h"
 #include "WpHash.h"
 
 namespace android {
@@ -58,19 +62,54 @@ public:
         }
     };
 
-    HdrLayerInfoReporter() = default;
+    // The HDR layer of the display that a layer snapshot maps to.
+    struct HdrLayer {
+        int32_t width = 0;
+        int32_t height = 0;
+        // The desired ratio of the layer, where "1" was already replaced with infinity.
+        float desiredHdrSdrRatio = 0.f;
+    };
+
+    // How often and for which changes a listener wants to be called.
+    struct ListenerOptions {
+        // The listener is not called more often than this, but the last update that was held back
+        // is dispatched once the interval elapsed. Updates where HDR layers appear or disappear
+        // are always dispatched right away.
+        std::chrono::nanoseconds minUpdateInterval{0};
+        // The relative change of the max HDR layer area or desired ratio below which an update is
+        // dropped. Changes of the number of HDR layers or the flags are always dispatched.
+        float hysteresis = 0.f;
+    };
+
+    explicit HdrLayerInfoReporter(std::unique_ptr<Clock> clock = std::make_unique<SteadyClock>());
     ~HdrLayerInfoReporter() final = default;
 
-    // Dispatches updated layer fps values for the registered listeners
-    // This method promotes Layer weak pointers and performs layer stack traversals, so mStateLock
-    // must be held when calling this method.
-    void dispatchHdrLayerInfo(const HdrLayerInfo& info) EXCLUDES(mMutex);
+    // The HDR layers of the display, keyed by the unique sequence of their snapshot. The main
+    // thread updates them for the snapshots that changed since the last frame, and computes the
+    // info to dispatch from them.
+    void setHdrLayer(uint32_t id, const HdrLayer& layer) { mHdrLayers[id] = layer; }
+    void removeHdrLayer(uint32_t id) { mHdrLayers.erase(id); }
+    void clearHdrLayers() { mHdrLayers.clear(); }
+    HdrLayerInfo getHdrLayerInfo() const;
+
+    // Dispatches the updated HDR layer info to the registered listeners which it differs for, as
+    // allowed by their options. Returns the delay after which the updates that were held back by
+    // the minimum update interval should be dispatched, with dispatchPendingHdrLayerInfo(), if
+    // no such dispatch is already due.
+    std::optional<std::chrono::nanoseconds> dispatchHdrLayerInfo(const HdrLayerInfo& info)
+            EXCLUDES(mMutex);
+    // Dispatches the last info to the listeners it was held back for.
+    std::optional<std::chrono::nanoseconds> dispatchPendingHdrLayerInfo() EXCLUDES(mMutex);
 
     // Override for IBinder::DeathRecipient
     void binderDied(const wp<IBinder>&) override EXCLUDES(mMutex);
 
     // Registers an Fps listener that listens to fps updates for the provided layer
-    void addListener(const sp<gui::IHdrLayerInfoListener>& listener) EXCLUDES(mMutex);
+    void addListener(const sp<gui::IHdrLayerInfoListener>& listener) EXCLUDES(mMutex) {
+        addListener(listener, ListenerOptions());
+    }
+    void addListener(const sp<gui::IHdrLayerInfoListener>& listener,
+                     const ListenerOptions& options) EXCLUDES(mMutex);
     // Deregisters an Fps listener
     void removeListener(const sp<gui::IHdrLayerInfoListener>& listener) EXCLUDES(mMutex);
 
@@ -84,10 +123,22 @@ private:
 
     struct TrackedListener {
         sp<gui::IHdrLayerInfoListener> listener;
+        ListenerOptions options;
         HdrLayerInfo lastInfo;
+        std::chrono::steady_clock::time_point lastDispatch =
+                std::chrono::steady_clock::time_point::min();
     };
 
+    // Returns whether the change from the last dispatched info is large enough to dispatch.
+    static bool exceedsHysteresis(const TrackedListener&, const HdrLayerInfo& info);
+
+    std::unique_ptr<Clock> mClock;
+    std::unordered_map<uint32_t, HdrLayer> mHdrLayers;
+
     std::unordered_map<wp<IBinder>, TrackedListener, WpHash> mListeners GUARDED_BY(mMutex);
+    HdrLayerInfo mLastInfo GUARDED_BY(mMutex);
+    // When the dispatch of the held back updates is due, if it was returned to the caller.
+    std::optional<std::chrono::steady_clock::time_point> mPendingDispatch GUARDED_BY(mMutex);
 };
 
 } // namespace android
\ No newline at end of file
@@ -52,6 +52,7 @@
 #include <system/graphics-base-v1.0.h>
 #include <ui/DataspaceUtils.h>
 #include <ui/DebugUtils.h>
+#include <ui/FenceSignalWatcher.h>
 #include <ui/FloatRect.h>
 #include <ui/GraphicBuffer.h>
 #include <ui/PixelFormat.h>
@@ -235,6 +236,8 @@ Layer::~Layer() {
         callReleaseBufferCallback(mDrawingState.releaseBufferListener,
                                   mBufferInfo.mBuffer->getBuffer(), mBufferInfo.mFrameNumber,
                                   mBufferInfo.mFence);
+        // The callbacks of the frame may have been sent already.
+        mFlinger->getTransactionCallbackInvoker().sendReleaseCallbacks();
     }
     if (!isClone()) {
         // The original layer and the clone layer share the same texture. Therefore, only one of
@@ -2801,9 +2804,12 @@ void Layer::callReleaseBufferCallback(const sp<ITransactionCompletedListener>& l
     ATRACE_FORMAT_INSTANT("callReleaseBufferCallback %s - %" PRIu64, getDebugName(), framenumber);
     uint32_t currentMaxAcquiredBufferCount =
             mFlinger->getMaxAcquiredBufferCountForCurrentRefreshRate(mOwnerUid);
-    listener->onReleaseBuffer({buffer->getId(), framenumber},
-                              releaseFence ? releaseFence : Fence::NO_FENCE,
-                              currentMaxAcquiredBufferCount);
+    // Sent with the other buffers of the listener released in this frame.
+    mFlinger->getTransactionCallbackInvoker()
+            .addReleaseCallback(listener,
+                                {{buffer->getId(), framenumber},
+                                 releaseFence ? releaseFence : Fence::NO_FENCE,
+                                 currentMaxAcquiredBufferCount});
 }
 
 void Layer::onLayerDisplayed(ftl::SharedFuture<FenceResult> futureFenceResult,
@@ -3114,6 +3120,8 @@ bool Layer::setBuffer(std::shared_ptr<renderengine::ExternalTexture>& buffer,
         // on the callback instead of just the acquire time, since it's unknown at
         // this point.
         mCallbackHandleAcquireTimeOrFence = mDrawingState.acquireFence;
+        // The fence is queried by TimeStats and FrameTracer until it signals.
+        FenceSignalWatcher::getInstance().watch(mDrawingState.acquireFenceTime);
     } else {
         mCallbackHandleAcquireTimeOrFence = mDrawingState.acquireFenceTime->getSignalTime();
     }
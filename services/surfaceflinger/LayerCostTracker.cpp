@@ -0,0 +1,351 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LayerCostTracker"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "LayerCostTracker.h"
+
+#include <android-base/stringprintf.h>
+#include <perfetto/common/builtin_clock.pbzero.h>
+#include <perfetto/trace/track_event/counter_descriptor.pbzero.h>
+#include <perfetto/trace/track_event/track_descriptor.pbzero.h>
+#include <perfetto/trace/track_event/track_event.pbzero.h>
+#include <unistd.h>
+#include <utils/String8.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <unordered_map>
+
+PERFETTO_DEFINE_DATA_SOURCE_STATIC_MEMBERS(android::LayerCostTracker::LayerCostsDataSource,
+                                           android::LayerCostsDataSourceTraits);
+
+namespace android {
+
+using base::StringAppendF;
+
+namespace {
+
+// The tracks of the costs of a layer follow the track of the layer.
+enum TrackOffset : uint64_t { kCpuTrack = 1, kGpuTrack, kHwcTrack, kTracksPerLayer };
+
+float toMicros(nsecs_t duration) {
+    return static_cast<float>(duration) / 1e3f;
+}
+
+} // namespace
+
+LayerCostTracker::LayerCostTracker(bool enabled)
+      : mEnabled(enabled), mNextTrackUuid(static_cast<uint64_t>(getpid()) << 32) {}
+
+void LayerCostTracker::onBootFinished() {
+    registerDataSource();
+}
+
+void LayerCostTracker::registerDataSource() {
+    perfetto::DataSourceDescriptor dsd;
+    dsd.set_name(kLayerCostsDataSource);
+    LayerCostsDataSource::Register(dsd);
+}
+
+bool LayerCostTracker::isEnabled() const {
+    if (mEnabled) {
+        return true;
+    }
+    bool tracing = false;
+    LayerCostsDataSource::Trace([&](LayerCostsDataSource::TraceContext) { tracing = true; });
+    return tracing;
+}
+
+void LayerCostTracker::recordFrame(int64_t vsyncId, nsecs_t time,
+                                   std::vector<OutputComposition>&& outputs) {
+    ATRACE_CALL();
+    std::scoped_lock lock(mMutex);
+    mFrameNumber++;
+
+    Frame frame{.vsyncId = vsyncId, .time = time};
+    // A layer composed by several outputs adds up their costs.
+    std::unordered_map<uint64_t /* trackUuid */, size_t> indices;
+    const auto getIndex = [&](const LayerComposition& layer) {
+        auto [it, inserted] = mKeys.try_emplace(layer.key);
+        KeyInfo& info = it->second;
+        if (inserted) {
+            info.name = layer.key.type == Key::Type::CachedSet
+                    ? base::StringPrintf("CachedSet %#" PRIx64, layer.key.id)
+                    : base::StringPrintf("%.*s#%" PRIu64, static_cast<int>(layer.name.size()),
+                                         layer.name.data(), layer.key.id);
+            info.trackUuid = mNextTrackUuid;
+            mNextTrackUuid += kTracksPerLayer;
+        }
+        if (info.lastFrameNumber != mFrameNumber) {
+            info.lastFrameNumber = mFrameNumber;
+            indices[info.trackUuid] = frame.costs.size();
+            frame.costs.emplace_back(layer.key, Cost{});
+        }
+        return indices[info.trackUuid];
+    };
+
+    for (const auto& output : outputs) {
+        if (output.layers.empty()) {
+            continue;
+        }
+
+        // The layers of a cached set are composed as one, so they share one cost.
+        std::vector<size_t> outputIndices;
+        outputIndices.reserve(output.layers.size());
+        std::map<size_t, int64_t> clientComposedAreas;
+        int64_t totalClientComposedArea = 0;
+        for (const auto& layer : output.layers) {
+            const size_t index = getIndex(layer);
+            frame.costs[index].second.cpu += layer.cpu;
+            if (std::find(outputIndices.begin(), outputIndices.end(), index) ==
+                outputIndices.end()) {
+                outputIndices.push_back(index);
+            }
+            if (layer.clientComposed) {
+                clientComposedAreas[index] += layer.area;
+                totalClientComposedArea += layer.area;
+            }
+        }
+
+        const nsecs_t hwcShare = (output.hwcValidateDuration + output.hwcPresentDuration) /
+                static_cast<nsecs_t>(outputIndices.size());
+        for (const size_t index : outputIndices) {
+            frame.costs[index].second.hwc += hwcShare;
+        }
+
+        if (output.renderEngineFence && !clientComposedAreas.empty()) {
+            Frame::PendingGpuCost pending{.fence = output.renderEngineFence,
+                                          .startTime = output.renderEngineStartTime};
+            for (const auto& [index, area] : clientComposedAreas) {
+                // Layers that cover no area, e.g. because they only cast shadows, split evenly.
+                const float weight = totalClientComposedArea > 0
+                        ? static_cast<float>(area) / static_cast<float>(totalClientComposedArea)
+                        : 1.f / static_cast<float>(clientComposedAreas.size());
+                pending.shares.emplace_back(index, weight);
+            }
+            frame.pendingGpuCosts.push_back(std::move(pending));
+        }
+    }
+
+    mFrames.push_back(std::move(frame));
+    if (mFrames.back().pendingGpuCosts.empty()) {
+        traceFrameLocked(mFrames.back());
+    }
+    while (mFrames.size() > kMaxFrames) {
+        mFrames.pop_front();
+    }
+
+    // Forget the layers that were not composed in the frames that are kept.
+    if (mFrameNumber % kMaxFrames == 0) {
+        std::erase_if(mKeys, [&](const auto& entry) {
+            return entry.second.lastFrameNumber + kMaxFrames <= mFrameNumber;
+        });
+    }
+
+    resolveGpuCostsLocked();
+}
+
+void LayerCostTracker::resolveGpuCostsLocked() {
+    for (auto& frame : mFrames) {
+        if (frame.pendingGpuCosts.empty()) {
+            continue;
+        }
+        std::erase_if(frame.pendingGpuCosts, [&](const Frame::PendingGpuCost& pending) {
+            const nsecs_t signalTime = pending.fence->getSignalTime();
+            if (signalTime == Fence::SIGNAL_TIME_PENDING) {
+                return false;
+            }
+            if (signalTime != Fence::SIGNAL_TIME_INVALID) {
+                const nsecs_t duration = std::max<nsecs_t>(0, signalTime - pending.startTime);
+                for (const auto& [index, weight] : pending.shares) {
+                    frame.costs[index].second.gpu +=
+                            static_cast<nsecs_t>(static_cast<float>(duration) * weight);
+                }
+            }
+            return true;
+        });
+        if (frame.pendingGpuCosts.empty()) {
+            traceFrameLocked(frame);
+        }
+    }
+}
+
+void LayerCostTracker::traceFrameLocked(const Frame& frame) {
+    using perfetto::protos::pbzero::CounterDescriptor;
+    using perfetto::protos::pbzero::TracePacket;
+    using perfetto::protos::pbzero::TrackEvent;
+
+    LayerCostsDataSource::Trace([&](LayerCostsDataSource::TraceContext ctx) {
+        auto* state = ctx.GetIncrementalState();
+        const auto newPacket = [&]() {
+            auto packet = ctx.NewTracePacket();
+            if (state->cleared) {
+                packet->set_sequence_flags(TracePacket::SEQ_INCREMENTAL_STATE_CLEARED);
+                state->cleared = false;
+            }
+            return packet;
+        };
+
+        for (const auto& [key, cost] : frame.costs) {
+            const auto it = mKeys.find(key);
+            if (it == mKeys.end()) {
+                continue;
+            }
+            const KeyInfo& info = it->second;
+
+            if (state->describedTracks.insert(info.trackUuid).second) {
+                auto packet = newPacket();
+                auto* layerTrack = packet->set_track_descriptor();
+                layerTrack->set_uuid(info.trackUuid);
+                layerTrack->set_name(info.name);
+                for (const auto& [offset, name] :
+                     {std::pair(kCpuTrack, "cpu"), std::pair(kGpuTrack, "gpu"),
+                      std::pair(kHwcTrack, "hwc")}) {
+                    auto costPacket = newPacket();
+                    auto* costTrack = costPacket->set_track_descriptor();
+                    costTrack->set_uuid(info.trackUuid + offset);
+                    costTrack->set_parent_uuid(info.trackUuid);
+                    costTrack->set_name(name);
+                    costTrack->set_counter()->set_unit(CounterDescriptor::UNIT_TIME_NS);
+                }
+            }
+
+            for (const auto& [offset, value] :
+                 {std::pair(kCpuTrack, cost.cpu), std::pair(kGpuTrack, cost.gpu),
+                  std::pair(kHwcTrack, cost.hwc)}) {
+                auto packet = newPacket();
+                packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
+                packet->set_timestamp(static_cast<uint64_t>(frame.time));
+                auto* event = packet->set_track_event();
+                event->set_type(TrackEvent::TYPE_COUNTER);
+                event->set_track_uuid(info.trackUuid + offset);
+                event->set_counter_value(value);
+            }
+        }
+    });
+}
+
+std::map<LayerCostTracker::Key, LayerCostTracker::Cost> LayerCostTracker::getCosts() {
+    std::scoped_lock lock(mMutex);
+    resolveGpuCostsLocked();
+    std::map<Key, Cost> costs;
+    for (const auto& frame : mFrames) {
+        if (!frame.pendingGpuCosts.empty()) {
+            continue;
+        }
+        for (const auto& [key, cost] : frame.costs) {
+            costs[key] += cost;
+        }
+    }
+    return costs;
+}
+
+void LayerCostTracker::parseArgs(const Vector<String16>& args, std::string& result) {
+    ATRACE_CALL();
+    std::unordered_map<std::string, bool> argsMap;
+    for (size_t i = 0; i < args.size(); i++) {
+        argsMap[std::string(String8(args[i]).c_str())] = true;
+    }
+    if (argsMap.count("-disable")) {
+        mEnabled = false;
+    }
+    if (argsMap.count("-clear")) {
+        std::scoped_lock lock(mMutex);
+        clearLocked();
+    }
+    if (argsMap.count("-enable")) {
+        mEnabled = true;
+    }
+    dump(result);
+}
+
+void LayerCostTracker::clearLocked() {
+    mFrames.clear();
+    mKeys.clear();
+}
+
+void LayerCostTracker::dump(std::string& result) {
+    struct Row {
+        std::string_view name;
+        Cost cost;
+        nsecs_t maxTotal = 0;
+        size_t frames = 0;
+    };
+
+    std::scoped_lock lock(mMutex);
+    resolveGpuCostsLocked();
+
+    std::map<Key, Row> rows;
+    Row frameRow{.name = "<all layers>"};
+    for (const auto& frame : mFrames) {
+        if (!frame.pendingGpuCosts.empty()) {
+            continue;
+        }
+        Cost frameCost;
+        for (const auto& [key, cost] : frame.costs) {
+            Row& row = rows[key];
+            row.cost += cost;
+            row.maxTotal = std::max(row.maxTotal, cost.total());
+            row.frames++;
+            frameCost += cost;
+        }
+        frameRow.cost += frameCost;
+        frameRow.maxTotal = std::max(frameRow.maxTotal, frameCost.total());
+        frameRow.frames++;
+    }
+
+    StringAppendF(&result, "Layer costs are %s\n",
+                  isEnabled() ? "recorded" : "not recorded, enable them with -enable");
+    StringAppendF(&result,
+                  "Costs over the last %zu frames, in us per frame the layer was composed:\n",
+                  frameRow.frames);
+    if (frameRow.frames == 0) {
+        return;
+    }
+
+    std::vector<Row> sortedRows;
+    sortedRows.reserve(rows.size());
+    for (auto& [key, row] : rows) {
+        const auto it = mKeys.find(key);
+        row.name = it != mKeys.end() ? std::string_view(it->second.name) : "<unknown>";
+        sortedRows.push_back(row);
+    }
+    std::sort(sortedRows.begin(), sortedRows.end(), [](const Row& lhs, const Row& rhs) {
+        return lhs.cost.total() * static_cast<nsecs_t>(rhs.frames) >
+                rhs.cost.total() * static_cast<nsecs_t>(lhs.frames);
+    });
+
+    StringAppendF(&result, "%10s %10s %10s %10s %10s %7s  %s\n", "total", "cpu", "gpu", "hwc",
+                  "max total", "frames", "layer");
+    const auto appendRow = [&](const Row& row) {
+        const auto count = static_cast<nsecs_t>(row.frames);
+        StringAppendF(&result, "%10.1f %10.1f %10.1f %10.1f %10.1f %7zu  %.*s\n",
+                      toMicros(row.cost.total() / count), toMicros(row.cost.cpu / count),
+                      toMicros(row.cost.gpu / count), toMicros(row.cost.hwc / count),
+                      toMicros(row.maxTotal), row.frames, static_cast<int>(row.name.size()),
+                      row.name.data());
+    };
+    appendRow(frameRow);
+    for (const auto& row : sortedRows) {
+        appendRow(row);
+    }
+}
+
+} // namespace android
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <perfetto/tracing.h>
+#include <ui/FenceTime.h>
+#include <utils/String16.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+#include <atomic>
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace android {
+
+// Attributes the cost of each composited frame to the layers, or the cached sets of layers, that
+// were composed, and keeps the costs of the last frames for dumpsys and perfetto:
+//
+//   - The main thread time spent on a layer in the per-layer loops of the outputs.
+//   - A share of the RenderEngine time, measured from the fence of the client composition, split
+//     between the client composed layers by the area they cover.
+//   - A share of the HWC validate and present time, split evenly between the layers of the output.
+//
+// Costs are only recorded while enabled, either from dumpsys or by a perfetto session that
+// enables the data source.
+class LayerCostTracker {
+public:
+    // A layer, or a cached set of layers, that costs are attributed to.
+    struct Key {
+        enum class Type { Layer, CachedSet };
+
+        Type type = Type::Layer;
+        // The sequence of the layer snapshot, or the buffer id of the cached set.
+        uint64_t id = 0;
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    struct Cost {
+        nsecs_t cpu = 0;
+        nsecs_t gpu = 0;
+        nsecs_t hwc = 0;
+
+        nsecs_t total() const { return cpu + gpu + hwc; }
+        Cost& operator+=(const Cost& other) {
+            cpu += other.cpu;
+            gpu += other.gpu;
+            hwc += other.hwc;
+            return *this;
+        }
+    };
+
+    // A layer composed by an output.
+    struct LayerComposition {
+        Key key;
+        // Only used for layers, and only read while the frame is recorded.
+        std::string_view name;
+        nsecs_t cpu = 0;
+        // Whether the layer was drawn by RenderEngine, and the area it covers on the output.
+        bool clientComposed = false;
+        int64_t area = 0;
+    };
+
+    struct OutputComposition {
+        // The layers of the output, in z order.
+        std::vector<LayerComposition> layers;
+        // The fence of the client composition and the time it was submitted, if any.
+        std::shared_ptr<FenceTime> renderEngineFence;
+        nsecs_t renderEngineStartTime = 0;
+        nsecs_t hwcValidateDuration = 0;
+        nsecs_t hwcPresentDuration = 0;
+    };
+
+    class LayerCostsDataSource;
+
+    static constexpr char kLayerCostsDataSource[] = "android.surfaceflinger.layer_costs";
+    // The number of frames the costs are aggregated over.
+    static constexpr size_t kMaxFrames = 120;
+
+    explicit LayerCostTracker(bool enabled);
+
+    // Registers the data source with the perfetto backend, which must already be initialized.
+    void onBootFinished();
+    // Registers the data source. Public to allow tests to use perfetto::kInProcessBackend.
+    void registerDataSource();
+
+    // Whether costs should be recorded for the next frame.
+    bool isEnabled() const;
+
+    // Records the costs of a frame. The GPU costs are attributed once the RenderEngine fences
+    // signal, when a later frame is recorded or the costs are dumped.
+    void recordFrame(int64_t vsyncId, nsecs_t time, std::vector<OutputComposition>&& outputs)
+            EXCLUDES(mMutex);
+
+    // Handles dumpsys SurfaceFlinger --layer-costs [-enable|-disable|-clear].
+    void parseArgs(const Vector<String16>& args, std::string& result) EXCLUDES(mMutex);
+    void dump(std::string& result) EXCLUDES(mMutex);
+
+    // Returns the costs of the frames whose GPU costs are known, summed for each layer.
+    std::map<Key, Cost> getCosts() EXCLUDES(mMutex);
+
+private:
+    struct Frame {
+        int64_t vsyncId = 0;
+        nsecs_t time = 0;
+        std::vector<std::pair<Key, Cost>> costs;
+
+        // RenderEngine time to split between the costs once the fence signals.
+        struct PendingGpuCost {
+            std::shared_ptr<FenceTime> fence;
+            nsecs_t startTime = 0;
+            std::vector<std::pair<size_t /* index in costs */, float /* weight */>> shares;
+        };
+        std::vector<PendingGpuCost> pendingGpuCosts;
+    };
+
+    struct KeyInfo {
+        std::string name;
+        // The uuid of the perfetto track of the layer. The tracks of its costs follow it.
+        uint64_t trackUuid = 0;
+        // The number of the last frame that the layer was composed in.
+        uint64_t lastFrameNumber = 0;
+    };
+
+    // Attributes the GPU costs of the frames whose fences signaled, and traces the frames whose
+    // costs are complete.
+    void resolveGpuCostsLocked() REQUIRES(mMutex);
+    void traceFrameLocked(const Frame& frame) REQUIRES(mMutex);
+    void clearLocked() REQUIRES(mMutex);
+
+    std::atomic<bool> mEnabled;
+
+    std::mutex mMutex;
+    std::deque<Frame> mFrames GUARDED_BY(mMutex);
+    std::map<Key, KeyInfo> mKeys GUARDED_BY(mMutex);
+    uint64_t mFrameNumber GUARDED_BY(mMutex) = 0;
+    uint64_t mNextTrackUuid GUARDED_BY(mMutex);
+};
+
+struct LayerCostsIncrementalState {
+    bool cleared = true;
+    std::unordered_set<uint64_t> describedTracks;
+};
+
+struct LayerCostsDataSourceTraits : public perfetto::DefaultDataSourceTraits {
+    using IncrementalStateType = LayerCostsIncrementalState;
+};
+
+class LayerCostTracker::LayerCostsDataSource
+      : public perfetto::DataSource<LayerCostsDataSource, LayerCostsDataSourceTraits> {
+    void OnSetup(const SetupArgs&) override {}
+    void OnStart(const StartArgs&) override {}
+    void OnStop(const StopArgs&) override {}
+};
+
+} // namespace android
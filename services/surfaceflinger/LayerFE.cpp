@@ -246,6 +246,7 @@ void LayerFE::prepareBufferStateClientComposition(
         }
     }
     layerSettings.source.buffer.maxLuminanceNits = maxLuminance;
+    layerSettings.source.buffer.frameNumber = mSnapshot->frameNumber;
     layerSettings.frameNumber = mSnapshot->frameNumber;
     layerSettings.bufferId = mSnapshot->externalTexture->getId();
 
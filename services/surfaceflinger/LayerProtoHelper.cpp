@@ -251,7 +251,7 @@ void LayerProtoHelper::readFromProto(const BlurRegion& proto, android::BlurRegio
 }
 
 LayersProto LayerProtoFromSnapshotGenerator::generate(const frontend::LayerHierarchy& root) {
-    mLayersProto.clear_layers();
+    using Variant = frontend::LayerHierarchy::Variant;
     std::unordered_set<uint64_t> stackIdsToSkip;
     if ((mTraceFlags & LayerTracing::TRACE_VIRTUAL_DISPLAYS) == 0) {
         for (const auto& [layerStack, displayInfo] : mDisplayInfos) {
@@ -261,70 +261,114 @@ LayersProto LayerProtoFromSnapshotGenerator::generate(const frontend::LayerHiera
         }
     }
 
-    frontend::LayerHierarchy::TraversalPath path = frontend::LayerHierarchy::TraversalPath::ROOT;
+    std::vector<std::pair<const frontend::LayerHierarchy*, Variant>> subtrees;
     for (auto& [child, variant] : root.mChildren) {
-        if (variant != frontend::LayerHierarchy::Variant::Attached ||
+        if (variant != Variant::Attached ||
             stackIdsToSkip.find(child->getLayer()->layerStack.id) != stackIdsToSkip.end()) {
             continue;
         }
+        subtrees.emplace_back(child, variant);
+    }
+
+    const auto writeSubtree = [this](const frontend::LayerHierarchy& subtree, Variant variant,
+                                     Fragment& fragment) {
+        frontend::LayerHierarchy::TraversalPath path =
+                frontend::LayerHierarchy::TraversalPath::ROOT;
         frontend::LayerHierarchy::ScopedAddToTraversalPath addChildToPath(path,
-                                                                          child->getLayer()->id,
+                                                                          subtree.getLayer()->id,
                                                                           variant);
-        LayerProtoFromSnapshotGenerator::writeHierarchyToProto(*child, path);
+        writeHierarchyToProto(subtree, path, fragment);
+    };
+
+    const bool parallel = mWorkerPool && subtrees.size() > 1;
+    std::vector<Fragment> fragments(parallel ? subtrees.size() : 1);
+    if (parallel) {
+        std::vector<frontend::WorkerPool::Task> tasks;
+        tasks.reserve(subtrees.size());
+        for (size_t i = 0; i < subtrees.size(); i++) {
+            tasks.emplace_back([&, i]() {
+                writeSubtree(*subtrees[i].first, subtrees[i].second, fragments[i]);
+            });
+        }
+        mWorkerPool->run(tasks);
+    } else {
+        for (const auto& [subtree, variant] : subtrees) {
+            writeSubtree(*subtree, variant, fragments.front());
+        }
+    }
+
+    // Concatenate the fragments, moving their layers.
+    LayersProto layersProto;
+    std::unordered_map<uint32_t, uint32_t> childToRelativeParent;
+    std::unordered_map<uint32_t, uint32_t> childToParent;
+    for (Fragment& fragment : fragments) {
+        auto* layers = fragment.layersProto.mutable_layers();
+        std::vector<LayerProto*> extracted(static_cast<size_t>(layers->size()));
+        layers->ExtractSubrange(0, layers->size(), extracted.data());
+        for (LayerProto* layer : extracted) {
+            layersProto.mutable_layers()->AddAllocated(layer);
+        }
+        // The later fragments win, as they would in a serial walk.
+        for (const auto& [child, relativeParent] : fragment.childToRelativeParent) {
+            childToRelativeParent.insert_or_assign(child, relativeParent);
+        }
+        for (const auto& [child, parent] : fragment.childToParent) {
+            childToParent.insert_or_assign(child, parent);
+        }
     }
 
     // fill in relative and parent info
-    for (int i = 0; i < mLayersProto.layers_size(); i++) {
-        auto layerProto = mLayersProto.mutable_layers()->Mutable(i);
-        auto it = mChildToRelativeParent.find(layerProto->id());
-        if (it == mChildToRelativeParent.end()) {
+    for (int i = 0; i < layersProto.layers_size(); i++) {
+        auto layerProto = layersProto.mutable_layers()->Mutable(i);
+        auto it = childToRelativeParent.find(layerProto->id());
+        if (it == childToRelativeParent.end()) {
             layerProto->set_z_order_relative_of(-1);
         } else {
             layerProto->set_z_order_relative_of(it->second);
         }
-        it = mChildToParent.find(layerProto->id());
-        if (it == mChildToParent.end()) {
+        it = childToParent.find(layerProto->id());
+        if (it == childToParent.end()) {
             layerProto->set_parent(-1);
         } else {
             layerProto->set_parent(it->second);
         }
     }
-
-    mDefaultSnapshots.clear();
-    mChildToRelativeParent.clear();
-    return std::move(mLayersProto);
+    return layersProto;
 }
 
 frontend::LayerSnapshot* LayerProtoFromSnapshotGenerator::getSnapshot(
-        frontend::LayerHierarchy::TraversalPath& path, const frontend::RequestedLayerState& layer) {
+        frontend::LayerHierarchy::TraversalPath& path, const frontend::RequestedLayerState& layer,
+        Fragment& fragment) {
     frontend::LayerSnapshot* snapshot = mSnapshotBuilder.getSnapshot(path);
     if (snapshot) {
         return snapshot;
     } else {
-        mDefaultSnapshots[path] = frontend::LayerSnapshot(layer, path);
-        return &mDefaultSnapshots[path];
+        fragment.defaultSnapshots[path] = frontend::LayerSnapshot(layer, path);
+        return &fragment.defaultSnapshots[path];
     }
 }
 
 void LayerProtoFromSnapshotGenerator::writeHierarchyToProto(
-        const frontend::LayerHierarchy& root, frontend::LayerHierarchy::TraversalPath& path) {
+        const frontend::LayerHierarchy& root, frontend::LayerHierarchy::TraversalPath& path,
+        Fragment& fragment) {
     using Variant = frontend::LayerHierarchy::Variant;
-    LayerProto* layerProto = mLayersProto.add_layers();
+    LayerProto* layerProto = fragment.layersProto.add_layers();
     const frontend::RequestedLayerState& layer = *root.getLayer();
-    frontend::LayerSnapshot* snapshot = getSnapshot(path, layer);
+    frontend::LayerSnapshot* snapshot = getSnapshot(path, layer, fragment);
     LayerProtoHelper::writeSnapshotToProto(layerProto, layer, *snapshot, mTraceFlags);
 
     for (const auto& [child, variant] : root.mChildren) {
         frontend::LayerHierarchy::ScopedAddToTraversalPath addChildToPath(path,
                                                                           child->getLayer()->id,
                                                                           variant);
-        frontend::LayerSnapshot* childSnapshot = getSnapshot(path, layer);
+        frontend::LayerSnapshot* childSnapshot = getSnapshot(path, layer, fragment);
         if (variant == Variant::Attached || variant == Variant::Detached ||
             variant == Variant::Mirror) {
-            mChildToParent[childSnapshot->uniqueSequence] = snapshot->uniqueSequence;
+            fragment.childToParent[childSnapshot->uniqueSequence] = snapshot->uniqueSequence;
             layerProto->add_children(childSnapshot->uniqueSequence);
         } else if (variant == Variant::Relative) {
-            mChildToRelativeParent[childSnapshot->uniqueSequence] = snapshot->uniqueSequence;
+            fragment.childToRelativeParent[childSnapshot->uniqueSequence] =
+                    snapshot->uniqueSequence;
             layerProto->add_relatives(childSnapshot->uniqueSequence);
         }
     }
@@ -344,7 +388,7 @@ void LayerProtoFromSnapshotGenerator::writeHierarchyToProto(
         frontend::LayerHierarchy::ScopedAddToTraversalPath addChildToPath(path,
                                                                           child->getLayer()->id,
                                                                           variant);
-        writeHierarchyToProto(*child, path);
+        writeHierarchyToProto(*child, path, fragment);
     }
 }
 
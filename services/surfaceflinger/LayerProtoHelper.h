@@ -28,6 +28,7 @@
 #include <cstdint>
 #include "FrontEnd/LayerHierarchy.h"
 #include "FrontEnd/LayerSnapshot.h"
+#include "FrontEnd/WorkerPool.h"
 
 namespace android {
 namespace surfaceflinger {
@@ -70,35 +71,46 @@ public:
 
 class LayerProtoFromSnapshotGenerator {
 public:
+    // With a worker pool, the subtrees of the root are written on the pool, each into its own
+    // fragment, and the fragments are concatenated in traversal order. The pool must not be used
+    // by another thread at the same time.
     LayerProtoFromSnapshotGenerator(
             const frontend::LayerSnapshotBuilder& snapshotBuilder,
             const display::DisplayMap<ui::LayerStack, frontend::DisplayInfo>& displayInfos,
-            const std::unordered_map<uint32_t, sp<Layer>>& legacyLayers, uint32_t traceFlags)
+            const std::unordered_map<uint32_t, sp<Layer>>& legacyLayers, uint32_t traceFlags,
+            frontend::WorkerPool* workerPool = nullptr)
           : mSnapshotBuilder(snapshotBuilder),
             mLegacyLayers(legacyLayers),
             mDisplayInfos(displayInfos),
-            mTraceFlags(traceFlags) {}
+            mTraceFlags(traceFlags),
+            mWorkerPool(workerPool) {}
     LayersProto generate(const frontend::LayerHierarchy& root);
 
 private:
+    // The layers written from one or more subtrees of the root.
+    struct Fragment {
+        LayersProto layersProto;
+        // winscope expects all the layers, so provide a snapshot even if it not currently drawing
+        std::unordered_map<frontend::LayerHierarchy::TraversalPath, frontend::LayerSnapshot,
+                           frontend::LayerHierarchy::TraversalPathHash>
+                defaultSnapshots;
+        std::unordered_map<uint32_t /* child unique seq*/, uint32_t /* relative parent unique seq*/>
+                childToRelativeParent;
+        std::unordered_map<uint32_t /* child unique seq*/, uint32_t /* parent unique seq*/>
+                childToParent;
+    };
+
     void writeHierarchyToProto(const frontend::LayerHierarchy& root,
-                               frontend::LayerHierarchy::TraversalPath& path);
+                               frontend::LayerHierarchy::TraversalPath& path, Fragment& fragment);
     frontend::LayerSnapshot* getSnapshot(frontend::LayerHierarchy::TraversalPath& path,
-                                         const frontend::RequestedLayerState& layer);
+                                         const frontend::RequestedLayerState& layer,
+                                         Fragment& fragment);
 
     const frontend::LayerSnapshotBuilder& mSnapshotBuilder;
     const std::unordered_map<uint32_t, sp<Layer>>& mLegacyLayers;
     const display::DisplayMap<ui::LayerStack, frontend::DisplayInfo>& mDisplayInfos;
     uint32_t mTraceFlags;
-    LayersProto mLayersProto;
-    // winscope expects all the layers, so provide a snapshot even if it not currently drawing
-    std::unordered_map<frontend::LayerHierarchy::TraversalPath, frontend::LayerSnapshot,
-                       frontend::LayerHierarchy::TraversalPathHash>
-            mDefaultSnapshots;
-    std::unordered_map<uint32_t /* child unique seq*/, uint32_t /* relative parent unique seq*/>
-            mChildToRelativeParent;
-    std::unordered_map<uint32_t /* child unique seq*/, uint32_t /* parent unique seq*/>
-            mChildToParent;
+    frontend::WorkerPool* mWorkerPool;
 };
 
 } // namespace surfaceflinger
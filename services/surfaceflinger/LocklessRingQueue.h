@@ -0,0 +1,164 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <thread>
+
+#include "LocklessQueue.h"
+
+template <typename T, size_t Capacity>
+// Bounded multi producer single consumer FIFO queue. Unlike LocklessQueue, pushing does not
+// allocate as long as the consumer keeps up; an overflowing push falls back to a LocklessQueue.
+//
+// The ring is a sequence-numbered slot array. Each slot's sequence tells producers and the consumer
+// whose turn it is: a producer may claim position `pos` when the slot's sequence equals `pos`, and
+// publishes the value by storing `pos + 1`. The consumer takes a value when the sequence equals
+// `head + 1`, and hands the slot back by storing `head + Capacity`, which is the position the
+// slot will be claimed at on the next lap. Producers race only on the mTail compare_exchange.
+//
+// Overflow keeps FIFO order for every producer. Once any entry is in the overflow list, new
+// pushes go there too, until the consumer has drained it. Entries from one thread can therefore
+// only be in the ring before they are in the overflow list, and the consumer drains the ring,
+// including slots that are claimed but not yet published, before taking from the overflow list.
+class LocklessRingQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+    static constexpr size_t kMask = Capacity - 1;
+    static constexpr size_t kCacheLineSize = 64;
+
+public:
+    LocklessRingQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~LocklessRingQueue() {
+        while (popRing()) {
+        }
+        while (mOverflow.pop()) {
+        }
+    }
+
+    LocklessRingQueue(const LocklessRingQueue&) = delete;
+    LocklessRingQueue& operator=(const LocklessRingQueue&) = delete;
+
+    // May be called from the consumer only.
+    bool isEmpty() {
+        return mHead == mTail.load(std::memory_order_acquire) && mOverflow.isEmpty();
+    }
+
+    // Safe to call from any thread.
+    void push(T&& value) {
+        if (mOverflowCount.load() == 0 && tryPushRing(value)) {
+            return;
+        }
+        mOverflowCount.fetch_add(1);
+        mOverflowPushes.fetch_add(1, std::memory_order_relaxed);
+        mOverflow.push(std::move(value));
+    }
+
+    // May be called from the consumer only.
+    std::optional<T> pop() {
+        if (auto value = popRing()) {
+            return value;
+        }
+        if (mOverflowCount.load() == 0) {
+            return std::nullopt;
+        }
+
+        // Deliver everything that was claimed in the ring before the overflow started.
+        while (mHead != mTail.load(std::memory_order_acquire)) {
+            if (auto value = popRing()) {
+                return value;
+            }
+            std::this_thread::yield();
+        }
+
+        auto value = mOverflow.pop();
+        if (value) {
+            mOverflowCount.fetch_sub(1);
+        }
+        return value;
+    }
+
+    // Number of pushes that had to allocate because the ring was full.
+    uint64_t getOverflowPushCount() const {
+        return mOverflowPushes.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    bool tryPushRing(T& value) {
+        size_t pos = mTail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &mSlots[pos & kMask];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The consumer has not freed this slot from the previous lap yet.
+                return false;
+            } else {
+                pos = mTail.load(std::memory_order_relaxed);
+            }
+        }
+        new (slot->storage) T(std::move(value));
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> popRing() {
+        Slot& slot = mSlots[mHead & kMask];
+        if (slot.sequence.load(std::memory_order_acquire) != mHead + 1) {
+            return std::nullopt;
+        }
+        T* stored = slot.value();
+        std::optional<T> value(std::move(*stored));
+        stored->~T();
+        slot.sequence.store(mHead + Capacity, std::memory_order_release);
+        mHead++;
+        return value;
+    }
+
+    std::array<Slot, Capacity> mSlots;
+
+    // Next position to claim, shared by all producers.
+    alignas(kCacheLineSize) std::atomic<size_t> mTail = 0;
+    // Next position to consume. Only accessed by the consumer.
+    alignas(kCacheLineSize) size_t mHead = 0;
+
+    alignas(kCacheLineSize) std::atomic<size_t> mOverflowCount = 0;
+    std::atomic<uint64_t> mOverflowPushes = 0;
+    LocklessQueue<T> mOverflow;
+};
@@ -36,6 +36,8 @@
 #include <ui/DisplayStatInfo.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include "DisplayDevice.h"
@@ -99,6 +101,7 @@ RegionSamplingThread::EnvironmentTimingTunables::EnvironmentTimingTunables() {
 RegionSamplingThread::RegionSamplingThread(SurfaceFlinger& flinger, const TimingTunables& tunables)
       : mFlinger(flinger),
         mTunables(tunables),
+        mUseGpuReduction(property_get_bool("debug.sf.region_sampling_gpu_reduction", true)),
         mIdleTimer(
                 "RegSampIdle",
                 std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -224,9 +227,48 @@ float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t st
     return accumulatedLuma / (255.0f * pixelCount);
 }
 
+int32_t getReductionLevels(const std::vector<Rect>& areas) {
+    if (areas.empty()) return 0;
+
+    int32_t minSize = std::numeric_limits<int32_t>::max();
+    for (const auto& area : areas) {
+        minSize = std::min({minSize, area.getWidth(), area.getHeight()});
+    }
+
+    int32_t levels = 0;
+    while (levels < kMaxReductionLevels && (minSize >> (levels + 1)) >= kMinReducedAreaSize) {
+        ++levels;
+    }
+    return levels;
+}
+
+Rect reduceArea(const Rect& area, int32_t levels) {
+    if (levels <= 0) return area;
+
+    // Round the edges to the nearest edge of the reduced pixels, so that the reduced area covers
+    // the pixels of the area as closely as possible.
+    const int32_t half = 1 << (levels - 1);
+    Rect reduced((area.left + half) >> levels, (area.top + half) >> levels,
+                 (area.right + half) >> levels, (area.bottom + half) >> levels);
+    reduced.right = std::max(reduced.right, reduced.left + 1);
+    reduced.bottom = std::max(reduced.bottom, reduced.top + 1);
+    return reduced;
+}
+
+ui::Size reduceSize(const ui::Size& size, int32_t levels) {
+    // Each level halves the size, rounding up so that no source pixel is dropped.
+    ui::Size reduced = size;
+    for (int32_t level = 0; level < levels; ++level) {
+        reduced.width = (reduced.width + 1) / 2;
+        reduced.height = (reduced.height + 1) / 2;
+    }
+    return reduced;
+}
+
 std::vector<float> RegionSamplingThread::sampleBuffer(
         const sp<GraphicBuffer>& buffer, const Point& leftTop,
-        const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation) {
+        const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation,
+        int32_t reductionLevels) {
     void* data_raw = nullptr;
     buffer->lock(GRALLOC_USAGE_SW_READ_OFTEN, &data_raw);
     std::shared_ptr<uint32_t> data(reinterpret_cast<uint32_t*>(data_raw),
@@ -240,7 +282,7 @@ std::vector<float> RegionSamplingThread::sampleBuffer(
     std::transform(descriptors.begin(), descriptors.end(), lumas.begin(),
                    [&](auto const& descriptor) {
                        return sampleArea(data.get(), width, height, stride, orientation,
-                                         descriptor.area - leftTop);
+                                         reduceArea(descriptor.area - leftTop, reductionLevels));
                    });
     return lumas;
 }
@@ -355,35 +397,46 @@ void RegionSamplingThread::captureSample() {
         getLayerSnapshots = RenderArea::fromTraverseLayersLambda(traverseLayers);
     }
 
-    std::shared_ptr<renderengine::ExternalTexture> buffer = nullptr;
-    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledBounds.getWidth() &&
-        mCachedBuffer->getBuffer()->getHeight() == sampledBounds.getHeight()) {
-        buffer = mCachedBuffer;
-    } else {
-        const uint32_t usage =
-                GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
-        sp<GraphicBuffer> graphicBuffer =
-                sp<GraphicBuffer>::make(sampledBounds.getWidth(), sampledBounds.getHeight(),
-                                        PIXEL_FORMAT_RGBA_8888, 1, usage, "RegionSamplingThread");
-        const status_t bufferStatus = graphicBuffer->initCheck();
-        LOG_ALWAYS_FATAL_IF(bufferStatus != OK, "captureSample: Buffer failed to allocate: %d",
-                            bufferStatus);
-        buffer = std::make_shared<
-                renderengine::impl::ExternalTexture>(graphicBuffer, mFlinger.getRenderEngine(),
-                                                     renderengine::impl::ExternalTexture::Usage::
-                                                             WRITEABLE);
+    // The layers are filtered while capturing, so which listeners are sampled is not known yet.
+    std::vector<Rect> areas;
+    for (const auto& descriptor : descriptors) {
+        areas.emplace_back(descriptor.area);
     }
 
+    // Only the buffer read back by the CPU needs to be mapped for reading.
+    const int32_t reductionLevels = mUseGpuReduction ? getReductionLevels(areas) : 0;
+    const uint32_t renderUsage = GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
+    const uint32_t readbackUsage = GRALLOC_USAGE_SW_READ_OFTEN | renderUsage;
+
+    const ui::Size sampledSize = sampledBounds.getSize();
+    const auto buffer = getBuffer(mCachedBuffer, sampledSize,
+                                  reductionLevels > 0 ? renderUsage : readbackUsage);
+
     constexpr bool kRegionSampling = true;
     constexpr bool kGrayscale = false;
 
+    sp<Fence> fence = Fence::NO_FENCE;
     if (const auto fenceResult =
                 mFlinger.captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, buffer,
                                              kRegionSampling, kGrayscale, nullptr)
                         .get();
         fenceResult.ok()) {
-        fenceResult.value()->waitForever(LOG_TAG);
+        fence = fenceResult.value();
+    }
+
+    // Rather than reading back every sampled pixel, halve the sampled buffer on the GPU until the
+    // smallest area is only a few pixels wide, and only wait for the last of the draws.
+    mCachedReductionBuffers.resize(reductionLevels);
+    std::shared_ptr<renderengine::ExternalTexture> sampledBuffer = buffer;
+    for (int32_t level = 1; level <= reductionLevels; ++level) {
+        const auto reducedBuffer = getBuffer(mCachedReductionBuffers[level - 1],
+                                             reduceSize(sampledSize, level),
+                                             level == reductionLevels ? readbackUsage
+                                                                      : renderUsage);
+        fence = drawReduced(sampledBuffer, fence, reducedBuffer);
+        sampledBuffer = reducedBuffer;
     }
+    fence->waitForever(LOG_TAG);
 
     std::vector<Descriptor> activeDescriptors;
     for (const auto& descriptor : descriptors) {
@@ -392,9 +445,9 @@ void RegionSamplingThread::captureSample() {
         }
     }
 
-    ALOGV("Sampling %zu descriptors", activeDescriptors.size());
-    std::vector<float> lumas = sampleBuffer(buffer->getBuffer(), sampledBounds.leftTop(),
-                                            activeDescriptors, orientation);
+    ALOGV("Sampling %zu descriptors reduced %d times", activeDescriptors.size(), reductionLevels);
+    std::vector<float> lumas = sampleBuffer(sampledBuffer->getBuffer(), sampledBounds.leftTop(),
+                                            activeDescriptors, orientation, reductionLevels);
     if (lumas.size() != activeDescriptors.size()) {
         ALOGW("collected %zu median luma values for %zu descriptors", lumas.size(),
               activeDescriptors.size());
@@ -405,10 +458,76 @@ void RegionSamplingThread::captureSample() {
         activeDescriptors[d].listener->onSampleCollected(lumas[d]);
     }
 
-    mCachedBuffer = buffer;
     ATRACE_INT(lumaSamplingStepTag, static_cast<int>(samplingStep::noWorkNeeded));
 }
 
+std::shared_ptr<renderengine::ExternalTexture> RegionSamplingThread::getBuffer(
+        std::shared_ptr<renderengine::ExternalTexture>& cachedBuffer, const ui::Size& size,
+        uint32_t usage) {
+    if (cachedBuffer && cachedBuffer->getBuffer()->getWidth() == size.getWidth() &&
+        cachedBuffer->getBuffer()->getHeight() == size.getHeight() &&
+        cachedBuffer->getBuffer()->getUsage() == usage) {
+        return cachedBuffer;
+    }
+
+    sp<GraphicBuffer> graphicBuffer =
+            sp<GraphicBuffer>::make(size.getWidth(), size.getHeight(), PIXEL_FORMAT_RGBA_8888, 1,
+                                    usage, "RegionSamplingThread");
+    const status_t bufferStatus = graphicBuffer->initCheck();
+    LOG_ALWAYS_FATAL_IF(bufferStatus != OK, "captureSample: Buffer failed to allocate: %d",
+                        bufferStatus);
+    using Usage = renderengine::impl::ExternalTexture::Usage;
+    cachedBuffer =
+            std::make_shared<renderengine::impl::ExternalTexture>(graphicBuffer,
+                                                                  mFlinger.getRenderEngine(),
+                                                                  Usage::READABLE |
+                                                                          Usage::WRITEABLE);
+    return cachedBuffer;
+}
+
+sp<Fence> RegionSamplingThread::drawReduced(
+        const std::shared_ptr<renderengine::ExternalTexture>& source, const sp<Fence>& sourceFence,
+        const std::shared_ptr<renderengine::ExternalTexture>& destination) {
+    ATRACE_CALL();
+    const Rect bounds = destination->getBounds();
+
+    // The buffers are encoded the same way, so that the reduction averages the encoded values, as
+    // sampleArea does.
+    const renderengine::DisplaySettings display{
+            .physicalDisplay = bounds,
+            .clip = bounds,
+            .outputDataspace = ui::Dataspace::V0_SRGB,
+            .isDeferrable = true,
+    };
+
+    // Scaling by half with linear filtering samples each destination pixel halfway between four
+    // source pixels, which averages them.
+    const std::vector<renderengine::LayerSettings> layers{{
+            .geometry = renderengine::Geometry{.boundaries = bounds.toFloatRect()},
+            .source =
+                    renderengine::PixelSource{
+                            .buffer =
+                                    renderengine::Buffer{
+                                            .buffer = source,
+                                            .fence = sourceFence,
+                                            .useTextureFiltering = true,
+                                            .isOpaque = true,
+                                    },
+                    },
+            .alpha = half(1.0f),
+            .sourceDataspace = ui::Dataspace::V0_SRGB,
+            .disableBlending = true,
+            .name = "RegionSamplingReduction",
+    }};
+
+    constexpr bool kUseFramebufferCache = false;
+    const auto fenceResult = mFlinger.getRenderEngine()
+                                     .drawLayers(display, layers, destination,
+                                                 kUseFramebufferCache, base::unique_fd())
+                                     .get();
+    return fenceResult.ok() ? fenceResult.value() : Fence::NO_FENCE;
+}
+
 // NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
 void RegionSamplingThread::threadMain() NO_THREAD_SAFETY_ANALYSIS {
     std::unique_lock<std::mutex> lock(mThreadControlMutex);
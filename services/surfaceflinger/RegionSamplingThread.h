@@ -20,8 +20,10 @@
 #include <android/gui/IRegionSamplingListener.h>
 #include <binder/IBinder.h>
 #include <renderengine/ExternalTexture.h>
+#include <ui/Fence.h>
 #include <ui/GraphicBuffer.h>
 #include <ui/Rect.h>
+#include <ui/Size.h>
 #include <utils/StrongPointer.h>
 
 #include <chrono>
@@ -30,6 +32,7 @@
 #include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "Scheduler/OneShotTimer.h"
 #include "WpHash.h"
@@ -45,6 +48,18 @@ using gui::IRegionSamplingListener;
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
                  uint32_t orientation, const Rect& area);
 
+// The sampled buffer is halved on the GPU at most this many times before it is read back, and only
+// while each sampled area still spans at least kMinReducedAreaSize pixels in each dimension.
+constexpr int32_t kMaxReductionLevels = 4;
+constexpr int32_t kMinReducedAreaSize = 4;
+
+// Returns how many times a buffer holding the given areas can be halved before sampling them.
+int32_t getReductionLevels(const std::vector<Rect>& areas);
+// Maps an area of a buffer to the same area of that buffer halved the given number of times.
+Rect reduceArea(const Rect& area, int32_t levels);
+// Returns the size of a buffer of the given size halved the given number of times.
+ui::Size reduceSize(const ui::Size& size, int32_t levels);
+
 class RegionSamplingThread : public IBinder::DeathRecipient {
 public:
     struct TimingTunables {
@@ -93,7 +108,17 @@ private:
 
     std::vector<float> sampleBuffer(
             const sp<GraphicBuffer>& buffer, const Point& leftTop,
-            const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation);
+            const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation,
+            int32_t reductionLevels);
+
+    std::shared_ptr<renderengine::ExternalTexture> getBuffer(
+            std::shared_ptr<renderengine::ExternalTexture>& cachedBuffer, const ui::Size& size,
+            uint32_t usage);
+    // Draws the source halved into the destination, averaging each 2x2 block of source pixels with
+    // a single filtered sample, and returns the fence of the draw.
+    sp<Fence> drawReduced(const std::shared_ptr<renderengine::ExternalTexture>& source,
+                          const sp<Fence>& sourceFence,
+                          const std::shared_ptr<renderengine::ExternalTexture>& destination);
 
     void doSample(std::optional<std::chrono::steady_clock::time_point> samplingDeadline);
     void binderDied(const wp<IBinder>& who) override;
@@ -104,6 +129,9 @@ private:
 
     SurfaceFlinger& mFlinger;
     const TimingTunables mTunables;
+    // debug.sf.region_sampling_gpu_reduction
+    // Whether the sampled buffer is reduced on the GPU, so that fewer pixels are read back.
+    const bool mUseGpuReduction;
     scheduler::OneShotTimer mIdleTimer;
 
     std::thread mThread;
@@ -120,6 +148,9 @@ private:
     std::unordered_map<wp<IBinder>, Descriptor, WpHash> mDescriptors GUARDED_BY(mSamplingMutex);
     std::shared_ptr<renderengine::ExternalTexture> mCachedBuffer GUARDED_BY(mSamplingMutex) =
             nullptr;
+    // The buffers the sampled buffer is reduced into, one per level.
+    std::vector<std::shared_ptr<renderengine::ExternalTexture>> mCachedReductionBuffers
+            GUARDED_BY(mSamplingMutex);
 };
 
 } // namespace android
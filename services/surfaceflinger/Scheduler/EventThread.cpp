@@ -20,10 +20,13 @@
 
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <fcntl.h>
 #include <pthread.h>
 #include <sched.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cstdint>
 #include <optional>
@@ -33,6 +36,7 @@
 #include <android-base/stringprintf.h>
 
 #include <binder/IPCThreadState.h>
+#include <binder/ParcelFileDescriptor.h>
 
 #include <cutils/compiler.h>
 #include <cutils/sched_policy.h>
@@ -211,6 +215,19 @@ binder::Status EventThreadConnection::getLatestVsyncEventData(
     return binder::Status::ok();
 }
 
+binder::Status EventThreadConnection::getVsyncMailbox(os::ParcelFileDescriptor* outMailbox) {
+    ATRACE_CALL();
+    base::unique_fd fd;
+    if (const status_t status =
+                mEventThread->enableVsyncMailbox(sp<EventThreadConnection>::fromExisting(this),
+                                                 &fd);
+        status != NO_ERROR) {
+        return binder::Status::fromStatusT(status);
+    }
+    *outMailbox = os::ParcelFileDescriptor(std::move(fd));
+    return binder::Status::ok();
+}
+
 status_t EventThreadConnection::postEvent(const DisplayEventReceiver::Event& event) {
     constexpr auto toStatus = [](ssize_t size) {
         return size < 0 ? status_t(size) : status_t(NO_ERROR);
@@ -380,6 +397,20 @@ VsyncEventData EventThread::getLatestVsyncEventData(
     return vsyncEventData;
 }
 
+status_t EventThread::enableVsyncMailbox(const sp<EventThreadConnection>& connection,
+                                         base::unique_fd* outFd) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!connection->vsyncMailbox) {
+        connection->vsyncMailbox = gui::VsyncMailbox::create();
+        if (!connection->vsyncMailbox) {
+            return NO_MEMORY;
+        }
+    }
+
+    outFd->reset(fcntl(connection->vsyncMailbox->getFd(), F_DUPFD_CLOEXEC, 0));
+    return outFd->ok() ? NO_ERROR : -errno;
+}
+
 void EventThread::enableSyntheticVsync(bool enable) {
     std::lock_guard<std::mutex> lock(mMutex);
     if (!mVSyncState || mVSyncState->synthetic == enable) {
@@ -434,6 +465,7 @@ size_t EventThread::getEventThreadConnectionCount() {
 
 void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
     DisplayEventConsumers consumers;
+    DisplayEventConsumers mailboxConsumers;
 
     while (mState != State::Quit) {
         std::optional<DisplayEventReceiver::Event> event;
@@ -450,10 +482,15 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
                            mVSyncState->displayId == event->header.displayId) {
                     mVSyncState.reset();
                 }
+            } else if (event->header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+                mUidVsyncStates.clear();
+                mVsyncEvents.clear();
             }
         }
 
         bool vsyncRequested = false;
+        const bool isVsync =
+                event && event->header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
 
         // Find connections that should consume this event.
         auto it = mDisplayEventConnections.begin();
@@ -462,6 +499,9 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
                 if (event && shouldConsumeEvent(*event, connection)) {
                     consumers.push_back(connection);
                 }
+                if (isVsync && connection->vsyncMailbox) {
+                    mailboxConsumers.push_back(connection);
+                }
 
                 vsyncRequested |= connection->vsyncRequest != VSyncRequest::None;
 
@@ -476,6 +516,11 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
             consumers.clear();
         }
 
+        if (!mailboxConsumers.empty()) {
+            publishToMailboxes(*event, mailboxConsumers);
+            mailboxConsumers.clear();
+        }
+
         if (mVSyncState && vsyncRequested) {
             mState = mVSyncState->synthetic ? State::SyntheticVSync : State::VSync;
         } else {
@@ -524,21 +569,51 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
     mVsyncRegistration.cancel();
 }
 
-bool EventThread::shouldConsumeEvent(const DisplayEventReceiver::Event& event,
-                                     const sp<EventThreadConnection>& connection) const {
-    const auto throttleVsync = [&]() REQUIRES(mMutex) {
-        const auto& vsyncData = event.vsync.vsyncData;
-        if (connection->frameRate.isValid()) {
-            return !mVsyncSchedule->getTracker()
-                            .isVSyncInPhase(vsyncData.preferredExpectedPresentationTime(),
-                                            connection->frameRate);
-        }
+bool EventThread::isUidThrottledLocked(const DisplayEventReceiver::Event& vsync, uid_t uid) {
+    auto& throttled = mUidVsyncStates[uid].throttled;
+    if (!throttled) {
+        throttled = mThrottleVsyncCallback &&
+                mThrottleVsyncCallback(vsync.vsync.vsyncData.preferredExpectedPresentationTime(),
+                                       uid);
+    }
+    return *throttled;
+}
 
-        return mThrottleVsyncCallback &&
-                mThrottleVsyncCallback(event.vsync.vsyncData.preferredExpectedPresentationTime(),
-                                       connection->mOwnerUid);
-    };
+nsecs_t EventThread::getFrameIntervalLocked(uid_t uid) {
+    auto& frameInterval = mUidVsyncStates[uid].frameInterval;
+    if (!frameInterval) {
+        frameInterval = mGetVsyncPeriodFunction(uid);
+    }
+    return *frameInterval;
+}
+
+const DisplayEventReceiver::Event& EventThread::getVsyncEventLocked(
+        const DisplayEventReceiver::Event& vsync, uid_t uid) {
+    const nsecs_t frameInterval = getFrameIntervalLocked(uid);
+    const auto [it, inserted] = mVsyncEvents.try_emplace(frameInterval, vsync);
+    if (inserted) {
+        auto& vsyncData = it->second.vsync.vsyncData;
+        vsyncData.frameInterval = frameInterval;
+        generateFrameTimeline(vsyncData, frameInterval, vsync.header.timestamp,
+                              vsync.vsync.vsyncData.preferredExpectedPresentationTime(),
+                              vsync.vsync.vsyncData.preferredDeadlineTimestamp());
+    }
+    return it->second;
+}
 
+bool EventThread::isVsyncThrottledLocked(const DisplayEventReceiver::Event& vsync,
+                                         const sp<EventThreadConnection>& connection) {
+    if (connection->frameRate.isValid()) {
+        return !mVsyncSchedule->getTracker()
+                        .isVSyncInPhase(vsync.vsync.vsyncData.preferredExpectedPresentationTime(),
+                                        connection->frameRate);
+    }
+
+    return isUidThrottledLocked(vsync, connection->mOwnerUid);
+}
+
+bool EventThread::shouldConsumeEvent(const DisplayEventReceiver::Event& event,
+                                     const sp<EventThreadConnection>& connection) {
     switch (event.header.type) {
         case DisplayEventReceiver::DISPLAY_EVENT_HOTPLUG:
             return true;
@@ -556,14 +631,14 @@ bool EventThread::shouldConsumeEvent(const DisplayEventReceiver::Event& event,
                     connection->vsyncRequest = VSyncRequest::None;
                     return false;
                 case VSyncRequest::Single: {
-                    if (throttleVsync()) {
+                    if (isVsyncThrottledLocked(event, connection)) {
                         return false;
                     }
                     connection->vsyncRequest = VSyncRequest::SingleSuppressCallback;
                     return true;
                 }
                 case VSyncRequest::Periodic:
-                    if (throttleVsync()) {
+                    if (isVsyncThrottledLocked(event, connection)) {
                         return false;
                     }
                     return true;
@@ -653,16 +728,13 @@ void EventThread::generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs
 
 void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
                                 const DisplayEventConsumers& consumers) {
+    const bool isVsync = event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
+    std::optional<nsecs_t> firstWakeLatency;
+    nsecs_t lastWakeLatency = 0;
+
     for (const auto& consumer : consumers) {
-        DisplayEventReceiver::Event copy = event;
-        if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
-            const int64_t frameInterval = mGetVsyncPeriodFunction(consumer->mOwnerUid);
-            copy.vsync.vsyncData.frameInterval = frameInterval;
-            generateFrameTimeline(copy.vsync.vsyncData, frameInterval, copy.header.timestamp,
-                                  event.vsync.vsyncData.preferredExpectedPresentationTime(),
-                                  event.vsync.vsyncData.preferredDeadlineTimestamp());
-        }
-        switch (consumer->postEvent(copy)) {
+        const auto& eventToPost = isVsync ? getVsyncEventLocked(event, consumer->mOwnerUid) : event;
+        switch (consumer->postEvent(eventToPost)) {
             case NO_ERROR:
                 break;
 
@@ -676,6 +748,38 @@ void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
                 // Treat EPIPE and other errors as fatal.
                 removeDisplayEventConnectionLocked(consumer);
         }
+
+        if (isVsync) {
+            lastWakeLatency = systemTime() - event.header.timestamp;
+            if (!firstWakeLatency) {
+                firstWakeLatency = lastWakeLatency;
+            }
+        }
+    }
+
+    if (firstWakeLatency) {
+        const auto bucket = [](nsecs_t latency) {
+            return static_cast<size_t>(std::upper_bound(kWakeLatencyBucketLimits.begin(),
+                                                        kWakeLatencyBucketLimits.end(), latency) -
+                                       kWakeLatencyBucketLimits.begin());
+        };
+        mFirstWakeLatency[bucket(*firstWakeLatency)]++;
+        mLastWakeLatency[bucket(lastWakeLatency)]++;
+    }
+}
+
+void EventThread::publishToMailboxes(const DisplayEventReceiver::Event& event,
+                                     const DisplayEventConsumers& mailboxConsumers) {
+    for (const auto& connection : mailboxConsumers) {
+        // Mailboxes see the same VSYNC rate as the channel would.
+        if (isVsyncThrottledLocked(event, connection)) {
+            continue;
+        }
+
+        const auto& vsync = getVsyncEventLocked(event, connection->mOwnerUid);
+        connection->vsyncMailbox->publish({.timestamp = vsync.header.timestamp,
+                                           .count = vsync.vsync.count,
+                                           .vsyncData = vsync.vsync.vsyncData});
     }
 }
 
@@ -697,6 +801,17 @@ void EventThread::dump(std::string& result) const {
                   mWorkDuration.get().count() / 1e6f, mReadyDuration.count() / 1e6f);
     StringAppendF(&result, "%.2fms relative to now\n", relativeLastCallTime);
 
+    result.append("  vsync wake latency (first/last connection):");
+    for (size_t i = 0; i < kWakeLatencyBucketCount; i++) {
+        if (i < kWakeLatencyBucketLimits.size()) {
+            StringAppendF(&result, " <%" PRId64 "us=", ns2us(kWakeLatencyBucketLimits[i]));
+        } else {
+            StringAppendF(&result, " >=%" PRId64 "us=", ns2us(kWakeLatencyBucketLimits.back()));
+        }
+        StringAppendF(&result, "%" PRIu64 "/%" PRIu64, mFirstWakeLatency[i], mLastWakeLatency[i]);
+    }
+    result += '\n';
+
     StringAppendF(&result, "  pending events (count=%zu):\n", mPendingEvents.size());
     for (const auto& event : mPendingEvents) {
         StringAppendF(&result, "    %s\n", toString(event).c_str());
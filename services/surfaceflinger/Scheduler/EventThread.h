@@ -17,19 +17,24 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
 #include <android/gui/BnDisplayEventConnection.h>
+#include <ftl/small_map.h>
 #include <gui/DisplayEventReceiver.h>
+#include <gui/VsyncMailbox.h>
 #include <private/gui/BitTube.h>
 #include <sys/types.h>
 #include <utils/Errors.h>
 
 #include <scheduler/FrameRateMode.h>
+#include <array>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "DisplayHardware/DisplayMode.h"
@@ -79,6 +84,7 @@ public:
     binder::Status setVsyncRate(int rate) override;
     binder::Status requestNextVsync() override; // asynchronous
     binder::Status getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) override;
+    binder::Status getVsyncMailbox(os::ParcelFileDescriptor* outMailbox) override;
 
     // Called in response to requestNextVsync.
     const ResyncCallback resyncCallback;
@@ -90,6 +96,9 @@ public:
     /** The frame rate set to the attached choreographer. */
     Fps frameRate;
 
+    // Created when the client first asks for it, after which every VSYNC is published to it.
+    std::unique_ptr<gui::VsyncMailbox> vsyncMailbox;
+
 private:
     virtual void onFirstRef();
     EventThread* const mEventThread;
@@ -130,6 +139,9 @@ public:
     virtual void requestNextVsync(const sp<EventThreadConnection>& connection) = 0;
     virtual VsyncEventData getLatestVsyncEventData(
             const sp<EventThreadConnection>& connection) const = 0;
+    // Returns a read-only file descriptor of the connection's VSYNC mailbox, creating it if needed.
+    virtual status_t enableVsyncMailbox(const sp<EventThreadConnection>& connection,
+                                        base::unique_fd* outFd) = 0;
 
     // Retrieves the number of event connections tracked by this EventThread.
     virtual size_t getEventThreadConnectionCount() = 0;
@@ -157,6 +169,8 @@ public:
     void requestNextVsync(const sp<EventThreadConnection>& connection) override;
     VsyncEventData getLatestVsyncEventData(
             const sp<EventThreadConnection>& connection) const override;
+    status_t enableVsyncMailbox(const sp<EventThreadConnection>& connection,
+                                base::unique_fd* outFd) override;
 
     void enableSyntheticVsync(bool) override;
 
@@ -184,9 +198,24 @@ private:
     void threadMain(std::unique_lock<std::mutex>& lock) REQUIRES(mMutex);
 
     bool shouldConsumeEvent(const DisplayEventReceiver::Event& event,
-                            const sp<EventThreadConnection>& connection) const REQUIRES(mMutex);
+                            const sp<EventThreadConnection>& connection) REQUIRES(mMutex);
     void dispatchEvent(const DisplayEventReceiver::Event& event,
                        const DisplayEventConsumers& consumers) REQUIRES(mMutex);
+    void publishToMailboxes(const DisplayEventReceiver::Event& vsync,
+                            const DisplayEventConsumers& mailboxConsumers) REQUIRES(mMutex);
+
+    bool isVsyncThrottledLocked(const DisplayEventReceiver::Event& vsync,
+                                const sp<EventThreadConnection>& connection) REQUIRES(mMutex);
+
+    // Throttling and the frame interval only depend on the uid, so they are looked up once per
+    // uid for each VSYNC event rather than once per connection.
+    bool isUidThrottledLocked(const DisplayEventReceiver::Event& vsync, uid_t) REQUIRES(mMutex);
+    nsecs_t getFrameIntervalLocked(uid_t) REQUIRES(mMutex);
+
+    // Returns the VSYNC with the frame timelines for the uid's frame interval. Connections with the
+    // same frame interval share the timelines, and the tokens generated for them.
+    const DisplayEventReceiver::Event& getVsyncEventLocked(const DisplayEventReceiver::Event& vsync,
+                                                           uid_t) REQUIRES(mMutex);
 
     void removeDisplayEventConnectionLocked(const wp<EventThreadConnection>& connection)
             REQUIRES(mMutex);
@@ -225,6 +254,25 @@ private:
     std::vector<wp<EventThreadConnection>> mDisplayEventConnections GUARDED_BY(mMutex);
     std::deque<DisplayEventReceiver::Event> mPendingEvents GUARDED_BY(mMutex);
 
+    struct UidVsyncState {
+        std::optional<bool> throttled;
+        std::optional<nsecs_t> frameInterval;
+    };
+
+    // Cleared for every VSYNC event.
+    std::unordered_map<uid_t, UidVsyncState> mUidVsyncStates GUARDED_BY(mMutex);
+    ftl::SmallMap<nsecs_t, DisplayEventReceiver::Event, 4> mVsyncEvents GUARDED_BY(mMutex);
+
+    // Buckets of the time from the VSYNC wakeup until the event was posted to the first and the
+    // last connection. The last bucket is unbounded.
+    static constexpr std::array<nsecs_t, 7> kWakeLatencyBucketLimits = {
+            us2ns(50), us2ns(100), us2ns(250), us2ns(500), ms2ns(1), ms2ns(2), ms2ns(4)};
+    static constexpr size_t kWakeLatencyBucketCount = kWakeLatencyBucketLimits.size() + 1;
+    using WakeLatencyHistogram = std::array<uint64_t, kWakeLatencyBucketCount>;
+
+    WakeLatencyHistogram mFirstWakeLatency GUARDED_BY(mMutex) = {};
+    WakeLatencyHistogram mLastWakeLatency GUARDED_BY(mMutex) = {};
+
     // VSYNC state of connected display.
     struct VSyncState {
         explicit VSyncState(PhysicalDisplayId displayId) : displayId(displayId) {}
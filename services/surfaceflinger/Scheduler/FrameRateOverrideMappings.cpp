@@ -19,36 +19,29 @@
 namespace android::scheduler {
 using FrameRateOverride = DisplayEventReceiver::Event::FrameRateOverride;
 
-std::optional<Fps> FrameRateOverrideMappings::getFrameRateOverrideForUid(
+std::optional<Fps> FrameRateOverrideMappings::Table::get(
         uid_t uid, bool supportsFrameRateOverrideByContent) const {
-    std::lock_guard lock(mFrameRateOverridesLock);
-
-    {
-        const auto iter = mFrameRateOverridesFromBackdoor.find(uid);
-        if (iter != mFrameRateOverridesFromBackdoor.end()) {
-            return iter->second;
-        }
-    }
-
-    {
-        const auto iter = mFrameRateOverridesFromGameManager.find(uid);
-        if (iter != mFrameRateOverridesFromGameManager.end()) {
-            return iter->second;
-        }
-    }
-
-    if (!supportsFrameRateOverrideByContent) {
+    const auto iter = entries.find(uid);
+    if (iter == entries.end() || (iter->second.byContent && !supportsFrameRateOverrideByContent)) {
         return std::nullopt;
     }
+    return iter->second.frameRate;
+}
 
-    {
-        const auto iter = mFrameRateOverridesByContent.find(uid);
-        if (iter != mFrameRateOverridesByContent.end()) {
-            return iter->second;
-        }
+std::optional<Fps> FrameRateOverrideMappings::Reader::getFrameRateOverrideForUid(
+        uid_t uid, bool supportsFrameRateOverrideByContent) {
+    if (!mTable ||
+        mTable->generation != mMappings->mTableGeneration.load(std::memory_order_acquire)) {
+        std::lock_guard lock(mMappings->mFrameRateOverridesLock);
+        mTable = mMappings->mTable;
     }
+    return mTable->get(uid, supportsFrameRateOverrideByContent);
+}
 
-    return std::nullopt;
+std::optional<Fps> FrameRateOverrideMappings::getFrameRateOverrideForUid(
+        uid_t uid, bool supportsFrameRateOverrideByContent) const {
+    std::lock_guard lock(mFrameRateOverridesLock);
+    return mTable->get(uid, supportsFrameRateOverrideByContent);
 }
 
 std::vector<FrameRateOverride> FrameRateOverrideMappings::getAllFrameRateOverrides(
@@ -112,6 +105,28 @@ void FrameRateOverrideMappings::dump(utils::Dumper& dumper, std::string_view nam
     }
 }
 
+void FrameRateOverrideMappings::publishTableLocked() {
+    auto table = std::make_shared<Table>();
+    table->generation = mTable->generation + 1;
+    table->entries.reserve(maxOverridesCount());
+
+    // The overrides from the backdoor take precedence over the ones from GameManager, which take
+    // precedence over the ones from setFrameRate.
+    for (const auto& [uid, frameRate] : mFrameRateOverridesFromBackdoor) {
+        table->entries.try_emplace(uid, Table::Entry{frameRate});
+    }
+    for (const auto& [uid, frameRate] : mFrameRateOverridesFromGameManager) {
+        table->entries.try_emplace(uid, Table::Entry{frameRate});
+    }
+    for (const auto& [uid, frameRate] : mFrameRateOverridesByContent) {
+        table->entries.try_emplace(uid, Table::Entry{frameRate, /*byContent*/ true});
+    }
+
+    const uint64_t generation = table->generation;
+    mTable = std::move(table);
+    mTableGeneration.store(generation, std::memory_order_release);
+}
+
 bool FrameRateOverrideMappings::updateFrameRateOverridesByContent(
         const UidToFrameRateOverride& frameRateOverrides) {
     std::lock_guard lock(mFrameRateOverridesLock);
@@ -121,6 +136,7 @@ bool FrameRateOverrideMappings::updateFrameRateOverridesByContent(
                         return lhs.first == rhs.first && isApproxEqual(lhs.second, rhs.second);
                     })) {
         mFrameRateOverridesByContent = frameRateOverrides;
+        publishTableLocked();
         return true;
     }
     return false;
@@ -134,6 +150,7 @@ void FrameRateOverrideMappings::setGameModeRefreshRateForUid(FrameRateOverride f
     } else {
         mFrameRateOverridesFromGameManager.erase(frameRateOverride.uid);
     }
+    publishTableLocked();
 }
 
 void FrameRateOverrideMappings::setPreferredRefreshRateForUid(FrameRateOverride frameRateOverride) {
@@ -144,5 +161,6 @@ void FrameRateOverrideMappings::setPreferredRefreshRateForUid(FrameRateOverride
     } else {
         mFrameRateOverridesFromBackdoor.erase(frameRateOverride.uid);
     }
+    publishTableLocked();
 }
 } // namespace android::scheduler
@@ -20,8 +20,11 @@
 #include <gui/DisplayEventReceiver.h>
 #include <scheduler/Fps.h>
 #include <sys/types.h>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <optional>
+#include <unordered_map>
 
 #include "Utils/Dumper.h"
 
@@ -32,6 +35,35 @@ class FrameRateOverrideMappings {
     using UidToFrameRateOverride = std::map<uid_t, Fps>;
 
 public:
+    // The frame rate overrides in effect for each uid, rebuilt whenever the mappings change.
+    struct Table {
+        struct Entry {
+            Fps frameRate;
+            // Whether the override is from setFrameRate, which only applies when the display
+            // supports frame rate overrides by content.
+            bool byContent = false;
+        };
+
+        std::optional<Fps> get(uid_t, bool supportsFrameRateOverrideByContent) const;
+
+        uint64_t generation = 0;
+        std::unordered_map<uid_t, Entry> entries;
+    };
+
+    // Looks up the overrides for a single thread, e.g. an EventThread on every VSYNC, in a copy of
+    // the table that is only refreshed, under the lock, after the mappings changed.
+    class Reader {
+    public:
+        explicit Reader(const FrameRateOverrideMappings& mappings) : mMappings(&mappings) {}
+
+        std::optional<Fps> getFrameRateOverrideForUid(uid_t uid,
+                                                      bool supportsFrameRateOverrideByContent);
+
+    private:
+        const FrameRateOverrideMappings* mMappings;
+        std::shared_ptr<const Table> mTable;
+    };
+
     std::optional<Fps> getFrameRateOverrideForUid(uid_t uid,
                                                   bool supportsFrameRateOverrideByContent) const
             EXCLUDES(mFrameRateOverridesLock);
@@ -55,6 +87,8 @@ private:
 
     void dump(utils::Dumper&, std::string_view name, const UidToFrameRateOverride&) const;
 
+    void publishTableLocked() REQUIRES(mFrameRateOverridesLock);
+
     // The frame rate override lists need their own mutex as they are being read
     // by SurfaceFlinger, Scheduler and EventThread (as a callback) to prevent deadlocks
     mutable std::mutex mFrameRateOverridesLock;
@@ -64,6 +98,11 @@ private:
     UidToFrameRateOverride mFrameRateOverridesByContent GUARDED_BY(mFrameRateOverridesLock);
     UidToFrameRateOverride mFrameRateOverridesFromBackdoor GUARDED_BY(mFrameRateOverridesLock);
     UidToFrameRateOverride mFrameRateOverridesFromGameManager GUARDED_BY(mFrameRateOverridesLock);
+
+    std::shared_ptr<const Table> mTable GUARDED_BY(mFrameRateOverridesLock) =
+            std::make_shared<const Table>();
+    // The generation of mTable, for Readers to check without locking.
+    std::atomic<uint64_t> mTableGeneration = 0;
 };
 
 } // namespace android::scheduler
@@ -106,7 +106,7 @@ void LayerHistory::registerLayer(Layer* layer, bool contentDetectionEnabled) {
 
     // The layer can be placed on either map, it is assumed that partitionLayers() will be called
     // to correct them.
-    mInactiveLayerInfos.insert({layer->getSequence(), std::make_pair(layer, std::move(info))});
+    mInactiveLayerInfos.try_emplace(layer->getSequence(), layer, std::move(info));
 }
 
 void LayerHistory::deregisterLayer(Layer* layer) {
@@ -149,8 +149,7 @@ void LayerHistory::record(int32_t id, const LayerProps& layerProps, nsecs_t pres
 
     // Activate layer if inactive.
     if (found == LayerStatus::LayerInInactiveMap) {
-        mActiveLayerInfos.insert(
-                {id, std::make_pair(layerPair->first, std::move(layerPair->second))});
+        mActiveLayerInfos.try_emplace(id, layerPair->first, std::move(layerPair->second));
         mInactiveLayerInfos.erase(id);
     }
 }
@@ -225,7 +224,7 @@ void LayerHistory::partitionLayers(nsecs_t now) {
         if (isLayerActive(*info, threshold)) {
             // move this to the active map
 
-            mActiveLayerInfos.insert({it->first, std::move(it->second)});
+            mActiveLayerInfos.try_emplace(it->first, std::move(it->second));
             it = mInactiveLayerInfos.erase(it);
         } else {
             if (CC_UNLIKELY(mTraceEnabled)) {
@@ -272,7 +271,7 @@ void LayerHistory::partitionLayers(nsecs_t now) {
             }
             info->onLayerInactive(now);
             // move this to the inactive map
-            mInactiveLayerInfos.insert({it->first, std::move(it->second)});
+            mInactiveLayerInfos.try_emplace(it->first, std::move(it->second));
             it = mActiveLayerInfos.erase(it);
         }
     }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include <ftl/flat_hash_map.h>
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
 
@@ -92,8 +93,10 @@ private:
     friend class TestableScheduler;
 
     using LayerPair = std::pair<Layer*, std::unique_ptr<LayerInfo>>;
-    // keyed by id as returned from Layer::getSequence()
-    using LayerInfos = std::unordered_map<int32_t, LayerPair>;
+    // keyed by id as returned from Layer::getSequence(). The maps are looked up for every buffer
+    // of every layer, and their mappings move between them whenever the layers become active or
+    // inactive, so they are flat hash maps rather than allocate a node per mapping.
+    using LayerInfos = ftl::FlatHashMap<int32_t, LayerPair>;
 
     // Iterates over layers maps moving all active layers to mActiveLayerInfos and all inactive
     // layers to mInactiveLayerInfos.
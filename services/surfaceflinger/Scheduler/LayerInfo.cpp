@@ -24,6 +24,7 @@
 #include "LayerInfo.h"
 
 #include <algorithm>
+#include <cinttypes>
 #include <utility>
 
 #include <cutils/compiler.h>
@@ -61,17 +62,114 @@ void LayerInfo::setLastPresentTime(nsecs_t lastPresentTime, nsecs_t now, LayerUp
             break;
         case LayerUpdateType::SetFrameRate:
         case LayerUpdateType::Buffer:
-            FrameTimeData frameTime = {.presentTime = lastPresentTime,
-                                       .queueTime = mLastUpdatedTime,
-                                       .pendingModeChange = pendingModeChange};
-            mFrameTimes.push_back(frameTime);
-            if (mFrameTimes.size() > HISTORY_SIZE) {
-                mFrameTimes.pop_front();
-            }
+            addFrameTime({.presentTime = lastPresentTime,
+                          .queueTime = mLastUpdatedTime,
+                          .pendingModeChange = pendingModeChange});
             break;
     }
 }
 
+void LayerInfo::addFrameTime(const FrameTimeData& frameTime) {
+    const uint64_t serial = mNextFrameTimeSerial++;
+    mFrameTimes.push_back(frameTime);
+    mPresentTimeDeltas.add(frameTime, serial);
+    mQueueTimeDeltas.add(frameTime, serial);
+    mPendingModeChangeCount += frameTime.pendingModeChange;
+    mMissingPresentTimeCount += frameTime.presentTime == 0;
+
+    if (mFrameTimes.size() <= HISTORY_SIZE) {
+        return;
+    }
+
+    const FrameTimeData& front = mFrameTimes.front();
+    mPendingModeChangeCount -= front.pendingModeChange;
+    mMissingPresentTimeCount -= front.presentTime == 0;
+    const uint64_t frontSerial = serial - (mFrameTimes.size() - 1);
+    mFrameTimes.pop_front();
+
+    const auto recount = [&](FrameDeltas& deltas) {
+        deltas.clear();
+        uint64_t frameSerial = frontSerial + 1;
+        for (const auto& frame : mFrameTimes) {
+            deltas.add(frame, frameSerial++);
+        }
+    };
+    if (!mPresentTimeDeltas.dropFront(frontSerial)) {
+        recount(mPresentTimeDeltas);
+    }
+    if (!mQueueTimeDeltas.dropFront(frontSerial)) {
+        recount(mQueueTimeDeltas);
+    }
+}
+
+void LayerInfo::clearFrameTimes() {
+    mFrameTimes.clear();
+    mPresentTimeDeltas.clear();
+    mQueueTimeDeltas.clear();
+    mPendingModeChangeCount = 0;
+    mMissingPresentTimeCount = 0;
+}
+
+void LayerInfo::FrameDeltas::add(const FrameTimeData& frameTime, uint64_t serial) {
+    const nsecs_t time = frameTime.*mTime;
+    if (mNodes.empty()) {
+        mNodes.push_back({serial, 0});
+        mLastTime = time;
+        return;
+    }
+
+    const nsecs_t delta = time - mLastTime;
+    if (delta < kMinPeriodBetweenFrames) {
+        // Count the delta into the next frame.
+        return;
+    }
+
+    mNodes.push_back({serial, delta});
+    mLastTime = time;
+
+    // Deltas that are too long are not counted, but still start the next delta.
+    if (delta <= kMaxPeriodBetweenFrames) {
+        mTotalDeltas += delta;
+        mNumDeltas++;
+    }
+}
+
+bool LayerInfo::FrameDeltas::dropFront(uint64_t serial) {
+    LOG_ALWAYS_FATAL_IF(mNodes.empty() || mNodes.front().serial != serial,
+                        "%s: Frame %" PRIu64 " is not the first", __func__, serial);
+    mNodes.pop_front();
+
+    // The deltas of the remaining frames only stand if the next frame started a delta.
+    if (mNodes.empty() || mNodes.front().serial != serial + 1) {
+        return false;
+    }
+
+    auto& node = mNodes.front();
+    if (node.delta <= kMaxPeriodBetweenFrames) {
+        mTotalDeltas -= node.delta;
+        mNumDeltas--;
+    }
+    node.delta = 0;
+    return true;
+}
+
+void LayerInfo::FrameDeltas::clear() {
+    mNodes.clear();
+    mLastTime = 0;
+    mTotalDeltas = 0;
+    mNumDeltas = 0;
+}
+
+std::optional<nsecs_t> LayerInfo::FrameDeltas::average() const {
+    if (mNumDeltas == 0) {
+        return std::nullopt;
+    }
+
+    const auto averageFrameTime =
+            static_cast<double>(mTotalDeltas) / static_cast<double>(mNumDeltas);
+    return static_cast<nsecs_t>(averageFrameTime);
+}
+
 bool LayerInfo::isFrameTimeValid(const FrameTimeData& frameTime) const {
     return frameTime.queueTime >= std::chrono::duration_cast<std::chrono::nanoseconds>(
                                           mFrameTimeValidSince.time_since_epoch())
@@ -173,16 +271,11 @@ bool LayerInfo::hasEnoughDataForHeuristic() const {
 
 std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
     // Ignore frames captured during a mode change
-    const bool isDuringModeChange =
-            std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
-                        [](const auto& frame) { return frame.pendingModeChange; });
-    if (isDuringModeChange) {
+    if (mPendingModeChangeCount > 0) {
         return std::nullopt;
     }
 
-    const bool isMissingPresentTime =
-            std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
-                        [](auto frame) { return frame.presentTime == 0; });
+    const bool isMissingPresentTime = mMissingPresentTimeCount > 0;
     if (isMissingPresentTime && !mLastRefreshRate.reported.isValid()) {
         // If there are no presentation timestamps and we haven't calculated
         // one in the past then we can't calculate the refresh rate
@@ -196,37 +289,7 @@ std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
     // when implementing render ahead for specific refresh rates. When hwui no longer provides
     // presentation timestamps we look at the queue time to see if the current refresh rate still
     // matches the content.
-
-    auto getFrameTime = isMissingPresentTime ? [](FrameTimeData data) { return data.queueTime; }
-                                             : [](FrameTimeData data) { return data.presentTime; };
-
-    nsecs_t totalDeltas = 0;
-    int numDeltas = 0;
-    auto prevFrame = mFrameTimes.begin();
-    for (auto it = mFrameTimes.begin() + 1; it != mFrameTimes.end(); ++it) {
-        const auto currDelta = getFrameTime(*it) - getFrameTime(*prevFrame);
-        if (currDelta < kMinPeriodBetweenFrames) {
-            // Skip this frame, but count the delta into the next frame
-            continue;
-        }
-
-        prevFrame = it;
-
-        if (currDelta > kMaxPeriodBetweenFrames) {
-            // Skip this frame and the current delta.
-            continue;
-        }
-
-        totalDeltas += currDelta;
-        numDeltas++;
-    }
-
-    if (numDeltas == 0) {
-        return std::nullopt;
-    }
-
-    const auto averageFrameTime = static_cast<double>(totalDeltas) / static_cast<double>(numDeltas);
-    return static_cast<nsecs_t>(averageFrameTime);
+    return isMissingPresentTime ? mQueueTimeDeltas.average() : mPresentTimeDeltas.average();
 }
 
 std::optional<Fps> LayerInfo::calculateRefreshRateIfPossible(const RefreshRateSelector& selector,
@@ -346,13 +409,36 @@ LayerInfo::RefreshRateHistory::makeHeuristicTraceTagData() const {
 
 void LayerInfo::RefreshRateHistory::clear() {
     mRefreshRates.clear();
+    mMinRefreshRates.clear();
+    mMaxRefreshRates.clear();
 }
 
 bool LayerInfo::RefreshRateHistory::add(Fps refreshRate, nsecs_t now) {
+    const uint64_t serial = mNextSerial++;
     mRefreshRates.push_back({refreshRate, now});
+
+    // A rate can no longer be the min (or max) once a lower (or higher) rate is added after it.
+    while (!mMinRefreshRates.empty() &&
+           !isStrictlyLess(mMinRefreshRates.back().refreshRate, refreshRate)) {
+        mMinRefreshRates.pop_back();
+    }
+    mMinRefreshRates.push_back({refreshRate, serial});
+    while (!mMaxRefreshRates.empty() &&
+           !isStrictlyLess(refreshRate, mMaxRefreshRates.back().refreshRate)) {
+        mMaxRefreshRates.pop_back();
+    }
+    mMaxRefreshRates.push_back({refreshRate, serial});
+
     while (mRefreshRates.size() >= HISTORY_SIZE ||
            now - mRefreshRates.front().timestamp > HISTORY_DURATION.count()) {
+        const uint64_t frontSerial = serial + 1 - mRefreshRates.size();
         mRefreshRates.pop_front();
+        if (mMinRefreshRates.front().serial == frontSerial) {
+            mMinRefreshRates.pop_front();
+        }
+        if (mMaxRefreshRates.front().serial == frontSerial) {
+            mMaxRefreshRates.pop_front();
+        }
     }
 
     if (CC_UNLIKELY(sTraceEnabled)) {
@@ -369,11 +455,8 @@ bool LayerInfo::RefreshRateHistory::add(Fps refreshRate, nsecs_t now) {
 bool LayerInfo::RefreshRateHistory::isConsistent() const {
     if (mRefreshRates.empty()) return true;
 
-    const auto [min, max] =
-            std::minmax_element(mRefreshRates.begin(), mRefreshRates.end(),
-                                [](const auto& lhs, const auto& rhs) {
-                                    return isStrictlyLess(lhs.refreshRate, rhs.refreshRate);
-                                });
+    const auto* const min = &mMinRefreshRates.front();
+    const auto* const max = &mMaxRefreshRates.front();
 
     const bool consistent =
             max->refreshRate.getValue() - min->refreshRate.getValue() < MARGIN_CONSISTENT_FPS;
@@ -186,7 +186,7 @@ public:
 
     void clearHistory(nsecs_t now) {
         onLayerInactive(now);
-        mFrameTimes.clear();
+        clearFrameTimes();
     }
 
 private:
@@ -197,6 +197,38 @@ private:
         bool pendingModeChange;
     };
 
+    // Sums the deltas between consecutive frame times, as calculateAverageFrameTime needs them, as
+    // frames are added. A delta shorter than kMinPeriodBetweenFrames is folded into the next one, so
+    // which frames start a delta depends on the first frame. Dropping the first frame only forces a
+    // recount if the second frame was folded, which is rare.
+    class FrameDeltas {
+    public:
+        explicit FrameDeltas(nsecs_t FrameTimeData::*time) : mTime(time) {}
+
+        void add(const FrameTimeData&, uint64_t serial);
+
+        // Drops the first frame, which must have been added with `serial`. Returns false if the
+        // deltas must be recounted from the remaining frames.
+        bool dropFront(uint64_t serial);
+
+        void clear();
+
+        std::optional<nsecs_t> average() const;
+
+    private:
+        // A frame that starts a delta, and the delta that ends at it, if any.
+        struct Node {
+            uint64_t serial;
+            nsecs_t delta;
+        };
+
+        const nsecs_t FrameTimeData::*const mTime;
+        std::deque<Node> mNodes;
+        nsecs_t mLastTime = 0;
+        nsecs_t mTotalDeltas = 0;
+        int mNumDeltas = 0;
+    };
+
     // Holds information about the calculated and reported refresh rate
     struct RefreshRateHeuristicData {
         // Rate calculated on the layer
@@ -235,6 +267,12 @@ private:
             nsecs_t timestamp = 0;
         };
 
+        // A candidate for the min or max of mRefreshRates, keyed by when it was added.
+        struct Extremum {
+            Fps refreshRate;
+            uint64_t serial;
+        };
+
         // Holds tracing strings
         struct HeuristicTraceTagData {
             std::string min;
@@ -249,6 +287,11 @@ private:
         const std::string mName;
         mutable std::optional<HeuristicTraceTagData> mHeuristicTraceTagData;
         std::deque<RefreshRateData> mRefreshRates;
+        // Ascending and descending rates of mRefreshRates, so that the min and max are at the
+        // front as rates are added and dropped.
+        std::deque<Extremum> mMinRefreshRates;
+        std::deque<Extremum> mMaxRefreshRates;
+        uint64_t mNextSerial = 0;
         static constexpr float MARGIN_CONSISTENT_FPS = 1.0;
     };
 
@@ -266,6 +309,8 @@ private:
     std::optional<Fps> calculateRefreshRateIfPossible(const RefreshRateSelector&, nsecs_t now);
     std::optional<nsecs_t> calculateAverageFrameTime() const;
     bool isFrameTimeValid(const FrameTimeData&) const;
+    void addFrameTime(const FrameTimeData&);
+    void clearFrameTimes();
 
     const std::string mName;
     const uid_t mOwnerUid;
@@ -288,6 +333,14 @@ private:
     RefreshRateHeuristicData mLastRefreshRate;
 
     std::deque<FrameTimeData> mFrameTimes;
+    // Kept up to date by addFrameTime, so that calculating the refresh rate does not walk
+    // mFrameTimes.
+    FrameDeltas mPresentTimeDeltas{&FrameTimeData::presentTime};
+    FrameDeltas mQueueTimeDeltas{&FrameTimeData::queueTime};
+    size_t mPendingModeChangeCount = 0;
+    size_t mMissingPresentTimeCount = 0;
+    // The serial of the next frame time, which increases even when frame times are dropped.
+    uint64_t mNextFrameTimeSerial = 0;
     std::chrono::time_point<std::chrono::steady_clock> mFrameTimeValidSince =
             std::chrono::steady_clock::now();
     static constexpr size_t HISTORY_SIZE = RefreshRateHistory::HISTORY_SIZE;
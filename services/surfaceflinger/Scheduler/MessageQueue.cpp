@@ -150,6 +150,7 @@ void MessageQueue::waitMessage() {
     do {
         IPCThreadState::self()->flushCommands();
         int32_t ret = mLooper->pollOnce(-1);
+        mWakeupCount++;
         switch (ret) {
             case Looper::POLL_WAKE:
             case Looper::POLL_CALLBACK:
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <future>
 #include <type_traits>
@@ -129,6 +130,8 @@ private:
 
     Vsync mVsync;
 
+    std::atomic<uint64_t> mWakeupCount = 0;
+
     // Returns the old registration so it can be destructed outside the lock to
     // avoid deadlock.
     std::unique_ptr<scheduler::VSyncCallbackRegistration> onNewVsyncScheduleLocked(
@@ -150,6 +153,9 @@ public:
     void scheduleFrame() override;
 
     std::optional<Clock::time_point> getScheduledFrameTime() const override;
+
+    // The number of times the main thread woke up from waiting for messages.
+    uint64_t getWakeupCount() const { return mWakeupCount; }
 };
 
 } // namespace impl
@@ -33,6 +33,7 @@
 #include <ftl/match.h>
 #include <ftl/unit.h>
 #include <gui/TraceUtils.h>
+#include <math/HashCombine.h>
 #include <scheduler/FrameRateMode.h>
 #include <utils/Trace.h>
 
@@ -355,17 +356,46 @@ float RefreshRateSelector::calculateDistanceScoreFromMax(Fps refreshRate) const
 float RefreshRateSelector::calculateLayerScoreLocked(const LayerRequirement& layer, Fps refreshRate,
                                                      bool isSeamlessSwitch) const {
     ATRACE_CALL();
-    // Slightly prefer seamless switches.
-    constexpr float kSeamedSwitchPenalty = 0.95f;
-    const float seamlessness = isSeamlessSwitch ? 1.0f : kSeamedSwitchPenalty;
-
     // If the layer wants Max, give higher score to the higher refresh rate
     if (layer.vote == LayerVoteType::Max) {
         return calculateDistanceScoreFromMax(refreshRate);
     }
 
-    if (layer.vote == LayerVoteType::ExplicitExact) {
-        const int divisor = getFrameRateDivisor(refreshRate, layer.desiredRefreshRate);
+    const int divisor = getFrameRateDivisor(refreshRate, layer.desiredRefreshRate);
+    const float nonExactMatchingScore = divisor > 0 || layer.vote == LayerVoteType::ExplicitExact
+            ? 0.f
+            : calculateNonExactMatchingLayerScoreLocked(layer, refreshRate);
+    return combineLayerScore(layer.vote, divisor, nonExactMatchingScore, isSeamlessSwitch);
+}
+
+float RefreshRateSelector::calculateLayerScoreLocked(const LayerRequirement& layer,
+                                                     std::optional<size_t> knownFrameRateIndex,
+                                                     size_t frameRateIndex,
+                                                     bool isSeamlessSwitch) const {
+    if (layer.vote == LayerVoteType::Max) {
+        return mLayerScoreTable.maxScores[frameRateIndex];
+    }
+
+    if (!knownFrameRateIndex) {
+        return calculateLayerScoreLocked(layer, mAppRequestFrameRates[frameRateIndex].fps,
+                                         isSeamlessSwitch);
+    }
+
+    const auto& entry = mLayerScoreTable.get(*knownFrameRateIndex, frameRateIndex);
+    const float nonExactMatchingScore = layer.vote == LayerVoteType::ExplicitDefault
+            ? entry.explicitDefaultScore
+            : entry.fixedSourceScore;
+    return combineLayerScore(layer.vote, entry.divisor, nonExactMatchingScore, isSeamlessSwitch);
+}
+
+float RefreshRateSelector::combineLayerScore(LayerVoteType vote, int divisor,
+                                             float nonExactMatchingScore,
+                                             bool isSeamlessSwitch) const {
+    // Slightly prefer seamless switches.
+    constexpr float kSeamedSwitchPenalty = 0.95f;
+    const float seamlessness = isSeamlessSwitch ? 1.0f : kSeamedSwitchPenalty;
+
+    if (vote == LayerVoteType::ExplicitExact) {
         if (supportsAppFrameRateOverrideByContent()) {
             // Since we support frame rate override, allow refresh rates which are
             // multiples of the layer's request, as those apps would be throttled
@@ -378,7 +408,7 @@ float RefreshRateSelector::calculateLayerScoreLocked(const LayerRequirement& lay
 
     // If the layer frame rate is a divisor of the refresh rate it should score
     // the highest score.
-    if (getFrameRateDivisor(refreshRate, layer.desiredRefreshRate) > 0) {
+    if (divisor > 0) {
         return 1.0f * seamlessness;
     }
 
@@ -386,24 +416,110 @@ float RefreshRateSelector::calculateLayerScoreLocked(const LayerRequirement& lay
     // there is a small penalty attached to the score to favor the frame rates
     // the exactly matches the display refresh rate or a multiple.
     constexpr float kNonExactMatchingPenalty = 0.95f;
-    return calculateNonExactMatchingLayerScoreLocked(layer, refreshRate) * seamlessness *
-            kNonExactMatchingPenalty;
+    return nonExactMatchingScore * seamlessness * kNonExactMatchingPenalty;
+}
+
+std::optional<size_t> RefreshRateSelector::findKnownFrameRateIndex(Fps fps) const {
+    const auto it = std::lower_bound(mKnownFrameRates.begin(), mKnownFrameRates.end(), fps,
+                                     isStrictlyLess);
+    if (it == mKnownFrameRates.end() || it->getValue() != fps.getValue()) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(std::distance(mKnownFrameRates.begin(), it));
+}
+
+void RefreshRateSelector::constructLayerScoreTable() {
+    ATRACE_CALL();
+    mLayerScoreTable.maxScores.clear();
+    for (const auto& frameRateMode : mAppRequestFrameRates) {
+        mLayerScoreTable.maxScores.push_back(calculateDistanceScoreFromMax(frameRateMode.fps));
+    }
+
+    mLayerScoreTable.entries.clear();
+    mLayerScoreTable.entries.reserve(mKnownFrameRates.size() * mAppRequestFrameRates.size());
+    for (const Fps knownFrameRate : mKnownFrameRates) {
+        const LayerRequirement fixedSourceLayer = {.vote = LayerVoteType::Heuristic,
+                                                   .desiredRefreshRate = knownFrameRate};
+        const LayerRequirement explicitDefaultLayer = {.vote = LayerVoteType::ExplicitDefault,
+                                                       .desiredRefreshRate = knownFrameRate};
+
+        for (const auto& frameRateMode : mAppRequestFrameRates) {
+            const Fps fps = frameRateMode.fps;
+            mLayerScoreTable.entries.push_back(
+                    {.divisor = getFrameRateDivisor(fps, knownFrameRate),
+                     .fixedSourceScore =
+                             calculateNonExactMatchingLayerScoreLocked(fixedSourceLayer, fps),
+                     .explicitDefaultScore =
+                             calculateNonExactMatchingLayerScoreLocked(explicitDefaultLayer,
+                                                                       fps)});
+        }
+    }
 }
 
 auto RefreshRateSelector::getRankedFrameRates(const std::vector<LayerRequirement>& layers,
                                               GlobalSignals signals) const -> RankedFrameRates {
     std::lock_guard lock(mLock);
 
-    if (mGetRankedFrameRatesCache &&
-        mGetRankedFrameRatesCache->arguments == std::make_pair(layers, signals)) {
-        return mGetRankedFrameRatesCache->result;
+    if (const auto* cachedResult = mGetRankedFrameRatesCache.get(layers, signals)) {
+        return *cachedResult;
     }
 
     const auto result = getRankedFrameRatesLocked(layers, signals);
-    mGetRankedFrameRatesCache = GetRankedFrameRatesCache{{layers, signals}, result};
+    mGetRankedFrameRatesCache.put(layers, signals, result);
     return result;
 }
 
+auto RefreshRateSelector::getRankedFrameRatesCacheStats() const -> GetRankedFrameRatesCacheStats {
+    std::lock_guard lock(mLock);
+    return mGetRankedFrameRatesCache.getStats();
+}
+
+size_t RefreshRateSelector::GetRankedFrameRatesCache::hash(
+        const std::vector<LayerRequirement>& layers, GlobalSignals signals) {
+    size_t hash = hashCombine(signals.touch, signals.idle, signals.powerOnImminent);
+    for (const auto& layer : layers) {
+        hashCombineSingleHashed(hash,
+                                hashCombine(layer.name, layer.vote, layer.seamlessness,
+                                            layer.weight, layer.focused));
+    }
+    return hash;
+}
+
+auto RefreshRateSelector::GetRankedFrameRatesCache::get(const std::vector<LayerRequirement>& layers,
+                                                        GlobalSignals signals)
+        -> const RankedFrameRates* {
+    const size_t argumentsHash = hash(layers, signals);
+    const auto it = std::find_if(mEntries.begin(), mEntries.end(), [&](const Entry& entry) {
+        return entry.hash == argumentsHash && entry.signals == signals && entry.layers == layers;
+    });
+
+    if (it == mEntries.end()) {
+        mStats.misses++;
+        return nullptr;
+    }
+
+    mStats.hits++;
+    it->lastUse = mUseCount++;
+    return &it->result;
+}
+
+void RefreshRateSelector::GetRankedFrameRatesCache::put(const std::vector<LayerRequirement>& layers,
+                                                        GlobalSignals signals,
+                                                        const RankedFrameRates& result) {
+    Entry entry{hash(layers, signals), layers, signals, result, mUseCount++};
+    if (mEntries.size() < kCapacity) {
+        mEntries.push_back(std::move(entry));
+        return;
+    }
+
+    const auto leastRecentlyUsed =
+            std::min_element(mEntries.begin(), mEntries.end(),
+                             [](const Entry& lhs, const Entry& rhs) {
+                                 return lhs.lastUse < rhs.lastUse;
+                             });
+    *leastRecentlyUsed = std::move(entry);
+}
+
 auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequirement>& layers,
                                                     GlobalSignals signals) const
         -> RankedFrameRates {
@@ -531,8 +647,11 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
         }
 
         const auto weight = layer.weight;
+        const auto knownFrameRateIndex = findKnownFrameRateIndex(layer.desiredRefreshRate);
 
-        for (auto& [mode, overallScore, fixedRateBelowThresholdLayersScore] : scores) {
+        // The scores are in the order of mAppRequestFrameRates.
+        for (size_t frameRateIndex = 0; frameRateIndex < scores.size(); frameRateIndex++) {
+            auto& [mode, overallScore, fixedRateBelowThresholdLayersScore] = scores[frameRateIndex];
             const auto& [fps, modePtr] = mode;
             const bool isSeamlessSwitch = modePtr->getGroup() == activeMode.getGroup();
 
@@ -574,7 +693,8 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
                 continue;
             }
 
-            const float layerScore = calculateLayerScoreLocked(layer, fps, isSeamlessSwitch);
+            const float layerScore = calculateLayerScoreLocked(layer, knownFrameRateIndex,
+                                                               frameRateIndex, isSeamlessSwitch);
             const float weightedLayerScore = weight * layerScore;
 
             // Layer with fixed source has a special consideration which depends on the
@@ -1023,7 +1143,7 @@ void RefreshRateSelector::setActiveMode(DisplayModeId modeId, Fps renderFrameRat
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    mGetRankedFrameRatesCache.clear();
 
     const auto activeModeOpt = mDisplayModes.get(modeId);
     LOG_ALWAYS_FATAL_IF(!activeModeOpt);
@@ -1062,7 +1182,7 @@ void RefreshRateSelector::updateDisplayModes(DisplayModes modes, DisplayModeId a
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    mGetRankedFrameRatesCache.clear();
 
     mDisplayModes = std::move(modes);
     const auto activeModeOpt = mDisplayModes.get(activeModeId);
@@ -1162,7 +1282,7 @@ auto RefreshRateSelector::setPolicy(const PolicyVariant& policy) -> SetPolicyRes
             return SetPolicyResult::Invalid;
         }
 
-        mGetRankedFrameRatesCache.reset();
+        mGetRankedFrameRatesCache.clear();
 
         if (*getCurrentPolicyLocked() == oldPolicy) {
             return SetPolicyResult::Unchanged;
@@ -1240,6 +1360,8 @@ void RefreshRateSelector::constructAvailableRefreshRates() {
 
     mPrimaryFrameRates = filterRefreshRates(policy->primaryRanges, "primary");
     mAppRequestFrameRates = filterRefreshRates(policy->appRequestRanges, "app request");
+
+    constructLayerScoreTable();
 }
 
 Fps RefreshRateSelector::findClosestKnownFrameRate(Fps frameRate) const {
@@ -1341,6 +1463,12 @@ void RefreshRateSelector::dump(utils::Dumper& dumper) const {
 
     dumper.dump("frameRateOverrideConfig"sv, *ftl::enum_name(mFrameRateOverrideConfig));
 
+    const auto& cacheStats = mGetRankedFrameRatesCache.getStats();
+    dumper.dump("rankedFrameRatesCache"sv,
+                ftl::Concat("{size=", mGetRankedFrameRatesCache.size(), ", hits=", cacheStats.hits,
+                            ", misses=", cacheStats.misses, '}')
+                        .str());
+
     dumper.dump("idleTimer"sv);
     {
         utils::Dumper::Indent indent(dumper);
@@ -234,6 +234,14 @@ public:
     RankedFrameRates getRankedFrameRates(const std::vector<LayerRequirement>&, GlobalSignals) const
             EXCLUDES(mLock);
 
+    // Lookups of getRankedFrameRates results since construction.
+    struct GetRankedFrameRatesCacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    GetRankedFrameRatesCacheStats getRankedFrameRatesCacheStats() const EXCLUDES(mLock);
+
     FpsRange getSupportedRefreshRateRange() const EXCLUDES(mLock) {
         std::lock_guard lock(mLock);
         return {mMinRefreshRateModeIt->second->getFps(), mMaxRefreshRateModeIt->second->getFps()};
@@ -446,6 +454,22 @@ private:
     float calculateNonExactMatchingLayerScoreLocked(const LayerRequirement&, Fps refreshRate) const
             REQUIRES(mLock);
 
+    // Same as calculateLayerScoreLocked, for the mAppRequestFrameRates at `frameRateIndex`. Looks
+    // up the score in mLayerScoreTable if the layer's desired refresh rate is a known frame rate.
+    float calculateLayerScoreLocked(const LayerRequirement&,
+                                    std::optional<size_t> knownFrameRateIndex,
+                                    size_t frameRateIndex, bool isSeamlessSwitch) const
+            REQUIRES(mLock);
+
+    // Combines the parts of a layer score that depend on the layer and refresh rate.
+    float combineLayerScore(LayerVoteType, int divisor, float nonExactMatchingScore,
+                            bool isSeamlessSwitch) const;
+
+    // Returns the index of `fps` in mKnownFrameRates, if it is exactly one of them.
+    std::optional<size_t> findKnownFrameRateIndex(Fps) const;
+
+    void constructLayerScoreTable() REQUIRES(mLock);
+
     void updateDisplayModes(DisplayModes, DisplayModeId activeModeId) EXCLUDES(mLock)
             REQUIRES(kMainThreadContext);
 
@@ -488,6 +512,30 @@ private:
     std::vector<FrameRateMode> mPrimaryFrameRates GUARDED_BY(mLock);
     std::vector<FrameRateMode> mAppRequestFrameRates GUARDED_BY(mLock);
 
+    // The parts of the scores of layers voting for each of mKnownFrameRates, for each of
+    // mAppRequestFrameRates, which only change with the policy.
+    struct LayerScoreTable {
+        struct Entry {
+            // getFrameRateDivisor
+            int divisor = 0;
+            // calculateNonExactMatchingLayerScoreLocked for Heuristic and ExplicitExactOrMultiple
+            // votes, which score the same, and for ExplicitDefault votes.
+            float fixedSourceScore = 0.f;
+            float explicitDefaultScore = 0.f;
+        };
+
+        // Rows of known frame rates, each with a column per app request frame rate.
+        std::vector<Entry> entries;
+        // calculateDistanceScoreFromMax for each app request frame rate.
+        std::vector<float> maxScores;
+
+        const Entry& get(size_t knownFrameRateIndex, size_t frameRateIndex) const {
+            return entries[knownFrameRateIndex * maxScores.size() + frameRateIndex];
+        }
+    };
+
+    LayerScoreTable mLayerScoreTable GUARDED_BY(mLock);
+
     Policy mDisplayManagerPolicy GUARDED_BY(mLock);
     std::optional<Policy> mOverridePolicy GUARDED_BY(mLock);
 
@@ -502,11 +550,43 @@ private:
     const Config mConfig;
     Config::FrameRateOverride mFrameRateOverrideConfig;
 
-    struct GetRankedFrameRatesCache {
-        std::pair<std::vector<LayerRequirement>, GlobalSignals> arguments;
-        RankedFrameRates result;
+    // Memoizes the results of the most recently used distinct arguments to getRankedFrameRates. The
+    // results also depend on the display modes and the policy, so the cache must be cleared when
+    // either changes.
+    class GetRankedFrameRatesCache {
+    public:
+        static constexpr size_t kCapacity = 8;
+
+        // Returns nullptr on a miss.
+        const RankedFrameRates* get(const std::vector<LayerRequirement>&, GlobalSignals);
+
+        // Evicts the least recently used result if the cache is full.
+        void put(const std::vector<LayerRequirement>&, GlobalSignals, const RankedFrameRates&);
+
+        void clear() { mEntries.clear(); }
+        size_t size() const { return mEntries.size(); }
+
+        const GetRankedFrameRatesCacheStats& getStats() const { return mStats; }
+
+    private:
+        // Consistent with LayerRequirement::operator==, so leaves out the approximately compared
+        // desired refresh rate.
+        static size_t hash(const std::vector<LayerRequirement>&, GlobalSignals);
+
+        struct Entry {
+            size_t hash;
+            std::vector<LayerRequirement> layers;
+            GlobalSignals signals;
+            RankedFrameRates result;
+            uint64_t lastUse;
+        };
+
+        std::vector<Entry> mEntries;
+        uint64_t mUseCount = 0;
+        GetRankedFrameRatesCacheStats mStats;
     };
-    mutable std::optional<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
+
+    mutable GetRankedFrameRatesCache mGetRankedFrameRatesCache GUARDED_BY(mLock);
 
     // Declare mIdleTimer last to ensure its thread joins before the mutex/callbacks are destroyed.
     std::mutex mIdleTimerCallbacksMutex;
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cinttypes>
 #include <cstdlib>
@@ -73,6 +74,29 @@ public:
         mCurrentRefreshRate = currRefreshRate;
     }
 
+    // Upper bounds of the buckets of mode switch latencies. The last bucket has no bound.
+    static constexpr std::array<std::chrono::milliseconds, 6> kModeSwitchLatencyBounds = {
+            std::chrono::milliseconds(4),  std::chrono::milliseconds(8),
+            std::chrono::milliseconds(17), std::chrono::milliseconds(34),
+            std::chrono::milliseconds(50), std::chrono::milliseconds(100)};
+
+    using ModeSwitchLatencyHistogram = std::array<uint32_t, kModeSwitchLatencyBounds.size() + 1>;
+
+    struct ModeSwitchLatencies {
+        // From the decision to switch the display mode to the mode change call to HWC.
+        ModeSwitchLatencyHistogram toHwc{};
+        // From the decision to switch the display mode to SF running at the new mode.
+        ModeSwitchLatencyHistogram toApplied{};
+    };
+
+    void recordModeSwitchLatency(std::chrono::nanoseconds toHwc,
+                                 std::chrono::nanoseconds toApplied) {
+        mModeSwitchLatencies.toHwc[getModeSwitchLatencyBucket(toHwc)]++;
+        mModeSwitchLatencies.toApplied[getModeSwitchLatencyBucket(toApplied)]++;
+    }
+
+    const ModeSwitchLatencies& getModeSwitchLatencies() const { return mModeSwitchLatencies; }
+
     // Maps stringified refresh rate to total time spent in that mode.
     using TotalTimes = ftl::SmallMap<std::string, std::chrono::milliseconds, 3>;
 
@@ -109,6 +133,17 @@ public:
         for (const auto& [name, time] : const_cast<RefreshRateStats*>(this)->getTotalTimes()) {
             stream << name << ": " << getDateFormatFromMs(time) << '\n';
         }
+
+        stream << "+  Mode switches: count by latency to HWC / to applied\n";
+        for (size_t i = 0; i < mModeSwitchLatencies.toHwc.size(); i++) {
+            if (i < kModeSwitchLatencyBounds.size()) {
+                stream << "<" << kModeSwitchLatencyBounds[i].count() << "ms";
+            } else {
+                stream << ">=" << kModeSwitchLatencyBounds.back().count() << "ms";
+            }
+            stream << ": " << mModeSwitchLatencies.toHwc[i] << " / "
+                   << mModeSwitchLatencies.toApplied[i] << '\n';
+        }
         result.append(stream.str());
     }
 
@@ -142,6 +177,15 @@ private:
         mTimeStats.recordRefreshRate(fps, timeElapsed);
     }
 
+    static size_t getModeSwitchLatencyBucket(std::chrono::nanoseconds latency) {
+        size_t bucket = 0;
+        while (bucket < kModeSwitchLatencyBounds.size() &&
+               latency >= kModeSwitchLatencyBounds[bucket]) {
+            bucket++;
+        }
+        return bucket;
+    }
+
     // Formats the time in milliseconds into easy to read format.
     static std::string getDateFormatFromMs(std::chrono::milliseconds time) {
         auto [days, dayRemainderMs] = std::div(static_cast<int64_t>(time.count()), MS_PER_DAY);
@@ -163,6 +207,8 @@ private:
     std::chrono::milliseconds mScreenOffTime = std::chrono::milliseconds::zero();
 
     nsecs_t mPreviousRecordedTime = systemTime();
+
+    ModeSwitchLatencies mModeSwitchLatencies;
 };
 
 } // namespace android::scheduler
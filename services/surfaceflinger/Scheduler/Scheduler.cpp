@@ -191,8 +191,37 @@ bool Scheduler::isVsyncInPhase(TimePoint timePoint, const Fps frameRate) const {
 }
 
 impl::EventThread::ThrottleVsyncCallback Scheduler::makeThrottleVsyncCallback() const {
-    return [this](nsecs_t expectedVsyncTimestamp, uid_t uid) {
-        return !isVsyncValid(TimePoint::fromNs(expectedVsyncTimestamp), uid);
+    // The EventThread asks for each uid with connections waiting for the VSYNC, so the overrides
+    // are looked up without locking, and the uids overridden to the same frame rate share their
+    // phase check for the VSYNC.
+    struct VsyncState {
+        nsecs_t expectedVsyncTimestamp = -1;
+        bool supportsFrameRateOverrideByContent = false;
+        ftl::SmallMap<Fps, bool, 4, FpsApproxEqual> inPhaseByFrameRate;
+    };
+
+    return [this, whence = __func__,
+            reader = FrameRateOverrideMappings::Reader(mFrameRateOverrideMappings),
+            state = VsyncState{}](nsecs_t expectedVsyncTimestamp, uid_t uid) mutable {
+        if (state.expectedVsyncTimestamp != expectedVsyncTimestamp) {
+            state.expectedVsyncTimestamp = expectedVsyncTimestamp;
+            state.supportsFrameRateOverrideByContent =
+                    pacesetterSelectorPtr()->supportsAppFrameRateOverrideByContent();
+            state.inPhaseByFrameRate.clear();
+        }
+
+        const auto frameRate =
+                reader.getFrameRateOverrideForUid(uid, state.supportsFrameRateOverrideByContent);
+        if (!frameRate) {
+            return false;
+        }
+
+        const auto [it, inserted] = state.inPhaseByFrameRate.try_emplace(*frameRate, true);
+        if (inserted) {
+            ATRACE_FORMAT("%s uid: %d frameRate: %s", whence, uid, to_string(*frameRate).c_str());
+            it->second = isVsyncInPhase(TimePoint::fromNs(expectedVsyncTimestamp), *frameRate);
+        }
+        return !it->second;
     };
 }
 
@@ -636,6 +665,26 @@ void Scheduler::kernelIdleTimerCallback(TimerState state) {
 void Scheduler::idleTimerCallback(TimerState state) {
     applyPolicy(&Policy::idleTimer, state);
     ATRACE_INT("ExpiredIdleTimer", static_cast<int>(state));
+
+    // Pause composition if no frame is pending, since nothing but a transaction or buffer (which
+    // reset the idle timer when scheduling a frame) can change the screen. The frame callback is
+    // already unscheduled, so HW VSYNC is the only remaining source of main thread wakeups.
+    if (state == TimerState::Expired) {
+        if (getScheduledFrameTime() || mIdle.exchange(true)) {
+            return;
+        }
+        ATRACE_INT("CompositionIdle", 1);
+
+        std::scoped_lock lock(mDisplayLock);
+        ftl::FakeGuard guard(kMainThreadContext);
+        for (const auto& [_, display] : mDisplays) {
+            constexpr bool kDisallow = false;
+            display.schedulePtr->disableHardwareVsync(mSchedulerCallback, kDisallow);
+        }
+    } else if (mIdle.exchange(false)) {
+        ATRACE_INT("CompositionIdle", 0);
+        resyncAllToHardwareVsync(false /* allowToEnable */);
+    }
 }
 
 void Scheduler::touchTimerCallback(TimerState state) {
@@ -677,6 +726,22 @@ void Scheduler::dump(utils::Dumper& dumper) const {
         dumper.dump("layerHistory"sv, mLayerHistory.dump());
         dumper.dump("touchTimer"sv, mTouchTimer.transform(&OneShotTimer::interval));
         dumper.dump("displayPowerTimer"sv, mDisplayPowerTimer.transform(&OneShotTimer::interval));
+        dumper.dump("idle"sv, mIdle.load());
+    }
+    {
+        utils::Dumper::Section section(dumper, "Main thread wakeups"sv);
+
+        const uint64_t count = getWakeupCount();
+        const TimePoint now = TimePoint::now();
+
+        std::scoped_lock lock(mWakeupSampleLock);
+        dumper.dump("total"sv, count);
+        if (mWakeupSample.time.ns() > 0) {
+            const auto seconds = static_cast<float>(now.ns() - mWakeupSample.time.ns()) / 1e9f;
+            dumper.dump("perSecondSinceLastDump"sv,
+                        static_cast<float>(count - mWakeupSample.count) / seconds);
+        }
+        mWakeupSample = {count, now};
     }
 
     mFrameRateOverrideMappings.dump(dumper);
@@ -313,7 +313,7 @@ private:
 
     // Update feature state machine to given state when corresponding timer resets or expires.
     void kernelIdleTimerCallback(TimerState) EXCLUDES(mDisplayLock);
-    void idleTimerCallback(TimerState);
+    void idleTimerCallback(TimerState) EXCLUDES(mDisplayLock);
     void touchTimerCallback(TimerState);
     void displayPowerTimerCallback(TimerState);
 
@@ -401,6 +401,19 @@ private:
 
     std::atomic<nsecs_t> mLastResyncTime = 0;
 
+    // Whether composition is paused, i.e. the idle timer expired with no frame scheduled, so HW
+    // VSYNC is disabled until the next frame is requested.
+    std::atomic_bool mIdle = false;
+
+    // The main thread wakeups when last dumped, to report the wakeup rate since then.
+    struct WakeupSample {
+        uint64_t count = 0;
+        TimePoint time;
+    };
+
+    mutable std::mutex mWakeupSampleLock;
+    mutable WakeupSample mWakeupSample GUARDED_BY(mWakeupSampleLock);
+
     const FeatureFlags mFeatures;
 
     // Shifts the VSYNC phase during certain transactions and refresh rate changes.
@@ -20,6 +20,7 @@
 
 #include <android-base/stringprintf.h>
 #include <ftl/concat.h>
+#include <ftl/enum.h>
 #include <utils/Trace.h>
 #include <log/log_main.h>
 
@@ -220,11 +221,13 @@ void VSyncDispatchTimerQueueEntry::dump(std::string& result) const {
 
 VSyncDispatchTimerQueue::VSyncDispatchTimerQueue(std::unique_ptr<TimeKeeper> tk,
                                                  VsyncSchedule::TrackerPtr tracker,
-                                                 nsecs_t timerSlack, nsecs_t minVsyncDistance)
+                                                 nsecs_t timerSlack, nsecs_t minVsyncDistance,
+                                                 Backend backend)
       : mTimeKeeper(std::move(tk)),
         mTracker(std::move(tracker)),
         mTimerSlack(timerSlack),
-        mMinVsyncDistance(minVsyncDistance) {}
+        mMinVsyncDistance(minVsyncDistance),
+        mBackend(backend) {}
 
 VSyncDispatchTimerQueue::~VSyncDispatchTimerQueue() {
     std::lock_guard lock(mMutex);
@@ -256,21 +259,32 @@ void VSyncDispatchTimerQueue::rearmTimerSkippingUpdateFor(
     std::optional<nsecs_t> min;
     std::optional<nsecs_t> targetVsync;
     std::optional<std::string_view> nextWakeupName;
-    for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
-        auto& callback = it->second;
-        if (!callback->wakeupTime() && !callback->hasPendingWorkloadUpdate()) {
-            continue;
-        }
-
-        if (it != skipUpdateIt) {
-            callback->update(*mTracker, now);
-        }
-        auto const wakeupTime = *callback->wakeupTime();
-        if (!min || *min > wakeupTime) {
+    if (mBackend == Backend::Heap) {
+        refreshEarliestWakeup(now, skipUpdateIt);
+        if (!mWakeups.empty()) {
+            const auto& [wakeupTime, token] = mWakeups.top();
+            const auto& callback = mCallbacks.at(token);
             nextWakeupName = callback->name();
             min = wakeupTime;
             targetVsync = callback->targetVsync();
         }
+    } else {
+        for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
+            auto& callback = it->second;
+            if (!callback->wakeupTime() && !callback->hasPendingWorkloadUpdate()) {
+                continue;
+            }
+
+            if (it != skipUpdateIt) {
+                callback->update(*mTracker, now);
+            }
+            auto const wakeupTime = *callback->wakeupTime();
+            if (!min || *min > wakeupTime) {
+                nextWakeupName = callback->name();
+                min = wakeupTime;
+                targetVsync = callback->targetVsync();
+            }
+        }
     }
 
     if (min && min < mIntendedWakeupTime) {
@@ -286,6 +300,34 @@ void VSyncDispatchTimerQueue::rearmTimerSkippingUpdateFor(
     }
 }
 
+void VSyncDispatchTimerQueue::refreshEarliestWakeup(nsecs_t now,
+                                                    CallbackMap::iterator const& skipUpdateIt) {
+    for (const auto token : mPendingUpdates) {
+        const auto it = mCallbacks.find(token);
+        if (it == mCallbacks.end()) continue;
+
+        // Applying the workload update arms the callback if it was disarmed.
+        it->second->update(*mTracker, now);
+        if (const auto wakeupTime = it->second->wakeupTime()) {
+            mWakeups.set(token, *wakeupTime);
+        }
+    }
+    mPendingUpdates.clear();
+
+    // Refreshing a wakeup may move it after the next one, which then needs refreshing in turn.
+    // Refreshing is deterministic, so this settles once the earliest wakeup stays in place.
+    for (size_t i = 0; !mWakeups.empty() && i <= mWakeups.size(); i++) {
+        const auto [previousTime, token] = mWakeups.top();
+        const auto it = mCallbacks.find(token);
+        if (it == skipUpdateIt) break;
+
+        it->second->update(*mTracker, now);
+        const auto wakeupTime = *it->second->wakeupTime();
+        mWakeups.set(token, wakeupTime);
+        if (wakeupTime <= previousTime || mWakeups.top().key == token) break;
+    }
+}
+
 void VSyncDispatchTimerQueue::timerCallback() {
     struct Invocation {
         std::shared_ptr<VSyncDispatchTimerQueueEntry> callback;
@@ -298,20 +340,33 @@ void VSyncDispatchTimerQueue::timerCallback() {
         std::lock_guard lock(mMutex);
         auto const now = mTimeKeeper->now();
         mLastTimerCallback = now;
-        for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
-            auto& callback = it->second;
-            auto const wakeupTime = callback->wakeupTime();
-            if (!wakeupTime) {
-                continue;
-            }
-
-            auto const readyTime = callback->readyTime();
-
-            auto const lagAllowance = std::max(now - mIntendedWakeupTime, static_cast<nsecs_t>(0));
-            if (*wakeupTime < mIntendedWakeupTime + mTimerSlack + lagAllowance) {
+        auto const lagAllowance = std::max(now - mIntendedWakeupTime, static_cast<nsecs_t>(0));
+        auto const dispatchBefore = mIntendedWakeupTime + mTimerSlack + lagAllowance;
+        if (mBackend == Backend::Heap) {
+            while (!mWakeups.empty() && mWakeups.top().time < dispatchBefore) {
+                const auto [wakeupTime, token] = mWakeups.pop();
+                auto& callback = mCallbacks.at(token);
+                auto const readyTime = callback->readyTime();
                 callback->executing();
                 invocations.emplace_back(Invocation{callback, *callback->lastExecutedVsyncTarget(),
-                                                    *wakeupTime, *readyTime});
+                                                    wakeupTime, *readyTime});
+            }
+        } else {
+            for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
+                auto& callback = it->second;
+                auto const wakeupTime = callback->wakeupTime();
+                if (!wakeupTime) {
+                    continue;
+                }
+
+                auto const readyTime = callback->readyTime();
+
+                if (*wakeupTime < dispatchBefore) {
+                    callback->executing();
+                    invocations.emplace_back(Invocation{callback,
+                                                        *callback->lastExecutedVsyncTarget(),
+                                                        *wakeupTime, *readyTime});
+                }
             }
         }
 
@@ -328,13 +383,17 @@ void VSyncDispatchTimerQueue::timerCallback() {
 VSyncDispatchTimerQueue::CallbackToken VSyncDispatchTimerQueue::registerCallback(
         Callback callback, std::string callbackName) {
     std::lock_guard lock(mMutex);
-    return CallbackToken{
+    const CallbackToken token{
             mCallbacks
                     .emplace(++mCallbackToken,
                              std::make_shared<VSyncDispatchTimerQueueEntry>(std::move(callbackName),
                                                                             std::move(callback),
                                                                             mMinVsyncDistance))
                     .first->first};
+    if (mBackend == Backend::Heap) {
+        mWakeups.track(token);
+    }
+    return token;
 }
 
 void VSyncDispatchTimerQueue::unregisterCallback(CallbackToken token) {
@@ -345,6 +404,7 @@ void VSyncDispatchTimerQueue::unregisterCallback(CallbackToken token) {
         if (it != mCallbacks.end()) {
             entry = it->second;
             mCallbacks.erase(it);
+            mWakeups.untrack(token);
         }
     }
 
@@ -372,6 +432,9 @@ ScheduleResult VSyncDispatchTimerQueue::scheduleLocked(CallbackToken token,
      * timer recalculation to avoid cancelling a callback that is about to fire. */
     auto const rearmImminent = now > mIntendedWakeupTime;
     if (CC_UNLIKELY(rearmImminent)) {
+        if (mBackend == Backend::Heap && !callback->hasPendingWorkloadUpdate()) {
+            mPendingUpdates.push_back(token);
+        }
         callback->addPendingWorkloadUpdate(scheduleTiming);
         return getExpectedCallbackTime(*mTracker, now, scheduleTiming);
     }
@@ -381,6 +444,10 @@ ScheduleResult VSyncDispatchTimerQueue::scheduleLocked(CallbackToken token,
         return {};
     }
 
+    if (mBackend == Backend::Heap) {
+        mWakeups.set(token, *callback->wakeupTime());
+    }
+
     if (callback->wakeupTime() < mIntendedWakeupTime - mTimerSlack) {
         rearmTimerSkippingUpdateFor(now, it);
     }
@@ -415,6 +482,7 @@ CancelResult VSyncDispatchTimerQueue::cancel(CallbackToken token) {
     auto const wakeupTime = callback->wakeupTime();
     if (wakeupTime) {
         callback->disarm();
+        mWakeups.clear(token);
 
         if (*wakeupTime == mIntendedWakeupTime) {
             mIntendedWakeupTime = kInvalidTime;
@@ -431,6 +499,11 @@ void VSyncDispatchTimerQueue::dump(std::string& result) const {
     mTimeKeeper->dump(result);
     StringAppendF(&result, "\tmTimerSlack: %.2fms mMinVsyncDistance: %.2fms\n", mTimerSlack / 1e6f,
                   mMinVsyncDistance / 1e6f);
+    StringAppendF(&result, "\tbackend: %s", ftl::enum_string(mBackend).c_str());
+    if (mBackend == Backend::Heap) {
+        StringAppendF(&result, " queuedWakeups: %zu", mWakeups.size());
+    }
+    result.append("\n");
     StringAppendF(&result, "\tmIntendedWakeupTime: %.2fms from now\n",
                   (mIntendedWakeupTime - mTimeKeeper->now()) / 1e6f);
     StringAppendF(&result, "\tmLastTimerCallback: %.2fms ago mLastTimerSchedule: %.2fms ago\n",
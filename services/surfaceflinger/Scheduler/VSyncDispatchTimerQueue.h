@@ -22,8 +22,10 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
+#include <scheduler/WakeupHeap.h>
 
 #include "VSyncDispatch.h"
 #include "VsyncSchedule.h"
@@ -113,6 +115,17 @@ private:
  */
 class VSyncDispatchTimerQueue : public VSyncDispatch {
 public:
+    enum class Backend {
+        // Scans every callback, refreshing each armed one with the latest model, whenever the
+        // timer is rearmed or fires.
+        Scan,
+        // Keeps armed callbacks in a WakeupHeap. Rearming only refreshes the earliest wakeup,
+        // and later ones are refreshed once they become the earliest.
+        Heap,
+
+        ftl_last = Heap
+    };
+
     // Constructs a VSyncDispatchTimerQueue.
     // \param[in] tk                    A timekeeper.
     // \param[in] tracker               A tracker.
@@ -120,8 +133,10 @@ public:
     //                                  should be grouped into one wakeup.
     // \param[in] minVsyncDistance      The minimum distance between two vsync estimates before the
     //                                  vsyncs are considered the same vsync event.
+    // \param[in] backend               How armed callbacks are ordered by wakeup time.
     VSyncDispatchTimerQueue(std::unique_ptr<TimeKeeper>, VsyncSchedule::TrackerPtr,
-                            nsecs_t timerSlack, nsecs_t minVsyncDistance);
+                            nsecs_t timerSlack, nsecs_t minVsyncDistance,
+                            Backend backend = Backend::Scan);
     ~VSyncDispatchTimerQueue();
 
     CallbackToken registerCallback(Callback, std::string callbackName) final;
@@ -143,6 +158,8 @@ private:
     void rearmTimer(nsecs_t now) REQUIRES(mMutex);
     void rearmTimerSkippingUpdateFor(nsecs_t now, CallbackMap::iterator const& skipUpdate)
             REQUIRES(mMutex);
+    void refreshEarliestWakeup(nsecs_t now, CallbackMap::iterator const& skipUpdate)
+            REQUIRES(mMutex);
     void cancelTimer() REQUIRES(mMutex);
     ScheduleResult scheduleLocked(CallbackToken, ScheduleTiming) REQUIRES(mMutex);
 
@@ -151,6 +168,7 @@ private:
     VsyncSchedule::TrackerPtr mTracker;
     nsecs_t const mTimerSlack;
     nsecs_t const mMinVsyncDistance;
+    Backend const mBackend;
 
     std::mutex mutable mMutex;
     size_t mCallbackToken GUARDED_BY(mMutex) = 0;
@@ -158,6 +176,11 @@ private:
     CallbackMap mCallbacks GUARDED_BY(mMutex);
     nsecs_t mIntendedWakeupTime GUARDED_BY(mMutex) = kInvalidTime;
 
+    // Only used with Backend::Heap. Callbacks with a workload update that is deferred until the
+    // next rearm are kept aside, since they are not necessarily armed.
+    WakeupHeap<CallbackToken> mWakeups GUARDED_BY(mMutex);
+    std::vector<CallbackToken> mPendingUpdates GUARDED_BY(mMutex);
+
     // For debugging purposes
     nsecs_t mLastTimerCallback GUARDED_BY(mMutex) = kInvalidTime;
     nsecs_t mLastTimerSchedule GUARDED_BY(mMutex) = kInvalidTime;
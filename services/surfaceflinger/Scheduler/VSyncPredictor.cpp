@@ -32,6 +32,7 @@
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <ftl/concat.h>
+#include <ftl/enum.h>
 #include <gui/TraceUtils.h>
 #include <utils/Log.h>
 
@@ -47,13 +48,16 @@ static auto constexpr kMaxPercent = 100u;
 VSyncPredictor::~VSyncPredictor() = default;
 
 VSyncPredictor::VSyncPredictor(PhysicalDisplayId id, nsecs_t idealPeriod, size_t historySize,
-                               size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent)
+                               size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent,
+                               Estimator estimator)
       : mId(id),
         mTraceOn(property_get_bool("debug.sf.vsp_trace", false)),
         kHistorySize(historySize),
         kMinimumSamplesForPrediction(minimumSamplesForPrediction),
         kOutlierTolerancePercent(std::min(outlierTolerancePercent, kMaxPercent)),
-        mIdealPeriod(idealPeriod) {
+        mEstimator(estimator),
+        mIdealPeriod(idealPeriod),
+        mKalmanFilter(idealPeriod) {
     resetModel();
 }
 
@@ -76,11 +80,16 @@ bool VSyncPredictor::validate(nsecs_t timestamp) const {
         return true;
     }
 
-    auto const aValidTimestamp = mTimestamps[mLastTimestampIndex];
-    auto const percent = (timestamp - aValidTimestamp) % mIdealPeriod * kMaxPercent / mIdealPeriod;
-    if (percent >= kOutlierTolerancePercent &&
-        percent <= (kMaxPercent - kOutlierTolerancePercent)) {
-        return false;
+    // Once the Kalman filter is running, it gates samples by their distance from its prediction
+    // instead, which adapts to how much the panel jitters.
+    if (mEstimator == Estimator::LeastSquares || !mKalmanFilter.isInitialized()) {
+        auto const aValidTimestamp = mTimestamps[mLastTimestampIndex];
+        auto const percent =
+                (timestamp - aValidTimestamp) % mIdealPeriod * kMaxPercent / mIdealPeriod;
+        if (percent >= kOutlierTolerancePercent &&
+            percent <= (kMaxPercent - kOutlierTolerancePercent)) {
+            return false;
+        }
     }
 
     const auto iter = std::min_element(mTimestamps.begin(), mTimestamps.end(),
@@ -100,26 +109,55 @@ nsecs_t VSyncPredictor::currentPeriod() const {
     return mRateMap.find(mIdealPeriod)->second.slope;
 }
 
+void VSyncPredictor::rejectTimestamp(nsecs_t timestamp) {
+    // VSR could elect to ignore the incongruent timestamp or resetModel(). If ts is ignored,
+    // don't insert this ts into mTimestamps ringbuffer. If we are still
+    // in the learning phase we should just clear all timestamps and start
+    // over.
+    if (mTimestamps.size() < kMinimumSamplesForPrediction) {
+        // Add the timestamp to mTimestamps before clearing it so we could
+        // update mKnownTimestamp based on the new timestamp.
+        mTimestamps.push_back(timestamp);
+        clearTimestamps();
+    } else if (!mTimestamps.empty()) {
+        mKnownTimestamp =
+                std::max(timestamp, *std::max_element(mTimestamps.begin(), mTimestamps.end()));
+    } else {
+        mKnownTimestamp = timestamp;
+    }
+}
+
 bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     std::lock_guard lock(mMutex);
 
+    // Readers do not move the reference point for sequence numbers forward, so move it here,
+    // before the model changes, so that sequence numbers stay continuous across model updates.
+    if (mLastVsyncSequence) {
+        mLastVsyncSequence = getVsyncSequence(makeSnapshotLocked(), timestamp);
+    }
+
+    const bool accepted = addVsyncTimestampLocked(timestamp);
+    publishSnapshotLocked();
+    return accepted;
+}
+
+bool VSyncPredictor::addVsyncTimestampLocked(nsecs_t timestamp) {
     if (!validate(timestamp)) {
-        // VSR could elect to ignore the incongruent timestamp or resetModel(). If ts is ignored,
-        // don't insert this ts into mTimestamps ringbuffer. If we are still
-        // in the learning phase we should just clear all timestamps and start
-        // over.
-        if (mTimestamps.size() < kMinimumSamplesForPrediction) {
-            // Add the timestamp to mTimestamps before clearing it so we could
-            // update mKnownTimestamp based on the new timestamp.
-            mTimestamps.push_back(timestamp);
+        rejectTimestamp(timestamp);
+        return false;
+    }
+
+    if (mEstimator == Estimator::Kalman) {
+        const auto result = mKalmanFilter.update(timestamp);
+        if (result == VsyncKalmanFilter::Result::Rejected) {
+            rejectTimestamp(timestamp);
+            return false;
+        }
+        if (result == VsyncKalmanFilter::Result::Initialized && !mTimestamps.empty()) {
+            // The filter restarted because the HW vsync timing changed, so the history is stale.
             clearTimestamps();
-        } else if (!mTimestamps.empty()) {
-            mKnownTimestamp =
-                    std::max(timestamp, *std::max_element(mTimestamps.begin(), mTimestamps.end()));
-        } else {
-            mKnownTimestamp = timestamp;
+            mKalmanFilter.update(timestamp);
         }
-        return false;
     }
 
     if (mTimestamps.size() != kHistorySize) {
@@ -138,72 +176,16 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         return true;
     }
 
-    // This is a 'simple linear regression' calculation of Y over X, with Y being the
-    // vsync timestamps, and X being the ordinal of vsync count.
-    // The calculated slope is the vsync period.
-    // Formula for reference:
-    // Sigma_i: means sum over all timestamps.
-    // mean(variable): statistical mean of variable.
-    // X: snapped ordinal of the timestamp
-    // Y: vsync timestamp
-    //
-    //         Sigma_i( (X_i - mean(X)) * (Y_i - mean(Y) )
-    // slope = -------------------------------------------
-    //         Sigma_i ( X_i - mean(X) ) ^ 2
-    //
-    // intercept = mean(Y) - slope * mean(X)
-    //
-    std::vector<nsecs_t> vsyncTS(numSamples);
-    std::vector<nsecs_t> ordinals(numSamples);
-
-    // Normalizing to the oldest timestamp cuts down on error in calculating the intercept.
-    const auto oldestTS = *std::min_element(mTimestamps.begin(), mTimestamps.end());
     auto it = mRateMap.find(mIdealPeriod);
-    auto const currentPeriod = it->second.slope;
-
-    // The mean of the ordinals must be precise for the intercept calculation, so scale them up for
-    // fixed-point arithmetic.
-    constexpr int64_t kScalingFactor = 1000;
-
-    nsecs_t meanTS = 0;
-    nsecs_t meanOrdinal = 0;
-
-    for (size_t i = 0; i < numSamples; i++) {
-        const auto timestamp = mTimestamps[i] - oldestTS;
-        vsyncTS[i] = timestamp;
-        meanTS += timestamp;
-
-        const auto ordinal = currentPeriod == 0
-                ? 0
-                : (vsyncTS[i] + currentPeriod / 2) / currentPeriod * kScalingFactor;
-        ordinals[i] = ordinal;
-        meanOrdinal += ordinal;
-    }
-
-    meanTS /= numSamples;
-    meanOrdinal /= numSamples;
-
-    for (size_t i = 0; i < numSamples; i++) {
-        vsyncTS[i] -= meanTS;
-        ordinals[i] -= meanOrdinal;
-    }
-
-    nsecs_t top = 0;
-    nsecs_t bottom = 0;
-    for (size_t i = 0; i < numSamples; i++) {
-        top += vsyncTS[i] * ordinals[i];
-        bottom += ordinals[i] * ordinals[i];
-    }
-
-    if (CC_UNLIKELY(bottom == 0)) {
+    const auto model =
+            mEstimator == Estimator::Kalman ? getKalmanModel() : fitLeastSquaresModel();
+    if (CC_UNLIKELY(!model)) {
         it->second = {mIdealPeriod, 0};
         clearTimestamps();
         return false;
     }
 
-    nsecs_t const anticipatedPeriod = top * kScalingFactor / bottom;
-    nsecs_t const intercept = meanTS - (anticipatedPeriod * meanOrdinal / kScalingFactor);
-
+    const auto [anticipatedPeriod, intercept] = *model;
     auto const percent = std::abs(anticipatedPeriod - mIdealPeriod) * kMaxPercent / mIdealPeriod;
     if (percent >= kOutlierTolerancePercent) {
         it->second = {mIdealPeriod, 0};
@@ -221,28 +203,79 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     return true;
 }
 
-auto VSyncPredictor::getVsyncSequenceLocked(nsecs_t timestamp) const -> VsyncSequence {
-    const auto vsync = nextAnticipatedVSyncTimeFromLocked(timestamp);
-    if (!mLastVsyncSequence) return {vsync, 0};
+auto VSyncPredictor::fitLeastSquaresModel() const -> std::optional<Model> {
+    const auto oldestTS = *std::min_element(mTimestamps.begin(), mTimestamps.end());
+    const auto currentPeriod = mRateMap.find(mIdealPeriod)->second.slope;
+    const auto fit = fitVsyncLeastSquares(mTimestamps, oldestTS, currentPeriod);
+    if (!fit) {
+        return std::nullopt;
+    }
+    return Model{fit->slope, fit->intercept};
+}
 
-    const auto [slope, _] = getVSyncPredictionModelLocked();
-    const auto [lastVsyncTime, lastVsyncSequence] = *mLastVsyncSequence;
+auto VSyncPredictor::getKalmanModel() const -> Model {
+    // Predictions are made relative to the oldest timestamp, so express the model that way.
+    const auto oldestTS = *std::min_element(mTimestamps.begin(), mTimestamps.end());
+    const auto fit = mKalmanFilter.getModel(oldestTS);
+    return {fit.slope, fit.intercept};
+}
+
+auto VSyncPredictor::makeSnapshotLocked() const -> ModelSnapshot {
+    ModelSnapshot snapshot;
+    snapshot.model = getVSyncPredictionModelLocked();
+    snapshot.idealPeriod = mIdealPeriod;
+    if (!mTimestamps.empty()) {
+        snapshot.oldestTimestamp = *std::min_element(mTimestamps.begin(), mTimestamps.end());
+    }
+    snapshot.knownTimestamp = mKnownTimestamp;
+    snapshot.renderRateDivisor = mRenderRate
+            ? RefreshRateSelector::getFrameRateDivisor(Fps::fromPeriodNsecs(mIdealPeriod),
+                                                       *mRenderRate)
+            : 0;
+    snapshot.lastVsyncSequence = mLastVsyncSequence;
+    return snapshot;
+}
+
+void VSyncPredictor::publishSnapshotLocked() const {
+    mSnapshot.store(makeSnapshotLocked());
+}
+
+auto VSyncPredictor::loadSnapshot() const -> std::optional<ModelSnapshot> {
+    // Publishing is short, so a couple of retries covers a read that raced with one.
+    static constexpr int kMaxAttempts = 4;
+    for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
+        if (const auto snapshot = mSnapshot.tryLoad()) {
+            return snapshot;
+        }
+        mSnapshotRetries.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::nullopt;
+}
+
+auto VSyncPredictor::getVsyncSequence(const ModelSnapshot& snapshot, nsecs_t timestamp) const
+        -> VsyncSequence {
+    const auto vsync = nextAnticipatedVSyncTimeFrom(snapshot, timestamp);
+    if (!snapshot.lastVsyncSequence) return {vsync, 0};
+
+    const auto slope = snapshot.model.slope;
+    const auto [lastVsyncTime, lastVsyncSequence] = *snapshot.lastVsyncSequence;
     const auto vsyncSequence = lastVsyncSequence +
-            static_cast<int64_t>(std::round((vsync - lastVsyncTime) / static_cast<float>(slope)));
+            static_cast<int64_t>(std::round((vsync - lastVsyncTime) / static_cast<double>(slope)));
     return {vsync, vsyncSequence};
 }
 
-nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFromLocked(nsecs_t timePoint) const {
-    auto const [slope, intercept] = getVSyncPredictionModelLocked();
+nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFrom(const ModelSnapshot& snapshot,
+                                                     nsecs_t timePoint) const {
+    auto const [slope, intercept] = snapshot.model;
 
-    if (mTimestamps.empty()) {
+    if (!snapshot.oldestTimestamp) {
         traceInt64("VSP-mode", 1);
-        auto const knownTimestamp = mKnownTimestamp ? *mKnownTimestamp : timePoint;
-        auto const numPeriodsOut = ((timePoint - knownTimestamp) / mIdealPeriod) + 1;
-        return knownTimestamp + numPeriodsOut * mIdealPeriod;
+        auto const knownTimestamp = snapshot.knownTimestamp.value_or(timePoint);
+        auto const numPeriodsOut = ((timePoint - knownTimestamp) / snapshot.idealPeriod) + 1;
+        return knownTimestamp + numPeriodsOut * snapshot.idealPeriod;
     }
 
-    auto const oldest = *std::min_element(mTimestamps.begin(), mTimestamps.end());
+    auto const oldest = *snapshot.oldestTimestamp;
 
     // See b/145667109, the ordinal calculation must take into account the intercept.
     auto const zeroPoint = oldest + intercept;
@@ -268,33 +301,43 @@ nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFromLocked(nsecs_t timePoint) co
     return prediction;
 }
 
-nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFrom(nsecs_t timePoint) const {
-    std::lock_guard lock(mMutex);
-
-    // update the mLastVsyncSequence for reference point
-    mLastVsyncSequence = getVsyncSequenceLocked(timePoint);
-
-    const auto renderRatePhase = [&]() REQUIRES(mMutex) -> int {
-        if (!mRenderRate) return 0;
-
-        const auto divisor =
-                RefreshRateSelector::getFrameRateDivisor(Fps::fromPeriodNsecs(mIdealPeriod),
-                                                         *mRenderRate);
+nsecs_t VSyncPredictor::nextRenderRateVSyncTime(const ModelSnapshot& snapshot,
+                                                VsyncSequence vsync) const {
+    const auto renderRatePhase = [&]() -> int {
+        const auto divisor = snapshot.renderRateDivisor;
         if (divisor <= 1) return 0;
 
-        const int mod = mLastVsyncSequence->seq % divisor;
+        const int mod = vsync.seq % divisor;
         if (mod == 0) return 0;
 
         return divisor - mod;
     }();
 
     if (renderRatePhase == 0) {
-        return mLastVsyncSequence->vsyncTime;
+        return vsync.vsyncTime;
     }
 
-    auto const [slope, intercept] = getVSyncPredictionModelLocked();
-    const auto approximateNextVsync = mLastVsyncSequence->vsyncTime + slope * renderRatePhase;
-    return nextAnticipatedVSyncTimeFromLocked(approximateNextVsync - slope / 2);
+    auto const slope = snapshot.model.slope;
+    const auto approximateNextVsync = vsync.vsyncTime + slope * renderRatePhase;
+    return nextAnticipatedVSyncTimeFrom(snapshot, approximateNextVsync - slope / 2);
+}
+
+nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFrom(nsecs_t timePoint) const {
+    if (const auto snapshot = loadSnapshot(); snapshot && snapshot->lastVsyncSequence) {
+        return nextRenderRateVSyncTime(*snapshot, getVsyncSequence(*snapshot, timePoint));
+    }
+
+    // Taking the lock is only needed to set the reference point for sequence numbers, or if the
+    // snapshot is being republished continuously.
+    std::lock_guard lock(mMutex);
+    mLockedReads.fetch_add(1, std::memory_order_relaxed);
+
+    // update the mLastVsyncSequence for reference point
+    const auto snapshot = makeSnapshotLocked();
+    mLastVsyncSequence = getVsyncSequence(snapshot, timePoint);
+    publishSnapshotLocked();
+
+    return nextRenderRateVSyncTime(snapshot, *mLastVsyncSequence);
 }
 
 /*
@@ -306,13 +349,21 @@ nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFrom(nsecs_t timePoint) const {
  * isVSyncInPhase(50.0, 30) = true
  */
 bool VSyncPredictor::isVSyncInPhase(nsecs_t timePoint, Fps frameRate) const {
-    std::lock_guard lock(mMutex);
+    auto snapshot = loadSnapshot();
+    if (!snapshot) {
+        std::lock_guard lock(mMutex);
+        mLockedReads.fetch_add(1, std::memory_order_relaxed);
+        snapshot = makeSnapshotLocked();
+    }
+
     const auto divisor =
-            RefreshRateSelector::getFrameRateDivisor(Fps::fromPeriodNsecs(mIdealPeriod), frameRate);
-    return isVSyncInPhaseLocked(timePoint, static_cast<unsigned>(divisor));
+            RefreshRateSelector::getFrameRateDivisor(Fps::fromPeriodNsecs(snapshot->idealPeriod),
+                                                     frameRate);
+    return isVSyncInPhase(*snapshot, timePoint, static_cast<unsigned>(divisor));
 }
 
-bool VSyncPredictor::isVSyncInPhaseLocked(nsecs_t timePoint, unsigned divisor) const {
+bool VSyncPredictor::isVSyncInPhase(const ModelSnapshot& snapshot, nsecs_t timePoint,
+                                    unsigned divisor) const {
     const TimePoint now = TimePoint::now();
     const auto getTimePointIn = [](TimePoint now, nsecs_t timePoint) -> float {
         return ticks<std::milli, float>(TimePoint::fromNs(timePoint) - now);
@@ -324,9 +375,9 @@ bool VSyncPredictor::isVSyncInPhaseLocked(nsecs_t timePoint, unsigned divisor) c
         return true;
     }
 
-    const nsecs_t period = mRateMap[mIdealPeriod].slope;
+    const nsecs_t period = snapshot.model.slope;
     const nsecs_t justBeforeTimePoint = timePoint - period / 2;
-    const auto vsyncSequence = getVsyncSequenceLocked(justBeforeTimePoint);
+    const auto vsyncSequence = getVsyncSequence(snapshot, justBeforeTimePoint);
     ATRACE_FORMAT_INSTANT("vsync in: %.2f sequence: %" PRId64,
                           getTimePointIn(now, vsyncSequence.vsyncTime), vsyncSequence.seq);
     return vsyncSequence.seq % divisor == 0;
@@ -336,6 +387,7 @@ void VSyncPredictor::setRenderRate(Fps fps) {
     ALOGV("%s %s: %s", __func__, to_string(mId).c_str(), to_string(fps).c_str());
     std::lock_guard lock(mMutex);
     mRenderRate = fps;
+    publishSnapshotLocked();
 }
 
 VSyncPredictor::Model VSyncPredictor::getVSyncPredictionModel() const {
@@ -364,9 +416,11 @@ void VSyncPredictor::setPeriod(nsecs_t period) {
     }
 
     clearTimestamps();
+    publishSnapshotLocked();
 }
 
 void VSyncPredictor::clearTimestamps() {
+    mKalmanFilter.reset(mIdealPeriod);
     if (!mTimestamps.empty()) {
         auto const maxRb = *std::max_element(mTimestamps.begin(), mTimestamps.end());
         if (mKnownTimestamp) {
@@ -385,15 +439,33 @@ bool VSyncPredictor::needsMoreSamples() const {
     return mTimestamps.size() < kMinimumSamplesForPrediction;
 }
 
+float VSyncPredictor::getModelConfidence() const {
+    std::lock_guard lock(mMutex);
+    if (mTimestamps.size() < kMinimumSamplesForPrediction) {
+        return 0.f;
+    }
+    return mEstimator == Estimator::Kalman ? mKalmanFilter.getConfidence() : 1.f;
+}
+
 void VSyncPredictor::resetModel() {
     std::lock_guard lock(mMutex);
     mRateMap[mIdealPeriod] = {mIdealPeriod, 0};
     clearTimestamps();
+    publishSnapshotLocked();
 }
 
 void VSyncPredictor::dump(std::string& result) const {
     std::lock_guard lock(mMutex);
     StringAppendF(&result, "\tmIdealPeriod=%.2f\n", mIdealPeriod / 1e6f);
+    StringAppendF(&result, "\testimator=%s", ftl::enum_string(mEstimator).c_str());
+    if (mEstimator == Estimator::Kalman) {
+        StringAppendF(&result, " confidence=%.2f samples=%zu", mKalmanFilter.getConfidence(),
+                      mKalmanFilter.getSampleCount());
+    }
+    result.append("\n");
+    StringAppendF(&result, "\tsnapshot: lockedReads=%" PRIu64 " retries=%" PRIu64 "\n",
+                  mLockedReads.load(std::memory_order_relaxed),
+                  mSnapshotRetries.load(std::memory_order_relaxed));
     StringAppendF(&result, "\tRefresh Rate Map:\n");
     for (const auto& [idealPeriod, periodInterceptTuple] : mRateMap) {
         StringAppendF(&result,
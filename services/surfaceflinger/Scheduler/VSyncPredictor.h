@@ -16,11 +16,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
+#include <scheduler/SeqLock.h>
+#include <scheduler/VsyncEstimators.h>
 #include <ui/DisplayId.h>
 
 #include "VSyncTracker.h"
@@ -29,6 +33,15 @@ namespace android::scheduler {
 
 class VSyncPredictor : public VSyncTracker {
 public:
+    enum class Estimator {
+        // Least squares fit over the timestamp history on every sample.
+        LeastSquares,
+        // Streaming Kalman filter, see VsyncKalmanFilter.
+        Kalman,
+
+        ftl_last = Kalman
+    };
+
     /*
      * \param [in] PhysicalDisplayid The display this corresponds to.
      * \param [in] idealPeriod  The initial ideal period to use.
@@ -36,9 +49,11 @@ public:
      * \param [in] minimumSamplesForPrediction The minimum number of samples to collect before
      * predicting. \param [in] outlierTolerancePercent a number 0 to 100 that will be used to filter
      * samples that fall outlierTolerancePercent from an anticipated vsync event.
+     * \param [in] estimator How the model is fit to the timestamps.
      */
     VSyncPredictor(PhysicalDisplayId, nsecs_t idealPeriod, size_t historySize,
-                   size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent);
+                   size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent,
+                   Estimator estimator = Estimator::LeastSquares);
     ~VSyncPredictor();
 
     bool addVsyncTimestamp(nsecs_t timestamp) final EXCLUDES(mMutex);
@@ -67,6 +82,12 @@ public:
 
     VSyncPredictor::Model getVSyncPredictionModel() const EXCLUDES(mMutex);
 
+    /* How much the current model can be trusted, from 0 to 1.
+     * For the Kalman estimator this reflects the uncertainty of the estimated period and recent
+     * outliers; for least squares, only whether enough samples have been collected.
+     */
+    float getModelConfidence() const EXCLUDES(mMutex);
+
     bool isVSyncInPhase(nsecs_t timePoint, Fps frameRate) const final EXCLUDES(mMutex);
 
     void setRenderRate(Fps) final EXCLUDES(mMutex);
@@ -83,36 +104,72 @@ private:
     inline void traceInt64If(const char* name, int64_t value) const;
     inline void traceInt64(const char* name, int64_t value) const;
 
-    size_t next(size_t i) const REQUIRES(mMutex);
-    bool validate(nsecs_t timestamp) const REQUIRES(mMutex);
-    Model getVSyncPredictionModelLocked() const REQUIRES(mMutex);
-    nsecs_t nextAnticipatedVSyncTimeFromLocked(nsecs_t timePoint) const REQUIRES(mMutex);
-    bool isVSyncInPhaseLocked(nsecs_t timePoint, unsigned divisor) const REQUIRES(mMutex);
-
     struct VsyncSequence {
         nsecs_t vsyncTime;
         int64_t seq;
     };
-    VsyncSequence getVsyncSequenceLocked(nsecs_t timestamp) const REQUIRES(mMutex);
+
+    // Everything needed to predict vsyncs, published on every change so that readers do not need
+    // to take mMutex.
+    struct ModelSnapshot {
+        Model model;
+        nsecs_t idealPeriod;
+        // The oldest timestamp in the history, which the model is relative to. Unset if there is
+        // no history, in which case predictions are made from knownTimestamp and idealPeriod.
+        std::optional<nsecs_t> oldestTimestamp;
+        std::optional<nsecs_t> knownTimestamp;
+        // Divisor of the refresh rate for the render rate, or 0 if there is none.
+        int renderRateDivisor;
+        std::optional<VsyncSequence> lastVsyncSequence;
+    };
+
+    size_t next(size_t i) const REQUIRES(mMutex);
+    bool validate(nsecs_t timestamp) const REQUIRES(mMutex);
+    bool addVsyncTimestampLocked(nsecs_t timestamp) REQUIRES(mMutex);
+    void rejectTimestamp(nsecs_t timestamp) REQUIRES(mMutex);
+    std::optional<Model> fitLeastSquaresModel() const REQUIRES(mMutex);
+    Model getKalmanModel() const REQUIRES(mMutex);
+    Model getVSyncPredictionModelLocked() const REQUIRES(mMutex);
+
+    ModelSnapshot makeSnapshotLocked() const REQUIRES(mMutex);
+    void publishSnapshotLocked() const REQUIRES(mMutex);
+    // Returns nullopt if the snapshot kept changing while being read.
+    std::optional<ModelSnapshot> loadSnapshot() const;
+
+    nsecs_t nextAnticipatedVSyncTimeFrom(const ModelSnapshot&, nsecs_t timePoint) const;
+    VsyncSequence getVsyncSequence(const ModelSnapshot&, nsecs_t timestamp) const;
+    // The first vsync at or after `vsync` that is in phase with the render rate.
+    nsecs_t nextRenderRateVSyncTime(const ModelSnapshot&, VsyncSequence vsync) const;
+    bool isVSyncInPhase(const ModelSnapshot&, nsecs_t timePoint, unsigned divisor) const;
 
     bool const mTraceOn;
     size_t const kHistorySize;
     size_t const kMinimumSamplesForPrediction;
     size_t const kOutlierTolerancePercent;
+    Estimator const mEstimator;
     std::mutex mutable mMutex;
 
     nsecs_t mIdealPeriod GUARDED_BY(mMutex);
     std::optional<nsecs_t> mKnownTimestamp GUARDED_BY(mMutex);
 
     // Map between ideal vsync period and the calculated model
-    std::unordered_map<nsecs_t, Model> mutable mRateMap GUARDED_BY(mMutex);
+    std::unordered_map<nsecs_t, Model> mRateMap GUARDED_BY(mMutex);
 
     size_t mLastTimestampIndex GUARDED_BY(mMutex) = 0;
     std::vector<nsecs_t> mTimestamps GUARDED_BY(mMutex);
 
+    // Only updated with Estimator::Kalman.
+    VsyncKalmanFilter mKalmanFilter GUARDED_BY(mMutex);
+
     std::optional<Fps> mRenderRate GUARDED_BY(mMutex);
 
+    // The reference point for vsync sequence numbers.
     mutable std::optional<VsyncSequence> mLastVsyncSequence GUARDED_BY(mMutex);
+
+    mutable SeqLock<ModelSnapshot> mSnapshot;
+    // Reads that overlapped a publish, and reads that fell back to taking mMutex.
+    mutable std::atomic<uint64_t> mSnapshotRetries = 0;
+    mutable std::atomic<uint64_t> mLockedReads = 0;
 };
 
 } // namespace android::scheduler
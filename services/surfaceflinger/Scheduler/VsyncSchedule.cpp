@@ -16,6 +16,8 @@
 
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <android-base/properties.h>
+#include <ftl/concat.h>
 #include <ftl/fake_guard.h>
 #include <scheduler/Fps.h>
 #include <scheduler/Timer.h>
@@ -98,6 +100,28 @@ void VsyncSchedule::dump(std::string& out) const {
     mDispatch->dump(out);
 }
 
+namespace {
+
+// "kalman" selects the streaming estimator. debug.sf.vsync_estimator.<port> overrides
+// debug.sf.vsync_estimator for the display on that port.
+VSyncPredictor::Estimator getEstimator(PhysicalDisplayId id) {
+    const std::string defaultEstimator = base::GetProperty("debug.sf.vsync_estimator", "");
+    const ftl::Concat displayProperty("debug.sf.vsync_estimator.",
+                                      static_cast<unsigned>(id.getPort()));
+    const std::string estimator = base::GetProperty(displayProperty.str(), defaultEstimator);
+    return estimator == "kalman" ? VSyncPredictor::Estimator::Kalman
+                                 : VSyncPredictor::Estimator::LeastSquares;
+}
+
+// "heap" keeps pending wakeups in a min-heap, which suits displays with many callbacks.
+VSyncDispatchTimerQueue::Backend getDispatchBackend() {
+    return base::GetProperty("debug.sf.vsync_dispatch_backend", "") == "heap"
+            ? VSyncDispatchTimerQueue::Backend::Heap
+            : VSyncDispatchTimerQueue::Backend::Scan;
+}
+
+} // namespace
+
 VsyncSchedule::TrackerPtr VsyncSchedule::createTracker(PhysicalDisplayId id) {
     // TODO(b/144707443): Tune constants.
     constexpr nsecs_t kInitialPeriod = (60_Hz).getPeriodNsecs();
@@ -106,7 +130,8 @@ VsyncSchedule::TrackerPtr VsyncSchedule::createTracker(PhysicalDisplayId id) {
     constexpr uint32_t kDiscardOutlierPercent = 20;
 
     return std::make_unique<VSyncPredictor>(id, kInitialPeriod, kHistorySize,
-                                            kMinSamplesForPrediction, kDiscardOutlierPercent);
+                                            kMinSamplesForPrediction, kDiscardOutlierPercent,
+                                            getEstimator(id));
 }
 
 VsyncSchedule::DispatchPtr VsyncSchedule::createDispatch(TrackerPtr tracker) {
@@ -118,7 +143,8 @@ VsyncSchedule::DispatchPtr VsyncSchedule::createDispatch(TrackerPtr tracker) {
 
     return std::make_unique<VSyncDispatchTimerQueue>(std::make_unique<Timer>(), std::move(tracker),
                                                      kGroupDispatchWithin.count(),
-                                                     kSnapToSameVsyncWithin.count());
+                                                     kSnapToSameVsyncWithin.count(),
+                                                     getDispatchBackend());
 }
 
 VsyncSchedule::ControllerPtr VsyncSchedule::createController(PhysicalDisplayId id,
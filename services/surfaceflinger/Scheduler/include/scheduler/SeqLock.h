@@ -0,0 +1,88 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+namespace android::scheduler {
+
+// Publishes a small value from one writer to any number of readers without locking. Readers never
+// block the writer; a read that overlaps a write fails, and the reader retries or falls back.
+//
+// Writes must be serialized externally, typically by the mutex that guards the source of the
+// value. The value is stored as atomic words, so readers never race with the writer on memory.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(std::is_default_constructible_v<T>);
+
+    static constexpr size_t kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    using Words = std::array<uint64_t, kWordCount>;
+
+public:
+    SeqLock() { store(T{}); }
+    explicit SeqLock(const T& value) { store(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    void store(const T& value) {
+        Words words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        // An odd sequence marks a write in progress. Storing the words with release semantics
+        // orders the odd sequence before them, so a reader that sees any new word also sees
+        // that the sequence changed.
+        const uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        for (size_t i = 0; i < kWordCount; i++) {
+            mWords[i].store(words[i], std::memory_order_release);
+        }
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Returns nullopt if the read overlapped a write.
+    std::optional<T> tryLoad() const {
+        const uint32_t sequence = mSequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            return std::nullopt;
+        }
+
+        Words words;
+        for (size_t i = 0; i < kWordCount; i++) {
+            words[i] = mWords[i].load(std::memory_order_acquire);
+        }
+        if (mSequence.load(std::memory_order_relaxed) != sequence) {
+            return std::nullopt;
+        }
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> mSequence = 0;
+    std::array<std::atomic<uint64_t>, kWordCount> mWords;
+};
+
+} // namespace android::scheduler
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+
+#include <utils/Timers.h>
+
+namespace android::scheduler {
+
+// A vsync model: vsync N after `origin` is predicted at origin + intercept + N * slope.
+struct VsyncModelFit {
+    nsecs_t slope;
+    nsecs_t intercept;
+};
+
+// Ordinary least squares fit of vsync timestamps over their ordinals, which are found by snapping
+// each timestamp to `currentPeriod`. Timestamps are taken relative to `oldest`, which the returned
+// intercept is relative to as well. Returns nullopt if the ordinals are degenerate. O(n).
+std::optional<VsyncModelFit> fitVsyncLeastSquares(std::span<const nsecs_t> timestamps,
+                                                  nsecs_t oldest, nsecs_t currentPeriod);
+
+// Streaming estimate of the vsync period and phase, updated in O(1) per timestamp.
+//
+// The state is the time of the latest vsync and the period, tracked with a two-state Kalman
+// filter. Samples are matched to the vsync they most likely belong to, so missed vsyncs are fine.
+// The filter is robust to jitter in two ways: samples whose innovation is moderately large are
+// down-weighted (Huber weighting) instead of pulling the model, and samples far outside the
+// predicted distribution are rejected. Consecutive rejections mean the display changed its
+// timing, and restart the filter from the latest sample.
+class VsyncKalmanFilter {
+public:
+    struct Params {
+        // Standard deviation of a HW vsync timestamp around the true vsync.
+        nsecs_t timestampStdDev = us2ns(100);
+        // Per-vsync standard deviation of phase and period drift.
+        double phaseDriftStdDev = 5'000;
+        double periodDriftStdDev = 50;
+        // Innovations beyond this many standard deviations are down-weighted...
+        double huberThreshold = 2.0;
+        // ...and beyond this many, rejected.
+        double rejectThreshold = 6.0;
+        size_t maxConsecutiveRejections = 3;
+    };
+
+    enum class Result { Initialized, Accepted, DownWeighted, Rejected };
+
+    explicit VsyncKalmanFilter(nsecs_t idealPeriod) : VsyncKalmanFilter(idealPeriod, Params()) {}
+    VsyncKalmanFilter(nsecs_t idealPeriod, Params);
+
+    void reset(nsecs_t idealPeriod);
+    Result update(nsecs_t timestamp);
+
+    bool isInitialized() const { return mSampleCount > 0; }
+    size_t getSampleCount() const { return mSampleCount; }
+
+    // The estimated vsync period.
+    nsecs_t getPeriod() const;
+    // The estimated time of the vsync closest to the latest accepted sample.
+    nsecs_t getLastVsyncTime() const;
+    // The model relative to `origin`, for comparison with fitVsyncLeastSquares.
+    VsyncModelFit getModel(nsecs_t origin) const;
+
+    // How settled the model is, from 0 to 1. Derived from the uncertainty of the period and the
+    // recent rate of rejected samples.
+    float getConfidence() const;
+
+private:
+    void initialize(nsecs_t timestamp);
+
+    const Params mParams;
+    nsecs_t mIdealPeriod;
+
+    // mPhase is relative to mOrigin, and re-based after every update to keep it small enough for
+    // sub-nanosecond precision in a double.
+    nsecs_t mOrigin = 0;
+    double mPhase = 0;
+    double mPeriod = 0;
+
+    // Covariance of (phase, period).
+    double mPhaseVar = 0;
+    double mCovariance = 0;
+    double mPeriodVar = 0;
+
+    size_t mSampleCount = 0;
+    size_t mConsecutiveRejections = 0;
+    // Exponentially weighted fraction of rejected samples.
+    double mRejectionRate = 0;
+};
+
+} // namespace android::scheduler
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <utils/Timers.h>
+
+namespace android::scheduler {
+
+// Min-heap of wakeup times for a set of keys, with at most one wakeup per key. Setting, clearing
+// and popping a wakeup are O(log n), and finding the earliest is O(1).
+//
+// Keys are tracked for as long as they may be scheduled, and memory is only allocated when a key
+// is tracked, so that scheduling in steady state does not allocate. Ties are broken by key, which
+// must be ordered, so that the order of wakeups is deterministic.
+template <typename Key, typename Hash = std::hash<Key>>
+class WakeupHeap {
+public:
+    struct Wakeup {
+        nsecs_t time;
+        Key key;
+    };
+
+    void track(Key key) {
+        mPositions.emplace(key, kNotQueued);
+        mHeap.reserve(mPositions.size());
+    }
+
+    void untrack(Key key) {
+        clear(key);
+        mPositions.erase(key);
+    }
+
+    bool isTracked(Key key) const { return mPositions.count(key) > 0; }
+
+    // Schedules the wakeup for `key` at `time`, replacing any earlier one. `key` must be tracked.
+    void set(Key key, nsecs_t time) {
+        auto& position = mPositions.at(key);
+        if (position == kNotQueued) {
+            position = mHeap.size();
+            mHeap.push_back({time, key});
+            siftUp(position);
+            return;
+        }
+
+        const nsecs_t previous = mHeap[position].time;
+        mHeap[position].time = time;
+        if (time < previous) {
+            siftUp(position);
+        } else {
+            siftDown(position);
+        }
+    }
+
+    // Removes the wakeup for `key`, if any.
+    void clear(Key key) {
+        const auto it = mPositions.find(key);
+        if (it == mPositions.end() || it->second == kNotQueued) {
+            return;
+        }
+
+        const size_t position = std::exchange(it->second, kNotQueued);
+        const size_t last = mHeap.size() - 1;
+        if (position != last) {
+            move(last, position);
+            mHeap.pop_back();
+            siftDown(position);
+            siftUp(position);
+        } else {
+            mHeap.pop_back();
+        }
+    }
+
+    std::optional<nsecs_t> get(Key key) const {
+        const auto it = mPositions.find(key);
+        if (it == mPositions.end() || it->second == kNotQueued) {
+            return {};
+        }
+        return mHeap[it->second].time;
+    }
+
+    bool empty() const { return mHeap.empty(); }
+    size_t size() const { return mHeap.size(); }
+
+    // The earliest wakeup. The heap must not be empty.
+    const Wakeup& top() const { return mHeap.front(); }
+
+    Wakeup pop() {
+        const Wakeup wakeup = mHeap.front();
+        clear(wakeup.key);
+        return wakeup;
+    }
+
+private:
+    static constexpr size_t kNotQueued = std::numeric_limits<size_t>::max();
+
+    static bool before(const Wakeup& lhs, const Wakeup& rhs) {
+        return lhs.time < rhs.time || (lhs.time == rhs.time && lhs.key < rhs.key);
+    }
+
+    void move(size_t from, size_t to) {
+        mHeap[to] = mHeap[from];
+        mPositions[mHeap[to].key] = to;
+    }
+
+    void place(size_t position, const Wakeup& wakeup) {
+        mHeap[position] = wakeup;
+        mPositions[wakeup.key] = position;
+    }
+
+    void siftUp(size_t position) {
+        const Wakeup wakeup = mHeap[position];
+        while (position > 0) {
+            const size_t parent = (position - 1) / 2;
+            if (!before(wakeup, mHeap[parent])) break;
+            move(parent, position);
+            position = parent;
+        }
+        place(position, wakeup);
+    }
+
+    void siftDown(size_t position) {
+        const Wakeup wakeup = mHeap[position];
+        const size_t size = mHeap.size();
+        for (;;) {
+            size_t child = 2 * position + 1;
+            if (child >= size) break;
+            if (child + 1 < size && before(mHeap[child + 1], mHeap[child])) child++;
+            if (!before(mHeap[child], wakeup)) break;
+            move(child, position);
+            position = child;
+        }
+        place(position, wakeup);
+    }
+
+    std::vector<Wakeup> mHeap;
+    std::unordered_map<Key, size_t, Hash> mPositions;
+};
+
+} // namespace android::scheduler
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <scheduler/VsyncEstimators.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace android::scheduler {
+
+std::optional<VsyncModelFit> fitVsyncLeastSquares(std::span<const nsecs_t> timestamps,
+                                                  nsecs_t oldest, nsecs_t currentPeriod) {
+    // This is a 'simple linear regression' calculation of Y over X, with Y being the
+    // vsync timestamps, and X being the ordinal of vsync count.
+    // The calculated slope is the vsync period.
+    // Formula for reference:
+    // Sigma_i: means sum over all timestamps.
+    // mean(variable): statistical mean of variable.
+    // X: snapped ordinal of the timestamp
+    // Y: vsync timestamp
+    //
+    //         Sigma_i( (X_i - mean(X)) * (Y_i - mean(Y) )
+    // slope = -------------------------------------------
+    //         Sigma_i ( X_i - mean(X) ) ^ 2
+    //
+    // intercept = mean(Y) - slope * mean(X)
+    //
+    // Two passes over the timestamps avoid keeping a normalized copy of them.
+    const size_t numSamples = timestamps.size();
+    if (numSamples == 0) {
+        return std::nullopt;
+    }
+
+    // The mean of the ordinals must be precise for the intercept calculation, so scale them up for
+    // fixed-point arithmetic.
+    constexpr int64_t kScalingFactor = 1000;
+
+    const auto ordinalOf = [currentPeriod](nsecs_t timestamp) -> nsecs_t {
+        return currentPeriod == 0
+                ? 0
+                : (timestamp + currentPeriod / 2) / currentPeriod * kScalingFactor;
+    };
+
+    // Normalizing to the oldest timestamp cuts down on error in calculating the intercept.
+    nsecs_t meanTS = 0;
+    nsecs_t meanOrdinal = 0;
+    for (const nsecs_t timestamp : timestamps) {
+        const nsecs_t normalized = timestamp - oldest;
+        meanTS += normalized;
+        meanOrdinal += ordinalOf(normalized);
+    }
+
+    meanTS /= static_cast<nsecs_t>(numSamples);
+    meanOrdinal /= static_cast<nsecs_t>(numSamples);
+
+    nsecs_t top = 0;
+    nsecs_t bottom = 0;
+    for (const nsecs_t timestamp : timestamps) {
+        const nsecs_t normalized = timestamp - oldest;
+        const nsecs_t ts = normalized - meanTS;
+        const nsecs_t ordinal = ordinalOf(normalized) - meanOrdinal;
+        top += ts * ordinal;
+        bottom += ordinal * ordinal;
+    }
+
+    if (bottom == 0) {
+        return std::nullopt;
+    }
+
+    const nsecs_t slope = top * kScalingFactor / bottom;
+    const nsecs_t intercept = meanTS - (slope * meanOrdinal / kScalingFactor);
+    return VsyncModelFit{slope, intercept};
+}
+
+VsyncKalmanFilter::VsyncKalmanFilter(nsecs_t idealPeriod, Params params)
+      : mParams(params), mIdealPeriod(idealPeriod) {}
+
+void VsyncKalmanFilter::reset(nsecs_t idealPeriod) {
+    mIdealPeriod = idealPeriod;
+    mSampleCount = 0;
+    mConsecutiveRejections = 0;
+    mRejectionRate = 0;
+}
+
+void VsyncKalmanFilter::initialize(nsecs_t timestamp) {
+    // The period starts at the ideal period, with an uncertainty of 1%.
+    constexpr double kInitialPeriodUncertainty = 0.01;
+    const double timestampVar =
+            static_cast<double>(mParams.timestampStdDev) * mParams.timestampStdDev;
+    const double periodStdDev = static_cast<double>(mIdealPeriod) * kInitialPeriodUncertainty;
+
+    mOrigin = timestamp;
+    mPhase = 0;
+    mPeriod = static_cast<double>(mIdealPeriod);
+    mPhaseVar = timestampVar;
+    mCovariance = 0;
+    mPeriodVar = periodStdDev * periodStdDev;
+    mSampleCount = 1;
+    mConsecutiveRejections = 0;
+}
+
+auto VsyncKalmanFilter::update(nsecs_t timestamp) -> Result {
+    if (!isInitialized()) {
+        initialize(timestamp);
+        return Result::Initialized;
+    }
+
+    // Match the sample to the vsync it most likely belongs to.
+    const double sinceLastVsync = static_cast<double>(timestamp - mOrigin) - mPhase;
+    const double steps = std::round(sinceLastVsync / mPeriod);
+
+    // Rejections feed an exponentially weighted rate over roughly the last 16 samples.
+    constexpr double kRejectionRateAlpha = 1.0 / 16;
+    const auto reject = [&] {
+        mRejectionRate += kRejectionRateAlpha * (1.0 - mRejectionRate);
+        if (++mConsecutiveRejections > mParams.maxConsecutiveRejections) {
+            const double rejectionRate = mRejectionRate;
+            initialize(timestamp);
+            mRejectionRate = rejectionRate;
+            return Result::Initialized;
+        }
+        return Result::Rejected;
+    };
+
+    if (steps < 1) {
+        // A duplicate of the last vsync, or a timestamp from the past.
+        return reject();
+    }
+
+    // Predict: phase advances by `steps` periods, and both states drift per elapsed vsync.
+    const double phaseDriftVar = mParams.phaseDriftStdDev * mParams.phaseDriftStdDev;
+    const double periodDriftVar = mParams.periodDriftStdDev * mParams.periodDriftStdDev;
+    const double predictedPhase = mPhase + steps * mPeriod;
+    const double phaseVar = mPhaseVar + 2 * steps * mCovariance + steps * steps * mPeriodVar +
+            steps * phaseDriftVar;
+    const double covariance = mCovariance + steps * mPeriodVar;
+    const double periodVar = mPeriodVar + steps * periodDriftVar;
+
+    const double innovation = static_cast<double>(timestamp - mOrigin) - predictedPhase;
+    double measurementVar =
+            static_cast<double>(mParams.timestampStdDev) * mParams.timestampStdDev;
+    const double innovationStdDev = std::sqrt(phaseVar + measurementVar);
+    const double normalized = std::abs(innovation) / innovationStdDev;
+
+    // Gate only once the period has settled; until then large innovations are expected.
+    constexpr size_t kMinSamplesForGating = 3;
+    if (mSampleCount >= kMinSamplesForGating && normalized > mParams.rejectThreshold) {
+        return reject();
+    }
+
+    Result result = Result::Accepted;
+    if (normalized > mParams.huberThreshold) {
+        // Huber weighting: the sample's influence grows linearly rather than quadratically.
+        measurementVar *= normalized / mParams.huberThreshold;
+        result = Result::DownWeighted;
+    }
+
+    const double innovationVar = phaseVar + measurementVar;
+    const double phaseGain = phaseVar / innovationVar;
+    const double periodGain = covariance / innovationVar;
+
+    mPhase = predictedPhase + phaseGain * innovation;
+    mPeriod += periodGain * innovation;
+    mPhaseVar = (1 - phaseGain) * phaseVar;
+    mCovariance = (1 - phaseGain) * covariance;
+    mPeriodVar = periodVar - periodGain * covariance;
+
+    // Re-base so that mPhase stays within a nanosecond of mOrigin.
+    const auto whole = static_cast<nsecs_t>(std::floor(mPhase));
+    mOrigin += whole;
+    mPhase -= static_cast<double>(whole);
+
+    mSampleCount++;
+    mConsecutiveRejections = 0;
+    mRejectionRate -= kRejectionRateAlpha * mRejectionRate;
+    return result;
+}
+
+nsecs_t VsyncKalmanFilter::getPeriod() const {
+    return isInitialized() ? static_cast<nsecs_t>(std::llround(mPeriod)) : mIdealPeriod;
+}
+
+nsecs_t VsyncKalmanFilter::getLastVsyncTime() const {
+    return mOrigin + static_cast<nsecs_t>(std::llround(mPhase));
+}
+
+VsyncModelFit VsyncKalmanFilter::getModel(nsecs_t origin) const {
+    const nsecs_t period = getPeriod();
+    if (!isInitialized() || period <= 0) {
+        return {period, 0};
+    }
+
+    // The offset of the vsync grid from `origin`, within half a period.
+    const nsecs_t offset = getLastVsyncTime() - origin;
+    const nsecs_t ordinal = (offset >= 0 ? offset + period / 2 : offset - period / 2) / period;
+    return {period, offset - ordinal * period};
+}
+
+float VsyncKalmanFilter::getConfidence() const {
+    if (mSampleCount < 2) {
+        return 0.f;
+    }
+
+    // A period uncertainty of 0.1% of the period or more means no confidence.
+    constexpr double kPeriodStdDevForZeroConfidence = 1e-3;
+    const double periodStdDev = std::sqrt(std::max(mPeriodVar, 0.0));
+    const double settled =
+            1.0 - periodStdDev / (mPeriod * kPeriodStdDevForZeroConfidence);
+    return static_cast<float>(std::clamp(settled, 0.0, 1.0) * (1.0 - mRejectionRate));
+}
+
+} // namespace android::scheduler
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <scheduler/SeqLock.h>
+
+namespace android::scheduler {
+namespace {
+
+// Not a multiple of the word size, and every field derives from `value` so torn reads show.
+struct Value {
+    int64_t value = 0;
+    int64_t doubled = 0;
+    std::optional<int32_t> negated;
+    bool odd = false;
+};
+
+Value makeValue(int64_t value) {
+    return {value, value * 2, static_cast<int32_t>(-value), value % 2 != 0};
+}
+
+TEST(SeqLockTest, loadsInitialValue) {
+    const SeqLock<Value> defaulted;
+    const auto value = defaulted.tryLoad();
+    ASSERT_TRUE(value);
+    EXPECT_EQ(0, value->value);
+    EXPECT_FALSE(value->negated);
+
+    const SeqLock<Value> initialized(makeValue(7));
+    EXPECT_EQ(14, initialized.tryLoad()->doubled);
+}
+
+TEST(SeqLockTest, loadsLatestStore) {
+    SeqLock<Value> lock;
+    for (int64_t i = 1; i <= 3; i++) {
+        lock.store(makeValue(i));
+        const auto value = lock.tryLoad();
+        ASSERT_TRUE(value);
+        EXPECT_EQ(i, value->value);
+        EXPECT_EQ(-i, value->negated);
+    }
+}
+
+TEST(SeqLockTest, readsAreNeverTorn) {
+    SeqLock<Value> lock(makeValue(0));
+    constexpr int64_t kStores = 200'000;
+    std::atomic<bool> done = false;
+
+    std::vector<std::thread> readers;
+    std::atomic<int64_t> failures = 0;
+    for (int i = 0; i < 3; i++) {
+        readers.emplace_back([&] {
+            int64_t last = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                const auto value = lock.tryLoad();
+                if (!value) continue;
+
+                const auto expected = makeValue(value->value);
+                if (value->doubled != expected.doubled || value->negated != expected.negated ||
+                    value->odd != expected.odd || value->value < last) {
+                    failures++;
+                }
+                last = value->value;
+            }
+        });
+    }
+
+    for (int64_t i = 1; i <= kStores; i++) {
+        lock.store(makeValue(i));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(0, failures);
+    EXPECT_EQ(kStores, lock.tryLoad()->value);
+}
+
+} // namespace
+} // namespace android::scheduler
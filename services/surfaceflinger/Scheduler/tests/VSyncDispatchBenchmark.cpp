@@ -0,0 +1,197 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <scheduler/TimeKeeper.h>
+
+#include "Scheduler/VSyncDispatchTimerQueue.h"
+#include "Scheduler/VSyncTracker.h"
+
+namespace android::scheduler {
+namespace {
+
+using Backend = VSyncDispatchTimerQueue::Backend;
+
+constexpr nsecs_t kPeriod = 16'666'667;
+constexpr nsecs_t kTimerSlack = 500'000;
+constexpr nsecs_t kVsyncMoveThreshold = 3'000'000;
+
+// Time only moves when the benchmark fires the alarm.
+class FakeTimeKeeper : public TimeKeeper {
+public:
+    explicit FakeTimeKeeper(nsecs_t& now) : mNow(now) {}
+
+    nsecs_t now() const override { return mNow; }
+
+    void alarmAt(std::function<void()> callback, nsecs_t time) override {
+        mCallback = std::move(callback);
+        mAlarm = time;
+    }
+
+    void alarmCancel() override { mCallback = nullptr; }
+    void dump(std::string&) const override {}
+
+    bool fire() {
+        if (!mCallback) return false;
+        mNow = std::max(mNow, mAlarm);
+        std::exchange(mCallback, nullptr)();
+        return true;
+    }
+
+private:
+    nsecs_t& mNow;
+    nsecs_t mAlarm = 0;
+    std::function<void()> mCallback;
+};
+
+class FixedRateTracker : public VSyncTracker {
+public:
+    bool addVsyncTimestamp(nsecs_t) override { return true; }
+
+    nsecs_t nextAnticipatedVSyncTimeFrom(nsecs_t timePoint) const override {
+        return (timePoint + kPeriod - 1) / kPeriod * kPeriod;
+    }
+
+    nsecs_t currentPeriod() const override { return kPeriod; }
+    void setPeriod(nsecs_t) override {}
+    void resetModel() override {}
+    bool needsMoreSamples() const override { return false; }
+    bool isVSyncInPhase(nsecs_t, Fps) const override { return true; }
+    void setRenderRate(Fps) override {}
+    void dump(std::string&) const override {}
+};
+
+class DispatchFixture {
+public:
+    DispatchFixture(Backend backend, size_t callbackCount)
+          : mTimeKeeper(new FakeTimeKeeper(mNow)),
+            mDispatch(std::unique_ptr<TimeKeeper>(mTimeKeeper),
+                      std::make_shared<FixedRateTracker>(), kTimerSlack, kVsyncMoveThreshold,
+                      backend) {
+        for (size_t i = 0; i < callbackCount; i++) {
+            mTokens.push_back(mDispatch.registerCallback([this](nsecs_t, nsecs_t,
+                                                                nsecs_t) { mDispatched++; },
+                                                         "callback" + std::to_string(i)));
+        }
+    }
+
+    ~DispatchFixture() {
+        for (const auto token : mTokens) {
+            mDispatch.unregisterCallback(token);
+        }
+    }
+
+    // Spreads the wakeups of the callbacks across most of a frame.
+    VSyncDispatch::ScheduleTiming timing(size_t index, nsecs_t jitter = 0) const {
+        const nsecs_t spread = kPeriod / 2 / static_cast<nsecs_t>(mTokens.size());
+        return {.workDuration = kPeriod / 4 + static_cast<nsecs_t>(index) * spread + jitter,
+                .readyDuration = 0,
+                .earliestVsync = mNow + kPeriod};
+    }
+
+    nsecs_t mNow = 0;
+    FakeTimeKeeper* const mTimeKeeper;
+    VSyncDispatchTimerQueue mDispatch;
+    std::vector<VSyncDispatch::CallbackToken> mTokens;
+    size_t mDispatched = 0;
+};
+
+// Reschedules one callback at a time while all the others are pending, nudging its wakeup earlier
+// or later. This is the cost paid on every frame request.
+void BM_ScheduleWhilePending(benchmark::State& state, Backend backend) {
+    const auto callbackCount = static_cast<size_t>(state.range(0));
+    DispatchFixture fixture(backend, callbackCount);
+    for (size_t i = 0; i < callbackCount; i++) {
+        fixture.mDispatch.schedule(fixture.mTokens[i], fixture.timing(i));
+    }
+
+    size_t index = 0;
+    bool early = false;
+    for (auto _ : state) {
+        const nsecs_t jitter = early ? kPeriod / 16 : -kPeriod / 16;
+        benchmark::DoNotOptimize(
+                fixture.mDispatch.schedule(fixture.mTokens[index], fixture.timing(index, jitter)));
+        index = (index + 1) % callbackCount;
+        early = !early;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Cancels and reschedules the earliest callback, which forces a rearm on every operation.
+void BM_CancelEarliest(benchmark::State& state, Backend backend) {
+    const auto callbackCount = static_cast<size_t>(state.range(0));
+    DispatchFixture fixture(backend, callbackCount);
+    for (size_t i = 0; i < callbackCount; i++) {
+        fixture.mDispatch.schedule(fixture.mTokens[i], fixture.timing(i));
+    }
+
+    // Wake up well ahead of the other callbacks, beyond the timer slack.
+    const auto earliest = fixture.mTokens.back();
+    const auto timing = fixture.timing(callbackCount - 1, kPeriod / 8);
+    fixture.mDispatch.schedule(earliest, timing);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.mDispatch.cancel(earliest));
+        benchmark::DoNotOptimize(fixture.mDispatch.schedule(earliest, timing));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+// Schedules every callback for the next vsync, then fires the timer until all are dispatched.
+void BM_DispatchFrame(benchmark::State& state, Backend backend) {
+    const auto callbackCount = static_cast<size_t>(state.range(0));
+    DispatchFixture fixture(backend, callbackCount);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < callbackCount; i++) {
+            fixture.mDispatch.schedule(fixture.mTokens[i], fixture.timing(i));
+        }
+        while (fixture.mTimeKeeper->fire()) {
+        }
+        fixture.mNow += kPeriod;
+    }
+
+    if (fixture.mDispatched != callbackCount * static_cast<size_t>(state.iterations())) {
+        state.SkipWithError("Not every callback was dispatched");
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(callbackCount));
+}
+
+void callbackCounts(benchmark::internal::Benchmark* benchmark) {
+    for (const int count : {10, 50, 100, 250, 500}) {
+        benchmark->Arg(count);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_ScheduleWhilePending, scan, Backend::Scan)->Apply(callbackCounts);
+BENCHMARK_CAPTURE(BM_ScheduleWhilePending, heap, Backend::Heap)->Apply(callbackCounts);
+BENCHMARK_CAPTURE(BM_CancelEarliest, scan, Backend::Scan)->Apply(callbackCounts);
+BENCHMARK_CAPTURE(BM_CancelEarliest, heap, Backend::Heap)->Apply(callbackCounts);
+BENCHMARK_CAPTURE(BM_DispatchFrame, scan, Backend::Scan)->Apply(callbackCounts);
+BENCHMARK_CAPTURE(BM_DispatchFrame, heap, Backend::Heap)->Apply(callbackCounts);
+
+} // namespace
+} // namespace android::scheduler
+
+BENCHMARK_MAIN();
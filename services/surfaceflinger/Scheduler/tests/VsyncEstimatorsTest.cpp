@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <scheduler/VsyncEstimators.h>
+
+namespace android::scheduler {
+namespace {
+
+constexpr nsecs_t kPeriod = 16'666'667;
+constexpr nsecs_t kStart = 1'000'000'000'000;
+
+// Deterministic jitter in [-amplitude, amplitude].
+class Jitter {
+public:
+    explicit Jitter(nsecs_t amplitude) : mAmplitude(amplitude) {}
+
+    nsecs_t next() {
+        mState = mState * 6364136223846793005ull + 1442695040888963407ull;
+        const auto unit = static_cast<double>(mState >> 11) / static_cast<double>(1ull << 53);
+        return static_cast<nsecs_t>((unit * 2 - 1) * static_cast<double>(mAmplitude));
+    }
+
+private:
+    const nsecs_t mAmplitude;
+    uint64_t mState = 42;
+};
+
+using Result = VsyncKalmanFilter::Result;
+
+TEST(VsyncEstimatorsTest, leastSquaresFitsPerfectTimestamps) {
+    std::vector<nsecs_t> timestamps;
+    for (int i = 0; i < 20; i++) {
+        timestamps.push_back(kStart + i * kPeriod);
+    }
+
+    const auto fit = fitVsyncLeastSquares(timestamps, kStart, kPeriod);
+    ASSERT_TRUE(fit);
+    EXPECT_EQ(kPeriod, fit->slope);
+    EXPECT_EQ(0, fit->intercept);
+}
+
+TEST(VsyncEstimatorsTest, leastSquaresRejectsDegenerateOrdinals) {
+    const std::vector<nsecs_t> timestamps = {kStart, kStart};
+    EXPECT_FALSE(fitVsyncLeastSquares(timestamps, kStart, kPeriod));
+    EXPECT_FALSE(fitVsyncLeastSquares({}, kStart, kPeriod));
+}
+
+TEST(VsyncEstimatorsTest, kalmanConvergesOnCleanTimestamps) {
+    constexpr nsecs_t kActualPeriod = kPeriod + 20'000;
+    VsyncKalmanFilter filter(kPeriod);
+    EXPECT_EQ(Result::Initialized, filter.update(kStart));
+    for (int i = 1; i < 100; i++) {
+        EXPECT_NE(Result::Rejected, filter.update(kStart + i * kActualPeriod)) << i;
+    }
+
+    EXPECT_NEAR(kActualPeriod, filter.getPeriod(), 100);
+    EXPECT_NEAR(kStart + 99 * kActualPeriod, filter.getLastVsyncTime(), 1000);
+    EXPECT_GT(filter.getConfidence(), 0.9f);
+}
+
+TEST(VsyncEstimatorsTest, kalmanToleratesJitter) {
+    Jitter jitter(us2ns(500));
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 200; i++) {
+        filter.update(kStart + i * kPeriod + jitter.next());
+    }
+
+    EXPECT_NEAR(kPeriod, filter.getPeriod(), us2ns(5));
+    EXPECT_NEAR(kStart + 199 * kPeriod, filter.getLastVsyncTime(), us2ns(300));
+    EXPECT_GT(filter.getConfidence(), 0.5f);
+}
+
+TEST(VsyncEstimatorsTest, kalmanRejectsOutliers) {
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 20; i++) {
+        filter.update(kStart + i * kPeriod);
+    }
+    const nsecs_t period = filter.getPeriod();
+    const nsecs_t lastVsync = filter.getLastVsyncTime();
+    const float confidence = filter.getConfidence();
+
+    EXPECT_EQ(Result::Rejected, filter.update(kStart + 20 * kPeriod + kPeriod * 2 / 5));
+    EXPECT_EQ(period, filter.getPeriod());
+    EXPECT_EQ(lastVsync, filter.getLastVsyncTime());
+    EXPECT_LT(filter.getConfidence(), confidence);
+
+    EXPECT_NE(Result::Rejected, filter.update(kStart + 20 * kPeriod));
+}
+
+TEST(VsyncEstimatorsTest, kalmanDownWeightsModerateOutliers) {
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 50; i++) {
+        filter.update(kStart + i * kPeriod);
+    }
+
+    EXPECT_EQ(Result::DownWeighted, filter.update(kStart + 50 * kPeriod + us2ns(400)));
+    EXPECT_NEAR(kPeriod, filter.getPeriod(), us2ns(2));
+}
+
+TEST(VsyncEstimatorsTest, kalmanHandlesMissedVsyncs) {
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 60; i += 3) {
+        EXPECT_NE(Result::Rejected, filter.update(kStart + i * kPeriod)) << i;
+    }
+    EXPECT_NEAR(kPeriod, filter.getPeriod(), 100);
+}
+
+TEST(VsyncEstimatorsTest, kalmanRestartsAfterConsecutiveRejections) {
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 20; i++) {
+        filter.update(kStart + i * kPeriod);
+    }
+
+    // The display shifted its phase by 40%.
+    const nsecs_t shifted = kStart + kPeriod * 2 / 5;
+    const size_t maxRejections = VsyncKalmanFilter::Params().maxConsecutiveRejections;
+    for (size_t i = 0; i < maxRejections; i++) {
+        EXPECT_EQ(Result::Rejected, filter.update(shifted + (20 + i) * kPeriod));
+    }
+    EXPECT_EQ(Result::Initialized, filter.update(shifted + (20 + maxRejections) * kPeriod));
+    EXPECT_EQ(shifted + (20 + maxRejections) * kPeriod, filter.getLastVsyncTime());
+}
+
+TEST(VsyncEstimatorsTest, kalmanModelMatchesLeastSquaresForm) {
+    constexpr nsecs_t kOffset = 3'000'000;
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 30; i++) {
+        filter.update(kStart + kOffset + i * kPeriod);
+    }
+
+    const auto model = filter.getModel(kStart);
+    EXPECT_NEAR(kPeriod, model.slope, 100);
+    EXPECT_NEAR(kOffset, model.intercept, 1000);
+    EXPECT_LE(std::abs(model.intercept), model.slope / 2);
+}
+
+TEST(VsyncEstimatorsTest, kalmanResetUsesNewIdealPeriod) {
+    constexpr nsecs_t kNewPeriod = 11'111'111;
+    VsyncKalmanFilter filter(kPeriod);
+    for (int i = 0; i < 20; i++) {
+        filter.update(kStart + i * kPeriod);
+    }
+
+    filter.reset(kNewPeriod);
+    EXPECT_FALSE(filter.isInitialized());
+    EXPECT_EQ(kNewPeriod, filter.getPeriod());
+    EXPECT_EQ(0.f, filter.getConfidence());
+
+    for (int i = 0; i < 50; i++) {
+        filter.update(kStart + i * kNewPeriod);
+    }
+    EXPECT_NEAR(kNewPeriod, filter.getPeriod(), 100);
+}
+
+} // namespace
+} // namespace android::scheduler
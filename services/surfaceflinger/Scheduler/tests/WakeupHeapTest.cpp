@@ -0,0 +1,147 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+
+#include <scheduler/WakeupHeap.h>
+
+namespace android::scheduler {
+namespace {
+
+using Heap = WakeupHeap<int>;
+
+TEST(WakeupHeapTest, popsInWakeupOrder) {
+    Heap heap;
+    for (int key = 0; key < 4; key++) {
+        heap.track(key);
+    }
+    heap.set(0, 300);
+    heap.set(1, 100);
+    heap.set(2, 400);
+    heap.set(3, 200);
+
+    ASSERT_EQ(4u, heap.size());
+    EXPECT_EQ(1, heap.pop().key);
+    EXPECT_EQ(3, heap.pop().key);
+    EXPECT_EQ(0, heap.pop().key);
+    EXPECT_EQ(2, heap.pop().key);
+    EXPECT_TRUE(heap.empty());
+}
+
+TEST(WakeupHeapTest, breaksTiesByKey) {
+    Heap heap;
+    for (int key : {5, 2, 9}) {
+        heap.track(key);
+        heap.set(key, 100);
+    }
+    EXPECT_EQ(2, heap.pop().key);
+    EXPECT_EQ(5, heap.pop().key);
+    EXPECT_EQ(9, heap.pop().key);
+}
+
+TEST(WakeupHeapTest, setReplacesWakeup) {
+    Heap heap;
+    heap.track(0);
+    heap.track(1);
+    heap.set(0, 100);
+    heap.set(1, 200);
+
+    heap.set(0, 300);
+    EXPECT_EQ(2u, heap.size());
+    EXPECT_EQ(1, heap.top().key);
+    EXPECT_EQ(300, heap.get(0));
+
+    heap.set(0, 50);
+    EXPECT_EQ(0, heap.top().key);
+}
+
+TEST(WakeupHeapTest, clearAndUntrack) {
+    Heap heap;
+    heap.track(0);
+    heap.track(1);
+    heap.set(0, 100);
+    heap.set(1, 200);
+
+    heap.clear(0);
+    EXPECT_FALSE(heap.get(0));
+    EXPECT_EQ(1, heap.top().key);
+
+    // Clearing twice, or clearing an untracked key, is a no-op.
+    heap.clear(0);
+    heap.clear(42);
+
+    heap.untrack(1);
+    EXPECT_FALSE(heap.isTracked(1));
+    EXPECT_TRUE(heap.isTracked(0));
+    EXPECT_TRUE(heap.empty());
+}
+
+TEST(WakeupHeapTest, matchesOrderedReference) {
+    constexpr int kKeys = 64;
+    Heap heap;
+    for (int key = 0; key < kKeys; key++) {
+        heap.track(key);
+    }
+
+    std::map<int, nsecs_t> wakeups;
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> keys(0, kKeys - 1);
+    std::uniform_int_distribution<nsecs_t> times(0, 1000);
+    std::uniform_int_distribution<int> operations(0, 3);
+
+    for (int i = 0; i < 10'000; i++) {
+        const int key = keys(generator);
+        switch (operations(generator)) {
+            case 0:
+            case 1: {
+                const nsecs_t time = times(generator);
+                heap.set(key, time);
+                wakeups[key] = time;
+                break;
+            }
+            case 2:
+                heap.clear(key);
+                wakeups.erase(key);
+                break;
+            case 3:
+                if (!wakeups.empty()) {
+                    const auto wakeup = heap.pop();
+                    EXPECT_EQ(wakeups.at(wakeup.key), wakeup.time);
+                    wakeups.erase(wakeup.key);
+                }
+                break;
+        }
+
+        ASSERT_EQ(wakeups.size(), heap.size());
+        if (!wakeups.empty()) {
+            std::set<std::pair<nsecs_t, int>> ordered;
+            for (const auto& [k, time] : wakeups) {
+                ordered.emplace(time, k);
+            }
+            EXPECT_EQ(ordered.begin()->first, heap.top().time);
+            EXPECT_EQ(ordered.begin()->second, heap.top().key);
+        }
+    }
+}
+
+} // namespace
+} // namespace android::scheduler
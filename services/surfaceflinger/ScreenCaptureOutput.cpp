@@ -76,6 +76,8 @@ renderengine::DisplaySettings ScreenCaptureOutput::generateClientCompositionDisp
     auto clientCompositionDisplay =
             compositionengine::impl::Output::generateClientCompositionDisplaySettings();
     clientCompositionDisplay.clip = mRenderArea.getSourceCrop();
+    // Screenshots and region sampling are not presented, so they may yield to composition.
+    clientCompositionDisplay.isDeferrable = true;
     return clientCompositionDisplay;
 }
 
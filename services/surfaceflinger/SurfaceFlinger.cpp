@@ -86,6 +86,7 @@
 #include <ui/DisplayStatInfo.h>
 #include <ui/DisplayState.h>
 #include <ui/DynamicDisplayInfo.h>
+#include <ui/FenceSignalWatcher.h>
 #include <ui/GraphicBufferAllocator.h>
 #include <ui/LayerStack.h>
 #include <ui/PixelFormat.h>
@@ -372,6 +373,8 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory, SkipInitializationTag)
         mTimeStats(std::make_shared<impl::TimeStats>()),
         mFrameTracer(mFactory.createFrameTracer()),
         mFrameTimeline(mFactory.createFrameTimeline(mTimeStats, mPid)),
+        mLayerCostTracker(std::make_unique<LayerCostTracker>(
+                base::GetBoolProperty("debug.sf.layer_costs"s, false))),
         mCompositionEngine(mFactory.createCompositionEngine()),
         mHwcServiceName(base::GetProperty("debug.sf.hwc_service_name"s, "default"s)),
         mTunnelModeEnabledReporter(sp<TunnelModeEnabledReporter>::make()),
@@ -455,9 +458,21 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
     property_get("debug.sf.predict_hwc_composition_strategy", value, "1");
     mPredictCompositionStrategy = atoi(value);
 
+    property_get("debug.sf.predict_skip_validate", value, "0");
+    mPredictSkipValidate = atoi(value);
+
+    property_get("debug.sf.hwc_buffer_cache_tracking", value, "0");
+    mHwcBufferCacheTracking = atoi(value);
+
     property_get("debug.sf.treat_170m_as_sRGB", value, "0");
     mTreat170mAsSrgb = atoi(value);
 
+    property_get("debug.sf.incremental_visible_regions", value, "0");
+    mIncrementalVisibleRegions = atoi(value);
+
+    property_get("debug.sf.parallel_output_present", value, "0");
+    mParallelOutputPresent = atoi(value);
+
     mIgnoreHwcPhysicalDisplayOrientation =
             base::GetBoolProperty("debug.sf.ignore_hwc_physical_display_orientation"s, false);
 
@@ -485,6 +500,12 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
 
     if (!mIsUserBuild && base::GetBoolProperty("debug.sf.enable_transaction_tracing"s, true)) {
         mTransactionTracing.emplace();
+        mTransactionTracing->setCompressionEnabled(
+                base::GetBoolProperty("debug.sf.transaction_trace_compression"s, false));
+        if (const auto path = base::GetProperty("debug.sf.transaction_trace_stream_path"s, ""s);
+            !path.empty()) {
+            mTransactionTracing->startStreaming(path);
+        }
     }
 
     mIgnoreHdrCameraLayers = ignore_hdr_camera_layers(false);
@@ -493,6 +514,20 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
             base::GetBoolProperty("persist.debug.sf.enable_layer_lifecycle_manager"s, false);
     mLegacyFrontEndEnabled = !mLayerLifecycleManagerEnabled ||
             base::GetBoolProperty("persist.debug.sf.enable_legacy_frontend"s, false);
+    mParallelSnapshotBuilderEnabled =
+            base::GetBoolProperty("debug.sf.frontend_parallel_snapshots"s, false);
+    mAsyncScreenshotsEnabled = mLayerLifecycleManagerEnabled &&
+            base::GetBoolProperty("debug.sf.async_screenshots"s, false);
+    mLayerTraceDeltasEnabled = !mLegacyFrontEndEnabled &&
+            base::GetBoolProperty("debug.sf.layer_trace_deltas"s, false);
+    if (!mLegacyFrontEndEnabled && base::GetBoolProperty("debug.sf.parallel_layer_proto"s, false)) {
+        constexpr unsigned kMaxLayerProtoThreads = 4;
+        mLayerProtoWorkerPool = std::make_unique<frontend::WorkerPool>(
+                std::clamp(std::thread::hardware_concurrency() / 2, 1u, kMaxLayerProtoThreads));
+    }
+    mTransactionHandler.setCoalescingEnabled(
+            base::GetBoolProperty("debug.sf.coalesce_transactions"s, false));
+    mEarlyModeSwitchEnabled = base::GetBoolProperty("debug.sf.early_mode_switch"s, false);
 }
 
 LatchUnsignaledConfig SurfaceFlinger::getLatchUnsignaledConfig() {
@@ -695,6 +730,7 @@ void SurfaceFlinger::bootFinished() {
 
     mFrameTracer->initialize();
     mFrameTimeline->onBootFinished();
+    mLayerCostTracker->onBootFinished();
     getRenderEngine().setEnableTracing(mFlagManager.use_skia_tracing());
 
     // wait patiently for the window manager death
@@ -827,6 +863,8 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
                            .setEnableProtectedContext(enable_protected_contents(false))
                            .setPrecacheToneMapperShaderOnly(false)
                            .setSupportsBackgroundBlur(mSupportsBlur)
+                           .setEnableBackgroundContext(base::GetBoolProperty(
+                                   PROPERTY_DEBUG_RENDERENGINE_BACKGROUND_CONTEXT, false))
                            .setContextPriority(
                                    useContextPriority
                                            ? renderengine::RenderEngine::ContextPriority::REALTIME
@@ -1217,6 +1255,25 @@ void SurfaceFlinger::setDesiredActiveMode(display::DisplayModeRequest&& request,
             mScheduler->modulateVsync(displayId, &VsyncModulator::onRefreshRateChangeInitiated);
             updatePhaseConfiguration(mode.fps);
             mScheduler->setModeChangePending(true);
+
+            mModeSwitchRequestTime = TimePoint::now();
+            mModeSwitchHwcLatency.reset();
+            if (mEarlyModeSwitchEnabled) {
+                // Call HWC as soon as the main thread is idle rather than on the next commit, so
+                // that the timeline of the switch starts up to a frame earlier.
+                static_cast<void>(mScheduler->schedule([this]() FTL_FAKE_GUARD(kMainThreadContext) {
+                    Mutex::Autolock lock(mStateLock);
+                    // The switch is already waiting for its present fence.
+                    if (mSetActiveModePending) return;
+                    setActiveModeInHwcIfNeeded();
+                    // The previous present fence is from before the switch, so the switch
+                    // waits for the fence of the next frame instead.
+                    if (mSetActiveModePending) {
+                        mSetActiveModeAwaitingFrame = true;
+                        mSetActiveModePresentFence.reset();
+                    }
+                }));
+            }
             break;
         case DisplayDevice::DesiredActiveModeAction::InitiateRenderRateSwitch:
             mScheduler->setRenderRate(displayId, mode.fps);
@@ -1329,6 +1386,7 @@ void SurfaceFlinger::updateInternalStateWithChangedMode() {
 
 void SurfaceFlinger::clearDesiredActiveModeState(const sp<DisplayDevice>& display) {
     display->clearDesiredActiveModeState();
+    mModeSwitchRequestTime.reset();
     if (display->getPhysicalId() == mActiveDisplayId) {
         mScheduler->setModeChangePending(false);
     }
@@ -1340,6 +1398,10 @@ void SurfaceFlinger::desiredActiveModeChangeDone(const sp<DisplayDevice>& displa
     const auto displayId = modeOpt->modePtr->getPhysicalDisplayId();
     const auto displayFps = modeOpt->modePtr->getFps();
     const auto renderFps = modeOpt->fps;
+    if (mModeSwitchRequestTime && mModeSwitchHwcLatency) {
+        mRefreshRateStats->recordModeSwitchLatency(*mModeSwitchHwcLatency,
+                                                   TimePoint::now() - *mModeSwitchRequestTime);
+    }
     clearDesiredActiveModeState(display);
     mScheduler->resyncToHardwareVsync(displayId, true /* allowToEnable */, displayFps);
     mScheduler->setRenderRate(displayId, renderFps);
@@ -1420,6 +1482,9 @@ void SurfaceFlinger::setActiveModeInHwcIfNeeded() {
             continue;
         }
 
+        if (mModeSwitchRequestTime) {
+            mModeSwitchHwcLatency = TimePoint::now() - *mModeSwitchRequestTime;
+        }
         display->refreshRateSelector().onModeChangeInitiated();
         mScheduler->onNewVsyncPeriodChangeTimeline(outTimeline);
 
@@ -1963,8 +2028,9 @@ status_t SurfaceFlinger::setDisplayBrightness(const sp<IBinder>& displayToken,
             .get();
 }
 
-status_t SurfaceFlinger::addHdrLayerInfoListener(const sp<IBinder>& displayToken,
-                                                 const sp<gui::IHdrLayerInfoListener>& listener) {
+status_t SurfaceFlinger::addHdrLayerInfoListener(
+        const sp<IBinder>& displayToken, const sp<gui::IHdrLayerInfoListener>& listener,
+        const HdrLayerInfoReporter::ListenerOptions& options) {
     if (!displayToken) {
         return BAD_VALUE;
     }
@@ -1980,7 +2046,7 @@ status_t SurfaceFlinger::addHdrLayerInfoListener(const sp<IBinder>& displayToken
     if (!hdrInfoReporter) {
         hdrInfoReporter = sp<HdrLayerInfoReporter>::make();
     }
-    hdrInfoReporter->addListener(listener);
+    hdrInfoReporter->addListener(listener, options);
 
 
     mAddingHDRLayerInfoListener = true;
@@ -2286,6 +2352,7 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, frontend::Update& upd
         ATRACE_NAME("LayerHierarchyBuilder:update");
         mLayerHierarchyBuilder.update(mLayerLifecycleManager.getLayers(),
                                       mLayerLifecycleManager.getDestroyedLayers());
+        mLayerTraceHierarchyChanged = true;
     }
 
     bool mustComposite = false;
@@ -2303,10 +2370,30 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, frontend::Update& upd
                      .forceFullDamage = mForceFullDamage,
                      .supportedLayerGenericMetadata =
                              getHwComposer().getSupportedLayerGenericMetadata(),
-                     .genericLayerMetadataKeyMap = getGenericLayerMetadataKeyMap()};
+                     .genericLayerMetadataKeyMap = getGenericLayerMetadataKeyMap(),
+                     .parallelSubtrees = mParallelSnapshotBuilderEnabled};
         mLayerSnapshotBuilder.update(args);
     }
 
+    if (mAsyncScreenshotsEnabled && mLayerLifecycleManager.getGlobalChanges().get() != 0) {
+        publishSnapshotsForScreenshots();
+    }
+
+    // The snapshots are destroyed with hierarchy changes only, so the changed ones are kept until
+    // the HDR layer info is updated after the next composition.
+    if (mLayerLifecycleManager.getGlobalChanges().test(Changes::Hierarchy) ||
+        mFrontEndDisplayInfosChanged) {
+        mHdrLayerInfoRebuildNeeded = true;
+        mHdrLayerInfoChangedSnapshots.clear();
+    } else if (!mHdrLayerInfoRebuildNeeded &&
+               mLayerLifecycleManager.getGlobalChanges().get() != 0) {
+        for (const auto& snapshot : mLayerSnapshotBuilder.getSnapshots()) {
+            if (snapshot->changes.get() != 0) {
+                mHdrLayerInfoChangedSnapshots.push_back(snapshot.get());
+            }
+        }
+    }
+
     if (mLayerLifecycleManager.getGlobalChanges().any(Changes::Geometry | Changes::Input |
                                                       Changes::Hierarchy | Changes::Visibility)) {
         mUpdateInputInfo = true;
@@ -2457,8 +2544,11 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
 
     // If we are in the middle of a mode change and the fence hasn't
     // fired yet just wait for the next commit.
-    if (mSetActiveModePending) {
-        if (framePending) {
+    if (mSetActiveModePending && !mSetActiveModeAwaitingFrame) {
+        const bool modeChangePending = mSetActiveModePresentFence
+                ? isFencePending(mSetActiveModePresentFence, graceTimeForPresentFenceMs)
+                : framePending;
+        if (modeChangePending) {
             mScheduler->scheduleFrame();
             return false;
         }
@@ -2466,6 +2556,7 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
         // We received the present fence from the HWC, so we assume it successfully updated
         // the mode, hence we update SF.
         mSetActiveModePending = false;
+        mSetActiveModePresentFence.reset();
         {
             Mutex::Autolock lock(mStateLock);
             updateInternalStateWithChangedMode();
@@ -2556,7 +2647,10 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
     {
         Mutex::Autolock lock(mStateLock);
         mScheduler->chooseRefreshRateForContent();
-        setActiveModeInHwcIfNeeded();
+        // A mode change that HWC was asked for between frames is still pending.
+        if (!mSetActiveModePending) {
+            setActiveModeInHwcIfNeeded();
+        }
     }
 
     updateCursorAsync();
@@ -2580,7 +2674,8 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     compositionengine::CompositionRefreshArgs refreshArgs;
     const auto& displays = FTL_FAKE_GUARD(mStateLock, mDisplays);
     refreshArgs.outputs.reserve(displays.size());
-    std::vector<DisplayId> displayIds;
+    std::vector<DisplayId>& displayIds = mCompositedDisplayIds;
+    displayIds.clear();
     for (const auto& [_, display] : displays) {
         bool dropFrame = false;
         if (display->isVirtual()) {
@@ -2619,9 +2714,14 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     }
 
     refreshArgs.bufferIdsToUncache = std::move(mBufferIdsToUncache);
+    {
+        std::scoped_lock<std::mutex> lock(mBuffersToPrefetchLock);
+        refreshArgs.buffersToPrefetch = std::move(mBuffersToPrefetch);
+        mBuffersToPrefetch.clear();
+    }
 
     refreshArgs.layersWithQueuedFrames.reserve(mLayersWithQueuedFrames.size());
-    for (auto layer : mLayersWithQueuedFrames) {
+    for (const auto& layer : mLayersWithQueuedFrames) {
         if (auto layerFE = layer->getCompositionEngineLayerFE())
             refreshArgs.layersWithQueuedFrames.push_back(layerFE);
     }
@@ -2662,6 +2762,16 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     refreshArgs.scheduledFrameTime = mScheduler->getScheduledFrameTime();
     refreshArgs.expectedPresentTime = mExpectedPresentTime.ns();
     refreshArgs.hasTrustedPresentationListener = mNumTrustedPresentationListeners > 0;
+    refreshArgs.recordLayerCosts = mLayerCostTracker->isEnabled();
+
+    if (mParallelOutputPresent) {
+        // Outputs presented concurrently rely on the RenderEngine thread to serialize their GPU
+        // work.
+        using Type = renderengine::RenderEngine::RenderEngineType;
+        const auto type = getRenderEngine().getRenderEngineType();
+        refreshArgs.parallelPresent = type == Type::THREADED || type == Type::SKIA_GL_THREADED ||
+                type == Type::SKIA_VK_THREADED;
+    }
 
     // Store the present time just before calling to the composition engine so we could notify
     // the scheduler.
@@ -2670,6 +2780,9 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     std::vector<std::pair<Layer*, LayerFE*>> layers =
             moveSnapshotsToCompositionArgs(refreshArgs, /*cursorOnly=*/false, vsyncId.value);
     mCompositionEngine->present(refreshArgs);
+    if (refreshArgs.recordLayerCosts) {
+        recordLayerCosts(refreshArgs, vsyncId);
+    }
     moveSnapshotsFromCompositionArgs(refreshArgs, layers);
 
     for (auto [layer, layerFE] : layers) {
@@ -2749,6 +2862,10 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
         addToLayerTracing(mVisibleRegionsDirty, frameTime.ns(), vsyncId.value);
     }
 
+    if (mDumpSnapshotRequested.exchange(false)) {
+        publishDumpSnapshot(frameTime, vsyncId);
+    }
+
     if (mVisibleRegionsDirty) mHdrLayerInfoChanged = true;
     mVisibleRegionsDirty = false;
 
@@ -2776,6 +2893,42 @@ void SurfaceFlinger::updateLayerGeometry() {
     mLayersPendingRefresh.clear();
 }
 
+template <typename GetLayerFE>
+void SurfaceFlinger::updateHdrLayer(HdrLayerInfoReporter& reporter,
+                                    const compositionengine::Output& output, uint32_t id,
+                                    const frontend::LayerSnapshot& snapshot,
+                                    GetLayerFE getLayerFE) {
+    const compositionengine::OutputLayer* outputLayer = nullptr;
+    if (snapshot.isVisible && output.includesLayer(snapshot.outputFilter) &&
+        isHdrLayer(snapshot)) {
+        if (const sp<LayerFE> layerFE = getLayerFE()) {
+            outputLayer = output.getOutputLayerForLayer(layerFE);
+        }
+    }
+    if (!outputLayer) {
+        reporter.removeHdrLayer(id);
+        return;
+    }
+    const auto& displayFrame = outputLayer->getState().displayFrame;
+    reporter.setHdrLayer(id,
+                         {.width = displayFrame.width(),
+                          .height = displayFrame.height(),
+                          .desiredHdrSdrRatio = snapshot.desiredHdrSdrRatio <= 1.f
+                                  ? std::numeric_limits<float>::infinity()
+                                  : snapshot.desiredHdrSdrRatio});
+}
+
+void SurfaceFlinger::scheduleHdrLayerInfoDispatch(const sp<HdrLayerInfoReporter>& reporter,
+                                                  std::chrono::nanoseconds delay) {
+    static_cast<void>(mScheduler->scheduleDelayed(
+            [this, reporter] {
+                if (const auto delay = reporter->dispatchPendingHdrLayerInfo()) {
+                    scheduleHdrLayerInfoDispatch(reporter, *delay);
+                }
+            },
+            std::max<nsecs_t>(delay.count(), 0)));
+}
+
 bool SurfaceFlinger::isHdrLayer(const frontend::LayerSnapshot& snapshot) const {
     // Even though the camera layer may be using an HDR transfer function or otherwise be "HDR"
     // the device may need to avoid boosting the brightness as a result of these layers to
@@ -2867,6 +3020,15 @@ void SurfaceFlinger::postComposition(nsecs_t callTime) {
 
     auto presentFenceTime = std::make_shared<FenceTime>(presentFence);
     mPreviousPresentFences[0] = {presentFence, presentFenceTime};
+    if (mSetActiveModeAwaitingFrame) {
+        mSetActiveModeAwaitingFrame = false;
+        mSetActiveModePresentFence = presentFenceTime;
+    }
+
+    // The fences are queried by FrameTimeline, TimeStats and the frame timestamps of the layers
+    // until they signal.
+    FenceSignalWatcher::getInstance().watch(presentFenceTime);
+    FenceSignalWatcher::getInstance().watch(glCompositionDoneFenceTime);
 
     const TimePoint presentTime = TimePoint::now();
 
@@ -2949,40 +3111,55 @@ void SurfaceFlinger::postComposition(nsecs_t callTime) {
         mAddingHDRLayerInfoListener = false;
     }
 
-    if (haveNewListeners || mHdrLayerInfoChanged) {
+    // With the new frontend, only the snapshots which changed since the last frame are evaluated
+    // again, unless the hierarchy or the displays changed.
+    const bool rebuildHdrLayers = haveNewListeners || mHdrLayerInfoRebuildNeeded;
+    const bool updateHdrLayers = mLayerLifecycleManagerEnabled
+            ? rebuildHdrLayers || !mHdrLayerInfoChangedSnapshots.empty()
+            : haveNewListeners || mHdrLayerInfoChanged;
+    if (updateHdrLayers) {
         for (auto& [compositionDisplay, listener] : hdrInfoListeners) {
-            HdrLayerInfoReporter::HdrLayerInfo info;
-            int32_t maxArea = 0;
-            mDrawingState.traverse([&, compositionDisplay = compositionDisplay](Layer* layer) {
-                const auto layerFe = layer->getCompositionEngineLayerFE();
-                const frontend::LayerSnapshot& snapshot = *layer->getLayerSnapshot();
-                if (snapshot.isVisible &&
-                    compositionDisplay->includesLayer(snapshot.outputFilter)) {
-                    if (isHdrLayer(snapshot)) {
-                        const auto* outputLayer =
-                            compositionDisplay->getOutputLayerForLayer(layerFe);
-                        if (outputLayer) {
-                            const float desiredHdrSdrRatio = snapshot.desiredHdrSdrRatio <= 1.f
-                                    ? std::numeric_limits<float>::infinity()
-                                    : snapshot.desiredHdrSdrRatio;
-                            info.mergeDesiredRatio(desiredHdrSdrRatio);
-                            info.numberOfHdrLayers++;
-                            const auto displayFrame = outputLayer->getState().displayFrame;
-                            const int32_t area = displayFrame.width() * displayFrame.height();
-                            if (area > maxArea) {
-                                maxArea = area;
-                                info.maxW = displayFrame.width();
-                                info.maxH = displayFrame.height();
-                            }
-                        }
+            if (!mLayerLifecycleManagerEnabled) {
+                listener->clearHdrLayers();
+                mDrawingState.traverse([&, compositionDisplay = compositionDisplay,
+                                        listener = listener](Layer* layer) {
+                    updateHdrLayer(*listener, *compositionDisplay, layer->sequence,
+                                   *layer->getLayerSnapshot(),
+                                   [layer] { return layer->getCompositionEngineLayerFE(); });
+                });
+            } else {
+                const auto update = [&, compositionDisplay = compositionDisplay,
+                                     listener = listener](const frontend::LayerSnapshot& snapshot) {
+                    updateHdrLayer(*listener, *compositionDisplay, snapshot.uniqueSequence,
+                                   snapshot, [&]() -> sp<LayerFE> {
+                                       auto it = mLegacyLayers.find(snapshot.sequence);
+                                       if (it == mLegacyLayers.end()) {
+                                           return nullptr;
+                                       }
+                                       return it->second->getCompositionEngineLayerFE(
+                                               snapshot.path);
+                                   });
+                };
+                if (rebuildHdrLayers) {
+                    listener->clearHdrLayers();
+                    for (const auto& snapshot : mLayerSnapshotBuilder.getSnapshots()) {
+                        update(*snapshot);
+                    }
+                } else {
+                    for (const frontend::LayerSnapshot* snapshot : mHdrLayerInfoChangedSnapshots) {
+                        update(*snapshot);
                     }
                 }
-            });
-            listener->dispatchHdrLayerInfo(info);
+            }
+            if (const auto delay = listener->dispatchHdrLayerInfo(listener->getHdrLayerInfo())) {
+                scheduleHdrLayerInfoDispatch(listener, *delay);
+            }
         }
     }
 
     mHdrLayerInfoChanged = false;
+    mHdrLayerInfoRebuildNeeded = false;
+    mHdrLayerInfoChangedSnapshots.clear();
 
     mTransactionCallbackInvoker.addPresentFence(std::move(presentFence));
     mTransactionCallbackInvoker.sendCallbacks(false /* onCommitOnly */);
@@ -4014,6 +4191,9 @@ void SurfaceFlinger::initScheduler(const sp<const DisplayDevice>& display) {
             sp<RegionSamplingThread>::make(*this,
                                            RegionSamplingThread::EnvironmentTimingTunables());
     mFpsReporter = sp<FpsReporter>::make(*mFrameTimeline, *this);
+    if (!mLegacyFrontEndEnabled) {
+        mLayerLifecycleManager.addLifecycleListener(mFpsReporter->trackTaskLayers());
+    }
 }
 
 void SurfaceFlinger::updatePhaseConfiguration(Fps refreshRate) {
@@ -4595,6 +4775,16 @@ status_t SurfaceFlinger::setTransactionState(
             mBufferCountTracker.increment(resolvedState.state.surface->localBinder());
         }
         resolvedState.layerId = LayerHandle::getLayerId(resolvedState.state.surface);
+        if (mHwcBufferCacheTracking && resolvedState.externalTexture &&
+            resolvedState.layerId != UNASSIGNED_LAYER_ID) {
+            const BufferData& bufferData = *resolvedState.state.bufferData;
+            if (bufferData.buffer &&
+                bufferData.flags.test(BufferData::BufferDataChange::cachedBufferChanged)) {
+                std::scoped_lock<std::mutex> lock(mBuffersToPrefetchLock);
+                mBuffersToPrefetch[static_cast<int32_t>(resolvedState.layerId)].push_back(
+                        bufferData.buffer);
+            }
+        }
         if (resolvedState.state.what & layer_state_t::eReparent) {
             resolvedState.parentId =
                     getLayerIdFromSurfaceControl(resolvedState.state.parentSurfaceControlForChild);
@@ -5655,6 +5845,7 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
                 {"--frametimeline"s, argsDumper(&SurfaceFlinger::dumpFrameTimeline)},
                 {"--hwclayers"s, dumper(&SurfaceFlinger::dumpHwcLayersMinidumpLocked)},
                 {"--latency"s, argsDumper(&SurfaceFlinger::dumpStatsLocked)},
+                {"--layer-costs"s, argsDumper(&SurfaceFlinger::dumpLayerCosts)},
                 {"--latency-clear"s, argsDumper(&SurfaceFlinger::clearStatsLocked)},
                 {"--list"s, dumper(&SurfaceFlinger::listLayersLocked)},
                 {"--planner"s, argsDumper(&SurfaceFlinger::dumpPlannerInfo)},
@@ -5666,6 +5857,12 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
 
         const auto flag = args.empty() ? ""s : std::string(String8(args[0]));
 
+        if (flag == "--snapshot"s) {
+            dumpFromSnapshot(asProto, result);
+            write(fd, result.c_str(), result.size());
+            return NO_ERROR;
+        }
+
         // Traversal of drawing state must happen on the main thread.
         // Otherwise, SortedVector may have shared ownership during concurrent
         // traversals, which can result in use-after-frees.
@@ -5764,6 +5961,10 @@ void SurfaceFlinger::dumpFrameTimeline(const DumpArgs& args, std::string& result
     mFrameTimeline->parseArgs(args, result);
 }
 
+void SurfaceFlinger::dumpLayerCosts(const DumpArgs& args, std::string& result) const {
+    mLayerCostTracker->parseArgs(args, result);
+}
+
 void SurfaceFlinger::logFrameStats(TimePoint now) {
     static TimePoint sTimestamp = now;
     if (now - sTimestamp < 30min) return;
@@ -5947,7 +6148,7 @@ LayersProto SurfaceFlinger::dumpDrawingStateProto(uint32_t traceFlags) const {
     }
 
     return LayerProtoFromSnapshotGenerator(mLayerSnapshotBuilder, mFrontEndDisplayInfos,
-                                           mLegacyLayers, traceFlags)
+                                           mLegacyLayers, traceFlags, mLayerProtoWorkerPool.get())
             .generate(mLayerHierarchyBuilder.getHierarchy());
 }
 
@@ -5997,6 +6198,76 @@ LayersProto SurfaceFlinger::dumpProtoFromMainThread(uint32_t traceFlags) {
     return mScheduler->schedule([=] { return dumpDrawingStateProto(traceFlags); }).get();
 }
 
+void SurfaceFlinger::publishDumpSnapshot(TimePoint frameTime, VsyncId vsyncId) {
+    ATRACE_CALL();
+    auto snapshot = std::make_shared<DumpSnapshot>();
+    snapshot->time = frameTime;
+    snapshot->vsyncId = vsyncId;
+    snapshot->layers = dumpDrawingStateProto(LayerTracing::TRACE_ALL);
+    snapshot->displays = dumpDisplayProto();
+    {
+        std::lock_guard lock(mDumpSnapshotMutex);
+        mDumpSnapshot = std::move(snapshot);
+    }
+    mDumpSnapshotCondition.notify_all();
+}
+
+void SurfaceFlinger::dumpFromSnapshot(bool asProto, std::string& result) {
+    // Long enough for a few frames at the lowest refresh rates.
+    constexpr auto kSnapshotTimeout = 500ms;
+
+    std::shared_ptr<const DumpSnapshot> snapshot;
+    {
+        std::unique_lock lock(mDumpSnapshotMutex);
+        const std::shared_ptr<const DumpSnapshot> previous = mDumpSnapshot;
+        mDumpSnapshotRequested = true;
+        // An idle main thread publishes the snapshot with the frame that this schedules.
+        scheduleComposite(FrameHint::kNone);
+        mDumpSnapshotCondition.wait_for(lock, kSnapshotTimeout,
+                                        [&]() REQUIRES(mDumpSnapshotMutex) {
+                                            return mDumpSnapshot != previous;
+                                        });
+        snapshot = mDumpSnapshot;
+    }
+    if (!snapshot) {
+        result.append("No snapshot was published by the main thread\n");
+        return;
+    }
+
+    if (asProto) {
+        LayersTraceFileProto traceFileProto = mLayerTracing.createTraceFileProto();
+        LayersTraceProto* layersTrace = traceFileProto.add_entry();
+        layersTrace->set_elapsed_realtime_nanos(snapshot->time.ns());
+        layersTrace->set_vsync_id(snapshot->vsyncId.value);
+        *layersTrace->mutable_layers() = snapshot->layers;
+        *layersTrace->mutable_displays() = snapshot->displays;
+        result.append(traceFileProto.SerializeAsString());
+        return;
+    }
+
+    StringAppendF(&result, "Snapshot of frame %" PRId64 " at %" PRId64 " (%.3f ms ago)\n\n",
+                  snapshot->vsyncId.value, snapshot->time.ns(),
+                  ticks<std::milli, float>(TimePoint::now() - snapshot->time));
+
+    result.append("Displays:\n");
+    for (const DisplayProto& display : snapshot->displays) {
+        StringAppendF(&result, "  %" PRIu64 " (%s): layerStack=%u, size=%dx%d, virtual=%s\n",
+                      display.id(), display.name().c_str(), display.layer_stack(),
+                      display.size().w(), display.size().h(), display.is_virtual() ? "yes" : "no");
+    }
+    result.append("\n");
+
+    // The scheduler synchronizes its own state.
+    result.append("Scheduler:\n");
+    utils::Dumper dumper{result};
+    mScheduler->dump(dumper);
+    result.append("\n");
+
+    const auto layerTree = LayerProtoParser::generateLayerTree(snapshot->layers);
+    result.append(LayerProtoParser::layerTreeToString(layerTree));
+    result.append("\n");
+}
+
 void SurfaceFlinger::dumpOffscreenLayers(std::string& result) {
     auto future = mScheduler->schedule([this] {
         std::string result;
@@ -6135,6 +6406,12 @@ void SurfaceFlinger::dumpAllLocked(const DumpArgs& args, const std::string& comp
 
     StringAppendF(&result, "  transaction time: %f us\n", inTransactionDuration / 1000.0);
 
+    if (mLayerLifecycleManagerEnabled) {
+        mLayerSnapshotBuilder.dumpSubtreeTimings(result);
+    }
+    mTransactionHandler.dump(result);
+    BackgroundExecutor::getInstance().dump(result);
+
     /*
      * Tracing state
      */
@@ -6158,6 +6435,8 @@ void SurfaceFlinger::dumpAllLocked(const DumpArgs& args, const std::string& comp
         dumpPlannerInfo(plannerArgs, result);
     }
 
+    mPowerAdvisor->dump(result);
+
     /*
      * Dump HWComposer state
      */
@@ -6509,6 +6788,7 @@ status_t SurfaceFlinger::onTransact(uint32_t code, const Parcel& data, Parcel* r
                         mScheduler
                                 ->schedule([&]() FTL_FAKE_GUARD(mStateLock) FTL_FAKE_GUARD(
                                                    kMainThreadContext) {
+                                    mLayerTraceNeedsFullState = true;
                                     addToLayerTracing(true /* visibleRegionDirty */, startingTime,
                                                       mLastCommittedVsyncId.value);
                                 })
@@ -7072,7 +7352,11 @@ status_t SurfaceFlinger::captureDisplay(const DisplayCaptureArgs& args,
     });
 
     GetLayerSnapshotsFunction getLayerSnapshots;
-    if (mLayerLifecycleManagerEnabled) {
+    bool fromPublishedSnapshots = false;
+    if (mAsyncScreenshotsEnabled && excludeLayerIds.empty()) {
+        getLayerSnapshots = getLayerSnapshotsForAsyncScreenshots(layerStack, args.uid,
+                                                                 fromPublishedSnapshots);
+    } else if (mLayerLifecycleManagerEnabled) {
         getLayerSnapshots =
                 getLayerSnapshotsForScreenshots(layerStack, args.uid, std::move(excludeLayerIds));
     } else {
@@ -7085,7 +7369,7 @@ status_t SurfaceFlinger::captureDisplay(const DisplayCaptureArgs& args,
 
     auto future = captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, reqSize,
                                       args.pixelFormat, args.allowProtected, args.grayscale,
-                                      captureListener);
+                                      captureListener, fromPublishedSnapshots);
     return fenceStatus(future.get());
 }
 
@@ -7115,7 +7399,11 @@ status_t SurfaceFlinger::captureDisplay(DisplayId displayId,
     });
 
     GetLayerSnapshotsFunction getLayerSnapshots;
-    if (mLayerLifecycleManagerEnabled) {
+    bool fromPublishedSnapshots = false;
+    if (mAsyncScreenshotsEnabled) {
+        getLayerSnapshots = getLayerSnapshotsForAsyncScreenshots(layerStack, CaptureArgs::UNSET_UID,
+                                                                 fromPublishedSnapshots);
+    } else if (mLayerLifecycleManagerEnabled) {
         getLayerSnapshots = getLayerSnapshotsForScreenshots(layerStack, CaptureArgs::UNSET_UID,
                                                             /*snapshotFilterFn=*/nullptr);
     } else {
@@ -7135,7 +7423,7 @@ status_t SurfaceFlinger::captureDisplay(DisplayId displayId,
 
     auto future = captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, size,
                                       ui::PixelFormat::RGBA_8888, kAllowProtected, kGrayscale,
-                                      captureListener);
+                                      captureListener, fromPublishedSnapshots);
     return fenceStatus(future.get());
 }
 
@@ -7280,7 +7568,7 @@ status_t SurfaceFlinger::captureLayers(const LayerCaptureArgs& args,
 ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
         RenderAreaFuture renderAreaFuture, GetLayerSnapshotsFunction getLayerSnapshots,
         ui::Size bufferSize, ui::PixelFormat reqPixelFormat, bool allowProtected, bool grayscale,
-        const sp<IScreenCaptureListener>& captureListener) {
+        const sp<IScreenCaptureListener>& captureListener, bool fromPublishedSnapshots) {
     ATRACE_CALL();
 
     if (exceedsMaxRenderTargetSize(bufferSize.getWidth(), bufferSize.getHeight())) {
@@ -7297,18 +7585,18 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
     const bool supportsProtected = getRenderEngine().supportsProtectedContent();
     bool hasProtectedLayer = false;
     if (allowProtected && supportsProtected) {
-        hasProtectedLayer = mScheduler
-                                    ->schedule([=]() {
-                                        bool protectedLayerFound = false;
-                                        auto layers = getLayerSnapshots();
-                                        for (auto& [_, layerFe] : layers) {
-                                            protectedLayerFound |=
-                                                    (layerFe->mSnapshot->isVisible &&
-                                                     layerFe->mSnapshot->hasProtectedContent);
-                                        }
-                                        return protectedLayerFound;
-                                    })
-                                    .get();
+        auto findProtectedLayer = [=]() {
+            bool protectedLayerFound = false;
+            auto layers = getLayerSnapshots();
+            for (auto& [_, layerFe] : layers) {
+                protectedLayerFound |=
+                        (layerFe->mSnapshot->isVisible && layerFe->mSnapshot->hasProtectedContent);
+            }
+            return protectedLayerFound;
+        };
+        hasProtectedLayer = fromPublishedSnapshots
+                ? findProtectedLayer()
+                : mScheduler->schedule(std::move(findProtectedLayer)).get();
     }
 
     const uint32_t usage = GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_RENDER |
@@ -7334,51 +7622,59 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
                                                  renderengine::impl::ExternalTexture::Usage::
                                                          WRITEABLE);
     return captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, texture,
-                               false /* regionSampling */, grayscale, captureListener);
+                               false /* regionSampling */, grayscale, captureListener,
+                               fromPublishedSnapshots);
 }
 
 ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
         RenderAreaFuture renderAreaFuture, GetLayerSnapshotsFunction getLayerSnapshots,
         const std::shared_ptr<renderengine::ExternalTexture>& buffer, bool regionSampling,
-        bool grayscale, const sp<IScreenCaptureListener>& captureListener) {
+        bool grayscale, const sp<IScreenCaptureListener>& captureListener,
+        bool fromPublishedSnapshots) {
     ATRACE_CALL();
 
     bool canCaptureBlackoutContent = hasCaptureBlackoutContentPermission();
 
-    auto future = mScheduler->schedule(
-            [=, renderAreaFuture = std::move(renderAreaFuture)]() FTL_FAKE_GUARD(
-                    kMainThreadContext) mutable -> ftl::SharedFuture<FenceResult> {
-                ScreenCaptureResults captureResults;
-                std::shared_ptr<RenderArea> renderArea = renderAreaFuture.get();
-                if (!renderArea) {
-                    ALOGW("Skipping screen capture because of invalid render area.");
-                    if (captureListener) {
-                        captureResults.fenceResult = base::unexpected(NO_MEMORY);
+    auto capture = [=, renderAreaFuture = std::move(renderAreaFuture)]() mutable
+            -> ftl::SharedFuture<FenceResult> {
+        ScreenCaptureResults captureResults;
+        std::shared_ptr<RenderArea> renderArea = renderAreaFuture.get();
+        if (!renderArea) {
+            ALOGW("Skipping screen capture because of invalid render area.");
+            if (captureListener) {
+                captureResults.fenceResult = base::unexpected(NO_MEMORY);
+                captureListener->onScreenCaptureCompleted(captureResults);
+            }
+            return ftl::yield<FenceResult>(base::unexpected(NO_ERROR)).share();
+        }
+
+        ftl::SharedFuture<FenceResult> renderFuture;
+        renderArea->render([&]() {
+            renderFuture = renderScreenImpl(renderArea, getLayerSnapshots, buffer,
+                                            canCaptureBlackoutContent, regionSampling, grayscale,
+                                            captureResults);
+        });
+
+        if (captureListener) {
+            // Defer blocking on renderFuture back to the Binder thread.
+            return ftl::Future(std::move(renderFuture))
+                    .then([captureListener, captureResults = std::move(captureResults)](
+                                  FenceResult fenceResult) mutable -> FenceResult {
+                        captureResults.fenceResult = std::move(fenceResult);
                         captureListener->onScreenCaptureCompleted(captureResults);
-                    }
-                    return ftl::yield<FenceResult>(base::unexpected(NO_ERROR)).share();
-                }
+                        return base::unexpected(NO_ERROR);
+                    })
+                    .share();
+        }
+        return renderFuture;
+    };
 
-                ftl::SharedFuture<FenceResult> renderFuture;
-                renderArea->render([&]() FTL_FAKE_GUARD(kMainThreadContext) {
-                    renderFuture = renderScreenImpl(renderArea, getLayerSnapshots, buffer,
-                                                    canCaptureBlackoutContent, regionSampling,
-                                                    grayscale, captureResults);
-                });
+    // The published snapshots are immutable, so the capture does not need the main thread.
+    if (fromPublishedSnapshots) {
+        return capture();
+    }
 
-                if (captureListener) {
-                    // Defer blocking on renderFuture back to the Binder thread.
-                    return ftl::Future(std::move(renderFuture))
-                            .then([captureListener, captureResults = std::move(captureResults)](
-                                          FenceResult fenceResult) mutable -> FenceResult {
-                                captureResults.fenceResult = std::move(fenceResult);
-                                captureListener->onScreenCaptureCompleted(captureResults);
-                                return base::unexpected(NO_ERROR);
-                            })
-                            .share();
-                }
-                return renderFuture;
-            });
+    auto future = mScheduler->schedule(std::move(capture));
 
     // Flatten nested futures.
     auto chain = ftl::Future(std::move(future)).then([](ftl::SharedFuture<FenceResult> future) {
@@ -7531,28 +7827,51 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::renderScreenImpl(
     //
     // TODO(b/196334700) Once we use RenderEngineThreaded everywhere we can always defer the call
     // to CompositionEngine::present.
-    const bool renderEngineIsThreaded = [&]() {
-        using Type = renderengine::RenderEngine::RenderEngineType;
-        const auto type = mRenderEngine->getRenderEngineType();
-        return type == Type::THREADED || type == Type::SKIA_GL_THREADED;
-    }();
-    auto presentFuture = renderEngineIsThreaded ? ftl::defer(std::move(present)).share()
-                                                : ftl::yield(present()).share();
+    auto presentFuture = isRenderEngineThreaded() ? ftl::defer(std::move(present)).share()
+                                                  : ftl::yield(present()).share();
 
+    // Layers gathered from published snapshots have no legacy layer, which may only be accessed on
+    // the main thread, so those are looked up there.
+    std::vector<std::pair<uint32_t, ftl::SharedFuture<FenceResult>>> releasedLayers;
     for (auto& [layer, layerFE] : layers) {
-        layer->onLayerDisplayed(ftl::Future(presentFuture)
-                                        .then([layerFE = std::move(layerFE)](FenceResult) {
-                                            return layerFE->stealCompositionResult()
-                                                    .releaseFences.back()
-                                                    .first.get();
-                                        })
-                                        .share(),
-                                ui::INVALID_LAYER_STACK);
+        const uint32_t sequence = static_cast<uint32_t>(layerFE->mSnapshot->sequence);
+        auto releaseFence = ftl::Future(presentFuture)
+                                    .then([layerFE = std::move(layerFE)](FenceResult) {
+                                        return layerFE->stealCompositionResult()
+                                                .releaseFences.back()
+                                                .first.get();
+                                    })
+                                    .share();
+        if (layer) {
+            layer->onLayerDisplayed(std::move(releaseFence), ui::INVALID_LAYER_STACK);
+        } else {
+            releasedLayers.emplace_back(sequence, std::move(releaseFence));
+        }
+    }
+
+    if (!releasedLayers.empty()) {
+        static_cast<void>(mScheduler->schedule(
+                [this, releasedLayers = std::move(releasedLayers)]() FTL_FAKE_GUARD(
+                        kMainThreadContext) mutable {
+                    for (auto& [sequence, releaseFence] : releasedLayers) {
+                        if (const auto it = mLegacyLayers.find(sequence);
+                            it != mLegacyLayers.end()) {
+                            it->second->onLayerDisplayed(std::move(releaseFence),
+                                                         ui::INVALID_LAYER_STACK);
+                        }
+                    }
+                }));
     }
 
     return presentFuture;
 }
 
+bool SurfaceFlinger::isRenderEngineThreaded() const {
+    using Type = renderengine::RenderEngine::RenderEngineType;
+    const auto type = mRenderEngine->getRenderEngineType();
+    return type == Type::THREADED || type == Type::SKIA_GL_THREADED;
+}
+
 void SurfaceFlinger::traverseLegacyLayers(const LayerVector::Visitor& visitor) const {
     if (mLayerLifecycleManagerEnabled) {
         for (auto& layer : mLegacyLayers) {
@@ -8194,6 +8513,49 @@ void SurfaceFlinger::updateLayerMetadataSnapshot() {
     });
 }
 
+void SurfaceFlinger::recordLayerCosts(const compositionengine::CompositionRefreshArgs& refreshArgs,
+                                      VsyncId vsyncId) {
+    ATRACE_CALL();
+    using Key = LayerCostTracker::Key;
+    std::vector<LayerCostTracker::OutputComposition> outputs;
+    outputs.reserve(refreshArgs.outputs.size());
+    for (const auto& output : refreshArgs.outputs) {
+        const auto& state = output->getState();
+        if (!state.isEnabled) {
+            continue;
+        }
+
+        LayerCostTracker::OutputComposition composition{
+                .hwcValidateDuration = state.hwcValidateDuration,
+                .hwcPresentDuration = state.hwcPresentDuration};
+        if (state.renderEngineStartTime > 0 && output->getRenderSurface()) {
+            composition.renderEngineFence = std::make_shared<FenceTime>(
+                    output->getRenderSurface()->getClientTargetAcquireFence());
+            composition.renderEngineStartTime = state.renderEngineStartTime;
+        }
+
+        composition.layers.reserve(output->getOutputLayerCount());
+        for (const auto* outputLayer : output->getOutputLayersOrderedByZ()) {
+            const auto& layerState = outputLayer->getState();
+            const auto& layerFE = outputLayer->getLayerFE();
+            LayerCostTracker::LayerComposition layer{
+                    .name = layerFE.getDebugName(),
+                    .cpu = layerState.cpuCost,
+                    .clientComposed = outputLayer->requiresClientComposition(),
+                    .area = static_cast<int64_t>(layerState.displayFrame.getWidth()) *
+                            layerState.displayFrame.getHeight()};
+            if (const auto& buffer = layerState.overrideInfo.buffer) {
+                layer.key = {Key::Type::CachedSet, buffer->getBuffer()->getId()};
+            } else {
+                layer.key = {Key::Type::Layer, static_cast<uint64_t>(layerFE.getSequence())};
+            }
+            composition.layers.push_back(layer);
+        }
+        outputs.push_back(std::move(composition));
+    }
+    mLayerCostTracker->recordFrame(vsyncId.value, systemTime(), std::move(outputs));
+}
+
 void SurfaceFlinger::moveSnapshotsFromCompositionArgs(
         compositionengine::CompositionRefreshArgs& refreshArgs,
         std::vector<std::pair<Layer*, LayerFE*>>& layers) {
@@ -8282,14 +8644,11 @@ SurfaceFlinger::getLayerSnapshotsForScreenshots(
     return [&, layerStack, uid]() {
         std::vector<std::pair<Layer*, sp<LayerFE>>> layers;
         bool stopTraversal = false;
-        mLayerSnapshotBuilder.forEachVisibleSnapshot(
+        const frontend::LayerSnapshotBuilder::Visitor visitor =
                 [&](std::unique_ptr<frontend::LayerSnapshot>& snapshot) {
                     if (stopTraversal) {
                         return;
                     }
-                    if (layerStack && snapshot->outputFilter.layerStack != *layerStack) {
-                        return;
-                    }
                     if (uid != CaptureArgs::UNSET_UID && snapshot->uid != uid) {
                         return;
                     }
@@ -8308,7 +8667,14 @@ SurfaceFlinger::getLayerSnapshotsForScreenshots(
                     sp<LayerFE> layerFE = getFactory().createLayerFE(snapshot->name);
                     layerFE->mSnapshot = std::make_unique<frontend::LayerSnapshot>(*snapshot);
                     layers.emplace_back(legacyLayer, std::move(layerFE));
-                });
+                };
+        if (layerStack) {
+            // Filter by layer stack using the builder's hot fields without loading the snapshots
+            // on other layer stacks.
+            mLayerSnapshotBuilder.forEachVisibleSnapshot(*layerStack, visitor);
+        } else {
+            mLayerSnapshotBuilder.forEachVisibleSnapshot(visitor);
+        }
 
         return layers;
     };
@@ -8387,6 +8753,64 @@ SurfaceFlinger::getLayerSnapshotsForScreenshots(uint32_t rootLayerId, uint32_t u
     };
 }
 
+std::function<std::vector<std::pair<Layer*, sp<LayerFE>>>()>
+SurfaceFlinger::getLayerSnapshotsForAsyncScreenshots(ui::LayerStack layerStack, uint32_t uid,
+                                                     bool& outFromPublishedSnapshots) {
+    mLastAsyncScreenshotTime = systemTime();
+
+    std::shared_ptr<const std::vector<frontend::LayerSnapshot>> snapshots;
+    if (isRenderEngineThreaded()) {
+        std::scoped_lock lock(mPublishedSnapshotsMutex);
+        snapshots = mPublishedSnapshots;
+    }
+
+    outFromPublishedSnapshots = snapshots != nullptr;
+    if (!snapshots) {
+        auto getLayerSnapshotsFn =
+                getLayerSnapshotsForScreenshots(layerStack, uid, /*snapshotFilterFn=*/nullptr);
+        return [this, getLayerSnapshotsFn = std::move(getLayerSnapshotsFn)]()
+                       FTL_FAKE_GUARD(kMainThreadContext) {
+                           publishSnapshotsForScreenshots();
+                           return getLayerSnapshotsFn();
+                       };
+    }
+
+    return [this, snapshots = std::move(snapshots), layerStack, uid]() {
+        std::vector<std::pair<Layer*, sp<LayerFE>>> layers;
+        for (const auto& snapshot : *snapshots) {
+            if (snapshot.outputFilter.layerStack != layerStack) {
+                continue;
+            }
+            if (uid != CaptureArgs::UNSET_UID && snapshot.uid != uid) {
+                continue;
+            }
+            sp<LayerFE> layerFE = getFactory().createLayerFE(snapshot.name);
+            layerFE->mSnapshot = std::make_unique<frontend::LayerSnapshot>(snapshot);
+            layers.emplace_back(nullptr, std::move(layerFE));
+        }
+        return layers;
+    };
+}
+
+void SurfaceFlinger::publishSnapshotsForScreenshots() {
+    // Stop copying the snapshots every commit once captures are no longer frequent.
+    constexpr nsecs_t kPublishTimeout = ms2ns(1000);
+    std::shared_ptr<const std::vector<frontend::LayerSnapshot>> snapshots;
+    if (systemTime() - mLastAsyncScreenshotTime < kPublishTimeout) {
+        ATRACE_CALL();
+        auto visibleSnapshots = std::make_shared<std::vector<frontend::LayerSnapshot>>();
+        mLayerSnapshotBuilder.forEachVisibleSnapshot([&](const frontend::LayerSnapshot& snapshot) {
+            if (snapshot.hasSomethingToDraw()) {
+                visibleSnapshots->push_back(snapshot);
+            }
+        });
+        snapshots = std::move(visibleSnapshots);
+    }
+
+    std::scoped_lock lock(mPublishedSnapshotsMutex);
+    mPublishedSnapshots = std::move(snapshots);
+}
+
 frontend::Update SurfaceFlinger::flushLifecycleUpdates() {
     frontend::Update update;
     ATRACE_NAME("TransactionHandler:flushTransactions");
@@ -8415,6 +8839,14 @@ frontend::Update SurfaceFlinger::flushLifecycleUpdates() {
 
 void SurfaceFlinger::addToLayerTracing(bool visibleRegionDirty, int64_t time, int64_t vsyncId) {
     const uint32_t tracingFlags = mLayerTracing.getFlags();
+    // The composition state and the offscreen layers are only available from the Layer objects.
+    if (mLayerTraceDeltasEnabled &&
+        !(tracingFlags & (LayerTracing::TRACE_COMPOSITION | LayerTracing::TRACE_EXTRA))) {
+        addDeltaToLayerTracing(visibleRegionDirty, time, vsyncId, tracingFlags);
+        return;
+    }
+    mLayerTraceNeedsFullState = true;
+
     LayersProto layers(dumpDrawingStateProto(tracingFlags));
     if (tracingFlags & LayerTracing::TRACE_EXTRA) {
         dumpOffscreenLayersProto(layers);
@@ -8427,6 +8859,26 @@ void SurfaceFlinger::addToLayerTracing(bool visibleRegionDirty, int64_t time, in
     mLayerTracing.notify(visibleRegionDirty, time, vsyncId, &layers, std::move(hwcDump), &displays);
 }
 
+void SurfaceFlinger::addDeltaToLayerTracing(bool visibleRegionDirty, int64_t time,
+                                            int64_t vsyncId, uint32_t tracingFlags) {
+    ATRACE_CALL();
+    LayerTraceDelta delta =
+            LayerTraceDelta::record(mLayerHierarchyBuilder.getHierarchy(), mLayerSnapshotBuilder,
+                                    mLayerLifecycleManager, mLayerTraceHierarchyChanged,
+                                    mLayerTraceNeedsFullState);
+    delta.time = time;
+    delta.vsyncId = vsyncId;
+    delta.visibleRegionDirty = visibleRegionDirty;
+    delta.traceFlags = tracingFlags;
+    if (tracingFlags & LayerTracing::TRACE_HWC) {
+        dumpHwc(delta.hwcDump);
+    }
+    delta.displays = dumpDisplayProto();
+    mLayerTracing.notifyDelta(std::move(delta));
+    mLayerTraceNeedsFullState = false;
+    mLayerTraceHierarchyChanged = false;
+}
+
 // gui::ISurfaceComposer
 
 binder::Status SurfaceComposerAIDL::bootFinished() {
@@ -9057,6 +9509,22 @@ binder::Status SurfaceComposerAIDL::addHdrLayerInfoListener(
     return binderStatusFromStatusT(status);
 }
 
+binder::Status SurfaceComposerAIDL::addHdrLayerInfoListenerWithOptions(
+        const sp<IBinder>& displayToken, const sp<gui::IHdrLayerInfoListener>& listener,
+        int64_t minUpdateIntervalNanos, float hysteresis) {
+    if (minUpdateIntervalNanos < 0 || !(hysteresis >= 0.f)) {
+        return binderStatusFromStatusT(BAD_VALUE);
+    }
+    status_t status = checkControlDisplayBrightnessPermission();
+    if (status == OK) {
+        const HdrLayerInfoReporter::ListenerOptions options{
+                .minUpdateInterval = std::chrono::nanoseconds(minUpdateIntervalNanos),
+                .hysteresis = hysteresis};
+        status = mFlinger->addHdrLayerInfoListener(displayToken, listener, options);
+    }
+    return binderStatusFromStatusT(status);
+}
+
 binder::Status SurfaceComposerAIDL::removeHdrLayerInfoListener(
         const sp<IBinder>& displayToken, const sp<gui::IHdrLayerInfoListener>& listener) {
     status_t status = checkControlDisplayBrightnessPermission();
@@ -53,6 +53,7 @@
 #include <utils/Trace.h>
 #include <utils/threads.h>
 
+#include <compositionengine/Output.h>
 #include <compositionengine/OutputColorSetting.h>
 #include <scheduler/Fps.h>
 #include <scheduler/PresentLatencyTracker.h>
@@ -76,6 +77,9 @@
 #include "FrontEnd/LayerSnapshot.h"
 #include "FrontEnd/LayerSnapshotBuilder.h"
 #include "FrontEnd/TransactionHandler.h"
+#include "FrontEnd/WorkerPool.h"
+#include "HdrLayerInfoReporter.h"
+#include "LayerCostTracker.h"
 #include "LayerVector.h"
 #include "Scheduler/ISchedulerCallback.h"
 #include "Scheduler/RefreshRateSelector.h"
@@ -89,6 +93,7 @@
 #include "TransactionState.h"
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -117,7 +122,6 @@ class EventThread;
 class FlagManager;
 class FpsReporter;
 class TunnelModeEnabledReporter;
-class HdrLayerInfoReporter;
 class HWComposer;
 class IGraphicBufferProducer;
 class Layer;
@@ -316,12 +320,28 @@ public:
     // run parallel to the hwc validateDisplay call and re-run if the predition is incorrect.
     bool mPredictCompositionStrategy = false;
 
+    // If set, each display tracks how often presentOrValidate presented each layer stack, and
+    // skips validate whenever that is likely to succeed, and only then.
+    bool mPredictSkipValidate = false;
+
+    // If set, HWC buffer caches learn each layer's buffer cycle to decide which buffers to evict,
+    // and buffers newly added to the ClientCache are sent to HWC before they are displayed.
+    bool mHwcBufferCacheTracking = false;
+
     // If true, then any layer with a SMPTE 170M transfer function is decoded using the sRGB
     // transfer instead. This is mainly to preserve legacy behavior, where implementations treated
     // SMPTE 170M as sRGB prior to color management being implemented, and now implementations rely
     // on this behavior to increase contrast for some media sources.
     bool mTreat170mAsSrgb = false;
 
+    // If set, composition engine reuses the previous frame's visible regions for layers that
+    // do not overlap any layer whose geometry changed.
+    bool mIncrementalVisibleRegions = false;
+
+    // If set, composition engine presents outputs that share no layers concurrently. Only takes
+    // effect with a threaded RenderEngine.
+    bool mParallelOutputPresent = false;
+
     // Allows to ignore physical orientation provided through hwc API in favour of
     // 'ro.surface_flinger.primary_display_orientation'.
     // TODO(b/246793311): Clean up a temporary property
@@ -590,7 +610,8 @@ private:
     status_t setDisplayBrightness(const sp<IBinder>& displayToken,
                                   const gui::DisplayBrightness& brightness);
     status_t addHdrLayerInfoListener(const sp<IBinder>& displayToken,
-                                     const sp<gui::IHdrLayerInfoListener>& listener);
+                                     const sp<gui::IHdrLayerInfoListener>& listener,
+                                     const HdrLayerInfoReporter::ListenerOptions& options = {});
     status_t removeHdrLayerInfoListener(const sp<IBinder>& displayToken,
                                         const sp<gui::IHdrLayerInfoListener>& listener);
     status_t notifyPowerBoost(int32_t boostId);
@@ -715,6 +736,9 @@ private:
             int64_t vsyncId);
     void moveSnapshotsFromCompositionArgs(compositionengine::CompositionRefreshArgs& refreshArgs,
                                           std::vector<std::pair<Layer*, LayerFE*>>& layers);
+    // Must be called before the snapshots are moved back from the composition args.
+    void recordLayerCosts(const compositionengine::CompositionRefreshArgs& refreshArgs,
+                          VsyncId vsyncId);
     bool updateLayerSnapshotsLegacy(VsyncId vsyncId, frontend::Update& update,
                                     bool transactionsFlushed, bool& out)
             REQUIRES(kMainThreadContext);
@@ -825,19 +849,25 @@ private:
     // Boot animation, on/off animations and screen capture
     void startBootAnim();
 
+    // If fromPublishedSnapshots, the layers are gathered from the snapshots published by the main
+    // thread, so the capture is rendered on the calling thread without scheduling the main thread.
     ftl::SharedFuture<FenceResult> captureScreenCommon(RenderAreaFuture, GetLayerSnapshotsFunction,
                                                        ui::Size bufferSize, ui::PixelFormat,
                                                        bool allowProtected, bool grayscale,
-                                                       const sp<IScreenCaptureListener>&);
+                                                       const sp<IScreenCaptureListener>&,
+                                                       bool fromPublishedSnapshots = false);
     ftl::SharedFuture<FenceResult> captureScreenCommon(
             RenderAreaFuture, GetLayerSnapshotsFunction,
             const std::shared_ptr<renderengine::ExternalTexture>&, bool regionSampling,
-            bool grayscale, const sp<IScreenCaptureListener>&);
+            bool grayscale, const sp<IScreenCaptureListener>&, bool fromPublishedSnapshots = false);
+    // Runs on the main thread, unless the layers are gathered from published snapshots, in which
+    // case the layers are notified that they were displayed on the main thread later.
     ftl::SharedFuture<FenceResult> renderScreenImpl(
             std::shared_ptr<const RenderArea>, GetLayerSnapshotsFunction,
             const std::shared_ptr<renderengine::ExternalTexture>&, bool canCaptureBlackoutContent,
-            bool regionSampling, bool grayscale, ScreenCaptureResults&) EXCLUDES(mStateLock)
-            REQUIRES(kMainThreadContext);
+            bool regionSampling, bool grayscale, ScreenCaptureResults&) EXCLUDES(mStateLock);
+
+    bool isRenderEngineThreaded() const;
 
     bool canAllocateHwcDisplayIdForVDS(uint64_t usage);
 
@@ -1074,6 +1104,7 @@ private:
     void clearStatsLocked(const DumpArgs& args, std::string& result);
     void dumpTimeStats(const DumpArgs& args, bool asProto, std::string& result) const;
     void dumpFrameTimeline(const DumpArgs& args, std::string& result) const;
+    void dumpLayerCosts(const DumpArgs& args, std::string& result) const;
     void logFrameStats(TimePoint now) REQUIRES(kMainThreadContext);
 
     void dumpScheduler(std::string& result) const REQUIRES(mStateLock);
@@ -1092,12 +1123,26 @@ private:
     google::protobuf::RepeatedPtrField<DisplayProto> dumpDisplayProto() const;
     void addToLayerTracing(bool visibleRegionDirty, int64_t time, int64_t vsyncId)
             REQUIRES(kMainThreadContext);
+    // Hands the layer state changes of the frame to the layer tracing thread, which builds the
+    // trace entry, instead of building it on the main thread.
+    void addDeltaToLayerTracing(bool visibleRegionDirty, int64_t time, int64_t vsyncId,
+                                uint32_t tracingFlags) REQUIRES(kMainThreadContext);
 
     // Dumps state from HW Composer
     void dumpHwc(std::string& result) const;
     LayersProto dumpProtoFromMainThread(uint32_t traceFlags = LayerTracing::TRACE_ALL)
             EXCLUDES(mStateLock);
     void dumpOffscreenLayers(std::string& result) EXCLUDES(mStateLock);
+    // The state that dumpsys --snapshot formats, copied by the main thread at the end of a frame,
+    // so that the dump neither waits for the main thread nor takes mStateLock.
+    struct DumpSnapshot {
+        TimePoint time;
+        VsyncId vsyncId;
+        LayersProto layers;
+        google::protobuf::RepeatedPtrField<DisplayProto> displays;
+    };
+    void publishDumpSnapshot(TimePoint frameTime, VsyncId vsyncId) REQUIRES(kMainThreadContext);
+    void dumpFromSnapshot(bool asProto, std::string& result) EXCLUDES(mStateLock);
     void dumpPlannerInfo(const DumpArgs& args, std::string& result) const REQUIRES(mStateLock);
 
     status_t doDump(int fd, const DumpArgs& args, bool asProto);
@@ -1128,6 +1173,15 @@ private:
     int getMaxAcquiredBufferCountForRefreshRate(Fps refreshRate) const;
 
     bool isHdrLayer(const frontend::LayerSnapshot& snapshot) const;
+    // Records whether the snapshot is an HDR layer of the output, in the HDR layer info reporter of
+    // the output.
+    template <typename GetLayerFE>
+    void updateHdrLayer(HdrLayerInfoReporter&, const compositionengine::Output&, uint32_t id,
+                        const frontend::LayerSnapshot&, GetLayerFE getLayerFE);
+    // Dispatches the HDR layer info updates which were held back by the minimum update interval
+    // of their listeners.
+    void scheduleHdrLayerInfoDispatch(const sp<HdrLayerInfoReporter>&,
+                                      std::chrono::nanoseconds delay);
 
     ui::Rotation getPhysicalDisplayOrientation(DisplayId, bool isPrimary) const
             REQUIRES(mStateLock);
@@ -1157,6 +1211,11 @@ private:
     // the graphics memory can be immediately freed.
     std::vector<uint64_t> mBufferIdsToUncache;
 
+    // Buffers that were newly added to the ClientCache, for HWC buffer caches to prefetch when
+    // mHwcBufferCacheTracking is set. These are collected on binder threads.
+    std::mutex mBuffersToPrefetchLock;
+    compositionengine::BuffersToPrefetch mBuffersToPrefetch GUARDED_BY(mBuffersToPrefetchLock);
+
     // global color transform states
     Daltonizer mDaltonizer;
     float mGlobalSaturationFactor = 1.0f;
@@ -1185,6 +1244,10 @@ private:
     bool mVisibleRegionsDirty = false;
 
     bool mHdrLayerInfoChanged = false;
+    // With the new frontend, whether the HDR layers of the displays must be found again from all
+    // the snapshots, or else the snapshots which changed since the last composition.
+    bool mHdrLayerInfoRebuildNeeded = true;
+    std::vector<const frontend::LayerSnapshot*> mHdrLayerInfoChangedSnapshots;
 
     // Used to ensure we omit a callback when HDR layer info listener is newly added but the
     // scene hasn't changed
@@ -1208,6 +1271,8 @@ private:
     std::unordered_set<sp<Layer>, SpHash<Layer>> mLayersWithBuffersRemoved;
     // Tracks layers that need to update a display's dirty region.
     std::vector<sp<Layer>> mLayersPendingRefresh;
+    // Scratch list for composite(), kept to reuse its capacity across frames.
+    std::vector<DisplayId> mCompositedDisplayIds GUARDED_BY(kMainThreadContext);
     // Sorted list of layers that were composed during previous frame. This is used to
     // avoid an expensive traversal of the layer hierarchy when there are no
     // visible region changes. Because this is a list of strong pointers, this will
@@ -1260,6 +1325,7 @@ private:
     const std::shared_ptr<TimeStats> mTimeStats;
     const std::unique_ptr<FrameTracer> mFrameTracer;
     const std::unique_ptr<frametimeline::FrameTimeline> mFrameTimeline;
+    const std::unique_ptr<LayerCostTracker> mLayerCostTracker;
 
     VsyncId mLastCommittedVsyncId;
 
@@ -1346,6 +1412,19 @@ private:
 
     // below flags are set by main thread only
     bool mSetActiveModePending = false;
+    // Whether HWC was asked to change the mode between frames, and no frame was composited since,
+    // so that the previous present fence does not tell whether the new mode is presented.
+    bool mSetActiveModeAwaitingFrame = false;
+    // The present fence of the first frame composited after HWC was asked to change the mode
+    // between frames, which the mode change waits for.
+    FenceTimePtr mSetActiveModePresentFence;
+
+    // debug.sf.early_mode_switch: calls HWC to switch the display mode as soon as the switch is
+    // decided, rather than on the next commit.
+    bool mEarlyModeSwitchEnabled = false;
+    // When the pending display mode switch was decided, and how long it took to call HWC.
+    std::optional<TimePoint> mModeSwitchRequestTime GUARDED_BY(mStateLock);
+    std::optional<Duration> mModeSwitchHwcLatency GUARDED_BY(mStateLock);
 
     bool mLumaSampling = true;
     sp<RegionSamplingThread> mRegionSamplingThread;
@@ -1420,6 +1499,18 @@ private:
             uint32_t rootLayerId, uint32_t uid, std::unordered_set<uint32_t> excludeLayerIds,
             bool childrenOnly, const std::optional<FloatRect>& optionalParentCrop);
 
+    // Returns a function that gathers the layers of a display capture from the snapshots that the
+    // main thread last published, and sets outFromPublishedSnapshots. If none are published, the
+    // function gathers the layers on the main thread instead, and publishes the snapshots for the
+    // next captures.
+    std::function<std::vector<std::pair<Layer*, sp<LayerFE>>>()>
+    getLayerSnapshotsForAsyncScreenshots(ui::LayerStack layerStack, uint32_t uid,
+                                         bool& outFromPublishedSnapshots);
+    // While display captures are frequent, e.g. during screen recording, publishes copies of the
+    // visible snapshots after each commit that changes them, so that captures do not need to
+    // schedule the main thread to gather layers.
+    void publishSnapshotsForScreenshots() REQUIRES(kMainThreadContext);
+
     const sp<WindowInfosListenerInvoker> mWindowInfosListenerInvoker;
 
     FlagManager mFlagManager;
@@ -1436,6 +1527,28 @@ private:
 
     bool mLayerLifecycleManagerEnabled = false;
     bool mLegacyFrontEndEnabled = true;
+    bool mParallelSnapshotBuilderEnabled = false;
+    // debug.sf.async_screenshots
+    bool mAsyncScreenshotsEnabled = false;
+    std::atomic<nsecs_t> mLastAsyncScreenshotTime = 0;
+    std::mutex mPublishedSnapshotsMutex;
+    std::shared_ptr<const std::vector<frontend::LayerSnapshot>> mPublishedSnapshots
+            GUARDED_BY(mPublishedSnapshotsMutex);
+    // Set by dumpsys --snapshot for the main thread to publish a DumpSnapshot at the end of the
+    // next frame.
+    std::atomic<bool> mDumpSnapshotRequested = false;
+    std::mutex mDumpSnapshotMutex;
+    std::condition_variable mDumpSnapshotCondition;
+    std::shared_ptr<const DumpSnapshot> mDumpSnapshot GUARDED_BY(mDumpSnapshotMutex);
+    // debug.sf.parallel_layer_proto: writes the layer protos of the subtrees of the hierarchy for
+    // dumps and traces on these threads. Only used from the main thread.
+    std::unique_ptr<frontend::WorkerPool> mLayerProtoWorkerPool;
+    // debug.sf.layer_trace_deltas
+    bool mLayerTraceDeltasEnabled = false;
+    // Whether the next frame notified to layer tracing as a delta needs the whole layer state,
+    // because tracing started, or the previous frame was not notified as a delta.
+    bool mLayerTraceNeedsFullState = true;
+    bool mLayerTraceHierarchyChanged = true;
 
     frontend::LayerLifecycleManager mLayerLifecycleManager;
     frontend::LayerHierarchyBuilder mLayerHierarchyBuilder{{}};
@@ -1549,6 +1662,9 @@ public:
                                         const gui::DisplayBrightness& brightness) override;
     binder::Status addHdrLayerInfoListener(const sp<IBinder>& displayToken,
                                            const sp<gui::IHdrLayerInfoListener>& listener) override;
+    binder::Status addHdrLayerInfoListenerWithOptions(
+            const sp<IBinder>& displayToken, const sp<gui::IHdrLayerInfoListener>& listener,
+            int64_t minUpdateIntervalNanos, float hysteresis) override;
     binder::Status removeHdrLayerInfoListener(
             const sp<IBinder>& displayToken,
             const sp<gui::IHdrLayerInfoListener>& listener) override;
@@ -101,7 +101,12 @@ std::unique_ptr<FrameTracer> DefaultFactory::createFrameTracer() {
 
 std::unique_ptr<frametimeline::FrameTimeline> DefaultFactory::createFrameTimeline(
         std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid) {
-    return std::make_unique<frametimeline::impl::FrameTimeline>(timeStats, surfaceFlingerPid);
+    const frametimeline::JankClassificationThresholds thresholds;
+    const bool pipelinedPresent = property_get_bool("debug.sf.frame_timeline_pipelined", false);
+    return std::make_unique<frametimeline::impl::FrameTimeline>(timeStats, surfaceFlingerPid,
+                                                                thresholds,
+                                                                /*useBootTimeClock=*/true,
+                                                                pipelinedPresent);
 }
 
 } // namespace android::surfaceflinger
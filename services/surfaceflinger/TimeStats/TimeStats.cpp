@@ -29,6 +29,7 @@
 #include <chrono>
 #include <cmath>
 #include <unordered_map>
+#include <utility>
 
 #include "TimeStats.h"
 #include "timestatsproto/TimeStatsHelper.h"
@@ -98,6 +99,7 @@ bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
         return false;
     }
     flushPowerTimeLocked();
+    mergeAccumulatorsLocked();
     SurfaceflingerStatsGlobalInfoWrapper atomList;
     for (const auto& globalSlice : mTimeStats.stats) {
         SurfaceflingerStatsGlobalInfo* atom = atomList.add_atom();
@@ -145,6 +147,7 @@ bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
 
 bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    mergeAccumulatorsLocked();
 
     std::vector<TimeStatsHelper::TimeStatsLayer*> dumpStats;
     uint32_t numLayers = 0;
@@ -319,8 +322,7 @@ void TimeStats::incrementTotalFrames() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.totalFramesLegacy++;
+    mGlobalAccumulator.totalFrames++;
 }
 
 void TimeStats::incrementMissedFrames() {
@@ -328,8 +330,7 @@ void TimeStats::incrementMissedFrames() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.missedFramesLegacy++;
+    mGlobalAccumulator.missedFrames++;
 }
 
 void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionRecord& record) {
@@ -339,12 +340,11 @@ void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionR
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (record.changed) mTimeStats.compositionStrategyChangesLegacy++;
-    if (record.hadClientComposition) mTimeStats.clientCompositionFramesLegacy++;
-    if (record.reused) mTimeStats.clientCompositionReusedFramesLegacy++;
-    if (record.predicted) mTimeStats.compositionStrategyPredictedLegacy++;
-    if (record.predictionSucceeded) mTimeStats.compositionStrategyPredictionSucceededLegacy++;
+    if (record.changed) mGlobalAccumulator.compositionStrategyChanges++;
+    if (record.hadClientComposition) mGlobalAccumulator.clientCompositionFrames++;
+    if (record.reused) mGlobalAccumulator.clientCompositionReusedFrames++;
+    if (record.predicted) mGlobalAccumulator.compositionStrategyPredicted++;
+    if (record.predictionSucceeded) mGlobalAccumulator.compositionStrategyPredictionSucceeded++;
 }
 
 void TimeStats::incrementRefreshRateSwitches() {
@@ -352,8 +352,7 @@ void TimeStats::incrementRefreshRateSwitches() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.refreshRateSwitchesLegacy++;
+    mGlobalAccumulator.refreshRateSwitches++;
 }
 
 void TimeStats::recordDisplayEventConnectionCount(int32_t count) {
@@ -361,9 +360,10 @@ void TimeStats::recordDisplayEventConnectionCount(int32_t count) {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.displayEventConnectionsCountLegacy =
-            std::max(mTimeStats.displayEventConnectionsCountLegacy, count);
+    std::atomic<int32_t>& maxCount = mGlobalAccumulator.displayEventConnectionsCount;
+    int32_t current = maxCount.load();
+    while (count > current && !maxCount.compare_exchange_weak(current, count)) {
+    }
 }
 
 static int32_t toMs(nsecs_t nanos) {
@@ -381,9 +381,8 @@ static int32_t msBetween(nsecs_t start, nsecs_t end) {
 void TimeStats::recordFrameDuration(nsecs_t startTime, nsecs_t endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (mPowerTime.powerMode == PowerMode::ON) {
-        mTimeStats.frameDurationLegacy.insert(msBetween(startTime, endTime));
+    if (mDisplayOn.load()) {
+        mGlobalAccumulator.frameDuration.insert(msBetween(startTime, endTime));
     }
 }
 
@@ -472,31 +471,24 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
               timeRecords[0].frameTime.frameNumber, timeRecords[0].frameTime.presentTime);
 
         if (prevTimeRecord.ready) {
-            uid_t uid = layerRecord.uid;
-            const std::string& layerName = layerRecord.layerName;
-            TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket, renderRateBucket};
-            if (!mTimeStats.stats.count(timelineKey)) {
-                mTimeStats.stats[timelineKey].key = timelineKey;
-            }
-
-            TimeStatsHelper::TimelineStats& displayStats = mTimeStats.stats[timelineKey];
-
-            TimeStatsHelper::LayerStatsKey layerKey = {uid, layerName, gameMode};
-            if (!displayStats.stats.count(layerKey)) {
-                displayStats.stats[layerKey].displayRefreshRateBucket = refreshRateBucket;
-                displayStats.stats[layerKey].renderRateBucket = renderRateBucket;
-                displayStats.stats[layerKey].uid = uid;
-                displayStats.stats[layerKey].layerName = layerName;
-                displayStats.stats[layerKey].gameMode = gameMode;
+            const TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket,
+                                                                   renderRateBucket};
+            const auto& cached = layerRecord.accumulator;
+            if (!cached || !(cached->timelineKey == timelineKey) ||
+                cached->layerKey.gameMode != gameMode) {
+                layerRecord.accumulator =
+                        getLayerAccumulatorLocked(timelineKey,
+                                                  {layerRecord.uid, layerRecord.layerName,
+                                                   gameMode});
             }
+            LayerAccumulator& accumulator = *layerRecord.accumulator;
             if (frameRateVote.frameRate > 0.0f) {
-                displayStats.stats[layerKey].setFrameRateVote = frameRateVote;
+                accumulator.setFrameRateVote = frameRateVote;
             }
-            TimeStatsHelper::TimeStatsLayer& timeStatsLayer = displayStats.stats[layerKey];
-            timeStatsLayer.totalFrames++;
-            timeStatsLayer.droppedFrames += layerRecord.droppedFrames;
-            timeStatsLayer.lateAcquireFrames += layerRecord.lateAcquireFrames;
-            timeStatsLayer.badDesiredPresentFrames += layerRecord.badDesiredPresentFrames;
+            accumulator.totalFrames++;
+            accumulator.droppedFrames += layerRecord.droppedFrames;
+            accumulator.lateAcquireFrames += layerRecord.lateAcquireFrames;
+            accumulator.badDesiredPresentFrames += layerRecord.badDesiredPresentFrames;
 
             layerRecord.droppedFrames = 0;
             layerRecord.lateAcquireFrames = 0;
@@ -506,41 +498,45 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
                                                       timeRecords[0].frameTime.acquireTime);
             ALOGV("[%d]-[%" PRIu64 "]-post2acquire[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, postToAcquireMs);
-            timeStatsLayer.deltas["post2acquire"].insert(postToAcquireMs);
+            accumulator.delta(LayerAccumulator::Delta::PostToAcquire).insert(postToAcquireMs);
 
             const int32_t postToPresentMs = msBetween(timeRecords[0].frameTime.postTime,
                                                       timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-post2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, postToPresentMs);
-            timeStatsLayer.deltas["post2present"].insert(postToPresentMs);
+            accumulator.delta(LayerAccumulator::Delta::PostToPresent).insert(postToPresentMs);
 
             const int32_t acquireToPresentMs = msBetween(timeRecords[0].frameTime.acquireTime,
                                                          timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-acquire2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, acquireToPresentMs);
-            timeStatsLayer.deltas["acquire2present"].insert(acquireToPresentMs);
+            accumulator.delta(LayerAccumulator::Delta::AcquireToPresent)
+                    .insert(acquireToPresentMs);
 
             const int32_t latchToPresentMs = msBetween(timeRecords[0].frameTime.latchTime,
                                                        timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-latch2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, latchToPresentMs);
-            timeStatsLayer.deltas["latch2present"].insert(latchToPresentMs);
+            accumulator.delta(LayerAccumulator::Delta::LatchToPresent).insert(latchToPresentMs);
 
             const int32_t desiredToPresentMs = msBetween(timeRecords[0].frameTime.desiredTime,
                                                          timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-desired2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, desiredToPresentMs);
-            timeStatsLayer.deltas["desired2present"].insert(desiredToPresentMs);
+            accumulator.delta(LayerAccumulator::Delta::DesiredToPresent)
+                    .insert(desiredToPresentMs);
 
             const int32_t presentToPresentMs = msBetween(prevTimeRecord.frameTime.presentTime,
                                                          timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-present2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, presentToPresentMs);
-            timeStatsLayer.deltas["present2present"].insert(presentToPresentMs);
+            accumulator.delta(LayerAccumulator::Delta::PresentToPresent)
+                    .insert(presentToPresentMs);
             if (prevPresentToPresentMs) {
                 const int32_t presentToPresentDeltaMs =
                         std::abs(presentToPresentMs - *prevPresentToPresentMs);
-                timeStatsLayer.deltas["present2presentDelta"].insert(presentToPresentDeltaMs);
+                accumulator.delta(LayerAccumulator::Delta::PresentToPresentDelta)
+                        .insert(presentToPresentDeltaMs);
             }
             prevPresentToPresentMs = presentToPresentMs;
         }
@@ -573,6 +569,105 @@ bool TimeStats::canAddNewAggregatedStats(uid_t uid, const std::string& layerName
     return layerRecords < MAX_NUM_LAYER_STATS;
 }
 
+void TimeStats::JankAccumulator::moveTo(TimeStatsHelper::JankPayload& payload) {
+    payload.totalFrames += totalFrames.exchange(0);
+    payload.totalJankyFrames += totalJankyFrames.exchange(0);
+    payload.totalSFLongCpu += totalSFLongCpu.exchange(0);
+    payload.totalSFLongGpu += totalSFLongGpu.exchange(0);
+    payload.totalSFUnattributed += totalSFUnattributed.exchange(0);
+    payload.totalAppUnattributed += totalAppUnattributed.exchange(0);
+    payload.totalSFScheduling += totalSFScheduling.exchange(0);
+    payload.totalSFPredictionError += totalSFPredictionError.exchange(0);
+    payload.totalAppBufferStuffing += totalAppBufferStuffing.exchange(0);
+}
+
+void TimeStats::LayerAccumulator::moveTo(TimeStatsHelper::TimeStatsLayer& layer) {
+    static constexpr std::array<const char*, kNumDeltas> kDeltaNames = {
+            "post2acquire",    "post2present",    "acquire2present",      "latch2present",
+            "desired2present", "present2present", "present2presentDelta", "appDeadlineDeltas",
+    };
+
+    layer.totalFrames += std::exchange(totalFrames, 0);
+    layer.droppedFrames += std::exchange(droppedFrames, 0);
+    layer.lateAcquireFrames += std::exchange(lateAcquireFrames, 0);
+    layer.badDesiredPresentFrames += std::exchange(badDesiredPresentFrames, 0);
+    if (setFrameRateVote.frameRate > 0.0f) {
+        layer.setFrameRateVote = std::exchange(setFrameRateVote, {});
+    }
+    jankPayload.moveTo(layer.jankPayload);
+    for (size_t i = 0; i < deltas.size(); i++) {
+        // Add the histograms that were only given negative deltas too, as inserting into deltas
+        // directly did.
+        if (deltas[i].hasInserts()) {
+            deltas[i].moveTo(layer.deltas[kDeltaNames[i]]);
+        }
+    }
+}
+
+std::shared_ptr<TimeStats::TimelineAccumulator> TimeStats::getTimelineAccumulatorLocked(
+        const TimeStatsHelper::TimelineStatsKey& timelineKey) {
+    auto& accumulator = mTimelineAccumulators[timelineKey];
+    if (!accumulator) {
+        accumulator = std::make_shared<TimelineAccumulator>();
+        mTimeStats.stats[timelineKey].key = timelineKey;
+    }
+    return accumulator;
+}
+
+std::shared_ptr<TimeStats::LayerAccumulator> TimeStats::getLayerAccumulatorLocked(
+        const TimeStatsHelper::TimelineStatsKey& timelineKey,
+        const TimeStatsHelper::LayerStatsKey& layerKey) {
+    auto& accumulator = getTimelineAccumulatorLocked(timelineKey)->layers[layerKey];
+    if (!accumulator) {
+        accumulator = std::make_shared<LayerAccumulator>();
+        accumulator->timelineKey = timelineKey;
+        accumulator->layerKey = layerKey;
+
+        TimeStatsHelper::TimelineStats& timelineStats = mTimeStats.stats[timelineKey];
+        if (!timelineStats.stats.count(layerKey)) {
+            TimeStatsHelper::TimeStatsLayer& layer = timelineStats.stats[layerKey];
+            layer.displayRefreshRateBucket = timelineKey.displayRefreshRateBucket;
+            layer.renderRateBucket = timelineKey.renderRateBucket;
+            layer.uid = layerKey.uid;
+            layer.layerName = layerKey.layerName;
+            layer.gameMode = layerKey.gameMode;
+        }
+    }
+    return accumulator;
+}
+
+void TimeStats::mergeAccumulatorsLocked() {
+    ATRACE_CALL();
+
+    mTimeStats.totalFramesLegacy += mGlobalAccumulator.totalFrames.exchange(0);
+    mTimeStats.missedFramesLegacy += mGlobalAccumulator.missedFrames.exchange(0);
+    mTimeStats.clientCompositionFramesLegacy +=
+            mGlobalAccumulator.clientCompositionFrames.exchange(0);
+    mTimeStats.clientCompositionReusedFramesLegacy +=
+            mGlobalAccumulator.clientCompositionReusedFrames.exchange(0);
+    mTimeStats.compositionStrategyChangesLegacy +=
+            mGlobalAccumulator.compositionStrategyChanges.exchange(0);
+    mTimeStats.compositionStrategyPredictedLegacy +=
+            mGlobalAccumulator.compositionStrategyPredicted.exchange(0);
+    mTimeStats.compositionStrategyPredictionSucceededLegacy +=
+            mGlobalAccumulator.compositionStrategyPredictionSucceeded.exchange(0);
+    mTimeStats.refreshRateSwitchesLegacy += mGlobalAccumulator.refreshRateSwitches.exchange(0);
+    mTimeStats.displayEventConnectionsCountLegacy =
+            std::max(mTimeStats.displayEventConnectionsCountLegacy,
+                     mGlobalAccumulator.displayEventConnectionsCount.exchange(0));
+    mGlobalAccumulator.frameDuration.moveTo(mTimeStats.frameDurationLegacy);
+
+    for (const auto& [timelineKey, timelineAccumulator] : mTimelineAccumulators) {
+        TimeStatsHelper::TimelineStats& timelineStats = mTimeStats.stats[timelineKey];
+        timelineAccumulator->jankPayload.moveTo(timelineStats.jankPayload);
+        timelineAccumulator->displayDeadlineDeltas.moveTo(timelineStats.displayDeadlineDeltas);
+        timelineAccumulator->displayPresentDeltas.moveTo(timelineStats.displayPresentDeltas);
+        for (const auto& [layerKey, layerAccumulator] : timelineAccumulator->layers) {
+            layerAccumulator->moveTo(timelineStats.stats[layerKey]);
+        }
+    }
+}
+
 void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::string& layerName,
                             uid_t uid, nsecs_t postTime, GameMode gameMode) {
     if (!mEnabled.load()) return;
@@ -815,7 +910,6 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
-    std::lock_guard<std::mutex> lock(mMutex);
 
     // Only update layer stats if we're already tracking the layer in TimeStats.
     // Otherwise, continue tracking the statistic but use a default layer name instead.
@@ -838,34 +932,30 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
                                  RENDER_RATE_BUCKET_WIDTH);
     const TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket, renderRateBucket};
 
-    if (!mTimeStats.stats.count(timelineKey)) {
-        mTimeStats.stats[timelineKey].key = timelineKey;
-    }
-
-    TimeStatsHelper::TimelineStats& timelineStats = mTimeStats.stats[timelineKey];
-
-    updateJankPayload<TimeStatsHelper::TimelineStats>(timelineStats, info.reasons);
+    std::shared_ptr<TimelineAccumulator> timelineAccumulator;
+    std::shared_ptr<LayerAccumulator> layerAccumulator;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        timelineAccumulator = getTimelineAccumulatorLocked(timelineKey);
 
-    TimeStatsHelper::LayerStatsKey layerKey = {info.uid, info.layerName, info.gameMode};
-    if (!timelineStats.stats.count(layerKey)) {
-        layerKey = {info.uid, kDefaultLayerName, kDefaultGameMode};
-        timelineStats.stats[layerKey].displayRefreshRateBucket = refreshRateBucket;
-        timelineStats.stats[layerKey].renderRateBucket = renderRateBucket;
-        timelineStats.stats[layerKey].uid = info.uid;
-        timelineStats.stats[layerKey].layerName = kDefaultLayerName;
-        timelineStats.stats[layerKey].gameMode = kDefaultGameMode;
+        TimeStatsHelper::LayerStatsKey layerKey = {info.uid, info.layerName, info.gameMode};
+        if (!mTimeStats.stats[timelineKey].stats.count(layerKey)) {
+            layerKey = {info.uid, kDefaultLayerName, kDefaultGameMode};
+        }
+        layerAccumulator = getLayerAccumulatorLocked(timelineKey, layerKey);
     }
 
-    TimeStatsHelper::TimeStatsLayer& timeStatsLayer = timelineStats.stats[layerKey];
-    updateJankPayload<TimeStatsHelper::TimeStatsLayer>(timeStatsLayer, info.reasons);
+    updateJankPayload<TimelineAccumulator>(*timelineAccumulator, info.reasons);
+    updateJankPayload<LayerAccumulator>(*layerAccumulator, info.reasons);
 
     if (info.reasons & kValidJankyReason) {
         // TimeStats Histograms only retain positive values, so we don't need to check if these
         // deadlines were really missed if we know that the frame had jank, since deadlines
         // that were met will be dropped.
-        timelineStats.displayDeadlineDeltas.insert(toMs(info.displayDeadlineDelta));
-        timelineStats.displayPresentDeltas.insert(toMs(info.displayPresentJitter));
-        timeStatsLayer.deltas["appDeadlineDeltas"].insert(toMs(info.appDeadlineDelta));
+        timelineAccumulator->displayDeadlineDeltas.insert(toMs(info.displayDeadlineDelta));
+        timelineAccumulator->displayPresentDeltas.insert(toMs(info.displayPresentJitter));
+        layerAccumulator->delta(LayerAccumulator::Delta::AppDeadlineDeltas)
+                .insert(toMs(info.appDeadlineDelta));
     }
 }
 
@@ -924,6 +1014,7 @@ void TimeStats::setPowerMode(PowerMode powerMode) {
     if (!mEnabled.load()) {
         std::lock_guard<std::mutex> lock(mMutex);
         mPowerTime.powerMode = powerMode;
+        mDisplayOn = powerMode == PowerMode::ON;
         return;
     }
 
@@ -932,6 +1023,7 @@ void TimeStats::setPowerMode(PowerMode powerMode) {
 
     flushPowerTimeLocked();
     mPowerTime.powerMode = powerMode;
+    mDisplayOn = powerMode == PowerMode::ON;
 }
 
 void TimeStats::recordRefreshRate(uint32_t fps, nsecs_t duration) {
@@ -1054,6 +1146,7 @@ void TimeStats::disable() {
 
 void TimeStats::clearAll() {
     std::lock_guard<std::mutex> lock(mMutex);
+    mTimelineAccumulators.clear();
     mTimeStats.stats.clear();
     clearGlobalLocked();
     clearLayersLocked();
@@ -1062,6 +1155,9 @@ void TimeStats::clearAll() {
 void TimeStats::clearGlobalLocked() {
     ATRACE_CALL();
 
+    // Drop what was accumulated since the last merge along with the merged stats.
+    mergeAccumulatorsLocked();
+
     mTimeStats.statsStartLegacy = (mEnabled.load() ? static_cast<int64_t>(std::time(0)) : 0);
     mTimeStats.statsEndLegacy = 0;
     mTimeStats.totalFramesLegacy = 0;
@@ -1095,6 +1191,9 @@ void TimeStats::clearLayersLocked() {
     for (auto& globalRecord : mTimeStats.stats) {
         globalRecord.second.stats.clear();
     }
+    for (auto& timelineAccumulator : mTimelineAccumulators) {
+        timelineAccumulator.second->layers.clear();
+    }
     ALOGD("Cleared layer stats");
 }
 
@@ -1113,6 +1212,7 @@ void TimeStats::dump(bool asProto, std::optional<uint32_t> maxLayers, std::strin
     mTimeStats.statsEndLegacy = static_cast<int64_t>(std::time(0));
 
     flushPowerTimeLocked();
+    mergeAccumulatorsLocked();
 
     if (asProto) {
         ALOGD("Dumping TimeStats as proto");
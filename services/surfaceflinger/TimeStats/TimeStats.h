@@ -16,8 +16,11 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
@@ -207,6 +210,81 @@ class TimeStats : public android::TimeStats {
         std::shared_ptr<FenceTime> presentFence;
     };
 
+    // The accumulators below are updated without holding mMutex, except where noted, and are
+    // merged into mTimeStats when the stats are pulled, dumped or cleared, so that the callers on
+    // the main thread and binder threads neither wait for a pull nor look up the aggregated stats
+    // by name on every frame.
+    struct JankAccumulator {
+        std::atomic<int32_t> totalFrames = 0;
+        std::atomic<int32_t> totalJankyFrames = 0;
+        std::atomic<int32_t> totalSFLongCpu = 0;
+        std::atomic<int32_t> totalSFLongGpu = 0;
+        std::atomic<int32_t> totalSFUnattributed = 0;
+        std::atomic<int32_t> totalAppUnattributed = 0;
+        std::atomic<int32_t> totalSFScheduling = 0;
+        std::atomic<int32_t> totalSFPredictionError = 0;
+        std::atomic<int32_t> totalAppBufferStuffing = 0;
+
+        void moveTo(TimeStatsHelper::JankPayload& payload);
+    };
+
+    struct LayerAccumulator {
+        // The keys of TimeStatsHelper::TimeStatsLayer::deltas, in order.
+        enum class Delta {
+            PostToAcquire,
+            PostToPresent,
+            AcquireToPresent,
+            LatchToPresent,
+            DesiredToPresent,
+            PresentToPresent,
+            PresentToPresentDelta,
+            AppDeadlineDeltas,
+            ftl_last = AppDeadlineDeltas
+        };
+        static constexpr size_t kNumDeltas = static_cast<size_t>(Delta::ftl_last) + 1;
+
+        TimeStatsHelper::AtomicHistogram& delta(Delta delta) {
+            return deltas[static_cast<size_t>(delta)];
+        }
+        void moveTo(TimeStatsHelper::TimeStatsLayer& layer);
+
+        TimeStatsHelper::TimelineStatsKey timelineKey;
+        TimeStatsHelper::LayerStatsKey layerKey;
+        // Only updated when the records of the layer are flushed, so guarded by mMutex.
+        int32_t totalFrames = 0;
+        int32_t droppedFrames = 0;
+        int32_t lateAcquireFrames = 0;
+        int32_t badDesiredPresentFrames = 0;
+        TimeStatsHelper::SetFrameRateVote setFrameRateVote;
+
+        JankAccumulator jankPayload;
+        std::array<TimeStatsHelper::AtomicHistogram, kNumDeltas> deltas;
+    };
+
+    struct TimelineAccumulator {
+        JankAccumulator jankPayload;
+        TimeStatsHelper::AtomicHistogram displayDeadlineDeltas;
+        TimeStatsHelper::AtomicHistogram displayPresentDeltas;
+        // Guarded by mMutex.
+        std::unordered_map<TimeStatsHelper::LayerStatsKey, std::shared_ptr<LayerAccumulator>,
+                           TimeStatsHelper::LayerStatsKey::Hasher>
+                layers;
+    };
+
+    struct GlobalAccumulator {
+        std::atomic<int32_t> totalFrames = 0;
+        std::atomic<int32_t> missedFrames = 0;
+        std::atomic<int32_t> clientCompositionFrames = 0;
+        std::atomic<int32_t> clientCompositionReusedFrames = 0;
+        std::atomic<int32_t> compositionStrategyChanges = 0;
+        std::atomic<int32_t> compositionStrategyPredicted = 0;
+        std::atomic<int32_t> compositionStrategyPredictionSucceeded = 0;
+        std::atomic<int32_t> refreshRateSwitches = 0;
+        // The maximum count since the last merge.
+        std::atomic<int32_t> displayEventConnectionsCount = 0;
+        TimeStatsHelper::AtomicHistogram frameDuration;
+    };
+
     struct LayerRecord {
         uid_t uid;
         std::string layerName;
@@ -221,6 +299,8 @@ class TimeStats : public android::TimeStats {
         TimeRecord prevTimeRecord;
         std::optional<int32_t> prevPresentToPresentMs;
         std::deque<TimeRecord> timeRecords;
+        // The accumulator of the last flushed frame, which most frames reuse.
+        std::shared_ptr<LayerAccumulator> accumulator;
     };
 
     struct PowerTime {
@@ -302,6 +382,14 @@ private:
     void flushPowerTimeLocked();
     void flushAvailableGlobalRecordsToStatsLocked();
     bool canAddNewAggregatedStats(uid_t uid, const std::string& layerName, GameMode);
+    // Returns the accumulators for the keys, and adds the stats they are merged into to mTimeStats
+    // if needed.
+    std::shared_ptr<TimelineAccumulator> getTimelineAccumulatorLocked(
+            const TimeStatsHelper::TimelineStatsKey& timelineKey);
+    std::shared_ptr<LayerAccumulator> getLayerAccumulatorLocked(
+            const TimeStatsHelper::TimelineStatsKey& timelineKey,
+            const TimeStatsHelper::LayerStatsKey& layerKey);
+    void mergeAccumulatorsLocked();
 
     void enable();
     void disable();
@@ -316,7 +404,13 @@ private:
     // Hashmap for LayerRecord with layerId as the hash key
     std::unordered_map<int32_t, LayerRecord> mTimeStatsTracker;
     PowerTime mPowerTime;
+    // Mirrors mPowerTime.powerMode == PowerMode::ON for the callers that do not take mMutex.
+    std::atomic<bool> mDisplayOn = false;
     GlobalRecord mGlobalRecord;
+    GlobalAccumulator mGlobalAccumulator;
+    std::unordered_map<TimeStatsHelper::TimelineStatsKey, std::shared_ptr<TimelineAccumulator>,
+                       TimeStatsHelper::TimelineStatsKey::Hasher>
+            mTimelineAccumulators;
 
     static const size_t MAX_NUM_LAYER_RECORDS = 200;
 
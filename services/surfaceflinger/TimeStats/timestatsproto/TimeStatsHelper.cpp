@@ -21,8 +21,6 @@
 #include <array>
 #include <cinttypes>
 
-#define HISTOGRAM_SIZE 85
-
 using android::base::StringAppendF;
 using android::base::StringPrintf;
 
@@ -31,22 +29,26 @@ namespace surfaceflinger {
 
 // Time buckets for histogram, the calculated time deltas will be lower bounded
 // to the buckets in this array.
-static const std::array<int32_t, HISTOGRAM_SIZE> histogramConfig =
+static const std::array<int32_t, TimeStatsHelper::kHistogramSize> histogramConfig =
         {0,   1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,  15,  16,
          17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,  32,  33,
          34,  36,  38,  40,  42,  44,  46,  48,  50,  54,  58,  62,  66,  70,  74,  78,  82,
          86,  90,  94,  98,  102, 106, 110, 114, 118, 122, 126, 130, 134, 138, 142, 146, 150,
          200, 250, 300, 350, 400, 450, 500, 550, 600, 650, 700, 750, 800, 850, 900, 950, 1000};
 
-void TimeStatsHelper::Histogram::insert(int32_t delta) {
-    if (delta < 0) return;
+// Returns the index of the bucket of a non-negative delta.
+static size_t bucketIndex(int32_t delta) {
     // std::lower_bound won't work on out of range values
-    if (delta > histogramConfig[HISTOGRAM_SIZE - 1]) {
-        hist[histogramConfig[HISTOGRAM_SIZE - 1]]++;
-        return;
+    if (delta > histogramConfig.back()) {
+        return histogramConfig.size() - 1;
     }
     auto iter = std::lower_bound(histogramConfig.begin(), histogramConfig.end(), delta);
-    hist[*iter]++;
+    return static_cast<size_t>(iter - histogramConfig.begin());
+}
+
+void TimeStatsHelper::Histogram::insert(int32_t delta) {
+    if (delta < 0) return;
+    hist[histogramConfig[bucketIndex(delta)]]++;
 }
 
 int64_t TimeStatsHelper::Histogram::totalTime() const {
@@ -69,7 +71,7 @@ float TimeStatsHelper::Histogram::averageTime() const {
 
 std::string TimeStatsHelper::Histogram::toString() const {
     std::string result;
-    for (int32_t i = 0; i < HISTOGRAM_SIZE; ++i) {
+    for (size_t i = 0; i < histogramConfig.size(); ++i) {
         int32_t bucket = histogramConfig[i];
         int32_t count = (hist.count(bucket) == 0) ? 0 : hist.at(bucket);
         StringAppendF(&result, "%dms=%d ", bucket, count);
@@ -78,6 +80,21 @@ std::string TimeStatsHelper::Histogram::toString() const {
     return result;
 }
 
+void TimeStatsHelper::AtomicHistogram::insert(int32_t delta) {
+    mHasInserts.store(true, std::memory_order_relaxed);
+    if (delta < 0) return;
+    mCounts[bucketIndex(delta)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void TimeStatsHelper::AtomicHistogram::moveTo(Histogram& histogram) {
+    mHasInserts.store(false, std::memory_order_relaxed);
+    for (size_t i = 0; i < mCounts.size(); ++i) {
+        if (const int32_t count = mCounts[i].exchange(0, std::memory_order_relaxed); count > 0) {
+            histogram.hist[histogramConfig[i]] += count;
+        }
+    }
+}
+
 std::string TimeStatsHelper::JankPayload::toString() const {
     std::string result;
     StringAppendF(&result, "totalTimelineFrames = %d\n", totalFrames);
@@ -19,6 +19,8 @@
 #include <timestatsproto/TimeStatsProtoHeader.h>
 #include <utils/Timers.h>
 
+#include <array>
+#include <atomic>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -32,6 +34,8 @@ namespace surfaceflinger {
 
 class TimeStatsHelper {
 public:
+    static constexpr size_t kHistogramSize = 85;
+
     class Histogram {
     public:
         // Key is the delta time between timestamps
@@ -44,6 +48,22 @@ public:
         std::string toString() const;
     };
 
+    // A Histogram with a fixed array of atomic buckets, so deltas can be inserted from any thread
+    // without a lock. The counts are moved to a Histogram when the stats are pulled or dumped.
+    class AtomicHistogram {
+    public:
+        void insert(int32_t delta);
+        // Whether insert was called since the last moveTo, even if the delta was dropped.
+        bool hasInserts() const { return mHasInserts.load(std::memory_order_relaxed); }
+        // Adds the counts to histogram and resets them. Deltas inserted concurrently are either
+        // moved or left for the next call.
+        void moveTo(Histogram& histogram);
+
+    private:
+        std::atomic<bool> mHasInserts = false;
+        std::array<std::atomic<int32_t>, kHistogramSize> mCounts{};
+    };
+
     struct JankPayload {
         // note that transactions are counted for these frames.
         int32_t totalFrames = 0;
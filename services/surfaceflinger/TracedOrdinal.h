@@ -62,7 +62,16 @@ public:
                   "it to the list.");
 
     TracedOrdinal(std::string name, T initialValue)
-          : mName(std::move(name)), mHasGoneNegative(signbit(initialValue)), mData(initialValue) {
+          : mNameStorage(std::move(name)),
+            mHasGoneNegative(signbit(initialValue)),
+            mData(initialValue) {
+        trace();
+    }
+
+    // Refers to the name instead of copying it, so that constructing a TracedOrdinal on a hot path
+    // does not allocate. The name must outlive the TracedOrdinal, which a string literal does.
+    TracedOrdinal(const char* name, T initialValue)
+          : mLiteralName(name), mHasGoneNegative(signbit(initialValue)), mData(initialValue) {
         trace();
     }
 
@@ -84,21 +93,24 @@ private:
         }
 
         if (mNameNegative.empty()) {
-            mNameNegative = mName + "Negative";
+            mNameNegative = std::string(traceName()) + "Negative";
         }
 
         if (!signbit(mData)) {
-            ATRACE_INT64(mName.c_str(), to_int64(mData));
+            ATRACE_INT64(traceName(), to_int64(mData));
             if (mHasGoneNegative) {
                 ATRACE_INT64(mNameNegative.c_str(), 0);
             }
         } else {
             ATRACE_INT64(mNameNegative.c_str(), -to_int64(mData));
-            ATRACE_INT64(mName.c_str(), 0);
+            ATRACE_INT64(traceName(), 0);
         }
     }
 
-    const std::string mName;
+    const char* traceName() const { return mLiteralName ? mLiteralName : mNameStorage.c_str(); }
+
+    const std::string mNameStorage;
+    const char* const mLiteralName = nullptr;
     std::string mNameNegative;
     bool mHasGoneNegative;
     T mData;
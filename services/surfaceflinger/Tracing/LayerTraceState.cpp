@@ -0,0 +1,259 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LayerTracing"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <unordered_set>
+
+#include <utils/Trace.h>
+
+#include "LayerProtoHelper.h"
+#include "LayerTraceState.h"
+#include "LayerTracing.h"
+
+namespace android::surfaceflinger {
+
+namespace {
+
+using frontend::LayerHierarchy;
+using frontend::LayerSnapshot;
+using frontend::RequestedLayerState;
+
+class DeltaRecorder {
+public:
+    DeltaRecorder(LayerTraceDelta& delta, frontend::LayerSnapshotBuilder& snapshotBuilder,
+                  frontend::LayerLifecycleManager& lifecycleManager)
+          : mDelta(delta), mSnapshotBuilder(snapshotBuilder), mLifecycleManager(lifecycleManager) {}
+
+    void recordSnapshots(bool fullState) {
+        for (const auto& snapshot : mSnapshotBuilder.getSnapshots()) {
+            if (!fullState && snapshot->changes.get() == 0) {
+                continue;
+            }
+            mDelta.snapshots.push_back(std::make_shared<const LayerSnapshot>(*snapshot));
+            recordRequestedState(snapshot->path.id);
+        }
+    }
+
+    // Walks the hierarchy in the same order as LayerProtoFromSnapshotGenerator.
+    void recordHierarchy(const LayerHierarchy& root) {
+        mDelta.hierarchy.emplace();
+        LayerHierarchy::TraversalPath path = LayerHierarchy::TraversalPath::ROOT;
+        for (const auto& [child, variant] : root.mChildren) {
+            if (variant != LayerHierarchy::Variant::Attached) {
+                continue;
+            }
+            LayerHierarchy::ScopedAddToTraversalPath addChildToPath(path, child->getLayer()->id,
+                                                                    variant);
+            recordHierarchy(*child, path, /*isRoot=*/true);
+        }
+    }
+
+private:
+    void recordHierarchy(const LayerHierarchy& hierarchy, LayerHierarchy::TraversalPath& path,
+                         bool isRoot) {
+        using Variant = LayerHierarchy::Variant;
+        const RequestedLayerState& layer = *hierarchy.getLayer();
+        LayerTraceDelta::Node node{.path = path, .layerId = layer.id, .isRoot = isRoot};
+        getUniqueSequence(path, layer);
+
+        for (const auto& [child, variant] : hierarchy.mChildren) {
+            LayerHierarchy::ScopedAddToTraversalPath addChildToPath(path, child->getLayer()->id,
+                                                                    variant);
+            const uint32_t childSequence = getUniqueSequence(path, *child->getLayer());
+            if (variant == Variant::Attached || variant == Variant::Detached ||
+                variant == Variant::Mirror) {
+                node.children.push_back(childSequence);
+            } else if (variant == Variant::Relative) {
+                node.relatives.push_back(childSequence);
+            }
+        }
+        mDelta.hierarchy->push_back(std::move(node));
+
+        for (const auto& [child, variant] : hierarchy.mChildren) {
+            // avoid visiting relative layers twice
+            if (variant == Variant::Detached) {
+                continue;
+            }
+            LayerHierarchy::ScopedAddToTraversalPath addChildToPath(path, child->getLayer()->id,
+                                                                    variant);
+            recordHierarchy(*child, path, /*isRoot=*/false);
+        }
+    }
+
+    // winscope expects all the layers, so layers without a snapshot are traced with a default one.
+    uint32_t getUniqueSequence(const LayerHierarchy::TraversalPath& path,
+                               const RequestedLayerState& layer) {
+        if (const LayerSnapshot* snapshot = mSnapshotBuilder.getSnapshot(path)) {
+            return snapshot->uniqueSequence;
+        }
+        auto it = mDefaultSnapshots.find(path);
+        if (it == mDefaultSnapshots.end()) {
+            auto snapshot = std::make_shared<const LayerSnapshot>(layer, path);
+            it = mDefaultSnapshots.emplace(path, snapshot).first;
+            mDelta.snapshots.push_back(std::move(snapshot));
+            recordRequestedState(layer.id);
+        }
+        return it->second->uniqueSequence;
+    }
+
+    void recordRequestedState(uint32_t layerId) {
+        if (!mRecordedLayers.insert(layerId).second) {
+            return;
+        }
+        if (const RequestedLayerState* layer = mLifecycleManager.getLayerFromId(layerId)) {
+            mDelta.requestedStates.push_back(std::make_shared<const RequestedLayerState>(*layer));
+        }
+    }
+
+    LayerTraceDelta& mDelta;
+    frontend::LayerSnapshotBuilder& mSnapshotBuilder;
+    frontend::LayerLifecycleManager& mLifecycleManager;
+    std::unordered_set<uint32_t> mRecordedLayers;
+    std::unordered_map<LayerHierarchy::TraversalPath, std::shared_ptr<const LayerSnapshot>,
+                       LayerHierarchy::TraversalPathHash>
+            mDefaultSnapshots;
+};
+
+} // namespace
+
+LayerTraceDelta LayerTraceDelta::record(const frontend::LayerHierarchy& root,
+                                        frontend::LayerSnapshotBuilder& snapshotBuilder,
+                                        frontend::LayerLifecycleManager& lifecycleManager,
+                                        bool hierarchyChanged, bool fullState) {
+    ATRACE_CALL();
+    LayerTraceDelta delta;
+    delta.isFullState = fullState;
+    DeltaRecorder recorder(delta, snapshotBuilder, lifecycleManager);
+    recorder.recordSnapshots(fullState);
+    if (hierarchyChanged || fullState) {
+        recorder.recordHierarchy(root);
+    }
+    return delta;
+}
+
+bool LayerTraceState::apply(LayerTraceDelta&& delta) {
+    if (delta.isFullState) {
+        mHierarchy.clear();
+        mSnapshots.clear();
+        mRequestedStates.clear();
+        mSnapshotsWithDamage.clear();
+        mHasFullState = true;
+    } else if (!mHasFullState) {
+        return false;
+    }
+
+    for (const auto& path : mSnapshotsWithDamage) {
+        auto it = mSnapshots.find(path);
+        if (it == mSnapshots.end()) {
+            continue;
+        }
+        auto snapshot = std::make_shared<LayerSnapshot>(*it->second);
+        snapshot->contentDirty = false;
+        snapshot->surfaceDamage.clear();
+        it->second = std::move(snapshot);
+    }
+    mSnapshotsWithDamage.clear();
+
+    for (auto& snapshot : delta.snapshots) {
+        if (snapshot->contentDirty || !snapshot->surfaceDamage.isEmpty()) {
+            mSnapshotsWithDamage.push_back(snapshot->path);
+        }
+        mSnapshots[snapshot->path] = std::move(snapshot);
+    }
+    for (auto& layer : delta.requestedStates) {
+        mRequestedStates[layer->id] = std::move(layer);
+    }
+
+    if (delta.hierarchy) {
+        mHierarchy = std::move(*delta.hierarchy);
+
+        // Forget the layers that left the hierarchy, e.g. because they were destroyed.
+        std::unordered_set<LayerHierarchy::TraversalPath, LayerHierarchy::TraversalPathHash> paths;
+        std::unordered_set<uint32_t> layerIds;
+        for (const auto& node : mHierarchy) {
+            paths.insert(node.path);
+            layerIds.insert(node.layerId);
+        }
+        std::erase_if(mSnapshots, [&](const auto& entry) { return !paths.count(entry.first); });
+        std::erase_if(mRequestedStates,
+                      [&](const auto& entry) { return !layerIds.count(entry.first); });
+    }
+    return true;
+}
+
+LayersProto LayerTraceState::generate(
+        uint32_t traceFlags,
+        const google::protobuf::RepeatedPtrField<DisplayProto>& displays) const {
+    ATRACE_CALL();
+    std::unordered_set<uint64_t> stackIdsToSkip;
+    if ((traceFlags & LayerTracing::TRACE_VIRTUAL_DISPLAYS) == 0) {
+        for (const auto& display : displays) {
+            if (display.is_virtual()) {
+                stackIdsToSkip.insert(display.layer_stack());
+            }
+        }
+    }
+
+    LayersProto layersProto;
+    std::unordered_map<uint32_t /* child unique seq*/, uint32_t /* relative parent unique seq*/>
+            childToRelativeParent;
+    std::unordered_map<uint32_t /* child unique seq*/, uint32_t /* parent unique seq*/>
+            childToParent;
+    bool skipRoot = false;
+    for (const auto& node : mHierarchy) {
+        const auto snapshotIt = mSnapshots.find(node.path);
+        const auto layerIt = mRequestedStates.find(node.layerId);
+        // Every layer of the hierarchy is recorded before the hierarchy refers to it, so this
+        // only skips layers if a delta was lost.
+        const bool isRecorded =
+                snapshotIt != mSnapshots.end() && layerIt != mRequestedStates.end();
+        if (node.isRoot) {
+            skipRoot = !isRecorded ||
+                    stackIdsToSkip.find(layerIt->second->layerStack.id) != stackIdsToSkip.end();
+        }
+        if (!isRecorded || skipRoot) {
+            continue;
+        }
+        const LayerSnapshot& snapshot = *snapshotIt->second;
+        const RequestedLayerState& layer = *layerIt->second;
+
+        LayerProto* layerProto = layersProto.add_layers();
+        LayerProtoHelper::writeSnapshotToProto(layerProto, layer, snapshot, traceFlags);
+        for (const uint32_t child : node.children) {
+            childToParent[child] = snapshot.uniqueSequence;
+            layerProto->add_children(child);
+        }
+        for (const uint32_t relative : node.relatives) {
+            childToRelativeParent[relative] = snapshot.uniqueSequence;
+            layerProto->add_relatives(relative);
+        }
+    }
+
+    // fill in relative and parent info
+    for (int i = 0; i < layersProto.layers_size(); i++) {
+        auto layerProto = layersProto.mutable_layers()->Mutable(i);
+        auto it = childToRelativeParent.find(layerProto->id());
+        layerProto->set_z_order_relative_of(it == childToRelativeParent.end() ? -1 : it->second);
+        it = childToParent.find(layerProto->id());
+        layerProto->set_parent(it == childToParent.end() ? -1 : it->second);
+    }
+    return layersProto;
+}
+
+} // namespace android::surfaceflinger
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <layerproto/LayerProtoHeader.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FrontEnd/LayerHierarchy.h"
+#include "FrontEnd/LayerLifecycleManager.h"
+#include "FrontEnd/LayerSnapshot.h"
+#include "FrontEnd/LayerSnapshotBuilder.h"
+#include "FrontEnd/RequestedLayerState.h"
+
+namespace android::surfaceflinger {
+
+// The layer state of one frame of a layer trace, relative to the previous frame. Only the
+// snapshots that changed are copied, with the requested states of their layers, and the hierarchy
+// is only copied when it changed, so recording a frame on the main thread costs a few copies
+// instead of building a LayersProto.
+struct LayerTraceDelta {
+    // A layer of the hierarchy. The nodes are in the order in which the layers are written to
+    // the trace.
+    struct Node {
+        frontend::LayerHierarchy::TraversalPath path;
+        uint32_t layerId;
+        // Whether the layer is a child of the root of the hierarchy.
+        bool isRoot = false;
+        // Unique sequences of the children and relative children of the layer.
+        std::vector<uint32_t> children;
+        std::vector<uint32_t> relatives;
+    };
+
+    int64_t time = 0;
+    int64_t vsyncId = 0;
+    bool visibleRegionDirty = false;
+    uint32_t traceFlags = 0;
+    // Whether the delta holds the whole state, as the first frame of a trace does.
+    bool isFullState = false;
+    std::vector<std::shared_ptr<const frontend::LayerSnapshot>> snapshots;
+    std::vector<std::shared_ptr<const frontend::RequestedLayerState>> requestedStates;
+    std::optional<std::vector<Node>> hierarchy;
+    std::string hwcDump;
+    google::protobuf::RepeatedPtrField<DisplayProto> displays;
+
+    // Copies the snapshots that changed in the last snapshot update, or all of them if fullState
+    // is set, and the hierarchy if it changed.
+    static LayerTraceDelta record(const frontend::LayerHierarchy& root,
+                                  frontend::LayerSnapshotBuilder& snapshotBuilder,
+                                  frontend::LayerLifecycleManager& lifecycleManager,
+                                  bool hierarchyChanged, bool fullState);
+};
+
+// The layer state rebuilt from the deltas recorded by the main thread. Builds the same LayersProto
+// as LayerProtoFromSnapshotGenerator does from the live state, except for the composition state,
+// which is only available from the Layer objects on the main thread.
+//
+// This class is not thread-safe; it is only used on the layer tracing thread.
+class LayerTraceState {
+public:
+    // Returns false if the delta is dropped because the state has not been recorded in full yet.
+    bool apply(LayerTraceDelta&& delta);
+    // Layers on the layer stacks of virtual displays are skipped unless TRACE_VIRTUAL_DISPLAYS is
+    // set in traceFlags.
+    LayersProto generate(uint32_t traceFlags,
+                         const google::protobuf::RepeatedPtrField<DisplayProto>& displays) const;
+
+private:
+    bool mHasFullState = false;
+    std::vector<LayerTraceDelta::Node> mHierarchy;
+    std::unordered_map<frontend::LayerHierarchy::TraversalPath,
+                       std::shared_ptr<const frontend::LayerSnapshot>,
+                       frontend::LayerHierarchy::TraversalPathHash>
+            mSnapshots;
+    std::unordered_map<uint32_t /* layerId */, std::shared_ptr<const frontend::RequestedLayerState>>
+            mRequestedStates;
+    // The snapshot builder clears the damage of all snapshots before each update, without marking
+    // them as changed, so the damage of the snapshots copied by the previous delta is cleared here.
+    std::vector<frontend::LayerHierarchy::TraversalPath> mSnapshotsWithDamage;
+};
+
+} // namespace android::surfaceflinger
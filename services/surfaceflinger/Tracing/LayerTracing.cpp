@@ -18,6 +18,7 @@
 #define LOG_TAG "LayerTracing"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <cinttypes>
 #include <filesystem>
 
 #include <SurfaceFlinger.h>
@@ -34,24 +35,35 @@ namespace android {
 LayerTracing::LayerTracing()
       : mBuffer(std::make_unique<RingBuffer<LayersTraceFileProto, LayersTraceProto>>()) {}
 
-LayerTracing::~LayerTracing() = default;
+LayerTracing::~LayerTracing() {
+    stopThread();
+}
 
 bool LayerTracing::enable() {
-    std::scoped_lock lock(mTraceLock);
-    if (mEnabled) {
-        return false;
+    {
+        std::scoped_lock lock(mTraceLock);
+        if (mEnabled) {
+            return false;
+        }
+        mBuffer->setSize(mBufferSizeInBytes);
+        mEnabled = true;
     }
-    mBuffer->setSize(mBufferSizeInBytes);
-    mEnabled = true;
+    startThread();
     return true;
 }
 
 bool LayerTracing::disable(std::string filename, bool writeToFile) {
-    std::scoped_lock lock(mTraceLock);
-    if (!mEnabled) {
-        return false;
+    {
+        std::scoped_lock lock(mTraceLock);
+        if (!mEnabled) {
+            return false;
+        }
+        mEnabled = false;
     }
-    mEnabled = false;
+    // Adds the entries of the deltas notified before tracing was disabled.
+    stopThread();
+
+    std::scoped_lock lock(mTraceLock);
     if (writeToFile) {
         LayersTraceFileProto fileProto = createTraceFileProto();
         mBuffer->writeToFile(fileProto, filename);
@@ -61,6 +73,7 @@ bool LayerTracing::disable(std::string filename, bool writeToFile) {
 }
 
 void LayerTracing::appendToStream(std::ofstream& out) {
+    waitForDeltas();
     std::scoped_lock lock(mTraceLock);
     LayersTraceFileProto fileProto = createTraceFileProto();
     mBuffer->appendToStream(fileProto, out);
@@ -73,6 +86,7 @@ bool LayerTracing::isEnabled() const {
 }
 
 status_t LayerTracing::writeToFile(std::string filename) {
+    waitForDeltas();
     std::scoped_lock lock(mTraceLock);
     if (!mEnabled) {
         return STATUS_OK;
@@ -112,11 +126,32 @@ void LayerTracing::dump(std::string& result) const {
     std::scoped_lock lock(mTraceLock);
     base::StringAppendF(&result, "Tracing state: %s\n", mEnabled ? "enabled" : "disabled");
     mBuffer->dump(result);
+    base::StringAppendF(&result, "Delta queue overflows: %" PRIu64 "\n",
+                        mDeltas.getOverflowPushCount());
+}
+
+LayersTraceProto LayerTracing::createEntry(bool visibleRegionDirty, int64_t time, int64_t vsyncId,
+                                           uint32_t traceFlags, std::string hwcDump) {
+    LayersTraceProto entry;
+    entry.set_elapsed_realtime_nanos(time);
+    const char* where = visibleRegionDirty ? "visibleRegionsDirty" : "bufferLatched";
+    entry.set_where(where);
+
+    if (traceFlags & LayerTracing::TRACE_HWC) {
+        entry.set_hwc_blob(std::move(hwcDump));
+    }
+    if (!(traceFlags & LayerTracing::TRACE_COMPOSITION)) {
+        entry.set_excludes_composition_state(true);
+    }
+    entry.set_vsync_id(vsyncId);
+    return entry;
 }
 
 void LayerTracing::notify(bool visibleRegionDirty, int64_t time, int64_t vsyncId,
                           LayersProto* layers, std::string hwcDump,
                           google::protobuf::RepeatedPtrField<DisplayProto>* displays) {
+    // Keeps the entries in order if the previous frames were notified as deltas.
+    waitForDeltas();
     std::scoped_lock lock(mTraceLock);
     if (!mEnabled) {
         return;
@@ -127,21 +162,100 @@ void LayerTracing::notify(bool visibleRegionDirty, int64_t time, int64_t vsyncId
     }
 
     ATRACE_CALL();
-    LayersTraceProto entry;
-    entry.set_elapsed_realtime_nanos(time);
-    const char* where = visibleRegionDirty ? "visibleRegionsDirty" : "bufferLatched";
-    entry.set_where(where);
+    LayersTraceProto entry =
+            createEntry(visibleRegionDirty, time, vsyncId, mFlags, std::move(hwcDump));
     entry.mutable_layers()->Swap(layers);
+    entry.mutable_displays()->Swap(displays);
+    mBuffer->emplace(std::move(entry));
+}
+
+void LayerTracing::notifyDelta(LayerTraceDelta&& delta) {
+    mDeltas.push(std::move(delta));
+    mDeltasQueued++;
+    // The lock is only taken so that the tracing thread cannot miss the notification between
+    // checking for deltas and waiting, which is as long as the tracing thread holds it.
+    { std::scoped_lock lock(mThreadLock); }
+    mDeltasAvailableCv.notify_one();
+}
 
-    if (flagIsSet(LayerTracing::TRACE_HWC)) {
-        entry.set_hwc_blob(hwcDump);
+void LayerTracing::startThread() {
+    std::scoped_lock lock(mThreadLock);
+    // Deltas notified after the previous trace was disabled do not belong to this trace.
+    while (mDeltas.pop()) {
+        mDeltasApplied++;
     }
-    if (!flagIsSet(LayerTracing::TRACE_COMPOSITION)) {
-        entry.set_excludes_composition_state(true);
+    mDone = false;
+    mThread = std::thread(&LayerTracing::loop, this);
+}
+
+void LayerTracing::stopThread() {
+    std::thread thread;
+    {
+        std::scoped_lock lock(mThreadLock);
+        mDone = true;
+        mDeltasAvailableCv.notify_all();
+        mDeltasAppliedCv.notify_all();
+        thread = std::move(mThread);
     }
-    entry.mutable_displays()->Swap(displays);
-    entry.set_vsync_id(vsyncId);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void LayerTracing::loop() {
+    LayerTraceState state;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mThreadLock);
+            base::ScopedLockAssertion assumeLocked(mThreadLock);
+            mDeltasAvailableCv.wait(lock, [&]() REQUIRES(mThreadLock) {
+                return mDone || mDeltasQueued != mDeltasApplied;
+            });
+            if (mDone && mDeltasQueued == mDeltasApplied) {
+                break;
+            }
+        } // unlock mThreadLock
+
+        while (auto delta = mDeltas.pop()) {
+            addDeltaEntry(state, std::move(*delta));
+            std::scoped_lock lock(mThreadLock);
+            mDeltasApplied++;
+            mDeltasAppliedCv.notify_all();
+        }
+    }
+}
+
+void LayerTracing::addDeltaEntry(LayerTraceState& state, LayerTraceDelta&& delta) {
+    ATRACE_CALL();
+    const bool visibleRegionDirty = delta.visibleRegionDirty;
+    const int64_t time = delta.time;
+    const int64_t vsyncId = delta.vsyncId;
+    const uint32_t traceFlags = delta.traceFlags;
+    std::string hwcDump = std::move(delta.hwcDump);
+    google::protobuf::RepeatedPtrField<DisplayProto> displays = std::move(delta.displays);
+
+    // The state follows every frame, but only the frames that notify() would trace are added.
+    if (!state.apply(std::move(delta)) ||
+        (!visibleRegionDirty && !(traceFlags & LayerTracing::TRACE_BUFFERS))) {
+        return;
+    }
+
+    LayersTraceProto entry =
+            createEntry(visibleRegionDirty, time, vsyncId, traceFlags, std::move(hwcDump));
+    LayersProto layers = state.generate(traceFlags, displays);
+    entry.mutable_layers()->Swap(&layers);
+    entry.mutable_displays()->Swap(&displays);
+    std::scoped_lock lock(mTraceLock);
     mBuffer->emplace(std::move(entry));
 }
 
+void LayerTracing::waitForDeltas() {
+    const uint64_t queued = mDeltasQueued;
+    std::unique_lock<std::mutex> lock(mThreadLock);
+    base::ScopedLockAssertion assumeLocked(mThreadLock);
+    mDeltasAppliedCv.wait(lock, [&]() REQUIRES(mThreadLock) {
+        return !mThread.joinable() || mDeltasApplied >= queued;
+    });
+}
+
 } // namespace android
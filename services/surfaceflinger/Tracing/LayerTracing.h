@@ -16,14 +16,20 @@
 
 #pragma once
 
+#include <LocklessRingQueue.h>
 #include <android-base/thread_annotations.h>
 #include <layerproto/LayerProtoHeader.h>
 #include <utils/Errors.h>
 #include <utils/StrongPointer.h>
 #include <utils/Timers.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <thread>
+
+#include "LayerTraceState.h"
 
 using namespace android::surfaceflinger;
 
@@ -37,6 +43,10 @@ class SurfaceFlinger;
 /*
  * LayerTracing records layer states during surface flinging. Manages tracing state and
  * configuration.
+ *
+ * Frames are either notified as a LayersProto built on the main thread, or as a LayerTraceDelta,
+ * which the main thread hands to the tracing thread through a lockless queue. The tracing thread
+ * applies the deltas to its copy of the layer state and builds the entries from it.
  */
 class LayerTracing {
 public:
@@ -50,6 +60,9 @@ public:
     static LayersTraceFileProto createTraceFileProto();
     void notify(bool visibleRegionDirty, int64_t time, int64_t vsyncId, LayersProto* layers,
                 std::string hwcDump, google::protobuf::RepeatedPtrField<DisplayProto>* displays);
+    // Called on the main thread. Does not block, unless the tracing thread falls behind by more
+    // than the capacity of the queue, in which case pushing the delta allocates.
+    void notifyDelta(LayerTraceDelta&& delta);
 
     enum : uint32_t {
         TRACE_INPUT = 1 << 1,
@@ -68,12 +81,32 @@ public:
 
 private:
     static constexpr auto FILE_NAME = "/data/misc/wmtrace/layers_trace.winscope";
+    static constexpr size_t kDeltaQueueCapacity = 64;
+
+    static LayersTraceProto createEntry(bool visibleRegionDirty, int64_t time, int64_t vsyncId,
+                                        uint32_t traceFlags, std::string hwcDump);
+    void startThread() EXCLUDES(mThreadLock);
+    void stopThread() EXCLUDES(mThreadLock);
+    void loop() EXCLUDES(mThreadLock);
+    void addDeltaEntry(LayerTraceState& state, LayerTraceDelta&& delta) EXCLUDES(mTraceLock);
+    // Waits until the tracing thread has added the entries of the deltas notified so far.
+    void waitForDeltas() EXCLUDES(mThreadLock);
+
     uint32_t mFlags = TRACE_INPUT;
     mutable std::mutex mTraceLock;
     bool mEnabled GUARDED_BY(mTraceLock) = false;
     std::unique_ptr<RingBuffer<LayersTraceFileProto, LayersTraceProto>> mBuffer
             GUARDED_BY(mTraceLock);
     size_t mBufferSizeInBytes GUARDED_BY(mTraceLock) = 20 * 1024 * 1024;
+
+    LocklessRingQueue<LayerTraceDelta, kDeltaQueueCapacity> mDeltas;
+    std::atomic<uint64_t> mDeltasQueued = 0;
+    std::mutex mThreadLock;
+    std::thread mThread GUARDED_BY(mThreadLock);
+    bool mDone GUARDED_BY(mThreadLock) = false;
+    uint64_t mDeltasApplied GUARDED_BY(mThreadLock) = 0;
+    std::condition_variable mDeltasAvailableCv;
+    std::condition_variable mDeltasAppliedCv;
 };
 
 } // namespace android
@@ -25,8 +25,11 @@
 #include <utils/Trace.h>
 #include <chrono>
 #include <fstream>
+#include <iterator>
 #include <queue>
 
+#include "TraceCompression.h"
+
 namespace android {
 
 class SurfaceFlinger;
@@ -34,22 +37,51 @@ class SurfaceFlinger;
 template <typename FileProto, typename EntryProto>
 class RingBuffer {
 public:
+    static constexpr size_t kDefaultSegmentSizeInBytes = 64 * 1024;
+
     size_t size() const { return mSizeInBytes; }
     size_t used() const { return mUsedInBytes; }
-    size_t frameCount() const { return mStorage.size(); }
+    size_t frameCount() const { return mStorage.size() + mSegmentEntryCount; }
     void setSize(size_t newSize) { mSizeInBytes = newSize; }
-    const std::string& front() const { return mStorage.front(); }
+    std::string front() const {
+        if (!mSegments.empty()) {
+            if (auto entries = decompressTraceEntries(mSegments.front());
+                entries && !entries->empty()) {
+                return std::move(entries->front());
+            }
+        }
+        return mStorage.front();
+    }
     const std::string& back() const { return mStorage.back(); }
 
+    // When compression is enabled, the oldest entries are packed into compressed segments of about
+    // segmentSizeInBytes once twice that many bytes of entries are uncompressed, so that more
+    // entries fit in the buffer. The most recent entries are always kept uncompressed.
+    void setCompression(bool enabled, size_t segmentSizeInBytes = kDefaultSegmentSizeInBytes) {
+        mCompressionEnabled = enabled;
+        mSegmentSizeInBytes = segmentSizeInBytes;
+    }
+
     void reset() {
         // use the swap trick to make sure memory is released
         std::deque<std::string>().swap(mStorage);
+        std::deque<CompressedTraceSegment>().swap(mSegments);
         mUsedInBytes = 0U;
+        mUncompressedInBytes = 0U;
+        mSegmentEntryCount = 0U;
+        mSegmentRawBytes = 0U;
     }
 
     void writeToProto(FileProto& fileProto) {
-        fileProto.mutable_entry()->Reserve(static_cast<int>(mStorage.size()) +
+        fileProto.mutable_entry()->Reserve(static_cast<int>(frameCount()) +
                                            fileProto.entry().size());
+        for (const CompressedTraceSegment& segment : mSegments) {
+            if (auto entries = decompressTraceEntries(segment)) {
+                for (const std::string& entry : *entries) {
+                    fileProto.add_entry()->ParseFromString(entry);
+                }
+            }
+        }
         for (const std::string& entry : mStorage) {
             EntryProto* entryProto = fileProto.add_entry();
             entryProto->ParseFromString(entry);
@@ -91,15 +123,24 @@ public:
         std::vector<std::string> replacedEntries;
         size_t protoSize = static_cast<size_t>(serializedProto.size());
         while (mUsedInBytes + protoSize > mSizeInBytes) {
+            if (!mSegments.empty()) {
+                evictSegment(replacedEntries);
+                continue;
+            }
             if (mStorage.empty()) {
                 return {};
             }
             mUsedInBytes -= static_cast<size_t>(mStorage.front().size());
+            mUncompressedInBytes -= static_cast<size_t>(mStorage.front().size());
             replacedEntries.emplace_back(mStorage.front());
             mStorage.pop_front();
         }
         mUsedInBytes += protoSize;
+        mUncompressedInBytes += protoSize;
         mStorage.emplace_back(serializedProto);
+        if (mCompressionEnabled && mUncompressedInBytes >= 2 * mSegmentSizeInBytes) {
+            compressSegment();
+        }
         return replacedEntries;
     }
 
@@ -122,12 +163,59 @@ public:
                             "  number of entries: %zu (%.2fMB / %.2fMB) duration: %" PRIi64 "ms\n",
                             frameCount(), float(used()) / (1024.f * 1024.f),
                             float(size()) / (1024.f * 1024.f), durationCount);
+        if (!mSegments.empty()) {
+            base::StringAppendF(&result,
+                                "  compressed segments: %zu (%zu entries, %.2fMB compressed to "
+                                "%.2fMB)\n",
+                                mSegments.size(), mSegmentEntryCount,
+                                float(mSegmentRawBytes) / (1024.f * 1024.f),
+                                float(mUsedInBytes - mUncompressedInBytes) / (1024.f * 1024.f));
+        }
     }
 
 private:
+    void compressSegment() {
+        ATRACE_CALL();
+        size_t segmentBytes = 0;
+        auto end = mStorage.begin();
+        while (segmentBytes < mSegmentSizeInBytes && std::next(end) != mStorage.end()) {
+            segmentBytes += end->size();
+            ++end;
+        }
+
+        CompressedTraceSegment segment = compressTraceEntries(mStorage.begin(), end);
+        mStorage.erase(mStorage.begin(), end);
+        mUncompressedInBytes -= segmentBytes;
+        mUsedInBytes = mUsedInBytes - segmentBytes + segment.data.size();
+        mSegmentEntryCount += segment.entryCount;
+        mSegmentRawBytes += segment.rawBytes;
+        mSegments.emplace_back(std::move(segment));
+    }
+
+    void evictSegment(std::vector<std::string>& replacedEntries) {
+        const CompressedTraceSegment& segment = mSegments.front();
+        if (auto entries = decompressTraceEntries(segment)) {
+            replacedEntries.insert(replacedEntries.end(), std::make_move_iterator(entries->begin()),
+                                   std::make_move_iterator(entries->end()));
+        }
+        mUsedInBytes -= segment.data.size();
+        mSegmentEntryCount -= segment.entryCount;
+        mSegmentRawBytes -= segment.rawBytes;
+        mSegments.pop_front();
+    }
+
     size_t mUsedInBytes = 0U;
     size_t mSizeInBytes = 0U;
+    // The most recent entries, uncompressed.
     std::deque<std::string> mStorage;
+    size_t mUncompressedInBytes = 0U;
+
+    bool mCompressionEnabled = false;
+    size_t mSegmentSizeInBytes = kDefaultSegmentSizeInBytes;
+    // The oldest entries, least recent first.
+    std::deque<CompressedTraceSegment> mSegments;
+    size_t mSegmentEntryCount = 0U;
+    size_t mSegmentRawBytes = 0U;
 };
 
 } // namespace android
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "TraceCompression"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <log/log.h>
+#include <lz4.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "TraceCompression.h"
+
+namespace android {
+
+namespace {
+
+using EntrySize = uint32_t;
+
+} // namespace
+
+CompressedTraceSegment compressTraceEntries(std::deque<std::string>::const_iterator begin,
+                                            std::deque<std::string>::const_iterator end) {
+    ATRACE_CALL();
+    CompressedTraceSegment segment;
+    std::string raw;
+    for (auto it = begin; it != end; ++it) {
+        const auto size = static_cast<EntrySize>(it->size());
+        raw.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        raw.append(*it);
+        segment.entryCount++;
+    }
+    segment.rawBytes = raw.size();
+
+    segment.data.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(raw.size()))));
+    const int compressedSize = LZ4_compress_default(raw.data(), segment.data.data(),
+                                                    static_cast<int>(raw.size()),
+                                                    static_cast<int>(segment.data.size()));
+    segment.data.resize(static_cast<size_t>(std::max(compressedSize, 0)));
+    segment.data.shrink_to_fit();
+    return segment;
+}
+
+std::optional<std::vector<std::string>> decompressTraceEntries(
+        const CompressedTraceSegment& segment) {
+    ATRACE_CALL();
+    std::string raw(segment.rawBytes, '\0');
+    const int rawSize = LZ4_decompress_safe(segment.data.data(), raw.data(),
+                                            static_cast<int>(segment.data.size()),
+                                            static_cast<int>(raw.size()));
+    if (rawSize < 0 || static_cast<size_t>(rawSize) != segment.rawBytes) {
+        ALOGE("Could not decompress trace segment of %zu entries", segment.entryCount);
+        return std::nullopt;
+    }
+
+    std::vector<std::string> entries;
+    entries.reserve(segment.entryCount);
+    size_t offset = 0;
+    while (offset + sizeof(EntrySize) <= raw.size()) {
+        EntrySize size;
+        std::memcpy(&size, raw.data() + offset, sizeof(size));
+        offset += sizeof(size);
+        if (offset + size > raw.size()) {
+            ALOGE("Trace segment entry of %u bytes is truncated", size);
+            return std::nullopt;
+        }
+        entries.emplace_back(raw, offset, size);
+        offset += size;
+    }
+    return entries;
+}
+
+} // namespace android
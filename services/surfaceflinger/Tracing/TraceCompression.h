@@ -0,0 +1,41 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace android {
+
+// The entries of a trace ring buffer packed into one LZ4 compressed block.
+struct CompressedTraceSegment {
+    std::string data;
+    size_t entryCount = 0;
+    // The size of the packed entries before compression.
+    size_t rawBytes = 0;
+};
+
+// Packs the entries, each prefixed with its size, and compresses them.
+CompressedTraceSegment compressTraceEntries(std::deque<std::string>::const_iterator begin,
+                                            std::deque<std::string>::const_iterator end);
+
+// Returns the entries of the segment, or nullopt if the segment is corrupt.
+std::optional<std::vector<std::string>> decompressTraceEntries(const CompressedTraceSegment&);
+
+} // namespace android
@@ -53,6 +53,7 @@ TransactionTracing::~TransactionTracing() {
         thread.join();
     }
 
+    stopStreaming();
     writeToFile();
 }
 
@@ -69,6 +70,69 @@ void TransactionTracing::setBufferSize(size_t bufferSizeInBytes) {
     mBuffer.setSize(mBufferSizeInBytes);
 }
 
+void TransactionTracing::setCompressionEnabled(bool enabled) {
+    std::scoped_lock lock(mTraceLock);
+    mBuffer.setCompression(enabled);
+}
+
+status_t TransactionTracing::startStreaming(const std::string& path) {
+    std::scoped_lock lock(mTraceLock);
+    stopStreamingLocked();
+
+    mStream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!mStream) {
+        ALOGE("Could not open %s to stream transactions", path.c_str());
+        return PERMISSION_DENIED;
+    }
+
+    proto::TransactionTraceFile fileProto = createTraceFileProto();
+    addStartingStateToProtoLocked(fileProto);
+    if (const status_t status = mBuffer.appendToStream(fileProto, mStream); status != NO_ERROR) {
+        mStream.close();
+        return status;
+    }
+    mStream.flush();
+    mStreamPath = path;
+    return NO_ERROR;
+}
+
+void TransactionTracing::stopStreaming() {
+    std::scoped_lock lock(mTraceLock);
+    stopStreamingLocked();
+}
+
+void TransactionTracing::stopStreamingLocked() {
+    if (!mStream.is_open()) {
+        return;
+    }
+    flushStreamChunkLocked();
+    mStream.close();
+    mStreamPath.clear();
+}
+
+void TransactionTracing::flushStreamChunkLocked() {
+    if (mStreamChunk.entry_size() == 0) {
+        return;
+    }
+
+    // Serialized trace files concatenate into one, so each chunk only holds entries.
+    std::string output;
+    if (!mStreamChunk.SerializeToString(&output)) {
+        ALOGE("Could not serialize stream chunk.");
+    }
+    mStream << output;
+    mStream.flush();
+    mStreamChunk.Clear();
+    mStreamChunkInBytes = 0;
+
+    if (!mStream) {
+        // The reader of a pipe may have gone away.
+        ALOGE("Could not write to %s, stopped streaming transactions", mStreamPath.c_str());
+        mStream.close();
+        mStreamPath.clear();
+    }
+}
+
 proto::TransactionTraceFile TransactionTracing::createTraceFileProto() const {
     proto::TransactionTraceFile proto;
     proto.set_magic_number(uint64_t(proto::TransactionTraceFile_MagicNumber_MAGIC_NUMBER_H) << 32 |
@@ -85,6 +149,9 @@ void TransactionTracing::dump(std::string& result) const {
     base::StringAppendF(&result, "  queued transactions=%zu created layers=%zu states=%zu\n",
                         mQueuedTransactions.size(), mCreatedLayers.size(), mStartingStates.size());
     mBuffer.dump(result);
+    if (mStream.is_open()) {
+        base::StringAppendF(&result, "  streaming to %s\n", mStreamPath.c_str());
+    }
 }
 
 void TransactionTracing::addQueuedTransaction(const TransactionState& transaction) {
@@ -102,6 +169,10 @@ void TransactionTracing::addCommittedTransactions(
     update.transactionIds.reserve(newUpdate.transactions.size());
     for (const auto& transaction : newUpdate.transactions) {
         update.transactionIds.emplace_back(transaction.id);
+        // Coalesced transactions were traced individually when queued, so replay them in order.
+        update.transactionIds.insert(update.transactionIds.end(),
+                                     transaction.coalescedTransactionIds.begin(),
+                                     transaction.coalescedTransactionIds.end());
     }
     update.displayInfoChanged = displayInfoChanged;
     if (displayInfoChanged) {
@@ -202,6 +273,10 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
 
         std::string serializedProto;
         entryProto.SerializeToString(&serializedProto);
+        if (mStream.is_open()) {
+            mStreamChunkInBytes += serializedProto.size();
+            *mStreamChunk.add_entry() = entryProto;
+        }
         entryProto.Clear();
         std::vector<std::string> entries = mBuffer.emplace(std::move(serializedProto));
         removedEntries.reserve(removedEntries.size() + entries.size());
@@ -209,6 +284,10 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
                               std::make_move_iterator(entries.end()));
     }
 
+    if (mStreamChunkInBytes >= STREAM_CHUNK_SIZE) {
+        flushStreamChunkLocked();
+    }
+
     proto::TransactionTraceEntry removedEntryProto;
     for (const std::string& removedEntry : removedEntries) {
         removedEntryProto.ParseFromString(removedEntry);
@@ -21,8 +21,10 @@
 #include <utils/Errors.h>
 #include <utils/Timers.h>
 
+#include <fstream>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 
 #include "Display/DisplayMap.h"
@@ -52,6 +54,10 @@ class TransactionTracingTest;
  * When generating SF dump state, we will flush the buffer to a file which
  * will then be included in the bugreport.
  *
+ * The oldest entries of the ring buffer may be compressed, so that more history fits in the same
+ * memory. The entries may also be streamed to a file or pipe as they are committed, in which case
+ * the stream grows into a trace file of the whole session, a chunk of entries at a time.
+ *
  */
 class TransactionTracing {
 public:
@@ -65,10 +71,16 @@ public:
             bool displayInfoChanged);
     status_t writeToFile(std::string filename = FILE_NAME);
     void setBufferSize(size_t bufferSizeInBytes);
+    void setCompressionEnabled(bool enabled);
+    // Writes the current contents of the buffer to the path, then appends each chunk of committed
+    // entries, until streaming stops.
+    status_t startStreaming(const std::string& path);
+    void stopStreaming();
     void onLayerRemoved(int layerId);
     void dump(std::string&) const;
     static constexpr auto CONTINUOUS_TRACING_BUFFER_SIZE = 512 * 1024;
     static constexpr auto ACTIVE_TRACING_BUFFER_SIZE = 100 * 1024 * 1024;
+    static constexpr auto STREAM_CHUNK_SIZE = 64 * 1024;
     // version 1 - switching to support new frontend
     static constexpr auto TRACING_VERSION = 1;
 
@@ -92,6 +104,11 @@ private:
             GUARDED_BY(mTraceLock);
 
     std::set<uint32_t /* layerId */> mRemovedLayerHandlesAtStart GUARDED_BY(mTraceLock);
+
+    std::string mStreamPath GUARDED_BY(mTraceLock);
+    std::ofstream mStream GUARDED_BY(mTraceLock);
+    proto::TransactionTraceFile mStreamChunk GUARDED_BY(mTraceLock);
+    size_t mStreamChunkInBytes GUARDED_BY(mTraceLock) = 0;
     TransactionProtoParser mProtoParser;
 
     // We do not want main thread to block so main thread will try to acquire mMainThreadLock,
@@ -124,6 +141,8 @@ private:
     void tryPushToTracingThread() EXCLUDES(mMainThreadLock);
     void addStartingStateToProtoLocked(proto::TransactionTraceFile& proto) REQUIRES(mTraceLock);
     void updateStartingStateLocked(const proto::TransactionTraceEntry& entry) REQUIRES(mTraceLock);
+    void flushStreamChunkLocked() REQUIRES(mTraceLock);
+    void stopStreamingLocked() REQUIRES(mTraceLock);
     // TEST
     // Wait until all the committed transactions for the specified vsync id are added to the buffer.
     void flush(int64_t vsyncId) EXCLUDES(mMainThreadLock);
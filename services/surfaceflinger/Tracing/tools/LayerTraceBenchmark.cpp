@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LayerTraceBenchmark"
+
+#include <android-base/unique_fd.h>
+#include <linux/perf_event.h>
+#include <log/log.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+#include <string>
+#include "AllocationCounter.h"
+#include "cutils/properties.h"
+
+#include "LayerTraceBenchmark.h"
+#include "LayerTraceGenerator.h"
+
+namespace android {
+namespace {
+
+// Counts the cache misses of the calling thread in user space, if perf events are permitted.
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        mFd.reset(static_cast<int>(syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                                           /*group_fd=*/-1, /*flags=*/0)));
+        if (!mFd.ok()) {
+            ALOGW("Cache misses are not counted: %s", strerror(errno));
+        }
+    }
+
+    bool ok() const { return mFd.ok(); }
+
+    uint64_t read() const {
+        uint64_t count = 0;
+        if (!ok() || ::read(mFd.get(), &count, sizeof(count)) != sizeof(count)) {
+            return 0;
+        }
+        return count;
+    }
+
+private:
+    base::unique_fd mFd;
+};
+
+// Adds the cost of its scope to a stage. The counters are read outside of the timed interval.
+class ScopedStageMeasurement {
+public:
+    ScopedStageMeasurement(LayerTraceBenchmark::Stage& stage, const CacheMissCounter& cacheMisses)
+          : mStage(stage),
+            mCacheMisses(cacheMisses),
+            mStartCacheMisses(cacheMisses.read()),
+            mStartTime(systemTime()) {}
+
+    ~ScopedStageMeasurement() {
+        const nsecs_t duration = systemTime() - mStartTime;
+        const uint64_t cacheMisses = mCacheMisses.read() - mStartCacheMisses;
+        const size_t allocationCount = mAllocations.getAllocationCount();
+        const size_t allocatedBytes = mAllocations.getAllocatedBytes();
+
+        mStage.durations.push_back(duration);
+        mStage.allocationCounts.push_back(allocationCount);
+        mStage.allocatedBytes += allocatedBytes;
+        if (mCacheMisses.ok()) {
+            mStage.cacheMisses = mStage.cacheMisses.value_or(0) + cacheMisses;
+        }
+    }
+
+private:
+    LayerTraceBenchmark::Stage& mStage;
+    const CacheMissCounter& mCacheMisses;
+    const uint64_t mStartCacheMisses;
+    const nsecs_t mStartTime;
+    // Last, so that the bookkeeping above does not count.
+    ScopedAllocationCounter mAllocations;
+};
+
+template <typename T>
+void dumpPercentiles(std::ostream& out, std::vector<T> values, double scale) {
+    std::sort(values.begin(), values.end());
+    const auto percentile = [&values, scale](size_t p) {
+        return static_cast<double>(values[std::min(values.size() - 1, values.size() * p / 100)]) /
+                scale;
+    };
+    const double mean =
+            static_cast<double>(std::accumulate(values.begin(), values.end(), T{})) / scale /
+            static_cast<double>(values.size());
+    out << "p50=" << percentile(50) << " p90=" << percentile(90) << " p99=" << percentile(99)
+        << " max=" << static_cast<double>(values.back()) / scale << " mean=" << mean;
+}
+
+void dumpStage(std::ostream& out, const char* name, const LayerTraceBenchmark::Stage& stage) {
+    const double frameCount = static_cast<double>(stage.durations.size());
+    out << name << ":\n  time (us):     ";
+    dumpPercentiles(out, stage.durations, 1e3);
+    out << "\n  allocations:   ";
+    dumpPercentiles(out, stage.allocationCounts, 1);
+    out << " (" << static_cast<double>(stage.allocatedBytes) / 1024.0 / frameCount
+        << " KB per frame)\n  cache misses:  ";
+    if (stage.cacheMisses) {
+        out << static_cast<double>(*stage.cacheMisses) / frameCount << " per frame\n";
+    } else {
+        out << "unavailable (requires perf events, see security.perf_harden)\n";
+    }
+}
+
+} // namespace
+
+bool LayerTraceBenchmark::replay(const proto::TransactionTraceFile& traceFile, int iterations) {
+    if (traceFile.entry_size() == 0) {
+        ALOGD("Trace file is empty");
+        return false;
+    }
+
+    renderengine::ShadowSettings globalShadowSettings{.ambientColor = {1, 1, 1, 1}};
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.surface_flinger.supports_background_blur", value, "0");
+    bool supportsBlur = atoi(value);
+
+    const CacheMissCounter cacheMisses;
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        ALOGD("Replaying %d entries, iteration %d/%d...", traceFile.entry_size(), iteration + 1,
+              iterations);
+
+        // Each iteration replays the trace from scratch, with new layers.
+        TransactionProtoParser parser(
+                std::make_unique<TransactionProtoParser::FlingerDataMapper>());
+        std::vector<LayerTraceFrame> frames;
+        frames.reserve(static_cast<size_t>(traceFile.entry_size()));
+        for (int i = 0; i < traceFile.entry_size(); i++) {
+            frames.push_back(LayerTraceGenerator::parseFrame(parser, traceFile.entry(i)));
+        }
+
+        frontend::LayerLifecycleManager lifecycleManager;
+        frontend::LayerHierarchyBuilder hierarchyBuilder{{}};
+        frontend::LayerSnapshotBuilder snapshotBuilder;
+        display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> displayInfos;
+
+        for (LayerTraceFrame& frame : frames) {
+            if (frame.displayChanged) {
+                displayInfos = std::move(frame.displayInfos);
+            }
+
+            {
+                ScopedStageMeasurement measurement(mApplyTransactions, cacheMisses);
+                lifecycleManager.addLayers(std::move(frame.addedLayers));
+                lifecycleManager.applyTransactions(frame.transactions,
+                                                   /*ignoreUnknownHandles=*/true);
+                lifecycleManager.onHandlesDestroyed(frame.destroyedHandles,
+                                                    /*ignoreUnknownHandles=*/true);
+            }
+
+            {
+                ScopedStageMeasurement measurement(mUpdateSnapshots, cacheMisses);
+                if (lifecycleManager.getGlobalChanges().test(
+                            frontend::RequestedLayerState::Changes::Hierarchy)) {
+                    hierarchyBuilder.update(lifecycleManager.getLayers(),
+                                            lifecycleManager.getDestroyedLayers());
+                }
+
+                frontend::LayerSnapshotBuilder::Args
+                        args{.root = hierarchyBuilder.getHierarchy(),
+                             .layerLifecycleManager = lifecycleManager,
+                             .displays = displayInfos,
+                             .displayChanges = frame.displayChanged,
+                             .globalShadowSettings = globalShadowSettings,
+                             .supportsBlur = supportsBlur,
+                             .forceFullDamage = false,
+                             .supportedLayerGenericMetadata = {},
+                             .genericLayerMetadataKeyMap = {}};
+                snapshotBuilder.update(args);
+                lifecycleManager.commitChanges();
+            }
+        }
+    }
+    return true;
+}
+
+void LayerTraceBenchmark::dump(std::ostream& out) const {
+    if (getFrameCount() == 0) {
+        out << "No frames replayed\n";
+        return;
+    }
+
+    out << "Replayed " << getFrameCount() << " frames\n" << std::fixed << std::setprecision(1);
+    dumpStage(out, "applyTransactions", mApplyTransactions);
+    dumpStage(out, "updateSnapshots", mUpdateSnapshots);
+}
+
+} // namespace android
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <Tracing/TransactionTracing.h>
+#include <utils/Timers.h>
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace android {
+
+// Replays transaction traces through the frontend as fast as possible, and measures the two
+// frontend stages of each entry: applying the transactions to the LayerLifecycleManager, and
+// updating the layer hierarchy and snapshots. Unlike LayerTraceGenerator, no layers trace is
+// generated, and the entries are parsed before the replay so that parsing is not measured.
+class LayerTraceBenchmark {
+public:
+    struct Stage {
+        // Per frame.
+        std::vector<nsecs_t> durations;
+        std::vector<size_t> allocationCounts;
+
+        size_t allocatedBytes = 0;
+        // Unset if the hardware counter is not available, e.g. for lack of permission.
+        std::optional<uint64_t> cacheMisses;
+    };
+
+    // Replays the trace the given number of times, and adds its frames to the measurements.
+    bool replay(const proto::TransactionTraceFile&, int iterations = 1);
+
+    size_t getFrameCount() const { return mApplyTransactions.durations.size(); }
+    const Stage& getApplyTransactions() const { return mApplyTransactions; }
+    const Stage& getUpdateSnapshots() const { return mUpdateSnapshots; }
+
+    // Prints the percentiles of the stage durations and allocations per frame.
+    void dump(std::ostream&) const;
+
+private:
+    Stage mApplyTransactions;
+    Stage mUpdateSnapshots;
+};
+
+} // namespace android
@@ -40,6 +40,51 @@
 namespace android {
 using namespace ftl::flag_operators;
 
+LayerTraceFrame LayerTraceGenerator::parseFrame(TransactionProtoParser& parser,
+                                                const proto::TransactionTraceEntry& entry) {
+    LayerTraceFrame frame;
+    frame.addedLayers.reserve((size_t)entry.added_layers_size());
+    for (int j = 0; j < entry.added_layers_size(); j++) {
+        LayerCreationArgs args;
+        parser.fromProto(entry.added_layers(j), args);
+        ALOGV("       %s", args.getDebugString().c_str());
+        frame.addedLayers.emplace_back(std::make_unique<frontend::RequestedLayerState>(args));
+    }
+
+    frame.transactions.reserve((size_t)entry.transactions_size());
+    for (int j = 0; j < entry.transactions_size(); j++) {
+        // apply transactions
+        TransactionState transaction = parser.fromProto(entry.transactions(j));
+        for (auto& resolvedComposerState : transaction.states) {
+            if (resolvedComposerState.state.what & layer_state_t::eInputInfoChanged) {
+                if (!resolvedComposerState.state.windowInfoHandle->getInfo()->inputConfig.test(
+                            gui::WindowInfo::InputConfig::NO_INPUT_CHANNEL)) {
+                    // create a fake token since the FE expects a valid token
+                    resolvedComposerState.state.windowInfoHandle->editInfo()->token =
+                            sp<BBinder>::make();
+                }
+            }
+        }
+        frame.transactions.emplace_back(std::move(transaction));
+    }
+
+    for (int j = 0; j < entry.destroyed_layers_size(); j++) {
+        ALOGV("       destroyedHandles=%d", entry.destroyed_layers(j));
+    }
+
+    frame.destroyedHandles.reserve((size_t)entry.destroyed_layer_handles_size());
+    for (int j = 0; j < entry.destroyed_layer_handles_size(); j++) {
+        ALOGV("       destroyedHandles=%d", entry.destroyed_layer_handles(j));
+        frame.destroyedHandles.push_back(entry.destroyed_layer_handles(j));
+    }
+
+    frame.displayChanged = entry.displays_changed();
+    if (frame.displayChanged) {
+        parser.fromProto(entry.displays(), frame.displayInfos);
+    }
+    return frame;
+}
+
 bool LayerTraceGenerator::generate(const proto::TransactionTraceFile& traceFile,
                                    const char* outputLayersTracePath) {
     if (traceFile.entry_size() == 0) {
@@ -78,53 +123,16 @@ bool LayerTraceGenerator::generate(const proto::TransactionTraceFile& traceFile,
               entry.added_layers_size(), entry.destroyed_layers_size(),
               entry.destroyed_layer_handles_size(), entry.transactions_size());
 
-        std::vector<std::unique_ptr<frontend::RequestedLayerState>> addedLayers;
-        addedLayers.reserve((size_t)entry.added_layers_size());
-        for (int j = 0; j < entry.added_layers_size(); j++) {
-            LayerCreationArgs args;
-            parser.fromProto(entry.added_layers(j), args);
-            ALOGV("       %s", args.getDebugString().c_str());
-            addedLayers.emplace_back(std::make_unique<frontend::RequestedLayerState>(args));
-        }
-
-        std::vector<TransactionState> transactions;
-        transactions.reserve((size_t)entry.transactions_size());
-        for (int j = 0; j < entry.transactions_size(); j++) {
-            // apply transactions
-            TransactionState transaction = parser.fromProto(entry.transactions(j));
-            for (auto& resolvedComposerState : transaction.states) {
-                if (resolvedComposerState.state.what & layer_state_t::eInputInfoChanged) {
-                    if (!resolvedComposerState.state.windowInfoHandle->getInfo()->inputConfig.test(
-                                gui::WindowInfo::InputConfig::NO_INPUT_CHANNEL)) {
-                        // create a fake token since the FE expects a valid token
-                        resolvedComposerState.state.windowInfoHandle->editInfo()->token =
-                                sp<BBinder>::make();
-                    }
-                }
-            }
-            transactions.emplace_back(std::move(transaction));
-        }
-
-        for (int j = 0; j < entry.destroyed_layers_size(); j++) {
-            ALOGV("       destroyedHandles=%d", entry.destroyed_layers(j));
-        }
-
-        std::vector<uint32_t> destroyedHandles;
-        destroyedHandles.reserve((size_t)entry.destroyed_layer_handles_size());
-        for (int j = 0; j < entry.destroyed_layer_handles_size(); j++) {
-            ALOGV("       destroyedHandles=%d", entry.destroyed_layer_handles(j));
-            destroyedHandles.push_back(entry.destroyed_layer_handles(j));
-        }
-
-        bool displayChanged = entry.displays_changed();
+        LayerTraceFrame frame = parseFrame(parser, entry);
+        const bool displayChanged = frame.displayChanged;
         if (displayChanged) {
-            parser.fromProto(entry.displays(), displayInfos);
+            displayInfos = std::move(frame.displayInfos);
         }
 
         // apply updates
-        lifecycleManager.addLayers(std::move(addedLayers));
-        lifecycleManager.applyTransactions(transactions, /*ignoreUnknownHandles=*/true);
-        lifecycleManager.onHandlesDestroyed(destroyedHandles, /*ignoreUnknownHandles=*/true);
+        lifecycleManager.addLayers(std::move(frame.addedLayers));
+        lifecycleManager.applyTransactions(frame.transactions, /*ignoreUnknownHandles=*/true);
+        lifecycleManager.onHandlesDestroyed(frame.destroyedHandles, /*ignoreUnknownHandles=*/true);
 
         if (lifecycleManager.getGlobalChanges().test(
                     frontend::RequestedLayerState::Changes::Hierarchy)) {
@@ -16,11 +16,32 @@
 
 #pragma once
 
+#include <Tracing/TransactionProtoParser.h>
 #include <Tracing/TransactionTracing.h>
 
+#include <memory>
+#include <vector>
+
+#include "FrontEnd/RequestedLayerState.h"
+#include "TransactionState.h"
+
 namespace android {
+
+// The frontend updates of one transaction trace entry.
+struct LayerTraceFrame {
+    std::vector<std::unique_ptr<frontend::RequestedLayerState>> addedLayers;
+    std::vector<TransactionState> transactions;
+    std::vector<uint32_t> destroyedHandles;
+    bool displayChanged = false;
+    // Only set if displayChanged.
+    display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> displayInfos;
+};
+
 class LayerTraceGenerator {
 public:
     bool generate(const proto::TransactionTraceFile&, const char* outputLayersTracePath);
+
+    static LayerTraceFrame parseFrame(TransactionProtoParser&,
+                                      const proto::TransactionTraceEntry&);
 };
 } // namespace android
\ No newline at end of file
@@ -17,33 +17,83 @@
 #undef LOG_TAG
 #define LOG_TAG "LayerTraceGenerator"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
 
+#include "LayerTraceBenchmark.h"
 #include "LayerTraceGenerator.h"
 
 using namespace android;
 
-int main(int argc, char** argv) {
-    if (argc > 3) {
-        std::cout << "Usage: " << argv[0]
-                  << " [transaction-trace-path] [output-layers-trace-path]\n";
-        return -1;
-    }
+namespace {
 
-    const char* transactionTracePath =
-            (argc > 1) ? argv[1] : "/data/misc/wmtrace/transactions_trace.winscope";
+bool parseTransactionTrace(const char* transactionTracePath,
+                           proto::TransactionTraceFile& transactionTraceFile) {
     std::cout << "Parsing " << transactionTracePath << "\n";
     std::fstream input(transactionTracePath, std::ios::in | std::ios::binary);
     if (!input) {
         std::cout << "Error: Could not open " << transactionTracePath;
-        return -1;
+        return false;
     }
 
-    proto::TransactionTraceFile transactionTraceFile;
     if (!transactionTraceFile.ParseFromIstream(&input)) {
         std::cout << "Error: Failed to parse " << transactionTracePath;
+        return false;
+    }
+    return true;
+}
+
+// Replays each transaction trace through the frontend, and prints the frame costs of the corpus.
+int benchmark(int argc, char** argv) {
+    int iterations = 1;
+    int first = 0;
+    if (argc > 1 && strcmp(argv[0], "--iterations") == 0) {
+        iterations = std::max(1, atoi(argv[1]));
+        first = 2;
+    }
+    if (first == argc) {
+        std::cout << "Error: No transaction traces to benchmark\n";
+        return -1;
+    }
+
+    LayerTraceBenchmark benchmark;
+    for (int i = first; i < argc; i++) {
+        proto::TransactionTraceFile transactionTraceFile;
+        if (!parseTransactionTrace(argv[i], transactionTraceFile)) {
+            return -1;
+        }
+        if (!benchmark.replay(transactionTraceFile, iterations)) {
+            std::cout << "Error: Failed to replay " << argv[i];
+            return -1;
+        }
+    }
+    benchmark.dump(std::cout);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        return benchmark(argc - 2, argv + 2);
+    }
+
+    if (argc > 3) {
+        std::cout << "Usage: " << argv[0]
+                  << " [transaction-trace-path] [output-layers-trace-path]\n"
+                  << "       " << argv[0]
+                  << " --benchmark [--iterations N] transaction-trace-path...\n";
+        return -1;
+    }
+
+    const char* transactionTracePath =
+            (argc > 1) ? argv[1] : "/data/misc/wmtrace/transactions_trace.winscope";
+    proto::TransactionTraceFile transactionTraceFile;
+    if (!parseTransactionTrace(transactionTracePath, transactionTraceFile)) {
         return -1;
     }
 
@@ -24,11 +24,11 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include "TransactionCallbackInvoker.h"
-#include "BackgroundExecutor.h"
 
 #include <cinttypes>
 
 #include <binder/IInterface.h>
+#include <binder/IPCThreadState.h>
 #include <utils/RefBase.h>
 
 namespace android {
@@ -50,6 +50,21 @@ static bool containsOnCommitCallbacks(const std::vector<CallbackId>& callbacks)
     return !callbacks.empty() && callbacks.front().type == CallbackId::Type::ON_COMMIT;
 }
 
+// Sends callbacks that make oneway calls to the listeners, which do not check their status.
+// They run as a single task, so that the calls are sent to the driver with one ioctl.
+static void sendOnewayCallbacks(BackgroundExecutor::Callbacks&& callbacks) {
+    if (callbacks.size() <= 1) {
+        BackgroundExecutor::getInstance().sendCallbacks(std::move(callbacks));
+        return;
+    }
+    BackgroundExecutor::getInstance().sendCallbacks({[callbacks = std::move(callbacks)]() {
+        IPCThreadState::BatchScope batch;
+        for (const auto& callback : callbacks) {
+            callback();
+        }
+    }});
+}
+
 void TransactionCallbackInvoker::addEmptyTransaction(const ListenerCallbacks& listenerCallbacks) {
     auto& [listener, callbackIds] = listenerCallbacks;
     auto& transactionStatsDeque = mCompletedTransactions[listener];
@@ -176,10 +191,39 @@ void TransactionCallbackInvoker::addPresentFence(sp<Fence> presentFence) {
     mPresentFence = std::move(presentFence);
 }
 
+void TransactionCallbackInvoker::addReleaseCallback(
+        const sp<ITransactionCompletedListener>& listener, BufferReleaseStats stats) {
+    mReleasedBuffers[IInterface::asBinder(listener)].push_back(std::move(stats));
+}
+
+void TransactionCallbackInvoker::takeReleaseCallbacks(BackgroundExecutor::Callbacks& callbacks) {
+    for (auto& [listener, stats] : mReleasedBuffers) {
+        if (!listener->isBinderAlive()) {
+            continue;
+        }
+        callbacks.emplace_back([listener = listener, stats = std::move(stats)]() {
+            interface_cast<ITransactionCompletedListener>(listener)->onReleaseBuffers(stats);
+        });
+    }
+    mReleasedBuffers.clear();
+}
+
+void TransactionCallbackInvoker::sendReleaseCallbacks() {
+    if (mReleasedBuffers.empty()) {
+        return;
+    }
+    BackgroundExecutor::Callbacks callbacks;
+    takeReleaseCallbacks(callbacks);
+    sendOnewayCallbacks(std::move(callbacks));
+}
+
 void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
+    // The buffers are released before the transactions that replaced them complete.
+    BackgroundExecutor::Callbacks callbacks;
+    takeReleaseCallbacks(callbacks);
+
     // For each listener
     auto completedTransactionsItr = mCompletedTransactions.begin();
-    BackgroundExecutor::Callbacks callbacks;
     while (completedTransactionsItr != mCompletedTransactions.end()) {
         auto& [listener, transactionStatsDeque] = *completedTransactionsItr;
         ListenerStats listenerStats;
@@ -227,7 +271,7 @@ void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
         mPresentFence.clear();
     }
 
-    BackgroundExecutor::getInstance().sendCallbacks(std::move(callbacks));
+    sendOnewayCallbacks(std::move(callbacks));
 }
 
 // -----------------------------------------------------------------------
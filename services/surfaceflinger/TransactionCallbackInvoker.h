@@ -32,6 +32,8 @@
 #include <ui/Fence.h>
 #include <ui/FenceResult.h>
 
+#include "BackgroundExecutor.h"
+
 namespace android {
 
 class CallbackHandle : public RefBase {
@@ -78,8 +80,16 @@ public:
     status_t addCallbackHandle(const sp<CallbackHandle>& handle,
                                const std::vector<JankData>& jankData);
 
+    // Queues the release callback of a buffer. The buffers released for a listener until the next
+    // sendCallbacks or sendReleaseCallbacks are sent to it in one call.
+    void addReleaseCallback(const sp<ITransactionCompletedListener>& listener,
+                            BufferReleaseStats stats);
+    void sendReleaseCallbacks();
 
 private:
+    // Moves the queued release callbacks to callbacks, one per listener.
+    void takeReleaseCallbacks(BackgroundExecutor::Callbacks& callbacks);
+
     status_t findOrCreateTransactionStats(const sp<IBinder>& listener,
                                           const std::vector<CallbackId>& callbackIds,
                                           TransactionStats** outTransactionStats);
@@ -87,6 +97,9 @@ private:
     std::unordered_map<sp<IBinder>, std::deque<TransactionStats>, IListenerHash>
         mCompletedTransactions;
 
+    std::unordered_map<sp<IBinder>, std::vector<BufferReleaseStats>, IListenerHash>
+            mReleasedBuffers;
+
     sp<Fence> mPresentFence;
 };
 
@@ -134,6 +134,9 @@ struct TransactionState {
     uint64_t id;
     bool sentFenceTimeoutWarning = false;
     std::vector<uint64_t> mergedTransactionIds;
+    // Ids of queued transactions that TransactionHandler coalesced into this one, in the order
+    // they were queued.
+    std::vector<uint64_t> coalescedTransactionIds;
 };
 
 } // namespace android
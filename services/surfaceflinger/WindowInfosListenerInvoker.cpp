@@ -56,6 +56,9 @@ void WindowInfosListenerInvoker::removeWindowInfosListener(
         ATRACE_NAME("WindowInfosListenerInvoker::removeWindowInfosListener");
         sp<IBinder> asBinder = IInterface::asBinder(listener);
         asBinder->unlinkToDeath(sp<DeathRecipient>::fromExisting(this));
+        if (auto it = mWindowInfosListeners.find(asBinder); it != mWindowInfosListeners.end()) {
+            mSyncedListenerIds.erase(it->second.first);
+        }
         mWindowInfosListeners.erase(asBinder);
     }});
 }
@@ -66,6 +69,7 @@ void WindowInfosListenerInvoker::binderDied(const wp<IBinder>& who) {
         auto it = mWindowInfosListeners.find(who);
         int64_t listenerId = it->second.first;
         mWindowInfosListeners.erase(who);
+        mSyncedListenerIds.erase(listenerId);
 
         std::vector<int64_t> vsyncIds;
         for (auto& [vsyncId, state] : mUnackedState) {
@@ -129,14 +133,27 @@ void WindowInfosListenerInvoker::windowInfosChanged(
     mDelayInfo.reset();
     updateMaxSendDelay();
 
+    // The listeners that received the last update only need the windows that changed since.
+    update.version = mNextVersion++;
+    std::optional<gui::WindowInfosUpdate> delta;
+    if (mLastUpdate && !mSyncedListenerIds.empty()) {
+        delta = update.makeDelta(mLastUpdate->windowInfos, mLastUpdate->version);
+    }
+
     // Call the listeners
+    std::unordered_set<int64_t> syncedListenerIds;
     for (auto& pair : mWindowInfosListeners) {
         auto& [listenerId, listener] = pair.second;
-        auto status = listener->onWindowInfosChanged(update);
-        if (!status.isOk()) {
+        const bool sendDelta = delta && mSyncedListenerIds.count(listenerId) != 0;
+        auto status = listener->onWindowInfosChanged(sendDelta ? *delta : update);
+        if (status.isOk()) {
+            syncedListenerIds.insert(listenerId);
+        } else {
             ackWindowInfosReceived(update.vsyncId, listenerId);
         }
     }
+    mSyncedListenerIds = std::move(syncedListenerIds);
+    mLastUpdate = std::move(update);
 }
 
 WindowInfosListenerInvoker::DebugInfo WindowInfosListenerInvoker::getDebugInfo() {
@@ -172,9 +189,13 @@ binder::Status WindowInfosListenerInvoker::ackWindowInfosReceived(int64_t vsyncI
         }
 
         auto& state = it->second;
-        state.unackedListenerIds.unstable_erase(std::find(state.unackedListenerIds.begin(),
-                                                          state.unackedListenerIds.end(),
-                                                          listenerId));
+        // Updates sent again by resyncWindowInfos are acked again.
+        const auto listenerIt = std::find(state.unackedListenerIds.begin(),
+                                          state.unackedListenerIds.end(), listenerId);
+        if (listenerIt == state.unackedListenerIds.end()) {
+            return;
+        }
+        state.unackedListenerIds.unstable_erase(listenerIt);
         if (!state.unackedListenerIds.empty()) {
             return;
         }
@@ -199,4 +220,21 @@ binder::Status WindowInfosListenerInvoker::ackWindowInfosReceived(int64_t vsyncI
     return binder::Status::ok();
 }
 
+binder::Status WindowInfosListenerInvoker::resyncWindowInfos(int64_t listenerId) {
+    BackgroundExecutor::getInstance().sendCallbacks({[this, listenerId]() {
+        ATRACE_NAME("WindowInfosListenerInvoker::resyncWindowInfos");
+        mSyncedListenerIds.erase(listenerId);
+        if (!mLastUpdate) {
+            return;
+        }
+        for (auto& pair : mWindowInfosListeners) {
+            auto& [id, listener] = pair.second;
+            if (id == listenerId && listener->onWindowInfosChanged(*mLastUpdate).isOk()) {
+                mSyncedListenerIds.insert(listenerId);
+            }
+        }
+    }});
+    return binder::Status::ok();
+}
+
 } // namespace android
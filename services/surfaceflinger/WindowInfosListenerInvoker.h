@@ -26,6 +26,7 @@
 #include <ftl/small_map.h>
 #include <ftl/small_vector.h>
 #include <gui/SpHash.h>
+#include <gui/WindowInfosUpdate.h>
 #include <utils/Mutex.h>
 
 #include "scheduler/VsyncId.h"
@@ -47,6 +48,7 @@ public:
                             bool forceImmediateCall);
 
     binder::Status ackWindowInfosReceived(int64_t, int64_t) override;
+    binder::Status resyncWindowInfos(int64_t) override;
 
     struct DebugInfo {
         VsyncId maxSendDelayVsyncId;
@@ -66,6 +68,12 @@ private:
             mWindowInfosListeners;
 
     std::optional<gui::WindowInfosUpdate> mDelayedUpdate;
+
+    // The last update sent, and the listeners that received it, which the next update is sent to
+    // as a delta against it.
+    std::optional<gui::WindowInfosUpdate> mLastUpdate;
+    std::unordered_set<int64_t> mSyncedListenerIds;
+    int64_t mNextVersion = 0;
     WindowInfosReportedListenerSet mReportedListeners;
 
     struct UnackedState {
@@ -146,5 +146,92 @@ TEST(LayerStateTest, ParcellingScreenCaptureResultsWithFenceError) {
     ASSERT_EQ(results.fenceResult.error(), results2.fenceResult.error());
 }
 
+TEST(LayerStateTest, ParcellingCompactLayerState) {
+    layer_state_t state;
+    state.surface = sp<BBinder>::make();
+    state.layerId = 42;
+    state.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged |
+            layer_state_t::eMatrixChanged | layer_state_t::eCropChanged |
+            layer_state_t::eFlagsChanged | layer_state_t::eTrustedOverlayChanged;
+    state.x = 10;
+    state.y = 20;
+    state.color.a = 0.5f;
+    state.matrix = {.dsdx = 2, .dtdx = 0, .dtdy = 0, .dsdy = 3};
+    state.crop = Rect(1, 2, 300, 400);
+    state.flags = layer_state_t::eLayerOpaque;
+    state.mask = layer_state_t::eLayerOpaque | layer_state_t::eLayerHidden;
+    state.isTrustedOverlay = true;
+    ASSERT_TRUE(state.isCompact());
+
+    Parcel p;
+    ASSERT_EQ(NO_ERROR, state.write(p));
+    p.setDataPosition(0);
+
+    layer_state_t state2;
+    ASSERT_EQ(NO_ERROR, state2.read(p));
+    ASSERT_EQ(state.surface, state2.surface);
+    ASSERT_EQ(state.layerId, state2.layerId);
+    ASSERT_EQ(state.what, state2.what);
+    ASSERT_EQ(state.x, state2.x);
+    ASSERT_EQ(state.y, state2.y);
+    ASSERT_EQ(state.color.a, state2.color.a);
+    ASSERT_EQ(state.matrix, state2.matrix);
+    ASSERT_EQ(state.crop, state2.crop);
+    ASSERT_EQ(state.flags, state2.flags);
+    ASSERT_EQ(state.mask, state2.mask);
+    ASSERT_EQ(state.isTrustedOverlay, state2.isTrustedOverlay);
+    ASSERT_EQ(state.bufferCrop, state2.bufferCrop);
+    ASSERT_EQ(state.fixedTransformHint, state2.fixedTransformHint);
+}
+
+TEST(LayerStateTest, ParcellingLayerStateWithMetadata) {
+    layer_state_t state;
+    state.surface = sp<BBinder>::make();
+    state.what = layer_state_t::ePositionChanged | layer_state_t::eMetadataChanged;
+    state.x = 10;
+    state.metadata.setInt32(gui::METADATA_OWNER_UID, 1000);
+    ASSERT_FALSE(state.isCompact());
+
+    Parcel p;
+    ASSERT_EQ(NO_ERROR, state.write(p));
+    p.setDataPosition(0);
+
+    layer_state_t state2;
+    ASSERT_EQ(NO_ERROR, state2.read(p));
+    ASSERT_EQ(state.what, state2.what);
+    ASSERT_EQ(state.x, state2.x);
+    ASSERT_EQ(1000, state2.metadata.getInt32(gui::METADATA_OWNER_UID, 0));
+}
+
+TEST(LayerStateTest, ParcellingOnlyChangedFieldsOfLayerState) {
+    layer_state_t state;
+    state.surface = sp<BBinder>::make();
+    state.what = layer_state_t::eInputInfoChanged | layer_state_t::eBlurRegionsChanged |
+            layer_state_t::eFrameRateChanged;
+    state.windowInfoHandle->editInfo()->name = "Window";
+    state.blurRegions.push_back({.blurRadius = 10, .left = 1, .top = 2, .right = 3, .bottom = 4});
+    state.frameRate = 60;
+    // Not part of the changes, so not written.
+    state.cornerRadius = 8;
+    state.bgColor.a = 1;
+    ASSERT_FALSE(state.isCompact());
+
+    Parcel p;
+    ASSERT_EQ(NO_ERROR, state.write(p));
+    p.setDataPosition(0);
+
+    layer_state_t state2;
+    ASSERT_EQ(NO_ERROR, state2.read(p));
+    ASSERT_EQ(p.dataSize(), p.dataPosition());
+    ASSERT_EQ(state.what, state2.what);
+    ASSERT_EQ("Window", state2.windowInfoHandle->getInfo()->name);
+    ASSERT_EQ(1u, state2.blurRegions.size());
+    ASSERT_EQ(10u, state2.blurRegions[0].blurRadius);
+    ASSERT_EQ(4, state2.blurRegions[0].bottom);
+    ASSERT_EQ(60.f, state2.frameRate);
+    ASSERT_EQ(0.f, state2.cornerRadius);
+    ASSERT_EQ(0.f, state2.bgColor.a);
+}
+
 } // namespace test
 } // namespace android
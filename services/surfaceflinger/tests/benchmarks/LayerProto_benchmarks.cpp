@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Client.h" // temporarily needed for LayerCreationArgs
+#include "FrontEnd/LayerCreationArgs.h"
+#include "FrontEnd/LayerHierarchy.h"
+#include "FrontEnd/LayerLifecycleManager.h"
+#include "FrontEnd/LayerSnapshotBuilder.h"
+#include "FrontEnd/WorkerPool.h"
+#include "LayerProtoHelper.h"
+#include "Tracing/LayerTracing.h"
+
+namespace android::surfaceflinger::frontend {
+namespace {
+
+constexpr uint32_t kRootCount = 4;
+
+// Measures writing the layers proto of state.range(0) layers, the way dumps and layer traces do,
+// on a worker pool if state.range(1). The layers are in binary trees under four roots, like the
+// containers of the displays.
+void BM_LayerProtoGenerate(benchmark::State& state) {
+    const auto layerCount = static_cast<uint32_t>(state.range(0));
+    const bool parallel = state.range(1);
+
+    LayerLifecycleManager lifecycleManager;
+    std::vector<std::unique_ptr<RequestedLayerState>> layers;
+    for (uint32_t id = 1; id <= layerCount; id++) {
+        // The layer is the index-th of the tree of its root.
+        const uint32_t root = (id - 1) % kRootCount + 1;
+        const uint32_t index = (id - 1) / kRootCount;
+        LayerCreationArgs args(std::make_optional(id));
+        args.name = "layer" + std::to_string(id);
+        args.addToRoot = index == 0;
+        args.parentId = index == 0 ? UNASSIGNED_LAYER_ID : root + kRootCount * ((index - 1) / 2);
+        args.layerIdToMirror = UNASSIGNED_LAYER_ID;
+        layers.emplace_back(std::make_unique<RequestedLayerState>(args));
+    }
+    lifecycleManager.addLayers(std::move(layers));
+
+    LayerHierarchyBuilder hierarchyBuilder{{}};
+    hierarchyBuilder.update(lifecycleManager.getLayers(), lifecycleManager.getDestroyedLayers());
+    const display::DisplayMap<ui::LayerStack, DisplayInfo> displayInfos;
+    const renderengine::ShadowSettings globalShadowSettings;
+    LayerSnapshotBuilder snapshotBuilder;
+    snapshotBuilder.update({.root = hierarchyBuilder.getHierarchy(),
+                            .layerLifecycleManager = lifecycleManager,
+                            .includeMetadata = false,
+                            .displays = displayInfos,
+                            .displayChanges = false,
+                            .globalShadowSettings = globalShadowSettings,
+                            .supportsBlur = true,
+                            .supportedLayerGenericMetadata = {},
+                            .genericLayerMetadataKeyMap = {}});
+    lifecycleManager.commitChanges();
+
+    // The threads of the pool and the calling thread write one subtree each.
+    const auto workerPool = parallel ? std::make_unique<WorkerPool>(kRootCount - 1) : nullptr;
+    const std::unordered_map<uint32_t, sp<Layer>> legacyLayers;
+    for (auto _ : state) {
+        LayersProto layersProto =
+                LayerProtoFromSnapshotGenerator(snapshotBuilder, displayInfos, legacyLayers,
+                                                LayerTracing::TRACE_ALL, workerPool.get())
+                        .generate(hierarchyBuilder.getHierarchy());
+        benchmark::DoNotOptimize(layersProto);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * layerCount));
+}
+BENCHMARK(BM_LayerProtoGenerate)
+        ->ArgNames({"layers", "parallel"})
+        ->Args({100, false})
+        ->Args({100, true})
+        ->Args({500, false})
+        ->Args({500, true});
+
+} // namespace
+} // namespace android::surfaceflinger::frontend
+
+BENCHMARK_MAIN();
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <LocklessQueue.h>
+#include <LocklessRingQueue.h>
+
+namespace android {
+namespace {
+
+// Roughly the shape of a TransactionState: a few movable containers and some inline state.
+struct Payload {
+    std::vector<uint64_t> states;
+    std::vector<uint64_t> listenerCallbacks;
+    uint64_t id = 0;
+    uint8_t inlineState[192] = {};
+};
+
+using LinkedListQueue = LocklessQueue<Payload>;
+using RingQueue = LocklessRingQueue<Payload, 64>;
+
+constexpr int kPushesPerProducer = 10000;
+
+// Each iteration starts state.range(0) producer threads, like binder threads calling
+// setTransactionState, while the benchmark thread drains the queue the way the main thread
+// flushes transactions.
+template <typename Queue>
+void BM_QueueThroughput(benchmark::State& state) {
+    const auto producerCount = static_cast<int>(state.range(0));
+    const int total = producerCount * kPushesPerProducer;
+    Queue queue;
+
+    for (auto _ : state) {
+        std::atomic<bool> start = false;
+        std::vector<std::thread> producers;
+        producers.reserve(static_cast<size_t>(producerCount));
+        for (int p = 0; p < producerCount; p++) {
+            producers.emplace_back([&queue, &start, p]() {
+                while (!start.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < kPushesPerProducer; i++) {
+                    Payload payload;
+                    payload.id = static_cast<uint64_t>(p * kPushesPerProducer + i);
+                    queue.push(std::move(payload));
+                }
+            });
+        }
+
+        start.store(true, std::memory_order_release);
+        int received = 0;
+        while (received < total) {
+            if (auto value = queue.pop()) {
+                benchmark::DoNotOptimize(value->id);
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+BENCHMARK_TEMPLATE(BM_QueueThroughput, LinkedListQueue)->Arg(1)->Arg(8)->Arg(16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_QueueThroughput, RingQueue)->Arg(1)->Arg(8)->Arg(16)->UseRealTime();
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
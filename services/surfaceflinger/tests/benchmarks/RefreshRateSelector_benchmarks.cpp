@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <scheduler/Fps.h>
+
+#include "Scheduler/RefreshRateSelector.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+
+namespace android::scheduler {
+namespace {
+
+using namespace std::chrono_literals;
+
+using GlobalSignals = RefreshRateSelector::GlobalSignals;
+using LayerRequirement = RefreshRateSelector::LayerRequirement;
+using LayerVoteType = RefreshRateSelector::LayerVoteType;
+
+using mock::createDisplayMode;
+
+constexpr DisplayModeId kModeId60{0};
+
+// The 30/60/72/90/120 Hz panel of RefreshRateSelectorTest.
+DisplayModes makePanelModes() {
+    return makeModes(createDisplayMode(kModeId60, 60_Hz),
+                     createDisplayMode(DisplayModeId(1), 90_Hz),
+                     createDisplayMode(DisplayModeId(2), 72_Hz),
+                     createDisplayMode(DisplayModeId(3), 120_Hz),
+                     createDisplayMode(DisplayModeId(4), 30_Hz));
+}
+
+struct Query {
+    std::vector<LayerRequirement> layers;
+    GlobalSignals signals;
+};
+
+// Variations on the scenarios of RefreshRateSelectorTest: video, a game, touch over a scrolling
+// list, and a crowded screen where most layers are idle.
+std::vector<Query> makeQueries(size_t count) {
+    const std::vector<Query> scenarios = {
+            {{{.name = "video",
+               .vote = LayerVoteType::ExplicitExactOrMultiple,
+               .desiredRefreshRate = 24_Hz,
+               .weight = 1.f}},
+             {}},
+            {{{.name = "game",
+               .vote = LayerVoteType::ExplicitDefault,
+               .desiredRefreshRate = 60_Hz,
+               .weight = 1.f}},
+             {}},
+            {{{.name = "list", .vote = LayerVoteType::Heuristic, .desiredRefreshRate = 90_Hz,
+               .weight = 1.f},
+              {.name = "statusBar", .vote = LayerVoteType::Min, .weight = 0.1f}},
+             {.touch = true}},
+            {{{.name = "wallpaper", .vote = LayerVoteType::NoVote, .weight = 1.f},
+              {.name = "launcher", .vote = LayerVoteType::Heuristic,
+               .desiredRefreshRate = 60_Hz, .weight = 0.9f},
+              {.name = "widget", .vote = LayerVoteType::Heuristic, .desiredRefreshRate = 30_Hz,
+               .weight = 0.2f},
+              {.name = "statusBar", .vote = LayerVoteType::Min, .weight = 0.1f},
+              {.name = "navigationBar", .vote = LayerVoteType::Min, .weight = 0.1f}},
+             {.idle = true}},
+    };
+
+    std::vector<Query> queries;
+    for (size_t i = 0; i < count; i++) {
+        Query query = scenarios[i % scenarios.size()];
+        // Distinct from the other repetitions of the scenario.
+        query.layers.front().weight /= static_cast<float>(i / scenarios.size() + 1);
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
+
+// Cycles through distinct queries, which all hit the cache if it holds enough entries.
+void BM_RankCycle(benchmark::State& state) {
+    RefreshRateSelector selector(makePanelModes(), kModeId60);
+    const auto queries = makeQueries(static_cast<size_t>(state.range(0)));
+
+    size_t index = 0;
+    for (auto _ : state) {
+        const auto& query = queries[index];
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(query.layers, query.signals));
+        index = (index + 1) % queries.size();
+    }
+
+    const auto stats = selector.getRankedFrameRatesCacheStats();
+    state.counters["hitRate"] =
+            static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+}
+
+// Ranks every query from scratch, since a mode change clears the cache.
+void BM_RankUncached(benchmark::State& state) {
+    RefreshRateSelector selector(makePanelModes(), kModeId60);
+    const auto queries = makeQueries(static_cast<size_t>(state.range(0)));
+
+    size_t index = 0;
+    for (auto _ : state) {
+        selector.setActiveMode(kModeId60, 60_Hz);
+        const auto& query = queries[index];
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(query.layers, query.signals));
+        index = (index + 1) % queries.size();
+    }
+}
+
+BENCHMARK(BM_RankCycle)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_RankUncached)->Arg(1)->Arg(4);
+
+} // namespace
+} // namespace android::scheduler
+
+BENCHMARK_MAIN();
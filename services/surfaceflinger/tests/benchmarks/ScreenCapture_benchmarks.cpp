@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SyncScreenCaptureListener.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+// Captures the main display at the given rate until stopped, the way screen recording does.
+class DisplayCapturer {
+public:
+    DisplayCapturer(sp<IBinder> displayToken, int fps) {
+        if (fps == 0) return;
+        mThread = std::thread([this, displayToken = std::move(displayToken), fps]() {
+            const auto period = std::chrono::nanoseconds(1s) / fps;
+            auto next = std::chrono::steady_clock::now();
+            while (!mStop) {
+                DisplayCaptureArgs args;
+                args.displayToken = displayToken;
+                const auto listener = sp<SyncScreenCaptureListener>::make();
+                if (ScreenshotClient::captureDisplay(args, listener) == NO_ERROR) {
+                    listener->waitForResults();
+                    mCaptures++;
+                }
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    ~DisplayCapturer() {
+        mStop = true;
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+    }
+
+    int getCaptures() const { return mCaptures; }
+
+private:
+    std::atomic<bool> mStop = false;
+    std::atomic<int> mCaptures = 0;
+    std::thread mThread;
+};
+
+// Measures how long synchronous transactions take to be committed while the main display is
+// captured at state.range(0) fps. Captures that schedule work on the main thread delay commits, so
+// the slowest commits show the jank that captures cause. Compare runs with
+// debug.sf.async_screenshots set to 0 and 1, which SurfaceFlinger reads when it starts.
+void BM_CommitWhileCapturing(benchmark::State& state) {
+    const auto displayIds = SurfaceComposerClient::getPhysicalDisplayIds();
+    if (displayIds.empty()) {
+        state.SkipWithError("No physical display");
+        return;
+    }
+    const auto displayToken = SurfaceComposerClient::getPhysicalDisplayToken(displayIds.front());
+
+    const auto client = sp<SurfaceComposerClient>::make();
+    const auto layer =
+            client->createSurface(String8("BM_CommitWhileCapturing"), 0, 0, PIXEL_FORMAT_RGBA_8888,
+                                  ISurfaceComposerClient::eFXSurfaceEffect);
+    if (!layer) {
+        state.SkipWithError("Could not create layer");
+        return;
+    }
+    SurfaceComposerClient::Transaction().setCrop(layer, Rect(0, 0, 1, 1)).show(layer).apply(true);
+
+    const DisplayCapturer capturer(displayToken, static_cast<int>(state.range(0)));
+    nsecs_t maxCommitTime = 0;
+    float alpha = 0.f;
+    for (auto _ : state) {
+        alpha = alpha > 0.5f ? 0.f : 1.f;
+        const nsecs_t start = systemTime();
+        SurfaceComposerClient::Transaction().setAlpha(layer, alpha).apply(true /*synchronous*/);
+        maxCommitTime = std::max(maxCommitTime, systemTime() - start);
+    }
+
+    state.counters["max_commit_ms"] = static_cast<double>(maxCommitTime) / 1e6;
+    state.counters["captures"] = capturer.getCaptures();
+    SurfaceComposerClient::Transaction().reparent(layer, nullptr).apply(true);
+}
+
+BENCHMARK(BM_CommitWhileCapturing)->Arg(0)->Arg(30)->Iterations(300)->UseRealTime();
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
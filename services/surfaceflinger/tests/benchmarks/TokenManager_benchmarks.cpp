@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include <FrameTimeline/FrameTimeline.h>
+
+namespace android {
+namespace {
+
+using frametimeline::TimelineItem;
+
+// Each iteration is one second of tokens generated at state.range(0) tokens per second, each
+// looked up once by the SurfaceFrame created a few frames later and once after it expired. The
+// time per iteration is the CPU time the token manager costs per second at that rate.
+void BM_TokenManager(benchmark::State& state) {
+    const auto tokensPerSecond = state.range(0);
+    constexpr int64_t kLookupLag = 4;
+    constexpr int64_t kExpiredLag = 1000;
+    frametimeline::impl::TokenManager tokenManager;
+    nsecs_t time = 0;
+
+    for (auto _ : state) {
+        for (int64_t i = 0; i < tokensPerSecond; i++) {
+            time += 1000;
+            const int64_t token = tokenManager.generateTokenForPredictions(
+                    TimelineItem(time, time + 16'000'000, time + 32'000'000));
+            benchmark::DoNotOptimize(tokenManager.getPredictionsForToken(token - kLookupLag));
+            benchmark::DoNotOptimize(tokenManager.getPredictionsForToken(token - kExpiredLag));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * tokensPerSecond);
+}
+
+BENCHMARK(BM_TokenManager)->Arg(10000);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <gui/LayerState.h>
+#include <renderengine/mock/RenderEngine.h>
+
+#include "TestableSurfaceFlinger.h"
+#include "TransactionState.h"
+#include "mock/DisplayHardware/MockComposer.h"
+
+namespace android {
+namespace {
+
+// Measures SurfaceFlinger::setClientStateLocked applying the states of a window animation frame
+// to state.range(0) layers, the per-layer part of applying a transaction.
+void BM_SetClientState(benchmark::State& state) {
+    TestableSurfaceFlinger flinger;
+    flinger.setupMockScheduler();
+    flinger.setupComposer(std::make_unique<Hwc2::mock::Composer>());
+    flinger.setupRenderEngine(std::make_unique<renderengine::mock::RenderEngine>());
+
+    const auto layerCount = static_cast<size_t>(state.range(0));
+    std::vector<sp<Layer>> layers;
+    std::vector<ResolvedComposerState> composerStates(layerCount);
+    for (size_t i = 0; i < layerCount; i++) {
+        sp<Client> client;
+        LayerCreationArgs args(flinger.flinger(), client, "layer" + std::to_string(i), 0,
+                               LayerMetadata());
+        layers.push_back(sp<Layer>::make(args));
+
+        layer_state_t& s = composerStates[i].state;
+        s.surface = layers.back()->getHandle();
+        s.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged |
+                layer_state_t::eMatrixChanged | layer_state_t::eCropChanged |
+                layer_state_t::eCornerRadiusChanged;
+        s.crop = Rect(0, 0, 1080, 2400);
+        s.cornerRadius = 16;
+    }
+
+    int64_t frame = 0;
+    for (auto _ : state) {
+        // The layers only take the changes of their state into account.
+        const float progress = static_cast<float>(frame++ % 100) / 100.f;
+        for (auto& composerState : composerStates) {
+            layer_state_t& s = composerState.state;
+            s.x = progress * 100;
+            s.y = progress * 200;
+            s.color.a = progress;
+            s.matrix = {.dsdx = progress, .dtdx = 0, .dtdy = 0, .dsdy = progress};
+            benchmark::DoNotOptimize(
+                    flinger.setClientStateLocked(FrameTimelineInfo{}, composerState,
+                                                 /*desiredPresentTime=*/0,
+                                                 /*isAutoTimestamp=*/true, /*postTime=*/0,
+                                                 /*transactionId=*/0));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * layerCount));
+}
+BENCHMARK(BM_SetClientState)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
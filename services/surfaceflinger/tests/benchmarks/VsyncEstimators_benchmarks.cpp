@@ -0,0 +1,190 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <scheduler/VsyncEstimators.h>
+
+namespace android::scheduler {
+namespace {
+
+constexpr nsecs_t kIdealPeriod = 16'666'666;
+constexpr size_t kHistorySize = 20;
+constexpr size_t kMinimumSamplesForPrediction = 6;
+constexpr nsecs_t kOutlierTolerancePercent = 25;
+
+struct Sample {
+    // The HW vsync timestamp reported to the estimator.
+    nsecs_t observed;
+    // The vsync the timestamp belongs to, without jitter.
+    nsecs_t actual;
+};
+
+enum class Trace { Real60Hz, Jitter60Hz, Outliers60Hz };
+
+std::vector<Sample> makeTrace(Trace trace) {
+    if (trace == Trace::Real60Hz) {
+        // Real vsync timestamps from b/190331974, which include several that are very close.
+        constexpr nsecs_t kTimestamps[] = {
+                198353408177, 198370074844, 198371400000, 198374274000, 198390941000, 198407565000,
+                198540887994, 198607538588, 198624218276, 198657655939, 198674224176, 198690880955,
+                198724204319, 198740988133, 198758166681, 198790869196, 198824205052, 198840871678,
+                198857715631, 198890885797, 198924199640, 198940873834, 198974204401,
+        };
+        std::vector<Sample> samples;
+        for (const nsecs_t timestamp : kTimestamps) {
+            samples.push_back({timestamp, timestamp});
+        }
+        return samples;
+    }
+
+    // A panel that runs slightly fast, with Gaussian timestamp jitter. The outlier trace makes
+    // every 17th timestamp 3ms late, which is inside the fixed phase tolerance.
+    constexpr nsecs_t kActualPeriod = 16'600'000;
+    std::mt19937 generator(1234);
+    std::normal_distribution<double> jitter(0, 100'000);
+    std::vector<Sample> samples;
+    for (nsecs_t i = 0; i < 600; i++) {
+        const nsecs_t actual = 1'000'000'000 + i * kActualPeriod;
+        nsecs_t observed = actual + static_cast<nsecs_t>(jitter(generator));
+        if (trace == Trace::Outliers60Hz && i % 17 == 5) {
+            observed += 3'000'000;
+        }
+        samples.push_back({observed, actual});
+    }
+    return samples;
+}
+
+// Predicts the vsync closest to `timePoint`.
+nsecs_t predict(const VsyncModelFit& model, nsecs_t origin, nsecs_t timePoint) {
+    const nsecs_t zero = origin + model.intercept;
+    const nsecs_t ordinal = (timePoint - zero + model.slope / 2) / model.slope;
+    return zero + ordinal * model.slope;
+}
+
+// History and phase gating of VSyncPredictor, around fitVsyncLeastSquares.
+class LeastSquaresReplay {
+public:
+    void add(nsecs_t timestamp) {
+        if (mCount > 0) {
+            const nsecs_t last = mTimestamps[(mNext + kHistorySize - 1) % kHistorySize];
+            const nsecs_t percent = std::abs(timestamp - last) % kIdealPeriod * 100 / kIdealPeriod;
+            if (percent >= kOutlierTolerancePercent && percent <= 100 - kOutlierTolerancePercent) {
+                return;
+            }
+        }
+        mTimestamps[mNext] = timestamp;
+        mNext = (mNext + 1) % kHistorySize;
+        mCount = std::min(mCount + 1, kHistorySize);
+
+        if (mCount >= kMinimumSamplesForPrediction) {
+            const std::span<const nsecs_t> timestamps(mTimestamps.data(), mCount);
+            mOrigin = *std::min_element(timestamps.begin(), timestamps.end());
+            if (const auto fit = fitVsyncLeastSquares(timestamps, mOrigin, mModel.slope)) {
+                mModel = *fit;
+            }
+        } else {
+            mOrigin = timestamp;
+            mModel = {kIdealPeriod, 0};
+        }
+    }
+
+    nsecs_t predict(nsecs_t timePoint) const {
+        return scheduler::predict(mModel, mOrigin, timePoint);
+    }
+
+private:
+    std::array<nsecs_t, kHistorySize> mTimestamps{};
+    size_t mNext = 0;
+    size_t mCount = 0;
+    nsecs_t mOrigin = 0;
+    VsyncModelFit mModel{kIdealPeriod, 0};
+};
+
+class KalmanReplay {
+public:
+    void add(nsecs_t timestamp) {
+        mFilter.update(timestamp);
+        mOrigin = mFilter.getLastVsyncTime();
+        mModel = mFilter.getModel(mOrigin);
+    }
+
+    nsecs_t predict(nsecs_t timePoint) const {
+        return scheduler::predict(mModel, mOrigin, timePoint);
+    }
+
+private:
+    VsyncKalmanFilter mFilter{kIdealPeriod};
+    nsecs_t mOrigin = 0;
+    VsyncModelFit mModel{kIdealPeriod, 0};
+};
+
+// Feeds the trace through the estimator, predicting every vsync from the samples before it.
+// Reports the prediction error against the actual vsync, and the CPU cost per sample.
+template <typename Replay>
+void BM_VsyncPrediction(benchmark::State& state, Trace trace) {
+    const auto samples = makeTrace(trace);
+    double errorSum = 0;
+    nsecs_t maxError = 0;
+    size_t predictions = 0;
+
+    for (auto _ : state) {
+        Replay replay;
+        errorSum = 0;
+        maxError = 0;
+        predictions = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            if (i >= kMinimumSamplesForPrediction) {
+                const nsecs_t error = std::abs(replay.predict(samples[i].actual) -
+                                               samples[i].actual);
+                errorSum += static_cast<double>(error);
+                maxError = std::max(maxError, error);
+                predictions++;
+            }
+            replay.add(samples[i].observed);
+        }
+        benchmark::DoNotOptimize(errorSum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+    state.counters["meanErrorUs"] = predictions ? errorSum / predictions / 1e3 : 0;
+    state.counters["maxErrorUs"] = static_cast<double>(maxError) / 1e3;
+}
+
+void BM_VsyncPrediction_LeastSquares(benchmark::State& state, Trace trace) {
+    BM_VsyncPrediction<LeastSquaresReplay>(state, trace);
+}
+void BM_VsyncPrediction_Kalman(benchmark::State& state, Trace trace) {
+    BM_VsyncPrediction<KalmanReplay>(state, trace);
+}
+
+BENCHMARK_CAPTURE(BM_VsyncPrediction_LeastSquares, real60Hz, Trace::Real60Hz);
+BENCHMARK_CAPTURE(BM_VsyncPrediction_Kalman, real60Hz, Trace::Real60Hz);
+BENCHMARK_CAPTURE(BM_VsyncPrediction_LeastSquares, jitter60Hz, Trace::Jitter60Hz);
+BENCHMARK_CAPTURE(BM_VsyncPrediction_Kalman, jitter60Hz, Trace::Jitter60Hz);
+BENCHMARK_CAPTURE(BM_VsyncPrediction_LeastSquares, outliers60Hz, Trace::Outliers60Hz);
+BENCHMARK_CAPTURE(BM_VsyncPrediction_Kalman, outliers60Hz, Trace::Outliers60Hz);
+
+} // namespace
+} // namespace android::scheduler
+
+BENCHMARK_MAIN();
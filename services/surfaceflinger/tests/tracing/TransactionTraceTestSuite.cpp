@@ -23,6 +23,7 @@
 #include <unordered_map>
 
 #include <LayerProtoHelper.h>
+#include <LayerTraceBenchmark.h>
 #include <LayerTraceGenerator.h>
 #include <Tracing/TransactionProtoParser.h>
 #include <layerproto/LayerProtoHeader.h>
@@ -229,6 +230,20 @@ TEST_P(TransactionTraceTestSuite, validateEndState) {
     }
 }
 
+TEST_P(TransactionTraceTestSuite, benchmarkReplaysAllEntries) {
+    constexpr int kIterations = 2;
+    LayerTraceBenchmark benchmark;
+    ASSERT_TRUE(benchmark.replay(mTransactionTrace, kIterations));
+
+    const size_t frameCount = static_cast<size_t>(mTransactionTrace.entry_size() * kIterations);
+    EXPECT_EQ(frameCount, benchmark.getFrameCount());
+    EXPECT_EQ(frameCount, benchmark.getApplyTransactions().allocationCounts.size());
+    EXPECT_EQ(frameCount, benchmark.getUpdateSnapshots().durations.size());
+
+    // Layers are created, so the replay must have allocated.
+    EXPECT_GT(benchmark.getApplyTransactions().allocatedBytes, 0u);
+}
+
 std::string PrintToStringParamName(const ::testing::TestParamInfo<std::filesystem::path>& info) {
     const auto& prefix = android::TransactionTraceTestSuite::sTransactionTracePrefix;
     const auto& postfix = android::TransactionTraceTestSuite::sTracePostfix;
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+namespace android {
+namespace {
+
+thread_local ScopedAllocationCounter* tCurrentCounter = nullptr;
+
+void* allocate(size_t bytes) {
+    ScopedAllocationCounter::onAllocation(bytes);
+    // malloc(0) may return nullptr, which operator new must not. Tests are built without
+    // exceptions, so running out of memory aborts instead of throwing std::bad_alloc.
+    if (void* p = std::malloc(bytes ? bytes : 1)) {
+        return p;
+    }
+    std::abort();
+}
+
+void* allocateAligned(size_t bytes, std::align_val_t alignment) {
+    ScopedAllocationCounter::onAllocation(bytes);
+    void* p = nullptr;
+    const auto align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if (posix_memalign(&p, align, bytes ? bytes : 1) != 0) {
+        std::abort();
+    }
+    return p;
+}
+
+} // namespace
+
+ScopedAllocationCounter::ScopedAllocationCounter() : mPrevious(tCurrentCounter) {
+    tCurrentCounter = this;
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter() {
+    tCurrentCounter = mPrevious;
+}
+
+void ScopedAllocationCounter::onAllocation(size_t bytes) {
+    if (ScopedAllocationCounter* counter = tCurrentCounter) {
+        counter->mAllocationCount++;
+        counter->mAllocatedBytes += bytes;
+    }
+}
+
+} // namespace android
+
+// Replacements for the global allocation functions. They forward to malloc, which the address
+// sanitizer still instruments, so only new/delete mismatch detection is lost in this binary.
+void* operator new(size_t bytes) {
+    return android::allocate(bytes);
+}
+
+void* operator new[](size_t bytes) {
+    return android::allocate(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    android::ScopedAllocationCounter::onAllocation(bytes);
+    return std::malloc(bytes ? bytes : 1);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    android::ScopedAllocationCounter::onAllocation(bytes);
+    return std::malloc(bytes ? bytes : 1);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return android::allocateAligned(bytes, alignment);
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+    return android::allocateAligned(bytes, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace android {
+
+// Counts heap allocations made through operator new on the calling thread while in scope, so
+// that tests can assert that a hot path does not allocate. Work done on other threads, such as
+// BackgroundExecutor callbacks, is not counted.
+//
+// The global operator new replacement lives in AllocationCounter.cpp. Counters nest; only the
+// innermost one counts.
+class ScopedAllocationCounter {
+public:
+    ScopedAllocationCounter();
+    ~ScopedAllocationCounter();
+
+    ScopedAllocationCounter(const ScopedAllocationCounter&) = delete;
+    ScopedAllocationCounter& operator=(const ScopedAllocationCounter&) = delete;
+
+    size_t getAllocationCount() const { return mAllocationCount; }
+    size_t getAllocatedBytes() const { return mAllocatedBytes; }
+
+    // Called by the operator new replacement.
+    static void onAllocation(size_t bytes);
+
+private:
+    ScopedAllocationCounter* const mPrevious;
+    size_t mAllocationCount = 0;
+    size_t mAllocatedBytes = 0;
+};
+
+} // namespace android
@@ -1,10 +1,16 @@
+#include <ftl/enum.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <vector>
 
 #include "BackgroundExecutor.h"
 
 namespace android {
 
+using namespace std::chrono_literals;
+
 class BackgroundExecutorTest : public testing::Test {};
 
 namespace {
@@ -52,6 +58,69 @@ TEST_F(BackgroundExecutorTest, multipleProducers) {
     ASSERT_EQ(backgroundTaskCount, backgroundTaskCompleteCount);
 }
 
+TEST_F(BackgroundExecutorTest, laneRunsBatchesInOrder) {
+    constexpr int kBatchCount = 100;
+    std::vector<int> order;
+    for (int i = 0; i < kBatchCount; i++) {
+        BackgroundExecutor::getInstance().sendCallbacks({[&order, i]() { order.push_back(i); }},
+                                                        BackgroundExecutor::Lane::Bulk);
+    }
+    BackgroundExecutor::getInstance().flushQueue();
+
+    ASSERT_EQ(static_cast<size_t>(kBatchCount), order.size());
+    EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST_F(BackgroundExecutorTest, slowBulkWorkDoesNotBlockLatencyCriticalWork) {
+    std::mutex mutex;
+    std::condition_variable condition_variable;
+    bool releaseBulk = false;
+    bool criticalComplete = false;
+
+    BackgroundExecutor::getInstance().sendCallbacks(
+            {[&]() {
+                std::unique_lock<std::mutex> lock{mutex};
+                condition_variable.wait(lock, [&]() { return releaseBulk; });
+            }},
+            BackgroundExecutor::Lane::Bulk);
+    BackgroundExecutor::getInstance().sendCallbacks({[&]() {
+        std::lock_guard<std::mutex> lock{mutex};
+        criticalComplete = true;
+        condition_variable.notify_all();
+    }});
+
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        EXPECT_TRUE(condition_variable.wait_for(lock, 5s, [&]() { return criticalComplete; }));
+        releaseBulk = true;
+        condition_variable.notify_all();
+    }
+    BackgroundExecutor::getInstance().flushQueue();
+}
+
+TEST_F(BackgroundExecutorTest, flushQueueWaitsForAllLanes) {
+    std::atomic<int> completed = 0;
+    for (const auto lane : ftl::enum_range<BackgroundExecutor::Lane>()) {
+        BackgroundExecutor::getInstance().sendCallbacks({[&completed]() {
+                                                            std::this_thread::sleep_for(10ms);
+                                                            completed++;
+                                                        }},
+                                                        lane);
+    }
+    BackgroundExecutor::getInstance().flushQueue();
+    EXPECT_EQ(static_cast<int>(BackgroundExecutor::kLaneCount), completed.load());
+}
+
+TEST_F(BackgroundExecutorTest, dumpReportsEveryLane) {
+    BackgroundExecutor::getInstance().flushQueue();
+
+    std::string result;
+    BackgroundExecutor::getInstance().dump(result);
+    EXPECT_NE(std::string::npos, result.find("LatencyCritical: depth=0"));
+    EXPECT_NE(std::string::npos, result.find("Bulk: depth=0"));
+    EXPECT_NE(std::string::npos, result.find("queue latency: <100us="));
+}
+
 } // namespace
 
 } // namespace android
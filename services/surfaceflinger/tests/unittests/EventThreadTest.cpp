@@ -427,6 +427,62 @@ TEST_F(EventThreadTest, requestNextVsyncEventFrameTimelinesCorrect) {
     expectVsyncEventFrameTimelinesCorrect(123, {-1, 789, 456});
 }
 
+TEST_F(EventThreadTest, vsyncDecisionsAreSharedByConnectionsOfSameUid) {
+    setupEventThread(VSYNC_PERIOD);
+
+    ConnectionEventRecorder secondConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> secondConnection =
+            createConnection(secondConnectionEventRecorder);
+
+    mThread->requestNextVsync(mConnection);
+    mThread->requestNextVsync(secondConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    // The throttler should only be asked once for both connections.
+    onVSyncEvent(123, 456, 789);
+    expectThrottleVsyncReceived(456, mConnectionUid);
+    EXPECT_FALSE(mThrottleVsyncCallRecorder.waitForUnexpectedCall().has_value());
+
+    // Both connections should receive the same frame timelines.
+    auto args = mConnectionEventCallRecorder.waitForCall();
+    ASSERT_TRUE(args.has_value());
+    auto secondArgs = secondConnectionEventRecorder.waitForCall();
+    ASSERT_TRUE(secondArgs.has_value());
+
+    const auto& vsyncData = std::get<0>(args.value()).vsync.vsyncData;
+    const auto& secondVsyncData = std::get<0>(secondArgs.value()).vsync.vsyncData;
+    ASSERT_EQ(vsyncData.frameTimelinesLength, secondVsyncData.frameTimelinesLength);
+    for (size_t i = 0; i < vsyncData.frameTimelinesLength; i++) {
+        EXPECT_EQ(vsyncData.frameTimelines[i].vsyncId, secondVsyncData.frameTimelines[i].vsyncId);
+    }
+
+    std::string dump;
+    mThread->dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("vsync wake latency (first/last connection):"));
+}
+
+TEST_F(EventThreadTest, vsyncMailboxReceivesVsyncWithoutRequest) {
+    setupEventThread(VSYNC_PERIOD);
+
+    base::unique_fd fd;
+    ASSERT_EQ(NO_ERROR, mThread->enableVsyncMailbox(mConnection, &fd));
+    const auto mailbox = gui::VsyncMailbox::fromFd(std::move(fd));
+    ASSERT_NE(nullptr, mailbox);
+    EXPECT_FALSE(mailbox->read());
+
+    // The connection did not request the VSYNC, so it is only published to the mailbox.
+    onVSyncEvent(123, 456, 789);
+    ASSERT_TRUE(mailbox->waitForNext(0, 1s));
+    EXPECT_FALSE(mConnectionEventCallRecorder.waitForUnexpectedCall().has_value());
+
+    const auto vsync = mailbox->read();
+    ASSERT_TRUE(vsync);
+    EXPECT_EQ(123, vsync->timestamp);
+    EXPECT_EQ(1u, vsync->count);
+    EXPECT_EQ(std::chrono::nanoseconds(VSYNC_PERIOD).count(), vsync->vsyncData.frameInterval);
+    EXPECT_EQ(789, vsync->vsyncData.preferredDeadlineTimestamp());
+}
+
 TEST_F(EventThreadTest, requestNextVsyncEventFrameTimelinesValidLength) {
     // The VsyncEventData should not have kFrameTimelinesCapacity amount of valid frame timelines,
     // due to longer vsync period and kEarlyLatchMaxThreshold. Use length-2 to avoid decimal
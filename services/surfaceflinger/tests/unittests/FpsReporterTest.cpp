@@ -26,6 +26,7 @@
 
 #include "FpsReporter.h"
 #include "Layer.h"
+#include "LayerHierarchyTest.h"
 #include "TestableSurfaceFlinger.h"
 #include "fake/FakeClock.h"
 #include "mock/DisplayHardware/MockComposer.h"
@@ -183,5 +184,115 @@ TEST_F(FpsReporterTest, rateLimits) {
     EXPECT_EQ(secondFps, mFpsListener->lastReportedFps);
 }
 
+TEST_F(FpsReporterTest, callsListenersWithTrackedTaskLayers) {
+    using surfaceflinger::frontend::RequestedLayerState;
+    constexpr int32_t kTaskId = 12;
+    const auto tracker = mFpsReporter->trackTaskLayers();
+    const auto createLayer = [&](uint32_t id, uint32_t parentId, LayerMetadata metadata = {}) {
+        LayerCreationArgs args(std::make_optional(id));
+        args.parentId = parentId;
+        args.metadata = metadata;
+        tracker->onLayerAdded(RequestedLayerState(args));
+    };
+    LayerMetadata targetMetadata;
+    targetMetadata.setInt32(gui::METADATA_TASK_ID, kTaskId);
+    createLayer(1, surfaceflinger::frontend::UNASSIGNED_LAYER_ID);
+    createLayer(2, 1, targetMetadata);
+    createLayer(3, 2);
+    createLayer(4, 1);
+
+    float expectedFps = 44.0;
+    EXPECT_CALL(mFrameTimeline, computeFps(UnorderedElementsAre(2, 3)))
+            .WillOnce(Return(expectedFps));
+
+    mFpsReporter->addListener(mFpsListener, kTaskId);
+    mClock->advanceTime(600ms);
+    mFpsReporter->dispatchLayerFps();
+    EXPECT_EQ(expectedFps, mFpsListener->lastReportedFps);
+}
+
 } // namespace
+
+namespace surfaceflinger::frontend {
+
+class TaskLayerTrackerTest : public LayerHierarchyTestBase {
+protected:
+    TaskLayerTrackerTest() { mLifecycleManager.addLifecycleListener(mTracker); }
+
+    void setTaskId(uint32_t id, int32_t taskId) {
+        std::vector<TransactionState> transactions;
+        transactions.emplace_back();
+        transactions.back().states.push_back({});
+        transactions.back().states.front().state.what = layer_state_t::eMetadataChanged;
+        transactions.back().states.front().layerId = id;
+        transactions.back().states.front().state.metadata.setInt32(gui::METADATA_TASK_ID, taskId);
+        mLifecycleManager.applyTransactions(transactions);
+    }
+
+    std::unordered_set<int32_t> getTaskLayers(int32_t taskId) const {
+        const auto* layerIds = mTracker->getTaskLayers(taskId);
+        return layerIds ? *layerIds : std::unordered_set<int32_t>();
+    }
+
+    std::shared_ptr<TaskLayerTracker> mTracker = std::make_shared<TaskLayerTracker>();
+};
+
+TEST_F(TaskLayerTrackerTest, tracksTaskTrees) {
+    constexpr int32_t kTaskId = 5;
+    setTaskId(12, kTaskId);
+    mLifecycleManager.commitChanges();
+    EXPECT_THAT(getTaskLayers(kTaskId), testing::UnorderedElementsAre(12, 121, 122, 1221));
+
+    createLayer(123, 12);
+    mLifecycleManager.commitChanges();
+    EXPECT_THAT(getTaskLayers(kTaskId), testing::UnorderedElementsAre(12, 121, 122, 123, 1221));
+}
+
+TEST_F(TaskLayerTrackerTest, updatesTaskTreesOnReparent) {
+    constexpr int32_t kTaskId = 5;
+    setTaskId(1, kTaskId);
+    setTaskId(2, kTaskId + 1);
+    mLifecycleManager.commitChanges();
+
+    reparentLayer(122, 2);
+    mLifecycleManager.commitChanges();
+    EXPECT_THAT(getTaskLayers(kTaskId),
+                testing::UnorderedElementsAre(1, 11, 12, 13, 111, 121));
+    EXPECT_THAT(getTaskLayers(kTaskId + 1), testing::UnorderedElementsAre(2, 122, 1221));
+
+    reparentLayer(122, UNASSIGNED_LAYER_ID);
+    mLifecycleManager.commitChanges();
+    EXPECT_THAT(getTaskLayers(kTaskId + 1), testing::UnorderedElementsAre(2));
+}
+
+TEST_F(TaskLayerTrackerTest, keepsLayersOfNestedTasksOfSameId) {
+    constexpr int32_t kTaskId = 5;
+    setTaskId(1, kTaskId);
+    setTaskId(12, kTaskId);
+    mLifecycleManager.commitChanges();
+
+    setTaskId(1, kTaskId + 1);
+    mLifecycleManager.commitChanges();
+    EXPECT_THAT(getTaskLayers(kTaskId), testing::UnorderedElementsAre(12, 121, 122, 1221));
+    EXPECT_THAT(getTaskLayers(kTaskId + 1),
+                testing::UnorderedElementsAre(1, 11, 12, 13, 111, 121, 122, 1221));
+}
+
+TEST_F(TaskLayerTrackerTest, removesDestroyedLayers) {
+    constexpr int32_t kTaskId = 5;
+    setTaskId(12, kTaskId);
+    mLifecycleManager.commitChanges();
+
+    reparentLayer(122, UNASSIGNED_LAYER_ID);
+    destroyLayerHandle(122);
+    mLifecycleManager.commitChanges();
+    EXPECT_THAT(getTaskLayers(kTaskId), testing::UnorderedElementsAre(12, 121));
+
+    reparentLayer(12, UNASSIGNED_LAYER_ID);
+    destroyLayerHandle(12);
+    mLifecycleManager.commitChanges();
+    EXPECT_EQ(nullptr, mTracker->getTaskLayers(kTaskId));
+}
+
+} // namespace surfaceflinger::frontend
 } // namespace android
@@ -181,5 +181,30 @@ TEST_F(FrameRateOverrideMappingsTest, testGetFrameRateOverrideForUidMixed) {
               mFrameRateOverrideMappings
                       .getFrameRateOverrideForUid(5, /*supportsFrameRateOverrideByContent*/ false));
 }
+
+TEST_F(FrameRateOverrideMappingsTest, readerSeesChanges) {
+    FrameRateOverrideMappings::Reader reader(mFrameRateOverrideMappings);
+    ASSERT_EQ(std::nullopt,
+              reader.getFrameRateOverrideForUid(0, /*supportsFrameRateOverrideByContent*/ true));
+
+    mFrameRateOverrideByContent.emplace(0, 30.0_Hz);
+    ASSERT_TRUE(mFrameRateOverrideMappings.updateFrameRateOverridesByContent(
+            mFrameRateOverrideByContent));
+    ASSERT_TRUE(isApproxEqual(30.0_Hz,
+                              *reader.getFrameRateOverrideForUid(
+                                      0, /*supportsFrameRateOverrideByContent*/ true)));
+    ASSERT_EQ(std::nullopt,
+              reader.getFrameRateOverrideForUid(0, /*supportsFrameRateOverrideByContent*/ false));
+
+    mFrameRateOverrideMappings.setGameModeRefreshRateForUid({0, 60.0f});
+    ASSERT_TRUE(isApproxEqual(60.0_Hz,
+                              *reader.getFrameRateOverrideForUid(
+                                      0, /*supportsFrameRateOverrideByContent*/ false)));
+
+    mFrameRateOverrideMappings.setGameModeRefreshRateForUid({0, 0.0f});
+    ASSERT_TRUE(isApproxEqual(30.0_Hz,
+                              *reader.getFrameRateOverrideForUid(
+                                      0, /*supportsFrameRateOverrideByContent*/ true)));
+}
 } // namespace
 } // namespace android::scheduler
@@ -24,6 +24,7 @@
 #include <gtest/gtest.h>
 #include <log/log.h>
 #include <perfetto/trace/trace.pb.h>
+#include <algorithm>
 #include <cinttypes>
 
 using namespace std::chrono_literals;
@@ -77,10 +78,15 @@ public:
     }
 
     void SetUp() override {
-        constexpr bool kUseBootTimeClock = true;
         mTimeStats = std::make_shared<mock::TimeStats>();
+        createFrameTimeline(/*pipelinedPresent=*/false);
+    }
+
+    void createFrameTimeline(bool pipelinedPresent) {
+        constexpr bool kUseBootTimeClock = true;
         mFrameTimeline = std::make_unique<impl::FrameTimeline>(mTimeStats, kSurfaceFlingerPid,
-                                                               kTestThresholds, !kUseBootTimeClock);
+                                                               kTestThresholds, !kUseBootTimeClock,
+                                                               pipelinedPresent);
         mFrameTimeline->registerDataSource();
         mTokenManager = &mFrameTimeline->mTokenManager;
         mTraceCookieCounter = &mFrameTimeline->mTraceCookieCounter;
@@ -88,6 +94,8 @@ public:
         maxTokens = mTokenManager->kMaxTokens;
     }
 
+    void waitForPresentQueue() { mFrameTimeline->waitForPresentQueue(); }
+
     // Each tracing session can be used for a single block of Start -> Stop.
     static std::unique_ptr<perfetto::TracingSession> getTracingSessionForTest() {
         perfetto::TraceConfig cfg;
@@ -135,7 +143,7 @@ public:
         for (size_t i = 0; i < maxTokens; i++) {
             mTokenManager->generateTokenForPredictions({});
         }
-        EXPECT_EQ(getPredictions().size(), maxTokens);
+        EXPECT_EQ(getNumberOfPredictions(), maxTokens);
     }
 
     SurfaceFrame& getSurfaceFrame(size_t displayFrameIdx, size_t surfaceFrameIdx) {
@@ -154,8 +162,13 @@ public:
                 a.presentTime == b.presentTime;
     }
 
-    const std::map<int64_t, TimelineItem>& getPredictions() const {
-        return mTokenManager->mPredictions;
+    size_t getNumberOfPredictions() const {
+        std::lock_guard<std::mutex> lock(mTokenManager->mMutex);
+        return static_cast<size_t>(
+                std::count_if(mTokenManager->mPredictions.begin(),
+                              mTokenManager->mPredictions.end(), [](const auto& prediction) {
+                                  return prediction.token != FrameTimelineInfo::INVALID_VSYNC_ID;
+                              }));
     }
 
     uint32_t getNumberOfDisplayFrames() const {
@@ -189,7 +202,7 @@ public:
 
 TEST_F(FrameTimelineTest, tokenManagerRemovesStalePredictions) {
     int64_t token1 = mTokenManager->generateTokenForPredictions({0, 0, 0});
-    EXPECT_EQ(getPredictions().size(), 1u);
+    EXPECT_EQ(getNumberOfPredictions(), 1u);
     flushTokens();
     int64_t token2 = mTokenManager->generateTokenForPredictions({10, 20, 30});
     std::optional<TimelineItem> predictions = mTokenManager->getPredictionsForToken(token1);
@@ -201,6 +214,30 @@ TEST_F(FrameTimelineTest, tokenManagerRemovesStalePredictions) {
     EXPECT_EQ(compareTimelineItems(*predictions, TimelineItem(10, 20, 30)), true);
 }
 
+TEST_F(FrameTimelineTest, tokenManagerExpiresTokensAfterMaxTokens) {
+    int64_t token1 = mTokenManager->generateTokenForPredictions({10, 20, 30});
+    for (size_t i = 0; i < maxTokens - 1; i++) {
+        mTokenManager->generateTokenForPredictions({});
+    }
+    // token1 is the oldest token that is still stored
+    std::optional<TimelineItem> predictions = mTokenManager->getPredictionsForToken(token1);
+    ASSERT_TRUE(predictions.has_value());
+    EXPECT_EQ(compareTimelineItems(*predictions, TimelineItem(10, 20, 30)), true);
+
+    // The next token reuses the slot of token1
+    int64_t token2 = mTokenManager->generateTokenForPredictions({40, 50, 60});
+    EXPECT_EQ(getNumberOfPredictions(), maxTokens);
+    EXPECT_FALSE(mTokenManager->getPredictionsForToken(token1).has_value());
+    predictions = mTokenManager->getPredictionsForToken(token2);
+    ASSERT_TRUE(predictions.has_value());
+    EXPECT_EQ(compareTimelineItems(*predictions, TimelineItem(40, 50, 60)), true);
+
+    // Tokens that were never generated have no predictions
+    EXPECT_FALSE(mTokenManager->getPredictionsForToken(token2 + 1).has_value());
+    EXPECT_FALSE(
+            mTokenManager->getPredictionsForToken(FrameTimelineInfo::INVALID_VSYNC_ID).has_value());
+}
+
 TEST_F(FrameTimelineTest, createSurfaceFrameForToken_getOwnerPidReturnsCorrectPid) {
     auto surfaceFrame1 =
             mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, sUidOne, sLayerIdOne,
@@ -801,6 +838,49 @@ TEST_F(FrameTimelineTest, presentFenceSignaled_displayFramePredictionExpiredPres
  * another TracePacket is created, the previous one is guaranteed to be flushed. The following tests
  * will have additional empty frames created for this reason.
  */
+TEST_F(FrameTimelineTest, pipelinedPresent_classifiesAndTracesOnWorker) {
+    createFrameTimeline(/*pipelinedPresent=*/true);
+    auto tracingSession = getTracingSessionForTest();
+    Fps refreshRate = Fps::fromPeriodNsecs(11);
+    EXPECT_CALL(*mTimeStats,
+                incrementJankyFrames(
+                        TimeStats::JankyFramesInfo{refreshRate, std::nullopt, sUidOne,
+                                                   sLayerNameOne, sGameMode,
+                                                   JankType::SurfaceFlingerCpuDeadlineMissed, 2, 10,
+                                                   0}));
+    auto presentFence1 = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    int64_t surfaceFrameToken1 = mTokenManager->generateTokenForPredictions({10, 20, 60});
+    int64_t sfToken1 = mTokenManager->generateTokenForPredictions({52, 60, 60});
+    FrameTimelineInfo ftInfo;
+    ftInfo.vsyncId = surfaceFrameToken1;
+    ftInfo.inputEventId = sInputEventId;
+
+    tracingSession->StartBlocking();
+    auto surfaceFrame1 =
+            mFrameTimeline->createSurfaceFrameForToken(ftInfo, sPidOne, sUidOne, sLayerIdOne,
+                                                       sLayerNameOne, sLayerNameOne,
+                                                       /*isBuffer*/ true, sGameMode);
+    mFrameTimeline->setSfWakeUp(sfToken1, 52, refreshRate);
+    surfaceFrame1->setAcquireFenceTime(20);
+    surfaceFrame1->setPresentState(SurfaceFrame::PresentState::Presented);
+    mFrameTimeline->addSurfaceFrame(surfaceFrame1);
+    presentFence1->signalForTest(70);
+    mFrameTimeline->setSfPresent(62, presentFence1);
+
+    // The frame is only queued by setSfPresent, and classified by the worker.
+    waitForPresentQueue();
+    auto displayFrame = getDisplayFrame(0);
+    EXPECT_EQ(displayFrame->getActuals().presentTime, 70);
+    EXPECT_EQ(surfaceFrame1->getActuals().presentTime, 70);
+    EXPECT_EQ(surfaceFrame1->getJankType(), JankType::SurfaceFlingerCpuDeadlineMissed);
+
+    flushTrace();
+    tracingSession->StopBlocking();
+    auto packets = readFrameTimelinePacketsBlocking(tracingSession.get());
+    // 4 packets from the DisplayFrame and 4 from the SurfaceFrame.
+    EXPECT_EQ(packets.size(), 8u);
+}
+
 TEST_F(FrameTimelineTest, tracing_noPacketsSentWithoutTraceStart) {
     auto tracingSession = getTracingSessionForTest();
     auto presentFence1 = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
@@ -2445,6 +2525,25 @@ TEST_F(FrameTimelineTest, computeFps_averagesOverMultipleFrames) {
     EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdOne}), 5.0f);
 }
 
+TEST_F(FrameTimelineTest, computeFps_onlyAveragesOverSlidingWindow) {
+    mFrameTimeline->setMaxDisplayFrames(2);
+    for (const auto presentTime : {100ms, 200ms, 400ms}) {
+        auto surfaceFrame =
+                mFrameTimeline->createSurfaceFrameForToken(FrameTimelineInfo(), sPidOne, sUidOne,
+                                                           sLayerIdOne, sLayerNameOne,
+                                                           sLayerNameOne, /*isBuffer*/ true,
+                                                           sGameMode);
+        auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+        surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+        mFrameTimeline->addSurfaceFrame(surfaceFrame);
+        presentFence->signalForTest(std::chrono::nanoseconds(presentTime).count());
+        mFrameTimeline->setSfPresent(std::chrono::nanoseconds(presentTime).count(), presentFence);
+    }
+
+    // Only the presents at 200ms and 400ms are within the last 2 display frames.
+    EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdOne}), 5.0f);
+}
+
 TEST_F(FrameTimelineTest, getMinTime) {
     // Use SurfaceFrame::getBaseTime to test the getMinTime.
     FrameTimelineInfo ftInfo;
@@ -271,5 +271,51 @@ TEST_F(HWComposerLayerGenericMetadataTest, forwardsSupportedMetadata) {
     EXPECT_EQ(hal::Error::UNSUPPORTED, result);
 }
 
+struct HWComposerLayerStateCacheTest : public HWComposerLayerTest {
+    HWComposerLayerStateCacheTest() : HWComposerLayerTest({}) {}
+};
+
+TEST_F(HWComposerLayerStateCacheTest, suppressesUnchangedState) {
+    const Rect frame(0, 0, 100, 200);
+    EXPECT_CALL(*mHal, setLayerDisplayFrame(kDisplayId, kLayerId, _))
+            .WillOnce(Return(V2_1::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 3u))
+            .WillOnce(Return(V2_1::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(3u));
+
+    auto stats = mLayer.takeCommandStats();
+    EXPECT_EQ(2u, stats.sent);
+    EXPECT_EQ(0u, stats.suppressed);
+
+    EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(3u));
+
+    stats = mLayer.takeCommandStats();
+    EXPECT_EQ(0u, stats.sent);
+    EXPECT_EQ(2u, stats.suppressed);
+
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 4u))
+            .WillOnce(Return(V2_1::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(4u));
+
+    stats = mLayer.takeCommandStats();
+    EXPECT_EQ(1u, stats.sent);
+    EXPECT_EQ(0u, stats.suppressed);
+}
+
+TEST_F(HWComposerLayerStateCacheTest, resendsStateAfterError) {
+    EXPECT_CALL(*mHal, setLayerPlaneAlpha(kDisplayId, kLayerId, 0.5f))
+            .WillOnce(Return(V2_1::Error::BAD_LAYER))
+            .WillOnce(Return(V2_1::Error::NONE));
+    EXPECT_EQ(hal::Error::BAD_LAYER, mLayer.setPlaneAlpha(0.5f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+
+    const auto stats = mLayer.takeCommandStats();
+    EXPECT_EQ(2u, stats.sent);
+    EXPECT_EQ(1u, stats.suppressed);
+}
+
 } // namespace
 } // namespace android
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "HdrLayerInfoReporterTest"
+
+#include <chrono>
+#include <limits>
+
+#include <android/gui/BnHdrLayerInfoListener.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "HdrLayerInfoReporter.h"
+#include "fake/FakeClock.h"
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+using HdrLayer = HdrLayerInfoReporter::HdrLayer;
+using HdrLayerInfo = HdrLayerInfoReporter::HdrLayerInfo;
+
+struct TestableHdrLayerInfoListener : public gui::BnHdrLayerInfoListener {
+    int calls = 0;
+    HdrLayerInfo lastInfo;
+
+    binder::Status onHdrLayerInfoChanged(int32_t numberOfHdrLayers, int32_t maxW, int32_t maxH,
+                                         int32_t flags, float maxDesiredHdrSdrRatio) override {
+        calls++;
+        lastInfo = {.numberOfHdrLayers = numberOfHdrLayers,
+                    .maxW = maxW,
+                    .maxH = maxH,
+                    .flags = flags,
+                    .maxDesiredHdrSdrRatio = maxDesiredHdrSdrRatio};
+        return binder::Status::ok();
+    }
+};
+
+class HdrLayerInfoReporterTest : public testing::Test {
+protected:
+    HdrLayerInfo dispatch() { return dispatch(mReporter->getHdrLayerInfo()); }
+
+    HdrLayerInfo dispatch(const HdrLayerInfo& info) {
+        mPendingDelay = mReporter->dispatchHdrLayerInfo(info);
+        return info;
+    }
+
+    fake::FakeClock* mClock = new fake::FakeClock();
+    sp<HdrLayerInfoReporter> mReporter =
+            sp<HdrLayerInfoReporter>::make(std::unique_ptr<Clock>(mClock));
+    sp<TestableHdrLayerInfoListener> mListener = sp<TestableHdrLayerInfoListener>::make();
+    std::optional<std::chrono::nanoseconds> mPendingDelay;
+};
+
+TEST_F(HdrLayerInfoReporterTest, computesInfoFromHdrLayers) {
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100, .desiredHdrSdrRatio = 2.f});
+    mReporter->setHdrLayer(2, {.width = 300, .height = 200, .desiredHdrSdrRatio = 4.f});
+    mReporter->setHdrLayer(3, {.width = 50, .height = 50, .desiredHdrSdrRatio = 3.f});
+
+    HdrLayerInfo info = mReporter->getHdrLayerInfo();
+    EXPECT_EQ(3, info.numberOfHdrLayers);
+    EXPECT_EQ(300, info.maxW);
+    EXPECT_EQ(200, info.maxH);
+    EXPECT_EQ(4.f, info.maxDesiredHdrSdrRatio);
+
+    // Only the changed layers are updated.
+    mReporter->removeHdrLayer(2);
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100,
+                               .desiredHdrSdrRatio = std::numeric_limits<float>::infinity()});
+    info = mReporter->getHdrLayerInfo();
+    EXPECT_EQ(2, info.numberOfHdrLayers);
+    EXPECT_EQ(100, info.maxW);
+    EXPECT_EQ(100, info.maxH);
+    EXPECT_EQ(std::numeric_limits<float>::infinity(), info.maxDesiredHdrSdrRatio);
+
+    mReporter->clearHdrLayers();
+    EXPECT_EQ(HdrLayerInfo{}, mReporter->getHdrLayerInfo());
+}
+
+TEST_F(HdrLayerInfoReporterTest, dispatchesChangesOnly) {
+    mReporter->addListener(mListener);
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100, .desiredHdrSdrRatio = 2.f});
+
+    const HdrLayerInfo info = dispatch();
+    EXPECT_EQ(1, mListener->calls);
+    EXPECT_EQ(info, mListener->lastInfo);
+    EXPECT_FALSE(mPendingDelay);
+
+    dispatch();
+    EXPECT_EQ(1, mListener->calls);
+}
+
+TEST_F(HdrLayerInfoReporterTest, holdsBackUpdatesWithinMinUpdateInterval) {
+    mReporter->addListener(mListener, {.minUpdateInterval = 100ms});
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+    EXPECT_EQ(1, mListener->calls);
+
+    mClock->advanceTime(10ms);
+    mReporter->setHdrLayer(1, {.width = 200, .height = 100, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+    EXPECT_EQ(1, mListener->calls);
+    EXPECT_EQ(90ms, mPendingDelay);
+
+    // A later update is coalesced with the one held back, and its dispatch is already due.
+    mClock->advanceTime(10ms);
+    mReporter->setHdrLayer(1, {.width = 300, .height = 100, .desiredHdrSdrRatio = 2.f});
+    const HdrLayerInfo info = dispatch();
+    EXPECT_EQ(1, mListener->calls);
+    EXPECT_FALSE(mPendingDelay);
+
+    mClock->advanceTime(80ms);
+    EXPECT_FALSE(mReporter->dispatchPendingHdrLayerInfo());
+    EXPECT_EQ(2, mListener->calls);
+    EXPECT_EQ(info, mListener->lastInfo);
+}
+
+TEST_F(HdrLayerInfoReporterTest, dispatchesHdrLayersAppearingRightAway) {
+    mReporter->addListener(mListener, {.minUpdateInterval = 100ms});
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+
+    mClock->advanceTime(10ms);
+    mReporter->removeHdrLayer(1);
+    dispatch();
+    EXPECT_EQ(2, mListener->calls);
+    EXPECT_EQ(0, mListener->lastInfo.numberOfHdrLayers);
+    EXPECT_FALSE(mPendingDelay);
+}
+
+TEST_F(HdrLayerInfoReporterTest, dropsChangesWithinHysteresis) {
+    mReporter->addListener(mListener, {.hysteresis = 0.1f});
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+    EXPECT_EQ(1, mListener->calls);
+
+    mReporter->setHdrLayer(1, {.width = 105, .height = 100, .desiredHdrSdrRatio = 2.1f});
+    dispatch();
+    EXPECT_EQ(1, mListener->calls);
+
+    // The changes add up from the last dispatched info.
+    mReporter->setHdrLayer(1, {.width = 115, .height = 100, .desiredHdrSdrRatio = 2.1f});
+    const HdrLayerInfo info = dispatch();
+    EXPECT_EQ(2, mListener->calls);
+    EXPECT_EQ(info, mListener->lastInfo);
+
+    mReporter->setHdrLayer(2, {.width = 10, .height = 10, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+    EXPECT_EQ(3, mListener->calls);
+    EXPECT_EQ(2, mListener->lastInfo.numberOfHdrLayers);
+}
+
+TEST_F(HdrLayerInfoReporterTest, appliesOptionsPerListener) {
+    const auto throttled = sp<TestableHdrLayerInfoListener>::make();
+    mReporter->addListener(mListener);
+    mReporter->addListener(throttled, {.minUpdateInterval = 100ms});
+    mReporter->setHdrLayer(1, {.width = 100, .height = 100, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+
+    mClock->advanceTime(10ms);
+    mReporter->setHdrLayer(1, {.width = 200, .height = 100, .desiredHdrSdrRatio = 2.f});
+    dispatch();
+    EXPECT_EQ(2, mListener->calls);
+    EXPECT_EQ(1, throttled->calls);
+    EXPECT_EQ(90ms, mPendingDelay);
+}
+
+} // namespace
+} // namespace android
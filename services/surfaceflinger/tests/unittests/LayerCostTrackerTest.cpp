@@ -0,0 +1,136 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LibSurfaceFlingerUnittests"
+
+#include <gtest/gtest.h>
+
+#include "LayerCostTracker.h"
+
+namespace android {
+namespace {
+
+using Key = LayerCostTracker::Key;
+using OutputComposition = LayerCostTracker::OutputComposition;
+
+constexpr Key kLayerA{Key::Type::Layer, 1};
+constexpr Key kLayerB{Key::Type::Layer, 2};
+constexpr Key kCachedSet{Key::Type::CachedSet, 0x1234};
+
+class LayerCostTrackerTest : public testing::Test {
+protected:
+    std::vector<OutputComposition> makeOutputs(OutputComposition&& output) {
+        std::vector<OutputComposition> outputs;
+        outputs.push_back(std::move(output));
+        return outputs;
+    }
+
+    LayerCostTracker mTracker{/*enabled=*/true};
+    FenceToFenceTimeMap mFenceFactory;
+};
+
+TEST_F(LayerCostTrackerTest, attributesCpuAndHwcCosts) {
+    mTracker.recordFrame(1, 100,
+                         makeOutputs({.layers = {{.key = kLayerA, .name = "A", .cpu = 30},
+                                                 {.key = kLayerB, .name = "B", .cpu = 10}},
+                                      .hwcValidateDuration = 60,
+                                      .hwcPresentDuration = 40}));
+
+    const auto costs = mTracker.getCosts();
+    ASSERT_EQ(2u, costs.size());
+    EXPECT_EQ(30, costs.at(kLayerA).cpu);
+    EXPECT_EQ(50, costs.at(kLayerA).hwc);
+    EXPECT_EQ(0, costs.at(kLayerA).gpu);
+    EXPECT_EQ(10, costs.at(kLayerB).cpu);
+    EXPECT_EQ(50, costs.at(kLayerB).hwc);
+}
+
+TEST_F(LayerCostTrackerTest, splitsGpuCostByAreaOnceFenceSignals) {
+    const auto fence = mFenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    mTracker.recordFrame(1, 100,
+                         makeOutputs({.layers = {{.key = kLayerA,
+                                                  .name = "A",
+                                                  .clientComposed = true,
+                                                  .area = 300},
+                                                 {.key = kLayerB,
+                                                  .name = "B",
+                                                  .clientComposed = true,
+                                                  .area = 100}},
+                                      .renderEngineFence = fence,
+                                      .renderEngineStartTime = 1000}));
+
+    // The frame is left out until its GPU cost is known.
+    EXPECT_TRUE(mTracker.getCosts().empty());
+
+    mFenceFactory.signalAllForTest(Fence::NO_FENCE, 1400);
+    const auto costs = mTracker.getCosts();
+    ASSERT_EQ(2u, costs.size());
+    EXPECT_EQ(300, costs.at(kLayerA).gpu);
+    EXPECT_EQ(100, costs.at(kLayerB).gpu);
+}
+
+TEST_F(LayerCostTrackerTest, layersOfCachedSetShareOneCost) {
+    mTracker.recordFrame(1, 100,
+                         makeOutputs({.layers = {{.key = kCachedSet, .cpu = 5},
+                                                 {.key = kCachedSet, .cpu = 7},
+                                                 {.key = kLayerA, .name = "A", .cpu = 1}},
+                                      .hwcPresentDuration = 20}));
+
+    const auto costs = mTracker.getCosts();
+    ASSERT_EQ(2u, costs.size());
+    EXPECT_EQ(12, costs.at(kCachedSet).cpu);
+    EXPECT_EQ(10, costs.at(kCachedSet).hwc);
+    EXPECT_EQ(10, costs.at(kLayerA).hwc);
+
+    std::string dump;
+    mTracker.dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("CachedSet 0x1234"));
+    EXPECT_NE(std::string::npos, dump.find("A#1"));
+}
+
+TEST_F(LayerCostTrackerTest, keepsLastFrames) {
+    for (size_t i = 0; i < LayerCostTracker::kMaxFrames + 10; i++) {
+        mTracker.recordFrame(static_cast<int64_t>(i), static_cast<nsecs_t>(i),
+                             makeOutputs({.layers = {{.key = kLayerA, .name = "A", .cpu = 1}}}));
+    }
+    EXPECT_EQ(static_cast<nsecs_t>(LayerCostTracker::kMaxFrames),
+              mTracker.getCosts().at(kLayerA).cpu);
+}
+
+TEST_F(LayerCostTrackerTest, parsesArgs) {
+    LayerCostTracker tracker(/*enabled=*/false);
+    EXPECT_FALSE(tracker.isEnabled());
+
+    std::string result;
+    Vector<String16> args;
+    args.add(String16("-enable"));
+    tracker.parseArgs(args, result);
+    EXPECT_TRUE(tracker.isEnabled());
+
+    tracker.recordFrame(1, 100, makeOutputs({.layers = {{.key = kLayerA, .name = "A"}}}));
+    EXPECT_FALSE(tracker.getCosts().empty());
+
+    args.clear();
+    args.add(String16("-clear"));
+    args.add(String16("-disable"));
+    tracker.parseArgs(args, result);
+    EXPECT_FALSE(tracker.isEnabled());
+    EXPECT_TRUE(tracker.getCosts().empty());
+}
+
+} // namespace
+} // namespace android
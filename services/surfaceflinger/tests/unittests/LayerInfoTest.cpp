@@ -32,9 +32,16 @@ protected:
     using FrameTimeData = LayerInfo::FrameTimeData;
 
     void setFrameTimes(const std::deque<FrameTimeData>& frameTimes) {
-        layerInfo.mFrameTimes = frameTimes;
+        layerInfo.clearFrameTimes();
+        for (const auto& frameTime : frameTimes) {
+            layerInfo.addFrameTime(frameTime);
+        }
     }
 
+    void addFrameTime(const FrameTimeData& frameTime) { layerInfo.addFrameTime(frameTime); }
+
+    const std::deque<FrameTimeData>& frameTimes() const { return layerInfo.mFrameTimes; }
+
     void setLastRefreshRate(Fps fps) {
         layerInfo.mLastRefreshRate.reported = fps;
         layerInfo.mLastRefreshRate.calculated = fps;
@@ -171,5 +178,26 @@ TEST_F(LayerInfoTest, ignoresLargePeriods) {
     ASSERT_EQ(kExpectedFps, Fps::fromPeriodNsecs(*averageFrameTime));
 }
 
+// The deltas are summed as frames are added and dropped, so they have to match those of the frames
+// left in the history, including when the dropped frame was a duplicate.
+TEST_F(LayerInfoTest, averageFrameTimeTracksDroppedFrames) {
+    constexpr auto kPeriod = (60_Hz).getPeriodNsecs();
+    constexpr auto kSmallPeriod = (250_Hz).getPeriodNsecs();
+    constexpr auto kLargePeriod = (9_Hz).getPeriodNsecs();
+
+    nsecs_t time = kPeriod;
+    for (int i = 0; i < 500; i++) {
+        time += i % 7 == 0 ? kSmallPeriod : i % 31 == 0 ? kLargePeriod : kPeriod + i % 3 * 100'000;
+        addFrameTime(FrameTimeData{.presentTime = time,
+                                   .queueTime = time,
+                                   .pendingModeChange = false});
+
+        const auto averageFrameTime = calculateAverageFrameTime();
+        const auto history = frameTimes();
+        setFrameTimes(history);
+        ASSERT_EQ(calculateAverageFrameTime(), averageFrameTime) << "after frame " << i;
+    }
+}
+
 } // namespace
 } // namespace android::scheduler
@@ -81,7 +81,8 @@ protected:
                                         .globalShadowSettings = globalShadowSettings,
                                         .supportsBlur = true,
                                         .supportedLayerGenericMetadata = {},
-                                        .genericLayerMetadataKeyMap = {}};
+                                        .genericLayerMetadataKeyMap = {},
+                                        .parallelSubtrees = mParallelSubtrees};
         actualBuilder.update(args);
 
         // rebuild layer snapshots from scratch and verify that it matches the updated state.
@@ -107,6 +108,7 @@ protected:
     LayerSnapshotBuilder mSnapshotBuilder;
     display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> mFrontEndDisplayInfos;
     renderengine::ShadowSettings globalShadowSettings;
+    bool mParallelSubtrees = false;
     static const std::vector<uint32_t> STARTING_ZORDER;
 };
 const std::vector<uint32_t> LayerSnapshotTest::STARTING_ZORDER = {1,   11,   111, 12, 121,
@@ -462,4 +464,63 @@ TEST_F(LayerSnapshotTest, cleanUpUnreachableSnapshotsAfterLayerDestruction) {
     EXPECT_LE(startingNumSnapshots - 2, mSnapshotBuilder.getSnapshots().size());
 }
 
+TEST_F(LayerSnapshotTest, hotFieldsMatchSnapshots) {
+    setAlpha(12, 0.5);
+    hideLayer(13);
+    setLayerStack(2, 7);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 2});
+
+    const auto& hotFields = mSnapshotBuilder.getHotFields();
+    const auto& snapshots = mSnapshotBuilder.getSnapshots();
+    ASSERT_EQ(hotFields.size(), snapshots.size());
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        SCOPED_TRACE(snapshots[i]->getDebugString());
+        EXPECT_EQ(hotFields.sequence[i], static_cast<uint32_t>(snapshots[i]->sequence));
+        EXPECT_EQ(hotFields.alpha[i], snapshots[i]->alpha);
+        EXPECT_EQ(hotFields.isVisible[i] != 0, snapshots[i]->isVisible);
+        EXPECT_EQ(hotFields.hasInputInfo[i] != 0, snapshots[i]->hasInputInfo());
+        EXPECT_EQ(hotFields.layerStack[i], snapshots[i]->outputFilter.layerStack);
+    }
+
+    std::vector<uint32_t> visibleIds;
+    mSnapshotBuilder.forEachVisibleSnapshot(ui::LayerStack::fromValue(7),
+                                            [&](std::unique_ptr<LayerSnapshot>& snapshot) {
+                                                visibleIds.push_back(snapshot->path.id);
+                                            });
+    EXPECT_EQ(visibleIds, std::vector<uint32_t>{2});
+}
+
+TEST_F(LayerSnapshotTest, parallelUpdateMatchesSerialUpdate) {
+    mParallelSubtrees = true;
+    setAlpha(1, 0.5);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    EXPECT_EQ(getSnapshot(1221)->alpha, 0.5f);
+
+    hideLayer(2);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 13});
+    showLayer(2);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+}
+
+TEST_F(LayerSnapshotTest, parallelUpdateSkipsUnchangedSubtrees) {
+    mParallelSubtrees = true;
+    setAlpha(2, 0.5);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    EXPECT_EQ(getSnapshot(2)->alpha, 0.5f);
+
+    std::string dump;
+    mSnapshotBuilder.dumpSubtreeTimings(dump);
+    EXPECT_THAT(dump, testing::HasSubstr("[1]"));
+    EXPECT_THAT(dump, testing::HasSubstr("skipped"));
+}
+
+TEST_F(LayerSnapshotTest, parallelUpdateFallsBackWithRelativeLayersAcrossSubtrees) {
+    mParallelSubtrees = true;
+    reparentRelativeLayer(11, 2);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 12, 121, 122, 1221, 13, 2, 11, 111});
+    setAlpha(2, 0.5);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 12, 121, 122, 1221, 13, 2, 11, 111});
+    EXPECT_EQ(getSnapshot(11)->alpha, 1.f);
+}
+
 } // namespace android::surfaceflinger::frontend
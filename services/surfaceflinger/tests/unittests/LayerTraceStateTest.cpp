@@ -0,0 +1,142 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "FrontEnd/LayerHierarchy.h"
+#include "FrontEnd/LayerLifecycleManager.h"
+#include "FrontEnd/LayerSnapshotBuilder.h"
+#include "LayerHierarchyTest.h"
+#include "LayerProtoHelper.h"
+#include "Tracing/LayerTraceState.h"
+#include "Tracing/LayerTracing.h"
+
+namespace android::surfaceflinger::frontend {
+
+class LayerTraceStateTest : public LayerHierarchyTestBase {
+protected:
+    static constexpr uint32_t kTraceFlags = LayerTracing::TRACE_INPUT;
+
+    // Updates the snapshots and records the delta of the update, the way SurfaceFlinger does.
+    LayerTraceDelta updateAndRecord(bool fullState = false) {
+        const bool hierarchyChanged =
+                mLifecycleManager.getGlobalChanges().test(RequestedLayerState::Changes::Hierarchy);
+        if (hierarchyChanged) {
+            mHierarchyBuilder.update(mLifecycleManager.getLayers(),
+                                     mLifecycleManager.getDestroyedLayers());
+        }
+        LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                        .layerLifecycleManager = mLifecycleManager,
+                                        .includeMetadata = false,
+                                        .displays = mFrontEndDisplayInfos,
+                                        .displayChanges = false,
+                                        .globalShadowSettings = globalShadowSettings,
+                                        .supportsBlur = true,
+                                        .supportedLayerGenericMetadata = {},
+                                        .genericLayerMetadataKeyMap = {}};
+        mSnapshotBuilder.update(args);
+        mLifecycleManager.commitChanges();
+        return LayerTraceDelta::record(mHierarchyBuilder.getHierarchy(), mSnapshotBuilder,
+                                       mLifecycleManager, hierarchyChanged, fullState);
+    }
+
+    // Verifies that the state rebuilt from the deltas traces the same layers as the live state.
+    void traceAndVerify(bool fullState = false) {
+        ASSERT_TRUE(mTraceState.apply(updateAndRecord(fullState)));
+        const LayersProto expected =
+                LayerProtoFromSnapshotGenerator(mSnapshotBuilder, mFrontEndDisplayInfos,
+                                                mLegacyLayers, kTraceFlags)
+                        .generate(mHierarchyBuilder.getHierarchy());
+        const LayersProto actual = mTraceState.generate(kTraceFlags, {});
+        EXPECT_EQ(expected.layers_size(), actual.layers_size());
+        EXPECT_EQ(expected.SerializeAsString(), actual.SerializeAsString());
+    }
+
+    LayerHierarchyBuilder mHierarchyBuilder{{}};
+    LayerSnapshotBuilder mSnapshotBuilder;
+    display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> mFrontEndDisplayInfos;
+    renderengine::ShadowSettings globalShadowSettings;
+    std::unordered_map<uint32_t, sp<Layer>> mLegacyLayers;
+    LayerTraceState mTraceState;
+};
+
+TEST_F(LayerTraceStateTest, tracesSameLayersAsLiveState) {
+    traceAndVerify(/*fullState=*/true);
+
+    setColor(11, {1._hf, 0._hf, 0._hf});
+    traceAndVerify();
+
+    setAlpha(12, 0.5f);
+    setCrop(121, Rect(0, 0, 10, 10));
+    traceAndVerify();
+
+    reparentLayer(122, 2);
+    traceAndVerify();
+
+    reparentRelativeLayer(13, 2);
+    setZ(13, 5);
+    traceAndVerify();
+
+    reparentLayer(111, UNASSIGNED_LAYER_ID);
+    destroyLayerHandle(111);
+    traceAndVerify();
+
+    // Frames without changes keep the state.
+    traceAndVerify();
+}
+
+TEST_F(LayerTraceStateTest, recordsOnlyChangedSnapshots) {
+    traceAndVerify(/*fullState=*/true);
+
+    setColor(1221, {0._hf, 1._hf, 0._hf});
+    const LayerTraceDelta delta = updateAndRecord();
+    ASSERT_EQ(1u, delta.snapshots.size());
+    EXPECT_EQ(1221u, delta.snapshots[0]->path.id);
+    ASSERT_EQ(1u, delta.requestedStates.size());
+    EXPECT_EQ(1221u, delta.requestedStates[0]->id);
+    EXPECT_FALSE(delta.hierarchy);
+}
+
+TEST_F(LayerTraceStateTest, dropsDeltasUntilFullState) {
+    setColor(11);
+    EXPECT_FALSE(mTraceState.apply(updateAndRecord()));
+    EXPECT_EQ(0, mTraceState.generate(kTraceFlags, {}).layers_size());
+
+    traceAndVerify(/*fullState=*/true);
+}
+
+TEST_F(LayerTraceStateTest, parallelGeneratorWritesSameLayers) {
+    createRootLayer(3);
+    createLayer(31, 3);
+    reparentRelativeLayer(13, 2);
+    reparentRelativeLayer(31, 11);
+    updateAndRecord(/*fullState=*/true);
+
+    WorkerPool workerPool(/*numThreads=*/2);
+    const LayersProto serial = LayerProtoFromSnapshotGenerator(mSnapshotBuilder,
+                                                               mFrontEndDisplayInfos,
+                                                               mLegacyLayers, kTraceFlags)
+                                       .generate(mHierarchyBuilder.getHierarchy());
+    const LayersProto parallel =
+            LayerProtoFromSnapshotGenerator(mSnapshotBuilder, mFrontEndDisplayInfos,
+                                            mLegacyLayers, kTraceFlags, &workerPool)
+                    .generate(mHierarchyBuilder.getHierarchy());
+    EXPECT_EQ(11, parallel.layers_size());
+    EXPECT_EQ(serial.SerializeAsString(), parallel.SerializeAsString());
+}
+
+} // namespace android::surfaceflinger::frontend
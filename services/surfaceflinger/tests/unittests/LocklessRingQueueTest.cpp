@@ -0,0 +1,122 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LocklessRingQueue.h"
+
+namespace android {
+namespace {
+
+TEST(LocklessRingQueueTest, startsEmpty) {
+    LocklessRingQueue<int, 4> queue;
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(LocklessRingQueueTest, popsInPushOrderAcrossLaps) {
+    LocklessRingQueue<int, 4> queue;
+    int next = 0;
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 3; i++) {
+            queue.push(lap * 3 + i);
+        }
+        while (auto value = queue.pop()) {
+            EXPECT_EQ(next++, *value);
+        }
+    }
+    EXPECT_EQ(9, next);
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(0u, queue.getOverflowPushCount());
+}
+
+TEST(LocklessRingQueueTest, overflowKeepsOrder) {
+    LocklessRingQueue<int, 4> queue;
+    for (int i = 0; i < 10; i++) {
+        queue.push(int(i));
+    }
+    EXPECT_EQ(6u, queue.getOverflowPushCount());
+
+    // Still overflowing: this push must not jump ahead of the earlier overflowed entries.
+    EXPECT_EQ(0, *queue.pop());
+    queue.push(10);
+
+    for (int i = 1; i <= 10; i++) {
+        auto value = queue.pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(i, *value);
+    }
+    EXPECT_TRUE(queue.isEmpty());
+
+    // Once drained, pushes go back to the ring.
+    queue.push(11);
+    EXPECT_EQ(7u, queue.getOverflowPushCount());
+    EXPECT_EQ(11, *queue.pop());
+}
+
+TEST(LocklessRingQueueTest, movesValues) {
+    LocklessRingQueue<std::unique_ptr<std::string>, 2> queue;
+    for (int i = 0; i < 4; i++) {
+        queue.push(std::make_unique<std::string>(std::to_string(i)));
+    }
+    for (int i = 0; i < 4; i++) {
+        auto value = queue.pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(std::to_string(i), **value);
+    }
+}
+
+TEST(LocklessRingQueueTest, multipleProducersKeepPerProducerOrder) {
+    constexpr int kProducers = 8;
+    constexpr int kPushesPerProducer = 5000;
+    LocklessRingQueue<std::pair<int, int>, 16> queue;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kPushesPerProducer; i++) {
+                queue.push({p, i});
+            }
+        });
+    }
+
+    std::vector<int> expected(kProducers, 0);
+    int received = 0;
+    while (received < kProducers * kPushesPerProducer) {
+        auto value = queue.pop();
+        if (!value) {
+            std::this_thread::yield();
+            continue;
+        }
+        auto [producer, sequence] = *value;
+        ASSERT_EQ(expected[producer], sequence) << "producer " << producer;
+        expected[producer]++;
+        received++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+} // namespace
+} // namespace android
@@ -218,5 +218,54 @@ TEST_F(PowerAdvisorTest, hintSessionUsingSecondaryVirtualDisplays) {
     mPowerAdvisor->reportActualWorkDuration();
 }
 
+TEST_F(PowerAdvisorTest, hintSessionPredictsHeavyClientCompositionFrames) {
+    mPowerAdvisor->mUsePredictedWorkDuration = true;
+    mPowerAdvisor->onBootFinished();
+    startPowerHintSession();
+
+    std::vector<DisplayId> displayIds{PhysicalDisplayId::fromPort(42u)};
+
+    // 60hz
+    const Duration vsyncPeriod{std::chrono::nanoseconds(1s) / 60};
+    const Duration clientCompositionDuration = 20ms;
+    const Duration deviceCompositionDuration = 5ms;
+
+    TimePoint startTime{100ns};
+    const auto fakeFrame = [&](bool usesClientComposition, Duration presentDuration) {
+        fakeBasicFrameTiming(startTime, vsyncPeriod);
+        setExpectedTiming(vsyncPeriod, startTime + vsyncPeriod);
+        mPowerAdvisor->setDisplays(displayIds);
+        mPowerAdvisor->setExpectedClientComposition(displayIds[0], usesClientComposition);
+        mPowerAdvisor->setRequiresClientComposition(displayIds[0], usesClientComposition);
+        mPowerAdvisor->setHwcValidateTiming(displayIds[0], startTime + 1ms, startTime + 1500us);
+        mPowerAdvisor->setHwcPresentTiming(displayIds[0], startTime + 2ms, startTime + 2500us);
+        mPowerAdvisor->setSfPresentTiming(startTime, startTime + presentDuration);
+        mPowerAdvisor->reportActualWorkDuration();
+        startTime += vsyncPeriod;
+    };
+
+    // Learn the duration of both kinds of frames, which are only hinted once they are known,
+    // and not when the previous frame already went over the target.
+    EXPECT_CALL(*mMockPowerHintSession, sendHint(SessionHint::CPU_LOAD_UP)).Times(0);
+    fakeFrame(true, clientCompositionDuration);
+    fakeFrame(true, clientCompositionDuration);
+    fakeFrame(true, clientCompositionDuration);
+    fakeFrame(false, deviceCompositionDuration);
+    fakeFrame(false, deviceCompositionDuration);
+    Mock::VerifyAndClearExpectations(mMockPowerHintSession.get());
+
+    // A client composition frame after a light one is expected to go over the target.
+    EXPECT_CALL(*mMockPowerHintSession, sendHint(SessionHint::CPU_LOAD_UP)).Times(1);
+    fakeBasicFrameTiming(startTime, vsyncPeriod);
+    mPowerAdvisor->setExpectedClientComposition(displayIds[0], true);
+    // Only once per frame.
+    mPowerAdvisor->setExpectedClientComposition(displayIds[0], true);
+    Mock::VerifyAndClearExpectations(mMockPowerHintSession.get());
+
+    std::string result;
+    mPowerAdvisor->dump(result);
+    EXPECT_NE(std::string::npos, result.find("CPU_LOAD_UP hints 1"));
+}
+
 } // namespace
 } // namespace android::Hwc2::impl
@@ -132,6 +132,25 @@ struct TestableRefreshRateSelector : RefreshRateSelector {
     }
 
     const auto& getPrimaryFrameRates() const { return mPrimaryFrameRates; }
+
+    size_t getAppRequestFrameRateCount() const {
+        std::lock_guard lock(mLock);
+        return mAppRequestFrameRates.size();
+    }
+
+    // Scores the layer for the app request frame rate at `frameRateIndex`, either as ranking does,
+    // or without the layer score table.
+    float calculateLayerScore(const LayerRequirement& layer, size_t frameRateIndex,
+                              bool isSeamlessSwitch, bool useTable) const {
+        std::lock_guard lock(mLock);
+        if (useTable) {
+            return calculateLayerScoreLocked(layer,
+                                             findKnownFrameRateIndex(layer.desiredRefreshRate),
+                                             frameRateIndex, isSeamlessSwitch);
+        }
+        return calculateLayerScoreLocked(layer, mAppRequestFrameRates[frameRateIndex].fps,
+                                         isSeamlessSwitch);
+    }
 };
 
 class RefreshRateSelectorTest : public testing::TestWithParam<Config::FrameRateOverride> {
@@ -2265,6 +2284,32 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExact) {
     EXPECT_FRAME_RATE_MODE(kMode120, 120_Hz, selector.getBestScoredFrameRate(layers).frameRateMode);
 }
 
+TEST_P(RefreshRateSelectorTest, layerScoreTableMatchesCalculatedScores) {
+    auto selector = createSelector(kModes_24_25_30_50_60_Frac, kModeId60);
+
+    // Known frame rates are looked up in the table, and the others calculated.
+    auto desiredRefreshRates = selector.knownFrameRates();
+    desiredRefreshRates.push_back(33_Hz);
+
+    for (const Fps desiredRefreshRate : desiredRefreshRates) {
+        for (const auto vote : {LayerVoteType::Heuristic, LayerVoteType::ExplicitDefault,
+                                LayerVoteType::ExplicitExactOrMultiple,
+                                LayerVoteType::ExplicitExact, LayerVoteType::Max}) {
+            const LayerRequirement layer = {.vote = vote,
+                                            .desiredRefreshRate = desiredRefreshRate,
+                                            .weight = 1.f};
+            for (size_t i = 0; i < selector.getAppRequestFrameRateCount(); i++) {
+                for (const bool isSeamlessSwitch : {true, false}) {
+                    EXPECT_EQ(selector.calculateLayerScore(layer, i, isSeamlessSwitch, false),
+                              selector.calculateLayerScore(layer, i, isSeamlessSwitch, true))
+                            << ftl::enum_string(vote) << " " << to_string(desiredRefreshRate)
+                            << " for frame rate " << i;
+                }
+            }
+        }
+    }
+}
+
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ReadsCache) {
     auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
 
@@ -2276,7 +2321,7 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ReadsCache) {
                                                                   {90_Hz, kMode90}}},
                                                           GlobalSignals{.touch = true}};
 
-    selector.mutableGetRankedRefreshRatesCache() = {args, result};
+    selector.mutableGetRankedRefreshRatesCache().put(args.first, args.second, result);
 
     EXPECT_EQ(result, selector.getRankedFrameRates(args.first, args.second));
 }
@@ -2284,18 +2329,63 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ReadsCache) {
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
 
-    EXPECT_FALSE(selector.mutableGetRankedRefreshRatesCache());
+    EXPECT_EQ(0u, selector.mutableGetRankedRefreshRatesCache().size());
 
     std::vector<LayerRequirement> layers = {{.weight = 1.f}, {.weight = 0.5f}};
     RefreshRateSelector::GlobalSignals globalSignals{.touch = true, .idle = true};
 
     const auto result = selector.getRankedFrameRates(layers, globalSignals);
 
-    const auto& cache = selector.mutableGetRankedRefreshRatesCache();
-    ASSERT_TRUE(cache);
+    auto& cache = selector.mutableGetRankedRefreshRatesCache();
+    ASSERT_EQ(1u, cache.size());
+
+    const auto* cachedResult = cache.get(layers, globalSignals);
+    ASSERT_TRUE(cachedResult);
+    EXPECT_EQ(*cachedResult, result);
+}
+
+TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_CachesDistinctArguments) {
+    using Cache = TestableRefreshRateSelector::GetRankedFrameRatesCache;
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    const auto layersWithWeight = [](size_t i) {
+        return std::vector<LayerRequirement>{{.vote = LayerVoteType::Heuristic,
+                                              .desiredRefreshRate = 60_Hz,
+                                              .weight = 1.f / static_cast<float>(i + 1)}};
+    };
+
+    for (size_t i = 0; i < Cache::kCapacity; i++) {
+        selector.getRankedFrameRates(layersWithWeight(i), {});
+    }
+    EXPECT_EQ(0u, selector.getRankedFrameRatesCacheStats().hits);
+    EXPECT_EQ(Cache::kCapacity, selector.getRankedFrameRatesCacheStats().misses);
+
+    // Every distinct argument is still cached, and the touch signal makes for a distinct one.
+    for (size_t i = 0; i < Cache::kCapacity; i++) {
+        selector.getRankedFrameRates(layersWithWeight(i), {});
+    }
+    EXPECT_EQ(Cache::kCapacity, selector.getRankedFrameRatesCacheStats().hits);
+    selector.getRankedFrameRates(layersWithWeight(0), {.touch = true});
+    EXPECT_EQ(Cache::kCapacity + 1, selector.getRankedFrameRatesCacheStats().misses);
+
+    // The touch boosted arguments evicted the least recently used ones.
+    auto& cache = selector.mutableGetRankedRefreshRatesCache();
+    EXPECT_EQ(Cache::kCapacity, cache.size());
+    EXPECT_FALSE(cache.get(layersWithWeight(0), {}));
+    EXPECT_TRUE(cache.get(layersWithWeight(1), {}));
+}
+
+TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_PolicyChangeClearsCache) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    const std::vector<LayerRequirement> layers = {{.vote = LayerVoteType::Max, .weight = 1.f}};
+    EXPECT_EQ(kMode120, selector.getBestFrameRateMode(layers));
+    EXPECT_EQ(1u, selector.mutableGetRankedRefreshRatesCache().size());
 
-    EXPECT_EQ(cache->arguments, std::make_pair(layers, globalSignals));
-    EXPECT_EQ(cache->result, result);
+    EXPECT_EQ(SetPolicyResult::Changed,
+              selector.setDisplayManagerPolicy({kModeId60, {60_Hz, 60_Hz}}));
+    EXPECT_EQ(0u, selector.mutableGetRankedRefreshRatesCache().size());
+    EXPECT_EQ(kMode60, selector.getBestFrameRateMode(layers));
 }
 
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExactTouchBoost) {
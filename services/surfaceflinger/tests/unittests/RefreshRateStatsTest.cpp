@@ -183,5 +183,29 @@ TEST_F(RefreshRateStatsTest, twoModes) {
     EXPECT_EQ(sixty, times.get("60.00 Hz")->get());
 }
 
+TEST_F(RefreshRateStatsTest, modeSwitchLatencies) {
+    resetStats(60_Hz);
+
+    EXPECT_CALL(mTimeStats, recordRefreshRate(_, _)).Times(AtLeast(0));
+
+    using Histogram = RefreshRateStats::ModeSwitchLatencyHistogram;
+    EXPECT_EQ(Histogram{}, mRefreshRateStats->getModeSwitchLatencies().toHwc);
+    EXPECT_EQ(Histogram{}, mRefreshRateStats->getModeSwitchLatencies().toApplied);
+
+    mRefreshRateStats->recordModeSwitchLatency(1ms, 20ms);
+    mRefreshRateStats->recordModeSwitchLatency(4ms, 33ms);
+    mRefreshRateStats->recordModeSwitchLatency(12ms, 250ms);
+
+    EXPECT_EQ((Histogram{1, 1, 1, 0, 0, 0, 0}),
+              mRefreshRateStats->getModeSwitchLatencies().toHwc);
+    EXPECT_EQ((Histogram{0, 0, 0, 2, 0, 0, 1}),
+              mRefreshRateStats->getModeSwitchLatencies().toApplied);
+
+    std::string dump;
+    mRefreshRateStats->dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("<34ms: 0 / 2\n"));
+    EXPECT_NE(std::string::npos, dump.find(">=100ms: 0 / 1\n"));
+}
+
 } // namespace
 } // namespace android::scheduler
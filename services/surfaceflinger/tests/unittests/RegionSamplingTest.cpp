@@ -106,6 +106,59 @@ TEST_F(RegionSamplingTest, bounds_checking) {
                 testing::Eq(0.0));
 }
 
+TEST_F(RegionSamplingTest, reduction_levels_keep_smallest_area_sampled) {
+    EXPECT_EQ(0, getReductionLevels({}));
+    EXPECT_EQ(0, getReductionLevels({Rect{0, 0, 7, 100}}));
+    EXPECT_EQ(1, getReductionLevels({Rect{0, 0, 8, 100}}));
+    EXPECT_EQ(2, getReductionLevels({Rect{0, 0, 1000, 100}, Rect{0, 0, 16, 31}}));
+    EXPECT_EQ(kMaxReductionLevels, getReductionLevels({Rect{0, 0, 1080, 132}}));
+}
+
+TEST_F(RegionSamplingTest, reduced_area_rounds_to_nearest_pixels) {
+    EXPECT_EQ(Rect(3, 5, 10, 20), reduceArea(Rect{3, 5, 10, 20}, 0));
+    EXPECT_EQ(Rect(0, 1, 3, 5), reduceArea(Rect{0, 5, 10, 20}, 2));
+    EXPECT_EQ(Rect(2, 2, 3, 3), reduceArea(Rect{8, 8, 9, 9}, 2));
+
+    EXPECT_EQ(ui::Size(25, 8), reduceSize(ui::Size(98, 29), 2));
+    EXPECT_EQ(ui::Size(98, 29), reduceSize(ui::Size(98, 29), 0));
+}
+
+TEST_F(RegionSamplingTest, reduced_buffer_samples_like_full_buffer) {
+    // Reduce the buffer on the CPU the way the GPU does, by averaging each 2x2 block.
+    constexpr int32_t kWhiteColumns = 48;
+    std::generate(buffer.begin(), buffer.end(), [n = 0]() mutable {
+        return ((n++ % kStride) < kWhiteColumns) ? kWhite : kBlack;
+    });
+    const auto reducedSize = reduceSize(ui::Size(kWidth, kHeight), 1);
+    std::vector<uint32_t> reduced(reducedSize.getWidth() * reducedSize.getHeight());
+    for (int32_t row = 0; row < reducedSize.getHeight(); ++row) {
+        for (int32_t column = 0; column < reducedSize.getWidth(); ++column) {
+            uint32_t pixel = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                uint32_t channel = 0;
+                for (int32_t y = 2 * row; y < 2 * row + 2; ++y) {
+                    for (int32_t x = 2 * column; x < 2 * column + 2; ++x) {
+                        const int32_t offset = std::min(y, kHeight - 1) * kStride +
+                                std::min(x, kWidth - 1);
+                        channel += (buffer[offset] >> shift) & 0xFF;
+                    }
+                }
+                pixel |= (channel / 4) << shift;
+            }
+            reduced[row * reducedSize.getWidth() + column] = pixel;
+        }
+    }
+
+    const Rect left_half{0, 0, kWhiteColumns, kHeight};
+    EXPECT_THAT(sampleArea(reduced.data(), reducedSize.getWidth(), reducedSize.getHeight(),
+                           reducedSize.getWidth(), kOrientation, reduceArea(left_half, 1)),
+                testing::FloatEq(sampleArea(buffer.data(), kWidth, kHeight, kStride, kOrientation,
+                                            left_half)));
+    EXPECT_THAT(sampleArea(reduced.data(), reducedSize.getWidth(), reducedSize.getHeight(),
+                           reducedSize.getWidth(), kOrientation, reduceArea(whole_area, 1)),
+                testing::FloatNear(0.5, 0.05));
+}
+
 } // namespace android
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -35,6 +35,7 @@ namespace android::scheduler {
 using android::mock::createDisplayMode;
 
 using testing::_;
+using testing::Mock;
 using testing::Return;
 
 namespace {
@@ -224,6 +225,27 @@ TEST_F(SchedulerTest, calculateMaxAcquiredBufferCount) {
     EXPECT_EQ(1, mFlinger.calculateMaxAcquiredBufferCount(60_Hz, 10ms));
 }
 
+TEST_F(SchedulerTest, idleTimerExpiryDisablesHardwareVsyncUntilReset) {
+    EXPECT_CALL(mSchedulerCallback, setVsyncEnabled(kDisplayId1, true)).Times(1);
+    mScheduler->resyncAllToHardwareVsync(true /* allowToEnable */);
+    Mock::VerifyAndClearExpectations(&mSchedulerCallback);
+
+    // No frame is scheduled, so composition pauses.
+    EXPECT_CALL(mSchedulerCallback, setVsyncEnabled(kDisplayId1, false)).Times(1);
+    mScheduler->idleTimerCallback(/*expired=*/true);
+    EXPECT_TRUE(mScheduler->isIdle());
+    Mock::VerifyAndClearExpectations(&mSchedulerCallback);
+
+    EXPECT_CALL(mSchedulerCallback, setVsyncEnabled(_, _)).Times(0);
+    mScheduler->idleTimerCallback(/*expired=*/true);
+    Mock::VerifyAndClearExpectations(&mSchedulerCallback);
+
+    // The next frame resumes composition.
+    EXPECT_CALL(mSchedulerCallback, setVsyncEnabled(kDisplayId1, true)).Times(1);
+    mScheduler->idleTimerCallback(/*expired=*/false);
+    EXPECT_FALSE(mScheduler->isIdle());
+}
+
 MATCHER(Is120Hz, "") {
     return isApproxEqual(arg.front().mode.fps, 120_Hz);
 }
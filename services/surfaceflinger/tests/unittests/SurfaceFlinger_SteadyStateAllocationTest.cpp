@@ -0,0 +1,197 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "SurfaceFlingerSteadyStateAllocationTest"
+
+#include <compositionengine/Display.h>
+#include <compositionengine/mock/DisplaySurface.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <renderengine/mock/RenderEngine.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "AllocationCounter.h"
+#include "BackgroundExecutor.h"
+#include "TestableSurfaceFlinger.h"
+#include "TracedOrdinal.h"
+#include "TransactionCallbackInvoker.h"
+#include "mock/DisplayHardware/MockComposer.h"
+#include "mock/DisplayHardware/MockPowerAdvisor.h"
+#include "mock/MockTimeStats.h"
+#include "mock/system/window/MockNativeWindow.h"
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+using FakeHwcDisplayInjector = TestableSurfaceFlinger::FakeHwcDisplayInjector;
+using FakeDisplayDeviceInjector = TestableSurfaceFlinger::FakeDisplayDeviceInjector;
+
+constexpr hal::HWDisplayId HWC_DISPLAY = FakeHwcDisplayInjector::DEFAULT_HWC_DISPLAY_ID;
+constexpr PhysicalDisplayId DEFAULT_DISPLAY_ID = PhysicalDisplayId::fromPort(42u);
+constexpr int DEFAULT_DISPLAY_WIDTH = 1920;
+constexpr int DEFAULT_DISPLAY_HEIGHT = 1024;
+
+// exported symbol, to force compiler not to optimize away pointers we set here
+const void* imaginary_use;
+
+TEST(AllocationCounterTest, countsAllocationsOnThisThread) {
+    ScopedAllocationCounter counter;
+    auto* p = new int[10];
+    imaginary_use = p;
+    delete[] p;
+    EXPECT_EQ(1u, counter.getAllocationCount());
+    EXPECT_EQ(10 * sizeof(int), counter.getAllocatedBytes());
+}
+
+TEST(AllocationCounterTest, ignoresOtherThreads) {
+    ScopedAllocationCounter counter;
+    std::thread thread;
+    {
+        // Starting a thread allocates its state, so only count what the thread itself does.
+        ScopedAllocationCounter threadCreation;
+        thread = std::thread([] { imaginary_use = new std::string(100, 'x'); });
+    }
+    thread.join();
+    delete static_cast<const std::string*>(imaginary_use);
+    EXPECT_EQ(0u, counter.getAllocationCount());
+}
+
+TEST(AllocationCounterTest, innermostCounterCounts) {
+    ScopedAllocationCounter outer;
+    {
+        ScopedAllocationCounter inner;
+        imaginary_use = new int;
+        delete static_cast<const int*>(imaginary_use);
+        EXPECT_EQ(1u, inner.getAllocationCount());
+    }
+    EXPECT_EQ(0u, outer.getAllocationCount());
+}
+
+TEST(SteadyStateAllocationTest, tracedOrdinalFromLiteralDoesNotAllocate) {
+    ScopedAllocationCounter counter;
+    const TracedOrdinal<bool> ordinal = {"AVeryLongTracedOrdinalName", true};
+    EXPECT_TRUE(ordinal);
+    EXPECT_EQ(0u, counter.getAllocationCount());
+}
+
+TEST(SteadyStateAllocationTest, idleTransactionCallbacksDoNotAllocate) {
+    TransactionCallbackInvoker invoker;
+    ScopedAllocationCounter counter;
+    invoker.sendCallbacks(/*onCommitOnly=*/true);
+    invoker.sendCallbacks(/*onCommitOnly=*/false);
+    EXPECT_EQ(0u, counter.getAllocationCount());
+}
+
+TEST(SteadyStateAllocationTest, emptyBackgroundCallbacksDoNotAllocate) {
+    BackgroundExecutor::Callbacks callbacks;
+    ScopedAllocationCounter counter;
+    BackgroundExecutor::getInstance().sendCallbacks(std::move(callbacks));
+    EXPECT_EQ(0u, counter.getAllocationCount());
+}
+
+// Drives commit and composite for an idle display with no layer changes. Mocked HAL calls are
+// nice mocks so that gmock does not format warnings for them.
+class SurfaceFlingerSteadyStateAllocationTest : public testing::Test {
+public:
+    void SetUp() override;
+
+protected:
+    size_t countFrameAllocations();
+
+    TestableSurfaceFlinger mFlinger;
+    renderengine::mock::RenderEngine* mRenderEngine =
+            new NiceMock<renderengine::mock::RenderEngine>();
+    sp<DisplayDevice> mDisplay;
+    sp<compositionengine::mock::DisplaySurface> mDisplaySurface =
+            sp<NiceMock<compositionengine::mock::DisplaySurface>>::make();
+    sp<mock::NativeWindow> mNativeWindow = sp<NiceMock<mock::NativeWindow>>::make();
+    mock::TimeStats* mTimeStats = new NiceMock<mock::TimeStats>();
+    Hwc2::mock::PowerAdvisor* mPowerAdvisor = nullptr;
+    Hwc2::mock::Composer* mComposer = nullptr;
+    TimePoint mFrameTime = scheduler::SchedulerClock::now();
+    int64_t mVsyncId = 1;
+};
+
+void SurfaceFlingerSteadyStateAllocationTest::SetUp() {
+    mFlinger.setupMockScheduler({.displayId = DEFAULT_DISPLAY_ID});
+    mComposer = new NiceMock<Hwc2::mock::Composer>();
+    mPowerAdvisor = new NiceMock<Hwc2::mock::PowerAdvisor>();
+    mFlinger.setupRenderEngine(std::unique_ptr<renderengine::RenderEngine>(mRenderEngine));
+    mFlinger.setupTimeStats(std::shared_ptr<TimeStats>(mTimeStats));
+    mFlinger.setupComposer(std::unique_ptr<Hwc2::Composer>(mComposer));
+    mFlinger.setupPowerAdvisor(std::unique_ptr<Hwc2::PowerAdvisor>(mPowerAdvisor));
+    static constexpr bool kIsPrimary = true;
+    FakeHwcDisplayInjector(DEFAULT_DISPLAY_ID, hal::DisplayType::PHYSICAL, kIsPrimary)
+            .setPowerMode(hal::PowerMode::ON)
+            .inject(&mFlinger, mComposer);
+    auto compositionEngineDisplayArgs =
+            compositionengine::DisplayCreationArgsBuilder()
+                    .setId(DEFAULT_DISPLAY_ID)
+                    .setPixels({DEFAULT_DISPLAY_WIDTH, DEFAULT_DISPLAY_HEIGHT})
+                    .setPowerAdvisor(mPowerAdvisor)
+                    .setName("injected display")
+                    .build();
+    auto compositionDisplay =
+            compositionengine::impl::createDisplay(mFlinger.getCompositionEngine(),
+                                                   std::move(compositionEngineDisplayArgs));
+    mDisplay =
+            FakeDisplayDeviceInjector(mFlinger, compositionDisplay,
+                                      ui::DisplayConnectionType::Internal, HWC_DISPLAY, kIsPrimary)
+                    .setDisplaySurface(mDisplaySurface)
+                    .setNativeWindow(mNativeWindow)
+                    .setPowerMode(hal::PowerMode::ON)
+                    .setRefreshRateSelector(mFlinger.scheduler()->refreshRateSelector())
+                    .skipRegisterDisplay()
+                    .inject();
+}
+
+size_t SurfaceFlingerSteadyStateAllocationTest::countFrameAllocations() {
+    constexpr Period kVsyncPeriod = 16ms;
+    mFrameTime += kVsyncPeriod;
+    const VsyncId vsyncId{mVsyncId++};
+
+    ScopedAllocationCounter counter;
+    mFlinger.commitAndComposite(mFrameTime, vsyncId, mFrameTime + kVsyncPeriod);
+    return counter.getAllocationCount();
+}
+
+TEST_F(SurfaceFlingerSteadyStateAllocationTest, idleFramesDoNotAccumulateAllocations) {
+    // The first frames size caches, arenas and scratch vectors.
+    constexpr int kWarmUpFrames = 3;
+    for (int i = 0; i < kWarmUpFrames; i++) {
+        countFrameAllocations();
+    }
+
+    // Whatever a steady-state frame still allocates must not depend on how long SurfaceFlinger
+    // has been running. Mocked HAL calls allocate inside gmock, so compare frames against each
+    // other rather than against zero.
+    const size_t baseline = countFrameAllocations();
+    constexpr int kMeasuredFrames = 10;
+    for (int i = 0; i < kMeasuredFrames; i++) {
+        EXPECT_LE(countFrameAllocations(), baseline) << "frame " << i;
+    }
+}
+
+} // namespace
+} // namespace android
@@ -119,6 +119,14 @@ public:
         mTouchTimer->start();
     }
 
+    void idleTimerCallback(bool expired) {
+        Scheduler::idleTimerCallback(expired ? TimerState::Expired : TimerState::Reset);
+    }
+
+    bool isIdle() const { return mIdle; }
+
+    using Scheduler::resyncAllToHardwareVsync;
+
     bool isTouchActive() {
         std::lock_guard<std::mutex> lock(mPolicyLock);
         return mPolicy.touch == Scheduler::TouchState::Active;
@@ -484,6 +484,14 @@ public:
         return mFlinger->mTransactionHandler.queueTransaction(std::move(transaction));
     }
 
+    auto setClientStateLocked(const FrameTimelineInfo& frameTimelineInfo,
+                              ResolvedComposerState& composerState, int64_t desiredPresentTime,
+                              bool isAutoTimestamp, int64_t postTime, uint64_t transactionId) {
+        Mutex::Autolock lock(mFlinger->mStateLock);
+        return mFlinger->setClientStateLocked(frameTimelineInfo, composerState, desiredPresentTime,
+                                              isAutoTimestamp, postTime, transactionId);
+    }
+
     auto flushTransactionQueues() {
         return FTL_FAKE_GUARD(kMainThreadContext, mFlinger->flushTransactionQueues(kVsyncId));
     }
@@ -32,6 +32,7 @@
 
 #include <chrono>
 #include <random>
+#include <thread>
 #include <unordered_set>
 
 #include "libsurfaceflinger_unittest_main.h"
@@ -289,6 +290,46 @@ TEST_F(TimeStatsTest, canIncreaseGlobalStats) {
     EXPECT_EQ(CLIENT_COMPOSITION_FRAMES, globalProto.client_composition_frames());
 }
 
+TEST_F(TimeStatsTest, mergesStatsAccumulatedConcurrentlyWithDumps) {
+    constexpr size_t NUM_THREADS = 4;
+    constexpr size_t FRAMES_PER_THREAD = 1000;
+
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    std::atomic<size_t> runningThreads = NUM_THREADS;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < NUM_THREADS; i++) {
+        threads.emplace_back([&] {
+            for (size_t frame = 0; frame < FRAMES_PER_THREAD; frame++) {
+                mTimeStats->incrementTotalFrames();
+                mTimeStats->incrementJankyFrames({kRefreshRate0, kRenderRate0, UID_0,
+                                                  genLayerName(LAYER_ID_0), kGameMode,
+                                                  JankType::AppDeadlineMissed, 1, 2, 3});
+            }
+            runningThreads--;
+        });
+    }
+    // Dumps merge the accumulated stats while the threads add to them.
+    while (runningThreads > 0) {
+        inputCommand(InputCommand::DUMP_ALL, FMT_STRING);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+    EXPECT_EQ(NUM_THREADS * FRAMES_PER_THREAD, globalProto.total_frames());
+
+    const std::string result(inputCommand(InputCommand::DUMP_ALL, FMT_STRING));
+    EXPECT_THAT(result,
+                HasSubstr("totalTimelineFrames = " +
+                          std::to_string(NUM_THREADS * FRAMES_PER_THREAD)));
+    EXPECT_THAT(result,
+                HasSubstr("appUnattributedJankyFrames = " +
+                          std::to_string(NUM_THREADS * FRAMES_PER_THREAD)));
+}
+
 TEST_F(TimeStatsTest, canIncreaseLateAcquireFrames) {
     // this stat is not in the proto so verify by checking the string dump
     constexpr size_t LATE_ACQUIRE_FRAMES = 2;
@@ -1088,6 +1088,92 @@ TEST(TransactionHandlerTest, QueueTransaction) {
     EXPECT_EQ(transactionsReadyToBeApplied.front().id, 42u);
 }
 
+namespace {
+TransactionState makePositionTransaction(const sp<IBinder>& applyToken, const sp<IBinder>& surface,
+                                         uint64_t id, float x) {
+    TransactionState transaction;
+    transaction.applyToken = applyToken;
+    transaction.id = id;
+    transaction.isAutoTimestamp = true;
+    transaction.flags = 0;
+    transaction.originPid = 0;
+    transaction.originUid = 0;
+    ResolvedComposerState state;
+    state.state.surface = surface;
+    state.state.what = layer_state_t::ePositionChanged;
+    state.state.x = x;
+    transaction.states.emplace_back(std::move(state));
+    return transaction;
+}
+} // namespace
+
+TEST(TransactionHandlerTest, CoalescingIsDisabledByDefault) {
+    TransactionHandler handler;
+    const sp<IBinder> applyToken = sp<BBinder>::make();
+    const sp<IBinder> surface = sp<BBinder>::make();
+    handler.queueTransaction(makePositionTransaction(applyToken, surface, 1, 1.f));
+    handler.queueTransaction(makePositionTransaction(applyToken, surface, 2, 2.f));
+
+    EXPECT_EQ(handler.flushTransactions().size(), 2u);
+}
+
+TEST(TransactionHandlerTest, CoalescesTransactionsFromSameApplyToken) {
+    TransactionHandler handler;
+    handler.setCoalescingEnabled(true);
+    const sp<IBinder> applyToken = sp<BBinder>::make();
+    const sp<IBinder> surface = sp<BBinder>::make();
+    const sp<IBinder> otherSurface = sp<BBinder>::make();
+    handler.queueTransaction(makePositionTransaction(applyToken, surface, 1, 1.f));
+    handler.queueTransaction(makePositionTransaction(applyToken, otherSurface, 2, 2.f));
+    handler.queueTransaction(makePositionTransaction(applyToken, surface, 3, 3.f));
+
+    std::vector<TransactionState> transactions = handler.flushTransactions();
+    ASSERT_EQ(transactions.size(), 1u);
+    const TransactionState& transaction = transactions.front();
+    EXPECT_EQ(transaction.id, 1u);
+    EXPECT_EQ(transaction.coalescedTransactionIds, (std::vector<uint64_t>{2u, 3u}));
+    EXPECT_EQ(transaction.mergedTransactionIds, (std::vector<uint64_t>{3u, 2u}));
+
+    // Last writer wins for the layer that appears twice.
+    ASSERT_EQ(transaction.states.size(), 2u);
+    EXPECT_EQ(transaction.states[0].state.surface, surface);
+    EXPECT_EQ(transaction.states[0].state.x, 3.f);
+    EXPECT_EQ(transaction.states[1].state.surface, otherSurface);
+    EXPECT_EQ(transaction.states[1].state.x, 2.f);
+    EXPECT_FALSE(handler.hasPendingTransactions());
+
+    std::string dump;
+    handler.dump(dump);
+    EXPECT_NE(dump.find("applied=1 coalesced=2 "), std::string::npos) << dump;
+}
+
+TEST(TransactionHandlerTest, DoesNotCoalesceIneligibleTransactions) {
+    TransactionHandler handler;
+    handler.setCoalescingEnabled(true);
+    const sp<IBinder> applyToken = sp<BBinder>::make();
+    const sp<IBinder> otherApplyToken = sp<BBinder>::make();
+    const sp<IBinder> surface = sp<BBinder>::make();
+
+    handler.queueTransaction(makePositionTransaction(applyToken, surface, 1, 1.f));
+    // Different origin.
+    auto transaction = makePositionTransaction(applyToken, surface, 2, 2.f);
+    transaction.originUid = 1000;
+    handler.queueTransaction(std::move(transaction));
+    // Different frame timeline.
+    transaction = makePositionTransaction(applyToken, surface, 3, 3.f);
+    transaction.originUid = 1000;
+    transaction.frameTimelineInfo.vsyncId = 42;
+    handler.queueTransaction(std::move(transaction));
+    // Different apply token.
+    handler.queueTransaction(makePositionTransaction(otherApplyToken, surface, 4, 4.f));
+
+    std::vector<TransactionState> transactions = handler.flushTransactions();
+    ASSERT_EQ(transactions.size(), 4u);
+    for (const auto& flushed : transactions) {
+        EXPECT_TRUE(flushed.coalescedTransactionIds.empty());
+    }
+}
+
 TEST(TransactionHandlerTest, TransactionsKeepTrackOfDirectMerges) {
     SurfaceComposerClient::Transaction transaction1, transaction2, transaction3, transaction4;
 
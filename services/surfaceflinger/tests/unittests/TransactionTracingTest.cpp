@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -334,4 +335,66 @@ TEST(LayerTraceTest, canStreamLayersTrace) {
     // magic?
     EXPECT_EQ(outProto.entry().size(), 3);
 }
+
+TEST(TransactionTraceRingBufferTest, compressedSegmentsHoldMoreEntries) {
+    using Buffer = RingBuffer<proto::TransactionTraceFile, proto::TransactionTraceEntry>;
+    constexpr int64_t kEntries = 1000;
+    auto fill = [](Buffer& buffer) {
+        for (int64_t vsyncId = 1; vsyncId <= kEntries; vsyncId++) {
+            proto::TransactionTraceEntry entry;
+            entry.set_vsync_id(vsyncId);
+            proto::TransactionState* transaction = entry.add_transactions();
+            transaction->set_pid(42);
+            transaction->set_uid(1000);
+            transaction->set_transaction_id(static_cast<uint64_t>(vsyncId));
+            for (uint32_t layerId = 1; layerId <= 4; layerId++) {
+                transaction->add_layer_changes()->set_layer_id(layerId);
+            }
+            buffer.emplace(std::move(entry));
+        }
+    };
+
+    Buffer uncompressed;
+    uncompressed.setSize(16 * 1024);
+    fill(uncompressed);
+
+    Buffer compressed;
+    compressed.setSize(16 * 1024);
+    compressed.setCompression(true, 1024);
+    fill(compressed);
+
+    EXPECT_GT(compressed.frameCount(), uncompressed.frameCount());
+    EXPECT_LE(compressed.used(), compressed.size());
+
+    proto::TransactionTraceFile file;
+    compressed.writeToProto(file);
+    ASSERT_EQ(static_cast<size_t>(file.entry_size()), compressed.frameCount());
+    const int64_t firstVsyncId = kEntries - file.entry_size() + 1;
+    for (int i = 0; i < file.entry_size(); i++) {
+        EXPECT_EQ(firstVsyncId + i, file.entry(i).vsync_id());
+    }
+
+    proto::TransactionTraceEntry front;
+    front.ParseFromString(compressed.front());
+    EXPECT_EQ(firstVsyncId, front.vsync_id());
+}
+
+TEST_F(TransactionTracingTest, streamsCommittedEntries) {
+    queueAndCommitTransaction(1);
+
+    TemporaryFile stream;
+    ASSERT_EQ(NO_ERROR, mTracing.startStreaming(stream.path));
+    queueAndCommitTransaction(2);
+    queueAndCommitTransaction(3);
+    mTracing.stopStreaming();
+
+    std::string contents;
+    ASSERT_TRUE(base::ReadFileToString(stream.path, &contents));
+    proto::TransactionTraceFile file;
+    ASSERT_TRUE(file.ParseFromString(contents));
+    ASSERT_EQ(3, file.entry_size());
+    EXPECT_EQ(1, file.entry(0).vsync_id());
+    EXPECT_EQ(3, file.entry(2).vsync_id());
+    EXPECT_EQ(TransactionTracing::TRACING_VERSION, file.version());
+}
 } // namespace android
@@ -1061,6 +1061,99 @@ TEST_F(VSyncDispatchTimerQueueTest, updatesVsyncTimeForCloseWakeupTime) {
     EXPECT_THAT(cb.mReadyTime[0], Eq(2000));
 }
 
+class VSyncDispatchTimerQueueHeapTest : public VSyncDispatchTimerQueueTest {
+protected:
+    VSyncDispatchTimerQueueHeapTest() {
+        mDispatch = std::make_shared<VSyncDispatchTimerQueue>(createTimeKeeper(), mStubTracker,
+                                                              mDispatchGroupThreshold,
+                                                              mVsyncMoveThreshold,
+                                                              VSyncDispatchTimerQueue::Backend::Heap);
+    }
+};
+
+TEST_F(VSyncDispatchTimerQueueHeapTest, dispatchesInWakeupOrder) {
+    Sequence seq;
+    EXPECT_CALL(mMockClock, alarmAt(_, 900)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 750)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 900)).InSequence(seq);
+
+    CountingCallback cb0(mDispatch);
+    CountingCallback cb1(mDispatch);
+
+    mDispatch->schedule(cb0, {.workDuration = 100, .readyDuration = 0, .earliestVsync = mPeriod});
+    mDispatch->schedule(cb1, {.workDuration = 250, .readyDuration = 0, .earliestVsync = mPeriod});
+
+    advanceToNextCallback();
+    ASSERT_THAT(cb1.mCalls.size(), Eq(1));
+    EXPECT_THAT(cb1.mCalls[0], Eq(mPeriod));
+    EXPECT_THAT(cb0.mCalls.size(), Eq(0));
+
+    advanceToNextCallback();
+    ASSERT_THAT(cb0.mCalls.size(), Eq(1));
+    EXPECT_THAT(cb0.mCalls[0], Eq(mPeriod));
+}
+
+TEST_F(VSyncDispatchTimerQueueHeapTest, rearmsFaroutTimeoutWhenCancellingCloseOne) {
+    Sequence seq;
+    EXPECT_CALL(mMockClock, alarmAt(_, 9900)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 750)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 9900)).InSequence(seq);
+
+    CountingCallback cb0(mDispatch);
+    CountingCallback cb1(mDispatch);
+
+    mDispatch->schedule(cb0,
+                        {.workDuration = 100, .readyDuration = 0, .earliestVsync = mPeriod * 10});
+    mDispatch->schedule(cb1, {.workDuration = 250, .readyDuration = 0, .earliestVsync = mPeriod});
+    mDispatch->cancel(cb1);
+}
+
+// Unlike the scan, rearming only refreshes the earliest wakeup rather than every callback.
+TEST_F(VSyncDispatchTimerQueueHeapTest, schedulingDoesNotRefreshOtherCallbacks) {
+    constexpr int kCallbacks = 10;
+    EXPECT_CALL(*mStubTracker.get(), nextAnticipatedVSyncTimeFrom(_)).Times(kCallbacks);
+
+    std::vector<std::unique_ptr<CountingCallback>> callbacks;
+    for (int i = 0; i < kCallbacks; i++) {
+        callbacks.push_back(std::make_unique<CountingCallback>(mDispatch));
+    }
+
+    // Every callback wakes up earlier than the previous one, so each schedule rearms the timer.
+    for (int i = 0; i < kCallbacks; i++) {
+        const auto result =
+                mDispatch->schedule(*callbacks[i],
+                                    {.workDuration = 10 * (i + 1),
+                                     .readyDuration = 0,
+                                     .earliestVsync = mPeriod});
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ(mPeriod - 10 * (i + 1), *result);
+    }
+}
+
+TEST_F(VSyncDispatchTimerQueueHeapTest, skipsSchedulingIfTimerReschedulingIsImminentSameCallback) {
+    Sequence seq;
+    EXPECT_CALL(mMockClock, alarmAt(_, 600)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 1630)).InSequence(seq);
+    CountingCallback cb(mDispatch);
+
+    auto result =
+            mDispatch->schedule(cb,
+                                {.workDuration = 400, .readyDuration = 0, .earliestVsync = 1000});
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(600, *result);
+
+    mMockClock.setLag(100);
+    mMockClock.advanceBy(620);
+
+    result = mDispatch->schedule(cb,
+                                 {.workDuration = 370, .readyDuration = 0, .earliestVsync = 2000});
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(1630, *result);
+    mMockClock.advanceBy(80);
+
+    EXPECT_THAT(cb.mCalls.size(), Eq(1));
+}
+
 class VSyncDispatchTimerQueueEntryTest : public testing::Test {
 protected:
     nsecs_t const mPeriod = 1000;
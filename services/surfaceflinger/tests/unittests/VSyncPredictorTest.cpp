@@ -28,7 +28,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <thread>
 #include <utility>
 
 using namespace testing;
@@ -626,6 +628,127 @@ TEST_F(VSyncPredictorTest, setRenderRateIsIgnoredIfNotDivisor) {
     EXPECT_THAT(tracker.nextAnticipatedVSyncTimeFrom(mNow + 5100), Eq(mNow + 6 * mPeriod));
 }
 
+TEST_F(VSyncPredictorTest, predictionsDoNotLockOnceReferenceIsSet) {
+    for (auto i = 0u; i < kMinimumSamplesForPrediction; i++) {
+        mNow += mPeriod;
+        tracker.addVsyncTimestamp(mNow);
+    }
+    tracker.setRenderRate(Fps::fromPeriodNsecs(2 * mPeriod));
+
+    // The first prediction sets the reference point for sequence numbers.
+    tracker.nextAnticipatedVSyncTimeFrom(mNow);
+    for (int i = 0; i < 10; i++) {
+        tracker.nextAnticipatedVSyncTimeFrom(mNow + i * mPeriod);
+        tracker.isVSyncInPhase(mNow + i * mPeriod, Fps::fromPeriodNsecs(2 * mPeriod));
+    }
+
+    std::string dump;
+    tracker.dump(dump);
+    EXPECT_THAT(dump, HasSubstr("lockedReads=1 "));
+}
+
+TEST_F(VSyncPredictorTest, predictionsAreConsistentWhileModelIsUpdated) {
+    for (auto i = 0u; i < kMinimumSamplesForPrediction; i++) {
+        mNow += mPeriod;
+        tracker.addVsyncTimestamp(mNow);
+    }
+    tracker.nextAnticipatedVSyncTimeFrom(mNow);
+
+    std::atomic<nsecs_t> latest = mNow;
+    std::atomic<bool> done = false;
+    std::thread reader([&] {
+        while (!done) {
+            // The model may already include the timestamp after `timePoint`.
+            const nsecs_t timePoint = latest;
+            const nsecs_t prediction = tracker.nextAnticipatedVSyncTimeFrom(timePoint);
+            EXPECT_GE(prediction, timePoint);
+            EXPECT_LE(prediction, timePoint + 2 * mPeriod + mMaxRoundingError);
+        }
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        mNow += mPeriod + (i % 2 ? 10 : -10);
+        tracker.addVsyncTimestamp(mNow);
+        latest = mNow;
+    }
+    done = true;
+    reader.join();
+}
+
+struct VSyncPredictorKalmanTest : testing::Test {
+    static constexpr nsecs_t kPeriod = 16'666'666;
+    static constexpr size_t kHistorySize = 20;
+    static constexpr size_t kMinimumSamplesForPrediction = 6;
+    static constexpr size_t kOutlierTolerancePercent = 25;
+
+    VSyncPredictor tracker{DEFAULT_DISPLAY_ID,
+                           kPeriod,
+                           kHistorySize,
+                           kMinimumSamplesForPrediction,
+                           kOutlierTolerancePercent,
+                           VSyncPredictor::Estimator::Kalman};
+};
+
+TEST_F(VSyncPredictorKalmanTest, robustToDuplicateTimestamps_60hzRealTraceData) {
+    // The same trace as VSyncPredictorTest.robustToDuplicateTimestamps_60hzRealTraceData.
+    std::vector<nsecs_t> const simulatedVsyncs{
+            198353408177, 198370074844, 198371400000, 198374274000, 198390941000, 198407565000,
+            198540887994, 198607538588, 198624218276, 198657655939, 198674224176, 198690880955,
+            198724204319, 198740988133, 198758166681, 198790869196, 198824205052, 198840871678,
+            198857715631, 198890885797, 198924199640, 198940873834, 198974204401,
+    };
+    for (auto const& timestamp : simulatedVsyncs) {
+        tracker.addVsyncTimestamp(timestamp);
+    }
+    auto [slope, intercept] = tracker.getVSyncPredictionModel();
+    EXPECT_THAT(slope, IsCloseTo(kPeriod, 20'000));
+    EXPECT_THAT(tracker.nextAnticipatedVSyncTimeFrom(simulatedVsyncs.back() + kPeriod / 2),
+                IsCloseTo(simulatedVsyncs.back() + kPeriod, 200'000));
+}
+
+TEST_F(VSyncPredictorKalmanTest, rejectsOutliersWithinPhaseTolerance) {
+    // A 16.6ms display with +/-50us of jitter. Every 17th sample is 3ms late, which is inside the
+    // fixed phase tolerance, so only the filter can tell that it is an outlier.
+    constexpr nsecs_t kActualPeriod = 16'600'000;
+    constexpr nsecs_t kBase = 1'000'000'000;
+    nsecs_t last = 0;
+    for (int i = 0; i < 200; i++) {
+        last = kBase + i * kActualPeriod + (i % 2 ? 50'000 : -50'000);
+        if (i > kMinimumSamplesForPrediction && i % 17 == 0) {
+            EXPECT_FALSE(tracker.addVsyncTimestamp(last + 3'000'000)) << "sample " << i;
+        } else {
+            tracker.addVsyncTimestamp(last);
+        }
+    }
+
+    auto [slope, intercept] = tracker.getVSyncPredictionModel();
+    EXPECT_THAT(slope, IsCloseTo(kActualPeriod, 1'000));
+    EXPECT_THAT(tracker.nextAnticipatedVSyncTimeFrom(last + kActualPeriod / 2),
+                IsCloseTo(last + kActualPeriod, 100'000));
+    EXPECT_GT(tracker.getModelConfidence(), 0.5f);
+}
+
+TEST_F(VSyncPredictorKalmanTest, confidenceIsZeroUntilModelled) {
+    EXPECT_EQ(tracker.getModelConfidence(), 0.f);
+    for (size_t i = 0; i < kMinimumSamplesForPrediction - 1; i++) {
+        tracker.addVsyncTimestamp(i * kPeriod);
+        EXPECT_EQ(tracker.getModelConfidence(), 0.f);
+    }
+
+    // Confidence builds up as the period estimate settles.
+    float confidence = 0.f;
+    for (size_t i = kMinimumSamplesForPrediction - 1; i < 60; i++) {
+        tracker.addVsyncTimestamp(i * kPeriod);
+        EXPECT_GE(tracker.getModelConfidence(), confidence);
+        confidence = tracker.getModelConfidence();
+    }
+    EXPECT_GT(confidence, 0.5f);
+
+    tracker.resetModel();
+    tracker.setPeriod(kPeriod / 2);
+    EXPECT_EQ(tracker.getModelConfidence(), 0.f);
+}
+
 } // namespace android::scheduler
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
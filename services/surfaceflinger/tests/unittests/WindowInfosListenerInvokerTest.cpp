@@ -245,4 +245,76 @@ TEST_F(WindowInfosListenerInvokerTest, noListeners) {
     EXPECT_EQ(callCount, 1);
 }
 
+// Test that the listeners that received the last update are only sent the windows that changed
+// since, and that a listener that asks for a resync is sent all the windows again.
+TEST_F(WindowInfosListenerInvokerTest, sendsDeltas) {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    std::vector<gui::WindowInfosUpdate> updates;
+
+    gui::WindowInfosListenerInfo listenerInfo;
+    mInvoker->addWindowInfosListener(sp<Listener>::make([&](const gui::WindowInfosUpdate& update) {
+                                         std::scoped_lock lock{mutex};
+                                         updates.push_back(update);
+                                         cv.notify_one();
+
+                                         listenerInfo.windowInfosPublisher
+                                                 ->ackWindowInfosReceived(update.vsyncId,
+                                                                          listenerInfo.listenerId);
+                                     }),
+                                     &listenerInfo);
+
+    auto makeWindowInfo = [](int32_t id, float alpha) {
+        gui::WindowInfo info;
+        info.id = id;
+        info.name = "Window";
+        info.alpha = alpha;
+        return info;
+    };
+
+    BackgroundExecutor::getInstance().sendCallbacks({[&]() {
+        mInvoker->windowInfosChanged({{makeWindowInfo(1, 1.0f), makeWindowInfo(2, 1.0f)},
+                                      {},
+                                      /* vsyncId= */ 1,
+                                      0},
+                                     {}, false);
+    }});
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return updates.size() == 1; });
+    }
+
+    BackgroundExecutor::getInstance().sendCallbacks({[&]() {
+        mInvoker->windowInfosChanged({{makeWindowInfo(1, 1.0f), makeWindowInfo(2, 0.5f)},
+                                      {},
+                                      /* vsyncId= */ 2,
+                                      0},
+                                     {}, false);
+    }});
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return updates.size() == 2; });
+    }
+
+    listenerInfo.windowInfosPublisher->resyncWindowInfos(listenerInfo.listenerId);
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return updates.size() == 3; });
+    }
+
+    EXPECT_FALSE(updates[0].isDelta());
+    EXPECT_EQ(2u, updates[0].windowInfos.size());
+
+    ASSERT_TRUE(updates[1].isDelta());
+    EXPECT_EQ(updates[0].version, *updates[1].baseVersion);
+    EXPECT_EQ((std::vector<int32_t>{1, 2}), updates[1].windowIds);
+    ASSERT_EQ(1u, updates[1].windowInfos.size());
+    EXPECT_EQ(2, updates[1].windowInfos[0].id);
+
+    EXPECT_FALSE(updates[2].isDelta());
+    EXPECT_EQ(updates[1].version, updates[2].version);
+    EXPECT_EQ(2u, updates[2].windowInfos.size());
+}
+
 } // namespace android
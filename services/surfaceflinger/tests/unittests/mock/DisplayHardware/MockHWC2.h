@@ -108,6 +108,8 @@ public:
     MOCK_METHOD(hal::Error, getOverlaySupport,
                 (aidl::android::hardware::graphics::composer3::OverlayProperties *),
                 (const override));
+    MOCK_METHOD(LayerCommandStats, getLayerCommandStats, (), (const, override));
+    MOCK_METHOD(LayerCommandStats, getLastFrameLayerCommandStats, (), (const, override));
 };
 
 class Layer : public HWC2::Layer {
@@ -48,6 +48,8 @@ public:
     MOCK_METHOD(void, setHwcPresentTiming,
                 (DisplayId displayId, TimePoint presentStartTime, TimePoint presentEndTime),
                 (override));
+    MOCK_METHOD(void, setExpectedClientComposition, (DisplayId displayId, bool expected),
+                (override));
     MOCK_METHOD(void, setSkippedValidate, (DisplayId displayId, bool skipped), (override));
     MOCK_METHOD(void, setRequiresClientComposition,
                 (DisplayId displayId, bool requiresClientComposition), (override));
@@ -61,6 +63,7 @@ public:
     MOCK_METHOD(void, setCompositeEnd, (TimePoint compositeEndTime), (override));
     MOCK_METHOD(void, setDisplays, (std::vector<DisplayId> & displayIds), (override));
     MOCK_METHOD(void, setTotalFrameTargetWorkDuration, (Duration targetDuration), (override));
+    MOCK_METHOD(void, dump, (std::string & result), (const, override));
 };
 
 } // namespace android::Hwc2::mock
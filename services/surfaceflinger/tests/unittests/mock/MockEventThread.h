@@ -47,6 +47,8 @@ public:
     MOCK_METHOD(void, requestNextVsync, (const sp<android::EventThreadConnection>&), (override));
     MOCK_METHOD(VsyncEventData, getLatestVsyncEventData,
                 (const sp<android::EventThreadConnection>&), (const, override));
+    MOCK_METHOD(status_t, enableVsyncMailbox,
+                (const sp<android::EventThreadConnection>&, base::unique_fd*), (override));
     MOCK_METHOD(void, requestLatestConfig, (const sp<android::EventThreadConnection>&));
     MOCK_METHOD(void, pauseVsyncCallback, (bool));
     MOCK_METHOD(size_t, getEventThreadConnectionCount, (), (override));
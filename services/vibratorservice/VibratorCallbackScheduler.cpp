@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -59,36 +60,53 @@ CallbackScheduler::~CallbackScheduler() {
 }
 
 void CallbackScheduler::schedule(std::function<void()> callback, std::chrono::milliseconds delay) {
+    bool expiresFirst;
     {
         std::lock_guard<std::mutex> lock(mMutex);
         if (mCallbackThread == nullptr) {
             mCallbackThread = std::make_unique<std::thread>(&CallbackScheduler::loop, this);
         }
-        mQueue.emplace(DelayedCallback(callback, delay));
+        DelayedCallback delayedCallback(std::move(callback), delay);
+        // The callback thread already waits for the callbacks which expire before this one.
+        expiresFirst = mQueue.empty() || delayedCallback < mQueue.front();
+        mQueue.push_back(std::move(delayedCallback));
+        std::push_heap(mQueue.begin(), mQueue.end(), std::greater<DelayedCallback>());
+    }
+    if (expiresFirst) {
+        mCondition.notify_all();
     }
-    mCondition.notify_all();
 }
 
 void CallbackScheduler::loop() {
+    std::unique_lock<std::mutex> lock(mMutex);
     while (true) {
-        std::unique_lock<std::mutex> lock(mMutex);
         if (mFinished) {
             // Destructor was called, so let the callback thread die.
             break;
         }
-        while (!mQueue.empty() && mQueue.top().isExpired()) {
-            DelayedCallback callback = mQueue.top();
-            mQueue.pop();
+        // Take all the callbacks which expired together, so that a burst of short vibrations only
+        // takes the lock once.
+        while (!mQueue.empty() && mQueue.front().isExpired()) {
+            std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<DelayedCallback>());
+            mExpiredCallbacks.push_back(std::move(mQueue.back()));
+            mQueue.pop_back();
+        }
+        if (!mExpiredCallbacks.empty()) {
             lock.unlock();
-            callback.run();
+            for (const DelayedCallback& callback : mExpiredCallbacks) {
+                callback.run();
+            }
+            mExpiredCallbacks.clear();
             lock.lock();
+            // More callbacks might have expired, or been scheduled, while these were running.
+            continue;
         }
         if (mQueue.empty()) {
             // Wait until a new callback is scheduled.
             mCondition.wait(mMutex);
         } else {
             // Wait until next callback expires, or a new one is scheduled.
-            mCondition.wait_until(mMutex, mQueue.top().getExpiration());
+            mCondition.wait_until(mMutex, mQueue.front().getExpiration());
         }
     }
 }
@@ -46,7 +46,7 @@ namespace vibrator {
 
 // -------------------------------------------------------------------------------------------------
 
-std::shared_ptr<HalWrapper> connectHal(std::shared_ptr<CallbackScheduler> scheduler) {
+static std::shared_ptr<HalWrapper> connectHalWrapper(std::shared_ptr<CallbackScheduler> scheduler) {
     static bool gHalExists = true;
     if (!gHalExists) {
         // We already tried to connect to all of the vibrator HAL versions and none was available.
@@ -85,6 +85,16 @@ std::shared_ptr<HalWrapper> connectHal(std::shared_ptr<CallbackScheduler> schedu
     return std::make_shared<HidlHalWrapperV1_0>(std::move(scheduler), halV1_0);
 }
 
+std::shared_ptr<HalWrapper> connectHal(std::shared_ptr<CallbackScheduler> scheduler) {
+    std::shared_ptr<HalWrapper> hal = connectHalWrapper(std::move(scheduler));
+    if (hal) {
+        // Load the static info while connecting, which already waits for the HAL service, so that
+        // the first vibrations do not wait for the many calls it takes.
+        hal->getInfo();
+    }
+    return hal;
+}
+
 // -------------------------------------------------------------------------------------------------
 
 bool HalController::init() {
@@ -187,6 +187,36 @@ HalResult<Capabilities> HalWrapper::getCapabilities() {
 
 HalResult<std::vector<milliseconds>> HalWrapper::getPrimitiveDurations() {
     std::lock_guard<std::mutex> lock(mInfoMutex);
+    loadPrimitiveDurationsLocked();
+    return mInfoCache.mPrimitiveDurations;
+}
+
+milliseconds HalWrapper::getCompositionDuration(const std::vector<CompositeEffect>& primitives) {
+    std::lock_guard<std::mutex> lock(mInfoMutex);
+    loadPrimitiveDurationsLocked();
+    const auto& cachedDurations = mInfoCache.mPrimitiveDurations;
+    const std::vector<milliseconds>* durations =
+            cachedDurations.isOk() ? &cachedDurations.value() : nullptr;
+    milliseconds duration(0);
+    for (const auto& effect : primitives) {
+        auto primitiveIdx = static_cast<size_t>(effect.primitive);
+        if (durations != nullptr && primitiveIdx < durations->size()) {
+            duration += (*durations)[primitiveIdx];
+        } else {
+            // Make sure the returned duration is positive to indicate successful vibration.
+            duration += milliseconds(1);
+        }
+        duration += milliseconds(effect.delayMs);
+    }
+    return duration;
+}
+
+void HalWrapper::clearInfoCache() {
+    std::lock_guard<std::mutex> lock(mInfoMutex);
+    mInfoCache = InfoCache();
+}
+
+void HalWrapper::loadPrimitiveDurationsLocked() {
     if (mInfoCache.mSupportedPrimitives.isFailed()) {
         mInfoCache.mSupportedPrimitives = getSupportedPrimitivesInternal();
         if (mInfoCache.mSupportedPrimitives.isUnsupported()) {
@@ -197,7 +227,6 @@ HalResult<std::vector<milliseconds>> HalWrapper::getPrimitiveDurations() {
         mInfoCache.mPrimitiveDurations =
                 getPrimitiveDurationsInternal(mInfoCache.mSupportedPrimitives.value());
     }
-    return mInfoCache.mPrimitiveDurations;
 }
 
 HalResult<std::vector<Effect>> HalWrapper::getSupportedEffectsInternal() {
@@ -279,8 +308,17 @@ void AidlHalWrapper::tryReconnect() {
     }
     sp<Aidl::IVibrator> newHandle = result.value();
     if (newHandle) {
-        std::lock_guard<std::mutex> lock(mHandleMutex);
-        mHandle = std::move(newHandle);
+        bool restarted;
+        {
+            std::lock_guard<std::mutex> lock(mHandleMutex);
+            // The proxies of the same service share their binder, which changes when the HAL
+            // service restarts, and so might its info.
+            restarted = IInterface::asBinder(newHandle) != IInterface::asBinder(mHandle);
+            mHandle = std::move(newHandle);
+        }
+        if (restarted) {
+            clearInfoCache();
+        }
     }
 }
 
@@ -343,20 +381,7 @@ HalResult<milliseconds> AidlHalWrapper::performComposedEffect(
         const std::function<void()>& completionCallback) {
     // This method should always support callbacks, so no need to double check.
     auto cb = new HalCallbackWrapper(completionCallback);
-
-    auto durations = getPrimitiveDurations().valueOr({});
-    milliseconds duration(0);
-    for (const auto& effect : primitives) {
-        auto primitiveIdx = static_cast<size_t>(effect.primitive);
-        if (primitiveIdx < durations.size()) {
-            duration += durations[primitiveIdx];
-        } else {
-            // Make sure the returned duration is positive to indicate successful vibration.
-            duration += milliseconds(1);
-        }
-        duration += milliseconds(effect.delayMs);
-    }
-
+    milliseconds duration = getCompositionDuration(primitives);
     return HalResult<milliseconds>::fromStatus(getHal()->compose(primitives, cb), duration);
 }
 
@@ -495,8 +520,13 @@ template <typename I>
 void HidlHalWrapper<I>::tryReconnect() {
     sp<I> newHandle = I::tryGetService();
     if (newHandle) {
-        std::lock_guard<std::mutex> lock(mHandleMutex);
-        mHandle = std::move(newHandle);
+        {
+            std::lock_guard<std::mutex> lock(mHandleMutex);
+            mHandle = std::move(newHandle);
+        }
+        // The HAL service might have restarted, and only the capabilities are cached for the HIDL
+        // HALs, so they are simply loaded again.
+        clearInfoCache();
     }
 }
 
@@ -17,8 +17,12 @@
 #define LOG_TAG "VibratorHalControllerBenchmarks"
 
 #include <benchmark/benchmark.h>
+#include <vibratorservice/VibratorCallbackScheduler.h>
 #include <vibratorservice/VibratorHalController.h>
 
+#include <condition_variable>
+#include <mutex>
+
 using ::android::enum_range;
 using ::android::hardware::vibrator::CompositeEffect;
 using ::android::hardware::vibrator::CompositePrimitive;
@@ -468,4 +472,63 @@ BENCHMARK_WRAPPER(VibratorPrimitivesBench, performComposedEffect, {
     }
 });
 
+// Haptic feedback of fast keyboard typing: a short composition for each key press, while the
+// vibrator is checked for the capabilities every time and never waited on.
+BENCHMARK_WRAPPER(VibratorPrimitivesBench, keyboardTyping, {
+    if (!hasCapabilities(vibrator::Capabilities::COMPOSE_EFFECTS, state)) {
+        return;
+    }
+    if (!hasArgs(state)) {
+        return;
+    }
+
+    CompositeEffect effect;
+    effect.primitive = getPrimitive(state);
+    effect.scale = 0.5f;
+    effect.delayMs = static_cast<int32_t>(0);
+
+    std::vector<CompositeEffect> effects;
+    effects.push_back(effect);
+    auto callback = []() {};
+
+    for (auto _ : state) {
+        if (!hasCapabilities(vibrator::Capabilities::COMPOSE_EFFECTS, state)) {
+            break;
+        }
+        auto ret = halCall<std::chrono::milliseconds>(mController, [&](auto hal) {
+            return hal->performComposedEffect(effects, callback);
+        });
+        if (!checkHalResult(ret, state)) {
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+});
+
+// The completion callbacks of the key presses on a vibrator without callback support, which all
+// go through the callback thread of the scheduler.
+BENCHMARK_WRAPPER(VibratorBench, keyboardTypingCallbacks, {
+    constexpr int kKeyPresses = 64;
+    std::mutex mutex;
+    std::condition_variable condition;
+    int completed = 0;
+    auto callback = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++completed == kKeyPresses) {
+            condition.notify_all();
+        }
+    };
+
+    for (auto _ : state) {
+        vibrator::CallbackScheduler scheduler;
+        completed = 0;
+        for (int i = 0; i < kKeyPresses; i++) {
+            scheduler.schedule(callback, std::chrono::milliseconds(1 + i % 4));
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return completed == kKeyPresses; });
+    }
+    state.SetItemsProcessed(state.iterations() * kKeyPresses);
+});
+
 BENCHMARK_MAIN();
\ No newline at end of file
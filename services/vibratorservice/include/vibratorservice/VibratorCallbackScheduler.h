@@ -20,8 +20,9 @@
 #include <android-base/thread_annotations.h>
 #include <chrono>
 #include <condition_variable>
-#include <queue>
+#include <functional>
 #include <thread>
+#include <vector>
 
 namespace android {
 
@@ -33,7 +34,7 @@ public:
     using Timestamp = std::chrono::time_point<std::chrono::steady_clock>;
 
     DelayedCallback(std::function<void()> callback, std::chrono::milliseconds delay)
-          : mCallback(callback), mExpiration(std::chrono::steady_clock::now() + delay) {}
+          : mCallback(std::move(callback)), mExpiration(std::chrono::steady_clock::now() + delay) {}
     ~DelayedCallback() = default;
 
     void run() const;
@@ -67,10 +68,12 @@ private:
     // Used to quit the callback thread when this instance is being destroyed.
     bool mFinished GUARDED_BY(mMutex);
 
-    // Priority queue with reverse comparator, so tasks that expire first will be on top.
-    std::priority_queue<DelayedCallback, std::vector<DelayedCallback>,
-                        std::greater<DelayedCallback>>
-            mQueue GUARDED_BY(mMutex);
+    // Heap with reverse comparator, so tasks that expire first will be on top. This is not a
+    // std::priority_queue so that the callbacks can be moved out of it.
+    std::vector<DelayedCallback> mQueue GUARDED_BY(mMutex);
+
+    // Callbacks which expired together, run by the callback thread without the lock held.
+    std::vector<DelayedCallback> mExpiredCallbacks;
 
     void loop();
 };
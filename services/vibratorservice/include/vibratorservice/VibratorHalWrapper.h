@@ -300,6 +300,13 @@ protected:
     // Load and cache vibrator info, returning cached result is present.
     HalResult<Capabilities> getCapabilities();
     HalResult<std::vector<std::chrono::milliseconds>> getPrimitiveDurations();
+    // Returns the duration of the composition from the cached primitive durations, without copying
+    // them, counting the primitives with an unknown duration as 1ms.
+    std::chrono::milliseconds getCompositionDuration(
+            const std::vector<hardware::vibrator::CompositeEffect>& primitives);
+
+    // Drops the cached vibrator info, so that it is loaded again from a restarted HAL service.
+    void clearInfoCache();
 
     // Request vibrator info to HAL skipping cache.
     virtual HalResult<Capabilities> getCapabilitiesInternal() = 0;
@@ -322,6 +329,8 @@ protected:
 private:
     std::mutex mInfoMutex;
     InfoCache mInfoCache GUARDED_BY(mInfoMutex);
+
+    void loadPrimitiveDurationsLocked() REQUIRES(mInfoMutex);
 };
 
 // Wrapper for the AIDL Vibrator HAL.
@@ -114,6 +114,23 @@ TEST_F(VibratorCallbackSchedulerTest, TestScheduleInParallelRunsInDelayOrder) {
     ASSERT_THAT(getExpiredCallbacks(), ElementsAre(0, 1, 2, 3, 4));
 }
 
+TEST_F(VibratorCallbackSchedulerTest, TestScheduleBurstOfShortCallbacksRunsAllInDelayOrder) {
+    std::vector<int32_t> expectedCallbacks;
+    for (int i = 0; i < 100; i++) {
+        // Scheduled from the longest delay, so that each callback expires first when scheduled.
+        mScheduler->schedule(createCallback(i), milliseconds(5 - i / 20));
+        expectedCallbacks.push_back(i);
+    }
+
+    ASSERT_TRUE(waitForCallbacks(100, 20ms));
+    std::vector<int32_t> callbacks = getExpiredCallbacks();
+    ASSERT_THAT(callbacks, UnorderedElementsAreArray(expectedCallbacks));
+    // The callbacks with a shorter delay run first.
+    for (size_t i = 1; i < callbacks.size(); i++) {
+        ASSERT_GE(callbacks[i - 1] / 20, callbacks[i] / 20);
+    }
+}
+
 TEST_F(VibratorCallbackSchedulerTest, TestDestructorDropsPendingCallbacksAndKillsThread) {
     mScheduler->schedule(createCallback(1), 5ms);
     mScheduler.reset(nullptr);
@@ -140,6 +140,41 @@ TEST_F(VibratorHalWrapperAidlTest, TestPing) {
     ASSERT_TRUE(mWrapper->ping().isFailed());
 }
 
+TEST_F(VibratorHalWrapperAidlTest, TestTryReconnectReloadsInfoFromRestartedHal) {
+    sp<StrictMock<MockIVibrator>> restartedMockHal = new StrictMock<MockIVibrator>();
+    sp<StrictMock<MockBinder>> restartedMockBinder = new StrictMock<MockBinder>();
+    mWrapper = std::make_unique<vibrator::AidlHalWrapper>(mMockScheduler, mMockHal, [&]() {
+        return vibrator::HalResult<sp<IVibrator>>::ok(restartedMockHal);
+    });
+
+    EXPECT_CALL(*mMockHal.get(), onAsBinder()).WillRepeatedly(Return(mMockBinder.get()));
+    EXPECT_CALL(*restartedMockHal.get(), onAsBinder())
+            .WillRepeatedly(Return(restartedMockBinder.get()));
+    EXPECT_CALL(*mMockHal.get(), getCapabilities(_))
+            .Times(Exactly(1))
+            .WillRepeatedly(DoAll(SetArgPointee<0>(IVibrator::CAP_ON_CALLBACK), Return(Status())));
+    EXPECT_CALL(*mMockHal.get(), on(Eq(10), _))
+            .Times(Exactly(1))
+            .WillRepeatedly(DoAll(TriggerCallbackInArg1(), Return(Status())));
+    // Loaded once from the restarted HAL, and not again when reconnecting to the same HAL.
+    EXPECT_CALL(*restartedMockHal.get(), getCapabilities(_))
+            .Times(Exactly(1))
+            .WillRepeatedly(DoAll(SetArgPointee<0>(IVibrator::CAP_ON_CALLBACK), Return(Status())));
+    EXPECT_CALL(*restartedMockHal.get(), on(Eq(10), _))
+            .Times(Exactly(2))
+            .WillRepeatedly(DoAll(TriggerCallbackInArg1(), Return(Status())));
+
+    std::unique_ptr<int32_t> callbackCounter = std::make_unique<int32_t>();
+    auto callback = vibrator::TestFactory::createCountingCallback(callbackCounter.get());
+
+    ASSERT_TRUE(mWrapper->on(10ms, callback).isOk());
+    mWrapper->tryReconnect();
+    ASSERT_TRUE(mWrapper->on(10ms, callback).isOk());
+    mWrapper->tryReconnect();
+    ASSERT_TRUE(mWrapper->on(10ms, callback).isOk());
+    ASSERT_EQ(3, *callbackCounter.get());
+}
+
 TEST_F(VibratorHalWrapperAidlTest, TestOnWithCallbackSupport) {
     {
         InSequence seq;
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+#include <vulkan/vulkan.h>
+
+namespace {
+
+// The commands are recorded into the same command buffer, which is reset from
+// time to time so that a real driver does not run out of memory.
+constexpr int64_t kCommandsPerReset = 4096;
+
+// A device with a command buffer in the recording state. On a device where
+// the loader uses the null driver (vulkan.default), the benchmarks only
+// measure the dispatch of the commands.
+class CommandRecorder {
+public:
+    CommandRecorder() {
+        const VkApplicationInfo app_info = {
+            .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            .apiVersion = VK_API_VERSION_1_1,
+        };
+        const VkInstanceCreateInfo instance_info = {
+            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            .pApplicationInfo = &app_info,
+        };
+        if (vkCreateInstance(&instance_info, nullptr, &instance_) !=
+            VK_SUCCESS) {
+            ALOGE("vkCreateInstance failed");
+            return;
+        }
+
+        uint32_t count = 1;
+        VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+        VkResult result =
+            vkEnumeratePhysicalDevices(instance_, &count, &physical_device);
+        if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || count == 0) {
+            ALOGE("No physical device");
+            return;
+        }
+
+        const float priority = 1.0f;
+        const VkDeviceQueueCreateInfo queue_info = {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = 0,
+            .queueCount = 1,
+            .pQueuePriorities = &priority,
+        };
+        const VkDeviceCreateInfo device_info = {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            .queueCreateInfoCount = 1,
+            .pQueueCreateInfos = &queue_info,
+        };
+        if (vkCreateDevice(physical_device, &device_info, nullptr,
+                           &device_) != VK_SUCCESS) {
+            ALOGE("vkCreateDevice failed");
+            return;
+        }
+
+        const VkCommandPoolCreateInfo pool_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = 0,
+        };
+        if (vkCreateCommandPool(device_, &pool_info, nullptr, &pool_) !=
+            VK_SUCCESS) {
+            ALOGE("vkCreateCommandPool failed");
+            return;
+        }
+        const VkCommandBufferAllocateInfo allocate_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool_,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        if (vkAllocateCommandBuffers(device_, &allocate_info,
+                                     &command_buffer_) != VK_SUCCESS) {
+            ALOGE("vkAllocateCommandBuffers failed");
+            command_buffer_ = VK_NULL_HANDLE;
+            return;
+        }
+        Begin();
+    }
+
+    ~CommandRecorder() {
+        if (command_buffer_ != VK_NULL_HANDLE)
+            vkEndCommandBuffer(command_buffer_);
+        if (pool_ != VK_NULL_HANDLE)
+            vkDestroyCommandPool(device_, pool_, nullptr);
+        if (device_ != VK_NULL_HANDLE)
+            vkDestroyDevice(device_, nullptr);
+        if (instance_ != VK_NULL_HANDLE)
+            vkDestroyInstance(instance_, nullptr);
+    }
+
+    bool IsValid() const { return command_buffer_ != VK_NULL_HANDLE; }
+    VkDevice device() const { return device_; }
+    VkCommandBuffer command_buffer() const { return command_buffer_; }
+
+    void Restart() {
+        vkEndCommandBuffer(command_buffer_);
+        vkResetCommandBuffer(command_buffer_, 0);
+        Begin();
+    }
+
+private:
+    void Begin() {
+        const VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        vkBeginCommandBuffer(command_buffer_, &begin_info);
+    }
+
+    VkInstance instance_ = VK_NULL_HANDLE;
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkCommandPool pool_ = VK_NULL_HANDLE;
+    VkCommandBuffer command_buffer_ = VK_NULL_HANDLE;
+};
+
+template <typename Record>
+void RecordCommands(benchmark::State& state,
+                    CommandRecorder& recorder,
+                    Record record) {
+    VkCommandBuffer command_buffer = recorder.command_buffer();
+    int64_t recorded = 0;
+    for (auto _ : state) {
+        record(command_buffer);
+        if (++recorded == kCommandsPerReset) {
+            state.PauseTiming();
+            recorder.Restart();
+            recorded = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Records through the entry point exported by libvulkan, which dispatches
+// through the command buffer to the first layer or to the driver.
+void BM_CmdSetLineWidth_Exported(benchmark::State& state) {
+    CommandRecorder recorder;
+    if (!recorder.IsValid()) {
+        state.SkipWithError("No Vulkan device");
+        return;
+    }
+    RecordCommands(state, recorder, [](VkCommandBuffer command_buffer) {
+        vkCmdSetLineWidth(command_buffer, 1.0f);
+    });
+}
+BENCHMARK(BM_CmdSetLineWidth_Exported);
+
+// Records through the function returned by vkGetDeviceProcAddr, which for the
+// commands that the loader does not intercept is the function of the first
+// layer or of the driver itself.
+void BM_CmdSetLineWidth_DeviceProcAddr(benchmark::State& state) {
+    CommandRecorder recorder;
+    if (!recorder.IsValid()) {
+        state.SkipWithError("No Vulkan device");
+        return;
+    }
+    auto set_line_width = reinterpret_cast<PFN_vkCmdSetLineWidth>(
+        vkGetDeviceProcAddr(recorder.device(), "vkCmdSetLineWidth"));
+    RecordCommands(state, recorder,
+                   [set_line_width](VkCommandBuffer command_buffer) {
+                       set_line_width(command_buffer, 1.0f);
+                   });
+}
+BENCHMARK(BM_CmdSetLineWidth_DeviceProcAddr);
+
+// Interleaves the state commands of a typical draw, to measure the dispatch
+// when the driver functions do not all stay in the branch predictor.
+void BM_RecordDrawState_Exported(benchmark::State& state) {
+    CommandRecorder recorder;
+    if (!recorder.IsValid()) {
+        state.SkipWithError("No Vulkan device");
+        return;
+    }
+    const VkViewport viewport = {0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f};
+    const VkRect2D scissor = {{0, 0}, {1920, 1080}};
+    const float blend_constants[4] = {};
+    RecordCommands(state, recorder, [&](VkCommandBuffer command_buffer) {
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        vkCmdSetBlendConstants(command_buffer, blend_constants);
+        vkCmdSetStencilReference(command_buffer,
+                                 VK_STENCIL_FACE_FRONT_AND_BACK, 0);
+    });
+}
+BENCHMARK(BM_RecordDrawState_Exported);
+
+void BM_RecordDrawState_DeviceProcAddr(benchmark::State& state) {
+    CommandRecorder recorder;
+    if (!recorder.IsValid()) {
+        state.SkipWithError("No Vulkan device");
+        return;
+    }
+    VkDevice device = recorder.device();
+    auto set_viewport = reinterpret_cast<PFN_vkCmdSetViewport>(
+        vkGetDeviceProcAddr(device, "vkCmdSetViewport"));
+    auto set_scissor = reinterpret_cast<PFN_vkCmdSetScissor>(
+        vkGetDeviceProcAddr(device, "vkCmdSetScissor"));
+    auto set_blend_constants = reinterpret_cast<PFN_vkCmdSetBlendConstants>(
+        vkGetDeviceProcAddr(device, "vkCmdSetBlendConstants"));
+    auto set_stencil_reference =
+        reinterpret_cast<PFN_vkCmdSetStencilReference>(
+            vkGetDeviceProcAddr(device, "vkCmdSetStencilReference"));
+    const VkViewport viewport = {0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f};
+    const VkRect2D scissor = {{0, 0}, {1920, 1080}};
+    const float blend_constants[4] = {};
+    RecordCommands(state, recorder, [&](VkCommandBuffer command_buffer) {
+        set_viewport(command_buffer, 0, 1, &viewport);
+        set_scissor(command_buffer, 0, 1, &scissor);
+        set_blend_constants(command_buffer, blend_constants);
+        set_stencil_reference(command_buffer, VK_STENCIL_FACE_FRONT_AND_BACK,
+                              0);
+    });
+}
+BENCHMARK(BM_RecordDrawState_DeviceProcAddr);
+
+}  // namespace
+
+BENCHMARK_MAIN();
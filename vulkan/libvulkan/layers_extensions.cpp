@@ -24,6 +24,7 @@
 #include <string.h>
 #include <sys/prctl.h>
 
+#include <algorithm>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -324,17 +325,34 @@ void* LayerLibrary::GetGPA(const Layer& layer, const std::string_view gpa_name)
 std::vector<LayerLibrary> g_layer_libraries;
 std::vector<Layer> g_instance_layers;
 
-void AddLayerLibrary(const std::string& path, const std::string& filename) {
+void AddLayerLibrary(const std::string& path,
+                     const std::string& filename,
+                     const std::vector<std::string>& settings_layers) {
     LayerLibrary library(path + "/" + filename, filename);
     if (!library.Open())
         return;
 
+    const size_t prev_num_instance_layers = g_instance_layers.size();
     if (!library.EnumerateLayers(g_layer_libraries.size(), g_instance_layers)) {
         library.Close();
         return;
     }
 
-    library.Close();
+    // The layers enabled by the settings are inserted into every instance, so
+    // their library is kept open instead of being closed now and opened again
+    // by each instance.
+    bool in_settings = false;
+    for (size_t i = prev_num_instance_layers; i < g_instance_layers.size(); i++) {
+        in_settings |= std::find(settings_layers.cbegin(), settings_layers.cend(),
+                                 g_instance_layers[i].properties.layerName) !=
+                       settings_layers.cend();
+    }
+    if (in_settings) {
+        ALOGV("keeping layer library '%s' open for the layers of the settings",
+              filename.c_str());
+    } else {
+        library.Close();
+    }
 
     g_layer_libraries.emplace_back(std::move(library));
 }
@@ -408,7 +426,8 @@ void ForEachFileInPath(const std::string& path, Functor functor) {
     }
 }
 
-void DiscoverLayersInPathList(const std::string& pathstr) {
+void DiscoverLayersInPathList(const std::string& pathstr,
+                              const std::vector<std::string>& settings_layers) {
     ATRACE_CALL();
 
     std::vector<std::string> paths = android::base::Split(pathstr, ":");
@@ -434,7 +453,7 @@ void DiscoverLayersInPathList(const std::string& pathstr) {
                 }
 
                 if (!duplicate)
-                    AddLayerLibrary(path, filename);
+                    AddLayerLibrary(path, filename, settings_layers);
             }
         });
     }
@@ -461,11 +480,17 @@ void* GetLayerGetProcAddr(const Layer& layer,
 void DiscoverLayers() {
     ATRACE_CALL();
 
+    const std::string settings =
+        android::GraphicsEnv::getInstance().getDebugLayers();
+    const std::vector<std::string> settings_layers =
+        settings.empty() ? std::vector<std::string>()
+                         : android::base::Split(settings, ":");
     if (android::GraphicsEnv::getInstance().isDebuggable()) {
-        DiscoverLayersInPathList(kSystemLayerLibraryDir);
+        DiscoverLayersInPathList(kSystemLayerLibraryDir, settings_layers);
     }
     if (!android::GraphicsEnv::getInstance().getLayerPaths().empty())
-        DiscoverLayersInPathList(android::GraphicsEnv::getInstance().getLayerPaths());
+        DiscoverLayersInPathList(android::GraphicsEnv::getInstance().getLayerPaths(),
+                                 settings_layers);
 }
 
 uint32_t GetLayerCount() {
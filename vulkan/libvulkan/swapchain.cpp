@@ -292,6 +292,21 @@ struct Swapchain {
     nsecs_t acquire_next_image_timeout;
     bool shared;
 
+    // The parameters of the images, which a swapchain created with this one as
+    // its oldSwapchain must match to take the images over.
+    VkFormat image_format;
+    VkExtent2D image_extent;
+    VkImageUsageFlags image_usage;
+    VkSwapchainCreateFlagsKHR create_flags;
+    VkPresentModeKHR present_mode;
+    uint32_t min_image_count;
+    uint64_t native_usage;
+    // Whether the images can be taken over by the next swapchain of the
+    // surface. They can't for the deferred, shared and concurrent images, for
+    // the images with compression control, and once the window returned a
+    // buffer which isn't one of the images.
+    bool images_reusable;
+
     struct Image {
         Image()
             : image(VK_NULL_HANDLE),
@@ -398,15 +413,24 @@ void ReleaseSwapchainImage(VkDevice device,
     image.buffer.clear();
 }
 
-void OrphanSwapchain(VkDevice device, Swapchain* swapchain) {
-    if (swapchain->surface.swapchain_handle != HandleFromSwapchain(swapchain))
-        return;
+static void ReleaseIdleSwapchainImages(VkDevice device, Swapchain* swapchain) {
     for (uint32_t i = 0; i < swapchain->num_images; i++) {
         if (!swapchain->images[i].dequeued) {
             ReleaseSwapchainImage(device, swapchain->shared, nullptr, -1,
                                   swapchain->images[i], true);
         }
     }
+}
+
+// The swapchain keeps its idle images when they are taken over by the next
+// swapchain of the surface.
+void OrphanSwapchain(VkDevice device,
+                     Swapchain* swapchain,
+                     bool release_images = true) {
+    if (swapchain->surface.swapchain_handle != HandleFromSwapchain(swapchain))
+        return;
+    if (release_images)
+        ReleaseIdleSwapchainImages(device, swapchain);
     swapchain->surface.swapchain_handle = VK_NULL_HANDLE;
     swapchain->timing.clear();
 }
@@ -1332,6 +1356,37 @@ static void DestroySwapchainInternal(VkDevice device,
     allocator->pfnFree(allocator->pUserData, swapchain);
 }
 
+// Returns whether a swapchain created with the create info can take over the
+// buffers and images of its old swapchain, instead of reallocating them. The
+// native window is then not reset, so that its buffers are kept, and none of
+// the buffers may be dequeued by the app.
+static bool CanReuseSwapchainImages(const Swapchain& old_swapchain,
+                                    const VkSwapchainCreateInfoKHR& create_info) {
+    if (!old_swapchain.images_reusable ||
+        create_info.imageFormat != old_swapchain.image_format ||
+        create_info.imageExtent.width != old_swapchain.image_extent.width ||
+        create_info.imageExtent.height != old_swapchain.image_extent.height ||
+        create_info.imageUsage != old_swapchain.image_usage ||
+        create_info.flags != old_swapchain.create_flags ||
+        create_info.presentMode != old_swapchain.present_mode ||
+        create_info.minImageCount != old_swapchain.min_image_count ||
+        create_info.imageSharingMode != VK_SHARING_MODE_EXCLUSIVE) {
+        return false;
+    }
+    for (const VkBaseInStructure* next =
+             reinterpret_cast<const VkBaseInStructure*>(create_info.pNext);
+         next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT)
+            return false;
+    }
+    for (uint32_t i = 0; i < old_swapchain.num_images; i++) {
+        const Swapchain::Image& img = old_swapchain.images[i];
+        if (!img.image || !img.buffer || img.dequeued)
+            return false;
+    }
+    return true;
+}
+
 VKAPI_ATTR
 VkResult CreateSwapchainKHR(VkDevice device,
                             const VkSwapchainCreateInfoKHR* create_info,
@@ -1392,8 +1447,17 @@ VkResult CreateSwapchainKHR(VkDevice device,
               reinterpret_cast<uint64_t>(create_info->oldSwapchain));
         return VK_ERROR_NATIVE_WINDOW_IN_USE_KHR;
     }
-    if (create_info->oldSwapchain != VK_NULL_HANDLE)
-        OrphanSwapchain(device, SwapchainFromHandle(create_info->oldSwapchain));
+    Swapchain* old_swapchain =
+        create_info->oldSwapchain != VK_NULL_HANDLE
+            ? SwapchainFromHandle(create_info->oldSwapchain)
+            : nullptr;
+    // On rotation with pre-rotation, or when the app recreates the swapchain
+    // with the same images, the images of the old swapchain are taken over
+    // instead of freeing their buffers and allocating new ones.
+    const bool reuse_images =
+        old_swapchain && CanReuseSwapchainImages(*old_swapchain, *create_info);
+    if (old_swapchain)
+        OrphanSwapchain(device, old_swapchain, !reuse_images);
 
     // -- Reset the native window --
     // The native window might have been used previously, and had its properties
@@ -1407,11 +1471,14 @@ VkResult CreateSwapchainKHR(VkDevice device,
     // orphans the previous buffers, getting us back to the state where we can
     // dequeue all buffers.
     //
-    // This is not necessary if the surface was never used previously.
-    //
-    // TODO(http://b/134186185) recycle swapchain images more efficiently
+    // This is not necessary if the surface was never used previously, nor when
+    // the images of the old swapchain are reused, since their buffers must be
+    // kept.
     ANativeWindow* window = surface.window.get();
-    if (surface.used_by_swapchain) {
+    if (reuse_images) {
+        if (old_swapchain->frame_timestamps_enabled)
+            native_window_enable_frame_timestamps(window, false);
+    } else if (surface.used_by_swapchain) {
         err = native_window_api_disconnect(window, NATIVE_WINDOW_API_EGL);
         ALOGW_IF(err != android::OK,
                  "native_window_api_disconnect failed: %s (%d)", strerror(-err),
@@ -1635,6 +1702,18 @@ VkResult CreateSwapchainKHR(VkDevice device,
         createProtectedSwapchain = true;
         native_usage |= BufferUsage::PROTECTED;
     }
+
+    if (reuse_images && (num_images != old_swapchain->num_images ||
+                         native_usage != old_swapchain->native_usage)) {
+        // The buffers of the old swapchain don't match after all, so the
+        // swapchain is created again from a reset window.
+        ALOGV("vkCreateSwapchainKHR: can't reuse the images of oldSwapchain");
+        ReleaseIdleSwapchainImages(device, old_swapchain);
+        VkSwapchainCreateInfoKHR reset_create_info = *create_info;
+        reset_create_info.oldSwapchain = VK_NULL_HANDLE;
+        return CreateSwapchainKHR(device, &reset_create_info, allocator,
+                                  swapchain_handle);
+    }
     err = native_window_set_usage(window, native_usage);
     if (err != android::OK) {
         ALOGE("native_window_set_usage failed: %s (%d)", strerror(-err), err);
@@ -1668,6 +1747,19 @@ VkResult CreateSwapchainKHR(VkDevice device,
         Swapchain(surface, num_images, create_info->presentMode,
                   TranslateVulkanToNativeTransform(create_info->preTransform),
                   refresh_duration);
+    swapchain->image_format = create_info->imageFormat;
+    swapchain->image_extent = create_info->imageExtent;
+    swapchain->image_usage = create_info->imageUsage;
+    swapchain->create_flags = create_info->flags;
+    swapchain->present_mode = create_info->presentMode;
+    swapchain->min_image_count = create_info->minImageCount;
+    swapchain->native_usage = native_usage;
+    swapchain->images_reusable =
+        !(create_info->flags &
+          VK_SWAPCHAIN_CREATE_DEFERRED_MEMORY_ALLOCATION_BIT_EXT) &&
+        !swapchain->shared &&
+        create_info->imageSharingMode == VK_SHARING_MODE_EXCLUSIVE &&
+        usage_info_pNext == nullptr;
     VkSwapchainImageCreateInfoANDROID swapchain_image_create = {
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wold-style-cast"
@@ -1730,6 +1822,22 @@ VkResult CreateSwapchainKHR(VkDevice device,
                 break;
             }
         }
+    } else if (reuse_images) {
+        // -- Take over the buffers and VkImages of the old swapchain --
+        // The buffers are all in the queue of the window, which returns them
+        // to AcquireNextImage as before.
+        ALOGV("vkCreateSwapchainKHR: reusing the %u images of oldSwapchain",
+              num_images);
+        for (uint32_t i = 0; i < num_images; i++) {
+            Swapchain::Image& img = swapchain->images[i];
+            Swapchain::Image& old_img = old_swapchain->images[i];
+            img.image = old_img.image;
+            img.buffer = old_img.buffer;
+            img.release_fence = old_img.release_fence;
+            old_img.image = VK_NULL_HANDLE;
+            old_img.buffer.clear();
+            old_img.release_fence = -1;
+        }
     } else {
         // -- Dequeue all buffers and create a VkImage for each --
         // Any failures during or after this must cancel the dequeued buffers.
@@ -1970,6 +2078,9 @@ VkResult AcquireNextImageKHR(VkDevice device,
     if (idx == swapchain.num_images) {
         ALOGE("dequeueBuffer returned unrecognized buffer");
         window->cancelBuffer(window, buffer, fence_fd);
+        // The buffers of the window changed, so the next swapchain must not
+        // expect them to be the images of this one.
+        swapchain.images_reusable = false;
         return VK_ERROR_OUT_OF_DATE_KHR;
     }
 
@@ -2110,6 +2221,23 @@ static bool SetSwapchainPresentMode(ANativeWindow *window, VkPresentModeKHR mode
     return true;
 }
 
+// Returns a fence which signals once both the wait fence and the fence have
+// signalled. Takes the ownership of the fence, but not of the wait fence.
+static int MergeReleaseFence(int wait_fence, int fence) {
+    int merged = fence < 0 ? dup(wait_fence)
+                           : sync_merge("vkQueuePresentKHR", wait_fence, fence);
+    if (merged < 0) {
+        ALOGE("merging the release fences failed, stalling until signalled: "
+              "%s (%d)",
+              strerror(errno), errno);
+        sync_wait(wait_fence, -1 /* forever */);
+        return fence;
+    }
+    if (fence >= 0)
+        close(fence);
+    return merged;
+}
+
 static VkResult PresentOneSwapchain(
         VkQueue queue,
         Swapchain& swapchain,
@@ -2119,7 +2247,9 @@ static VkResult PresentOneSwapchain(
         VkFence presentFence,
         const VkPresentModeKHR *pPresentMode,
         uint32_t waitSemaphoreCount,
-        const VkSemaphore *pWaitSemaphores) {
+        const VkSemaphore *pWaitSemaphores,
+        int wait_fence,
+        int *out_release_fence) {
 
     VkDevice device = GetData(queue).driver_device;
     const auto& dispatch = GetData(queue).driver;
@@ -2129,9 +2259,10 @@ static VkResult PresentOneSwapchain(
     VkResult result;
     int err;
 
-    // XXX: long standing issue: QueueSignalReleaseImageANDROID consumes the
-    // wait semaphores, so this doesn't actually work for the multiple swapchain
-    // case.
+    // QueueSignalReleaseImageANDROID consumes the wait semaphores, so when
+    // several swapchains are presented together, only the first image waits
+    // for them. The release fences of the other images also wait for the
+    // release fence of the first one, without the CPU waiting for it.
     int fence = -1;
     result = dispatch.QueueSignalReleaseImageANDROID(
         queue, waitSemaphoreCount,
@@ -2140,6 +2271,10 @@ static VkResult PresentOneSwapchain(
         ALOGE("QueueSignalReleaseImageANDROID failed: %d", result);
         swapchain_result = result;
     }
+    if (wait_fence >= 0)
+        fence = MergeReleaseFence(wait_fence, fence);
+    if (out_release_fence)
+        *out_release_fence = fence < 0 ? -1 : dup(fence);
     if (img.release_fence >= 0)
         close(img.release_fence);
     img.release_fence = fence < 0 ? -1 : dup(fence);
@@ -2306,9 +2441,13 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
     const VkPresentTimeGOOGLE* times =
         (present_times) ? present_times->pTimes : nullptr;
 
+    // The release fence of the first image, which the images of the other
+    // swapchains wait for instead of the wait semaphores.
+    int semaphores_fence = -1;
     for (uint32_t sc = 0; sc < present_info->swapchainCount; sc++) {
         Swapchain& swapchain =
             *SwapchainFromHandle(present_info->pSwapchains[sc]);
+        const bool first = sc == 0;
 
         VkResult swapchain_result = PresentOneSwapchain(
             queue,
@@ -2318,8 +2457,11 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
             times ? &times[sc] : nullptr,
             present_fences ? present_fences->pFences[sc] : VK_NULL_HANDLE,
             present_modes ? &present_modes->pPresentModes[sc] : nullptr,
-            present_info->waitSemaphoreCount,
-            present_info->pWaitSemaphores);
+            first ? present_info->waitSemaphoreCount : 0,
+            present_info->pWaitSemaphores,
+            first ? -1 : semaphores_fence,
+            first && present_info->swapchainCount > 1 ? &semaphores_fence
+                                                      : nullptr);
 
         if (present_info->pResults)
             present_info->pResults[sc] = swapchain_result;
@@ -2327,6 +2469,8 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
         if (swapchain_result != final_result)
             final_result = WorstPresentResult(final_result, swapchain_result);
     }
+    if (semaphores_fence >= 0)
+        close(semaphores_fence);
 
     return final_result;
 }